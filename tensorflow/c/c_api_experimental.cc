@@ -15,6 +15,9 @@ limitations under the License.
 
 #include "tensorflow/c/c_api_experimental.h"
 
+#include <algorithm>
+#include <cstring>
+
 #include "absl/strings/substitute.h"
 #include "tensorflow/c/c_api.h"
 #include "tensorflow/c/c_api_internal.h"
@@ -32,6 +35,7 @@ limitations under the License.
 #include "tensorflow/core/framework/collective.h"
 #include "tensorflow/core/framework/node_def.pb.h"
 #include "tensorflow/core/framework/shape_inference.h"
+#include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/graph/graph.h"
 #include "tensorflow/core/graph/node_builder.h"
@@ -225,6 +229,122 @@ static std::vector<UniqueFuncPtr> CreateFunctionsFromTextProto(
   return ret;
 }
 
+namespace {
+
+bool IsMemcpyable(TF_DataType dtype) {
+  return dtype != TF_STRING && dtype != TF_RESOURCE &&
+         tensorflow::DataTypeCanUseMemcpy(
+             static_cast<tensorflow::DataType>(dtype));
+}
+
+// Copies `src`, the value fetched for output `index`, into the data of the
+// caller-provided `dst`.
+tensorflow::Status CopyToOutputBuffer(int index, const TF_Tensor* src,
+                                      TF_Tensor* dst) {
+  const TF_DataType dtype = TF_TensorType(src);
+  if (TF_TensorType(dst) != dtype) {
+    return tensorflow::errors::InvalidArgument(
+        "Output ", index, " is a ",
+        tensorflow::DataTypeString(static_cast<tensorflow::DataType>(dtype)),
+        " tensor but its buffer has type ",
+        tensorflow::DataTypeString(
+            static_cast<tensorflow::DataType>(TF_TensorType(dst))));
+  }
+  if (!IsMemcpyable(dtype)) {
+    return tensorflow::errors::InvalidArgument(
+        "Output ", index, " has type ",
+        tensorflow::DataTypeString(static_cast<tensorflow::DataType>(dtype)),
+        ", which can not be written into a caller-provided buffer");
+  }
+  bool same_shape = TF_NumDims(src) == TF_NumDims(dst);
+  for (int d = 0; same_shape && d < TF_NumDims(src); ++d) {
+    same_shape = TF_Dim(src, d) == TF_Dim(dst, d);
+  }
+  if (!same_shape) {
+    tensorflow::Tensor src_tensor;
+    tensorflow::Tensor dst_tensor;
+    TF_RETURN_IF_ERROR(tensorflow::TF_TensorToTensor(src, &src_tensor));
+    TF_RETURN_IF_ERROR(tensorflow::TF_TensorToTensor(dst, &dst_tensor));
+    return tensorflow::errors::InvalidArgument(
+        "Output ", index, " has shape ", src_tensor.shape().DebugString(),
+        " but its buffer has shape ", dst_tensor.shape().DebugString());
+  }
+  // Fetching a fed tensor returns the tensor itself.
+  const size_t size = TF_TensorByteSize(src);
+  if (size > 0 && TF_TensorData(dst) != TF_TensorData(src)) {
+    std::memcpy(TF_TensorData(dst), TF_TensorData(src), size);
+  }
+  return tensorflow::Status::OK();
+}
+
+}  // namespace
+
+size_t TF_TensorDataAlignment() { return std::max(1, EIGEN_MAX_ALIGN_BYTES); }
+
+TF_Tensor* TF_NewTensorNoCopy(TF_DataType dtype, const int64_t* dims,
+                              int num_dims, void* data, size_t len,
+                              void (*deallocator)(void* data, size_t len,
+                                                  void* arg),
+                              void* deallocator_arg, TF_Status* status) {
+  if (!IsMemcpyable(dtype)) {
+    status->status = tensorflow::errors::InvalidArgument(
+        "Tensors of type ",
+        tensorflow::DataTypeString(static_cast<tensorflow::DataType>(dtype)),
+        " can not adopt a buffer");
+    return nullptr;
+  }
+  if (reinterpret_cast<intptr_t>(data) % TF_TensorDataAlignment() != 0) {
+    status->status = tensorflow::errors::InvalidArgument(
+        "Tensor data at ", data, " is not aligned to ",
+        TF_TensorDataAlignment(), " bytes");
+    return nullptr;
+  }
+  size_t num_elements = 1;
+  for (int i = 0; i < num_dims; ++i) {
+    if (dims[i] < 0) {
+      status->status = tensorflow::errors::InvalidArgument(
+          "Dimension ", i, " is negative: ", dims[i]);
+      return nullptr;
+    }
+    num_elements *= dims[i];
+  }
+  if (len < num_elements * TF_DataTypeSize(dtype)) {
+    status->status = tensorflow::errors::InvalidArgument(
+        "A buffer of ", len, " bytes is too small for ", num_elements,
+        " elements of ", TF_DataTypeSize(dtype), " bytes");
+    return nullptr;
+  }
+  // TF_NewTensor only copies misaligned data.
+  TF_Tensor* tensor = TF_NewTensor(dtype, dims, num_dims, data, len,
+                                   deallocator, deallocator_arg);
+  status->status = tensorflow::Status::OK();
+  return tensor;
+}
+
+void TF_SessionRunWithOutputBuffers(
+    TF_Session* session, const TF_Buffer* run_options, const TF_Output* inputs,
+    TF_Tensor* const* input_values, int ninputs, const TF_Output* outputs,
+    TF_Tensor** output_values, int noutputs,
+    const TF_Operation* const* target_opers, int ntargets,
+    TF_Buffer* run_metadata, TF_Status* status) {
+  std::vector<TF_Tensor*> fetched(noutputs, nullptr);
+  TF_SessionRun(session, run_options, inputs, input_values, ninputs, outputs,
+                fetched.data(), noutputs, target_opers, ntargets, run_metadata,
+                status);
+  for (int i = 0; i < noutputs && status->status.ok(); ++i) {
+    if (output_values[i] != nullptr) {
+      status->status = CopyToOutputBuffer(i, fetched[i], output_values[i]);
+    }
+  }
+  for (int i = 0; i < noutputs; ++i) {
+    if (output_values[i] == nullptr && status->status.ok()) {
+      output_values[i] = fetched[i];
+    } else {
+      TF_DeleteTensor(fetched[i]);
+    }
+  }
+}
+
 TF_Tensor* TF_DequeueNamedTensor(TF_Session* session, int tensor_id,
                                  TF_Status* status) {
   assert(session);
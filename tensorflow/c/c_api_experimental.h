@@ -143,6 +143,47 @@ TF_CAPI_EXPORT extern void TF_EnqueueNamedTensor(TF_Session* session,
                                                  int tensor_id,
                                                  TF_Tensor* tensor,
                                                  TF_Status* status);
+
+// Returns the alignment, in bytes, that the data of a tensor must have for
+// TF_NewTensor to use it without copying.
+TF_CAPI_EXPORT extern size_t TF_TensorDataAlignment(void);
+
+// Like TF_NewTensor, but guarantees that the returned tensor uses `data`
+// directly: `deallocator` is called once TensorFlow no longer needs the
+// buffer, which may be after TF_DeleteTensor() if the tensor was fed to a
+// session. Feeding such tensors to TF_SessionRun does not copy them either.
+//
+// Fails with an InvalidArgument error, without calling `deallocator`, if
+// `data` is not aligned to TF_TensorDataAlignment(), if `len` is too small
+// for `dims`, or if `dtype` is TF_STRING or TF_RESOURCE, whose encodings
+// differ from their in-memory representation.
+TF_CAPI_EXPORT extern TF_Tensor* TF_NewTensorNoCopy(
+    TF_DataType dtype, const int64_t* dims, int num_dims, void* data,
+    size_t len, void (*deallocator)(void* data, size_t len, void* arg),
+    void* deallocator_arg, TF_Status* status);
+
+// Like TF_SessionRun, but writes fetched values into tensors that the caller
+// provides and keeps owning, so that a loop can fetch into the same buffers
+// on every step instead of receiving newly allocated tensors.
+//
+// If `output_values[i]` is not NULL, it must have the dtype and shape of the
+// fetched value, which is copied into its data. TF_STRING and TF_RESOURCE
+// outputs can not be written this way. If `output_values[i]` is NULL, it is
+// set to a new tensor that the caller must delete, as with TF_SessionRun.
+// On error, no new tensors are returned and caller-provided tensors may have
+// been partially written.
+TF_CAPI_EXPORT extern void TF_SessionRunWithOutputBuffers(
+    TF_Session* session, const TF_Buffer* run_options,
+    // Input tensors
+    const TF_Output* inputs, TF_Tensor* const* input_values, int ninputs,
+    // Output tensors
+    const TF_Output* outputs, TF_Tensor** output_values, int noutputs,
+    // Target operations
+    const TF_Operation* const* target_opers, int ntargets,
+    // RunMetadata
+    TF_Buffer* run_metadata,
+    // Output status
+    TF_Status* status);
 // Create a serialized tensorflow.ServerDef proto.
 TF_Buffer* TFE_GetServerDef(const char* text_proto, TF_Status* status);
 
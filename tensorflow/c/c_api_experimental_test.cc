@@ -84,6 +84,86 @@ TEST(CAPI_EXPERIMENTAL, IsStateful) {
   EXPECT_EQ(id, 0);
 }
 
+TEST(CAPI_EXPERIMENTAL, NewTensorNoCopy) {
+  std::unique_ptr<TF_Status, decltype(&TF_DeleteStatus)> status(
+      TF_NewStatus(), TF_DeleteStatus);
+  const size_t alignment = TF_TensorDataAlignment();
+  std::vector<char> storage(8 * sizeof(float) + 2 * alignment);
+  char* aligned = storage.data() + alignment -
+                  reinterpret_cast<intptr_t>(storage.data()) % alignment;
+  const int64_t dims[] = {8};
+  bool deallocated = false;
+  auto deallocator = [](void* data, size_t len, void* arg) {
+    *static_cast<bool*>(arg) = true;
+  };
+
+  TF_Tensor* t = TF_NewTensorNoCopy(TF_FLOAT, dims, 1, aligned + 1,
+                                    8 * sizeof(float), deallocator,
+                                    &deallocated, status.get());
+  EXPECT_EQ(nullptr, t);
+  EXPECT_EQ(TF_INVALID_ARGUMENT, TF_GetCode(status.get()));
+  t = TF_NewTensorNoCopy(TF_FLOAT, dims, 1, aligned, 4 * sizeof(float),
+                         deallocator, &deallocated, status.get());
+  EXPECT_EQ(nullptr, t);
+  EXPECT_EQ(TF_INVALID_ARGUMENT, TF_GetCode(status.get()));
+  EXPECT_FALSE(deallocated);
+
+  t = TF_NewTensorNoCopy(TF_FLOAT, dims, 1, aligned, 8 * sizeof(float),
+                         deallocator, &deallocated, status.get());
+  ASSERT_EQ(TF_OK, TF_GetCode(status.get())) << TF_Message(status.get());
+  EXPECT_EQ(aligned, TF_TensorData(t));
+  TF_DeleteTensor(t);
+  EXPECT_TRUE(deallocated);
+}
+
+TEST(CAPI_EXPERIMENTAL, SessionRunWithOutputBuffers) {
+  std::unique_ptr<TF_Status, decltype(&TF_DeleteStatus)> status(
+      TF_NewStatus(), TF_DeleteStatus);
+  TF_Graph* graph = TF_NewGraph();
+  TF_Operation* feed = Placeholder(graph, status.get());
+  ASSERT_EQ(TF_OK, TF_GetCode(status.get())) << TF_Message(status.get());
+  TF_Operation* neg = Neg(feed, graph, status.get());
+  ASSERT_EQ(TF_OK, TF_GetCode(status.get())) << TF_Message(status.get());
+  TF_SessionOptions* opts = TF_NewSessionOptions();
+  TF_Session* session = TF_NewSession(graph, opts, status.get());
+  TF_DeleteSessionOptions(opts);
+  ASSERT_EQ(TF_OK, TF_GetCode(status.get())) << TF_Message(status.get());
+
+  TF_Output input{feed, 0};
+  TF_Output outputs[] = {{neg, 0}, {neg, 0}};
+  TF_Tensor* buffer = TF_AllocateTensor(TF_INT32, nullptr, 0, sizeof(int32));
+  for (int32 v : {3, 5}) {
+    TF_Tensor* value = Int32Tensor(v);
+    TF_Tensor* output_values[] = {buffer, nullptr};
+    TF_SessionRunWithOutputBuffers(session, nullptr, &input, &value, 1,
+                                   outputs, output_values, 2, nullptr, 0,
+                                   nullptr, status.get());
+    TF_DeleteTensor(value);
+    ASSERT_EQ(TF_OK, TF_GetCode(status.get())) << TF_Message(status.get());
+    EXPECT_EQ(buffer, output_values[0]);
+    EXPECT_EQ(-v, *static_cast<int32*>(TF_TensorData(buffer)));
+    ASSERT_NE(nullptr, output_values[1]);
+    EXPECT_EQ(-v, *static_cast<int32*>(TF_TensorData(output_values[1])));
+    TF_DeleteTensor(output_values[1]);
+  }
+
+  // Buffers with the wrong type are rejected.
+  TF_Tensor* value = Int32Tensor(7);
+  TF_Tensor* wrong_type = FloatTensor(0);
+  TF_SessionRunWithOutputBuffers(session, nullptr, &input, &value, 1,
+                                 outputs, &wrong_type, 1, nullptr, 0, nullptr,
+                                 status.get());
+  EXPECT_EQ(TF_INVALID_ARGUMENT, TF_GetCode(status.get()));
+  TF_DeleteTensor(value);
+  TF_DeleteTensor(wrong_type);
+  TF_DeleteTensor(buffer);
+
+  TF_CloseSession(session, status.get());
+  ASSERT_EQ(TF_OK, TF_GetCode(status.get())) << TF_Message(status.get());
+  TF_DeleteSession(session, status.get());
+  TF_DeleteGraph(graph);
+}
+
 class ShapeInferenceTest : public ::testing::Test {
  protected:
   ShapeInferenceTest()
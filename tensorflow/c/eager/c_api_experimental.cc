@@ -26,6 +26,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/composite_device.h"
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/common_runtime/eager/eager_operation.h"
+#include "tensorflow/core/common_runtime/eager/trace_cache.h"
 #include "tensorflow/core/lib/monitoring/counter.h"
 #include "tensorflow/core/lib/monitoring/gauge.h"
 #include "tensorflow/core/lib/monitoring/sampler.h"
@@ -677,3 +678,46 @@ void TFE_ContextSetLogDevicePlacement(TFE_Context* ctx, unsigned char enable,
       tensorflow::ContextFromInterface(tensorflow::unwrap(ctx));
   context->SetLogDevicePlacement(enable);
 }
+
+void TFE_ContextSetTraceCacheIterations(TFE_Context* ctx, int min_iterations,
+                                        TF_Status* status) {
+  tensorflow::EagerContext* context =
+      tensorflow::ContextFromInterface(tensorflow::unwrap(ctx));
+  if (min_iterations > 0) {
+    context->SetTraceCache(std::unique_ptr<tensorflow::EagerTraceCache>(
+        new tensorflow::EagerTraceCache(context, min_iterations)));
+  } else {
+    context->SetTraceCache(nullptr);
+  }
+}
+
+namespace {
+
+tensorflow::EagerTraceCache* GetTraceCache(TFE_Context* ctx,
+                                           TF_Status* status) {
+  tensorflow::EagerContext* context =
+      tensorflow::ContextFromInterface(tensorflow::unwrap(ctx));
+  if (context->GetTraceCache() == nullptr) {
+    status->status = tensorflow::errors::FailedPrecondition(
+        "The trace cache is not enabled.");
+    return nullptr;
+  }
+  return tensorflow::down_cast<tensorflow::EagerTraceCache*>(
+      context->GetTraceCache());
+}
+
+}  // namespace
+
+void TFE_ContextBeginTracedIteration(TFE_Context* ctx, TF_Status* status) {
+  tensorflow::EagerTraceCache* trace_cache = GetTraceCache(ctx, status);
+  if (trace_cache != nullptr) {
+    status->status = trace_cache->BeginIteration();
+  }
+}
+
+void TFE_ContextEndTracedIteration(TFE_Context* ctx, TF_Status* status) {
+  tensorflow::EagerTraceCache* trace_cache = GetTraceCache(ctx, status);
+  if (trace_cache != nullptr) {
+    status->status = trace_cache->EndIteration();
+  }
+}
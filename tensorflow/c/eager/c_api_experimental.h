@@ -569,6 +569,27 @@ TF_CAPI_EXPORT void TFE_ContextSetLogDevicePlacement(TFE_Context* ctx,
                                                      unsigned char enable,
                                                      TF_Status* status);
 
+// Enables the trace cache of `ctx` if `min_iterations` is positive, or
+// disables it. Ops that a thread executes between
+// TFE_ContextBeginTracedIteration and TFE_ContextEndTracedIteration are
+// recorded, and once `min_iterations` iterations in a row executed the same
+// ops on inputs of the same types and shapes, later iterations run all of
+// them as a single function. The handles returned by the ops of such an
+// iteration become ready when it ends, or when their value is read first.
+// Must not be called while other threads execute ops.
+TF_CAPI_EXPORT void TFE_ContextSetTraceCacheIterations(TFE_Context* ctx,
+                                                       int min_iterations,
+                                                       TF_Status* status);
+
+// Starts an iteration of the traced region on the calling thread.
+TF_CAPI_EXPORT void TFE_ContextBeginTracedIteration(TFE_Context* ctx,
+                                                    TF_Status* status);
+
+// Ends the iteration started by the calling thread. Reports errors of the
+// ops whose execution was deferred to the end of the iteration.
+TF_CAPI_EXPORT void TFE_ContextEndTracedIteration(TFE_Context* ctx,
+                                                  TF_Status* status);
+
 #ifdef __cplusplus
 } /* end extern "C" */
 #endif
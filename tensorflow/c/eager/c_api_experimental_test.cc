@@ -19,8 +19,12 @@ limitations under the License.
 
 #include "tensorflow/c/eager/c_api.h"
 #include "tensorflow/c/eager/c_api_test_util.h"
+#include "tensorflow/c/eager/tfe_context_internal.h"
 #include "tensorflow/cc/profiler/profiler.h"
+#include "tensorflow/core/common_runtime/eager/context.h"
+#include "tensorflow/core/common_runtime/eager/trace_cache.h"
 #include "tensorflow/core/lib/monitoring/collection_registry.h"
+#include "tensorflow/core/platform/casts.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/protobuf.h"
 #include "tensorflow/core/platform/str_util.h"
@@ -491,5 +495,112 @@ TEST(CAPI, TensorHandleOnDeviceMemory) {
   TF_DeleteStatus(status);
 }
 
+EagerTraceCache::Stats TraceCacheStats(TFE_Context* ctx) {
+  return down_cast<EagerTraceCache*>(
+             ContextFromInterface(unwrap(ctx))->GetTraceCache())
+      ->GetStats();
+}
+
+TFE_TensorHandle* ExecuteOp(TFE_Op* op, TF_Status* status) {
+  TFE_TensorHandle* retval = nullptr;
+  int num_retvals = 1;
+  TFE_Execute(op, &retval, &num_retvals, status);
+  TFE_DeleteOp(op);
+  return retval;
+}
+
+void ExpectValues(TFE_TensorHandle* handle, const std::vector<float>& values,
+                  TF_Status* status) {
+  TF_Tensor* t = TFE_TensorHandleResolve(handle, status);
+  ASSERT_EQ(TF_OK, TF_GetCode(status)) << TF_Message(status);
+  ASSERT_EQ(values.size() * sizeof(float), TF_TensorByteSize(t));
+  const float* data = static_cast<const float*>(TF_TensorData(t));
+  for (int i = 0; i < values.size(); ++i) {
+    EXPECT_EQ(values[i], data[i]);
+  }
+  TF_DeleteTensor(t);
+}
+
+TEST(CAPI, TraceCacheReplaysRepeatedIterations) {
+  TF_Status* status = TF_NewStatus();
+  TFE_ContextOptions* opts = TFE_NewContextOptions();
+  TFE_Context* ctx = TFE_NewContext(opts, status);
+  CHECK_EQ(TF_OK, TF_GetCode(status)) << TF_Message(status);
+  TFE_DeleteContextOptions(opts);
+  TFE_ContextSetTraceCacheIterations(ctx, 2, status);
+  CHECK_EQ(TF_OK, TF_GetCode(status)) << TF_Message(status);
+
+  TFE_TensorHandle* m = TestMatrixTensorHandle(ctx);
+  for (int i = 0; i < 4; ++i) {
+    TFE_ContextBeginTracedIteration(ctx, status);
+    ASSERT_EQ(TF_OK, TF_GetCode(status)) << TF_Message(status);
+    TFE_TensorHandle* square = ExecuteOp(MatMulOp(ctx, m, m), status);
+    ASSERT_EQ(TF_OK, TF_GetCode(status)) << TF_Message(status);
+    TFE_TensorHandle* cube = ExecuteOp(MatMulOp(ctx, square, m), status);
+    ASSERT_EQ(TF_OK, TF_GetCode(status)) << TF_Message(status);
+    TFE_ContextEndTracedIteration(ctx, status);
+    ASSERT_EQ(TF_OK, TF_GetCode(status)) << TF_Message(status);
+
+    ExpectValues(square, {7, 10, 15, 22}, status);
+    ExpectValues(cube, {37, 54, 81, 118}, status);
+    TFE_DeleteTensorHandle(square);
+    TFE_DeleteTensorHandle(cube);
+  }
+  EagerTraceCache::Stats stats = TraceCacheStats(ctx);
+  EXPECT_EQ(2, stats.traced_iterations);
+  EXPECT_EQ(2, stats.replayed_iterations);
+  EXPECT_EQ(0, stats.fallbacks);
+  EXPECT_EQ(1, stats.compiled_traces);
+
+  TFE_DeleteTensorHandle(m);
+  TFE_DeleteContext(ctx);
+  TF_DeleteStatus(status);
+}
+
+TEST(CAPI, TraceCacheFallsBack) {
+  TF_Status* status = TF_NewStatus();
+  TFE_ContextOptions* opts = TFE_NewContextOptions();
+  TFE_Context* ctx = TFE_NewContext(opts, status);
+  CHECK_EQ(TF_OK, TF_GetCode(status)) << TF_Message(status);
+  TFE_DeleteContextOptions(opts);
+  TFE_ContextSetTraceCacheIterations(ctx, 2, status);
+  CHECK_EQ(TF_OK, TF_GetCode(status)) << TF_Message(status);
+
+  TFE_TensorHandle* m = TestMatrixTensorHandle(ctx);
+  TFE_TensorHandle* m3x2 = TestMatrixTensorHandle3X2(ctx);
+  for (int i = 0; i < 4; ++i) {
+    // The third iteration reads a value before the end, the last one runs on
+    // an input of a different shape.
+    TFE_TensorHandle* input = i < 3 ? m : m3x2;
+    TFE_ContextBeginTracedIteration(ctx, status);
+    ASSERT_EQ(TF_OK, TF_GetCode(status)) << TF_Message(status);
+    TFE_TensorHandle* twice = ExecuteOp(AddOp(ctx, input, input), status);
+    ASSERT_EQ(TF_OK, TF_GetCode(status)) << TF_Message(status);
+    if (i == 2) ExpectValues(twice, {2, 4, 6, 8}, status);
+    TFE_TensorHandle* sum = ExecuteOp(AddOp(ctx, twice, input), status);
+    ASSERT_EQ(TF_OK, TF_GetCode(status)) << TF_Message(status);
+    TFE_ContextEndTracedIteration(ctx, status);
+    ASSERT_EQ(TF_OK, TF_GetCode(status)) << TF_Message(status);
+
+    if (i < 3) {
+      ExpectValues(sum, {3, 6, 9, 12}, status);
+    } else {
+      ExpectValues(sum, {3, 6, 9, 12, 15, 18}, status);
+    }
+    TFE_DeleteTensorHandle(twice);
+    TFE_DeleteTensorHandle(sum);
+  }
+  EagerTraceCache::Stats stats = TraceCacheStats(ctx);
+  EXPECT_EQ(4, stats.traced_iterations);
+  EXPECT_EQ(0, stats.replayed_iterations);
+  EXPECT_EQ(2, stats.fallbacks);
+  EXPECT_EQ(1, stats.compiled_traces);
+
+  TFE_DeleteTensorHandle(m);
+  TFE_DeleteTensorHandle(m3x2);
+  TFE_DeleteContext(ctx);
+  TF_DeleteStatus(status);
+}
+
 }  // namespace
 }  // namespace tensorflow
@@ -94,6 +94,19 @@ void TestRemoteExecute(bool async) {
   EXPECT_EQ(15, product[2]);
   EXPECT_EQ(22, product[3]);
 
+  // The fetched value is kept as a host mirror and reused by later resolves.
+  tensorflow::TensorHandle* remote_handle =
+      tensorflow::TensorHandleFromInterface(tensorflow::unwrap(retvals[0]));
+  EXPECT_TRUE(remote_handle->HasLocalMirror(nullptr));
+  t = TFE_TensorHandleResolve(retvals[0], status);
+  ASSERT_EQ(TF_OK, TF_GetCode(status)) << TF_Message(status);
+  float product_again[4] = {0};
+  memcpy(&product_again[0], TF_TensorData(t), TF_TensorByteSize(t));
+  TF_DeleteTensor(t);
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_EQ(product[i], product_again[i]);
+  }
+
   TFE_DeleteTensorHandle(h0_task0);
   TFE_DeleteTensorHandle(h1_task0);
   TFE_DeleteTensorHandle(h0_task1);
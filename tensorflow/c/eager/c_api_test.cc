@@ -149,6 +149,43 @@ void BM_Execute_Identity(int iters, int async) {
 }
 BENCHMARK(BM_Execute_Identity)->Arg(0)->Arg(1);
 
+// Measures per-op dispatch overhead with a scalar op whose kernel is trivial.
+// With `alternate` set, the reused op object switches between two ops and so
+// cannot reuse the kernel of its previous execution.
+void BM_Execute_ScalarDispatch(int iters, int alternate) {
+  tensorflow::testing::StopTiming();
+  tensorflow::testing::SetLabel(alternate ? "Alternating" : "Repeated");
+  TF_Status* status = TF_NewStatus();
+  TFE_ContextOptions* opts = TFE_NewContextOptions();
+  TFE_Context* ctx = TFE_NewContext(opts, status);
+  CHECK_EQ(TF_OK, TF_GetCode(status)) << TF_Message(status);
+  TFE_DeleteContextOptions(opts);
+
+  TFE_TensorHandle* x = TestScalarTensorHandle(ctx, 1.0f);
+  TFE_Op* op = TFE_NewOp(ctx, "AddV2", status);
+  CHECK_EQ(TF_OK, TF_GetCode(status)) << TF_Message(status);
+  TFE_TensorHandle* retvals[1];
+  tensorflow::testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    TFE_OpReset(op, (alternate && i % 2) ? "Mul" : "AddV2", nullptr, status);
+    CHECK_EQ(TF_OK, TF_GetCode(status)) << TF_Message(status);
+    TFE_OpAddInput(op, x, status);
+    CHECK_EQ(TF_OK, TF_GetCode(status)) << TF_Message(status);
+    TFE_OpAddInput(op, x, status);
+    CHECK_EQ(TF_OK, TF_GetCode(status)) << TF_Message(status);
+    int num_retvals = 1;
+    TFE_Execute(op, &retvals[0], &num_retvals, status);
+    CHECK_EQ(TF_OK, TF_GetCode(status)) << TF_Message(status);
+    TFE_DeleteTensorHandle(retvals[0]);
+  }
+  tensorflow::testing::StopTiming();
+  TFE_DeleteOp(op);
+  TFE_DeleteTensorHandle(x);
+  TFE_DeleteContext(ctx);
+  TF_DeleteStatus(status);
+}
+BENCHMARK(BM_Execute_ScalarDispatch)->Arg(0)->Arg(1);
+
 TEST(CAPI, Context) {
   TF_Status* status = TF_NewStatus();
   TFE_ContextOptions* opts = TFE_NewContextOptions();
@@ -51,8 +51,8 @@ auto* load_latency_by_stage = monitoring::Sampler<2>::New(
     {
         "/tensorflow/cc/saved_model/load_latency_by_stage",  // metric name
         "Distribution of wall time spent (in microseconds) in each stage "
-        "(restore graph from disk, run init graph op, etc) when loading the "
-        "model",
+        "(read meta graph, create session, restore variables, run init graph "
+        "op, etc) when loading the model",
         "model_path",
         "stage",
     },
@@ -256,9 +256,16 @@ Status LoadSavedModelInternal(const SessionOptions& session_options,
                                                     &bundle->meta_graph_def));
   TF_RETURN_IF_ERROR(
       ReadSavedModelDebugInfoIfPresent(export_dir, &bundle->debug_info));
+  const uint64 read_meta_graph_walltime =
+      GetLatencyMicroseconds(read_start_microseconds);
+
+  const uint64 session_start_microseconds = Env::Default()->NowMicros();
   TF_RETURN_IF_ERROR(LoadMetaGraphIntoSession(
       bundle->meta_graph_def, session_options, &bundle->session));
+  const uint64 create_session_walltime =
+      GetLatencyMicroseconds(session_start_microseconds);
 
+  const uint64 restore_start_microseconds = Env::Default()->NowMicros();
   std::vector<AssetFileDef> asset_file_defs;
   TF_RETURN_IF_ERROR(
       internal::GetAssetFileDefs(bundle->meta_graph_def, &asset_file_defs));
@@ -269,6 +276,8 @@ Status LoadSavedModelInternal(const SessionOptions& session_options,
                  asset_file_defs, bundle->session.get()));
   // Record walltime spent in restoring graph from disk, but postpone metric
   // increments until graph init finishes.
+  const uint64 restore_variables_walltime =
+      GetLatencyMicroseconds(restore_start_microseconds);
   const uint64 restore_graph_walltime =
       GetLatencyMicroseconds(read_start_microseconds);
 
@@ -279,11 +288,25 @@ Status LoadSavedModelInternal(const SessionOptions& session_options,
   TF_RETURN_IF_ERROR(RunInitOp(run_options, export_dir, bundle->meta_graph_def,
                                asset_file_defs, bundle->session.get(),
                                init_op_name));
+  const uint64 init_graph_walltime =
+      GetLatencyMicroseconds(graph_init_start_microseconds);
+  // "restore_graph" covers the first three stages.
+  load_latency_by_stage->GetCell(export_dir, "read_meta_graph")
+      ->Add(read_meta_graph_walltime);
+  load_latency_by_stage->GetCell(export_dir, "create_session")
+      ->Add(create_session_walltime);
+  load_latency_by_stage->GetCell(export_dir, "restore_variables")
+      ->Add(restore_variables_walltime);
   load_latency_by_stage->GetCell(export_dir, "restore_graph")
       ->Add(restore_graph_walltime);
   // Record wall time spent in init op.
   load_latency_by_stage->GetCell(export_dir, "init_graph")
-      ->Add(GetLatencyMicroseconds(graph_init_start_microseconds));
+      ->Add(init_graph_walltime);
+  LOG(INFO) << "SavedModel load stages in microseconds: read_meta_graph: "
+            << read_meta_graph_walltime
+            << ", create_session: " << create_session_walltime
+            << ", restore_variables: " << restore_variables_walltime
+            << ", init_graph: " << init_graph_walltime << ".";
   return Status::OK();
 }
 
@@ -129,7 +129,13 @@ void AppendMarkForCompilationPassFlagsInternal(std::vector<Flag>* flag_list) {
            &mark_for_compilation_flags
                 ->tf_xla_disable_resource_variable_safety_checks_for_debugging,
            "Disable resource variables related safety checks when clustering "
-           "(this is unsound).")};
+           "(this is unsound)."),
+      Flag("tf_xla_decluster_unprofitable_clusters",
+           &mark_for_compilation_flags->tf_xla_decluster_unprofitable_clusters,
+           "(experimental) Do not compile auto-clustered clusters whose "
+           "estimated cost when compiled, including the recompilations their "
+           "inputs of unknown shape may cause, is not lower than the "
+           "estimated cost of running their ops in the TF executor.")};
   flag_list->insert(flag_list->end(), new_flags.begin(), new_flags.end());
 }
 
@@ -156,6 +162,7 @@ void AllocateAndParseFlags() {
       ->tf_xla_disable_deadness_safety_checks_for_debugging = false;
   mark_for_compilation_flags
       ->tf_xla_disable_resource_variable_safety_checks_for_debugging = false;
+  mark_for_compilation_flags->tf_xla_decluster_unprofitable_clusters = false;
 
   device_flags = new XlaDeviceFlags;
   device_flags->tf_xla_compile_on_demand = false;
@@ -163,6 +170,8 @@ void AllocateAndParseFlags() {
 
   ops_flags = new XlaOpsCommonFlags;
   ops_flags->tf_xla_always_defer_compilation = false;
+  ops_flags->tf_xla_enable_shape_bucketing = false;
+  ops_flags->tf_xla_async_compilation = false;
 
   jitter_flags = new IntroduceFloatingPointJitterPassFlags;
   jitter_flags->jitter_amount = 1e-5;
@@ -207,6 +216,16 @@ void AllocateAndParseFlags() {
 
        Flag("tf_xla_always_defer_compilation",
             &ops_flags->tf_xla_always_defer_compilation, ""),
+       Flag("tf_xla_enable_shape_bucketing",
+            &ops_flags->tf_xla_enable_shape_bucketing,
+            "If true then cluster inputs whose shapes vary between executions "
+            "are padded to learned buckets, so that one executable serves many "
+            "shapes."),
+       Flag("tf_xla_async_compilation",
+            &ops_flags->tf_xla_async_compilation,
+            "If true then lazily compiled clusters are compiled on a "
+            "background thread, and run in the TF executor until their "
+            "compilation finishes."),
 
        Flag("tf_introduce_floating_point_jitter_to_tensors",
             setter_for_jitter_tensor_names, "",
@@ -78,6 +78,10 @@ struct MarkForCompilationPassFlags {
   // variable concurrency semantics.  This is unsound in general, but can be
   // used as a debugging aid.
   bool tf_xla_disable_resource_variable_safety_checks_for_debugging;
+
+  // If true, auto-clustered clusters whose estimated cost when compiled is not
+  // lower than their estimated cost in the TF executor are not compiled.
+  bool tf_xla_decluster_unprofitable_clusters;
 };
 
 // Flags associated with the XLA bridge's xla_device module.
@@ -97,6 +101,17 @@ struct XlaOpsCommonFlags {
   // If true, _XlaCompile always refuses to compile the cluster, which means the
   // XLA clusters always run in the TF executor.  Defaults to false.
   bool tf_xla_always_defer_compilation;
+
+  // If true, the dimensions of cluster inputs whose sizes vary between
+  // executions are padded to buckets learned from the sizes seen, so that one
+  // executable serves all the shapes of a bucket.  Only applies to devices with
+  // a stream.  Defaults to false.
+  bool tf_xla_enable_shape_bucketing;
+
+  // If true, _XlaCompile compiles the clusters it may defer on a background
+  // thread, and the clusters run in the TF executor until their compilation
+  // finishes.  Defaults to false.
+  bool tf_xla_async_compilation;
 };
 
 // Flags for the build_xla_ops pass.
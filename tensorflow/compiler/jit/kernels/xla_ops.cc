@@ -168,7 +168,8 @@ static Status CompileToLocalExecutable(
     absl::Span<const int> constants, bool lazy, bool may_alias_resource_update,
     xla::LocalClient** client,
     const XlaCompiler::CompilationResult** compilation_result,
-    xla::LocalExecutable** executable) {
+    xla::LocalExecutable** executable,
+    XlaCompilationCache** cache_out = nullptr) {
   // We store information about the JIT-compiled XLA computation
   // in the ResourceMgr.
   ResourceMgr* rm = ctx->resource_manager();
@@ -186,6 +187,10 @@ static Status CompileToLocalExecutable(
   // free it sooner because the ResourceMgr will retain a reference, but
   // this is more obviously correct.)
   core::ScopedUnref cache_ref(cache);
+  if (cache_out != nullptr) {
+    cache->Ref();
+    *cache_out = cache;
+  }
 
   *client = static_cast<xla::LocalClient*>(cache->client());
 
@@ -210,10 +215,59 @@ static Status CompileToLocalExecutable(
   std::vector<XlaCompiler::Argument> args;
   TF_RETURN_IF_ERROR(XlaComputationLaunchContext::BuildXlaCompilerArguments(
       constant_args, variable_infos, ctx, &args));
+  XlaCompilationCache::CompileMode compile_mode =
+      XlaCompilationCache::CompileMode::kStrict;
+  if (lazy) {
+    compile_mode = GetXlaOpsCommonFlags().tf_xla_async_compilation
+                       ? XlaCompilationCache::CompileMode::kAsync
+                       : XlaCompilationCache::CompileMode::kLazy;
+  }
+
+  // Reading the dynamic shapes of the results needs a stream.
+  const bool has_stream =
+      ctx->op_device_context() && ctx->op_device_context()->stream();
+  if (GetXlaOpsCommonFlags().tf_xla_enable_shape_bucketing && has_stream &&
+      !platform_info.is_on_xla_device()) {
+    std::vector<XlaCompiler::Argument> padded_args = args;
+    if (cache->PadArgumentsToBuckets(function, &padded_args)) {
+      Status status =
+          cache->Compile(options, function, padded_args, compile_options,
+                         compile_mode, compilation_result, executable);
+      if (status.ok()) {
+        return status;
+      }
+      // Not every op supports dynamic dimensions. Fall back to compiling the
+      // exact shapes from now on.
+      VLOG(1) << "Disabling shape bucketing for " << function.name()
+              << " after failing to compile it with padded arguments: "
+              << status;
+      cache->DisableShapeBucketing(function);
+    }
+  }
   return cache->Compile(options, function, args, compile_options,
-                        lazy ? XlaCompilationCache::CompileMode::kLazy
-                             : XlaCompilationCache::CompileMode::kStrict,
-                        compilation_result, executable);
+                        compile_mode, compilation_result, executable);
+}
+
+std::shared_ptr<const XlaInputPlan> XlaLocalLaunchBase::GetInputPlan(
+    XlaCompilationCache* cache, const xla::LocalExecutable* executable,
+    const XlaCompiler::CompilationResult* compilation_result,
+    const XlaComputationLaunchContext& launch_context) {
+  mutex_lock lock(input_plans_mu_);
+  if (input_plans_cache_.get() != cache) {
+    // The cache was replaced, and the executables of the previous one will be
+    // released with it.
+    input_plans_.clear();
+    cache->Ref();
+    input_plans_cache_.reset(cache);
+  }
+  std::shared_ptr<const XlaInputPlan>& input_plan = input_plans_[executable];
+  if (!input_plan) {
+    input_plan = std::make_shared<const XlaInputPlan>(
+        launch_context.BuildInputPlan(
+            compilation_result,
+            executable->executable()->module().input_output_alias_config()));
+  }
+  return input_plan;
 }
 
 void XlaLocalLaunchBase::Compute(OpKernelContext* ctx) {
@@ -223,6 +277,7 @@ void XlaLocalLaunchBase::Compute(OpKernelContext* ctx) {
   xla::LocalClient* client;
   const XlaCompiler::CompilationResult* compilation_result;
   xla::LocalExecutable* executable;
+  XlaCompilationCache* cache = nullptr;
 
   std::vector<VariableInfo> variable_infos;
   {
@@ -233,9 +288,10 @@ void XlaLocalLaunchBase::Compute(OpKernelContext* ctx) {
         ctx, function_, /*has_ref_vars=*/has_ref_vars_, platform_info_,
         variable_infos, constants_, /*lazy=*/false,
         /*may_alias_resource_update=*/true, &client, &compilation_result,
-        &executable);
+        &executable, &cache);
     OP_REQUIRES_OK(ctx, s);
   }
+  core::ScopedUnref cache_ref(cache);
 
   std::map<int, const Tensor*> resource_var_ptrs;
   for (int i = 0; i < resources_.size(); i++) {
@@ -258,10 +314,12 @@ void XlaLocalLaunchBase::Compute(OpKernelContext* ctx) {
       platform_info_.UseMultipleStreams());
   const xla::HloInputOutputAliasConfig& input_output_alias =
       executable->executable()->module().input_output_alias_config();
+  std::shared_ptr<const XlaInputPlan> input_plan =
+      GetInputPlan(cache, executable, compilation_result, launch_context);
   xla::StatusOr<std::vector<xla::ExecutionInput>> execution_inputs =
       launch_context.PopulateInputs(ctx, compilation_result, resource_var_ptrs,
                                     /*missing_ctx_input_prefix=*/0,
-                                    input_output_alias);
+                                    *input_plan);
   OP_REQUIRES_OK(ctx, execution_inputs.status());
 
   // Execute the computation.
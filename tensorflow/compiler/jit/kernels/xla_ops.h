@@ -17,6 +17,9 @@ limitations under the License.
 #define TENSORFLOW_COMPILER_JIT_KERNELS_XLA_OPS_H_
 
 #include <atomic>
+#include <memory>
+
+#include "absl/container/flat_hash_map.h"
 
 #include "tensorflow/compiler/jit/xla_compilation_cache.h"
 #include "tensorflow/compiler/jit/xla_device.h"
@@ -27,6 +30,9 @@ limitations under the License.
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/refcount.h"
+#include "tensorflow/core/platform/thread_annotations.h"
 #include "tensorflow/core/util/stream_executor_util.h"
 #include "tensorflow/stream_executor/tf_allocator_adapter.h"
 
@@ -66,6 +72,23 @@ class XlaLocalLaunchBase : public OpKernel {
   const XlaPlatformInfo platform_info_;
 
   bool has_ref_vars_;
+
+ private:
+  // Returns the input plan of `executable`, an executable of `cache`, building
+  // it on its first launch.
+  std::shared_ptr<const XlaInputPlan> GetInputPlan(
+      XlaCompilationCache* cache, const xla::LocalExecutable* executable,
+      const XlaCompiler::CompilationResult* compilation_result,
+      const XlaComputationLaunchContext& launch_context);
+
+  mutex input_plans_mu_;
+  // The compilation cache the executables in `input_plans_` belong to.  The
+  // reference keeps them alive while they are keys of `input_plans_`.
+  core::RefCountPtr<XlaCompilationCache> input_plans_cache_
+      TF_GUARDED_BY(input_plans_mu_);
+  absl::flat_hash_map<const xla::LocalExecutable*,
+                      std::shared_ptr<const XlaInputPlan>>
+      input_plans_ TF_GUARDED_BY(input_plans_mu_);
 };
 
 // XlaLocalLaunchOp is used to replace a region of the TensorFlow graph
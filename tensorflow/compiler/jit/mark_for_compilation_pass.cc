@@ -25,6 +25,8 @@ limitations under the License.
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/strings/str_join.h"
+#include "absl/types/optional.h"
+#include "absl/types/span.h"
 #include "tensorflow/compiler/jit/compilability_check_util.h"
 #include "tensorflow/compiler/jit/deadness_analysis.h"
 #include "tensorflow/compiler/jit/defs.h"
@@ -32,7 +34,9 @@ limitations under the License.
 #include "tensorflow/compiler/jit/flags.h"
 #include "tensorflow/compiler/jit/graphcycles/graphcycles.h"
 #include "tensorflow/compiler/jit/resource_operation_safety_analysis.h"
+#include "tensorflow/compiler/jit/shape_inference.h"
 #include "tensorflow/compiler/jit/union_find.h"
+#include "tensorflow/compiler/jit/xla_activity_listener.h"
 #include "tensorflow/compiler/jit/xla_cluster_util.h"
 #include "tensorflow/compiler/tf2xla/const_analysis.h"
 #include "tensorflow/compiler/tf2xla/resource_operation_table.h"
@@ -106,6 +110,10 @@ class MarkForCompilationPassImpl {
     std::atomic<int64>* fuel;
 
     bool dump_graphs;
+
+    // If true, do not compile auto-clustered clusters that are estimated to
+    // run slower compiled than in the TF executor.
+    bool decluster_unprofitable_clusters;
   };
 
   MarkForCompilationPassImpl(DebugOptions debug_options, Graph* graph,
@@ -301,6 +309,12 @@ class MarkForCompilationPassImpl {
 
   StatusOr<bool> ShouldCompileCluster(const Cluster& cluster);
 
+  // Returns whether compiling `cluster`, made of `cluster_nodes`, is estimated
+  // to be cheaper than running its nodes in the TF executor.  Clusters that
+  // must be compiled are always profitable.
+  StatusOr<bool> IsProfitableToCompile(const Cluster& cluster,
+                                       absl::Span<Node* const> cluster_nodes);
+
   StatusOr<bool> ClusteringWillIntroduceInterDeviceDependency(
       const Cluster& from, const Cluster& to);
 
@@ -429,6 +443,10 @@ class MarkForCompilationPassImpl {
   absl::flat_hash_map<const Cluster*, bool> should_compile_cluster_cache_;
   jit::DeviceInfoCache device_info_cache_;
 
+  // The shapes of the outputs of the nodes in `graph_`, inferred the first
+  // time a cluster's profitability is estimated.
+  absl::optional<GraphShapeInfo> shape_info_;
+
   bool initialized_ = false;
   bool edges_contracted_ = false;
   bool clusters_created_ = false;
@@ -860,7 +878,10 @@ Status MarkForCompilationPassImpl::CreateClusters() {
   // * are explicitly marked for compilation (_XlaCompile=true), or
   // * have more than debug_options_.xla_min_cluster_size elements (applicable
   //   only if compilation is enabled, otherwise there will be no such
-  //   candidates).
+  //   candidates), and are estimated to be profitable to compile if
+  //   debug_options_.decluster_unprofitable_clusters is set.
+  std::vector<Node*> nodes_to_cluster;
+  absl::flat_hash_map<Cluster*, std::vector<Node*>> nodes_by_cluster;
   for (Node* n : compilation_candidates_) {
     Cluster* cluster = GetClusterForNode(n);
     TF_ASSIGN_OR_RETURN(bool should_compile_cluster,
@@ -877,21 +898,152 @@ Status MarkForCompilationPassImpl::CreateClusters() {
     if (cluster->effective_cluster_size() >= debug_options_.min_cluster_size ||
         cluster->has_functional_control_flow() ||
         cluster->is_xla_compile_attr_true()) {
-      string& name = cluster_names[cluster->cycles_graph_node_id()];
+      nodes_to_cluster.push_back(n);
+      nodes_by_cluster[cluster].push_back(n);
+    }
+  }
 
-      if (name.empty()) {
-        name = absl::StrCat("cluster_", GetNextClusterSequenceNumber());
+  absl::flat_hash_set<const Cluster*> unprofitable_clusters;
+  if (debug_options_.decluster_unprofitable_clusters) {
+    for (const auto& cluster_and_nodes : nodes_by_cluster) {
+      const Cluster& cluster = *cluster_and_nodes.first;
+      TF_ASSIGN_OR_RETURN(
+          bool profitable,
+          IsProfitableToCompile(cluster, cluster_and_nodes.second));
+      if (!profitable) {
+        unprofitable_clusters.insert(&cluster);
+        BroadcastOptimizationRemark(XlaOptimizationRemark::UNPROFITABLE_CLUSTER,
+                                    cluster.DebugString(*graph_))
+            .IgnoreError();
       }
+    }
+  }
 
-      n->AddAttr(kXlaClusterAttr, name);
-      n->AddAttr(kXlaAlreadyClustered, true);
-      VLOG(3) << "Assigning node " << n->name() << " to cluster " << name;
+  for (Node* n : nodes_to_cluster) {
+    Cluster* cluster = GetClusterForNode(n);
+    if (unprofitable_clusters.contains(cluster)) {
+      continue;
     }
+
+    string& name = cluster_names[cluster->cycles_graph_node_id()];
+
+    if (name.empty()) {
+      name = absl::StrCat("cluster_", GetNextClusterSequenceNumber());
+    }
+
+    n->AddAttr(kXlaClusterAttr, name);
+    n->AddAttr(kXlaAlreadyClustered, true);
+    VLOG(3) << "Assigning node " << n->name() << " to cluster " << name;
   }
 
   return Status::OK();
 }
 
+// Ops that XLA lowers to the same library calls as their TF kernels make, so
+// that compiling them only saves their dispatch.
+bool IsLibraryCallOp(const Node& node) {
+  static const auto* const kLibraryCallOps = new absl::flat_hash_set<string>{
+      "BatchMatMul",
+      "BatchMatMulV2",
+      "Conv2D",
+      "Conv2DBackpropFilter",
+      "Conv2DBackpropInput",
+      "Conv3D",
+      "Conv3DBackpropFilterV2",
+      "Conv3DBackpropInputV2",
+      "DepthwiseConv2dNative",
+      "DepthwiseConv2dNativeBackpropFilter",
+      "DepthwiseConv2dNativeBackpropInput",
+      "MatMul",
+  };
+  return kLibraryCallOps->contains(node.type_string());
+}
+
+// Elementwise ops and reductions, which XLA fuses with their neighbours.
+bool IsFusibleOp(const Node& node) {
+  static const auto* const kFusibleOps = [] {
+    auto* ops = new absl::flat_hash_set<string>;
+    for (const char* category : {"PW", "RED", "PWRED"}) {
+      const std::vector<string>& category_ops =
+          GetAllowlistTable()->at(category);
+      ops->insert(category_ops.begin(), category_ops.end());
+    }
+    return ops;
+  }();
+  return kFusibleOps->contains(node.type_string());
+}
+
+StatusOr<bool> MarkForCompilationPassImpl::IsProfitableToCompile(
+    const Cluster& cluster, absl::Span<Node* const> cluster_nodes) {
+  // We do not know what the functional control flow in a cluster costs, see
+  // CreateClusters.
+  if (cluster.is_xla_compile_attr_true() ||
+      cluster.has_functional_control_flow()) {
+    return true;
+  }
+  TF_ASSIGN_OR_RETURN(DeviceId chosen_device,
+                      PickDeviceForXla(device_info_cache_, cluster.devices(),
+                                       /*allow_mixing_unknown_and_cpu=*/false));
+  const XlaOpRegistry::DeviceRegistration* registration =
+      device_info_cache_.GetCompilationDevice(chosen_device);
+  TF_RET_CHECK(registration);
+  if (registration->autoclustering_policy ==
+      XlaOpRegistry::AutoclusteringPolicy::kAlways) {
+    return true;
+  }
+
+  if (!shape_info_.has_value()) {
+    GraphShapeInfo shape_info;
+    Status status =
+        InferShapes(graph_, /*arg_shapes=*/{}, flib_def_, &shape_info);
+    if (!status.ok()) {
+      VLOG(2) << "Could not infer the shapes of the graph, assuming the "
+                 "inputs of all clusters have static shapes: "
+              << status;
+      shape_info.clear();
+    }
+    shape_info_ = std::move(shape_info);
+  }
+
+  int fusible_ops = 0;
+  int library_call_ops = 0;
+  absl::flat_hash_set<std::pair<int, int>> dynamic_inputs;
+  for (Node* n : cluster_nodes) {
+    fusible_ops += IsFusibleOp(*n);
+    library_call_ops += IsLibraryCallOp(*n);
+    for (const Edge* e : n->in_edges()) {
+      if (e->IsControlEdge() || (IsCompilationCandidate(e->src()) &&
+                                 GetClusterForNode(e->src()) == &cluster)) {
+        continue;
+      }
+      auto it = shape_info_->find(e->src()->name());
+      if (it != shape_info_->end() && e->src_output() < it->second.size() &&
+          !it->second[e->src_output()].shape.IsFullyDefined()) {
+        dynamic_inputs.insert({e->src()->id(), e->src_output()});
+      }
+    }
+  }
+
+  // The costs are in units of the cost of running one op in the TF executor.
+  //
+  // In the executor, every op is dispatched on its own, and the outputs of the
+  // ops XLA fuses make a round trip through memory.  Compiled, the cluster is
+  // launched once, after which only its library calls are separate kernels,
+  // but every input of unknown shape may have it recompiled for each shape the
+  // input takes.
+  constexpr double kClusterLaunchCost = 4;
+  constexpr double kRecompilationCost = 8;
+  const double interpreted_cost = cluster_nodes.size() + fusible_ops;
+  const double compiled_cost = kClusterLaunchCost + library_call_ops +
+                               kRecompilationCost * dynamic_inputs.size();
+  VLOG(2) << "Estimated cost of " << cluster.DebugString(*graph_) << ": "
+          << compiled_cost << " compiled, " << interpreted_cost
+          << " interpreted (" << fusible_ops << " fusible ops, "
+          << library_call_ops << " library calls, " << dynamic_inputs.size()
+          << " inputs of unknown shape)";
+  return compiled_cost < interpreted_cost;
+}
+
 Status MarkForCompilationPassImpl::DumpDebugInfo() {
   TF_RET_CHECK(initialized_ && edges_contracted_ && clusters_created_);
 
@@ -1759,6 +1911,8 @@ Status MarkForCompilationPass::Run(
   debug_options.min_cluster_size = flags->tf_xla_min_cluster_size;
   debug_options.fuel = GetPointerToFuel(flags->tf_xla_clustering_fuel);
   debug_options.dump_graphs = flags->tf_xla_clustering_debug;
+  debug_options.decluster_unprofitable_clusters =
+      flags->tf_xla_decluster_unprofitable_clusters;
 
   return MarkForCompilation(options, debug_options);
 }
@@ -1777,6 +1931,8 @@ Status MarkForCompilationPass::RunForTest(
   debug_options.min_cluster_size = flags->tf_xla_min_cluster_size;
   debug_options.fuel = GetPointerToFuel(flags->tf_xla_clustering_fuel);
   debug_options.dump_graphs = flags->tf_xla_clustering_debug;
+  debug_options.decluster_unprofitable_clusters =
+      flags->tf_xla_decluster_unprofitable_clusters;
 
   return MarkForCompilation(options, debug_options);
 }
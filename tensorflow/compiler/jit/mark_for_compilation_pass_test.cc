@@ -26,6 +26,7 @@ limitations under the License.
 #include "tensorflow/cc/ops/sendrecv_ops.h"
 #include "tensorflow/cc/ops/standard_ops.h"
 #include "tensorflow/compiler/jit/defs.h"
+#include "tensorflow/compiler/jit/flags.h"
 #include "tensorflow/compiler/jit/mark_for_compilation_pass_test_helper.h"
 #include "tensorflow/compiler/jit/node_matchers.h"
 #include "tensorflow/compiler/tf2xla/xla_op_kernel.h"
@@ -37,6 +38,7 @@ limitations under the License.
 #include "tensorflow/core/graph/algorithm.h"
 #include "tensorflow/core/graph/graph_def_builder.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/gtl/cleanup.h"
 #include "tensorflow/core/platform/test.h"
 
 using ::tensorflow::testing::FindNodeByName;
@@ -1807,6 +1809,40 @@ TEST(XlaCompilationTest, StagePipelinePreservedByClusterScopingPass) {
     EXPECT_NE(clusters["relu0"], clusters["relu1"]);
   }
 }
+TEST(XlaCompilationTest, DeclusterUnprofitableClusters) {
+  MarkForCompilationPassFlags* flags = GetMarkForCompilationPassFlags();
+  flags->tf_xla_decluster_unprofitable_clusters = true;
+  auto reset_flag = gtl::MakeCleanup(
+      [&] { flags->tf_xla_decluster_unprofitable_clusters = false; });
+
+  Scope root = Scope::NewRootScope().ExitOnError();
+  // Compiling the chain fed by `static_input` saves the dispatch of its ops,
+  // which is not worth the recompilations `dynamic_input` may cause.
+  Output static_input = ops::Placeholder(
+      root.WithOpName("static_input"), DT_FLOAT,
+      ops::Placeholder::Shape(PartialTensorShape({2, 2})));
+  Output dynamic_input = ops::Placeholder(
+      root.WithOpName("dynamic_input"), DT_FLOAT,
+      ops::Placeholder::Shape(PartialTensorShape({-1, 2})));
+  Output a = ops::Relu(root.WithOpName("A"), static_input);
+  Output b = ops::Relu(root.WithOpName("B"), a);
+  ops::Relu(root.WithOpName("C"), b);
+  Output d = ops::Relu(root.WithOpName("D"), dynamic_input);
+  Output e = ops::Relu(root.WithOpName("E"), d);
+  ops::Relu(root.WithOpName("F"), e);
+
+  std::unique_ptr<Graph> graph(new Graph(OpRegistry::Global()));
+  TF_ASSERT_OK(root.ToGraph(graph.get()));
+  TF_ASSERT_OK(MarkForCompilationPassTestHelper::MarkForCompilation(&graph));
+  auto clusters = GetClusters(*graph);
+
+  EXPECT_EQ(3, clusters.size());
+  EXPECT_FALSE(clusters["A"].empty());
+  EXPECT_EQ(clusters["A"], clusters["B"]);
+  EXPECT_EQ(clusters["A"], clusters["C"]);
+  EXPECT_TRUE(clusters.find("D") == clusters.cend());
+}
+
 TEST(XlaCompilationTest, XLALiteAllowlist) {
   auto* allowlist_table = tensorflow::GetAllowlistTable();
   absl::flat_hash_set<string> hallowlist;
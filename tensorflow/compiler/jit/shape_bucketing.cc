@@ -0,0 +1,120 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/jit/shape_bucketing.h"
+
+#include <algorithm>
+
+#include "absl/algorithm/container.h"
+#include "absl/strings/str_join.h"
+#include "tensorflow/compiler/tf2xla/shape_util.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+
+absl::optional<int64> DimensionBucketer::Bucket(int64 size) {
+  ++histogram_[size];
+  if (histogram_.size() < options_.min_distinct_sizes) {
+    return absl::nullopt;
+  }
+  if (buckets_.empty() || size > buckets_.back()) {
+    LearnBuckets();
+  }
+  return *std::lower_bound(buckets_.begin(), buckets_.end(), size);
+}
+
+void DimensionBucketer::LearnBuckets() {
+  struct Group {
+    int64 min_size;
+    int64 bound;
+    // The number of observations of the sizes in the group.
+    int64 count;
+  };
+  std::vector<Group> groups;
+  for (const auto& size_and_count : histogram_) {
+    const int64 size = size_and_count.first;
+    if (groups.empty() ||
+        size > groups.back().min_size * (1.0 + options_.max_padding_fraction)) {
+      groups.push_back({size, size, size_and_count.second});
+    } else {
+      groups.back().bound = size;
+      groups.back().count += size_and_count.second;
+    }
+  }
+  while (groups.size() > std::max(options_.max_buckets, 1)) {
+    // Merging a group into the next one pads each of its observations to the
+    // bound of the next group.
+    auto padding = [&](int i) {
+      return groups[i].count * (groups[i + 1].bound - groups[i].bound);
+    };
+    int best = 0;
+    for (int i = 1; i + 1 < groups.size(); ++i) {
+      if (padding(i) < padding(best)) {
+        best = i;
+      }
+    }
+    groups[best + 1].min_size = groups[best].min_size;
+    groups[best + 1].count += groups[best].count;
+    groups.erase(groups.begin() + best);
+  }
+  buckets_.clear();
+  for (const Group& group : groups) {
+    buckets_.push_back(group.bound);
+  }
+  VLOG(2) << "Learned shape buckets " << absl::StrJoin(buckets_, ",")
+          << " from " << histogram_.size() << " distinct sizes";
+}
+
+bool ArgumentBucketer::PadArguments(std::vector<XlaCompiler::Argument>* args) {
+  if (absl::c_any_of(*args, [](const XlaCompiler::Argument& arg) {
+        return arg.kind == XlaCompiler::Argument::kResource;
+      })) {
+    return false;
+  }
+  bool padded = false;
+  for (int i = 0; i < args->size(); ++i) {
+    XlaCompiler::Argument& arg = (*args)[i];
+    if (arg.kind != XlaCompiler::Argument::kParameter ||
+        !absl::holds_alternative<TensorShape>(arg.shape)) {
+      continue;
+    }
+    TensorShape shape = absl::get<TensorShape>(arg.shape);
+    std::vector<int> dynamic_dimensions;
+    for (int d = 0; d < shape.dims(); ++d) {
+      DimensionBucketer& bucketer =
+          dimensions_.try_emplace({i, d}, options_).first->second;
+      absl::optional<int64> bucket = bucketer.Bucket(shape.dim_size(d));
+      if (bucket.has_value()) {
+        shape.set_dim(d, *bucket);
+        dynamic_dimensions.push_back(d);
+      }
+    }
+    if (dynamic_dimensions.empty()) {
+      continue;
+    }
+    xla::Shape xla_shape;
+    if (!TensorShapeToXLAShape(arg.type, shape, &xla_shape).ok()) {
+      continue;
+    }
+    for (int d : dynamic_dimensions) {
+      xla_shape.set_dynamic_dimension(d, true);
+    }
+    arg.shape = xla_shape;
+    padded = true;
+  }
+  return padded;
+}
+
+}  // namespace tensorflow
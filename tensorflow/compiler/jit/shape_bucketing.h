@@ -0,0 +1,98 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMPILER_JIT_SHAPE_BUCKETING_H_
+#define TENSORFLOW_COMPILER_JIT_SHAPE_BUCKETING_H_
+
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/types/optional.h"
+#include "tensorflow/compiler/tf2xla/xla_compiler.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// Learns the sizes a dimension of a cluster argument is padded to, from the
+// histogram of the sizes it has been seen with.
+//
+// A dimension is left static until it has been seen with
+// `min_distinct_sizes` different sizes. The buckets are then the largest sizes
+// of groups of observed sizes, such that each size is padded by at most
+// `max_padding_fraction` of itself. When that takes more than `max_buckets`
+// buckets, the adjacent groups whose merge pads the fewest observed elements
+// are merged. The buckets are only relearned when a size larger than all of
+// them is seen, so that the executables compiled for them stay in use.
+class DimensionBucketer {
+ public:
+  struct Options {
+    int min_distinct_sizes = 3;
+    int max_buckets = 8;
+    double max_padding_fraction = 0.25;
+  };
+
+  explicit DimensionBucketer(const Options& options) : options_(options) {}
+
+  // Records an occurrence of `size`, and returns the size it is padded to, or
+  // nullopt if the dimension stays static.
+  absl::optional<int64> Bucket(int64 size);
+
+  // The learned buckets, in increasing order.
+  const std::vector<int64>& buckets() const { return buckets_; }
+
+ private:
+  void LearnBuckets();
+
+  Options options_;
+
+  // Maps each observed size to the number of times it was seen.
+  std::map<int64, int64> histogram_;
+
+  std::vector<int64> buckets_;
+};
+
+// Pads the dimensions of the parameters of a cluster whose sizes vary between
+// executions to the buckets learned for them, so that one executable serves
+// all the shapes of a bucket.
+//
+// A padded dimension is marked dynamic in the xla::Shape of the argument, with
+// the bucket as its bound. The cluster is then compiled with the padded
+// dimension dynamic: DynamicPadder masks the padding where an op depends on
+// it, and the results have their true sizes.
+class ArgumentBucketer {
+ public:
+  explicit ArgumentBucketer(const DimensionBucketer::Options& options)
+      : options_(options) {}
+
+  // Records the shapes of the parameters in `args`, and replaces the shapes of
+  // those with varying dimensions by their padded dynamic shapes. Returns
+  // whether any argument was padded.
+  //
+  // Clusters with resource arguments are not padded, since the shapes of the
+  // resource updates of an executable are static.
+  bool PadArguments(std::vector<XlaCompiler::Argument>* args);
+
+ private:
+  DimensionBucketer::Options options_;
+
+  // Keyed by argument number and dimension.
+  absl::flat_hash_map<std::pair<int, int>, DimensionBucketer> dimensions_;
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_COMPILER_JIT_SHAPE_BUCKETING_H_
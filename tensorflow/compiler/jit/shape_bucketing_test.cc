@@ -0,0 +1,119 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/jit/shape_bucketing.h"
+
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+using ::testing::ElementsAre;
+
+TEST(DimensionBucketerTest, StaysStaticUntilSizesVary) {
+  DimensionBucketer bucketer(DimensionBucketer::Options{});
+  EXPECT_EQ(bucketer.Bucket(10), absl::nullopt);
+  EXPECT_EQ(bucketer.Bucket(10), absl::nullopt);
+  EXPECT_EQ(bucketer.Bucket(11), absl::nullopt);
+  EXPECT_EQ(bucketer.Bucket(12), 12);
+  EXPECT_EQ(bucketer.Bucket(10), 12);
+}
+
+TEST(DimensionBucketerTest, GroupsSizesWithinPaddingFraction) {
+  DimensionBucketer::Options options;
+  options.max_padding_fraction = 0.25;
+  DimensionBucketer bucketer(options);
+  for (int64 size : {100, 110, 200, 120, 210}) {
+    bucketer.Bucket(size);
+  }
+  EXPECT_THAT(bucketer.buckets(), ElementsAre(120, 210));
+  EXPECT_EQ(bucketer.Bucket(105), 120);
+  EXPECT_EQ(bucketer.Bucket(121), 210);
+}
+
+TEST(DimensionBucketerTest, MergesRarelySeenSizes) {
+  DimensionBucketer::Options options;
+  options.min_distinct_sizes = 1;
+  options.max_buckets = 2;
+  options.max_padding_fraction = 0;
+  DimensionBucketer bucketer(options);
+  for (int i = 0; i < 10; ++i) {
+    bucketer.Bucket(40);
+  }
+  bucketer.Bucket(10);
+  bucketer.Bucket(20);
+  for (int i = 0; i < 10; ++i) {
+    bucketer.Bucket(80);
+  }
+  EXPECT_THAT(bucketer.buckets(), ElementsAre(40, 80));
+}
+
+TEST(DimensionBucketerTest, RelearnsOnlyForLargerSizes) {
+  DimensionBucketer bucketer(DimensionBucketer::Options{});
+  for (int64 size : {100, 200, 300}) {
+    bucketer.Bucket(size);
+  }
+  EXPECT_THAT(bucketer.buckets(), ElementsAre(100, 200, 300));
+  EXPECT_EQ(bucketer.Bucket(150), 200);
+  EXPECT_THAT(bucketer.buckets(), ElementsAre(100, 200, 300));
+  EXPECT_EQ(bucketer.Bucket(310), 310);
+  EXPECT_THAT(bucketer.buckets(), ElementsAre(100, 150, 200, 310));
+}
+
+XlaCompiler::Argument ParameterArgument(const TensorShape& shape) {
+  XlaCompiler::Argument arg;
+  arg.kind = XlaCompiler::Argument::kParameter;
+  arg.type = DT_FLOAT;
+  arg.shape = shape;
+  return arg;
+}
+
+TEST(ArgumentBucketerTest, PadsVaryingDimensions) {
+  ArgumentBucketer bucketer(DimensionBucketer::Options{});
+  std::vector<XlaCompiler::Argument> args;
+  for (int64 size : {5, 6}) {
+    args = {ParameterArgument(TensorShape({2, size}))};
+    EXPECT_FALSE(bucketer.PadArguments(&args));
+  }
+  args = {ParameterArgument(TensorShape({2, 7}))};
+  ASSERT_TRUE(bucketer.PadArguments(&args));
+  ASSERT_TRUE(absl::holds_alternative<xla::Shape>(args[0].shape));
+  const xla::Shape& shape = absl::get<xla::Shape>(args[0].shape);
+  EXPECT_THAT(shape.dimensions(), ElementsAre(2, 7));
+  EXPECT_FALSE(shape.is_dynamic_dimension(0));
+  EXPECT_TRUE(shape.is_dynamic_dimension(1));
+
+  // 5 and 6 are within the padding fraction of each other.
+  args = {ParameterArgument(TensorShape({2, 5}))};
+  ASSERT_TRUE(bucketer.PadArguments(&args));
+  EXPECT_THAT(absl::get<xla::Shape>(args[0].shape).dimensions(),
+              ElementsAre(2, 6));
+}
+
+TEST(ArgumentBucketerTest, DoesNotPadClustersWithResources) {
+  ArgumentBucketer bucketer(DimensionBucketer::Options{});
+  XlaCompiler::Argument resource;
+  resource.kind = XlaCompiler::Argument::kResource;
+  resource.type = DT_FLOAT;
+  for (int64 size : {5, 6, 7}) {
+    std::vector<XlaCompiler::Argument> args = {
+        ParameterArgument(TensorShape({size})), resource};
+    EXPECT_FALSE(bucketer.PadArguments(&args));
+    EXPECT_TRUE(absl::holds_alternative<TensorShape>(args[0].shape));
+  }
+}
+
+}  // namespace
+}  // namespace tensorflow
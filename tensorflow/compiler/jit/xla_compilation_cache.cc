@@ -15,9 +15,11 @@ limitations under the License.
 
 #include "tensorflow/compiler/jit/xla_compilation_cache.h"
 
+#include <memory>
 #include <numeric>
 
 #include "absl/base/call_once.h"
+#include "absl/memory/memory.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_join.h"
 #include "tensorflow/compiler/jit/xla_activity.pb.h"
@@ -50,12 +52,20 @@ limitations under the License.
 namespace tensorflow {
 
 constexpr int64 XlaCompilationCache::kDefaultCompilationThreshold;
+constexpr int64 XlaCompilationCache::kMaxOngoingAsyncCompilations;
 
 XlaCompilationCache::XlaCompilationCache(xla::LocalClient* client,
                                          DeviceType device_type)
     : client_(client), device_type_(std::move(device_type)) {}
 
 XlaCompilationCache::~XlaCompilationCache() {
+  // Wait for the async compilations in flight, which write into the cache.
+  std::unique_ptr<thread::ThreadPool> async_compiler_threads;
+  {
+    mutex_lock lock(async_compilation_mu_);
+    async_compiler_threads = std::move(async_compiler_threads_);
+  }
+  async_compiler_threads.reset();
   // Ensure any use of our programs have completed by waiting for all stream
   // executors to complete.
   for (auto* executor : client_->backend().stream_executors()) {
@@ -81,9 +91,16 @@ string XlaCompilationCache::DebugString() const {
 // arguments in the supplied list.
 string XlaCompilationCache::Signature::HumanString() const {
   string result = name;
-  for (const auto& a : arg_shapes) {
-    absl::StrAppend(&result, ",", DataTypeString(a.first));
-    absl::StrAppend(&result, " [", absl::StrJoin(a.second, ","), "]");
+  for (int i = 0, end = arg_shapes.size(); i < end; ++i) {
+    const auto& a = arg_shapes[i];
+    const uint64 dynamic_dimensions =
+        i < arg_dynamic_dimensions.size() ? arg_dynamic_dimensions[i] : 0;
+    absl::StrAppend(&result, ",", DataTypeString(a.first), " [");
+    for (int d = 0, rank = a.second.size(); d < rank; ++d) {
+      absl::StrAppend(&result, d > 0 ? "," : "",
+                      (dynamic_dimensions >> d) & 1 ? "<=" : "", a.second[d]);
+    }
+    absl::StrAppend(&result, "]");
   }
 
   for (const auto& v : arg_values) {
@@ -95,6 +112,7 @@ string XlaCompilationCache::Signature::HumanString() const {
 bool XlaCompilationCache::Signature::operator==(const Signature& other) const {
   if (name != other.name) return false;
   if (arg_shapes != other.arg_shapes) return false;
+  if (arg_dynamic_dimensions != other.arg_dynamic_dimensions) return false;
 
   if (arg_values.size() != other.arg_values.size()) return false;
   for (int i = 0, end = arg_values.size(); i < end; ++i) {
@@ -117,6 +135,9 @@ uint64 XlaCompilationCache::Signature::Hash::operator()(
       h = Hash64Combine(h, std::hash<int>()(dim));
     }
   }
+  for (uint64 dynamic_dimensions : signature.arg_dynamic_dimensions) {
+    h = Hash64Combine(h, dynamic_dimensions);
+  }
   for (const auto& arg : signature.arg_values) {
     h = Hash64Combine(
         h, Hash64(arg.tensor_data().data(), arg.tensor_data().size()));
@@ -137,10 +158,21 @@ XlaCompilationCache::BuildSignature(
         signature.arg_values.push_back(arg.constant_value);
         break;
       case XlaCompiler::Argument::kParameter:
-      case XlaCompiler::Argument::kResource:
+      case XlaCompiler::Argument::kResource: {
         signature.arg_shapes.emplace_back(arg.type,
                                           arg.DimensionSizesAsInlinedVector());
+        uint64 dynamic_dimensions = 0;
+        if (absl::holds_alternative<xla::Shape>(arg.shape)) {
+          const xla::Shape& shape = absl::get<xla::Shape>(arg.shape);
+          for (int d = 0; d < shape.rank() && d < 64; ++d) {
+            if (shape.is_dynamic_dimension(d)) {
+              dynamic_dimensions |= uint64{1} << d;
+            }
+          }
+        }
+        signature.arg_dynamic_dimensions.push_back(dynamic_dimensions);
         break;
+      }
       default:
         return errors::InvalidArgument(
             "Unhandled argument kind in XlaCompilationCache: ",
@@ -184,19 +216,43 @@ Status XlaCompilationCache::Compile(
     CompileMode compile_mode,
     const XlaCompiler::CompilationResult** out_compilation_result,
     xla::LocalExecutable** out_executable) {
-  absl::optional<int64> compile_threshold;
-  if (compile_mode == CompileMode::kLazy) {
-    compile_threshold = kDefaultCompilationThreshold;
+  CompileFn compile_fn;
+  if (compile_mode == CompileMode::kAsync) {
+    // The compilation may outlive the arguments of this call.
+    compile_fn = [compile_options, function,
+                  args = std::vector<XlaCompiler::Argument>(args.begin(),
+                                                            args.end())](
+                     XlaCompiler* compiler,
+                     XlaCompiler::CompilationResult* result) {
+      return compiler->CompileFunction(compile_options, function, args, result);
+    };
+  } else {
+    compile_fn = [&](XlaCompiler* compiler,
+                     XlaCompiler::CompilationResult* result) {
+      return compiler->CompileFunction(compile_options, function, args, result);
+    };
   }
-  auto compile_fn = [&](XlaCompiler* compiler,
-                        XlaCompiler::CompilationResult* result) {
-    return compiler->CompileFunction(compile_options, function, args, result);
-  };
-  return CompileImpl(options, function, args, compile_fn,
-                     /*compile_threshold=*/compile_threshold,
+  return CompileImpl(options, function, args, compile_fn, compile_mode,
                      out_compilation_result, out_executable);
 }
 
+bool XlaCompilationCache::PadArgumentsToBuckets(
+    const NameAttrList& function, std::vector<XlaCompiler::Argument>* args) {
+  mutex_lock lock(shape_buckets_mu_);
+  ClusterShapeBuckets& buckets =
+      shape_buckets_.try_emplace(function.name(), DimensionBucketer::Options())
+          .first->second;
+  return !buckets.disabled && buckets.bucketer.PadArguments(args);
+}
+
+void XlaCompilationCache::DisableShapeBucketing(const NameAttrList& function) {
+  mutex_lock lock(shape_buckets_mu_);
+  auto it = shape_buckets_.find(function.name());
+  if (it != shape_buckets_.end()) {
+    it->second.disabled = true;
+  }
+}
+
 static bool ShouldBeMegamorphic(int64 compile_count, int64 execution_count) {
   const int64 kCompileThreshold = 10;
   const int64 kMinExecutionsPerCompile = 50;
@@ -298,8 +354,7 @@ Status XlaCompilationCache::CompileSingleOp(
         compile_options.use_tuple_arg, *options.flib_def, debug_info,
         options.shape_representation_fn, result);
   };
-  return CompileImpl(options, name, args, compile_op,
-                     /*compile_threshold=*/absl::nullopt,
+  return CompileImpl(options, name, args, compile_op, CompileMode::kStrict,
                      out_compilation_result, out_executable);
 }
 
@@ -317,12 +372,41 @@ void LogOnceXlaCompiledFirstCluster() {
 }
 }  // namespace
 
+Status XlaCompilationCache::RecordCompilation(const string& function_name,
+                                              uint64 compile_start_us) {
+  const uint64 compile_end_us = tensorflow::Env::Default()->NowMicros();
+  const uint64 compile_time_us = compile_end_us - compile_start_us;
+  metrics::UpdateXlaCompilationTime(compile_time_us);
+  mutex_lock lock(cluster_compile_stats_mu_);
+  auto it = cluster_compile_stats_.find(function_name);
+  it->second.compile_count++;
+  it->second.cumulative_compile_time_us += compile_time_us;
+  LogOnceXlaCompiledFirstCluster();
+  VLOG(1) << "compiled " << function_name << " " << it->second.compile_count
+          << " times, compile time: " << compile_time_us
+          << " us, cumulative: " << it->second.cumulative_compile_time_us
+          << " us ("
+          << tensorflow::strings::HumanReadableElapsedTime(compile_time_us /
+                                                           1.0e6)
+          << " / "
+          << tensorflow::strings::HumanReadableElapsedTime(
+                 it->second.cumulative_compile_time_us / 1.0e6)
+          << ")";
+
+  XlaJitCompilationActivity jit_compilation_activity;
+  jit_compilation_activity.set_cluster_name(function_name);
+  jit_compilation_activity.set_compile_count(it->second.compile_count);
+  jit_compilation_activity.set_compile_time_us(compile_time_us);
+  jit_compilation_activity.set_cumulative_compile_time_us(
+      it->second.cumulative_compile_time_us);
+
+  return BroadcastXlaActivity(std::move(jit_compilation_activity));
+}
+
 Status XlaCompilationCache::CompileImpl(
     const XlaCompiler::Options& options, const NameAttrList& function,
-    absl::Span<const XlaCompiler::Argument> args,
-    const std::function<Status(XlaCompiler* compiler,
-                               XlaCompiler::CompilationResult*)>& compile_fn,
-    absl::optional<int64> compile_threshold,
+    absl::Span<const XlaCompiler::Argument> args, const CompileFn& compile_fn,
+    CompileMode compile_mode,
     const XlaCompiler::CompilationResult** out_compilation_result,
     xla::LocalExecutable** out_executable) {
   DCHECK_NE(out_executable, nullptr);
@@ -386,16 +470,28 @@ Status XlaCompilationCache::CompileImpl(
   // Acquire the cache entry lock and compile, if necessary.
   // TODO(phawkins): this locking will need to be restructured when we implement
   // cache eviction.
+  absl::optional<int64> compile_threshold;
+  if (compile_mode == CompileMode::kLazy) {
+    compile_threshold = kDefaultCompilationThreshold;
+  }
   mutex_lock entry_lock(entry->mu);
   int64 current_request_count = ++entry->request_count;
-  VLOG(2) << "Compilation cache entry hit: " << entry->compiled
+  VLOG(2) << "Compilation cache entry hit: "
+          << (entry->state == Entry::State::kCompiled)
           << " signature: " << signature.HumanString() << " with request count "
           << current_request_count << " and compile threshold "
           << compile_threshold.value_or(0);
-  if (!entry->compiled) {
+  if (entry->state == Entry::State::kCompiling) {
+    VLOG(2) << "Compilation in flight for signature: "
+            << signature.HumanString();
+    *out_compilation_result = nullptr;
+    *out_executable = nullptr;
+    return Status::OK();
+  }
+  if (entry->state == Entry::State::kUncompiled) {
     XLA_SCOPED_LOGGING_TIMER("Compilation of XLA executable");
     const bool should_compile = [&] {
-      if (!compile_threshold.has_value()) {
+      if (compile_mode == CompileMode::kStrict) {
         // Lazy compilation is disabled.
         return true;
       }
@@ -409,7 +505,9 @@ Status XlaCompilationCache::CompileImpl(
         return false;
       }
 
-      if (is_first_execution) {
+      // Compiling in the background doesn't hold up the execution, so there
+      // is no need to wait for the signature to be requested again.
+      if (is_first_execution || compile_mode == CompileMode::kAsync) {
         return true;
       }
 
@@ -433,12 +531,79 @@ Status XlaCompilationCache::CompileImpl(
     }
 
     tensorflow::Env* env = tensorflow::Env::Default();
+
+    if (compile_mode == CompileMode::kAsync) {
+      *out_compilation_result = nullptr;
+      *out_executable = nullptr;
+      mutex_lock lock(async_compilation_mu_);
+      if (num_ongoing_async_compilations_ >= kMaxOngoingAsyncCompilations) {
+        VLOG(2) << "Not compiling for signature: " << signature.HumanString()
+                << " because " << num_ongoing_async_compilations_
+                << " compilations are in flight.";
+        return Status::OK();
+      }
+      if (async_compiler_threads_ == nullptr) {
+        async_compiler_threads_ = absl::make_unique<thread::ThreadPool>(
+            env, "xla_async_compilation", kMaxOngoingAsyncCompilations);
+      }
+      // The compilation outlives this call, but the allocator and the
+      // function library of the caller may not: the compilation uses the
+      // default allocator of the backend, and a copy of the functions it
+      // needs.
+      std::shared_ptr<FunctionLibraryDefinition> flib_def;
+      const FunctionDef* fdef = options.flib_def->Find(function.name());
+      if (fdef != nullptr) {
+        flib_def = std::make_shared<FunctionLibraryDefinition>(
+            options.flib_def->ReachableDefinitions(*fdef));
+        TF_RETURN_IF_ERROR(
+            flib_def->CopyFunctionDefFrom(function.name(), *options.flib_def));
+      } else {
+        flib_def =
+            std::make_shared<FunctionLibraryDefinition>(*options.flib_def);
+      }
+      XlaCompiler::Options async_options = options;
+      async_options.device_allocator = nullptr;
+      async_options.flib_def = flib_def.get();
+      ++num_ongoing_async_compilations_;
+      entry->state = Entry::State::kCompiling;
+      async_compiler_threads_->Schedule([this, env, entry, async_options,
+                                         flib_def,
+                                         function_name = function.name(),
+                                         compile_fn]() {
+        const uint64 compile_start_us = env->NowMicros();
+        XlaCompiler compiler(async_options);
+        XlaCompiler::CompilationResult compilation_result;
+        std::unique_ptr<xla::LocalExecutable> executable;
+        Status status = compile_fn(&compiler, &compilation_result);
+        if (status.ok()) {
+          status =
+              BuildExecutable(async_options, compilation_result, &executable);
+          Status record_status =
+              RecordCompilation(function_name, compile_start_us);
+          if (!record_status.ok()) {
+            LOG(WARNING) << "Failed to record the compilation of "
+                         << function_name << ": " << record_status;
+          }
+        }
+        {
+          mutex_lock entry_lock(entry->mu);
+          entry->compilation_status = status;
+          entry->compilation_result = std::move(compilation_result);
+          entry->executable = std::move(executable);
+          entry->state = Entry::State::kCompiled;
+        }
+        mutex_lock lock(async_compilation_mu_);
+        --num_ongoing_async_compilations_;
+      });
+      return Status::OK();
+    }
+
     const uint64 compile_start_us = env->NowMicros();
     // Do the actual JIT compilation without holding the lock (it can take
     // a long time.)
 
     XlaCompiler compiler(options);
-    entry->compiled = true;
+    entry->state = Entry::State::kCompiled;
 
     entry->compilation_status =
         compile_fn(&compiler, &entry->compilation_result);
@@ -446,38 +611,7 @@ Status XlaCompilationCache::CompileImpl(
     CHECK_EQ(entry->executable.get(), nullptr);
     entry->compilation_status =
         BuildExecutable(options, entry->compilation_result, &entry->executable);
-
-    const uint64 compile_end_us = env->NowMicros();
-    const uint64 compile_time_us = compile_end_us - compile_start_us;
-    metrics::UpdateXlaCompilationTime(compile_time_us);
-    {
-      mutex_lock lock(cluster_compile_stats_mu_);
-      auto it = cluster_compile_stats_.find(function.name());
-      it->second.compile_count++;
-      it->second.cumulative_compile_time_us += compile_time_us;
-      LogOnceXlaCompiledFirstCluster();
-      VLOG(1) << "compiled " << function.name() << " "
-              << it->second.compile_count
-              << " times, compile time: " << compile_time_us
-              << " us, cumulative: " << it->second.cumulative_compile_time_us
-              << " us ("
-              << tensorflow::strings::HumanReadableElapsedTime(compile_time_us /
-                                                               1.0e6)
-              << " / "
-              << tensorflow::strings::HumanReadableElapsedTime(
-                     it->second.cumulative_compile_time_us / 1.0e6)
-              << ")";
-
-      XlaJitCompilationActivity jit_compilation_activity;
-      jit_compilation_activity.set_cluster_name(function.name());
-      jit_compilation_activity.set_compile_count(it->second.compile_count);
-      jit_compilation_activity.set_compile_time_us(compile_time_us);
-      jit_compilation_activity.set_cumulative_compile_time_us(
-          it->second.cumulative_compile_time_us);
-
-      TF_RETURN_IF_ERROR(
-          BroadcastXlaActivity(std::move(jit_compilation_activity)));
-    }
+    TF_RETURN_IF_ERROR(RecordCompilation(function.name(), compile_start_us));
   }
   TF_RETURN_IF_ERROR(entry->compilation_status);
   *out_compilation_result = &entry->compilation_result;
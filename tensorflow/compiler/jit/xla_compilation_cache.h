@@ -20,6 +20,7 @@ limitations under the License.
 #include "absl/container/inlined_vector.h"
 #include "absl/types/optional.h"
 #include "absl/types/span.h"
+#include "tensorflow/compiler/jit/shape_bucketing.h"
 #include "tensorflow/compiler/tf2xla/xla_compiler.h"
 #include "tensorflow/compiler/tf2xla/xla_context.h"
 #include "tensorflow/compiler/xla/client/local_client.h"
@@ -50,6 +51,7 @@ class XlaCompilationCache : public ResourceBase {
   enum class CompileMode {
     kLazy,
     kStrict,
+    kAsync,
   };
 
   // Compiles a function into a XlaCompiler::CompilationResult that can be used
@@ -62,7 +64,10 @@ class XlaCompilationCache : public ResourceBase {
   // heuristics, the compilation cache may decide not to compile the cluster at
   // this time.  In this case it returns null into both `out_compilation_result`
   // and `out_executable`.  If `compile_mode` is `kStrict` then the compilation
-  // cache always attempts the compilation on a cache miss.
+  // cache always attempts the compilation on a cache miss.  If `compile_mode`
+  // is `kAsync` then a cache miss starts the compilation on a background
+  // thread, unless `kMaxOngoingAsyncCompilations` are already in flight, and
+  // null is returned into both outputs until the compilation has finished.
   //
   // The result of compilation is written to `*out_compilation_result`, which
   // must be non-null. If `out_executable` is non-null, also builds an
@@ -88,6 +93,16 @@ class XlaCompilationCache : public ResourceBase {
       const XlaCompiler::CompilationResult** out_compilation_result,
       xla::LocalExecutable** out_executable);
 
+  // Pads the dimensions of the parameters in `args` whose sizes vary between
+  // executions of `function` to the buckets learned for them (see
+  // ArgumentBucketer). Returns whether any argument was padded.
+  bool PadArgumentsToBuckets(const NameAttrList& function,
+                             std::vector<XlaCompiler::Argument>* args);
+
+  // Stops padding the arguments of `function`, e.g. because it failed to
+  // compile with padded arguments.
+  void DisableShapeBucketing(const NameAttrList& function);
+
   xla::LocalClient* client() const { return client_; }
   const DeviceType& device_type() const { return device_type_; }
 
@@ -103,6 +118,10 @@ class XlaCompilationCache : public ResourceBase {
     absl::InlinedVector<std::pair<DataType, absl::InlinedVector<int64, 4>>, 4>
         arg_shapes;
 
+    // For each of arg_shapes, a bit mask of its dimensions which are dynamic,
+    // with the sizes in arg_shapes as their bounds.
+    absl::InlinedVector<uint64, 4> arg_dynamic_dimensions;
+
     // List of Tensor values for compile-time constant arguments to the
     // compilation, ordered by argument number. Tensors must be in host memory.
     absl::InlinedVector<Tensor, 4> arg_values;
@@ -123,13 +142,15 @@ class XlaCompilationCache : public ResourceBase {
       absl::Span<const XlaCompiler::Argument> args);
 
  private:
-  // Common implementation of Compile and CompileSingleOp.
+  using CompileFn = std::function<Status(XlaCompiler* compiler,
+                                         XlaCompiler::CompilationResult*)>;
+
+  // Common implementation of Compile and CompileSingleOp. With the kAsync
+  // `compile_mode`, `compile_fn` may be called after CompileImpl returns.
   Status CompileImpl(
       const XlaCompiler::Options& options, const NameAttrList& function,
-      absl::Span<const XlaCompiler::Argument> args,
-      const std::function<Status(XlaCompiler* compiler,
-                                 XlaCompiler::CompilationResult*)>& compile_fn,
-      absl::optional<int64> compile_threshold,
+      absl::Span<const XlaCompiler::Argument> args, const CompileFn& compile_fn,
+      CompileMode compile_mode,
       const XlaCompiler::CompilationResult** out_compilation_result,
       xla::LocalExecutable** out_executable);
 
@@ -139,6 +160,11 @@ class XlaCompilationCache : public ResourceBase {
                          const XlaCompiler::CompilationResult& result,
                          std::unique_ptr<xla::LocalExecutable>* executable);
 
+  // Updates the compilation statistics of `function_name` with a compilation
+  // that started at `compile_start_us`, and broadcasts them.
+  Status RecordCompilation(const string& function_name,
+                           uint64 compile_start_us);
+
   xla::LocalClient* const client_;
   const DeviceType device_type_;
 
@@ -146,8 +172,14 @@ class XlaCompilationCache : public ResourceBase {
   struct Entry {
     mutex mu;
 
-    // Have we tried compiling this entry?
-    bool compiled = false;
+    enum class State {
+      kUncompiled,
+      // A compilation of the entry is in flight on a background thread.
+      kCompiling,
+      // We have tried compiling this entry.
+      kCompiled,
+    };
+    State state TF_GUARDED_BY(mu) = State::kUncompiled;
 
     // The number of times a compilation with this signature has been requested.
     int64 request_count = 0;
@@ -189,10 +221,40 @@ class XlaCompilationCache : public ResourceBase {
   absl::flat_hash_map<string, ClusterCompileStats> cluster_compile_stats_
       TF_GUARDED_BY(cluster_compile_stats_mu_);
 
+  struct ClusterShapeBuckets {
+    explicit ClusterShapeBuckets(const DimensionBucketer::Options& options)
+        : bucketer(options) {}
+
+    ArgumentBucketer bucketer;
+
+    // True once the cluster has failed to compile with padded arguments.
+    bool disabled = false;
+  };
+
+  mutex shape_buckets_mu_;
+
+  // Maps cluster names to the buckets learned for their arguments.
+  absl::flat_hash_map<string, ClusterShapeBuckets> shape_buckets_
+      TF_GUARDED_BY(shape_buckets_mu_);
+
+  mutex async_compilation_mu_;
+
+  // The number of kAsync compilations in flight.
+  int64 num_ongoing_async_compilations_ TF_GUARDED_BY(async_compilation_mu_) =
+      0;
+
+  // Runs the kAsync compilations. Created on the first of them.
+  std::unique_ptr<thread::ThreadPool> async_compiler_threads_
+      TF_GUARDED_BY(async_compilation_mu_);
+
   // The number of times a lazy compilation must be requested for a specific
   // signature before  we attempt to compile it.
   static constexpr int64 kDefaultCompilationThreshold = 2;
 
+  // The maximum number of kAsync compilations in flight. Further cache misses
+  // are not compiled until one of them finishes.
+  static constexpr int64 kMaxOngoingAsyncCompilations = 4;
+
   TF_DISALLOW_COPY_AND_ASSIGN(XlaCompilationCache);
 };
 
@@ -15,7 +15,14 @@ limitations under the License.
 
 #include "tensorflow/compiler/jit/xla_compilation_cache.h"
 
+#include "absl/memory/memory.h"
 #include "tensorflow/compiler/tf2xla/shape_util.h"
+#include "tensorflow/compiler/tf2xla/xla_op_registry.h"
+#include "tensorflow/compiler/xla/client/client_library.h"
+#include "tensorflow/core/framework/function.h"
+#include "tensorflow/core/framework/function_testlib.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/test_benchmark.h"
 
@@ -52,6 +59,99 @@ TEST(XlaCompilationCacheTest, SignatureEquality) {
   }
 }
 
+class AsyncCompilationTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    client_ = xla::ClientLibrary::LocalClientOrDie();
+    XlaOpRegistry::RegisterCompilationKernels();
+    cache_ = new XlaCompilationCache(client_, DeviceType(DEVICE_CPU_XLA_JIT));
+    function_.set_name("XTimesTwo");
+    (*function_.mutable_attr())["T"].set_type(DT_FLOAT);
+    args_.resize(1);
+    args_[0].kind = XlaCompiler::Argument::kParameter;
+    args_[0].type = DT_FLOAT;
+    args_[0].shape = TensorShape({2});
+  }
+
+  void TearDown() override { cache_->Unref(); }
+
+  // Returns a library holding XTimesTwo.
+  static std::unique_ptr<FunctionLibraryDefinition> MakeLibrary() {
+    FunctionDefLibrary library;
+    *library.add_function() = test::function::XTimesTwo();
+    return absl::make_unique<FunctionLibraryDefinition>(OpRegistry::Global(),
+                                                        library);
+  }
+
+  Status Compile(const FunctionLibraryDefinition* flib_def,
+                 const XlaCompiler::CompilationResult** compilation_result,
+                 xla::LocalExecutable** executable) {
+    XlaCompiler::Options options;
+    options.device_type = DeviceType(DEVICE_CPU_XLA_JIT);
+    options.client = client_;
+    options.flib_def = flib_def;
+    return cache_->Compile(options, function_, args_,
+                           XlaCompiler::CompileOptions(),
+                           XlaCompilationCache::CompileMode::kAsync,
+                           compilation_result, executable);
+  }
+
+  // Requests the compilation until it has finished, and returns the status of
+  // the last request.
+  Status WaitForCompilation(const FunctionLibraryDefinition* flib_def,
+                            xla::LocalExecutable** executable) {
+    const XlaCompiler::CompilationResult* compilation_result = nullptr;
+    for (int i = 0; i < 6000; ++i) {
+      Status status = Compile(flib_def, &compilation_result, executable);
+      if (!status.ok() || *executable != nullptr) {
+        return status;
+      }
+      Env::Default()->SleepForMicroseconds(10 * 1000);
+    }
+    return errors::DeadlineExceeded("The compilation did not finish");
+  }
+
+  xla::LocalClient* client_;
+  XlaCompilationCache* cache_;
+  NameAttrList function_;
+  std::vector<XlaCompiler::Argument> args_;
+};
+
+TEST_F(AsyncCompilationTest, FallsBackUntilCompiled) {
+  // The first request starts the compilation and returns no executable, so
+  // that the caller runs the cluster in the TF executor. The library of the
+  // caller is gone before the compilation has finished.
+  const XlaCompiler::CompilationResult* compilation_result = nullptr;
+  xla::LocalExecutable* executable = nullptr;
+  {
+    std::unique_ptr<FunctionLibraryDefinition> flib_def = MakeLibrary();
+    TF_ASSERT_OK(Compile(flib_def.get(), &compilation_result, &executable));
+    EXPECT_EQ(compilation_result, nullptr);
+    EXPECT_EQ(executable, nullptr);
+  }
+
+  // Later requests pick up the executable once it is compiled.
+  std::unique_ptr<FunctionLibraryDefinition> flib_def = MakeLibrary();
+  TF_ASSERT_OK(WaitForCompilation(flib_def.get(), &executable));
+  ASSERT_NE(executable, nullptr);
+  TF_ASSERT_OK(Compile(flib_def.get(), &compilation_result, &executable));
+  ASSERT_NE(compilation_result, nullptr);
+  EXPECT_EQ(compilation_result->xla_input_shapes.size(), 1);
+  EXPECT_NE(executable, nullptr);
+}
+
+TEST_F(AsyncCompilationTest, ReturnsCompilationErrorLater) {
+  const XlaCompiler::CompilationResult* compilation_result = nullptr;
+  xla::LocalExecutable* executable = nullptr;
+  FunctionLibraryDefinition empty_library(OpRegistry::Global(),
+                                          FunctionDefLibrary());
+  TF_ASSERT_OK(Compile(&empty_library, &compilation_result, &executable));
+  EXPECT_EQ(executable, nullptr);
+  Status status = WaitForCompilation(&empty_library, &executable);
+  EXPECT_FALSE(status.ok());
+  EXPECT_FALSE(errors::IsDeadlineExceeded(status)) << status;
+}
+
 static void BM_BuildSignature(int iters, int n_args) {
   NameAttrList fn;
   fn.set_name("afunction");
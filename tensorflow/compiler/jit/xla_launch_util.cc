@@ -18,12 +18,15 @@ limitations under the License.
 #include <memory>
 
 #include "absl/algorithm/container.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/memory/memory.h"
 #include "tensorflow/compiler/jit/defs.h"
 #include "tensorflow/compiler/tf2xla/shape_util.h"
 #include "tensorflow/compiler/tf2xla/xla_compiler.h"
 #include "tensorflow/compiler/xla/client/client_library.h"
 #include "tensorflow/compiler/xla/client/local_client.h"
+#include "tensorflow/compiler/xla/layout_util.h"
+#include "tensorflow/compiler/xla/shape_util.h"
 #include "tensorflow/compiler/xla/statusor.h"
 #include "tensorflow/core/common_runtime/dma_helper.h"
 #include "tensorflow/core/common_runtime/function.h"
@@ -194,6 +197,80 @@ static void PopulateExecutionInputBuffer(xla::ExecutionInput& execution_input,
   }
 }
 
+// Copies `tensor` to a new buffer for an argument of dynamic shape
+// `device_shape`, in the form XLA takes it: the elements of `tensor`, followed
+// by the int32 sizes of its dimensions at the offset of the size of the bounded
+// shape.
+static xla::StatusOr<se::OwningDeviceMemory> CopyToDynamicShapeBuffer(
+    se::Stream* stream, const Tensor& tensor, const xla::Shape& device_shape,
+    const std::function<int64(const xla::Shape&)>& shape_size_fn,
+    se::DeviceMemoryAllocator* allocator, int device_ordinal) {
+  if (stream == nullptr) {
+    return errors::Unimplemented(
+        "Passing a dynamically shaped argument requires a stream");
+  }
+  if (!xla::LayoutUtil::IsMonotonicWithDim0Major(device_shape.layout())) {
+    return errors::Unimplemented(
+        "Dynamically shaped arguments must have a major-to-minor layout: ",
+        xla::ShapeUtil::HumanStringWithLayout(device_shape));
+  }
+  TF_RET_CHECK(tensor.dims() == device_shape.rank());
+  for (int d = 0; d < tensor.dims(); ++d) {
+    TF_RET_CHECK(tensor.dim_size(d) <= device_shape.dimensions(d))
+        << tensor.shape().DebugString() << " does not fit in "
+        << xla::ShapeUtil::HumanString(device_shape);
+  }
+  const int64 metadata_offset =
+      shape_size_fn(xla::ShapeUtil::MakeStaticShape(device_shape));
+  TF_ASSIGN_OR_RETURN(
+      se::OwningDeviceMemory buffer,
+      allocator->Allocate(device_ordinal, shape_size_fn(device_shape)));
+
+  char* base = static_cast<char*>(buffer->opaque());
+  se::DeviceMemoryBase data = XlaTensor::DeviceMemoryFromTensor(tensor);
+  if (data.size() > 0) {
+    se::DeviceMemoryBase destination(base, data.size());
+    stream->ThenMemcpyD2D(&destination, data, data.size());
+  }
+  for (int d = 0; d < tensor.dims(); ++d) {
+    se::DeviceMemoryBase size(base + metadata_offset + d * sizeof(int32),
+                              sizeof(int32));
+    stream->ThenMemset32(&size, static_cast<uint32>(tensor.dim_size(d)),
+                         sizeof(int32));
+  }
+  return std::move(buffer);
+}
+
+XlaInputPlan XlaComputationLaunchContext::BuildInputPlan(
+    const XlaCompiler::CompilationResult* compilation_result,
+    const xla::HloInputOutputAliasConfig& input_output_alias) const {
+  absl::flat_hash_set<int> modified_inputs;
+  for (const XlaCompiler::ResourceUpdate& update :
+       compilation_result->resource_updates) {
+    if (update.modified) {
+      modified_inputs.insert(update.input_index);
+    }
+  }
+
+  xla::TransferManager* transfer_manager =
+      client_->backend().transfer_manager();
+  XlaInputPlan plan;
+  plan.inputs.resize(compilation_result->xla_input_shapes.size());
+  for (int i = 0, end = plan.inputs.size(); i < end; ++i) {
+    const xla::Shape& shape = compilation_result->xla_input_shapes[i];
+    XlaInputPlan::Input& input = plan.inputs[i];
+    input.device_shape = transfer_manager->HostShapeToDeviceShape(shape);
+    input.is_updated_resource_variable = modified_inputs.contains(i);
+    input.may_donate =
+        input.is_updated_resource_variable &&
+        input_output_alias.ParameterHasAlias(i, xla::ShapeIndex{});
+    input.device_shape_matches =
+        xla::Shape::Equal().MinorToMajorOnlyInLayout()(shape,
+                                                       input.device_shape);
+  }
+  return plan;
+}
+
 xla::StatusOr<std::vector<xla::ExecutionInput>>
 XlaComputationLaunchContext::PopulateInputs(
     OpKernelContext* ctx,
@@ -201,34 +278,40 @@ XlaComputationLaunchContext::PopulateInputs(
     const std::map<int, const Tensor*>& resource_vars,
     int missing_ctx_input_prefix,
     const xla::HloInputOutputAliasConfig& input_output_alias) {
+  return PopulateInputs(ctx, compilation_result, resource_vars,
+                        missing_ctx_input_prefix,
+                        BuildInputPlan(compilation_result, input_output_alias));
+}
+
+xla::StatusOr<std::vector<xla::ExecutionInput>>
+XlaComputationLaunchContext::PopulateInputs(
+    OpKernelContext* ctx,
+    const XlaCompiler::CompilationResult* compilation_result,
+    const std::map<int, const Tensor*>& resource_vars,
+    int missing_ctx_input_prefix, const XlaInputPlan& input_plan) {
   std::vector<xla::ExecutionInput> arguments;
   arguments.reserve(compilation_result->xla_input_shapes.size());
 
-  xla::TransferManager* transfer_manager =
-      client_->backend().transfer_manager();
+  TF_RET_CHECK(input_plan.inputs.size() ==
+               compilation_result->xla_input_shapes.size());
   for (int i = 0, end = compilation_result->xla_input_shapes.size(); i < end;
        ++i) {
     int arg_num = compilation_result->input_mapping[i];
     CHECK_GE(arg_num, missing_ctx_input_prefix);
     const xla::Shape& shape = compilation_result->xla_input_shapes[i];
-    const xla::Shape& device_shape =
-        transfer_manager->HostShapeToDeviceShape(shape);
+    const XlaInputPlan::Input& input = input_plan.inputs[i];
+    const xla::Shape& device_shape = input.device_shape;
 
     bool is_resource_variable = resource_vars.count(arg_num);
     bool is_updated_resource_variable =
-        is_resource_variable &&
-        absl::c_any_of(compilation_result->resource_updates,
-                       [&](const XlaCompiler::ResourceUpdate& update) {
-                         return update.input_index == i && update.modified;
-                       });
+        is_resource_variable && input.is_updated_resource_variable;
 
     const Tensor* t = is_resource_variable
                           ? resource_vars.at(arg_num)
                           : &(ctx->input(arg_num - missing_ctx_input_prefix));
     CHECK(t);
     bool donate_buffer =
-        t->RefCountIsOne() && is_updated_resource_variable &&
-        input_output_alias.ParameterHasAlias(i, xla::ShapeIndex{});
+        is_resource_variable && input.may_donate && t->RefCountIsOne();
     VLOG(3) << "Processing input: " << i
             << "; is_resource_variable=" << is_resource_variable
             << "; is_updated_resource_variable=" << is_updated_resource_variable
@@ -245,7 +328,19 @@ XlaComputationLaunchContext::PopulateInputs(
 
     arguments.emplace_back(device_shape, shape);
     xla::ExecutionInput& execution_input = arguments.back();
-    if (xla::Shape::Equal().MinorToMajorOnlyInLayout()(shape, device_shape)) {
+    if (shape.is_dynamic()) {
+      // The argument was padded to a bucket of its shape, see
+      // XlaCompilationCache::PadArgumentsToBuckets.
+      TF_ASSIGN_OR_RETURN(
+          se::OwningDeviceMemory buffer,
+          CopyToDynamicShapeBuffer(
+              ctx->op_device_context() ? ctx->op_device_context()->stream()
+                                       : nullptr,
+              *t, device_shape,
+              client_->backend().compiler()->ShapeSizeBytesFunction(),
+              xla_allocator_, device_ordinal_));
+      *execution_input.MutableBuffer(xla::ShapeIndex{}) = std::move(buffer);
+    } else if (input.device_shape_matches) {
       se::DeviceMemoryBase dmem = XlaTensor::DeviceMemoryFromTensor(*t);
       PopulateExecutionInputBuffer(execution_input, xla::ShapeIndex{}, dmem,
                                    donate_buffer, device_ordinal_,
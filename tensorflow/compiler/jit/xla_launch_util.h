@@ -116,6 +116,30 @@ Status GetVariableInfosFromCtxInputs(OpKernelContext* ctx,
                                      absl::Span<const int> variable_indices,
                                      std::vector<VariableInfo>* result);
 
+// The parts of the marshalling of the inputs of an executable that only depend
+// on its compilation, so that they can be computed once and reused by all the
+// launches of the executable.
+struct XlaInputPlan {
+  struct Input {
+    // The shape of the input on the device.
+    xla::Shape device_shape;
+
+    // Whether the input is a resource variable updated by the computation.
+    bool is_updated_resource_variable = false;
+
+    // Whether the computation may write its update of the input in place, in
+    // the buffer of the input, when the input holds the only reference to it.
+    bool may_donate = false;
+
+    // Whether the device shape of the input differs from its host shape only
+    // in its layout, so that the buffer of its tensor can be passed as is.
+    bool device_shape_matches = false;
+  };
+
+  // Indexed like the `xla_input_shapes` of the compilation result.
+  std::vector<Input> inputs;
+};
+
 // Helper class to perform the marshalling of TensorFlow inputs and outputs to
 // ShapedBuffers suitable for passing to an XLA computation.
 class XlaComputationLaunchContext {
@@ -141,6 +165,13 @@ class XlaComputationLaunchContext {
       absl::Span<VariableInfo const> variable_args, OpKernelContext* ctx,
       std::vector<XlaCompiler::Argument>* args);
 
+  // Computes the parts of the marshalling of the inputs of the executable of
+  // `compilation_result`, whose input/output aliasing is `input_output_alias`,
+  // that are the same for every launch.
+  XlaInputPlan BuildInputPlan(
+      const XlaCompiler::CompilationResult* compilation_result,
+      const xla::HloInputOutputAliasConfig& input_output_alias) const;
+
   // Add all inputs within `ctx` as XLA arguments (returned by arguments()).
   // `variables` is a map from TensorFlow argument number to resource variable.
   //
@@ -155,6 +186,13 @@ class XlaComputationLaunchContext {
       int missing_ctx_input_prefix,
       const xla::HloInputOutputAliasConfig& input_output_alias);
 
+  // Like the above, with the plan `BuildInputPlan` returned for the executable.
+  xla::StatusOr<std::vector<xla::ExecutionInput>> PopulateInputs(
+      OpKernelContext* ctx,
+      const XlaCompiler::CompilationResult* compilation_result,
+      const std::map<int, const Tensor*>& resource_vars,
+      int missing_ctx_input_prefix, const XlaInputPlan& input_plan);
+
   // Given the XLA output in `output`, populate all outputs of `ctx`.  Also
   // writes out the resource variable updates.
   //
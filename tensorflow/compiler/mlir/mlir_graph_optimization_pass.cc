@@ -32,6 +32,8 @@ limitations under the License.
 #include "tensorflow/compiler/mlir/tensorflow/utils/device_util.h"
 #include "tensorflow/compiler/mlir/tensorflow/utils/dump_mlir_util.h"
 #include "tensorflow/core/common_runtime/graph_constructor.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
+#include "tensorflow/core/platform/fingerprint.h"
 #include "tensorflow/core/public/session_options.h"
 
 namespace tensorflow {
@@ -86,6 +88,34 @@ static void DumpModule(mlir::ModuleOp module, std::string file_prefix) {
   VLOG(1) << "Dumped MLIR module to " << prefix;
 }
 
+// Returns the fingerprint of the inputs of a run of the function optimization
+// pass, which determine its output.
+static uint64 RunFingerprint(const DeviceSet& device_set,
+                             const ConfigProto& config_proto,
+                             const Graph& graph,
+                             const FunctionLibraryDefinition& flib_def,
+                             const std::vector<std::string>& control_rets) {
+  auto proto_fingerprint = [](const protobuf::MessageLite& proto) {
+    std::string serialized;
+    SerializeToStringDeterministic(proto, &serialized);
+    return Fingerprint64(serialized);
+  };
+  GraphDef graph_def;
+  graph.ToGraphDef(&graph_def);
+  uint64 fingerprint = proto_fingerprint(graph_def);
+  fingerprint = FingerprintCat64(
+      fingerprint,
+      proto_fingerprint(flib_def.ReachableDefinitions(graph_def).ToProto()));
+  fingerprint = FingerprintCat64(fingerprint, proto_fingerprint(config_proto));
+  for (const Device* device : device_set.devices()) {
+    fingerprint = FingerprintCat64(fingerprint, Fingerprint64(device->name()));
+  }
+  for (const std::string& control_ret : control_rets) {
+    fingerprint = FingerprintCat64(fingerprint, Fingerprint64(control_ret));
+  }
+  return fingerprint;
+}
+
 MlirOptimizationPassRegistry& MlirOptimizationPassRegistry::Global() {
   static auto* global = new MlirOptimizationPassRegistry();
   return *global;
@@ -125,6 +155,40 @@ Status MlirFunctionOptimizationPass::Run(
                           << "(registered " << registry_->passes().size()
                           << " passes)";
 
+  const uint64 key = RunFingerprint(device_set, config_proto, **graph,
+                                    *flib_def, *control_ret_node_names);
+  CachedRun cached;
+  bool is_cached = false;
+  {
+    mutex_lock l(mu_);
+    auto it = cached_runs_.find(key);
+    if (it != cached_runs_.end()) {
+      cached = it->second;
+      is_cached = true;
+    }
+  }
+  if (is_cached) {
+    VLOG(1) << "Reusing the output of a previous run of the MLIR graph "
+               "optimization passes";
+    for (const FunctionDef& fdef : cached.library.function()) {
+      const std::string& name = fdef.signature().name();
+      if (flib_def->Contains(name)) {
+        TF_RETURN_IF_ERROR(flib_def->ReplaceFunction(name, fdef));
+      } else {
+        TF_RETURN_IF_ERROR(flib_def->AddFunctionDef(fdef));
+      }
+    }
+    GraphConstructorOptions opts;
+    opts.allow_internal_ops = true;
+    auto cached_graph = std::make_unique<Graph>(flib_def);
+    TF_RETURN_IF_ERROR(ConvertGraphDefToGraph(opts, std::move(cached.graph),
+                                              cached_graph.get()));
+    *graph = std::move(cached_graph);
+    *control_ret_node_names = std::move(cached.control_ret_node_names);
+    *control_rets_updated = true;
+    return Status::OK();
+  }
+
   GraphDebugInfo debug_info;
   RegisterDialects();
   mlir::MLIRContext context;
@@ -173,6 +237,20 @@ Status MlirFunctionOptimizationPass::Run(
 
   *control_rets_updated = true;
 
+  // The passes are run without holding the lock, so concurrent runs with the
+  // same inputs may both miss; only the first output is cached.
+  (*graph)->ToGraphDef(&cached.graph);
+  cached.library = flib_def->ReachableDefinitions(cached.graph).ToProto();
+  cached.control_ret_node_names = *control_ret_node_names;
+  mutex_lock l(mu_);
+  if (cached_runs_.emplace(key, std::move(cached)).second) {
+    cached_run_keys_.push_back(key);
+    if (cached_run_keys_.size() > kMaxCachedRuns) {
+      cached_runs_.erase(cached_run_keys_.front());
+      cached_run_keys_.pop_front();
+    }
+  }
+
   return Status::OK();
 }
 
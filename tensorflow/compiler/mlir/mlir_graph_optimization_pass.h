@@ -16,9 +16,15 @@ limitations under the License.
 #ifndef TENSORFLOW_COMPILER_MLIR_MLIR_GRAPH_OPTIMIZATION_PASS_H_
 #define TENSORFLOW_COMPILER_MLIR_MLIR_GRAPH_OPTIMIZATION_PASS_H_
 
+#include <deque>
+
+#include "absl/container/flat_hash_map.h"
 #include "mlir/IR/Module.h"  // from @llvm-project
 #include "tensorflow/core/common_runtime/function_optimization_registry.h"
 #include "tensorflow/core/common_runtime/optimization_registry.h"
+#include "tensorflow/core/framework/function.pb.h"
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/platform/mutex.h"
 
 namespace tensorflow {
 
@@ -71,6 +77,10 @@ class MlirOptimizationPassRegistry {
 
 // Function optimization pass that runs all MLIR passes registered in
 // MlirOptimizationPassRegistry.
+//
+// The round trip of a graph through MLIR is costly and the same function is
+// often instantiated several times (e.g. on each device it runs on), so the
+// outputs of the last runs are cached by fingerprint of their inputs.
 class MlirFunctionOptimizationPass : public FunctionOptimizationPass {
  public:
   explicit MlirFunctionOptimizationPass(
@@ -83,8 +93,24 @@ class MlirFunctionOptimizationPass : public FunctionOptimizationPass {
              std::vector<std::string>* control_ret_node_names,
              bool* control_rets_updated) override;
 
+  // The maximum number of runs whose outputs are cached.
+  static constexpr size_t kMaxCachedRuns = 64;
+
  private:
+  // The output of a run of the passes over a function graph.
+  struct CachedRun {
+    GraphDef graph;
+    // The functions that `graph` may call.
+    FunctionDefLibrary library;
+    std::vector<std::string> control_ret_node_names;
+  };
+
   const MlirOptimizationPassRegistry* registry_;
+
+  mutex mu_;
+  absl::flat_hash_map<uint64, CachedRun> cached_runs_ TF_GUARDED_BY(mu_);
+  // The keys of `cached_runs_`, from the oldest to the newest.
+  std::deque<uint64> cached_run_keys_ TF_GUARDED_BY(mu_);
 };
 
 // -------------------------------------------------------------------------- //
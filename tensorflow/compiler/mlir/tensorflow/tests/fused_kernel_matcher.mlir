@@ -158,3 +158,14 @@ func @matmulBiasAdd_elu(%arg0: tensor<64xf32>, %arg1: tensor<8x32xf32>, %arg2: t
   %6 = "tf.Identity"(%5) : (tensor<*xf32>) -> tensor<*xf32>
   return %6 : tensor<*xf32>
 }
+
+// CHECK-LABEL: matmulBiasAdd_onGpu
+func @matmulBiasAdd_onGpu(%arg0: tensor<64xf32>, %arg1: tensor<8x32xf32>, %arg2: tensor<32x64xf32>) -> (tensor<*xf32>) {
+  // CHECK-NOT: "tf._FusedMatMul"
+  // CHECK: "tf.MatMul"
+  // CHECK: "tf.BiasAdd"
+  %3 = "tf.MatMul"(%arg1, %arg2) {device = "/job:localhost/replica:0/task:0/device:GPU:0", transpose_a = false, transpose_b = false} : (tensor<8x32xf32>, tensor<32x64xf32>) -> tensor<*xf32>
+  %4 = "tf.BiasAdd"(%3, %arg0) {data_format = "NHWC"} : (tensor<*xf32>, tensor<64xf32>) -> tensor<*xf32>
+  %5 = "tf.Identity"(%4) : (tensor<*xf32>) -> tensor<*xf32>
+  return %5 : tensor<*xf32>
+}
@@ -25,6 +25,7 @@ limitations under the License.
 #include "mlir/Support/LLVM.h"  // from @llvm-project
 #include "mlir/Support/LogicalResult.h"  // from @llvm-project
 #include "tensorflow/compiler/mlir/tensorflow/ir/tf_ops.h"
+#include "tensorflow/core/util/device_name_utils.h"
 
 namespace mlir {
 
@@ -52,6 +53,17 @@ struct FusedKernelMatcherPass
   void runOnFunction() override;
 };
 
+// Returns true if `op` is explicitly placed on a device other than a CPU, for
+// which the fusions of this pass are not supported.
+bool IsPlacedOnNonCpuDevice(Operation *op) {
+  auto device = op->getAttrOfType<StringAttr>("device");
+  if (!device || device.getValue().empty()) return false;
+  tensorflow::DeviceNameUtils::ParsedName parsed_device;
+  return tensorflow::DeviceNameUtils::ParseFullName(device.getValue().str(),
+                                                    &parsed_device) &&
+         parsed_device.has_type && parsed_device.type != "CPU";
+}
+
 bool IsActivationFunction(Operation *op) {
   return isa<EluOp, ReluOp, Relu6Op>(op);
 }
@@ -105,6 +117,10 @@ class FuseContractionWithBiasAdd : public OpRewritePattern<SrcOpT> {
   LogicalResult matchAndRewrite(SrcOpT contraction,
                                 PatternRewriter &rewriter) const override {
     auto context = rewriter.getContext();
+    if (IsPlacedOnNonCpuDevice(contraction)) {
+      return rewriter.notifyMatchFailure(contraction,
+                                         "is not placed on a CPU device");
+    }
     // If the contraction is used in multiple places, fusing it will only create
     // more contraction nodes, which is slower.
     if (!contraction.getResult().hasOneUse())
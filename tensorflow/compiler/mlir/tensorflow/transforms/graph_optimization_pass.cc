@@ -19,7 +19,9 @@ limitations under the License.
 #include "mlir/Pass/PassManager.h"  // from @llvm-project
 #include "mlir/Support/LogicalResult.h"  // from @llvm-project
 #include "mlir/Transforms/Passes.h"  // from @llvm-project
+#include "tensorflow/compiler/mlir/tensorflow/ir/tf_structs.h"
 #include "tensorflow/compiler/mlir/tensorflow/transforms/passes.h"
+#include "tensorflow/compiler/mlir/tensorflow/utils/device_util.h"
 #include "tensorflow/compiler/mlir/tensorflow/utils/error_util.h"
 
 namespace mlir {
@@ -27,6 +29,16 @@ namespace TF {
 namespace {
 using Status = ::tensorflow::Status;
 using ConfigProto = ::tensorflow::ConfigProto;
+
+// Returns true if the module may run on GPUs. The graph is not placed yet, so
+// the ops without a device may be placed on any of the devices of the module.
+bool HasGpuDevices(ModuleOp module) {
+  RuntimeDevices devices;
+  if (failed(::tensorflow::GetDevicesFromOp(module, &devices))) return true;
+  return llvm::any_of(devices.device_names(), [](const auto& device) {
+    return device.has_type && device.type == "GPU";
+  });
+}
 }  // namespace
 
 Status MlirGraphOptimizationPass::Run(const ConfigProto& config_proto,
@@ -40,16 +52,31 @@ Status MlirGraphOptimizationPass::Run(const ConfigProto& config_proto,
   VLOG(1) << "Run MLIR Graph Optimization Passes";
   PassManager pm(module.getContext());
 
+  // Prune the nodes that the fetches and the control outputs don't depend on.
+  pm.addNestedPass<FuncOp>(tf_executor::CreateTFExecutorGraphPruningPass());
+
   // Run island coarsening before shape inference to allow more exact shape
   // inference using constant folding within islands.
   pm.addNestedPass<FuncOp>(tf_executor::CreateTFExecutorIslandCoarseningPass());
   pm.addPass(CreateTFShapeInferencePass());
 
+  // Fold the constant subgraphs, through the TensorFlow constant folding hook
+  // of the canonicalizer, and simplify the arithmetic they feed.
+  pm.addNestedPass<FuncOp>(createCanonicalizerPass());
+  pm.addNestedPass<FuncOp>(CreateTFOptimizePass());
+
   // Assign optimal data layout to layout sensitive operations and delete
   // redundant transposes from the IR.
   LayoutOptimizationPipelineOptions layout_optimization_options;
   CreateLayoutOptimizationPipeline(pm, layout_optimization_options);
 
+  // Fuse contractions with their bias and activation. Only the CPU kernels
+  // support all of these fusions, and the ops without a device must not be
+  // pulled off the GPUs.
+  if (!HasGpuDevices(module)) {
+    pm.addNestedPass<FuncOp>(CreateFusedKernelMatcherPass());
+  }
+
   // Prepare IR for exporting.
   pm.addPass(CreateBreakUpIslandsPass());
 
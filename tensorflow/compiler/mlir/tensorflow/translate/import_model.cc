@@ -17,6 +17,7 @@ limitations under the License.
 
 #include <iterator>
 #include <memory>
+#include <set>
 #include <string>
 #include <tuple>
 #include <type_traits>
@@ -101,9 +102,13 @@ limitations under the License.
 #include "tensorflow/core/grappler/utils/transitive_fanin.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/platform/blocking_counter.h"
+#include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/path.h"
 #include "tensorflow/core/platform/protobuf.h"
+#include "tensorflow/core/platform/threadpool.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/protobuf/graph_debug_info.pb.h"
 #include "tensorflow/core/protobuf/meta_graph.pb.h"
@@ -319,6 +324,20 @@ class ImporterBase {
   // Converts the given non-function-call AttrValue to an MLIR Attribute.
   StatusOr<mlir::Attribute> ConvertAttributeValue(const AttrValue& value);
 
+  // Returns the interned "tf." operation name of the TensorFlow op type.
+  mlir::OperationName GetOperationName(absl::string_view op_type);
+
+  // Returns the interned identifier of the attribute name.
+  mlir::Identifier GetAttributeName(absl::string_view attr_name);
+
+  // Returns the interned "device" attribute of the node.
+  mlir::NamedAttribute GetDeviceAttribute(const NodeDef& node_def);
+
+  // Builds the bodies of the library functions called from graph_ on a thread
+  // pool, ahead of their conversion by ConvertLibFunction. Only the MLIR
+  // functions are built serially, as they are all added to module_.
+  void PrebuildFunctionBodies();
+
   // Converts the given function-call AttrValue to MLIR Attributes and pushes
   // them to the given attributes list. For example, if there is a kFunc
   // AttrValue {name : foo, attrs : {k1 : bar, k2 : rfc}}, it will convert it to
@@ -433,6 +452,21 @@ class ImporterBase {
   NameUniquifier* function_name_uniquifier_;
   mlir::StatusScopedDiagnosticHandler error_handler_;
 
+  // The state shared by the importer of a graph and the importers of the
+  // library functions it calls, so that huge graphs with many functions intern
+  // the same names only once.
+  struct SharedState {
+    absl::flat_hash_map<std::string, mlir::OperationName> op_names;
+    absl::flat_hash_map<std::string, mlir::Identifier> attr_names;
+    absl::flat_hash_map<std::string, mlir::StringAttr> device_attrs;
+    // The function bodies built by PrebuildFunctionBodies, removed once the
+    // function is converted.
+    absl::flat_hash_map<std::string, std::unique_ptr<FunctionBody>>
+        function_bodies;
+    bool function_bodies_prebuilt = false;
+  };
+  std::shared_ptr<SharedState> shared_state_ = std::make_shared<SharedState>();
+
  protected:
   // Maps feed as TensorId to new Placeholder node name.
   absl::flat_hash_map<TensorId, absl::string_view> remapped_feeds_;
@@ -1126,6 +1160,41 @@ StatusOr<mlir::FlatSymbolRefAttr> ImporterBase::ConvertFunctionCallName(
   return builder_.getSymbolRefAttr(func);
 }
 
+mlir::OperationName ImporterBase::GetOperationName(absl::string_view op_type) {
+  auto it = shared_state_->op_names.find(op_type);
+  if (it == shared_state_->op_names.end()) {
+    it = shared_state_->op_names
+             .emplace(std::string(op_type),
+                      mlir::OperationName(absl::StrCat("tf.", op_type),
+                                          context_))
+             .first;
+  }
+  return it->second;
+}
+
+mlir::Identifier ImporterBase::GetAttributeName(absl::string_view attr_name) {
+  auto it = shared_state_->attr_names.find(attr_name);
+  if (it == shared_state_->attr_names.end()) {
+    it = shared_state_->attr_names
+             .emplace(std::string(attr_name),
+                      builder_.getIdentifier(
+                          llvm::StringRef(attr_name.data(), attr_name.size())))
+             .first;
+  }
+  return it->second;
+}
+
+mlir::NamedAttribute ImporterBase::GetDeviceAttribute(const NodeDef& node_def) {
+  auto it = shared_state_->device_attrs.find(node_def.device());
+  if (it == shared_state_->device_attrs.end()) {
+    it = shared_state_->device_attrs
+             .emplace(node_def.device(),
+                      builder_.getStringAttr(node_def.device()))
+             .first;
+  }
+  return mlir::NamedAttribute(GetAttributeName("device"), it->second);
+}
+
 StatusOr<mlir::Attribute> ImporterBase::ConvertAttributeValue(
     const AttrValue& value) {
   switch (value.value_case()) {
@@ -1234,10 +1303,17 @@ Status ImporterBase::ConvertLibFunction(llvm::StringRef func_name) {
                      "'. The imported TensorFlow GraphDef is ill-formed."));
   }
 
-  // Converts the function definition to a graph.
+  // Converts the function definition to a graph, unless it was prebuilt.
   std::unique_ptr<FunctionBody> fbody;
-  TF_RETURN_IF_ERROR(
-      FunctionDefToBodyHelper(*func_def, AttrSlice(), &func_lib, &fbody));
+  auto prebuilt_body =
+      shared_state_->function_bodies.find(StringRefToView(func_name));
+  if (prebuilt_body != shared_state_->function_bodies.end()) {
+    fbody = std::move(prebuilt_body->second);
+    shared_state_->function_bodies.erase(prebuilt_body);
+  } else {
+    TF_RETURN_IF_ERROR(
+        FunctionDefToBodyHelper(*func_def, AttrSlice(), &func_lib, &fbody));
+  }
 
   // Converts the argument and return types to MLIR types.
   absl::InlinedVector<mlir::NamedAttribute, 8> attributes;
@@ -1249,7 +1325,8 @@ Status ImporterBase::ConvertLibFunction(llvm::StringRef func_name) {
                         ConvertAttributeValue(name_and_value.second));
     std::string attr_name =
         mangling_util::MangleAttributeName(name_and_value.first);
-    attributes.push_back(builder_.getNamedAttr(attr_name, attr));
+    attributes.push_back(
+        mlir::NamedAttribute(GetAttributeName(attr_name), attr));
   }
 
   // Checks opdef stateful attribute and import that as Function Attribute
@@ -1298,6 +1375,7 @@ Status ImporterBase::ConvertLibFunction(llvm::StringRef func_name) {
   ImporterBase child_importer(graph_flib_, debug_info_, specs, module_,
                               tf_name_to_mlir_name_, function_name_uniquifier_,
                               func_name);
+  child_importer.shared_state_ = shared_state_;
   TF_RETURN_IF_ERROR(child_importer.PrepareConvert(*fbody->graph));
 
   TF_ASSIGN_OR_RETURN(auto func_type,
@@ -1405,9 +1483,76 @@ Status ImporterBase::PrepareConvert(const Graph& graph) {
         [](const Node* n1, const Node* n2) { return n1->name() < n2->name(); });
   }
 
+  // The importers of the library functions share the prebuilt bodies.
+  if (!shared_state_->function_bodies_prebuilt) {
+    shared_state_->function_bodies_prebuilt = true;
+    PrebuildFunctionBodies();
+  }
+
   return Status::OK();
 }
 
+void ImporterBase::PrebuildFunctionBodies() {
+  // Collects the library functions the nodes call, directly or through
+  // function attributes, and the functions they call in turn.
+  std::set<std::string> func_names;
+  auto add_function = [&](const std::string& name) {
+    const FunctionDef* func_def = graph_flib_.Find(name);
+    if (func_def == nullptr || !func_names.insert(name).second) return;
+    for (const std::string& reachable_name :
+         graph_flib_.ReachableDefinitions(*func_def).ListFunctionNames()) {
+      func_names.insert(reachable_name);
+    }
+  };
+  for (const Node* node : graph_->op_nodes()) {
+    add_function(node->type_string());
+    for (const auto& name_and_value : node->attrs()) {
+      const AttrValue& attr_value = name_and_value.second;
+      if (attr_value.value_case() == AttrValue::kFunc) {
+        add_function(attr_value.func().name());
+      } else if (attr_value.value_case() == AttrValue::kList) {
+        for (const auto& func : attr_value.list().func()) {
+          add_function(func.name());
+        }
+      }
+    }
+  }
+  // A single function is not worth a thread pool.
+  if (func_names.size() < 2) return;
+
+  std::vector<const FunctionDef*> func_defs;
+  func_defs.reserve(func_names.size());
+  for (const std::string& name : func_names) {
+    func_defs.push_back(graph_flib_.Find(name));
+  }
+  std::vector<std::unique_ptr<FunctionBody>> fbodies(func_defs.size());
+  const int num_threads = std::min<int>(port::MaxParallelism(),
+                                        static_cast<int>(func_defs.size()));
+  {
+    thread::ThreadPool thread_pool(Env::Default(), "import_function_bodies",
+                                   num_threads);
+    BlockingCounter counter(func_defs.size());
+    for (int i = 0, e = func_defs.size(); i < e; ++i) {
+      thread_pool.Schedule([&, i]() {
+        // A function failing here is built again, and fails with the same
+        // error, when it is converted.
+        FunctionDefToBodyHelper(*func_defs[i], AttrSlice(), &graph_flib_,
+                                &fbodies[i])
+            .IgnoreError();
+        counter.DecrementCount();
+      });
+    }
+    counter.Wait();
+  }
+
+  auto name_it = func_names.begin();
+  for (int i = 0, e = fbodies.size(); i < e; ++i, ++name_it) {
+    if (fbodies[i] != nullptr) {
+      shared_state_->function_bodies.emplace(*name_it, std::move(fbodies[i]));
+    }
+  }
+}
+
 Status ImporterBase::Convert(
     llvm::StringRef func_name, mlir::FunctionType func_type,
     const absl::InlinedVector<OutputTensor, 4>& arg_nodes,
@@ -1794,27 +1939,24 @@ Status ImporterBase::ConvertNode(const Node& node) {
 
   // If it is a custom OP, its definition should be found in the library. We
   // create the MLIR function and insert it to the module if it doesn't exist.
-  std::string node_type_name = node.type_string();
-  const auto* func_def = graph_flib_.Find(node_type_name);
+  // The op names are interned, so no string is built per node.
+  llvm::StringRef node_type_name = node.type_string();
+  const auto* func_def = graph_flib_.Find(node.type_string());
   bool convert_to_legacy_call = false;
   if (func_def) {
     TF_RETURN_IF_ERROR(ConvertLibFunction(node_type_name));
-    node_type_name = (*tf_name_to_mlir_name_)[node_type_name];
+    node_type_name = (*tf_name_to_mlir_name_)[node.type_string()];
     convert_to_legacy_call = true;
   }
 
-  auto get_full_op_name = [&](const std::string& op_name) {
-    const char* kTfPrefix = "tf.";
-    return kTfPrefix + op_name;
-  };
-
-  std::string op_name = get_full_op_name(node_type_name);
+  const auto& node_def = node.def();
+  mlir::OperationState result(
+      GetLocation(node_def), GetOperationName(StringRefToView(node_type_name)));
   if (back_edge_node_output_.contains(&node)) {
-    op_name = op_name + ".sink";
+    result.name = mlir::OperationName(
+        absl::StrCat("tf.", StringRefToView(node_type_name), ".sink"),
+        context_);
   }
-
-  const auto& node_def = node.def();
-  mlir::OperationState result(GetLocation(node_def), op_name);
   for (int i = 0; i < node.num_outputs(); ++i) {
     // The backedge has been removed, so we shouldn't count the corresponding
     // output from the src node when converting to an operation.
@@ -1905,7 +2047,8 @@ Status ImporterBase::ConvertNode(const Node& node) {
       funcs.emplace_back(&attr_name, &attr_value);
     } else {
       TF_ASSIGN_OR_RETURN(auto attr, ConvertAttributeValue(attr_value));
-      result.attributes.push_back(builder_.getNamedAttr(attr_name, attr));
+      result.attributes.push_back(
+          mlir::NamedAttribute(GetAttributeName(attr_name), attr));
     }
   }
 
@@ -1918,13 +2061,12 @@ Status ImporterBase::ConvertNode(const Node& node) {
                                                     &result.attributes));
   }
 
-  result.attributes.push_back(builder_.getNamedAttr(
-      "device", builder_.getStringAttr(std::string(node_def.device()))));
+  result.attributes.push_back(GetDeviceAttribute(node_def));
 
   // Map user function calls to LegacyCall ops and add the user function name
   // as an attribute.
   if (convert_to_legacy_call) {
-    result.name = mlir::OperationName(get_full_op_name("LegacyCall"), context_);
+    result.name = GetOperationName("LegacyCall");
     mlir::SymbolRefAttr val = builder_.getSymbolRefAttr(node_type_name);
     result.addAttribute("f", val);
 
@@ -1934,9 +2076,9 @@ Status ImporterBase::ConvertNode(const Node& node) {
     }
   }
 
-  auto composite_control_flow_op = [&](const std::string& name) {
-    result.name = mlir::OperationName(get_full_op_name(name), context_);
-    bool stateless = absl::StartsWith(node_type_name, "Stateless");
+  auto composite_control_flow_op = [&](absl::string_view name) {
+    result.name = GetOperationName(name);
+    bool stateless = node_type_name.startswith("Stateless");
     mlir::BoolAttr val = builder_.getBoolAttr(stateless);
     result.attributes.push_back(builder_.getNamedAttr("is_stateless", val));
   };
@@ -0,0 +1,110 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/mlir/tensorflow/translate/import_model.h"
+
+#include <string>
+
+#include "absl/strings/str_cat.h"
+#include "mlir/IR/Function.h"  // from @llvm-project
+#include "mlir/IR/MLIRContext.h"  // from @llvm-project
+#include "mlir/IR/Module.h"  // from @llvm-project
+#include "tensorflow/compiler/mlir/tensorflow/ir/tf_ops.h"
+#include "tensorflow/compiler/mlir/tensorflow/translate/mlir_roundtrip_flags.h"
+#include "tensorflow/compiler/xla/test.h"
+#include "tensorflow/core/framework/function_testlib.h"
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+#include "tensorflow/core/protobuf/graph_debug_info.pb.h"
+
+namespace tensorflow {
+namespace {
+
+// Returns a chain of `num_nodes` nodes fed by a placeholder, the first
+// `num_functions` of which call their own copy of XTimesTwo and the others are
+// Identity nodes.
+GraphDef MakeGraph(int num_functions, int num_nodes) {
+  GraphDef graph_def;
+  for (int i = 0; i < num_functions; ++i) {
+    FunctionDef* func = graph_def.mutable_library()->add_function();
+    *func = test::function::XTimesTwo();
+    func->mutable_signature()->set_name(absl::StrCat("XTimesTwo", i));
+  }
+  NodeDef* input = graph_def.add_node();
+  input->set_name("input");
+  input->set_op("Placeholder");
+  (*input->mutable_attr())["dtype"].set_type(DT_FLOAT);
+  std::string previous = input->name();
+  for (int i = 0; i < num_nodes; ++i) {
+    NodeDef* node = graph_def.add_node();
+    node->set_name(absl::StrCat("node", i));
+    node->set_op(i < num_functions ? absl::StrCat("XTimesTwo", i)
+                                   : std::string("Identity"));
+    node->set_device("/job:localhost/replica:0/task:0/device:CPU:0");
+    node->add_input(previous);
+    (*node->mutable_attr())["T"].set_type(DT_FLOAT);
+    previous = node->name();
+  }
+  return graph_def;
+}
+
+TEST(ImportModelTest, ImportsAllLibraryFunctions) {
+  constexpr int kNumFunctions = 8;
+  GraphDef graph_def = MakeGraph(kNumFunctions, 2 * kNumFunctions);
+  mlir::MLIRContext context;
+  auto module_or = ConvertGraphdefToMlir(graph_def, GraphDebugInfo(),
+                                         GraphImportConfig(), &context);
+  TF_ASSERT_OK(module_or.status());
+  mlir::ModuleOp module = module_or.ValueOrDie().get();
+
+  for (int i = 0; i < kNumFunctions; ++i) {
+    const std::string func_name = absl::StrCat("XTimesTwo", i);
+    EXPECT_TRUE(module.lookupSymbol<mlir::FuncOp>(func_name))
+        << "Missing function " << func_name;
+  }
+  int num_calls = 0;
+  int num_identities = 0;
+  module.walk([&](mlir::Operation* op) {
+    if (llvm::isa<mlir::TF::LegacyCallOp>(op)) ++num_calls;
+    if (llvm::isa<mlir::TF::IdentityOp>(op)) ++num_identities;
+  });
+  EXPECT_EQ(num_calls, kNumFunctions);
+  EXPECT_EQ(num_identities, kNumFunctions);
+}
+
+void BM_ImportGraphDef(int iters, int num_functions, int num_nodes) {
+  testing::StopTiming();
+  GraphDef graph_def = MakeGraph(num_functions, num_nodes);
+  testing::UseRealTime();
+  testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    mlir::MLIRContext context;
+    auto module_or = ConvertGraphdefToMlir(graph_def, GraphDebugInfo(),
+                                           GraphImportConfig(), &context);
+    CHECK(module_or.ok());
+  }
+  testing::StopTiming();
+  testing::ItemsProcessed(static_cast<int64>(iters) * num_nodes);
+}
+BENCHMARK(BM_ImportGraphDef)
+    ->ArgPair(0, 1000)
+    ->ArgPair(0, 100000)
+    ->ArgPair(100, 1000)
+    ->ArgPair(1000, 10000);
+
+}  // namespace
+}  // namespace tensorflow
@@ -769,6 +769,17 @@ Status XlaCompiler::XLAShapeForArgument(
         TF_RETURN_IF_ERROR(RewriteLayoutWithShardedShape(
             arg_sharding, /*use_fast_memory=*/false,
             options_.shape_representation_fn, xla_shape));
+        // Keep the dynamic dimensions of the argument, unless the shape
+        // representation changed its rank.
+        if (absl::holds_alternative<xla::Shape>(arg.shape)) {
+          const xla::Shape& arg_shape = absl::get<xla::Shape>(arg.shape);
+          if (xla_shape->IsArray() && xla_shape->rank() == arg_shape.rank()) {
+            for (int d = 0; d < arg_shape.rank(); ++d) {
+              xla_shape->set_dynamic_dimension(
+                  d, arg_shape.is_dynamic_dimension(d));
+            }
+          }
+        }
       } else {
         if (absl::holds_alternative<xla::Shape>(arg.shape)) {
           *xla_shape = absl::get<xla::Shape>(arg.shape);
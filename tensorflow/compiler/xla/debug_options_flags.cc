@@ -24,6 +24,7 @@ limitations under the License.
 #include "absl/strings/str_split.h"
 #include "tensorflow/compiler/xla/debug_options_parsers.h"
 #include "tensorflow/compiler/xla/parse_flags_from_env.h"
+#include "tensorflow/core/platform/protobuf.h"
 
 namespace xla {
 
@@ -137,6 +138,14 @@ static void AllocateFlags() {
     };
   };
 
+  auto int64_setter_for =
+      [](void (DebugOptions::*member_setter)(tensorflow::protobuf_int64)) {
+        return [member_setter](int64 value) {
+          (flag_values->*member_setter)(value);
+          return true;
+        };
+      };
+
   auto string_setter_for =
       [](void (DebugOptions::*member_setter)(const string& value)) {
         return [member_setter](const string& value) {
@@ -545,6 +554,70 @@ static void AllocateFlags() {
       bool_setter_for(&DebugOptions::set_xla_gpu_deterministic_reductions),
       flag_values->xla_gpu_deterministic_reductions(),
       "Always run deterministic reductions on GPU"));
+  flag_objects->push_back(tensorflow::Flag(
+      "xla_gpu_enable_cuda_graphs",
+      bool_setter_for(&DebugOptions::set_xla_gpu_enable_cuda_graphs),
+      flag_values->xla_gpu_enable_cuda_graphs(),
+      "Replay the thunks of GPU executables as CUDA graphs, updated to the "
+      "buffers of each run."));
+  flag_objects->push_back(tensorflow::Flag(
+      "xla_gpu_persistent_cache_dir",
+      string_setter_for(&DebugOptions::set_xla_gpu_persistent_cache_dir),
+      flag_values->xla_gpu_persistent_cache_dir(),
+      "If set, XLA:GPU stores the PTX and cubin of the modules it compiles in "
+      "this directory and reuses them across processes."));
+  flag_objects->push_back(tensorflow::Flag(
+      "xla_gpu_force_compilation_parallelism",
+      int32_setter_for(
+          &DebugOptions::set_xla_gpu_force_compilation_parallelism),
+      flag_values->xla_gpu_force_compilation_parallelism(),
+      "If greater than 1, XLA:GPU splits the LLVM module of an executable "
+      "into this many parts which are compiled in parallel and then linked."));
+  flag_objects->push_back(tensorflow::Flag(
+      "xla_gpu_enable_fusion_cost_model",
+      bool_setter_for(&DebugOptions::set_xla_gpu_enable_fusion_cost_model),
+      flag_values->xla_gpu_enable_fusion_cost_model(),
+      "Only fuse instructions on GPU when a model of the kernel run times "
+      "estimates the fusion not to be slower."));
+  flag_objects->push_back(tensorflow::Flag(
+      "xla_gpu_enable_latency_hiding_scheduler",
+      bool_setter_for(
+          &DebugOptions::set_xla_gpu_enable_latency_hiding_scheduler),
+      flag_values->xla_gpu_enable_latency_hiding_scheduler(),
+      "Run collectives on a stream of their own on GPU, and order the thunk "
+      "launches to overlap them with independent computation."));
+  flag_objects->push_back(tensorflow::Flag(
+      "xla_gpu_latency_hiding_scheduler_memory_limit",
+      int64_setter_for(
+          &DebugOptions::set_xla_gpu_latency_hiding_scheduler_memory_limit),
+      static_cast<int64>(
+          flag_values->xla_gpu_latency_hiding_scheduler_memory_limit()),
+      "The most bytes live at once in the order of the GPU latency hiding "
+      "scheduler. If not positive, 110% of the peak of the memory-minimizing "
+      "order."));
+  flag_objects->push_back(tensorflow::Flag(
+      "xla_gpu_host_offload_device_memory_limit",
+      int64_setter_for(
+          &DebugOptions::set_xla_gpu_host_offload_device_memory_limit),
+      static_cast<int64>(
+          flag_values->xla_gpu_host_offload_device_memory_limit()),
+      "If positive, the most bytes of device memory the temporary buffers of "
+      "a GPU computation may use. The other buffers are held in pinned host "
+      "memory, and prefetched back to device memory with asynchronous "
+      "copies."));
+  flag_objects->push_back(tensorflow::Flag(
+      "xla_gpu_autotune_results_path",
+      string_setter_for(&DebugOptions::set_xla_gpu_autotune_results_path),
+      flag_values->xla_gpu_autotune_results_path(),
+      "If not empty, a file the GEMM and convolution autotuning results of "
+      "XLA:GPU are loaded from and saved to, so that later runs do not "
+      "autotune the same ops again."));
+  flag_objects->push_back(tensorflow::Flag(
+      "xla_gpu_enable_cublaslt",
+      bool_setter_for(&DebugOptions::set_xla_gpu_enable_cublaslt),
+      flag_values->xla_gpu_enable_cublaslt(),
+      "Fuse bias adds and relus into the preceding gemms, which then run "
+      "through cuBLASLt epilogues. Requires CUDA 11."));
   flag_objects->push_back(tensorflow::Flag(
       "xla_tpu_detect_nan",
       bool_setter_for(&DebugOptions::set_xla_tpu_detect_nan),
@@ -22,6 +22,7 @@ limitations under the License.
 #include <numeric>
 #include <vector>
 
+#include "absl/algorithm/container.h"
 #include "absl/base/casts.h"
 #include "absl/memory/memory.h"
 #include "absl/strings/str_cat.h"
@@ -780,6 +781,52 @@ StatusOr<Literal> LiteralBase::Broadcast(
     result.SetDynamicSize(dimensions[i], dynamic_size);
   }
 
+  // When the most minor dimension of the result is either not broadcast from
+  // the operand, or broadcast from the most minor dimension of the operand, a
+  // run along it is a single source element repeated, or a contiguous run of
+  // the source.
+  const Shape& dest_shape = result.shape();
+  if (dest_shape.rank() > 0 && !ShapeUtil::IsZeroElementArray(dest_shape)) {
+    const int64 minor_dimension = LayoutUtil::Minor(dest_shape.layout(), 0);
+    const int64 minor_dimension_size = dest_shape.dimensions(minor_dimension);
+    const auto source_minor_it = absl::c_find(dimensions, minor_dimension);
+    const bool repeated = source_minor_it == dimensions.end();
+    if (repeated || LayoutUtil::Minor(shape().layout(), 0) ==
+                        source_minor_it - dimensions.begin()) {
+      const int64 run_bytes = primitive_size * minor_dimension_size;
+      std::vector<int64> base(dest_shape.rank(), 0);
+      std::vector<int64> incr(dest_shape.rank(), 1);
+      incr[minor_dimension] = minor_dimension_size;
+      ShapeUtil::ForEachIndex(
+          dest_shape, base, AsInt64Slice(dest_shape.dimensions()), incr,
+          [&](absl::Span<const int64> output_index) {
+            for (int64 i = 0, end = dimensions.size(); i < end; ++i) {
+              scratch_source_index[i] = output_index[dimensions[i]];
+            }
+            char* dest = dest_data +
+                         primitive_size *
+                             IndexUtil::MultidimensionalIndexToLinearIndex(
+                                 dest_shape, output_index);
+            const char* source =
+                source_data + primitive_size *
+                                  IndexUtil::MultidimensionalIndexToLinearIndex(
+                                      shape(), scratch_source_index);
+            if (!repeated) {
+              memcpy(dest, source, run_bytes);
+              return true;
+            }
+            // Fills the run by doubling the filled prefix.
+            memcpy(dest, source, primitive_size);
+            for (int64 filled = primitive_size; filled < run_bytes;
+                 filled *= 2) {
+              memcpy(dest + filled, dest, std::min(filled, run_bytes - filled));
+            }
+            return true;
+          });
+      return std::move(result);
+    }
+  }
+
   ShapeUtil::ForEachIndex(
       result_shape, [&](absl::Span<const int64> output_index) {
         for (int64 i = 0, end = dimensions.size(); i < end; ++i) {
@@ -2078,6 +2078,35 @@ TEST_F(LiteralUtilTest, BroadcastScalarToMatrix) {
             LiteralUtil::CreateR2<int32>({{9, 9}, {9, 9}}));
 }
 
+TEST_F(LiteralUtilTest, BroadcastMatrixToRank3) {
+  Literal literal = LiteralUtil::CreateR2<int32>({{1, 2, 3}, {4, 5, 6}});
+  Literal expected = LiteralUtil::CreateR3<int32>(
+      {{{1, 2, 3}, {4, 5, 6}}, {{1, 2, 3}, {4, 5, 6}}});
+  TF_ASSERT_OK_AND_ASSIGN(
+      Literal broadcasted_literal,
+      literal.Broadcast(/*result_shape=*/ShapeUtil::MakeShape(S32, {2, 2, 3}),
+                        /*dimensions=*/{1, 2}));
+  EXPECT_EQ(broadcasted_literal, expected);
+
+  // The broadcast dimension is the most minor one of the result.
+  Shape result_shape =
+      ShapeUtil::MakeShapeWithLayout(S32, {2, 2, 3}, {0, 2, 1});
+  TF_ASSERT_OK_AND_ASSIGN(
+      broadcasted_literal,
+      literal.Broadcast(result_shape, /*dimensions=*/{1, 2}));
+  EXPECT_EQ(broadcasted_literal, expected.Relayout(result_shape));
+
+  // The most minor dimension of the result is not that of the operand.
+  TF_ASSERT_OK_AND_ASSIGN(
+      broadcasted_literal,
+      literal.Transpose({1, 0}).Broadcast(
+          /*result_shape=*/ShapeUtil::MakeShape(S32, {2, 3, 2}),
+          /*dimensions=*/{1, 2}));
+  EXPECT_EQ(broadcasted_literal,
+            LiteralUtil::CreateR3<int32>(
+                {{{1, 4}, {2, 5}, {3, 6}}, {{1, 4}, {2, 5}, {3, 6}}}));
+}
+
 TEST_F(LiteralUtilTest, DynamicBroadcast) {
   Literal literal = LiteralUtil::CreateR1<int64>({1, 2});
   literal.SetDynamicSize(0, 1);
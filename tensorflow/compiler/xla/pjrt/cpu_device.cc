@@ -28,7 +28,8 @@ CpuDevice::CpuDevice(int id,
     : Device(id, std::move(local_device_state), kCpuPlatformName,
              /*device_kind=*/kCpuPlatformName) {}
 
-StatusOr<std::shared_ptr<PjRtClient>> GetCpuClient(bool asynchronous) {
+StatusOr<std::shared_ptr<PjRtClient>> GetCpuClient(bool asynchronous,
+                                                   int num_compute_streams) {
   TF_ASSIGN_OR_RETURN(se::Platform * platform,
                       PlatformUtil::GetPlatform("Host"));
   if (platform->VisibleDeviceCount() <= 0) {
@@ -51,7 +52,7 @@ StatusOr<std::shared_ptr<PjRtClient>> GetCpuClient(bool asynchronous) {
                         platform->GetExecutor(config));
     auto device_state = absl::make_unique<LocalDeviceState>(
         executor, client, LocalDeviceState::kSynchronous, asynchronous,
-        /*allow_event_reuse=*/false);
+        /*allow_event_reuse=*/false, num_compute_streams);
     auto device = absl::make_unique<CpuDevice>(i, std::move(device_state));
     devices.push_back(std::move(device));
   }
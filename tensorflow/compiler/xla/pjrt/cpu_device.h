@@ -28,7 +28,10 @@ class CpuDevice : public Device {
   CpuDevice(int id, std::unique_ptr<LocalDeviceState> local_device_state);
 };
 
-StatusOr<std::shared_ptr<PjRtClient>> GetCpuClient(bool asynchronous);
+// Independent executions on a device are spread over `num_compute_streams`
+// host streams, so that they may run concurrently.
+StatusOr<std::shared_ptr<PjRtClient>> GetCpuClient(bool asynchronous,
+                                                   int num_compute_streams = 1);
 
 }  // namespace xla
 
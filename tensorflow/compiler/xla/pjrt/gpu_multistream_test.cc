@@ -102,5 +102,85 @@ TEST(GpuMultiStream, Basics) {
   }
 }
 
+// Returns true if `buffer` is defined by work enqueued on `stream`.
+bool DefinedOn(PjRtBuffer* buffer, se::Stream* stream) {
+  PjRtBuffer::ScopedHold hold = buffer->GetBufferWithUsageHold();
+  CHECK(hold.ok());
+  return hold->definition_events().at(0)->DefinedOn(stream);
+}
+
+// Verifies that two executables enqueued back to back run on different
+// streams, and that memory one of them frees is not reused by the other before
+// it finishes.
+TEST(GpuMultiStream, ConcurrentExecutions) {
+  TF_ASSERT_OK_AND_ASSIGN(
+      std::shared_ptr<PjRtClient> client,
+      GetNvidiaGpuClient(/*asynchronous=*/true, GpuAllocatorConfig(),
+                         /*distributed_client=*/nullptr, /*node_id=*/0,
+                         /*num_compute_streams=*/2));
+
+  Device* device = client->local_devices().at(0);
+  const std::vector<std::unique_ptr<se::Stream>>& streams =
+      device->local_device_state()->compute_streams();
+  ASSERT_EQ(streams.size(), 3);
+
+  int n = 1 << 20;
+  Shape shape = ShapeUtil::MakeShape(S32, {n});
+
+  XlaBuilder neg_builder("neg");
+  auto p0 = Parameter(&neg_builder, 0, shape, "param");
+  Neg(Add(p0, p0));
+  TF_ASSERT_OK_AND_ASSIGN(XlaComputation neg, neg_builder.Build());
+  XlaBuilder sub_builder("sub");
+  auto p1 = Parameter(&sub_builder, 0, shape, "param");
+  Sub(p1, Add(p1, p1));
+  TF_ASSERT_OK_AND_ASSIGN(XlaComputation sub, sub_builder.Build());
+
+  CompileOptions compile_options;
+  DeviceAssignment device_assignment(1, 1);
+  device_assignment(0, 0) = device->id();
+  compile_options.executable_build_options.set_device_assignment(
+      device_assignment);
+  TF_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<PjRtExecutable> neg_executable,
+      PjRtExecutable::Compile(neg, client.get(), compile_options));
+  TF_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<PjRtExecutable> sub_executable,
+      PjRtExecutable::Compile(sub, client.get(), compile_options));
+
+  std::vector<int32> inputs(n);
+  std::vector<int32> neg_outputs(n);
+  std::vector<int32> sub_outputs(n);
+  for (int i = 0; i < 20; ++i) {
+    for (int j = 0; j < n; ++j) {
+      inputs[j] = tensorflow::random::New64() % 1000;
+      neg_outputs[j] = -2 * inputs[j];
+      sub_outputs[j] = -inputs[j];
+    }
+    TF_ASSERT_OK_AND_ASSIGN(
+        auto in_buffer,
+        PjRtBuffer::FromHostBuffer(
+            inputs.data(), shape,
+            PjRtBuffer::HostBufferSemantics::kImmutableUntilTransferCompletes,
+            /*buffer_reference=*/nullptr, client.get(), device));
+    TF_ASSERT_OK_AND_ASSIGN(
+        auto neg_buffers,
+        neg_executable->Execute({in_buffer.get()}, ExecuteOptions()));
+    TF_ASSERT_OK_AND_ASSIGN(
+        auto sub_buffers,
+        sub_executable->Execute({in_buffer.get()}, ExecuteOptions()));
+
+    EXPECT_FALSE(DefinedOn(neg_buffers[0].get(), streams[0].get()));
+    EXPECT_FALSE(DefinedOn(sub_buffers[0].get(), streams[0].get()));
+    EXPECT_NE(DefinedOn(neg_buffers[0].get(), streams[1].get()),
+              DefinedOn(sub_buffers[0].get(), streams[1].get()));
+
+    TF_ASSERT_OK_AND_ASSIGN(auto out_literal, neg_buffers[0]->ToLiteral());
+    LiteralTestUtil::ExpectR1Equal<int32>(neg_outputs, *out_literal);
+    TF_ASSERT_OK_AND_ASSIGN(out_literal, sub_buffers[0]->ToLiteral());
+    LiteralTestUtil::ExpectR1Equal<int32>(sub_outputs, *out_literal);
+  }
+}
+
 }  // namespace
 }  // namespace xla
@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/compiler/xla/pjrt/local_device_state.h"
 
+#include <algorithm>
 #include <memory>
 #include <vector>
 
@@ -29,7 +30,8 @@ namespace xla {
 LocalDeviceState::LocalDeviceState(se::StreamExecutor* executor,
                                    LocalClient* client,
                                    AllocationModel allocation_model,
-                                   bool asynchronous, bool allow_event_reuse)
+                                   bool asynchronous, bool allow_event_reuse,
+                                   int num_compute_streams)
     : allocation_model_(allocation_model),
       event_pool_(allow_event_reuse),
       compute_semaphore_(/*capacity=*/asynchronous ? 32 : 1),
@@ -38,12 +40,28 @@ LocalDeviceState::LocalDeviceState(se::StreamExecutor* executor,
       prng_seed_generator_(prng_seed_device_()),
       prng_seed_distribution_(std::numeric_limits<int>::min(),
                               std::numeric_limits<int>::max()) {
-  compute_stream_ = absl::make_unique<se::Stream>(executor);
-  host_to_device_stream_ = absl::make_unique<se::Stream>(executor);
+  num_compute_streams = std::max(num_compute_streams, 1);
+  if (allocation_model == kComputeSynchronized && num_compute_streams > 1) {
+    // Keep the compute stream free of executions, so that an execution on
+    // another stream only waits for the work that orders frees, not for the
+    // executions running on the other streams.
+    first_execution_stream_ = 1;
+    ++num_compute_streams;
+  }
+  compute_streams_.reserve(num_compute_streams);
+  for (int i = 0; i < num_compute_streams; ++i) {
+    auto stream = absl::make_unique<se::Stream>(executor);
+    stream->Init();
+    compute_streams_.push_back(std::move(stream));
+  }
   callback_stream_ = absl::make_unique<se::Stream>(executor);
-  compute_stream_->Init();
-  host_to_device_stream_->Init();
   callback_stream_->Init();
+  host_to_device_streams_.reserve(kNumHostToDeviceStreams);
+  for (int i = 0; i < kNumHostToDeviceStreams; ++i) {
+    auto stream = absl::make_unique<se::Stream>(executor);
+    stream->Init();
+    host_to_device_streams_.push_back(std::move(stream));
+  }
   device_to_host_streams_.reserve(kNumDeviceToHostStreams);
   for (int i = 0; i < kNumDeviceToHostStreams; ++i) {
     auto stream = absl::make_unique<se::Stream>(executor);
@@ -76,9 +94,11 @@ Status LocalDeviceState::SynchronizeAllActivity() {
   // implementation that doesn't actually block. To make sure activity has
   // stopped, also block on the compute stream. If SynchronizeAllActivity is
   // fixed, we could remove the BlockHostUntilDone call.
-  status.Update(compute_stream_->BlockHostUntilDone());
+  for (const auto& stream : compute_streams_) {
+    status.Update(stream->BlockHostUntilDone());
+  }
   status.Update(callback_stream_->BlockHostUntilDone());
-  bool ok = compute_stream_->parent()->SynchronizeAllActivity();
+  bool ok = compute_stream()->parent()->SynchronizeAllActivity();
   if (!ok) {
     status.Update(Unknown("SynchronizeAllActivity failed."));
   }
@@ -102,6 +122,22 @@ void LocalDeviceState::ThenExecuteOnCallbackThread(
   });
 }
 
+se::Stream* LocalDeviceState::GetExecutionStream() {
+  absl::MutexLock lock(&mu_);
+  int i = next_compute_stream_;
+  next_compute_stream_ = (next_compute_stream_ + 1) %
+                         (compute_streams_.size() - first_execution_stream_);
+  return compute_streams_.at(first_execution_stream_ + i).get();
+}
+
+se::Stream* LocalDeviceState::GetHostToDeviceStream() {
+  absl::MutexLock lock(&mu_);
+  int i = next_host_to_device_stream_;
+  next_host_to_device_stream_ =
+      (next_host_to_device_stream_ + 1) % host_to_device_streams_.size();
+  return host_to_device_streams_.at(i).get();
+}
+
 se::Stream* LocalDeviceState::GetDeviceToHostStream() {
   absl::MutexLock lock(&mu_);
   int i = next_device_to_host_stream_;
@@ -121,7 +157,7 @@ se::Stream* LocalDeviceState::GetDeviceToDeviceStream() {
 std::unique_ptr<se::Stream> LocalDeviceState::BorrowStreamFromPool() {
   absl::MutexLock lock(&mu_);
   if (usage_stream_pool_.empty()) {
-    auto stream = absl::make_unique<se::Stream>(compute_stream_->parent());
+    auto stream = absl::make_unique<se::Stream>(compute_stream()->parent());
     stream->Init();
     return stream;
   } else {
@@ -149,4 +185,22 @@ int LocalDeviceState::GetNewPrngSeed() {
   return x;
 }
 
+void LocalDeviceState::RecordHostToDeviceTransfer(int64 bytes,
+                                                  absl::Duration latency) {
+  VLOG(3) << "Host to device transfer of " << bytes << " bytes to device "
+          << device_ordinal() << " took " << latency << " ("
+          << bytes / std::max(absl::ToDoubleSeconds(latency), 1e-9) / 1e6
+          << " MB/s)";
+  absl::MutexLock lock(&mu_);
+  ++host_to_device_transfer_stats_.num_transfers;
+  host_to_device_transfer_stats_.bytes_transferred += bytes;
+  host_to_device_transfer_stats_.total_latency += latency;
+}
+
+LocalDeviceState::TransferStats
+LocalDeviceState::host_to_device_transfer_stats() {
+  absl::MutexLock lock(&mu_);
+  return host_to_device_transfer_stats_;
+}
+
 }  // namespace xla
@@ -21,6 +21,7 @@ limitations under the License.
 #include <vector>
 
 #include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
 #include "tensorflow/compiler/xla/client/local_client.h"
 #include "tensorflow/compiler/xla/pjrt/event_pool.h"
 #include "tensorflow/compiler/xla/pjrt/semaphore.h"
@@ -88,9 +89,15 @@ class LocalDeviceState {
 
   // If asynchronous is false, the host will synchronize to the device after
   // each execution or transfer. This is intended for debugging only.
+  //
+  // Executions are spread over `num_compute_streams` streams, so that
+  // independent executions may run concurrently. The kComputeSynchronized
+  // allocation model orders frees behind the compute stream, so when
+  // `num_compute_streams` > 1 it runs executions on that many streams in
+  // addition to the compute stream; see GetExecutionStream().
   LocalDeviceState(se::StreamExecutor* executor, LocalClient* client,
                    AllocationModel allocation_model, bool asynchronous,
-                   bool allow_event_reuse);
+                   bool allow_event_reuse, int num_compute_streams = 1);
   virtual ~LocalDeviceState();
 
   se::StreamExecutor* executor() const { return executor_; }
@@ -103,11 +110,31 @@ class LocalDeviceState {
 
   EventPool& event_pool() { return event_pool_; }
 
-  se::Stream* compute_stream() const { return compute_stream_.get(); }
+  se::Stream* compute_stream() const { return compute_streams_.front().get(); }
+
+  // Returns a stream to enqueue an execution on. Allocates streams in a
+  // round-robin fashion amongst the compute streams; the first of them is
+  // compute_stream(). Dependencies between executions on different streams
+  // are tracked by the events of the buffers they use.
+  //
+  // In the kComputeSynchronized model with several streams, executions never
+  // run on compute_stream() itself. An execution on another stream must wait
+  // for compute_stream() before it starts, and must defer the frees it would
+  // make until it completes; PjRtExecutable takes care of both.
+  se::Stream* GetExecutionStream();
+
+  const std::vector<std::unique_ptr<se::Stream>>& compute_streams() const {
+    return compute_streams_;
+  }
   se::Stream* host_to_device_stream() const {
-    return host_to_device_stream_.get();
+    return host_to_device_streams_.front().get();
   }
 
+  // Returns a host to device stream. Allocates streams in a round-robin
+  // fashion amongst the available streams, so that independent transfers can
+  // overlap.
+  se::Stream* GetHostToDeviceStream();
+
   // Returns a device to host stream. Allocates streams in a round-robin fashion
   // amongst the available streams.
   se::Stream* GetDeviceToHostStream();
@@ -159,6 +186,19 @@ class LocalDeviceState {
   // Returns a fresh, PRNG-generated random seed for an XLA computation.
   int GetNewPrngSeed();
 
+  struct TransferStats {
+    int64 num_transfers = 0;
+    int64 bytes_transferred = 0;
+    // The sum over the transfers of the time from enqueueing a transfer to
+    // the host observing its completion.
+    absl::Duration total_latency;
+  };
+
+  // Records a host to device transfer of `bytes` which took `latency`.
+  void RecordHostToDeviceTransfer(int64 bytes, absl::Duration latency);
+
+  TransferStats host_to_device_transfer_stats();
+
  private:
   Status SynchronizeAllActivity();
 
@@ -172,16 +212,21 @@ class LocalDeviceState {
 
   se::StreamExecutor* const executor_;
   LocalClient* const client_;
-  std::unique_ptr<se::Stream> compute_stream_;
-  std::unique_ptr<se::Stream> host_to_device_stream_;
+  std::vector<std::unique_ptr<se::Stream>> compute_streams_;
+  std::vector<std::unique_ptr<se::Stream>> host_to_device_streams_;
   std::vector<std::unique_ptr<se::Stream>> device_to_host_streams_;
   std::vector<std::unique_ptr<se::Stream>> device_to_device_streams_;
 
-  // Number of device-to-host and device-to-device streams.
+  // Number of host-to-device, device-to-host and device-to-device streams.
+  static constexpr int kNumHostToDeviceStreams = 4;
   static constexpr int kNumDeviceToHostStreams = 4;
   static constexpr int kNumDeviceToDeviceStreams = 4;
 
   absl::Mutex mu_;
+  // Index of the first compute stream that GetExecutionStream() hands out.
+  int first_execution_stream_ = 0;
+  int next_compute_stream_ TF_GUARDED_BY(mu_) = 0;
+  int next_host_to_device_stream_ TF_GUARDED_BY(mu_) = 0;
   int next_device_to_host_stream_ TF_GUARDED_BY(mu_) = 0;
   int next_device_to_device_stream_ TF_GUARDED_BY(mu_) = 0;
   std::stack<std::unique_ptr<se::Stream>> usage_stream_pool_ TF_GUARDED_BY(mu_);
@@ -190,6 +235,8 @@ class LocalDeviceState {
   std::mt19937 prng_seed_generator_ TF_GUARDED_BY(mu_);
   std::uniform_int_distribution<> prng_seed_distribution_ TF_GUARDED_BY(mu_);
 
+  TransferStats host_to_device_transfer_stats_ TF_GUARDED_BY(mu_);
+
   // Callback stream is used for running short host-side callbacks after device
   // side events, without preventing the device-side stream from doing useful
   // work.
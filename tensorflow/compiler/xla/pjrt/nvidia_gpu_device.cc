@@ -69,7 +69,7 @@ StatusOr<LocalClient*> GetGpuXlaClient() {
 
 // Builds a LocalDeviceState for each GPU present.
 StatusOr<std::vector<std::unique_ptr<LocalDeviceState>>> BuildLocalDeviceStates(
-    LocalClient* xla_client, bool asynchronous) {
+    LocalClient* xla_client, bool asynchronous, int num_compute_streams) {
   std::vector<std::unique_ptr<LocalDeviceState>> local_devices;
   for (int i = 0; i < xla_client->device_count(); ++i) {
     se::StreamExecutor* executor =
@@ -77,7 +77,7 @@ StatusOr<std::vector<std::unique_ptr<LocalDeviceState>>> BuildLocalDeviceStates(
     local_devices.push_back(absl::make_unique<LocalDeviceState>(
         executor, xla_client, LocalDeviceState::kComputeSynchronized,
         asynchronous,
-        /*allow_event_reuse=*/true));
+        /*allow_event_reuse=*/true, num_compute_streams));
   }
   return std::move(local_devices);
 }
@@ -291,11 +291,12 @@ GpuDevice::GpuDevice(int id,
 
 StatusOr<std::shared_ptr<PjRtClient>> GetNvidiaGpuClient(
     bool asynchronous, const GpuAllocatorConfig& allocator_config,
-    std::shared_ptr<DistributedRuntimeClient> distributed_client, int node_id) {
+    std::shared_ptr<DistributedRuntimeClient> distributed_client, int node_id,
+    int num_compute_streams) {
   TF_ASSIGN_OR_RETURN(LocalClient * xla_client, GetGpuXlaClient());
   TF_ASSIGN_OR_RETURN(
       std::vector<std::unique_ptr<LocalDeviceState>> local_device_states,
-      BuildLocalDeviceStates(xla_client, asynchronous));
+      BuildLocalDeviceStates(xla_client, asynchronous, num_compute_streams));
   TF_ASSIGN_OR_RETURN(
       auto allocator,
       GetGpuDeviceAllocator(allocator_config, local_device_states));
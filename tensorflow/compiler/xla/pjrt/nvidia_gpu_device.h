@@ -53,9 +53,12 @@ struct GpuAllocatorConfig {
 
 // distributed_client may be nullptr in non-distributed settings.
 // distributed_client should not be Open()ed before calling this function.
+// Independent executions on a device are spread over `num_compute_streams`
+// streams, so that they may run concurrently.
 StatusOr<std::shared_ptr<PjRtClient>> GetNvidiaGpuClient(
     bool asynchronous, const GpuAllocatorConfig& allocator_config,
-    std::shared_ptr<DistributedRuntimeClient> distributed_client, int node_id);
+    std::shared_ptr<DistributedRuntimeClient> distributed_client, int node_id,
+    int num_compute_streams = 1);
 
 }  // namespace xla
 
@@ -173,6 +173,54 @@ class CpuAllocator : public tensorflow::Allocator {
   }
 };
 
+// Allocator for executions that run on a stream other than the compute stream
+// in the kComputeSynchronized allocation model. That model lets memory be
+// reused as soon as it is freed on the host, relying on the compute stream to
+// order the reuse after the last use. Work on another stream is not ordered
+// that way, so frees made through this allocator are deferred until the work
+// already enqueued on `stream` has completed.
+class StreamOrderedDeallocator : public se::DeviceMemoryAllocator {
+ public:
+  StreamOrderedDeallocator(se::DeviceMemoryAllocator* wrapped,
+                           LocalDeviceState* local_device, se::Stream* stream)
+      : se::DeviceMemoryAllocator(wrapped->platform()),
+        wrapped_(wrapped),
+        local_device_(local_device),
+        stream_(stream) {}
+
+  StatusOr<se::OwningDeviceMemory> Allocate(int device_ordinal, uint64 size,
+                                            bool retry_on_failure,
+                                            int64 memory_space) override {
+    TF_ASSIGN_OR_RETURN(se::OwningDeviceMemory memory,
+                        wrapped_->Allocate(device_ordinal, size,
+                                           retry_on_failure, memory_space));
+    // Rewrap the memory so that it is returned through Deallocate() below.
+    return se::OwningDeviceMemory(memory.Release(), device_ordinal, this);
+  }
+
+  Status Deallocate(int device_ordinal, se::DeviceMemoryBase mem) override {
+    if (mem.is_null()) {
+      return Status::OK();
+    }
+    local_device_->ThenExecuteOnCallbackThread(
+        stream_, [wrapped{wrapped_}, device_ordinal, mem]() {
+          TF_CHECK_OK(wrapped->Deallocate(device_ordinal, mem));
+        });
+    return Status::OK();
+  }
+
+  bool AllowsAsynchronousDeallocation() const override { return true; }
+
+  StatusOr<se::Stream*> GetStream(int device_ordinal) override {
+    return stream_;
+  }
+
+ private:
+  se::DeviceMemoryAllocator* const wrapped_;
+  LocalDeviceState* const local_device_;
+  se::Stream* const stream_;
+};
+
 PjRtClient::PjRtClient(
     std::string platform_name, LocalClient* client,
     std::vector<std::unique_ptr<Device>> devices, int host_id,
@@ -217,9 +265,27 @@ PjRtClient::PjRtClient(
   }
   for (int idx = 0; idx < local_devices_.size(); ++idx) {
     CHECK(local_devices_[idx] != nullptr) << idx;
+    LocalDeviceState* local_device = local_devices_[idx]->local_device_state();
+    if (local_device->allocation_model() !=
+        LocalDeviceState::kComputeSynchronized) {
+      continue;
+    }
+    for (const auto& stream : local_device->compute_streams()) {
+      if (stream.get() != local_device->compute_stream()) {
+        execution_allocators_[stream.get()] =
+            absl::make_unique<StreamOrderedDeallocator>(
+                allocator_, local_device, stream.get());
+      }
+    }
   }
 }
 
+se::DeviceMemoryAllocator* PjRtClient::execution_allocator(
+    se::Stream* stream) const {
+  auto it = execution_allocators_.find(stream);
+  return it == execution_allocators_.end() ? allocator_ : it->second.get();
+}
+
 StatusOr<DeviceAssignment> PjRtClient::GetDefaultDeviceAssignment(
     int num_replicas, int num_partitions) const {
   return client_->backend().computation_placer()->AssignDevices(num_replicas,
@@ -640,10 +706,12 @@ StatusOr<std::unique_ptr<PjRtBuffer>> PjRtBuffer::FromHostBuffer(
     }
   }
 
+  // Independent transfers are spread over the host to device streams so that
+  // they overlap with each other.
+  se::Stream* h2d_stream = local_device->GetHostToDeviceStream();
   TF_ASSIGN_OR_RETURN(
       std::unique_ptr<PjRtBuffer> py_buffer,
-      AllocateDestinationBuffer(compact_shape, device, local_device,
-                                local_device->host_to_device_stream(),
+      AllocateDestinationBuffer(compact_shape, device, local_device, h2d_stream,
                                 /*is_uninitialized_create=*/false, client));
 
   ScopedHold device_buffer(py_buffer->GetBufferWithUsageHold());
@@ -677,8 +745,9 @@ StatusOr<std::unique_ptr<PjRtBuffer>> PjRtBuffer::FromHostBuffer(
   // usage holds have gone away.
   // TODO(misard) assess if it would be preferable to introduce a heuristic to
   // put the transfer into the calling thread for small literals.
-  auto transfer_h2d = [client, transfer_manager, local_device, data, size,
-                       movable_device_buffer{device_buffer.ToClosure()}, shape,
+  auto transfer_h2d = [client, transfer_manager, local_device, h2d_stream, data,
+                       size, movable_device_buffer{device_buffer.ToClosure()},
+                       shape,
                        py_buffer{py_buffer.get()}, compact_shape,
                        on_device_shape{py_buffer->on_device_shape()},
                        staging_buffer{std::move(staging_buffer)},
@@ -691,6 +760,7 @@ StatusOr<std::unique_ptr<PjRtBuffer>> PjRtBuffer::FromHostBuffer(
     // memory that has already been allocated, and a possible Event
     // allocation.
 
+    absl::Time start_time = absl::Now();
     ShapedBuffer buffer = device_buffer->AsShapedBuffer(
         compact_shape, on_device_shape, client->client()->platform());
     // If applicable on the backend, stage the transfer via host memory
@@ -706,23 +776,28 @@ StatusOr<std::unique_ptr<PjRtBuffer>> PjRtBuffer::FromHostBuffer(
       BorrowingLiteral literal(static_cast<const char*>(staging_buffer.get()),
                                shape);
       TF_CHECK_OK(transfer_manager->TransferLiteralToDeviceAsync(
-          local_device->host_to_device_stream(), literal, buffer));
+          h2d_stream, literal, buffer));
     } else {
       BorrowingLiteral literal(static_cast<const char*>(data), shape);
       // Otherwise, just transfer the literal.
       TF_CHECK_OK(transfer_manager->TransferLiteralToDeviceAsync(
-          local_device->host_to_device_stream(), literal, buffer));
+          h2d_stream, literal, buffer));
     }
 
     std::shared_ptr<BufferSequencingEvent> event =
         device_buffer->definition_events()[0];
     TF_CHECK_OK(AddDestinationBufferSynchronization(
-        local_device, std::move(device_buffer), event,
-        local_device->host_to_device_stream()));
+        local_device, std::move(device_buffer), event, h2d_stream));
 
-    local_device->ThenRelease(
-        local_device->host_to_device_stream(),
-        std::make_pair(std::move(buffer_reference), std::move(staging_buffer)));
+    // Releases the host buffers, and records the transfer, once the stream
+    // has reached the end of the transfer.
+    local_device->ThenExecuteOnCallbackThread(
+        h2d_stream, [local_device, size, start_time,
+                     buffer_reference{std::move(buffer_reference)},
+                     staging_buffer{std::move(staging_buffer)}]() {
+          local_device->RecordHostToDeviceTransfer(size,
+                                                   absl::Now() - start_time);
+        });
   };
   if (is_cpu_platform) {
     // Using the h2d_transfer_pool would be a double thread hop; the code
@@ -767,10 +842,10 @@ StatusOr<std::unique_ptr<PjRtBuffer>> PjRtBuffer::FromHostLiteral(
   TF_ASSIGN_OR_RETURN(
       Shape compact_shape,
       transfer_manager->ChooseCompactLayoutForShape(literal.shape()));
+  se::Stream* h2d_stream = local_device->GetHostToDeviceStream();
   TF_ASSIGN_OR_RETURN(
       std::unique_ptr<PjRtBuffer> py_buffer,
-      AllocateDestinationBuffer(compact_shape, device, local_device,
-                                local_device->host_to_device_stream(),
+      AllocateDestinationBuffer(compact_shape, device, local_device, h2d_stream,
                                 /*is_uninitialized_create=*/false, client));
 
   ScopedHold device_buffer(py_buffer->GetBufferWithUsageHold());
@@ -782,7 +857,7 @@ StatusOr<std::unique_ptr<PjRtBuffer>> PjRtBuffer::FromHostLiteral(
   // usage holds have gone away.
   // TODO(misard) assess if it would be preferable to introduce a heuristic to
   // put the transfer into the calling thread for small literals.
-  auto transfer_h2d = [client, transfer_manager, local_device,
+  auto transfer_h2d = [client, transfer_manager, local_device, h2d_stream,
                        movable_device_buffer{device_buffer.ToClosure()},
                        literal, py_buffer{py_buffer.get()}, compact_shape,
                        on_device_shape{py_buffer->on_device_shape()}]() {
@@ -793,7 +868,6 @@ StatusOr<std::unique_ptr<PjRtBuffer>> PjRtBuffer::FromHostLiteral(
     // memory that has already been allocated, and a possible Event
     // allocation.
 
-    se::Stream* h2d_stream = local_device->host_to_device_stream();
     ShapedBuffer buffer = device_buffer->AsShapedBuffer(
         compact_shape, on_device_shape, client->client()->platform());
     TF_CHECK_OK(transfer_manager->TransferLiteralToDeviceAsync(
@@ -1418,12 +1492,12 @@ StatusOr<TupleHandle> MakeTupleHelper(
                       std::move(transfer_event)});
 }
 
-// Converts a ScopedShapedBuffer returned from an execution into a
-// PjRtBuffer.
+// Converts a ScopedShapedBuffer returned from an execution enqueued on `stream`
+// into a PjRtBuffer.
 std::unique_ptr<PjRtBuffer> OutputBufferHelper(
     ScopedShapedBuffer* result_buffer,
     std::shared_ptr<BufferSequencingEvent> definition_event, PjRtClient* client,
-    Device* device, LocalDeviceState* local_device) {
+    Device* device, LocalDeviceState* local_device, se::Stream* stream) {
   std::shared_ptr<TrackedDeviceBuffer> out_buffer =
       TrackedDeviceBuffer::FromScopedShapedBuffer(result_buffer,
                                                   {definition_event});
@@ -1431,11 +1505,21 @@ std::unique_ptr<PjRtBuffer> OutputBufferHelper(
       result_buffer->on_host_shape(), result_buffer->on_device_shape(),
       std::move(out_buffer), client, device);
   RecordUsage(py_buffer->GetBufferWithUsageHold(), local_device, local_device,
-              definition_event, local_device->compute_stream(),
+              definition_event, stream,
               /*prefer_to_retain_reference=*/false);
   return py_buffer;
 }
 
+// Returns true if memory an execution on `stream` releases must be kept until
+// the execution completes, rather than freed once the execution is enqueued.
+bool MustDeferFrees(const LocalDeviceState* local_device,
+                    const se::Stream* stream) {
+  return local_device->allocation_model() == LocalDeviceState::kSynchronous ||
+         (local_device->allocation_model() ==
+              LocalDeviceState::kComputeSynchronized &&
+          stream != local_device->compute_stream());
+}
+
 static Device* LookupDevice(const PjRtClient& client, int device_id) {
   auto it = client.id_to_device().find(device_id);
   CHECK(it != client.id_to_device().end())
@@ -1508,13 +1592,14 @@ const std::string& PjRtExecutable::name() const {
   }
 }
 
-// Enqueues a computation onto the compute stream. Each buffer returned in
-// device_buffers has a usage hold added that must be dropped on error or
-// converted on success.
+// Enqueues a computation onto `stream`, one of the compute streams of the
+// device. Each buffer returned in device_buffers has a usage hold added that
+// must be dropped on error or converted on success.
 StatusOr<ScopedShapedBuffer> PjRtExecutable::EnqueueExecution(
     absl::Span<PjRtBuffer* const> argument_handles, int replica, int partition,
     int executable_idx, const RunId& run_id, const ExecuteOptions& options,
-    Device* device, std::vector<PjRtBuffer::ScopedHold>* device_buffers,
+    Device* device, se::Stream* stream,
+    std::vector<PjRtBuffer::ScopedHold>* device_buffers,
     std::shared_ptr<DeviceAssignment> device_assignment) const {
   int device_ordinal = device->local_device_state()->device_ordinal();
   tensorflow::profiler::TraceMeConsumer activity(
@@ -1600,13 +1685,20 @@ StatusOr<ScopedShapedBuffer> PjRtExecutable::EnqueueExecution(
   }
 
   for (BufferSequencingEvent* event : events) {
-    event->WaitForEventOnStream(device_state->compute_stream());
+    event->WaitForEventOnStream(stream);
+  }
+  if (device_state->allocation_model() ==
+          LocalDeviceState::kComputeSynchronized &&
+      stream != device_state->compute_stream()) {
+    // Memory freed on the host may still be in use by work enqueued on the
+    // compute stream, so wait for that work before reusing any of it.
+    stream->ThenWaitFor(device_state->compute_stream());
   }
 
   ExecutableRunOptions run_options;
-  run_options.set_stream(device_state->compute_stream());
+  run_options.set_stream(stream);
   run_options.set_host_to_device_stream(device_state->host_to_device_stream());
-  run_options.set_allocator(client_->allocator());
+  run_options.set_allocator(client_->execution_allocator(stream));
   run_options.set_intra_op_thread_pool(
       client_->client()->backend().eigen_intra_op_thread_pool_device());
   run_options.set_device_assignment(device_assignment.get());
@@ -1637,7 +1729,7 @@ StatusOr<ScopedShapedBuffer> PjRtExecutable::EnqueueExecution(
     return result_buffer_or_status.status();
   }
 
-  if (device_state->allocation_model() == LocalDeviceState::kSynchronous) {
+  if (MustDeferFrees(device_state, stream)) {
     ExecutionOutput& execution_output = result_buffer_or_status.ValueOrDie();
     // If we used a transient tuple for the arguments we donated its root table
     // buffer. In that case, and/or if we donated any input buffers that were
@@ -1655,7 +1747,7 @@ StatusOr<ScopedShapedBuffer> PjRtExecutable::EnqueueExecution(
       donated_ptrs.push_back(owning.Release());
     }
     device_state->ThenExecuteOnCallbackThread(
-        device_state->compute_stream(),
+        stream,
         [references{std::make_tuple(executables_[executable_idx],
                                     compute_reservation, device_assignment)},
          donated_ptrs{std::move(donated_ptrs)}, allocator{client_->allocator()},
@@ -1668,9 +1760,8 @@ StatusOr<ScopedShapedBuffer> PjRtExecutable::EnqueueExecution(
     // Any donated memory returned by the ExecutionOutput can be immediately
     // freed.
     device_state->ThenRelease(
-        device_state->compute_stream(),
-        std::make_tuple(executables_[executable_idx], compute_reservation,
-                        device_assignment));
+        stream, std::make_tuple(executables_[executable_idx],
+                                compute_reservation, device_assignment));
   }
 
   return result_buffer_or_status.ConsumeValueOrDie().ConsumeResult();
@@ -1705,11 +1796,13 @@ PjRtExecutable::ExecuteHelper(absl::Span<PjRtBuffer* const> argument_handles,
   // SPMD sharding produces a single executable for multiple partitions.
   int executable_idx = executables_.size() > 1 ? partition : 0;
 
+  LocalDeviceState* device_state = &client_->device_state(device_ordinal);
+  se::Stream* stream = device_state->GetExecutionStream();
   std::vector<PjRtBuffer::ScopedHold> device_buffers;
   device_buffers.reserve(argument_handles.size());
   StatusOr<ScopedShapedBuffer> result_buffer_or_status = EnqueueExecution(
       argument_handles, replica, partition, executable_idx, run_id, options,
-      device, &device_buffers, std::move(device_assignment));
+      device, stream, &device_buffers, std::move(device_assignment));
 
   if (!result_buffer_or_status.ok()) {
     LOG(ERROR) << "Execution of replica " << replica
@@ -1719,8 +1812,6 @@ PjRtExecutable::ExecuteHelper(absl::Span<PjRtBuffer* const> argument_handles,
   ScopedShapedBuffer result_buffer =
       result_buffer_or_status.ConsumeValueOrDie();
 
-  LocalDeviceState* device_state = &client_->device_state(device_ordinal);
-  se::Stream* stream = device_state->compute_stream();
   StatusOr<EventPool::Handle> event_or =
       device_state->event_pool().ThenAllocateAndRecordEvent(stream);
   if (!event_or.ok()) {
@@ -1746,32 +1837,35 @@ PjRtExecutable::ExecuteHelper(absl::Span<PjRtBuffer* const> argument_handles,
     for (int i = 0; i < tuple_count; ++i) {
       ScopedShapedBuffer tuple_buffer = result_buffer.TakeSubTree({i});
       outputs.push_back(OutputBufferHelper(&tuple_buffer, definition_event,
-                                           client_, device, device_state));
+                                           client_, device, device_state,
+                                           stream));
     }
-    if (device_state->allocation_model() == LocalDeviceState::kSynchronous) {
+    if (MustDeferFrees(device_state, stream)) {
       // Don't release the root buffer until after execution completes.
       ShapedBuffer root_buffer_holder = result_buffer.release();
       se::DeviceMemoryBase root_buffer = root_buffer_holder.root_buffer();
       device_state->ThenExecuteOnCallbackThread(
-          device_state->compute_stream(),
+          stream,
           [root_buffer, allocator{client_->allocator()}, device_ordinal]() {
             TF_CHECK_OK(allocator->Deallocate(device_ordinal, root_buffer));
           });
     }
   } else {
     outputs.push_back(OutputBufferHelper(&result_buffer, definition_event,
-                                         client_, device, device_state));
+                                         client_, device, device_state,
+                                         stream));
   }
 
   for (PjRtBuffer::ScopedHold& b : device_buffers) {
-    // prefer_to_retain_reference=false because when using the
-    // ComputeSynchronized allocation model we don't need to retain a reference
-    // to the device_buffer during execution because by definition the compute
-    // stream is synchronized past the execution.
+    // When using the ComputeSynchronized allocation model we don't need to
+    // retain a reference to the device_buffer during an execution on the
+    // compute stream because by definition the compute stream is synchronized
+    // past the execution. Executions on other streams are not.
     if (b.type() == PjRtBuffer::ScopedHold::kUsage) {
       RecordUsage(std::move(b), device_state, device_state, definition_event,
                   stream,
-                  /*prefer_to_retain_reference=*/false);
+                  /*prefer_to_retain_reference=*/stream !=
+                      device_state->compute_stream());
     } else {
       CHECK(b.type() == PjRtBuffer::ScopedHold::kDonation);
       b.ConfirmDonation();
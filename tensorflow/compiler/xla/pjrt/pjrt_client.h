@@ -156,6 +156,10 @@ class PjRtClient {
 
   LocalClient* client() const { return client_; }
   se::DeviceMemoryAllocator* allocator() const { return allocator_; }
+  // Returns the allocator for an execution enqueued on `stream`. This is
+  // allocator(), unless `stream` needs its frees deferred; see
+  // LocalDeviceState::GetExecutionStream().
+  se::DeviceMemoryAllocator* execution_allocator(se::Stream* stream) const;
   tensorflow::Allocator* host_memory_allocator() const {
     return host_memory_allocator_.get();
   }
@@ -219,6 +223,10 @@ class PjRtClient {
 
   se::DeviceMemoryAllocator* allocator_;
   std::unique_ptr<se::DeviceMemoryAllocator> owned_allocator_;
+  // Allocators for the execution streams that defer their frees, keyed by
+  // stream.
+  absl::flat_hash_map<se::Stream*, std::unique_ptr<se::DeviceMemoryAllocator>>
+      execution_allocators_;
 
   // Should we always prefer to stage host-to-device transfers via memory
   // allocated on host_memory_allocator_? True only on GPU, where we prefer to
@@ -764,7 +772,7 @@ class PjRtExecutable {
   StatusOr<ScopedShapedBuffer> EnqueueExecution(
       absl::Span<PjRtBuffer* const> argument_handles, int replica,
       int partition, int executable_idx, const RunId& run_id,
-      const ExecuteOptions& options, Device* device,
+      const ExecuteOptions& options, Device* device, se::Stream* stream,
       std::vector<PjRtBuffer::ScopedHold>* device_buffers,
       std::shared_ptr<DeviceAssignment> device_assignment) const;
 
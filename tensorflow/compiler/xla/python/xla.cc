@@ -550,12 +550,13 @@ PYBIND11_MODULE(xla_extension, m) {
 
   m.def(
       "get_cpu_client",
-      [](bool asynchronous) -> StatusOr<std::shared_ptr<PyClient>> {
+      [](bool asynchronous,
+         int num_compute_streams) -> StatusOr<std::shared_ptr<PyClient>> {
         TF_ASSIGN_OR_RETURN(std::shared_ptr<PjRtClient> client,
-                            GetCpuClient(asynchronous));
+                            GetCpuClient(asynchronous, num_compute_streams));
         return std::make_shared<PyClient>(std::move(client));
       },
-      py::arg("asynchronous") = true);
+      py::arg("asynchronous") = true, py::arg("num_compute_streams") = 1);
   m.def("get_interpreter_client", []() -> StatusOr<std::shared_ptr<PyClient>> {
     TF_ASSIGN_OR_RETURN(std::shared_ptr<PjRtClient> client,
                         GetInterpreterClient());
@@ -565,16 +566,19 @@ PYBIND11_MODULE(xla_extension, m) {
       "get_nvidia_gpu_client",
       [](bool asynchronous, const GpuAllocatorConfig& allocator_config,
          std::shared_ptr<DistributedRuntimeClient> distributed_client,
-         int node_id) -> StatusOr<std::shared_ptr<PyClient>> {
+         int node_id,
+         int num_compute_streams) -> StatusOr<std::shared_ptr<PyClient>> {
         TF_ASSIGN_OR_RETURN(
             std::shared_ptr<PjRtClient> client,
             GetNvidiaGpuClient(asynchronous, allocator_config,
-                               std::move(distributed_client), node_id));
+                               std::move(distributed_client), node_id,
+                               num_compute_streams));
         return std::make_shared<PyClient>(std::move(client));
       },
       py::arg("asynchronous") = true,
       py::arg("allocator_config") = GpuAllocatorConfig(),
-      py::arg("distributed_client") = nullptr, py::arg("node_id") = 0);
+      py::arg("distributed_client") = nullptr, py::arg("node_id") = 0,
+      py::arg("num_compute_streams") = 1);
 
   py::class_<Traceback::Frame>(m, "Frame")
       .def_readonly("file_name", &Traceback::Frame::file_name)
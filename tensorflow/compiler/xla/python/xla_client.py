@@ -59,8 +59,14 @@ def _interpreter_backend_factory():
   return _xla.get_interpreter_client()
 
 
+def _num_compute_streams():
+  """Returns the number of compute streams requested for a local backend."""
+  return int(os.getenv('XLA_PYTHON_CLIENT_COMPUTE_STREAMS', '1'))
+
+
 def _cpu_backend_factory():
-  return _xla.get_cpu_client(asynchronous=True)
+  return _xla.get_cpu_client(
+      asynchronous=True, num_compute_streams=_num_compute_streams())
 
 
 def _gpu_backend_factory(distributed_client=None, node_id=0):
@@ -87,7 +93,8 @@ def _gpu_backend_factory(distributed_client=None, node_id=0):
       asynchronous=True,
       allocator_config=config,
       distributed_client=distributed_client,
-      node_id=node_id)
+      node_id=node_id,
+      num_compute_streams=_num_compute_streams())
 
 
 # Backend factories, keyed by user-visible name, in increasing priority order.
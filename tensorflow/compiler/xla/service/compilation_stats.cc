@@ -22,6 +22,7 @@ limitations under the License.
 #include "absl/container/flat_hash_map.h"
 #include "absl/memory/memory.h"
 #include "absl/strings/str_format.h"
+#include "absl/types/optional.h"
 #include "tensorflow/compiler/xla/types.h"
 #include "tensorflow/core/platform/env.h"
 
@@ -35,6 +36,8 @@ class NoopStats : public CompilationStats {
 
   void EndPass(absl::string_view pass_name) override {}
 
+  void RecordPassWork(absl::string_view pass_name, double work_ms) override {}
+
   void CompilationReport() override {}
 };
 
@@ -46,16 +49,19 @@ class Stats : public CompilationStats {
 
   void EndPass(absl::string_view pass_name) override;
 
+  void RecordPassWork(absl::string_view pass_name, double work_ms) override;
+
   void CompilationReport() override;
 
  private:
   struct PassInfo {
-    PassInfo(absl::string_view name, double duration)
-        : name(name), duration_ms(duration) {}
+    PassInfo(absl::string_view name, double duration, double work)
+        : name(name), duration_ms(duration), work_ms(work) {}
 
     absl::string_view name;
     int num_runs = 1;
     double duration_ms;
+    double work_ms;
   };
 
   // Info about the passes that have been run so far.
@@ -65,6 +71,8 @@ class Stats : public CompilationStats {
   absl::string_view current_pass_;
   // The start time of the currently running pass.
   uint64 start_micros_;
+  // The work recorded for the currently running pass, if any.
+  absl::optional<double> current_work_ms_;
 };
 
 /* static */
@@ -82,6 +90,7 @@ void Stats::StartPass(absl::string_view pass_name) {
                         << current_pass_;
   pass_running_ = true;
   current_pass_ = pass_name;
+  current_work_ms_.reset();
   start_micros_ = tensorflow::Env::Default()->NowMicros();
 }
 
@@ -91,23 +100,33 @@ void Stats::EndPass(absl::string_view pass_name) {
   pass_running_ = false;
   uint64 end_micros = tensorflow::Env::Default()->NowMicros();
   double duration_ms = (end_micros - start_micros_) / 1000.0;
-  passes_.push_back(PassInfo(current_pass_, duration_ms));
+  passes_.push_back(PassInfo(current_pass_, duration_ms,
+                             current_work_ms_.value_or(duration_ms)));
+}
+
+void Stats::RecordPassWork(absl::string_view pass_name, double work_ms) {
+  CHECK(pass_running_);
+  CHECK_EQ(current_pass_, pass_name);
+  current_work_ms_ = work_ms;
 }
 
 void Stats::CompilationReport() {
   CHECK(!pass_running_) << "EndPass never called for " << current_pass_;
   absl::flat_hash_map<absl::string_view, PassInfo> summary;
   double total_duration = 0;
+  double total_work = 0;
 
   for (auto& pass_run : passes_) {
     auto pass_name = pass_run.name;
     total_duration += pass_run.duration_ms;
+    total_work += pass_run.work_ms;
     auto it = summary.find(pass_name);
     if (it == summary.end()) {
       summary.insert(std::make_pair(pass_name, pass_run));
     } else {
       ++summary.at(pass_name).num_runs;
       summary.at(pass_name).duration_ms += pass_run.duration_ms;
+      summary.at(pass_name).work_ms += pass_run.work_ms;
     }
   }
 
@@ -122,10 +141,11 @@ void Stats::CompilationReport() {
            std::make_pair(a.duration_ms, b.name);
   });
   LOG(INFO) << "Total runtime (ms) of HLO passes: " << total_duration;
-  LOG(INFO) << "Pass name, num runs, time (ms)";
+  LOG(INFO) << "Total work (ms) of HLO passes: " << total_work;
+  LOG(INFO) << "Pass name, num runs, time (ms), work (ms)";
   for (auto& pass_info : sorted_summary) {
     LOG(INFO) << pass_info.name << ", " << pass_info.num_runs << ", "
-              << pass_info.duration_ms;
+              << pass_info.duration_ms << ", " << pass_info.work_ms;
   }
 }
 
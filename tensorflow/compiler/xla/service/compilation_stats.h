@@ -28,6 +28,10 @@ namespace xla {
 // before the execution of a pass, and EndPass after. Currently, we only collect
 // timing information and how many times each pass was run. In the future, we
 // can add more things, such as the size of the HLO graph after each pass.
+//
+// A pass run on several computations in parallel also reports, with
+// RecordPassWork, the time spent on all of them, which exceeds the time between
+// StartPass and EndPass as much as the pass made use of parallelism.
 class CompilationStats {
  public:
   virtual ~CompilationStats() = default;
@@ -40,6 +44,10 @@ class CompilationStats {
 
   virtual void EndPass(absl::string_view pass_name) = 0;
 
+  // Records the time the running pass spent in total on the computations it
+  // ran on in parallel. Without it, the work of a pass is its duration.
+  virtual void RecordPassWork(absl::string_view pass_name, double work_ms) = 0;
+
   virtual void CompilationReport() = 0;
 };
 
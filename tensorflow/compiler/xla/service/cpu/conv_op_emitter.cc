@@ -0,0 +1,127 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/cpu/conv_op_emitter.h"
+
+#include <string>
+
+#include "absl/strings/str_cat.h"
+#include "mlir/Dialect/Linalg/EDSC/Intrinsics.h"  // from @llvm-project
+#include "mlir/Dialect/StandardOps/EDSC/Intrinsics.h"  // from @llvm-project
+#include "mlir/EDSC/Builders.h"  // from @llvm-project
+#include "mlir/IR/AffineExpr.h"  // from @llvm-project
+#include "mlir/IR/Builders.h"  // from @llvm-project
+#include "mlir/IR/Function.h"  // from @llvm-project
+#include "mlir/IR/Value.h"  // from @llvm-project
+#include "tensorflow/compiler/xla/service/cpu/dot_op_emitter.h"
+#include "tensorflow/compiler/xla/service/cpu/mlir_emitter.h"
+#include "tensorflow/compiler/xla/shape_util.h"
+#include "tensorflow/compiler/xla/window_util.h"
+#include "tensorflow/compiler/xla/xla_data.pb.h"
+
+namespace xla {
+namespace cpu {
+
+bool CanEmitLinalgConvolution(const HloInstruction& convolution,
+                              const HloModuleConfig& hlo_module_config) {
+  const Shape& input_shape = convolution.operand(0)->shape();
+  const Shape& kernel_shape = convolution.operand(1)->shape();
+  const Shape& output_shape = convolution.shape();
+  if (output_shape.element_type() != F32 || output_shape.rank() != 4) {
+    return false;
+  }
+
+  if (convolution.feature_group_count() != 1 ||
+      convolution.batch_group_count() != 1) {
+    return false;
+  }
+
+  const Window& window = convolution.window();
+  if (window_util::HasPadding(window) || window_util::HasBaseDilation(window)) {
+    return false;
+  }
+
+  const ConvolutionDimensionNumbers& dnums =
+      convolution.convolution_dimension_numbers();
+  int64 m = output_shape.dimensions(dnums.output_batch_dimension()) *
+            output_shape.dimensions(dnums.output_spatial_dimensions(0)) *
+            output_shape.dimensions(dnums.output_spatial_dimensions(1));
+  int64 k = kernel_shape.dimensions(dnums.kernel_spatial_dimensions(0)) *
+            kernel_shape.dimensions(dnums.kernel_spatial_dimensions(1)) *
+            input_shape.dimensions(dnums.input_feature_dimension());
+  int64 n = output_shape.dimensions(dnums.output_feature_dimension());
+  return IsLinalgMatmulProfitable(hlo_module_config, m, k, n);
+}
+
+Status EmitLinalgConvolution(const HloInstruction& convolution,
+                             llvm::Value* target_ptr, llvm::Value* lhs_ptr,
+                             llvm::Value* rhs_ptr, llvm::IRBuilder<>* b,
+                             mlir::MLIRContext* mlir_context) {
+  const Shape& result_shape = convolution.shape();
+  Shape operand_shapes[] = {convolution.operand(0)->shape(),
+                            convolution.operand(1)->shape()};
+  llvm::Value* operand_ptrs[] = {lhs_ptr, rhs_ptr};
+
+  // Zero out the output buffer, the linalg op accumulates into it.
+  b->CreateMemSet(target_ptr, b->getInt8(0),
+                  /*Size=*/ShapeUtil::ByteSizeOf(result_shape),
+                  /*Align=*/llvm::MaybeAlign(1));
+
+  const Window& window = convolution.window();
+  std::string name = absl::StrCat(
+      "linalgConv_", result_shape.ToString(true), "_",
+      operand_shapes[0].ToString(true), "_", operand_shapes[1].ToString(true),
+      "_", window.dimensions(0).stride(), "x", window.dimensions(1).stride(),
+      "_", window.dimensions(0).window_dilation(), "x",
+      window.dimensions(1).window_dilation());
+
+  return EmitMlirFuncAndCall(
+      mlir_context, b, result_shape, operand_shapes, target_ptr, operand_ptrs,
+      name, [&](mlir::OpBuilder* builder, mlir::FuncOp function) {
+        mlir::MLIRContext* context = builder->getContext();
+        mlir::edsc::ScopedContext scope(*builder, function.getLoc());
+        mlir::Value output = function.getArgument(0),
+                    input = function.getArgument(1),
+                    kernel = function.getArgument(2);
+
+        // The loops are (batch, output row, output col, output feature) and
+        // the reductions over (kernel row, kernel col, input feature), with
+        // the input in NHWC, the kernel in HWIO and the output in NHWC order.
+        auto d = [&](int i) { return mlir::getAffineDimExpr(i, context); };
+        mlir::AffineExpr input_row =
+            d(1) * window.dimensions(0).stride() +
+            d(4) * window.dimensions(0).window_dilation();
+        mlir::AffineExpr input_col =
+            d(2) * window.dimensions(1).stride() +
+            d(5) * window.dimensions(1).window_dilation();
+
+        llvm::SmallVector<mlir::IteratorType, 7> types(
+            4, mlir::IteratorType::Parallel);
+        types.append(3, mlir::IteratorType::Reduction);
+
+        mlir::edsc::StructuredIndexed s_output(output), s_input(input),
+            s_kernel(kernel);
+        mlir::edsc::makeGenericLinalgOp(
+            types,
+            {s_input({d(0), input_row, input_col, d(6)}),
+             s_kernel({d(4), d(5), d(6), d(3)})},
+            {s_output({d(0), d(1), d(2), d(3)})},
+            mlir::edsc::ops::macRegionBuilder);
+        mlir::edsc::intrinsics::std_ret();
+      });
+}
+
+}  // namespace cpu
+}  // namespace xla
@@ -0,0 +1,46 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMPILER_XLA_SERVICE_CPU_CONV_OP_EMITTER_H_
+#define TENSORFLOW_COMPILER_XLA_SERVICE_CPU_CONV_OP_EMITTER_H_
+
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/Value.h"
+#include "mlir/IR/MLIRContext.h"  // from @llvm-project
+#include "tensorflow/compiler/xla/service/hlo_instruction.h"
+#include "tensorflow/compiler/xla/service/hlo_module_config.h"
+#include "tensorflow/core/lib/core/status.h"
+
+namespace xla {
+namespace cpu {
+// Returns true if `convolution` should be lowered into a linalg op instead of
+// a call into Eigen.  `convolution` must be potentially implemented as an
+// Eigen convolution, with dim0-major layouts for its operands and result.
+//
+// Only unpadded 2D F32 convolutions are supported, and they are treated as the
+// GEMM they would be lowered to by im2col when deciding if linalg beats Eigen.
+bool CanEmitLinalgConvolution(const HloInstruction& convolution,
+                              const HloModuleConfig& hlo_module_config);
+
+// Emits a call to an MLIR function that computes `convolution` over the
+// buffers at `lhs_ptr` and `rhs_ptr` and writes the result to `target_ptr`.
+Status EmitLinalgConvolution(const HloInstruction& convolution,
+                             llvm::Value* target_ptr, llvm::Value* lhs_ptr,
+                             llvm::Value* rhs_ptr, llvm::IRBuilder<>* b,
+                             mlir::MLIRContext* mlir_context);
+}  // namespace cpu
+}  // namespace xla
+
+#endif  // TENSORFLOW_COMPILER_XLA_SERVICE_CPU_CONV_OP_EMITTER_H_
@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/compiler/xla/service/cpu/cpu_instruction_fusion.h"
 
+#include "tensorflow/compiler/xla/service/cpu/dot_op_emitter.h"
 #include "tensorflow/compiler/xla/service/fusion_node_indexing_evaluation.h"
 #include "tensorflow/compiler/xla/service/hlo_opcode.h"
 #include "tensorflow/compiler/xla/service/llvm_ir/fused_ir_emitter.h"
@@ -54,10 +55,25 @@ bool HasExactlyOneUse(const HloInstruction& hlo_instr) {
          absl::c_count(hlo_instr.users().front()->operands(), &hlo_instr) == 1;
 }
 
+// Returns true if `hlo` is a matrix-matrix dot emitted through linalg whose
+// result can be accumulated into an addend of `consumer`.  The addend is copied
+// into the output buffer as is, so it needs the same layout as the output.
+bool IsLinalgMatmulDotWithFusibleAddend(const HloInstruction* hlo,
+                                        const HloInstruction* consumer) {
+  if (!DotIsEmittedAsLinalgMatmul(*hlo)) {
+    return false;
+  }
+  const HloInstruction* addend =
+      consumer->operand(consumer->operand(0) == hlo ? 1 : 0);
+  return ShapeUtil::Equal(addend->shape(), hlo->shape()) &&
+         ShapeUtil::Equal(consumer->shape(), hlo->shape());
+}
+
 bool CanBeOutputFused(const HloInstruction* producer,
                       const HloInstruction* consumer) {
   return consumer->opcode() == HloOpcode::kAdd &&
-         IsNonComplexNonBatchedMatrixVectorDot(producer) &&
+         (IsNonComplexNonBatchedMatrixVectorDot(producer) ||
+          IsLinalgMatmulDotWithFusibleAddend(producer, consumer)) &&
          HasExactlyOneUse(*producer) == 1;
 }
 
@@ -719,6 +719,56 @@ TEST_F(OpcodeFusionTest, DotAddOutputFusion_19x50x1_multi_use) {
               Not(op::Fusion()));
 }
 
+// With single threaded Eigen, small matrix-matrix dots are lowered into a
+// linalg matmul that can accumulate into a fused addend.
+class LinalgDotAddOutputFusionTest : public OpcodeFusionTest {
+ protected:
+  DebugOptions GetDebugOptionsForTest() override {
+    DebugOptions debug_options = OpcodeFusionTest::GetDebugOptionsForTest();
+    debug_options.set_xla_cpu_multi_thread_eigen(false);
+    return debug_options;
+  }
+};
+
+TEST_F(LinalgDotAddOutputFusionTest, DotAddOutputFusion_19x50x19) {
+  auto module = CreateNewVerifiedModule();
+  CreateComputationForDotAddOutputFusionTest(TestName(), module.get(), /*m=*/19,
+                                             /*k=*/50, /*n=*/19,
+                                             /*add_extra_use_for_dot=*/false);
+
+  RunFusionAndCheckOpcodesWereFused(
+      module.get(),
+      {HloOpcode::kDot, HloOpcode::kAdd, HloOpcode::kParameter,
+       HloOpcode::kParameter, HloOpcode::kParameter},
+      HloInstruction::FusionKind::kOutput);
+}
+
+TEST_F(LinalgDotAddOutputFusionTest, DotAddOutputFusion_512x512x512) {
+  auto module = CreateNewVerifiedModule();
+  CreateComputationForDotAddOutputFusionTest(TestName(), module.get(),
+                                             /*m=*/512, /*k=*/512, /*n=*/512,
+                                             /*add_extra_use_for_dot=*/false);
+
+  TF_ASSERT_OK_AND_ASSIGN(bool fused_something,
+                          CpuInstructionFusion().Run(module.get()));
+  EXPECT_FALSE(fused_something);
+  EXPECT_THAT(module->entry_computation()->root_instruction(),
+              Not(op::Fusion()));
+}
+
+TEST_F(LinalgDotAddOutputFusionTest, DotAddOutputFusion_19x50x19_multi_use) {
+  auto module = CreateNewVerifiedModule();
+  CreateComputationForDotAddOutputFusionTest(TestName(), module.get(), /*m=*/19,
+                                             /*k=*/50, /*n=*/19,
+                                             /*add_extra_use_for_dot=*/true);
+
+  TF_ASSERT_OK_AND_ASSIGN(bool fused_something,
+                          CpuInstructionFusion().Run(module.get()));
+  EXPECT_FALSE(fused_something);
+  EXPECT_THAT(module->entry_computation()->root_instruction(),
+              Not(op::Fusion()));
+}
+
 TEST_F(InstructionFusionTest,
        DotOperationFusion_DontOutputFuseDuplicateOperands) {
   absl::string_view module_string = R"(
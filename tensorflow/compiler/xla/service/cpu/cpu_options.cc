@@ -26,6 +26,7 @@ const char* const kLlvmIrDotTilingFactor = "xla_llvm_dot_tiling_factor";
 const char* const kXlaForceEnableExperimentalLlvmIrGemm =
     "xla_force_enable_experimental_llvm_ir_gemm";
 const char* const kLlvmIrGemmTileSize = "xla_llvm_ir_gemm_tile_size";
+const char* const kLinalgMatmulMaxSize = "xla_cpu_linalg_matmul_max_size";
 
 }  // namespace
 
@@ -63,6 +64,18 @@ bool ForceEnableExperimentalLlvmIrGemm(const HloModuleConfig& config) {
   return extra_options_map.count(kXlaForceEnableExperimentalLlvmIrGemm) > 0;
 }
 
+absl::optional<int64> LinalgMatmulMaxSize(const HloModuleConfig& config) {
+  const auto& extra_options_map =
+      config.debug_options().xla_backend_extra_options();
+  auto it = extra_options_map.find(kLinalgMatmulMaxSize);
+  int64 max_size;
+  if (it != extra_options_map.end() &&
+      absl::SimpleAtoi(it->second, &max_size)) {
+    return max_size;
+  }
+  return absl::nullopt;
+}
+
 static absl::string_view RemoveSuffix(absl::string_view str,
                                       absl::string_view suffix) {
   CHECK_GE(str.size(), suffix.size());
@@ -15,6 +15,8 @@ limitations under the License.
 #define EIGEN_USE_THREADS
 #include "tensorflow/compiler/xla/service/cpu/cpu_runtime.h"
 
+#include <array>
+#include <atomic>
 #include <memory>
 #include <string>
 #include <tuple>
@@ -24,10 +26,12 @@ limitations under the License.
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/compiler/xla/array2d.h"
 #include "tensorflow/compiler/xla/client/local_client.h"
+#include "tensorflow/compiler/xla/service/cpu/runtime_fork_join.h"
 #include "tensorflow/compiler/xla/service/cpu/runtime_matmul.h"
 #include "tensorflow/compiler/xla/service/cpu/runtime_matmul_mkl.h"
 #include "tensorflow/compiler/xla/service/cpu/runtime_single_threaded_matmul.h"
 #include "tensorflow/compiler/xla/types.h"
+#include "tensorflow/core/platform/blocking_counter.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/test.h"
@@ -236,5 +240,61 @@ INSTANTIATE_TEST_CASE_P(MKLMatMulTestInstantiaion, MKLMatMulTest,
                         MKLMatMulTest::Name);
 #endif  // INTEL_MKL
 
+constexpr int32 kNumForkJoinPartitions = 16;
+using PartitionCounts = std::array<std::atomic<int32>, kNumForkJoinPartitions>;
+
+// Counts the calls for each of the rows in the partition's [start, limit).
+void CountPartitionCalls(void* result_ptr, const void* run_options_ptr,
+                         const void** params, void** buffer_table,
+                         int64* partition, uint64* prof_counters) {
+  auto* counts = static_cast<PartitionCounts*>(result_ptr);
+  for (int64 row = partition[0]; row < partition[1]; ++row) {
+    ++(*counts)[row];
+  }
+}
+
+TEST_F(CpuRuntimeTest, ConcurrentParallelForkJoinsRunEachPartitionOnce) {
+  tensorflow::thread::ThreadPool pool(tensorflow::Env::Default(), "XLAEigen",
+                                      4);
+  Eigen::ThreadPoolDevice device(pool.AsEigenThreadPool(), pool.NumThreads());
+  ExecutableRunOptions run_options;
+  run_options.set_intra_op_thread_pool(&device);
+
+  std::array<int64, 2 * kNumForkJoinPartitions> partitions;
+  for (int32 i = 0; i < kNumForkJoinPartitions; ++i) {
+    partitions[2 * i] = i;
+    partitions[2 * i + 1] = i + 1;
+  }
+
+  constexpr int kNumForkJoins = 8;
+  std::array<PartitionCounts, kNumForkJoins> counts{};
+  tensorflow::BlockingCounter done(kNumForkJoins);
+  // The fork-joins share the intra-op pool, and half of them run on it.
+  tensorflow::thread::ThreadPool callers(tensorflow::Env::Default(), "callers",
+                                         kNumForkJoins / 2);
+  for (int i = 0; i < kNumForkJoins; ++i) {
+    auto fork_join = [&, i]() {
+      __xla_cpu_runtime_ParallelForkJoin(
+          &counts[i], &run_options, /*params=*/nullptr,
+          /*buffer_table=*/nullptr, /*prof_counters=*/nullptr,
+          kNumForkJoinPartitions, partitions.data(),
+          /*num_partitioned_dims=*/1,
+          reinterpret_cast<void*>(&CountPartitionCalls));
+      done.DecrementCount();
+    };
+    if (i % 2 == 0) {
+      callers.Schedule(fork_join);
+    } else {
+      pool.Schedule(fork_join);
+    }
+  }
+  done.Wait();
+  for (const PartitionCounts& fork_join_counts : counts) {
+    for (const std::atomic<int32>& count : fork_join_counts) {
+      EXPECT_EQ(count, 1);
+    }
+  }
+}
+
 }  // namespace
 }  // namespace xla
@@ -257,10 +257,18 @@ Status DotOpEmitter::EmitLinalgMatmul() {
                                  rhs_array_.GetBasePointer()};
   llvm::Value* target_ptr = target_array_.GetBasePointer();
 
-  // Zero out the output buffer.
+  // The linalg op accumulates into the output buffer, so start it off with
+  // the addend if there is one and with zeros otherwise.  The addend buffer
+  // may be reused for the output, which llvm.memcpy allows.
   int64 size_bytes = ShapeUtil::ByteSizeOf(dot_info_.result_shape);
-  b_->CreateMemSet(target_ptr, b_->getInt8(0), /*Size=*/size_bytes,
-                   /*Align=*/llvm::MaybeAlign(1));
+  if (addend_array_) {
+    b_->CreateMemCpy(target_ptr, /*DstAlign=*/llvm::Align(1),
+                     addend_array_->GetBasePointer(),
+                     /*SrcAlign=*/llvm::Align(1), /*Size=*/size_bytes);
+  } else {
+    b_->CreateMemSet(target_ptr, b_->getInt8(0), /*Size=*/size_bytes,
+                     /*Align=*/llvm::MaybeAlign(1));
+  }
 
   std::string name =
       absl::StrCat("linalgMatMul_", dot_info_.result_shape.ToString(true), "_",
@@ -931,8 +939,7 @@ bool IsSimpleLayout(const Layout& layout) {
 // In a gemm operation where output = lhs * rhs, check whether the given shapes
 // are valid for the operation.
 bool AreGemmShapes(const Shape& lhs_shape, const Shape& rhs_shape,
-                   const Shape& output_shape,
-                   const TargetMachineFeatures& target_machine_features) {
+                   const Shape& output_shape) {
   CHECK(!lhs_shape.has_layout() || IsSimpleLayout(lhs_shape.layout()))
       << lhs_shape.DebugString();
   CHECK(!rhs_shape.has_layout() || IsSimpleLayout(rhs_shape.layout()))
@@ -953,40 +960,42 @@ bool AreGemmShapes(const Shape& lhs_shape, const Shape& rhs_shape,
   }
 }
 
-bool IsAlignedGemm(const DotInfo& dot_info,
-                   const TargetMachineFeatures& target_machine_features) {
+bool IsAlignedGemm(const DotInfo& dot_info) {
   if (ShapeUtil::IsZeroElementArray(dot_info.lhs_shape) ||
       ShapeUtil::IsZeroElementArray(dot_info.rhs_shape)) {
     return false;
   }
 
   return AreGemmShapes(dot_info.lhs_shape, dot_info.rhs_shape,
-                       dot_info.result_shape, target_machine_features);
+                       dot_info.result_shape);
 }
 
-bool CanEmitTiledLlvmIrGemm(
-    const HloModuleConfig& config, const DotInfo& dot_info,
-    const TargetMachineFeatures& target_machine_features) {
-  CHECK(IsAlignedGemm(dot_info, target_machine_features));
+// Returns true if `dot_info` is a matrix-vector product, which is lowered to a
+// tiled LLVM IR implementation.
+bool IsTiledLlvmIrGemv(const DotInfo& dot_info) {
+  PrimitiveType element_type = dot_info.result_shape.element_type();
+  return (dot_info.result_shape.dimensions_size() <= 1 ||
+          (dot_info.result_shape.dimensions_size() == 2 &&
+           (dot_info.result_shape.dimensions(0) == 1 ||
+            dot_info.result_shape.dimensions(1) == 1))) &&
+         (primitive_util::IsFloatingPointType(element_type) ||
+          primitive_util::IsIntegralType(element_type));
+}
 
-  if (ShouldUseMultiThreadedEigen(config)) {
-    return false;
-  }
+bool CanEmitLinalgMatmul(const HloModuleConfig& config,
+                         const DotInfo& dot_info) {
+  CHECK(IsAlignedGemm(dot_info));
 
-  int m = dot_info.result_shape.dimensions(0);
-  int k = dot_info.lhs_shape.dimensions(
+  int64 m = dot_info.result_shape.dimensions(0);
+  int64 k = dot_info.lhs_shape.dimensions(
       dot_info.dim_nums.lhs_contracting_dimensions(0));
-  int n = dot_info.result_shape.dimensions(1);
+  int64 n = dot_info.result_shape.dimensions(1);
 
-  if (!options::ForceEnableExperimentalLlvmIrGemm(config)) {
-    // TODO(sanjoy):  We should make these numbers micro-arch specific.
-    bool small_gemm =
-        k <= 128 && ((m <= 32 && n <= 128) || (m <= 128 && n <= 32));
-    if (!small_gemm) {
-      return false;
-    }
+  if (!IsLinalgMatmulProfitable(config, m, k, n)) {
+    return false;
   }
 
+  // Only the canonical matmul is vectorized by the codegen strategy.
   bool lhs_canonical = dot_info.dim_nums.lhs_contracting_dimensions(0) == 1;
   bool rhs_canonical = dot_info.dim_nums.rhs_contracting_dimensions(0) == 0;
 
@@ -1008,21 +1017,15 @@ bool CanEmitTiledLlvmIrGemm(
 DotImplementationStrategy GetDotImplementationStrategy(
     const HloModuleConfig& config, const DotInfo& dot_info,
     const TargetMachineFeatures& target_machine_features) {
-  PrimitiveType element_type = dot_info.result_shape.element_type();
   // Any Matrix-Vector product of floating point or integral type, or
   // a transpose-dot fusion of the same can be lowered to a tiled LLVM
   // IR implementation.
-  if ((dot_info.result_shape.dimensions_size() <= 1 ||
-       (dot_info.result_shape.dimensions_size() == 2 &&
-        (dot_info.result_shape.dimensions(0) == 1 ||
-         dot_info.result_shape.dimensions(1) == 1))) &&
-      (primitive_util::IsFloatingPointType(element_type) ||
-       primitive_util::IsIntegralType(element_type))) {
+  if (IsTiledLlvmIrGemv(dot_info)) {
     return DotImplementationStrategy::kTiledLlvmIrGemv;
   }
 
-  if (IsAlignedGemm(dot_info, target_machine_features)) {
-    if (CanEmitTiledLlvmIrGemm(config, dot_info, target_machine_features)) {
+  if (IsAlignedGemm(dot_info)) {
+    if (CanEmitLinalgMatmul(config, dot_info)) {
       return DotImplementationStrategy::kLinalgMatmul;
     }
     return DotImplementationStrategy::kEigen;
@@ -1190,6 +1193,37 @@ bool IsBatchDot(const HloInstruction& instr) {
 }
 }  // namespace
 
+bool IsLinalgMatmulProfitable(const HloModuleConfig& config, int64 m, int64 k,
+                              int64 n) {
+  // An explicitly configured threshold applies whichever Eigen is used.
+  if (absl::optional<int64> max_size = options::LinalgMatmulMaxSize(config)) {
+    return m * k * n <= *max_size;
+  }
+
+  // Multi-threaded Eigen splits GEMMs across its thread pool, which the linalg
+  // code does not, so it is kept by default.
+  if (ShouldUseMultiThreadedEigen(config)) {
+    return false;
+  }
+
+  if (options::ForceEnableExperimentalLlvmIrGemm(config)) {
+    return true;
+  }
+
+  // TODO(sanjoy):  We should make these numbers micro-arch specific.
+  return m * k * n <= int64{128} * 128 * 32;
+}
+
+bool DotIsEmittedAsLinalgMatmul(const HloInstruction& dot) {
+  if (dot.opcode() != HloOpcode::kDot || IsBatchDot(dot)) {
+    return false;
+  }
+
+  DotInfo dot_info(dot);
+  return !IsTiledLlvmIrGemv(dot_info) && IsAlignedGemm(dot_info) &&
+         CanEmitLinalgMatmul(dot.parent()->parent()->config(), dot_info);
+}
+
 bool DotImplementationCanHandleTranspose(
     const HloInstruction& dot_instr,
     const TargetMachineFeatures& target_machine_features) {
@@ -1216,7 +1250,10 @@ bool DotOperandsAndResultMustHaveRowMajorLayout(
       GetDotImplementationStrategy(dot_instr.parent()->parent()->config(),
                                    DotInfo(dot_instr), target_machine_features);
 
+  // The memrefs the linalg code is emitted with have the default row-major
+  // layout.
   return impl_strategy == DotImplementationStrategy::kTiledLlvmIrGemm ||
+         impl_strategy == DotImplementationStrategy::kLinalgMatmul ||
          impl_strategy == DotImplementationStrategy::kEigen;
 }
 
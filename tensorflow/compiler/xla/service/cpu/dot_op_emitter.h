@@ -49,6 +49,20 @@ bool DotImplementationCanHandleTranspose(
 absl::optional<int64> ProfitableToMakeDotOperandColumnMajor(
     const HloInstruction& hlo);
 
+// Returns whether the code emitted through linalg is expected to be faster
+// than the call to Eigen for a GEMM of size m x k x n.
+//
+// For small GEMMs the cost of the call into Eigen, and of packing the operands,
+// dominates that of the multiply itself, and the linalg code, which works on
+// the operands in place, wins.  The size limit can be set with the
+// xla_cpu_linalg_matmul_max_size backend option.
+bool IsLinalgMatmulProfitable(const HloModuleConfig& config, int64 m, int64 k,
+                              int64 n);
+
+// Returns true if `dot` is lowered into a linalg matmul, which also supports
+// fusing in an addend.
+bool DotIsEmittedAsLinalgMatmul(const HloInstruction& dot);
+
 // Emit LLVM IR to perform the dot operation on lhs_array and rhs_array and
 // place the result in target_array. IR is emitted at current insert point of
 // the builder. Upon completion of the method, the insert point is set to the
@@ -57,7 +71,7 @@ absl::optional<int64> ProfitableToMakeDotOperandColumnMajor(
 // If `addend_array` is not nullptr then it must be an array of the same
 // dimensions as the result, and the result is computed as `addend_array` +
 // dot(`lhs_array`, `rhs_array`).  A non-null `addend_array` is only supported
-// for Matrix-vector products.
+// for Matrix-vector products and for dots lowered into a linalg matmul.
 Status EmitDotOperation(const HloInstruction& dot,
                         const llvm_ir::IrArray& target_array,
                         const llvm_ir::IrArray& lhs_array,
@@ -47,6 +47,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/primitive_util.h"
 #include "tensorflow/compiler/xla/service/buffer_assignment.h"
 #include "tensorflow/compiler/xla/service/collective_ops_utils.h"
+#include "tensorflow/compiler/xla/service/cpu/conv_op_emitter.h"
 #include "tensorflow/compiler/xla/service/cpu/cpu_options.h"
 #include "tensorflow/compiler/xla/service/cpu/cpu_runtime.h"
 #include "tensorflow/compiler/xla/service/cpu/dot_op_emitter.h"
@@ -1029,6 +1030,13 @@ Status IrEmitter::HandleConvolution(HloInstruction* convolution) {
       llvm::Value* rhs_address = GetEmittedValueFor(rhs);
       TF_RETURN_IF_ERROR(EmitTargetAddressForOp(convolution));
 
+      if (CanEmitLinalgConvolution(*convolution, hlo_module_config_)) {
+        return EmitLinalgConvolution(*convolution,
+                                     GetEmittedValueFor(convolution),
+                                     lhs_address, rhs_address, &b_,
+                                     mlir_context_);
+      }
+
       const ConvolutionDimensionNumbers& dnums =
           convolution->convolution_dimension_numbers();
 
@@ -1806,8 +1814,17 @@ StatusOr<bool> IrEmitter::EmitVectorizedReduce(
       MinimumAlignmentForPrimitiveType(reduce->shape().element_type()));
 
   if (is_reduction_over_minor_dimension) {
-    // TODO(sanjoy): Implement vectorized reduction over the minor dimension.
-    *failure_reason = "reduction over minor dimension not implemented";
+    return EmitVectorizedReduceOverMinorDimensions(
+        reduce, arg, init_value, dimensions, reduction_generator,
+        vectorization_factor, element_alignment, failure_reason);
+  }
+
+  // The innermost loop below is strided by the vectorization factor, so it
+  // cannot run within the dynamic loop bounds of a parallel task.
+  if (ShouldEmitParallelLoopFor(*reduce) &&
+      num_dynamic_loop_bounds_ >= reduce->shape().rank()) {
+    *failure_reason =
+        "the most minor output dimension is partitioned across parallel tasks";
     return false;
   }
 
@@ -1835,17 +1852,8 @@ StatusOr<bool> IrEmitter::EmitVectorizedReduce(
   //  }
 
   llvm_ir::ForLoopNest loop_nest(IrName(reduce), &b_);
-  std::vector<llvm::Value*> array_multi_index(
-      reduce->shape().dimensions_size());
-  for (int i = LayoutUtil::MinorToMajor(reduce->shape()).size() - 1; i > 0;
-       --i) {
-    int64 dimension = LayoutUtil::Minor(reduce->shape().layout(), i);
-    int64 start_index = 0;
-    int64 end_index = reduce->shape().dimensions(dimension);
-    std::unique_ptr<llvm_ir::ForLoop> loop = loop_nest.AddLoop(
-        start_index, end_index, absl::StrFormat("dim.%d", dimension));
-    array_multi_index[dimension] = loop->GetIndVarValue();
-  }
+  std::vector<llvm::Value*> array_multi_index = AddLoopsForReduceOutput(
+      *reduce, /*num_inner_dimensions=*/1, &loop_nest);
 
   int64 innermost_dimension = LayoutUtil::Minor(reduce->shape().layout(), 0);
   int64 innermost_dimension_size =
@@ -1926,6 +1934,249 @@ StatusOr<bool> IrEmitter::EmitVectorizedReduce(
   return true;
 }
 
+std::vector<llvm::Value*> IrEmitter::AddLoopsForReduceOutput(
+    const HloInstruction& reduce, int64 num_inner_dimensions,
+    llvm_ir::ForLoopNest* loop_nest) {
+  const Shape& shape = reduce.shape();
+  const int64 num_dims = shape.dimensions_size();
+  std::vector<llvm::Value*> multi_index(num_dims);
+  DynamicLoopBounds dynamic_loop_bounds;
+  if (ShouldEmitParallelLoopFor(reduce)) {
+    dynamic_loop_bounds = compute_function_->GetDynamicLoopBounds();
+  }
+  for (int64 i = num_dims - 1; i >= num_inner_dimensions; --i) {
+    const int64 dimension = LayoutUtil::Minor(shape.layout(), i);
+    // As in ParallelLoopEmitter, the dynamic loop bounds are those of the
+    // most major dimensions.
+    const int64 bounds_index = num_dims - 1 - i;
+    std::unique_ptr<llvm_ir::ForLoop> loop;
+    if (bounds_index < dynamic_loop_bounds.size()) {
+      loop = loop_nest->AddLoop(
+          /*suffix=*/absl::StrFormat("dim.%d", dimension),
+          /*start_index=*/dynamic_loop_bounds[bounds_index].first,
+          /*end_index=*/dynamic_loop_bounds[bounds_index].second);
+    } else {
+      loop = loop_nest->AddLoop(
+          /*start_index=*/0, /*end_index=*/shape.dimensions(dimension),
+          /*suffix=*/absl::StrFormat("dim.%d", dimension));
+    }
+    multi_index[dimension] = loop->GetIndVarValue();
+  }
+  return multi_index;
+}
+
+llvm::Value* IrEmitter::EmitHorizontalReduction(
+    const ReductionGenerator& reduction_generator,
+    const ShardedVector& vector) {
+  ShardedVector shards = vector;
+  bool reduced_pair = true;
+  while (reduced_pair) {
+    reduced_pair = false;
+    ShardedVector next_shards;
+    for (int i = 0; i < shards.size(); ++i) {
+      if (i + 1 < shards.size() &&
+          shards[i]->getType() == shards[i + 1]->getType()) {
+        next_shards.push_back(
+            reduction_generator(&b_, shards[i], shards[i + 1]));
+        reduced_pair = true;
+        ++i;
+      } else {
+        next_shards.push_back(shards[i]);
+      }
+    }
+    shards = std::move(next_shards);
+  }
+
+  llvm::Value* result = nullptr;
+  for (llvm::Value* shard : shards) {
+    if (auto vector_type = llvm::dyn_cast<llvm::VectorType>(shard->getType())) {
+      // Each step reduces the upper half of the remaining lanes into the lower
+      // half.  The sharded vector types have power of two sizes.
+      const unsigned vector_size = vector_type->getNumElements();
+      CHECK_EQ(vector_size & (vector_size - 1), 0);
+      for (unsigned lanes = vector_size; lanes > 1; lanes /= 2) {
+        std::vector<llvm::Constant*> mask(
+            vector_size, llvm::UndefValue::get(b_.getInt32Ty()));
+        for (unsigned j = 0; j < lanes / 2; ++j) {
+          mask[j] = b_.getInt32(lanes / 2 + j);
+        }
+        llvm::Value* upper_half = b_.CreateShuffleVector(
+            shard, llvm::UndefValue::get(vector_type),
+            llvm::ConstantVector::get(mask));
+        shard = reduction_generator(&b_, shard, upper_half);
+      }
+      shard = b_.CreateExtractElement(shard, b_.getInt32(0));
+    }
+    result = result ? reduction_generator(&b_, result, shard) : shard;
+  }
+  return result;
+}
+
+StatusOr<bool> IrEmitter::EmitVectorizedReduceOverMinorDimensions(
+    HloInstruction* reduce, HloInstruction* arg, HloInstruction* init_value,
+    absl::Span<const int64> dimensions,
+    const ReductionGenerator& reduction_generator, int vectorization_factor,
+    unsigned element_alignment, string* failure_reason) {
+  const Shape& arg_shape = arg->shape();
+  absl::Span<const int64> arg_minor_to_major =
+      LayoutUtil::MinorToMajor(arg_shape);
+  for (int64 i = 0; i < dimensions.size(); ++i) {
+    if (!absl::c_linear_search(dimensions, arg_minor_to_major[i])) {
+      *failure_reason =
+          "reduced dimensions are not the most minor dimensions of the operand";
+      return false;
+    }
+  }
+  int64 reduced_size = 1;
+  for (int64 dimension : dimensions) {
+    reduced_size *= arg_shape.dimensions(dimension);
+  }
+  // TreeReductionRewriter leaves the reductions with a reduced dimension
+  // smaller than its window, so narrower vectors are used for short runs.
+  while (vectorization_factor > reduced_size) {
+    vectorization_factor /= 2;
+  }
+  if (vectorization_factor < 2) {
+    *failure_reason = "reduced dimensions are too small to vectorize";
+    return false;
+  }
+  // The lanes of the vector accumulator are reduced together at the end, which
+  // reassociates the reduction.
+  if (ShapeUtil::ElementIsFloating(reduce->shape()) &&
+      !b_.getFastMathFlags().allowReassoc()) {
+    *failure_reason =
+        "reduction over minor dimension needs reassociation of floating point "
+        "operations";
+    return false;
+  }
+
+  CHECK(!reduce->shape().IsTuple());
+  TF_RETURN_IF_ERROR(EmitTargetAddressForOp(reduce));
+
+  // The reduced dimensions R are the most minor ones of the operand, so the
+  // elements reduced into an output element are a contiguous run of the size
+  // of R.  With VS the vectorization stride, we lower the reduction loop as:
+  //
+  //  for (d in D) {
+  //    vector_acc = input[d, 0 : VS]
+  //    for (r in R with stride VS, from VS) {
+  //      vector_acc = elementwise_reduce(vector_acc, input[d, r : r + VS])
+  //    }
+  //    acc = reduce(init, horizontal_reduce(vector_acc))
+  //    for (r in the remaining elements of R) {
+  //      acc = reduce(acc, input[d, r])
+  //    }
+  //    output[d] = acc
+  //  }
+  llvm_ir::ForLoopNest loop_nest(IrName(reduce), &b_);
+  std::vector<llvm::Value*> output_multi_index = AddLoopsForReduceOutput(
+      *reduce, /*num_inner_dimensions=*/0, &loop_nest);
+  if (llvm::BasicBlock* innermost_body_bb =
+          loop_nest.GetInnerLoopBodyBasicBlock()) {
+    SetToFirstInsertPoint(innermost_body_bb, &b_);
+  }
+  auto outermost_loop_exit_block = loop_nest.GetOuterLoopExitBasicBlock();
+
+  std::vector<llvm::Value*> input_multi_index(arg_shape.dimensions_size());
+  auto output_it = output_multi_index.begin();
+  for (int64 i = 0; i < arg_shape.dimensions_size(); ++i) {
+    input_multi_index[i] = absl::c_linear_search(dimensions, i)
+                               ? b_.getInt64(0)
+                               : *output_it++;
+  }
+  CHECK(output_it == output_multi_index.end());
+  llvm_ir::IrArray arg_array(GetIrArrayFor(arg));
+  llvm_ir::IrArray::Index input_index(input_multi_index, arg_shape,
+                                      b_.getInt64Ty());
+  llvm::Type* element_ir_type =
+      llvm_ir::PrimitiveTypeToIrType(reduce->shape().element_type(), module_);
+  llvm::Value* input_address =
+      BitCast(arg_array.EmitArrayElementAddress(input_index, &b_),
+              element_ir_type->getPointerTo());
+
+  ShardedVectorType vector_type = CreateShardedVectorType(
+      reduce->shape().element_type(), vectorization_factor);
+  // Loads the sharded vector of "vectorization_factor" elements starting at
+  // the element at "offset" of the reduced run.
+  auto load_sharded_vector = [&](llvm::Value* offset) {
+    ShardedVector vector;
+    llvm::Value* address = InBoundsGEP(input_address, {offset});
+    for (llvm::Type* shard_type : vector_type) {
+      llvm::Value* shard_address =
+          BitCast(address, llvm::PointerType::getUnqual(shard_type));
+      llvm::LoadInst* shard = AlignedLoad(shard_address, element_alignment);
+      arg_array.AnnotateLoadStoreInstructionWithMetadata(shard);
+      vector.push_back(shard);
+      address = ConstInBoundsGEP1_32(shard_type, shard_address, 1);
+      address = BitCast(address, element_ir_type->getPointerTo());
+    }
+    return vector;
+  };
+
+  ShardedVector accumulator;
+  ShardedVector first_vector = load_sharded_vector(b_.getInt64(0));
+  for (int i = 0; i < vector_type.size(); ++i) {
+    accumulator.push_back(llvm_ir::EmitAllocaAtFunctionEntry(
+        vector_type[i], "accumulator", &b_, 0));
+    AlignedStore(first_vector[i], accumulator[i], element_alignment);
+  }
+
+  const int64 vectorized_size =
+      (reduced_size / vectorization_factor) * vectorization_factor;
+  llvm_ir::ForLoopNest vector_loop_nest(IrName(arg, "vectorized_inner"), &b_);
+  std::unique_ptr<llvm_ir::ForLoop> vector_loop =
+      vector_loop_nest.AddLoop(vectorization_factor, vectorized_size,
+                               vectorization_factor, "reduction_dim");
+  SetToFirstInsertPoint(vector_loop->GetBodyBasicBlock(), &b_);
+  ShardedVector addend = load_sharded_vector(vector_loop->GetIndVarValue());
+  for (int i = 0; i < accumulator.size(); ++i) {
+    llvm::Value* current_accumulator_value =
+        AlignedLoad(accumulator[i], element_alignment);
+    AlignedStore(
+        reduction_generator(&b_, current_accumulator_value, addend[i]),
+        accumulator[i], element_alignment);
+  }
+  SetToFirstInsertPoint(vector_loop_nest.GetOuterLoopExitBasicBlock(), &b_);
+
+  ShardedVector accumulator_value;
+  for (llvm::Value* accumulator_shard : accumulator) {
+    accumulator_value.push_back(
+        AlignedLoad(accumulator_shard, element_alignment));
+  }
+  llvm::Value* scalar_accumulator = llvm_ir::EmitAllocaAtFunctionEntry(
+      element_ir_type, "scalar_accumulator", &b_, 0);
+  Store(reduction_generator(&b_, Load(GetEmittedValueFor(init_value)),
+                            EmitHorizontalReduction(reduction_generator,
+                                                    accumulator_value)),
+        scalar_accumulator);
+
+  if (vectorized_size != reduced_size) {
+    llvm_ir::ForLoopNest epilogue_loop_nest(IrName(arg, "scalar_inner"), &b_);
+    std::unique_ptr<llvm_ir::ForLoop> epilogue_loop =
+        epilogue_loop_nest.AddLoop(vectorized_size, reduced_size,
+                                   "reduction_dim");
+    SetToFirstInsertPoint(epilogue_loop->GetBodyBasicBlock(), &b_);
+    llvm::LoadInst* element = AlignedLoad(
+        InBoundsGEP(input_address, {epilogue_loop->GetIndVarValue()}),
+        element_alignment);
+    arg_array.AnnotateLoadStoreInstructionWithMetadata(element);
+    Store(reduction_generator(&b_, Load(scalar_accumulator), element),
+          scalar_accumulator);
+    SetToFirstInsertPoint(epilogue_loop_nest.GetOuterLoopExitBasicBlock(),
+                          &b_);
+  }
+
+  llvm_ir::IrArray::Index output_index(output_multi_index, reduce->shape(),
+                                       b_.getInt64Ty());
+  GetIrArrayFor(reduce).EmitWriteArrayElement(
+      output_index, Load(scalar_accumulator), &b_);
+
+  if (outermost_loop_exit_block) {
+    b_.SetInsertPoint(outermost_loop_exit_block);
+  }
+  return true;
+}
+
 Status IrEmitter::HandleReduce(HloInstruction* reduce) {
   auto arg = reduce->mutable_operand(0);
   auto init_value = reduce->mutable_operand(1);
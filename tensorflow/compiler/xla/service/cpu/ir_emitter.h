@@ -45,6 +45,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/llvm_ir/alias_analysis.h"
 #include "tensorflow/compiler/xla/service/llvm_ir/ir_array.h"
 #include "tensorflow/compiler/xla/service/llvm_ir/ir_builder_mixin.h"
+#include "tensorflow/compiler/xla/service/llvm_ir/llvm_loop.h"
 #include "tensorflow/compiler/xla/service/llvm_ir/llvm_util.h"
 #include "tensorflow/compiler/xla/service/llvm_ir/loop_emitter.h"
 #include "tensorflow/compiler/xla/service/name_uniquer.h"
@@ -408,6 +409,32 @@ class IrEmitter : public DfsHloVisitorWithDefault,
       HloInstruction* arg, absl::Span<const int64> dimensions,
       unsigned element_alignment);
 
+  // Emits a vectorized reduction over dimensions that are the most minor
+  // dimensions of the operand, so that the elements reduced into an output
+  // element are contiguous.  Helper function for EmitVectorizedReduce.
+  StatusOr<bool> EmitVectorizedReduceOverMinorDimensions(
+      HloInstruction* reduce, HloInstruction* arg, HloInstruction* init_value,
+      absl::Span<const int64> dimensions,
+      const ReductionGenerator& reduction_generator, int vectorization_factor,
+      unsigned element_alignment, string* failure_reason);
+
+  // Adds loops over the dimensions of the output of "reduce" to "loop_nest",
+  // from the most major one to the most minor one, leaving out the
+  // "num_inner_dimensions" most minor ones.  The outer dimensions that are
+  // partitioned across parallel tasks loop within the dynamic loop bounds of
+  // the task.  Returns the multi-index of the loops, with nullptr for the
+  // dimensions left out.
+  std::vector<llvm::Value*> AddLoopsForReduceOutput(
+      const HloInstruction& reduce, int64 num_inner_dimensions,
+      llvm_ir::ForLoopNest* loop_nest);
+
+  // Reduces the elements of the sharded vector "vector" to a scalar. The
+  // shards of the same type are reduced pairwise first, and the lanes of each
+  // remaining vector are then reduced as a tree of shuffles.
+  llvm::Value* EmitHorizontalReduction(
+      const ReductionGenerator& reduction_generator,
+      const ShardedVector& vector);
+
   // Tries to emit a fast concatenate operation using memcpy.  Returns true if
   // successful, and false on failure.  On failure, sets "failure_reason" to a
   // string describing why it could not emit a fast concatenate.
@@ -17,6 +17,10 @@ limitations under the License.
 
 #define EIGEN_USE_THREADS
 
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/compiler/xla/executable_run_options.h"
 #include "tensorflow/core/platform/blocking_counter.h"
@@ -31,9 +35,46 @@ using tensorflow::uint64;
 using ComputeFunctionType = void (*)(void*, const void*, const void**, void**,
                                      int64*, uint64*);
 
-// Dispatches 'num_partitions - 1' calls to 'function_ptr' in parallel.
-// Calls 'function_ptr' for first partition inline.
-// Uses blocking counter to synchronize threads after parallel calls complete.
+namespace {
+
+// The number of fork-joins running concurrently, which share the threads of
+// the intra-op thread pool.
+std::atomic<int32> num_active_fork_joins{0};
+
+// The partitions of a fork-join are claimed one at a time by the calling
+// thread and the workers dispatched to the thread pool. The state is shared
+// with the workers, since a worker which only starts once all the partitions
+// are done may outlive the call.
+struct ForkJoinState {
+  explicit ForkJoinState(int32 num_partitions)
+      : num_partitions(num_partitions), pending(num_partitions) {}
+
+  // Runs the unclaimed partitions until there are none left.
+  template <typename Fn>
+  void RunPartitions(const Fn& run_partition) {
+    for (int32 i = next_partition.fetch_add(1); i < num_partitions;
+         i = next_partition.fetch_add(1)) {
+      run_partition(i);
+      pending.DecrementCount();
+    }
+  }
+
+  const int32 num_partitions;
+  std::atomic<int32> next_partition{0};
+  tensorflow::BlockingCounter pending;
+};
+
+}  // namespace
+
+// Runs the 'num_partitions' calls to 'function_ptr' in parallel, and returns
+// once they are all done.
+//
+// The calling thread runs partitions itself, together with up to
+// 'num_partitions - 1' workers dispatched to the intra-op thread pool, each of
+// which claims the next partition not yet run when it is done with the last.
+// The threads of the pool are divided between the fork-joins running
+// concurrently, so that they do not oversubscribe the pool, and a busy pool
+// only delays the partitions the calling thread does not get to first.
 //
 // The 'partitions' array has a total number of elements equal to
 // 'num_partitions * num_partitioned_dims * 2' (the '2' is necessary to specify
@@ -81,24 +122,31 @@ TF_ATTRIBUTE_NO_SANITIZE_MEMORY void __xla_cpu_runtime_ParallelForkJoin(
   // Compute partition stride in 'partitions' array.
   const int64 stride = 2 * num_partitioned_dims;
 
-  // Dispatch 'num_partitions - 1' compute functions to run in parallel.
-  tensorflow::BlockingCounter bc(num_partitions - 1);
-  for (int32 i = 1; i < num_partitions; ++i) {
-    const int64 offset = i * stride;
-    run_options->intra_op_thread_pool()->enqueueNoNotification(
-        [i, function, result_ptr, run_options_ptr, buffer_table, prof_counters,
-         partitions, offset, &bc]() {
-          function(result_ptr, run_options_ptr, nullptr, buffer_table,
-                   &partitions[offset], prof_counters);
-          bc.DecrementCount();
-          VLOG(3) << "ParallelForkJoin partition " << i << " done.";
-        });
+  auto run_partition = [=](int32 i) {
+    function(result_ptr, run_options_ptr, nullptr, buffer_table,
+             &partitions[i * stride], prof_counters);
+    VLOG(3) << "ParallelForkJoin partition " << i << " done.";
+  };
+
+  const Eigen::ThreadPoolDevice* thread_pool =
+      run_options->intra_op_thread_pool();
+  const int32 num_active = ++num_active_fork_joins;
+  int32 num_threads = thread_pool->numThreads() / num_active;
+  if (thread_pool->currentThreadId() >= 0) {
+    // The calling thread is one of the threads of the pool.
+    --num_threads;
   }
+  const int32 num_workers =
+      std::max(0, std::min(num_threads, num_partitions - 1));
+  VLOG(2) << "ParallelForkJoin num_workers: " << num_workers;
 
-  // Call first compute function inline.
-  function(result_ptr, run_options_ptr, params, buffer_table, &partitions[0],
-           prof_counters);
-  VLOG(3) << "ParallelForkJoin partition 0 done.";
-  bc.Wait();
+  auto state = std::make_shared<ForkJoinState>(num_partitions);
+  for (int32 i = 0; i < num_workers; ++i) {
+    thread_pool->enqueueNoNotification(
+        [state, run_partition]() { state->RunPartitions(run_partition); });
+  }
+  state->RunPartitions(run_partition);
+  state->pending.Wait();
+  --num_active_fork_joins;
   VLOG(2) << "ParallelForkJoin EXIT";
 }
@@ -39,9 +39,7 @@ string DotTestSpecToString(const ::testing::TestParamInfo<DotTestSpec>& info) {
   return PrimitiveType_Name(info.param.primitive_type);
 }
 
-class CpuEigenDotOperationTest
-    : public CpuCodegenTest,
-      public ::testing::WithParamInterface<DotTestSpec> {
+class CpuDotOperationTestBase : public CpuCodegenTest {
  protected:
   void CompileAndCheck(std::unique_ptr<HloComputation> entry_computation,
                        const string& filecheck_lines) {
@@ -60,6 +58,10 @@ class CpuEigenDotOperationTest
   }
 };
 
+class CpuEigenDotOperationTest
+    : public CpuDotOperationTestBase,
+      public ::testing::WithParamInterface<DotTestSpec> {};
+
 TEST_P(CpuEigenDotOperationTest, SimpleDotOp) {
   HloComputation::Builder builder(TestName());
   DotTestSpec spec = GetParam();
@@ -108,6 +110,138 @@ INSTANTIATE_TEST_SUITE_P(CpuEigenDotOperationTestInstantiation,
                          ::testing::ValuesIn(GetDotTestCases()),
                          DotTestSpecToString);
 
+// Tests the choice between the linalg code and the call into Eigen for small
+// GEMMs and convolutions.
+class CpuLinalgDotOperationTest : public CpuDotOperationTestBase {
+ protected:
+  DebugOptions GetDebugOptionsForTest() override {
+    DebugOptions debug_options =
+        CpuDotOperationTestBase::GetDebugOptionsForTest();
+    debug_options.set_xla_cpu_multi_thread_eigen(multi_threaded_eigen_);
+    if (!linalg_matmul_max_size_.empty()) {
+      (*debug_options.mutable_xla_backend_extra_options())
+          ["xla_cpu_linalg_matmul_max_size"] = linalg_matmul_max_size_;
+    }
+    return debug_options;
+  }
+
+  std::unique_ptr<HloComputation> SmallDot() {
+    HloComputation::Builder builder(TestName());
+
+    auto param_shape = ShapeUtil::MakeShape(F32, {16, 16});
+
+    HloInstruction* lhs = builder.AddInstruction(
+        HloInstruction::CreateParameter(0, param_shape, "input"));
+    HloInstruction* rhs = builder.AddInstruction(
+        HloInstruction::CreateParameter(1, param_shape, "input"));
+
+    builder.AddInstruction(CreateCanonicalDot(param_shape, lhs, rhs));
+    return builder.Build();
+  }
+
+  bool multi_threaded_eigen_ = false;
+  string linalg_matmul_max_size_;
+};
+
+TEST_F(CpuLinalgDotOperationTest, SmallDotOpUsesLinalg) {
+  CompileAndCheck(SmallDot(), R"(
+CHECK: define
+CHECK-NOT: EigenMatMulF32
+)");
+}
+
+// Multi-threaded Eigen is kept for small GEMMs unless a size limit is set.
+TEST_F(CpuLinalgDotOperationTest, SmallDotOpUsesMultiThreadedEigen) {
+  multi_threaded_eigen_ = true;
+  CompileAndCheck(SmallDot(), R"(
+CHECK: call void @__xla_cpu_runtime_EigenMatMulF32
+)");
+}
+
+TEST_F(CpuLinalgDotOperationTest, MaxSizeOverridesMultiThreadedEigen) {
+  multi_threaded_eigen_ = true;
+  linalg_matmul_max_size_ = absl::StrCat(16 * 16 * 16);
+  CompileAndCheck(SmallDot(), R"(
+CHECK: define
+CHECK-NOT: EigenMatMulF32
+)");
+}
+
+TEST_F(CpuLinalgDotOperationTest, MaxSizeSendsSmallDotOpToEigen) {
+  linalg_matmul_max_size_ = absl::StrCat(16 * 16 * 16 - 1);
+  CompileAndCheck(SmallDot(), R"(
+CHECK: call void @__xla_cpu_runtime_EigenSingleThreadedMatMulF32
+)");
+}
+
+// The addend is fused into the linalg code for the dot.
+TEST_F(CpuLinalgDotOperationTest, SmallDotAddUsesLinalg) {
+  HloComputation::Builder builder(TestName());
+
+  auto param_shape = ShapeUtil::MakeShape(F32, {16, 16});
+
+  HloInstruction* lhs = builder.AddInstruction(
+      HloInstruction::CreateParameter(0, param_shape, "input"));
+  HloInstruction* rhs = builder.AddInstruction(
+      HloInstruction::CreateParameter(1, param_shape, "input"));
+  HloInstruction* addend = builder.AddInstruction(
+      HloInstruction::CreateParameter(2, param_shape, "addend"));
+
+  HloInstruction* dot =
+      builder.AddInstruction(CreateCanonicalDot(param_shape, lhs, rhs));
+  builder.AddInstruction(
+      HloInstruction::CreateBinary(param_shape, HloOpcode::kAdd, dot, addend));
+  CompileAndCheck(builder.Build(), R"(
+CHECK: define
+CHECK-NOT: EigenMatMulF32
+)");
+}
+
+TEST_F(CpuLinalgDotOperationTest, SmallConvolutionUsesLinalg) {
+  HloComputation::Builder builder(TestName());
+
+  HloInstruction* input = builder.AddInstruction(HloInstruction::CreateParameter(
+      0, ShapeUtil::MakeShape(F32, {1, 8, 8, 4}), "input"));
+  HloInstruction* kernel =
+      builder.AddInstruction(HloInstruction::CreateParameter(
+          1, ShapeUtil::MakeShape(F32, {3, 3, 4, 8}), "kernel"));
+
+  Window window;
+  for (int i = 0; i < 2; ++i) {
+    WindowDimension* dim = window.add_dimensions();
+    dim->set_size(3);
+    dim->set_stride(1);
+    dim->set_window_dilation(1);
+    dim->set_base_dilation(1);
+  }
+
+  ConvolutionDimensionNumbers dnums;
+  dnums.set_input_batch_dimension(0);
+  dnums.add_input_spatial_dimensions(1);
+  dnums.add_input_spatial_dimensions(2);
+  dnums.set_input_feature_dimension(3);
+  dnums.add_kernel_spatial_dimensions(0);
+  dnums.add_kernel_spatial_dimensions(1);
+  dnums.set_kernel_input_feature_dimension(2);
+  dnums.set_kernel_output_feature_dimension(3);
+  dnums.set_output_batch_dimension(0);
+  dnums.add_output_spatial_dimensions(1);
+  dnums.add_output_spatial_dimensions(2);
+  dnums.set_output_feature_dimension(3);
+
+  PrecisionConfig precision_config;
+  precision_config.mutable_operand_precision()->Resize(
+      2, PrecisionConfig::DEFAULT);
+  builder.AddInstruction(HloInstruction::CreateConvolve(
+      ShapeUtil::MakeShape(F32, {1, 6, 6, 8}), input, kernel,
+      /*feature_group_count=*/1, /*batch_group_count=*/1, window, dnums,
+      precision_config));
+  CompileAndCheck(builder.Build(), R"(
+CHECK: define
+CHECK-NOT: EigenSingleThreadedConvF32
+)");
+}
+
 }  // namespace
 }  // namespace cpu
 }  // namespace xla
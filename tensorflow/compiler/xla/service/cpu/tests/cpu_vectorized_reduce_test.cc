@@ -0,0 +1,70 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/cpu/tests/cpu_codegen_test.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace xla {
+namespace cpu {
+namespace {
+
+// Reduces the two most minor dimensions, which are too small for
+// TreeReductionRewriter to rewrite the reduction.
+const char* const kReductionOverMinorDimensionsHlo = R"(
+HloModule ReductionOverMinorDimensions
+
+add {
+  lhs = f32[] parameter(0)
+  rhs = f32[] parameter(1)
+  ROOT add = f32[] add(lhs, rhs)
+}
+
+ENTRY main {
+  input = f32[128,20,20] parameter(0)
+  zero = f32[] constant(0)
+  ROOT reduce = f32[128] reduce(input, zero), dimensions={1,2}, to_apply=add
+}
+)";
+
+class CpuVectorizedReduceTest : public CpuCodegenTest {
+ protected:
+  DebugOptions GetDebugOptionsForTest() override {
+    DebugOptions debug_options = CpuCodegenTest::GetDebugOptionsForTest();
+    debug_options.set_xla_cpu_enable_fast_math(enable_fast_math_);
+    return debug_options;
+  }
+
+  bool enable_fast_math_ = true;
+};
+
+TEST_F(CpuVectorizedReduceTest, ReductionOverMinorDimensionsIsVectorized) {
+  CompileAndVerifyIr(kReductionOverMinorDimensionsHlo, R"(
+CHECK: fadd {{.*}}<{{[0-9]+}} x float>
+CHECK: shufflevector
+CHECK: extractelement
+)");
+}
+
+TEST_F(CpuVectorizedReduceTest,
+       ReductionOverMinorDimensionsWithoutReassociationIsNotVectorized) {
+  enable_fast_math_ = false;
+  CompileAndVerifyIr(kReductionOverMinorDimensionsHlo, R"(
+CHECK-NOT: shufflevector
+)");
+}
+
+}  // namespace
+}  // namespace cpu
+}  // namespace xla
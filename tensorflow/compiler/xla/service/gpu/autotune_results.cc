@@ -0,0 +1,71 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/gpu/autotune_results.h"
+
+#include "absl/strings/str_cat.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/random.h"
+
+namespace xla {
+namespace gpu {
+
+std::string AutotuneDeviceKey(se::StreamExecutor* executor,
+                              absl::string_view library_version) {
+  const se::DeviceDescription& description = executor->GetDeviceDescription();
+  int cc_major = 0, cc_minor = 0;
+  description.cuda_compute_capability(&cc_major, &cc_minor);
+  return absl::StrCat(description.name(), " sm_", cc_major, cc_minor,
+                      " driver ", description.driver_version(), " ",
+                      library_version);
+}
+
+AutotuneResults ReadAutotuneResults(const std::string& path) {
+  AutotuneResults results;
+  tensorflow::Env* env = tensorflow::Env::Default();
+  if (env->FileExists(path).ok()) {
+    const Status status = tensorflow::ReadTextProto(env, path, &results);
+    if (!status.ok()) {
+      LOG(WARNING) << "Ignoring the autotuning results at " << path << ": "
+                   << status;
+      results.Clear();
+    }
+  }
+  return results;
+}
+
+Status UpdateAutotuneResults(
+    const std::string& path,
+    const std::function<void(AutotuneResults*)>& update) {
+  AutotuneResults results = ReadAutotuneResults(path);
+  update(&results);
+  tensorflow::Env* env = tensorflow::Env::Default();
+  const std::string temp_path =
+      absl::StrCat(path, ".tmp", absl::Hex(tensorflow::random::New64()));
+  Status status = tensorflow::WriteTextProto(env, temp_path, results);
+  if (status.ok()) status = env->RenameFile(temp_path, path);
+  if (!status.ok()) {
+    env->DeleteFile(temp_path).IgnoreError();
+    return status;
+  }
+  VLOG(1) << "Saved " << results.gemms_size() << " GEMM and "
+          << results.convs_size() << " convolution autotuning results to "
+          << path;
+  return Status::OK();
+}
+
+}  // namespace gpu
+}  // namespace xla
@@ -0,0 +1,56 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMPILER_XLA_SERVICE_GPU_AUTOTUNE_RESULTS_H_
+#define TENSORFLOW_COMPILER_XLA_SERVICE_GPU_AUTOTUNE_RESULTS_H_
+
+#include <functional>
+#include <string>
+
+#include "absl/strings/string_view.h"
+#include "tensorflow/compiler/xla/service/gpu/gpu_autotuning.pb.h"
+#include "tensorflow/compiler/xla/status.h"
+#include "tensorflow/compiler/xla/statusor.h"
+#include "tensorflow/compiler/xla/types.h"
+#include "tensorflow/core/platform/stream_executor_no_cuda.h"
+
+namespace xla {
+namespace gpu {
+
+// Returns the device key of the autotuning results picked on `executor` with
+// version `library_version` of cuBLAS or cuDNN. Results apply to all devices
+// of the same model and compute capability, with the same driver and library
+// versions.
+std::string AutotuneDeviceKey(se::StreamExecutor* executor,
+                              absl::string_view library_version);
+
+// Reads the text AutotuneResults proto at `path`. A missing file holds no
+// results, and so does a file which can't be read or parsed, with a warning:
+// the results only save autotuning time.
+AutotuneResults ReadAutotuneResults(const std::string& path);
+
+// Reads the results at `path`, lets `update` change them and writes them back.
+// The pickers update the results of their own kind only, so that they can
+// share the file. The file is replaced by renaming a temporary file, so that
+// readers in other processes never see a partial file; concurrent updates
+// from several processes may lose all but the last one.
+Status UpdateAutotuneResults(
+    const std::string& path,
+    const std::function<void(AutotuneResults*)>& update);
+
+}  // namespace gpu
+}  // namespace xla
+
+#endif  // TENSORFLOW_COMPILER_XLA_SERVICE_GPU_AUTOTUNE_RESULTS_H_
@@ -0,0 +1,95 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/gpu/autotune_results.h"
+
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/path.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace xla {
+namespace gpu {
+namespace {
+
+TEST(AutotuneResultsTest, MissingFileHoldsNoResults) {
+  std::string path = tensorflow::io::JoinPath(tensorflow::testing::TmpDir(),
+                                              "missing_autotune_results");
+  AutotuneResults results = ReadAutotuneResults(path);
+  EXPECT_EQ(results.gemms_size(), 0);
+  EXPECT_EQ(results.convs_size(), 0);
+}
+
+TEST(AutotuneResultsTest, MalformedFileHoldsNoResults) {
+  std::string path = tensorflow::io::JoinPath(tensorflow::testing::TmpDir(),
+                                              "malformed_autotune_results");
+  // E.g. a file another process was writing in place.
+  TF_ASSERT_OK(tensorflow::WriteStringToFile(tensorflow::Env::Default(), path,
+                                             "gemms { device: \"gp"));
+  AutotuneResults results = ReadAutotuneResults(path);
+  EXPECT_EQ(results.gemms_size(), 0);
+  EXPECT_EQ(results.convs_size(), 0);
+
+  // Updating the results replaces the malformed file.
+  TF_ASSERT_OK(UpdateAutotuneResults(path, [](AutotuneResults* results) {
+    results->add_gemms()->set_device("gpu");
+  }));
+  results = ReadAutotuneResults(path);
+  ASSERT_EQ(results.gemms_size(), 1);
+  EXPECT_EQ(results.gemms(0).device(), "gpu");
+}
+
+TEST(AutotuneResultsTest, UpdatesLeaveNoTemporaryFiles) {
+  const std::string dir = tensorflow::io::JoinPath(
+      tensorflow::testing::TmpDir(), "autotune_results_dir");
+  tensorflow::Env* env = tensorflow::Env::Default();
+  TF_ASSERT_OK(env->RecursivelyCreateDir(dir));
+  const std::string path = tensorflow::io::JoinPath(dir, "results");
+  for (int i = 0; i < 3; ++i) {
+    TF_ASSERT_OK(UpdateAutotuneResults(path, [](AutotuneResults* results) {
+      results->add_convs()->set_device("gpu");
+    }));
+  }
+  std::vector<std::string> children;
+  TF_ASSERT_OK(env->GetChildren(dir, &children));
+  EXPECT_EQ(children, std::vector<std::string>{"results"});
+  EXPECT_EQ(ReadAutotuneResults(path).convs_size(), 3);
+}
+
+TEST(AutotuneResultsTest, UpdatesKeepResultsOfOtherKinds) {
+  std::string path = tensorflow::io::JoinPath(tensorflow::testing::TmpDir(),
+                                              "autotune_results");
+  TF_ASSERT_OK(UpdateAutotuneResults(path, [](AutotuneResults* results) {
+    GemmAutotuneEntry* gemm = results->add_gemms();
+    gemm->set_device("gpu");
+    gemm->set_algorithm(3);
+  }));
+  TF_ASSERT_OK(UpdateAutotuneResults(path, [](AutotuneResults* results) {
+    results->clear_convs();
+    ConvAutotuneEntry* conv = results->add_convs();
+    conv->set_device("gpu");
+    conv->set_hlo("custom-call");
+  }));
+
+  AutotuneResults results = ReadAutotuneResults(path);
+  ASSERT_EQ(results.gemms_size(), 1);
+  EXPECT_EQ(results.gemms(0).algorithm(), 3);
+  ASSERT_EQ(results.convs_size(), 1);
+  EXPECT_EQ(results.convs(0).hlo(), "custom-call");
+}
+
+}  // namespace
+}  // namespace gpu
+}  // namespace xla
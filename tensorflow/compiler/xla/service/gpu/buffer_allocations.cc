@@ -41,6 +41,11 @@ Status BufferAllocations::TearDown(
   const int64 num_buffers = buffer_assignment->Allocations().size();
   for (BufferAllocation::Index i = 0; i < num_buffers; ++i) {
     const BufferAllocation& allocation = buffer_assignment->GetAllocation(i);
+    // Buffers in host memory are not from the allocator, and are freed by
+    // GpuExecutable.
+    if (allocation.color() != 0) {
+      continue;
+    }
     se::DeviceMemoryBase buffer_address = GetDeviceAddress(allocation.index());
     // Deallocate buffers marked "maybe_live_out" but aren't actually live out,
     // and temp buffers.
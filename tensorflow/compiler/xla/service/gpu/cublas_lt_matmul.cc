@@ -0,0 +1,190 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/gpu/cublas_lt_matmul.h"
+
+#include "absl/container/flat_hash_map.h"
+#include "third_party/gpus/cuda/include/cuda.h"
+#include "tensorflow/compiler/xla/primitive_util.h"
+#include "tensorflow/compiler/xla/statusor.h"
+#include "tensorflow/compiler/xla/util.h"
+#include "tensorflow/core/lib/gtl/cleanup.h"
+#include "tensorflow/core/platform/mutex.h"
+
+#if CUDA_VERSION >= 11000
+#include "third_party/gpus/cuda/include/cublasLt.h"
+#endif
+
+namespace xla {
+namespace gpu {
+
+#if CUDA_VERSION >= 11000
+
+namespace {
+
+// Converts a cuBLAS status to a Status.
+Status CublasStatusToStatus(cublasStatus_t status, const char* what) {
+  if (status == CUBLAS_STATUS_SUCCESS) {
+    return Status::OK();
+  }
+  return InternalError("%s failed with cuBLAS status %d", what,
+                       static_cast<int>(status));
+}
+
+// Returns the cuBLASLt handle of `executor`, creating it on first use. The
+// handles live as long as the process.
+StatusOr<cublasLtHandle_t> GetHandle(se::StreamExecutor* executor) {
+  static tensorflow::mutex mu(tensorflow::LINKER_INITIALIZED);
+  static auto* handles =
+      new absl::flat_hash_map<se::StreamExecutor*, cublasLtHandle_t>();
+  tensorflow::mutex_lock lock(mu);
+  auto it = handles->find(executor);
+  if (it != handles->end()) {
+    return it->second;
+  }
+  cublasLtHandle_t handle;
+  TF_RETURN_IF_ERROR(
+      CublasStatusToStatus(cublasLtCreate(&handle), "cublasLtCreate"));
+  handles->emplace(executor, handle);
+  return handle;
+}
+
+cublasLtEpilogue_t ToCublasLtEpilogue(GemmBackendConfig::Epilogue epilogue) {
+  switch (epilogue) {
+    case GemmBackendConfig::RELU:
+      return CUBLASLT_EPILOGUE_RELU;
+    case GemmBackendConfig::BIAS:
+      return CUBLASLT_EPILOGUE_BIAS;
+    case GemmBackendConfig::BIAS_RELU:
+      return CUBLASLT_EPILOGUE_RELU_BIAS;
+    default:
+      return CUBLASLT_EPILOGUE_DEFAULT;
+  }
+}
+
+}  // namespace
+
+Status RunCublasLtMatmul(PrimitiveType type, const CublasLtMatrix& lhs,
+                         const CublasLtMatrix& rhs,
+                         const CublasLtMatrix& output, double alpha,
+                         GemmBackendConfig::Epilogue epilogue,
+                         se::DeviceMemoryBase bias, se::Stream* stream) {
+  cudaDataType_t data_type;
+  switch (type) {
+    case F16:
+      data_type = CUDA_R_16F;
+      break;
+    case F32:
+      data_type = CUDA_R_32F;
+      break;
+    default:
+      return Unimplemented("cuBLASLt matmuls of %s are not supported",
+                           primitive_util::LowercasePrimitiveTypeName(type));
+  }
+  TF_ASSIGN_OR_RETURN(cublasLtHandle_t handle, GetHandle(stream->parent()));
+
+  // F16 matmuls accumulate and scale in F32, like the cuBLAS gemms.
+  cublasLtMatmulDesc_t matmul_desc;
+  TF_RETURN_IF_ERROR(CublasStatusToStatus(
+      cublasLtMatmulDescCreate(&matmul_desc, CUBLAS_COMPUTE_32F, CUDA_R_32F),
+      "cublasLtMatmulDescCreate"));
+  auto matmul_desc_cleanup = tensorflow::gtl::MakeCleanup(
+      [&] { cublasLtMatmulDescDestroy(matmul_desc); });
+  auto set_attribute = [&](cublasLtMatmulDescAttributes_t attribute,
+                           const void* value, size_t size) {
+    return CublasStatusToStatus(
+        cublasLtMatmulDescSetAttribute(matmul_desc, attribute, value, size),
+        "cublasLtMatmulDescSetAttribute");
+  };
+  cublasOperation_t lhs_op = lhs.transpose ? CUBLAS_OP_T : CUBLAS_OP_N;
+  cublasOperation_t rhs_op = rhs.transpose ? CUBLAS_OP_T : CUBLAS_OP_N;
+  cublasLtEpilogue_t lt_epilogue = ToCublasLtEpilogue(epilogue);
+  TF_RETURN_IF_ERROR(
+      set_attribute(CUBLASLT_MATMUL_DESC_TRANSA, &lhs_op, sizeof(lhs_op)));
+  TF_RETURN_IF_ERROR(
+      set_attribute(CUBLASLT_MATMUL_DESC_TRANSB, &rhs_op, sizeof(rhs_op)));
+  TF_RETURN_IF_ERROR(set_attribute(CUBLASLT_MATMUL_DESC_EPILOGUE, &lt_epilogue,
+                                   sizeof(lt_epilogue)));
+  if (epilogue == GemmBackendConfig::BIAS ||
+      epilogue == GemmBackendConfig::BIAS_RELU) {
+    const void* bias_pointer = bias.opaque();
+    TF_RETURN_IF_ERROR(set_attribute(CUBLASLT_MATMUL_DESC_BIAS_POINTER,
+                                     &bias_pointer, sizeof(bias_pointer)));
+  }
+
+  cublasLtMatrixLayout_t layouts[3] = {nullptr, nullptr, nullptr};
+  auto layouts_cleanup = tensorflow::gtl::MakeCleanup([&] {
+    for (cublasLtMatrixLayout_t layout : layouts) {
+      if (layout != nullptr) cublasLtMatrixLayoutDestroy(layout);
+    }
+  });
+  const CublasLtMatrix* matrices[3] = {&lhs, &rhs, &output};
+  for (int i = 0; i < 3; ++i) {
+    TF_RETURN_IF_ERROR(CublasStatusToStatus(
+        cublasLtMatrixLayoutCreate(&layouts[i], data_type,
+                                   matrices[i]->num_rows, matrices[i]->num_cols,
+                                   /*ld=*/matrices[i]->num_rows),
+        "cublasLtMatrixLayoutCreate"));
+  }
+
+  // The matmul runs without a workspace, so the heuristic only returns
+  // algorithms that need none.
+  cublasLtMatmulPreference_t preference;
+  TF_RETURN_IF_ERROR(
+      CublasStatusToStatus(cublasLtMatmulPreferenceCreate(&preference),
+                           "cublasLtMatmulPreferenceCreate"));
+  auto preference_cleanup = tensorflow::gtl::MakeCleanup(
+      [&] { cublasLtMatmulPreferenceDestroy(preference); });
+  cublasLtMatmulHeuristicResult_t heuristic;
+  int num_algorithms = 0;
+  TF_RETURN_IF_ERROR(CublasStatusToStatus(
+      cublasLtMatmulAlgoGetHeuristic(handle, matmul_desc, layouts[0],
+                                     layouts[1], layouts[2], layouts[2],
+                                     preference, /*requestedAlgoCount=*/1,
+                                     &heuristic, &num_algorithms),
+      "cublasLtMatmulAlgoGetHeuristic"));
+  if (num_algorithms == 0) {
+    return Unimplemented("cuBLASLt has no algorithm for this matmul");
+  }
+
+  // StreamExecutor really should just expose the Cuda stream to clients...
+  const cudaStream_t* cuda_stream =
+      CHECK_NOTNULL(reinterpret_cast<const cudaStream_t*>(
+          stream->implementation()->GpuStreamMemberHack()));
+  const float alpha_value = static_cast<float>(alpha);
+  const float beta_value = 0;
+  return CublasStatusToStatus(
+      cublasLtMatmul(handle, matmul_desc, &alpha_value, lhs.data.opaque(),
+                     layouts[0], rhs.data.opaque(), layouts[1], &beta_value,
+                     output.data.opaque(), layouts[2], output.data.opaque(),
+                     layouts[2], &heuristic.algo, /*workspace=*/nullptr,
+                     /*workspaceSizeInBytes=*/0, *cuda_stream),
+      "cublasLtMatmul");
+}
+
+#else  // CUDA_VERSION >= 11000
+
+Status RunCublasLtMatmul(PrimitiveType type, const CublasLtMatrix& lhs,
+                         const CublasLtMatrix& rhs,
+                         const CublasLtMatrix& output, double alpha,
+                         GemmBackendConfig::Epilogue epilogue,
+                         se::DeviceMemoryBase bias, se::Stream* stream) {
+  return Unimplemented("cuBLASLt matmuls require CUDA 11");
+}
+
+#endif  // CUDA_VERSION >= 11000
+
+}  // namespace gpu
+}  // namespace xla
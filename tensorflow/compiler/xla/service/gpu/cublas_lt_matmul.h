@@ -0,0 +1,51 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMPILER_XLA_SERVICE_GPU_CUBLAS_LT_MATMUL_H_
+#define TENSORFLOW_COMPILER_XLA_SERVICE_GPU_CUBLAS_LT_MATMUL_H_
+
+#include "tensorflow/compiler/xla/service/gpu/backend_configs.pb.h"
+#include "tensorflow/compiler/xla/status.h"
+#include "tensorflow/compiler/xla/types.h"
+#include "tensorflow/compiler/xla/xla_data.pb.h"
+#include "tensorflow/core/platform/stream_executor_no_cuda.h"
+
+namespace xla {
+namespace gpu {
+
+// A column-major matrix operand of a cuBLASLt matmul.
+struct CublasLtMatrix {
+  se::DeviceMemoryBase data;
+  bool transpose;  // Whether the matmul uses the transpose of this matrix.
+  int64 num_rows;
+  int64 num_cols;
+};
+
+// Computes "output = epilogue(alpha * op(lhs) x op(rhs))" on `stream` through
+// cuBLASLt. For the BIAS and BIAS_RELU epilogues, `bias` holds one element per
+// row of `output`, which is added to every column of the product.
+//
+// Only F16 and F32 are supported, and only on CUDA 11 or newer; otherwise an
+// error is returned.
+Status RunCublasLtMatmul(PrimitiveType type, const CublasLtMatrix& lhs,
+                         const CublasLtMatrix& rhs,
+                         const CublasLtMatrix& output, double alpha,
+                         GemmBackendConfig::Epilogue epilogue,
+                         se::DeviceMemoryBase bias, se::Stream* stream);
+
+}  // namespace gpu
+}  // namespace xla
+
+#endif  // TENSORFLOW_COMPILER_XLA_SERVICE_GPU_CUBLAS_LT_MATMUL_H_
@@ -129,8 +129,9 @@ double GetMergedBytesTransferred(HloInstruction* fusion) {
 // Accumulates and reports stats on successful/failed merge attempts.
 class FusionInstructionMerger {
  public:
-  explicit FusionInstructionMerger(HloComputation* computation)
-      : computation_(computation) {}
+  FusionInstructionMerger(HloComputation* computation,
+                          const GpuPerformanceModel* performance_model)
+      : computation_(computation), performance_model_(performance_model) {}
 
   Status Run();
 
@@ -140,6 +141,8 @@ class FusionInstructionMerger {
   Status HandleFusion(HloInstruction* fusion);
 
   HloComputation* computation_;
+  // Decides whether merging pays off, if not null.
+  const GpuPerformanceModel* performance_model_;
   bool changed_ = false;
 
   // Fusion instruction merge stats.
@@ -152,6 +155,7 @@ class FusionInstructionMerger {
   int num_fail_net_bytes_transferred_ratio_ = 0;
   int num_fail_inefficient_fusion_emitter_ = 0;
   int num_fail_fusion_too_large_ = 0;
+  int num_fail_slower_if_merged_ = 0;
 
   TF_DISALLOW_COPY_AND_ASSIGN(FusionInstructionMerger);
 };
@@ -174,7 +178,8 @@ Status FusionInstructionMerger::Run() {
           << " net_bytes_transferred: " << num_fail_net_bytes_transferred_ratio_
           << " inefficient_fusion_emitter: "
           << num_fail_inefficient_fusion_emitter_
-          << " fusion_too_large: " << num_fail_fusion_too_large_ << " }";
+          << " fusion_too_large: " << num_fail_fusion_too_large_
+          << " slower_if_merged: " << num_fail_slower_if_merged_ << " }";
   return Status::OK();
 }
 
@@ -213,12 +218,13 @@ Status FusionInstructionMerger::HandleFusion(HloInstruction* fusion) {
   // Skip 'fusion' instruction if merging it into all users would result in a
   // net increase in bytes transferred (currently allowing the net bytes
   // transferred to be exceeded up to ~10% in exchange for eliminating the
-  // overhead from a GPU kernel launch).
+  // overhead from a GPU kernel launch). The performance model, if any, weighs
+  // this below instead.
   const double current_bytes_transferred = GetCurrentBytesTransferred(fusion);
   const double merged_bytes_transferred = GetMergedBytesTransferred(fusion);
   const double merged_to_current_bytes_ratio =
       merged_bytes_transferred / std::max(1.0, current_bytes_transferred);
-  if (merged_to_current_bytes_ratio > 1.10) {
+  if (performance_model_ == nullptr && merged_to_current_bytes_ratio > 1.10) {
     VLOG(3) << "Not merging " << fusion->name()
             << ": merged-to-current-bytes-ratio of "
             << merged_to_current_bytes_ratio << " is not favorable.";
@@ -243,7 +249,7 @@ Status FusionInstructionMerger::HandleFusion(HloInstruction* fusion) {
   bool allow_expensive_ops =
       merged_to_current_bytes_ratio < 0.3 && current_bytes_transferred > 1024;
 
-  if (!allow_expensive_ops &&
+  if (performance_model_ == nullptr && !allow_expensive_ops &&
       absl::c_any_of(fusion->fused_instructions(),
                      [](const HloInstruction* instruction) {
                        return instruction->opcode() != HloOpcode::kParameter &&
@@ -283,6 +289,22 @@ Status FusionInstructionMerger::HandleFusion(HloInstruction* fusion) {
     return Status::OK();
   }
 
+  // Skip 'fusion' instruction if the performance model estimates that it and
+  // its users would take longer to run merged, because of the recomputation
+  // of 'fusion' in each of them.
+  if (performance_model_ != nullptr) {
+    const GpuPerformanceModel::RunTimes run_times =
+        performance_model_->EstimateRunTimes(fusion, fusion->users());
+    if (run_times.time_fused > run_times.time_unfused) {
+      VLOG(3) << "Not merging " << fusion->name() << ": estimated to run in "
+              << absl::FormatDuration(run_times.time_fused)
+              << " merged instead of "
+              << absl::FormatDuration(run_times.time_unfused);
+      ++num_fail_slower_if_merged_;
+      return Status::OK();
+    }
+  }
+
   // Merge fused instructions from 'fusion' into each user.
   std::vector<HloInstruction*> users = fusion->users();
   for (HloInstruction* user : users) {
@@ -311,7 +333,9 @@ StatusOr<bool> FusionMerger::Run(HloModule* module) {
             << computation->name();
     XLA_VLOG_LINES(3, computation->ToString());
 
-    FusionInstructionMerger fusion_merger(computation);
+    FusionInstructionMerger fusion_merger(
+        computation,
+        performance_model_.has_value() ? &*performance_model_ : nullptr);
     TF_RETURN_IF_ERROR(fusion_merger.Run());
     changed |= fusion_merger.changed();
 
@@ -16,6 +16,8 @@ limitations under the License.
 #ifndef TENSORFLOW_COMPILER_XLA_SERVICE_GPU_FUSION_MERGER_H_
 #define TENSORFLOW_COMPILER_XLA_SERVICE_GPU_FUSION_MERGER_H_
 
+#include "absl/types/optional.h"
+#include "tensorflow/compiler/xla/service/gpu/gpu_performance_model.h"
 #include "tensorflow/compiler/xla/service/hlo_module.h"
 #include "tensorflow/compiler/xla/service/hlo_pass_interface.h"
 
@@ -32,11 +34,21 @@ namespace gpu {
 // 2) The result of merging the fusion instruction into its users would not
 //    increase bytes transferred.
 //
+// Given a performance model, the two conditions are replaced by the run time
+// the model estimates for the fusion instruction and its users not increasing
+// when they are merged.
 class FusionMerger : public HloModulePass {
  public:
+  explicit FusionMerger(
+      absl::optional<GpuPerformanceModel> performance_model = absl::nullopt)
+      : performance_model_(std::move(performance_model)) {}
+
   absl::string_view name() const override { return "fusion_merger"; }
 
   StatusOr<bool> Run(HloModule* module) override;
+
+ private:
+  absl::optional<GpuPerformanceModel> performance_model_;
 };
 
 }  // namespace gpu
@@ -19,9 +19,11 @@ limitations under the License.
 
 #include "absl/types/span.h"
 #include "tensorflow/compiler/xla/service/gpu/gpu_fusible.h"
+#include "tensorflow/compiler/xla/service/gpu/gpu_performance_model.h"
 #include "tensorflow/compiler/xla/service/gpu/instruction_fusion.h"
 #include "tensorflow/compiler/xla/service/hlo_matchers.h"
 #include "tensorflow/compiler/xla/service/hlo_parser.h"
+#include "tensorflow/compiler/xla/shape_util.h"
 #include "tensorflow/compiler/xla/test_helpers.h"
 #include "tensorflow/compiler/xla/tests/hlo_test_base.h"
 
@@ -398,6 +400,45 @@ TEST_F(FusionMergerTest, WillMergeExpensiveFusionsIfSavesMemory) {
   EXPECT_TRUE(FusionMerger().Run(module.get()).ValueOrDie());
 }
 
+TEST_F(FusionMergerTest, PerformanceModelRejectsCostlyRecomputation) {
+  // Merging f1 recomputes each of its exponentials 16384 times in f2, which
+  // does not pay off on a device slow at transcendentals.
+  const char* hlo = R"(
+    HloModule m
+
+    %f_a (p: f32[1024]) -> f32[1024] {
+      %p = f32[1024] parameter(0)
+      ROOT %e = f32[1024] exponential(%p)
+    }
+
+    %f_b (p: f32[1024]) -> f32[1024,1024,16] {
+      %p = f32[1024] parameter(0)
+      ROOT %b = f32[1024,1024,16] broadcast(%p), dimensions={1}
+    }
+
+    ENTRY entry {
+      p0 = f32[1024] parameter(0)
+      f1 = f32[1024] fusion(p0), kind=kLoop, calls=%f_a
+      ROOT f2 = f32[1024,1024,16] fusion(f1), kind=kLoop, calls=%f_b
+    })";
+  auto shape_size = [](const Shape& shape) {
+    return ShapeUtil::ByteSizeOf(shape, 8);
+  };
+  GpuPerformanceModel::DeviceProperties slow_device;
+  slow_device.transcendentals_per_second = 1e9;
+  auto module = ParseAndReturnVerifiedModule(hlo).ValueOrDie();
+  EXPECT_FALSE(FusionMerger(GpuPerformanceModel(slow_device, shape_size))
+                   .Run(module.get())
+                   .ValueOrDie());
+
+  module = ParseAndReturnVerifiedModule(hlo).ValueOrDie();
+  EXPECT_TRUE(FusionMerger(GpuPerformanceModel(
+                               GpuPerformanceModel::DeviceProperties(),
+                               shape_size))
+                  .Run(module.get())
+                  .ValueOrDie());
+}
+
 }  // namespace
 }  // namespace gpu
 }  // namespace xla
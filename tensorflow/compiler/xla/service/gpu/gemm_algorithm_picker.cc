@@ -16,10 +16,15 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/gpu/gemm_algorithm_picker.h"
 
 #include <limits>
+#include <string>
 
+#include "absl/container/flat_hash_set.h"
+#include "absl/strings/str_cat.h"
+#include "tensorflow/compiler/xla/service/gpu/autotune_results.h"
 #include "tensorflow/compiler/xla/service/gpu/backend_configs.pb.h"
 #include "tensorflow/compiler/xla/service/gpu/buffer_comparator.h"
 #include "tensorflow/compiler/xla/service/gpu/gemm_thunk.h"
+#include "tensorflow/compiler/xla/service/gpu/gpu_autotuning.pb.h"
 #include "tensorflow/compiler/xla/service/gpu/ir_emission_utils.h"
 #include "tensorflow/compiler/xla/service/gpu/stream_executor_util.h"
 #include "tensorflow/compiler/xla/service/hlo_computation.h"
@@ -41,8 +46,9 @@ namespace gpu {
 
 using tensorflow::AutotuneResult;
 
-using GemmCacheKey =
-    std::tuple<se::StreamExecutor*, Shape, Shape, Shape, std::string>;
+// The device key, the shapes of the operands and of the result, and the
+// serialized backend config of the gemm.
+using GemmCacheKey = std::tuple<std::string, Shape, Shape, Shape, std::string>;
 
 static tensorflow::mutex autotune_cache_mu(tensorflow::LINKER_INITIALIZED);
 static auto& autotune_cache TF_GUARDED_BY(autotune_cache_mu) =
@@ -50,6 +56,71 @@ static auto& autotune_cache TF_GUARDED_BY(autotune_cache_mu) =
                              absl::optional<se::blas::AlgorithmType>>();
 static int64 cache_hits TF_GUARDED_BY(autotune_cache_mu) = 0;
 static int64 cache_misses TF_GUARDED_BY(autotune_cache_mu) = 0;
+// Whether gemms were autotuned since the cache was last saved.
+static bool cache_changed TF_GUARDED_BY(autotune_cache_mu) = false;
+// The files results were loaded from into the cache.
+static auto& loaded_results_paths TF_GUARDED_BY(autotune_cache_mu) =
+    *new absl::flat_hash_set<std::string>();
+
+static std::string GemmDeviceKey(se::StreamExecutor* executor) {
+  std::string blas_version;
+  if (auto* blas = executor->AsBlas()) {
+    (void)blas->GetVersion(&blas_version);
+  }
+  return AutotuneDeviceKey(executor, absl::StrCat("cuBLAS ", blas_version));
+}
+
+// Adds the results saved at `path` to the cache, unless they were added
+// already.
+static void LoadGemmAutotuneResults(const std::string& path)
+    TF_EXCLUSIVE_LOCKS_REQUIRED(autotune_cache_mu) {
+  if (!loaded_results_paths.insert(path).second) {
+    return;
+  }
+  const AutotuneResults results = ReadAutotuneResults(path);
+  for (const GemmAutotuneEntry& entry : results.gemms()) {
+    absl::optional<se::blas::AlgorithmType> algorithm;
+    if (entry.result_case() == GemmAutotuneEntry::kAlgorithm) {
+      algorithm = entry.algorithm();
+    }
+    autotune_cache.emplace(
+        std::make_tuple(entry.device(), Shape(entry.lhs_shape()),
+                        Shape(entry.rhs_shape()), Shape(entry.output_shape()),
+                        entry.backend_config().SerializeAsString()),
+        algorithm);
+  }
+  VLOG(1) << "Loaded " << results.gemms_size()
+          << " GEMM autotuning results from " << path;
+}
+
+// Saves all the results in the cache to `path`, including those loaded from
+// it. Failing to save them only costs autotuning time later, so it doesn't
+// fail the compilation.
+static void SaveGemmAutotuneResults(const std::string& path)
+    TF_EXCLUSIVE_LOCKS_REQUIRED(autotune_cache_mu) {
+  Status status = UpdateAutotuneResults(path, [](AutotuneResults* results) {
+    results->clear_gemms();
+    for (const auto& key_and_algorithm : autotune_cache) {
+      const GemmCacheKey& key = key_and_algorithm.first;
+      GemmAutotuneEntry* entry = results->add_gemms();
+      entry->set_device(std::get<0>(key));
+      *entry->mutable_lhs_shape() = std::get<1>(key).ToProto();
+      *entry->mutable_rhs_shape() = std::get<2>(key).ToProto();
+      *entry->mutable_output_shape() = std::get<3>(key).ToProto();
+      CHECK(entry->mutable_backend_config()->ParseFromString(
+          std::get<4>(key)));
+      if (key_and_algorithm.second.has_value()) {
+        entry->set_algorithm(*key_and_algorithm.second);
+      }
+    }
+  });
+  if (!status.ok()) {
+    LOG(WARNING) << "Could not save the GEMM autotuning results to " << path
+                 << ": " << status;
+    return;
+  }
+  cache_changed = false;
+}
 
 // Experimentally tries to pick the best algorithm for the given gemm.
 //
@@ -130,7 +201,7 @@ static StatusOr<absl::optional<se::blas::AlgorithmType>> DoUncachedGemmAutotune(
     // non-null ProfileResult, DoGemmWithAlgorithm should always return true,
     // and the actual success-ness is returned in ProfileResult::is_valid.
     CHECK(RunGemm(gemm, backend_config, lhs_buffer, rhs_buffer, output_buffer,
-                  stream,
+                  /*bias_buffer=*/se::DeviceMemoryBase(), stream,
                   /*implements_whole_instruction=*/true,
                   /*profile_index=*/-1,
                   /*profiler=*/nullptr,
@@ -238,8 +309,9 @@ static StatusOr<absl::optional<se::blas::AlgorithmType>> DoGemmAutotune(
 
 
   GemmCacheKey key =
-      std::make_tuple(stream->parent(), lhs->shape(), rhs->shape(),
-                      instr->shape(), gemm_config.SerializeAsString());
+      std::make_tuple(GemmDeviceKey(stream->parent()), lhs->shape(),
+                      rhs->shape(), instr->shape(),
+                      gemm_config.SerializeAsString());
 
   tensorflow::mutex_lock cache_lock(autotune_cache_mu);
   auto it = autotune_cache.find(key);
@@ -271,6 +343,7 @@ static StatusOr<absl::optional<se::blas::AlgorithmType>> DoGemmAutotune(
   }
 
   CHECK(autotune_cache.emplace(key, result).second);
+  cache_changed = true;
   return result;
 }
 
@@ -285,6 +358,10 @@ static StatusOr<bool> RunOnInstruction(HloInstruction* instr,
 
   GemmBackendConfig gemm_config =
       instr->backend_config<GemmBackendConfig>().ValueOrDie();
+  // cuBLASLt picks the algorithms of gemms with epilogues itself.
+  if (gemm_config.epilogue() != GemmBackendConfig::DEFAULT) {
+    return false;
+  }
 
   TF_ASSIGN_OR_RETURN(absl::optional<se::blas::AlgorithmType> gemm_algorithm,
                       DoGemmAutotune(instr, gemm_config, allocator, stream));
@@ -320,12 +397,26 @@ StatusOr<bool> GemmAlgorithmPicker::Run(HloModule* module) {
     return false;
   }
 
+  const std::string& results_path =
+      module->config().debug_options().xla_gpu_autotune_results_path();
+  if (!results_path.empty()) {
+    tensorflow::mutex_lock cache_lock(autotune_cache_mu);
+    LoadGemmAutotuneResults(results_path);
+  }
+
   bool changed = false;
   for (HloComputation* computation : module->MakeNonfusionComputations()) {
     TF_ASSIGN_OR_RETURN(
         bool result, RunOnComputation(computation, stream_exec_, allocator_));
     changed |= result;
   }
+
+  if (!results_path.empty()) {
+    tensorflow::mutex_lock cache_lock(autotune_cache_mu);
+    if (cache_changed) {
+      SaveGemmAutotuneResults(results_path);
+    }
+  }
   return changed;
 }
 
@@ -27,6 +27,9 @@ limitations under the License.
 namespace xla {
 namespace gpu {
 
+// Picks the fastest cuBLAS algorithm for each gemm. The results are cached per
+// device model and cuBLAS version, and persisted across processes in the file
+// named by xla_gpu_autotune_results_path, if set.
 class GemmAlgorithmPicker : public HloModulePass {
  public:
   GemmAlgorithmPicker(se::StreamExecutor* stream_exec,
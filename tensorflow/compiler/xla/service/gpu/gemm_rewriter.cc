@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/compiler/xla/service/gpu/gemm_rewriter.h"
 
+#include "tensorflow/compiler/xla/layout_util.h"
 #include "tensorflow/compiler/xla/service/dfs_hlo_visitor_with_default.h"
 #include "tensorflow/compiler/xla/service/gpu/backend_configs.pb.h"
 #include "tensorflow/compiler/xla/service/gpu/ir_emission_utils.h"
@@ -44,8 +45,17 @@ namespace m = match;
 // and provided C has no other users).
 // We then guide the buffer assignment to alias the buffer of the custom call
 // and C.
+//
+// When cuBLASLt is enabled, (kAdd (kCustomCall:gemm A B) (kBroadcast bias)) is
+// rather rewritten into (kCustomCall:gemm A B bias) with a BIAS epilogue,
+// provided bias is a vector along the minor-most dimension of the output, and
+// (kMaximum (kCustomCall:gemm ...) (kBroadcast 0)) folds a relu into the
+// epilogue of the gemm.
 class GemmRewriterVisitor : public DfsHloRewriteVisitor {
  public:
+  explicit GemmRewriterVisitor(bool enable_cublaslt)
+      : enable_cublaslt_(enable_cublaslt) {}
+
   Status HandleDot(HloInstruction *instr) override {
     if (IsMatrixMultiplication(*instr)) {
       CHECK(!instr->IsRank2Transpose());
@@ -97,7 +107,33 @@ class GemmRewriterVisitor : public DfsHloRewriteVisitor {
   }
 
   Status HandleAdd(HloInstruction *instr) override {
-    HloInstruction *bias, *existing_gemm;
+    HloInstruction *bias, *existing_gemm, *broadcast;
+    if (enable_cublaslt_ &&
+        Match(instr,
+              m::AddAnyOrder(
+                  m::Op(&existing_gemm).WithCustomCallTarget(kGemmCallTarget),
+                  m::Broadcast(&broadcast, m::Op(&bias))))) {
+      TF_ASSIGN_OR_RETURN(auto config,
+                          existing_gemm->backend_config<GemmBackendConfig>());
+      if (config.beta() == 0 &&
+          config.epilogue() == GemmBackendConfig::DEFAULT &&
+          existing_gemm->user_count() == 1 &&
+          CanUseEpilogue(*existing_gemm, config) &&
+          bias->shape().rank() == 1 &&
+          broadcast->dimensions(0) ==
+              LayoutUtil::Minor(existing_gemm->shape().layout(), 0)) {
+        config.set_epilogue(GemmBackendConfig::BIAS);
+        CHECK_EQ(existing_gemm->operand_count(), 2);
+        std::unique_ptr<HloInstruction> gemm_call =
+            HloInstruction::CreateCustomCall(
+                instr->shape(),
+                {existing_gemm->mutable_operand(0),
+                 existing_gemm->mutable_operand(1), bias},
+                kGemmCallTarget);
+        TF_RETURN_IF_ERROR(gemm_call->set_backend_config(config));
+        return ReplaceWithNewInstruction(instr, std::move(gemm_call));
+      }
+    }
     if (Match(instr,
               m::AddAnyOrder(
                   m::Op(&existing_gemm).WithCustomCallTarget(kGemmCallTarget),
@@ -122,18 +158,58 @@ class GemmRewriterVisitor : public DfsHloRewriteVisitor {
     }
     return Status::OK();
   }
+
+  Status HandleMaximum(HloInstruction *instr) override {
+    HloInstruction *existing_gemm;
+    if (enable_cublaslt_ &&
+        Match(instr,
+              m::MaximumAnyOrder(
+                  m::Op(&existing_gemm).WithCustomCallTarget(kGemmCallTarget),
+                  m::Broadcast(m::ConstantScalar(0))))) {
+      TF_ASSIGN_OR_RETURN(auto config,
+                          existing_gemm->backend_config<GemmBackendConfig>());
+      GemmBackendConfig::Epilogue epilogue = config.epilogue();
+      if (config.beta() == 0 && existing_gemm->user_count() == 1 &&
+          CanUseEpilogue(*existing_gemm, config) &&
+          (epilogue == GemmBackendConfig::DEFAULT ||
+           epilogue == GemmBackendConfig::BIAS)) {
+        config.set_epilogue(epilogue == GemmBackendConfig::BIAS
+                                ? GemmBackendConfig::BIAS_RELU
+                                : GemmBackendConfig::RELU);
+        TF_RETURN_IF_ERROR(existing_gemm->set_backend_config(config));
+        TF_RETURN_IF_ERROR(ReplaceInstruction(instr, existing_gemm));
+      }
+    }
+    return Status::OK();
+  }
+
+ private:
+  // Returns whether cuBLASLt can run `gemm` with an epilogue: it must be a
+  // single real F16 or F32 matrix product.
+  static bool CanUseEpilogue(const HloInstruction &gemm,
+                             const GemmBackendConfig &config) {
+    PrimitiveType type = gemm.shape().element_type();
+    return (type == F16 || type == F32) && gemm.shape().rank() == 2 &&
+           config.batch_size() == 1 && config.alpha_imag() == 0;
+  }
+
+  bool enable_cublaslt_;
 };
 
-static StatusOr<bool> RunOnComputation(HloComputation *computation) {
-  GemmRewriterVisitor visitor;
+static StatusOr<bool> RunOnComputation(HloComputation *computation,
+                                       bool enable_cublaslt) {
+  GemmRewriterVisitor visitor(enable_cublaslt);
   TF_RETURN_IF_ERROR(computation->Accept(&visitor));
   return visitor.changed();
 }
 
 StatusOr<bool> GemmRewriter::Run(HloModule *module) {
   bool changed = false;
+  const bool enable_cublaslt =
+      module->config().debug_options().xla_gpu_enable_cublaslt();
   for (HloComputation *computation : module->MakeNonfusionComputations()) {
-    TF_ASSIGN_OR_RETURN(bool result, RunOnComputation(computation));
+    TF_ASSIGN_OR_RETURN(bool result,
+                        RunOnComputation(computation, enable_cublaslt));
     changed |= result;
   }
   return changed;
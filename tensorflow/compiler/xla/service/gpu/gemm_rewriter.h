@@ -40,6 +40,9 @@ namespace gpu {
 // (we assume transposes are already folded), and rewrites it into a custom call
 // where (A, B, C) are three operands respectively, and `alpha` and `beta` are
 // stored in the backend config.
+//
+// With xla_gpu_enable_cublaslt, the pass also folds the add of a broadcast bias
+// vector and a following relu into the gemm, as a cuBLASLt epilogue.
 class GemmRewriter : public HloModulePass {
  public:
   absl::string_view name() const override { return "cublas-gemm-rewriter"; }
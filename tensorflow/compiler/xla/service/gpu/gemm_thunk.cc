@@ -30,6 +30,10 @@ limitations under the License.
 #include "tensorflow/stream_executor/blas.h"
 #include "tensorflow/stream_executor/device_memory.h"
 
+#if GOOGLE_CUDA
+#include "tensorflow/compiler/xla/service/gpu/cublas_lt_matmul.h"
+#endif
+
 namespace xla {
 namespace gpu {
 
@@ -38,12 +42,14 @@ GemmThunk::GemmThunk(ThunkInfo thunk_info,
                      const BufferAllocation::Slice &rhs_buffer,
                      const BufferAllocation::Slice &output_buffer,
                      bool implements_whole_instruction,
-                     const GemmBackendConfig &backend_config)
+                     const GemmBackendConfig &backend_config,
+                     const BufferAllocation::Slice &bias_buffer)
     : Thunk(Kind::kGemm, thunk_info),
       hlo_instruction_(thunk_info.hlo_instruction),
       lhs_buffer_(lhs_buffer),
       rhs_buffer_(rhs_buffer),
       output_buffer_(output_buffer),
+      bias_buffer_(bias_buffer),
       implements_whole_instruction_(implements_whole_instruction),
       backend_config_(backend_config) {}
 
@@ -56,9 +62,14 @@ Status GemmThunk::ExecuteOnStream(const ExecuteParams &params) {
   se::DeviceMemoryBase lhs_data = get_device_address(lhs_buffer_);
   se::DeviceMemoryBase rhs_data = get_device_address(rhs_buffer_);
   se::DeviceMemoryBase output_data = get_device_address(output_buffer_);
+  se::DeviceMemoryBase bias_data;
+  if (bias_buffer_.allocation() != nullptr) {
+    bias_data = get_device_address(bias_buffer_);
+  }
   return RunGemm(hlo_instruction_, backend_config_, lhs_data, rhs_data,
-                 output_data, params.stream, implements_whole_instruction_,
-                 profile_index(), params.profiler);
+                 output_data, bias_data, params.stream,
+                 implements_whole_instruction_, profile_index(),
+                 params.profiler);
 }
 
 // This struct contains the metadata of a matrix, e.g., its base address and
@@ -163,7 +174,8 @@ static bool DoGemmWithAlgorithm(
 Status RunGemm(const HloInstruction *gemm,
                const GemmBackendConfig &backend_config,
                se::DeviceMemoryBase lhs_buffer, se::DeviceMemoryBase rhs_buffer,
-               se::DeviceMemoryBase output_buffer, se::Stream *stream,
+               se::DeviceMemoryBase output_buffer,
+               se::DeviceMemoryBase bias_buffer, se::Stream *stream,
                bool implements_whole_instruction,
                absl::optional<int64> profile_index,
                HloExecutionProfiler *profiler,
@@ -256,6 +268,24 @@ Status RunGemm(const HloInstruction *gemm,
 
   const MatrixDescriptor output_matrix{output_buffer, /*needs_transpose=*/false,
                                        output_num_rows, output_num_cols};
+
+  if (backend_config.epilogue() != GemmBackendConfig::DEFAULT) {
+#if GOOGLE_CUDA
+    CHECK_EQ(batch_size, 1);
+    auto to_lt_matrix = [](const MatrixDescriptor &matrix) {
+      return CublasLtMatrix{matrix.data, matrix.transpose, matrix.num_rows,
+                            matrix.num_cols};
+    };
+    CHECK_EQ(backend_config.alpha_imag(), 0);
+    return RunCublasLtMatmul(output_shape.element_type(),
+                             to_lt_matrix(lhs_matrix), to_lt_matrix(rhs_matrix),
+                             to_lt_matrix(output_matrix),
+                             backend_config.alpha_real(),
+                             backend_config.epilogue(), bias_buffer, stream);
+#else
+    return Unimplemented("Gemm epilogues are only supported through cuBLASLt");
+#endif
+  }
   auto best_algorithm = [&]() -> absl::optional<se::blas::AlgorithmType> {
     if (algorithm) {
       return *algorithm;
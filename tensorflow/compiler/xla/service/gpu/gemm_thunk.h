@@ -39,11 +39,14 @@ class GemmThunk : public Thunk {
  public:
   // Constructs a thunk that computes "output = (lhs <dot> rhs) * alpha" using
   // BLAS gemm (alpha is stored in the instruction GemmBackendConfig).
+  // `bias_buffer` holds the bias vector of the BIAS and BIAS_RELU epilogues
+  // and is unused otherwise.
   GemmThunk(ThunkInfo thunk_info, const BufferAllocation::Slice& lhs_buffer,
             const BufferAllocation::Slice& rhs_buffer,
             const BufferAllocation::Slice& output_buffer,
             bool implements_whole_instruction,
-            const GemmBackendConfig& backend_config);
+            const GemmBackendConfig& backend_config,
+            const BufferAllocation::Slice& bias_buffer = {});
 
   GemmThunk(const GemmThunk&) = delete;
   GemmThunk& operator=(const GemmThunk&) = delete;
@@ -55,6 +58,7 @@ class GemmThunk : public Thunk {
   const BufferAllocation::Slice lhs_buffer_;
   const BufferAllocation::Slice rhs_buffer_;
   const BufferAllocation::Slice output_buffer_;
+  const BufferAllocation::Slice bias_buffer_;
   bool implements_whole_instruction_;
   GemmBackendConfig backend_config_;
 };
@@ -68,10 +72,15 @@ class GemmThunk : public Thunk {
 //
 // If `algorithm` is provided, it overrides the one specified in
 // `backend_config`.
+//
+// Gemms with an epilogue in `backend_config` run through cuBLASLt, which picks
+// its own algorithm, and add `bias_buffer` for the BIAS and BIAS_RELU
+// epilogues.
 Status RunGemm(
     const HloInstruction* gemm, const GemmBackendConfig& backend_config,
     se::DeviceMemoryBase lhs_buffer, se::DeviceMemoryBase rhs_buffer,
-    se::DeviceMemoryBase output_buffer, se::Stream* stream,
+    se::DeviceMemoryBase output_buffer, se::DeviceMemoryBase bias_buffer,
+    se::Stream* stream,
     bool implements_whole_instruction, absl::optional<int64> profile_index,
     HloExecutionProfiler* profiler = nullptr,
     se::blas::ProfileResult* profile_result = nullptr,
@@ -50,6 +50,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/gpu/alias_passthrough_params.h"
 #include "tensorflow/compiler/xla/service/gpu/cudnn_batchnorm_rewriter.h"
 #include "tensorflow/compiler/xla/service/gpu/fusion_merger.h"
+#include "tensorflow/compiler/xla/service/gpu/gpu_performance_model.h"
 #include "tensorflow/compiler/xla/service/gpu/gemm_rewriter.h"
 #include "tensorflow/compiler/xla/service/gpu/gpu_constants.h"
 #include "tensorflow/compiler/xla/service/gpu/gpu_conv_algorithm_picker.h"
@@ -60,6 +61,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/gpu/gpu_sanitize_constant_names.h"
 #include "tensorflow/compiler/xla/service/gpu/gpu_scatter_expander.h"
 #include "tensorflow/compiler/xla/service/gpu/horizontal_fusion.h"
+#include "tensorflow/compiler/xla/service/gpu/host_memory_offload.h"
 #include "tensorflow/compiler/xla/service/gpu/instruction_fusion.h"
 #include "tensorflow/compiler/xla/service/gpu/ir_emission_utils.h"
 #include "tensorflow/compiler/xla/service/gpu/ir_emitter_context.h"
@@ -122,6 +124,35 @@ limitations under the License.
 namespace xla {
 namespace gpu {
 
+namespace {
+
+// Returns the throughput of the device for the performance model of fusion,
+// keeping the defaults of the model for what the device does not report.
+GpuPerformanceModel::DeviceProperties GetPerformanceModelDeviceProperties(
+    se::StreamExecutor* stream_exec) {
+  GpuPerformanceModel::DeviceProperties properties;
+  if (stream_exec == nullptr) {
+    return properties;
+  }
+  const se::DeviceDescription& description =
+      stream_exec->GetDeviceDescription();
+  if (description.memory_bandwidth() > 0) {
+    properties.memory_bandwidth_bytes_per_second =
+        description.memory_bandwidth();
+  }
+  if (description.core_count() > 0 && description.clock_rate_ghz() > 0) {
+    // Each core is taken to issue a 64-wide FMA and a 16-wide transcendental
+    // per cycle, as Volta and later do.
+    const double cycles_per_second =
+        description.core_count() * description.clock_rate_ghz() * 1e9;
+    properties.flops_per_second = 2 * 64 * cycles_per_second;
+    properties.transcendentals_per_second = 16 * cycles_per_second;
+  }
+  return properties;
+}
+
+}  // namespace
+
 GpuCompiler::GpuCompiler(se::Platform::Id platform_id,
                          const char* target_triple, const char* data_layout)
     : platform_id_(platform_id),
@@ -293,9 +324,19 @@ Status GpuCompiler::OptimizeHloModule(
         /*layout_sensitive=*/true,
         /*allow_mixed_precision=*/false,
         LayoutAssignment::InstructionCanChangeLayout);
-    fusion.AddPass<GpuInstructionFusion>(/*may_duplicate=*/false);
-    fusion.AddPass<GpuInstructionFusion>(/*may_duplicate=*/true);
-    fusion.AddPass<FusionMerger>();
+    absl::optional<GpuPerformanceModel> performance_model;
+    if (hlo_module->config()
+            .debug_options()
+            .xla_gpu_enable_fusion_cost_model()) {
+      performance_model.emplace(
+          GetPerformanceModelDeviceProperties(stream_exec),
+          ShapeSizeBytesFunction());
+    }
+    fusion.AddPass<GpuInstructionFusion>(/*may_duplicate=*/false,
+                                         performance_model);
+    fusion.AddPass<GpuInstructionFusion>(/*may_duplicate=*/true,
+                                         performance_model);
+    fusion.AddPass<FusionMerger>(performance_model);
     fusion.AddPass<GpuMultiOutputFusion>();
     fusion.AddPass<HloCSE>(/*is_layout_sensitive=*/true,
                            /*only_fusion_computations=*/true);
@@ -491,6 +532,19 @@ static Status CompileModuleToLlvmIrImpl(
   (*llvm_module)->setTargetTriple(target_triple);
   (*llvm_module)->setDataLayout(data_layout);
 
+  const int64 device_memory_limit =
+      hlo_module->config()
+          .debug_options()
+          .xla_gpu_host_offload_device_memory_limit();
+  if (device_memory_limit > 0) {
+    HostMemoryOffloadOptions offload_options;
+    offload_options.device_memory_limit_bytes = device_memory_limit;
+    offload_options.pointer_size = pointer_size;
+    offload_options.can_share_buffer = can_share_buffer_function;
+    TF_RETURN_IF_ERROR(
+        HostMemoryOffload(offload_options).Run(hlo_module).status());
+  }
+
   std::unique_ptr<StreamAssignment> stream_assignment =
       AssignStreams(*hlo_module);
   TF_ASSIGN_OR_RETURN(
@@ -31,6 +31,10 @@ extern const int64 kXlaAllocatedBufferAlignBytes;
 // Minimum alignment for constant buffers.
 extern const int64 kConstantBufferAlignBytes;
 
+// The memory space, and buffer color, of buffers held in pinned host memory.
+// Kernels and copies access them through unified virtual addressing.
+extern const int64 kHostMemorySpace;
+
 }  // namespace gpu
 }  // namespace xla
 
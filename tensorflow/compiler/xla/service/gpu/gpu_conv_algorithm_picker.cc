@@ -16,11 +16,13 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/gpu/gpu_conv_algorithm_picker.h"
 
 #include "absl/algorithm/container.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "absl/time/time.h"
 #include "absl/types/optional.h"
 #include "tensorflow/compiler/xla/literal_util.h"
+#include "tensorflow/compiler/xla/service/gpu/autotune_results.h"
 #include "tensorflow/compiler/xla/service/gpu/backend_configs.pb.h"
 #include "tensorflow/compiler/xla/service/gpu/convolution_thunk.h"
 #include "tensorflow/compiler/xla/service/gpu/gpu_autotuning.pb.h"
@@ -248,7 +250,7 @@ StatusOr<bool> CheckRedzones(const se::RedzoneAllocator& allocator,
 #endif
 
 using ConvCacheKey =
-    std::tuple<se::StreamExecutor*,
+    std::tuple</* AutotuneDeviceKey */ std::string,
                /* conv->ToString(HloPrintOptions::Canonical()) */ std::string>;
 
 struct ConvCacheStats {
@@ -265,7 +267,12 @@ ConvCacheKey AutotuneCacheKeyfromInstruction(
     const HloCustomCallInstruction* conv, se::StreamExecutor* se) {
   auto options = HloPrintOptions::Canonical();
   options.set_print_backend_config(true);
-  return std::make_tuple(se, conv->ToString(options));
+  tensorflow::CudnnVersion cudnn_version = GetCudnnVersion(se);
+  return std::make_tuple(
+      AutotuneDeviceKey(se, absl::StrCat("cuDNN ", cudnn_version.major(), ".",
+                                         cudnn_version.minor(), ".",
+                                         cudnn_version.patch())),
+      conv->ToString(options));
 }
 
 tensorflow::mutex autotune_cache_lock(tensorflow::LINKER_INITIALIZED);
@@ -273,6 +280,49 @@ auto& autotune_cache TF_GUARDED_BY(autotune_cache_lock) =
     *new absl::flat_hash_map<ConvCacheKey, AutotuneResult>();
 auto& autotune_cache_stats TF_GUARDED_BY(autotune_cache_lock) =
     *new ConvCacheStats();
+// Whether convolutions were autotuned since the cache was last saved.
+bool autotune_cache_changed TF_GUARDED_BY(autotune_cache_lock) = false;
+// The files results were loaded from into the cache.
+auto& loaded_results_paths TF_GUARDED_BY(autotune_cache_lock) =
+    *new absl::flat_hash_set<std::string>();
+
+// Adds the results saved at `path` to the cache, unless they were added
+// already.
+void LoadConvAutotuneResults(const std::string& path)
+    TF_EXCLUSIVE_LOCKS_REQUIRED(autotune_cache_lock) {
+  if (!loaded_results_paths.insert(path).second) {
+    return;
+  }
+  const AutotuneResults results = ReadAutotuneResults(path);
+  for (const ConvAutotuneEntry& entry : results.convs()) {
+    autotune_cache.emplace(std::make_tuple(entry.device(), entry.hlo()),
+                           entry.result());
+  }
+  VLOG(1) << "Loaded " << results.convs_size()
+          << " convolution autotuning results from " << path;
+}
+
+// Saves all the results in the cache to `path`, including those loaded from
+// it. Failing to save them only costs autotuning time later, so it doesn't
+// fail the compilation.
+void SaveConvAutotuneResults(const std::string& path)
+    TF_EXCLUSIVE_LOCKS_REQUIRED(autotune_cache_lock) {
+  Status status = UpdateAutotuneResults(path, [](AutotuneResults* results) {
+    results->clear_convs();
+    for (const auto& key_and_result : autotune_cache) {
+      ConvAutotuneEntry* entry = results->add_convs();
+      entry->set_device(std::get<0>(key_and_result.first));
+      entry->set_hlo(std::get<1>(key_and_result.first));
+      *entry->mutable_result() = key_and_result.second;
+    }
+  });
+  if (!status.ok()) {
+    LOG(WARNING) << "Could not save the convolution autotuning results to "
+                 << path << ": " << status;
+    return;
+  }
+  autotune_cache_changed = false;
+}
 }  // anonymous namespace
 
 StatusOr<AutotuneResult> GpuConvAlgorithmPicker::PickBestAlgorithm(
@@ -337,6 +387,7 @@ StatusOr<AutotuneResult> GpuConvAlgorithmPicker::PickBestAlgorithm(
   if (result_or.ok()) {
     tensorflow::mutex_lock lock(autotune_cache_lock);
     CHECK(autotune_cache.insert({key, result_or.ValueOrDie()}).second);
+    autotune_cache_changed = true;
   }
   return result_or;
 }
@@ -834,6 +885,13 @@ StatusOr<bool> GpuConvAlgorithmPicker::Run(HloModule* module) {
     return false;
   }
 
+  const std::string& results_path =
+      module->config().debug_options().xla_gpu_autotune_results_path();
+  if (!results_path.empty()) {
+    tensorflow::mutex_lock lock(autotune_cache_lock);
+    LoadConvAutotuneResults(results_path);
+  }
+
   bool changed = false;
   for (HloComputation* computation : module->MakeNonfusionComputations()) {
     TF_ASSIGN_OR_RETURN(bool result, RunOnComputation(computation));
@@ -843,6 +901,9 @@ StatusOr<bool> GpuConvAlgorithmPicker::Run(HloModule* module) {
   {
     tensorflow::mutex_lock lock(autotune_cache_lock);
     autotune_cache_stats.LogStats();
+    if (!results_path.empty() && autotune_cache_changed) {
+      SaveConvAutotuneResults(results_path);
+    }
   }
 
   return changed;
@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/compiler/xla/service/gpu/gpu_executable.h"
 
+#include <algorithm>
 #include <set>
 #include <utility>
 #include <vector>
@@ -22,12 +23,15 @@ limitations under the License.
 #include "absl/container/flat_hash_map.h"
 #include "absl/memory/memory.h"
 #include "tensorflow/compiler/xla/map_util.h"
+#include "absl/algorithm/container.h"
 #include "tensorflow/compiler/xla/service/gpu/buffer_allocations.h"
+#include "tensorflow/compiler/xla/service/gpu/copy_thunk.h"
 #include "tensorflow/compiler/xla/service/gpu/gpu_constants.h"
 #include "tensorflow/compiler/xla/service/gpu/gpu_debug_info_manager.h"
 #include "tensorflow/compiler/xla/service/gpu/gpu_executable_run_options.h"
 #include "tensorflow/compiler/xla/service/gpu/gpu_types.h"
 #include "tensorflow/compiler/xla/service/gpu/hlo_execution_profiler.h"
+#include "tensorflow/compiler/xla/service/gpu/sequential_thunk.h"
 #include "tensorflow/compiler/xla/service/hlo_instruction.h"
 #include "tensorflow/compiler/xla/service/llvm_ir/buffer_assignment_util.h"
 #include "tensorflow/compiler/xla/service/logical_buffer.h"
@@ -44,14 +48,69 @@ limitations under the License.
 #include "tensorflow/core/profiler/lib/traceme.h"
 #include "tensorflow/stream_executor/platform.h"
 
+#if GOOGLE_CUDA
+#include "tensorflow/stream_executor/gpu/gpu_driver.h"
+#include "tensorflow/stream_executor/gpu/gpu_executor.h"
+#include "tensorflow/stream_executor/gpu/gpu_stream.h"
+#endif
+
 namespace xla {
 namespace gpu {
 namespace {
 
 using ::tensorflow::profiler::ScopedAnnotation;
 
+// Upper bound on the number of sets of buffer addresses an executable keeps a
+// CUDA graph for on one device.
+constexpr int kMaxCudaGraphsPerExecutor = 8;
+
+// Returns true if `thunk` only enqueues device work that stream capture can
+// record: kernels, memsets, device to device copies and cuBLAS calls. Thunks
+// that copy from host memory, wait for the host or talk to other devices can
+// not be captured.
+bool IsCapturable(const Thunk& thunk) {
+  switch (thunk.kind()) {
+    case Thunk::kGemm:
+    case Thunk::kKernel:
+    case Thunk::kMemset32BitValue:
+    case Thunk::kMemzero:
+      return true;
+    case Thunk::kCopy:
+      return dynamic_cast<const DeviceToDeviceCopyThunk*>(&thunk) != nullptr;
+    case Thunk::kSequential:
+      return absl::c_all_of(
+          static_cast<const SequentialThunk&>(thunk).thunks(),
+          [](const std::unique_ptr<Thunk>& t) { return IsCapturable(*t); });
+    default:
+      return false;
+  }
+}
+
 }  // namespace
 
+#if GOOGLE_CUDA
+struct GpuExecutable::CudaGraphs {
+  struct Graph {
+    std::vector<const void*> addresses;
+    se::gpu::GpuGraphExecHandle exec;
+  };
+
+  se::gpu::GpuContext* context = nullptr;
+  // In order of their last launch.
+  std::vector<Graph> graphs;
+  // Set once the thunks ran individually on the device, which also does the
+  // lazy initialization that may not happen during a capture.
+  bool warmed_up = false;
+  // Buffer addresses of the last run that did not launch a graph.
+  std::vector<const void*> last_addresses;
+  // Set when a capture failed, after which the thunks are always launched
+  // individually.
+  bool disabled = false;
+};
+#else
+struct GpuExecutable::CudaGraphs {};
+#endif
+
 // Implementation note: HLO profiling is always enabled for GPU executables,
 // since we can use timers around thunks.
 GpuExecutable::GpuExecutable(
@@ -71,6 +130,11 @@ GpuExecutable::GpuExecutable(
   CHECK(has_module() && assignment_);
   GpuDebugInfoManager::Get()->RegisterModule(module().name(), shared_module(),
                                              assignment_);
+  use_cuda_graphs_ =
+      module().config().debug_options().xla_gpu_enable_cuda_graphs() &&
+      thunk_schedule_->StreamCount() == 1 &&
+      absl::c_all_of(thunk_schedule_->TotalOrder(),
+                     [](const Thunk* thunk) { return IsCapturable(*thunk); });
 }
 
 GpuExecutable::~GpuExecutable() {
@@ -90,6 +154,17 @@ GpuExecutable::~GpuExecutable() {
       CHECK(pair.first->SynchronizeAllActivity());
     }
   }
+
+#if GOOGLE_CUDA
+  tensorflow::mutex_lock lock(graph_mutex_);
+  for (const auto& pair : cuda_graphs_) {
+    // Graphs may only be destroyed once their launches have completed.
+    CHECK(pair.first->SynchronizeAllActivity());
+    for (const CudaGraphs::Graph& graph : pair.second->graphs) {
+      se::gpu::GpuDriver::DestroyGraphExec(pair.second->context, graph.exec);
+    }
+  }
+#endif
 }
 
 Status GpuExecutable::CheckCompatibilityWithServiceExecutableRunOptions(
@@ -163,46 +238,17 @@ Status GpuExecutable::ExecuteThunks(
       [&] { return absl::StrCat(hlo_module_->name(), ":XLA GPU module"); },
       tensorflow::profiler::TraceMeLevel::kInfo);
 
-  std::map<const Thunk*, std::unique_ptr<se::Event>> thunk_to_finish_event;
   std::vector<std::function<void()>> deferred_host_callbacks;
-  for (Thunk* thunk : thunk_schedule_->TotalOrder()) {
-    // Annotate execution of this op if tracing was enabled when we started
-    // running this module.  If tracing is enabled *while* we're running the
-    // module, we won't get any data, but that's probably an OK trade-off.
-    ScopedAnnotation annotation([&] { return thunk->profile_annotation(); });
-
-    int32 stream_no = thunk_schedule_->StreamNumberForThunk(thunk);
-    se::Stream* stream =
-        (stream_no == 0 ? main_stream : sub_streams[stream_no - 1].get());
-
-    for (const Thunk* dependency : thunk_schedule_->DependsOn(thunk)) {
-      stream->ThenWaitFor(FindOrDie(thunk_to_finish_event, dependency).get());
-    }
-
-    VLOG(2) << "Executing the thunk for " << thunk->profile_annotation()
-            << " on stream " << stream_no;
-    const GpuExecutableRunOptions* gpu_options =
-        run_options->run_options().gpu_executable_run_options();
-    Thunk::ExecuteParams thunk_params{
-        &buffer_allocations,
-        stream,
-        run_options->run_options().run_id(),
-        &profiler,
-        run_options->run_options().device_assignment(),
-        &deferred_host_callbacks,
-        gpu_options && gpu_options->gpu_global_device_ids()
-            ? &*gpu_options->gpu_global_device_ids()
-            : nullptr,
-        gpu_options && gpu_options->nccl_unique_id_callback()
-            ? &gpu_options->nccl_unique_id_callback()
-            : nullptr};
-    TF_RETURN_IF_ERROR(thunk->ExecuteOnStream(thunk_params));
-    if (thunk_schedule_->Depended(thunk)) {
-      auto finish_event = absl::make_unique<se::Event>(main_stream->parent());
-      finish_event->Init();
-      stream->ThenRecordEvent(finish_event.get());
-      thunk_to_finish_event[thunk] = std::move(finish_event);
-    }
+  bool launched_as_graph = false;
+  if (use_cuda_graphs_ && !do_profile) {
+    TF_ASSIGN_OR_RETURN(launched_as_graph,
+                        LaunchAsGraph(run_options, buffer_allocations,
+                                      main_stream, &profiler));
+  }
+  if (!launched_as_graph) {
+    TF_RETURN_IF_ERROR(LaunchThunks(run_options, buffer_allocations,
+                                    main_stream, sub_streams, &profiler,
+                                    &deferred_host_callbacks));
   }
 
   main_stream->ThenWaitFor(&sub_streams);
@@ -254,6 +300,170 @@ Status GpuExecutable::ExecuteThunks(
   return Status::OK();
 }
 
+Status GpuExecutable::LaunchThunks(
+    const ServiceExecutableRunOptions* run_options,
+    const BufferAllocations& buffer_allocations, se::Stream* main_stream,
+    const std::vector<StreamPool::Ptr>& sub_streams,
+    HloExecutionProfiler* profiler,
+    std::vector<std::function<void()>>* deferred_host_callbacks) {
+  std::map<const Thunk*, std::unique_ptr<se::Event>> thunk_to_finish_event;
+  for (Thunk* thunk : thunk_schedule_->TotalOrder()) {
+    // Annotate execution of this op if tracing was enabled when we started
+    // running this module.  If tracing is enabled *while* we're running the
+    // module, we won't get any data, but that's probably an OK trade-off.
+    ScopedAnnotation annotation([&] { return thunk->profile_annotation(); });
+
+    int32 stream_no = thunk_schedule_->StreamNumberForThunk(thunk);
+    se::Stream* stream =
+        (stream_no == 0 ? main_stream : sub_streams[stream_no - 1].get());
+
+    for (const Thunk* dependency : thunk_schedule_->DependsOn(thunk)) {
+      stream->ThenWaitFor(FindOrDie(thunk_to_finish_event, dependency).get());
+    }
+
+    VLOG(2) << "Executing the thunk for " << thunk->profile_annotation()
+            << " on stream " << stream_no;
+    const GpuExecutableRunOptions* gpu_options =
+        run_options->run_options().gpu_executable_run_options();
+    Thunk::ExecuteParams thunk_params{
+        &buffer_allocations,
+        stream,
+        run_options->run_options().run_id(),
+        profiler,
+        run_options->run_options().device_assignment(),
+        deferred_host_callbacks,
+        gpu_options && gpu_options->gpu_global_device_ids()
+            ? &*gpu_options->gpu_global_device_ids()
+            : nullptr,
+        gpu_options && gpu_options->nccl_unique_id_callback()
+            ? &gpu_options->nccl_unique_id_callback()
+            : nullptr};
+    TF_RETURN_IF_ERROR(thunk->ExecuteOnStream(thunk_params));
+    if (thunk_schedule_->Depended(thunk)) {
+      auto finish_event = absl::make_unique<se::Event>(main_stream->parent());
+      finish_event->Init();
+      stream->ThenRecordEvent(finish_event.get());
+      thunk_to_finish_event[thunk] = std::move(finish_event);
+    }
+  }
+  return Status::OK();
+}
+
+StatusOr<bool> GpuExecutable::LaunchAsGraph(
+    const ServiceExecutableRunOptions* run_options,
+    const BufferAllocations& buffer_allocations, se::Stream* main_stream,
+    HloExecutionProfiler* profiler) {
+#if GOOGLE_CUDA
+  using se::gpu::GpuDriver;
+
+  std::vector<const void*> addresses;
+  addresses.reserve(assignment_->Allocations().size());
+  for (BufferAllocation::Index i = 0; i < assignment_->Allocations().size();
+       ++i) {
+    addresses.push_back(buffer_allocations.GetDeviceAddress(i).opaque());
+  }
+
+  tensorflow::mutex_lock lock(graph_mutex_);
+  std::unique_ptr<CudaGraphs>& graphs = cuda_graphs_[main_stream->parent()];
+  if (graphs == nullptr) {
+    graphs = absl::make_unique<CudaGraphs>();
+    graphs->context =
+        se::gpu::AsGpuStream(main_stream)->parent()->gpu_context();
+  }
+  if (graphs->disabled) {
+    return false;
+  }
+  se::gpu::GpuStreamHandle stream = se::gpu::AsGpuStreamValue(main_stream);
+  auto it = absl::c_find_if(graphs->graphs,
+                            [&](const CudaGraphs::Graph& graph) {
+                              return graph.addresses == addresses;
+                            });
+  if (it != graphs->graphs.end()) {
+    std::rotate(it, it + 1, graphs->graphs.end());
+    TF_RETURN_IF_ERROR(GpuDriver::GraphLaunch(
+        graphs->context, graphs->graphs.back().exec, stream));
+    return true;
+  }
+  if (!graphs->warmed_up) {
+    graphs->warmed_up = true;
+    graphs->last_addresses = std::move(addresses);
+    return false;
+  }
+
+  // Addresses seen twice in a row get a graph of their own, as long as there is
+  // room for it. Otherwise the least recently launched graph is updated to the
+  // new addresses, which is much cheaper than instantiating a graph, so that
+  // executables whose buffers move from run to run still launch graphs.
+  const bool update_graph =
+      !graphs->graphs.empty() &&
+      (addresses != graphs->last_addresses ||
+       graphs->graphs.size() >= kMaxCudaGraphsPerExecutor);
+  graphs->last_addresses = addresses;
+
+  VLOG(1) << "Capturing the thunks of " << module().name()
+          << " into a CUDA graph";
+  Status status = GpuDriver::StreamBeginCapture(graphs->context, stream);
+  se::gpu::GpuGraphExecHandle exec = nullptr;
+  if (status.ok()) {
+    std::vector<std::function<void()>> deferred_host_callbacks;
+    status = LaunchThunks(run_options, buffer_allocations, main_stream,
+                          /*sub_streams=*/{}, profiler,
+                          &deferred_host_callbacks);
+    se::gpu::GpuGraphHandle graph = nullptr;
+    Status capture_status =
+        GpuDriver::StreamEndCapture(graphs->context, stream, &graph);
+    if (status.ok()) {
+      status = capture_status;
+    }
+    if (status.ok() && !deferred_host_callbacks.empty()) {
+      status = InternalError("Thunks deferred host callbacks");
+    }
+    if (status.ok() && update_graph) {
+      se::gpu::GpuGraphExecHandle lru_exec = graphs->graphs.front().exec;
+      Status update_status =
+          GpuDriver::GraphExecUpdate(graphs->context, lru_exec, graph);
+      if (update_status.ok()) {
+        exec = lru_exec;
+      } else {
+        // The graph is instantiated instead, and replaces the least recently
+        // launched one, which is freed once its pending launches are done.
+        VLOG(1) << "Could not update a CUDA graph of " << module().name()
+                << ": " << update_status;
+        status = GpuDriver::GraphInstantiate(graphs->context, graph, &exec);
+        if (status.ok()) {
+          GpuDriver::DestroyGraphExec(graphs->context, lru_exec);
+        }
+      }
+      if (status.ok()) {
+        graphs->graphs.erase(graphs->graphs.begin());
+      }
+    } else if (status.ok()) {
+      status = GpuDriver::GraphInstantiate(graphs->context, graph, &exec);
+    }
+    if (graph != nullptr) {
+      GpuDriver::DestroyGraph(graphs->context, graph);
+    }
+  }
+  if (!status.ok()) {
+    // Nothing that was captured ran, so the caller launches the thunks again.
+    LOG(WARNING) << "Could not capture " << module().name()
+                 << " into a CUDA graph, launching its thunks individually "
+                    "from now on: "
+                 << status;
+    if (exec != nullptr) {
+      GpuDriver::DestroyGraphExec(graphs->context, exec);
+    }
+    graphs->disabled = true;
+    return false;
+  }
+  graphs->graphs.push_back({std::move(addresses), exec});
+  TF_RETURN_IF_ERROR(GpuDriver::GraphLaunch(graphs->context, exec, stream));
+  return true;
+#else
+  return false;
+#endif
+}
+
 StatusOr<const GpuExecutable::BufferAllocToDeviceMemoryMap*>
 GpuExecutable::ResolveConstantGlobals(se::Stream* stream) {
   se::StreamExecutor* executor = stream->parent();
@@ -314,8 +524,8 @@ StatusOr<se::DeviceMemoryBase> GpuExecutable::BufferForAllocation(
     absl::Span<ExecutionInput const> arguments,
     const GpuExecutable::BufferAllocToDeviceMemoryMap* globals,
     const BufferAllocation& allocation,
-    se::DeviceMemoryAllocator* const memory_allocator, int device_ordinal,
-    int64 arg_idx) {
+    se::DeviceMemoryAllocator* const memory_allocator,
+    se::StreamExecutor* executor, int64 arg_idx) {
   if (allocation.is_thread_local()) {
     return se::DeviceMemoryBase{};
   } else if (allocation.is_entry_computation_parameter()) {
@@ -335,6 +545,22 @@ StatusOr<se::DeviceMemoryBase> GpuExecutable::BufferForAllocation(
     return registered_buffer;
   } else if (allocation.is_constant()) {
     return FindOrDie(*globals, arg_idx);
+  } else if (allocation.color() == kHostMemorySpace) {
+    // Buffers offloaded to host memory live in pinned host memory, which the
+    // device accesses directly and the copy thunks read and write at full link
+    // bandwidth. They are freed by ExecuteAsyncOnStream.
+    const int64 buffer_size = allocation.size();
+    se::DeviceMemoryBase buffer_address;
+    if (buffer_size > 0) {
+      void* host_buffer = executor->HostMemoryAllocate(buffer_size);
+      if (host_buffer == nullptr) {
+        return ResourceExhausted(
+            "Failed to allocate %d bytes of host memory for buffer %d",
+            buffer_size, arg_idx);
+      }
+      buffer_address = se::DeviceMemoryBase(host_buffer, buffer_size);
+    }
+    return buffer_address;
   } else {
     // Allocate each allocation that might escape, or is the temp buffer.
     CHECK(allocation.maybe_live_out() || allocation.IsPreallocatedTempBuffer());
@@ -343,7 +569,7 @@ StatusOr<se::DeviceMemoryBase> GpuExecutable::BufferForAllocation(
     if (buffer_size > 0) {
       TF_ASSIGN_OR_RETURN(
           se::OwningDeviceMemory buffer,
-          memory_allocator->Allocate(device_ordinal, buffer_size));
+          memory_allocator->Allocate(executor->device_ordinal(), buffer_size));
       buffer_address = buffer.Release();
     }
     return buffer_address;
@@ -388,7 +614,7 @@ StatusOr<BufferAllocations> GpuExecutable::GenerateBufferAllocations(
     TF_ASSIGN_OR_RETURN(
         se::DeviceMemoryBase buffer,
         BufferForAllocation(arguments, globals, allocation, memory_allocator,
-                            executor->device_ordinal(), i));
+                            executor, i));
     buffers.push_back(buffer);
     TF_RETURN_IF_ERROR(CheckAlignment(allocation, buffer, i));
   }
@@ -427,9 +653,15 @@ StatusOr<ExecutionOutput> GpuExecutable::ExecuteAsyncOnStream(
   XLA_SCOPED_LOGGING_TIMER(absl::StrCat("GpuExecutable::ExecuteAsyncOnStream(",
                                         module().name(), ")"));
   se::DeviceMemoryAllocator* const memory_allocator = run_options->allocator();
-  // Force synchronous execution if the allocator requires it.
+  // Force synchronous execution if the allocator requires it, or if buffers
+  // are offloaded to host memory, which is freed below.
+  const bool has_host_buffers =
+      absl::c_any_of(assignment_->Allocations(),
+                     [](const BufferAllocation& allocation) {
+                       return allocation.color() == kHostMemorySpace;
+                     });
   const bool block_host_until_done =
-      !memory_allocator->AllowsAsynchronousDeallocation();
+      !memory_allocator->AllowsAsynchronousDeallocation() || has_host_buffers;
 
   if (GetRootValueSet().IsAmbiguous()) {
     return Unimplemented("Points-to set of root instruction is ambiguous");
@@ -557,6 +789,16 @@ StatusOr<ExecutionOutput> GpuExecutable::ExecuteAsyncOnStream(
   // Free all temporary allocations.
   TF_RETURN_IF_ERROR(
       buffer_allocations.TearDown(buffers_in_result, assignment_.get()));
+  for (const BufferAllocation& allocation : assignment_->Allocations()) {
+    if (allocation.color() != kHostMemorySpace) {
+      continue;
+    }
+    se::DeviceMemoryBase buffer =
+        buffer_allocations.GetDeviceAddress(allocation.index());
+    if (!buffer.is_null()) {
+      executor->HostMemoryDeallocate(buffer.opaque());
+    }
+  }
 
   // Free allocations for arguments.
   MarkToBeReleasedArguments(absl::MakeSpan(arguments), result);
@@ -16,8 +16,10 @@ limitations under the License.
 #ifndef TENSORFLOW_COMPILER_XLA_SERVICE_GPU_GPU_EXECUTABLE_H_
 #define TENSORFLOW_COMPILER_XLA_SERVICE_GPU_GPU_EXECUTABLE_H_
 
+#include <functional>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/strings/string_view.h"
@@ -102,6 +104,32 @@ class GpuExecutable : public Executable {
                        bool block_host_until_done,
                        HloExecutionProfile* hlo_execution_profile);
 
+  // Enqueues the thunks onto `main_stream` and `sub_streams`, one after the
+  // other.
+  Status LaunchThunks(
+      const ServiceExecutableRunOptions* run_options,
+      const BufferAllocations& buffer_allocations, se::Stream* main_stream,
+      const std::vector<StreamPool::Ptr>& sub_streams,
+      HloExecutionProfiler* profiler,
+      std::vector<std::function<void()>>* deferred_host_callbacks);
+
+  // Enqueues the thunks onto `main_stream` as a single CUDA graph launch, if a
+  // graph is captured for the addresses in `buffer_allocations`, or captures
+  // one on every run but the first. Returns false if the thunks were not
+  // enqueued.
+  //
+  // Graphs bake in the buffer addresses of the kernel arguments, so they are
+  // only replayed for the exact addresses they were captured with. Allocators
+  // that hand out the same buffers every run, such as the one planning memory
+  // from previous steps, make the executable hit the same graph every time.
+  // Runs with new addresses update the least recently launched graph to them
+  // instead, unless the same addresses were seen in the previous run and
+  // there is room to keep a graph for them.
+  StatusOr<bool> LaunchAsGraph(const ServiceExecutableRunOptions* run_options,
+                               const BufferAllocations& buffer_allocations,
+                               se::Stream* main_stream,
+                               HloExecutionProfiler* profiler);
+
   // Returns the value set of the root instruction of the entry
   // computation. Uses dataflow analysis from buffer assignment.
   const InstructionValueSet& GetRootValueSet() const;
@@ -130,8 +158,8 @@ class GpuExecutable : public Executable {
       absl::Span<ExecutionInput const> arguments,
       const GpuExecutable::BufferAllocToDeviceMemoryMap* globals,
       const BufferAllocation& allocation,
-      se::DeviceMemoryAllocator* const memory_allocator, int device_ordinal,
-      int64 arg_idx);
+      se::DeviceMemoryAllocator* const memory_allocator,
+      se::StreamExecutor* executor, int64 arg_idx);
 
   // The LLVM IR, in string format, of the unoptimized module generated for
   // this GpuExecutable. We save a string instead of an llvm::Module* because
@@ -169,6 +197,16 @@ class GpuExecutable : public Executable {
   std::map<stream_executor::StreamExecutor*, BufferAllocToDeviceMemoryMap>
       module_globals_ TF_GUARDED_BY(module_handle_mutex_);
 
+  // Whether xla_gpu_enable_cuda_graphs is set and all thunks run on one
+  // stream and can be captured into a CUDA graph.
+  bool use_cuda_graphs_ = false;
+
+  // CUDA graphs captured by `LaunchAsGraph`, per StreamExecutor.
+  struct CudaGraphs;
+  tensorflow::mutex graph_mutex_;
+  std::map<stream_executor::StreamExecutor*, std::unique_ptr<CudaGraphs>>
+      cuda_graphs_ TF_GUARDED_BY(graph_mutex_);
+
   TF_DISALLOW_COPY_AND_ASSIGN(GpuExecutable);
 };
 
@@ -21,6 +21,7 @@ limitations under the License.
 
 #include "absl/memory/memory.h"
 #include "tensorflow/compiler/xla/service/buffer_value.h"
+#include "tensorflow/compiler/xla/service/gpu/latency_hiding_scheduler.h"
 #include "tensorflow/compiler/xla/service/hlo_memory_scheduler.h"
 #include "tensorflow/compiler/xla/service/hlo_reachability.h"
 #include "tensorflow/compiler/xla/service/hlo_schedule.h"
@@ -196,7 +197,39 @@ StatusOr<std::unique_ptr<GpuHloSchedule>> GpuHloSchedule::Build(
 
   // Initialize thunk_launch_order_, the total order of thunk launches.
   HloComputation* entry_computation = module.entry_computation();
-  if (stream_assignment.StreamCount() == 1) {
+  const DebugOptions& debug_options = module.config().debug_options();
+  if (debug_options.xla_gpu_host_offload_device_memory_limit() > 0 &&
+      module.has_schedule()) {
+    // Host memory offload placed its copies in the module schedule, at the
+    // points its memory limit was computed for.
+    schedule->thunk_launch_order_ =
+        module.schedule().sequence(entry_computation).instructions();
+  } else if (debug_options.xla_gpu_enable_latency_hiding_scheduler()) {
+    // Overlap collectives and asynchronous transfers with independent
+    // kernels, within a memory budget which by default leaves a little room
+    // over the memory-minimizing order.
+    LatencyEstimator estimator;
+    BufferSizeFunction buffer_size = [pointer_size](const HloInstruction& hlo) {
+      return DefaultBufferSize(hlo, pointer_size);
+    };
+    int64 memory_limit =
+        debug_options.xla_gpu_latency_hiding_scheduler_memory_limit();
+    if (memory_limit <= 0) {
+      TF_ASSIGN_OR_RETURN(
+          HloInstructionSequence sequence,
+          ScheduleComputation(
+              entry_computation, [pointer_size](const BufferValue& buffer) {
+                return ShapeUtil::ByteSizeOf(buffer.shape(), pointer_size);
+              }));
+      const SimulatedLaunchOrder memory_minimizing = SimulateLaunchOrder(
+          *entry_computation, sequence.instructions(), stream_assignment,
+          estimator, buffer_size);
+      memory_limit = memory_minimizing.peak_memory_bytes * 11 / 10;
+    }
+    schedule->thunk_launch_order_ =
+        LatencyHidingLaunchOrder(*entry_computation, stream_assignment,
+                                 estimator, buffer_size, memory_limit);
+  } else if (stream_assignment.StreamCount() == 1) {
     // All kernels are launched on a single stream, so there's no loss of
     // concurrency by optimizing for minimal memory usage.
     TF_ASSIGN_OR_RETURN(
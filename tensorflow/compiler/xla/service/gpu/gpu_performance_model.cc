@@ -0,0 +1,132 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/gpu/gpu_performance_model.h"
+
+#include <algorithm>
+
+#include "absl/algorithm/container.h"
+#include "tensorflow/compiler/xla/shape_util.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace xla {
+namespace gpu {
+
+GpuPerformanceModel::KernelCost GpuPerformanceModel::Analyze(
+    HloInstruction* instruction, std::vector<double>* operand_bytes,
+    double* output_bytes) const {
+  HloCostAnalysis analysis(shape_size_);
+  Status status = analysis.Preprocess(instruction);
+  if (status.ok()) {
+    status = instruction->Visit(&analysis);
+  }
+  if (status.ok()) {
+    status = analysis.Postprocess(instruction);
+  }
+
+  KernelCost cost;
+  operand_bytes->assign(instruction->operand_count(), 0);
+  if (!status.ok()) {
+    // Without a cost analysis the instruction is taken to read and write every
+    // byte of its operands and result once, and to do no arithmetic.
+    VLOG(3) << "No cost analysis of " << instruction->name() << ": " << status;
+    for (int64 i = 0; i < instruction->operand_count(); ++i) {
+      (*operand_bytes)[i] = shape_size_(instruction->operand(i)->shape());
+      cost.bytes += (*operand_bytes)[i];
+    }
+    *output_bytes = shape_size_(instruction->shape());
+    cost.bytes += *output_bytes;
+    return cost;
+  }
+
+  cost.flops = analysis.flop_count(*instruction);
+  cost.transcendentals = analysis.transcendental_count(*instruction);
+  for (int64 i = 0; i < instruction->operand_count(); ++i) {
+    (*operand_bytes)[i] = analysis.operand_bytes_accessed(*instruction, i);
+    cost.bytes += (*operand_bytes)[i];
+  }
+  *output_bytes = analysis.GetBytesWritten(*instruction);
+  cost.bytes += *output_bytes;
+  return cost;
+}
+
+absl::Duration GpuPerformanceModel::KernelTime(const KernelCost& cost) const {
+  const double seconds = std::max(
+      {cost.bytes / device_.memory_bandwidth_bytes_per_second,
+       cost.flops / device_.flops_per_second,
+       cost.transcendentals / device_.transcendentals_per_second});
+  return device_.kernel_launch_overhead + absl::Seconds(seconds);
+}
+
+absl::Duration GpuPerformanceModel::EstimateRunTime(
+    HloInstruction* instruction) const {
+  std::vector<double> operand_bytes;
+  double output_bytes;
+  return KernelTime(Analyze(instruction, &operand_bytes, &output_bytes));
+}
+
+GpuPerformanceModel::RunTimes GpuPerformanceModel::EstimateRunTimes(
+    HloInstruction* producer,
+    absl::Span<HloInstruction* const> fused_users) const {
+  std::vector<double> producer_operand_bytes;
+  double producer_output_bytes;
+  const KernelCost producer_cost =
+      Analyze(producer, &producer_operand_bytes, &producer_output_bytes);
+  const absl::Duration producer_time = KernelTime(producer_cost);
+  const double producer_elements =
+      std::max<int64>(1, ShapeUtil::ElementsInRecursive(producer->shape()));
+
+  RunTimes run_times;
+  run_times.time_unfused = producer_time;
+  for (HloInstruction* user : fused_users) {
+    std::vector<double> user_operand_bytes;
+    double user_output_bytes;
+    const KernelCost user_cost =
+        Analyze(user, &user_operand_bytes, &user_output_bytes);
+    run_times.time_unfused += KernelTime(user_cost);
+
+    // The fused kernel reads the operands of the producer instead of its
+    // result, and computes every element of the producer as many times as the
+    // user reads it.
+    KernelCost fused_cost = user_cost;
+    double recomputation = 1;
+    for (int64 i = 0; i < user->operand_count(); ++i) {
+      if (user->operand(i) != producer) {
+        continue;
+      }
+      fused_cost.bytes -= user_operand_bytes[i];
+      if (user->ReusesOperandElements(i)) {
+        recomputation = std::max(
+            recomputation,
+            ShapeUtil::ElementsInRecursive(user->shape()) / producer_elements);
+      }
+    }
+    fused_cost.bytes += producer_cost.bytes - producer_output_bytes;
+    fused_cost.flops += recomputation * producer_cost.flops;
+    fused_cost.transcendentals += recomputation * producer_cost.transcendentals;
+    run_times.time_fused += KernelTime(fused_cost);
+  }
+
+  // The producer still runs for the users it is not fused into.
+  if (absl::c_any_of(producer->users(), [&](const HloInstruction* user) {
+        return !absl::c_linear_search(fused_users, user);
+      })) {
+    run_times.time_fused += producer_time;
+  }
+  return run_times;
+}
+
+}  // namespace gpu
+}  // namespace xla
@@ -0,0 +1,88 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMPILER_XLA_SERVICE_GPU_GPU_PERFORMANCE_MODEL_H_
+#define TENSORFLOW_COMPILER_XLA_SERVICE_GPU_GPU_PERFORMANCE_MODEL_H_
+
+#include <vector>
+
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+#include "tensorflow/compiler/xla/service/hlo_cost_analysis.h"
+#include "tensorflow/compiler/xla/service/hlo_instruction.h"
+
+namespace xla {
+namespace gpu {
+
+// Estimates the run time of GPU kernels, to tell whether fusing a producer into
+// its users pays off. Every kernel is taken to be bound by either its memory
+// traffic, its arithmetic or its transcendental functions, whichever takes the
+// longest on the device, plus a fixed launch overhead. The flops and bytes of a
+// kernel come from HloCostAnalysis.
+class GpuPerformanceModel {
+ public:
+  // The throughput of the device. The defaults are those of a V100.
+  struct DeviceProperties {
+    double memory_bandwidth_bytes_per_second = 900e9;
+    double flops_per_second = 15e12;
+    double transcendentals_per_second = 3.75e12;
+    absl::Duration kernel_launch_overhead = absl::Microseconds(5);
+  };
+
+  // The estimated run times of a producer and a set of its users, as separate
+  // kernels and with the producer fused into each of the users.
+  struct RunTimes {
+    absl::Duration time_unfused;
+    absl::Duration time_fused;
+  };
+
+  GpuPerformanceModel(const DeviceProperties& device,
+                      const HloCostAnalysis::ShapeSizeFunction& shape_size)
+      : device_(device), shape_size_(shape_size) {}
+
+  // Returns the estimated run time of the instruction as a kernel of its own.
+  absl::Duration EstimateRunTime(HloInstruction* instruction) const;
+
+  // Estimates the run times of 'producer' and its users in 'fused_users'. When
+  // fused, the producer is recomputed in every such user, and still runs as a
+  // kernel of its own if it has other users.
+  RunTimes EstimateRunTimes(
+      HloInstruction* producer,
+      absl::Span<HloInstruction* const> fused_users) const;
+
+ private:
+  // The work a kernel does.
+  struct KernelCost {
+    double flops = 0;
+    double transcendentals = 0;
+    double bytes = 0;
+  };
+
+  // Runs the cost analysis on the instruction alone, and returns its cost
+  // along with the bytes it reads from each operand and writes.
+  KernelCost Analyze(HloInstruction* instruction,
+                     std::vector<double>* operand_bytes,
+                     double* output_bytes) const;
+
+  absl::Duration KernelTime(const KernelCost& cost) const;
+
+  DeviceProperties device_;
+  HloCostAnalysis::ShapeSizeFunction shape_size_;
+};
+
+}  // namespace gpu
+}  // namespace xla
+
+#endif  // TENSORFLOW_COMPILER_XLA_SERVICE_GPU_GPU_PERFORMANCE_MODEL_H_
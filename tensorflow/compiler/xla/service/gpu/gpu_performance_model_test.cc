@@ -0,0 +1,99 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/gpu/gpu_performance_model.h"
+
+#include "tensorflow/compiler/xla/service/hlo_computation.h"
+#include "tensorflow/compiler/xla/shape_util.h"
+#include "tensorflow/compiler/xla/tests/hlo_test_base.h"
+
+namespace xla {
+namespace gpu {
+namespace {
+
+class GpuPerformanceModelTest : public HloTestBase {
+ protected:
+  GpuPerformanceModel MakeModel(
+      const GpuPerformanceModel::DeviceProperties& device =
+          GpuPerformanceModel::DeviceProperties()) {
+    return GpuPerformanceModel(device, [](const Shape& shape) {
+      return ShapeUtil::ByteSizeOf(shape, 8);
+    });
+  }
+};
+
+TEST_F(GpuPerformanceModelTest, ElementwiseFusionIsFaster) {
+  auto module = ParseAndReturnVerifiedModule(R"(
+    HloModule m
+
+    ENTRY entry {
+      p0 = f32[1024,1024] parameter(0)
+      p1 = f32[1024,1024] parameter(1)
+      a = f32[1024,1024] add(p0, p1)
+      ROOT m = f32[1024,1024] multiply(a, p1)
+    })")
+                    .ValueOrDie();
+  HloInstruction* root = module->entry_computation()->root_instruction();
+  GpuPerformanceModel model = MakeModel();
+  GpuPerformanceModel::RunTimes times =
+      model.EstimateRunTimes(root->mutable_operand(0), {root});
+  EXPECT_LT(times.time_fused, times.time_unfused);
+}
+
+TEST_F(GpuPerformanceModelTest, RecomputingExpensiveProducerIsSlower) {
+  // Every element of the exponential is read 16384 times by the broadcast, so
+  // fusing recomputes it as often, which a device slow at transcendentals pays
+  // for.
+  auto module = ParseAndReturnVerifiedModule(R"(
+    HloModule m
+
+    ENTRY entry {
+      p0 = f32[1024] parameter(0)
+      e = f32[1024] exponential(p0)
+      ROOT b = f32[1024,1024,16] broadcast(e), dimensions={1}
+    })")
+                    .ValueOrDie();
+  HloInstruction* root = module->entry_computation()->root_instruction();
+  GpuPerformanceModel::DeviceProperties device;
+  device.transcendentals_per_second = 1e9;
+  GpuPerformanceModel model = MakeModel(device);
+  GpuPerformanceModel::RunTimes times =
+      model.EstimateRunTimes(root->mutable_operand(0), {root});
+  EXPECT_GT(times.time_fused, times.time_unfused);
+}
+
+TEST_F(GpuPerformanceModelTest, ProducerWithOtherUsersStillRuns) {
+  auto module = ParseAndReturnVerifiedModule(R"(
+    HloModule m
+
+    ENTRY entry {
+      p0 = f32[1024,1024] parameter(0)
+      a = f32[1024,1024] add(p0, p0)
+      n = f32[1024,1024] negate(a)
+      s = f32[1024,1024] sqrt(a)
+      ROOT t = (f32[1024,1024], f32[1024,1024]) tuple(n, s)
+    })")
+                    .ValueOrDie();
+  HloComputation* entry = module->entry_computation();
+  HloInstruction* add = entry->GetInstructionWithName("a");
+  HloInstruction* negate = entry->GetInstructionWithName("n");
+  GpuPerformanceModel model = MakeModel();
+  GpuPerformanceModel::RunTimes times = model.EstimateRunTimes(add, {negate});
+  EXPECT_GE(times.time_fused, model.EstimateRunTime(add));
+}
+
+}  // namespace
+}  // namespace gpu
+}  // namespace xla
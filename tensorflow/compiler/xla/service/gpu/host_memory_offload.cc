@@ -0,0 +1,177 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/gpu/host_memory_offload.h"
+
+#include <algorithm>
+#include <memory>
+
+#include "absl/algorithm/container.h"
+#include "tensorflow/compiler/xla/service/buffer_value.h"
+#include "tensorflow/compiler/xla/service/gpu/gpu_constants.h"
+#include "tensorflow/compiler/xla/service/hlo_alias_analysis.h"
+#include "tensorflow/compiler/xla/service/hlo_buffer.h"
+#include "tensorflow/compiler/xla/service/hlo_cost_analysis.h"
+#include "tensorflow/compiler/xla/service/hlo_live_range.h"
+#include "tensorflow/compiler/xla/service/hlo_memory_scheduler.h"
+#include "tensorflow/compiler/xla/service/hlo_value.h"
+#include "tensorflow/compiler/xla/service/memory_space_assignment.h"
+#include "tensorflow/compiler/xla/shape_util.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace xla {
+namespace gpu {
+
+namespace {
+
+// The memory space MemorySpaceAssignment tags the buffers it keeps in device
+// memory with. Device memory is memory space 0 once the pass is done.
+constexpr int64 kDeviceResidentMemorySpace = 2;
+
+// Returns whether 'value' is live in device memory for the whole program,
+// outside of the control of memory space assignment.
+bool MustStayInDeviceMemory(const HloValue& value) {
+  const HloInstruction* instruction = value.defining_instruction();
+  const HloComputation* entry = instruction->GetModule()->entry_computation();
+  return value.live_out_of_module() ||
+         instruction->opcode() == HloOpcode::kConstant ||
+         (instruction->opcode() == HloOpcode::kParameter &&
+          instruction->parent() == entry);
+}
+
+// Returns whether any position of the buffer is in 'memory_space'.
+bool HasPositionInMemorySpace(const HloBuffer& buffer, int64 memory_space) {
+  for (const HloValue* value : buffer.values()) {
+    for (const HloPosition& position : value->positions()) {
+      const Shape& shape = position.shape();
+      if (shape.has_layout() && shape.layout().memory_space() == memory_space) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+}  // namespace
+
+StatusOr<bool> HostMemoryOffload::Run(HloModule* module) {
+  if (options_.device_memory_limit_bytes <= 0) {
+    return false;
+  }
+  const int64 pointer_size = options_.pointer_size;
+  auto size_fn = [pointer_size](const BufferValue& buffer) {
+    return ShapeUtil::ByteSizeOf(buffer.shape(), pointer_size);
+  };
+  if (!module->has_schedule()) {
+    TF_ASSIGN_OR_RETURN(HloSchedule schedule, ScheduleModule(module, size_fn));
+    TF_RETURN_IF_ERROR(module->set_schedule(std::move(schedule)));
+  }
+
+  // The buffers which must stay in device memory take their share of the limit
+  // for the whole program.
+  TF_ASSIGN_OR_RETURN(
+      std::unique_ptr<HloAliasAnalysis> alias_analysis,
+      HloAliasAnalysis::Run(module, options_.can_share_buffer));
+  int64 reserved_bytes = 0;
+  for (const HloBuffer& buffer : alias_analysis->buffers()) {
+    if (absl::c_any_of(buffer.values(), [](const HloValue* value) {
+          return MustStayInDeviceMemory(*value);
+        })) {
+      reserved_bytes += ShapeUtil::ByteSizeOf(buffer.values()[0]->shape(),
+                                              pointer_size);
+    }
+  }
+  if (reserved_bytes >= options_.device_memory_limit_bytes) {
+    LOG(WARNING) << "The parameters, constants and results of "
+                 << module->name() << " take " << reserved_bytes
+                 << " bytes, at least the device memory limit of "
+                 << options_.device_memory_limit_bytes
+                 << " bytes; all other buffers are held in host memory.";
+  }
+
+  HloCostAnalysis hlo_cost_analysis(
+      [pointer_size](const Shape& shape) {
+        return ShapeUtil::ByteSizeOf(shape, pointer_size);
+      });
+  hlo_cost_analysis.set_flops_per_second(options_.flops_per_second);
+  hlo_cost_analysis.set_transcendentals_per_second(
+      options_.transcendentals_per_second);
+  hlo_cost_analysis.set_bytes_per_second(
+      options_.host_link_bandwidth_bytes_per_second);
+  for (HloComputation* computation : module->MakeNonfusionComputations()) {
+    TF_RETURN_IF_ERROR(computation->Accept(&hlo_cost_analysis));
+  }
+  TF_ASSIGN_OR_RETURN(
+      std::unique_ptr<MemorySpaceAssignmentCostAnalysis> cost_analysis,
+      MemorySpaceAssignmentCostAnalysis::Create(
+          hlo_cost_analysis, options_.host_link_bandwidth_bytes_per_second,
+          options_.device_memory_bandwidth_bytes_per_second, *module));
+  CostAnalysisPrefetchIntervalPicker prefetch_interval_picker(
+      *cost_analysis, /*min_async_copy_to_overlap_ratio=*/0.8,
+      /*max_async_copy_to_overlap_ratio=*/10.0,
+      /*preferred_async_copy_to_overlap_ratio=*/1.5);
+  MemorySpaceAssignmentCostAnalysis::Cache cache;
+
+  MemorySpaceAssignment::Options options;
+  options.alternate_memory_space = kDeviceResidentMemorySpace;
+  options.max_size_in_bytes =
+      std::max<int64>(0, options_.device_memory_limit_bytes - reserved_bytes);
+  options.alignment_in_bytes = kXlaAllocatedBufferAlignBytes;
+  options.buffer_interval_compare =
+      MemorySpaceAssignment::GetMemoryBoundednessBufferIntervalCompare(
+          *cost_analysis, &cache);
+  options.prefetch_interval_picker = &prefetch_interval_picker;
+  options.size_fn = size_fn;
+  options.is_allowed_in_alternate_mem_fn = [](const HloValue& value) {
+    return !MustStayInDeviceMemory(value);
+  };
+  options.enable_cross_program_prefetch = false;
+
+  const int64 instruction_count_before = module->instruction_count();
+  TF_ASSIGN_OR_RETURN(std::unique_ptr<HloLiveRange> hlo_live_range,
+                      HloLiveRange::Run(module->schedule(), *alias_analysis,
+                                        module->entry_computation()));
+  TF_RETURN_IF_ERROR(MemorySpaceAssignment::Run(module, *hlo_live_range,
+                                                *alias_analysis, options)
+                         .status());
+
+  // Memory space assignment tagged the buffers it kept in device memory, and
+  // left the others in its default memory, which is host memory here.
+  TF_ASSIGN_OR_RETURN(
+      alias_analysis, HloAliasAnalysis::Run(module, options_.can_share_buffer));
+  bool changed = module->instruction_count() != instruction_count_before;
+  for (const HloBuffer& buffer : alias_analysis->buffers()) {
+    const bool in_device_memory =
+        HasPositionInMemorySpace(buffer, kDeviceResidentMemorySpace) ||
+        absl::c_any_of(buffer.values(), [](const HloValue* value) {
+          return MustStayInDeviceMemory(*value);
+        });
+    const int64 memory_space = in_device_memory ? 0 : kHostMemorySpace;
+    changed |= memory_space == kHostMemorySpace;
+    for (const HloValue* value : buffer.values()) {
+      for (const HloPosition& position : value->positions()) {
+        Shape* shape = ShapeUtil::GetMutableSubshape(
+            position.instruction->mutable_shape(), position.index);
+        if (shape->IsArray()) {
+          shape->mutable_layout()->set_memory_space(memory_space);
+        }
+      }
+    }
+  }
+  return changed;
+}
+
+}  // namespace gpu
+}  // namespace xla
@@ -0,0 +1,73 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMPILER_XLA_SERVICE_GPU_HOST_MEMORY_OFFLOAD_H_
+#define TENSORFLOW_COMPILER_XLA_SERVICE_GPU_HOST_MEMORY_OFFLOAD_H_
+
+#include "tensorflow/compiler/xla/service/hlo_dataflow_analysis.h"
+#include "tensorflow/compiler/xla/service/hlo_module.h"
+#include "tensorflow/compiler/xla/service/hlo_pass_interface.h"
+#include "tensorflow/compiler/xla/statusor.h"
+
+namespace xla {
+namespace gpu {
+
+struct HostMemoryOffloadOptions {
+  // The most bytes of device memory the buffers of the module may use at once.
+  int64 device_memory_limit_bytes = 0;
+
+  int64 pointer_size = 8;
+
+  // The throughput of the device and of its link to the host. The defaults are
+  // those of a V100 on PCIe 3.0 x16.
+  float device_memory_bandwidth_bytes_per_second = 900e9;
+  float host_link_bandwidth_bytes_per_second = 12e9;
+  float flops_per_second = 15e12;
+  float transcendentals_per_second = 3.75e12;
+
+  // Used to compute the buffers of the module the way buffer assignment does.
+  HloDataflowAnalysis::CanShareBuffer can_share_buffer = nullptr;
+};
+
+// Keeps the buffers of a module resident in device memory within a limit, by
+// holding the others in pinned host memory (gpu::kHostMemorySpace) for some or
+// all of their lifetime. Buffers are evicted to host memory and prefetched back
+// with copy-start/copy-done pairs, which the GPU backend runs on a stream of
+// their own.
+//
+// This reuses MemorySpaceAssignment, with device memory as its limited
+// alternate memory and host memory as its default memory. The cost analysis
+// prefetch interval picker decides how early a prefetch starts to hide it
+// behind the kernels before the use. The parameters, constants and results of
+// the entry computation stay in device memory, and count against the limit for
+// the whole program.
+//
+// The module is scheduled if it is not already, and keeps the schedule with the
+// copies, which must be the launch order of the entry computation.
+class HostMemoryOffload : public HloModulePass {
+ public:
+  explicit HostMemoryOffload(const HostMemoryOffloadOptions& options)
+      : options_(options) {}
+  absl::string_view name() const override { return "host-memory-offload"; }
+  StatusOr<bool> Run(HloModule* module) override;
+
+ private:
+  HostMemoryOffloadOptions options_;
+};
+
+}  // namespace gpu
+}  // namespace xla
+
+#endif  // TENSORFLOW_COMPILER_XLA_SERVICE_GPU_HOST_MEMORY_OFFLOAD_H_
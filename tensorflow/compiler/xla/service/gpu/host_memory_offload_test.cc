@@ -0,0 +1,94 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/gpu/host_memory_offload.h"
+
+#include "tensorflow/compiler/xla/service/gpu/gpu_constants.h"
+#include "tensorflow/compiler/xla/service/hlo_computation.h"
+#include "tensorflow/compiler/xla/service/hlo_instruction.h"
+#include "tensorflow/compiler/xla/tests/hlo_test_base.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+
+namespace xla {
+namespace gpu {
+namespace {
+
+// 'a' is live from the start of the computation to its end, and every array
+// is 4KiB.
+const char* const kLongLivedBufferHlo = R"(
+  HloModule m
+
+  ENTRY entry {
+    p0 = f32[1024] parameter(0)
+    a = f32[1024] negate(p0)
+    b = f32[1024] exponential(p0)
+    c = f32[1024] tanh(b)
+    d = f32[1024] sqrt(c)
+    e = f32[1024] log(d)
+    ROOT f = f32[1024] add(a, e)
+  })";
+
+class HostMemoryOffloadTest : public HloTestBase {
+ protected:
+  static int64 MemorySpaceOf(HloModule* module, absl::string_view name) {
+    HloInstruction* hlo =
+        module->entry_computation()->GetInstructionWithName(name);
+    CHECK(hlo != nullptr) << name;
+    return hlo->shape().layout().memory_space();
+  }
+};
+
+TEST_F(HostMemoryOffloadTest, OffloadsBuffersOverTheLimit) {
+  TF_ASSERT_OK_AND_ASSIGN(auto module,
+                          ParseAndReturnVerifiedModule(kLongLivedBufferHlo));
+  HostMemoryOffloadOptions options;
+  // The parameter and the result take all but a few bytes of the limit.
+  options.device_memory_limit_bytes = 2 * 4096 + 16;
+  TF_ASSERT_OK_AND_ASSIGN(bool changed,
+                          HostMemoryOffload(options).Run(module.get()));
+  EXPECT_TRUE(changed);
+  EXPECT_TRUE(module->has_schedule());
+  EXPECT_EQ(MemorySpaceOf(module.get(), "p0"), 0);
+  EXPECT_EQ(MemorySpaceOf(module.get(), "f"), 0);
+  EXPECT_EQ(MemorySpaceOf(module.get(), "a"), kHostMemorySpace);
+}
+
+TEST_F(HostMemoryOffloadTest, KeepsBuffersWithinTheLimitOnDevice) {
+  TF_ASSERT_OK_AND_ASSIGN(auto module,
+                          ParseAndReturnVerifiedModule(kLongLivedBufferHlo));
+  HostMemoryOffloadOptions options;
+  options.device_memory_limit_bytes = int64{1} << 30;
+  TF_ASSERT_OK_AND_ASSIGN(bool changed,
+                          HostMemoryOffload(options).Run(module.get()));
+  EXPECT_FALSE(changed);
+  for (const HloInstruction* hlo :
+       module->entry_computation()->instructions()) {
+    EXPECT_EQ(hlo->shape().layout().memory_space(), 0) << hlo->ToString();
+  }
+}
+
+TEST_F(HostMemoryOffloadTest, NoLimitIsNoOp) {
+  TF_ASSERT_OK_AND_ASSIGN(auto module,
+                          ParseAndReturnVerifiedModule(kLongLivedBufferHlo));
+  HostMemoryOffloadOptions options;
+  TF_ASSERT_OK_AND_ASSIGN(bool changed,
+                          HostMemoryOffload(options).Run(module.get()));
+  EXPECT_FALSE(changed);
+  EXPECT_FALSE(module->has_schedule());
+}
+
+}  // namespace
+}  // namespace gpu
+}  // namespace xla
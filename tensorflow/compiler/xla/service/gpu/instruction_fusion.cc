@@ -84,7 +84,7 @@ bool GpuInstructionFusion::ShouldFuse(HloInstruction* consumer,
             << " of " << consumer->ToString();
     return false;
   }
-  auto producer = consumer->operand(operand_index);
+  auto producer = consumer->mutable_operand(operand_index);
 
   // The following checks are potentially expensive.
   if (FusionWouldBeTooLarge(*consumer, *producer)) {
@@ -92,6 +92,17 @@ bool GpuInstructionFusion::ShouldFuse(HloInstruction* consumer,
             << consumer->ToString() << ") would be too large";
     return false;
   }
+  if (performance_model_.has_value()) {
+    const GpuPerformanceModel::RunTimes run_times =
+        performance_model_->EstimateRunTimes(producer, {consumer});
+    if (run_times.time_fused > run_times.time_unfused) {
+      VLOG(5) << "Fusion of (" << producer->ToString() << ") into ("
+              << consumer->ToString() << ") is estimated to run in "
+              << absl::FormatDuration(run_times.time_fused) << " instead of "
+              << absl::FormatDuration(run_times.time_unfused);
+      return false;
+    }
+  }
   if (consumer->opcode() != HloOpcode::kFusion) {
     return true;
   }
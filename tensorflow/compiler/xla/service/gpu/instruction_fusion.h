@@ -17,7 +17,9 @@ limitations under the License.
 #define TENSORFLOW_COMPILER_XLA_SERVICE_GPU_INSTRUCTION_FUSION_H_
 
 #include "absl/container/flat_hash_map.h"
+#include "absl/types/optional.h"
 #include "tensorflow/compiler/xla/service/fusion_node_indexing_evaluation.h"
+#include "tensorflow/compiler/xla/service/gpu/gpu_performance_model.h"
 #include "tensorflow/compiler/xla/service/hlo_instruction.h"
 #include "tensorflow/compiler/xla/service/instruction_fusion.h"
 
@@ -26,8 +28,13 @@ namespace gpu {
 
 class GpuInstructionFusion : public InstructionFusion {
  public:
-  explicit GpuInstructionFusion(bool may_duplicate)
-      : InstructionFusion(GpuInstructionFusion::IsExpensive, may_duplicate) {}
+  // Given a performance model, producers are only fused into consumers if the
+  // model does not estimate the fusion to run slower.
+  explicit GpuInstructionFusion(
+      bool may_duplicate,
+      absl::optional<GpuPerformanceModel> performance_model = absl::nullopt)
+      : InstructionFusion(GpuInstructionFusion::IsExpensive, may_duplicate),
+        performance_model_(std::move(performance_model)) {}
 
   static bool IsExpensive(const HloInstruction& instruction);
 
@@ -57,6 +64,8 @@ class GpuInstructionFusion : public InstructionFusion {
   // indexed with different index vectors.
   absl::flat_hash_map<const HloInstruction*, FusionNodeIndexingEvaluation>
       fusion_node_evaluations_;
+
+  absl::optional<GpuPerformanceModel> performance_model_;
 };
 
 }  // namespace gpu
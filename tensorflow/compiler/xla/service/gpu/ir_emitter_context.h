@@ -16,6 +16,9 @@ limitations under the License.
 #ifndef TENSORFLOW_COMPILER_XLA_SERVICE_GPU_IR_EMITTER_CONTEXT_H_
 #define TENSORFLOW_COMPILER_XLA_SERVICE_GPU_IR_EMITTER_CONTEXT_H_
 
+#include <string>
+
+#include "absl/container/flat_hash_map.h"
 #include "llvm/IR/Module.h"
 #include "mlir/IR/MLIRContext.h"  // from @llvm-project
 #include "tensorflow/compiler/xla/service/buffer_assignment.h"
@@ -64,6 +67,19 @@ class IrEmitterContext {
   llvm::Module* llvm_module() { return llvm_module_; }
   NameUniquer* name_uniquer() { return &name_uniquer_; }
 
+  // A kernel emitted for a loop fusion, for the loop fusions of the module
+  // which are identical to it up to the buffers they access.
+  struct ReusableKernel {
+    std::string kernel_name;
+    LaunchDimensions launch_dimensions;
+  };
+
+  // The kernels emitted for loop fusions, keyed by the fingerprint of the
+  // fusion and of how its buffers are passed to the kernel.
+  absl::flat_hash_map<std::string, ReusableKernel>* reusable_kernels() {
+    return &reusable_kernels_;
+  }
+
  private:
   const HloModule* hlo_module_;
   const BufferAssignment* buffer_assignment_;
@@ -74,6 +90,7 @@ class IrEmitterContext {
   mlir::MLIRContext* mlir_context_;
   llvm::Module* llvm_module_;
   NameUniquer name_uniquer_;
+  absl::flat_hash_map<std::string, ReusableKernel> reusable_kernels_;
 };
 
 }  // namespace gpu
@@ -805,7 +805,7 @@ Status IrEmitterUnnested::HandleFusion(HloInstruction* fusion) {
     return Status::OK();
   }
 
-  return IrEmitter::HandleFusion(fusion);
+  return EmitLoopFusion(fusion);
 }
 
 Status IrEmitterUnnested::HandleCopy(HloInstruction* copy) {
@@ -835,6 +835,26 @@ Status IrEmitterUnnested::HandleCopy(HloInstruction* copy) {
   return IrEmitter::HandleCopy(copy);
 }
 
+Status IrEmitterUnnested::HandleCopyStart(HloInstruction* copy_start) {
+  // The copy runs on the stream of the copy-start, which may differ from the
+  // stream of its users. The copy-done has no thunk; the users of it wait for
+  // the copy-start instead.
+  auto source_buffer = GetAllocationSlice(*copy_start->operand(0));
+  auto destination_buffer = GetAllocationSlice(*copy_start, {0});
+  if (source_buffer != destination_buffer) {
+    AddThunkToThunkSequence(absl::make_unique<DeviceToDeviceCopyThunk>(
+        GetThunkInfo(copy_start),
+        /*source_address=*/source_buffer,
+        /*destination_buffer=*/destination_buffer,
+        /*mem_size=*/ByteSizeOf(copy_start->operand(0)->shape())));
+  }
+  return Status::OK();
+}
+
+Status IrEmitterUnnested::HandleCopyDone(HloInstruction*) {
+  return Status::OK();
+}
+
 Status IrEmitterUnnested::EmitExtraOutputsForReduce(
     const HloInstruction* unnested_hlo, const IrArray::Index& index,
     bool use_linear_index,
@@ -1852,14 +1872,13 @@ static std::vector<HloBufferSlice> GetHloBufferSlices(
   return result;
 }
 
-std::unique_ptr<KernelThunk>
-IrEmitterUnnested::BuildKernelThunkFromBufferSlices(
-    absl::string_view name, Thunk::ThunkInfo thunk_info,
+// Returns the buffer allocations passed as arguments to the kernel which
+// accesses `slices`, in the order of the kernel parameters, and sets
+// `temp_buffer` to the XLA temp buffer if we have it.
+static std::vector<const BufferAllocation*> GetKernelArgumentAllocations(
+    const BufferAssignment& buffer_assn,
     absl::Span<const BufferSlice* const> slices,
-    std::function<void(const BufferSlice*, llvm::Value*)>
-        bind_slice_to_ir_value) {
-  const auto& buffer_assn = ir_emitter_context_->buffer_assignment();
-
+    absl::optional<const BufferAllocation*>* temp_buffer) {
   // Figure out which buffer allocations need to be passed as arguments to our
   // kernel.  This is simply all of the allocations referenced in slices,
   // plus the XLA temp buffer (if we have it).  We always include the temp
@@ -1869,18 +1888,17 @@ IrEmitterUnnested::BuildKernelThunkFromBufferSlices(
   for (auto* slice : slices) {
     buffers_needed.insert(slice->buffer_slice.allocation());
   }
-  absl::optional<const BufferAllocation*> temp_buffer;
   for (const BufferAllocation& alloc : buffer_assn.Allocations()) {
     if (alloc.IsPreallocatedTempBuffer()) {
-      if (!temp_buffer.has_value()) {
-        temp_buffer = &alloc;
+      if (!temp_buffer->has_value()) {
+        *temp_buffer = &alloc;
       } else {
         LOG(FATAL) << "Multiple temp buffers found, but only one is allowed!";
       }
     }
   }
-  if (temp_buffer.has_value()) {
-    buffers_needed.insert(*temp_buffer);
+  if (temp_buffer->has_value()) {
+    buffers_needed.insert(**temp_buffer);
   }
 
   // We'll pass a pointer to each of the elements of `buffers` to our kernel, in
@@ -1895,6 +1913,51 @@ IrEmitterUnnested::BuildKernelThunkFromBufferSlices(
                [](const BufferAllocation* a, const BufferAllocation* b) {
                  return a->index() < b->index();
                });
+  return non_constant_buffers;
+}
+
+// Returns a fingerprint of the kernel emitted for the loop fusion `fusion`,
+// which accesses `slices` through the kernel parameters `kernel_args`. It is
+// made of the canonical text of the fused computation, which includes the
+// shapes and layouts of its parameters and of its root, and of how each slice
+// is found from the kernel parameters. Two loop fusions with the same
+// fingerprint are emitted as the same kernel, up to the buffers passed to it.
+static std::string GetLoopFusionKernelFingerprint(
+    const HloInstruction& fusion, absl::Span<const BufferSlice* const> slices,
+    absl::Span<const BufferAllocation* const> kernel_args) {
+  std::string fingerprint = fusion.fused_instructions_computation()->ToString(
+      HloPrintOptions::Fingerprint().set_print_large_constants(true));
+  for (const BufferAllocation* alloc : kernel_args) {
+    absl::StrAppend(
+        &fingerprint, "\nparameter size=", alloc->size(),
+        " entry_parameter=", alloc->is_entry_computation_parameter(),
+        " temp=", alloc->IsPreallocatedTempBuffer());
+  }
+  for (const BufferSlice* slice : slices) {
+    const BufferAllocation* alloc = slice->buffer_slice.allocation();
+    if (alloc->is_constant()) {
+      absl::StrAppend(&fingerprint, "\nconstant ", alloc->index());
+    } else {
+      absl::StrAppend(&fingerprint, "\nparameter ",
+                      absl::c_find(kernel_args, alloc) - kernel_args.begin());
+    }
+    absl::StrAppend(&fingerprint, " offset=", slice->buffer_slice.offset(),
+                    " size=", slice->buffer_slice.size(),
+                    " gte_index=", slice->gte_index.ToString());
+  }
+  return fingerprint;
+}
+
+std::unique_ptr<KernelThunk>
+IrEmitterUnnested::BuildKernelThunkFromBufferSlices(
+    absl::string_view name, Thunk::ThunkInfo thunk_info,
+    absl::Span<const BufferSlice* const> slices,
+    std::function<void(const BufferSlice*, llvm::Value*)>
+        bind_slice_to_ir_value) {
+  absl::optional<const BufferAllocation*> temp_buffer;
+  std::vector<const BufferAllocation*> non_constant_buffers =
+      GetKernelArgumentAllocations(ir_emitter_context_->buffer_assignment(),
+                                   slices, &temp_buffer);
 
   llvm::Function* kernel = BuildKernelPrototype(name, non_constant_buffers);
 
@@ -1998,6 +2061,44 @@ std::unique_ptr<KernelThunk> IrEmitterUnnested::BuildKernelThunk(
       });
 }
 
+Status IrEmitterUnnested::EmitLoopFusion(HloInstruction* fusion) {
+  // Loop fusions which only differ in the buffers they access, e.g. the same
+  // elementwise fusion applied to every layer of a model, share one kernel.
+  // This saves emitting, optimizing and compiling it to PTX again.
+  std::vector<HloBufferSlice> hlo_slices =
+      GetHloBufferSlices(fusion, ir_emitter_context_->buffer_assignment());
+  std::vector<const BufferSlice*> slice_ptrs;
+  slice_ptrs.reserve(hlo_slices.size());
+  for (auto& slice : hlo_slices) {
+    slice_ptrs.push_back(&slice);
+  }
+  absl::optional<const BufferAllocation*> temp_buffer;
+  std::vector<const BufferAllocation*> kernel_args =
+      GetKernelArgumentAllocations(ir_emitter_context_->buffer_assignment(),
+                                   slice_ptrs, &temp_buffer);
+  std::string fingerprint =
+      GetLoopFusionKernelFingerprint(*fusion, slice_ptrs, kernel_args);
+  auto* reusable_kernels = ir_emitter_context_->reusable_kernels();
+  auto it = reusable_kernels->find(fingerprint);
+  if (it != reusable_kernels->end()) {
+    VLOG(2) << "Reusing kernel " << it->second.kernel_name << " for "
+            << fusion->name();
+    auto kernel_thunk = absl::make_unique<KernelThunk>(
+        GetThunkInfo(fusion), kernel_args, it->second.kernel_name);
+    kernel_thunk->SetLaunchDimensions(it->second.launch_dimensions);
+    AddThunkToThunkSequence(std::move(kernel_thunk));
+    return Status::OK();
+  }
+
+  TF_RETURN_IF_ERROR(IrEmitter::HandleFusion(fusion));
+  const auto* kernel_thunk = static_cast<const KernelThunk*>(LastThunk());
+  reusable_kernels->emplace(
+      std::move(fingerprint),
+      IrEmitterContext::ReusableKernel{kernel_thunk->kernel_name(),
+                                       kernel_thunk->launch_dimensions()});
+  return Status::OK();
+}
+
 std::unique_ptr<KernelThunk> IrEmitterUnnested::BuildKernelThunkForMlir(
     absl::string_view name, Thunk::ThunkInfo thunk_info,
     absl::Span<const MlirBufferSlice> slices,
@@ -143,6 +143,8 @@ class IrEmitterUnnested : public IrEmitter,
   // IrEmitter. It also mixes in some special handling for custom kernels
   // via the ThunkEmitter.
   Status HandleCopy(HloInstruction* copy) override;
+  Status HandleCopyStart(HloInstruction* copy_start) override;
+  Status HandleCopyDone(HloInstruction* copy_done) override;
   Status HandleConditional(HloInstruction* conditional) override;
   Status HandleConvolution(HloInstruction* convolution) override;
   Status HandleCustomCall(HloInstruction* custom_call) override;
@@ -545,6 +547,10 @@ class IrEmitterUnnested : public IrEmitter,
   std::unique_ptr<KernelThunk> BuildKernelThunk(
       const HloInstruction* inst, bool implements_whole_instruction);
 
+  // Emits the loop fusion `fusion` as a kernel, or reuses the kernel emitted
+  // for an identical loop fusion of the module.
+  Status EmitLoopFusion(HloInstruction* fusion);
+
   std::unique_ptr<KernelThunk> BuildKernelThunkForMlir(
       absl::string_view name, Thunk::ThunkInfo thunk_info,
       absl::Span<const MlirBufferSlice> slices,
@@ -56,6 +56,9 @@ class KernelThunk : public Thunk {
 
   const string& kernel_name() const { return kernel_name_; }
   void SetLaunchDimensions(const LaunchDimensions& launch_dims);
+  const LaunchDimensions& launch_dimensions() const {
+    return launch_dimensions_;
+  }
 
   Status Initialize(const GpuExecutable& executable,
                     se::StreamExecutor* executor) override;
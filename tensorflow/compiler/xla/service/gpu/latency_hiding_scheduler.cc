@@ -0,0 +1,421 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/gpu/latency_hiding_scheduler.h"
+
+#include <algorithm>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "tensorflow/compiler/xla/map_util.h"
+#include "tensorflow/compiler/xla/service/hlo_opcode.h"
+#include "tensorflow/compiler/xla/shape_util.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace xla {
+namespace gpu {
+
+namespace {
+
+// Rough figures of a V100 with NVLink, in microseconds and bytes per
+// microsecond.
+constexpr double kKernelLaunchOverhead = 5;
+constexpr double kMemoryBytesPerMicrosecond = 900e3;
+constexpr double kCollectiveLatency = 20;
+constexpr double kInterconnectBytesPerMicrosecond = 25e3;
+constexpr double kHostBytesPerMicrosecond = 12e3;
+
+// Returns the bytes of the arrays in 'shape'.
+double ArrayBytes(const Shape& shape) {
+  double bytes = 0;
+  ShapeUtil::ForEachSubshape(
+      shape, [&](const Shape& subshape, const ShapeIndex& /*index*/) {
+        if (subshape.IsArray()) {
+          bytes += ShapeUtil::ByteSizeOf(subshape);
+        }
+      });
+  return bytes;
+}
+
+// Returns whether the result of 'hlo' is made of the buffers of its operands
+// rather than of a buffer of its own.
+bool IsAliasingOp(const HloInstruction& hlo) {
+  switch (hlo.opcode()) {
+    case HloOpcode::kBitcast:
+    case HloOpcode::kGetTupleElement:
+    case HloOpcode::kTuple:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Returns the instructions which must be launched before 'hlo'.
+std::vector<HloInstruction*> Predecessors(const HloInstruction& hlo) {
+  std::vector<HloInstruction*> predecessors(hlo.operands().begin(),
+                                            hlo.operands().end());
+  predecessors.insert(predecessors.end(), hlo.control_predecessors().begin(),
+                      hlo.control_predecessors().end());
+  std::sort(predecessors.begin(), predecessors.end());
+  predecessors.erase(std::unique(predecessors.begin(), predecessors.end()),
+                     predecessors.end());
+  return predecessors;
+}
+
+// Returns the instructions which must be launched after 'hlo'.
+std::vector<HloInstruction*> Successors(const HloInstruction& hlo) {
+  std::vector<HloInstruction*> successors(hlo.users().begin(),
+                                          hlo.users().end());
+  successors.insert(successors.end(), hlo.control_successors().begin(),
+                    hlo.control_successors().end());
+  std::sort(successors.begin(), successors.end());
+  successors.erase(std::unique(successors.begin(), successors.end()),
+                   successors.end());
+  return successors;
+}
+
+// Launches the instructions of a computation one at a time, and tracks when
+// every stream is free, when every result is available and which results are
+// live.
+class LaunchSimulator {
+ public:
+  LaunchSimulator(const HloComputation& computation,
+                  const StreamAssignment& stream_assignment,
+                  const LatencyEstimator& estimator,
+                  const BufferSizeFunction& buffer_size);
+
+  // Returns the instructions with no predecessors.
+  const std::vector<HloInstruction*>& initially_ready() const {
+    return initially_ready_;
+  }
+
+  // Returns the earliest time at which 'hlo' could start if launched next.
+  double EarliestStart(const HloInstruction& hlo) const;
+
+  // Returns the bytes 'hlo' allocates for its result.
+  int64 ResultBytes(const HloInstruction& hlo) const {
+    return IsAliasingOp(hlo) ? 0 : FindOrDie(buffer_bytes_, &hlo);
+  }
+
+  // Returns the change of the live bytes if 'hlo' were launched next, once
+  // its operands used for the last time are released.
+  int64 MemoryDelta(const HloInstruction& hlo) const;
+
+  // Launches 'hlo', and appends the instructions whose predecessors have now
+  // all been launched to 'ready'.
+  void Launch(const HloInstruction& hlo, std::vector<HloInstruction*>* ready);
+
+  double run_time() const { return run_time_; }
+  int64 live_bytes() const { return live_bytes_; }
+  int64 peak_memory_bytes() const { return peak_memory_bytes_; }
+
+ private:
+  // Returns the instructions whose buffers make up the operands of 'hlo'.
+  std::vector<const HloInstruction*> OperandOwners(
+      const HloInstruction& hlo) const;
+
+  const StreamAssignment& stream_assignment_;
+  const LatencyEstimator& estimator_;
+
+  // The time at which every stream finishes the instructions launched on it.
+  std::vector<double> stream_free_time_;
+  // The time at which the results of launched instructions are available.
+  absl::flat_hash_map<const HloInstruction*, double> available_time_;
+  // The number of predecessors of every instruction not launched yet.
+  absl::flat_hash_map<const HloInstruction*, int64> pending_predecessors_;
+  std::vector<HloInstruction*> initially_ready_;
+
+  // The instructions whose buffers make up the result of every instruction,
+  // which is the instruction itself unless it is an aliasing op.
+  absl::flat_hash_map<const HloInstruction*, std::vector<const HloInstruction*>>
+      owners_;
+  // The bytes of the buffer of every instruction.
+  absl::flat_hash_map<const HloInstruction*, int64> buffer_bytes_;
+  // The number of instructions not launched yet which use every buffer.
+  absl::flat_hash_map<const HloInstruction*, int64> remaining_uses_;
+  // The buffers of the result of the computation, which stay live.
+  absl::flat_hash_set<const HloInstruction*> output_owners_;
+
+  double run_time_ = 0;
+  int64 live_bytes_ = 0;
+  int64 peak_memory_bytes_ = 0;
+};
+
+LaunchSimulator::LaunchSimulator(const HloComputation& computation,
+                                 const StreamAssignment& stream_assignment,
+                                 const LatencyEstimator& estimator,
+                                 const BufferSizeFunction& buffer_size)
+    : stream_assignment_(stream_assignment),
+      estimator_(estimator),
+      stream_free_time_(stream_assignment.StreamCount(), 0) {
+  for (HloInstruction* hlo : computation.MakeInstructionPostOrder()) {
+    const int64 num_predecessors = Predecessors(*hlo).size();
+    pending_predecessors_[hlo] = num_predecessors;
+    if (num_predecessors == 0) {
+      initially_ready_.push_back(hlo);
+    }
+
+    std::vector<const HloInstruction*>& owners = owners_[hlo];
+    if (IsAliasingOp(*hlo)) {
+      owners = OperandOwners(*hlo);
+    } else {
+      owners.push_back(hlo);
+      buffer_bytes_[hlo] = buffer_size(*hlo);
+      remaining_uses_[hlo] = 0;
+    }
+    for (const HloInstruction* owner : OperandOwners(*hlo)) {
+      ++remaining_uses_[owner];
+    }
+  }
+  for (const HloInstruction* owner :
+       FindOrDie(owners_, computation.root_instruction())) {
+    output_owners_.insert(owner);
+  }
+}
+
+std::vector<const HloInstruction*> LaunchSimulator::OperandOwners(
+    const HloInstruction& hlo) const {
+  std::vector<const HloInstruction*> owners;
+  for (const HloInstruction* operand : hlo.operands()) {
+    const std::vector<const HloInstruction*>& operand_owners =
+        FindOrDie(owners_, operand);
+    owners.insert(owners.end(), operand_owners.begin(), operand_owners.end());
+  }
+  std::sort(owners.begin(), owners.end());
+  owners.erase(std::unique(owners.begin(), owners.end()), owners.end());
+  return owners;
+}
+
+double LaunchSimulator::EarliestStart(const HloInstruction& hlo) const {
+  double start = 0;
+  for (const HloInstruction* predecessor : Predecessors(hlo)) {
+    start = std::max(start, FindOrDie(available_time_, predecessor));
+  }
+  if (stream_assignment_.HasStreamAssigned(hlo)) {
+    start = std::max(
+        start, stream_free_time_[stream_assignment_.StreamNumberForHlo(hlo)]);
+  }
+  return start;
+}
+
+int64 LaunchSimulator::MemoryDelta(const HloInstruction& hlo) const {
+  int64 delta = ResultBytes(hlo);
+  for (const HloInstruction* owner : OperandOwners(hlo)) {
+    if (FindOrDie(remaining_uses_, owner) == 1 &&
+        !output_owners_.contains(owner)) {
+      delta -= FindOrDie(buffer_bytes_, owner);
+    }
+  }
+  return delta;
+}
+
+void LaunchSimulator::Launch(const HloInstruction& hlo,
+                             std::vector<HloInstruction*>* ready) {
+  const double start = EarliestStart(hlo);
+  const double finish = start + estimator_.RunTime(hlo);
+  if (stream_assignment_.HasStreamAssigned(hlo)) {
+    stream_free_time_[stream_assignment_.StreamNumberForHlo(hlo)] = finish;
+  }
+  available_time_[&hlo] = finish + estimator_.Latency(hlo);
+  run_time_ = std::max(run_time_, finish);
+
+  // The result of 'hlo' is allocated before its operands are released.
+  live_bytes_ += ResultBytes(hlo);
+  peak_memory_bytes_ = std::max(peak_memory_bytes_, live_bytes_);
+  std::vector<const HloInstruction*> released = OperandOwners(hlo);
+  if (!IsAliasingOp(hlo) && remaining_uses_[&hlo] == 0) {
+    ++remaining_uses_[&hlo];
+    released.push_back(&hlo);
+  }
+  for (const HloInstruction* owner : released) {
+    if (--remaining_uses_[owner] == 0 && !output_owners_.contains(owner)) {
+      live_bytes_ -= FindOrDie(buffer_bytes_, owner);
+    }
+  }
+
+  for (HloInstruction* successor : Successors(hlo)) {
+    if (--pending_predecessors_[successor] == 0) {
+      ready->push_back(successor);
+    }
+  }
+}
+
+}  // namespace
+
+double LatencyEstimator::RunTime(const HloInstruction& hlo) const {
+  switch (hlo.opcode()) {
+    case HloOpcode::kBitcast:
+    case HloOpcode::kConstant:
+    case HloOpcode::kGetTupleElement:
+    case HloOpcode::kParameter:
+    case HloOpcode::kTuple:
+    case HloOpcode::kCollectivePermuteDone:
+    case HloOpcode::kCopyDone:
+    case HloOpcode::kRecvDone:
+    case HloOpcode::kSendDone:
+      return 0;
+    case HloOpcode::kAllGather:
+    case HloOpcode::kAllReduce:
+    case HloOpcode::kAllToAll:
+    case HloOpcode::kCollectivePermute:
+      return kCollectiveLatency +
+             ArrayBytes(hlo.shape()) / kInterconnectBytesPerMicrosecond;
+    case HloOpcode::kCollectivePermuteStart:
+    case HloOpcode::kCopyStart:
+    case HloOpcode::kRecv:
+    case HloOpcode::kSend:
+      // Only the launch of the transfer occupies the stream.
+      return kKernelLaunchOverhead;
+    default: {
+      double bytes = ArrayBytes(hlo.shape());
+      for (const HloInstruction* operand : hlo.operands()) {
+        bytes += ArrayBytes(operand->shape());
+      }
+      return kKernelLaunchOverhead + bytes / kMemoryBytesPerMicrosecond;
+    }
+  }
+}
+
+double LatencyEstimator::Latency(const HloInstruction& hlo) const {
+  switch (hlo.opcode()) {
+    case HloOpcode::kCopyStart:
+      return ArrayBytes(hlo.operand(0)->shape()) / kHostBytesPerMicrosecond;
+    case HloOpcode::kCollectivePermuteStart:
+    case HloOpcode::kSend:
+      return kCollectiveLatency + ArrayBytes(hlo.operand(0)->shape()) /
+                                      kInterconnectBytesPerMicrosecond;
+    case HloOpcode::kRecv:
+      return kCollectiveLatency +
+             ArrayBytes(ShapeUtil::GetTupleElementShape(hlo.shape(), 0)) /
+                 kInterconnectBytesPerMicrosecond;
+    default:
+      return 0;
+  }
+}
+
+int64 DefaultBufferSize(const HloInstruction& hlo, int64 pointer_size) {
+  if (hlo.opcode() == HloOpcode::kParameter ||
+      hlo.opcode() == HloOpcode::kConstant || IsAliasingOp(hlo)) {
+    return 0;
+  }
+  int64 bytes = 0;
+  ShapeUtil::ForEachSubshape(
+      hlo.shape(), [&](const Shape& subshape, const ShapeIndex& /*index*/) {
+        bytes += ShapeUtil::ByteSizeOf(subshape, pointer_size);
+      });
+  return bytes;
+}
+
+SimulatedLaunchOrder SimulateLaunchOrder(
+    const HloComputation& computation,
+    absl::Span<HloInstruction* const> launch_order,
+    const StreamAssignment& stream_assignment,
+    const LatencyEstimator& estimator, const BufferSizeFunction& buffer_size) {
+  LaunchSimulator simulator(computation, stream_assignment, estimator,
+                            buffer_size);
+  std::vector<HloInstruction*> ready;
+  for (const HloInstruction* hlo : launch_order) {
+    simulator.Launch(*hlo, &ready);
+  }
+  SimulatedLaunchOrder result;
+  result.run_time = simulator.run_time();
+  result.peak_memory_bytes = simulator.peak_memory_bytes();
+  return result;
+}
+
+std::vector<HloInstruction*> LatencyHidingLaunchOrder(
+    const HloComputation& computation,
+    const StreamAssignment& stream_assignment,
+    const LatencyEstimator& estimator, const BufferSizeFunction& buffer_size,
+    int64 memory_limit_bytes) {
+  const std::vector<HloInstruction*> post_order =
+      computation.MakeInstructionPostOrder();
+  absl::flat_hash_map<const HloInstruction*, int64> position;
+  // The longest time from the start of every instruction to the end of the
+  // computation.
+  absl::flat_hash_map<const HloInstruction*, double> critical_path;
+  for (int64 i = post_order.size() - 1; i >= 0; --i) {
+    const HloInstruction* hlo = post_order[i];
+    position[hlo] = i;
+    double path = estimator.RunTime(*hlo);
+    for (const HloInstruction* successor : Successors(*hlo)) {
+      path = std::max(path, estimator.RunTime(*hlo) + estimator.Latency(*hlo) +
+                                FindOrDie(critical_path, successor));
+    }
+    critical_path[hlo] = path;
+  }
+
+  LaunchSimulator simulator(computation, stream_assignment, estimator,
+                            buffer_size);
+  std::vector<HloInstruction*> ready = simulator.initially_ready();
+  std::vector<HloInstruction*> launch_order;
+  launch_order.reserve(post_order.size());
+  while (!ready.empty()) {
+    struct Candidate {
+      int64 index;
+      bool fits;
+      int64 memory_delta;
+      double start;
+    };
+    auto better = [&](const Candidate& a, const Candidate& b) {
+      if (a.fits != b.fits) {
+        return a.fits;
+      }
+      if (!a.fits && a.memory_delta != b.memory_delta) {
+        return a.memory_delta < b.memory_delta;
+      }
+      if (a.start != b.start) {
+        return a.start < b.start;
+      }
+      const double a_path = FindOrDie(critical_path, ready[a.index]);
+      const double b_path = FindOrDie(critical_path, ready[b.index]);
+      if (a_path != b_path) {
+        return a_path > b_path;
+      }
+      return FindOrDie(position, ready[a.index]) <
+             FindOrDie(position, ready[b.index]);
+    };
+
+    Candidate best;
+    for (int64 i = 0; i < ready.size(); ++i) {
+      Candidate candidate;
+      candidate.index = i;
+      candidate.memory_delta = simulator.MemoryDelta(*ready[i]);
+      candidate.fits =
+          memory_limit_bytes < 0 ||
+          simulator.live_bytes() + simulator.ResultBytes(*ready[i]) <=
+              memory_limit_bytes;
+      candidate.start = simulator.EarliestStart(*ready[i]);
+      if (i == 0 || better(candidate, best)) {
+        best = candidate;
+      }
+    }
+
+    HloInstruction* hlo = ready[best.index];
+    ready[best.index] = ready.back();
+    ready.pop_back();
+    launch_order.push_back(hlo);
+    simulator.Launch(*hlo, &ready);
+  }
+  CHECK_EQ(launch_order.size(), post_order.size());
+  VLOG(2) << "Latency hiding launch order of " << computation.name()
+          << " has an estimated run time of " << simulator.run_time()
+          << "us and peak memory of " << simulator.peak_memory_bytes()
+          << " bytes";
+  return launch_order;
+}
+
+}  // namespace gpu
+}  // namespace xla
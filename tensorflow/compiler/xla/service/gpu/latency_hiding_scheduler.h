@@ -0,0 +1,95 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMPILER_XLA_SERVICE_GPU_LATENCY_HIDING_SCHEDULER_H_
+#define TENSORFLOW_COMPILER_XLA_SERVICE_GPU_LATENCY_HIDING_SCHEDULER_H_
+
+#include <functional>
+#include <vector>
+
+#include "absl/types/span.h"
+#include "tensorflow/compiler/xla/service/gpu/stream_assignment.h"
+#include "tensorflow/compiler/xla/service/hlo_computation.h"
+#include "tensorflow/compiler/xla/service/hlo_instruction.h"
+#include "tensorflow/compiler/xla/shape.h"
+#include "tensorflow/compiler/xla/types.h"
+
+namespace xla {
+namespace gpu {
+
+// Estimates how long HLO instructions take to run on a GPU, in microseconds.
+// The estimates only need to be good enough to tell which instructions are
+// worth overlapping: collectives and asynchronous transfers are slow compared
+// to kernels of the same size.
+class LatencyEstimator {
+ public:
+  virtual ~LatencyEstimator() = default;
+
+  // Returns the time 'hlo' occupies the stream it runs on.
+  virtual double RunTime(const HloInstruction& hlo) const;
+
+  // Returns the time from the completion of 'hlo' on its stream until its
+  // result is available to its users, e.g. the transfer a copy-start begins.
+  virtual double Latency(const HloInstruction& hlo) const;
+};
+
+// Returns the bytes an instruction allocates for its result.
+using BufferSizeFunction = std::function<int64(const HloInstruction&)>;
+
+// The bytes of the result of 'hlo', or zero if the result aliases other
+// buffers or is not allocated by the computation, as for parameters.
+int64 DefaultBufferSize(const HloInstruction& hlo, int64 pointer_size);
+
+// The run time and the memory use of a launch order, as estimated by
+// SimulateLaunchOrder.
+struct SimulatedLaunchOrder {
+  // The time at which the last instruction completes.
+  double run_time = 0;
+  // The most bytes the results of live instructions occupy at once.
+  int64 peak_memory_bytes = 0;
+};
+
+// Simulates launching the instructions of 'computation' in 'launch_order'.
+// Instructions on the same stream run one after another in launch order, and
+// instructions on different streams run concurrently once their operands are
+// available. A result is live from the launch of its instruction until all its
+// users, including through tuples, get-tuple-elements and bitcasts, have been
+// launched.
+SimulatedLaunchOrder SimulateLaunchOrder(
+    const HloComputation& computation,
+    absl::Span<HloInstruction* const> launch_order,
+    const StreamAssignment& stream_assignment,
+    const LatencyEstimator& estimator, const BufferSizeFunction& buffer_size);
+
+// Returns a launch order of the instructions of 'computation' which overlaps
+// slow instructions, such as collectives on a stream of their own and the
+// transfers of asynchronous start/done pairs, with independent work. It is a
+// list schedule driven by the same model as SimulateLaunchOrder: among the
+// instructions whose operands have been launched, it prefers the one which can
+// start the earliest, and then the one with the longest critical path to the
+// end of the computation. Once the live bytes would exceed
+// 'memory_limit_bytes', it launches the instructions which fit in the limit, or
+// failing that, which increase memory use the least. A negative limit disables
+// the check.
+std::vector<HloInstruction*> LatencyHidingLaunchOrder(
+    const HloComputation& computation,
+    const StreamAssignment& stream_assignment,
+    const LatencyEstimator& estimator, const BufferSizeFunction& buffer_size,
+    int64 memory_limit_bytes);
+
+}  // namespace gpu
+}  // namespace xla
+
+#endif  // TENSORFLOW_COMPILER_XLA_SERVICE_GPU_LATENCY_HIDING_SCHEDULER_H_
@@ -0,0 +1,181 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/gpu/latency_hiding_scheduler.h"
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "tensorflow/compiler/xla/service/gpu/stream_assignment.h"
+#include "tensorflow/compiler/xla/service/hlo_computation.h"
+#include "tensorflow/compiler/xla/service/hlo_instruction.h"
+#include "tensorflow/compiler/xla/tests/hlo_test_base.h"
+
+namespace xla {
+namespace gpu {
+namespace {
+
+class LatencyHidingSchedulerTest : public HloTestBase {
+ protected:
+  DebugOptions GetDebugOptionsForTest() override {
+    DebugOptions debug_options = HloTestBase::GetDebugOptionsForTest();
+    debug_options.set_xla_gpu_enable_latency_hiding_scheduler(true);
+    return debug_options;
+  }
+
+  SimulatedLaunchOrder Simulate(const HloComputation& computation,
+                                const std::vector<HloInstruction*>& order,
+                                const StreamAssignment& streams) {
+    return SimulateLaunchOrder(computation, order, streams, estimator_,
+                               buffer_size_);
+  }
+
+  std::vector<HloInstruction*> Schedule(const HloComputation& computation,
+                                        const StreamAssignment& streams,
+                                        int64 memory_limit_bytes) {
+    return LatencyHidingLaunchOrder(computation, streams, estimator_,
+                                    buffer_size_, memory_limit_bytes);
+  }
+
+  // Returns the position of the instruction named 'name' in 'order'.
+  static int64 Position(const std::vector<HloInstruction*>& order,
+                        absl::string_view name) {
+    auto it = std::find_if(
+        order.begin(), order.end(),
+        [&](const HloInstruction* hlo) { return hlo->name() == name; });
+    CHECK(it != order.end()) << name;
+    return it - order.begin();
+  }
+
+  LatencyEstimator estimator_;
+  BufferSizeFunction buffer_size_ = [](const HloInstruction& hlo) {
+    return DefaultBufferSize(hlo, /*pointer_size=*/8);
+  };
+};
+
+TEST_F(LatencyHidingSchedulerTest, OverlapsAllReduceWithIndependentKernels) {
+  auto module = ParseAndReturnVerifiedModule(R"(
+    HloModule m
+
+    add {
+      x = f32[] parameter(0)
+      y = f32[] parameter(1)
+      ROOT add = f32[] add(x, y)
+    }
+
+    ENTRY entry {
+      p0 = f32[1024,1024] parameter(0)
+      p1 = f32[1024,1024] parameter(1)
+      a = f32[1024,1024] negate(p0)
+      ar = f32[1024,1024] all-reduce(a), replica_groups={}, to_apply=add
+      b0 = f32[1024,1024] exponential(p1)
+      b1 = f32[1024,1024] exponential(b0)
+      b2 = f32[1024,1024] exponential(b1)
+      ROOT t = (f32[1024,1024], f32[1024,1024]) tuple(ar, b2)
+    })")
+                    .ValueOrDie();
+  const HloComputation& entry = *module->entry_computation();
+  std::unique_ptr<StreamAssignment> streams = AssignStreams(*module);
+  const HloInstruction* ar = entry.root_instruction()->operand(0);
+  const HloInstruction* b2 = entry.root_instruction()->operand(1);
+  EXPECT_NE(streams->StreamNumberForHlo(*ar), streams->StreamNumberForHlo(*b2));
+
+  // The operand of the all-reduce is launched first, so that the all-reduce
+  // runs while the exponentials do.
+  std::vector<HloInstruction*> order =
+      Schedule(entry, *streams, /*memory_limit_bytes=*/-1);
+  EXPECT_LT(Position(order, "a"), Position(order, "b0"));
+  EXPECT_LT(Position(order, "ar"), Position(order, "b1"));
+
+  // Launching the exponentials first delays the all-reduce.
+  std::vector<HloInstruction*> post_order = entry.MakeInstructionPostOrder();
+  std::vector<HloInstruction*> serial_order;
+  for (absl::string_view name :
+       {"p0", "p1", "b0", "b1", "b2", "a", "ar", "t"}) {
+    serial_order.push_back(post_order[Position(post_order, name)]);
+  }
+  EXPECT_LT(Simulate(entry, order, *streams).run_time,
+            Simulate(entry, serial_order, *streams).run_time);
+}
+
+TEST_F(LatencyHidingSchedulerTest, DefersDoneOfAsynchronousCopy) {
+  auto module = ParseAndReturnVerifiedModule(R"(
+    HloModule m
+
+    ENTRY entry {
+      p0 = f32[1024,1024] parameter(0)
+      p1 = f32[1024,1024] parameter(1)
+      cs = (f32[1024,1024], f32[1024,1024], u32[]) copy-start(p0)
+      cd = f32[1024,1024] copy-done(cs)
+      n = f32[1024,1024] negate(p1)
+      ROOT a = f32[1024,1024] add(cd, n)
+    })")
+                    .ValueOrDie();
+  const HloComputation& entry = *module->entry_computation();
+  std::unique_ptr<StreamAssignment> streams = AssignStreams(*module);
+
+  // The negate runs during the copy, between its start and its done.
+  std::vector<HloInstruction*> order =
+      Schedule(entry, *streams, /*memory_limit_bytes=*/-1);
+  EXPECT_LT(Position(order, "cs"), Position(order, "n"));
+  EXPECT_LT(Position(order, "n"), Position(order, "cd"));
+}
+
+TEST_F(LatencyHidingSchedulerTest, RespectsMemoryLimit) {
+  // Every broadcast is on the longest path to the end, so without a limit all
+  // of them are launched before the reduces which release them.
+  auto module = ParseAndReturnVerifiedModule(R"(
+    HloModule m
+
+    add {
+      x = f32[] parameter(0)
+      y = f32[] parameter(1)
+      ROOT add = f32[] add(x, y)
+    }
+
+    ENTRY entry {
+      p0 = f32[] parameter(0)
+      b0 = f32[1024,1024] broadcast(p0), dimensions={}
+      b1 = f32[1024,1024] broadcast(p0), dimensions={}
+      b2 = f32[1024,1024] broadcast(p0), dimensions={}
+      b3 = f32[1024,1024] broadcast(p0), dimensions={}
+      r0 = f32[] reduce(b0, p0), dimensions={0,1}, to_apply=add
+      r1 = f32[] reduce(b1, p0), dimensions={0,1}, to_apply=add
+      r2 = f32[] reduce(b2, p0), dimensions={0,1}, to_apply=add
+      r3 = f32[] reduce(b3, p0), dimensions={0,1}, to_apply=add
+      ROOT t = (f32[], f32[], f32[], f32[]) tuple(r0, r1, r2, r3)
+    })")
+                    .ValueOrDie();
+  const HloComputation& entry = *module->entry_computation();
+  std::unique_ptr<StreamAssignment> streams = AssignStreams(*module);
+  const int64 kBroadcastBytes = 1024 * 1024 * 4;
+
+  std::vector<HloInstruction*> unlimited =
+      Schedule(entry, *streams, /*memory_limit_bytes=*/-1);
+  EXPECT_GE(Simulate(entry, unlimited, *streams).peak_memory_bytes,
+            4 * kBroadcastBytes);
+
+  const int64 memory_limit = 2 * kBroadcastBytes + 1024;
+  std::vector<HloInstruction*> limited =
+      Schedule(entry, *streams, memory_limit);
+  EXPECT_LE(Simulate(entry, limited, *streams).peak_memory_bytes,
+            memory_limit);
+}
+
+}  // namespace
+}  // namespace gpu
+}  // namespace xla
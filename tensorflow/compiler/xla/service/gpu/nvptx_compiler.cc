@@ -20,6 +20,14 @@ limitations under the License.
 #include <fstream>
 
 #include "absl/base/call_once.h"
+#include "absl/strings/str_cat.h"
+#include "llvm/Bitcode/BitcodeReader.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/Support/Error.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Transforms/Utils/Cloning.h"
+#include "llvm/Transforms/Utils/SplitModule.h"
 #include "tensorflow/compiler/xla/service/algebraic_simplifier.h"
 #include "tensorflow/compiler/xla/service/dump.h"
 #include "tensorflow/compiler/xla/service/gpu/cublas_gemm_pad_for_tensor_cores.h"
@@ -32,6 +40,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/gpu/gpu_layout_assignment.h"
 #include "tensorflow/compiler/xla/service/gpu/ir_emission_utils.h"
 #include "tensorflow/compiler/xla/service/gpu/llvm_gpu_backend/gpu_backend_lib.h"
+#include "tensorflow/compiler/xla/service/gpu/persistent_cache_entry.h"
 #include "tensorflow/compiler/xla/service/gpu/stream_executor_util.h"
 #include "tensorflow/compiler/xla/service/gpu/target_constants.h"
 #include "tensorflow/compiler/xla/service/hlo_constant_folding.h"
@@ -46,7 +55,12 @@ limitations under the License.
 #include "tensorflow/compiler/xla/util.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
 #include "tensorflow/core/platform/cuda_libdevice_path.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/fingerprint.h"
+#include "tensorflow/core/platform/random.h"
+#include "tensorflow/core/platform/threadpool.h"
 #include "tensorflow/core/platform/tracing.h"
 #include "tensorflow/core/profiler/lib/traceme.h"
 #include "tensorflow/stream_executor/cuda/cuda_diagnostics.h"
@@ -184,9 +198,11 @@ namespace {
 absl::optional<bool> CanShareBufferHint(const HloInstruction* user,
                                         const HloInstruction* operand,
                                         const ShapeIndex& user_index) {
-  // Share the bias buffer with the parent instruction.
+  // Share the bias buffer with the parent instruction. The bias vector of a
+  // cuBLASLt epilogue does not have the shape of the output and is only read.
   if (IsCublasGemm(*user)) {
-    if (user->operand_count() == 3 && user->operand(2) == operand) {
+    if (user->operand_count() == 3 && user->operand(2) == operand &&
+        operand->shape() == user->shape()) {
       return true;
     }
   }
@@ -238,6 +254,70 @@ void WarnIfBadDriverJITVersion() {
   });
 }
 
+// Returns the path of the persistent cache entry of `llvm_module`, keyed by
+// everything that goes into its PTX and cubin: the unoptimized IR, the debug
+// options, the compute capability and libdevice.
+string PersistentCachePath(const HloModuleConfig& config,
+                           const llvm::Module& llvm_module,
+                           std::pair<int, int> compute_capability,
+                           const string& libdevice_dir) {
+  DebugOptions options = config.debug_options();
+  options.clear_xla_gpu_persistent_cache_dir();
+  string serialized_options;
+  tensorflow::SerializeToStringDeterministic(options, &serialized_options);
+  const tensorflow::Fprint128 fingerprint = tensorflow::Fingerprint128(
+      absl::StrCat(kPersistentCacheMagic, "\n", compute_capability.first, ".",
+                   compute_capability.second, "\n", libdevice_dir, "\n",
+                   serialized_options, "\n",
+                   llvm_ir::DumpModuleToString(llvm_module)));
+  return tensorflow::io::JoinPath(
+      config.debug_options().xla_gpu_persistent_cache_dir(),
+      absl::StrCat(absl::Hex(fingerprint.high64, absl::kZeroPad16),
+                   absl::Hex(fingerprint.low64, absl::kZeroPad16), ".xlagpu"));
+}
+
+// Reads the entry at `path`, returning false if there is none or it is
+// invalid.
+bool LoadFromPersistentCache(const string& path, string* ptx,
+                             std::vector<uint8>* cubin) {
+  tensorflow::Env* env = tensorflow::Env::Default();
+  if (!env->FileExists(path).ok()) return false;
+  string contents;
+  const Status status = tensorflow::ReadFileToString(env, path, &contents);
+  if (!status.ok()) {
+    LOG(WARNING) << "Could not read the XLA:GPU cache entry " << path << ": "
+                 << status;
+    return false;
+  }
+  if (!DecodePersistentCacheEntry(contents, ptx, cubin)) {
+    LOG(WARNING) << "Ignoring the malformed XLA:GPU cache entry " << path;
+    return false;
+  }
+  return true;
+}
+
+// Writes an entry at `path`, through a temporary file renamed in place so that
+// other processes never read a partial entry.
+void StoreInPersistentCache(const string& path, const string& ptx,
+                            const std::vector<uint8>& cubin) {
+  tensorflow::Env* env = tensorflow::Env::Default();
+  const string contents = EncodePersistentCacheEntry(ptx, cubin);
+
+  const string temp_path =
+      absl::StrCat(path, ".tmp", absl::Hex(tensorflow::random::New64()));
+  Status status = env->RecursivelyCreateDir(
+      string(tensorflow::io::Dirname(path)));
+  if (status.ok()) {
+    status = tensorflow::WriteStringToFile(env, temp_path, contents);
+  }
+  if (status.ok()) status = env->RenameFile(temp_path, path);
+  if (!status.ok()) {
+    LOG(WARNING) << "Could not write the XLA:GPU cache entry " << path << ": "
+                 << status;
+    env->DeleteFile(temp_path).IgnoreError();
+  }
+}
+
 // Try to load ptx from files defined in the FLAGS. If successful, return true.
 bool MaybeLoadPtxFromFile(const HloModule* module, std::string* ptx) {
   // If the xla_gpu_ptx_file options is set, be explicit when a file is used
@@ -317,6 +397,47 @@ NVPTXCompiler::CompileTargetBinary(const HloModule* module,
   }
   VLOG(2) << "Libdevice dir = " << libdevice_dir << "\n";
 
+  // A cached entry stands for the optimization of the IR, the PTX and the
+  // cubin all at once, and a split module is never optimized as a whole, so
+  // neither the cache nor splitting is used when any of them is replaced,
+  // hooked into or dumped.
+  const DebugOptions& debug_options = module->config().debug_options();
+  const bool needs_whole_module = !debug_options.xla_gpu_ptx_file().empty() ||
+                                  user_post_optimization_hook_ != nullptr ||
+                                  DumpingEnabledForHloModule(*module);
+  string cache_path;
+  if (!debug_options.xla_gpu_persistent_cache_dir().empty() &&
+      !needs_whole_module) {
+    cache_path = PersistentCachePath(module->config(), *llvm_module,
+                                     compute_capability, libdevice_dir);
+    string cached_ptx;
+    std::vector<uint8> cached_cubin;
+    if (LoadFromPersistentCache(cache_path, &cached_ptx, &cached_cubin)) {
+      VLOG(1) << "Loaded the PTX and cubin of " << module->name() << " from "
+              << cache_path;
+      return std::pair<std::string, std::vector<uint8>>(
+          std::move(cached_ptx), std::move(cached_cubin));
+    }
+  }
+
+  const int num_parts = debug_options.xla_gpu_force_compilation_parallelism();
+  if (num_parts > 1 && !needs_whole_module) {
+    StatusOr<std::pair<std::string, std::vector<uint8>>> result =
+        CompileInParallel(module, llvm_module, gpu_version, libdevice_dir,
+                          num_parts);
+    if (result.ok()) {
+      if (!cache_path.empty()) {
+        StoreInPersistentCache(cache_path, result.ValueOrDie().first,
+                               result.ValueOrDie().second);
+      }
+      return result;
+    }
+    // Linking needs nvlink, which is not in every CUDA installation.
+    LOG(WARNING) << "Compiling " << module->name() << " in " << num_parts
+                 << " parts failed, compiling it as a whole: "
+                 << result.status();
+  }
+
   string ptx;
   if (!MaybeLoadPtxFromFile(module, &ptx)) {
     XLA_SCOPED_LOGGING_TIMER(
@@ -340,10 +461,103 @@ NVPTXCompiler::CompileTargetBinary(const HloModule* module,
       stream_exec, ptx, compute_capability.first, compute_capability.second,
       module->config());
 
+  // An empty cubin leaves the compilation to the driver, which is not cached.
+  if (!cache_path.empty() && !cubin.empty()) {
+    StoreInPersistentCache(cache_path, ptx, cubin);
+  }
+
   return std::pair<std::string, std::vector<uint8>>(std::move(ptx),
                                                     std::move(cubin));
 }
 
+StatusOr<std::pair<std::string, std::vector<uint8>>>
+NVPTXCompiler::CompileInParallel(const HloModule* module,
+                                 llvm::Module* llvm_module,
+                                 GpuVersion gpu_version,
+                                 const string& libdevice_dir, int num_parts) {
+  XLA_SCOPED_LOGGING_TIMER("NVPTXCompiler::CompileInParallel");
+  std::pair<int, int> compute_capability =
+      absl::get<std::pair<int, int>>(gpu_version);
+
+  // An LLVMContext must not be used by several threads at once, so the parts
+  // are handed over as bitcode, which every thread reads into a context of
+  // its own. Functions sharing local symbols stay in the same part.
+  std::vector<std::string> part_bitcodes;
+  llvm::SplitModule(
+      llvm::CloneModule(*llvm_module), num_parts,
+      [&](std::unique_ptr<llvm::Module> part) {
+        std::string bitcode;
+        llvm::raw_string_ostream stream(bitcode);
+        llvm::WriteBitcodeToFile(*part, stream);
+        stream.flush();
+        part_bitcodes.push_back(std::move(bitcode));
+      },
+      /*PreserveLocals=*/true);
+
+  se::GpuAsmOpts relocatable_opts = PtxOptsFromConfig(module->config());
+  relocatable_opts.extra_flags.push_back("-c");
+  auto compile_part = [&](const std::string& bitcode)
+      -> StatusOr<std::pair<std::string, std::vector<uint8>>> {
+    llvm::LLVMContext context;
+    llvm::Expected<std::unique_ptr<llvm::Module>> part = llvm::parseBitcodeFile(
+        llvm::MemoryBufferRef(bitcode, module->name()), context);
+    if (!part) {
+      return InternalError("Couldn't read back a part of %s: %s",
+                           module->name(), llvm::toString(part.takeError()));
+    }
+    TF_ASSIGN_OR_RETURN(string ptx,
+                        nvptx::CompileToPtx(part->get(), gpu_version,
+                                            module->config(), libdevice_dir));
+    if (ptx.empty()) {
+      return std::pair<std::string, std::vector<uint8>>();
+    }
+    TF_ASSIGN_OR_RETURN(
+        std::vector<uint8> relocatable_cubin,
+        se::CompileGpuAsm(compute_capability.first, compute_capability.second,
+                          ptx.c_str(), relocatable_opts));
+    return std::make_pair(std::move(ptx), std::move(relocatable_cubin));
+  };
+
+  std::vector<StatusOr<std::pair<std::string, std::vector<uint8>>>> results(
+      part_bitcodes.size());
+  {
+    tensorflow::thread::ThreadPool thread_pool(tensorflow::Env::Default(),
+                                               "xla_gpu_compile",
+                                               part_bitcodes.size());
+    thread_pool.ParallelFor(
+        part_bitcodes.size(),
+        tensorflow::thread::ThreadPool::SchedulingParams(
+            tensorflow::thread::ThreadPool::SchedulingStrategy::
+                kFixedBlockSize,
+            /*cost_per_unit=*/absl::nullopt, /*block_size=*/1),
+        [&](int64 begin, int64 end) {
+          for (int64 i = begin; i < end; ++i) {
+            results[i] = compile_part(part_bitcodes[i]);
+          }
+        });
+  }
+
+  // The PTX of the parts is only kept for inspection, the executable loads
+  // the linked cubin.
+  string ptx;
+  std::vector<std::vector<uint8>> relocatable_cubins;
+  for (auto& result : results) {
+    TF_ASSIGN_OR_RETURN(auto part, std::move(result));
+    if (part.first.empty()) {
+      continue;
+    }
+    absl::StrAppend(&ptx, part.first, "\n");
+    relocatable_cubins.push_back(std::move(part.second));
+  }
+  TF_ASSIGN_OR_RETURN(
+      std::vector<uint8> cubin,
+      se::LinkGpuAsm(compute_capability.first, compute_capability.second,
+                     relocatable_cubins, PtxOptsFromConfig(module->config())));
+  VLOG(1) << "Compiled " << module->name() << " in "
+          << relocatable_cubins.size() << " parts";
+  return std::make_pair(std::move(ptx), std::move(cubin));
+}
+
 std::vector<uint8> NVPTXCompiler::CompileGpuAsmOrGetCachedResult(
     se::StreamExecutor* stream_exec, const string& ptx, int cc_major,
     int cc_minor, const HloModuleConfig& hlo_module_config) {
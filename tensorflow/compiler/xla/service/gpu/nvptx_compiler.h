@@ -65,6 +65,13 @@ class NVPTXCompiler : public GpuCompiler {
   string cached_cuda_data_dir_ TF_GUARDED_BY(mutex_);
   string cached_libdevice_dir_ TF_GUARDED_BY(mutex_);
 
+  // Splits llvm_module into up to num_parts parts, which are compiled to PTX
+  // and relocatable cubins in parallel, and links the cubins. Returns the PTX
+  // of all the parts and the linked cubin.
+  StatusOr<std::pair<std::string, std::vector<uint8>>> CompileInParallel(
+      const HloModule* module, llvm::Module* llvm_module,
+      GpuVersion gpu_version, const string& libdevice_dir, int num_parts);
+
   // Tries to compile the given ptx string to cubin.  Returns a vector with the
   // compiled cubin.  If compilation was unsuccessful, returns an empty vector.
   std::vector<uint8> CompileGpuAsmOrGetCachedResult(
@@ -0,0 +1,69 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/gpu/persistent_cache_entry.h"
+
+#include "tensorflow/core/lib/core/coding.h"
+#include "tensorflow/core/lib/hash/crc32c.h"
+
+namespace xla {
+namespace gpu {
+namespace {
+
+constexpr size_t kMagicSize = sizeof(kPersistentCacheMagic) - 1;
+constexpr size_t kHeaderSize = kMagicSize + 2 * sizeof(uint64) + sizeof(uint32);
+
+}  // namespace
+
+std::string EncodePersistentCacheEntry(absl::string_view ptx,
+                                       absl::Span<const uint8> cubin) {
+  std::string contents(kPersistentCacheMagic, kMagicSize);
+  tensorflow::core::PutFixed64(&contents, ptx.size());
+  tensorflow::core::PutFixed64(&contents, cubin.size());
+  uint32 crc = tensorflow::crc32c::Value(ptx.data(), ptx.size());
+  crc = tensorflow::crc32c::Extend(
+      crc, reinterpret_cast<const char*>(cubin.data()), cubin.size());
+  tensorflow::core::PutFixed32(&contents, tensorflow::crc32c::Mask(crc));
+  contents.append(ptx.data(), ptx.size());
+  contents.append(cubin.begin(), cubin.end());
+  return contents;
+}
+
+bool DecodePersistentCacheEntry(absl::string_view contents, std::string* ptx,
+                                std::vector<uint8>* cubin) {
+  if (contents.size() < kHeaderSize ||
+      contents.substr(0, kMagicSize) != kPersistentCacheMagic) {
+    return false;
+  }
+  const char* header = contents.data() + kMagicSize;
+  const uint64 ptx_size = tensorflow::core::DecodeFixed64(header);
+  const uint64 cubin_size =
+      tensorflow::core::DecodeFixed64(header + sizeof(uint64));
+  const uint32 masked_crc =
+      tensorflow::core::DecodeFixed32(header + 2 * sizeof(uint64));
+  const uint64 payload_size = contents.size() - kHeaderSize;
+  const char* payload = contents.data() + kHeaderSize;
+  if (ptx_size > payload_size || cubin_size != payload_size - ptx_size ||
+      tensorflow::crc32c::Unmask(masked_crc) !=
+          tensorflow::crc32c::Value(payload, payload_size)) {
+    return false;
+  }
+  ptx->assign(payload, ptx_size);
+  cubin->assign(payload + ptx_size, payload + payload_size);
+  return true;
+}
+
+}  // namespace gpu
+}  // namespace xla
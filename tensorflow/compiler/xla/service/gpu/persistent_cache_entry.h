@@ -0,0 +1,47 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMPILER_XLA_SERVICE_GPU_PERSISTENT_CACHE_ENTRY_H_
+#define TENSORFLOW_COMPILER_XLA_SERVICE_GPU_PERSISTENT_CACHE_ENTRY_H_
+
+#include <string>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "tensorflow/compiler/xla/types.h"
+
+namespace xla {
+namespace gpu {
+
+// The entries of the persistent cache of NVPTXCompiler (see
+// xla_gpu_persistent_cache_dir) are kPersistentCacheMagic, the fixed64 PTX and
+// cubin sizes and the masked crc32c of the PTX and cubin, followed by the PTX
+// and the cubin.
+constexpr char kPersistentCacheMagic[] = "XLAGPUC1";
+
+// Returns the entry holding `ptx` and `cubin`.
+std::string EncodePersistentCacheEntry(absl::string_view ptx,
+                                       absl::Span<const uint8> cubin);
+
+// Extracts the PTX and cubin of the entry. Returns false if `contents` don't
+// start with the magic, are truncated or fail the checksum.
+bool DecodePersistentCacheEntry(absl::string_view contents, std::string* ptx,
+                                std::vector<uint8>* cubin);
+
+}  // namespace gpu
+}  // namespace xla
+
+#endif  // TENSORFLOW_COMPILER_XLA_SERVICE_GPU_PERSISTENT_CACHE_ENTRY_H_
@@ -0,0 +1,84 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/gpu/persistent_cache_entry.h"
+
+#include "tensorflow/compiler/xla/test.h"
+
+namespace xla {
+namespace gpu {
+namespace {
+
+const char kPtx[] = ".version 6.0\n.target sm_70\n";
+const std::vector<uint8> kCubin = {0x7f, 'E', 'L', 'F', 0, 1, 2, 3};
+
+TEST(PersistentCacheEntryTest, RoundTrips) {
+  const std::string entry = EncodePersistentCacheEntry(kPtx, kCubin);
+  EXPECT_EQ(entry.compare(0, sizeof(kPersistentCacheMagic) - 1,
+                          kPersistentCacheMagic),
+            0);
+  std::string ptx;
+  std::vector<uint8> cubin;
+  ASSERT_TRUE(DecodePersistentCacheEntry(entry, &ptx, &cubin));
+  EXPECT_EQ(ptx, kPtx);
+  EXPECT_EQ(cubin, kCubin);
+}
+
+TEST(PersistentCacheEntryTest, RoundTripsEmptyCubin) {
+  const std::string entry = EncodePersistentCacheEntry(kPtx, {});
+  std::string ptx;
+  std::vector<uint8> cubin = kCubin;
+  ASSERT_TRUE(DecodePersistentCacheEntry(entry, &ptx, &cubin));
+  EXPECT_EQ(ptx, kPtx);
+  EXPECT_TRUE(cubin.empty());
+}
+
+TEST(PersistentCacheEntryTest, RejectsTruncatedEntries) {
+  const std::string entry = EncodePersistentCacheEntry(kPtx, kCubin);
+  std::string ptx;
+  std::vector<uint8> cubin;
+  for (size_t size = 0; size < entry.size(); ++size) {
+    EXPECT_FALSE(
+        DecodePersistentCacheEntry(entry.substr(0, size), &ptx, &cubin))
+        << "Accepted an entry truncated to " << size << " bytes";
+  }
+}
+
+TEST(PersistentCacheEntryTest, RejectsBadMagic) {
+  std::string entry = EncodePersistentCacheEntry(kPtx, kCubin);
+  entry[0] = 'Y';
+  std::string ptx;
+  std::vector<uint8> cubin;
+  EXPECT_FALSE(DecodePersistentCacheEntry(entry, &ptx, &cubin));
+}
+
+TEST(PersistentCacheEntryTest, RejectsCorruptedPayload) {
+  std::string entry = EncodePersistentCacheEntry(kPtx, kCubin);
+  entry.back() ^= 1;
+  std::string ptx;
+  std::vector<uint8> cubin;
+  EXPECT_FALSE(DecodePersistentCacheEntry(entry, &ptx, &cubin));
+}
+
+TEST(PersistentCacheEntryTest, RejectsTrailingBytes) {
+  const std::string entry = EncodePersistentCacheEntry(kPtx, kCubin) + "x";
+  std::string ptx;
+  std::vector<uint8> cubin;
+  EXPECT_FALSE(DecodePersistentCacheEntry(entry, &ptx, &cubin));
+}
+
+}  // namespace
+}  // namespace gpu
+}  // namespace xla
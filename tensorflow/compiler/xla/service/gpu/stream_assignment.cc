@@ -59,14 +59,29 @@ inline bool IsStreamNumValid(int stream_num) {
   return stream_num != kInvalidStreamNum;
 }
 
+// Returns whether `hlo` communicates with other devices.
+bool IsCollective(const HloInstruction& hlo) {
+  switch (hlo.opcode()) {
+    case HloOpcode::kAllGather:
+    case HloOpcode::kAllReduce:
+    case HloOpcode::kAllToAll:
+    case HloOpcode::kCollectivePermute:
+      return true;
+    default:
+      return false;
+  }
+}
+
 // Returns which existing stream to assign to `hlo`, or -1 if a stream is not
 // needed. `stream_assignment` is the existing stream assignment for all
 // instructions topologically before `hlo`. `seen_gemms` contains all GEMMs that
-// are topologically before `hlo`.
+// are topologically before `hlo`. `collective_stream_num`, if valid, is the
+// stream reserved for collectives and host memory offload copies.
 int ComputeStreamToAssign(
     const HloInstruction& hlo, const StreamAssignment& stream_assignment,
     const HloReachabilityMap& reachability,
-    const std::vector<const HloInstruction*>& seen_gemms) {
+    const std::vector<const HloInstruction*>& seen_gemms,
+    int collective_stream_num) {
   if (hlo.opcode() == HloOpcode::kParameter ||
       hlo.opcode() == HloOpcode::kConstant) {
     // kParameter and kConstant do not need a thunk.
@@ -89,7 +104,9 @@ int ComputeStreamToAssign(
     // avoid excessive synchronization.
     int stream_num = -1;
     for (const auto* operand : hlo.operands()) {
-      if (stream_assignment.HasStreamAssigned(*operand)) {
+      if (stream_assignment.HasStreamAssigned(*operand) &&
+          stream_assignment.StreamNumberForHlo(*operand) !=
+              collective_stream_num) {
         stream_num = std::max(stream_num,
                               stream_assignment.StreamNumberForHlo(*operand));
       }
@@ -105,6 +122,9 @@ int ComputeStreamToAssign(
   // streams assigned to GEMMs that are concurrent with `hlo`. Then, we assign
   // `hlo` a different stream.
   absl::flat_hash_set<int> forbidden_stream_numbers;
+  if (IsStreamNumValid(collective_stream_num)) {
+    forbidden_stream_numbers.insert(collective_stream_num);
+  }
   for (const auto* seen_gemm : seen_gemms) {
     int stream_num = stream_assignment.StreamNumberForHlo(*seen_gemm);
     if (!forbidden_stream_numbers.contains(stream_num) &&
@@ -137,14 +157,33 @@ std::unique_ptr<StreamAssignment> AssignStreams(const HloModule& module) {
   // TODO(b/111791052): If we remove such a common variable, we will need to
   // clean up the code here.
   int stream_num_for_rng = kInvalidStreamNum;
+  // The latency hiding scheduler runs collectives on a stream of their own, so
+  // that kernels independent of them can run while they communicate.
+  // Host memory offload does the same with its copies, so that they overlap
+  // the kernels before the uses of the prefetched values.
+  const DebugOptions& debug_options = module.config().debug_options();
+  const bool separate_collectives =
+      debug_options.xla_gpu_enable_latency_hiding_scheduler();
+  const bool separate_copies =
+      debug_options.xla_gpu_host_offload_device_memory_limit() > 0;
+  int stream_num_for_collectives = kInvalidStreamNum;
   for (const auto* hlo : computation.MakeInstructionPostOrder()) {
+    if ((separate_collectives && IsCollective(*hlo)) ||
+        (separate_copies && hlo->opcode() == HloOpcode::kCopyStart)) {
+      if (!IsStreamNumValid(stream_num_for_collectives)) {
+        stream_num_for_collectives = stream_assignment->StreamCount();
+      }
+      stream_assignment->AssignStreamToHlo(hlo, stream_num_for_collectives);
+      continue;
+    }
     // If we ever enable fusion of RNG instructions, we will need to extend this
     // code to look inside a fused instruction.
     int stream_num = (hlo->opcode() == HloOpcode::kRng &&
                       IsStreamNumValid(stream_num_for_rng))
                          ? stream_num_for_rng
                          : ComputeStreamToAssign(*hlo, *stream_assignment,
-                                                 *reachability, seen_gemms);
+                                                 *reachability, seen_gemms,
+                                                 stream_num_for_collectives);
     if (IsStreamNumValid(stream_num)) {
       stream_assignment->AssignStreamToHlo(hlo, stream_num);
       if (hlo->opcode() == HloOpcode::kRng &&
@@ -304,6 +304,119 @@ ENTRY AddDotsFunc {
   EXPECT_TRUE(RunAndCompare(hlo_text, ErrorSpec{1e-5, 1e-5}));
 }
 
+class CublasLtGemmRewriteTest : public GemmRewriteTest {
+  DebugOptions GetDebugOptionsForTest() override {
+    DebugOptions debug_options = GemmRewriteTest::GetDebugOptionsForTest();
+    debug_options.set_xla_gpu_enable_cublaslt(true);
+    return debug_options;
+  }
+};
+
+TEST_F(CublasLtGemmRewriteTest, BiasEpilogue) {
+  const char* hlo_text = R"(
+HloModule BiasEpilogue
+
+ENTRY AddDotsFunc {
+  x = f32[2,3] parameter(0)
+  y = f32[3,4] parameter(1)
+  z = f32[4] parameter(2)
+  dot_a = f32[2,4] dot(x, y), lhs_contracting_dims={1}, rhs_contracting_dims={0}
+  z_broadcast = f32[2,4] broadcast(z), dimensions={1}
+  ROOT out = f32[2,4] add(dot_a, z_broadcast)
+}
+
+)";
+
+  EXPECT_TRUE(RunAndCompare(hlo_text, ErrorSpec{1e-5, 1e-5}));
+  MatchOptimizedHlo(hlo_text,
+                    R"(
+
+; CHECK-LABEL: ENTRY %AddDotsFunc (x: f32[2,3], y: f32[3,4], z: f32[4]) -> f32[2,4] {
+; CHECK-NOT:     broadcast
+; CHECK:         ROOT %custom-call{{.*}} = f32[2,4]{1,0} custom-call(%x, %y, %z), custom_call_target="__cublas$gemm", backend_config="{{.*}}\"epilogue\":\"BIAS\"{{.*}}"
+      )");
+}
+
+TEST_F(CublasLtGemmRewriteTest, BiasReluEpilogue) {
+  const char* hlo_text = R"(
+HloModule BiasReluEpilogue
+
+ENTRY AddDotsFunc {
+  x = f32[2,3] parameter(0)
+  y = f32[3,4] parameter(1)
+  z = f32[4] parameter(2)
+  dot_a = f32[2,4] dot(x, y), lhs_contracting_dims={1}, rhs_contracting_dims={0}
+  z_broadcast = f32[2,4] broadcast(z), dimensions={1}
+  biased = f32[2,4] add(dot_a, z_broadcast)
+  zero = f32[] constant(0)
+  zero_broadcast = f32[2,4] broadcast(zero), dimensions={}
+  ROOT out = f32[2,4] maximum(biased, zero_broadcast)
+}
+
+)";
+
+  EXPECT_TRUE(RunAndCompare(hlo_text, ErrorSpec{1e-5, 1e-5}));
+  MatchOptimizedHlo(hlo_text,
+                    R"(
+
+; CHECK-LABEL: ENTRY %AddDotsFunc (x: f32[2,3], y: f32[3,4], z: f32[4]) -> f32[2,4] {
+; CHECK-NOT:     maximum
+; CHECK:         ROOT %custom-call{{.*}} = f32[2,4]{1,0} custom-call(%x, %y, %z), custom_call_target="__cublas$gemm", backend_config="{{.*}}\"epilogue\":\"BIAS_RELU\"{{.*}}"
+      )");
+}
+
+TEST_F(CublasLtGemmRewriteTest, ReluEpilogue) {
+  const char* hlo_text = R"(
+HloModule ReluEpilogue
+
+ENTRY AddDotsFunc {
+  x = f16[8,16] parameter(0)
+  y = f16[16,8] parameter(1)
+  dot_a = f16[8,8] dot(x, y), lhs_contracting_dims={1}, rhs_contracting_dims={0}
+  zero = f16[] constant(0)
+  zero_broadcast = f16[8,8] broadcast(zero), dimensions={}
+  ROOT out = f16[8,8] maximum(dot_a, zero_broadcast)
+}
+
+)";
+
+  EXPECT_TRUE(RunAndCompare(hlo_text, ErrorSpec{1e-3, 1e-3}));
+  MatchOptimizedHlo(hlo_text,
+                    R"(
+
+; CHECK-LABEL: ENTRY %AddDotsFunc (x: f16[8,16], y: f16[16,8]) -> f16[8,8] {
+; CHECK-NOT:     maximum
+; CHECK:         ROOT %custom-call{{.*}} = f16[8,8]{1,0} custom-call(%x, %y), custom_call_target="__cublas$gemm", backend_config="{{.*}}\"epilogue\":\"RELU\"{{.*}}"
+      )");
+}
+
+// A bias along the major dimension of the output is not a cuBLASLt bias, so it
+// is still folded into the beta operand of the gemm.
+TEST_F(CublasLtGemmRewriteTest, MajorDimensionBiasNoEpilogue) {
+  const char* hlo_text = R"(
+HloModule MajorDimensionBiasNoEpilogue
+
+ENTRY AddDotsFunc {
+  x = f32[2,3] parameter(0)
+  y = f32[3,4] parameter(1)
+  z = f32[2] parameter(2)
+  dot_a = f32[2,4] dot(x, y), lhs_contracting_dims={1}, rhs_contracting_dims={0}
+  z_broadcast = f32[2,4] broadcast(z), dimensions={0}
+  ROOT out = f32[2,4] add(dot_a, z_broadcast)
+}
+
+)";
+
+  EXPECT_TRUE(RunAndCompare(hlo_text, ErrorSpec{1e-5, 1e-5}));
+  MatchOptimizedHlo(hlo_text,
+                    R"(
+
+; CHECK-LABEL: ENTRY %AddDotsFunc (x: f32[2,3], y: f32[3,4], z: f32[2]) -> f32[2,4] {
+; CHECK:         ROOT %custom-call{{.*}} = f32[2,4]{1,0} custom-call(%x, %y, %{{.*}}), custom_call_target="__cublas$gemm", backend_config="{{.*}}\"beta\":1
+; CHECK-NOT:     epilogue
+      )");
+}
+
 }  // namespace
 }  // namespace gpu
 }  // namespace xla
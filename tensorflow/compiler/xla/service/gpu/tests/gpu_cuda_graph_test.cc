@@ -0,0 +1,123 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <memory>
+#include <vector>
+
+#include "tensorflow/compiler/xla/literal_util.h"
+#include "tensorflow/compiler/xla/service/executable.h"
+#include "tensorflow/compiler/xla/tests/hlo_test_base.h"
+#include "tensorflow/compiler/xla/tests/literal_test_util.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+
+namespace xla {
+namespace gpu {
+namespace {
+
+class CudaGraphTest : public HloTestBase {
+  DebugOptions GetDebugOptionsForTest() override {
+    DebugOptions debug_options = HloTestBase::GetDebugOptionsForTest();
+    debug_options.set_xla_gpu_enable_cuda_graphs(true);
+    return debug_options;
+  }
+};
+
+// Runs the same executable on the same arguments several times, so that its
+// thunks are captured into a graph and replayed whenever the buffers land at
+// the same addresses, and checks every result.
+TEST_F(CudaGraphTest, RepeatedRunsMatch) {
+  const char* hlo_text = R"(
+HloModule cuda_graph
+
+ENTRY main {
+  p0 = f32[2,2] parameter(0)
+  p1 = f32[2,2] parameter(1)
+  dot = f32[2,2] dot(p0, p1), lhs_contracting_dims={1}, rhs_contracting_dims={0}
+  ROOT add = f32[2,2] add(dot, p0)
+}
+)";
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<VerifiedHloModule> module,
+                          ParseAndReturnVerifiedModule(hlo_text));
+  TF_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<Executable> executable,
+      test_runner_.CreateExecutable(std::move(module),
+                                    /*run_hlo_passes=*/true));
+
+  Literal literals[] = {LiteralUtil::CreateR2<float>({{1, 2}, {3, 4}}),
+                        LiteralUtil::CreateR2<float>({{2, 0}, {0, 2}})};
+  std::vector<ScopedShapedBuffer> arguments;
+  for (const Literal& literal : literals) {
+    TF_ASSERT_OK_AND_ASSIGN(ScopedShapedBuffer buffer,
+                            test_runner_.TransferLiteralToDevice(literal));
+    arguments.push_back(std::move(buffer));
+  }
+
+  for (int run = 0; run < 4; ++run) {
+    TF_ASSERT_OK_AND_ASSIGN(
+        ExecutionOutput output,
+        test_runner_.ExecuteWithDeviceBuffers(executable.get(), arguments));
+    TF_ASSERT_OK_AND_ASSIGN(
+        Literal result,
+        test_runner_.TransferLiteralFromDevice(output.Result()));
+    LiteralTestUtil::ExpectR2Equal<float>({{3, 6}, {9, 12}}, result);
+  }
+}
+
+// Transfers the arguments anew for every run, so that the graph captured for
+// the first addresses is updated to the ones of later runs.
+TEST_F(CudaGraphTest, RunsWithMovingBuffersMatch) {
+  const char* hlo_text = R"(
+HloModule cuda_graph
+
+ENTRY main {
+  p0 = f32[4] parameter(0)
+  p1 = f32[4] parameter(1)
+  mul = f32[4] multiply(p0, p1)
+  ROOT add = f32[4] add(mul, p0)
+}
+)";
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<VerifiedHloModule> module,
+                          ParseAndReturnVerifiedModule(hlo_text));
+  TF_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<Executable> executable,
+      test_runner_.CreateExecutable(std::move(module),
+                                    /*run_hlo_passes=*/true));
+
+  // Earlier arguments are kept alive, so that later ones get new addresses.
+  std::vector<ScopedShapedBuffer> arguments;
+  for (int run = 0; run < 12; ++run) {
+    float x = run;
+    Literal literals[] = {LiteralUtil::CreateR1<float>({x, x, x, x}),
+                          LiteralUtil::CreateR1<float>({2, 2, 2, 2})};
+    for (const Literal& literal : literals) {
+      TF_ASSERT_OK_AND_ASSIGN(ScopedShapedBuffer buffer,
+                              test_runner_.TransferLiteralToDevice(literal));
+      arguments.push_back(std::move(buffer));
+    }
+    TF_ASSERT_OK_AND_ASSIGN(
+        ExecutionOutput output,
+        test_runner_.ExecuteWithDeviceBuffers(
+            executable.get(), absl::MakeConstSpan(arguments).last(2)));
+    TF_ASSERT_OK_AND_ASSIGN(
+        Literal result,
+        test_runner_.TransferLiteralFromDevice(output.Result()));
+    LiteralTestUtil::ExpectR1Equal<float>({3 * x, 3 * x, 3 * x, 3 * x},
+                                          result);
+  }
+}
+
+}  // namespace
+}  // namespace gpu
+}  // namespace xla
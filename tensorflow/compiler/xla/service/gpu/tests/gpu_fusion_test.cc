@@ -54,6 +54,39 @@ TEST_F(GpuFusionTest, FusedReshape) {
       )");
 }
 
+TEST_F(GpuFusionTest, IdenticalLoopFusionsShareAKernel) {
+  const char* hlo_text = R"(
+    HloModule test_module
+
+    fused_computation_a {
+      param_0 = f32[1024]{0} parameter(0)
+      ROOT exp = f32[1024]{0} exponential(param_0)
+    }
+
+    fused_computation_b {
+      param_0 = f32[1024]{0} parameter(0)
+      ROOT exp = f32[1024]{0} exponential(param_0)
+    }
+
+    ENTRY main {
+      p0 = f32[1024]{0} parameter(0)
+      p1 = f32[1024]{0} parameter(1)
+      fusion_a = f32[1024]{0} fusion(p0), kind=kLoop,
+                                          calls=fused_computation_a
+      fusion_b = f32[1024]{0} fusion(p1), kind=kLoop,
+                                          calls=fused_computation_b
+      ROOT tuple = (f32[1024]{0}, f32[1024]{0}) tuple(fusion_a, fusion_b)
+    }
+)";
+
+  CompileAndVerifyIr(hlo_text,
+                     R"(
+; CHECK: define void @fusion_a(
+; CHECK-NOT: define void @fusion_b(
+      )");
+  EXPECT_TRUE(RunAndCompareNoHloPasses(hlo_text, ErrorSpec{1e-5, 1e-5}));
+}
+
 }  // namespace
 }  // namespace gpu
 }  // namespace xla
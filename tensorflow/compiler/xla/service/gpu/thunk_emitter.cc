@@ -101,12 +101,20 @@ std::unique_ptr<Thunk> ThunkEmitter::BuildGemmThunk(
     }
   }
 
+  // The bias vector of a cuBLASLt epilogue has a buffer of its own.
+  BufferAllocation::Slice bias_slice;
+  if (gemm_config.epilogue() == GemmBackendConfig::BIAS ||
+      gemm_config.epilogue() == GemmBackendConfig::BIAS_RELU) {
+    bias_slice = GetAllocationSlice(*inst->operand(2));
+  }
+
   return absl::make_unique<GemmThunk>(
       context_->GetThunkInfo(inst),
       GetAllocationSlice(*lhs),   // The buffer assigned to LHS.
       GetAllocationSlice(*rhs),   // The buffer assigned to RHS.
       GetAllocationSlice(*inst),  // The output buffer.
-      /*implements_whole_instruction=*/true, std::move(gemm_config));
+      /*implements_whole_instruction=*/true, std::move(gemm_config),
+      bias_slice);
 }
 
 std::unique_ptr<Thunk> ThunkEmitter::BuildInfeedThunk(
@@ -49,8 +49,11 @@ limitations under the License.
 #include "tensorflow/core/lib/core/bitmap.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/protobuf.h"
+#include "tensorflow/core/platform/threadpool.h"
 #include "tensorflow/core/platform/types.h"
 
 namespace xla {
@@ -2587,4 +2590,29 @@ std::unique_ptr<Array2D<int32>> HloEvaluator::MatmulArray2D(
       lhs, rhs, __xla_cpu_runtime_EigenSingleThreadedMatMulS32);
 }
 
+/* static */ void HloEvaluator::ParallelFor(
+    int64 size, int64 cost_per_unit,
+    const std::function<void(int64, int64)>& fn) {
+  if (size * cost_per_unit < kMinParallelLoopCost) {
+    fn(0, size);
+    return;
+  }
+  static tensorflow::thread::ThreadPool* pool =
+      new tensorflow::thread::ThreadPool(tensorflow::Env::Default(),
+                                         "hlo_evaluator",
+                                         tensorflow::port::MaxParallelism());
+  pool->ParallelFor(size, cost_per_unit, fn);
+}
+
+/* static */ const Literal& HloEvaluator::InLinearOrderOf(
+    const Shape& shape, const Literal& literal, Literal* storage) {
+  DCHECK(ShapeUtil::SameDimensions(shape, literal.shape()));
+  if (absl::c_equal(LayoutUtil::MinorToMajor(shape),
+                    LayoutUtil::MinorToMajor(literal.shape()))) {
+    return literal;
+  }
+  *storage = literal.Relayout(shape.layout());
+  return *storage;
+}
+
 }  // namespace xla
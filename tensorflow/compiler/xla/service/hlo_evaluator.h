@@ -25,6 +25,7 @@ limitations under the License.
 #include "absl/memory/memory.h"
 #include "absl/types/span.h"
 #include "tensorflow/compiler/xla/array2d.h"
+#include "tensorflow/compiler/xla/layout_util.h"
 #include "tensorflow/compiler/xla/literal.h"
 #include "tensorflow/compiler/xla/service/dfs_hlo_visitor_with_default.h"
 #include "tensorflow/compiler/xla/service/dynamic_dimension_inference.h"
@@ -325,6 +326,24 @@ class HloEvaluator : public DfsHloVisitorWithDefault {
   // Use fast path that uses eigen in the evaluator.
   bool use_fast_path_ = false;
 
+  // The fast paths which loop over the raw buffers of literals split the work
+  // of loops with at least this many cost units across threads.
+  static constexpr int64 kMinParallelLoopCost = 64 * 1024;
+
+  // Calls fn(begin, end) on consecutive ranges covering [0, size), in parallel
+  // when size * cost_per_unit is at least kMinParallelLoopCost. fn must be
+  // thread-safe.
+  static void ParallelFor(int64 size, int64 cost_per_unit,
+                          const std::function<void(int64, int64)>& fn);
+
+  // Returns `literal` if its elements are stored in the order of those of
+  // `shape`, such that they can be read with the linear indices of `shape`.
+  // Otherwise relays `literal` out to the layout of `shape` in `*storage`, and
+  // returns it. `literal` must be a dense array with the dimensions of `shape`.
+  static const Literal& InLinearOrderOf(const Shape& shape,
+                                        const Literal& literal,
+                                        Literal* storage);
+
  private:
   template <typename ReturnT, typename NativeT>
   static StatusOr<Literal> ElementWiseUnaryOpImpl(
@@ -336,6 +355,20 @@ class HloEvaluator : public DfsHloVisitorWithDefault {
     TF_RET_CHECK(ShapeUtil::SameDimensions(shape, operand->shape()));
 
     Literal result(shape);
+    if (LayoutUtil::IsDenseArray(result.shape())) {
+      Literal storage;
+      absl::Span<const NativeT> operand_data =
+          InLinearOrderOf(result.shape(), operand_literal, &storage)
+              .data<NativeT>();
+      absl::Span<ReturnT> result_data = result.data<ReturnT>();
+      ParallelFor(result_data.size(), /*cost_per_unit=*/1,
+                  [&](int64 begin, int64 end) {
+                    for (int64 i = begin; i < end; ++i) {
+                      result_data[i] = unary_op(operand_data[i]);
+                    }
+                  });
+      return std::move(result);
+    }
     TF_RETURN_IF_ERROR(
         result.Populate<ReturnT>([&](absl::Span<const int64> multi_index) {
           return unary_op(operand_literal.Get<NativeT>(multi_index));
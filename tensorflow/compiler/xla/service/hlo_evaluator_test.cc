@@ -4464,5 +4464,73 @@ TEST_F(HloEvaluatorTest, MapBF16) {
   EXPECT_TRUE(LiteralTestUtil::Equal(expected, result));
 }
 
+TEST_F(HloEvaluatorTest, AddWithDifferentOperandLayouts) {
+  const absl::string_view hlo_text = R"(
+  HloModule test
+
+  ENTRY AddWithDifferentOperandLayouts {
+    p0 = s32[2,3]{0,1} parameter(0)
+    p1 = s32[2,3]{1,0} parameter(1)
+    ROOT add = s32[2,3]{1,0} add(p0, p1)
+  }
+  )";
+  TF_ASSERT_OK_AND_ASSIGN(m_, ParseAndReturnVerifiedModule(hlo_text));
+  Literal lhs = LiteralUtil::CreateR2WithLayout<int32>(
+      {{1, 2, 3}, {4, 5, 6}}, LayoutUtil::MakeLayout({0, 1}));
+  Literal rhs = LiteralUtil::CreateR2<int32>({{10, 20, 30}, {40, 50, 60}});
+  Literal expected = LiteralUtil::CreateR2<int32>({{11, 22, 33}, {44, 55, 66}});
+  TF_ASSERT_OK_AND_ASSIGN(Literal result, Evaluate({&lhs, &rhs}));
+  EXPECT_TRUE(LiteralTestUtil::Equal(expected, result));
+}
+
+TEST_F(HloEvaluatorTest, LargeElementwiseOp) {
+  const absl::string_view hlo_text = R"(
+  HloModule test
+
+  ENTRY LargeElementwiseOp {
+    p0 = s32[1000,300] parameter(0)
+    p1 = s32[1000,300] parameter(1)
+    ROOT subtract = s32[1000,300] subtract(p0, p1)
+  }
+  )";
+  TF_ASSERT_OK_AND_ASSIGN(m_, ParseAndReturnVerifiedModule(hlo_text));
+  Array2D<int32> lhs_array(1000, 300);
+  Array2D<int32> rhs_array(1000, 300);
+  Array2D<int32> expected_array(1000, 300);
+  for (int64 i = 0; i < 1000; ++i) {
+    for (int64 j = 0; j < 300; ++j) {
+      lhs_array(i, j) = i * j;
+      rhs_array(i, j) = i + j;
+      expected_array(i, j) = i * j - (i + j);
+    }
+  }
+  Literal lhs = LiteralUtil::CreateR2FromArray2D(lhs_array);
+  Literal rhs = LiteralUtil::CreateR2FromArray2D(rhs_array);
+  TF_ASSERT_OK_AND_ASSIGN(Literal result, Evaluate({&lhs, &rhs}));
+  EXPECT_TRUE(LiteralTestUtil::Equal(
+      LiteralUtil::CreateR2FromArray2D(expected_array), result));
+}
+
+TEST_F(HloEvaluatorTest, DotWithTransposedOperands) {
+  const absl::string_view hlo_text = R"(
+  HloModule test
+
+  ENTRY DotWithTransposedOperands {
+    lhs = s32[3,2] parameter(0)
+    rhs = s32[4,3] parameter(1)
+    ROOT dot = s32[2,4]{0,1} dot(lhs, rhs), lhs_contracting_dims={0},
+                                            rhs_contracting_dims={1}
+  }
+  )";
+  TF_ASSERT_OK_AND_ASSIGN(m_, ParseAndReturnVerifiedModule(hlo_text));
+  Literal lhs = LiteralUtil::CreateR2<int32>({{1, 2}, {3, 4}, {5, 6}});
+  Literal rhs = LiteralUtil::CreateR2<int32>(
+      {{1, 0, 0}, {0, 1, 0}, {0, 0, 1}, {1, -1, 2}});
+  Literal expected = LiteralUtil::CreateR2WithLayout<int32>(
+      {{1, 3, 5, 8}, {2, 4, 6, 10}}, LayoutUtil::MakeLayout({0, 1}));
+  TF_ASSERT_OK_AND_ASSIGN(Literal result, Evaluate({&lhs, &rhs}));
+  EXPECT_TRUE(LiteralTestUtil::Equal(expected, result));
+}
+
 }  // namespace
 }  // namespace xla
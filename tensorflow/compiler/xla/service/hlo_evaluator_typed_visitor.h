@@ -1402,6 +1402,13 @@ class HloEvaluatorTypedVisitor : public DfsHloVisitorWithDefault {
     CHECK_EQ(dnums.lhs_batch_dimensions_size(),
              dnums.rhs_batch_dimensions_size());
 
+    if (lhs_rank == 2 && rhs_rank == 2 &&
+        dnums.lhs_batch_dimensions_size() == 0 &&
+        dnums.lhs_contracting_dimensions_size() == 1 &&
+        dnums.rhs_contracting_dimensions_size() == 1) {
+      return HandleMatmulWithLiterals(dot, lhs_literal, rhs_literal);
+    }
+
     DimensionVector lhs_index(lhs_rank);
     DimensionVector rhs_index(rhs_rank);
 
@@ -1496,6 +1503,72 @@ class HloEvaluatorTypedVisitor : public DfsHloVisitorWithDefault {
     return Status::OK();
   }
 
+  // Evaluates a rank 2 dot with raw loops over the operand buffers. The
+  // products are accumulated in the same order as in
+  // HandleDotSlowPathWithLiterals, which gives the same results, but a row of
+  // the result is accumulated at a time, so that the rhs is read contiguously.
+  Status HandleMatmulWithLiterals(HloInstruction* dot,
+                                  const Literal& lhs_literal,
+                                  const Literal& rhs_literal) {
+    const auto& dnums = dot->dot_dimension_numbers();
+    const bool lhs_transposed = dnums.lhs_contracting_dimensions(0) == 0;
+    const bool rhs_transposed = dnums.rhs_contracting_dimensions(0) == 1;
+    const int64 m = dot->shape().dimensions(0);
+    const int64 n = dot->shape().dimensions(1);
+    const int64 k = lhs_literal.shape().dimensions(lhs_transposed ? 0 : 1);
+
+    const Shape default_lhs_shape = ShapeUtil::MakeShapeWithDescendingLayout(
+        lhs_literal.shape().element_type(), lhs_literal.shape().dimensions());
+    const Shape default_rhs_shape = ShapeUtil::MakeShapeWithDescendingLayout(
+        rhs_literal.shape().element_type(), rhs_literal.shape().dimensions());
+    Literal lhs_storage;
+    Literal rhs_storage;
+    absl::Span<const ReturnT> lhs_data =
+        HloEvaluator::InLinearOrderOf(default_lhs_shape, lhs_literal,
+                                      &lhs_storage)
+            .data<ReturnT>();
+    absl::Span<const ReturnT> rhs_data =
+        HloEvaluator::InLinearOrderOf(default_rhs_shape, rhs_literal,
+                                      &rhs_storage)
+            .data<ReturnT>();
+    Literal result(ShapeUtil::MakeShapeWithDescendingLayout(
+        dot->shape().element_type(), dot->shape().dimensions()));
+    absl::Span<ReturnT> result_data = result.data<ReturnT>();
+
+    // Strides of the contracted and non-contracted dimensions of the operands.
+    const int64 lhs_row_stride = lhs_transposed ? 1 : k;
+    const int64 lhs_k_stride = lhs_transposed ? m : 1;
+    const int64 rhs_k_stride = rhs_transposed ? 1 : n;
+    const int64 rhs_column_stride = rhs_transposed ? k : 1;
+    HloEvaluator::ParallelFor(
+        m, /*cost_per_unit=*/n * k, [&](int64 begin, int64 end) {
+          absl::InlinedVector<ElementwiseT, 8> row(n);
+          for (int64 i = begin; i < end; ++i) {
+            std::fill(row.begin(), row.end(), static_cast<ElementwiseT>(0));
+            for (int64 p = 0; p < k; ++p) {
+              ElementwiseT lhs_val(lhs_data[i * lhs_row_stride +
+                                            p * lhs_k_stride]);
+              const ReturnT* rhs_row = rhs_data.data() + p * rhs_k_stride;
+              for (int64 j = 0; j < n; ++j) {
+                ElementwiseT rhs_val(rhs_row[j * rhs_column_stride]);
+                row[j] += ToArithmeticSafeType(lhs_val) *
+                          ToArithmeticSafeType(rhs_val);
+              }
+            }
+            for (int64 j = 0; j < n; ++j) {
+              result_data[i * n + j] = static_cast<ReturnT>(row[j]);
+            }
+          }
+        });
+
+    if (dot->shape().has_layout() &&
+        !LayoutUtil::Equal(dot->shape().layout(), result.shape().layout())) {
+      result = result.Relayout(dot->shape().layout());
+    }
+    parent_->evaluated_[dot] = std::move(result);
+    return Status::OK();
+  }
+
   Status HandleDotSlowPath(HloInstruction* dot) {
     auto lhs = dot->operand(0);
     auto rhs = dot->operand(1);
@@ -2933,6 +3006,29 @@ class HloEvaluatorTypedVisitor : public DfsHloVisitorWithDefault {
 
     Literal result(shape);
 
+    if (LayoutUtil::IsDenseArray(result.shape())) {
+      Literal lhs_storage;
+      Literal rhs_storage;
+      absl::Span<const ReturnT> lhs_data =
+          HloEvaluator::InLinearOrderOf(result.shape(), lhs_literal,
+                                        &lhs_storage)
+              .data<ReturnT>();
+      absl::Span<const ReturnT> rhs_data =
+          HloEvaluator::InLinearOrderOf(result.shape(), rhs_literal,
+                                        &rhs_storage)
+              .data<ReturnT>();
+      absl::Span<ReturnT> result_data = result.data<ReturnT>();
+      HloEvaluator::ParallelFor(
+          result_data.size(), /*cost_per_unit=*/1, [&](int64 begin, int64 end) {
+            for (int64 i = begin; i < end; ++i) {
+              result_data[i] = static_cast<ReturnT>(
+                  binary_op(static_cast<ElementwiseT>(lhs_data[i]),
+                            static_cast<ElementwiseT>(rhs_data[i])));
+            }
+          });
+      return std::move(result);
+    }
+
     TF_RETURN_IF_ERROR(
         result.Populate<ReturnT>([&](absl::Span<const int64> multi_index) {
           return ConvertBinaryFunction(binary_op)(
@@ -2960,6 +3056,33 @@ class HloEvaluatorTypedVisitor : public DfsHloVisitorWithDefault {
 
     Literal result(shape);
 
+    if (LayoutUtil::IsDenseArray(result.shape())) {
+      Literal lhs_storage;
+      Literal rhs_storage;
+      Literal ehs_storage;
+      absl::Span<const LhsType> lhs_data =
+          HloEvaluator::InLinearOrderOf(result.shape(), lhs_literal,
+                                        &lhs_storage)
+              .data<LhsType>();
+      absl::Span<const RhsType> rhs_data =
+          HloEvaluator::InLinearOrderOf(result.shape(), rhs_literal,
+                                        &rhs_storage)
+              .data<RhsType>();
+      absl::Span<const EhsType> ehs_data =
+          HloEvaluator::InLinearOrderOf(result.shape(), ehs_literal,
+                                        &ehs_storage)
+              .data<EhsType>();
+      absl::Span<ReturnT> result_data = result.data<ReturnT>();
+      HloEvaluator::ParallelFor(
+          result_data.size(), /*cost_per_unit=*/1, [&](int64 begin, int64 end) {
+            for (int64 i = begin; i < end; ++i) {
+              result_data[i] =
+                  ternary_op(lhs_data[i], rhs_data[i], ehs_data[i]);
+            }
+          });
+      return std::move(result);
+    }
+
     TF_RETURN_IF_ERROR(
         result.Populate<ReturnT>([&](absl::Span<const int64> multi_index) {
           return ternary_op(lhs_literal.Get<LhsType>(multi_index),
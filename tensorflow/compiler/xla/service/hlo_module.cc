@@ -754,6 +754,12 @@ uint64 HloModule::RandomNew64() const {
   return rng_();
 }
 
+void HloModule::UniquifyInstruction(HloInstruction* instruction) {
+  tensorflow::mutex_lock lock(instruction_id_mutex_);
+  instruction->UniquifyName(&instruction_name_uniquer_);
+  instruction->SetUniqueId(next_unique_id_++);
+}
+
 HloComputation* HloModule::GetComputationWithName(absl::string_view name) {
   auto computations_in_module = computations();
   auto it = absl::c_find_if(
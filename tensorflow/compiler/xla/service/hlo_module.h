@@ -264,8 +264,14 @@ class HloModule {
   // Returns the NameUniquer for uniquing instruction names in this module.
   NameUniquer& instruction_name_uniquer() { return instruction_name_uniquer_; }
 
+  // Gives the instruction a name and an id which are unique in this module.
+  // Unlike using the uniquer directly, this is safe to call concurrently, as
+  // computation passes running in parallel do.
+  void UniquifyInstruction(HloInstruction* instruction);
+
   // Assign a new unique dense id for an instruction
   int NewUniqueInstructionId() {
+    tensorflow::mutex_lock lock(instruction_id_mutex_);
     int result = next_unique_id_;
     next_unique_id_++;
     return result;
@@ -383,6 +389,9 @@ class HloModule {
   // Unique name generator for computation and instruction names, which are
   // unique per module.
   NameUniquer computation_name_uniquer_{/*separator=*/"."};
+  // Guards the instruction uniquer and ids while instructions are added to the
+  // computations of the module concurrently.
+  tensorflow::mutex instruction_id_mutex_;
   NameUniquer instruction_name_uniquer_{/*separator=*/"."};
   int next_unique_id_ = 0;
 
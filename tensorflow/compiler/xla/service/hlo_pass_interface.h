@@ -43,6 +43,10 @@ class HloPassInterface {
   virtual StatusOr<bool> RunOnModuleGroup(HloModuleGroup* module_group) = 0;
 
   virtual bool IsPassPipeline() { return false; }
+
+  // Whether the pass is an HloComputationPass, which an HloPassPipeline can run
+  // on the computations of a module in parallel.
+  virtual bool IsComputationPass() { return false; }
 };
 
 // Base class for passes which are module-scoped.
@@ -68,6 +72,31 @@ class HloModulePass : public HloPassInterface {
   virtual void UpdateLayout(Shape* shape) {}
 };
 
+// Base class for passes which transform each non-fusion computation of a module
+// independently of the others. Running the pass on a computation must not add
+// or remove computations, nor change any computation but the given one, which
+// lets an HloPassPipeline with a thread pool run it on all the computations of
+// a module at once.
+class HloComputationPass : public HloModulePass {
+ public:
+  // Runs the pass on the given computation. Returns whether it modified the
+  // computation.
+  virtual StatusOr<bool> RunOnComputation(HloComputation* computation) = 0;
+
+  // Runs the pass on the non-fusion computations of the module, one by one.
+  StatusOr<bool> Run(HloModule* module) override {
+    bool changed = false;
+    for (HloComputation* computation : module->MakeNonfusionComputations()) {
+      TF_ASSIGN_OR_RETURN(bool computation_changed,
+                          RunOnComputation(computation));
+      changed |= computation_changed;
+    }
+    return changed;
+  }
+
+  bool IsComputationPass() override { return true; }
+};
+
 // Base class for passes which are module-group scoped. These passes cannot run
 // on an HLO module.
 class HloModuleGroupPass : public HloPassInterface {
@@ -27,6 +27,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/status_macros.h"
 #include "tensorflow/compiler/xla/types.h"
 #include "tensorflow/compiler/xla/util.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
 
 namespace xla {
@@ -66,9 +67,18 @@ StatusOr<bool> HloPassPipeline::RunPassesInternal(
                  /*before_pass_name=*/pass_name);
     if (!pass->IsPassPipeline()) {
       compilation_stats_->StartPass(pass_name);
+    } else if (thread_pool_ != nullptr) {
+      auto* pipeline = static_cast<HloPassPipeline*>(pass);
+      if (pipeline->thread_pool_ == nullptr) {
+        pipeline->set_thread_pool(thread_pool_);
+      }
     }
     TF_ASSIGN_OR_RETURN(bool pass_changed, RunHelper(pass, hlo));
     changed |= pass_changed;
+    if (last_pass_work_ms_.has_value()) {
+      compilation_stats_->RecordPassWork(pass_name, *last_pass_work_ms_);
+      last_pass_work_ms_.reset();
+    }
     TF_RETURN_IF_ERROR(RunInvariantCheckers(hlo, pass_name));
     last_pass_name = string(pass_name);
     if (!pass->IsPassPipeline()) {
@@ -81,6 +91,37 @@ StatusOr<bool> HloPassPipeline::RunPassesInternal(
   return changed;
 }
 
+StatusOr<bool> HloPassPipeline::RunComputationPassInParallel(
+    HloComputationPass* pass, HloModule* module) {
+  const std::vector<HloComputation*> computations =
+      module->MakeNonfusionComputations();
+  std::vector<StatusOr<bool>> results(computations.size(), false);
+  std::vector<uint64> durations_micros(computations.size(), 0);
+  tensorflow::Env* env = tensorflow::Env::Default();
+  thread_pool_->ParallelFor(
+      computations.size(),
+      tensorflow::thread::ThreadPool::SchedulingParams(
+          tensorflow::thread::ThreadPool::SchedulingStrategy::kFixedBlockSize,
+          /*cost_per_unit=*/absl::nullopt, /*block_size=*/1),
+      [&](int64 begin, int64 end) {
+        for (int64 i = begin; i < end; ++i) {
+          const uint64 start_micros = env->NowMicros();
+          results[i] = pass->RunOnComputation(computations[i]);
+          durations_micros[i] = env->NowMicros() - start_micros;
+        }
+      });
+
+  bool changed = false;
+  uint64 work_micros = 0;
+  for (int64 i = 0; i < computations.size(); ++i) {
+    TF_ASSIGN_OR_RETURN(bool computation_changed, results[i]);
+    changed |= computation_changed;
+    work_micros += durations_micros[i];
+  }
+  last_pass_work_ms_ = work_micros / 1000.0;
+  return changed;
+}
+
 std::vector<HloPassInterface*> HloPassPipeline::GetEnabledPasses(
     const DebugOptions& debug_options) {
   if (debug_options.xla_disable_all_hlo_passes()) {
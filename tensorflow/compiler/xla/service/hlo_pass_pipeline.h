@@ -23,12 +23,14 @@ limitations under the License.
 
 #include "absl/memory/memory.h"
 #include "absl/strings/str_cat.h"
+#include "absl/types/optional.h"
 #include "tensorflow/compiler/xla/service/compilation_stats.h"
 #include "tensorflow/compiler/xla/service/hlo_module.h"
 #include "tensorflow/compiler/xla/service/hlo_pass_interface.h"
 #include "tensorflow/compiler/xla/statusor.h"
 #include "tensorflow/compiler/xla/types.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/threadpool.h"
 
 namespace xla {
 
@@ -78,6 +80,14 @@ class HloPassPipeline : public HloPassInterface {
 #endif  // NDEBUG
   }
 
+  // Sets the thread pool on which the computation passes of the pipeline, and
+  // of the pipelines it contains which have no pool of their own, run on the
+  // computations of a module in parallel. The pool must outlive the runs of
+  // the pipeline. Without a pool, every pass runs on one computation at a time.
+  void set_thread_pool(tensorflow::thread::ThreadPool* thread_pool) {
+    thread_pool_ = thread_pool;
+  }
+
   StatusOr<bool> Run(HloModule* module) override;
   StatusOr<bool> RunOnModuleGroup(HloModuleGroup* module_group) override;
 
@@ -108,11 +118,24 @@ class HloPassPipeline : public HloPassInterface {
   StatusOr<bool> RunPassesInternal(HloT* hlo,
                                    absl::Span<HloPassInterface* const> passes);
 
+  // Runs the computation pass on all the non-fusion computations of the module
+  // at once on thread_pool_, and sets last_pass_work_ms_ to the time spent on
+  // them.
+  StatusOr<bool> RunComputationPassInParallel(HloComputationPass* pass,
+                                              HloModule* module);
+
   // Helpers which run the given passes on the given HLO construct. These
   // helpers enable templating of the core of the pipeline logic by providing
   // HloModule and HloModuleGroup specific methods with the same name.
-  static StatusOr<bool> RunHelper(HloPassInterface* pass, HloModule* module) {
-    TF_ASSIGN_OR_RETURN(bool changed, pass->Run(module));
+  StatusOr<bool> RunHelper(HloPassInterface* pass, HloModule* module) {
+    bool changed;
+    if (thread_pool_ != nullptr && pass->IsComputationPass()) {
+      TF_ASSIGN_OR_RETURN(changed,
+                          RunComputationPassInParallel(
+                              static_cast<HloComputationPass*>(pass), module));
+    } else {
+      TF_ASSIGN_OR_RETURN(changed, pass->Run(module));
+    }
     module->Cleanup();
     return changed;
   }
@@ -127,6 +150,9 @@ class HloPassPipeline : public HloPassInterface {
   std::vector<std::unique_ptr<HloPassInterface>> passes_;
   std::vector<std::unique_ptr<HloPassInterface>> invariant_checkers_;
   bool run_called_ = false;
+  tensorflow::thread::ThreadPool* thread_pool_ = nullptr;
+  // The work of the last pass run in parallel, until it is recorded.
+  absl::optional<double> last_pass_work_ms_;
 
   CompilationStats* compilation_stats_;
   // Default stats instance for when one is not passed in the constructor.
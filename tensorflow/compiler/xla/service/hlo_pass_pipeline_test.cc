@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/compiler/xla/service/hlo_pass_pipeline.h"
 
+#include "absl/container/flat_hash_set.h"
 #include "tensorflow/compiler/xla/service/hlo_computation.h"
 #include "tensorflow/compiler/xla/service/hlo_instruction.h"
 #include "tensorflow/compiler/xla/service/hlo_module.h"
@@ -22,6 +23,8 @@ limitations under the License.
 #include "tensorflow/compiler/xla/tests/hlo_test_base.h"
 #include "tensorflow/compiler/xla/util.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/threadpool.h"
 
 namespace xla {
 namespace {
@@ -78,6 +81,18 @@ class BazToQuxModuleGroupPass : public HloModuleGroupPass {
   }
 };
 
+// A computation pass which negates the root of every computation.
+class NegateRootComputationPass : public HloComputationPass {
+  absl::string_view name() const override { return "negate-root"; }
+
+  StatusOr<bool> RunOnComputation(HloComputation* computation) override {
+    HloInstruction* root = computation->root_instruction();
+    computation->set_root_instruction(computation->AddInstruction(
+        HloInstruction::CreateUnary(root->shape(), HloOpcode::kNegate, root)));
+    return true;
+  }
+};
+
 // An invariant checker pass which returns an error if there exists an
 // instruction named 'bar'.
 class BarBlowerUpper : public HloModulePass {
@@ -255,5 +270,49 @@ ENTRY main {
       ::testing::HasSubstr("Module group pass cannot be run on a module"));
 }
 
+TEST_F(HloPassPipelineTest, ComputationPassInParallel) {
+  const string module_str = R"(
+HloModule ComputationPassInParallel
+
+add {
+  x = f32[] parameter(0)
+  y = f32[] parameter(1)
+  ROOT add = f32[] add(x, y)
+}
+
+mul {
+  x = f32[] parameter(0)
+  y = f32[] parameter(1)
+  ROOT mul = f32[] multiply(x, y)
+}
+
+ENTRY main {
+  a = f32[] parameter(0)
+  b = f32[] parameter(1)
+  c = f32[] call(a, b), to_apply=add
+  ROOT d = f32[] call(c, b), to_apply=mul
+}
+)";
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<VerifiedHloModule> module,
+                          ParseAndReturnVerifiedModule(module_str));
+  tensorflow::thread::ThreadPool thread_pool(tensorflow::Env::Default(),
+                                             TestName(), /*num_threads=*/4);
+  HloPassPipeline pipeline(TestName());
+  pipeline.set_thread_pool(&thread_pool);
+  pipeline.AddPass<NegateRootComputationPass>();
+  TF_ASSERT_OK_AND_ASSIGN(bool changed, pipeline.Run(module.get()));
+  EXPECT_TRUE(changed);
+
+  absl::flat_hash_set<int> ids;
+  absl::flat_hash_set<string> names;
+  for (HloComputation* computation : module->computations()) {
+    EXPECT_EQ(computation->root_instruction()->opcode(), HloOpcode::kNegate);
+    for (HloInstruction* instruction : computation->instructions()) {
+      EXPECT_TRUE(ids.insert(instruction->unique_id()).second);
+      EXPECT_TRUE(names.insert(instruction->name()).second);
+    }
+  }
+}
+
 }  // namespace
 }  // namespace xla
@@ -38,6 +38,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/hlo_opcode.h"
 #include "tensorflow/compiler/xla/service/hlo_ordering.h"
 #include "tensorflow/compiler/xla/service/logical_buffer.h"
+#include "tensorflow/compiler/xla/shape_util.h"
 #include "tensorflow/compiler/xla/status_macros.h"
 #include "tensorflow/compiler/xla/statusor.h"
 #include "tensorflow/compiler/xla/types.h"
@@ -107,7 +108,14 @@ struct RematStrategy {
     // Change the layout into a compact form and uncompress it back at a later
     // program point.
     kCompress,
+    // Convert the value to bf16 and back to its original type at a later
+    // program point.
+    kDownCast,
+    // Copy the value to host memory and back to device memory at a later
+    // program point.
+    kOffload,
   } kind;
+  // The shape the value is held in between the two program points.
   Shape compact_shape;
 };
 
@@ -371,7 +379,8 @@ class MemoryUsageTracker {
       const HloRematerialization::CompactShapeFunction& compact_shape_function,
       const TuplePointsToAnalysis& points_to_analysis,
       const InstructionList& instruction_list,
-      HloRematerialization::RematerializationMode mode);
+      HloRematerialization::RematerializationMode mode,
+      const RematerializationStorageOptions& storage_options);
 
   // Starts the placement of the given instruction. This adds the sizes of the
   // LogicalBuffers defined by the instruction to the current memory
@@ -426,6 +435,15 @@ class MemoryUsageTracker {
   Status AddCompressInstructions(Item* original_item, Item* compressed_item,
                                  Item* uncompressed_item);
 
+  // Adjusts memory usage to account for copying the value of original_item to
+  // host memory and back for all remaining unplaced uses. The copies to host
+  // memory are offload_start_item and offload_done_item, which are placed, and
+  // the copies back are prefetch_start_item and prefetch_done_item.
+  Status AddOffloadInstructions(Item* original_item, Item* offload_start_item,
+                                Item* offload_done_item,
+                                Item* prefetch_start_item,
+                                Item* prefetch_done_item);
+
   // Adjusts memory usage to account for the rematerialization of
   // original_item for all remaining unplaced uses. The rematerialization
   // is remat_item. This method should be called after the HLO graph has
@@ -456,6 +474,9 @@ class MemoryUsageTracker {
   // Returns whether 'item' is currently in progress.
   bool IsInProgressItem(Item* item) const { return item == in_progress_item_; }
 
+  // Returns the item currently being placed, or nullptr if there is none.
+  Item* in_progress_item() const { return in_progress_item_; }
+
   // Returns the current memory usage. This is the sum of sizes of all live
   // values.
   int64 memory_usage() const { return memory_usage_; }
@@ -511,6 +532,26 @@ class MemoryUsageTracker {
   // to avoid computing the shape multiple times.
   StatusOr<Shape> GetCompactShape(const HloInstruction* hlo);
 
+  // Returns the strategies of storage_options_ which apply to the output of
+  // 'item'.
+  std::vector<RematStrategy> GetStorageStrategies(Item* item) const;
+
+  // Returns the cost of reducing the current memory usage by 'memory_reduced'
+  // bytes with the given storage strategy. Only the bytes saved up to the
+  // amount the memory usage is over 'memory_limit_bytes' count.
+  int64 StorageCost(const RematStrategy& strategy, int64 memory_reduced,
+                    int64 memory_limit_bytes) const;
+
+  // Returns the number of bytes of device memory a buffer of the given shape
+  // occupies. Buffers in host memory occupy none.
+  int64 BufferSize(const Shape& shape) const {
+    if (storage_options_.host_memory_space != 0 && shape.has_layout() &&
+        shape.layout().memory_space() == storage_options_.host_memory_space) {
+      return 0;
+    }
+    return size_function_(shape);
+  }
+
   // Creates a Buffer representing the given logical buffer. The buffer is added
   // to buffers_ and a reference is returned.
   Buffer& CreateBufferFromLogicalBuffer(
@@ -601,7 +642,7 @@ class MemoryUsageTracker {
                     ItemList&& users, bool live_out, bool has_indirect_uses) {
     int buffer_id = buffers_.size();
     buffers_.push_back(Buffer{
-        buffer_id, defining_instruction, size_function_(shape), shape, live_out,
+        buffer_id, defining_instruction, BufferSize(shape), shape, live_out,
         has_indirect_uses, users, static_cast<int64>(users.size())});
     return buffers_.back();
   }
@@ -631,6 +672,9 @@ class MemoryUsageTracker {
   Item* in_progress_item_ = nullptr;
 
   HloRematerialization::RematerializationMode mode_;
+
+  const RematerializationStorageOptions& storage_options_;
+
   // All buffers in the computation.
   std::vector<Buffer> buffers_;
 };
@@ -641,12 +685,14 @@ MemoryUsageTracker::MemoryUsageTracker(
     const HloRematerialization::CompactShapeFunction& compact_shape_function,
     const TuplePointsToAnalysis& points_to_analysis,
     const InstructionList& instruction_list,
-    HloRematerialization::RematerializationMode mode)
+    HloRematerialization::RematerializationMode mode,
+    const RematerializationStorageOptions& storage_options)
     : computation_(computation),
       instruction_list_(instruction_list),
       size_function_(size_function),
       compact_shape_function_(compact_shape_function),
-      mode_(mode) {
+      mode_(mode),
+      storage_options_(storage_options) {
   PointsToSet::BufferSet live_out_set =
       points_to_analysis.GetPointsToSet(computation_->root_instruction())
           .CreateFlattenedSet();
@@ -796,7 +842,7 @@ int64 MemoryUsageTracker::MemoryReducedIfCompressed(
     const Buffer& buffer = buffers_.at(buffer_id);
     memory_reduced += buffer.size;
 
-    int64 compact_shape_size = size_function_(compact_shape);
+    int64 compact_shape_size = BufferSize(compact_shape);
     // Account for buffers that are compressed after instruction.
     memory_reduced -= compact_shape_size;
   }
@@ -952,6 +998,62 @@ Status MemoryUsageTracker::AddCompressInstructions(Item* original_item,
   return Status::OK();
 }
 
+Status MemoryUsageTracker::AddOffloadInstructions(Item* original_item,
+                                                  Item* offload_start_item,
+                                                  Item* offload_done_item,
+                                                  Item* prefetch_start_item,
+                                                  Item* prefetch_done_item) {
+  CHECK_EQ(original_item->buffers_output.size(), 1);
+  BufferId original_buffer_id = original_item->buffers_output[0];
+  // Original buffer is now dead. The buffer in host memory takes no device
+  // memory.
+  memory_usage_ -= AllocatedSize(original_buffer_id);
+
+  ItemList placed_users;
+  ItemList unplaced_users;
+  Buffer& original_buffer = buffers_.at(original_buffer_id);
+  for (Item* user : original_buffer.users) {
+    if (user->placed) {
+      CHECK(IsFinished(user)) << user->instruction->name();
+      placed_users.push_back(user);
+    } else {
+      unplaced_users.push_back(user);
+    }
+  }
+  // The source of an asynchronous copy stays live until the copy is done.
+  original_buffer.users = std::move(placed_users);
+  original_buffer.users.push_back(offload_start_item);
+  original_buffer.users.push_back(offload_done_item);
+  original_buffer.unfinished_user_count = 0;
+  offload_start_item->buffers_used = {original_buffer_id};
+  offload_done_item->buffers_used = {original_buffer_id};
+
+  BufferId host_buffer_id =
+      NewBuffer(offload_done_item, offload_done_item->instruction->shape(),
+                {prefetch_start_item, prefetch_done_item}, /*live_out=*/false,
+                /*has_indirect_uses=*/false)
+          .id;
+  offload_done_item->buffers_defined = {host_buffer_id};
+  offload_done_item->buffers_output = {host_buffer_id};
+  prefetch_start_item->buffers_used = {host_buffer_id};
+  prefetch_done_item->buffers_used = {host_buffer_id};
+
+  Buffer& prefetched_buffer =
+      NewBuffer(prefetch_done_item, prefetch_done_item->instruction->shape(),
+                std::move(unplaced_users), /*live_out=*/false,
+                /*has_indirect_uses=*/false);
+  prefetch_done_item->buffers_defined = {prefetched_buffer.id};
+  prefetch_done_item->buffers_output = {prefetched_buffer.id};
+
+  for (Item* user : prefetched_buffer.users) {
+    BufferIdList& buffers_used = user->buffers_used;
+    std::replace(buffers_used.begin(), buffers_used.end(), original_buffer_id,
+                 prefetched_buffer.id);
+  }
+
+  return Status::OK();
+}
+
 Status MemoryUsageTracker::AddRematerializedInstruction(Item* original_item,
                                                         Item* remat_item) {
   VLOG(3) << "AddRematerializedInstruction: original_instruction = "
@@ -1057,6 +1159,48 @@ StatusOr<Shape> MemoryUsageTracker::GetCompactShape(const HloInstruction* hlo) {
   return min_shape;
 }
 
+std::vector<RematStrategy> MemoryUsageTracker::GetStorageStrategies(
+    Item* item) const {
+  std::vector<RematStrategy> strategies;
+  const Shape& shape = item->instruction->shape();
+  if (item->buffers_output.size() != 1 || !item->placed ||
+      item == in_progress_item_ ||
+      buffers_.at(item->buffers_output[0]).live_out || !shape.IsArray()) {
+    return strategies;
+  }
+  if (storage_options_.allow_bf16_storage && shape.element_type() == F32) {
+    RematStrategy strategy;
+    strategy.kind = RematStrategy::kDownCast;
+    strategy.compact_shape = ShapeUtil::ChangeElementType(shape, BF16);
+    strategies.push_back(strategy);
+  }
+  if (storage_options_.host_memory_space != 0 && shape.has_layout() &&
+      shape.layout().memory_space() != storage_options_.host_memory_space) {
+    RematStrategy strategy;
+    strategy.kind = RematStrategy::kOffload;
+    strategy.compact_shape = shape;
+    strategy.compact_shape.mutable_layout()->set_memory_space(
+        storage_options_.host_memory_space);
+    strategies.push_back(strategy);
+  }
+  return strategies;
+}
+
+int64 MemoryUsageTracker::StorageCost(const RematStrategy& strategy,
+                                      int64 memory_reduced,
+                                      int64 memory_limit_bytes) const {
+  CHECK_GT(memory_reduced, 0);
+  const double relative_cost = strategy.kind == RematStrategy::kDownCast
+                                   ? storage_options_.bf16_storage_cost
+                                   : storage_options_.host_offload_cost;
+  int64 bytes_saved = memory_reduced;
+  const int64 excess_bytes = memory_usage_ - memory_limit_bytes;
+  if (excess_bytes > 0) {
+    bytes_saved = std::min(bytes_saved, excess_bytes);
+  }
+  return static_cast<int64>(relative_cost * memory_limit_bytes / bytes_saved);
+}
+
 bool MemoryUsageTracker::Check() const {
   auto elements_are_unique = [](const BufferIdList& vec) {
     return vec.size() == std::set<BufferId>(vec.begin(), vec.end()).size();
@@ -1241,6 +1385,26 @@ MemoryUsageTracker::PickRematerializationCandidates(
             }
           }
         }
+        if (mode_ !=
+            HloRematerialization::RematerializationMode::kRecomputeOnly) {
+          for (const RematStrategy& strategy : GetStorageStrategies(item)) {
+            const int64 memory_reduced =
+                MemoryReducedIfCompressed(item, strategy.compact_shape);
+            if (memory_reduced > 0) {
+              const int64 cost =
+                  StorageCost(strategy, memory_reduced, memory_limit_bytes);
+              if (best_items.empty() || cost < best_cost) {
+                VLOG(3) << "candidate " << candidate->name() << "("
+                        << candidate->ToShortString() << ")"
+                        << " now best when stored as "
+                        << strategy.compact_shape.ToString(true);
+                best_strategy = strategy;
+                best_items = block;
+                best_cost = cost;
+              }
+            }
+          }
+        }
       }
       // Do not consider recomputation in compress-only mode.
       if (mode_ == HloRematerialization::RematerializationMode::kCompressOnly) {
@@ -1417,6 +1581,9 @@ StatusOr<int64> RematerializeInstructions(
   return net_instructions_added;
 }
 
+// Replaces the unplaced uses of 'best_item' with a round trip through
+// 'compact_shape', made of two copies, or of two converts if 'compact_shape'
+// has a different element type. Returns the number of instructions added.
 StatusOr<int64> CompressInstruction(MemoryUsageTracker* memory_tracker,
                                     Item* best_item, const Shape& compact_shape,
                                     InstructionList* instruction_list) {
@@ -1428,11 +1595,19 @@ StatusOr<int64> CompressInstruction(MemoryUsageTracker* memory_tracker,
 
   HloComputation* computation = best->parent();
 
-  HloInstruction* compressed = computation->AddInstruction(
-      HloInstruction::CreateUnary(compact_shape, HloOpcode::kCopy, best));
-
-  HloInstruction* uncompressed = computation->AddInstruction(
-      HloInstruction::CreateUnary(best->shape(), HloOpcode::kCopy, compressed));
+  HloInstruction* compressed;
+  HloInstruction* uncompressed;
+  if (compact_shape.element_type() != best->shape().element_type()) {
+    compressed = computation->AddInstruction(
+        HloInstruction::CreateConvert(compact_shape, best));
+    uncompressed = computation->AddInstruction(
+        HloInstruction::CreateConvert(best->shape(), compressed));
+  } else {
+    compressed = computation->AddInstruction(
+        HloInstruction::CreateUnary(compact_shape, HloOpcode::kCopy, best));
+    uncompressed = computation->AddInstruction(HloInstruction::CreateUnary(
+        best->shape(), HloOpcode::kCopy, compressed));
+  }
 
   Item* compressed_item = instruction_list->CreateItem(compressed);
   compressed_item->placed = true;
@@ -1470,6 +1645,76 @@ StatusOr<int64> CompressInstruction(MemoryUsageTracker* memory_tracker,
   return 2;
 }
 
+// Copies the value of 'best_item' to the host memory space of 'host_shape' with
+// an asynchronous copy which overlaps the instructions placed since its
+// definition, and replaces its unplaced uses with an asynchronous copy back to
+// device memory right before the earliest of them. Returns the number of
+// instructions added.
+StatusOr<int64> OffloadInstruction(MemoryUsageTracker* memory_tracker,
+                                   Item* best_item, const Shape& host_shape,
+                                   InstructionList* instruction_list) {
+  HloInstruction* best = best_item->instruction;
+  HloComputation* computation = best->parent();
+  const Shape& shape = best->shape();
+  const Shape context_shape = ShapeUtil::MakeShape(U32, {});
+
+  HloInstruction* offload_start =
+      computation->AddInstruction(HloInstruction::CreateUnary(
+          ShapeUtil::MakeTupleShape({host_shape, shape, context_shape}),
+          HloOpcode::kCopyStart, best));
+  HloInstruction* offload_done = computation->AddInstruction(
+      HloInstruction::CreateUnary(host_shape, HloOpcode::kCopyDone,
+                                  offload_start));
+  HloInstruction* prefetch_start =
+      computation->AddInstruction(HloInstruction::CreateUnary(
+          ShapeUtil::MakeTupleShape({shape, host_shape, context_shape}),
+          HloOpcode::kCopyStart, offload_done));
+  HloInstruction* prefetch_done = computation->AddInstruction(
+      HloInstruction::CreateUnary(shape, HloOpcode::kCopyDone, prefetch_start));
+
+  Item* offload_start_item = instruction_list->CreateItem(offload_start);
+  offload_start_item->placed = true;
+  Item* offload_done_item = instruction_list->CreateItem(offload_done);
+  offload_done_item->placed = true;
+  Item* prefetch_start_item = instruction_list->CreateItem(prefetch_start);
+  Item* prefetch_done_item = instruction_list->CreateItem(prefetch_done);
+
+  // Replace each remaining use of 'best' with the prefetched value.
+  std::vector<HloInstruction*> best_users_copy = best->users();
+  for (HloInstruction* user : best_users_copy) {
+    if (!memory_tracker->IsPlaced(user)) {
+      VLOG(5) << "  Replacing use of " << best->name() << " in " << user->name()
+              << " with " << prefetch_done->name();
+      TF_RETURN_IF_ERROR(best->ReplaceUseWith(user, prefetch_done));
+    }
+  }
+
+  TF_RETURN_IF_ERROR(memory_tracker->AddOffloadInstructions(
+      best_item, offload_start_item, offload_done_item, prefetch_start_item,
+      prefetch_done_item));
+
+  ItemList place_before;
+  for (auto user : prefetch_done->users()) {
+    place_before.push_back(instruction_list->GetItem(user));
+  }
+
+  for (Item* item : {offload_start_item, offload_done_item, prefetch_start_item,
+                     prefetch_done_item}) {
+    instruction_list->Denylist(item->instruction);
+  }
+
+  // The offload runs from the definition to the current program point, where
+  // its memory is needed.
+  instruction_list->InsertBeforeInstructions(prefetch_done_item, place_before);
+  instruction_list->InsertBeforeInstructions(prefetch_start_item,
+                                             {prefetch_done_item});
+  instruction_list->InsertAfterInstructions(offload_start_item, {best_item});
+  instruction_list->InsertBeforeInstructions(
+      offload_done_item, {memory_tracker->in_progress_item()});
+
+  return 4;
+}
+
 // A simple struct to encapsulate the number of instructions added during
 // rematerialization.
 struct InstructionsAdded {
@@ -1503,7 +1748,21 @@ StatusOr<InstructionsAdded> RematerializeBestBlock(
     return num_instructions_added;
   }
 
-  if (best_strategy.kind == RematStrategy::kCompress) {
+  if (best_strategy.kind == RematStrategy::kOffload) {
+    CHECK(best_items.size() == 1)
+        << "More than one instruction offloaded simultaneously.";
+    HloInstruction* best = best_items[0]->instruction;
+    VLOG(1) << "Offloading instruction " << best->name() << " (saving "
+            << HumanReadableNumBytes(memory_tracker->MemoryReducedIfCompressed(
+                   best_items[0], best_strategy.compact_shape))
+            << ")";
+
+    TF_ASSIGN_OR_RETURN(
+        num_instructions_added.net_instructions_added,
+        OffloadInstruction(memory_tracker, best_items[0],
+                           best_strategy.compact_shape, instruction_list));
+  } else if (best_strategy.kind == RematStrategy::kCompress ||
+             best_strategy.kind == RematStrategy::kDownCast) {
     CHECK(best_items.size() == 1)
         << "More than one instruction compressed simultaneously.";
     HloInstruction* best = best_items[0]->instruction;
@@ -1532,7 +1791,7 @@ StatusOr<int64> HloRematerialization::ComputePeakMemory(
   InstructionList instruction_list(order);
   MemoryUsageTracker tracker(computation, size_function_,
                              compact_shape_function_, *points_to_analysis_,
-                             instruction_list, mode_);
+                             instruction_list, mode_, storage_options_);
   int64 peak_memory = tracker.memory_usage();
   for (auto* item = instruction_list.first(); item != nullptr;
        item = instruction_list.next(item)) {
@@ -1576,7 +1835,7 @@ StatusOr<bool> HloRematerialization::RematerializeComputation(
   InstructionList instruction_list(schedule->sequence(computation));
   MemoryUsageTracker memory_tracker(
       computation, size_function_, compact_shape_function_,
-      *points_to_analysis_, instruction_list, mode_);
+      *points_to_analysis_, instruction_list, mode_, storage_options_);
   bool changed = false;
 
   // If the rematerialization makes the source instruction dead, then the
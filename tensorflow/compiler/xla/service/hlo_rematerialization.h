@@ -29,6 +29,28 @@
 
 namespace xla {
 
+// Ways of storing a large value in a cheaper form between its last placed use
+// and its next use, considered by HloRematerialization in addition to
+// recomputation and layout compaction. Each has a cost per byte relative to
+// recomputing the value; the cost of a strategy only counts the bytes it
+// saves up to the amount the memory use is over the limit, so the cheapest
+// strategy which reaches the limit is preferred over one which saves more.
+struct RematerializationStorageOptions {
+  // If true, f32 arrays may be converted to bf16 after their definition and
+  // back to f32 before their next use. This loses precision, so it should only
+  // be enabled when the users tolerate it, e.g. for activations saved for the
+  // backward pass of a training step.
+  bool allow_bf16_storage = false;
+  double bf16_storage_cost = 1.5;
+
+  // If non-zero, the memory space of host memory. Arrays with a layout may
+  // then be copied to this memory space with an asynchronous copy after their
+  // definition and copied back before their next use. Buffers in this memory
+  // space do not count against the memory limit.
+  int64 host_memory_space = 0;
+  double host_offload_cost = 2.0;
+};
+
 // HLO pass which rematerializes instructions to reduce peak memory use, where
 // memory use is defined as the total size of all live HLO instruction
 // values. Parameters and constants are included in memory use estimates.
@@ -80,12 +102,17 @@ class HloRematerialization : public HloModulePass {
   //
   //   compact_shape_function: Function which returns the compact form of a
   //   shape. If nullptr is provided, an default identity function is used.
+  //
+  //   storage_options: The alternatives to recomputation to consider for
+  //     large values, unless 'mode' is kRecomputeOnly. None by default.
   explicit HloRematerialization(
       const ShapeSizeFunction& size_function, int64 memory_limit_bytes,
       RematerializationSizes* sizes, RematerializationPass pass_location,
       int block_size_limit,
       CompactShapeFunction compact_shape_function = nullptr,
-      RematerializationMode mode = RematerializationMode::kRecomputeAndCompress)
+      RematerializationMode mode = RematerializationMode::kRecomputeAndCompress,
+      const RematerializationStorageOptions& storage_options =
+          RematerializationStorageOptions())
       : size_function_(size_function),
         memory_limit_bytes_(memory_limit_bytes),
         sizes_(sizes),
@@ -94,7 +121,8 @@ class HloRematerialization : public HloModulePass {
         compact_shape_function_(compact_shape_function == nullptr
                                     ? DefaultCompactShapeFunction
                                     : std::move(compact_shape_function)),
-        mode_(mode) {}
+        mode_(mode),
+        storage_options_(storage_options) {}
   ~HloRematerialization() override = default;
 
   absl::string_view name() const override { return "rematerialization"; }
@@ -185,6 +213,8 @@ class HloRematerialization : public HloModulePass {
   int max_rematerialized_block_size_ = 0;
 
   RematerializationMode mode_;
+
+  const RematerializationStorageOptions storage_options_;
 };
 
 }  // namespace xla
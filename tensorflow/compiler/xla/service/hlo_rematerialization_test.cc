@@ -18,6 +18,7 @@ limitations under the License.
 #include <memory>
 #include <string>
 
+#include "absl/algorithm/container.h"
 #include "tensorflow/compiler/xla/service/hlo_computation.h"
 #include "tensorflow/compiler/xla/service/hlo_instruction.h"
 #include "tensorflow/compiler/xla/service/hlo_matchers.h"
@@ -675,6 +676,127 @@ ENTRY %entry {
               op::Reduce(op::Copy(op::Copy(broadcast)), op::Constant()));
 }
 
+class StorageRematerializationTest : public RematerializationTestBase {
+ protected:
+  // Runs rematerialization without recomputation, so that the storage
+  // strategies are the only ones which reduce memory use.
+  StatusOr<bool> RunHloRematerialization(
+      int64 memory_limit_bytes, HloModule* module,
+      const RematerializationStorageOptions& storage_options) {
+    TF_EXPECT_OK(verifier().Run(module).status());
+    HloRematerialization remat(
+        ByteSizeOf, memory_limit_bytes,
+        /*sizes=*/nullptr,
+        HloRematerialization::RematerializationPass::kPreFusion,
+        /*block_size_limit=*/1, /*compact_shape_function=*/nullptr,
+        HloRematerialization::RematerializationMode::kCompressOnly,
+        storage_options);
+    return remat.Run(module);
+  }
+
+  // The broadcast is live across reduce.0 and negate, which together with it
+  // use about 8KB.
+  static constexpr char kModule[] = R"(
+HloModule storage, is_scheduled=true
+
+%add_float {
+  %x = f32[] parameter(0)
+  %y = f32[] parameter(1)
+  ROOT %add = f32[] add(f32[] %x, f32[] %y)
+}
+
+ENTRY %entry {
+  %param.0 = f32[] parameter(0)
+  %constant = f32[] constant(0)
+  %broadcast.0 = f32[1024]{0} broadcast(f32[] %param.0), dimensions={}
+  %negate = f32[1024]{0} negate(f32[1024]{0} %broadcast.0)
+  %reduce.0 = f32[] reduce(f32[1024]{0} %negate, f32[] %constant), dimensions={0}, to_apply=%add_float
+  %reduce.1 = f32[] reduce(f32[1024]{0} %broadcast.0, f32[] %constant), dimensions={0}, to_apply=%add_float
+  ROOT %add = f32[] add(f32[] %reduce.0, f32[] %reduce.1)
+}
+)";
+};
+
+constexpr char StorageRematerializationTest::kModule[];
+
+TEST_F(StorageRematerializationTest, DownCastToBf16) {
+  TF_ASSERT_OK_AND_ASSIGN(auto module, ParseAndReturnVerifiedModule(kModule));
+  RematerializationStorageOptions storage_options;
+  storage_options.allow_bf16_storage = true;
+  TF_ASSERT_OK_AND_ASSIGN(
+      bool changed,
+      RunHloRematerialization(/*memory_limit_bytes=*/7 * 1024, module.get(),
+                              storage_options));
+  EXPECT_TRUE(changed);
+  HloInstruction* broadcast =
+      module->entry_computation()->GetInstructionWithName("broadcast.0");
+  HloInstruction* reduce =
+      module->entry_computation()->GetInstructionWithName("reduce.1");
+  EXPECT_THAT(reduce,
+              op::Reduce(op::Convert(op::Convert(broadcast)), op::Constant()));
+  EXPECT_EQ(reduce->operand(0)->operand(0)->shape().element_type(), BF16);
+}
+
+TEST_F(StorageRematerializationTest, OffloadToHost) {
+  TF_ASSERT_OK_AND_ASSIGN(auto module, ParseAndReturnVerifiedModule(kModule));
+  RematerializationStorageOptions storage_options;
+  storage_options.host_memory_space = 1;
+  TF_ASSERT_OK_AND_ASSIGN(
+      bool changed,
+      RunHloRematerialization(/*memory_limit_bytes=*/7 * 1024, module.get(),
+                              storage_options));
+  EXPECT_TRUE(changed);
+  HloComputation* entry = module->entry_computation();
+  HloInstruction* broadcast = entry->GetInstructionWithName("broadcast.0");
+  HloInstruction* reduce = entry->GetInstructionWithName("reduce.1");
+  EXPECT_THAT(reduce, op::Reduce(op::CopyDone(op::CopyStart(op::CopyDone(
+                                     op::CopyStart(broadcast)))),
+                                 op::Constant()));
+  const HloInstruction* offload_done =
+      reduce->operand(0)->operand(0)->operand(0);
+  EXPECT_EQ(offload_done->shape().layout().memory_space(), 1);
+
+  // The copy to host overlaps the negate, and the copy back follows the
+  // reduce which needed the memory.
+  const HloInstructionSequence& sequence = module->schedule().sequence(entry);
+  auto position = [&](const HloInstruction* instruction) {
+    return absl::c_find(sequence.instructions(), instruction) -
+           sequence.instructions().begin();
+  };
+  EXPECT_LT(position(offload_done->operand(0)),
+            position(entry->GetInstructionWithName("negate")));
+  EXPECT_LT(position(offload_done),
+            position(entry->GetInstructionWithName("reduce.0")));
+  EXPECT_GT(position(reduce->operand(0)->operand(0)),
+            position(entry->GetInstructionWithName("reduce.0")));
+}
+
+TEST_F(StorageRematerializationTest, PicksCheapestStrategyReachingLimit) {
+  RematerializationStorageOptions storage_options;
+  storage_options.allow_bf16_storage = true;
+  storage_options.host_memory_space = 1;
+
+  // Down-casting is cheaper and saves enough to reach the limit.
+  TF_ASSERT_OK_AND_ASSIGN(auto module, ParseAndReturnVerifiedModule(kModule));
+  TF_ASSERT_OK_AND_ASSIGN(
+      bool changed,
+      RunHloRematerialization(/*memory_limit_bytes=*/7 * 1024, module.get(),
+                              storage_options));
+  EXPECT_TRUE(changed);
+  EXPECT_THAT(module->entry_computation()->GetInstructionWithName("reduce.1"),
+              op::Reduce(op::Convert(), op::Constant()));
+
+  // Only offloading saves enough to reach the limit.
+  TF_ASSERT_OK_AND_ASSIGN(module, ParseAndReturnVerifiedModule(kModule));
+  TF_ASSERT_OK_AND_ASSIGN(
+      changed,
+      RunHloRematerialization(/*memory_limit_bytes=*/5 * 1024, module.get(),
+                              storage_options));
+  EXPECT_TRUE(changed);
+  EXPECT_THAT(module->entry_computation()->GetInstructionWithName("reduce.1"),
+              op::Reduce(op::CopyDone(), op::Constant()));
+}
+
 }  // namespace
 
 }  // namespace xla
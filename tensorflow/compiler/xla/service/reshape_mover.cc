@@ -389,24 +389,14 @@ StatusOr<bool> TryReshapeMoveOnCandidates(
 
 }  // namespace
 
-StatusOr<bool> ReshapeMover::Run(HloModule* module) {
-  bool changed = false;
-  VLOG(2) << "Pre ReshapeMover HLO:";
-  XLA_VLOG_LINES(2, module->ToString());
-  for (auto* comp : module->MakeNonfusionComputations()) {
-    HloInstructionSet reshape_candidates;
-    for (HloInstruction* instruction : comp->instructions()) {
-      if (IsReshapeMoveCandidate(instruction)) {
-        reshape_candidates.insert(instruction);
-      }
+StatusOr<bool> ReshapeMover::RunOnComputation(HloComputation* computation) {
+  HloInstructionSet reshape_candidates;
+  for (HloInstruction* instruction : computation->instructions()) {
+    if (IsReshapeMoveCandidate(instruction)) {
+      reshape_candidates.insert(instruction);
     }
-    TF_ASSIGN_OR_RETURN(bool did_change,
-                        TryReshapeMoveOnCandidates(&reshape_candidates));
-    changed |= did_change;
   }
-  VLOG(2) << "Post ReshapeMover HLO:";
-  XLA_VLOG_LINES(2, module->ToString());
-  return changed;
+  return TryReshapeMoveOnCandidates(&reshape_candidates);
 }
 
 }  // namespace xla
@@ -0,0 +1,403 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/spmd/auto_sharding.h"
+
+#include <limits>
+#include <vector>
+
+#include "absl/algorithm/container.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/types/optional.h"
+#include "absl/types/span.h"
+#include "tensorflow/compiler/xla/array.h"
+#include "tensorflow/compiler/xla/map_util.h"
+#include "tensorflow/compiler/xla/service/hlo_computation.h"
+#include "tensorflow/compiler/xla/service/hlo_instruction.h"
+#include "tensorflow/compiler/xla/service/hlo_opcode.h"
+#include "tensorflow/compiler/xla/service/hlo_sharding.h"
+#include "tensorflow/compiler/xla/service/hlo_sharding_util.h"
+#include "tensorflow/compiler/xla/shape_util.h"
+#include "tensorflow/compiler/xla/util.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace xla {
+namespace spmd {
+
+namespace {
+
+// One way to shard an instruction.
+struct ShardingStrategy {
+  HloSharding output_sharding = HloSharding::Replicate();
+  // The shardings the operands must have, one per operand.
+  std::vector<HloSharding> operand_shardings;
+  // The bytes the instruction itself communicates, e.g. to all-reduce the
+  // partial results of a dot sharded along its contracting dimensions.
+  double communication_bytes = 0;
+};
+
+// The strategies of an instruction, and the cheapest way to reach each one.
+struct StrategyChoices {
+  std::vector<ShardingStrategy> strategies;
+  // The total cost of every strategy, including the best strategies of the
+  // operands.
+  std::vector<double> costs;
+  // For every strategy, the best strategy of every operand.
+  std::vector<std::vector<int64>> operand_choices;
+};
+
+class AutoShardingSolver {
+ public:
+  explicit AutoShardingSolver(const AutoShardingOptions& options)
+      : options_(options) {}
+
+  // Chooses the shardings of the instructions of 'computation', and returns
+  // whether any instruction was given a sharding.
+  bool Solve(HloComputation* computation);
+
+ private:
+  // Returns whether the instruction takes part in the search.
+  static bool IsNode(const HloInstruction* hlo) {
+    return hlo->shape().IsArray();
+  }
+
+  // Returns whether 'dim' of 'shape' can be tiled across all devices.
+  bool CanTile(const Shape& shape, int64 dim) const {
+    return shape.dimensions(dim) >= options_.num_devices &&
+           shape.dimensions(dim) % options_.num_devices == 0;
+  }
+
+  // Returns the sharding tiling 'dim' of 'shape' across all devices.
+  HloSharding TileOn(const Shape& shape, int64 dim) const {
+    std::vector<int64> tiles(shape.rank(), 1);
+    tiles[dim] = options_.num_devices;
+    Array<int64> tile_assignment(tiles);
+    tile_assignment.FillIota(0);
+    return HloSharding::Tile(tile_assignment);
+  }
+
+  // Returns the bytes every device communicates to reshard an operand of
+  // 'shape' from 'from' to 'to'.
+  double ReshardBytes(const Shape& shape, const HloSharding& from,
+                      const HloSharding& to) const;
+
+  // Adds to 'strategies' the ways to shard 'hlo'.
+  void AddStrategies(const HloInstruction* hlo,
+                     std::vector<ShardingStrategy>* strategies) const;
+
+  // Fills in the strategies of 'hlo' and their costs.
+  void ComputeChoices(const HloInstruction* hlo);
+
+  const AutoShardingOptions& options_;
+  absl::flat_hash_map<const HloInstruction*, StrategyChoices> choices_;
+};
+
+double AutoShardingSolver::ReshardBytes(const Shape& shape,
+                                        const HloSharding& from,
+                                        const HloSharding& to) const {
+  if (from == to || from.IsReplicated()) {
+    // A replicated operand is sliced locally.
+    return 0;
+  }
+  const double bytes = ShapeUtil::ByteSizeOf(shape);
+  const double n = options_.num_devices;
+  if (to.IsReplicated()) {
+    // All-gather.
+    return bytes * (n - 1) / n;
+  }
+  // All-to-all of the shards.
+  return bytes * (n - 1) / (n * n);
+}
+
+void AutoShardingSolver::AddStrategies(
+    const HloInstruction* hlo,
+    std::vector<ShardingStrategy>* strategies) const {
+  const Shape& shape = hlo->shape();
+  auto add = [&](HloSharding output_sharding,
+                 std::vector<HloSharding> operand_shardings,
+                 double communication_bytes) {
+    ShardingStrategy strategy;
+    strategy.output_sharding = std::move(output_sharding);
+    strategy.operand_shardings = std::move(operand_shardings);
+    strategy.communication_bytes = communication_bytes;
+    strategies->push_back(std::move(strategy));
+  };
+  const std::vector<HloSharding> replicated_operands(hlo->operand_count(),
+                                                     HloSharding::Replicate());
+  add(HloSharding::Replicate(), replicated_operands, 0);
+  if (absl::c_any_of(hlo->operands(), [](const HloInstruction* operand) {
+        return !IsNode(operand);
+      })) {
+    return;
+  }
+
+  switch (hlo->opcode()) {
+    case HloOpcode::kConstant:
+    case HloOpcode::kIota:
+    case HloOpcode::kParameter:
+      for (int64 dim = 0; dim < shape.rank(); ++dim) {
+        if (CanTile(shape, dim)) {
+          add(TileOn(shape, dim), {}, 0);
+        }
+      }
+      return;
+    case HloOpcode::kBroadcast: {
+      const Shape& operand_shape = hlo->operand(0)->shape();
+      for (int64 dim = 0; dim < shape.rank(); ++dim) {
+        if (!CanTile(shape, dim)) {
+          continue;
+        }
+        auto it = absl::c_find(hlo->dimensions(), dim);
+        if (it == hlo->dimensions().end()) {
+          add(TileOn(shape, dim), replicated_operands, 0);
+        } else {
+          add(TileOn(shape, dim),
+              {TileOn(operand_shape, it - hlo->dimensions().begin())}, 0);
+        }
+      }
+      return;
+    }
+    case HloOpcode::kTranspose:
+      for (int64 dim = 0; dim < shape.rank(); ++dim) {
+        if (CanTile(shape, dim)) {
+          add(TileOn(shape, dim),
+              {TileOn(hlo->operand(0)->shape(), hlo->dimensions(dim))}, 0);
+        }
+      }
+      return;
+    case HloOpcode::kReshape:
+      for (int64 dim = 0; dim < shape.rank(); ++dim) {
+        if (!CanTile(shape, dim)) {
+          continue;
+        }
+        absl::optional<HloSharding> operand_sharding =
+            hlo_sharding_util::ReshapeSharding(
+                shape, hlo->operand(0)->shape(), TileOn(shape, dim));
+        if (operand_sharding.has_value()) {
+          add(TileOn(shape, dim), {*operand_sharding}, 0);
+        }
+      }
+      return;
+    case HloOpcode::kReduce: {
+      const Shape& input_shape = hlo->operand(0)->shape();
+      std::vector<int64> kept_dims;
+      for (int64 dim = 0; dim < input_shape.rank(); ++dim) {
+        if (!absl::c_linear_search(hlo->dimensions(), dim)) {
+          kept_dims.push_back(dim);
+        }
+      }
+      for (int64 dim = 0; dim < shape.rank(); ++dim) {
+        if (CanTile(shape, dim)) {
+          add(TileOn(shape, dim),
+              {TileOn(input_shape, kept_dims[dim]), HloSharding::Replicate()},
+              0);
+        }
+      }
+      // Reducing a tiled dimension leaves partial results to all-reduce.
+      const double n = options_.num_devices;
+      for (int64 dim : hlo->dimensions()) {
+        if (CanTile(input_shape, dim)) {
+          add(HloSharding::Replicate(),
+              {TileOn(input_shape, dim), HloSharding::Replicate()},
+              2 * ShapeUtil::ByteSizeOf(shape) * (n - 1) / n);
+        }
+      }
+      return;
+    }
+    case HloOpcode::kDot: {
+      const Shape& lhs_shape = hlo->operand(0)->shape();
+      const Shape& rhs_shape = hlo->operand(1)->shape();
+      const DotDimensionNumbers& dnums = hlo->dot_dimension_numbers();
+      auto free_dims = [](const Shape& shape, absl::Span<const int64> batch,
+                          absl::Span<const int64> contracting) {
+        std::vector<int64> dims;
+        for (int64 dim = 0; dim < shape.rank(); ++dim) {
+          if (!absl::c_linear_search(batch, dim) &&
+              !absl::c_linear_search(contracting, dim)) {
+            dims.push_back(dim);
+          }
+        }
+        return dims;
+      };
+      const std::vector<int64> lhs_free =
+          free_dims(lhs_shape, AsInt64Slice(dnums.lhs_batch_dimensions()),
+                    AsInt64Slice(dnums.lhs_contracting_dimensions()));
+      const std::vector<int64> rhs_free =
+          free_dims(rhs_shape, AsInt64Slice(dnums.rhs_batch_dimensions()),
+                    AsInt64Slice(dnums.rhs_contracting_dimensions()));
+      const int64 num_batch = dnums.lhs_batch_dimensions_size();
+      const int64 num_lhs_free = lhs_free.size();
+      // The output dimensions are the batch dimensions, then the free
+      // dimensions of the lhs, then those of the rhs.
+      for (int64 dim = 0; dim < shape.rank(); ++dim) {
+        if (!CanTile(shape, dim)) {
+          continue;
+        }
+        HloSharding lhs_sharding = HloSharding::Replicate();
+        HloSharding rhs_sharding = HloSharding::Replicate();
+        if (dim < num_batch) {
+          lhs_sharding = TileOn(lhs_shape, dnums.lhs_batch_dimensions(dim));
+          rhs_sharding = TileOn(rhs_shape, dnums.rhs_batch_dimensions(dim));
+        } else if (dim < num_batch + num_lhs_free) {
+          lhs_sharding = TileOn(lhs_shape, lhs_free[dim - num_batch]);
+        } else {
+          rhs_sharding =
+              TileOn(rhs_shape, rhs_free[dim - num_batch - num_lhs_free]);
+        }
+        add(TileOn(shape, dim), {lhs_sharding, rhs_sharding}, 0);
+      }
+      // Tiling a contracting dimension leaves partial sums to all-reduce.
+      const double n = options_.num_devices;
+      for (int64 i = 0; i < dnums.lhs_contracting_dimensions_size(); ++i) {
+        const int64 lhs_dim = dnums.lhs_contracting_dimensions(i);
+        const int64 rhs_dim = dnums.rhs_contracting_dimensions(i);
+        if (CanTile(lhs_shape, lhs_dim)) {
+          add(HloSharding::Replicate(),
+              {TileOn(lhs_shape, lhs_dim), TileOn(rhs_shape, rhs_dim)},
+              2 * ShapeUtil::ByteSizeOf(shape) * (n - 1) / n);
+        }
+      }
+      return;
+    }
+    default:
+      break;
+  }
+
+  if (hlo->IsElementwise() &&
+      absl::c_all_of(hlo->operands(), [&](const HloInstruction* operand) {
+        return ShapeUtil::SameDimensions(operand->shape(), shape);
+      })) {
+    for (int64 dim = 0; dim < shape.rank(); ++dim) {
+      if (!CanTile(shape, dim)) {
+        continue;
+      }
+      std::vector<HloSharding> operand_shardings;
+      for (const HloInstruction* operand : hlo->operands()) {
+        operand_shardings.push_back(TileOn(operand->shape(), dim));
+      }
+      add(TileOn(shape, dim), std::move(operand_shardings), 0);
+    }
+  }
+}
+
+void AutoShardingSolver::ComputeChoices(const HloInstruction* hlo) {
+  StrategyChoices& choices = choices_[hlo];
+  AddStrategies(hlo, &choices.strategies);
+  if (hlo->has_sharding()) {
+    // Keep the strategies which agree with the existing sharding, or else
+    // assume the operands have to be replicated.
+    std::vector<ShardingStrategy> agreeing;
+    for (ShardingStrategy& strategy : choices.strategies) {
+      if (strategy.output_sharding == hlo->sharding()) {
+        agreeing.push_back(std::move(strategy));
+      }
+    }
+    if (agreeing.empty()) {
+      agreeing.resize(1);
+      agreeing[0].output_sharding = hlo->sharding();
+      agreeing[0].operand_shardings.assign(hlo->operand_count(),
+                                           HloSharding::Replicate());
+    }
+    choices.strategies = std::move(agreeing);
+  }
+
+  for (const ShardingStrategy& strategy : choices.strategies) {
+    const double held_bytes =
+        strategy.output_sharding.IsReplicated()
+            ? ShapeUtil::ByteSizeOf(hlo->shape())
+            : ShapeUtil::ByteSizeOf(
+                  strategy.output_sharding.TileShape(hlo->shape()));
+    double cost = strategy.communication_bytes +
+                  options_.memory_cost_per_byte * held_bytes;
+    std::vector<int64> operand_choices(hlo->operand_count(), -1);
+    for (int64 i = 0; i < hlo->operand_count(); ++i) {
+      const HloInstruction* operand = hlo->operand(i);
+      if (!IsNode(operand)) {
+        continue;
+      }
+      const StrategyChoices& operand_choices_so_far =
+          FindOrDie(choices_, operand);
+      double best = std::numeric_limits<double>::infinity();
+      for (int64 j = 0; j < operand_choices_so_far.strategies.size(); ++j) {
+        const double operand_cost =
+            operand_choices_so_far.costs[j] +
+            ReshardBytes(operand->shape(),
+                         operand_choices_so_far.strategies[j].output_sharding,
+                         strategy.operand_shardings[i]);
+        if (operand_cost < best) {
+          best = operand_cost;
+          operand_choices[i] = j;
+        }
+      }
+      cost += best;
+    }
+    choices.costs.push_back(cost);
+    choices.operand_choices.push_back(std::move(operand_choices));
+  }
+}
+
+bool AutoShardingSolver::Solve(HloComputation* computation) {
+  const std::vector<HloInstruction*> post_order =
+      computation->MakeInstructionPostOrder();
+  for (const HloInstruction* hlo : post_order) {
+    if (IsNode(hlo)) {
+      ComputeChoices(hlo);
+    }
+  }
+
+  // Every user comes before its operands in the reverse post order, so the
+  // strategy of an instruction is decided by the time its operands are
+  // visited. Instructions with no array-shaped users take their cheapest
+  // strategy.
+  absl::flat_hash_map<const HloInstruction*, int64> chosen;
+  bool changed = false;
+  for (auto it = post_order.rbegin(); it != post_order.rend(); ++it) {
+    HloInstruction* hlo = *it;
+    if (!IsNode(hlo)) {
+      continue;
+    }
+    const StrategyChoices& choices = FindOrDie(choices_, hlo);
+    if (!chosen.contains(hlo)) {
+      chosen[hlo] = absl::c_min_element(choices.costs) - choices.costs.begin();
+    }
+    const int64 strategy = chosen[hlo];
+    for (int64 i = 0; i < hlo->operand_count(); ++i) {
+      const int64 operand_choice = choices.operand_choices[strategy][i];
+      if (operand_choice >= 0) {
+        chosen.emplace(hlo->operand(i), operand_choice);
+      }
+    }
+    if (!hlo->has_sharding()) {
+      VLOG(2) << "Sharding " << hlo->name() << " as "
+              << choices.strategies[strategy].output_sharding.ToString();
+      hlo->set_sharding(choices.strategies[strategy].output_sharding);
+      changed = true;
+    }
+  }
+  return changed;
+}
+
+}  // namespace
+
+StatusOr<bool> AutoSharding::Run(HloModule* module) {
+  if (options_.num_devices <= 1) {
+    return false;
+  }
+  AutoShardingSolver solver(options_);
+  return solver.Solve(module->entry_computation());
+}
+
+}  // namespace spmd
+}  // namespace xla
@@ -0,0 +1,61 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMPILER_XLA_SERVICE_SPMD_AUTO_SHARDING_H_
+#define TENSORFLOW_COMPILER_XLA_SERVICE_SPMD_AUTO_SHARDING_H_
+
+#include "tensorflow/compiler/xla/service/hlo_module.h"
+#include "tensorflow/compiler/xla/service/hlo_pass_interface.h"
+#include "tensorflow/compiler/xla/statusor.h"
+
+namespace xla {
+namespace spmd {
+
+struct AutoShardingOptions {
+  // The number of devices arrays are tiled across.
+  int64 num_devices = 1;
+
+  // The cost of a byte of an array held on every device, relative to the cost
+  // of a byte communicated between devices. Higher values favor tiling arrays
+  // over replicating them.
+  double memory_cost_per_byte = 0.1;
+};
+
+// Chooses shardings for the array-shaped instructions of the entry computation
+// which have none, for SpmdPartitioner to partition. Every such instruction is
+// either replicated or tiled along one of its dimensions across all devices,
+// and the choice minimizes the bytes communicated to reshard operands and to
+// reduce partial results, plus the weighted bytes every device holds.
+// Shardings already in the module are kept, and constrain the choices.
+//
+// The search is a dynamic program over the post order, which is exact when
+// every instruction has a single user. An instruction with several users takes
+// the sharding the user closest to the root of the computation prefers. Tuples
+// are left to ShardingPropagation.
+class AutoSharding : public HloModulePass {
+ public:
+  explicit AutoSharding(const AutoShardingOptions& options)
+      : options_(options) {}
+  absl::string_view name() const override { return "auto-sharding"; }
+  StatusOr<bool> Run(HloModule* module) override;
+
+ private:
+  AutoShardingOptions options_;
+};
+
+}  // namespace spmd
+}  // namespace xla
+
+#endif  // TENSORFLOW_COMPILER_XLA_SERVICE_SPMD_AUTO_SHARDING_H_
@@ -0,0 +1,122 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/spmd/auto_sharding.h"
+
+#include "tensorflow/compiler/xla/service/hlo_computation.h"
+#include "tensorflow/compiler/xla/service/hlo_instruction.h"
+#include "tensorflow/compiler/xla/service/hlo_parser.h"
+#include "tensorflow/compiler/xla/service/hlo_sharding.h"
+#include "tensorflow/compiler/xla/tests/hlo_test_base.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+
+namespace xla {
+namespace spmd {
+namespace {
+
+class AutoShardingTest : public HloTestBase {
+ protected:
+  StatusOr<std::unique_ptr<VerifiedHloModule>> RunAutoSharding(
+      const char* hlo_string, int64 num_devices) {
+    TF_ASSIGN_OR_RETURN(auto module, ParseAndReturnVerifiedModule(hlo_string));
+    AutoShardingOptions options;
+    options.num_devices = num_devices;
+    TF_ASSIGN_OR_RETURN(bool changed,
+                        AutoSharding(options).Run(module.get()));
+    EXPECT_TRUE(changed);
+    return std::move(module);
+  }
+
+  static const HloSharding& ShardingOf(HloModule* module,
+                                       absl::string_view name) {
+    HloInstruction* hlo =
+        module->entry_computation()->GetInstructionWithName(name);
+    CHECK(hlo != nullptr) << name;
+    CHECK(hlo->has_sharding()) << name;
+    return hlo->sharding();
+  }
+};
+
+TEST_F(AutoShardingTest, TilesElementwiseChain) {
+  TF_ASSERT_OK_AND_ASSIGN(auto module, RunAutoSharding(R"(
+    HloModule m
+
+    ENTRY entry {
+      p0 = f32[64,128] parameter(0)
+      p1 = f32[64,128] parameter(1)
+      a = f32[64,128] add(p0, p1)
+      ROOT m = f32[64,128] multiply(a, p1)
+    })",
+                                                       /*num_devices=*/4));
+  const HloSharding& root = ShardingOf(module.get(), "m");
+  EXPECT_FALSE(root.IsReplicated());
+  EXPECT_EQ(ShardingOf(module.get(), "a"), root);
+  EXPECT_EQ(ShardingOf(module.get(), "p0"), root);
+  EXPECT_EQ(ShardingOf(module.get(), "p1"), root);
+}
+
+TEST_F(AutoShardingTest, DotFollowsShardedBatch) {
+  // The activations are sharded along the batch, so the small weights are
+  // replicated rather than gathering the activations.
+  TF_ASSERT_OK_AND_ASSIGN(auto module, RunAutoSharding(R"(
+    HloModule m
+
+    ENTRY entry {
+      x = f32[256,64] parameter(0), sharding={devices=[4,1]0,1,2,3}
+      w = f32[64,32] parameter(1)
+      ROOT d = f32[256,32] dot(x, w), lhs_contracting_dims={1},
+        rhs_contracting_dims={0}
+    })",
+                                                       /*num_devices=*/4));
+  EXPECT_EQ(ShardingOf(module.get(), "x").ToString(), "{devices=[4,1]0,1,2,3}");
+  EXPECT_TRUE(ShardingOf(module.get(), "w").IsReplicated());
+  EXPECT_EQ(ShardingOf(module.get(), "d").ToString(), "{devices=[4,1]0,1,2,3}");
+}
+
+TEST_F(AutoShardingTest, DotShardsLargeContractingDimension) {
+  // Both operands are much larger than the result, so the contracting
+  // dimension is split and the partial results all-reduced.
+  TF_ASSERT_OK_AND_ASSIGN(auto module, RunAutoSharding(R"(
+    HloModule m
+
+    ENTRY entry {
+      x = f32[16,4096] parameter(0)
+      w = f32[4096,16] parameter(1)
+      ROOT d = f32[16,16] dot(x, w), lhs_contracting_dims={1},
+        rhs_contracting_dims={0}
+    })",
+                                                       /*num_devices=*/4));
+  EXPECT_EQ(ShardingOf(module.get(), "x").ToString(), "{devices=[1,4]0,1,2,3}");
+  EXPECT_EQ(ShardingOf(module.get(), "w").ToString(), "{devices=[4,1]0,1,2,3}");
+  EXPECT_TRUE(ShardingOf(module.get(), "d").IsReplicated());
+}
+
+TEST_F(AutoShardingTest, SingleDeviceIsNoOp) {
+  TF_ASSERT_OK_AND_ASSIGN(auto module, ParseAndReturnVerifiedModule(R"(
+    HloModule m
+
+    ENTRY entry {
+      p0 = f32[64,128] parameter(0)
+      ROOT n = f32[64,128] negate(p0)
+    })"));
+  AutoShardingOptions options;
+  TF_ASSERT_OK_AND_ASSIGN(bool changed,
+                          AutoSharding(options).Run(module.get()));
+  EXPECT_FALSE(changed);
+}
+
+}  // namespace
+}  // namespace spmd
+}  // namespace xla
@@ -1822,5 +1822,86 @@ void DOT_ReorderContracting(int num_iters) {
 
 BENCHMARK(DOT_ReorderContracting);
 
+// Compares the linalg code emitted for a size x size x size GEMM on the CPU
+// backend with the call into Eigen, by setting the linalg size limit either
+// above or below the size of the GEMM.  Run it as part of the single threaded
+// runtime test to compare against single threaded Eigen.
+void DOT_LinalgVsEigenMatmul(int num_iters, int size, int use_linalg) {
+  tensorflow::testing::StopTiming();
+
+  se::Platform* platform = PlatformUtil::GetDefaultPlatform().ValueOrDie();
+  auto executors = PlatformUtil::GetStreamExecutors(platform).ValueOrDie();
+  se::StreamExecutorMemoryAllocator allocator(platform, executors);
+
+  xla::LocalClientOptions client_options;
+  client_options.set_platform(platform);
+  auto client =
+      ClientLibrary::GetOrCreateLocalClient(client_options).ValueOrDie();
+
+  int device_ordinal = client->default_device_ordinal();
+
+  Array2D<float> lhs_arr(size, size);
+  Array2D<float> rhs_arr(size, size);
+  lhs_arr.FillIota(0);
+  rhs_arr.FillIota(0);
+  XlaBuilder builder("LinalgVsEigenMatmul");
+  Shape shape = ShapeUtil::MakeShape(F32, {size, size});
+  auto lhs = Parameter(&builder, 0, shape, "lhs");
+  auto rhs = Parameter(&builder, 1, shape, "rhs");
+  Dot(lhs, rhs);
+  auto computation = builder.Build().ConsumeValueOrDie();
+
+  ScopedShapedBuffer lhs_buffer =
+      client
+          ->LiteralToShapedBuffer(LiteralUtil::CreateR2FromArray2D(lhs_arr),
+                                  device_ordinal)
+          .ConsumeValueOrDie();
+  ScopedShapedBuffer rhs_buffer =
+      client
+          ->LiteralToShapedBuffer(LiteralUtil::CreateR2FromArray2D(rhs_arr),
+                                  device_ordinal)
+          .ConsumeValueOrDie();
+
+  ExecutableBuildOptions build_options;
+  const int64 gemm_size = static_cast<int64>(size) * size * size;
+  (*build_options.mutable_debug_options()
+        ->mutable_xla_backend_extra_options())
+      ["xla_cpu_linalg_matmul_max_size"] =
+          absl::StrCat(use_linalg ? gemm_size : gemm_size - 1);
+  TF_ASSERT_OK_AND_ASSIGN(
+      auto executables,
+      client->Compile(computation, {&shape, &shape}, build_options));
+  auto executable = std::move(executables[0]);
+
+  std::vector<const ShapedBuffer*> arguments = {&lhs_buffer, &rhs_buffer};
+  ExecutableRunOptions options;
+  options.set_allocator(&allocator);
+
+  const int kWarmups = 2;
+  for (int i = 0; i < kWarmups; ++i) {
+    ASSERT_IS_OK(executable->Run(arguments, options));
+  }
+
+  tensorflow::testing::ItemsProcessed(static_cast<int64>(num_iters) * 2 *
+                                      gemm_size);
+  tensorflow::testing::UseRealTime();
+  tensorflow::testing::StartTiming();
+  for (int i = 0; i < num_iters; ++i) {
+    ASSERT_IS_OK(executable->Run(arguments, options));
+  }
+}
+
+BENCHMARK(DOT_LinalgVsEigenMatmul)
+    ->ArgPair(8, 0)
+    ->ArgPair(8, 1)
+    ->ArgPair(16, 0)
+    ->ArgPair(16, 1)
+    ->ArgPair(32, 0)
+    ->ArgPair(32, 1)
+    ->ArgPair(64, 0)
+    ->ArgPair(64, 1)
+    ->ArgPair(128, 0)
+    ->ArgPair(128, 1);
+
 }  // namespace
 }  // namespace xla
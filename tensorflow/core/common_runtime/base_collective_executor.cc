@@ -37,6 +37,7 @@ limitations under the License.
 #include "tensorflow/core/platform/tracing.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/profiler/lib/traceme.h"
+#include "tensorflow/core/util/env_var.h"
 
 #define VALUE_IN_DEBUG_STRING false
 
@@ -213,10 +214,30 @@ CollectiveAdapter* MakeCollectiveAdapter(Tensor* output, int num_chunks,
 
 BaseCollectiveExecutor::~BaseCollectiveExecutor() {}
 
+/*static*/
+std::unique_ptr<CollectiveLaunchQueue>
+BaseCollectiveExecutor::MaybeCreateLaunchQueue() {
+  static const int64 max_concurrent_reductions = [] {
+    int64 value;
+    Status s = ReadInt64FromEnvVar("TF_COLLECTIVE_MAX_CONCURRENT_REDUCTIONS",
+                                   /*default_val=*/0, &value);
+    if (!s.ok()) {
+      LOG(ERROR) << "Ignoring TF_COLLECTIVE_MAX_CONCURRENT_REDUCTIONS: " << s;
+      return int64{0};
+    }
+    return value;
+  }();
+  if (max_concurrent_reductions <= 0) return nullptr;
+  return std::make_unique<CollectiveLaunchQueue>(max_concurrent_reductions);
+}
+
 void BaseCollectiveExecutor::StartAbort(const Status& s) {
   VLOG(1) << "BaseCollectiveExecutor::StartAbort " << s;
   cem_->GetParamResolver()->StartAbort(s);
   remote_access_->StartAbort(s);
+  if (launch_queue_ != nullptr) {
+    launch_queue_->StartAbort();
+  }
 }
 
 void BaseCollectiveExecutor::ExecuteAsync(OpKernelContext* ctx,
@@ -276,25 +297,51 @@ void BaseCollectiveExecutor::ExecuteAsync(OpKernelContext* ctx,
     done_safe(status);
     return;
   }
+  // Reductions with a priority may be held back so that the ones needed
+  // first by the next step get the interconnect to themselves.
+  CollectiveLaunchQueue* launch_queue =
+      (launch_queue_ != nullptr &&
+       col_params.instance.type == REDUCTION_COLLECTIVE &&
+       col_params.launch_priority >= 0)
+          ? launch_queue_.get()
+          : nullptr;
+  const int64 priority = col_params.launch_priority;
+  const int32 instance_key = col_params.instance.instance_key;
+  StatusCallback run_done = done_safe;
+  if (launch_queue != nullptr) {
+    run_done = [launch_queue, priority, instance_key,
+                done_safe](const Status& s) {
+      launch_queue->Finished(priority, instance_key);
+      done_safe(s);
+    };
+  }
   // Run on an unbounded work queue that can handle blocking work so as to not
   // starve executor threads.
   col_impl->Ref();
-  RunClosure([col_impl, col_ctx, done_safe, ctx]() {
-    core::ScopedUnref unref(col_impl);
-    profiler::TraceMe activity(
-        [ctx] {
-          string op = profiler::TraceMeOp(ctx->op_kernel().name_view(),
-                                          ctx->op_kernel().type_string_view());
-          return profiler::TraceMeEncode(std::move(op),
-                                         {{"id", ctx->step_id()}});
-        },
-        profiler::TraceMeLevel::kInfo);
-    col_impl->Ref();
-    col_impl->Run([col_impl, col_ctx, done_safe](const Status& s) {
+  auto launch = [this, col_impl, col_ctx, run_done, ctx]() {
+    RunClosure([col_impl, col_ctx, run_done, ctx]() {
       core::ScopedUnref unref(col_impl);
-      done_safe(s);
+      profiler::TraceMe activity(
+          [ctx] {
+            string op = profiler::TraceMeOp(
+                ctx->op_kernel().name_view(),
+                ctx->op_kernel().type_string_view());
+            return profiler::TraceMeEncode(std::move(op),
+                                           {{"id", ctx->step_id()}});
+          },
+          profiler::TraceMeLevel::kInfo);
+      col_impl->Ref();
+      col_impl->Run([col_impl, col_ctx, run_done](const Status& s) {
+        core::ScopedUnref unref(col_impl);
+        run_done(s);
+      });
     });
-  });
+  };
+  if (launch_queue != nullptr) {
+    launch_queue->Schedule(priority, instance_key, std::move(launch));
+  } else {
+    launch();
+  }
 }
 
 void BaseCollectiveExecutor::CompleteParamsAsync(
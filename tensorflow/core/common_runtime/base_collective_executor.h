@@ -19,6 +19,7 @@ limitations under the License.
 #include <string>
 
 #include "tensorflow/core/common_runtime/buf_rendezvous.h"
+#include "tensorflow/core/common_runtime/collective_launch_queue.h"
 #include "tensorflow/core/framework/collective.h"
 #include "tensorflow/core/framework/device_attributes.pb.h"
 #include "tensorflow/core/platform/unbounded_work_queue.h"
@@ -104,7 +105,8 @@ class BaseCollectiveExecutor : public CollectiveExecutor {
         dev_mgr_(dev_mgr),
         remote_access_(remote_access),
         gpu_ring_order_(gpu_ring_order),
-        work_queue_(std::move(work_queue)) {}
+        work_queue_(std::move(work_queue)),
+        launch_queue_(MaybeCreateLaunchQueue()) {}
 
   ~BaseCollectiveExecutor() override;
 
@@ -148,8 +150,12 @@ class BaseCollectiveExecutor : public CollectiveExecutor {
   // collective instance key -> number of local devices for which NCCL ops have
   // been launched.
   std::unordered_map<int32, int32> launched_ TF_GUARDED_BY(launch_mu_);
+  // Orders the launch of reductions with a launch_priority.  Null unless
+  // TF_COLLECTIVE_MAX_CONCURRENT_REDUCTIONS is positive.
+  std::unique_ptr<CollectiveLaunchQueue> launch_queue_;
 
  private:
+  static std::unique_ptr<CollectiveLaunchQueue> MaybeCreateLaunchQueue();
   Status CreateCollective(const CollectiveParams& col_params,
                           CollectiveImplementationInterface** col_impl);
   // Check if all ops on which this collective depends on have launched.
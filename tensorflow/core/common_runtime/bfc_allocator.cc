@@ -19,16 +19,15 @@ limitations under the License.
 
 #include "absl/strings/string_view.h"
 #include "tensorflow/core/common_runtime/allocator_retry.h"
+#include "tensorflow/core/framework/metrics.h"
 #include "tensorflow/core/lib/core/bits.h"
 #include "tensorflow/core/lib/strings/numbers.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/file_system.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/env_time.h"
 #include "tensorflow/core/platform/mutex.h"
-#ifdef TENSORFLOW_MEM_DEBUG
-#include "tensorflow/core/platform/stacktrace.h"
-#endif
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/profiler/lib/traceme.h"
@@ -37,13 +36,23 @@ limitations under the License.
 namespace tensorflow {
 
 constexpr BFCAllocator::ChunkHandle BFCAllocator::kInvalidChunkHandle;
+constexpr size_t BFCAllocator::kThreadCacheMaxRequestBytes;
+constexpr size_t BFCAllocator::kThreadCacheMaxTotalBytes;
+constexpr int BFCAllocator::kSizeHistorySize;
+
+namespace {
+// The source of BFCAllocator::thread_cache_id_ values.
+std::atomic<int64> next_thread_cache_id{0};
+}  // namespace
 
 BFCAllocator::BFCAllocator(SubAllocator* sub_allocator, size_t total_memory,
                            bool allow_growth, const string& name,
-                           bool garbage_collection)
+                           bool garbage_collection, bool thread_cache)
     : garbage_collection_(garbage_collection),
       sub_allocator_(sub_allocator),
       name_(name),
+      thread_cache_(thread_cache),
+      thread_cache_id_(next_thread_cache_id.fetch_add(1)),
       free_chunks_list_(kInvalidChunkHandle),
       next_allocation_id_(1) {
   if (allow_growth) {
@@ -230,6 +239,14 @@ void* BFCAllocator::AllocateRawInternalWithRetry(
 void* BFCAllocator::AllocateRaw(size_t unused_alignment, size_t num_bytes,
                                 const AllocationAttributes& allocation_attr) {
   VLOG(1) << "AllocateRaw " << Name() << "  " << num_bytes;
+  const bool use_thread_cache = UseThreadCache(num_bytes, allocation_attr);
+  if (use_thread_cache) {
+    void* ptr = AllocateFromThreadCache(num_bytes);
+    if (ptr != nullptr) return ptr;
+  }
+  // Thread cache hits are cheap enough not to be timed.
+  const uint64 start_nsec = EnvTime::NowNanos();
+  void* result;
   if (!allocation_attr.retry_on_failure) {
     // Return immediately upon the first failure if this is for allocating an
     // optional scratch space.
@@ -238,8 +255,8 @@ void* BFCAllocator::AllocateRaw(size_t unused_alignment, size_t num_bytes,
     if (allocation_attr.freed_by_func != nullptr) {
       freed_by_count = (*allocation_attr.freed_by_func)();
     }
-    void* result = AllocateRawInternal(unused_alignment, num_bytes,
-                                       dump_log_on_failure, freed_by_count);
+    result = AllocateRawInternal(unused_alignment, num_bytes,
+                                 dump_log_on_failure, freed_by_count);
     if (result == nullptr) {
       static std::atomic<int32> log_counter{0};
       int32 counter_value = log_counter.load(std::memory_order_relaxed);
@@ -255,11 +272,137 @@ void* BFCAllocator::AllocateRaw(size_t unused_alignment, size_t num_bytes,
             << " memory were available.";
       }
     }
-    return result;
   } else {
-    return AllocateRawInternalWithRetry(unused_alignment, num_bytes,
-                                        allocation_attr);
+    result = AllocateRawInternalWithRetry(unused_alignment, num_bytes,
+                                          allocation_attr);
+  }
+  if (use_thread_cache && result != nullptr) {
+    // Remember the buffer, so that DeallocateRaw() can add it to a cache.
+    ThreadCache::Entry entry{num_bytes, AllocatedSize(result), result};
+    CachedChunkTableShard* shard = CachedChunkTableShardFor(result);
+    mutex_lock l(shard->mu);
+    shard->chunks.emplace(result, entry);
+  }
+  metrics::AddThreadAllocationTime(EnvTime::NowNanos() - start_nsec);
+  return result;
+}
+
+BFCAllocator::ThreadCache* BFCAllocator::GetThreadCache() {
+  // The caches of the allocators most recently used by this thread. When an
+  // entry is evicted, its cache stays registered with its allocator (so that
+  // its buffers are still released on memory pressure), and the thread gets
+  // a fresh cache if it uses that allocator again.
+  struct ThreadCacheRef {
+    int64 allocator_id;
+    ThreadCache* cache;
+  };
+  static constexpr int kMaxThreadCacheRefs = 8;
+  thread_local std::deque<ThreadCacheRef> thread_cache_refs;
+  for (const ThreadCacheRef& ref : thread_cache_refs) {
+    if (ref.allocator_id == thread_cache_id_) return ref.cache;
+  }
+  ThreadCache* cache;
+  {
+    mutex_lock l(lock_);
+    thread_caches_.emplace_back(new ThreadCache);
+    cache = thread_caches_.back().get();
+  }
+  if (thread_cache_refs.size() == kMaxThreadCacheRefs) {
+    thread_cache_refs.pop_front();
+  }
+  thread_cache_refs.push_back({thread_cache_id_, cache});
+  return cache;
+}
+
+void* BFCAllocator::AllocateFromThreadCache(size_t num_bytes) {
+  ThreadCache* cache = GetThreadCache();
+  {
+    mutex_lock l(cache->mu);
+    auto it = cache->free_lists.find(num_bytes);
+    if (it != cache->free_lists.end() && !it->second.empty()) {
+      // Reuse the most recently freed buffer, which is the most likely to
+      // still be in the cache hierarchy.
+      const ThreadCache::Entry entry = it->second.back();
+      it->second.pop_back();
+      cache->total_bytes -= entry.chunk_bytes;
+      thread_cache_bytes_.fetch_sub(entry.chunk_bytes,
+                                    std::memory_order_relaxed);
+      num_thread_cache_hits_.fetch_add(1, std::memory_order_relaxed);
+      return entry.ptr;
+    }
   }
+  num_thread_cache_misses_.fetch_add(1, std::memory_order_relaxed);
+  return nullptr;
+}
+
+bool BFCAllocator::DeallocateToThreadCache(void* ptr) {
+  ThreadCache::Entry entry;
+  {
+    CachedChunkTableShard* shard = CachedChunkTableShardFor(ptr);
+    mutex_lock l(shard->mu);
+    auto it = shard->chunks.find(ptr);
+    if (it == shard->chunks.end()) return false;
+    entry = it->second;
+  }
+  ThreadCache* cache = GetThreadCache();
+  std::vector<ThreadCache::Entry> to_release;
+  {
+    mutex_lock l(cache->mu);
+    cache->free_lists[entry.num_bytes].push_back(entry);
+    cache->total_bytes += entry.chunk_bytes;
+    thread_cache_bytes_.fetch_add(entry.chunk_bytes, std::memory_order_relaxed);
+    if (cache->total_bytes > kThreadCacheMaxTotalBytes) {
+      // Return the older half of each free list to the bins in one batch.
+      for (auto& free_list : cache->free_lists) {
+        std::vector<ThreadCache::Entry>& entries = free_list.second;
+        const size_t num_to_release = (entries.size() + 1) / 2;
+        for (size_t i = 0; i < num_to_release; ++i) {
+          cache->total_bytes -= entries[i].chunk_bytes;
+          to_release.push_back(entries[i]);
+        }
+        entries.erase(entries.begin(), entries.begin() + num_to_release);
+      }
+    }
+  }
+  if (!to_release.empty()) {
+    {
+      mutex_lock l(lock_);
+      ReleaseThreadCacheEntries(to_release);
+    }
+    retry_helper_.NotifyDealloc();
+  }
+  return true;
+}
+
+void BFCAllocator::ReleaseThreadCacheEntries(
+    const std::vector<ThreadCache::Entry>& entries) {
+  int64 released_bytes = 0;
+  for (const ThreadCache::Entry& entry : entries) {
+    {
+      CachedChunkTableShard* shard = CachedChunkTableShardFor(entry.ptr);
+      mutex_lock l(shard->mu);
+      shard->chunks.erase(entry.ptr);
+    }
+    DeallocateRawLocked(entry.ptr);
+    released_bytes += entry.chunk_bytes;
+  }
+  thread_cache_bytes_.fetch_sub(released_bytes, std::memory_order_relaxed);
+}
+
+bool BFCAllocator::FlushThreadCaches() {
+  std::vector<ThreadCache::Entry> entries;
+  for (const auto& cache : thread_caches_) {
+    mutex_lock l(cache->mu);
+    for (const auto& free_list : cache->free_lists) {
+      entries.insert(entries.end(), free_list.second.begin(),
+                     free_list.second.end());
+    }
+    cache->free_lists.clear();
+    cache->total_bytes = 0;
+  }
+  if (entries.empty()) return false;
+  ReleaseThreadCacheEntries(entries);
+  return true;
 }
 
 // static
@@ -412,6 +555,16 @@ void* BFCAllocator::AllocateRawInternal(size_t unused_alignment,
     }
   }
 
+  // Buffers held in thread caches are free from the user's point of view, so
+  // return them to the bins before going any further.
+  if (FlushThreadCaches()) {
+    ptr = FindChunkPtr(bin_num, rounded_bytes, num_bytes, freed_before);
+    if (ptr != nullptr) {
+      AddTraceMe("MemoryAllocation", ptr);
+      return ptr;
+    }
+  }
+
   // Reaching this point means that no chunks can satisfy the request. Also,
   // the unallocated bytes cannot satisfy the request. Before giving up, let's
   // try deallocating free regions so that suballocator can combine them with
@@ -454,22 +607,26 @@ int64 BFCAllocator::LargestFreeChunk() {
 
 double BFCAllocator::GetFragmentation() {
   int64 bytes_available = total_region_allocated_bytes_ - stats_.bytes_in_use;
-  DCHECK_GT(bytes_available, 0);
+  DCHECK_GE(bytes_available, 0);
+  if (bytes_available <= 0) {
+    return 0;
+  }
   return static_cast<double>(bytes_available - LargestFreeChunk()) /
          bytes_available;
 }
 
 void BFCAllocator::AddTraceMe(absl::string_view traceme_name, const void* ptr) {
   BFCAllocator::Chunk* chunk = ChunkFromHandle(region_manager_.get_handle(ptr));
-  AddTraceMe(traceme_name, chunk->ptr, chunk->requested_size, chunk->size);
+  AddTraceMe(traceme_name, chunk->ptr, chunk->requested_size, chunk->size,
+             chunk->op_name);
 }
 
 void BFCAllocator::AddTraceMe(absl::string_view traceme_name,
                               const void* chunk_ptr, int64 req_bytes,
-                              int64 alloc_bytes) {
+                              int64 alloc_bytes, const char* op_name) {
   tensorflow::profiler::TraceMe::InstantActivity(
-      [this, traceme_name, chunk_ptr, req_bytes,
-       alloc_bytes]() TF_NO_THREAD_SAFETY_ANALYSIS {
+      [this, traceme_name, chunk_ptr, req_bytes, alloc_bytes,
+       op_name]() TF_NO_THREAD_SAFETY_ANALYSIS {
         int64 bytes_available =
             memory_limit_ - stats_.bytes_reserved - stats_.bytes_in_use;
         const auto& annotation =
@@ -488,7 +645,9 @@ void BFCAllocator::AddTraceMe(absl::string_view traceme_name,
                            {"requested_bytes", req_bytes},
                            {"allocation_bytes", alloc_bytes},
                            {"addr", reinterpret_cast<uint64>(chunk_ptr)},
-                           {"tf_op", annotation.pending_op_name},
+                           {"tf_op", op_name != nullptr
+                                         ? op_name
+                                         : annotation.pending_op_name},
                            {"id", annotation.pending_step_id},
                            {"region_type", annotation.pending_region_type},
                            {"data_type", annotation.pending_data_type},
@@ -543,26 +702,16 @@ void* BFCAllocator::FindChunkPtr(BinNum bin_num, size_t rounded_bytes,
         stats_.largest_alloc_size =
             std::max<std::size_t>(stats_.largest_alloc_size, chunk->size);
 
-#ifdef TENSORFLOW_MEM_DEBUG
         if (ShouldRecordOpName()) {
           const auto& annotation =
               ScopedMemoryDebugAnnotation::CurrentAnnotation();
-          if (annotation.pending_op_name != nullptr) {
-            chunk->op_name = annotation.pending_op_name;
-          } else {
-            LOG(INFO) << "missing pending_op_name for " << Name()
-                      << " reading addr "
-                      << static_cast<const void*>(&annotation.pending_op_name)
-                      << "\n"
-                      << CurrentStackTrace();
-            chunk->op_name = nullptr;
-          }
-          chunk->action_count = ++action_counter_;
+          chunk->op_name = annotation.pending_op_name;
           chunk->step_id = annotation.pending_step_id;
-          int slot = chunk->action_count % MEM_DEBUG_SIZE_HISTORY_SIZE;
-          size_history_[slot] = stats_.bytes_in_use;
+          chunk->alloc_micros = EnvTime::NowMicros();
+          chunk->action_count = ++action_counter_;
+          size_history_[chunk->action_count % kSizeHistorySize] =
+              stats_.bytes_in_use;
         }
-#endif
 
         VLOG(4) << "Returning: " << chunk->ptr;
         if (VLOG_IS_ON(4)) {
@@ -617,6 +766,9 @@ void BFCAllocator::SplitChunk(BFCAllocator::ChunkHandle h, size_t num_bytes) {
 void BFCAllocator::DeallocateRaw(void* ptr) {
   VLOG(1) << "DeallocateRaw " << Name() << " "
           << (ptr ? RequestedSize(ptr) : 0);
+  if (thread_cache_ && ptr != nullptr && DeallocateToThreadCache(ptr)) {
+    return;
+  }
   DeallocateRawInternal(ptr);
   retry_helper_.NotifyDealloc();
 }
@@ -627,7 +779,10 @@ void BFCAllocator::DeallocateRawInternal(void* ptr) {
     return;
   }
   mutex_lock l(lock_);
+  DeallocateRawLocked(ptr);
+}
 
+void BFCAllocator::DeallocateRawLocked(void* ptr) {
   // Find the chunk from the ptr.
   BFCAllocator::ChunkHandle h = region_manager_.get_handle(ptr);
   CHECK(h != kInvalidChunkHandle);
@@ -636,6 +791,7 @@ void BFCAllocator::DeallocateRawInternal(void* ptr) {
   void* chunk_ptr = chunk->ptr;
   int64 req_bytes = chunk->requested_size;
   int64 alloc_bytes = chunk->size;
+  const char* op_name = chunk->op_name;
 
   MarkFree(h);
 
@@ -649,7 +805,8 @@ void BFCAllocator::DeallocateRawInternal(void* ptr) {
 
   // TraceMe needs to be added after MarkFree and InsertFreeChunkIntoBin for
   // correct aggregation stats (bytes_in_use, fragmentation).
-  AddTraceMe("MemoryDeallocation", chunk_ptr, req_bytes, alloc_bytes);
+  AddTraceMe("MemoryDeallocation", chunk_ptr, req_bytes, alloc_bytes,
+             op_name);
 
   if (VLOG_IS_ON(4)) {
     LOG(INFO) << "F: " << RenderOccupancy();
@@ -740,13 +897,10 @@ void BFCAllocator::MarkFree(BFCAllocator::ChunkHandle h) {
   // Updates the stats.
   stats_.bytes_in_use -= c->size;
 
-#ifdef TENSORFLOW_MEM_DEBUG
   if (ShouldRecordOpName()) {
     c->action_count = ++action_counter_;
-    int slot = c->action_count % MEM_DEBUG_SIZE_HISTORY_SIZE;
-    size_history_[slot] = stats_.bytes_in_use;
+    size_history_[c->action_count % kSizeHistorySize] = stats_.bytes_in_use;
   }
-#endif
 }
 
 BFCAllocator::ChunkHandle BFCAllocator::TryToCoalesce(ChunkHandle h,
@@ -1015,12 +1169,12 @@ void BFCAllocator::DumpMemoryLog(size_t num_bytes) {
       string buf = strings::StrCat(
           (c->in_use() ? "InUse" : "Free "), " at ",
           strings::Hex(reinterpret_cast<uint64>(c->ptr)), " of size ", c->size);
-#ifdef TENSORFLOW_MEM_DEBUG
-      if (ShouldRecordOpName()) {
-        strings::StrAppend(&buf, " by op ", c->op_name, " action_count ",
-                           c->action_count, " step ", c->step_id);
+      if (ShouldRecordOpName() && c->in_use()) {
+        strings::StrAppend(&buf, " by op ",
+                           c->op_name ? c->op_name : "UNKNOWN",
+                           " action_count ", c->action_count, " step ",
+                           c->step_id);
       }
-#endif
       strings::StrAppend(&buf, " next ", c->next);
       if (timing_counter_) {
         strings::StrAppend(&buf, " freed_at_count ", c->freed_at_count);
@@ -1110,11 +1264,12 @@ MemoryDump BFCAllocator::RecordMemoryMapInternal() {
       mc->set_size(c->size);
       mc->set_requested_size(c->requested_size);
       mc->set_bin(c->bin_num);
-#ifdef TENSORFLOW_MEM_DEBUG
-      mc->set_op_name(c->op_name ? string(c->op_name) : "UNKNOWN");
-      mc->set_step_id(c->step_id);
+      if (c->in_use()) {
+        mc->set_op_name(c->op_name ? string(c->op_name) : "UNKNOWN");
+        mc->set_step_id(c->step_id);
+        mc->set_alloc_micros(c->alloc_micros);
+      }
       mc->set_action_count(c->action_count);
-#endif
       if (timing_counter_) {
         mc->set_freed_at_count(c->in_use() ? 0 : c->freed_at_count);
       }
@@ -1124,28 +1279,41 @@ MemoryDump BFCAllocator::RecordMemoryMapInternal() {
 
   mas->set_fragmentation_metric(GetFragmentation());
 
-#ifdef TENSORFLOW_MEM_DEBUG
-  // Record the recent size history
-  int history_len = static_cast<int>(std::min(
-      action_counter_, static_cast<long long>(MEM_DEBUG_SIZE_HISTORY_SIZE)));
-  for (int i = action_counter_ - history_len; i < action_counter_; ++i) {
+  // Record the recent size history.
+  const int64 history_len =
+      std::min<int64>(action_counter_, kSizeHistorySize);
+  for (int64 i = action_counter_ - history_len + 1; i <= action_counter_;
+       ++i) {
     SnapShot* ss = md.add_snap_shot();
     ss->set_action_count(i);
-    int slot = i % MEM_DEBUG_SIZE_HISTORY_SIZE;
-    ss->set_size(size_history_[slot]);
+    ss->set_size(size_history_[i % kSizeHistorySize]);
   }
-#endif
 
   return md;
 }
 
 absl::optional<AllocatorStats> BFCAllocator::GetStats() {
   mutex_lock l(lock_);
-  return stats_;
+  AllocatorStats stats = stats_;
+  stats.largest_free_block_bytes = LargestFreeChunk();
+  stats.fragmentation = GetFragmentation();
+  if (thread_cache_) {
+    const int64 hits = num_thread_cache_hits_.load(std::memory_order_relaxed);
+    // Allocations served from a thread cache bypass `stats_`, and buffers held
+    // in a thread cache are not in use from the user's point of view.
+    stats.num_allocs += hits;
+    stats.bytes_in_use -= thread_cache_bytes_.load(std::memory_order_relaxed);
+    stats.num_thread_cache_hits = hits;
+    stats.num_thread_cache_misses =
+        num_thread_cache_misses_.load(std::memory_order_relaxed);
+  }
+  return stats;
 }
 
 void BFCAllocator::ClearStats() {
   mutex_lock l(lock_);
+  num_thread_cache_hits_.store(0, std::memory_order_relaxed);
+  num_thread_cache_misses_.store(0, std::memory_order_relaxed);
   stats_.num_allocs = 0;
   stats_.peak_bytes_in_use = stats_.bytes_in_use;
   stats_.largest_alloc_size = 0;
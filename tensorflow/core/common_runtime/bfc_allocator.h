@@ -17,12 +17,14 @@ limitations under the License.
 #define TENSORFLOW_CORE_COMMON_RUNTIME_BFC_ALLOCATOR_H_
 
 #include <array>
+#include <atomic>
 #include <deque>
 #include <memory>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "tensorflow/core/common_runtime/allocator_retry.h"
 #include "tensorflow/core/common_runtime/shared_counter.h"
@@ -46,12 +48,19 @@ class MemoryDump;
 // coalescing.  One assumption we make is that the process using this
 // allocator owns pretty much all of the memory, and that nearly
 // all requests to allocate memory go through this interface.
+//
+// If `thread_cache` is true, each thread that frees small buffers keeps them
+// in a private cache, and hands them out again to allocations of exactly the
+// same size without acquiring the allocator-wide lock. Cached buffers are
+// returned to the bins in batches when a cache fills up, and all caches are
+// drained before an allocation is allowed to fail. A buffer that is reused
+// from a cache keeps its previous AllocationId().
 class BFCAllocator : public Allocator {
  public:
   // Takes ownership of sub_allocator.
   BFCAllocator(SubAllocator* sub_allocator, size_t total_memory,
                bool allow_growth, const string& name,
-               bool garbage_collection = false);
+               bool garbage_collection = false, bool thread_cache = false);
   ~BFCAllocator() override;
 
   string Name() override { return name_; }
@@ -97,6 +106,55 @@ class BFCAllocator : public Allocator {
       const AllocationAttributes& allocation_attr);
 
   void DeallocateRawInternal(void* ptr);
+  void DeallocateRawLocked(void* ptr) TF_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  // The per-thread cache of freed buffers used when `thread_cache` is set.
+  // Each entry is a buffer that is free from the user's point of view, but
+  // whose chunk is still marked as in use, so that it is never coalesced or
+  // handed out by FindChunkPtr().
+  struct ThreadCache {
+    struct Entry {
+      size_t num_bytes;    // The requested size of the cached buffer.
+      size_t chunk_bytes;  // The size of the chunk backing it.
+      void* ptr;
+    };
+    mutex mu;
+    // Cached buffers, keyed by requested size, oldest first.
+    absl::flat_hash_map<size_t, std::vector<Entry>> free_lists
+        TF_GUARDED_BY(mu);
+    size_t total_bytes TF_GUARDED_BY(mu) = 0;
+  };
+
+  // Requests larger than this are never cached.
+  static constexpr size_t kThreadCacheMaxRequestBytes = 32 << 10;
+  // The maximum number of chunk bytes held by a single ThreadCache. When it is
+  // exceeded, the oldest half of the cache is returned to the bins.
+  static constexpr size_t kThreadCacheMaxTotalBytes = 1 << 20;
+
+  bool UseThreadCache(size_t num_bytes,
+                      const AllocationAttributes& allocation_attr) const {
+    return thread_cache_ && timing_counter_ == nullptr &&
+           allocation_attr.freed_by_func == nullptr && num_bytes > 0 &&
+           num_bytes <= kThreadCacheMaxRequestBytes;
+  }
+
+  // Returns the calling thread's cache, creating it if needed.
+  ThreadCache* GetThreadCache();
+
+  // Tries to satisfy an allocation of `num_bytes` from the calling thread's
+  // cache. Returns nullptr on a miss.
+  void* AllocateFromThreadCache(size_t num_bytes);
+
+  // Attempts to add `ptr` to the calling thread's cache, and returns true on
+  // success. Returns false if `ptr` was not allocated through the cache.
+  bool DeallocateToThreadCache(void* ptr);
+
+  // Returns the cached buffers in `entries` to the bins.
+  void ReleaseThreadCacheEntries(const std::vector<ThreadCache::Entry>& entries)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  // Empties every thread's cache. Returns true if any buffer was released.
+  bool FlushThreadCaches() TF_EXCLUSIVE_LOCKS_REQUIRED(lock_);
 
   // Chunks whose freed_at_count is later than the safe frontier value are kept
   // on a special list and not subject to merging immediately upon being freed.
@@ -125,9 +183,11 @@ class BFCAllocator : public Allocator {
   void AddTraceMe(absl::string_view traceme_name, const void* ptr)
       TF_EXCLUSIVE_LOCKS_REQUIRED(lock_);
 
-  // Overloaded AddTraceMe function with chunk information.
+  // Overloaded AddTraceMe function with chunk information. The event is
+  // attributed to `op_name`, the op that allocated the chunk, or to the op
+  // of the current ScopedMemoryDebugAnnotation if it is null.
   void AddTraceMe(absl::string_view traceme_name, const void* chunk_ptr,
-                  int64 req_bytes, int64 alloc_bytes)
+                  int64 req_bytes, int64 alloc_bytes, const char* op_name)
       TF_EXCLUSIVE_LOCKS_REQUIRED(lock_);
 
   // A ChunkHandle is an index into the chunks_ vector in BFCAllocator
@@ -188,12 +248,14 @@ class BFCAllocator : public Allocator {
 
     bool in_use() const { return allocation_id != -1; }
 
-#ifdef TENSORFLOW_MEM_DEBUG
-    // optional debugging info
+    // The op and step that allocated the chunk, taken from the
+    // ScopedMemoryDebugAnnotation of the allocating thread, and when.
     const char* op_name = nullptr;
     uint64 step_id = 0;
+    uint64 alloc_micros = 0;
+    // The value of action_counter_ after the most recent allocation or
+    // deallocation of this chunk.
     int64 action_count = 0;
-#endif
 
     string DebugString(BFCAllocator* a,
                        bool recurse) TF_NO_THREAD_SAFETY_ANALYSIS {
@@ -210,11 +272,9 @@ class BFCAllocator : public Allocator {
         Chunk* n = a->ChunkFromHandle(next);
         strings::StrAppend(&dbg, ", next: ", n->DebugString(a, false));
       }
-#ifdef TENSORFLOW_MEM_DEBUG
       strings::StrAppend(&dbg, ", for: ", op_name ? op_name : "UNKNOWN",
                          ", stepid: ", step_id,
                          ", last_action: ", action_count);
-#endif
       return dbg;
     }
   };
@@ -454,7 +514,8 @@ class BFCAllocator : public Allocator {
       TF_EXCLUSIVE_LOCKS_REQUIRED(lock_);
 
   // Fragmentation is calculated as the reverse ratio of the largest free chunk
-  // size over total free memory, and returns a value within [0, 1].
+  // size over total free memory, and returns a value within [0, 1]. Returns 0
+  // if there is no free memory.
   double GetFragmentation() TF_EXCLUSIVE_LOCKS_REQUIRED(lock_);
 
   // Information about a Bin that is useful for debugging.
@@ -534,6 +595,35 @@ class BFCAllocator : public Allocator {
 
   std::atomic<uint64> safe_frontier_ = {0};
 
+  // Whether small freed buffers are kept in per-thread caches.
+  const bool thread_cache_;
+  // Process-unique identifier, used to find this allocator's ThreadCache in
+  // thread-local storage. Unlike `this`, it is never reused.
+  const int64 thread_cache_id_;
+
+  // The requested and chunk sizes of every buffer that was allocated through
+  // a thread cache and has not since been returned to the bins, so that
+  // DeallocateRaw() can recognize such buffers without acquiring `lock_`. It
+  // is sharded by address to reduce contention between threads.
+  struct CachedChunkTableShard {
+    mutex mu;
+    absl::flat_hash_map<const void*, ThreadCache::Entry> chunks
+        TF_GUARDED_BY(mu);
+  };
+  static constexpr int kNumCachedChunkTableShards = 16;
+  CachedChunkTableShard cached_chunk_table_[kNumCachedChunkTableShards];
+  CachedChunkTableShard* CachedChunkTableShardFor(const void* ptr) {
+    return &cached_chunk_table_[(reinterpret_cast<std::uintptr_t>(ptr) >>
+                                 kMinAllocationBits) %
+                                kNumCachedChunkTableShards];
+  }
+
+  // Stats for the thread caches. These are updated without holding `lock_`.
+  std::atomic<int64> num_thread_cache_hits_{0};
+  std::atomic<int64> num_thread_cache_misses_{0};
+  // The total size of the chunks held in thread caches.
+  std::atomic<int64> thread_cache_bytes_{0};
+
   // Structures mutable after construction
   mutable mutex lock_;
   RegionManager region_manager_ TF_GUARDED_BY(lock_);
@@ -547,13 +637,18 @@ class BFCAllocator : public Allocator {
   // newly-created chunk.
   int64 next_allocation_id_ TF_GUARDED_BY(lock_);
 
+  // All thread caches created for this allocator.
+  std::vector<std::unique_ptr<ThreadCache>> thread_caches_ TF_GUARDED_BY(lock_);
+
   // Stats.
   AllocatorStats stats_ TF_GUARDED_BY(lock_);
-#ifdef TENSORFLOW_MEM_DEBUG
-  int64 action_counter_ TF_GUARDED_BY(lock_);
-#define MEM_DEBUG_SIZE_HISTORY_SIZE 4096
-  int64 size_history_[MEM_DEBUG_SIZE_HISTORY_SIZE];
-#endif
+
+  // Counts allocations and deallocations. size_history_ is a ring buffer of
+  // bytes_in_use after each of the last kSizeHistorySize of them, indexed by
+  // action count, and is exported in MemoryDump.snap_shot.
+  static constexpr int kSizeHistorySize = 4096;
+  int64 action_counter_ TF_GUARDED_BY(lock_) = 0;
+  int64 size_history_[kSizeHistorySize] TF_GUARDED_BY(lock_);
 
   friend class GPUBFCAllocatorPrivateMethodsTest;
   TF_DISALLOW_COPY_AND_ASSIGN(BFCAllocator);
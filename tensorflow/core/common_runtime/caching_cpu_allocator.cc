@@ -0,0 +1,341 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/caching_cpu_allocator.h"
+
+#include <algorithm>
+#include <functional>
+#include <thread>  // NOLINT
+
+#include "tensorflow/core/framework/allocator_registry.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/lib/core/bits.h"
+#include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mem.h"
+#include "tensorflow/core/profiler/lib/traceme.h"
+#include "tensorflow/core/util/env_var.h"
+
+namespace tensorflow {
+
+constexpr size_t CachingCPUAllocator::kMinCachedBytes;
+constexpr size_t CachingCPUAllocator::kMaxCachedBytes;
+constexpr int CachingCPUAllocator::kNumClasses;
+constexpr int CachingCPUAllocator::kMagazineSize;
+constexpr int CachingCPUAllocator::kNumRegistryShards;
+
+namespace {
+
+constexpr int kMinClassLog2 = 16;  // log2(kMinCachedBytes)
+
+void UpdateMax(std::atomic<int64>* max, int64 value) {
+  int64 current = max->load(std::memory_order_relaxed);
+  while (value > current &&
+         !max->compare_exchange_weak(current, value,
+                                     std::memory_order_relaxed)) {
+  }
+}
+
+// Moves up to `n` buffers from the back of `from` to the back of `to`.
+void MoveBuffers(std::vector<void*>* from, std::vector<void*>* to, size_t n) {
+  n = std::min(n, from->size());
+  to->insert(to->end(), from->end() - n, from->end());
+  from->resize(from->size() - n);
+}
+
+}  // namespace
+
+CachingCPUAllocator::CachingCPUAllocator(size_t max_cache_bytes,
+                                         int num_shards)
+    : max_cache_bytes_(max_cache_bytes) {
+  magazines_.resize(std::max(num_shards, 1));
+  for (auto& magazines : magazines_) {
+    magazines.reset(new FreeLists);
+  }
+}
+
+CachingCPUAllocator::~CachingCPUAllocator() {
+  auto free_all = [](FreeLists* free_lists) {
+    mutex_lock l(free_lists->mu);
+    for (auto& buffers : free_lists->buffers) {
+      for (void* ptr : buffers) port::AlignedFree(ptr);
+      buffers.clear();
+    }
+  };
+  for (auto& magazines : magazines_) free_all(magazines.get());
+  free_all(&depot_);
+}
+
+int CachingCPUAllocator::ClassIndex(size_t num_bytes) {
+  DCHECK_GE(num_bytes, kMinCachedBytes);
+  DCHECK_LE(num_bytes, kMaxCachedBytes);
+  const int log2 = Log2Ceiling64(num_bytes);
+  if (log2 == kMinClassLog2) return 0;
+  const size_t midpoint = size_t{3} << (log2 - 2);
+  return 2 * (log2 - kMinClassLog2) - (num_bytes <= midpoint ? 1 : 0);
+}
+
+size_t CachingCPUAllocator::ClassBytes(int index) {
+  if (index % 2 == 0) return size_t{1} << (kMinClassLog2 + index / 2);
+  return size_t{3} << (kMinClassLog2 + (index - 1) / 2 - 1);
+}
+
+CachingCPUAllocator::FreeLists* CachingCPUAllocator::CurrentMagazines() {
+  int cpu = port::GetCurrentCPU();
+  if (cpu < 0) {
+    static thread_local const int thread_index =
+        std::hash<std::thread::id>()(std::this_thread::get_id()) & 0x7fffffff;
+    cpu = thread_index;
+  }
+  return magazines_[cpu % magazines_.size()].get();
+}
+
+void* CachingCPUAllocator::AllocateRaw(size_t alignment, size_t num_bytes) {
+  if (alignment > kAllocatorAlignment || num_bytes < kMinCachedBytes ||
+      num_bytes > kMaxCachedBytes) {
+    return AllocateUncached(alignment, num_bytes);
+  }
+  const int index = ClassIndex(num_bytes);
+  const size_t class_bytes = ClassBytes(index);
+  void* ptr = nullptr;
+  {
+    FreeLists* magazines = CurrentMagazines();
+    mutex_lock l(magazines->mu);
+    std::vector<void*>& magazine = magazines->buffers[index];
+    if (magazine.empty()) {
+      mutex_lock dl(depot_.mu);
+      MoveBuffers(&depot_.buffers[index], &magazine, kMagazineSize / 2);
+    }
+    if (!magazine.empty()) {
+      ptr = magazine.back();
+      magazine.pop_back();
+    }
+  }
+  if (ptr != nullptr) {
+    cached_bytes_.fetch_sub(class_bytes, std::memory_order_relaxed);
+    num_cache_hits_.fetch_add(1, std::memory_order_relaxed);
+  } else {
+    ptr = port::AlignedMalloc(class_bytes, kAllocatorAlignment);
+    if (ptr == nullptr) return nullptr;
+    num_cache_misses_.fetch_add(1, std::memory_order_relaxed);
+    UpdateMax(&peak_bytes_reserved_,
+              bytes_reserved_.fetch_add(class_bytes) + class_bytes);
+  }
+  {
+    Registry& registry = RegistryFor(ptr);
+    mutex_lock l(registry.mu);
+    registry.classes[ptr] = index;
+  }
+  RecordAllocation(class_bytes, num_bytes);
+  AddTraceMe("MemoryAllocation", ptr, num_bytes, class_bytes);
+  return ptr;
+}
+
+void CachingCPUAllocator::DeallocateRaw(void* ptr) {
+  if (ptr == nullptr) return;
+  const int index = Unregister(ptr);
+  if (index < 0) {
+    DeallocateUncached(ptr);
+    return;
+  }
+  const size_t class_bytes = ClassBytes(index);
+  bytes_in_use_.fetch_sub(class_bytes, std::memory_order_relaxed);
+  AddTraceMe("MemoryDeallocation", ptr, 0, class_bytes);
+  if (cached_bytes_.fetch_add(class_bytes) + class_bytes > max_cache_bytes_) {
+    cached_bytes_.fetch_sub(class_bytes);
+    bytes_reserved_.fetch_sub(class_bytes);
+    port::AlignedFree(ptr);
+    return;
+  }
+  FreeLists* magazines = CurrentMagazines();
+  mutex_lock l(magazines->mu);
+  std::vector<void*>& magazine = magazines->buffers[index];
+  magazine.push_back(ptr);
+  if (magazine.size() > kMagazineSize) {
+    mutex_lock dl(depot_.mu);
+    MoveBuffers(&magazine, &depot_.buffers[index], kMagazineSize / 2);
+  }
+}
+
+size_t CachingCPUAllocator::AllocatedSizeSlow(const void* ptr) const {
+  Registry& registry = RegistryFor(ptr);
+  {
+    mutex_lock l(registry.mu);
+    auto it = registry.classes.find(ptr);
+    if (it != registry.classes.end()) return ClassBytes(it->second);
+  }
+  return port::MallocExtension_GetAllocatedSize(ptr);
+}
+
+absl::optional<AllocatorStats> CachingCPUAllocator::GetStats() {
+  AllocatorStats stats;
+  stats.num_allocs = num_allocs_.load(std::memory_order_relaxed);
+  stats.bytes_in_use = bytes_in_use_.load(std::memory_order_relaxed);
+  stats.peak_bytes_in_use = peak_bytes_in_use_.load(std::memory_order_relaxed);
+  stats.largest_alloc_size =
+      largest_alloc_size_.load(std::memory_order_relaxed);
+  stats.bytes_reserved = bytes_reserved_.load(std::memory_order_relaxed);
+  stats.peak_bytes_reserved =
+      peak_bytes_reserved_.load(std::memory_order_relaxed);
+  stats.num_thread_cache_hits =
+      num_cache_hits_.load(std::memory_order_relaxed);
+  stats.num_thread_cache_misses =
+      num_cache_misses_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+void CachingCPUAllocator::ClearStats() {
+  num_allocs_ = 0;
+  peak_bytes_in_use_ = bytes_in_use_.load();
+  largest_alloc_size_ = 0;
+  peak_bytes_reserved_ = bytes_reserved_.load();
+  num_cache_hits_ = 0;
+  num_cache_misses_ = 0;
+}
+
+int CachingCPUAllocator::Unregister(const void* ptr) {
+  Registry& registry = RegistryFor(ptr);
+  mutex_lock l(registry.mu);
+  auto it = registry.classes.find(ptr);
+  if (it == registry.classes.end()) return -1;
+  const int index = it->second;
+  registry.classes.erase(it);
+  return index;
+}
+
+void* CachingCPUAllocator::AllocateUncached(size_t alignment,
+                                            size_t num_bytes) {
+  void* ptr = port::AlignedMalloc(num_bytes, alignment);
+  if (ptr == nullptr) return nullptr;
+  const bool collect_stats = CPUAllocatorStatsEnabled();
+  if (collect_stats || profiler::TraceMe::Active()) {
+    const int64 allocation_bytes = port::MallocExtension_GetAllocatedSize(ptr);
+    if (collect_stats) RecordAllocation(allocation_bytes, num_bytes);
+    AddTraceMe("MemoryAllocation", ptr, num_bytes, allocation_bytes);
+  }
+  return ptr;
+}
+
+void CachingCPUAllocator::DeallocateUncached(void* ptr) {
+  const bool collect_stats = CPUAllocatorStatsEnabled();
+  if (collect_stats || profiler::TraceMe::Active()) {
+    const int64 allocation_bytes = port::MallocExtension_GetAllocatedSize(ptr);
+    if (collect_stats) {
+      bytes_in_use_.fetch_sub(allocation_bytes, std::memory_order_relaxed);
+    }
+    AddTraceMe("MemoryDeallocation", ptr, 0, allocation_bytes);
+  }
+  port::AlignedFree(ptr);
+}
+
+void CachingCPUAllocator::RecordAllocation(int64 allocated_bytes,
+                                           int64 requested_bytes) {
+  num_allocs_.fetch_add(1, std::memory_order_relaxed);
+  UpdateMax(&peak_bytes_in_use_,
+            bytes_in_use_.fetch_add(allocated_bytes) + allocated_bytes);
+  UpdateMax(&largest_alloc_size_, requested_bytes);
+}
+
+void CachingCPUAllocator::AddTraceMe(absl::string_view traceme_name,
+                                     const void* ptr, int64 requested_bytes,
+                                     int64 allocation_bytes) {
+  profiler::TraceMe::InstantActivity(
+      [this, traceme_name, ptr, requested_bytes, allocation_bytes]() {
+        const auto& annotation =
+            ScopedMemoryDebugAnnotation::CurrentAnnotation();
+        std::string tensor_shape;
+        if (annotation.pending_shape) {
+          tensor_shape = annotation.pending_shape->DebugString();
+        }
+        // The cached buffers are reported as available memory, like the
+        // free chunks of a BFCAllocator.
+        return profiler::TraceMeEncode(
+            traceme_name,
+            {{"allocator_name", Name()},
+             {"bytes_reserved", 0},
+             {"bytes_allocated", bytes_in_use_.load()},
+             {"bytes_available", cached_bytes_.load()},
+             {"fragmentation", 0.0},
+             {"peak_bytes_in_use", peak_bytes_in_use_.load()},
+             {"requested_bytes", requested_bytes},
+             {"allocation_bytes", allocation_bytes},
+             {"addr", reinterpret_cast<uint64>(ptr)},
+             {"tf_op", annotation.pending_op_name},
+             {"id", annotation.pending_step_id},
+             {"region_type", annotation.pending_region_type},
+             {"data_type", annotation.pending_data_type},
+             {"shape", tensor_shape}});
+      },
+      /*level=*/profiler::TraceMeLevel::kInfo);
+}
+
+namespace {
+
+class CachingCPUAllocatorFactory : public AllocatorFactory {
+ public:
+  Allocator* CreateAllocator() override {
+    int64 cache_mb = 0;
+    Status status = ReadInt64FromEnvVar("TF_CPU_ALLOCATOR_CACHE_MB", 256,
+                                        &cache_mb);
+    if (!status.ok()) {
+      LOG(ERROR) << "CachingCPUAllocatorFactory: " << status.error_message();
+    }
+    VLOG(1) << "Using CachingCPUAllocator with a cache of " << cache_mb
+            << " MB";
+    return new CachingCPUAllocator(std::max<int64>(cache_mb, 0) << 20,
+                                   port::NumTotalCPUs());
+  }
+
+  SubAllocator* CreateSubAllocator(int numa_node) override {
+    return new CachingCPUSubAllocator(
+        static_cast<CachingCPUAllocator*>(CreateAllocator()));
+  }
+
+ private:
+  class CachingCPUSubAllocator : public SubAllocator {
+   public:
+    explicit CachingCPUSubAllocator(CachingCPUAllocator* allocator)
+        : SubAllocator({}, {}), allocator_(allocator) {}
+
+    void* Alloc(size_t alignment, size_t num_bytes) override {
+      return allocator_->AllocateRaw(alignment, num_bytes);
+    }
+
+    void Free(void* ptr, size_t num_bytes) override {
+      allocator_->DeallocateRaw(ptr);
+    }
+
+   private:
+    std::unique_ptr<CachingCPUAllocator> allocator_;
+  };
+};
+
+// The factory only outranks the default CPU allocator (priority 100) when
+// TF_CPU_ALLOCATOR_USE_CACHING is set.
+int CachingCPUAllocatorPriority() {
+  bool use_caching = false;
+  Status status =
+      ReadBoolFromEnvVar("TF_CPU_ALLOCATOR_USE_CACHING", false, &use_caching);
+  if (!status.ok()) {
+    LOG(ERROR) << "CachingCPUAllocatorPriority: " << status.error_message();
+  }
+  return use_caching ? 150 : 50;
+}
+
+REGISTER_MEM_ALLOCATOR("CachingCPUAllocator", CachingCPUAllocatorPriority(),
+                       CachingCPUAllocatorFactory);
+
+}  // namespace
+}  // namespace tensorflow
@@ -0,0 +1,136 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_CACHING_CPU_ALLOCATOR_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_CACHING_CPU_ALLOCATOR_H_
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// A CPU allocator that caches freed buffers of medium size, for which malloc
+// and free are comparatively expensive. Requests of [kMinCachedBytes,
+// kMaxCachedBytes] bytes are rounded up to a size class (the powers of two
+// and the midpoints between them), and freed buffers are kept for reuse by
+// requests of the same class. Other requests go straight to
+// port::AlignedMalloc, as in the default CPU allocator.
+//
+// Freed buffers are kept in magazines of up to kMagazineSize buffers per
+// class, one set of magazines per shard, so that threads on different cores
+// rarely contend. A thread uses the shard of the core it runs on. When a
+// magazine overflows, half of it moves to a shared depot, and an empty
+// magazine refills from the depot before falling back to malloc. At most
+// `max_cache_bytes` are kept in free buffers in total.
+//
+// Set TF_CPU_ALLOCATOR_USE_CACHING=true to make this the default CPU
+// allocator, and TF_CPU_ALLOCATOR_CACHE_MB to bound the cache.
+//
+// This class is thread-safe.
+class CachingCPUAllocator : public Allocator {
+ public:
+  static constexpr size_t kMinCachedBytes = 64 << 10;
+  static constexpr size_t kMaxCachedBytes = 4 << 20;
+  static constexpr int kNumClasses = 13;
+  static constexpr int kMagazineSize = 8;
+
+  CachingCPUAllocator(size_t max_cache_bytes, int num_shards);
+  ~CachingCPUAllocator() override;
+
+  string Name() override { return "caching_cpu"; }
+  void* AllocateRaw(size_t alignment, size_t num_bytes) override;
+  void DeallocateRaw(void* ptr) override;
+  size_t AllocatedSizeSlow(const void* ptr) const override;
+
+  // `bytes_reserved` counts the cacheable buffers, whether in use or free.
+  // The sizes of other buffers are only counted when CPU allocator stats
+  // are enabled, like in the default CPU allocator.
+  absl::optional<AllocatorStats> GetStats() override;
+  void ClearStats() override;
+
+  // Returns the index of the size class for a request of `num_bytes`, which
+  // must be in [kMinCachedBytes, kMaxCachedBytes].
+  static int ClassIndex(size_t num_bytes);
+  // Returns the size of the buffers in class `index`.
+  static size_t ClassBytes(int index);
+
+ private:
+  struct FreeLists {
+    mutex mu;
+    std::vector<void*> buffers[kNumClasses] TF_GUARDED_BY(mu);
+  };
+
+  // Maps each cacheable buffer in use to its class. Sharded by address, since
+  // buffers are often freed on a different core than they were allocated on.
+  struct Registry {
+    mutex mu;
+    absl::flat_hash_map<const void*, int> classes TF_GUARDED_BY(mu);
+  };
+  static constexpr int kNumRegistryShards = 16;
+
+  FreeLists* CurrentMagazines();
+  Registry& RegistryFor(const void* ptr) const {
+    return registry_[(reinterpret_cast<uintptr_t>(ptr) >> 16) %
+                     kNumRegistryShards];
+  }
+
+  // Returns the class of `ptr` and forgets it, or -1 if `ptr` is not a
+  // cacheable buffer.
+  int Unregister(const void* ptr);
+
+  void* AllocateUncached(size_t alignment, size_t num_bytes);
+  void DeallocateUncached(void* ptr);
+
+  void RecordAllocation(int64 allocated_bytes, int64 requested_bytes);
+
+  // Adds a MemoryAllocation or MemoryDeallocation TraceMe, in the format of
+  // BFCAllocator's, so that the memory profiler can show a timeline of this
+  // allocator with the ops that allocated each buffer.
+  void AddTraceMe(absl::string_view traceme_name, const void* ptr,
+                  int64 requested_bytes, int64 allocation_bytes);
+
+  const size_t max_cache_bytes_;
+  std::vector<std::unique_ptr<FreeLists>> magazines_;
+  FreeLists depot_;
+  mutable Registry registry_[kNumRegistryShards];
+
+  // The number of bytes in free buffers.
+  std::atomic<int64> cached_bytes_{0};
+
+  std::atomic<int64> num_allocs_{0};
+  std::atomic<int64> bytes_in_use_{0};
+  std::atomic<int64> peak_bytes_in_use_{0};
+  std::atomic<int64> largest_alloc_size_{0};
+  std::atomic<int64> bytes_reserved_{0};
+  std::atomic<int64> peak_bytes_reserved_{0};
+  std::atomic<int64> num_cache_hits_{0};
+  std::atomic<int64> num_cache_misses_{0};
+
+  TF_DISALLOW_COPY_AND_ASSIGN(CachingCPUAllocator);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_CACHING_CPU_ALLOCATOR_H_
@@ -0,0 +1,193 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/caching_cpu_allocator.h"
+
+#include <set>
+#include <vector>
+
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+namespace {
+
+constexpr size_t kAlignment = Allocator::kAllocatorAlignment;
+
+TEST(CachingCPUAllocatorTest, SizeClasses) {
+  EXPECT_EQ(0, CachingCPUAllocator::ClassIndex(64 << 10));
+  EXPECT_EQ(1, CachingCPUAllocator::ClassIndex((64 << 10) + 1));
+  EXPECT_EQ(1, CachingCPUAllocator::ClassIndex(96 << 10));
+  EXPECT_EQ(2, CachingCPUAllocator::ClassIndex((96 << 10) + 1));
+  EXPECT_EQ(2, CachingCPUAllocator::ClassIndex(128 << 10));
+  EXPECT_EQ(CachingCPUAllocator::kNumClasses - 1,
+            CachingCPUAllocator::ClassIndex(4 << 20));
+  for (int i = 0; i < CachingCPUAllocator::kNumClasses; ++i) {
+    const size_t class_bytes = CachingCPUAllocator::ClassBytes(i);
+    EXPECT_EQ(i, CachingCPUAllocator::ClassIndex(class_bytes));
+    if (i > 0) {
+      EXPECT_EQ(i, CachingCPUAllocator::ClassIndex(
+                       CachingCPUAllocator::ClassBytes(i - 1) + 1));
+    }
+  }
+  EXPECT_EQ(CachingCPUAllocator::kMaxCachedBytes,
+            CachingCPUAllocator::ClassBytes(CachingCPUAllocator::kNumClasses -
+                                            1));
+}
+
+TEST(CachingCPUAllocatorTest, ReusesFreedBuffers) {
+  CachingCPUAllocator allocator(16 << 20, 1);
+  void* a = allocator.AllocateRaw(kAlignment, 100 << 10);
+  ASSERT_NE(nullptr, a);
+  EXPECT_EQ(0, reinterpret_cast<uintptr_t>(a) % kAlignment);
+  EXPECT_EQ(128 << 10, allocator.AllocatedSizeSlow(a));
+  allocator.DeallocateRaw(a);
+
+  // A request of the same class gets the same buffer back.
+  void* b = allocator.AllocateRaw(kAlignment, 120 << 10);
+  EXPECT_EQ(a, b);
+  // A request of another class does not.
+  void* c = allocator.AllocateRaw(kAlignment, 200 << 10);
+  EXPECT_NE(a, c);
+  allocator.DeallocateRaw(b);
+  allocator.DeallocateRaw(c);
+
+  absl::optional<AllocatorStats> stats = allocator.GetStats();
+  ASSERT_TRUE(stats);
+  EXPECT_EQ(3, stats->num_allocs);
+  EXPECT_EQ(1, stats->num_thread_cache_hits);
+  EXPECT_EQ(2, stats->num_thread_cache_misses);
+  EXPECT_EQ(0, stats->bytes_in_use);
+  EXPECT_EQ((128 << 10) + (256 << 10), stats->peak_bytes_in_use);
+  EXPECT_EQ((128 << 10) + (256 << 10), stats->bytes_reserved);
+  EXPECT_EQ(200 << 10, stats->largest_alloc_size);
+
+  allocator.ClearStats();
+  stats = allocator.GetStats();
+  EXPECT_EQ(0, stats->num_allocs);
+  EXPECT_EQ(0, stats->num_thread_cache_hits);
+  EXPECT_EQ(0, stats->peak_bytes_in_use);
+  EXPECT_EQ((128 << 10) + (256 << 10), stats->peak_bytes_reserved);
+}
+
+TEST(CachingCPUAllocatorTest, RefillsFromDepot) {
+  CachingCPUAllocator allocator(64 << 20, 1);
+  const int n = 4 * CachingCPUAllocator::kMagazineSize;
+  std::vector<void*> ptrs;
+  for (int i = 0; i < n; ++i) {
+    ptrs.push_back(allocator.AllocateRaw(kAlignment, 64 << 10));
+  }
+  // Freeing more buffers than fit in a magazine spills them to the depot.
+  for (void* ptr : ptrs) allocator.DeallocateRaw(ptr);
+  std::set<void*> reused;
+  for (int i = 0; i < n; ++i) {
+    reused.insert(allocator.AllocateRaw(kAlignment, 64 << 10));
+  }
+  EXPECT_EQ(std::set<void*>(ptrs.begin(), ptrs.end()), reused);
+  EXPECT_EQ(n, allocator.GetStats()->num_thread_cache_hits);
+  for (void* ptr : reused) allocator.DeallocateRaw(ptr);
+}
+
+TEST(CachingCPUAllocatorTest, BoundsCache) {
+  // Only two 1MB buffers fit in the cache.
+  CachingCPUAllocator allocator(2 << 20, 1);
+  std::vector<void*> ptrs;
+  for (int i = 0; i < 4; ++i) {
+    ptrs.push_back(allocator.AllocateRaw(kAlignment, 1 << 20));
+  }
+  EXPECT_EQ(4 << 20, allocator.GetStats()->bytes_reserved);
+  for (void* ptr : ptrs) allocator.DeallocateRaw(ptr);
+  EXPECT_EQ(2 << 20, allocator.GetStats()->bytes_reserved);
+}
+
+TEST(CachingCPUAllocatorTest, DoesNotCacheOtherRequests) {
+  CachingCPUAllocator allocator(16 << 20, 1);
+  const std::vector<std::pair<size_t, size_t>> requests = {
+      {kAlignment, 1024},
+      {kAlignment, (4 << 20) + 1},
+      {4096, 128 << 10},
+  };
+  for (const auto& request : requests) {
+    void* ptr = allocator.AllocateRaw(request.first, request.second);
+    ASSERT_NE(nullptr, ptr);
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(ptr) % request.first);
+    allocator.DeallocateRaw(ptr);
+  }
+  absl::optional<AllocatorStats> stats = allocator.GetStats();
+  EXPECT_EQ(0, stats->num_thread_cache_hits);
+  EXPECT_EQ(0, stats->num_thread_cache_misses);
+  EXPECT_EQ(0, stats->bytes_reserved);
+}
+
+TEST(CachingCPUAllocatorTest, ConcurrentAllocations) {
+  CachingCPUAllocator allocator(64 << 20, 4);
+  {
+    thread::ThreadPool pool(Env::Default(), "caching_cpu_allocator_test", 8);
+    for (int t = 0; t < 8; ++t) {
+      pool.Schedule([&allocator, t]() {
+        std::vector<void*> ptrs;
+        for (int i = 0; i < 200; ++i) {
+          const size_t num_bytes = (64 << 10) * (1 + (i + t) % 8);
+          void* ptr = allocator.AllocateRaw(kAlignment, num_bytes);
+          CHECK(ptr != nullptr);
+          // Touch the first and last bytes to catch handing out the same
+          // buffer twice under a sanitizer.
+          static_cast<char*>(ptr)[0] = t;
+          static_cast<char*>(ptr)[num_bytes - 1] = t;
+          ptrs.push_back(ptr);
+          if (ptrs.size() > 4) {
+            allocator.DeallocateRaw(ptrs.front());
+            ptrs.erase(ptrs.begin());
+          }
+        }
+        for (void* ptr : ptrs) allocator.DeallocateRaw(ptr);
+      });
+    }
+  }
+  absl::optional<AllocatorStats> stats = allocator.GetStats();
+  EXPECT_EQ(8 * 200, stats->num_allocs);
+  EXPECT_EQ(8 * 200,
+            stats->num_thread_cache_hits + stats->num_thread_cache_misses);
+  EXPECT_EQ(0, stats->bytes_in_use);
+  EXPECT_GT(stats->num_thread_cache_hits, 0);
+}
+
+// Allocates and frees `num_bytes` repeatedly, either through the caching
+// allocator or through the default CPU allocator.
+void BM_AllocateAndFree(int iters, int num_bytes, bool caching) {
+  testing::StopTiming();
+  CachingCPUAllocator caching_allocator(64 << 20, 1);
+  Allocator* allocator = caching ? &caching_allocator : cpu_allocator();
+  testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    allocator->DeallocateRaw(allocator->AllocateRaw(kAlignment, num_bytes));
+  }
+  testing::StopTiming();
+}
+
+void BM_AllocateAndFree_Caching(int iters, int num_bytes) {
+  BM_AllocateAndFree(iters, num_bytes, /*caching=*/true);
+}
+void BM_AllocateAndFree_Default(int iters, int num_bytes) {
+  BM_AllocateAndFree(iters, num_bytes, /*caching=*/false);
+}
+
+BENCHMARK(BM_AllocateAndFree_Caching)->Arg(64 << 10)->Arg(1 << 20);
+BENCHMARK(BM_AllocateAndFree_Default)->Arg(64 << 10)->Arg(1 << 20);
+
+}  // namespace
+}  // namespace tensorflow
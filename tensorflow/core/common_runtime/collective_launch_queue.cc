@@ -0,0 +1,89 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/common_runtime/collective_launch_queue.h"
+
+#include <utility>
+
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+
+CollectiveLaunchQueue::CollectiveLaunchQueue(int max_concurrent)
+    : max_concurrent_(max_concurrent) {
+  DCHECK_GT(max_concurrent_, 0);
+}
+
+bool CollectiveLaunchQueue::CanLaunch(const Order& order) const {
+  // Equal orders belong to the same instance on different local devices,
+  // which must run together.
+  return aborted_ || running_.size() < static_cast<size_t>(max_concurrent_) ||
+         order <= *running_.begin();
+}
+
+void CollectiveLaunchQueue::Schedule(int64 priority, int32 instance_key,
+                                     std::function<void()> launch) {
+  const Order order(priority, instance_key);
+  {
+    mutex_lock l(mu_);
+    if (!CanLaunch(order)) {
+      VLOG(2) << "Queueing collective instance " << instance_key
+              << " with priority " << priority << " behind "
+              << running_.size() << " running";
+      pending_.push({order, std::move(launch)});
+      return;
+    }
+    running_.insert(order);
+  }
+  launch();
+}
+
+void CollectiveLaunchQueue::PopAdmitted(
+    std::vector<std::function<void()>>* launches) {
+  // Admission is monotonic in the priority, so the queue can stop at the
+  // first collective that is not admitted.
+  while (!pending_.empty() && CanLaunch(pending_.top().order)) {
+    running_.insert(pending_.top().order);
+    launches->push_back(pending_.top().launch);
+    pending_.pop();
+  }
+}
+
+void CollectiveLaunchQueue::Finished(int64 priority, int32 instance_key) {
+  std::vector<std::function<void()>> launches;
+  {
+    mutex_lock l(mu_);
+    auto it = running_.find(Order(priority, instance_key));
+    DCHECK(it != running_.end());
+    if (it != running_.end()) running_.erase(it);
+    PopAdmitted(&launches);
+  }
+  for (auto& launch : launches) {
+    launch();
+  }
+}
+
+void CollectiveLaunchQueue::StartAbort() {
+  std::vector<std::function<void()>> launches;
+  {
+    mutex_lock l(mu_);
+    aborted_ = true;
+    PopAdmitted(&launches);
+  }
+  for (auto& launch : launches) {
+    launch();
+  }
+}
+
+}  // namespace tensorflow
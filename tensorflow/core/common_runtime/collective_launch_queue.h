@@ -0,0 +1,85 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_COLLECTIVE_LAUNCH_QUEUE_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_COLLECTIVE_LAUNCH_QUEUE_H_
+
+#include <functional>
+#include <queue>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// Orders the launch of prioritized collectives of one step.
+//
+// Collectives are ordered by priority and then by instance key.  At most
+// `max_concurrent` scheduled collectives run at a time, and queued ones are
+// launched in that order, so a collective with a smaller priority value
+// overtakes larger ones that became ready before it.  A collective that
+// orders no later than every running one is always launched immediately,
+// even if the limit is reached.  This keeps the queue deadlock-free across
+// workers provided every worker assigns the same priority to an instance and
+// no scheduled collective depends on the output of a later one.
+class CollectiveLaunchQueue {
+ public:
+  explicit CollectiveLaunchQueue(int max_concurrent);
+
+  // Calls `launch`, either inline or from a later call to Finished() once the
+  // collective is admitted.  Finished() must be called with the same
+  // arguments when the launched collective completes.
+  void Schedule(int64 priority, int32 instance_key,
+                std::function<void()> launch);
+
+  // Records the completion of a running collective and launches the queued
+  // ones that are now admitted.
+  void Finished(int64 priority, int32 instance_key);
+
+  // Launches every queued collective regardless of the limit, so that they
+  // observe the abort instead of waiting forever.
+  void StartAbort();
+
+ private:
+  // (priority, instance_key)
+  typedef std::pair<int64, int32> Order;
+  struct Pending {
+    Order order;
+    std::function<void()> launch;
+  };
+  struct PendingAfter {
+    bool operator()(const Pending& a, const Pending& b) const {
+      return a.order > b.order;
+    }
+  };
+
+  bool CanLaunch(const Order& order) const TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  // Moves the queued collectives that are admitted to `launches`.
+  void PopAdmitted(std::vector<std::function<void()>>* launches)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  const int max_concurrent_;
+  mutex mu_;
+  bool aborted_ TF_GUARDED_BY(mu_) = false;
+  std::multiset<Order> running_ TF_GUARDED_BY(mu_);
+  std::priority_queue<Pending, std::vector<Pending>, PendingAfter> pending_
+      TF_GUARDED_BY(mu_);
+};
+
+}  // namespace tensorflow
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_COLLECTIVE_LAUNCH_QUEUE_H_
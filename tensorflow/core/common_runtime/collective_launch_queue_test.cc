@@ -0,0 +1,102 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/common_runtime/collective_launch_queue.h"
+
+#include <vector>
+
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+class CollectiveLaunchQueueTest : public ::testing::Test {
+ protected:
+  // Schedules instance `instance_key` and records its launch.
+  void Schedule(CollectiveLaunchQueue* queue, int64 priority,
+                int32 instance_key) {
+    queue->Schedule(priority, instance_key, [this, instance_key] {
+      launched_.push_back(instance_key);
+    });
+  }
+
+  std::vector<int32> launched_;
+};
+
+TEST_F(CollectiveLaunchQueueTest, LaunchesImmediatelyBelowLimit) {
+  CollectiveLaunchQueue queue(2);
+  Schedule(&queue, 5, 1);
+  Schedule(&queue, 7, 2);
+  EXPECT_EQ(launched_, std::vector<int32>({1, 2}));
+}
+
+TEST_F(CollectiveLaunchQueueTest, LaunchesQueuedInPriorityOrder) {
+  CollectiveLaunchQueue queue(1);
+  Schedule(&queue, 1, 10);
+  Schedule(&queue, 9, 11);
+  Schedule(&queue, 4, 12);
+  Schedule(&queue, 6, 13);
+  EXPECT_EQ(launched_, std::vector<int32>({10}));
+  queue.Finished(1, 10);
+  EXPECT_EQ(launched_, std::vector<int32>({10, 12}));
+  queue.Finished(4, 12);
+  queue.Finished(6, 13);
+  EXPECT_EQ(launched_, std::vector<int32>({10, 12, 13, 11}));
+}
+
+TEST_F(CollectiveLaunchQueueTest, InstanceKeyBreaksTies) {
+  CollectiveLaunchQueue queue(1);
+  Schedule(&queue, 3, 22);
+  Schedule(&queue, 3, 21);
+  EXPECT_EQ(launched_, std::vector<int32>({22, 21}));
+  Schedule(&queue, 3, 23);
+  queue.Finished(3, 21);
+  EXPECT_EQ(launched_, std::vector<int32>({22, 21}));
+  queue.Finished(3, 22);
+  EXPECT_EQ(launched_, std::vector<int32>({22, 21, 23}));
+}
+
+TEST_F(CollectiveLaunchQueueTest, EarlierCollectiveBypassesLimit) {
+  CollectiveLaunchQueue queue(1);
+  Schedule(&queue, 8, 1);
+  Schedule(&queue, 9, 2);
+  Schedule(&queue, 2, 3);
+  EXPECT_EQ(launched_, std::vector<int32>({1, 3}));
+  // Neither completion admits instance 2 while an earlier one is running.
+  queue.Finished(2, 3);
+  EXPECT_EQ(launched_, std::vector<int32>({1, 3}));
+  queue.Finished(8, 1);
+  EXPECT_EQ(launched_, std::vector<int32>({1, 3, 2}));
+}
+
+TEST_F(CollectiveLaunchQueueTest, SameInstanceOnAllDevicesLaunches) {
+  CollectiveLaunchQueue queue(1);
+  Schedule(&queue, 4, 7);
+  Schedule(&queue, 4, 7);
+  EXPECT_EQ(launched_, std::vector<int32>({7, 7}));
+}
+
+TEST_F(CollectiveLaunchQueueTest, AbortLaunchesQueued) {
+  CollectiveLaunchQueue queue(1);
+  Schedule(&queue, 1, 1);
+  Schedule(&queue, 3, 3);
+  Schedule(&queue, 2, 2);
+  queue.StartAbort();
+  EXPECT_EQ(launched_, std::vector<int32>({1, 2, 3}));
+  Schedule(&queue, 4, 4);
+  EXPECT_EQ(launched_, std::vector<int32>({1, 2, 3, 4}));
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -17,6 +17,9 @@ limitations under the License.
 #include <stddef.h>
 
 #include <algorithm>
+#include <functional>
+#include <limits>
+#include <set>
 #include <unordered_map>
 #include <utility>
 
@@ -279,6 +282,133 @@ bool ParseRingOrder(const string& gpu_ring_order_str, TaskDeviceMap* tdm) {
   return true;
 }
 
+// Rings of at most this many devices are ordered by exhaustive search over
+// device subsets, which costs O(2^n * n^2) per distinct link strength.
+constexpr int kMaxExactRingSize = 12;
+
+// Symmetric matrix of link strengths between devices, indexed by position in
+// a device list.  0 means there is no direct link.
+typedef std::vector<std::vector<int32>> LinkStrengths;
+
+// Quality of a ring: the strength of its weakest link, which bounds the
+// bandwidth of every ring step, then the total strength of its links.
+typedef std::pair<int32, int64> RingScore;
+
+RingScore ScoreRing(const LinkStrengths& strengths,
+                    const std::vector<int>& ring) {
+  RingScore score(std::numeric_limits<int32>::max(), 0);
+  const int n = ring.size();
+  for (int i = 0; i < n; ++i) {
+    const int32 s = strengths[ring[i]][ring[(i + 1) % n]];
+    score.first = std::min(score.first, s);
+    score.second += s;
+  }
+  return score;
+}
+
+// Finds the ring through all devices of `strengths` with maximal RingScore,
+// closing edge included, starting at device 0.  For each candidate bottleneck,
+// strongest first, a Held-Karp search finds the heaviest Hamiltonian cycle
+// using only links at least that strong; the first one that exists wins.
+std::vector<int> FindBestRing(const LinkStrengths& strengths) {
+  const int n = strengths.size();
+  std::set<int32, std::greater<int32>> thresholds;
+  for (int i = 0; i < n; ++i) {
+    for (int j = 0; j < n; ++j) {
+      if (i != j) thresholds.insert(strengths[i][j]);
+    }
+  }
+  const int num_masks = 1 << n;
+  const int full_mask = num_masks - 1;
+  // best[mask * n + j]: heaviest path from device 0 through `mask` ending at
+  // j, or -1 if there is none.
+  std::vector<int64> best(num_masks * n);
+  std::vector<int8> parent(num_masks * n);
+  for (int32 threshold : thresholds) {
+    std::fill(best.begin(), best.end(), -1);
+    best[1 * n + 0] = 0;
+    for (int mask = 1; mask < num_masks; mask += 2) {
+      for (int j = 0; j < n; ++j) {
+        const int64 cur = best[mask * n + j];
+        if (cur < 0) continue;
+        for (int k = 1; k < n; ++k) {
+          if ((mask & (1 << k)) || strengths[j][k] < threshold) continue;
+          const int next = (mask | (1 << k)) * n + k;
+          if (cur + strengths[j][k] > best[next]) {
+            best[next] = cur + strengths[j][k];
+            parent[next] = j;
+          }
+        }
+      }
+    }
+    int last = -1;
+    int64 best_total = -1;
+    for (int j = 1; j < n; ++j) {
+      const int64 cur = best[full_mask * n + j];
+      if (cur < 0 || strengths[j][0] < threshold) continue;
+      if (cur + strengths[j][0] > best_total) {
+        best_total = cur + strengths[j][0];
+        last = j;
+      }
+    }
+    if (last < 0) continue;
+    std::vector<int> ring(n);
+    int mask = full_mask;
+    for (int pos = n - 1; pos > 0; --pos) {
+      ring[pos] = last;
+      const int prev = parent[mask * n + last];
+      mask &= ~(1 << last);
+      last = prev;
+    }
+    ring[0] = 0;
+    return ring;
+  }
+  // Unreachable: with a threshold of 0 every cycle qualifies.
+  std::vector<int> ring(n);
+  for (int i = 0; i < n; ++i) ring[i] = i;
+  return ring;
+}
+
+// Replaces the local ranks of `tdm`, a set of GPUs on one task, with the
+// best ring found by FindBestRing if it scores higher than the current order.
+void ImproveRingOrder(TaskDeviceMap* tdm) {
+  const int n = tdm->size();
+  if (n <= 3 || n > kMaxExactRingSize) return;
+  // Devices in local rank order, so the current ring is 0, 1, ..., n - 1.
+  std::vector<DevRec*> devs(n);
+  gtl::FlatMap<int32, int> index_by_id;
+  for (auto& it : *tdm) {
+    devs[it.second.local_rank] = &it.second;
+  }
+  for (int i = 0; i < n; ++i) {
+    DeviceNameUtils::ParsedName parsed_name;
+    if (!DeviceNameUtils::ParseFullName(devs[i]->device, &parsed_name)) return;
+    index_by_id[parsed_name.id] = i;
+  }
+  LinkStrengths strengths(n, std::vector<int32>(n, 0));
+  for (int i = 0; i < n; ++i) {
+    for (const InterconnectLink& il : devs[i]->locality->links().link()) {
+      auto id_it = index_by_id.find(il.device_id());
+      if (id_it == index_by_id.end() || id_it->second == i) continue;
+      // Links may be listed on one endpoint only, so treat them as
+      // symmetric.
+      const int j = id_it->second;
+      const int32 s = std::max<int32>(il.strength(), 0);
+      strengths[i][j] = std::max(strengths[i][j], s);
+      strengths[j][i] = std::max(strengths[j][i], s);
+    }
+  }
+  std::vector<int> current(n);
+  for (int i = 0; i < n; ++i) current[i] = i;
+  std::vector<int> ring = FindBestRing(strengths);
+  if (ScoreRing(strengths, ring) <= ScoreRing(strengths, current)) return;
+  for (int pos = 0; pos < n; ++pos) {
+    devs[ring[pos]]->local_rank = pos;
+  }
+  VLOG(2) << "Improved link-based ring order to bottleneck strength "
+          << ScoreRing(strengths, ring).first;
+}
+
 void OrderTaskDeviceMap(const string& gpu_ring_order, TaskDeviceMap* tdm) {
   CHECK_GT(tdm->size(), 0);  // Should never be called with 0 devices
 
@@ -286,8 +416,9 @@ void OrderTaskDeviceMap(const string& gpu_ring_order, TaskDeviceMap* tdm) {
   if (ParseRingOrder(gpu_ring_order, tdm)) return;
 
   // Either no ring order was passed in, or the format was unexpected.
-  // We now assign a ring order based on link strengths.  Note that this
-  // algorithm is not optimal and may not always find the best ring order.
+  // We now assign a ring order based on link strengths: a greedy walk along
+  // the strongest links, which small groups then replace with the optimal
+  // ring if that is strictly better.
   int least_rank = -1;
   string next_device;
   std::set<string> selected;
@@ -358,6 +489,7 @@ void OrderTaskDeviceMap(const string& gpu_ring_order, TaskDeviceMap* tdm) {
       CHECK_GE(least_rank, 0);
     }
   }
+  if (parsed_name.type == "GPU") ImproveRingOrder(tdm);
 }
 
 // The first time a shared CollectiveParams is established for a
@@ -722,6 +854,17 @@ void CollectiveParamResolverLocal::AssignCollectiveType(CollectiveParams* cp) {
       CollectiveRegistry::LookupParamResolverInstance("NcclReduce", &col_impl)
           .ok();
   cp->instance.impl_details.collective_name = GetCollectiveName(cp, use_nccl);
+  // The hierarchical all-reduce only pays off, and is only supported, for
+  // groups that span several tasks with the same number of devices each.
+  if (!use_nccl && cp->instance.type == REDUCTION_COLLECTIVE &&
+      cp->instance.impl_details.communication_hint == "hierarchical" &&
+      cp->group.num_tasks > 1 && cp->instance.same_num_devices_per_task &&
+      cp->group.group_size > cp->group.num_tasks &&
+      CollectiveRegistry::LookupParamResolverInstance("HierarchicalRingReduce",
+                                                      &col_impl)
+          .ok()) {
+    cp->instance.impl_details.collective_name = "HierarchicalRingReduce";
+  }
   VLOG(1) << "AssignCollectiveType "
           << cp->instance.impl_details.collective_name;
 }
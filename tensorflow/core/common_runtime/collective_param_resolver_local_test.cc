@@ -168,6 +168,45 @@ TEST_F(CollectiveParamResolverLocalTest, CompleteDefaultRanking) {
                             });
 }
 
+TEST_F(CollectiveParamResolverLocalTest, CompleteDefaultRankingOptimalRing) {
+  constexpr int kNumGpus = 4;
+  CollectiveParams cp;
+  std::vector<DeviceAttributes> attributes(kNumGpus);
+  cp.name = "PRLTest";
+  cp.group.device_type = DeviceType("GPU");
+  cp.group.num_tasks = 1;
+  cp.group.group_size = kNumGpus;
+  cp.instance.instance_key = 5;
+  cp.instance.type = REDUCTION_COLLECTIVE;
+  cp.instance.data_type = DataType(DT_FLOAT);
+  for (int gpu_idx = 0; gpu_idx < kNumGpus; ++gpu_idx) {
+    cp.instance.task_names.push_back("/job:localhost/replica:0/task:0");
+    cp.instance.device_names.push_back(strings::StrCat(
+        "/job:localhost/replica:0/task:0/device:GPU:", gpu_idx));
+  }
+  // Following the strongest links from 0 gives 0,1,2,3, but 3 and 0 are not
+  // linked.  Each link is listed on its lower-numbered endpoint only.
+  auto add_link = [&attributes](int from, int to, int strength) {
+    InterconnectLink* ilink =
+        attributes[from].mutable_locality()->mutable_links()->add_link();
+    ilink->set_device_id(to);
+    ilink->set_strength(strength);
+  };
+  add_link(0, 1, 3);
+  add_link(1, 2, 3);
+  add_link(0, 2, 2);
+  add_link(1, 3, 2);
+  add_link(2, 3, 2);
+  // The only rings without an unlinked hop are 0,1,3,2 and its reverse.
+  RunCompleteDefaultRanking(cp, attributes, {},
+                            {
+                                "/job:localhost/replica:0/task:0/device:GPU:0",
+                                "/job:localhost/replica:0/task:0/device:GPU:2",
+                                "/job:localhost/replica:0/task:0/device:GPU:3",
+                                "/job:localhost/replica:0/task:0/device:GPU:1",
+                            });
+}
+
 TEST_F(CollectiveParamResolverLocalTest, CompleteParamsReduction1Task) {
   CollectiveParams cps[NUM_DEVS];
   Status statuses[NUM_DEVS];
@@ -94,6 +94,22 @@ SubContext::SubContext(OpKernelContext* ctx, OpKernelContext::Params* params,
   sub_ctx_.reset(new OpKernelContext(&sub_params_, 1));
 }
 
+SubContext::SubContext(OpKernelContext* ctx, OpKernelContext::Params* params,
+                       OpKernel* op, Tensor* input)
+    : sub_params_(*params),
+      sub_inputs_({TensorValue(input)}),
+      sub_input_attr_({ctx->input_alloc_attr(0)}) {
+  sub_params_.op_kernel = op;
+  sub_params_.inputs = &sub_inputs_;
+  sub_params_.input_alloc_attrs = &sub_input_attr_;
+  sub_params_.op_device_context = ctx->op_device_context();
+  sub_params_.eigen_gpu_device = nullptr;
+  sub_params_.ensure_eigen_gpu_device();
+  // The output has a different type or shape, so must not be forwarded.
+  sub_params_.forward_from_array = nullptr;
+  sub_ctx_.reset(new OpKernelContext(&sub_params_, 1));
+}
+
 Status ComputeBinOp(OpKernelContext* op_ctx, OpKernelContext::Params* params,
                     Device* device, OpKernel* op, Tensor* output,
                     Tensor* input) {
@@ -108,5 +124,16 @@ Status ComputeBinOp(OpKernelContext* op_ctx, OpKernelContext::Params* params,
   return sub_ctx->sub_ctx_->status();
 }
 
+Status ComputeUnaryOp(OpKernelContext* op_ctx, OpKernelContext::Params* params,
+                      Device* device, OpKernel* op, Tensor* input,
+                      Tensor* output) {
+  std::unique_ptr<SubContext> sub_ctx(
+      new SubContext(op_ctx, params, op, input));
+  device->Compute(op, sub_ctx->sub_ctx_.get());
+  TF_RETURN_IF_ERROR(sub_ctx->sub_ctx_->status());
+  *output = *sub_ctx->sub_ctx_->mutable_output(0);
+  return Status::OK();
+}
+
 }  // namespace collective_util
 }  // namespace tensorflow
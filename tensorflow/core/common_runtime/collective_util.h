@@ -46,6 +46,9 @@ class SubContext {
   std::unique_ptr<OpKernelContext> sub_ctx_;
   SubContext(OpKernelContext* ctx, OpKernelContext::Params* params,
              OpKernel* op, Tensor* output, Tensor* input);
+  // Context for a unary op reading `input` into a newly allocated output.
+  SubContext(OpKernelContext* ctx, OpKernelContext::Params* params,
+             OpKernel* op, Tensor* input);
   ~SubContext() = default;
 };
 
@@ -53,6 +56,12 @@ Status ComputeBinOp(OpKernelContext* op_ctx, OpKernelContext::Params* params,
                     Device* device, OpKernel* op, Tensor* output,
                     Tensor* input);
 
+// Runs the unary `op`, e.g. a Cast, on `input` and sets `*output` to its
+// result.
+Status ComputeUnaryOp(OpKernelContext* op_ctx, OpKernelContext::Params* params,
+                      Device* device, OpKernel* op, Tensor* input,
+                      Tensor* output);
+
 }  // namespace collective_util
 }  // namespace tensorflow
 
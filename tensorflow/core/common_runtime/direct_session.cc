@@ -38,6 +38,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/process_util.h"
 #include "tensorflow/core/common_runtime/rendezvous_mgr.h"
 #include "tensorflow/core/common_runtime/scoped_allocator_mgr.h"
+#include "tensorflow/core/common_runtime/step_arena_allocator.h"
 #include "tensorflow/core/common_runtime/step_stats_collector.h"
 #include "tensorflow/core/framework/function.h"
 #include "tensorflow/core/framework/graph.pb.h"
@@ -69,10 +70,12 @@ limitations under the License.
 #include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/numa.h"
 #include "tensorflow/core/platform/tracing.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/profiler/lib/connected_traceme.h"
 #include "tensorflow/core/profiler/lib/profiler_session.h"
+#include "tensorflow/core/profiler/lib/sampling_profiler.h"
 #include "tensorflow/core/profiler/lib/traceme_encode.h"
 #include "tensorflow/core/protobuf/config.pb.h"
 #include "tensorflow/core/util/device_name_utils.h"
@@ -140,6 +143,38 @@ thread::ThreadPool* GlobalThreadPool(const SessionOptions& options) {
   return thread_pool;
 }
 
+// Creates one inter-op thread pool per NUMA node, whose threads have affinity
+// to that node. The inter-op threads requested by `options` are divided evenly
+// among the nodes.
+std::vector<thread::ThreadPool*> NewNumaThreadPoolsFromSessionOptions(
+    const SessionOptions& options) {
+  const int num_numa_nodes = port::NUMANumNodes();
+  const int32 num_threads = std::max(
+      1, NumInterOpThreadsFromSessionOptions(options) / num_numa_nodes);
+  std::vector<thread::ThreadPool*> pools;
+  pools.reserve(num_numa_nodes);
+  for (int numa_node = 0; numa_node < num_numa_nodes; ++numa_node) {
+    VLOG(1) << "Direct session inter op parallelism threads for NUMA node "
+            << numa_node << ": " << num_threads;
+    ThreadOptions thread_opts;
+    thread_opts.numa_node = numa_node;
+    pools.push_back(new thread::ThreadPool(
+        options.env, thread_opts,
+        strings::StrCat("numa_", numa_node, "_Compute"), num_threads,
+        !options.config.experimental().disable_thread_spinning(),
+        /*allocator=*/nullptr));
+  }
+  return pools;
+}
+
+const std::vector<thread::ThreadPool*>& GlobalNumaThreadPools(
+    const SessionOptions& options) {
+  static const std::vector<thread::ThreadPool*>* const pools =
+      new std::vector<thread::ThreadPool*>(
+          NewNumaThreadPoolsFromSessionOptions(options));
+  return *pools;
+}
+
 // TODO(vrv): Figure out how to unify the many different functions
 // that generate RendezvousKey, since many of them have to be
 // consistent with each other.
@@ -338,6 +373,16 @@ DirectSession::DirectSession(const SessionOptions& options,
       run_in_caller_thread_ = true;
     }
   }
+  // Explicitly configured session pools take precedence over NUMA pools.
+  if (options_.config.experimental().use_numa_affinity() &&
+      thread_pool_size == 0 && port::NUMANumNodes() > 1) {
+    if (options_.config.use_per_session_threads()) {
+      numa_thread_pools_ = NewNumaThreadPoolsFromSessionOptions(options_);
+      owns_numa_thread_pools_ = true;
+    } else {
+      numa_thread_pools_ = GlobalNumaThreadPools(options_);
+    }
+  }
   // The default value of sync_on_finish will be flipped soon and this
   // environment variable will be removed as well.
   const Status status =
@@ -391,6 +436,9 @@ DirectSession::~DirectSession() {
   for (const auto& p_and_owned : thread_pools_) {
     if (p_and_owned.second) delete p_and_owned.first;
   }
+  if (owns_numa_thread_pools_) {
+    for (thread::ThreadPool* pool : numa_thread_pools_) delete pool;
+  }
 
   execution_state_.reset(nullptr);
   flib_def_.reset(nullptr);
@@ -501,6 +549,8 @@ Status DirectSession::RunInternal(
   RunState run_state(step_id, &devices_);
   const size_t num_executors = executors_and_keys->items.size();
 
+  // Traces one in every N steps when the sampling profiler is enabled.
+  profiler::SamplingProfiler::ScopedStep sampled_step;
   profiler::TraceMeProducer activity(
       // To TraceMeConsumers in ExecutorState::Process/Finish.
       [&] {
@@ -688,18 +738,37 @@ Status DirectSession::RunInternal(
 
   Status run_status;
 
+  // Executors that would run on the default session pool run on the pool of
+  // their device's NUMA node instead, if there is one.
+  const bool use_numa_thread_pools =
+      !numa_thread_pools_.empty() && pool != nullptr &&
+      pool == thread_pools_[0].first && handler == nullptr;
+
   auto set_threadpool_args_for_item =
-      [&default_runner, &handler](const PerPartitionExecutorsAndLib& item,
-                                  Executor::Args* args) {
+      [this, &default_runner, &handler, use_numa_thread_pools](
+          const PerPartitionExecutorsAndLib& item, Executor::Args* args) {
         // TODO(azaks): support partial run.
         // TODO(azaks): if the device picks its own threadpool, we need to
         // assign
         //     less threads to the main compute pool by default.
         thread::ThreadPool* device_thread_pool =
             item.device->tensorflow_device_thread_pool();
+        thread::ThreadPool* numa_thread_pool = nullptr;
+        if (use_numa_thread_pools) {
+          const int numa_node =
+              item.device->attributes().locality().numa_node();
+          if (numa_node >= 0 &&
+              numa_node < static_cast<int>(numa_thread_pools_.size())) {
+            numa_thread_pool = numa_thread_pools_[numa_node];
+          }
+        }
         // TODO(crk): Investigate usage of RunHandlerPool when using device
         // specific thread pool(s).
-        if (!device_thread_pool) {
+        if (!device_thread_pool && numa_thread_pool) {
+          args->runner = [numa_thread_pool](Executor::Args::Closure c) {
+            numa_thread_pool->Schedule(std::move(c));
+          };
+        } else if (!device_thread_pool) {
           args->runner = default_runner;
         } else {
           args->runner = [device_thread_pool](Executor::Args::Closure c) {
@@ -712,12 +781,19 @@ Status DirectSession::RunInternal(
         }
       };
 
+  for (const auto& item : executors_and_keys->items) {
+    if (item.step_planning_allocator) {
+      item.step_planning_allocator->BeginStep(step_id);
+    }
+  }
+
   if (can_execute_synchronously) {
     PrivateIntraProcessRendezvous rendezvous(device_mgr_.get());
     args.rendezvous = &rendezvous;
 
     const auto& item = executors_and_keys->items[0];
     set_threadpool_args_for_item(item, &args);
+    args.step_temp_allocator = item.step_temp_allocator.get();
     run_status = item.executor->Run(args);
   } else {
     core::RefCountPtr<RefCountedIntraProcessRendezvous> rendezvous(
@@ -738,6 +814,7 @@ Status DirectSession::RunInternal(
 
     for (const auto& item : executors_and_keys->items) {
       set_threadpool_args_for_item(item, &args);
+      args.step_temp_allocator = item.step_temp_allocator.get();
       item.executor->RunAsync(args, barrier->Get());
     }
 
@@ -749,6 +826,13 @@ Status DirectSession::RunInternal(
     }
   }
 
+  for (const auto& item : executors_and_keys->items) {
+    if (item.step_temp_allocator) item.step_temp_allocator->Reset();
+    if (item.step_planning_allocator) {
+      item.step_planning_allocator->EndStep(step_id);
+    }
+  }
+
   if (step_cancellation_manager.IsCancelled()) {
     run_status.Update(errors::Cancelled("Run call was cancelled"));
   }
@@ -1414,6 +1498,18 @@ Status DirectSession::CreateExecutors(
 
     item->executor = nullptr;
     item->device = device;
+    if (options_.config.experimental().use_step_arena_allocator() &&
+        device->device_type() == DEVICE_CPU) {
+      item->step_temp_allocator.reset(
+          new StepArenaAllocator(device->GetAllocator(AllocatorAttributes())));
+    }
+    if (options_.config.gpu_options()
+            .experimental()
+            .plan_memory_from_previous_steps() &&
+        device->device_type() == DEVICE_GPU) {
+      item->step_planning_allocator =
+          device->GetAllocator(AllocatorAttributes());
+    }
     auto executor_type = options_.config.experimental().executor_type();
     TF_RETURN_IF_ERROR(
         NewExecutor(executor_type, params, *partition_graph, &item->executor));
@@ -32,6 +32,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/process_function_library_runtime.h"
 #include "tensorflow/core/common_runtime/rendezvous_mgr.h"
 #include "tensorflow/core/common_runtime/session_factory.h"
+#include "tensorflow/core/common_runtime/step_arena_allocator.h"
 #include "tensorflow/core/framework/cancellation.h"
 #include "tensorflow/core/framework/collective.h"
 #include "tensorflow/core/framework/graph.pb.h"
@@ -148,6 +149,13 @@ class DirectSession : public Session {
     Device* device = nullptr;                // not owned.
     FunctionLibraryRuntime* flib = nullptr;  // not owned.
     std::unique_ptr<Executor> executor;
+    // Non-null iff ConfigProto.Experimental.use_step_arena_allocator is set
+    // and `device` is a CPU device.
+    core::RefCountPtr<StepArenaAllocator> step_temp_allocator;
+    // Non-null iff GPUOptions.Experimental.plan_memory_from_previous_steps
+    // is set and `device` is a GPU device. The allocator of `device`, which
+    // is told when each step begins and ends.
+    Allocator* step_planning_allocator = nullptr;
   };
 
   // An ExecutorsAndKeys is created for a given set of feeds/fetches.
@@ -350,6 +358,12 @@ class DirectSession : public Session {
   // is owned.
   std::vector<std::pair<thread::ThreadPool*, bool>> thread_pools_;
 
+  // If `use_numa_affinity` is set and the system has more than one NUMA
+  // node, the i-th pool runs the inter-op closures of executors whose device
+  // is local to NUMA node i, in place of `thread_pools_[0]`.
+  std::vector<thread::ThreadPool*> numa_thread_pools_;
+  bool owns_numa_thread_pools_ = false;
+
   Status init_error_;  // Set to an error if construction failed.
 
   // If true, blocks until device has finished all queued operations in a step.
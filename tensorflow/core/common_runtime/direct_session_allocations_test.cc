@@ -0,0 +1,170 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Benchmarks that report the number of heap allocations performed by each
+// `DirectSession::RunCallable()` step. This file replaces the global
+// `operator new`, so it must be built into its own test binary.
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+#include "tensorflow/core/protobuf/config.pb.h"
+#include "tensorflow/core/public/session.h"
+#include "tensorflow/core/public/session_options.h"
+
+namespace {
+std::atomic<tensorflow::int64> num_allocations(0);
+}  // namespace
+
+void* operator new(std::size_t size) {
+  num_allocations.fetch_add(1, std::memory_order_relaxed);
+  void* ptr = std::malloc(size == 0 ? 1 : size);
+  if (ptr == nullptr) throw std::bad_alloc();
+  return ptr;
+}
+
+void* operator new[](std::size_t size) {
+  num_allocations.fetch_add(1, std::memory_order_relaxed);
+  void* ptr = std::malloc(size == 0 ? 1 : size);
+  if (ptr == nullptr) throw std::bad_alloc();
+  return ptr;
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { std::free(ptr); }
+
+namespace tensorflow {
+namespace {
+
+// Builds a graph with `num_chains` independent chains of `chain_length`
+// Identity nodes, each fed by its own Placeholder, and makes a callable that
+// feeds every Placeholder and fetches the end of every chain.
+void MakeChainsCallable(int num_chains, int chain_length, Session* session,
+                        Session::CallableHandle* handle,
+                        std::vector<Tensor>* feeds) {
+  Tensor value(DT_FLOAT, TensorShape());
+  value.flat<float>()(0) = 37.0;
+
+  Graph g(OpRegistry::Global());
+  CallableOptions callable_options;
+  for (int i = 0; i < num_chains; ++i) {
+    Node* node;
+    TF_CHECK_OK(NodeBuilder(g.NewName("Placeholder"), "Placeholder")
+                    .Attr("shape", TensorShape())
+                    .Attr("dtype", DT_FLOAT)
+                    .Device("/cpu:0")
+                    .Finalize(&g, &node));
+    callable_options.add_feed(strings::StrCat(node->name(), ":0"));
+    feeds->push_back(value);
+    for (int j = 0; j < chain_length; ++j) {
+      TF_CHECK_OK(NodeBuilder(g.NewName("Identity"), "Identity")
+                      .Input(node)
+                      .Attr("T", DT_FLOAT)
+                      .Device("/cpu:0")
+                      .Finalize(&g, &node));
+    }
+    callable_options.add_fetch(strings::StrCat(node->name(), ":0"));
+  }
+  GraphDef gd;
+  g.ToGraphDef(&gd);
+  TF_CHECK_OK(session->Create(gd));
+  TF_CHECK_OK(session->MakeCallable(callable_options, handle));
+}
+
+TEST(DirectSessionAllocationsTest, RepeatedRunCallable) {
+  std::unique_ptr<Session> session(NewSession(SessionOptions()));
+  Session::CallableHandle handle;
+  std::vector<Tensor> feeds;
+  MakeChainsCallable(4, 8, session.get(), &handle, &feeds);
+  for (int i = 0; i < 100; ++i) {
+    std::vector<Tensor> fetches;
+    TF_ASSERT_OK(session->RunCallable(handle, feeds, &fetches, nullptr));
+    ASSERT_EQ(4, fetches.size());
+    for (const Tensor& t : fetches) {
+      EXPECT_EQ(37.0, t.flat<float>()(0));
+    }
+  }
+  TF_ASSERT_OK(session->ReleaseCallable(handle));
+}
+
+void RunCallableAllocationsHelper(int iters, int num_chains, int chain_length,
+                                  int inter_op_threads) {
+  testing::StopTiming();
+  SessionOptions opts;
+  opts.config.set_inter_op_parallelism_threads(inter_op_threads);
+  std::unique_ptr<Session> session(NewSession(opts));
+  Session::CallableHandle handle;
+  std::vector<Tensor> feeds;
+  MakeChainsCallable(num_chains, chain_length, session.get(), &handle, &feeds);
+
+  // Warm up, so that per-callable caches are populated before measuring.
+  std::vector<Tensor> fetches;
+  for (int i = 0; i < 10; ++i) {
+    fetches.clear();
+    TF_CHECK_OK(session->RunCallable(handle, feeds, &fetches, nullptr));
+  }
+
+  const int64 allocations_before = num_allocations.load();
+  testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    fetches.clear();
+    TF_CHECK_OK(session->RunCallable(handle, feeds, &fetches, nullptr));
+  }
+  testing::StopTiming();
+  const int64 allocations = num_allocations.load() - allocations_before;
+  testing::SetLabel(strings::StrCat(
+      "allocs/step=", static_cast<double>(allocations) / std::max(iters, 1)));
+  TF_CHECK_OK(session->ReleaseCallable(handle));
+}
+
+void BM_RunCallableAllocations(int iters, int num_chains, int chain_length) {
+  RunCallableAllocationsHelper(iters, num_chains, chain_length,
+                               /*inter_op_threads=*/0);
+}
+
+void BM_RunCallableAllocationsSingleThread(int iters, int num_chains,
+                                           int chain_length) {
+  RunCallableAllocationsHelper(iters, num_chains, chain_length,
+                               /*inter_op_threads=*/-1);
+}
+
+BENCHMARK(BM_RunCallableAllocations)
+    ->ArgPair(1, 1)
+    ->ArgPair(1, 100)
+    ->ArgPair(10, 10)
+    ->ArgPair(100, 1);
+BENCHMARK(BM_RunCallableAllocationsSingleThread)
+    ->ArgPair(1, 1)
+    ->ArgPair(1, 100)
+    ->ArgPair(10, 10)
+    ->ArgPair(100, 1);
+
+}  // namespace
+}  // namespace tensorflow
@@ -30,6 +30,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/function_testlib.h"
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/framework/metrics.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
@@ -198,6 +199,56 @@ TEST_F(DirectSessionMinusAXTest, RunSimpleNetwork_Callable) {
   }
 }
 
+TEST_F(DirectSessionMinusAXTest, RunSimpleNetwork_ReusesOptimizedGraph) {
+  Initialize({3, 2, -1, 0});
+  auto session = CreateSession();
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(def_));
+
+  monitoring::CounterCell* hits =
+      metrics::GetGraphOptimizationCacheCounter("hit");
+  monitoring::CounterCell* misses =
+      metrics::GetGraphOptimizationCacheCounter("miss");
+  const int64 initial_hits = hits->value();
+  const int64 initial_misses = misses->value();
+
+  std::vector<Tensor> outputs;
+  TF_ASSERT_OK(session->Run({}, {y_ + ":0"}, {y_neg_}, &outputs));
+  ASSERT_EQ(1, outputs.size());
+  EXPECT_FLOAT_EQ(5.0, outputs[0].matrix<float>()(0, 0));
+  EXPECT_EQ(initial_hits, hits->value());
+  EXPECT_EQ(initial_misses + 1, misses->value());
+
+  // A callable with the same signature reuses the optimized graph.
+  Session::CallableHandle handle;
+  TF_ASSERT_OK(session->MakeCallable(
+      MakeCallableOptions({}, {y_ + ":0"}, {y_neg_}), &handle));
+  outputs.clear();
+  TF_ASSERT_OK(session->RunCallable(handle, {}, &outputs, nullptr));
+  ASSERT_EQ(1, outputs.size());
+  EXPECT_FLOAT_EQ(5.0, outputs[0].matrix<float>()(0, 0));
+  TF_ASSERT_OK(session->ReleaseCallable(handle));
+  EXPECT_EQ(initial_hits + 1, hits->value());
+  EXPECT_EQ(initial_misses + 1, misses->value());
+
+  // So does a new signature that induces the same node set.
+  outputs.clear();
+  TF_ASSERT_OK(session->Run({}, {y_ + ":0", y_ + ":0"}, {y_neg_}, &outputs));
+  ASSERT_EQ(2, outputs.size());
+  EXPECT_FLOAT_EQ(5.0, outputs[0].matrix<float>()(0, 0));
+  EXPECT_FLOAT_EQ(5.0, outputs[1].matrix<float>()(0, 0));
+  EXPECT_EQ(initial_hits + 2, hits->value());
+  EXPECT_EQ(initial_misses + 1, misses->value());
+
+  // A signature with a different node set is optimized separately.
+  outputs.clear();
+  TF_ASSERT_OK(session->Run({}, {z_ + ":0"}, {}, &outputs));
+  ASSERT_EQ(1, outputs.size());
+  EXPECT_FLOAT_EQ(-5.0, outputs[0].matrix<float>()(0, 0));
+  EXPECT_EQ(initial_hits + 2, hits->value());
+  EXPECT_EQ(initial_misses + 2, misses->value());
+}
+
 TEST_F(DirectSessionMinusAXTest, RunSimpleNetwork_OptimizeForStaticGraph) {
   Initialize({3, 2, -1, 0});
   SessionOptions options(DefaultSessionOptions());
@@ -228,6 +279,34 @@ TEST_F(DirectSessionMinusAXTest, RunSimpleNetwork_OptimizeForStaticGraph) {
       absl::StrContains(s.error_message(), "optimize_for_static_graph"));
 }
 
+TEST_F(DirectSessionMinusAXTest, RunSimpleNetwork_StepArenaAllocator) {
+  Initialize({3, 2, -1, 0});
+  SessionOptions options(DefaultSessionOptions());
+  options.config.mutable_experimental()->set_use_step_arena_allocator(true);
+  auto session = absl::WrapUnique(NewSession(options));
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(def_));
+
+  std::vector<Tensor> all_outputs;
+  for (int i = 0; i < 3; ++i) {
+    std::vector<Tensor> outputs;
+    TF_ASSERT_OK(session->Run({}, {y_ + ":0", z_ + ":0"}, {}, &outputs));
+    ASSERT_EQ(2, outputs.size());
+    EXPECT_FLOAT_EQ(5.0, outputs[0].matrix<float>()(0, 0));
+    EXPECT_FLOAT_EQ(-5.0, outputs[1].matrix<float>()(0, 0));
+    all_outputs.insert(all_outputs.end(), outputs.begin(), outputs.end());
+  }
+
+  // Tensors returned from a step remain valid after the session that
+  // produced them is destroyed.
+  TF_ASSERT_OK(session->Close());
+  session.reset();
+  for (int i = 0; i < all_outputs.size(); i += 2) {
+    EXPECT_FLOAT_EQ(5.0, all_outputs[i].matrix<float>()(0, 0));
+    EXPECT_FLOAT_EQ(-5.0, all_outputs[i + 1].matrix<float>()(0, 0));
+  }
+}
+
 TEST_F(DirectSessionMinusAXTest,
        RunSimpleNetwork_DisableOutputPartitionGraphs) {
   Initialize({3, 2, -1, 0});
@@ -391,6 +391,7 @@ void EagerContext::ClearCachesAndDefaultExecutor() {
   mutex_lock ml(cache_mu_);
   default_executor_.WaitForAllPendingNodes().IgnoreError();
   kernel_cache_.clear();
+  kernel_cache_generation_.fetch_add(1, std::memory_order_release);
   for (auto& entry : registered_functions_) {
     entry.second->cached_kernel_keys->clear();
   }
@@ -550,6 +551,8 @@ EagerContext::~EagerContext() {
   // Custom devices may have obtained references to various context components
   // (executors, thread pool). It's safer to run their destructors early.
   custom_devices_.clear();
+  // Likewise for the trace cache, which holds tensor handles.
+  trace_cache_.reset();
 
   ClearCachesAndThreadExecutors();
   std::unordered_map<std::thread::id, EagerExecutor*> executors_copy;
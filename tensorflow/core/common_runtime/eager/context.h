@@ -130,6 +130,17 @@ class CustomDevice {
                          int* num_retvals) = 0;
 };
 
+// Sees the ops dispatched through EagerOperation::Execute once installed with
+// EagerContext::SetTraceCache. See EagerTraceCache in trace_cache.h.
+class EagerTraceCacheInterface {
+ public:
+  virtual ~EagerTraceCacheInterface() {}
+
+  // Same contract as EagerExecute.
+  virtual Status Execute(EagerOperation* op, TensorHandle** retvals,
+                         int* num_retvals) = 0;
+};
+
 // Custom devices do many of the same things as physical Devices, but have a
 // much more restricted interface. We pass around ambiguous pointers since
 // TensorHandles may be placed either on custom or physical devices.
@@ -289,6 +300,13 @@ class EagerContext : public ImmediateExecutionContext, public core::RefCounted {
 
   void AddKernelToCache(Fprint128 cache_key, KernelAndDevice* kernel);
 
+  // Incremented every time the kernel cache is cleared.  Kernels remembered
+  // outside of the cache are only valid for the generation they were looked
+  // up in.
+  int64 KernelCacheGeneration() const {
+    return kernel_cache_generation_.load(std::memory_order_acquire);
+  }
+
   bool LogDevicePlacement() const { return log_device_placement_; }
   void SetLogDevicePlacement(bool enable) { log_device_placement_ = enable; }
   bool AllowSoftPlacement() const { return allow_soft_placement_; }
@@ -487,6 +505,15 @@ class EagerContext : public ImmediateExecutionContext, public core::RefCounted {
   Status RegisterCustomDevice(const string& name,
                               std::unique_ptr<CustomDevice> device);
 
+  // Replaces the trace cache, nullptr removes it. Not safe to call while other
+  // threads execute ops.
+  void SetTraceCache(std::unique_ptr<EagerTraceCacheInterface> trace_cache) {
+    trace_cache_ = std::move(trace_cache);
+  }
+  EagerTraceCacheInterface* GetTraceCache() const {
+    return trace_cache_.get();
+  }
+
   // Find or create a composite device with the given `underlying_devices` and
   // `device_name` (if not empty).
   Status FindOrCreateCompositeDevice(
@@ -578,6 +605,7 @@ class EagerContext : public ImmediateExecutionContext, public core::RefCounted {
   Rendezvous* rendezvous_;
   std::function<Rendezvous*(const int64)> rendezvous_creator_;
   std::unordered_map<string, std::unique_ptr<CustomDevice>> custom_devices_;
+  std::unique_ptr<EagerTraceCacheInterface> trace_cache_;
 
   mutable mutex composite_devices_mu_;
   // Maps from the fingerprint of a set of device names to a virtual
@@ -614,6 +642,7 @@ class EagerContext : public ImmediateExecutionContext, public core::RefCounted {
       kernel_cache_ TF_GUARDED_BY(cache_mu_);
   std::unordered_map<string, RegisteredFunction*> registered_functions_
       TF_GUARDED_BY(cache_mu_);
+  std::atomic<int64> kernel_cache_generation_{0};
 
   // Whether we should compute RunMetadata.
   std::atomic<bool> should_store_graphs_{false};
@@ -56,12 +56,17 @@ AbstractTensorInterface* TensorHandle::Resolve(Status* status) {
   if (Type() == REMOTE) {
     const tensorflow::Tensor* t = nullptr;
     TensorHandle* h_cpu = nullptr;
+    // Keep the fetched value as a host mirror of this handle, so that resolving
+    // it again or using it in local ops does not fetch it from the remote
+    // worker again. Remote handles are immutable, so the mirror never goes
+    // stale.
     *status = EagerCopyToDevice(this, ctx_, &ctx_->Executor(), ctx_->HostCPU(),
-                                false, &h_cpu);
+                                /*mirror=*/true, &h_cpu);
     if (!status->ok()) {
       return nullptr;
     }
-    *status = h_cpu->Tensor(&t);
+    *status = h_cpu->TensorFromDevice(ctx_->CanonicalDevice(ctx_->HostCPU()),
+                                      &t);
     if (!status->ok()) {
       h_cpu->Unref();
       return nullptr;
@@ -211,6 +216,12 @@ Status EagerOperation::Execute(absl::Span<AbstractTensorHandle*> retvals,
   if (device != kVariantDeviceNull) {
     SetDevice(device);
   }
+  EagerTraceCacheInterface* trace_cache = ctx_.GetTraceCache();
+  if (trace_cache != nullptr) {
+    return trace_cache->Execute(
+        this, reinterpret_cast<tensorflow::TensorHandle**>(retvals.data()),
+        num_retvals);
+  }
   return EagerExecute(
       this, reinterpret_cast<tensorflow::TensorHandle**>(retvals.data()),
       num_retvals);
@@ -38,6 +38,27 @@ void EagerOperation::Clear() {
   ClearInferenceState();
 }
 
+core::RefCountPtr<KernelAndDevice> EagerOperation::GetLastKernel(
+    const Fprint128& cache_key) {
+  if (last_kernel_ == nullptr) return nullptr;
+  if (last_kernel_generation_ != ctx_.KernelCacheGeneration()) {
+    // The kernel cache was cleared, e.g. because the set of devices changed.
+    last_kernel_.reset();
+    return nullptr;
+  }
+  if (!(last_kernel_key_ == cache_key)) return nullptr;
+  last_kernel_->Ref();
+  return core::RefCountPtr<KernelAndDevice>(last_kernel_.get());
+}
+
+void EagerOperation::SetLastKernel(const Fprint128& cache_key,
+                                   int64 generation, KernelAndDevice* kernel) {
+  kernel->Ref();
+  last_kernel_.reset(kernel);
+  last_kernel_key_ = cache_key;
+  last_kernel_generation_ = generation;
+}
+
 Status EagerOperation::SetAttrValue(const char* attr_name,
                                     const AttrValue& value) {
   MutableAttrs()->Set(attr_name, value);
@@ -150,6 +150,17 @@ class EagerOperation : public ImmediateExecutionOperation {
 
   void UpdateInput(int i, TensorHandle* h);
 
+  // Returns the kernel this operation last ran with if it was looked up under
+  // `cache_key` and the context's kernel cache has not been cleared since, or
+  // nullptr otherwise.  Lets repeated executions of the same primitive op skip
+  // the locked lookup in the context's kernel cache.
+  core::RefCountPtr<KernelAndDevice> GetLastKernel(const Fprint128& cache_key);
+
+  // Remembers `kernel`, found in or added to the context's kernel cache under
+  // `cache_key` during `generation`, across Clear() and Reset().
+  void SetLastKernel(const Fprint128& cache_key, int64 generation,
+                     KernelAndDevice* kernel);
+
   // Like TensorHandles, EagerOperations may be placed either on a virtual
   // CustomDevice or on a physical Device.
   VariantDevice Device() const { return device_; }
@@ -240,6 +251,11 @@ class EagerOperation : public ImmediateExecutionOperation {
   int inference_arg_idx_;  // arg definition index for the next input to be
                            // added
   gtl::FlatSet<std::string> inference_attrs_;  // attributes inferred so far
+
+  // Kernel cache entry of the last execution, see GetLastKernel().
+  Fprint128 last_kernel_key_ = {0, 0};
+  int64 last_kernel_generation_ = -1;
+  core::RefCountPtr<KernelAndDevice> last_kernel_;
 };
 
 inline void EagerOperation::UpdateInput(int i, TensorHandle* h) {
@@ -48,5 +48,37 @@ TEST(EagerOperationTest, DeviceName) {
   ctx->Unref();
 }
 
+TEST(EagerOperationTest, LastKernel) {
+  StaticDeviceMgr device_mgr(DeviceFactory::NewDevice(
+      "CPU", {}, "/job:localhost/replica:0/task:0/device:CPU:0"));
+  auto ctx = new EagerContext(
+      SessionOptions(),
+      tensorflow::ContextDevicePlacementPolicy::DEVICE_PLACEMENT_SILENT,
+      tensorflow::ContextMirroringPolicy::MIRRORING_NONE, false, false,
+      &device_mgr, false, nullptr, nullptr, nullptr);
+
+  auto op = new EagerOperation(ctx);
+  const Fprint128 key = {1, 2};
+  EXPECT_EQ(nullptr, op->GetLastKernel(key));
+
+  core::RefCountPtr<KernelAndDevice> kernel(new KernelAndDeviceOp(
+      nullptr, false, nullptr, nullptr, nullptr, ctx->HostCPU()));
+  op->SetLastKernel(key, ctx->KernelCacheGeneration(), kernel.get());
+  EXPECT_EQ(kernel.get(), op->GetLastKernel(key).get());
+  EXPECT_EQ(nullptr, op->GetLastKernel({1, 3}));
+
+  // The kernel survives reuse of the operation.
+  op->Clear();
+  EXPECT_EQ(kernel.get(), op->GetLastKernel(key).get());
+
+  // Clearing the kernel cache invalidates the remembered kernel.
+  ctx->ClearCachesAndDefaultExecutor();
+  EXPECT_EQ(nullptr, op->GetLastKernel(key));
+  EXPECT_TRUE(kernel->RefCountIsOne());
+
+  delete op;
+  ctx->Unref();
+}
+
 }  // namespace
 }  // namespace tensorflow
@@ -476,7 +476,20 @@ Status GetOrCreateKernelAndDevice(
     }
   }
 
-  core::RefCountPtr<KernelAndDevice> kernel = ctx.GetCachedKernel(cache_key);
+  // Read the generation before the lookup so that a concurrent clear of the
+  // kernel cache invalidates the kernel remembered below.
+  const int64 cache_generation = ctx.KernelCacheGeneration();
+  core::RefCountPtr<KernelAndDevice> kernel;
+  bool remember_kernel = false;
+  if (!op->is_function()) {
+    // Fast path for ops executed repeatedly with the same attributes, inputs
+    // and device, e.g. in a Python loop reusing the thread's EagerOperation.
+    kernel = op->GetLastKernel(cache_key);
+  }
+  if (kernel == nullptr) {
+    kernel = ctx.GetCachedKernel(cache_key);
+    remember_kernel = kernel != nullptr && !op->is_function();
+  }
   if (kernel == nullptr) {
     DVLOG(2) << "Creating new kernel for " << op->Name() << " on device "
              << DeviceNameOrUnspecified(op->Device());
@@ -567,10 +580,15 @@ Status GetOrCreateKernelAndDevice(
       TF_RETURN_IF_ERROR(OpDefForOp(op->Name().data(), &op_def));
       if (KernelCacheEnabled(*op_def)) {
         ctx.AddKernelToCache(cache_key, kernel.get());
+        remember_kernel = true;
       }
     }
   }
 
+  if (remember_kernel) {
+    op->SetLastKernel(cache_key, cache_generation, kernel.get());
+  }
+
   int num_outputs = kernel->num_outputs();
   if (num_outputs > *num_retvals) {
     return errors::InvalidArgument("Expecting ", num_outputs,
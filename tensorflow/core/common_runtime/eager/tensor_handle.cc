@@ -960,6 +960,11 @@ Status TensorHandle::SetTensor(tensorflow::Tensor&& t, const Device* d) {
   return Status::OK();
 }
 
+void TensorHandle::SetWaitCallback(std::function<void()> callback) {
+  DCHECK(Type() == LOCAL) << "SetWaitCallback is only called on local handles.";
+  absl::get<LocalTensorHandleData>(data_).SetWaitCallback(std::move(callback));
+}
+
 void TensorHandle::Poison(Status status, const Device* d) {
   DVLOG(3) << "Poison on TensorHandle: " << this << " device: " << d;
 
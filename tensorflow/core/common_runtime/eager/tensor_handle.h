@@ -17,6 +17,7 @@ limitations under the License.
 
 #include <algorithm>
 #include <cstddef>
+#include <functional>
 #include <memory>
 #include <queue>
 #include <string>
@@ -220,6 +221,10 @@ class TensorHandle : public ImmediateExecutionTensorHandle {
   // tensor for a specific device.
   void Poison(Status status, const Device* d);
 
+  // Makes the first wait for this non-ready local handle run `callback`
+  // before blocking. `callback` is expected to call SetTensor or Poison.
+  void SetWaitCallback(std::function<void()> callback);
+
   // TODO(b/154282629): Consider moving it to EagerContext.
   Status CopyToDevice(const EagerContext& ctx, tensorflow::Device* d,
                       tensorflow::Tensor* output);
@@ -264,6 +269,7 @@ class TensorHandle : public ImmediateExecutionTensorHandle {
 
  private:
   friend class PackedTensorHandleTest;
+  friend class EagerTraceCache;
 
   TensorHandle(std::vector<TensorHandle*>&& handles, Device* device,
                const tensorflow::DataType dtype,
@@ -105,10 +105,18 @@ string LocalTensorHandleData::DebugString() const {
 void LocalTensorHandleData::BlockingControl::SetReady() {
   mutex_lock l(mu_);
   is_ready_ = true;
+  on_wait_ = nullptr;
 }
 
 Status LocalTensorHandleData::BlockingControl::WaitReady(
     const char* caller) const {
+  std::function<void()> on_wait;
+  {
+    mutex_lock l(mu_);
+    if (!is_ready_) on_wait.swap(on_wait_);
+  }
+  if (on_wait) on_wait();
+
   tf_shared_lock l(mu_);
   if (!is_ready_) {
     profiler::TraceMe activity(
@@ -130,6 +138,7 @@ void LocalTensorHandleData::BlockingControl::Poison(Status status) {
   }
   is_poisoned_ = status;
   is_ready_ = true;
+  on_wait_ = nullptr;
 }
 
 }  // namespace tensorflow
@@ -15,6 +15,8 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_COMMON_RUNTIME_EAGER_TENSOR_HANDLE_DATA_H_
 #define TENSORFLOW_CORE_COMMON_RUNTIME_EAGER_TENSOR_HANDLE_DATA_H_
 
+#include <functional>
+
 #include "absl/types/variant.h"
 #include "tensorflow/core/common_runtime/eager/context.h"
 #include "tensorflow/core/framework/tensor.h"
@@ -57,6 +59,13 @@ class LocalTensorHandleData {
 
   Status SetTensor(tensorflow::Tensor&& t);
 
+  // Sets a function that the first WaitReady call made before the tensor is
+  // ready runs instead of blocking right away, so that whoever will set the
+  // tensor can produce it on demand. Dropped once the tensor is set.
+  void SetWaitCallback(std::function<void()> callback) {
+    absl::get<BlockingControl>(ctrl_).SetWaitCallback(std::move(callback));
+  }
+
   string DebugString() const;
 
  private:
@@ -89,6 +98,10 @@ class LocalTensorHandleData {
       return is_ready_;
     }
     void SetReady();
+    void SetWaitCallback(std::function<void()> callback) {
+      mutex_lock l(mu_);
+      on_wait_ = std::move(callback);
+    }
     Status WaitReady(const char* caller) const;
     void Poison(Status status);
     Status IsPoisoned() const {
@@ -100,6 +113,7 @@ class LocalTensorHandleData {
     mutable mutex mu_;
     bool is_ready_ TF_GUARDED_BY(mu_);
     Status is_poisoned_ TF_GUARDED_BY(mu_);
+    mutable std::function<void()> on_wait_ TF_GUARDED_BY(mu_);
   };
 
   absl::variant<NonBlockingControl, BlockingControl> ctrl_;
@@ -0,0 +1,526 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/common_runtime/eager/trace_cache.h"
+
+#include <limits>
+
+#include "absl/types/optional.h"
+#include "tensorflow/core/common_runtime/eager/execute.h"
+#include "tensorflow/core/framework/function.h"
+#include "tensorflow/core/framework/graph_to_functiondef.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+namespace {
+
+inline Fprint128 FingerprintCat128(const Fprint128& a, const Fprint128& b) {
+  return {FingerprintCat64(a.low64, b.low64),
+          FingerprintCat64(a.high64, b.high64)};
+}
+
+inline Fprint128 FingerprintCat128(const Fprint128& a, const int64 b) {
+  auto x = FingerprintCat64(a.low64, b);
+  return {x, FingerprintCat64(a.high64, x)};
+}
+
+// Number of ops the trace cache is executing on this thread. Ops that they
+// dispatch, e.g. from a py_func, are executed but not traced.
+thread_local int dispatch_depth = 0;
+
+class ScopedDispatch {
+ public:
+  ScopedDispatch() { ++dispatch_depth; }
+  ~ScopedDispatch() { --dispatch_depth; }
+};
+
+Status CopyToReplayedOutput(const EagerContext& ctx, TensorHandle* from,
+                            Device* device, TensorHandle* to) {
+  Tensor tensor;
+  TF_RETURN_IF_ERROR(from->CopyToDevice(
+      ctx, device == nullptr ? ctx.HostCPU() : device, &tensor));
+  return to->SetTensor(std::move(tensor), device);
+}
+
+}  // namespace
+
+EagerTraceCache::EagerTraceCache(EagerContext* ctx, int min_iterations)
+    : ctx_(ctx), min_iterations_(min_iterations) {
+  DCHECK_GT(min_iterations_, 0);
+}
+
+EagerTraceCache::~EagerTraceCache() {
+  mutex_lock l(mu_);
+  WaitForExecution(&l);
+  if (active_) {
+    PoisonReplayedOutputs(
+        0, errors::Cancelled("The eager trace cache was destroyed while an "
+                             "iteration was in progress."));
+    ResetIteration();
+  }
+}
+
+Status EagerTraceCache::BeginIteration() {
+  mutex_lock l(mu_);
+  WaitForExecution(&l);
+  if (active_) {
+    return errors::FailedPrecondition(
+        owner_ == std::this_thread::get_id()
+            ? "An iteration of the traced region is already in progress."
+            : "Another thread is running an iteration of the traced region.");
+  }
+  active_ = true;
+  owner_ = std::this_thread::get_id();
+  replaying_ = compiled_;
+  return Status::OK();
+}
+
+Status EagerTraceCache::EndIteration() {
+  mutex_lock l(mu_);
+  WaitForExecution(&l);
+  if (!ActiveOnThisThread()) {
+    return errors::FailedPrecondition(
+        "No iteration of the traced region is in progress on this thread.");
+  }
+  Status status;
+  if (replaying_ && num_replayed_ == compiled_trace_.ops.size()) {
+    ++stats_.replayed_iterations;
+    replaying_ = false;
+    {
+      ScopedExecution execution(this);
+      status = RunCompiledTrace();
+    }
+    if (!status.ok()) {
+      PoisonReplayedOutputs(0, status);
+      // Trace the region again rather than repeating the failure.
+      compiled_ = false;
+      repeats_ = 0;
+    }
+    ResetIteration();
+    return status;
+  }
+
+  // The iteration either was traced from the start or fell back, maybe now
+  // because it ran fewer ops than the compiled trace.
+  if (replaying_) status = FallBack();
+  ++stats_.traced_iterations;
+  if (status.ok() && traceable_ && !trace_.ops.empty()) {
+    Fprint128 fingerprint = Fingerprint128(strings::StrCat(args_.size()));
+    for (const TracedOp& op : trace_.ops) {
+      fingerprint = FingerprintCat128(fingerprint, op.signature);
+    }
+    trace_.fingerprint = fingerprint;
+    if (fingerprint == last_fingerprint_) {
+      ++repeats_;
+    } else {
+      last_fingerprint_ = fingerprint;
+      repeats_ = 1;
+    }
+    if (repeats_ >= min_iterations_ &&
+        !(compiled_ && compiled_trace_.fingerprint == fingerprint)) {
+      for (TensorHandle* arg : args_) {
+        trace_.arg_dtypes.push_back(arg->dtype);
+      }
+      Status s = CompileTrace(std::move(trace_));
+      if (!s.ok()) {
+        VLOG(1) << "Unable to replay the traced region: " << s;
+        // Do not retry until the region runs different ops.
+        repeats_ = std::numeric_limits<int>::min();
+      }
+    }
+  }
+  ResetIteration();
+  return status;
+}
+
+Status EagerTraceCache::Execute(EagerOperation* op, TensorHandle** retvals,
+                                int* num_retvals) {
+  if (dispatch_depth > 0) {
+    return EagerExecute(op, retvals, num_retvals);
+  }
+  TracedOp traced;
+  bool trace = false;
+  {
+    mutex_lock l(mu_);
+    WaitForExecution(&l);
+    if (ActiveOnThisThread()) {
+      if (replaying_) {
+        if (ReplayOp(op, retvals, num_retvals).ok()) return Status::OK();
+        TF_RETURN_IF_ERROR(FallBack());
+      }
+      if (traceable_) {
+        traceable_ = DescribeOp(op, &traced).ok();
+        trace = traceable_;
+      }
+    }
+  }
+
+  Status status;
+  {
+    ScopedDispatch dispatch;
+    status = EagerExecute(op, retvals, num_retvals);
+  }
+  if (trace) {
+    mutex_lock l(mu_);
+    if (!status.ok()) {
+      traceable_ = false;
+    } else if (traceable_) {
+      RecordOp(std::move(traced), retvals, *num_retvals);
+    }
+  }
+  return status;
+}
+
+EagerTraceCache::Stats EagerTraceCache::GetStats() const {
+  mutex_lock l(mu_);
+  return stats_;
+}
+
+Status EagerTraceCache::DescribeOp(EagerOperation* op, TracedOp* traced) {
+  if (op->is_function() || !op->IsLocal() ||
+      VariantDeviceIsCustom(op->Device()) || op->Executor().Async()) {
+    return errors::Unimplemented("Unable to trace ", op->Name());
+  }
+  traced->name = op->Name();
+  traced->device = op->DeviceName();
+  op->Attrs().FillAttrValueMap(&traced->attrs);
+  Fprint128 signature = op->MutableAttrs()->CacheKey(op->DeviceName());
+  for (TensorHandle* input : op->Inputs()) {
+    auto produced = output_index_.find(input);
+    if (produced != output_index_.end()) {
+      const std::pair<int, int>& location = produced->second;
+      traced->inputs.push_back({location.first, location.second});
+      signature = FingerprintCat128(signature, location.first);
+      signature = FingerprintCat128(signature, location.second);
+      continue;
+    }
+    // Never wait here: a handle that is not ready could be one of ours that
+    // needs mu_ to be computed.
+    if (input->Type() != TensorHandle::LOCAL ||
+        VariantDeviceIsCustom(input->device()) || !input->IsReady()) {
+      return errors::Unimplemented("Unable to trace an input of ", op->Name());
+    }
+    TensorShape shape;
+    TF_RETURN_IF_ERROR(input->Shape(&shape));
+    auto inserted = arg_index_.emplace(input, args_.size());
+    if (inserted.second) {
+      input->Ref();
+      args_.push_back(input);
+    }
+    const int index = inserted.first->second;
+    traced->inputs.push_back({-1, index});
+    signature = FingerprintCat128(signature, -1 - index);
+    signature = FingerprintCat128(signature, input->dtype);
+    signature = FingerprintCat128(
+        signature,
+        reinterpret_cast<intptr_t>(absl::get<Device*>(input->device())));
+    signature = FingerprintCat128(signature, shape.dims());
+    for (int d = 0; d < shape.dims(); ++d) {
+      signature = FingerprintCat128(signature, shape.dim_size(d));
+    }
+  }
+  traced->signature = signature;
+  return Status::OK();
+}
+
+void EagerTraceCache::RecordOp(TracedOp traced, TensorHandle** outputs,
+                               int num_outputs) {
+  for (int i = 0; i < num_outputs; ++i) {
+    TensorHandle* h = outputs[i];
+    if (h->Type() != TensorHandle::LOCAL ||
+        VariantDeviceIsCustom(h->device())) {
+      traceable_ = false;
+      return;
+    }
+    traced.outputs.push_back({h->dtype, absl::get<Device*>(h->device()),
+                              h->op_device(), h->resource_device()});
+  }
+  // Pin the replayed op where it ran rather than where it was requested.
+  if (num_outputs > 0 && traced.outputs[0].op_device != nullptr) {
+    traced.device = traced.outputs[0].op_device->name();
+  }
+
+  // The outputs are held until the iteration ends so that ops using them can
+  // be traced back to them.
+  const int index = trace_.ops.size();
+  std::vector<TensorHandle*> op_outputs(outputs, outputs + num_outputs);
+  for (int i = 0; i < num_outputs; ++i) {
+    op_outputs[i]->Ref();
+    output_index_[op_outputs[i]] = {index, i};
+  }
+  outputs_.push_back(std::move(op_outputs));
+  trace_.ops.push_back(std::move(traced));
+}
+
+Status EagerTraceCache::ReplayOp(EagerOperation* op, TensorHandle** retvals,
+                                 int* num_retvals) {
+  if (num_replayed_ == compiled_trace_.ops.size()) {
+    return errors::OutOfRange("The iteration runs more ops than traced.");
+  }
+  const TracedOp& expected = compiled_trace_.ops[num_replayed_];
+  TracedOp traced;
+  TF_RETURN_IF_ERROR(DescribeOp(op, &traced));
+  if (!(traced.signature == expected.signature) ||
+      expected.outputs.size() > *num_retvals) {
+    return errors::InvalidArgument(op->Name(), " does not match the trace.");
+  }
+
+  std::vector<TensorHandle*> outputs;
+  for (int i = 0; i < expected.outputs.size(); ++i) {
+    const TracedOutput& output = expected.outputs[i];
+    TensorHandle* h = TensorHandle::CreateEmptyLocalHandle(
+        output.device, output.op_device, output.resource_device, output.dtype,
+        ctx_);
+    h->SetWaitCallback([this]() { FallBackForRead(); });
+    h->Ref();
+    output_index_[h] = {num_replayed_, i};
+    outputs.push_back(h);
+    retvals[i] = h;
+  }
+  outputs_.push_back(std::move(outputs));
+  *num_retvals = expected.outputs.size();
+  ++num_replayed_;
+  // Like a synchronously executed op, drop the references to the inputs.
+  op->Clear();
+  return Status::OK();
+}
+
+Status EagerTraceCache::FallBack() {
+  DCHECK(replaying_);
+  replaying_ = false;
+  ++stats_.fallbacks;
+  trace_.ops.assign(compiled_trace_.ops.begin(),
+                    compiled_trace_.ops.begin() + num_replayed_);
+  Status status;
+  int i = 0;
+  {
+    ScopedExecution execution(this);
+    for (; i < num_replayed_ && status.ok(); ++i) {
+      status = ExecuteTracedOp(compiled_trace_.ops[i], ReplayedInputs(i),
+                               outputs_[i]);
+    }
+  }
+  if (!status.ok()) {
+    PoisonReplayedOutputs(i - 1, status);
+    traceable_ = false;
+  }
+  return status;
+}
+
+void EagerTraceCache::FallBackForRead() {
+  mutex_lock l(mu_);
+  WaitForExecution(&l);
+  if (replaying_) {
+    // Failures poison the handle being read.
+    FallBack().IgnoreError();
+  }
+}
+
+Status EagerTraceCache::ExecuteTracedOp(
+    const TracedOp& traced, const std::vector<TensorHandle*>& inputs,
+    const std::vector<TensorHandle*>& outputs) {
+  EagerOperation op(ctx_);
+  TF_RETURN_IF_ERROR(op.Reset(traced.name.c_str(), traced.device.c_str()));
+  for (const auto& attr : traced.attrs) {
+    op.MutableAttrs()->Set(attr.first, attr.second);
+  }
+  for (TensorHandle* input : inputs) {
+    TF_RETURN_IF_ERROR(op.AddInput(input));
+  }
+  std::vector<TensorHandle*> retvals(outputs.size(), nullptr);
+  int num_retvals = retvals.size();
+  {
+    ScopedDispatch dispatch;
+    TF_RETURN_IF_ERROR(EagerExecute(&op, retvals.data(), &num_retvals));
+  }
+  Status status;
+  if (num_retvals != outputs.size()) {
+    status = errors::Internal(traced.name, " returned ", num_retvals,
+                              " outputs, but ", outputs.size(),
+                              " were traced.");
+  }
+  for (int i = 0; i < num_retvals; ++i) {
+    if (status.ok() && i < outputs.size()) {
+      status = CopyToReplayedOutput(*ctx_, retvals[i],
+                                    traced.outputs[i].device, outputs[i]);
+    }
+    retvals[i]->Unref();
+  }
+  return status;
+}
+
+Status EagerTraceCache::RunCompiledTrace() {
+  EagerOperation op(ctx_);
+  TF_RETURN_IF_ERROR(op.Reset(function_name_.c_str(), nullptr));
+  for (TensorHandle* arg : args_) {
+    TF_RETURN_IF_ERROR(op.AddInput(arg));
+  }
+  int num_retvals = 0;
+  for (const TracedOp& traced : compiled_trace_.ops) {
+    num_retvals += traced.outputs.size();
+  }
+  const int num_outputs = num_retvals;
+  std::vector<TensorHandle*> retvals(num_outputs, nullptr);
+  {
+    ScopedDispatch dispatch;
+    TF_RETURN_IF_ERROR(EagerExecute(&op, retvals.data(), &num_retvals));
+  }
+  Status status;
+  if (num_retvals != num_outputs) {
+    status = errors::Internal(function_name_, " returned ", num_retvals,
+                              " outputs instead of ", num_outputs);
+  }
+  int next = 0;
+  for (int i = 0; i < compiled_trace_.ops.size() && status.ok(); ++i) {
+    const TracedOp& traced = compiled_trace_.ops[i];
+    for (int j = 0; j < traced.outputs.size() && status.ok(); ++j, ++next) {
+      status = CopyToReplayedOutput(*ctx_, retvals[next],
+                                    traced.outputs[j].device, outputs_[i][j]);
+    }
+  }
+  for (int i = 0; i < num_retvals; ++i) {
+    retvals[i]->Unref();
+  }
+  return status;
+}
+
+Status EagerTraceCache::CompileTrace(Trace trace) {
+  const string name =
+      strings::StrCat("__eager_trace_", trace.fingerprint.high64, "_",
+                      trace.fingerprint.low64);
+  if (ctx_->FindFunctionDef(name) == nullptr) {
+    Graph graph(OpRegistry::Global());
+    Status s;
+    std::vector<Node*> args;
+    for (int i = 0; i < trace.arg_dtypes.size(); ++i) {
+      NodeDef def;
+      TF_RETURN_IF_ERROR(NodeDefBuilder(strings::StrCat("arg", i),
+                                        FunctionLibraryDefinition::kArgOp)
+                             .Attr("T", trace.arg_dtypes[i])
+                             .Attr("index", i)
+                             .Finalize(&def));
+      args.push_back(graph.AddNode(def, &s));
+      TF_RETURN_IF_ERROR(s);
+    }
+
+    std::vector<Node*> nodes;
+    Node* last_stateful = nullptr;
+    int num_retvals = 0;
+    for (int i = 0; i < trace.ops.size(); ++i) {
+      const TracedOp& traced = trace.ops[i];
+      NodeDef def;
+      def.set_name(strings::StrCat("op", i));
+      def.set_op(traced.name);
+      def.set_device(traced.device);
+      def.mutable_attr()->insert(traced.attrs.begin(), traced.attrs.end());
+      Node* node = graph.AddNode(def, &s);
+      TF_RETURN_IF_ERROR(s);
+      for (int j = 0; j < traced.inputs.size(); ++j) {
+        const TracedInput& input = traced.inputs[j];
+        if (input.op < 0) {
+          graph.AddEdge(args[input.index], 0, node, j);
+        } else {
+          graph.AddEdge(nodes[input.op], input.index, node, j);
+        }
+      }
+      // Keep the side effects in the order the iteration ran them in.
+      if (node->op_def().is_stateful()) {
+        if (last_stateful != nullptr) {
+          graph.AddControlEdge(last_stateful, node);
+        }
+        last_stateful = node;
+      }
+      nodes.push_back(node);
+
+      for (int j = 0; j < traced.outputs.size(); ++j, ++num_retvals) {
+        const DataType dtype = traced.outputs[j].dtype;
+        NodeDef ret;
+        TF_RETURN_IF_ERROR(NodeDefBuilder(strings::StrCat("ret", num_retvals),
+                                          FunctionLibraryDefinition::kRetOp)
+                               .Input(def.name(), j, dtype)
+                               .Attr("T", dtype)
+                               .Attr("index", num_retvals)
+                               .Finalize(&ret));
+        Node* ret_node = graph.AddNode(ret, &s);
+        TF_RETURN_IF_ERROR(s);
+        graph.AddEdge(node, j, ret_node, 0);
+      }
+    }
+
+    FunctionDef fdef;
+    TF_RETURN_IF_ERROR(GraphToFunctionDef(
+        graph, name,
+        [](const Node* node) -> absl::optional<string> {
+          if (node->op_def().is_stateful()) return node->name();
+          return absl::nullopt;
+        },
+        &fdef));
+    TF_RETURN_IF_ERROR(ctx_->AddFunctionDef(fdef));
+  }
+
+  VLOG(1) << "Replaying " << trace.ops.size() << " traced eager ops as "
+          << name;
+  compiled_trace_ = std::move(trace);
+  function_name_ = name;
+  compiled_ = true;
+  ++stats_.compiled_traces;
+  return Status::OK();
+}
+
+std::vector<TensorHandle*> EagerTraceCache::ReplayedInputs(int index) {
+  std::vector<TensorHandle*> inputs;
+  for (const TracedInput& input : compiled_trace_.ops[index].inputs) {
+    inputs.push_back(input.op < 0 ? args_[input.index]
+                                  : outputs_[input.op][input.index]);
+  }
+  return inputs;
+}
+
+void EagerTraceCache::PoisonReplayedOutputs(int first_op,
+                                            const Status& status) {
+  for (int i = first_op; i < outputs_.size(); ++i) {
+    for (TensorHandle* h : outputs_[i]) {
+      if (!h->IsReady()) {
+        h->Poison(status, absl::get<Device*>(h->device()));
+      }
+    }
+  }
+}
+
+void EagerTraceCache::ResetIteration() {
+  for (TensorHandle* arg : args_) {
+    arg->Unref();
+  }
+  args_.clear();
+  arg_index_.clear();
+  for (const std::vector<TensorHandle*>& op_outputs : outputs_) {
+    for (TensorHandle* h : op_outputs) {
+      h->Unref();
+    }
+  }
+  outputs_.clear();
+  output_index_.clear();
+  trace_ = Trace();
+  active_ = false;
+  traceable_ = true;
+  replaying_ = false;
+  num_replayed_ = 0;
+}
+
+}  // namespace tensorflow
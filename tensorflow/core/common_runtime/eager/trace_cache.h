@@ -0,0 +1,233 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_EAGER_TRACE_CACHE_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_EAGER_TRACE_CACHE_H_
+
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "tensorflow/core/common_runtime/eager/context.h"
+#include "tensorflow/core/common_runtime/eager/eager_operation.h"
+#include "tensorflow/core/common_runtime/eager/tensor_handle.h"
+#include "tensorflow/core/framework/attr_value_util.h"
+#include "tensorflow/core/framework/function.pb.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/fingerprint.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+
+namespace tensorflow {
+
+// Captures the ops that a thread dispatches inside a marked region, typically
+// the body of a training loop, and replays them as a single function once
+// they repeat.
+//
+// Every iteration of the region is bracketed by BeginIteration() and
+// EndIteration(). While an iteration is traced, ops run eagerly as usual and
+// are recorded along with the dtypes and shapes of the tensors that flow into
+// the region. Once `min_iterations` iterations in a row recorded the same
+// ops, the trace is converted into a function that is registered with the
+// context and run through the ProcessFunctionLibraryRuntime like any other
+// function.
+//
+// From then on the ops of an iteration are matched against the trace instead
+// of being executed: every matching op returns handles that become ready when
+// EndIteration() runs the function on the iteration's inputs. An op that does
+// not match, because its attributes or the shapes of its inputs changed,
+// makes the iteration fall back: the ops matched so far are executed eagerly,
+// in order, and the rest of the iteration is traced again. Reading the value
+// of a handle that is not ready yet has the same effect.
+//
+// Only local ops on physical devices are traced, and only with a synchronous
+// executor. Errors raised by replayed ops are reported by EndIteration(), or
+// by the read that made the iteration fall back.
+class EagerTraceCache : public EagerTraceCacheInterface {
+ public:
+  struct Stats {
+    // Iterations whose ops ran eagerly, completely or after a fallback.
+    int64 traced_iterations = 0;
+    // Iterations that ran as one function.
+    int64 replayed_iterations = 0;
+    // Replayed iterations that fell back to eager execution.
+    int64 fallbacks = 0;
+    // Functions created from traces.
+    int64 compiled_traces = 0;
+  };
+
+  EagerTraceCache(EagerContext* ctx, int min_iterations);
+  ~EagerTraceCache() override;
+
+  // Starts an iteration of the traced region on the calling thread. Ops
+  // dispatched by other threads are not affected.
+  Status BeginIteration();
+
+  // Ends the iteration started by the calling thread, which makes all handles
+  // it returned ready.
+  Status EndIteration();
+
+  Status Execute(EagerOperation* op, TensorHandle** retvals,
+                 int* num_retvals) override;
+
+  Stats GetStats() const;
+
+ private:
+  // Where an op input comes from: output `index` of the op at `op` in the
+  // trace, or the iteration input `index` if `op` is negative.
+  struct TracedInput {
+    int op;
+    int index;
+  };
+
+  struct TracedOutput {
+    DataType dtype;
+    Device* device;
+    Device* op_device;
+    Device* resource_device;
+  };
+
+  struct TracedOp {
+    string name;
+    // The device the op ran on.
+    string device;
+    AttrValueMap attrs;
+    std::vector<TracedInput> inputs;
+    std::vector<TracedOutput> outputs;
+    Fprint128 signature;
+  };
+
+  struct Trace {
+    std::vector<TracedOp> ops;
+    std::vector<DataType> arg_dtypes;
+    Fprint128 fingerprint;
+  };
+
+  // Fills the name, attributes, inputs and signature of `traced` from `op`,
+  // adding its inputs that are not produced by the current iteration to the
+  // iteration inputs. Fails if `op` can not be traced.
+  Status DescribeOp(EagerOperation* op, TracedOp* traced)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Adds `traced`, whose outputs are `outputs`, to the current trace.
+  void RecordOp(TracedOp traced, TensorHandle** outputs, int num_outputs)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Returns handles for the outputs of the next op of the compiled trace.
+  Status ReplayOp(EagerOperation* op, TensorHandle** retvals, int* num_retvals)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Executes the ops replayed so far in the current iteration and switches it
+  // to tracing.
+  Status FallBack() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Called when a handle returned by ReplayOp is waited for.
+  void FallBackForRead();
+
+  // Releases mu_ while the cache executes ops for the current iteration,
+  // which may take long or dispatch more ops. In the meantime the state of
+  // the iteration does not change: everyone else that needs it waits in
+  // WaitForExecution().
+  class ScopedExecution {
+   public:
+    explicit ScopedExecution(EagerTraceCache* cache)
+        TF_NO_THREAD_SAFETY_ANALYSIS : cache_(cache) {
+      cache_->executing_ = true;
+      cache_->mu_.unlock();
+    }
+    ~ScopedExecution() TF_NO_THREAD_SAFETY_ANALYSIS {
+      cache_->mu_.lock();
+      cache_->executing_ = false;
+      cache_->execution_done_.notify_all();
+    }
+
+   private:
+    EagerTraceCache* const cache_;
+  };
+
+  void WaitForExecution(mutex_lock* l) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    while (executing_) execution_done_.wait(*l);
+  }
+
+  // The following run under a ScopedExecution.
+
+  // Executes `traced` eagerly on `inputs` and sets its replayed outputs.
+  Status ExecuteTracedOp(const TracedOp& traced,
+                         const std::vector<TensorHandle*>& inputs,
+                         const std::vector<TensorHandle*>& outputs);
+
+  // Runs the compiled function for the current iteration.
+  Status RunCompiledTrace() TF_NO_THREAD_SAFETY_ANALYSIS;
+
+  // Returns the inputs of the op at `index` in the compiled trace.
+  std::vector<TensorHandle*> ReplayedInputs(int index)
+      TF_NO_THREAD_SAFETY_ANALYSIS;
+
+  // Makes `trace` the compiled trace, creating its function.
+  Status CompileTrace(Trace trace) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Poisons the outputs of the replayed ops starting at `first_op`.
+  void PoisonReplayedOutputs(int first_op, const Status& status)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Drops the handles held for the current iteration.
+  void ResetIteration() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  bool ActiveOnThisThread() const TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    return active_ && owner_ == std::this_thread::get_id();
+  }
+
+  EagerContext* const ctx_;
+  const int min_iterations_;
+
+  mutable mutex mu_;
+  Stats stats_ TF_GUARDED_BY(mu_);
+  bool executing_ TF_GUARDED_BY(mu_) = false;
+  condition_variable execution_done_;
+
+  // The iteration in progress.
+  bool active_ TF_GUARDED_BY(mu_) = false;
+  std::thread::id owner_ TF_GUARDED_BY(mu_);
+  // False once an op that can not be traced ran in the iteration.
+  bool traceable_ TF_GUARDED_BY(mu_) = true;
+  // Whether the iteration follows the compiled trace so far.
+  bool replaying_ TF_GUARDED_BY(mu_) = false;
+  // Ops of the iteration, when it is traced.
+  Trace trace_ TF_GUARDED_BY(mu_);
+  // Number of ops replayed, when it is replayed.
+  int num_replayed_ TF_GUARDED_BY(mu_) = 0;
+  // Inputs of the iteration, in the order in which ops used them first.
+  std::vector<TensorHandle*> args_ TF_GUARDED_BY(mu_);
+  absl::flat_hash_map<TensorHandle*, int> arg_index_ TF_GUARDED_BY(mu_);
+  // Outputs of the iteration's ops and where they come from.
+  std::vector<std::vector<TensorHandle*>> outputs_ TF_GUARDED_BY(mu_);
+  absl::flat_hash_map<TensorHandle*, std::pair<int, int>> output_index_
+      TF_GUARDED_BY(mu_);
+
+  // The previous traced iteration and how many times in a row it ran.
+  Fprint128 last_fingerprint_ TF_GUARDED_BY(mu_) = {0, 0};
+  int repeats_ TF_GUARDED_BY(mu_) = 0;
+
+  // The trace replayed as `function_name_`, if any.
+  bool compiled_ TF_GUARDED_BY(mu_) = false;
+  Trace compiled_trace_ TF_GUARDED_BY(mu_);
+  string function_name_ TF_GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(EagerTraceCache);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_EAGER_TRACE_CACHE_H_
@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/executor.h"
 
+#include <algorithm>
 #include <atomic>
 #include <memory>
 #include <vector>
@@ -30,12 +31,14 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/renamed_device.h"
 #include "tensorflow/core/common_runtime/simple_propagator_state.h"
 #include "tensorflow/core/common_runtime/step_stats_collector.h"
+#include "tensorflow/core/common_runtime/work_stealing_ready_queues.h"
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/cancellation.h"
 #include "tensorflow/core/framework/collective.h"
 #include "tensorflow/core/framework/control_flow.h"
 #include "tensorflow/core/framework/device_attributes.pb.h"
 #include "tensorflow/core/framework/log_memory.h"
+#include "tensorflow/core/framework/metrics.h"
 #include "tensorflow/core/framework/node_def_util.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/op_segment.h"
@@ -43,6 +46,7 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor_reference.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/graph/algorithm.h"
 #include "tensorflow/core/graph/edgeset.h"
 #include "tensorflow/core/graph/graph.h"
 #include "tensorflow/core/graph/graph_node_util.h"
@@ -55,6 +59,7 @@ limitations under the License.
 #include "tensorflow/core/lib/gtl/manual_constructor.h"
 #include "tensorflow/core/lib/hash/hash.h"
 #include "tensorflow/core/platform/context.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/logging.h"
@@ -134,11 +139,35 @@ typedef gtl::InlinedVector<AllocatorAttributes, 4> AllocatorAttributeVec;
 
 class ExecutorImpl : public Executor {
  public:
-  explicit ExecutorImpl(const LocalExecutorParams& p) : immutable_state_(p) {}
+  // If `num_work_stealing_workers` is positive, each invocation of the
+  // executor dispatches ready nodes to at most that many worker loops, each of
+  // which owns a local ready queue and steals from the others when it runs
+  // out of work. Otherwise, every expensive node is dispatched to the runner
+  // in its own closure.
+  //
+  // If `use_static_schedule` is true and the graph has no control flow, the
+  // executor computes the critical path cost of every node once, in
+  // `Initialize()`, and dispatches ready nodes in decreasing order of that
+  // cost, so that the thread that completes a node continues along the
+  // longest remaining path.
+  explicit ExecutorImpl(const LocalExecutorParams& p,
+                        int num_work_stealing_workers = 0,
+                        bool use_static_schedule = false)
+      : immutable_state_(p),
+        num_work_stealing_workers_(num_work_stealing_workers),
+        use_static_schedule_(use_static_schedule) {}
 
   Status Initialize(const Graph& graph) {
     TF_RETURN_IF_ERROR(immutable_state_.Initialize(graph));
     kernel_stats_.Initialize(immutable_state_.graph_view());
+    const CostModel* cost_model = immutable_state_.params().cost_model;
+    if (cost_model != nullptr) {
+      kernel_stats_.SeedCostEstimates(graph, *cost_model);
+    }
+    if (use_static_schedule_ &&
+        !immutable_state_.requires_control_flow_support()) {
+      kernel_stats_.ComputeCriticalPathCosts(graph, cost_model);
+    }
     return Status::OK();
   }
 
@@ -154,18 +183,43 @@ class ExecutorImpl : public Executor {
     KernelStats() = default;
 
     void Initialize(const GraphView& gview) {
+      may_be_expensive_ = absl::make_unique<bool[]>(gview.num_nodes());
       is_expensive_ = absl::make_unique<std::atomic<bool>[]>(gview.num_nodes());
       cost_estimates_ =
           absl::make_unique<std::atomic_uint_fast64_t[]>(gview.num_nodes());
+      sample_counts_ =
+          absl::make_unique<std::atomic_uint_fast32_t[]>(gview.num_nodes());
       for (int32 i = 0; i < gview.num_nodes(); ++i) {
+        may_be_expensive_[i] = false;
+        is_expensive_[i] = false;
+        sample_counts_[i] = 0;
         if (gview.node(i)) {
-          is_expensive_[i] =
+          may_be_expensive_[i] =
               gview.node(i)->kernel && gview.node(i)->kernel->IsExpensive();
+          is_expensive_[i] = may_be_expensive_[i];
           cost_estimates_[i] = kInitialCostEstimateCycles;
         }
       }
     }
 
+    // Replaces the initial cost estimate of every node in `graph` that has
+    // been measured by `cost_model` with the measured average execution time.
+    // This avoids dispatching cheap kernels to the runner during the first
+    // steps, while the executor's own measurements are still warming up.
+    void SeedCostEstimates(const Graph& graph, const CostModel& cost_model) {
+      const double cycles_per_micro =
+          1.0 / profile_utils::CpuUtils::GetMicroSecPerClock();
+      if (!(cycles_per_micro > 0)) return;
+      for (const Node* n : graph.op_nodes()) {
+        const int32 id = n->id();
+        if (!may_be_expensive_[id] || cost_model.TotalCount(n) == 0) continue;
+        const uint64 estimate = static_cast<uint64>(
+            cost_model.TimeEstimate(n).value() * cycles_per_micro);
+        cost_estimates_[id] = estimate;
+        is_expensive_[id] = estimate > kOpIsExpensiveThresholdCycles;
+      }
+    }
+
     // Returns true iff the given node is considered "expensive". The
     // executor uses this flag to optimize graph execution, for example
     // by "inlining" inexpensive kernels.
@@ -175,15 +229,63 @@ class ExecutorImpl : public Executor {
               kOpIsExpensiveThresholdCycles);
     }
 
+    // Returns true iff the execution time of the next invocation of the given
+    // node should be measured and passed to `UpdateCostEstimate()`.
+    //
+    // Expensive nodes are always measured. Nodes that are currently considered
+    // inexpensive, but whose kernel may be expensive, are measured once every
+    // `kInexpensiveSampleInterval` invocations, so that a kernel whose cost
+    // grows across steps (e.g. because its input shapes change) is eventually
+    // dispatched asynchronously again.
+    bool ShouldMeasure(const NodeItem& node) {
+      if (is_expensive_[node.node_id].load(std::memory_order_relaxed)) {
+        return true;
+      }
+      return may_be_expensive_[node.node_id] &&
+             sample_counts_[node.node_id].fetch_add(
+                 1, std::memory_order_relaxed) %
+                     kInexpensiveSampleInterval ==
+                 0;
+    }
+
+    // Computes, for every node in `graph`, the cost of the most expensive path
+    // from that node to the sink, including the node itself. Nodes measured by
+    // `cost_model` (if not null) cost their average execution time in
+    // microseconds, and all other nodes cost one.
+    //
+    // REQUIRES: `graph` does not contain cycles.
+    void ComputeCriticalPathCosts(const Graph& graph,
+                                  const CostModel* cost_model) {
+      critical_path_costs_ = absl::make_unique<uint64[]>(graph.num_node_ids());
+      std::vector<Node*> post_order;
+      GetPostOrder(graph, &post_order);
+      // In post order, every node is visited after all of its successors.
+      for (const Node* n : post_order) {
+        uint64 cost = 1;
+        if (cost_model != nullptr && cost_model->TotalCount(n) > 0) {
+          cost = std::max<int64>(1, cost_model->TimeEstimate(n).value());
+        }
+        uint64 max_successor_cost = 0;
+        for (const Edge* e : n->out_edges()) {
+          max_successor_cost = std::max(max_successor_cost,
+                                        critical_path_costs_[e->dst()->id()]);
+        }
+        critical_path_costs_[n->id()] = cost + max_successor_cost;
+      }
+    }
+
+    bool has_critical_path_costs() const {
+      return critical_path_costs_ != nullptr;
+    }
+
+    // REQUIRES: `has_critical_path_costs()`.
+    uint64 CriticalPathCost(const NodeItem& node) const {
+      return critical_path_costs_[node.node_id];
+    }
+
     // Updates the dynamic cost estimate, which is used to determine whether the
     // given node is expensive. The new cost estimate is a weighted average of
     // the old cost estimate and the latest cost.
-    //
-    // NOTE: We currently only expect updates to the cost estimate when
-    // `is_expensive_[node.node_id]` is true (or at least, it *was* true, when
-    // we started to execute the kernel. As a result, we expect that a kernel
-    // can only ever transition from "expensive" to "inexpensive", but not vice
-    // versa.
     void UpdateCostEstimate(const NodeItem& node, uint64 elapsed_cycles) {
       // N.B. Updates to `cost_estimate` are atomic but unlocked.  Simultaneous
       // updates may result in one or more updates being ignored.  This does not
@@ -194,9 +296,9 @@ class ExecutorImpl : public Executor {
                                 kCostDecay +
                             (elapsed_cycles / kCostDecay);
       cost_estimate.store(new_estimate, std::memory_order_relaxed);
-      if (new_estimate < kOpIsExpensiveThresholdCycles) {
-        is_expensive_[node.node_id].store(false, std::memory_order_relaxed);
-      }
+      is_expensive_[node.node_id].store(
+          new_estimate > kOpIsExpensiveThresholdCycles,
+          std::memory_order_relaxed);
     }
 
    private:
@@ -206,13 +308,27 @@ class ExecutorImpl : public Executor {
     static constexpr uint64 kInitialCostEstimateCycles = 100 * 1000 * 1000;
     static constexpr uint64 kOpIsExpensiveThresholdCycles = 5000;
     static constexpr uint64 kCostDecay = 10;
+    static constexpr uint32 kInexpensiveSampleInterval = 64;
 
+    // True iff the node's kernel reports `OpKernel::IsExpensive()`. Nodes
+    // whose kernel is never expensive are always run inline.
+    std::unique_ptr<bool[]> may_be_expensive_;
     std::unique_ptr<std::atomic<bool>[]> is_expensive_;
     std::unique_ptr<std::atomic_uint_fast64_t[]> cost_estimates_;
+    std::unique_ptr<std::atomic_uint_fast32_t[]> sample_counts_;
+    // Null unless `ComputeCriticalPathCosts()` has been called.
+    std::unique_ptr<uint64[]> critical_path_costs_;
   };
 
   ImmutableExecutorState immutable_state_;
   KernelStats kernel_stats_;
+  const int num_work_stealing_workers_;
+  const bool use_static_schedule_;
+
+  // Recycles the pending counts and input entries of completed steps, so that
+  // repeated invocations of the executor (e.g. through
+  // `DirectSession::RunCallable()`) do not reallocate them on every step.
+  SimplePropagatorState::StatePool simple_state_pool_;
 
   TF_DISALLOW_COPY_AND_ASSIGN(ExecutorImpl);
 };
@@ -245,7 +361,9 @@ class ExecutorImpl : public Executor {
 //   * `const_iterator begin() const`
 //   * `const_iterator end() const`
 // * A public constructor, `PropagatorStateType(const ImmutableExecutorState&
-//   immutable_state, int64 step_id)`.
+//   immutable_state, int64 step_id, bool vlog, StatePool* state_pool)`,
+//   where `StatePool` is a public type of `PropagatorStateType` that may be
+//   used to recycle per-step state across invocations of one executor.
 // * The following public methods:
 //   * `void ActivateRoots(gtl::ArraySlice<const NodeItem*> roots,
 //     TaggedNodeSeq* ready)`, which creates `TaggedNode` instances for the
@@ -271,7 +389,9 @@ class ExecutorState {
  public:
   ExecutorState(const Executor::Args& args,
                 const ImmutableExecutorState& immutable_state_,
-                ExecutorImpl::KernelStats* kernel_stats_);
+                ExecutorImpl::KernelStats* kernel_stats_,
+                int num_work_stealing_workers,
+                typename PropagatorStateType::StatePool* state_pool);
   ~ExecutorState();
 
   void RunAsync(Executor::DoneCallback done);
@@ -285,11 +405,23 @@ class ExecutorState {
 
   struct AsyncState;
 
+  // The breakdown of the time spent on some nodes of this step, in
+  // nanoseconds. See metrics::StepBreakdown.
+  struct StepBreakdownCounts {
+    uint64 scheduling_delay = 0;
+    uint64 compute = 0;
+    uint64 rendezvous_wait = 0;
+    uint64 allocator = 0;
+    uint64 input_wait = 0;
+    uint64 bytes_transferred = 0;
+  };
+
   // Process a ready node in current thread.
   void Process(TaggedNode node, int64 scheduled_nsec);
 
   Status ProcessSync(const NodeItem& item, OpKernelContext::Params* params,
-                     EntryVector* outputs, NodeExecStatsInterface* stats);
+                     EntryVector* outputs, NodeExecStatsInterface* stats,
+                     StepBreakdownCounts* breakdown);
   void ProcessAsync(const NodeItem& item, const OpKernelContext::Params& params,
                     const TaggedNode& tagged_node, Entry* first_input,
                     NodeExecStatsInterface* stats);
@@ -323,6 +455,43 @@ class ExecutorState {
   // REQUIRES: `!ready->empty()`.
   void ScheduleReady(TaggedNodeSeq* ready, TaggedNodeReadyQueue* inline_ready);
 
+  // Work-stealing variant of `ScheduleReady()`: inexpensive nodes are put in
+  // 'inline_ready' as before, but expensive nodes are pushed onto the ready
+  // queue of the current worker, and new worker loops are started (up to the
+  // number of queues) to run or steal them.
+  //
+  // REQUIRES: `ready_queues_ != nullptr`.
+  void ScheduleReadyWorkStealing(TaggedNodeSeq* ready,
+                                 TaggedNodeReadyQueue* inline_ready);
+
+  // Runs nodes from `ready_queues_`, starting with the queue at `index`, until
+  // all queues are empty.
+  //
+  // Each running worker loop holds a reference on `num_outstanding_ops_`, so
+  // that this state is not destroyed while the loop still accesses it.
+  void RunWorker(int index);
+
+  // Identifies the worker loop running on the current thread, if any.
+  struct WorkerSlot {
+    const ExecutorState* owner;
+    int index;
+  };
+  static WorkerSlot* CurrentWorker() {
+    static thread_local WorkerSlot slot = {nullptr, 0};
+    return &slot;
+  }
+
+  // Adds the `kernel_nsec` the kernel of `item` ran for, of which it spent
+  // `allocator_nsec` allocating memory, to the component of `*breakdown` the
+  // kernel belongs to.
+  static void AddKernelTime(const NodeItem& item, uint64 kernel_nsec,
+                            uint64 allocator_nsec,
+                            StepBreakdownCounts* breakdown);
+
+  // Adds `*breakdown` to the breakdown of this step, and resets it. Must be
+  // called before NodeDone(), after which this state may be deleted.
+  void FlushStepBreakdown(StepBreakdownCounts* breakdown);
+
   // Clean up when this executor is done.
   void Finish();
   void ScheduleFinish();
@@ -346,6 +515,7 @@ class ExecutorState {
   TensorStore* tensor_store_;
   // Step-local container.
   ScopedStepContainer* step_container_;
+  Allocator* step_temp_allocator_;
   StepStatsCollectorInterface* const stats_collector_;
   const tracing::EventCollector* const event_collector_;
   Context context_;
@@ -365,11 +535,26 @@ class ExecutorState {
 
   PropagatorStateType propagator_;
 
+  // Non-null iff the executor runs in work-stealing mode.
+  std::unique_ptr<WorkStealingReadyQueues<TaggedNode>> ready_queues_;
+  // Used to spread nodes scheduled from non-worker threads, and worker loop
+  // indices, across `ready_queues_`.
+  std::atomic<int> next_queue_index_{0};
+
   // Invoked when the execution finishes.
   Executor::DoneCallback done_cb_;
 
   std::atomic_int_fast32_t num_outstanding_ops_;
 
+  // The sums of the StepBreakdownCounts of the nodes of this step, recorded to
+  // metrics::RecordStepBreakdown() when it finishes.
+  std::atomic<uint64> scheduling_delay_nsec_{0};
+  std::atomic<uint64> compute_nsec_{0};
+  std::atomic<uint64> rendezvous_wait_nsec_{0};
+  std::atomic<uint64> allocator_nsec_{0};
+  std::atomic<uint64> input_wait_nsec_{0};
+  std::atomic<uint64> bytes_transferred_{0};
+
   // Available via OpKernelContext to every OpKernel invocation.
   mutex num_deferred_ops_mu_;
   int64 num_deferred_ops_ TF_GUARDED_BY(num_deferred_ops_mu_) = 0;
@@ -383,7 +568,8 @@ class ExecutorState {
 template <class PropagatorStateType>
 ExecutorState<PropagatorStateType>::ExecutorState(
     const Executor::Args& args, const ImmutableExecutorState& immutable_state,
-    ExecutorImpl::KernelStats* kernel_stats)
+    ExecutorImpl::KernelStats* kernel_stats, int num_work_stealing_workers,
+    typename PropagatorStateType::StatePool* state_pool)
     : vlog_(VLOG_IS_ON(1)),
       log_memory_(LogMemory::IsEnabled()),
       step_id_(args.step_id),
@@ -394,6 +580,7 @@ ExecutorState<PropagatorStateType>::ExecutorState(
       session_metadata_(immutable_state.params().session_metadata),
       tensor_store_(args.tensor_store),
       step_container_(args.step_container),
+      step_temp_allocator_(args.step_temp_allocator),
       stats_collector_(args.stats_collector),
       event_collector_(
           tracing::GetEventCollector(tracing::EventCategory::kCompute)),
@@ -406,13 +593,17 @@ ExecutorState<PropagatorStateType>::ExecutorState(
       runner_(args.runner),
       sync_on_finish_(args.sync_on_finish),
       run_all_kernels_inline_(args.run_all_kernels_inline),
-      propagator_(immutable_state, step_id_, vlog_),
+      propagator_(immutable_state, step_id_, vlog_, state_pool),
       num_outstanding_ops_(0) {
   if (args.user_intra_op_threadpool != nullptr) {
     Device* device = immutable_state_.params().device;
     user_device_ = RenamedDevice::NewRenamedDevice(
         device->name(), device, false, false, args.user_intra_op_threadpool);
   }
+  if (num_work_stealing_workers > 0 && !run_all_kernels_inline_) {
+    ready_queues_ = absl::make_unique<WorkStealingReadyQueues<TaggedNode>>(
+        num_work_stealing_workers);
+  }
 }
 
 template <class PropagatorStateType>
@@ -483,6 +674,8 @@ struct ExecutorState<PropagatorStateType>::AsyncState {
   Entry* first_input;
   OpKernelContext ctx;
   NodeExecStatsInterface* stats;
+  // When ComputeAsync() was called, for the step breakdown.
+  int64 start_nsec = 0;
 
  private:
   OpKernelContext::Params* ParamsButClearingEigenGPUDevice(
@@ -517,10 +710,12 @@ bool MightTrace(const tracing::EventCollector* event_collector,
 template <class PropagatorStateType>
 Status ExecutorState<PropagatorStateType>::ProcessSync(
     const NodeItem& item, OpKernelContext::Params* params, EntryVector* outputs,
-    NodeExecStatsInterface* stats) {
+    NodeExecStatsInterface* stats, StepBreakdownCounts* breakdown) {
   Status s;
   OpKernelContext ctx(params, item.num_outputs);
   nodestats::SetOpStart(stats);
+  const uint64 start_allocation_nsec = metrics::GetThreadAllocationTime();
+  const int64 start_nsec = nodestats::NowInNsec();
 
   OpKernel* op_kernel = item.kernel;
   Device* device = immutable_state_.params().device;
@@ -538,7 +733,7 @@ Status ExecutorState<PropagatorStateType>::ProcessSync(
     device->Compute(op_kernel, &ctx);
   } else {
     // In the common case, avoid creating any tracing objects.
-    if (is_expensive) {
+    if (kernel_stats_->ShouldMeasure(item)) {
       KernelTimer timer;
       device->Compute(op_kernel, &ctx);
       kernel_stats_->UpdateCostEstimate(item, timer.ElapsedCycles());
@@ -546,6 +741,9 @@ Status ExecutorState<PropagatorStateType>::ProcessSync(
       device->Compute(op_kernel, &ctx);
     }
   }
+  AddKernelTime(item, nodestats::NowInNsec() - start_nsec,
+                metrics::GetThreadAllocationTime() - start_allocation_nsec,
+                breakdown);
   nodestats::SetOpEnd(stats);
   if (outputs->size() < item.num_outputs) outputs->resize(item.num_outputs);
   s = ProcessOutputs(item, &ctx, outputs->data(), stats);
@@ -568,6 +766,21 @@ void ExecutorState<PropagatorStateType>::ProcessAsync(
     NodeExecStatsInterface* stats = state->stats;  // Shorthand
     Entry* first_input = state->first_input;       // Shorthand
 
+    // The allocations of async kernels may happen on any thread, so only the
+    // duration of the kernel is known.
+    StepBreakdownCounts breakdown;
+    AddKernelTime(*state->item, nodestats::NowInNsec() - state->start_nsec,
+                  /*allocator_nsec=*/0, &breakdown);
+    if (state->item->is_transfer_node && state->item->is_recv_or_switch) {
+      for (int i = 0; i < state->item->num_outputs; ++i) {
+        const Tensor* output = state->ctx.mutable_output(i);
+        if (output != nullptr) {
+          breakdown.bytes_transferred += output->TotalBytes();
+        }
+      }
+    }
+    FlushStepBreakdown(&breakdown);
+
     nodestats::SetOpEnd(stats);
     EntryVector outputs(state->item->num_outputs);
     Status s = ProcessOutputs(*state->item, &state->ctx, outputs.data(), stats);
@@ -595,6 +808,7 @@ void ExecutorState<PropagatorStateType>::ProcessAsync(
     if (completed) ScheduleFinish();
   };
   nodestats::SetOpStart(stats);
+  state->start_nsec = nodestats::NowInNsec();
   {
     profiler::AnnotatedTraceMe activity(
         [async_kernel, state] {
@@ -671,6 +885,7 @@ void ExecutorState<PropagatorStateType>::Process(TaggedNode tagged_node,
   params.function_library = immutable_state_.params().function_library;
   params.resource_manager = device->resource_manager();
   params.step_container = step_container_;
+  params.step_temp_allocator = step_temp_allocator_;
   params.slice_reader_cache = slice_reader_cache_;
   params.inputs = &inputs;
   params.input_alloc_attrs = &input_alloc_attrs;
@@ -701,6 +916,7 @@ void ExecutorState<PropagatorStateType>::Process(TaggedNode tagged_node,
 
   Status s;
   NodeExecStatsInterface* stats = nullptr;
+  StepBreakdownCounts breakdown;
 
   EntryVector outputs(1);
 
@@ -713,6 +929,10 @@ void ExecutorState<PropagatorStateType>::Process(TaggedNode tagged_node,
     const int id = item.node_id;
 
     propagator_.MaybeMarkStarted(tagged_node);
+    const int64 start_nsec = nodestats::NowInNsec();
+    if (start_nsec > scheduled_nsec) {
+      breakdown.scheduling_delay += start_nsec - scheduled_nsec;
+    }
 
     params.track_allocations = false;
     stats = nullptr;
@@ -756,6 +976,7 @@ void ExecutorState<PropagatorStateType>::Process(TaggedNode tagged_node,
           (first_input + i)->ClearVal();
         }
         propagator_.MaybeMarkCompleted(tagged_node);
+        FlushStepBreakdown(&breakdown);
         // Continue to process the nodes in 'inline_ready'.
         completed = NodeDone(s, &ready, stats, &inline_ready);
         continue;
@@ -770,10 +991,11 @@ void ExecutorState<PropagatorStateType>::Process(TaggedNode tagged_node,
       params.outputs_required_array = item.outputs_required.get();
 
       if (item.kernel_is_async) {
+        FlushStepBreakdown(&breakdown);
         ProcessAsync(item, params, tagged_node, first_input, stats);
         launched_asynchronously = true;
       } else {
-        s = ProcessSync(item, &params, &outputs, stats);
+        s = ProcessSync(item, &params, &outputs, stats, &breakdown);
       }
     }
 
@@ -802,9 +1024,9 @@ void ExecutorState<PropagatorStateType>::Process(TaggedNode tagged_node,
         outputs[i].ClearVal();
       }
 
-      if (stats) {
-        scheduled_nsec = nodestats::NowInNsec();
-      }
+      // The nodes this one made ready for `inline_ready` are scheduled now.
+      scheduled_nsec = nodestats::NowInNsec();
+      FlushStepBreakdown(&breakdown);
       // Postprocess.
       completed = NodeDone(s, &ready, stats, &inline_ready);
     }
@@ -1105,9 +1327,18 @@ void ExecutorState<PropagatorStateType>::ScheduleReady(
     TaggedNodeSeq* ready, TaggedNodeReadyQueue* inline_ready) {
   DCHECK(!ready->empty());
 
-  int64 scheduled_nsec = 0;
-  if (stats_collector_) {
-    scheduled_nsec = nodestats::NowInNsec();
+  const int64 scheduled_nsec = nodestats::NowInNsec();
+
+  if (kernel_stats_->has_critical_path_costs() && ready->size() > 1) {
+    // Static schedule: process the nodes with the longest remaining critical
+    // path first.
+    auto cost = [this](const TaggedNode& node) {
+      return kernel_stats_->CriticalPathCost(node.get_node_item());
+    };
+    std::sort(ready->begin(), ready->end(),
+              [&cost](const TaggedNode& a, const TaggedNode& b) {
+                return cost(a) > cost(b);
+              });
   }
 
   if (run_all_kernels_inline_) {
@@ -1126,12 +1357,34 @@ void ExecutorState<PropagatorStateType>::ScheduleReady(
         inline_ready->push_back(tagged_node);
       }
     }
+  } else if (ready_queues_) {
+    ScheduleReadyWorkStealing(ready, inline_ready);
   } else {
     const TaggedNode* curr_expensive_node = nullptr;
     if (inline_ready == nullptr) {
-      // Schedule to run all the ready ops in thread pool.
+      // Schedule to run all the expensive ready ops in thread pool, one
+      // closure per op. All inexpensive ops are batched into a single closure,
+      // so that they do not each pay for a thread pool hop.
+      TaggedNodeSeq inexpensive_nodes;
       for (auto& tagged_node : *ready) {
-        runner_([=]() { Process(tagged_node, scheduled_nsec); });
+        const NodeItem& item = *tagged_node.node_item;
+        if (tagged_node.get_is_dead() || !kernel_stats_->IsExpensive(item)) {
+          inexpensive_nodes.push_back(tagged_node);
+        } else {
+          runner_([=]() { Process(tagged_node, scheduled_nsec); });
+        }
+      }
+      if (inexpensive_nodes.size() == 1) {
+        runner_([this, tagged_node = inexpensive_nodes[0], scheduled_nsec]() {
+          Process(tagged_node, scheduled_nsec);
+        });
+      } else if (!inexpensive_nodes.empty()) {
+        runner_([this, inexpensive_nodes = std::move(inexpensive_nodes),
+                 scheduled_nsec]() {
+          for (auto& tagged_node : inexpensive_nodes) {
+            Process(tagged_node, scheduled_nsec);
+          }
+        });
       }
     } else {
       for (auto& tagged_node : *ready) {
@@ -1139,6 +1392,12 @@ void ExecutorState<PropagatorStateType>::ScheduleReady(
         if (tagged_node.get_is_dead() || !kernel_stats_->IsExpensive(item)) {
           // Inline this inexpensive node.
           inline_ready->push_back(tagged_node);
+        } else if (curr_expensive_node &&
+                   kernel_stats_->has_critical_path_costs()) {
+          // `*ready` is sorted by critical path cost, so keep the first
+          // expensive node for this thread and dispatch the others.
+          runner_(std::bind(&ExecutorState::Process, this, tagged_node,
+                            scheduled_nsec));
         } else {
           if (curr_expensive_node) {
             // Dispatch to another thread since there is plenty of work to
@@ -1164,6 +1423,95 @@ void ExecutorState<PropagatorStateType>::ScheduleReady(
   ready->clear();
 }
 
+template <class PropagatorStateType>
+void ExecutorState<PropagatorStateType>::ScheduleReadyWorkStealing(
+    TaggedNodeSeq* ready, TaggedNodeReadyQueue* inline_ready) {
+  // Partition `*ready` in place: nodes that this thread will run inline are
+  // moved to `inline_ready`, and the nodes that remain at the front of
+  // `*ready` are pushed onto the work-stealing queues.
+  size_t num_queued = 0;
+  if (inline_ready == nullptr) {
+    num_queued = ready->size();
+  } else {
+    bool have_expensive_node = false;
+    size_t expensive_node_index = 0;
+    for (size_t i = 0; i < ready->size(); ++i) {
+      const TaggedNode& tagged_node = (*ready)[i];
+      if (tagged_node.get_is_dead() ||
+          !kernel_stats_->IsExpensive(*tagged_node.node_item)) {
+        // Inline this inexpensive node.
+        inline_ready->push_back(tagged_node);
+      } else {
+        (*ready)[num_queued] = tagged_node;
+        if (!have_expensive_node) {
+          have_expensive_node = true;
+          expensive_node_index = num_queued;
+        }
+        ++num_queued;
+      }
+    }
+    if (have_expensive_node && inline_ready->empty()) {
+      // Keep one expensive node for this thread, since it has nothing else to
+      // do.
+      inline_ready->push_back((*ready)[expensive_node_index]);
+      --num_queued;
+      (*ready)[expensive_node_index] = (*ready)[num_queued];
+    }
+  }
+  if (num_queued == 0) return;
+
+  // Reserve worker loops, and take references on their behalf, *before*
+  // publishing any node: once a node is visible in the queues, an already
+  // running worker may execute all remaining work and finish the step.
+  int num_new_workers = 0;
+  while (static_cast<size_t>(num_new_workers) < num_queued &&
+         ready_queues_->TryClaimWorker()) {
+    ++num_new_workers;
+  }
+  if (num_new_workers > 0) {
+    num_outstanding_ops_.fetch_add(num_new_workers, std::memory_order_relaxed);
+  }
+
+  const WorkerSlot* current = CurrentWorker();
+  const bool on_worker = current->owner == this;
+  for (size_t i = 0; i < num_queued; ++i) {
+    const int index = on_worker ? current->index
+                                : next_queue_index_.fetch_add(
+                                      1, std::memory_order_relaxed);
+    ready_queues_->Push(index, (*ready)[i]);
+  }
+
+  const int num_workers = ready_queues_->num_workers();
+  for (int i = 0; i < num_new_workers; ++i) {
+    const int index =
+        next_queue_index_.fetch_add(1, std::memory_order_relaxed) %
+        num_workers;
+    runner_([this, index]() { RunWorker(index); });
+  }
+}
+
+template <class PropagatorStateType>
+void ExecutorState<PropagatorStateType>::RunWorker(int index) {
+  WorkerSlot* current = CurrentWorker();
+  const WorkerSlot saved = *current;
+  *current = {this, index};
+
+  TaggedNode tagged_node;
+  while (true) {
+    while (ready_queues_->Pop(index, &tagged_node)) {
+      Process(tagged_node, nodestats::NowInNsec());
+    }
+    ready_queues_->ReleaseWorker();
+    // A node may have been pushed after our last `Pop()` by a thread that
+    // observed this worker as active. Reclaim the slot to run it.
+    if (ready_queues_->empty() || !ready_queues_->TryClaimWorker()) break;
+  }
+
+  *current = saved;
+  // Drop the reference taken when this worker loop was started.
+  if (num_outstanding_ops_.fetch_sub(1) == 1) ScheduleFinish();
+}
+
 template <class PropagatorStateType>
 void ExecutorState<PropagatorStateType>::ScheduleFinish() {
   // Checks condition to decide if needs to invoke Finish(). If there are
@@ -1184,6 +1532,37 @@ void ExecutorState<PropagatorStateType>::ScheduleFinish() {
   Finish();
 }
 
+template <class PropagatorStateType>
+void ExecutorState<PropagatorStateType>::AddKernelTime(
+    const NodeItem& item, uint64 kernel_nsec, uint64 allocator_nsec,
+    StepBreakdownCounts* breakdown) {
+  allocator_nsec = std::min(allocator_nsec, kernel_nsec);
+  breakdown->allocator += allocator_nsec;
+  kernel_nsec -= allocator_nsec;
+  if (item.is_iterator_get_next) {
+    breakdown->input_wait += kernel_nsec;
+  } else if (item.is_transfer_node) {
+    breakdown->rendezvous_wait += kernel_nsec;
+  } else {
+    breakdown->compute += kernel_nsec;
+  }
+}
+
+template <class PropagatorStateType>
+void ExecutorState<PropagatorStateType>::FlushStepBreakdown(
+    StepBreakdownCounts* breakdown) {
+  auto add = [](uint64 value, std::atomic<uint64>* sum) {
+    if (value > 0) sum->fetch_add(value, std::memory_order_relaxed);
+  };
+  add(breakdown->scheduling_delay, &scheduling_delay_nsec_);
+  add(breakdown->compute, &compute_nsec_);
+  add(breakdown->rendezvous_wait, &rendezvous_wait_nsec_);
+  add(breakdown->allocator, &allocator_nsec_);
+  add(breakdown->input_wait, &input_wait_nsec_);
+  add(breakdown->bytes_transferred, &bytes_transferred_);
+  *breakdown = StepBreakdownCounts();
+}
+
 template <class PropagatorStateType>
 void ExecutorState<PropagatorStateType>::Finish() {
   mu_.lock();
@@ -1191,6 +1570,21 @@ void ExecutorState<PropagatorStateType>::Finish() {
   auto done_cb = std::move(done_cb_);
   auto runner = std::move(runner_);
   mu_.unlock();
+  // All the nodes are done, so the sums are final.
+  metrics::StepBreakdown breakdown;
+  breakdown.scheduling_delay_usecs =
+      scheduling_delay_nsec_.load(std::memory_order_relaxed) / 1000;
+  breakdown.compute_usecs =
+      compute_nsec_.load(std::memory_order_relaxed) / 1000;
+  breakdown.rendezvous_wait_usecs =
+      rendezvous_wait_nsec_.load(std::memory_order_relaxed) / 1000;
+  breakdown.allocator_usecs =
+      allocator_nsec_.load(std::memory_order_relaxed) / 1000;
+  breakdown.input_wait_usecs =
+      input_wait_nsec_.load(std::memory_order_relaxed) / 1000;
+  breakdown.bytes_transferred =
+      bytes_transferred_.load(std::memory_order_relaxed);
+  metrics::RecordStepBreakdown(breakdown);
   int64 step_id = step_id_;
   CHECK(done_cb != nullptr);
   Device* device = immutable_state_.params().device;
@@ -1299,11 +1693,14 @@ void ExecutorState<PropagatorStateType>::Finish() {
 
 void ExecutorImpl::RunAsync(const Args& args, DoneCallback done) {
   if (immutable_state_.requires_control_flow_support()) {
-    (new ExecutorState<PropagatorState>(args, immutable_state_, &kernel_stats_))
+    (new ExecutorState<PropagatorState>(args, immutable_state_, &kernel_stats_,
+                                        num_work_stealing_workers_,
+                                        /*state_pool=*/nullptr))
         ->RunAsync(std::move(done));
   } else {
-    (new ExecutorState<SimplePropagatorState>(args, immutable_state_,
-                                              &kernel_stats_))
+    (new ExecutorState<SimplePropagatorState>(
+         args, immutable_state_, &kernel_stats_, num_work_stealing_workers_,
+         &simple_state_pool_))
         ->RunAsync(std::move(done));
   }
 }
@@ -1357,6 +1754,51 @@ class DefaultExecutorRegistrar {
 };
 static DefaultExecutorRegistrar registrar;
 
+// Registers the "WORK_STEALING_EXECUTOR" executor type, which can be selected
+// with `ConfigProto.Experimental.executor_type`.
+class WorkStealingExecutorRegistrar {
+ public:
+  WorkStealingExecutorRegistrar() {
+    ExecutorFactory::Register("WORK_STEALING_EXECUTOR", new Factory);
+  }
+
+ private:
+  class Factory : public ExecutorFactory {
+    Status NewExecutor(const LocalExecutorParams& params, const Graph& graph,
+                       std::unique_ptr<Executor>* out_executor) override {
+      auto impl = absl::make_unique<ExecutorImpl>(
+          params, std::max(1, port::MaxParallelism()));
+      TF_RETURN_IF_ERROR(impl->Initialize(graph));
+      *out_executor = std::move(impl);
+      return Status::OK();
+    }
+  };
+};
+static WorkStealingExecutorRegistrar work_stealing_registrar;
+
+// Registers the "STATIC_SCHEDULE_EXECUTOR" executor type, which can be
+// selected with `ConfigProto.Experimental.executor_type`.
+class StaticScheduleExecutorRegistrar {
+ public:
+  StaticScheduleExecutorRegistrar() {
+    ExecutorFactory::Register("STATIC_SCHEDULE_EXECUTOR", new Factory);
+  }
+
+ private:
+  class Factory : public ExecutorFactory {
+    Status NewExecutor(const LocalExecutorParams& params, const Graph& graph,
+                       std::unique_ptr<Executor>* out_executor) override {
+      auto impl = absl::make_unique<ExecutorImpl>(
+          params, /*num_work_stealing_workers=*/0,
+          /*use_static_schedule=*/true);
+      TF_RETURN_IF_ERROR(impl->Initialize(graph));
+      *out_executor = std::move(impl);
+      return Status::OK();
+    }
+  };
+};
+static StaticScheduleExecutorRegistrar static_schedule_registrar;
+
 }  // namespace
 
 }  // namespace tensorflow
@@ -94,6 +94,9 @@ class Executor {
     string session_handle;
     TensorStore* tensor_store = nullptr;
     ScopedStepContainer* step_container = nullptr;
+    // If not null, used in place of the device allocator for temporaries
+    // that kernels allocate with default attributes. Not owned.
+    Allocator* step_temp_allocator = nullptr;
     CollectiveExecutor* collective_executor = nullptr;
     thread::ThreadPoolInterface* user_intra_op_threadpool = nullptr;
 
@@ -25,6 +25,7 @@ limitations under the License.
 #include "tensorflow/cc/ops/standard_ops.h"
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/common_runtime/device_factory.h"
+#include "tensorflow/core/common_runtime/executor_factory.h"
 #include "tensorflow/core/common_runtime/graph_constructor.h"
 #include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
 #include "tensorflow/core/common_runtime/lower_functional_ops.h"
@@ -37,7 +38,9 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/framework/versions.pb.h"
 #include "tensorflow/core/graph/algorithm.h"
+#include "tensorflow/core/graph/costmodel.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/monitoring/collection_registry.h"
 #include "tensorflow/core/lib/random/simple_philox.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/logging.h"
@@ -80,9 +83,16 @@ class ExecutorTest : public ::testing::Test {
     params.delete_kernel = [](OpKernel* kernel) {
       DeleteNonCachedKernel(kernel);
     };
+    params.cost_model = cost_model_;
     rendez_ = NewLocalRendezvous();
     delete exec_;
-    TF_CHECK_OK(NewLocalExecutor(params, *graph, &exec_));
+    if (executor_type_.empty()) {
+      TF_CHECK_OK(NewLocalExecutor(params, *graph, &exec_));
+    } else {
+      std::unique_ptr<Executor> executor;
+      TF_CHECK_OK(NewExecutor(executor_type_, params, *graph, &executor));
+      exec_ = executor.release();
+    }
     runner_ = [this](std::function<void()> fn) { thread_pool_->Schedule(fn); };
   }
 
@@ -101,6 +111,20 @@ class ExecutorTest : public ::testing::Test {
   StepStats step_stats_;
   Executor::Args::Runner runner_;
   Rendezvous* rendez_ = nullptr;
+  // If non-empty, `Create()` uses the executor registered under this type.
+  string executor_type_;
+  // If not null, passed to the executor created by `Create()`.
+  const CostModel* cost_model_ = nullptr;
+};
+
+class WorkStealingExecutorTest : public ExecutorTest {
+ protected:
+  WorkStealingExecutorTest() { executor_type_ = "WORK_STEALING_EXECUTOR"; }
+};
+
+class StaticScheduleExecutorTest : public ExecutorTest {
+ protected:
+  StaticScheduleExecutorTest() { executor_type_ = "STATIC_SCHEDULE_EXECUTOR"; }
 };
 
 // A float val -> Tensor<float>
@@ -175,6 +199,47 @@ TEST_F(ExecutorTest, SimpleAdd) {
   EXPECT_EQ(2.0, V(out));  // out = 1.0 + 1.0 = 2.0
 }
 
+// Returns the sum of the values recorded to the histogram `metric_name`, for
+// the point labeled `component` if it is not empty.
+double HistogramSum(const string& metric_name, const string& component) {
+  monitoring::CollectionRegistry::CollectMetricsOptions options;
+  options.collect_metric_descriptors = false;
+  auto metrics =
+      monitoring::CollectionRegistry::Default()->CollectMetrics(options);
+  auto it = metrics->point_set_map.find(metric_name);
+  if (it == metrics->point_set_map.end()) return 0;
+  for (const auto& point : it->second->points) {
+    if (component.empty() ||
+        (!point->labels.empty() && point->labels[0].value == component)) {
+      return point->histogram_value.sum();
+    }
+  }
+  return 0;
+}
+
+TEST_F(ExecutorTest, StepBreakdown) {
+  // c = a + b
+  auto g = absl::make_unique<Graph>(OpRegistry::Global());
+  auto in0 = test::graph::Recv(g.get(), "a", "float", ALICE, 1, BOB);
+  auto in1 = test::graph::Recv(g.get(), "b", "float", ALICE, 1, BOB);
+  auto tmp = test::graph::Add(g.get(), in0, in1);
+  test::graph::Send(g.get(), tmp, "c", BOB, 1, ALICE);
+  Create(std::move(g));
+  const double bytes_before =
+      HistogramSum("/tensorflow/core/step_bytes_transferred", "");
+  Rendezvous::Args args;
+  TF_ASSERT_OK(rendez_->Send(Key(ALICE, kIncarnation, BOB, "a"), args, V(1.0),
+                             false));
+  TF_ASSERT_OK(rendez_->Send(Key(ALICE, kIncarnation, BOB, "b"), args, V(1.0),
+                             false));
+  TF_ASSERT_OK(Run(rendez_));
+  // The two float scalars received by the Recv nodes.
+  EXPECT_DOUBLE_EQ(
+      2 * sizeof(float),
+      HistogramSum("/tensorflow/core/step_bytes_transferred", "") -
+          bytes_before);
+}
+
 TEST_F(ExecutorTest, SelfAdd) {
   // v0 <- a
   // v1 = v0 + v0
@@ -255,6 +320,101 @@ TEST_F(ExecutorTest, RandomTree) {
   EXPECT_EQ(4096.0, V(out));
 }
 
+TEST_F(ExecutorTest, CostModelSeededTree) {
+  auto g = absl::make_unique<Graph>(OpRegistry::Global());
+  BuildTree(1024, g.get());
+  // Mark every other node as expensive, so that the ready nodes are split
+  // between the inline and asynchronous dispatch paths.
+  CostModel cost_model(/*is_global=*/false);
+  cost_model.InitFromGraph(*g);
+  for (const Node* n : g->op_nodes()) {
+    cost_model.RecordCount(n, 1);
+    cost_model.RecordTime(n, Microseconds(n->id() % 2 == 0 ? 1 : 100000));
+  }
+  cost_model_ = &cost_model;
+  Create(std::move(g));
+  Rendezvous::Args args;
+  TF_ASSERT_OK(
+      rendez_->Send(Key(ALICE, kIncarnation, BOB, "a"), args, V(1.0), false));
+  TF_ASSERT_OK(Run(rendez_));
+  Tensor out = V(-1);
+  bool is_dead = false;
+  TF_ASSERT_OK(
+      rendez_->Recv(Key(BOB, kIncarnation, ALICE, "b"), args, &out, &is_dead));
+  EXPECT_EQ(1024.0, V(out));
+}
+
+TEST_F(WorkStealingExecutorTest, RandomTree) {
+  auto g = absl::make_unique<Graph>(OpRegistry::Global());
+  BuildTree(4096, g.get());
+  Create(std::move(g));
+  Rendezvous::Args args;
+  TF_ASSERT_OK(
+      rendez_->Send(Key(ALICE, kIncarnation, BOB, "a"), args, V(1.0), false));
+  TF_ASSERT_OK(Run(rendez_));
+  Tensor out = V(-1);
+  bool is_dead = false;
+  TF_ASSERT_OK(
+      rendez_->Recv(Key(BOB, kIncarnation, ALICE, "b"), args, &out, &is_dead));
+  EXPECT_EQ(4096.0, V(out));
+}
+
+TEST_F(WorkStealingExecutorTest, RepeatedRuns) {
+  auto g = absl::make_unique<Graph>(OpRegistry::Global());
+  BuildTree(256, g.get());
+  Create(std::move(g));
+  for (int iters = 0; iters < 32; ++iters) {
+    Rendezvous* rendez = NewLocalRendezvous();
+    Rendezvous::Args args;
+    TF_ASSERT_OK(
+        rendez->Send(Key(ALICE, kIncarnation, BOB, "a"), args, V(2.0), false));
+    TF_ASSERT_OK(Run(rendez));
+    Tensor out = V(-1);
+    bool is_dead = false;
+    TF_ASSERT_OK(
+        rendez->Recv(Key(BOB, kIncarnation, ALICE, "b"), args, &out, &is_dead));
+    EXPECT_EQ(512.0, V(out));
+    rendez->Unref();
+  }
+}
+
+TEST_F(StaticScheduleExecutorTest, RandomTree) {
+  auto g = absl::make_unique<Graph>(OpRegistry::Global());
+  BuildTree(4096, g.get());
+  Create(std::move(g));
+  Rendezvous::Args args;
+  TF_ASSERT_OK(
+      rendez_->Send(Key(ALICE, kIncarnation, BOB, "a"), args, V(1.0), false));
+  TF_ASSERT_OK(Run(rendez_));
+  Tensor out = V(-1);
+  bool is_dead = false;
+  TF_ASSERT_OK(
+      rendez_->Recv(Key(BOB, kIncarnation, ALICE, "b"), args, &out, &is_dead));
+  EXPECT_EQ(4096.0, V(out));
+}
+
+TEST_F(StaticScheduleExecutorTest, CostModelSeededTree) {
+  auto g = absl::make_unique<Graph>(OpRegistry::Global());
+  BuildTree(1024, g.get());
+  CostModel cost_model(/*is_global=*/false);
+  cost_model.InitFromGraph(*g);
+  for (const Node* n : g->op_nodes()) {
+    cost_model.RecordCount(n, 1);
+    cost_model.RecordTime(n, Microseconds(n->id() % 2 == 0 ? 1 : 100000));
+  }
+  cost_model_ = &cost_model;
+  Create(std::move(g));
+  Rendezvous::Args args;
+  TF_ASSERT_OK(
+      rendez_->Send(Key(ALICE, kIncarnation, BOB, "a"), args, V(1.0), false));
+  TF_ASSERT_OK(Run(rendez_));
+  Tensor out = V(-1);
+  bool is_dead = false;
+  TF_ASSERT_OK(
+      rendez_->Recv(Key(BOB, kIncarnation, ALICE, "b"), args, &out, &is_dead));
+  EXPECT_EQ(1024.0, V(out));
+}
+
 void BuildConcurrentAddAssign(Graph* g) {
   auto one = test::graph::Constant(g, V(1.0));
   // A variable holds one float.
@@ -433,7 +593,8 @@ TEST_F(ExecutorTest, NoInputTensors) {
 // Create a graph that is 'depth' deep. At each level, fan-in and fan-out a
 // maximum of 'width' nodes. All nodes are no-ops and all dependencies are
 // control dependencies.
-static void BM_executor(int iters, int width, int depth) {
+static void BM_executor_impl(int iters, int width, int depth,
+                             const char* executor_type) {
   testing::StopTiming();
 #ifdef PLATFORM_GOOGLE
   BenchmarkUseRealTime();
@@ -472,19 +633,76 @@ static void BM_executor(int iters, int width, int depth) {
 #endif  // PLATFORM_GOOGLE
   FixupSourceAndSinkEdges(g);
   testing::StartTiming();
-  test::Benchmark("cpu", g).Run(iters);
+  test::Benchmark("cpu", g, nullptr, nullptr, nullptr, executor_type)
+      .Run(iters);
+}
+
+static void BM_executor(int iters, int width, int depth) {
+  BM_executor_impl(iters, width, depth, "");
+}
+
+static void BM_work_stealing_executor(int iters, int width, int depth) {
+  BM_executor_impl(iters, width, depth, "WORK_STEALING_EXECUTOR");
+}
+
+static void BM_static_schedule_executor(int iters, int width, int depth) {
+  BM_executor_impl(iters, width, depth, "STATIC_SCHEDULE_EXECUTOR");
 }
 
 // Tall skinny graphs
 BENCHMARK(BM_executor)->ArgPair(16, 1024);
 BENCHMARK(BM_executor)->ArgPair(32, 8192);
+BENCHMARK(BM_work_stealing_executor)->ArgPair(16, 1024);
+BENCHMARK(BM_work_stealing_executor)->ArgPair(32, 8192);
+BENCHMARK(BM_static_schedule_executor)->ArgPair(16, 1024);
+BENCHMARK(BM_static_schedule_executor)->ArgPair(32, 8192);
 
 // Short fat graphs
 BENCHMARK(BM_executor)->ArgPair(1024, 16);
 BENCHMARK(BM_executor)->ArgPair(8192, 32);
+BENCHMARK(BM_work_stealing_executor)->ArgPair(1024, 16);
+BENCHMARK(BM_work_stealing_executor)->ArgPair(8192, 32);
+BENCHMARK(BM_static_schedule_executor)->ArgPair(1024, 16);
+BENCHMARK(BM_static_schedule_executor)->ArgPair(8192, 32);
 
 // Tall fat graph
 BENCHMARK(BM_executor)->ArgPair(1024, 1024);
+BENCHMARK(BM_work_stealing_executor)->ArgPair(1024, 1024);
+BENCHMARK(BM_static_schedule_executor)->ArgPair(1024, 1024);
+
+// Create a graph of 'width' independent chains, each of 'depth' scalar Add
+// ops, that all read the same constant. Wide shallow graphs exercise the
+// dispatch of many cheap ready nodes at once, and deep narrow graphs exercise
+// the inline execution of long chains of cheap nodes.
+static void BM_executor_step_time(int iters, int width, int depth) {
+  testing::StopTiming();
+#ifdef PLATFORM_GOOGLE
+  BenchmarkUseRealTime();
+#endif  // PLATFORM_GOOGLE
+  Graph* g = new Graph(OpRegistry::Global());
+  Node* one = test::graph::Constant(g, V(1.0));
+  for (int i = 0; i < width; ++i) {
+    Node* n = one;
+    for (int j = 0; j < depth; ++j) {
+      n = test::graph::Add(g, n, one);
+    }
+  }
+#ifdef PLATFORM_GOOGLE
+  SetBenchmarkLabel(strings::StrCat("Nodes = ", width * depth + 1));
+  SetBenchmarkItemsProcessed(width * depth * static_cast<int64>(iters));
+#endif  // PLATFORM_GOOGLE
+  FixupSourceAndSinkEdges(g);
+  testing::StartTiming();
+  test::Benchmark("cpu", g).Run(iters);
+}
+
+// Wide shallow graphs
+BENCHMARK(BM_executor_step_time)->ArgPair(1024, 1);
+BENCHMARK(BM_executor_step_time)->ArgPair(4096, 4);
+
+// Deep narrow graphs
+BENCHMARK(BM_executor_step_time)->ArgPair(1, 1024);
+BENCHMARK(BM_executor_step_time)->ArgPair(4, 4096);
 
 static void BM_const_identity(int iters, int width, int outputs_per_const) {
 #ifdef PLATFORM_GOOGL
@@ -73,6 +73,27 @@ bool GPUBFCAllocator::GetGarbageCollectionValue() {
   return true;
 }
 
+bool GPUBFCAllocator::GetThreadCacheValue() {
+  const char* enable_thread_cache =
+      std::getenv("TF_GPU_BFC_ALLOCATOR_THREAD_CACHE");
+  if (enable_thread_cache == nullptr) {
+    // By default, do not cache freed buffers per thread.
+    return false;
+  }
+  if (strcmp("false", enable_thread_cache) == 0) {
+    return false;
+  } else if (strcmp("true", enable_thread_cache) == 0) {
+    return true;
+  }
+
+  LOG(ERROR)
+      << "The TF_GPU_BFC_ALLOCATOR_THREAD_CACHE environment variable is set but"
+      << " could not be parsed: \"" << enable_thread_cache << "\"."
+      << " Valid values are \"true\" or \"false\"."
+      << " Using the default value \"false\".";
+  return false;
+}
+
 GPUBFCAllocator::GPUBFCAllocator(GPUMemAllocator* sub_allocator,
                                  size_t total_memory, const string& name)
     : GPUBFCAllocator(sub_allocator, total_memory, GPUOptions(), name) {}
@@ -83,6 +104,7 @@ GPUBFCAllocator::GPUBFCAllocator(GPUMemAllocator* sub_allocator,
                                  const string& name)
     : BFCAllocator(sub_allocator, total_memory,
                    GPUBFCAllocator::GetAllowGrowthValue(gpu_options), name,
-                   GPUBFCAllocator::GetGarbageCollectionValue()) {}
+                   GPUBFCAllocator::GetGarbageCollectionValue(),
+                   GPUBFCAllocator::GetThreadCacheValue()) {}
 
 }  // namespace tensorflow
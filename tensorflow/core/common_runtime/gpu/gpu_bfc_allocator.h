@@ -44,6 +44,7 @@ class GPUBFCAllocator : public BFCAllocator {
  private:
   static bool GetAllowGrowthValue(const GPUOptions& gpu_options);
   static bool GetGarbageCollectionValue();
+  static bool GetThreadCacheValue();
 };
 
 }  // namespace tensorflow
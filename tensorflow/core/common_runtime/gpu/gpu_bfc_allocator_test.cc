@@ -25,6 +25,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/gpu/gpu_id_utils.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_init.h"
 #include "tensorflow/core/framework/typed_allocator.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
 #include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/lib/random/simple_philox.h"
@@ -217,6 +218,167 @@ TEST(GPUBFCAllocatorTest, AllocatedVsRequested) {
   a.DeallocateRaw(t1);
 }
 
+TEST(GPUBFCAllocatorTest, ThreadCacheReusesBuffersOfTheSameSize) {
+  PlatformGpuId platform_gpu_id(0);
+  GPUMemAllocator* sub_allocator = new GPUMemAllocator(
+      GpuIdUtil::ExecutorForPlatformGpuId(platform_gpu_id).ValueOrDie(),
+      platform_gpu_id, false /*use_unified_memory*/, {}, {});
+  BFCAllocator a(sub_allocator, 1 << 30, /*allow_growth=*/false, "GPU_0_bfc",
+                 /*garbage_collection=*/false, /*thread_cache=*/true);
+
+  void* p1 = a.AllocateRaw(1, 1000);
+  a.DeallocateRaw(p1);
+  void* p2 = a.AllocateRaw(1, 1000);
+  EXPECT_EQ(p1, p2);
+  EXPECT_EQ(1000, a.RequestedSize(p2));
+  EXPECT_EQ(1024, a.AllocatedSize(p2));
+  CheckStats(&a, 2, 1024, 1024, 1024);
+
+  // A request of a different size is not served from the cache.
+  void* p3 = a.AllocateRaw(1, 2000);
+  EXPECT_NE(p2, p3);
+  a.DeallocateRaw(p2);
+  a.DeallocateRaw(p3);
+  CheckStats(&a, 3, 0, 3072, 2048);
+
+  absl::optional<AllocatorStats> stats = a.GetStats();
+  ASSERT_TRUE(stats);
+  EXPECT_EQ(1, stats->num_thread_cache_hits);
+  EXPECT_EQ(2, stats->num_thread_cache_misses);
+}
+
+TEST(GPUBFCAllocatorTest, ThreadCacheIsFlushedWhenOutOfMemory) {
+  PlatformGpuId platform_gpu_id(0);
+  GPUMemAllocator* sub_allocator = new GPUMemAllocator(
+      GpuIdUtil::ExecutorForPlatformGpuId(platform_gpu_id).ValueOrDie(),
+      platform_gpu_id, false /*use_unified_memory*/, {}, {});
+  // Configure a 1MiB byte limit, and fill it with cacheable buffers.
+  BFCAllocator a(sub_allocator, 1 << 20, /*allow_growth=*/false, "GPU_0_bfc",
+                 /*garbage_collection=*/false, /*thread_cache=*/true);
+  std::vector<void*> ptrs;
+  for (int i = 0; i < 32; ++i) {
+    ptrs.push_back(a.AllocateRaw(1, 32 << 10));
+    ASSERT_NE(nullptr, ptrs.back());
+  }
+  for (void* ptr : ptrs) {
+    a.DeallocateRaw(ptr);
+  }
+  CheckStats(&a, 32, 0, 1 << 20, 32 << 10);
+
+  // The cached buffers must be coalesced to satisfy a larger request.
+  void* large = a.AllocateRaw(1, 1 << 20);
+  EXPECT_NE(nullptr, large);
+  a.DeallocateRaw(large);
+}
+
+TEST(GPUBFCAllocatorTest, ThreadCacheReleasesBuffersInBatches) {
+  PlatformGpuId platform_gpu_id(0);
+  GPUMemAllocator* sub_allocator = new GPUMemAllocator(
+      GpuIdUtil::ExecutorForPlatformGpuId(platform_gpu_id).ValueOrDie(),
+      platform_gpu_id, false /*use_unified_memory*/, {}, {});
+  BFCAllocator a(sub_allocator, 1 << 30, /*allow_growth=*/false, "GPU_0_bfc",
+                 /*garbage_collection=*/false, /*thread_cache=*/true);
+  // Free more than a thread cache can hold.
+  std::vector<void*> ptrs;
+  for (int i = 0; i < 64; ++i) {
+    ptrs.push_back(a.AllocateRaw(1, 32 << 10));
+  }
+  for (void* ptr : ptrs) {
+    a.DeallocateRaw(ptr);
+  }
+  CheckStats(&a, 64, 0, 64 << 15, 32 << 10);
+
+  // Only the buffers that are still cached are reused.
+  std::vector<void*> new_ptrs;
+  for (int i = 0; i < 64; ++i) {
+    new_ptrs.push_back(a.AllocateRaw(1, 32 << 10));
+  }
+  absl::optional<AllocatorStats> stats = a.GetStats();
+  ASSERT_TRUE(stats);
+  EXPECT_GT(stats->num_thread_cache_hits, 0);
+  EXPECT_LE(stats->num_thread_cache_hits, 32);
+  EXPECT_EQ(128, stats->num_thread_cache_hits + stats->num_thread_cache_misses);
+  EXPECT_EQ(128, stats->num_allocs);
+  EXPECT_EQ(64 << 15, stats->bytes_in_use);
+  for (void* ptr : new_ptrs) {
+    a.DeallocateRaw(ptr);
+  }
+}
+
+TEST(GPUBFCAllocatorTest, ReportsFragmentation) {
+  PlatformGpuId platform_gpu_id(0);
+  GPUMemAllocator* sub_allocator = new GPUMemAllocator(
+      GpuIdUtil::ExecutorForPlatformGpuId(platform_gpu_id).ValueOrDie(),
+      platform_gpu_id, false /*use_unified_memory*/, {}, {});
+  GPUBFCAllocator a(sub_allocator, 1 << 20, "GPU_0_bfc");
+
+  // Fill the region, then free every other buffer.
+  std::vector<void*> ptrs;
+  for (int i = 0; i < 16; ++i) {
+    ptrs.push_back(a.AllocateRaw(1, 64 << 10));
+    ASSERT_NE(nullptr, ptrs.back());
+  }
+  absl::optional<AllocatorStats> stats = a.GetStats();
+  ASSERT_TRUE(stats);
+  EXPECT_EQ(0, stats->largest_free_block_bytes);
+  EXPECT_EQ(0, stats->fragmentation);
+
+  for (int i = 0; i < 16; i += 2) {
+    a.DeallocateRaw(ptrs[i]);
+  }
+  stats = a.GetStats();
+  EXPECT_EQ(64 << 10, stats->largest_free_block_bytes);
+  EXPECT_DOUBLE_EQ(7.0 / 8.0, stats->fragmentation);
+
+  for (int i = 1; i < 16; i += 2) {
+    a.DeallocateRaw(ptrs[i]);
+  }
+  stats = a.GetStats();
+  EXPECT_EQ(1 << 20, stats->largest_free_block_bytes);
+  EXPECT_EQ(0, stats->fragmentation);
+}
+
+TEST(GPUBFCAllocatorTest, MemoryDumpAttributesChunksToOps) {
+  PlatformGpuId platform_gpu_id(0);
+  GPUMemAllocator* sub_allocator = new GPUMemAllocator(
+      GpuIdUtil::ExecutorForPlatformGpuId(platform_gpu_id).ValueOrDie(),
+      platform_gpu_id, false /*use_unified_memory*/, {}, {});
+  GPUBFCAllocator a(sub_allocator, 1 << 30, "GPU_0_bfc");
+
+  void* conv;
+  void* relu;
+  {
+    ScopedMemoryDebugAnnotation annotation("conv", 7);
+    conv = a.AllocateRaw(1, 4096);
+  }
+  {
+    ScopedMemoryDebugAnnotation annotation("relu", 8);
+    relu = a.AllocateRaw(1, 1024);
+  }
+  a.DeallocateRaw(relu);
+
+  MemoryDump md = a.RecordMemoryMap();
+  int num_in_use = 0;
+  for (const MemChunk& chunk : md.chunk()) {
+    if (!chunk.in_use()) continue;
+    ++num_in_use;
+    EXPECT_EQ(reinterpret_cast<uint64>(conv), chunk.address());
+    EXPECT_EQ("conv", chunk.op_name());
+    EXPECT_EQ(7, chunk.step_id());
+    EXPECT_GT(chunk.alloc_micros(), 0);
+  }
+  EXPECT_EQ(1, num_in_use);
+
+  // The size history has the bytes in use after each of the three actions.
+  ASSERT_EQ(3, md.snap_shot_size());
+  EXPECT_EQ(1, md.snap_shot(0).action_count());
+  EXPECT_EQ(a.AllocatedSize(conv), md.snap_shot(0).size());
+  EXPECT_EQ(3, md.snap_shot(2).action_count());
+  EXPECT_EQ(a.AllocatedSize(conv), md.snap_shot(2).size());
+  EXPECT_GT(md.snap_shot(1).size(), md.snap_shot(0).size());
+  a.DeallocateRaw(conv);
+}
+
 TEST(GPUBFCAllocatorTest, TestCustomMemoryLimit) {
   PlatformGpuId platform_gpu_id(0);
   GPUMemAllocator* sub_allocator = new GPUMemAllocator(
@@ -377,6 +539,34 @@ static void BM_AllocationThreaded(int iters, int num_threads) {
 }
 BENCHMARK(BM_AllocationThreaded)->Arg(1)->Arg(4)->Arg(16);
 
+static void BM_AllocationThreadedWithThreadCache(int iters, int num_threads) {
+  PlatformGpuId platform_gpu_id(0);
+  GPUMemAllocator* sub_allocator = new GPUMemAllocator(
+      GpuIdUtil::ExecutorForPlatformGpuId(platform_gpu_id).ValueOrDie(),
+      platform_gpu_id, false /*use_unified_memory*/, {}, {});
+  BFCAllocator a(sub_allocator, 1uLL << 33, /*allow_growth=*/false,
+                 "GPU_0_bfc", /*garbage_collection=*/false,
+                 /*thread_cache=*/true);
+  thread::ThreadPool pool(Env::Default(), "test", num_threads);
+  BlockingCounter done(num_threads);
+  const int iters_per_thread = std::max(iters / num_threads, 1);
+  for (int t = 0; t < num_threads; t++) {
+    pool.Schedule([&a, &done, iters_per_thread]() {
+      // Exercise a few small allocation sizes, which are cacheable.
+      std::vector<int> sizes = {256, 4096, 16384, 512, 1024, 32768};
+      int size_index = 0;
+      for (int i = 0; i < iters_per_thread; i++) {
+        int bytes = sizes[size_index++ % sizes.size()];
+        void* p = a.AllocateRaw(1, bytes);
+        a.DeallocateRaw(p);
+      }
+      done.DecrementCount();
+    });
+  }
+  done.Wait();
+}
+BENCHMARK(BM_AllocationThreadedWithThreadCache)->Arg(1)->Arg(4)->Arg(16);
+
 // A more complex benchmark that defers deallocation of an object for
 // "delay" allocations.
 static void BM_AllocationDelayed(int iters, int delay) {
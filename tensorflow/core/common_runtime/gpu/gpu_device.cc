@@ -41,6 +41,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/gpu/gpu_id_manager.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_id_utils.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_init.h"
+#include "tensorflow/core/common_runtime/gpu/gpu_managed_allocator.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_process_state.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_util.h"
 #include "tensorflow/core/common_runtime/gpu_device_context.h"
@@ -449,6 +450,10 @@ Status BaseGPUDevice::Init(const SessionOptions& options) {
       options.config.gpu_options().experimental().kernel_tracker_max_pending());
   timestamped_allocator_ =
       options.config.gpu_options().experimental().timestamped_allocator();
+  prefetch_unified_memory_ =
+      options.config.gpu_options().experimental().prefetch_unified_memory() &&
+      (options.config.gpu_options().per_process_gpu_memory_fraction() > 1.0 ||
+       options.config.gpu_options().experimental().use_unified_memory());
   pending_cap_ = tracker_params.max_pending;
   if (timestamped_allocator_ ||
       (tracker_params.max_interval > 0 || tracker_params.max_bytes > 0 ||
@@ -563,6 +568,7 @@ void BaseGPUDevice::Compute(OpKernel* op_kernel, OpKernelContext* context) {
     }
   }
   ScopedActivateExecutorContext scoped_activation{stream->parent()};
+  if (prefetch_unified_memory_) PrefetchInputs(context, stream);
   ScopedMemoryDebugAnnotation op_annotation(op_kernel->name_view().data(),
                                             context->step_id());
   op_kernel->Compute(context);
@@ -619,9 +625,25 @@ void BaseGPUDevice::ComputeAsync(AsyncOpKernel* op_kernel,
           << stream_id << "]";
 
   ScopedActivateExecutorContext scoped_activation{stream->parent()};
+  if (prefetch_unified_memory_) PrefetchInputs(context, stream);
   op_kernel->ComputeAsync(context, std::move(done));
 }
 
+void BaseGPUDevice::PrefetchInputs(OpKernelContext* context,
+                                   se::Stream* stream) {
+  const PlatformGpuId platform_gpu_id(gpu_device_info_->gpu_id);
+  for (int i = 0; i < context->num_inputs(); ++i) {
+    if (context->input_is_ref(i) ||
+        context->input_memory_type(i) == HOST_MEMORY) {
+      continue;
+    }
+    const Tensor& input = context->input(i);
+    if (!DMAHelper::CanUseDMA(&input) || input.TotalBytes() == 0) continue;
+    GpuManagedAllocator::Prefetch(DMAHelper::base(&input), input.TotalBytes(),
+                                  platform_gpu_id, stream);
+  }
+}
+
 Status BaseGPUDevice::MaybeCopyTensorToGPU(
     const AllocatorAttributes& alloc_attrs, const Tensor& from, Tensor* to,
     StatusCallback done) {
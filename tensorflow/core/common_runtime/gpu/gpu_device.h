@@ -153,6 +153,9 @@ class BaseGPUDevice : public LocalDevice {
   std::unique_ptr<GPUKernelTracker> kernel_tracker_;
   int32 pending_cap_ = 0;
   bool timestamped_allocator_ = false;
+  // If true, the inputs of each kernel are prefetched to this GPU from
+  // unified memory before the kernel is launched.
+  bool prefetch_unified_memory_ = false;
 
   // Initialize scratch buffers used by Eigen.
   Status InitScratchBuffers();
@@ -163,6 +166,10 @@ class BaseGPUDevice : public LocalDevice {
   std::string ComputeOpKernelDebugString(const OpKernel& op_kernel,
                                          const int& stream_id);
 
+  // Prefetches the GPU inputs of the kernel of `context` to this GPU, on the
+  // stream it runs on.
+  void PrefetchInputs(OpKernelContext* context, se::Stream* stream);
+
   // This method returns an initialization status, in addition to
   // calling the "done" StatusCallback, if there is a failure to
   // allocate memory or if the tensor "from" is not DMA-copyable.
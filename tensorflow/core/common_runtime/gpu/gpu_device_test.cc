@@ -19,6 +19,7 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/gpu/gpu_id_utils.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_init.h"
+#include "tensorflow/core/common_runtime/gpu/gpu_managed_allocator.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_process_state.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
@@ -421,6 +422,45 @@ TEST_F(GPUDeviceTest, UnifiedMemoryAllocation) {
   allocator->DeallocateRaw(ptr);
 }
 
+TEST_F(GPUDeviceTest, ManagedAllocatorPrefetchesToDevice) {
+  static constexpr PlatformGpuId kPlatformGpuId(0);
+
+  int cc_major, cc_minor;
+  TF_ASSERT_OK(GetComputeCapability(kPlatformGpuId, &cc_major, &cc_minor));
+  // Exit early if running on pre-Pascal GPUs.
+  if (cc_major < 6) {
+    LOG(INFO) << "Prefetching unified memory is not supported with "
+                 "pre-Pascal GPUs.";
+    return;
+  }
+
+  SessionOptions opts = MakeSessionOptions("0");
+  std::vector<std::unique_ptr<Device>> devices;
+  TF_ASSERT_OK(DeviceFactory::GetFactory("GPU")->CreateDevices(
+      opts, kDeviceNamePrefix, &devices));
+  se::Stream* stream = devices[0]->tensorflow_gpu_device_info()->stream;
+
+  GpuManagedAllocator allocator(kPlatformGpuId);
+  void* ptr = allocator.AllocateRaw(Allocator::kAllocatorAlignment, 1 << 20);
+  ASSERT_NE(ptr, nullptr);
+  absl::optional<AllocatorStats> stats = allocator.GetStats();
+  ASSERT_TRUE(stats);
+  EXPECT_EQ(1, stats->num_allocs);
+  EXPECT_EQ(1 << 20, stats->bytes_in_use);
+
+  const GpuManagedAllocator::PrefetchStats before =
+      GpuManagedAllocator::GetPrefetchStats();
+  GpuManagedAllocator::Prefetch(ptr, 1 << 20, kPlatformGpuId, stream);
+  TF_ASSERT_OK(stream->BlockHostUntilDone());
+  const GpuManagedAllocator::PrefetchStats after =
+      GpuManagedAllocator::GetPrefetchStats();
+  EXPECT_EQ(before.num_prefetches + 1, after.num_prefetches);
+  EXPECT_EQ(before.bytes_prefetched + (1 << 20), after.bytes_prefetched);
+
+  allocator.DeallocateRaw(ptr);
+  EXPECT_EQ(0, allocator.GetStats()->bytes_in_use);
+}
+
 TEST_F(GPUDeviceTest, CopyTensorInSameDevice) {
   SessionOptions opts = MakeSessionOptions("0");
   std::vector<std::unique_ptr<Device>> devices;
@@ -25,8 +25,30 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/gpu/gpu_managed_allocator.h"
 
+#include <atomic>
+
+#include "tensorflow/core/platform/logging.h"
+
 namespace tensorflow {
 
+namespace {
+
+std::atomic<int64> num_prefetches{0};
+std::atomic<int64> bytes_prefetched{0};
+
+#if GOOGLE_CUDA
+CUdevice GetDevice(PlatformGpuId platform_gpu_id) {
+  CUdevice device;
+  CHECK_EQ(cuDeviceGet(&device, platform_gpu_id.value()), CUDA_SUCCESS);
+  return device;
+}
+#endif
+
+}  // namespace
+
+GpuManagedAllocator::GpuManagedAllocator(PlatformGpuId platform_gpu_id)
+    : device_ordinal_(platform_gpu_id.value()) {}
+
 void* GpuManagedAllocator::AllocateRaw(size_t alignment, size_t num_bytes) {
   void* ptr = nullptr;
 #if GOOGLE_CUDA
@@ -34,16 +56,43 @@ void* GpuManagedAllocator::AllocateRaw(size_t alignment, size_t num_bytes) {
   CHECK_EQ(cuMemAllocManaged(&result, num_bytes, CU_MEM_ATTACH_GLOBAL),
            CUDA_SUCCESS);
   ptr = reinterpret_cast<void*>(result);
+  if (device_ordinal_ >= 0) {
+    const PlatformGpuId platform_gpu_id(device_ordinal_);
+    AdviseDevice(ptr, num_bytes, platform_gpu_id);
+    // The allocator does not know which stream will use the memory. The
+    // prefetch is only a hint, so the default stream does.
+    CUresult status = cuMemPrefetchAsync(result, num_bytes,
+                                         GetDevice(platform_gpu_id), nullptr);
+    if (status != CUDA_SUCCESS) {
+      VLOG(1) << "cuMemPrefetchAsync failed: " << status;
+    }
+  }
 #elif TENSORFLOW_USE_ROCM
   void** result = 0;
   CHECK_EQ(hipHostMalloc(&result, num_bytes, 0), 0);
   ptr = reinterpret_cast<void*>(result);
 #endif
   CHECK(!(reinterpret_cast<uintptr_t>(ptr) & (alignment - 1)));
+  mutex_lock l(mu_);
+  sizes_[ptr] = num_bytes;
+  ++stats_.num_allocs;
+  stats_.bytes_in_use += num_bytes;
+  stats_.peak_bytes_in_use =
+      std::max(stats_.peak_bytes_in_use, stats_.bytes_in_use);
+  stats_.largest_alloc_size =
+      std::max<int64>(stats_.largest_alloc_size, num_bytes);
   return ptr;
 }
 
 void GpuManagedAllocator::DeallocateRaw(void* ptr) {
+  {
+    mutex_lock l(mu_);
+    auto it = sizes_.find(ptr);
+    if (it != sizes_.end()) {
+      stats_.bytes_in_use -= it->second;
+      sizes_.erase(it);
+    }
+  }
 #if GOOGLE_CUDA
   CHECK_EQ(cudaFree(ptr), cudaSuccess);
 #elif TENSORFLOW_USE_ROCM
@@ -51,4 +100,49 @@ void GpuManagedAllocator::DeallocateRaw(void* ptr) {
 #endif
 }
 
+absl::optional<AllocatorStats> GpuManagedAllocator::GetStats() {
+  mutex_lock l(mu_);
+  return stats_;
+}
+
+void GpuManagedAllocator::AdviseDevice(void* ptr, size_t num_bytes,
+                                       PlatformGpuId platform_gpu_id) {
+#if GOOGLE_CUDA
+  const CUdeviceptr device_ptr = reinterpret_cast<CUdeviceptr>(ptr);
+  const CUdevice device = GetDevice(platform_gpu_id);
+  for (CUmem_advise advice : {CU_MEM_ADVISE_SET_PREFERRED_LOCATION,
+                              CU_MEM_ADVISE_SET_ACCESSED_BY}) {
+    CUresult status = cuMemAdvise(device_ptr, num_bytes, advice, device);
+    if (status != CUDA_SUCCESS) {
+      VLOG(1) << "cuMemAdvise(" << advice << ") failed: " << status;
+    }
+  }
+#endif
+}
+
+void GpuManagedAllocator::Prefetch(const void* ptr, size_t num_bytes,
+                                   PlatformGpuId platform_gpu_id,
+                                   se::Stream* stream) {
+#if GOOGLE_CUDA
+  const CUstream cu_stream = *reinterpret_cast<const CUstream*>(
+      stream->implementation()->GpuStreamMemberHack());
+  CUresult status =
+      cuMemPrefetchAsync(reinterpret_cast<CUdeviceptr>(ptr), num_bytes,
+                         GetDevice(platform_gpu_id), cu_stream);
+  if (status != CUDA_SUCCESS) {
+    VLOG(1) << "cuMemPrefetchAsync failed: " << status;
+    return;
+  }
+  num_prefetches.fetch_add(1, std::memory_order_relaxed);
+  bytes_prefetched.fetch_add(num_bytes, std::memory_order_relaxed);
+#endif
+}
+
+GpuManagedAllocator::PrefetchStats GpuManagedAllocator::GetPrefetchStats() {
+  PrefetchStats stats;
+  stats.num_prefetches = num_prefetches.load(std::memory_order_relaxed);
+  stats.bytes_prefetched = bytes_prefetched.load(std::memory_order_relaxed);
+  return stats;
+}
+
 }  // namespace tensorflow
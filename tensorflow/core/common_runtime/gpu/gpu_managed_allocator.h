@@ -16,19 +16,66 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_COMMON_RUNTIME_GPU_GPU_MANAGED_ALLOCATOR_H_
 #define TENSORFLOW_CORE_COMMON_RUNTIME_GPU_GPU_MANAGED_ALLOCATOR_H_
 
+#include "absl/container/flat_hash_map.h"
+#include "tensorflow/core/common_runtime/gpu/gpu_id.h"
 #include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/stream_executor.h"
+#include "tensorflow/core/platform/thread_annotations.h"
 
 namespace tensorflow {
 
 // An allocator for CUDA unified memory. Memory allocated with this allocator
 // can be accessed from both host and device. CUDA transparently migrates dirty
-// pages, which can be slow. Therefore, this allocator is intended for
+// pages, which can be slow. Therefore, the default allocator is intended for
 // convenience in functional tests only.
+//
+// An allocator constructed for a GPU instead hints the driver to keep its
+// memory on that GPU, and prefetches each allocation there. The memory may
+// then exceed the memory of the GPU, with the least recently used pages
+// evicted to host memory; callers prefetch them back with Prefetch() on the
+// stream that will use them next, so that they migrate in bulk ahead of the
+// kernels that use them rather than page by page on faults.
 class GpuManagedAllocator : public Allocator {
  public:
+  GpuManagedAllocator() {}
+  explicit GpuManagedAllocator(PlatformGpuId platform_gpu_id);
+
   string Name() override { return "GpuManagedAllocator"; }
   void* AllocateRaw(size_t alignment, size_t num_bytes) override;
   void DeallocateRaw(void* ptr) override;
+  absl::optional<AllocatorStats> GetStats() override;
+
+  // Advises the driver that the unified memory [ptr, ptr + num_bytes) should
+  // preferably reside on `platform_gpu_id`, and that it stays mapped for the
+  // GPU when it is evicted to host memory.
+  static void AdviseDevice(void* ptr, size_t num_bytes,
+                           PlatformGpuId platform_gpu_id);
+
+  // Starts migrating the unified memory [ptr, ptr + num_bytes) to
+  // `platform_gpu_id`, ordered on `stream`. Pages that already reside on the
+  // GPU are not copied.
+  static void Prefetch(const void* ptr, size_t num_bytes,
+                       PlatformGpuId platform_gpu_id, se::Stream* stream);
+
+  // The number of prefetches issued by Prefetch() in this process, and the
+  // bytes they covered. The page faults and migrations that happen anyway
+  // are reported by the profiler's unified memory counters.
+  struct PrefetchStats {
+    int64 num_prefetches = 0;
+    int64 bytes_prefetched = 0;
+  };
+  static PrefetchStats GetPrefetchStats();
+
+ private:
+  // -1 for the default allocator, which gives no hints.
+  const int device_ordinal_ = -1;
+
+  mutex mu_;
+  absl::flat_hash_map<void*, size_t> sizes_ TF_GUARDED_BY(mu_);
+  AllocatorStats stats_ TF_GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(GpuManagedAllocator);
 };
 
 }  // namespace tensorflow
@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/gpu/gpu_process_state.h"
 
+#include <algorithm>
 #include <cstring>
 #include <vector>
 
@@ -26,8 +27,11 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/gpu/gpu_id_manager.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_id_utils.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_init.h"
+#include "tensorflow/core/common_runtime/gpu/gpu_managed_allocator.h"
 #include "tensorflow/core/common_runtime/pool_allocator.h"
+#include "tensorflow/core/common_runtime/replay_allocator.h"
 #include "tensorflow/core/common_runtime/shared_counter.h"
+#include "tensorflow/core/common_runtime/size_class_allocator.h"
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/log_memory.h"
 #include "tensorflow/core/framework/tracking_allocator.h"
@@ -105,12 +109,20 @@ Allocator* GPUProcessState::GetGPUAllocator(const GPUOptions& options,
     while (bus_id >= gpu_visitors_.size()) {
       gpu_visitors_.push_back({});
     }
+    const bool use_unified_memory =
+        options.per_process_gpu_memory_fraction() > 1.0 ||
+        options.experimental().use_unified_memory();
+    std::vector<SubAllocator::Visitor> alloc_visitors = gpu_visitors_[bus_id];
+    if (use_unified_memory &&
+        options.experimental().prefetch_unified_memory()) {
+      alloc_visitors.push_back(
+          [platform_gpu_id](void* ptr, int index, size_t num_bytes) {
+            GpuManagedAllocator::AdviseDevice(ptr, num_bytes, platform_gpu_id);
+          });
+    }
     GPUMemAllocator* sub_allocator = new GPUMemAllocator(
         GpuIdUtil::ExecutorForPlatformGpuId(platform_gpu_id).ValueOrDie(),
-        platform_gpu_id,
-        (options.per_process_gpu_memory_fraction() > 1.0 ||
-         options.experimental().use_unified_memory()),
-        gpu_visitors_[bus_id], {});
+        platform_gpu_id, use_unified_memory, alloc_visitors, {});
     GPUBFCAllocator* gpu_bfc_allocator =
         new GPUBFCAllocator(sub_allocator, total_bytes, options,
                             strings::StrCat("GPU_", tf_gpu_id.value(), "_bfc"));
@@ -121,6 +133,10 @@ Allocator* GPUProcessState::GetGPUAllocator(const GPUOptions& options,
       gpu_bfc_allocator->SetTimingCounter(timing_counter);
     }
 
+    if (options.experimental().plan_memory_from_previous_steps()) {
+      gpu_allocator = new ReplayAllocator(gpu_allocator);
+    }
+
     // If true, checks for memory overwrites by writing
     // distinctive patterns on both ends of allocated memory.
     if (useCudaMemoryGuardAllocator()) {
@@ -251,9 +267,30 @@ Allocator* GPUProcessState::GetGpuHostAllocator(int numa_node) {
     }
     int64 gpu_host_mem_limit = gpu_host_mem_limit_in_mb * (1LL << 20);
 
-    Allocator* allocator =
-        new BFCAllocator(sub_allocator, gpu_host_mem_limit,
-                         true /*allow_growth*/, "gpu_host_bfc" /*name*/);
+    // If enabled, serve pinned host memory from size-class free lists
+    // instead, optionally out of a pool reserved up front.
+    bool use_size_classes = false;
+    status = ReadBoolFromEnvVar("TF_GPU_HOST_ALLOCATOR_USE_SIZE_CLASSES",
+                                false, &use_size_classes);
+    if (!status.ok()) {
+      LOG(ERROR) << "GetGpuHostAllocator: " << status.error_message();
+    }
+    Allocator* allocator = nullptr;
+    if (use_size_classes) {
+      int64 gpu_host_mem_reserve_in_mb = 0;
+      status = ReadInt64FromEnvVar("TF_GPU_HOST_MEM_RESERVE_IN_MB", 0,
+                                   &gpu_host_mem_reserve_in_mb);
+      if (!status.ok()) {
+        LOG(ERROR) << "GetGpuHostAllocator: " << status.error_message();
+      }
+      allocator = new SizeClassAllocator(
+          sub_allocator, std::max<int64>(gpu_host_mem_reserve_in_mb, 0) << 20,
+          gpu_host_mem_limit, "gpu_host_size_class" /*name*/);
+    } else {
+      allocator =
+          new BFCAllocator(sub_allocator, gpu_host_mem_limit,
+                           true /*allow_growth*/, "gpu_host_bfc" /*name*/);
+    }
 
     if (LogMemory::IsEnabled() && !allocator->TracksAllocationSizes()) {
       // Wrap the allocator to track allocation ids for better logging
@@ -46,6 +46,8 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/threadpool.h"
 #include "tensorflow/core/public/version.h"
 
 namespace tensorflow {
@@ -96,7 +98,8 @@ class GraphConstructor {
           importing(false),
           validate_nodes(in.validate_nodes),
           validate_colocation_constraints(false),
-          add_default_attributes(in.add_default_attributes) {}
+          add_default_attributes(in.add_default_attributes),
+          thread_pool(in.thread_pool) {}
     Options(const ImportGraphDefOptions& in)  // NOLINT(runtime/explicit)
         : allow_internal_ops(false),
           expect_device_spec(false),
@@ -149,6 +152,10 @@ class GraphConstructor {
     bool add_default_attributes = true;
 
     string default_device;
+
+    // If non-null, NodeDefs are prepared for conversion in parallel on this
+    // pool. Only used when `importing` is false.
+    thread::ThreadPool* thread_pool = nullptr;
   };
 
   typedef gtl::ArraySlice<const NodeDef*> NodeDefSlice;
@@ -208,6 +215,8 @@ class GraphConstructor {
   Status ValidateInputMapAndControlDependencies();
   Status BuildNodeIndex();
   Status InitFromEdges();
+  Status PrepareNodeDefsInParallel();
+  Status PrepareNodeDef(NodeDef* node_def);
   Status Convert();
   Status AddBackEdges();
   Status UpdateVersionDef();
@@ -282,6 +291,10 @@ class GraphConstructor {
   // possible. After calling this method, the result of get_node_def(i) is
   // undefined.
   virtual NodeDef consume_node_def(int i) = 0;
+  // Returns a mutable pointer to the i^th node in the graph, or nullptr if the
+  // input nodes cannot be modified in place. Must not be called after
+  // consume_node_def(i).
+  virtual NodeDef* mutable_node_def(int i) = 0;
   // Returns the version information for the graph, or nullptr if none is
   // available.
   virtual const VersionDef* versions() const = 0;
@@ -315,6 +328,10 @@ class GraphConstructor {
   // Intermediate datastructure used to track the destinations of back edges.
   absl::flat_hash_set<int> merge_node_indices_;
 
+  // True if PrepareNodeDefsInParallel() has already added default attributes
+  // to and validated every NodeDef.
+  bool node_defs_prepared_ = false;
+
   // Mapping from node name to the index within node_defs_.
   struct NodeInfo {
     explicit NodeInfo(int i) : gdef_index(i), node(nullptr) {}
@@ -415,6 +432,7 @@ class NodeDefCopyingGraphConstructor : public GraphConstructor {
   size_t node_def_count() const override { return node_defs_.size(); }
   const NodeDef& get_node_def(int i) const override { return *node_defs_[i]; }
   NodeDef consume_node_def(int i) override { return *node_defs_[i]; }
+  NodeDef* mutable_node_def(int i) override { return nullptr; }
   const VersionDef* versions() const override { return versions_; }
   const FunctionDefLibrary* library() const override { return library_; }
 
@@ -449,6 +467,11 @@ class NodeDefMovingGraphConstructor : public GraphConstructor {
     is_consumed_[i] = true;
     return std::move(*graph_def_.mutable_node(i));
   }
+  NodeDef* mutable_node_def(int i) override {
+    CHECK(!is_consumed_[i])
+        << "NodeDef " << i << " accessed after it was consumed.";
+    return graph_def_.mutable_node(i);
+  }
   const VersionDef* versions() const override { return &graph_def_.versions(); }
   const FunctionDefLibrary* library() const override {
     return &graph_def_.library();
@@ -1104,6 +1127,49 @@ void GraphConstructor::PrintCycles() {
   }
 }
 
+Status GraphConstructor::PrepareNodeDef(NodeDef* node_def) {
+  const OpDef* op_def;
+  TF_RETURN_IF_ERROR(g_->op_registry()->LookUpOpDef(node_def->op(), &op_def));
+  if (opts_.add_default_attributes) {
+    AddDefaultsToNodeDef(*op_def, node_def);
+  }
+  if (opts_.validate_nodes) {
+    TF_RETURN_IF_ERROR(ValidateNodeDef(*node_def, *op_def));
+  }
+  return Status::OK();
+}
+
+Status GraphConstructor::PrepareNodeDefsInParallel() {
+  const int64 num_nodes = node_def_count();
+  if (num_nodes == 0 || mutable_node_def(0) == nullptr) return Status::OK();
+
+  // To match the sequential conversion as closely as possible, report the
+  // error for the first invalid node in GraphDef order.
+  mutex mu;
+  int64 first_error_index = num_nodes;
+  Status first_error;
+  // Looking up an OpDef and validating a NodeDef costs on the order of a few
+  // microseconds.
+  const int64 kCostPerNode = 10000;
+  opts_.thread_pool->ParallelFor(
+      num_nodes, kCostPerNode, [&](int64 start, int64 limit) {
+        for (int64 i = start; i < limit; ++i) {
+          Status s = PrepareNodeDef(mutable_node_def(i));
+          if (!s.ok()) {
+            mutex_lock l(mu);
+            if (i < first_error_index) {
+              first_error_index = i;
+              first_error = s;
+            }
+            return;
+          }
+        }
+      });
+  TF_RETURN_IF_ERROR(first_error);
+  node_defs_prepared_ = true;
+  return Status::OK();
+}
+
 Status GraphConstructor::Convert() {
   // Import functions before adding nodes, since imported nodes may refer to
   // functions
@@ -1113,6 +1179,10 @@ Status GraphConstructor::Convert() {
     TF_RETURN_IF_ERROR(g_->AddFunctionLibrary(*library()));
   }
 
+  if (opts_.thread_pool != nullptr && !opts_.importing) {
+    TF_RETURN_IF_ERROR(PrepareNodeDefsInParallel());
+  }
+
   std::vector<InputInfo> inputs;
   int processed = 0;
 
@@ -1230,16 +1300,8 @@ Status GraphConstructor::Convert() {
 
     if (opts_.importing) {
       TF_RETURN_IF_ERROR(ModifyNodeDefForImport(&node_def));
-    } else {
-      const OpDef* op_def;
-      TF_RETURN_IF_ERROR(
-          g_->op_registry()->LookUpOpDef(node_def.op(), &op_def));
-      if (opts_.add_default_attributes) {
-        AddDefaultsToNodeDef(*op_def, &node_def);
-      }
-      if (opts_.validate_nodes) {
-        TF_RETURN_IF_ERROR(ValidateNodeDef(node_def, *op_def));
-      }
+    } else if (!node_defs_prepared_) {
+      TF_RETURN_IF_ERROR(PrepareNodeDef(&node_def));
     }
 
     TF_RETURN_IF_ERROR(MakeNode(std::move(node_def), &node));
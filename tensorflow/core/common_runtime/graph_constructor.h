@@ -23,6 +23,9 @@ limitations under the License.
 
 namespace tensorflow {
 class ShapeRefiner;
+namespace thread {
+class ThreadPool;
+}  // namespace thread
 
 // Construct a Graph *g out of a GraphDef gdef. Returns non-OK on
 // error, in which case *g is left in an incomplete state.
@@ -52,6 +55,14 @@ struct GraphConstructorOptions {
   // If true, GraphConstructor will add attributes with their default
   // value to the Node when they are missing from the NodeDef.
   bool add_default_attributes = true;
+
+  // If non-null, the per-node work of looking up each node's OpDef, adding
+  // default attributes and validating the NodeDef is sharded over this pool
+  // before the nodes are added to the graph. Not owned.
+  //
+  // This only has an effect when the GraphDef is passed by rvalue reference,
+  // since the NodeDefs are modified in place.
+  thread::ThreadPool* thread_pool = nullptr;
 };
 extern Status ConvertGraphDefToGraph(const GraphConstructorOptions& opts,
                                      const GraphDef& gdef, Graph* g);
@@ -30,9 +30,12 @@ limitations under the License.
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/protobuf.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+#include "tensorflow/core/platform/threadpool.h"
 #include "tensorflow/core/public/session.h"
 #include "tensorflow/core/public/version.h"
 
@@ -914,6 +917,55 @@ TEST_F(GraphConstructorTest, SimpleModelWithControlEdges) {
   EXPECT_TRUE(HasControlEdge("t1", "t2"));
 }
 
+// Returns a GraphDef containing a TestInput node followed by a chain of
+// `num_nodes - 1` TestMul nodes.
+GraphDef MakeChainGraphDef(int num_nodes) {
+  GraphDef gdef;
+  NodeDef* input = gdef.add_node();
+  input->set_name("input");
+  input->set_op("TestInput");
+  string prev = input->name();
+  for (int i = 1; i < num_nodes; ++i) {
+    NodeDef* node = gdef.add_node();
+    node->set_name(strings::StrCat("mul", i));
+    node->set_op("TestMul");
+    node->add_input(prev);
+    node->add_input("input:1");
+    prev = node->name();
+  }
+  return gdef;
+}
+
+TEST_F(GraphConstructorTest, ConvertWithThreadPool) {
+  const GraphDef gdef = MakeChainGraphDef(1000);
+  GraphConstructorOptions opts;
+  opts.validate_nodes = true;
+  TF_ASSERT_OK(ConvertGraphDefToGraph(opts, GraphDef(gdef), &graph_));
+
+  thread::ThreadPool pool(Env::Default(), "test", 4);
+  opts.thread_pool = &pool;
+  Graph parallel_graph(OpRegistry::Global());
+  TF_ASSERT_OK(ConvertGraphDefToGraph(opts, GraphDef(gdef), &parallel_graph));
+  EXPECT_EQ(GraphDebugString(),
+            parallel_graph.ToGraphDefDebug().DebugString());
+}
+
+TEST_F(GraphConstructorTest, ConvertWithThreadPoolReportsFirstError) {
+  GraphDef gdef = MakeChainGraphDef(1000);
+  gdef.mutable_node(10)->set_op("FirstUnknownOp");
+  gdef.mutable_node(900)->set_op("SecondUnknownOp");
+  const string original_graph_description = GraphDebugString();
+
+  thread::ThreadPool pool(Env::Default(), "test", 4);
+  GraphConstructorOptions opts;
+  opts.thread_pool = &pool;
+  Status s = ConvertGraphDefToGraph(opts, std::move(gdef), &graph_);
+  EXPECT_FALSE(s.ok());
+  EXPECT_TRUE(s.error_message().find("FirstUnknownOp") != string::npos) << s;
+  EXPECT_TRUE(s.error_message().find("SecondUnknownOp") == string::npos) << s;
+  EXPECT_EQ(original_graph_description, GraphDebugString());
+}
+
 TEST_F(GraphConstructorTest, Error_ControlEdgeBeforeRealInput) {
   ExpectError(
       "node { name: 'W1' op: 'TestParams' }"
@@ -3258,5 +3310,33 @@ TEST_F(GraphConstructorTest, ImportGraphDef_UnknownOps) {
        "when the module is first accessed."});
 }
 
+void BM_ConvertGraphDefToGraph(int iters, int num_nodes, int num_threads) {
+  testing::StopTiming();
+  const GraphDef gdef = MakeChainGraphDef(num_nodes);
+  std::unique_ptr<thread::ThreadPool> pool;
+  GraphConstructorOptions opts;
+  opts.validate_nodes = true;
+  if (num_threads > 0) {
+    pool.reset(new thread::ThreadPool(Env::Default(), "bm", num_threads));
+    opts.thread_pool = pool.get();
+  }
+  for (int i = 0; i < iters; ++i) {
+    GraphDef copy = gdef;
+    Graph graph(OpRegistry::Global());
+    testing::StartTiming();
+    TF_CHECK_OK(ConvertGraphDefToGraph(opts, std::move(copy), &graph));
+    testing::StopTiming();
+  }
+  testing::ItemsProcessed(static_cast<int64>(iters) * num_nodes);
+}
+BENCHMARK(BM_ConvertGraphDefToGraph)
+    ->ArgPair(1 << 10, 0)
+    ->ArgPair(1 << 10, 8)
+    ->ArgPair(1 << 16, 0)
+    ->ArgPair(1 << 16, 1)
+    ->ArgPair(1 << 16, 8)
+    ->ArgPair(1 << 20, 0)
+    ->ArgPair(1 << 20, 8);
+
 }  // namespace
 }  // namespace tensorflow
@@ -276,6 +276,29 @@ Status GraphExecutionState::Extend(
   return Status::OK();
 }
 
+Status GraphExecutionState::ReplaceDeviceSet(
+    const DeviceSet* device_set,
+    std::unique_ptr<GraphExecutionState>* out) const {
+  if (!original_graph_def_) {
+    return errors::FailedPrecondition(
+        "Changing the device set is not supported when "
+        "`optimize_for_static_graph` is true.");
+  }
+
+  GraphExecutionStateOptions options;
+  options.device_set = device_set;
+  options.session_options = session_options_;
+  options.session_handle = session_handle_;
+  for (const auto& placement : stateful_placements_) {
+    if (device_set->FindDeviceByName(placement.second) != nullptr) {
+      options.stateful_placements.insert(placement);
+    }
+  }
+
+  GraphDef gdef(*original_graph_def_);
+  return MakeForBaseGraph(std::move(gdef), options, out);
+}
+
 void GraphExecutionState::SaveStatefulNodes(Graph* graph) {
   for (Node* n : graph->nodes()) {
     if (n->op_def().is_stateful()) {
@@ -487,6 +510,34 @@ Status GetFeedShapeAndTypeFromAttribute(const NodeDef& node,
   return Status::OK();
 }
 
+// Returns a key that identifies the Grappler item built by
+// `GraphExecutionState::OptimizeGraph()` for `options`. Grappler preserves
+// fetched and targeted nodes by name, so they contribute their node names
+// only, whereas feeds (and tensor connections, which act as both a feed and a
+// fetch) are identified by their full tensor names.
+string OptimizedGraphCacheKey(const BuildGraphOptions& options) {
+  const CallableOptions& callable_options = options.callable_options;
+  std::set<string> feeds(callable_options.feed().begin(),
+                         callable_options.feed().end());
+  std::set<string> fetch_nodes;
+  for (const string& fetch : callable_options.fetch()) {
+    fetch_nodes.insert(string(ParseTensorName(fetch).node()));
+  }
+  for (const string& target : callable_options.target()) {
+    fetch_nodes.insert(string(ParseTensorName(target).node()));
+  }
+  std::set<string> tensor_connections;
+  for (const TensorConnection& tensor_connection :
+       callable_options.tensor_connection()) {
+    tensor_connections.insert(strings::StrCat(tensor_connection.from_tensor(),
+                                              "->",
+                                              tensor_connection.to_tensor()));
+  }
+  return strings::StrCat(absl::StrJoin(feeds, ","), "/",
+                         absl::StrJoin(fetch_nodes, ","), "/",
+                         absl::StrJoin(tensor_connections, ","));
+}
+
 }  // namespace
 
 Status GraphExecutionState::PruneGraph(
@@ -801,6 +852,36 @@ Status GraphExecutionState::OptimizeGraph(
 #endif  // IS_MOBILE_PLATFORM
 }
 
+Status GraphExecutionState::OptimizeGraphWithCache(
+    const BuildGraphOptions& options, std::unique_ptr<Graph>* optimized_graph,
+    std::unique_ptr<FunctionLibraryDefinition>* optimized_flib) {
+  const string key = OptimizedGraphCacheKey(options);
+  {
+    mutex_lock l(optimized_graph_cache_mu_);
+    auto it = optimized_graph_cache_.find(key);
+    if (it != optimized_graph_cache_.end()) {
+      metrics::GetGraphOptimizationCacheCounter("hit")->IncrementBy(1);
+      optimized_flib->reset(
+          new FunctionLibraryDefinition(*it->second.flib_def));
+      optimized_graph->reset(new Graph(optimized_flib->get()));
+      CopyGraph(*it->second.graph, optimized_graph->get());
+      return Status::OK();
+    }
+  }
+
+  // Grappler is run without holding the lock, so concurrent misses on the
+  // same key may both optimize the graph; only the first result is cached.
+  TF_RETURN_IF_ERROR(OptimizeGraph(options, optimized_graph, optimized_flib));
+  metrics::GetGraphOptimizationCacheCounter("miss")->IncrementBy(1);
+  OptimizedGraph cached;
+  cached.flib_def.reset(new FunctionLibraryDefinition(**optimized_flib));
+  cached.graph.reset(new Graph(cached.flib_def.get()));
+  CopyGraph(**optimized_graph, cached.graph.get());
+  mutex_lock l(optimized_graph_cache_mu_);
+  optimized_graph_cache_.emplace(key, std::move(cached));
+  return Status::OK();
+}
+
 Status GraphExecutionState::BuildGraph(const BuildGraphOptions& options,
                                        std::unique_ptr<ClientGraph>* out) {
   VLOG(1) << "BuildGraph";
@@ -817,7 +898,7 @@ Status GraphExecutionState::BuildGraph(const BuildGraphOptions& options,
   std::unique_ptr<Graph> optimized_graph;
   std::unique_ptr<FunctionLibraryDefinition> optimized_flib;
 
-  Status s = OptimizeGraph(options, &optimized_graph, &optimized_flib);
+  Status s = OptimizeGraphWithCache(options, &optimized_graph, &optimized_flib);
   if (!s.ok()) {
     VLOG(2) << "Grappler optimization failed. Error: " << s.error_message();
     // Simply copy the original graph and the function library if we couldn't
@@ -19,6 +19,7 @@ limitations under the License.
 #include <functional>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "tensorflow/core/common_runtime/build_graph_options.h"
@@ -30,6 +31,8 @@ limitations under the License.
 #include "tensorflow/core/graph/graph.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
 #include "tensorflow/core/platform/types.h"
 
 namespace tensorflow {
@@ -91,6 +94,12 @@ struct ClientGraph {
 // Graph.  MasterSession uses such a ClientGraph to execute one or
 // more similar client requests.
 //
+// The result of running Grappler for a given set of feeds, fetches and
+// targets is cached, so that building several ClientGraphs that induce the
+// same node set (e.g. signatures that differ only in the order, duplication
+// or output index of their fetches, or a callable that matches a previous
+// `Session::Run()` call) only optimizes the graph once.
+//
 // GraphExecutionState is thread-safe.
 
 class GraphExecutionState {
@@ -130,6 +139,15 @@ class GraphExecutionState {
   Status Extend(const GraphDef& extension_def,
                 std::unique_ptr<GraphExecutionState>* out) const;
 
+  // Creates a new GraphExecutionState for the same graph as *this, placed
+  // on "device_set".  Stateful nodes keep their placement if their device
+  // is still in "device_set", and are placed anew otherwise.
+  //
+  // If successful, returns OK and the caller takes ownership of "*out".
+  // Otherwise returns an error and does not modify "*out".
+  Status ReplaceDeviceSet(const DeviceSet* device_set,
+                          std::unique_ptr<GraphExecutionState>* out) const;
+
   // Builds a ClientGraph (a sub-graph of the full graph as induced by
   // the Node set specified in "options").  If successful, returns OK
   // and the caller takes the ownership of "*out". Otherwise, returns
@@ -183,6 +201,14 @@ class GraphExecutionState {
       const BuildGraphOptions& options, std::unique_ptr<Graph>* optimized_graph,
       std::unique_ptr<FunctionLibraryDefinition>* optimized_flib);
 
+  // Looks up the output of `OptimizeGraph()` for `options` in
+  // `optimized_graph_cache_`, and on a miss, runs `OptimizeGraph()` and
+  // caches its output. On success, `*optimized_graph` and `*optimized_flib`
+  // are owned by the caller and may be modified freely.
+  Status OptimizeGraphWithCache(
+      const BuildGraphOptions& options, std::unique_ptr<Graph>* optimized_graph,
+      std::unique_ptr<FunctionLibraryDefinition>* optimized_flib);
+
   // The GraphExecutionState must store a copy of the original GraphDef if
   // either of the following conditions holds:
   //
@@ -210,6 +236,17 @@ class GraphExecutionState {
   // The dataflow graph owned by this object.
   Graph* graph_;
 
+  // Grappler output for each distinct set of feed tensors and fetched or
+  // targeted nodes that has been passed to `BuildGraph()`. The cached graphs
+  // have not been pruned or rewritten for execution.
+  struct OptimizedGraph {
+    std::unique_ptr<FunctionLibraryDefinition> flib_def;
+    std::unique_ptr<Graph> graph;
+  };
+  mutex optimized_graph_cache_mu_;
+  std::unordered_map<string, OptimizedGraph> optimized_graph_cache_
+      TF_GUARDED_BY(optimized_graph_cache_mu_);
+
   TF_DISALLOW_COPY_AND_ASSIGN(GraphExecutionState);
 };
 
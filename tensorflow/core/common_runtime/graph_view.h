@@ -76,6 +76,8 @@ struct NodeItem {
   bool is_recv_or_switch : 1;     // True iff IsRecv(node) || IsSwitch(node)
   bool is_next_iteration : 1;     // True iff IsNextIteration(node)
   bool is_noop : 1;  // True iff item->kernel->type_string_view() == "NoOp")
+  bool is_iterator_get_next : 1;  // True iff the kernel gets the next element
+                                  // of a tf.data iterator.
   bool
       is_any_consumer_merge_or_control_trigger : 1;  // True iff the destination
                                                      // of any output edge is a
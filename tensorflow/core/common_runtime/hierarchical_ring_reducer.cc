@@ -0,0 +1,378 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/common_runtime/hierarchical_ring_reducer.h"
+
+#include <functional>
+#include <utility>
+
+#include "tensorflow/core/common_runtime/collective_rma_local.h"
+#include "tensorflow/core/common_runtime/collective_util.h"
+#include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/common_runtime/device_mgr.h"
+#include "tensorflow/core/common_runtime/dma_helper.h"
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/device_base.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/notification.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/blocking_counter.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/profiler/lib/traceme.h"
+
+namespace tensorflow {
+namespace {
+
+enum Phase {
+  kLocalReduceScatter = 0,
+  kCrossReduceScatter = 1,
+  kCrossAllGather = 2,
+  kLocalAllGather = 3,
+};
+
+// Returns x mod n in [0, n).
+int Mod(int x, int n) { return ((x % n) + n) % n; }
+
+}  // namespace
+
+HierarchicalRingReducer::HierarchicalRingReducer()
+    : col_params_(nullptr),
+      num_tasks_(0),
+      devices_per_task_(0),
+      local_rank_(-1),
+      task_rank_(-1) {}
+
+Status HierarchicalRingReducer::InitializeCollectiveParams(
+    CollectiveParams* col_params) {
+  if (col_params->instance.type != REDUCTION_COLLECTIVE) {
+    return errors::Internal("HierarchicalRingReduce only supports reductions");
+  }
+  const int num_tasks = col_params->group.num_tasks;
+  if (num_tasks <= 0 || !col_params->instance.same_num_devices_per_task ||
+      col_params->group.group_size % num_tasks != 0) {
+    return errors::InvalidArgument(
+        "HierarchicalRingReduce requires the same number of devices on every "
+        "task, got group_size ",
+        col_params->group.group_size, " on ", num_tasks, " tasks");
+  }
+  // Precondition: device_names must be sorted so that all devices in the same
+  // task are adjacent.
+  const int devices_per_task = col_params->group.group_size / num_tasks;
+  for (int di = 0; di < col_params->group.group_size; ++di) {
+    if (col_params->instance.task_names[di] !=
+        col_params->instance.task_names[di - di % devices_per_task]) {
+      return errors::Internal("Devices of collective ", col_params->name,
+                              " are not grouped by task");
+    }
+  }
+  return Status::OK();
+}
+
+Status HierarchicalRingReducer::InitializeCollectiveContext(
+    std::shared_ptr<CollectiveContext> col_ctx) {
+  DCHECK(col_ctx->dev_mgr);
+  col_ctx_ = col_ctx;
+  col_params_ = &col_ctx->col_params;
+  return collective_util::InitializeDeviceAndLocality(
+      col_ctx->dev_mgr, col_ctx->device_name, &col_ctx->device,
+      &col_ctx->device_locality);
+}
+
+void HierarchicalRingReducer::Run(StatusCallback done) {
+  CHECK(col_ctx_);
+  CHECK(col_params_);
+  col_ctx_->col_exec->UnblockDependencies(*col_params_);
+
+  num_tasks_ = col_params_->group.num_tasks;
+  if (num_tasks_ <= 0 || col_params_->group.group_size % num_tasks_ != 0) {
+    done(errors::Internal("HierarchicalRingReduce of group_size ",
+                          col_params_->group.group_size, " on ", num_tasks_,
+                          " tasks"));
+    return;
+  }
+  devices_per_task_ = col_params_->group.group_size / num_tasks_;
+  const int rank = col_params_->default_rank;
+  local_rank_ = rank % devices_per_task_;
+  task_rank_ = rank / devices_per_task_;
+  local_ring_.clear();
+  for (int l = 0; l < devices_per_task_; ++l) {
+    local_ring_.push_back(task_rank_ * devices_per_task_ + l);
+  }
+  cross_ring_.clear();
+  for (int t = 0; t < num_tasks_; ++t) {
+    cross_ring_.push_back(t * devices_per_task_ + local_rank_);
+  }
+
+  // Start by copying input to output if they're not already the same, i.e. if
+  // we're not computing in-place on the input tensor.
+  if ((col_ctx_->input != col_ctx_->output) &&
+      (DMAHelper::base(col_ctx_->input) != DMAHelper::base(col_ctx_->output))) {
+    Notification note;
+    Status status;
+    profiler::TraceMe activity("MemCpyAsync", profiler::TraceMeLevel::kInfo);
+    CollectiveRemoteAccessLocal::MemCpyAsync(
+        col_ctx_->op_ctx->op_device_context(),
+        col_ctx_->op_ctx->op_device_context(), col_ctx_->device,
+        col_ctx_->device, col_ctx_->op_ctx->input_alloc_attr(0),
+        col_ctx_->op_ctx->output_alloc_attr(0), col_ctx_->input,
+        col_ctx_->output, 0 /*dev_to_dev_stream_index*/,
+        [&note, &status](const Status& s) {
+          status.Update(s);
+          note.Notify();
+        });
+    note.WaitForNotification();
+    if (!status.ok()) {
+      done(status);
+      return;
+    }
+  }
+
+  AllocatorAttributes attr = col_ctx_->op_ctx->output_alloc_attr(0);
+  ca_.reset(MakeCollectiveAdapter(col_ctx_->output,
+                                  devices_per_task_ * num_tasks_,
+                                  col_ctx_->device->GetAllocator(attr)));
+  if (col_params_->final_op) {
+    Status s = InitGroupSizeTensor();
+    if (!s.ok()) {
+      done(s);
+      return;
+    }
+  }
+
+  const int L = devices_per_task_;
+  const int T = num_tasks_;
+  bool ok = true;
+  // Phase 1: after L-1 steps this device holds the task-local sum of
+  // `segment`.
+  for (int k = 0; ok && k < L - 1; ++k) {
+    ok = RunRingStep(kLocalReduceScatter, k, local_ring_, local_rank_,
+                     SegmentChunks(Mod(local_rank_ - k, L)),
+                     SegmentChunks(Mod(local_rank_ - k - 1, L)),
+                     /*reduce=*/true);
+  }
+  const int segment = (local_rank_ + 1) % L;
+  // Phase 2: all-reduce `segment` across tasks.
+  for (int k = 0; ok && k < T - 1; ++k) {
+    ok = RunRingStep(kCrossReduceScatter, k, cross_ring_, task_rank_,
+                     {segment * T + Mod(task_rank_ - k, T)},
+                     {segment * T + Mod(task_rank_ - k - 1, T)},
+                     /*reduce=*/true);
+  }
+  const int final_chunk = segment * T + (task_rank_ + 1) % T;
+  if (ok && col_params_->final_op && ca_->ChunkBytes(final_chunk) > 0) {
+    Tensor chunk = ca_->ChunkAlias(final_chunk);
+    Status s = collective_util::ComputeBinOp(
+        col_ctx_->op_ctx, col_ctx_->op_params, col_ctx_->device,
+        col_params_->final_op.get(), &chunk, &group_size_tensor_);
+    if (!s.ok()) {
+      StartAbort(s);
+      ok = false;
+    }
+  }
+  for (int k = 0; ok && k < T - 1; ++k) {
+    ok = RunRingStep(kCrossAllGather, k, cross_ring_, task_rank_,
+                     {segment * T + Mod(task_rank_ + 1 - k, T)},
+                     {segment * T + Mod(task_rank_ - k, T)},
+                     /*reduce=*/false);
+  }
+  // Phase 3: share the reduced segments within the task.
+  for (int k = 0; ok && k < L - 1; ++k) {
+    ok = RunRingStep(kLocalAllGather, k, local_ring_, local_rank_,
+                     SegmentChunks(Mod(local_rank_ + 1 - k, L)),
+                     SegmentChunks(Mod(local_rank_ - k, L)),
+                     /*reduce=*/false);
+  }
+
+  if (ok) {
+    ca_->ConsumeFinalValue(col_ctx_->output);
+  }
+  Status s;
+  {
+    mutex_lock l(status_mu_);
+    s = status_;
+  }
+  ca_.reset();
+  group_size_tensor_ = Tensor();
+  done(s);
+}
+
+std::vector<int> HierarchicalRingReducer::SegmentChunks(int segment) const {
+  std::vector<int> chunks(num_tasks_);
+  for (int t = 0; t < num_tasks_; ++t) {
+    chunks[t] = segment * num_tasks_ + t;
+  }
+  return chunks;
+}
+
+bool HierarchicalRingReducer::RunRingStep(int phase, int step,
+                                          const std::vector<int>& ring,
+                                          int ring_rank,
+                                          const std::vector<int>& send_chunks,
+                                          const std::vector<int>& recv_chunks,
+                                          bool reduce) {
+  const int ring_size = static_cast<int>(ring.size());
+  const int send_to = ring[(ring_rank + 1) % ring_size];
+  const int recv_from = ring[Mod(ring_rank - 1, ring_size)];
+  std::vector<Transfer> sends;
+  for (int chunk_idx : send_chunks) {
+    if (ca_->ChunkBytes(chunk_idx) > 0) sends.push_back({send_to, chunk_idx});
+  }
+  std::vector<Transfer> recvs;
+  for (int chunk_idx : recv_chunks) {
+    if (ca_->ChunkBytes(chunk_idx) > 0) {
+      recvs.push_back({recv_from, chunk_idx});
+    }
+  }
+  return RunStep(phase, step, sends, recvs, reduce);
+}
+
+bool HierarchicalRingReducer::RunStep(int phase, int step,
+                                      const std::vector<Transfer>& sends,
+                                      const std::vector<Transfer>& recvs,
+                                      bool reduce) {
+  if (sends.empty() && recvs.empty()) return true;
+  profiler::TraceMe activity(
+      [&] { return strings::StrCat("HierarchicalRingReduce:", phase); },
+      profiler::TraceMeLevel::kInfo);
+  std::vector<Tensor> send_tensors;
+  send_tensors.reserve(sends.size());
+  for (const Transfer& t : sends) {
+    send_tensors.push_back(ca_->ChunkAlias(t.chunk_idx));
+  }
+  std::vector<Tensor> chunks;
+  std::vector<Tensor> recv_tensors;
+  chunks.reserve(recvs.size());
+  recv_tensors.reserve(recvs.size());
+  for (const Transfer& t : recvs) {
+    chunks.push_back(ca_->ChunkAlias(t.chunk_idx));
+    recv_tensors.push_back(reduce ? ca_->TempChunk(t.chunk_idx)
+                                  : chunks.back());
+  }
+  const DeviceBase::GpuDeviceInfo* gpu_info =
+      col_ctx_->device->tensorflow_gpu_device_info();
+  if (gpu_info && reduce && !recvs.empty()) {
+    // The temp chunks are not guaranteed to be valid (e.g. for RDMA write)
+    // until the currently queued work on the compute stream completes.
+    Notification note;
+    Status s = gpu_info->default_context->ThenExecute(
+        col_ctx_->device, gpu_info->stream, [&note]() { note.Notify(); });
+    if (!s.ok()) {
+      StartAbort(errors::Internal(
+          "Failed to dispatch ThenExecute in HierarchicalRingReducer"));
+      return false;
+    }
+    note.WaitForNotification();
+  }
+
+  BlockingCounter pending(sends.size() + recvs.size());
+  auto on_done = [this, &pending](const Status& s) {
+    if (!s.ok()) StartAbort(s);
+    pending.DecrementCount();
+  };
+  const int rank = col_params_->default_rank;
+  for (int i = 0; i < sends.size(); ++i) {
+    const int peer = sends[i].peer;
+    col_ctx_->col_exec->remote_access()->PostToPeer(
+        col_params_->instance.device_names[peer],
+        col_params_->instance.task_names[peer],
+        BufKey(phase, step, rank, sends[i].chunk_idx), col_ctx_->device,
+        col_ctx_->op_ctx->op_device_context(),
+        col_ctx_->op_ctx->output_alloc_attr(0), &send_tensors[i],
+        col_ctx_->device_locality, on_done);
+  }
+  for (int i = 0; i < recvs.size(); ++i) {
+    const int peer = recvs[i].peer;
+    col_ctx_->col_exec->remote_access()->RecvFromPeer(
+        col_params_->instance.device_names[peer],
+        col_params_->instance.task_names[peer],
+        col_params_->task.is_local[peer],
+        BufKey(phase, step, peer, recvs[i].chunk_idx), col_ctx_->device,
+        col_ctx_->op_ctx->op_device_context(),
+        col_ctx_->op_ctx->output_alloc_attr(0), &recv_tensors[i],
+        col_ctx_->device_locality, 0 /*dev_to_dev_stream_index*/, on_done);
+  }
+  pending.Wait();
+  {
+    mutex_lock l(status_mu_);
+    if (!status_.ok()) return false;
+  }
+
+  if (reduce) {
+    for (int i = 0; i < recvs.size(); ++i) {
+      Status s = collective_util::ComputeBinOp(
+          col_ctx_->op_ctx, col_ctx_->op_params, col_ctx_->device,
+          col_params_->merge_op.get(), &chunks[i], &recv_tensors[i]);
+      if (!s.ok()) {
+        StartAbort(s);
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+Status HierarchicalRingReducer::InitGroupSizeTensor() {
+  // Create an on-device scalar value from the group size that is used by the
+  // final op.
+  Tensor group_size_val = ca_->Scalar(col_params_->group.group_size);
+  if (col_params_->group.device_type == "CPU") {
+    group_size_tensor_ = group_size_val;
+    return Status::OK();
+  }
+  group_size_tensor_ = ca_->Scalar(
+      col_ctx_->device->GetAllocator(col_ctx_->op_ctx->input_alloc_attr(0)),
+      AllocationAttributes());
+  Notification note;
+  Status status;
+  col_ctx_->op_ctx->op_device_context()->CopyCPUTensorToDevice(
+      &group_size_val, col_ctx_->device, &group_size_tensor_,
+      [&note, &status](const Status& s) {
+        status = s;
+        note.Notify();
+      });
+  note.WaitForNotification();
+  return status;
+}
+
+string HierarchicalRingReducer::BufKey(int phase, int step, int src_rank,
+                                       int chunk_idx) const {
+  return strings::StrCat("HierarchicalRingReduce(", col_ctx_->exec_key, "):",
+                         phase, ":", step, ":", src_rank, ":", chunk_idx);
+}
+
+void HierarchicalRingReducer::StartAbort(const Status& s) {
+  bool abort_started = false;
+  {
+    mutex_lock l(status_mu_);
+    if (status_.ok()) {
+      LOG(ERROR) << "Aborting HierarchicalRingReduce with " << s;
+      abort_started = true;
+      status_.Update(s);
+    }
+  }
+  // Starting the abort on the CollectiveExecutor cancels all outstanding
+  // CollectiveRemoteAccess actions, so RunStep does not wait forever.
+  if (abort_started) {
+    col_ctx_->col_exec->StartAbort(s);
+  }
+}
+
+namespace {
+REGISTER_COLLECTIVE(HierarchicalRingReduce, HierarchicalRingReducer);
+}  // namespace
+
+}  // namespace tensorflow
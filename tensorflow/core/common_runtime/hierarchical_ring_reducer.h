@@ -0,0 +1,110 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_HIERARCHICAL_RING_REDUCER_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_HIERARCHICAL_RING_REDUCER_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/base_collective_executor.h"
+#include "tensorflow/core/framework/collective.h"
+
+namespace tensorflow {
+class Device;
+
+// Two-level implementation of collective all-reduce for groups spanning
+// several tasks with the same number of devices each.
+//
+// With T tasks of L devices, the tensor is divided into L segments of T
+// chunks.  The algorithm runs in three phases:
+//   1. A ring reduce-scatter among the L devices of each task, after which
+//      every device holds the task-local sum of one segment.
+//   2. A ring all-reduce of that segment among the T devices, one per task,
+//      that hold it.
+//   3. A ring all-gather of the segments among the L devices of each task.
+// Only phase 2 crosses task boundaries, so a tensor crosses the network in
+// 2(T-1) steps instead of the 2(TL-1) steps of a flat ring.
+//
+// Selected by the resolver for reductions with communication_hint
+// "hierarchical".
+class HierarchicalRingReducer : public CollectiveImplementationInterface {
+ public:
+  HierarchicalRingReducer();
+  ~HierarchicalRingReducer() override = default;
+
+  // Checks that the group has the same number of devices on every task.
+  Status InitializeCollectiveParams(CollectiveParams* col_params) override;
+
+  // Initializes members of CollectiveContext not yet initialized, i.e. device
+  // and device_locality.  Also saves the CollectiveContext in this object.
+  Status InitializeCollectiveContext(
+      std::shared_ptr<CollectiveContext> col_ctx) override;
+
+  Status InitializeCollectiveGroupRuntimeDetails(
+      CollGroupRuntimeDetails*) override {
+    return Status::OK();
+  }
+
+  // Begins execution of the hierarchical all-reduce.  Blocks until every phase
+  // completes, so it must be called in a blockable thread.
+  void Run(StatusCallback done) override;
+
+ private:
+  // A single chunk transfer of one step of a ring.
+  struct Transfer {
+    int peer;       // default rank of the device sent to or received from
+    int chunk_idx;  // chunk of ca_ transferred
+  };
+
+  // Sends and receives the given chunks concurrently and waits for all of
+  // them.  If `reduce` is true each received chunk is merged into the local
+  // chunk, otherwise it overwrites it.  Returns false on abort.
+  bool RunStep(int phase, int step, const std::vector<Transfer>& sends,
+               const std::vector<Transfer>& recvs, bool reduce);
+
+  // Runs one ring step in which every device forwards `send_chunks` to the
+  // next device of `ring` and receives `recv_chunks` from the previous one.
+  bool RunRingStep(int phase, int step, const std::vector<int>& ring,
+                   int ring_rank, const std::vector<int>& send_chunks,
+                   const std::vector<int>& recv_chunks, bool reduce);
+
+  // Chunk indices of segment `segment`.
+  std::vector<int> SegmentChunks(int segment) const;
+
+  // Makes a device scalar holding the group size for the final op.
+  Status InitGroupSizeTensor();
+
+  string BufKey(int phase, int step, int src_rank, int chunk_idx) const;
+  void StartAbort(const Status& s);
+
+  std::shared_ptr<CollectiveContext> col_ctx_;
+  const CollectiveParams* col_params_;  // Not owned
+  int num_tasks_;
+  int devices_per_task_;
+  // Default ranks of the devices of this task, in ring order.
+  std::vector<int> local_ring_;
+  // Default ranks of the devices at this device's position on every task.
+  std::vector<int> cross_ring_;
+  int local_rank_;
+  int task_rank_;
+  std::unique_ptr<CollectiveAdapter> ca_;
+  Tensor group_size_tensor_;
+  mutex status_mu_;
+  Status status_ TF_GUARDED_BY(status_mu_);
+};
+
+}  // namespace tensorflow
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_HIERARCHICAL_RING_REDUCER_H_
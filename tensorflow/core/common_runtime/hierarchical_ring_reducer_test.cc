@@ -0,0 +1,326 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/common_runtime/hierarchical_ring_reducer.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "absl/memory/memory.h"
+#include "tensorflow/core/common_runtime/base_collective_executor.h"
+#include "tensorflow/core/common_runtime/collective_rma_local.h"
+#include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/common_runtime/device_mgr.h"
+#include "tensorflow/core/common_runtime/device_resolver_local.h"
+#include "tensorflow/core/common_runtime/process_util.h"
+#include "tensorflow/core/common_runtime/test_collective_executor_mgr.h"
+#include "tensorflow/core/common_runtime/threadpool_device.h"
+#include "tensorflow/core/framework/collective.h"
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/blocking_counter.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/unbounded_work_queue.h"
+#include "tensorflow/core/public/session_options.h"
+#include "tensorflow/core/public/version.h"
+
+namespace tensorflow {
+namespace {
+
+// Wraps CollectiveRemoteAccessLocal with the ability to return an
+// error status to the N'th action.
+class FailTestRMA : public CollectiveRemoteAccessLocal {
+ public:
+  FailTestRMA(const DeviceMgr* dev_mgr, DeviceResolverInterface* dev_resolver,
+              int64 step_id, int fail_after)
+      : CollectiveRemoteAccessLocal(dev_mgr, dev_resolver, step_id),
+        fail_after_(fail_after) {}
+
+  bool MaybeFail(const StatusCallback& done) {
+    bool fail_now = false;
+    {
+      mutex_lock l(mu_);
+      if (fail_after_ > 0) {
+        fail_now = (--fail_after_ == 0);
+      }
+    }
+    if (fail_now) {
+      done(errors::Internal("Deliberate failure"));
+      return true;
+    }
+    return false;
+  }
+
+  void RecvFromPeer(const string& peer_device, const string& peer_task,
+                    bool peer_is_local, const string& key, Device* to_device,
+                    DeviceContext* to_device_ctx,
+                    const AllocatorAttributes& to_alloc_attr, Tensor* to_tensor,
+                    const DeviceLocality& client_locality,
+                    int dev_to_dev_stream_index,
+                    const StatusCallback& done) override {
+    if (MaybeFail(done)) return;
+    CollectiveRemoteAccessLocal::RecvFromPeer(
+        peer_device, peer_task, peer_is_local, key, to_device, to_device_ctx,
+        to_alloc_attr, to_tensor, client_locality, dev_to_dev_stream_index,
+        done);
+  }
+
+  void PostToPeer(const string& peer_device, const string& peer_task,
+                  const string& key, Device* from_device,
+                  DeviceContext* from_device_ctx,
+                  const AllocatorAttributes& from_alloc_attr,
+                  const Tensor* from_tensor,
+                  const DeviceLocality& client_locality,
+                  const StatusCallback& done) override {
+    if (MaybeFail(done)) return;
+    CollectiveRemoteAccessLocal::PostToPeer(
+        peer_device, peer_task, key, from_device, from_device_ctx,
+        from_alloc_attr, from_tensor, client_locality, done);
+  }
+
+  mutex mu_;
+  int fail_after_ TF_GUARDED_BY(mu_);
+};
+
+std::unique_ptr<OpKernel> GetKernel(const string& op, DataType dtype,
+                                    DeviceBase* device) {
+  NodeDef node_def;
+  TF_CHECK_OK(NodeDefBuilder(strings::StrCat(op, "_node"), op)
+                  .Attr("T", dtype)
+                  .Input(FakeInput(dtype))
+                  .Input(FakeInput(dtype))
+                  .Finalize(&node_def));
+  Status status;
+  std::unique_ptr<OpKernel> k = CreateOpKernel(
+      DEVICE_CPU, device, device->GetAllocator(AllocatorAttributes()), node_def,
+      TF_GRAPH_DEF_VERSION, &status);
+  TF_CHECK_OK(status);
+  return k;
+}
+
+static int64 kStepId = 123;
+
+class HierarchicalRingReducerTest : public ::testing::Test {
+ protected:
+  ~HierarchicalRingReducerTest() override {
+    if (col_exec_) col_exec_->Unref();
+  }
+
+  void Init(int num_tasks, int num_devices, DataType dtype, int fail_after) {
+    std::vector<std::unique_ptr<Device>> local_devices;
+    SessionOptions sess_opts;
+    sess_opts.env = Env::Default();
+    Bytes mem_limit(4 << 20);
+    DeviceLocality dev_locality;
+    col_params_.group.group_key = 5;
+    col_params_.group.device_type = DEVICE_CPU;
+    col_params_.group.group_size = num_tasks * num_devices;
+    col_params_.group.num_tasks = num_tasks;
+    col_params_.instance.instance_key = 17;
+    col_params_.instance.type = REDUCTION_COLLECTIVE;
+    col_params_.instance.impl_details.collective_name =
+        "HierarchicalRingReduce";
+    col_params_.instance.data_type = dtype;
+    col_params_.instance.same_num_devices_per_task = true;
+    for (int ti = 0; ti < num_tasks; ++ti) {
+      string task_name = strings::StrCat("/job:worker/replica:0/task:", ti);
+      col_params_.instance.num_devices_per_task[task_name] = num_devices;
+      for (int di = 0; di < num_devices; ++di) {
+        string dev_name = strings::StrCat(task_name, "/cpu:", di);
+        local_devices.push_back(absl::make_unique<ThreadPoolDevice>(
+            sess_opts, dev_name, mem_limit, dev_locality, cpu_allocator()));
+        col_params_.instance.device_names.push_back(dev_name);
+        col_params_.instance.task_names.push_back(task_name);
+        // This test runs in a single process so is_local is always true.
+        col_params_.task.is_local.push_back(true);
+      }
+    }
+    dev_mgr_ = absl::make_unique<StaticDeviceMgr>(std::move(local_devices));
+    dev_resolver_ = absl::make_unique<DeviceResolverLocal>(dev_mgr_.get());
+    work_queue_ = std::make_shared<UnboundedWorkQueue>(Env::Default(), "test");
+    rma_ = new FailTestRMA(dev_mgr_.get(), dev_resolver_.get(), kStepId,
+                           fail_after);
+    col_exec_ = new BaseCollectiveExecutor(
+        &col_exec_mgr_, rma_, kStepId, dev_mgr_.get(), &gpu_ring_order_,
+        work_queue_);
+  }
+
+  // Runs the all-reduce on every device and returns the final status of each.
+  std::vector<Status> Reduce(std::vector<Tensor>* tensors) {
+    const int group_size = col_params_.group.group_size;
+    std::vector<Status> statuses(group_size);
+    BlockingCounter counter(group_size);
+    for (int rank = 0; rank < group_size; ++rank) {
+      SchedClosure([this, rank, tensors, &statuses, &counter] {
+        statuses[rank] = DoReduce(rank, &(*tensors)[rank]);
+        counter.DecrementCount();
+      });
+    }
+    counter.Wait();
+    return statuses;
+  }
+
+  Status DoReduce(int rank, Tensor* tensor) {
+    Device* device = nullptr;
+    TF_CHECK_OK(dev_mgr_->LookupDevice(col_params_.instance.device_names[rank],
+                                       &device));
+    CollectiveParams col_params;
+    col_params.name = "test_collective";
+    col_params.group = col_params_.group;
+    col_params.instance = col_params_.instance;
+    col_params.task.is_local = col_params_.task.is_local;
+    col_params.default_rank = rank;
+    col_params.merge_op = GetKernel("Add", tensor->dtype(), device);
+    col_params.final_op = GetKernel("Div", tensor->dtype(), device);
+
+    OpKernelContext::Params op_params;
+    op_params.step_id = kStepId;
+    op_params.device = device;
+    gtl::InlinedVector<TensorValue, 4> inputs;
+    inputs.push_back(TensorValue(tensor));
+    op_params.inputs = &inputs;
+    gtl::InlinedVector<AllocatorAttributes, 4> input_aa(
+        {AllocatorAttributes()});
+    op_params.input_alloc_attrs = &input_aa;
+    DeviceContext* dev_ctx = new DeviceContext;
+    op_params.op_device_context = dev_ctx;
+    int forward_from = 0;
+    op_params.forward_from_array = &forward_from;
+    AllocatorAttributes generic_alloc_attr;
+    op_params.output_attr_array = &generic_alloc_attr;
+    op_params.op_kernel = col_params.merge_op.get();
+    OpKernelContext ctx(&op_params, 1);
+
+    string exec_key = strings::StrCat(col_params.instance.instance_key, ":0:0");
+    HierarchicalRingReducer* reducer = new HierarchicalRingReducer;
+    core::ScopedUnref unref(reducer);
+    auto col_ctx = std::make_shared<CollectiveContext>(
+        col_exec_, dev_mgr_.get(), &ctx, &op_params, col_params, exec_key,
+        kStepId, tensor, tensor);
+    TF_CHECK_OK(reducer->InitializeCollectiveContext(col_ctx));
+    Status status;
+    reducer->Run([&status](const Status& s) { status = s; });
+    dev_ctx->Unref();
+    return status;
+  }
+
+  template <typename T>
+  void RunTest(DataType dtype, int num_tasks, int num_devices, int tensor_len,
+               int fail_after) {
+    Init(num_tasks, num_devices, dtype, fail_after);
+    const int group_size = num_tasks * num_devices;
+    std::vector<double> expected(tensor_len, 0.0);
+    std::vector<Tensor> tensors;
+    for (int rank = 0; rank < group_size; ++rank) {
+      Tensor t(dtype, TensorShape({tensor_len}));
+      for (int i = 0; i < tensor_len; ++i) {
+        double value = (dtype == DT_INT32) ? group_size * (rank * 10 + i)
+                                           : (rank + 1) * 0.5 + i;
+        t.flat<T>()(i) = static_cast<T>(value);
+        expected[i] += value;
+      }
+      tensors.push_back(t);
+    }
+    std::vector<Status> statuses = Reduce(&tensors);
+    for (int rank = 0; rank < group_size; ++rank) {
+      if (fail_after > 0) {
+        EXPECT_NE(statuses[rank].error_message().find("Deliberate failure"),
+                  string::npos)
+            << statuses[rank];
+        continue;
+      }
+      TF_ASSERT_OK(statuses[rank]);
+      auto actual = tensors[rank].flat<T>();
+      for (int i = 0; i < tensor_len; ++i) {
+        const double want = expected[i] / group_size;
+        EXPECT_NEAR(want, static_cast<double>(actual(i)),
+                    1e-5 * std::abs(want) + 1e-4)
+            << "Mismatch at rank " << rank << " index " << i;
+      }
+    }
+  }
+
+  TestCollectiveExecutorMgr col_exec_mgr_;
+  CollectiveExecutor* col_exec_ = nullptr;
+  CollectiveRemoteAccessLocal* rma_;
+  std::unique_ptr<DeviceResolverLocal> dev_resolver_;
+  std::shared_ptr<UnboundedWorkQueue> work_queue_;
+  std::unique_ptr<DeviceMgr> dev_mgr_;
+  string gpu_ring_order_;
+  CollectiveParams col_params_;
+};
+
+TEST_F(HierarchicalRingReducerTest, InitializeParams) {
+  Init(2, 4, DT_FLOAT, 0);
+  HierarchicalRingReducer* reducer = new HierarchicalRingReducer;
+  core::ScopedUnref unref(reducer);
+  TF_EXPECT_OK(reducer->InitializeCollectiveParams(&col_params_));
+
+  col_params_.instance.same_num_devices_per_task = false;
+  EXPECT_TRUE(errors::IsInvalidArgument(
+      reducer->InitializeCollectiveParams(&col_params_)));
+}
+
+TEST_F(HierarchicalRingReducerTest, InitializeParamsRequiresGroupedTasks) {
+  Init(2, 2, DT_FLOAT, 0);
+  std::swap(col_params_.instance.task_names[1],
+            col_params_.instance.task_names[2]);
+  HierarchicalRingReducer* reducer = new HierarchicalRingReducer;
+  core::ScopedUnref unref(reducer);
+  EXPECT_FALSE(reducer->InitializeCollectiveParams(&col_params_).ok());
+}
+
+#define DEF_TEST(B, T, D, L, A)                                              \
+  TEST_F(HierarchicalRingReducerTest,                                        \
+         DaTy##B##_Tasks##T##_Devs##D##_Len##L##_Abrt##A) {                  \
+    DataType dtype = DT_##B;                                                 \
+    switch (dtype) {                                                         \
+      case DT_FLOAT: {                                                       \
+        RunTest<float>(dtype, T, D, L, A);                                   \
+      } break;                                                               \
+      case DT_DOUBLE: {                                                      \
+        RunTest<double>(dtype, T, D, L, A);                                  \
+      } break;                                                               \
+      case DT_INT32: {                                                       \
+        RunTest<int32>(dtype, T, D, L, A);                                   \
+      } break;                                                               \
+      default:                                                               \
+        LOG(FATAL) << "Unimplemented";                                       \
+    }                                                                        \
+  }
+
+// Success tests
+DEF_TEST(FLOAT, 1, 2, 1, 0)
+DEF_TEST(FLOAT, 1, 4, 1001, 0)
+DEF_TEST(FLOAT, 2, 1, 1001, 0)
+DEF_TEST(FLOAT, 2, 2, 1, 0)
+DEF_TEST(FLOAT, 2, 2, 7, 0)
+DEF_TEST(FLOAT, 2, 4, 4096, 0)
+DEF_TEST(FLOAT, 3, 4, 9408, 0)
+DEF_TEST(FLOAT, 4, 8, 4095, 0)
+DEF_TEST(DOUBLE, 2, 4, 1001, 0)
+DEF_TEST(INT32, 2, 4, 1001, 0)
+DEF_TEST(INT32, 3, 2, 4095, 0)
+
+// Failure tests
+DEF_TEST(FLOAT, 2, 4, 4096, 1)
+DEF_TEST(FLOAT, 2, 4, 4096, 9)
+
+}  // namespace
+}  // namespace tensorflow
@@ -31,6 +31,13 @@ namespace {
 bool IsInitializationOp(const Node* node) {
   return node->op_def().allows_uninitialized_input();
 }
+
+bool IsIteratorGetNext(const OpKernel& kernel) {
+  const absl::string_view type = kernel.type_string_view();
+  return type == "IteratorGetNext" || type == "IteratorGetNextSync" ||
+         type == "IteratorGetNextAsOptional" ||
+         type == "MultiDeviceIteratorGetNextFromShard";
+}
 }  // namespace
 
 ImmutableExecutorState::~ImmutableExecutorState() {
@@ -154,6 +161,7 @@ Status ImmutableExecutorState::Initialize(const Graph& graph) {
     }
     item->const_tensor = const_tensor;
     item->is_noop = (item->kernel->type_string_view() == "NoOp");
+    item->is_iterator_get_next = IsIteratorGetNext(*item->kernel);
     item->is_enter = IsEnter(n);
     if (item->is_enter) {
       bool is_constant_enter;
@@ -21,6 +21,7 @@ limitations under the License.
 
 namespace tensorflow {
 
+class CostModel;
 class Device;
 class StepStatsCollector;
 class SessionMetadata;
@@ -47,6 +48,12 @@ struct LocalExecutorParams {
                        OpKernel**)>
       create_kernel;
   std::function<void(OpKernel*)> delete_kernel;
+
+  // If not null, the per-node execution times recorded in this cost model
+  // are used as the initial estimates when deciding whether a node is cheap
+  // enough to run inline. The cost model must have been built for the graph
+  // passed to the executor, and is only read while the executor is created.
+  const CostModel* cost_model = nullptr;
 };
 
 }  // end namespace tensorflow
@@ -49,6 +49,16 @@ class PropagatorState {
                   bool vlog);
   ~PropagatorState();
 
+  // `PropagatorState` does not reuse per-step state across steps, because the
+  // frames and iterations that a step creates depend on the values computed by
+  // that step. This type only exists so that `ExecutorState` can construct
+  // both propagator types in the same way.
+  class StatePool {};
+
+  PropagatorState(const ImmutableExecutorState& immutable_state, int64 step_id,
+                  bool vlog, StatePool* /*state_pool*/)
+      : PropagatorState(immutable_state, step_id, vlog) {}
+
  private:
   // Forward declaration so that `TaggedNode` can include a `FrameState*` and an
   // `IterationState*`.
@@ -0,0 +1,360 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/replay_allocator.h"
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <utility>
+
+#include "tensorflow/core/lib/strings/numbers.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+
+constexpr int ReplayAllocator::kMaxPlanAttempts;
+constexpr int ReplayAllocator::kMaxPlannedAllocations;
+constexpr size_t ReplayAllocator::kSlabAlignment;
+
+namespace {
+
+size_t RoundUpToSlabAlignment(size_t num_bytes) {
+  return (num_bytes + ReplayAllocator::kSlabAlignment - 1) &
+         ~(ReplayAllocator::kSlabAlignment - 1);
+}
+
+}  // namespace
+
+ReplayAllocator::ReplayAllocator(Allocator* base) : base_(base) {}
+
+ReplayAllocator::~ReplayAllocator() {
+  mutex_lock l(mu_);
+  if (!slab_live_.empty()) {
+    LOG(WARNING) << Name() << ": destroying ReplayAllocator with "
+                 << slab_live_.size() << " live planned allocations";
+  }
+  for (const auto& it : slabs_) {
+    base_->DeallocateRaw(it.second.base);
+  }
+}
+
+size_t ReplayAllocator::PackBuffers(const std::vector<size_t>& sizes,
+                                    const std::vector<int64>& alloc_times,
+                                    const std::vector<int64>& free_times,
+                                    std::vector<size_t>* offsets) {
+  const int n = sizes.size();
+  offsets->assign(n, 0);
+  // Place the largest buffers first, and put each one in the smallest gap
+  // between the buffers already placed whose lifetimes overlap its own.
+  std::vector<int> order(n);
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(),
+                   [&sizes](int a, int b) { return sizes[a] > sizes[b]; });
+  std::vector<int> placed;
+  placed.reserve(n);
+  std::vector<std::pair<size_t, size_t>> busy;
+  size_t total_bytes = 0;
+  for (int i : order) {
+    const size_t num_bytes = RoundUpToSlabAlignment(sizes[i]);
+    busy.clear();
+    for (int j : placed) {
+      if (alloc_times[j] < free_times[i] && alloc_times[i] < free_times[j]) {
+        busy.emplace_back((*offsets)[j],
+                          (*offsets)[j] + RoundUpToSlabAlignment(sizes[j]));
+      }
+    }
+    std::sort(busy.begin(), busy.end());
+    size_t best_offset = 0;
+    size_t best_gap = std::numeric_limits<size_t>::max();
+    size_t end = 0;
+    for (const auto& range : busy) {
+      if (range.first > end) {
+        const size_t gap = range.first - end;
+        if (gap >= num_bytes && gap < best_gap) {
+          best_offset = end;
+          best_gap = gap;
+        }
+      }
+      end = std::max(end, range.second);
+    }
+    if (best_gap == std::numeric_limits<size_t>::max()) best_offset = end;
+    (*offsets)[i] = best_offset;
+    total_bytes = std::max(total_bytes, best_offset + num_bytes);
+    placed.push_back(i);
+  }
+  return total_bytes;
+}
+
+void* ReplayAllocator::AllocateRaw(
+    size_t alignment, size_t num_bytes,
+    const AllocationAttributes& allocation_attr) {
+  // Requests that need timestamp-based reuse from the wrapped allocator are
+  // never planned.
+  const bool plannable = alignment <= kSlabAlignment &&
+                         allocation_attr.freed_by_func == nullptr;
+  {
+    mutex_lock l(mu_);
+    if (mode_ == Mode::kReplaying && num_active_steps_ == 1 && !overlapped_ &&
+        !diverged_) {
+      const int32 index = NextPlannedLocked(num_bytes);
+      if (index >= 0 && plannable) {
+        Planned& planned = plan_[index];
+        planned.live = true;
+        Slab& slab = slabs_[plan_slab_id_];
+        ++slab.num_live;
+        void* ptr = slab.base + planned.offset;
+        slab_live_[ptr] = {plan_slab_id_, index, num_bytes};
+        return ptr;
+      }
+    }
+  }
+  // The wrapped allocator may wait for memory to be freed, so it must not be
+  // called with `mu_` held.
+  void* ptr = base_->AllocateRaw(alignment, num_bytes, allocation_attr);
+  if (ptr == nullptr) return nullptr;
+  mutex_lock l(mu_);
+  if (mode_ == Mode::kRecording && num_active_steps_ == 1 && !overlapped_) {
+    if (recorded_.size() >= kMaxPlannedAllocations) {
+      LOG(INFO) << Name() << ": a step made more than "
+                << kMaxPlannedAllocations
+                << " allocations; not planning memory from previous steps.";
+      mode_ = Mode::kDisabled;
+      recorded_.clear();
+      recorded_live_.clear();
+    } else {
+      recorded_live_[ptr] = recorded_.size();
+      recorded_.push_back({num_bytes, clock_++, -1, plannable});
+    }
+  }
+  return ptr;
+}
+
+void ReplayAllocator::DeallocateRaw(void* ptr) {
+  if (ptr == nullptr) return;
+  char* slab_to_free = nullptr;
+  {
+    mutex_lock l(mu_);
+    auto it = slab_live_.find(ptr);
+    if (it != slab_live_.end()) {
+      const SlabAllocation allocation = it->second;
+      slab_live_.erase(it);
+      auto slab_it = slabs_.find(allocation.slab_id);
+      DCHECK(slab_it != slabs_.end());
+      --slab_it->second.num_live;
+      if (allocation.slab_id == plan_slab_id_) {
+        plan_[allocation.index].live = false;
+      } else if (slab_it->second.num_live == 0) {
+        // The last allocation in a slab whose plan was discarded.
+        slab_to_free = slab_it->second.base;
+        slabs_.erase(slab_it);
+      }
+    } else {
+      auto recorded_it = recorded_live_.find(ptr);
+      if (recorded_it != recorded_live_.end()) {
+        recorded_[recorded_it->second].free_time = clock_++;
+        recorded_live_.erase(recorded_it);
+      }
+      slab_to_free = static_cast<char*>(ptr);
+    }
+  }
+  if (slab_to_free != nullptr) base_->DeallocateRaw(slab_to_free);
+}
+
+size_t ReplayAllocator::RequestedSize(const void* ptr) const {
+  {
+    mutex_lock l(mu_);
+    auto it = slab_live_.find(ptr);
+    if (it != slab_live_.end()) return it->second.num_bytes;
+  }
+  return base_->RequestedSize(ptr);
+}
+
+size_t ReplayAllocator::AllocatedSize(const void* ptr) const {
+  {
+    mutex_lock l(mu_);
+    auto it = slab_live_.find(ptr);
+    if (it != slab_live_.end()) {
+      return RoundUpToSlabAlignment(it->second.num_bytes);
+    }
+  }
+  return base_->AllocatedSize(ptr);
+}
+
+int64 ReplayAllocator::AllocationId(const void* ptr) const {
+  {
+    mutex_lock l(mu_);
+    if (slab_live_.contains(ptr)) return 0;
+  }
+  return base_->AllocationId(ptr);
+}
+
+void ReplayAllocator::BeginStep(int64 step_id) {
+  mutex_lock l(mu_);
+  if (++num_active_steps_ > 1) overlapped_ = true;
+}
+
+void ReplayAllocator::EndStep(int64 step_id) {
+  char* slab_to_free = nullptr;
+  {
+    mutex_lock l(mu_);
+    DCHECK_GT(num_active_steps_, 0);
+    if (--num_active_steps_ > 0) return;
+    if (!overlapped_) {
+      if (mode_ == Mode::kRecording) {
+        if (BuildPlanLocked()) {
+          VLOG(1) << Name() << ": planned " << plan_.size()
+                  << " allocations of step " << step_id << " into "
+                  << strings::HumanReadableNumBytes(PlannedBytesLocked());
+        }
+      } else if (mode_ == Mode::kReplaying) {
+        if (diverged_) {
+          VLOG(1) << Name() << ": step " << step_id
+                  << " diverged from the memory plan";
+          slab_to_free = DiscardPlanLocked();
+          if (++num_failed_plans_ >= kMaxPlanAttempts) {
+            LOG(INFO) << Name() << ": allocations differ from step to step; "
+                      << "not planning memory from previous steps.";
+            mode_ = Mode::kDisabled;
+          } else {
+            mode_ = Mode::kRecording;
+          }
+        } else {
+          num_failed_plans_ = 0;
+        }
+      }
+    }
+    ResetStepLocked();
+  }
+  if (slab_to_free != nullptr) base_->DeallocateRaw(slab_to_free);
+}
+
+bool ReplayAllocator::HasPlan() const {
+  mutex_lock l(mu_);
+  return mode_ == Mode::kReplaying;
+}
+
+size_t ReplayAllocator::PlannedBytes() const {
+  mutex_lock l(mu_);
+  return PlannedBytesLocked();
+}
+
+size_t ReplayAllocator::PlannedBytesLocked() const {
+  auto it = slabs_.find(plan_slab_id_);
+  return it == slabs_.end() ? 0 : it->second.num_bytes;
+}
+
+int32 ReplayAllocator::NextPlannedLocked(size_t num_bytes) {
+  auto it = by_size_.find(num_bytes);
+  int32& next = next_by_size_[num_bytes];
+  if (it == by_size_.end() || next >= it->second.size()) {
+    diverged_ = true;
+    return -1;
+  }
+  const int32 index = it->second[next++];
+  if (index < 0) return -1;
+  for (int32 overlap : plan_[index].overlaps) {
+    if (plan_[overlap].live) return -1;
+  }
+  return index;
+}
+
+bool ReplayAllocator::BuildPlanLocked() {
+  std::vector<int32> candidates;
+  std::vector<size_t> sizes;
+  std::vector<int64> alloc_times;
+  std::vector<int64> free_times;
+  for (int32 i = 0; i < recorded_.size(); ++i) {
+    const Recorded& recorded = recorded_[i];
+    // Allocations that outlive the step cannot be served from the slab.
+    if (recorded.plannable && recorded.free_time >= 0) {
+      candidates.push_back(i);
+      sizes.push_back(recorded.num_bytes);
+      alloc_times.push_back(recorded.alloc_time);
+      free_times.push_back(recorded.free_time);
+    }
+  }
+  if (candidates.empty()) return false;
+
+  std::vector<size_t> offsets;
+  const size_t slab_bytes =
+      PackBuffers(sizes, alloc_times, free_times, &offsets);
+  AllocationAttributes attr;
+  attr.retry_on_failure = false;
+  char* slab =
+      static_cast<char*>(base_->AllocateRaw(kSlabAlignment, slab_bytes, attr));
+  if (slab == nullptr) {
+    LOG(WARNING) << Name() << ": could not allocate "
+                 << strings::HumanReadableNumBytes(slab_bytes)
+                 << " to plan memory from previous steps.";
+    return false;
+  }
+
+  plan_.resize(candidates.size());
+  std::vector<int32> planned_index(recorded_.size(), -1);
+  for (int32 i = 0; i < candidates.size(); ++i) {
+    plan_[i].num_bytes = sizes[i];
+    plan_[i].offset = offsets[i];
+    planned_index[candidates[i]] = i;
+  }
+  for (int32 i = 0; i < recorded_.size(); ++i) {
+    by_size_[recorded_[i].num_bytes].push_back(planned_index[i]);
+  }
+
+  // Find the planned allocations that overlap in memory, by sweeping them in
+  // order of offset.
+  std::vector<int32> by_offset(plan_.size());
+  std::iota(by_offset.begin(), by_offset.end(), 0);
+  std::sort(by_offset.begin(), by_offset.end(), [this](int32 a, int32 b) {
+    return plan_[a].offset < plan_[b].offset;
+  });
+  for (int32 a = 0; a < by_offset.size(); ++a) {
+    Planned& first = plan_[by_offset[a]];
+    first.overlaps.push_back(by_offset[a]);
+    const size_t end = first.offset + RoundUpToSlabAlignment(first.num_bytes);
+    for (int32 b = a + 1;
+         b < by_offset.size() && plan_[by_offset[b]].offset < end; ++b) {
+      first.overlaps.push_back(by_offset[b]);
+      plan_[by_offset[b]].overlaps.push_back(by_offset[a]);
+    }
+  }
+
+  plan_slab_id_ = next_slab_id_++;
+  slabs_[plan_slab_id_] = {slab, slab_bytes, 0};
+  mode_ = Mode::kReplaying;
+  return true;
+}
+
+char* ReplayAllocator::DiscardPlanLocked() {
+  plan_.clear();
+  by_size_.clear();
+  auto it = slabs_.find(plan_slab_id_);
+  plan_slab_id_ = -1;
+  if (it == slabs_.end() || it->second.num_live > 0) return nullptr;
+  char* slab = it->second.base;
+  slabs_.erase(it);
+  return slab;
+}
+
+void ReplayAllocator::ResetStepLocked() {
+  overlapped_ = false;
+  diverged_ = false;
+  clock_ = 0;
+  recorded_.clear();
+  recorded_live_.clear();
+  next_by_size_.clear();
+}
+
+}  // namespace tensorflow
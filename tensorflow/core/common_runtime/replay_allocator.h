@@ -0,0 +1,201 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_REPLAY_ALLOCATOR_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_REPLAY_ALLOCATOR_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// ReplayAllocator is a wrapper for a device Allocator that plans the memory
+// of a step from the allocations made by a previous step. It is intended for
+// training loops that run the same graph with the same shapes every step.
+//
+// The owner brackets each step with BeginStep() and EndStep(). The first step
+// is recorded: every allocation is served by the wrapped allocator, and its
+// size and lifetime are noted. When the step ends, the allocations that were
+// freed within it are packed into a single slab with a best-fit heuristic
+// (like the one in XLA's HeapSimulator). The slab is obtained from the
+// wrapped allocator, and later steps are served from it at the planned
+// offsets.
+//
+// Allocations are matched to the plan by size: the i-th allocation of N
+// bytes in a step gets the offset of the i-th allocation of N bytes in the
+// recorded step, so the plan tolerates the nondeterministic order in which
+// the executor runs independent kernels. Before an offset is handed out, the
+// planned allocations whose memory overlaps it are checked, and if any of
+// them is still live the request is forwarded to the wrapped allocator.
+// If a step makes an allocation of a size that the plan does not have room
+// for, the shapes have diverged: the rest of the step is served by the
+// wrapped allocator, and the next step is recorded again. After
+// `kMaxPlanAttempts` consecutive plans have diverged, planning is disabled.
+//
+// Allocations are also forwarded to the wrapped allocator outside of a step,
+// and whenever more than one step is running, since the allocator cannot
+// tell which step they belong to.
+//
+// This class is thread-safe.
+class ReplayAllocator : public Allocator {
+ public:
+  static constexpr int kMaxPlanAttempts = 3;
+  // Steps with more allocations than this are not planned.
+  static constexpr int kMaxPlannedAllocations = 1 << 14;
+  // Offsets in the slab are aligned to this many bytes.
+  static constexpr size_t kSlabAlignment = 256;
+
+  // Takes ownership of `base`.
+  explicit ReplayAllocator(Allocator* base);
+  ~ReplayAllocator() override;
+
+  std::string Name() override { return base_->Name(); }
+  void* AllocateRaw(size_t alignment, size_t num_bytes) override {
+    return AllocateRaw(alignment, num_bytes, AllocationAttributes());
+  }
+  void* AllocateRaw(size_t alignment, size_t num_bytes,
+                    const AllocationAttributes& allocation_attr) override;
+  void DeallocateRaw(void* ptr) override;
+  bool TracksAllocationSizes() const override {
+    return base_->TracksAllocationSizes();
+  }
+  size_t RequestedSize(const void* ptr) const override;
+  size_t AllocatedSize(const void* ptr) const override;
+  int64 AllocationId(const void* ptr) const override;
+  absl::optional<AllocatorStats> GetStats() override {
+    return base_->GetStats();
+  }
+  void ClearStats() override { base_->ClearStats(); }
+  void SetSafeFrontier(uint64 count) override {
+    base_->SetSafeFrontier(count);
+  }
+  void BeginStep(int64 step_id) override;
+  void EndStep(int64 step_id) override;
+
+  // Returns true if the allocator currently has a plan to serve steps from.
+  bool HasPlan() const;
+
+  // Returns the size of the slab for the current plan, or 0 if there is
+  // none.
+  size_t PlannedBytes() const;
+
+  // Assigns an offset to each buffer in `sizes`, whose lifetimes are
+  // [`alloc_times[i]`, `free_times[i]`), so that buffers with overlapping
+  // lifetimes do not overlap in memory. Returns the size of the slab that
+  // holds them.
+  static size_t PackBuffers(const std::vector<size_t>& sizes,
+                            const std::vector<int64>& alloc_times,
+                            const std::vector<int64>& free_times,
+                            std::vector<size_t>* offsets);
+
+ private:
+  enum class Mode { kRecording, kReplaying, kDisabled };
+
+  // An allocation made while recording.
+  struct Recorded {
+    size_t num_bytes;
+    int64 alloc_time;
+    // -1 until the allocation is freed.
+    int64 free_time;
+    // False if the allocation could not be placed in the slab.
+    bool plannable;
+  };
+
+  // An allocation in the current plan.
+  struct Planned {
+    size_t num_bytes;
+    size_t offset;
+    // The planned allocations, including this one, whose memory overlaps
+    // this one's.
+    std::vector<int32> overlaps;
+    bool live = false;
+  };
+
+  // A slab, and the number of allocations in it that have not been freed.
+  struct Slab {
+    char* base;
+    size_t num_bytes;
+    int64 num_live;
+  };
+
+  // A live allocation served from a slab.
+  struct SlabAllocation {
+    int64 slab_id;
+    int32 index;
+    size_t num_bytes;
+  };
+
+  // Returns the planned allocation to serve a request of `num_bytes` from,
+  // or -1 if the request must be forwarded to `base_`.
+  int32 NextPlannedLocked(size_t num_bytes) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Builds a plan from the recorded step. Returns false if the step cannot
+  // be planned.
+  bool BuildPlanLocked() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Drops the current plan. Returns the slab to give back to `base_`, or
+  // nullptr if allocations in it are still live.
+  char* DiscardPlanLocked() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  size_t PlannedBytesLocked() const TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Clears the per-step state.
+  void ResetStepLocked() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  const std::unique_ptr<Allocator> base_;
+
+  mutable mutex mu_;
+  Mode mode_ TF_GUARDED_BY(mu_) = Mode::kRecording;
+  int num_active_steps_ TF_GUARDED_BY(mu_) = 0;
+  // True if another step began while the current step was running.
+  bool overlapped_ TF_GUARDED_BY(mu_) = false;
+  // True if the current step has diverged from the plan.
+  bool diverged_ TF_GUARDED_BY(mu_) = false;
+  // The number of consecutive plans that have diverged.
+  int num_failed_plans_ TF_GUARDED_BY(mu_) = 0;
+
+  // Recording state. `clock_` counts the allocations and deallocations in the
+  // recorded step.
+  int64 clock_ TF_GUARDED_BY(mu_) = 0;
+  std::vector<Recorded> recorded_ TF_GUARDED_BY(mu_);
+  absl::flat_hash_map<const void*, int32> recorded_live_ TF_GUARDED_BY(mu_);
+
+  // Replay state. `by_size_` maps each size to the planned allocations of
+  // that size, in recording order, and `next_by_size_` counts how many of
+  // them the current step has used.
+  std::vector<Planned> plan_ TF_GUARDED_BY(mu_);
+  absl::flat_hash_map<size_t, std::vector<int32>> by_size_ TF_GUARDED_BY(mu_);
+  absl::flat_hash_map<size_t, int32> next_by_size_ TF_GUARDED_BY(mu_);
+  int64 plan_slab_id_ TF_GUARDED_BY(mu_) = -1;
+
+  int64 next_slab_id_ TF_GUARDED_BY(mu_) = 0;
+  absl::flat_hash_map<int64, Slab> slabs_ TF_GUARDED_BY(mu_);
+  absl::flat_hash_map<const void*, SlabAllocation> slab_live_
+      TF_GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ReplayAllocator);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_REPLAY_ALLOCATOR_H_
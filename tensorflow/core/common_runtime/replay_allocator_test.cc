@@ -0,0 +1,273 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/replay_allocator.h"
+
+#include <vector>
+
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/mem.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+namespace {
+
+// An Allocator that counts its calls.
+class CountingAllocator : public Allocator {
+ public:
+  string Name() override { return "counting"; }
+  void* AllocateRaw(size_t alignment, size_t num_bytes) override {
+    ++num_allocs_;
+    ++num_live_;
+    return port::AlignedMalloc(num_bytes, alignment);
+  }
+  void DeallocateRaw(void* ptr) override {
+    --num_live_;
+    port::AlignedFree(ptr);
+  }
+
+  int num_allocs() const { return num_allocs_; }
+  int num_live() const { return num_live_; }
+
+ private:
+  int num_allocs_ = 0;
+  int num_live_ = 0;
+};
+
+class ReplayAllocatorTest : public ::testing::Test {
+ protected:
+  ReplayAllocatorTest()
+      : base_(new CountingAllocator), allocator_(new ReplayAllocator(base_)) {}
+
+  void* Allocate(size_t num_bytes) {
+    return allocator_->AllocateRaw(Allocator::kAllocatorAlignment, num_bytes);
+  }
+
+  // Runs a step that allocates 1000 and 2000 bytes, frees the first, then
+  // allocates 1000 bytes again. Returns the three pointers.
+  std::vector<void*> RunStep(int64 step_id) {
+    allocator_->BeginStep(step_id);
+    void* a = Allocate(1000);
+    void* b = Allocate(2000);
+    allocator_->DeallocateRaw(a);
+    void* c = Allocate(1000);
+    allocator_->DeallocateRaw(b);
+    allocator_->DeallocateRaw(c);
+    allocator_->EndStep(step_id);
+    return {a, b, c};
+  }
+
+  CountingAllocator* base_;  // Owned by `allocator_`.
+  std::unique_ptr<ReplayAllocator> allocator_;
+};
+
+TEST(ReplayAllocatorPackTest, DisjointLifetimesShareMemory) {
+  std::vector<size_t> offsets;
+  EXPECT_EQ(1024, ReplayAllocator::PackBuffers({1000, 1000}, {0, 2}, {1, 3},
+                                               &offsets));
+  EXPECT_EQ(0, offsets[0]);
+  EXPECT_EQ(0, offsets[1]);
+}
+
+TEST(ReplayAllocatorPackTest, OverlappingLifetimesDoNotShareMemory) {
+  std::vector<size_t> offsets;
+  EXPECT_EQ(3072, ReplayAllocator::PackBuffers({1000, 2000}, {0, 1}, {2, 3},
+                                               &offsets));
+  // The larger buffer is placed first.
+  EXPECT_EQ(1024, offsets[0]);
+  EXPECT_EQ(0, offsets[1]);
+}
+
+TEST(ReplayAllocatorPackTest, UsesSmallestGapThatFits) {
+  // Buffers 0-4 are placed one after another. Once buffers 0 and 2 are
+  // freed, they leave gaps of 2048 and 256 bytes, and buffer 5 goes in the
+  // smaller one.
+  std::vector<size_t> offsets;
+  EXPECT_EQ(4608, ReplayAllocator::PackBuffers(
+                      {2048, 1024, 256, 1024, 256, 256}, {0, 0, 0, 0, 0, 5},
+                      {4, 10, 4, 10, 10, 6}, &offsets));
+  EXPECT_EQ(0, offsets[0]);
+  EXPECT_EQ(4096, offsets[2]);
+  EXPECT_EQ(4352, offsets[4]);
+  EXPECT_EQ(4096, offsets[5]);
+}
+
+TEST_F(ReplayAllocatorTest, ReplaysRecordedStep) {
+  EXPECT_FALSE(allocator_->HasPlan());
+  RunStep(1);
+  ASSERT_TRUE(allocator_->HasPlan());
+  // The second 1000-byte buffer reuses the memory of the first.
+  EXPECT_EQ(3072, allocator_->PlannedBytes());
+  const int num_base_allocs = base_->num_allocs();
+
+  std::vector<void*> first = RunStep(2);
+  EXPECT_EQ(num_base_allocs, base_->num_allocs());
+  EXPECT_EQ(first[0], first[2]);
+  EXPECT_NE(first[0], first[1]);
+
+  // Later steps get the same offsets.
+  std::vector<void*> second = RunStep(3);
+  EXPECT_EQ(first, second);
+  EXPECT_EQ(num_base_allocs, base_->num_allocs());
+  EXPECT_TRUE(allocator_->HasPlan());
+}
+
+TEST_F(ReplayAllocatorTest, ReportsSizesOfPlannedAllocations) {
+  RunStep(1);
+  allocator_->BeginStep(2);
+  void* ptr = Allocate(1000);
+  EXPECT_EQ(1000, allocator_->RequestedSize(ptr));
+  EXPECT_EQ(1024, allocator_->AllocatedSize(ptr));
+  allocator_->DeallocateRaw(ptr);
+  allocator_->EndStep(2);
+}
+
+TEST_F(ReplayAllocatorTest, ForwardsWhenPlannedMemoryIsLive) {
+  RunStep(1);
+  allocator_->BeginStep(2);
+  void* a = Allocate(1000);
+  void* b = Allocate(2000);
+  // `a` is still live, so the second 1000-byte buffer cannot take its
+  // planned place.
+  const int num_base_allocs = base_->num_allocs();
+  void* c = Allocate(1000);
+  EXPECT_NE(a, c);
+  EXPECT_EQ(num_base_allocs + 1, base_->num_allocs());
+  allocator_->DeallocateRaw(a);
+  allocator_->DeallocateRaw(b);
+  allocator_->DeallocateRaw(c);
+  allocator_->EndStep(2);
+  // Running out of order is not a divergence.
+  EXPECT_TRUE(allocator_->HasPlan());
+}
+
+TEST_F(ReplayAllocatorTest, DivergedStepFallsBackAndIsRecordedAgain) {
+  RunStep(1);
+  ASSERT_TRUE(allocator_->HasPlan());
+  const int num_live = base_->num_live();
+
+  allocator_->BeginStep(2);
+  void* a = Allocate(1000);
+  void* d = Allocate(4000);
+  allocator_->DeallocateRaw(a);
+  allocator_->DeallocateRaw(d);
+  allocator_->EndStep(2);
+  // The slab was given back.
+  EXPECT_FALSE(allocator_->HasPlan());
+  EXPECT_EQ(num_live - 1, base_->num_live());
+
+  // Step 3 is recorded, and planned.
+  RunStep(3);
+  EXPECT_TRUE(allocator_->HasPlan());
+  EXPECT_EQ(3072, allocator_->PlannedBytes());
+}
+
+TEST_F(ReplayAllocatorTest, KeepsSlabUntilLastAllocationIsFreed) {
+  RunStep(1);
+  allocator_->BeginStep(2);
+  void* a = Allocate(1000);
+  void* d = Allocate(4000);
+  allocator_->DeallocateRaw(d);
+  allocator_->EndStep(2);
+  EXPECT_FALSE(allocator_->HasPlan());
+  const int num_live = base_->num_live();
+  allocator_->DeallocateRaw(a);
+  EXPECT_EQ(num_live - 1, base_->num_live());
+}
+
+TEST_F(ReplayAllocatorTest, DoesNotPlanAllocationsThatOutliveStep) {
+  allocator_->BeginStep(1);
+  void* output = Allocate(512);
+  allocator_->DeallocateRaw(Allocate(1000));
+  allocator_->EndStep(1);
+  allocator_->DeallocateRaw(output);
+  ASSERT_TRUE(allocator_->HasPlan());
+  EXPECT_EQ(1024, allocator_->PlannedBytes());
+
+  allocator_->BeginStep(2);
+  const int num_base_allocs = base_->num_allocs();
+  output = Allocate(512);
+  EXPECT_EQ(num_base_allocs + 1, base_->num_allocs());
+  allocator_->DeallocateRaw(Allocate(1000));
+  EXPECT_EQ(num_base_allocs + 1, base_->num_allocs());
+  allocator_->EndStep(2);
+  allocator_->DeallocateRaw(output);
+  EXPECT_TRUE(allocator_->HasPlan());
+}
+
+TEST_F(ReplayAllocatorTest, DoesNotRecordOverlappingSteps) {
+  allocator_->BeginStep(1);
+  allocator_->BeginStep(2);
+  allocator_->DeallocateRaw(Allocate(1000));
+  allocator_->EndStep(1);
+  allocator_->DeallocateRaw(Allocate(1000));
+  allocator_->EndStep(2);
+  EXPECT_FALSE(allocator_->HasPlan());
+  // Nor does it record outside of a step.
+  allocator_->DeallocateRaw(Allocate(1000));
+  EXPECT_FALSE(allocator_->HasPlan());
+}
+
+TEST_F(ReplayAllocatorTest, GivesUpAfterRepeatedDivergence) {
+  for (int i = 0; i < ReplayAllocator::kMaxPlanAttempts; ++i) {
+    allocator_->BeginStep(2 * i);
+    allocator_->DeallocateRaw(Allocate(1000 + i));
+    allocator_->EndStep(2 * i);
+    ASSERT_TRUE(allocator_->HasPlan());
+    allocator_->BeginStep(2 * i + 1);
+    allocator_->DeallocateRaw(Allocate(2000 + i));
+    allocator_->EndStep(2 * i + 1);
+    EXPECT_FALSE(allocator_->HasPlan());
+  }
+  RunStep(100);
+  EXPECT_FALSE(allocator_->HasPlan());
+}
+
+// Runs steps that allocate and free `num_buffers` buffers of varying sizes,
+// each live across the next one. Compares serving them from a plan to
+// forwarding them to the wrapped allocator.
+void BM_ReplaySteps(int iters, int num_buffers, bool plan) {
+  testing::StopTiming();
+  ReplayAllocator allocator(new CountingAllocator);
+  std::vector<void*> ptrs(num_buffers);
+  testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    if (plan) allocator.BeginStep(i);
+    for (int j = 0; j < num_buffers; ++j) {
+      ptrs[j] = allocator.AllocateRaw(Allocator::kAllocatorAlignment,
+                                      (j % 16 + 1) * 1024);
+      if (j > 0) allocator.DeallocateRaw(ptrs[j - 1]);
+    }
+    allocator.DeallocateRaw(ptrs[num_buffers - 1]);
+    if (plan) allocator.EndStep(i);
+  }
+  testing::StopTiming();
+  testing::SetLabel(strings::StrCat(
+      "planned_bytes=", allocator.PlannedBytes()));
+}
+
+void BM_ReplaySteps_Planned(int iters, int num_buffers) {
+  BM_ReplaySteps(iters, num_buffers, /*plan=*/true);
+}
+void BM_ReplaySteps_Forwarded(int iters, int num_buffers) {
+  BM_ReplaySteps(iters, num_buffers, /*plan=*/false);
+}
+
+BENCHMARK(BM_ReplaySteps_Planned)->Arg(100)->Arg(1000);
+BENCHMARK(BM_ReplaySteps_Forwarded)->Arg(100)->Arg(1000);
+
+}  // namespace
+}  // namespace tensorflow
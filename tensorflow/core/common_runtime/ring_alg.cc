@@ -374,8 +374,54 @@ string RingAlg::RingField::DebugString() const {
   return rv;
 }
 
+Status RingAlg::EncodeChunk(RingField* rf) {
+  TF_RETURN_IF_ERROR(collective_util::ComputeUnaryOp(
+      col_ctx_->op_ctx, col_ctx_->op_params, col_ctx_->device,
+      col_params_->encode_op.get(), &rf->chunk, &rf->wire_chunk));
+  if (rf->second_pass && !rf->do_recv) {
+    // This device is the source of the final value of the chunk.  Keep the
+    // value the other devices will decode so that all of them agree.
+    return DecodeChunk(rf, &rf->chunk);
+  }
+  return Status::OK();
+}
+
+Status RingAlg::DecodeChunk(RingField* rf, Tensor* dst) {
+  Tensor decoded;
+  TF_RETURN_IF_ERROR(collective_util::ComputeUnaryOp(
+      col_ctx_->op_ctx, col_ctx_->op_params, col_ctx_->device,
+      col_params_->decode_op.get(), &rf->wire_chunk, &decoded));
+  if (dst == &rf->tmp_chunk) {
+    *dst = decoded;
+    return Status::OK();
+  }
+  // `dst` aliases the output, so the decoded values must be copied into it.
+  Notification note;
+  Status status;
+  CollectiveRemoteAccessLocal::MemCpyAsync(
+      col_ctx_->op_ctx->op_device_context(),
+      col_ctx_->op_ctx->op_device_context(), col_ctx_->device,
+      col_ctx_->device, col_ctx_->op_ctx->output_alloc_attr(0),
+      col_ctx_->op_ctx->output_alloc_attr(0), &decoded, dst,
+      0 /*dev_to_dev_stream_index*/, [&note, &status](const Status& s) {
+        status.Update(s);
+        note.Notify();
+      });
+  note.WaitForNotification();
+  return status;
+}
+
 void RingAlg::DispatchSend(RingField* rf, const StatusCallback& done) {
   DCHECK(rf->do_send);
+  const Tensor* send_tensor = &rf->chunk;
+  if (col_params_->encode_op) {
+    Status s = EncodeChunk(rf);
+    if (!s.ok()) {
+      done(s);
+      return;
+    }
+    send_tensor = &rf->wire_chunk;
+  }
   string send_buf_key = RingAlgBufKey(name_, col_ctx_->exec_key,
                                       rf->second_pass, rf->sc_idx, rf->rank);
   VLOG(3) << "DispatchSend rank=" << col_params_->default_rank << " send key "
@@ -388,7 +434,7 @@ void RingAlg::DispatchSend(RingField* rf, const StatusCallback& done) {
       col_params_->instance.device_names[send_to_dev_idx],
       col_params_->instance.task_names[send_to_dev_idx], send_buf_key,
       col_ctx_->device, col_ctx_->op_ctx->op_device_context(),
-      col_ctx_->op_ctx->output_alloc_attr(0), &rf->chunk,
+      col_ctx_->op_ctx->output_alloc_attr(0), send_tensor,
       col_ctx_->device_locality, done);
 }
 
@@ -403,6 +449,13 @@ void RingAlg::DispatchRecv(RingField* rf, const StatusCallback& done) {
   Tensor* dst_tensor = (!rf->second_pass && (col_params_->merge_op != nullptr))
                            ? &rf->tmp_chunk
                            : &rf->chunk;
+  if (col_params_->decode_op) {
+    rf->wire_chunk =
+        Tensor(col_ctx_->device->GetAllocator(
+                   col_ctx_->op_ctx->output_alloc_attr(0)),
+               col_params_->decode_op->input_type(0), rf->chunk.shape());
+    dst_tensor = &rf->wire_chunk;
+  }
   col_ctx_->col_exec->remote_access()->RecvFromPeer(
       col_params_->instance.device_names[rf->recv_dev_idx],
       col_params_->instance.task_names[rf->recv_dev_idx],
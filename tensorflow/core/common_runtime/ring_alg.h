@@ -81,6 +81,7 @@ class RingAlg : public CollectiveImplementationInterface {
     bool is_final = false;  // is the last field in the pass for this rank
     Tensor chunk;           // alias to field values
     Tensor tmp_chunk;
+    Tensor wire_chunk;  // chunk as transferred, if compressed
     Status status;
     string DebugString() const;
   };
@@ -90,6 +91,12 @@ class RingAlg : public CollectiveImplementationInterface {
   void DispatchSend(RingField* rf, const StatusCallback& done);
   void DispatchRecv(RingField* rf, const StatusCallback& done);
 
+  // When col_params_ has an encode_op, chunks are sent in its output type.
+  // EncodeChunk fills rf->wire_chunk from rf->chunk, and DecodeChunk writes
+  // the received rf->wire_chunk to `dst`.
+  Status EncodeChunk(RingField* rf);
+  Status DecodeChunk(RingField* rf, Tensor* dst);
+
   // For constructing log messages for debugging.
   string FieldState();
   string TensorDebugString(const Tensor& tensor);
@@ -252,6 +252,14 @@ bool RingReducer::RunAsyncParts() {
           case RF_RECV:
             CHECK_GT(recv_pending_count, 0);
             --recv_pending_count;
+            if (col_params_->decode_op) {
+              Status s = DecodeChunk(
+                  rf, rf->second_pass ? &rf->chunk : &rf->tmp_chunk);
+              if (!s.ok()) {
+                aborted = true;
+                StartAbort(s);
+              }
+            }
             if (!rf->second_pass) {
               rf->action = RF_REDUCE;
               Status s = collective_util::ComputeBinOp(
@@ -15,6 +15,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/ring_reducer.h"
 
 #include <algorithm>
+#include <cmath>
 
 #include "absl/memory/memory.h"
 #include "tensorflow/core/common_runtime/base_collective_executor.h"
@@ -130,6 +131,19 @@ std::unique_ptr<OpKernel> GetDiv(DataType dtype, const DeviceType& device_type,
   return GetKernel(node_def, device_type, device);
 }
 
+std::unique_ptr<OpKernel> GetCast(DataType src, DataType dst,
+                                  const DeviceType& device_type,
+                                  DeviceBase* device) {
+  NodeDef node_def;
+  NodeDefBuilder builder("cast_node", "Cast");
+  TF_CHECK_OK(builder.Attr("SrcT", src)
+                  .Attr("DstT", dst)
+                  .Attr("Truncate", false)
+                  .Input(FakeInput(src))
+                  .Finalize(&node_def));
+  return GetKernel(node_def, device_type, device);
+}
+
 static int64 kStepId = 123;
 
 class RingReducerTest : public ::testing::Test {
@@ -343,8 +357,18 @@ class RingReducerTest : public ::testing::Test {
         for (int i = 0; i < tensor_len; ++i) {
           switch (dtype) {
             case DT_FLOAT:
-              EXPECT_FLOAT_EQ(expected[i], alias(i))
-                  << "Mismatch at device " << di << " index " << i;
+              if (wire_type_ != DT_INVALID) {
+                // Compression is lossy, but every device must end up with
+                // the same value.
+                EXPECT_NEAR(expected[i], alias(i),
+                            2e-2 * std::abs(expected[i]) + 1e-2)
+                    << "Mismatch at device " << di << " index " << i;
+                EXPECT_EQ(instances_[0]->tensor_.flat<T>()(i), alias(i))
+                    << "Disagreement at device " << di << " index " << i;
+              } else {
+                EXPECT_FLOAT_EQ(expected[i], alias(i))
+                    << "Mismatch at device " << di << " index " << i;
+              }
               break;
             case DT_DOUBLE:
               EXPECT_DOUBLE_EQ(expected[i], alias(i))
@@ -468,6 +492,14 @@ class RingReducerTest : public ::testing::Test {
           GetAdd(col_params_.instance.data_type, device_type_, device_);
       col_params_.final_op =
           GetDiv(col_params_.instance.data_type, device_type_, device_);
+      if (parent_->wire_type_ != DT_INVALID) {
+        col_params_.encode_op =
+            GetCast(col_params_.instance.data_type, parent_->wire_type_,
+                    device_type_, device_);
+        col_params_.decode_op =
+            GetCast(parent_->wire_type_, col_params_.instance.data_type,
+                    device_type_, device_);
+      }
 
       // Prepare an OpKernelContext.
       OpKernelContext::Params op_params;
@@ -539,6 +571,8 @@ class RingReducerTest : public ::testing::Test {
 
   bool stop_ = false;
   DeviceType device_type_;
+  // Data type chunks are sent in, or DT_INVALID to send them uncompressed.
+  DataType wire_type_ = DT_INVALID;
   TestCollectiveExecutorMgr col_exec_mgr_;
   CollectiveExecutor* col_exec_;
   CollectiveRemoteAccessLocal* rma_;
@@ -702,6 +736,16 @@ DEF_TEST(INT64, CPU, 2, 8, 3, 4095, 0)
 DEF_TEST(FLOAT, CPU, 2, 8, 1, 9408, 1)
 DEF_TEST(FLOAT, CPU, 2, 8, 1, 9408, 7)
 DEF_TEST(FLOAT, CPU, 2, 8, 2, 9408, 11)
+
+TEST_F(RingReducerTest, Fp16Compression) {
+  wire_type_ = DT_HALF;
+  RunTest<float>(DT_FLOAT, DEVICE_CPU, 1, 2, 1, 1001, 0);
+}
+
+TEST_F(RingReducerTest, Bf16Compression) {
+  wire_type_ = DT_BFLOAT16;
+  RunTest<float>(DT_FLOAT, DEVICE_CPU, 2, 4, 1, 1001, 0);
+}
 #endif
 
 #if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
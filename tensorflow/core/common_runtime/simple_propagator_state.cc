@@ -16,6 +16,7 @@ limitations under the License.
 
 #include <atomic>
 
+#include "absl/memory/memory.h"
 #include "tensorflow/core/common_runtime/propagator_debug_utils.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/profiler/lib/traceme.h"
@@ -23,27 +24,56 @@ limitations under the License.
 namespace tensorflow {
 
 SimplePropagatorState::SimplePropagatorState(
-    const ImmutableExecutorState& immutable_state, int64 step_id, bool vlog)
+    const ImmutableExecutorState& immutable_state, int64 step_id, bool vlog,
+    StatePool* state_pool)
     : SimplePropagatorState(immutable_state, step_id,
-                            immutable_state.get_root_frame_info(), vlog) {}
+                            immutable_state.get_root_frame_info(), vlog,
+                            state_pool) {}
 
 SimplePropagatorState::SimplePropagatorState(
     const ImmutableExecutorState& immutable_state, int64 step_id,
-    const ImmutableExecutorState::FrameInfo& finfo, bool vlog)
+    const ImmutableExecutorState::FrameInfo& finfo, bool vlog,
+    StatePool* state_pool)
     : immutable_state_(immutable_state),
       step_id_(step_id),
       vlog_(vlog || VLOG_IS_ON(1)),
-      input_tensors_(finfo.total_inputs),
-      pending_(
-          new std::atomic<int32>[immutable_state.graph_view().num_nodes()]),
+      state_pool_(state_pool),
+      buffers_(GetBuffers(immutable_state, finfo, state_pool)),
+      input_tensors_(&buffers_->input_tensors),
+      pending_(buffers_->pending.get()),
       active_(vlog_ ? new std::vector<bool>(
                           immutable_state.graph_view().num_nodes())
                     : nullptr),
       nodes_(finfo.nodes.get()) {
-  immutable_state_.copy_pending_counts(pending_.get());
+  immutable_state_.copy_pending_counts(pending_);
 }
 
-SimplePropagatorState::~SimplePropagatorState() {}
+SimplePropagatorState::~SimplePropagatorState() {
+  if (state_pool_ != nullptr) {
+    // Entries are normally cleared by the node that consumes them, but a step
+    // that fails or is cancelled may leave some behind. Release their tensors
+    // before the buffers are reused by another step.
+    for (Entry& entry : *input_tensors_) {
+      entry.ClearVal();
+    }
+    state_pool_->Put(std::move(buffers_));
+  }
+}
+
+/*static*/ std::unique_ptr<SimplePropagatorState::StepBuffers>
+SimplePropagatorState::GetBuffers(
+    const ImmutableExecutorState& immutable_state,
+    const ImmutableExecutorState::FrameInfo& finfo, StatePool* state_pool) {
+  if (state_pool != nullptr) {
+    std::unique_ptr<StepBuffers> buffers = state_pool->Get();
+    if (buffers != nullptr) return buffers;
+  }
+  auto buffers = absl::make_unique<StepBuffers>();
+  buffers->input_tensors.resize(finfo.total_inputs);
+  buffers->pending.reset(
+      new std::atomic<int32>[immutable_state.graph_view().num_nodes()]);
+  return buffers;
+}
 
 void SimplePropagatorState::ActivateRoots(
     gtl::ArraySlice<const NodeItem*> roots, TaggedNodeSeq* ready) {
@@ -84,9 +114,9 @@ void SimplePropagatorState::PropagateOutputs(const TaggedNode& tagged_node,
     // count has dropped to zero before another thread finishes updating the
     // input.
     if (e.is_last) {
-      input_tensors_[dst_loc] = std::move((*outputs)[src_slot]);
+      (*input_tensors_)[dst_loc] = std::move((*outputs)[src_slot]);
     } else {
-      input_tensors_[dst_loc] = (*outputs)[src_slot];
+      (*input_tensors_)[dst_loc] = (*outputs)[src_slot];
     }
 
     int32 previous_num_pending =
@@ -108,19 +138,19 @@ void SimplePropagatorState::DumpState() {
   // Dump any waiting nodes that are holding on to tensors.
   for (const NodeItem* node : *nodes_) {
     if (pending_[node->node_id]) {
-      DumpPendingNodeState(*node, input_tensors_.data(), false);
+      DumpPendingNodeState(*node, input_tensors_->data(), false);
     }
   }
   // Then the active nodes.
   for (const NodeItem* node : *nodes_) {
     if ((*active_)[node->node_id]) {
-      DumpActiveNodeState(*node, input_tensors_.data());
+      DumpActiveNodeState(*node, input_tensors_->data());
     }
   }
   // Show all input tensors in use.
   size_t total_bytes = 0;
-  for (size_t i = 0; i < input_tensors_.size(); ++i) {
-    const Entry& input = input_tensors_[i];
+  for (size_t i = 0; i < input_tensors_->size(); ++i) {
+    const Entry& input = (*input_tensors_)[i];
     const Tensor* tensor = GetTensorValueForDump(input);
     if (tensor && tensor->IsInitialized()) {
       LOG(WARNING) << "    Input " << i << ": "
@@ -15,6 +15,7 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_COMMON_RUNTIME_SIMPLE_PROPAGATOR_STATE_H_
 #define TENSORFLOW_CORE_COMMON_RUNTIME_SIMPLE_PROPAGATOR_STATE_H_
 
+#include <memory>
 #include <vector>
 
 #include "tensorflow/core/common_runtime/entry.h"
@@ -46,8 +47,61 @@ namespace tensorflow {
 // dispatches `TaggedNode`s by adding them to a `TaggedNodeSeq`.
 class SimplePropagatorState {
  public:
+  // The per-step buffers of a `SimplePropagatorState`, whose size depends only
+  // on the graph.
+  struct StepBuffers {
+    // The i-th node's j-th input is stored at
+    // `input_tensors[impl_->nodes[i].input_start + j]`.
+    std::vector<Entry> input_tensors;
+    // The number of pending inputs of each node, indexed by node ID.
+    std::unique_ptr<std::atomic<int32>[]> pending;
+  };
+
+  // A cache of `StepBuffers`, which lets the steps of one executor reuse the
+  // buffers of earlier steps instead of allocating them anew. At most
+  // `max_cached` sets of buffers are kept; buffers released while the pool is
+  // full are freed.
+  //
+  // This class is thread-safe.
+  class StatePool {
+   public:
+    static constexpr int kDefaultMaxCached = 8;
+
+    explicit StatePool(int max_cached = kDefaultMaxCached)
+        : max_cached_(max_cached) {}
+
+    // Returns a cached set of buffers, or nullptr if the pool is empty.
+    std::unique_ptr<StepBuffers> Get() {
+      mutex_lock l(mu_);
+      if (free_.empty()) return nullptr;
+      std::unique_ptr<StepBuffers> buffers = std::move(free_.back());
+      free_.pop_back();
+      return buffers;
+    }
+
+    // Returns `buffers` to the pool.
+    //
+    // REQUIRES: Every entry of `buffers->input_tensors` is `NO_VALUE`.
+    void Put(std::unique_ptr<StepBuffers> buffers) {
+      mutex_lock l(mu_);
+      if (free_.size() < static_cast<size_t>(max_cached_)) {
+        free_.push_back(std::move(buffers));
+      }
+    }
+
+   private:
+    const int max_cached_;
+    mutex mu_;
+    std::vector<std::unique_ptr<StepBuffers>> free_ TF_GUARDED_BY(mu_);
+
+    TF_DISALLOW_COPY_AND_ASSIGN(StatePool);
+  };
+
+  // If `state_pool` is not null, the per-step buffers are taken from and
+  // returned to that pool.
   SimplePropagatorState(const ImmutableExecutorState& immutable_state,
-                        int64 step_id, bool vlog);
+                        int64 step_id, bool vlog,
+                        StatePool* state_pool = nullptr);
   ~SimplePropagatorState();
 
   // A `TaggedNode` corresponds to a single invocation of a node's kernel,
@@ -55,6 +109,7 @@ class SimplePropagatorState {
   struct TaggedNode {
     const NodeItem* node_item;
 
+    TaggedNode() = default;
     explicit TaggedNode(const NodeItem* node_item) : node_item(node_item) {}
 
     const NodeItem& get_node_item() const { return *node_item; }
@@ -126,7 +181,7 @@ class SimplePropagatorState {
     // `PrepareInputs()`.
     CHECK_EQ(pending_[tagged_node.node_item->node_id], 0);
 #endif  // defined(THREAD_SANITIZER) || defined(DEBUG)
-    return input_tensors_.data() + tagged_node.node_item->input_start;
+    return input_tensors_->data() + tagged_node.node_item->input_start;
   }
 
   FrameAndIter GetFrameAndIter(const TaggedNode& tagged_node) const {
@@ -158,23 +213,30 @@ class SimplePropagatorState {
   SimplePropagatorState(const ImmutableExecutorState& immutable_state_,
                         int64 step_id,
                         const ImmutableExecutorState::FrameInfo& finfo,
-                        bool vlog);
+                        bool vlog, StatePool* state_pool);
+
+  // Returns buffers for a step of the given graph, either from `state_pool`
+  // or newly allocated.
+  static std::unique_ptr<StepBuffers> GetBuffers(
+      const ImmutableExecutorState& immutable_state,
+      const ImmutableExecutorState::FrameInfo& finfo, StatePool* state_pool);
 
   const ImmutableExecutorState& immutable_state_;
   const int64 step_id_;
   const bool vlog_;
 
-  // The i-th node's j-th input is stored at
-  // `input_tensors[impl_->nodes[i].input_start + j]`.
+  StatePool* const state_pool_;  // Not owned. May be null.
+  std::unique_ptr<StepBuffers> buffers_;
+
+  // Aliases of `buffers_->input_tensors` and `buffers_->pending`.
   //
   // NOTE: No need to protect input_tensors[i] by any locks because it
   // is resized once. Each element of input_tensors is written once by the
   // source node of an edge and is cleared by the destination of the same
   // edge. The destination node always runs after the source node, so there
   // is never concurrent access to the same entry.
-  std::vector<Entry> input_tensors_;
-
-  std::unique_ptr<std::atomic<int32>[]> pending_;
+  std::vector<Entry>* const input_tensors_;
+  std::atomic<int32>* const pending_;
 
   // If `vlog_` is true, this stores a bit vector of active nodes, indexed by
   // node ID.
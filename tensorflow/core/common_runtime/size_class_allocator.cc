@@ -0,0 +1,210 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/size_class_allocator.h"
+
+#include <algorithm>
+
+#include "tensorflow/core/lib/core/bits.h"
+#include "tensorflow/core/lib/strings/numbers.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+
+constexpr size_t SizeClassAllocator::kMinClassBytes;
+
+SizeClassAllocator::SizeClassAllocator(SubAllocator* sub_allocator,
+                                       size_t reserve_bytes,
+                                       size_t max_cached_bytes,
+                                       const string& name)
+    : name_(name),
+      sub_allocator_(sub_allocator),
+      max_cached_bytes_(max_cached_bytes) {
+  if (reserve_bytes > 0) {
+    reserved_base_ = sub_allocator_->Alloc(kAllocatorAlignment, reserve_bytes);
+    if (reserved_base_ == nullptr) {
+      LOG(WARNING) << name_ << ": failed to reserve "
+                   << strings::HumanReadableNumBytes(reserve_bytes)
+                   << "; allocations will not be served from a reserved pool.";
+    } else {
+      reserved_bytes_ = reserve_bytes;
+      VLOG(1) << name_ << ": reserved "
+              << strings::HumanReadableNumBytes(reserve_bytes);
+    }
+  }
+  mutex_lock l(mu_);
+  stats_.bytes_reserved = reserved_bytes_;
+  stats_.peak_bytes_reserved = reserved_bytes_;
+}
+
+SizeClassAllocator::~SizeClassAllocator() {
+  std::vector<std::pair<void*, size_t>> to_free;
+  {
+    mutex_lock l(mu_);
+    if (!in_use_.empty()) {
+      LOG(WARNING) << name_ << " destroyed with " << in_use_.size()
+                   << " buffers still in use";
+    }
+    TakeCachedBuffersLocked(&to_free);
+  }
+  for (const auto& buffer : to_free) {
+    sub_allocator_->Free(buffer.first, buffer.second);
+  }
+  if (reserved_base_ != nullptr) {
+    sub_allocator_->Free(reserved_base_, reserved_bytes_);
+  }
+}
+
+size_t SizeClassAllocator::RoundUpToClass(size_t num_bytes) {
+  if (num_bytes <= kMinClassBytes) return kMinClassBytes;
+  const size_t pow2 = size_t{1} << Log2Ceiling64(num_bytes);
+  const size_t midpoint = pow2 / 2 + pow2 / 4;
+  return num_bytes <= midpoint ? midpoint : pow2;
+}
+
+void* SizeClassAllocator::AllocateRaw(size_t alignment, size_t num_bytes) {
+  if (num_bytes == 0) return nullptr;
+  const size_t class_bytes = RoundUpToClass(num_bytes);
+  const bool cacheable = alignment <= kAllocatorAlignment;
+  void* ptr = nullptr;
+  std::vector<std::pair<void*, size_t>> to_free;
+  {
+    mutex_lock l(mu_);
+    if (cacheable) {
+      auto it = free_lists_.find(class_bytes);
+      if (it != free_lists_.end() && !it->second.empty()) {
+        ptr = it->second.back();
+        it->second.pop_back();
+        if (!IsReserved(ptr)) cached_bytes_ -= class_bytes;
+      }
+    }
+    if (ptr == nullptr) {
+      ptr = NewBufferLocked(alignment, class_bytes);
+      if (ptr == nullptr && cached_bytes_ > 0) {
+        // Give the cached buffers back to the SubAllocator, and try again.
+        TakeCachedBuffersLocked(&to_free);
+        for (const auto& buffer : to_free) {
+          sub_allocator_->Free(buffer.first, buffer.second);
+        }
+        ptr = NewBufferLocked(alignment, class_bytes);
+      }
+    }
+    if (ptr != nullptr) {
+      in_use_[ptr] = {num_bytes, class_bytes, cacheable};
+      ++stats_.num_allocs;
+      stats_.bytes_in_use += class_bytes;
+      stats_.peak_bytes_in_use =
+          std::max(stats_.peak_bytes_in_use, stats_.bytes_in_use);
+      stats_.largest_alloc_size =
+          std::max<int64>(stats_.largest_alloc_size, num_bytes);
+    }
+  }
+  if (ptr == nullptr) {
+    LOG(WARNING) << name_ << " ran out of memory trying to allocate "
+                 << strings::HumanReadableNumBytes(num_bytes);
+  }
+  return ptr;
+}
+
+void SizeClassAllocator::DeallocateRaw(void* ptr) {
+  if (ptr == nullptr) return;
+  size_t bytes_to_free = 0;
+  {
+    mutex_lock l(mu_);
+    auto it = in_use_.find(ptr);
+    CHECK(it != in_use_.end()) << name_ << ": freeing unknown pointer " << ptr;
+    const Buffer buffer = it->second;
+    in_use_.erase(it);
+    stats_.bytes_in_use -= buffer.class_bytes;
+    if (IsReserved(ptr)) {
+      free_lists_[buffer.class_bytes].push_back(ptr);
+    } else if (buffer.cacheable &&
+               cached_bytes_ + buffer.class_bytes <= max_cached_bytes_) {
+      free_lists_[buffer.class_bytes].push_back(ptr);
+      cached_bytes_ += buffer.class_bytes;
+    } else {
+      bytes_to_free = buffer.class_bytes;
+      stats_.bytes_reserved -= bytes_to_free;
+    }
+  }
+  if (bytes_to_free > 0) {
+    sub_allocator_->Free(ptr, bytes_to_free);
+  }
+}
+
+size_t SizeClassAllocator::RequestedSize(const void* ptr) const {
+  mutex_lock l(mu_);
+  auto it = in_use_.find(ptr);
+  CHECK(it != in_use_.end()) << name_ << ": unknown pointer " << ptr;
+  return it->second.requested_bytes;
+}
+
+size_t SizeClassAllocator::AllocatedSize(const void* ptr) const {
+  mutex_lock l(mu_);
+  auto it = in_use_.find(ptr);
+  CHECK(it != in_use_.end()) << name_ << ": unknown pointer " << ptr;
+  return it->second.class_bytes;
+}
+
+absl::optional<AllocatorStats> SizeClassAllocator::GetStats() {
+  mutex_lock l(mu_);
+  return stats_;
+}
+
+void SizeClassAllocator::ClearStats() {
+  mutex_lock l(mu_);
+  stats_.num_allocs = 0;
+  stats_.peak_bytes_in_use = stats_.bytes_in_use;
+  stats_.largest_alloc_size = 0;
+  stats_.peak_bytes_reserved = stats_.bytes_reserved;
+}
+
+void* SizeClassAllocator::NewBufferLocked(size_t alignment,
+                                          size_t class_bytes) {
+  // Class sizes are multiples of 128 bytes, so bumping through the reserved
+  // pool preserves kAllocatorAlignment.
+  if (alignment <= kAllocatorAlignment &&
+      reserved_offset_ + class_bytes <= reserved_bytes_) {
+    void* ptr = static_cast<char*>(reserved_base_) + reserved_offset_;
+    reserved_offset_ += class_bytes;
+    return ptr;
+  }
+  void* ptr = sub_allocator_->Alloc(std::max(alignment, kAllocatorAlignment),
+                                    class_bytes);
+  if (ptr != nullptr) {
+    stats_.bytes_reserved += class_bytes;
+    stats_.peak_bytes_reserved =
+        std::max(stats_.peak_bytes_reserved, stats_.bytes_reserved);
+  }
+  return ptr;
+}
+
+void SizeClassAllocator::TakeCachedBuffersLocked(
+    std::vector<std::pair<void*, size_t>>* to_free) {
+  for (auto& it : free_lists_) {
+    std::vector<void*>& free_list = it.second;
+    auto reserved_end =
+        std::partition(free_list.begin(), free_list.end(),
+                       [this](void* ptr) { return IsReserved(ptr); });
+    for (auto ptr_it = reserved_end; ptr_it != free_list.end(); ++ptr_it) {
+      to_free->emplace_back(*ptr_it, it.first);
+      stats_.bytes_reserved -= it.first;
+    }
+    free_list.erase(reserved_end, free_list.end());
+  }
+  cached_bytes_ = 0;
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,117 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_SIZE_CLASS_ALLOCATOR_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_SIZE_CLASS_ALLOCATOR_H_
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// An allocator for memory that is expensive to obtain from its SubAllocator,
+// such as pinned host memory. Requests are rounded up to the next size class,
+// where the classes are the powers of two and the midpoints between them
+// (256, 384, 512, 768, 1024, 1536, ...), so that at most a third of each
+// buffer is wasted. Freed buffers are kept on a free list for their class and
+// handed out again to any request that rounds to the same class.
+//
+// If `reserve_bytes` is positive, a pool of that size is obtained from the
+// SubAllocator at construction, and new buffers are carved out of it until it
+// is exhausted. Buffers carved from the pool are always kept for reuse. Other
+// buffers are returned to the SubAllocator when the free lists would
+// otherwise hold more than `max_cached_bytes`.
+//
+// This class is thread-safe.
+class SizeClassAllocator : public Allocator {
+ public:
+  static constexpr size_t kMinClassBytes = 256;
+
+  // Takes ownership of `sub_allocator`.
+  SizeClassAllocator(SubAllocator* sub_allocator, size_t reserve_bytes,
+                     size_t max_cached_bytes, const string& name);
+  ~SizeClassAllocator() override;
+
+  string Name() override { return name_; }
+  void* AllocateRaw(size_t alignment, size_t num_bytes) override;
+  void DeallocateRaw(void* ptr) override;
+  bool TracksAllocationSizes() const override { return true; }
+  size_t RequestedSize(const void* ptr) const override;
+  size_t AllocatedSize(const void* ptr) const override;
+  absl::optional<AllocatorStats> GetStats() override;
+  void ClearStats() override;
+
+  // Returns the size of the class that `num_bytes` rounds up to.
+  static size_t RoundUpToClass(size_t num_bytes);
+
+ private:
+  struct Buffer {
+    size_t requested_bytes;
+    size_t class_bytes;
+    // False for buffers with an alignment larger than kAllocatorAlignment,
+    // which are never put on a free list.
+    bool cacheable;
+  };
+
+  bool IsReserved(const void* ptr) const {
+    const char* p = static_cast<const char*>(ptr);
+    const char* base = static_cast<const char*>(reserved_base_);
+    return reserved_bytes_ > 0 && p >= base && p < base + reserved_bytes_;
+  }
+
+  // Returns a new buffer of `class_bytes` bytes, carved from the reserved
+  // pool if possible, or nullptr if the SubAllocator is out of memory.
+  void* NewBufferLocked(size_t alignment, size_t class_bytes)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Removes the free buffers that are not from the reserved pool from the
+  // free lists, and appends them to `to_free`.
+  void TakeCachedBuffersLocked(std::vector<std::pair<void*, size_t>>* to_free)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  const string name_;
+  std::unique_ptr<SubAllocator> sub_allocator_;
+  const size_t max_cached_bytes_;
+
+  // The reserved pool, and the number of bytes of it handed out so far.
+  void* reserved_base_ = nullptr;
+  size_t reserved_bytes_ = 0;
+  size_t reserved_offset_ TF_GUARDED_BY(mu_) = 0;
+
+  mutable mutex mu_;
+  // Buffers that are in use, keyed by address.
+  absl::flat_hash_map<const void*, Buffer> in_use_ TF_GUARDED_BY(mu_);
+  // Free buffers, keyed by class size.
+  absl::flat_hash_map<size_t, std::vector<void*>> free_lists_
+      TF_GUARDED_BY(mu_);
+  // The number of bytes in free buffers that are not from the reserved pool.
+  size_t cached_bytes_ TF_GUARDED_BY(mu_) = 0;
+  AllocatorStats stats_ TF_GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(SizeClassAllocator);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_SIZE_CLASS_ALLOCATOR_H_
@@ -0,0 +1,199 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/size_class_allocator.h"
+
+#include <vector>
+
+#include "tensorflow/core/platform/mem.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+namespace {
+
+// A SubAllocator that counts its calls, and fails once `limit_bytes` are
+// outstanding.
+class CountingSubAllocator : public SubAllocator {
+ public:
+  explicit CountingSubAllocator(size_t limit_bytes = ~size_t{0})
+      : SubAllocator({}, {}), limit_bytes_(limit_bytes) {}
+
+  void* Alloc(size_t alignment, size_t num_bytes) override {
+    if (outstanding_bytes_ + num_bytes > limit_bytes_) return nullptr;
+    ++num_allocs_;
+    outstanding_bytes_ += num_bytes;
+    return port::AlignedMalloc(num_bytes, alignment);
+  }
+
+  void Free(void* ptr, size_t num_bytes) override {
+    ++num_frees_;
+    outstanding_bytes_ -= num_bytes;
+    port::AlignedFree(ptr);
+  }
+
+  int num_allocs() const { return num_allocs_; }
+  int num_frees() const { return num_frees_; }
+
+ private:
+  const size_t limit_bytes_;
+  size_t outstanding_bytes_ = 0;
+  int num_allocs_ = 0;
+  int num_frees_ = 0;
+};
+
+TEST(SizeClassAllocatorTest, RoundUpToClass) {
+  EXPECT_EQ(256, SizeClassAllocator::RoundUpToClass(1));
+  EXPECT_EQ(256, SizeClassAllocator::RoundUpToClass(256));
+  EXPECT_EQ(384, SizeClassAllocator::RoundUpToClass(257));
+  EXPECT_EQ(384, SizeClassAllocator::RoundUpToClass(384));
+  EXPECT_EQ(512, SizeClassAllocator::RoundUpToClass(385));
+  EXPECT_EQ(768, SizeClassAllocator::RoundUpToClass(513));
+  EXPECT_EQ(1 << 20, SizeClassAllocator::RoundUpToClass((1 << 20) - 1));
+  EXPECT_EQ(3 << 19, SizeClassAllocator::RoundUpToClass((1 << 20) + 1));
+}
+
+TEST(SizeClassAllocatorTest, ReusesBuffersOfTheSameClass) {
+  CountingSubAllocator* sub = new CountingSubAllocator;
+  SizeClassAllocator a(sub, /*reserve_bytes=*/0, /*max_cached_bytes=*/1 << 20,
+                       "test");
+  void* p1 = a.AllocateRaw(Allocator::kAllocatorAlignment, 1000);
+  ASSERT_NE(nullptr, p1);
+  EXPECT_EQ(1000, a.RequestedSize(p1));
+  EXPECT_EQ(1024, a.AllocatedSize(p1));
+  a.DeallocateRaw(p1);
+
+  // A request of a different size in the same class reuses the buffer.
+  void* p2 = a.AllocateRaw(Allocator::kAllocatorAlignment, 800);
+  EXPECT_EQ(p1, p2);
+  EXPECT_EQ(800, a.RequestedSize(p2));
+  EXPECT_EQ(1, sub->num_allocs());
+
+  // A request in another class does not.
+  void* p3 = a.AllocateRaw(Allocator::kAllocatorAlignment, 700);
+  EXPECT_NE(p2, p3);
+  EXPECT_EQ(768, a.AllocatedSize(p3));
+  EXPECT_EQ(2, sub->num_allocs());
+  a.DeallocateRaw(p2);
+  a.DeallocateRaw(p3);
+  EXPECT_EQ(0, sub->num_frees());
+
+  absl::optional<AllocatorStats> stats = a.GetStats();
+  ASSERT_TRUE(stats);
+  EXPECT_EQ(3, stats->num_allocs);
+  EXPECT_EQ(0, stats->bytes_in_use);
+  EXPECT_EQ(1024 + 768, stats->peak_bytes_in_use);
+  EXPECT_EQ(1024 + 768, stats->bytes_reserved);
+}
+
+TEST(SizeClassAllocatorTest, ServesFromReservedPool) {
+  CountingSubAllocator* sub = new CountingSubAllocator;
+  SizeClassAllocator a(sub, /*reserve_bytes=*/1 << 16,
+                       /*max_cached_bytes=*/0, "test");
+  EXPECT_EQ(1, sub->num_allocs());
+  std::vector<void*> ptrs;
+  for (int i = 0; i < 16; ++i) {
+    void* ptr = a.AllocateRaw(Allocator::kAllocatorAlignment, 4096);
+    ASSERT_NE(nullptr, ptr);
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(ptr) %
+                     Allocator::kAllocatorAlignment);
+    ptrs.push_back(ptr);
+  }
+  EXPECT_EQ(1, sub->num_allocs());
+
+  // The pool is exhausted, so the next buffer comes from the SubAllocator.
+  void* extra = a.AllocateRaw(Allocator::kAllocatorAlignment, 4096);
+  ASSERT_NE(nullptr, extra);
+  EXPECT_EQ(2, sub->num_allocs());
+
+  // Buffers from the pool are kept even though max_cached_bytes is 0.
+  for (void* ptr : ptrs) a.DeallocateRaw(ptr);
+  a.DeallocateRaw(extra);
+  EXPECT_EQ(1, sub->num_frees());
+  for (int i = 0; i < 16; ++i) {
+    a.DeallocateRaw(a.AllocateRaw(Allocator::kAllocatorAlignment, 4000));
+  }
+  EXPECT_EQ(2, sub->num_allocs());
+  EXPECT_EQ(1 << 16, a.GetStats()->bytes_reserved);
+}
+
+TEST(SizeClassAllocatorTest, LimitsCachedBytes) {
+  CountingSubAllocator* sub = new CountingSubAllocator;
+  SizeClassAllocator a(sub, /*reserve_bytes=*/0, /*max_cached_bytes=*/2048,
+                       "test");
+  void* p1 = a.AllocateRaw(Allocator::kAllocatorAlignment, 1024);
+  void* p2 = a.AllocateRaw(Allocator::kAllocatorAlignment, 1024);
+  void* p3 = a.AllocateRaw(Allocator::kAllocatorAlignment, 1024);
+  a.DeallocateRaw(p1);
+  a.DeallocateRaw(p2);
+  EXPECT_EQ(0, sub->num_frees());
+  a.DeallocateRaw(p3);
+  EXPECT_EQ(1, sub->num_frees());
+  EXPECT_EQ(2048, a.GetStats()->bytes_reserved);
+}
+
+TEST(SizeClassAllocatorTest, ReleasesCachedBuffersWhenOutOfMemory) {
+  CountingSubAllocator* sub = new CountingSubAllocator(/*limit_bytes=*/4096);
+  SizeClassAllocator a(sub, /*reserve_bytes=*/0,
+                       /*max_cached_bytes=*/1 << 20, "test");
+  void* small = a.AllocateRaw(Allocator::kAllocatorAlignment, 2048);
+  ASSERT_NE(nullptr, small);
+  a.DeallocateRaw(small);
+
+  // The cached 2KiB buffer must be freed for a 4KiB buffer to fit.
+  void* large = a.AllocateRaw(Allocator::kAllocatorAlignment, 4096);
+  EXPECT_NE(nullptr, large);
+  EXPECT_EQ(1, sub->num_frees());
+  EXPECT_EQ(nullptr, a.AllocateRaw(Allocator::kAllocatorAlignment, 256));
+  a.DeallocateRaw(large);
+}
+
+TEST(SizeClassAllocatorTest, LargeAlignmentIsNotCached) {
+  CountingSubAllocator* sub = new CountingSubAllocator;
+  SizeClassAllocator a(sub, /*reserve_bytes=*/0,
+                       /*max_cached_bytes=*/1 << 20, "test");
+  void* ptr = a.AllocateRaw(4096, 100);
+  ASSERT_NE(nullptr, ptr);
+  EXPECT_EQ(0, reinterpret_cast<uintptr_t>(ptr) % 4096);
+  a.DeallocateRaw(ptr);
+  EXPECT_EQ(1, sub->num_frees());
+}
+
+TEST(SizeClassAllocatorTest, ZeroSizeRequests) {
+  SizeClassAllocator a(new CountingSubAllocator, /*reserve_bytes=*/0,
+                       /*max_cached_bytes=*/0, "test");
+  EXPECT_EQ(nullptr, a.AllocateRaw(Allocator::kAllocatorAlignment, 0));
+  a.DeallocateRaw(nullptr);  // Should not crash.
+}
+
+// Allocates and frees batches of buffers of varying sizes, as an input
+// pipeline with variable-sized batches would.
+static void BM_VariableSizedBatches(int iters) {
+  SizeClassAllocator a(new CountingSubAllocator, /*reserve_bytes=*/0,
+                       /*max_cached_bytes=*/1LL << 30, "bench");
+  std::vector<void*> ptrs;
+  for (int i = 0; i < iters; ++i) {
+    for (int j = 0; j < 16; ++j) {
+      ptrs.push_back(a.AllocateRaw(Allocator::kAllocatorAlignment,
+                                   (1 << 20) + ((i * 16 + j) % 1000) * 1024));
+    }
+    for (void* ptr : ptrs) a.DeallocateRaw(ptr);
+    ptrs.clear();
+  }
+}
+BENCHMARK(BM_VariableSizedBatches);
+
+}  // namespace
+}  // namespace tensorflow
@@ -0,0 +1,187 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/step_arena_allocator.h"
+
+#include <algorithm>
+
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+
+namespace {
+
+// The number of empty blocks kept for reuse instead of being returned to the
+// wrapped allocator.
+constexpr size_t kMaxFreeBlocks = 4;
+
+size_t RoundUpToAlignment(size_t num_bytes) {
+  return (num_bytes + Allocator::kAllocatorAlignment - 1) &
+         ~(Allocator::kAllocatorAlignment - 1);
+}
+
+}  // namespace
+
+StepArenaAllocator::StepArenaAllocator(Allocator* base, size_t block_bytes,
+                                       size_t max_allocation_bytes)
+    : base_(base),
+      block_bytes_(block_bytes),
+      max_allocation_bytes_(max_allocation_bytes) {
+  CHECK_GT(block_bytes_, 0);
+  CHECK_EQ(block_bytes_ & (block_bytes_ - 1), 0)
+      << "block_bytes must be a power of two: " << block_bytes_;
+  CHECK_LE(max_allocation_bytes_, block_bytes_);
+}
+
+StepArenaAllocator::~StepArenaAllocator() {
+  mutex_lock l(mu_);
+  for (const auto& it : blocks_) {
+    DCHECK_EQ(it.second.num_live, 0);
+    base_->DeallocateRaw(it.second.base_ptr);
+  }
+}
+
+void* StepArenaAllocator::AllocateRaw(size_t alignment, size_t num_bytes) {
+  if (num_bytes > 0 && num_bytes <= max_allocation_bytes_ &&
+      alignment <= kAllocatorAlignment) {
+    const size_t bytes = RoundUpToAlignment(num_bytes);
+    void* ptr = nullptr;
+    {
+      mutex_lock l(mu_);
+      if (current_ == nullptr ||
+          blocks_[current_].offset + bytes > block_bytes_) {
+        // A current block with no live allocations has already been rewound,
+        // so the request does not fit only if the block is in use.
+        NewCurrentBlockLocked();
+      }
+      if (current_ != nullptr) {
+        Block& block = blocks_[current_];
+        ptr = current_ + block.offset;
+        block.offset += bytes;
+        ++block.num_live;
+        ++stats_.num_allocs;
+        stats_.bytes_in_use += bytes;
+        stats_.peak_bytes_in_use =
+            std::max(stats_.peak_bytes_in_use, stats_.bytes_in_use);
+        stats_.largest_alloc_size =
+            std::max<int64>(stats_.largest_alloc_size, bytes);
+      }
+    }
+    if (ptr != nullptr) {
+      Ref();
+      return ptr;
+    }
+    // The wrapped allocator could not provide a new block. Fall through, in
+    // case it still has room for this request.
+  }
+  void* ptr = base_->AllocateRaw(alignment, num_bytes);
+  if (ptr != nullptr) Ref();
+  return ptr;
+}
+
+void StepArenaAllocator::DeallocateRaw(void* ptr) {
+  bool from_arena = false;
+  char* block_to_release = nullptr;
+  {
+    mutex_lock l(mu_);
+    char* start = BlockStart(ptr);
+    auto it = blocks_.find(start);
+    if (it != blocks_.end()) {
+      from_arena = true;
+      Block& block = it->second;
+      DCHECK_GT(block.num_live, 0);
+      if (--block.num_live == 0) {
+        stats_.bytes_in_use -= block.offset;
+        if (start == current_) {
+          block.offset = 0;
+        } else {
+          block_to_release = RecycleBlockLocked(start);
+        }
+      }
+    }
+  }
+  if (!from_arena) base_->DeallocateRaw(ptr);
+  if (block_to_release != nullptr) base_->DeallocateRaw(block_to_release);
+  Unref();
+}
+
+void StepArenaAllocator::Reset() {
+  mutex_lock l(mu_);
+  if (current_ != nullptr && blocks_[current_].num_live > 0) {
+    current_ = nullptr;
+  }
+}
+
+absl::optional<AllocatorStats> StepArenaAllocator::GetStats() {
+  mutex_lock l(mu_);
+  return stats_;
+}
+
+void StepArenaAllocator::ClearStats() {
+  mutex_lock l(mu_);
+  stats_.num_allocs = 0;
+  stats_.peak_bytes_in_use = stats_.bytes_in_use;
+  stats_.largest_alloc_size = 0;
+  stats_.peak_bytes_reserved = stats_.bytes_reserved;
+}
+
+bool StepArenaAllocator::NewCurrentBlockLocked() {
+  char* start = nullptr;
+  if (!free_blocks_.empty()) {
+    start = free_blocks_.back();
+    free_blocks_.pop_back();
+  } else {
+    Block block;
+    block.base_bytes = block_bytes_;
+    block.base_ptr =
+        static_cast<char*>(base_->AllocateRaw(block_bytes_, block_bytes_));
+    if (block.base_ptr != nullptr &&
+        block.base_ptr != BlockStart(block.base_ptr)) {
+      // The wrapped allocator ignored the alignment. Over-allocate so that an
+      // aligned block fits whatever the (kAllocatorAlignment-aligned) address
+      // returned.
+      base_->DeallocateRaw(block.base_ptr);
+      block.base_bytes = 2 * block_bytes_ - kAllocatorAlignment;
+      block.base_ptr = static_cast<char*>(
+          base_->AllocateRaw(kAllocatorAlignment, block.base_bytes));
+    }
+    if (block.base_ptr == nullptr) {
+      current_ = nullptr;
+      return false;
+    }
+    start = BlockStart(block.base_ptr + block_bytes_ - 1);
+    stats_.bytes_reserved += block.base_bytes;
+    blocks_.emplace(start, block);
+    stats_.peak_bytes_reserved =
+        std::max(stats_.peak_bytes_reserved, stats_.bytes_reserved);
+  }
+  current_ = start;
+  return true;
+}
+
+char* StepArenaAllocator::RecycleBlockLocked(char* start) {
+  if (free_blocks_.size() < kMaxFreeBlocks) {
+    blocks_[start].offset = 0;
+    free_blocks_.push_back(start);
+    return nullptr;
+  }
+  auto it = blocks_.find(start);
+  char* base_ptr = it->second.base_ptr;
+  stats_.bytes_reserved -= it->second.base_bytes;
+  blocks_.erase(it);
+  return base_ptr;
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,128 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_STEP_ARENA_ALLOCATOR_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_STEP_ARENA_ALLOCATOR_H_
+
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/refcount.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// StepArenaAllocator is a wrapper for a host-memory Allocator that serves
+// small requests by bumping a pointer through large blocks obtained from the
+// wrapped allocator. It is intended for the temporaries that kernels allocate
+// through `OpKernelContext::allocate_temp()`, most of which are freed before
+// the step that allocated them ends.
+//
+// Each block counts its live allocations. When the count of the block that is
+// currently being bumped drops to zero, the block is rewound. `Reset()`, which
+// the owner calls at the end of each step, retires the current block if any
+// of its allocations are still alive, so that the next step starts with an
+// empty block. A retired block is recycled once its last allocation is freed,
+// which means that a temporary that outlives its step (for example because it
+// was passed to `set_output()`) remains valid, at the cost of pinning its
+// block.
+//
+// Requests larger than `max_allocation_bytes`, or with an alignment larger
+// than `Allocator::kAllocatorAlignment`, are forwarded to the wrapped
+// allocator.
+//
+// Blocks are aligned to `block_bytes`, so that the block of an allocation can
+// be found from its address. If the wrapped allocator does not honour that
+// alignment (BFCAllocator does not), the block is carved out of a larger
+// allocation.
+//
+// Every outstanding allocation holds a reference on the StepArenaAllocator,
+// so the owner may drop its reference while tensors allocated from the arena
+// are still alive.
+//
+// This class is thread-safe.
+class StepArenaAllocator : public Allocator, public core::RefCounted {
+ public:
+  static constexpr size_t kDefaultBlockBytes = 1 << 20;
+
+  // `block_bytes` must be a power of two, and `max_allocation_bytes` must not
+  // be larger than `block_bytes`. `base` is not owned, and must outlive this
+  // object.
+  StepArenaAllocator(Allocator* base, size_t block_bytes,
+                     size_t max_allocation_bytes);
+  explicit StepArenaAllocator(Allocator* base)
+      : StepArenaAllocator(base, kDefaultBlockBytes, kDefaultBlockBytes / 16) {}
+
+  std::string Name() override { return "step_arena"; }
+  void* AllocateRaw(size_t alignment, size_t num_bytes) override;
+  void DeallocateRaw(void* ptr) override;
+  absl::optional<AllocatorStats> GetStats() override;
+  void ClearStats() override;
+
+  // Marks the end of a step. See the class comment.
+  void Reset();
+
+ protected:
+  ~StepArenaAllocator() override;
+
+ private:
+  struct Block {
+    // The allocation obtained from `base_` that contains the block, and its
+    // size.
+    char* base_ptr = nullptr;
+    size_t base_bytes = 0;
+    size_t offset = 0;
+    int64 num_live = 0;
+  };
+
+  // Returns the start of the block that would contain `ptr` if it had been
+  // allocated from the arena.
+  char* BlockStart(const void* ptr) const {
+    return reinterpret_cast<char*>(reinterpret_cast<uintptr_t>(ptr) &
+                                   ~static_cast<uintptr_t>(block_bytes_ - 1));
+  }
+
+  // Makes an empty block current, reusing a free block if there is one.
+  // Returns false if the wrapped allocator is out of memory.
+  bool NewCurrentBlockLocked() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Called when the last allocation in the retired block at `start` is
+  // freed. Returns the allocation to return to the wrapped allocator, or
+  // nullptr if the block was kept for reuse.
+  char* RecycleBlockLocked(char* start) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  Allocator* const base_;  // not owned.
+  const size_t block_bytes_;
+  const size_t max_allocation_bytes_;
+
+  mutex mu_;
+  // All blocks obtained from `base_` and not yet returned, keyed by their
+  // start address.
+  absl::flat_hash_map<char*, Block> blocks_ TF_GUARDED_BY(mu_);
+  char* current_ TF_GUARDED_BY(mu_) = nullptr;
+  std::vector<char*> free_blocks_ TF_GUARDED_BY(mu_);
+  AllocatorStats stats_ TF_GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(StepArenaAllocator);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_STEP_ARENA_ALLOCATOR_H_
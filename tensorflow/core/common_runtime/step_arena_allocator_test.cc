@@ -0,0 +1,270 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/step_arena_allocator.h"
+
+#include <cstring>
+#include <vector>
+
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+namespace {
+
+constexpr size_t kBlockBytes = 1 << 16;
+constexpr size_t kMaxAllocationBytes = 1 << 12;
+
+core::RefCountPtr<StepArenaAllocator> NewArena() {
+  return core::RefCountPtr<StepArenaAllocator>(
+      new StepArenaAllocator(cpu_allocator(), kBlockBytes,
+                             kMaxAllocationBytes));
+}
+
+TEST(StepArenaAllocatorTest, AllocationsAreAlignedAndDisjoint) {
+  auto arena = NewArena();
+  std::vector<char*> ptrs;
+  for (size_t num_bytes : {1, 63, 64, 65, 1000}) {
+    char* ptr = static_cast<char*>(
+        arena->AllocateRaw(Allocator::kAllocatorAlignment, num_bytes));
+    ASSERT_NE(nullptr, ptr);
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(ptr) %
+                     Allocator::kAllocatorAlignment);
+    memset(ptr, 0xff, num_bytes);
+    if (!ptrs.empty()) EXPECT_GT(ptr, ptrs.back());
+    ptrs.push_back(ptr);
+  }
+  EXPECT_EQ(64, ptrs[1] - ptrs[0]);
+  EXPECT_EQ(64, ptrs[2] - ptrs[1]);
+  EXPECT_EQ(64, ptrs[3] - ptrs[2]);
+  EXPECT_EQ(128, ptrs[4] - ptrs[3]);
+
+  absl::optional<AllocatorStats> stats = arena->GetStats();
+  ASSERT_TRUE(stats);
+  EXPECT_EQ(5, stats->num_allocs);
+  EXPECT_EQ(64 * 3 + 128 + 1024, stats->bytes_in_use);
+  EXPECT_EQ(kBlockBytes, stats->bytes_reserved);
+
+  for (char* ptr : ptrs) arena->DeallocateRaw(ptr);
+  stats = arena->GetStats();
+  EXPECT_EQ(0, stats->bytes_in_use);
+}
+
+TEST(StepArenaAllocatorTest, RewindsWhenCurrentBlockEmpties) {
+  auto arena = NewArena();
+  void* a = arena->AllocateRaw(Allocator::kAllocatorAlignment, 100);
+  void* b = arena->AllocateRaw(Allocator::kAllocatorAlignment, 100);
+  arena->DeallocateRaw(b);
+  arena->DeallocateRaw(a);
+  void* c = arena->AllocateRaw(Allocator::kAllocatorAlignment, 100);
+  EXPECT_EQ(a, c);
+  arena->DeallocateRaw(c);
+}
+
+TEST(StepArenaAllocatorTest, ForwardsLargeAndOveralignedRequests) {
+  auto arena = NewArena();
+  void* large =
+      arena->AllocateRaw(Allocator::kAllocatorAlignment, kBlockBytes);
+  ASSERT_NE(nullptr, large);
+  void* overaligned = arena->AllocateRaw(4096, 128);
+  ASSERT_NE(nullptr, overaligned);
+  EXPECT_EQ(0, reinterpret_cast<uintptr_t>(overaligned) % 4096);
+
+  absl::optional<AllocatorStats> stats = arena->GetStats();
+  EXPECT_EQ(0, stats->num_allocs);
+  EXPECT_EQ(0, stats->bytes_reserved);
+  arena->DeallocateRaw(large);
+  arena->DeallocateRaw(overaligned);
+}
+
+TEST(StepArenaAllocatorTest, StartsNewBlockWhenFull) {
+  auto arena = NewArena();
+  std::vector<void*> ptrs;
+  const int num_per_block = kBlockBytes / kMaxAllocationBytes;
+  for (int i = 0; i < num_per_block + 1; ++i) {
+    ptrs.push_back(arena->AllocateRaw(Allocator::kAllocatorAlignment,
+                                      kMaxAllocationBytes));
+  }
+  EXPECT_EQ(2 * kBlockBytes, arena->GetStats()->bytes_reserved);
+  for (void* ptr : ptrs) arena->DeallocateRaw(ptr);
+  EXPECT_EQ(0, arena->GetStats()->bytes_in_use);
+}
+
+// Ignores the requested alignment beyond kAllocatorAlignment, like
+// BFCAllocator, and never returns addresses aligned to more than 64 bytes.
+class MisalignedAllocator : public Allocator {
+ public:
+  std::string Name() override { return "misaligned"; }
+  void* AllocateRaw(size_t alignment, size_t num_bytes) override {
+    char* ptr = static_cast<char*>(
+        cpu_allocator()->AllocateRaw(4096, num_bytes + kAllocatorAlignment));
+    return ptr + kAllocatorAlignment;
+  }
+  void DeallocateRaw(void* ptr) override {
+    cpu_allocator()->DeallocateRaw(static_cast<char*>(ptr) -
+                                   kAllocatorAlignment);
+  }
+};
+
+TEST(StepArenaAllocatorTest, AlignsBlocksFromMisalignedAllocator) {
+  MisalignedAllocator base;
+  core::RefCountPtr<StepArenaAllocator> arena(
+      new StepArenaAllocator(&base, kBlockBytes, kMaxAllocationBytes));
+  std::vector<char*> ptrs;
+  const int num_per_block = kBlockBytes / kMaxAllocationBytes;
+  for (int i = 0; i < num_per_block + 1; ++i) {
+    char* ptr = static_cast<char*>(arena->AllocateRaw(
+        Allocator::kAllocatorAlignment, kMaxAllocationBytes));
+    ASSERT_NE(nullptr, ptr);
+    memset(ptr, 0xff, kMaxAllocationBytes);
+    ptrs.push_back(ptr);
+  }
+  EXPECT_EQ(0, reinterpret_cast<uintptr_t>(ptrs[0]) % kBlockBytes);
+  EXPECT_EQ(0, reinterpret_cast<uintptr_t>(ptrs[num_per_block]) % kBlockBytes);
+  EXPECT_EQ(2 * (2 * kBlockBytes - Allocator::kAllocatorAlignment),
+            arena->GetStats()->bytes_reserved);
+  for (char* ptr : ptrs) arena->DeallocateRaw(ptr);
+  EXPECT_EQ(0, arena->GetStats()->bytes_in_use);
+}
+
+TEST(StepArenaAllocatorTest, ResetRetiresBlockWithLiveAllocations) {
+  auto arena = NewArena();
+  void* survivor = arena->AllocateRaw(Allocator::kAllocatorAlignment, 100);
+  arena->Reset();
+
+  // The next step starts in a different block.
+  void* next = arena->AllocateRaw(Allocator::kAllocatorAlignment, 100);
+  EXPECT_NE(reinterpret_cast<uintptr_t>(survivor) / kBlockBytes,
+            reinterpret_cast<uintptr_t>(next) / kBlockBytes);
+  EXPECT_EQ(2 * kBlockBytes, arena->GetStats()->bytes_reserved);
+  arena->DeallocateRaw(next);
+  arena->Reset();
+
+  // Once the survivor is freed, its block is kept for reuse instead of the
+  // arena growing further.
+  arena->DeallocateRaw(survivor);
+  void* a = arena->AllocateRaw(Allocator::kAllocatorAlignment, 100);
+  void* b = arena->AllocateRaw(Allocator::kAllocatorAlignment, 100);
+  EXPECT_EQ(2 * kBlockBytes, arena->GetStats()->bytes_reserved);
+  arena->DeallocateRaw(a);
+  arena->DeallocateRaw(b);
+}
+
+TEST(StepArenaAllocatorTest, ResetKeepsEmptyBlock) {
+  auto arena = NewArena();
+  void* a = arena->AllocateRaw(Allocator::kAllocatorAlignment, 100);
+  arena->DeallocateRaw(a);
+  arena->Reset();
+  void* b = arena->AllocateRaw(Allocator::kAllocatorAlignment, 100);
+  EXPECT_EQ(a, b);
+  EXPECT_EQ(kBlockBytes, arena->GetStats()->bytes_reserved);
+  arena->DeallocateRaw(b);
+}
+
+TEST(StepArenaAllocatorTest, TensorsOutliveOwner) {
+  auto arena = NewArena();
+  Tensor small(arena.get(), DT_FLOAT, TensorShape({16}));
+  Tensor large(arena.get(), DT_FLOAT, TensorShape({4096}));
+  small.flat<float>().setConstant(1.0f);
+  large.flat<float>().setConstant(2.0f);
+  arena.reset();
+  EXPECT_EQ(1.0f, small.flat<float>()(15));
+  EXPECT_EQ(2.0f, large.flat<float>()(4095));
+}
+
+TEST(StepArenaAllocatorTest, ConcurrentAllocateAndDeallocate) {
+  auto arena = NewArena();
+  const int kNumThreads = 4;
+  const int kNumSteps = 100;
+  {
+    thread::ThreadPool pool(Env::Default(), "test", kNumThreads);
+    for (int t = 0; t < kNumThreads; ++t) {
+      pool.Schedule([&arena, t]() {
+        for (int step = 0; step < kNumSteps; ++step) {
+          std::vector<int*> ptrs;
+          for (int i = 0; i < 50; ++i) {
+            int* ptr = static_cast<int*>(arena->AllocateRaw(
+                Allocator::kAllocatorAlignment, (i % 8 + 1) * sizeof(int)));
+            *ptr = t * 1000 + i;
+            ptrs.push_back(ptr);
+          }
+          for (int i = 0; i < 50; ++i) {
+            CHECK_EQ(t * 1000 + i, *ptrs[i]);
+            arena->DeallocateRaw(ptrs[i]);
+          }
+          arena->Reset();
+        }
+      });
+    }
+  }
+  EXPECT_EQ(0, arena->GetStats()->bytes_in_use);
+}
+
+// Allocates and frees `num_temps` temporaries of `num_bytes` bytes per step,
+// keeping half of them alive until the end of the step. Compares the arena to
+// the allocator that CPU devices use by default.
+void BM_StepTemporaries(int iters, int num_temps, int num_bytes,
+                        bool use_arena) {
+  testing::StopTiming();
+  Allocator* base = cpu_allocator();
+  core::RefCountPtr<StepArenaAllocator> arena;
+  if (use_arena) arena.reset(new StepArenaAllocator(base));
+  Allocator* a = use_arena ? arena.get() : base;
+  std::vector<void*> live;
+  live.reserve(num_temps);
+  testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    for (int j = 0; j < num_temps; ++j) {
+      void* ptr = a->AllocateRaw(Allocator::kAllocatorAlignment, num_bytes);
+      if (j % 2 == 0) {
+        a->DeallocateRaw(ptr);
+      } else {
+        live.push_back(ptr);
+      }
+    }
+    for (void* ptr : live) a->DeallocateRaw(ptr);
+    live.clear();
+    if (use_arena) arena->Reset();
+  }
+  testing::StopTiming();
+  if (use_arena) {
+    testing::SetLabel(strings::StrCat(
+        "peak_bytes_reserved=", arena->GetStats()->peak_bytes_reserved));
+  }
+}
+
+void BM_StepTemporaries_Arena(int iters, int num_temps, int num_bytes) {
+  BM_StepTemporaries(iters, num_temps, num_bytes, /*use_arena=*/true);
+}
+void BM_StepTemporaries_Default(int iters, int num_temps, int num_bytes) {
+  BM_StepTemporaries(iters, num_temps, num_bytes, /*use_arena=*/false);
+}
+
+BENCHMARK(BM_StepTemporaries_Arena)
+    ->ArgPair(100, 64)
+    ->ArgPair(1000, 256)
+    ->ArgPair(1000, 4096);
+BENCHMARK(BM_StepTemporaries_Default)
+    ->ArgPair(100, 64)
+    ->ArgPair(1000, 256)
+    ->ArgPair(1000, 4096);
+
+}  // namespace
+}  // namespace tensorflow
@@ -42,6 +42,10 @@ class ThreadPoolDeviceFactory : public DeviceFactory {
     auto iter = options.config.device_count().find("CPU");
     if (iter != options.config.device_count().end()) {
       n = iter->second;
+    } else if (options.config.experimental().use_numa_affinity()) {
+      // Create one CPU device per NUMA node, unless the user asks for a
+      // specific number of devices.
+      n = num_numa_nodes;
     }
     for (int i = 0; i < n; i++) {
       string name = strings::StrCat(name_prefix, "/device:CPU:", i);
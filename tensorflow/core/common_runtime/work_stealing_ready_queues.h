@@ -0,0 +1,147 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_WORK_STEALING_READY_QUEUES_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_WORK_STEALING_READY_QUEUES_H_
+
+#include <atomic>
+#include <deque>
+#include <memory>
+
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// A set of per-worker ready queues with work stealing, for use by the
+// "WORK_STEALING" mode of ExecutorState.
+//
+// Each worker owns one deque. A worker pushes newly ready items onto the back
+// of its own deque and pops from the back (LIFO, to keep producer/consumer
+// pairs on the same core). When its own deque is empty, a worker steals from
+// the front of the other workers' deques, visiting them round-robin starting
+// after its own index.
+//
+// In addition to the queues, this class tracks how many of the `num_workers`
+// worker slots are currently active, so that the owner can avoid scheduling
+// more worker loops than there are queues.
+//
+//    WorkStealingReadyQueues<T> queues(4);
+//    queues.Push(worker, item);
+//    if (queues.TryClaimWorker()) { ... start a new worker loop ... }
+//    T next;
+//    while (queues.Pop(worker, &next)) { ... }
+//    queues.ReleaseWorker();
+//
+// This class is thread-safe.
+template <typename T>
+class WorkStealingReadyQueues {
+ public:
+  explicit WorkStealingReadyQueues(int num_workers)
+      : num_workers_(num_workers),
+        queues_(new WorkerQueue[num_workers]),
+        num_active_workers_(0),
+        num_items_(0) {
+    DCHECK_GT(num_workers, 0);
+  }
+
+  int num_workers() const { return num_workers_; }
+
+  // Adds `item` to the back of the queue owned by `worker`.
+  void Push(int worker, const T& item) {
+    WorkerQueue& q = queues_[worker % num_workers_];
+    mutex_lock l(q.mu);
+    q.items.push_back(item);
+    num_items_.fetch_add(1);
+  }
+
+  // Removes an item from the back of the queue owned by `worker`, or, if that
+  // queue is empty, steals one from the front of another worker's queue.
+  // Returns false if all queues were observed to be empty.
+  bool Pop(int worker, T* item) {
+    if (num_items_.load() == 0) return false;
+    const int self = worker % num_workers_;
+    {
+      WorkerQueue& q = queues_[self];
+      mutex_lock l(q.mu);
+      if (!q.items.empty()) {
+        *item = q.items.back();
+        q.items.pop_back();
+        num_items_.fetch_sub(1);
+        return true;
+      }
+    }
+    for (int i = 1; i < num_workers_; ++i) {
+      WorkerQueue& victim = queues_[(self + i) % num_workers_];
+      mutex_lock l(victim.mu);
+      if (!victim.items.empty()) {
+        *item = victim.items.front();
+        victim.items.pop_front();
+        num_items_.fetch_sub(1);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Returns true if no items were queued at the time of the call.
+  bool empty() const { return num_items_.load() == 0; }
+
+  // Attempts to reserve one of the `num_workers` worker slots. Returns true
+  // if the caller is now responsible for running a worker loop, which must
+  // eventually be matched by a call to `ReleaseWorker()`.
+  bool TryClaimWorker() {
+    int active = num_active_workers_.load();
+    while (active < num_workers_) {
+      if (num_active_workers_.compare_exchange_weak(active, active + 1)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Releases a worker slot previously reserved by `TryClaimWorker()`.
+  //
+  // NOTE: An item pushed concurrently with this call may be observed by
+  // neither the releasing worker nor the pusher's `TryClaimWorker()`. To
+  // avoid stranding such items, callers should check `empty()` after
+  // `ReleaseWorker()` and try to reclaim a slot if it returns false.
+  void ReleaseWorker() {
+    const int prev = num_active_workers_.fetch_sub(1);
+    DCHECK_GT(prev, 0);
+  }
+
+  int num_active_workers() const { return num_active_workers_.load(); }
+
+ private:
+  struct WorkerQueue {
+    mutex mu;
+    std::deque<T> items TF_GUARDED_BY(mu);
+  };
+
+  const int num_workers_;
+  std::unique_ptr<WorkerQueue[]> queues_;
+  std::atomic<int> num_active_workers_;
+  std::atomic<int64> num_items_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(WorkStealingReadyQueues);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_WORK_STEALING_READY_QUEUES_H_
@@ -0,0 +1,114 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/work_stealing_ready_queues.h"
+
+#include <atomic>
+#include <vector>
+
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+TEST(WorkStealingReadyQueuesTest, OwnerPopsLifo) {
+  WorkStealingReadyQueues<int> queues(2);
+  queues.Push(0, 1);
+  queues.Push(0, 2);
+  queues.Push(0, 3);
+  int item = 0;
+  ASSERT_TRUE(queues.Pop(0, &item));
+  EXPECT_EQ(3, item);
+  ASSERT_TRUE(queues.Pop(0, &item));
+  EXPECT_EQ(2, item);
+  ASSERT_TRUE(queues.Pop(0, &item));
+  EXPECT_EQ(1, item);
+  EXPECT_FALSE(queues.Pop(0, &item));
+  EXPECT_TRUE(queues.empty());
+}
+
+TEST(WorkStealingReadyQueuesTest, ThiefStealsFifo) {
+  WorkStealingReadyQueues<int> queues(3);
+  queues.Push(0, 1);
+  queues.Push(0, 2);
+  int item = 0;
+  ASSERT_TRUE(queues.Pop(2, &item));
+  EXPECT_EQ(1, item);
+  ASSERT_TRUE(queues.Pop(1, &item));
+  EXPECT_EQ(2, item);
+  EXPECT_FALSE(queues.Pop(1, &item));
+}
+
+TEST(WorkStealingReadyQueuesTest, WorkerIndexWrapsAround) {
+  WorkStealingReadyQueues<int> queues(2);
+  queues.Push(5, 7);
+  int item = 0;
+  ASSERT_TRUE(queues.Pop(1, &item));
+  EXPECT_EQ(7, item);
+}
+
+TEST(WorkStealingReadyQueuesTest, ClaimAndReleaseWorkers) {
+  WorkStealingReadyQueues<int> queues(2);
+  EXPECT_TRUE(queues.TryClaimWorker());
+  EXPECT_TRUE(queues.TryClaimWorker());
+  EXPECT_FALSE(queues.TryClaimWorker());
+  EXPECT_EQ(2, queues.num_active_workers());
+  queues.ReleaseWorker();
+  EXPECT_EQ(1, queues.num_active_workers());
+  EXPECT_TRUE(queues.TryClaimWorker());
+  queues.ReleaseWorker();
+  queues.ReleaseWorker();
+  EXPECT_EQ(0, queues.num_active_workers());
+}
+
+TEST(WorkStealingReadyQueuesTest, ConcurrentPushAndPop) {
+  const int kNumWorkers = 4;
+  const int kItemsPerWorker = 10000;
+  WorkStealingReadyQueues<int> queues(kNumWorkers);
+  std::atomic<int64> sum(0);
+  std::atomic<int> num_popped(0);
+  {
+    thread::ThreadPool pool(Env::Default(), "test", kNumWorkers);
+    for (int w = 0; w < kNumWorkers; ++w) {
+      pool.Schedule([&queues, &sum, &num_popped, w]() {
+        for (int i = 0; i < kItemsPerWorker; ++i) {
+          queues.Push(w, i);
+          // Only pop every other iteration, so that queues build up and the
+          // other workers have an opportunity to steal.
+          int item;
+          if (i % 2 == 0 && queues.Pop(w, &item)) {
+            sum += item;
+            ++num_popped;
+          }
+        }
+        int item;
+        while (queues.Pop(w, &item)) {
+          sum += item;
+          ++num_popped;
+        }
+      });
+    }
+  }
+  EXPECT_TRUE(queues.empty());
+  EXPECT_EQ(kNumWorkers * kItemsPerWorker, num_popped.load());
+  const int64 expected_sum = static_cast<int64>(kNumWorkers) *
+                             kItemsPerWorker * (kItemsPerWorker - 1) / 2;
+  EXPECT_EQ(expected_sum, sum.load());
+}
+
+}  // namespace
+}  // namespace tensorflow
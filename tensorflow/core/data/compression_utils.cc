@@ -21,8 +21,12 @@ limitations under the License.
 namespace tensorflow {
 namespace data {
 
-Status CompressElement(const std::vector<Tensor>& element,
-                       CompressedElement* out) {
+namespace {
+
+// Writes the tensor bytes of the components of `element` to `*uncompressed`,
+// and fills out the per-component metadata in `*out`.
+Status SerializeElement(const std::vector<Tensor>& element,
+                        CompressedElement* out, tstring* uncompressed) {
   // Step 1: Determine the total uncompressed size. This requires serializing
   // non-memcopyable tensors, which we save to use again later.
   std::vector<TensorProto> non_memcpy_components;
@@ -39,12 +43,11 @@ Status CompressElement(const std::vector<Tensor>& element,
     }
   }
 
-  // Step 2: Write the tensor data to a buffer, and compress that buffer.
-  // We use tstring for access to resize_uninitialized.
-  tstring uncompressed;
-  uncompressed.resize_uninitialized(total_size);
+  // Step 2: Write the tensor data to a buffer. We use tstring for access to
+  // resize_uninitialized.
+  uncompressed->resize_uninitialized(total_size);
   // Position in `uncompressed` to write the next component.
-  char* position = uncompressed.mdata();
+  char* position = uncompressed->mdata();
   int non_memcpy_component_index = 0;
   for (auto& component : element) {
     CompressedComponentMetadata* metadata =
@@ -62,14 +65,99 @@ Status CompressElement(const std::vector<Tensor>& element,
     }
     position += metadata->tensor_size_bytes();
   }
-  DCHECK_EQ(position, uncompressed.mdata() + total_size);
+  DCHECK_EQ(position, uncompressed->mdata() + total_size);
+  return Status::OK();
+}
 
-  if (!port::Snappy_Compress(uncompressed.mdata(), total_size,
-                             out->mutable_data())) {
+Status SnappyCompress(const tstring& uncompressed, std::string* out) {
+  if (!port::Snappy_Compress(uncompressed.data(), uncompressed.size(), out)) {
     return errors::Internal("Failed to compress using snappy.");
   }
-  VLOG(3) << "Compressed element from " << total_size << " bytes to "
-          << out->data().size() << " bytes";
+  VLOG(3) << "Compressed element from " << uncompressed.size() << " bytes to "
+          << out->size() << " bytes";
+  return Status::OK();
+}
+
+Status SnappyUncompress(const std::string& compressed_data, int64 total_size,
+                        std::vector<struct iovec>& iov) {
+  size_t uncompressed_size;
+  if (!port::Snappy_GetUncompressedLength(
+          compressed_data.data(), compressed_data.size(), &uncompressed_size)) {
+    return errors::Internal("Could not get snappy uncompressed length");
+  }
+  if (uncompressed_size != static_cast<size_t>(total_size)) {
+    return errors::Internal(
+        "Uncompressed size mismatch. Snappy expects ", uncompressed_size,
+        " whereas the tensor metadata suggests ", total_size);
+  }
+  if (!port::Snappy_UncompressToIOVec(compressed_data.data(),
+                                      compressed_data.size(), iov.data(),
+                                      iov.size())) {
+    return errors::Internal("Failed to perform snappy decompression.");
+  }
+  return Status::OK();
+}
+
+}  // namespace
+
+Status CompressElement(const std::vector<Tensor>& element,
+                       CompressedElement* out) {
+  return CompressElement(element, CompressedElement::SNAPPY, out);
+}
+
+Status CompressElement(const std::vector<Tensor>& element,
+                       CompressedElement::Compression compression,
+                       CompressedElement* out) {
+  tstring uncompressed;
+  TF_RETURN_IF_ERROR(SerializeElement(element, out, &uncompressed));
+  out->set_compression(compression);
+  switch (compression) {
+    case CompressedElement::SNAPPY:
+      return SnappyCompress(uncompressed, out->mutable_data());
+    case CompressedElement::NONE:
+      out->set_data(uncompressed.data(), uncompressed.size());
+      return Status::OK();
+    default:
+      return errors::InvalidArgument("Unsupported compression: ",
+                                     compression);
+  }
+}
+
+constexpr double AdaptiveElementCompressor::kMaxCompressionRatio;
+constexpr int64 AdaptiveElementCompressor::kMaxSkippedElements;
+
+Status AdaptiveElementCompressor::Compress(const std::vector<Tensor>& element,
+                                           CompressedElement* out) {
+  {
+    mutex_lock l(mu_);
+    if (num_to_skip_ > 0) {
+      --num_to_skip_;
+      return CompressElement(element, CompressedElement::NONE, out);
+    }
+  }
+  tstring uncompressed;
+  TF_RETURN_IF_ERROR(SerializeElement(element, out, &uncompressed));
+  std::string compressed;
+  TF_RETURN_IF_ERROR(SnappyCompress(uncompressed, &compressed));
+  const bool compresses_well =
+      compressed.size() <= kMaxCompressionRatio * uncompressed.size();
+  {
+    mutex_lock l(mu_);
+    if (compresses_well) {
+      skip_interval_ = 0;
+    } else {
+      skip_interval_ =
+          std::min(std::max<int64>(2 * skip_interval_, 1), kMaxSkippedElements);
+      num_to_skip_ = skip_interval_;
+    }
+  }
+  if (compresses_well) {
+    out->set_compression(CompressedElement::SNAPPY);
+    *out->mutable_data() = std::move(compressed);
+  } else {
+    out->set_compression(CompressedElement::NONE);
+    out->set_data(uncompressed.data(), uncompressed.size());
+  }
   return Status::OK();
 }
 
@@ -111,22 +199,26 @@ Status UncompressElement(const CompressedElement& compressed,
 
   // Step 2: Uncompress into the iovec.
   const std::string& compressed_data = compressed.data();
-  size_t uncompressed_size;
-  if (!port::Snappy_GetUncompressedLength(
-          compressed_data.data(), compressed_data.size(), &uncompressed_size)) {
-    return errors::Internal("Could not get snappy uncompressed length");
-  }
-  if (uncompressed_size != static_cast<size_t>(total_size)) {
-    return errors::Internal(
-        "Uncompressed size mismatch. Snappy expects ", uncompressed_size,
-        " whereas the tensor metadata suggests ", total_size);
-  }
-  if (!port::Snappy_UncompressToIOVec(compressed_data.data(),
-                                      compressed_data.size(), iov.data(),
-                                      num_components)) {
-    return errors::Internal("Failed to perform snappy decompression.");
+  if (compressed.compression() == CompressedElement::NONE) {
+    if (compressed_data.size() != static_cast<size_t>(total_size)) {
+      return errors::Internal(
+          "Uncompressed size mismatch. The element holds ",
+          compressed_data.size(),
+          " bytes whereas the tensor metadata suggests ", total_size);
+    }
+    const char* position = compressed_data.data();
+    for (const struct iovec& component : iov) {
+      memcpy(component.iov_base, position, component.iov_len);
+      position += component.iov_len;
+    }
+  } else if (compressed.compression() != CompressedElement::SNAPPY) {
+    return errors::Internal("Unsupported compression: ",
+                            compressed.compression());
+  } else {
+    TF_RETURN_IF_ERROR(SnappyUncompress(compressed_data, total_size, iov));
   }
 
+
   // Step 3: Deserialize tensor proto strings to tensors.
   int tensor_proto_strs_index = 0;
   for (int i = 0; i < num_components; ++i) {
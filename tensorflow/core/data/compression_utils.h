@@ -17,7 +17,10 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/dma_helper.h"
 #include "tensorflow/core/data/dataset.pb.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
 
 namespace tensorflow {
 namespace data {
@@ -29,6 +32,36 @@ namespace data {
 Status CompressElement(const std::vector<Tensor>& element,
                        CompressedElement* out);
 
+// Like above, but compresses the bytes as specified by `compression`. With
+// `CompressedElement::NONE`, the bytes are stored as is.
+Status CompressElement(const std::vector<Tensor>& element,
+                       CompressedElement::Compression compression,
+                       CompressedElement* out);
+
+// Compresses elements with snappy only while it pays off. An element whose
+// compressed size is more than `kMaxCompressionRatio` of its uncompressed size
+// is stored uncompressed instead, which saves the reader from decompressing it
+// for little gain. After such an element, the next elements are stored
+// uncompressed without trying, for twice as many elements each time the
+// compression keeps not paying off, up to `kMaxSkippedElements`.
+//
+// This class is thread-safe.
+class AdaptiveElementCompressor {
+ public:
+  static constexpr double kMaxCompressionRatio = 0.8;
+  static constexpr int64 kMaxSkippedElements = 64;
+
+  Status Compress(const std::vector<Tensor>& element, CompressedElement* out);
+
+ private:
+  mutex mu_;
+  // The number of elements to store uncompressed before trying again.
+  int64 num_to_skip_ TF_GUARDED_BY(mu_) = 0;
+  // The number of elements skipped after the last element that did not
+  // compress well.
+  int64 skip_interval_ TF_GUARDED_BY(mu_) = 0;
+};
+
 // Uncompresses a `CompressedElement` into a vector of tensor components.
 Status UncompressElement(const CompressedElement& compressed,
                          std::vector<Tensor>* out);
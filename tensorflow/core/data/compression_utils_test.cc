@@ -35,6 +35,30 @@ TEST_P(ParameterizedCompressionUtilsTest, RoundTrip) {
       ExpectEqual(element, round_trip_element, /*compare_order=*/true));
 }
 
+TEST_P(ParameterizedCompressionUtilsTest, RoundTripUncompressed) {
+  std::vector<Tensor> element = GetParam();
+  CompressedElement compressed;
+  TF_ASSERT_OK(CompressElement(element, CompressedElement::NONE, &compressed));
+  EXPECT_EQ(compressed.compression(), CompressedElement::NONE);
+  std::vector<Tensor> round_trip_element;
+  TF_ASSERT_OK(UncompressElement(compressed, &round_trip_element));
+  TF_EXPECT_OK(
+      ExpectEqual(element, round_trip_element, /*compare_order=*/true));
+}
+
+TEST_P(ParameterizedCompressionUtilsTest, RoundTripAdaptive) {
+  std::vector<Tensor> element = GetParam();
+  AdaptiveElementCompressor compressor;
+  for (int i = 0; i < 10; ++i) {
+    CompressedElement compressed;
+    TF_ASSERT_OK(compressor.Compress(element, &compressed));
+    std::vector<Tensor> round_trip_element;
+    TF_ASSERT_OK(UncompressElement(compressed, &round_trip_element));
+    TF_EXPECT_OK(
+        ExpectEqual(element, round_trip_element, /*compare_order=*/true));
+  }
+}
+
 std::vector<std::vector<Tensor>> TestCases() {
   return {
       CreateTensors<int64>(TensorShape{1}, {{1}}),             // int64
@@ -49,5 +73,41 @@ std::vector<std::vector<Tensor>> TestCases() {
 INSTANTIATE_TEST_SUITE_P(Instantiation, ParameterizedCompressionUtilsTest,
                          ::testing::ValuesIn(TestCases()));
 
+class AdaptiveElementCompressorTest : public DatasetOpsTestBase {};
+
+TEST_F(AdaptiveElementCompressorTest, CompressesCompressibleElements) {
+  std::vector<Tensor> element = {
+      CreateTensor<int64>(TensorShape{1024}, std::vector<int64>(1024, 0))};
+  AdaptiveElementCompressor compressor;
+  for (int i = 0; i < 10; ++i) {
+    CompressedElement compressed;
+    TF_ASSERT_OK(compressor.Compress(element, &compressed));
+    EXPECT_EQ(compressed.compression(), CompressedElement::SNAPPY);
+  }
+}
+
+TEST_F(AdaptiveElementCompressorTest, BacksOffOnIncompressibleElements) {
+  std::vector<int64> values(1024);
+  uint64 state = 0x9e3779b97f4a7c15ULL;
+  for (int64& value : values) {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    value = static_cast<int64>(state);
+  }
+  std::vector<Tensor> element = {
+      CreateTensor<int64>(TensorShape{1024}, values)};
+  AdaptiveElementCompressor compressor;
+  for (int i = 0; i < 10; ++i) {
+    CompressedElement compressed;
+    TF_ASSERT_OK(compressor.Compress(element, &compressed));
+    EXPECT_EQ(compressed.compression(), CompressedElement::NONE);
+    std::vector<Tensor> round_trip_element;
+    TF_ASSERT_OK(UncompressElement(compressed, &round_trip_element));
+    TF_EXPECT_OK(
+        ExpectEqual(element, round_trip_element, /*compare_order=*/true));
+  }
+}
+
 }  // namespace data
 }  // namespace tensorflow
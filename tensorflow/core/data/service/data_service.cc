@@ -29,6 +29,7 @@ namespace data {
 namespace {
 constexpr const char kParallelEpochs[] = "parallel_epochs";
 constexpr const char kOneEpoch[] = "one_epoch";
+constexpr const char kSharedEpochs[] = "shared_epochs";
 }  // namespace
 
 Status ParseProcessingMode(const std::string& s, ProcessingMode* mode) {
@@ -36,6 +37,8 @@ Status ParseProcessingMode(const std::string& s, ProcessingMode* mode) {
     *mode = ProcessingMode::PARALLEL_EPOCHS;
   } else if (s == kOneEpoch) {
     *mode = ProcessingMode::ONE_EPOCH;
+  } else if (s == kSharedEpochs) {
+    *mode = ProcessingMode::SHARED_EPOCHS;
   } else {
     return errors::InvalidArgument("Unrecognized processing mode: ", s);
   }
@@ -48,6 +51,8 @@ std::string ProcessingModeToString(ProcessingMode mode) {
       return kParallelEpochs;
     case ProcessingMode::ONE_EPOCH:
       return kOneEpoch;
+    case ProcessingMode::SHARED_EPOCHS:
+      return kSharedEpochs;
     default:
       DCHECK(false);
       return "Unknown";
@@ -163,10 +168,21 @@ Status DataServiceWorkerClient::GetElement(int64 task_id,
   GetElementRequest req;
   req.set_task_id(task_id);
   GetElementResponse resp;
-  grpc::ClientContext ctx;
-  grpc::Status s = stub_->GetElement(&ctx, req, &resp);
-  if (!s.ok()) {
-    return grpc_util::WrapError("Failed to get element", s);
+  if (is_local_) {
+    std::shared_ptr<DataServiceWorkerImpl> worker = local_worker_.lock();
+    if (worker == nullptr) {
+      return errors::Unavailable("Local worker at address ", address_,
+                                 " has been stopped.");
+    }
+    // The worker swaps the element into `resp`, so nothing is serialized or
+    // copied.
+    TF_RETURN_IF_ERROR(worker->GetElement(&req, &resp));
+  } else {
+    grpc::ClientContext ctx;
+    grpc::Status s = stub_->GetElement(&ctx, req, &resp);
+    if (!s.ok()) {
+      return grpc_util::WrapError("Failed to get element", s);
+    }
   }
   *end_of_sequence = resp.end_of_sequence();
   if (!*end_of_sequence) {
@@ -175,7 +191,49 @@ Status DataServiceWorkerClient::GetElement(int64 task_id,
   return Status::OK();
 }
 
+Status DataServiceWorkerClient::GetElements(
+    int64 task_id, int64 max_elements, int64 max_bytes,
+    std::vector<CompressedElement>* elements, bool* end_of_sequence) {
+  TF_RETURN_IF_ERROR(EnsureInitialized());
+  GetElementsRequest req;
+  req.set_task_id(task_id);
+  req.set_max_elements(max_elements);
+  req.set_max_bytes(max_bytes);
+  GetElementsResponse resp;
+  if (is_local_) {
+    std::shared_ptr<DataServiceWorkerImpl> worker = local_worker_.lock();
+    if (worker == nullptr) {
+      return errors::Unavailable("Local worker at address ", address_,
+                                 " has been stopped.");
+    }
+    TF_RETURN_IF_ERROR(worker->GetElements(&req, &resp));
+  } else {
+    grpc::ClientContext ctx;
+    grpc::Status s = stub_->GetElements(&ctx, req, &resp);
+    if (!s.ok()) {
+      return grpc_util::WrapError("Failed to get elements", s);
+    }
+  }
+  *end_of_sequence = resp.end_of_sequence();
+  elements->reserve(elements->size() + resp.compressed_elements_size());
+  for (CompressedElement& element : *resp.mutable_compressed_elements()) {
+    elements->push_back(std::move(element));
+  }
+  return Status::OK();
+}
+
 Status DataServiceWorkerClient::EnsureInitialized() {
+  if (is_local_ || stub_) {
+    return Status::OK();
+  }
+  std::shared_ptr<DataServiceWorkerImpl> local_worker =
+      LocalWorkers::Get(address_);
+  if (local_worker != nullptr) {
+    VLOG(2) << "Reading from local worker at address " << address_;
+    local_worker_ = local_worker;
+    is_local_ = true;
+    return Status::OK();
+  }
   std::shared_ptr<grpc::ChannelCredentials> credentials;
   TF_RETURN_IF_ERROR(
       CredentialsFactory::CreateClientCredentials(protocol_, &credentials));
@@ -18,6 +18,7 @@ limitations under the License.
 
 #include "tensorflow/core/data/service/dispatcher.grpc.pb.h"
 #include "tensorflow/core/data/service/worker.grpc.pb.h"
+#include "tensorflow/core/data/service/worker_impl.h"
 #include "tensorflow/core/framework/dataset.h"
 #include "tensorflow/core/framework/op_kernel.h"
 
@@ -31,6 +32,10 @@ enum class ProcessingMode : int64 {
   PARALLEL_EPOCHS = 0,
   // Processing of a single epoch is distributed across all tf.data workers.
   ONE_EPOCH = 1,
+  // Like PARALLEL_EPOCHS, but concurrent jobs reading the same dataset share
+  // the elements each worker produces, so that the dataset is only processed
+  // once per epoch on each worker regardless of the number of jobs.
+  SHARED_EPOCHS = 2,
 };
 
 // Parses a string representing a processing mode and stores the result in
@@ -107,7 +112,9 @@ class DataServiceDispatcherClient : public DataServiceClientBase {
   std::unique_ptr<DispatcherService::Stub> stub_;
 };
 
-// Client for communicating with the tf.data service worker.
+// Client for communicating with the tf.data service worker. If the worker runs
+// in the same process as the client, the client calls it directly instead of
+// sending RPCs.
 class DataServiceWorkerClient : public DataServiceClientBase {
  public:
   DataServiceWorkerClient(const std::string& address,
@@ -120,11 +127,24 @@ class DataServiceWorkerClient : public DataServiceClientBase {
   Status GetElement(int64 task_id, CompressedElement* element,
                     bool* end_of_sequence);
 
+  // Fetches up to `max_elements` next elements for the specified task_id in a
+  // single round trip, stopping early once the elements add up to `max_bytes`
+  // compressed bytes (if `max_bytes` is positive). The elements are appended to
+  // `*elements`. `*end_of_sequence` is set to whether the task has no more
+  // elements after the fetched ones.
+  Status GetElements(int64 task_id, int64 max_elements, int64 max_bytes,
+                     std::vector<CompressedElement>* elements,
+                     bool* end_of_sequence);
+
  protected:
   Status EnsureInitialized() override;
 
  private:
   std::unique_ptr<WorkerService::Stub> stub_;
+  // Set if the worker runs in this process. Weak so that the client does not
+  // keep a stopped worker alive.
+  std::weak_ptr<DataServiceWorkerImpl> local_worker_;
+  bool is_local_ = false;
 };
 
 // Creates and initializes a new tf.data service dispatcher client.
@@ -51,6 +51,12 @@ TEST(DataService, ParseOneEpochProcessingMode) {
   EXPECT_EQ(mode, ProcessingMode::ONE_EPOCH);
 }
 
+TEST(DataService, ParseSharedEpochsProcessingMode) {
+  ProcessingMode mode;
+  TF_ASSERT_OK(ParseProcessingMode("shared_epochs", &mode));
+  EXPECT_EQ(mode, ProcessingMode::SHARED_EPOCHS);
+}
+
 TEST(DataService, ParseInvalidProcessingMode) {
   ProcessingMode mode;
   Status s = ParseProcessingMode("invalid", &mode);
@@ -61,6 +67,8 @@ TEST(DataService, ProcessingModeToString) {
   EXPECT_EQ("parallel_epochs",
             ProcessingModeToString(ProcessingMode::PARALLEL_EPOCHS));
   EXPECT_EQ("one_epoch", ProcessingModeToString(ProcessingMode::ONE_EPOCH));
+  EXPECT_EQ("shared_epochs",
+            ProcessingModeToString(ProcessingMode::SHARED_EPOCHS));
 }
 
 TEST(DataService, GetWorkers) {
@@ -73,5 +81,39 @@ TEST(DataService, GetWorkers) {
   EXPECT_EQ(1, workers.size());
 }
 
+TEST(DataService, RegistersLocalWorkers) {
+  std::string worker_address;
+  {
+    TestCluster cluster(1);
+    TF_ASSERT_OK(cluster.Initialize());
+    worker_address = cluster.WorkerAddress(0);
+    EXPECT_NE(LocalWorkers::Get(worker_address), nullptr);
+  }
+  EXPECT_EQ(LocalWorkers::Get(worker_address), nullptr);
+}
+
+TEST(DataService, LocalWorkerClient) {
+  TestCluster cluster(1);
+  TF_ASSERT_OK(cluster.Initialize());
+  DataServiceWorkerClient worker(cluster.WorkerAddress(0), kProtocol);
+  CompressedElement element;
+  bool end_of_sequence;
+  // The worker is called directly, and reports that the task is unknown.
+  Status s = worker.GetElement(/*task_id=*/-1, &element, &end_of_sequence);
+  EXPECT_EQ(s.code(), error::Code::NOT_FOUND);
+}
+
+TEST(DataService, GetElementsUnknownTask) {
+  TestCluster cluster(1);
+  TF_ASSERT_OK(cluster.Initialize());
+  DataServiceWorkerClient worker(cluster.WorkerAddress(0), kProtocol);
+  std::vector<CompressedElement> elements;
+  bool end_of_sequence;
+  Status s = worker.GetElements(/*task_id=*/-1, /*max_elements=*/8,
+                                /*max_bytes=*/0, &elements, &end_of_sequence);
+  EXPECT_EQ(s.code(), error::Code::NOT_FOUND);
+  EXPECT_TRUE(elements.empty());
+}
+
 }  // namespace data
 }  // namespace tensorflow
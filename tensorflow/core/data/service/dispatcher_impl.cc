@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/data/service/dispatcher_impl.h"
 
+#include <algorithm>
 #include <memory>
 #include <tuple>
 #include <utility>
@@ -48,6 +49,15 @@ namespace {
 constexpr char kJournalDir[] = "tf_data_dispatcher_journal";
 // The name of the datasets directory inside the dispatcher's working directory.
 constexpr char kDatasetsDir[] = "datasets";
+// How long to wait to hear from a worker before releasing its splits, unless
+// configured otherwise.
+constexpr int64 kDefaultWorkerTimeoutMs = 30 * 1000;
+// ONE_EPOCH jobs are divided into `kSplitsPerWorker` splits for each worker
+// registered when the job is created, and at least `kMinNumSplits` splits.
+// Having several splits per worker lets fast workers take on more of the epoch
+// than slow ones.
+constexpr int64 kSplitsPerWorker = 4;
+constexpr int64 kMinNumSplits = 16;
 
 using Dataset = DispatcherState::Dataset;
 using Worker = DispatcherState::Worker;
@@ -143,7 +153,11 @@ Status DataServiceDispatcherImpl::RegisterWorker(
     TF_RETURN_IF_ERROR(Apply(update));
   } else if (!s.ok()) {
     return s;
+  } else {
+    // The worker restarted, so the splits it was processing are lost.
+    TF_RETURN_IF_ERROR(ReleaseSplitsOfWorker(worker_address));
   }
+  RecordHeartbeat(worker_address);
 
   absl::flat_hash_map<int64, std::shared_ptr<const Task>> tasks_by_job;
   for (const auto& task : tasks) {
@@ -176,6 +190,8 @@ Status DataServiceDispatcherImpl::RegisterWorker(
     task_def->set_dataset_id(job->dataset_id);
     task_def->set_job_id(job->job_id);
     task_def->set_task_id(task->task_id);
+    task_def->set_processing_mode(ProcessingModeDef(job->processing_mode));
+    task_def->set_dataset_fingerprint(dataset->fingerprint);
   }
 
   VLOG(1) << "Registered worker at address " << request->worker_address();
@@ -184,7 +200,12 @@ Status DataServiceDispatcherImpl::RegisterWorker(
 
 Status DataServiceDispatcherImpl::WorkerUpdate(
     const WorkerUpdateRequest* request, WorkerUpdateResponse* response) {
+  RecordHeartbeat(request->worker_address());
+  if (request->updates().empty()) {
+    return Status::OK();
+  }
   mutex_lock l(mu_);
+  std::vector<Update> finish_tasks;
   for (auto& update : request->updates()) {
     int64 task_id = update.task_id();
     std::shared_ptr<const Task> task;
@@ -195,16 +216,131 @@ Status DataServiceDispatcherImpl::WorkerUpdate(
                 << task->task_id << " on worker " << task->worker_address;
         continue;
       }
-      Update update;
-      update.mutable_finish_task()->set_task_id(task_id);
-      TF_RETURN_IF_ERROR(Apply(update));
+      finish_tasks.emplace_back();
+      finish_tasks.back().mutable_finish_task()->set_task_id(task_id);
       VLOG(3) << "Task " << task_id << " from job " << task->job_id
               << " completed";
     }
   }
+  return ApplyBatch(finish_tasks);
+}
+
+Status DataServiceDispatcherImpl::GetSplit(const GetSplitRequest* request,
+                                           GetSplitResponse* response) {
+  mutex_lock l(mu_);
+  std::shared_ptr<const Task> task;
+  TF_RETURN_IF_ERROR(state_.TaskFromId(request->task_id(), &task));
+  RecordHeartbeat(task->worker_address);
+  std::shared_ptr<const Job> job;
+  TF_RETURN_IF_ERROR(state_.JobFromId(task->job_id, &job));
+  if (job->processing_mode != ProcessingMode::ONE_EPOCH) {
+    return errors::FailedPrecondition(
+        "Splits are only handed out for ONE_EPOCH jobs, but job ", job->job_id,
+        " has processing mode ", ProcessingModeToString(job->processing_mode));
+  }
+  std::vector<Update> updates;
+  for (int64 split_index : request->finished_splits()) {
+    auto it = job->acquired_splits.find(split_index);
+    if (it == job->acquired_splits.end() || it->second != task->task_id) {
+      // The split was released while the task was processing it, e.g.
+      // because the worker was too slow to check in.
+      VLOG(1) << "Ignoring finished split " << split_index << " of job "
+              << job->job_id << " from task " << task->task_id
+              << ", which no longer holds it";
+      continue;
+    }
+    updates.emplace_back();
+    FinishSplitUpdate* finish_split = updates.back().mutable_finish_split();
+    finish_split->set_job_id(job->job_id);
+    finish_split->set_split_index(split_index);
+  }
+  TF_RETURN_IF_ERROR(ApplyBatch(updates));
+  TF_RETURN_IF_ERROR(ReleaseSplitsOfLostWorkers(job));
+
+  response->set_num_splits(job->num_splits);
+  if (job->available_splits.empty()) {
+    response->set_split_index(-1);
+    response->set_end_of_splits(job->acquired_splits.empty());
+    return Status::OK();
+  }
+  int64 split_index = job->available_splits.front();
+  Update update;
+  AcquireSplitUpdate* acquire_split = update.mutable_acquire_split();
+  acquire_split->set_job_id(job->job_id);
+  acquire_split->set_split_index(split_index);
+  acquire_split->set_task_id(task->task_id);
+  TF_RETURN_IF_ERROR(Apply(update));
+  response->set_split_index(split_index);
+  VLOG(3) << "Handing out split " << split_index << " of job " << job->job_id
+          << " to task " << task->task_id;
   return Status::OK();
 }
 
+void DataServiceDispatcherImpl::RecordHeartbeat(
+    const std::string& worker_address) LOCKS_EXCLUDED(heartbeat_mu_) {
+  mutex_lock l(heartbeat_mu_);
+  worker_heartbeat_micros_[worker_address] = Env::Default()->NowMicros();
+}
+
+Status DataServiceDispatcherImpl::ReleaseSplitsOfLostWorkers(
+    std::shared_ptr<const Job> job) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+  int64 timeout_ms = config_.worker_timeout_ms() > 0
+                         ? config_.worker_timeout_ms()
+                         : kDefaultWorkerTimeoutMs;
+  uint64 now_micros = Env::Default()->NowMicros();
+  std::vector<int64> lost_splits;
+  mutex_lock l(heartbeat_mu_);
+  for (const auto& it : job->acquired_splits) {
+    std::shared_ptr<const Task> task;
+    TF_RETURN_IF_ERROR(state_.TaskFromId(it.second, &task));
+    auto heartbeat = worker_heartbeat_micros_.find(task->worker_address);
+    if (heartbeat == worker_heartbeat_micros_.end()) {
+      // The dispatcher restarted since it last heard from the worker.
+      worker_heartbeat_micros_[task->worker_address] = now_micros;
+      continue;
+    }
+    if (now_micros - heartbeat->second > timeout_ms * 1000) {
+      lost_splits.push_back(it.first);
+    }
+  }
+  std::vector<Update> updates;
+  for (int64 split_index : lost_splits) {
+    LOG(INFO) << "Releasing split " << split_index << " of job " << job->job_id
+              << ", since its worker hasn't checked in for " << timeout_ms
+              << "ms";
+    updates.emplace_back();
+    ReleaseSplitUpdate* release_split = updates.back().mutable_release_split();
+    release_split->set_job_id(job->job_id);
+    release_split->set_split_index(split_index);
+  }
+  return ApplyBatch(updates);
+}
+
+Status DataServiceDispatcherImpl::ReleaseSplitsOfWorker(
+    const std::string& worker_address) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+  std::vector<std::shared_ptr<const Task>> tasks;
+  TF_RETURN_IF_ERROR(state_.TasksForWorker(worker_address, tasks));
+  std::vector<Update> updates;
+  for (const auto& task : tasks) {
+    std::shared_ptr<const Job> job;
+    TF_RETURN_IF_ERROR(state_.JobFromId(task->job_id, &job));
+    std::vector<int64> splits;
+    for (const auto& it : job->acquired_splits) {
+      if (it.second == task->task_id) {
+        splits.push_back(it.first);
+      }
+    }
+    for (int64 split_index : splits) {
+      updates.emplace_back();
+      ReleaseSplitUpdate* release_split =
+          updates.back().mutable_release_split();
+      release_split->set_job_id(job->job_id);
+      release_split->set_split_index(split_index);
+    }
+  }
+  return ApplyBatch(updates);
+}
+
 Status DataServiceDispatcherImpl::GetOrRegisterDataset(
     const GetOrRegisterDatasetRequest* request,
     GetOrRegisterDatasetResponse* response) {
@@ -328,13 +464,15 @@ Status DataServiceDispatcherImpl::CreateJob(
     int64 dataset_id, ProcessingMode processing_mode,
     absl::optional<NamedJobKey> named_job_key, std::shared_ptr<const Job>* job)
     EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+  int64 num_splits = 0;
   switch (processing_mode) {
     case ProcessingMode::PARALLEL_EPOCHS:
+    case ProcessingMode::SHARED_EPOCHS:
       break;
     case ProcessingMode::ONE_EPOCH:
-      return errors::Unimplemented(
-          "CreateJob only supports the PARALLEL_EPOCHS job mode. "
-          "ONE_EPOCH is not currently supported.");
+      num_splits = std::max<int64>(
+          kMinNumSplits, kSplitsPerWorker * state_.ListWorkers().size());
+      break;
     default:
       return errors::Unimplemented("ProcessingMode ",
                                    ProcessingModeToString(processing_mode),
@@ -346,6 +484,7 @@ Status DataServiceDispatcherImpl::CreateJob(
   create_job->set_job_id(job_id);
   create_job->set_dataset_id(dataset_id);
   create_job->set_processing_mode(ProcessingModeDef(processing_mode));
+  create_job->set_num_splits(num_splits);
   if (named_job_key.has_value()) {
     NamedJobKeyDef* key = create_job->mutable_named_job_key();
     key->set_name(named_job_key->name);
@@ -435,8 +574,13 @@ Status DataServiceDispatcherImpl::AssignTask(std::shared_ptr<const Task> task)
     TF_RETURN_IF_ERROR(dataset_store_->Get(
         DatasetKey(dataset->dataset_id, dataset->fingerprint), dataset_def));
     *task_def->mutable_dataset() = *dataset_def;
+    std::shared_ptr<const Job> job;
+    TF_RETURN_IF_ERROR(state_.JobFromId(task->job_id, &job));
+    task_def->set_processing_mode(ProcessingModeDef(job->processing_mode));
+    task_def->set_dataset_fingerprint(dataset->fingerprint);
   }
   task_def->set_task_id(task->task_id);
+  task_def->set_job_id(task->job_id);
   ProcessTaskResponse resp;
   WorkerService::Stub* stub;
   TF_RETURN_IF_ERROR(GetOrCreateWorkerStub(task->worker_address, &stub));
@@ -496,5 +640,16 @@ Status DataServiceDispatcherImpl::Apply(const Update& update)
   return state_.Apply(update);
 }
 
+Status DataServiceDispatcherImpl::ApplyBatch(const std::vector<Update>& updates)
+    EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+  if (journal_writer_.has_value()) {
+    TF_RETURN_IF_ERROR(journal_writer_.value()->WriteBatch(updates));
+  }
+  for (const auto& update : updates) {
+    TF_RETURN_IF_ERROR(state_.Apply(update));
+  }
+  return Status::OK();
+}
+
 }  // namespace data
 }  // namespace tensorflow
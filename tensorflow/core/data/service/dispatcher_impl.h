@@ -59,6 +59,7 @@ class DataServiceDispatcherImpl {
                         RegisterWorkerResponse* response);
   Status WorkerUpdate(const WorkerUpdateRequest* request,
                       WorkerUpdateResponse* response);
+  Status GetSplit(const GetSplitRequest* request, GetSplitResponse* response);
 
   /// Client-facing API.
   Status GetOrRegisterDataset(const GetOrRegisterDatasetRequest* request,
@@ -107,6 +108,17 @@ class DataServiceDispatcherImpl {
   // Assigns a task to the worker indicated by its `worker_address` field.
   Status AssignTask(std::shared_ptr<const DispatcherState::Task> task)
       LOCKS_EXCLUDED(mu_);
+  // Records that the dispatcher heard from the worker at `worker_address`.
+  void RecordHeartbeat(const std::string& worker_address)
+      LOCKS_EXCLUDED(heartbeat_mu_);
+  // Releases the splits of `job` held by tasks on workers which haven't been
+  // heard from within the worker timeout, so that other tasks can take them
+  // over.
+  Status ReleaseSplitsOfLostWorkers(std::shared_ptr<const DispatcherState::Job>
+                                        job) EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  // Releases all splits held by the tasks on the worker at `worker_address`.
+  Status ReleaseSplitsOfWorker(const std::string& worker_address)
+      EXCLUSIVE_LOCKS_REQUIRED(mu_);
   // Validates that an existing job matches the given processing_mode and
   // dataset_id, returning an error status describing any difference.
   Status ValidateMatchingJob(std::shared_ptr<const DispatcherState::Job> job,
@@ -114,6 +126,10 @@ class DataServiceDispatcherImpl {
       EXCLUSIVE_LOCKS_REQUIRED(mu_);
   // Applies a state update, updating both the journal and the in-memory state.
   Status Apply(const Update& update) EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  // Applies a batch of independent state updates, syncing the journal once
+  // for the whole batch.
+  Status ApplyBatch(const std::vector<Update>& updates)
+      EXCLUSIVE_LOCKS_REQUIRED(mu_);
   // Applies a state update, but doesn't update the journal. Only meant to be
   // used when recovering state when the dispatcher starts.
   Status ApplyWithoutJournaling(const Update& update)
@@ -125,6 +141,15 @@ class DataServiceDispatcherImpl {
 
   int64 next_task_id_ TF_GUARDED_BY(mu_) = 0;
 
+  // Heartbeats are tracked under their own lock so that heartbeats without
+  // task updates don't contend with state changes. When both locks are
+  // needed, `mu_` must be acquired first.
+  mutex heartbeat_mu_;
+  // The last time each worker was heard from, in microseconds. This is not
+  // journaled: after a restart, workers get a full timeout to check in again.
+  absl::flat_hash_map<std::string, uint64> worker_heartbeat_micros_
+      TF_GUARDED_BY(heartbeat_mu_);
+
   // Cached worker stubs for communicating with workers.
   absl::flat_hash_map<std::string, std::unique_ptr<WorkerService::Stub>>
       worker_stubs_ TF_GUARDED_BY(mu_);
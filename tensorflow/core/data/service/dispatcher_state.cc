@@ -14,6 +14,7 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/data/service/dispatcher_state.h"
 
+#include <algorithm>
 #include <memory>
 
 #include "tensorflow/core/data/service/journal.h"
@@ -42,6 +43,15 @@ Status DispatcherState::Apply(Update update) {
     case Update::kFinishTask:
       FinishTask(update.finish_task());
       break;
+    case Update::kAcquireSplit:
+      AcquireSplit(update.acquire_split());
+      break;
+    case Update::kFinishSplit:
+      FinishSplit(update.finish_split());
+      break;
+    case Update::kReleaseSplit:
+      ReleaseSplit(update.release_split());
+      break;
     case Update::UPDATE_TYPE_NOT_SET:
       return errors::Internal("Update type not set.");
   }
@@ -78,7 +88,7 @@ void DispatcherState::CreateJob(const CreateJobUpdate& create_job) {
   }
   auto job = std::make_shared<Job>(job_id, create_job.dataset_id(),
                                    ProcessingMode(create_job.processing_mode()),
-                                   named_job_key);
+                                   named_job_key, create_job.num_splits());
   DCHECK(!jobs_.contains(job_id));
   jobs_[job_id] = job;
   tasks_by_job_[job_id] = std::vector<std::shared_ptr<Task>>();
@@ -117,6 +127,35 @@ void DispatcherState::FinishTask(const FinishTaskUpdate& finish_task) {
   jobs_[task->job_id]->finished = all_finished;
 }
 
+void DispatcherState::AcquireSplit(const AcquireSplitUpdate& acquire_split) {
+  auto& job = jobs_[acquire_split.job_id()];
+  DCHECK(job != nullptr);
+  int64 split_index = acquire_split.split_index();
+  auto it = std::find(job->available_splits.begin(),
+                      job->available_splits.end(), split_index);
+  DCHECK(it != job->available_splits.end());
+  job->available_splits.erase(it);
+  job->acquired_splits[split_index] = acquire_split.task_id();
+}
+
+void DispatcherState::FinishSplit(const FinishSplitUpdate& finish_split) {
+  auto& job = jobs_[finish_split.job_id()];
+  DCHECK(job != nullptr);
+  DCHECK(job->acquired_splits.contains(finish_split.split_index()));
+  job->acquired_splits.erase(finish_split.split_index());
+  job->num_finished_splits++;
+}
+
+void DispatcherState::ReleaseSplit(const ReleaseSplitUpdate& release_split) {
+  auto& job = jobs_[release_split.job_id()];
+  DCHECK(job != nullptr);
+  DCHECK(job->acquired_splits.contains(release_split.split_index()));
+  job->acquired_splits.erase(release_split.split_index());
+  // Hand the split out again before the untouched ones, so that the tail of
+  // the epoch isn't left waiting on it.
+  job->available_splits.push_front(release_split.split_index());
+}
+
 int64 DispatcherState::NextAvailableDatasetId() const {
   return next_available_dataset_id_;
 }
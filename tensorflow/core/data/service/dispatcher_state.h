@@ -15,6 +15,8 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_DATA_SERVICE_DISPATCHER_STATE_H_
 #define TENSORFLOW_CORE_DATA_SERVICE_DISPATCHER_STATE_H_
 
+#include <deque>
+
 #include "absl/container/flat_hash_map.h"
 #include "tensorflow/core/data/service/common.pb.h"
 #include "tensorflow/core/data/service/data_service.h"
@@ -96,16 +98,29 @@ class DispatcherState {
   // A job for processing a dataset.
   struct Job {
     explicit Job(int64 job_id, int64 dataset_id, ProcessingMode processing_mode,
-                 absl::optional<NamedJobKey> named_job_key)
+                 absl::optional<NamedJobKey> named_job_key, int64 num_splits)
         : job_id(job_id),
           dataset_id(dataset_id),
           processing_mode(processing_mode),
-          named_job_key(named_job_key) {}
+          named_job_key(named_job_key),
+          num_splits(num_splits) {
+      for (int64 i = 0; i < num_splits; ++i) {
+        available_splits.push_back(i);
+      }
+    }
 
     const int64 job_id;
     const int64 dataset_id;
     const ProcessingMode processing_mode;
     const absl::optional<NamedJobKey> named_job_key;
+    // The number of splits that ONE_EPOCH jobs hand out to tasks. 0 for other
+    // jobs.
+    const int64 num_splits;
+    // Splits waiting to be handed out to a task, in the order to hand them out.
+    std::deque<int64> available_splits;
+    // Splits being processed, mapped to the ids of the tasks processing them.
+    absl::flat_hash_map<int64, int64> acquired_splits;
+    int64 num_finished_splits = 0;
     bool finished = false;
   };
 
@@ -167,6 +182,9 @@ class DispatcherState {
   void CreateJob(const CreateJobUpdate& create_job);
   void CreateTask(const CreateTaskUpdate& create_task);
   void FinishTask(const FinishTaskUpdate& finish_task);
+  void AcquireSplit(const AcquireSplitUpdate& acquire_split);
+  void FinishSplit(const FinishSplitUpdate& finish_split);
+  void ReleaseSplit(const ReleaseSplitUpdate& release_split);
 
   int64 next_available_dataset_id_ = 0;
   // Registered datasets, keyed by dataset ids.
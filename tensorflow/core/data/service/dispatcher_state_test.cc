@@ -93,6 +93,47 @@ Status CreateTask(int64 task_id, int64 job_id, int64 dataset_id,
   return Status::OK();
 }
 
+Status CreateOneEpochJob(int64 job_id, int64 dataset_id, int64 num_splits,
+                         DispatcherState* state) {
+  Update update;
+  CreateJobUpdate* create_job = update.mutable_create_job();
+  create_job->set_job_id(job_id);
+  create_job->set_dataset_id(dataset_id);
+  create_job->set_processing_mode(ProcessingModeDef::ONE_EPOCH);
+  create_job->set_num_splits(num_splits);
+  TF_RETURN_IF_ERROR(state->Apply(update));
+  return Status::OK();
+}
+
+Status AcquireSplit(int64 job_id, int64 split_index, int64 task_id,
+                    DispatcherState* state) {
+  Update update;
+  AcquireSplitUpdate* acquire_split = update.mutable_acquire_split();
+  acquire_split->set_job_id(job_id);
+  acquire_split->set_split_index(split_index);
+  acquire_split->set_task_id(task_id);
+  TF_RETURN_IF_ERROR(state->Apply(update));
+  return Status::OK();
+}
+
+Status FinishSplit(int64 job_id, int64 split_index, DispatcherState* state) {
+  Update update;
+  FinishSplitUpdate* finish_split = update.mutable_finish_split();
+  finish_split->set_job_id(job_id);
+  finish_split->set_split_index(split_index);
+  TF_RETURN_IF_ERROR(state->Apply(update));
+  return Status::OK();
+}
+
+Status ReleaseSplit(int64 job_id, int64 split_index, DispatcherState* state) {
+  Update update;
+  ReleaseSplitUpdate* release_split = update.mutable_release_split();
+  release_split->set_job_id(job_id);
+  release_split->set_split_index(split_index);
+  TF_RETURN_IF_ERROR(state->Apply(update));
+  return Status::OK();
+}
+
 Status FinishTask(int64 task_id, DispatcherState* state) {
   Update update;
   FinishTaskUpdate* finish_task = update.mutable_finish_task();
@@ -400,5 +441,60 @@ TEST(DispatcherState, FinishMultiTaskJob) {
   }
 }
 
+TEST(DispatcherState, OneEpochJobSplits) {
+  int64 job_id = 3;
+  int64 dataset_id = 10;
+  int64 num_splits = 3;
+  DispatcherState state;
+  TF_EXPECT_OK(RegisterDataset(dataset_id, &state));
+  TF_EXPECT_OK(CreateOneEpochJob(job_id, dataset_id, num_splits, &state));
+  std::shared_ptr<const Job> job;
+  TF_EXPECT_OK(state.JobFromId(job_id, &job));
+  EXPECT_EQ(job->num_splits, num_splits);
+  EXPECT_THAT(job->available_splits, SizeIs(num_splits));
+  EXPECT_THAT(job->acquired_splits, IsEmpty());
+  EXPECT_EQ(job->num_finished_splits, 0);
+}
+
+TEST(DispatcherState, AcquireAndFinishSplits) {
+  int64 job_id = 3;
+  int64 dataset_id = 10;
+  int64 task_id = 4;
+  DispatcherState state;
+  TF_EXPECT_OK(RegisterDataset(dataset_id, &state));
+  TF_EXPECT_OK(CreateOneEpochJob(job_id, dataset_id, /*num_splits=*/2, &state));
+  TF_EXPECT_OK(AcquireSplit(job_id, /*split_index=*/0, task_id, &state));
+  std::shared_ptr<const Job> job;
+  TF_EXPECT_OK(state.JobFromId(job_id, &job));
+  EXPECT_EQ(job->available_splits.front(), 1);
+  EXPECT_EQ(job->acquired_splits.at(0), task_id);
+
+  TF_EXPECT_OK(FinishSplit(job_id, /*split_index=*/0, &state));
+  TF_EXPECT_OK(AcquireSplit(job_id, /*split_index=*/1, task_id, &state));
+  TF_EXPECT_OK(FinishSplit(job_id, /*split_index=*/1, &state));
+  EXPECT_THAT(job->available_splits, IsEmpty());
+  EXPECT_THAT(job->acquired_splits, IsEmpty());
+  EXPECT_EQ(job->num_finished_splits, 2);
+}
+
+TEST(DispatcherState, ReleaseSplit) {
+  int64 job_id = 3;
+  int64 dataset_id = 10;
+  int64 task_id = 4;
+  DispatcherState state;
+  TF_EXPECT_OK(RegisterDataset(dataset_id, &state));
+  TF_EXPECT_OK(CreateOneEpochJob(job_id, dataset_id, /*num_splits=*/3, &state));
+  TF_EXPECT_OK(AcquireSplit(job_id, /*split_index=*/0, task_id, &state));
+  TF_EXPECT_OK(AcquireSplit(job_id, /*split_index=*/1, task_id, &state));
+  TF_EXPECT_OK(ReleaseSplit(job_id, /*split_index=*/1, &state));
+  std::shared_ptr<const Job> job;
+  TF_EXPECT_OK(state.JobFromId(job_id, &job));
+  // Released splits are handed out before the ones never handed out.
+  EXPECT_THAT(job->available_splits, SizeIs(2));
+  EXPECT_EQ(job->available_splits.front(), 1);
+  EXPECT_THAT(job->acquired_splits, SizeIs(1));
+  EXPECT_EQ(job->num_finished_splits, 0);
+}
+
 }  // namespace data
 }  // namespace tensorflow
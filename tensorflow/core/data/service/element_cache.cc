@@ -0,0 +1,188 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/data/service/element_cache.h"
+
+#include <algorithm>
+
+#include "tensorflow/core/platform/errors.h"
+
+namespace tensorflow {
+namespace data {
+
+ElementCache::ElementCache(int64 max_bytes) : max_bytes_(max_bytes) {}
+
+Status ElementCache::MakeReader(const std::string& key,
+                                ElementProducerFactory factory,
+                                std::unique_ptr<Reader>* reader) {
+  mutex_lock l(mu_);
+  std::shared_ptr<Pass>& pass = joinable_passes_[key];
+  if (!pass) {
+    pass = std::make_shared<Pass>(key, std::move(factory));
+    passes_.push_back(pass);
+  }
+  reader->reset(new Reader(this, pass));
+  pass->readers.insert(reader->get());
+  return Status::OK();
+}
+
+int64 ElementCache::size_bytes() {
+  mutex_lock l(mu_);
+  return bytes_;
+}
+
+void ElementCache::EvictIfNeeded() {
+  while (bytes_ > max_bytes_) {
+    // Passes without readers are only kept in case a new reader joins them.
+    auto unread = std::find_if(
+        passes_.begin(), passes_.end(),
+        [](const std::shared_ptr<Pass>& p) { return p->readers.empty(); });
+    if (unread != passes_.end()) {
+      DropPass(unread->get());
+      continue;
+    }
+    Pass* read_by_all = nullptr;
+    Pass* largest = nullptr;
+    for (const auto& pass : passes_) {
+      if (pass->elements.empty()) {
+        continue;
+      }
+      int64 min_position = kint64max;
+      for (const Reader* reader : pass->readers) {
+        min_position = std::min(min_position, reader->position_);
+      }
+      if (min_position > pass->first_index) {
+        read_by_all = pass.get();
+        break;
+      }
+      if (largest == nullptr || pass->bytes > largest->bytes) {
+        largest = pass.get();
+      }
+    }
+    Pass* pass = read_by_all ? read_by_all : largest;
+    if (pass == nullptr) {
+      return;
+    }
+    EvictFirstElement(pass);
+  }
+}
+
+void ElementCache::EvictFirstElement(Pass* pass) {
+  pass->bytes -= pass->element_bytes.front();
+  bytes_ -= pass->element_bytes.front();
+  pass->elements.pop_front();
+  pass->element_bytes.pop_front();
+  pass->first_index++;
+  auto it = joinable_passes_.find(pass->key);
+  if (it != joinable_passes_.end() && it->second.get() == pass) {
+    joinable_passes_.erase(it);
+  }
+}
+
+void ElementCache::DropPass(Pass* pass) {
+  bytes_ -= pass->bytes;
+  pass->bytes = 0;
+  pass->elements.clear();
+  pass->element_bytes.clear();
+  auto joinable = joinable_passes_.find(pass->key);
+  if (joinable != joinable_passes_.end() && joinable->second.get() == pass) {
+    joinable_passes_.erase(joinable);
+  }
+  passes_.erase(std::find_if(
+      passes_.begin(), passes_.end(),
+      [pass](const std::shared_ptr<Pass>& p) { return p.get() == pass; }));
+}
+
+void ElementCache::RemoveReader(Pass* pass, Reader* reader) {
+  pass->readers.erase(reader);
+  if (!pass->readers.empty()) {
+    return;
+  }
+  auto joinable = joinable_passes_.find(pass->key);
+  if (joinable == joinable_passes_.end() || joinable->second.get() != pass) {
+    DropPass(pass);
+  }
+}
+
+ElementCache::Reader::~Reader() {
+  if (detached_) {
+    return;
+  }
+  mutex_lock l(cache_->mu_);
+  cache_->RemoveReader(pass_.get(), this);
+}
+
+Status ElementCache::Reader::GetNext(CompressedElement* element,
+                                     bool* end_of_sequence) {
+  if (!detached_) {
+    mutex_lock produce_lock(pass_->produce_mu);
+    {
+      mutex_lock l(cache_->mu_);
+      if (position_ >= pass_->first_index) {
+        int64 offset = position_ - pass_->first_index;
+        if (offset < pass_->elements.size()) {
+          *element = pass_->elements[offset];
+          *end_of_sequence = false;
+          position_++;
+          return Status::OK();
+        }
+        if (pass_->end_of_sequence) {
+          *end_of_sequence = true;
+          return Status::OK();
+        }
+      } else {
+        cache_->RemoveReader(pass_.get(), this);
+        detached_ = true;
+      }
+    }
+    if (!detached_) {
+      if (!pass_->producer) {
+        TF_RETURN_IF_ERROR(pass_->factory(&pass_->producer));
+      }
+      CompressedElement produced;
+      TF_RETURN_IF_ERROR(pass_->producer->GetNext(&produced, end_of_sequence));
+      mutex_lock l(cache_->mu_);
+      if (*end_of_sequence) {
+        pass_->end_of_sequence = true;
+        pass_->producer.reset();
+        return Status::OK();
+      }
+      int64 bytes = produced.ByteSizeLong();
+      *element = produced;
+      pass_->elements.push_back(std::move(produced));
+      pass_->element_bytes.push_back(bytes);
+      pass_->bytes += bytes;
+      cache_->bytes_ += bytes;
+      position_++;
+      cache_->EvictIfNeeded();
+      return Status::OK();
+    }
+  }
+  if (!private_producer_) {
+    std::unique_ptr<ElementProducer> producer;
+    TF_RETURN_IF_ERROR(pass_->factory(&producer));
+    for (int64 i = 0; i < position_; ++i) {
+      CompressedElement skipped;
+      TF_RETURN_IF_ERROR(producer->GetNext(&skipped, end_of_sequence));
+      if (*end_of_sequence) {
+        return Status::OK();
+      }
+    }
+    private_producer_ = std::move(producer);
+  }
+  return private_producer_->GetNext(element, end_of_sequence);
+}
+
+}  // namespace data
+}  // namespace tensorflow
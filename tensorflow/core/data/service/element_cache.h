@@ -0,0 +1,150 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_DATA_SERVICE_ELEMENT_CACHE_H_
+#define TENSORFLOW_CORE_DATA_SERVICE_ELEMENT_CACHE_H_
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "tensorflow/core/data/dataset.pb.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+
+namespace tensorflow {
+namespace data {
+
+// Produces the elements of one pass over a dataset.
+class ElementProducer {
+ public:
+  virtual ~ElementProducer() = default;
+
+  // Produces the next element into `*element`, or sets `*end_of_sequence` to
+  // true if there are no more elements.
+  virtual Status GetNext(CompressedElement* element, bool* end_of_sequence) = 0;
+};
+
+// Creates a producer for a new pass over a dataset.
+using ElementProducerFactory =
+    std::function<Status(std::unique_ptr<ElementProducer>*)>;
+
+// A bounded cache of dataset elements, shared by readers of the same dataset.
+//
+// Readers of the same key iterate over the same pass over the dataset: the
+// first reader to need an element produces it, and the element is cached for
+// the other readers. A reader joins the current pass for its key if the pass
+// still holds its first element, and starts a new pass otherwise.
+//
+// When the cache grows beyond `max_bytes`, elements are evicted in this order:
+// elements of passes which have no readers, elements which all readers of
+// their pass have already read, and finally the oldest elements of the
+// largest pass. A reader whose next element was evicted continues with a
+// private pass over the dataset, skipping the elements it has already read.
+//
+// This class is thread-safe.
+class ElementCache {
+ public:
+  class Reader;
+
+  explicit ElementCache(int64 max_bytes);
+  ElementCache(const ElementCache&) = delete;
+  ElementCache& operator=(const ElementCache&) = delete;
+
+  // Creates a reader for the elements of the dataset identified by `key`.
+  // `factory` creates producers for passes over the dataset.
+  Status MakeReader(const std::string& key, ElementProducerFactory factory,
+                    std::unique_ptr<Reader>* reader) TF_LOCKS_EXCLUDED(mu_);
+
+  // Returns the number of bytes of cached elements.
+  int64 size_bytes() TF_LOCKS_EXCLUDED(mu_);
+
+ private:
+  // One pass over a dataset.
+  struct Pass {
+    explicit Pass(const std::string& key, ElementProducerFactory factory)
+        : key(key), factory(std::move(factory)) {}
+
+    const std::string key;
+    const ElementProducerFactory factory;
+    // Serializes production of elements by the readers of the pass.
+    mutex produce_mu;
+    std::unique_ptr<ElementProducer> producer TF_GUARDED_BY(produce_mu);
+    // The remaining fields are guarded by the cache's `mu_`.
+    // The cached elements, starting with element `first_index` of the pass.
+    std::deque<CompressedElement> elements;
+    std::deque<int64> element_bytes;
+    int64 first_index = 0;
+    int64 bytes = 0;
+    bool end_of_sequence = false;
+    absl::flat_hash_set<Reader*> readers;
+  };
+
+  // Evicts elements until the cache holds at most `max_bytes_` bytes.
+  void EvictIfNeeded() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  // Evicts the first cached element of `pass`.
+  void EvictFirstElement(Pass* pass) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  // Drops `pass` and its cached elements from the cache.
+  void DropPass(Pass* pass) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  // Removes `reader` from `pass`, dropping the pass if no new reader can join
+  // it.
+  void RemoveReader(Pass* pass, Reader* reader)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  const int64 max_bytes_;
+  mutex mu_;
+  int64 bytes_ TF_GUARDED_BY(mu_) = 0;
+  // All passes which have readers or cached elements.
+  std::vector<std::shared_ptr<Pass>> passes_ TF_GUARDED_BY(mu_);
+  // The pass new readers of each key join. Only passes which still hold their
+  // first element are joinable.
+  absl::flat_hash_map<std::string, std::shared_ptr<Pass>> joinable_passes_
+      TF_GUARDED_BY(mu_);
+};
+
+// Reads the elements of one pass over a dataset from an `ElementCache`. The
+// reader must not outlive the cache.
+class ElementCache::Reader {
+ public:
+  ~Reader();
+
+  // Gets the next element into `*element`, or sets `*end_of_sequence` to true
+  // if there are no more elements.
+  Status GetNext(CompressedElement* element, bool* end_of_sequence);
+
+ private:
+  friend class ElementCache;
+
+  Reader(ElementCache* cache, std::shared_ptr<Pass> pass)
+      : cache_(cache), pass_(std::move(pass)) {}
+
+  ElementCache* const cache_;
+  const std::shared_ptr<Pass> pass_;
+  // The index of the next element to read.
+  int64 position_ = 0;
+  // Set once the elements the reader needs have been evicted, after which the
+  // reader no longer reads from `pass_`.
+  bool detached_ = false;
+  std::unique_ptr<ElementProducer> private_producer_;
+};
+
+}  // namespace data
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DATA_SERVICE_ELEMENT_CACHE_H_
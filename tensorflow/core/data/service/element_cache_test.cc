@@ -0,0 +1,184 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/data/service/element_cache.h"
+
+#include "absl/memory/memory.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace data {
+
+namespace {
+constexpr char kKey[] = "key";
+
+// Produces `num_elements` elements, each holding its index as data.
+class RangeProducer : public ElementProducer {
+ public:
+  RangeProducer(int64 num_elements, int64* num_produced)
+      : num_elements_(num_elements), num_produced_(num_produced) {}
+
+  Status GetNext(CompressedElement* element, bool* end_of_sequence) override {
+    if (next_ >= num_elements_) {
+      *end_of_sequence = true;
+      return Status::OK();
+    }
+    element->set_data(std::string(100, 'a' + next_ % 26));
+    *end_of_sequence = false;
+    next_++;
+    (*num_produced_)++;
+    return Status::OK();
+  }
+
+ private:
+  const int64 num_elements_;
+  int64* const num_produced_;
+  int64 next_ = 0;
+};
+
+ElementProducerFactory RangeFactory(int64 num_elements, int64* num_produced) {
+  return [num_elements, num_produced](std::unique_ptr<ElementProducer>* out) {
+    *out = absl::make_unique<RangeProducer>(num_elements, num_produced);
+    return Status::OK();
+  };
+}
+
+std::vector<std::string> ReadAll(ElementCache::Reader* reader) {
+  std::vector<std::string> result;
+  while (true) {
+    CompressedElement element;
+    bool end_of_sequence;
+    TF_CHECK_OK(reader->GetNext(&element, &end_of_sequence));
+    if (end_of_sequence) {
+      return result;
+    }
+    result.push_back(element.data());
+  }
+}
+
+std::vector<std::string> Expected(int64 num_elements) {
+  std::vector<std::string> result;
+  for (int64 i = 0; i < num_elements; ++i) {
+    result.push_back(std::string(100, 'a' + i % 26));
+  }
+  return result;
+}
+}  // namespace
+
+TEST(ElementCache, SingleReader) {
+  ElementCache cache(/*max_bytes=*/1 << 20);
+  int64 num_produced = 0;
+  std::unique_ptr<ElementCache::Reader> reader;
+  TF_ASSERT_OK(
+      cache.MakeReader(kKey, RangeFactory(10, &num_produced), &reader));
+  EXPECT_EQ(ReadAll(reader.get()), Expected(10));
+  EXPECT_EQ(num_produced, 10);
+}
+
+TEST(ElementCache, ConcurrentReadersShareElements) {
+  ElementCache cache(/*max_bytes=*/1 << 20);
+  int64 num_produced = 0;
+  std::unique_ptr<ElementCache::Reader> reader1;
+  std::unique_ptr<ElementCache::Reader> reader2;
+  TF_ASSERT_OK(
+      cache.MakeReader(kKey, RangeFactory(10, &num_produced), &reader1));
+  TF_ASSERT_OK(
+      cache.MakeReader(kKey, RangeFactory(10, &num_produced), &reader2));
+  EXPECT_EQ(ReadAll(reader1.get()), Expected(10));
+  EXPECT_EQ(ReadAll(reader2.get()), Expected(10));
+  EXPECT_EQ(num_produced, 10);
+}
+
+TEST(ElementCache, LaterReaderReusesCompletedPass) {
+  ElementCache cache(/*max_bytes=*/1 << 20);
+  int64 num_produced = 0;
+  std::unique_ptr<ElementCache::Reader> reader;
+  TF_ASSERT_OK(
+      cache.MakeReader(kKey, RangeFactory(10, &num_produced), &reader));
+  EXPECT_EQ(ReadAll(reader.get()), Expected(10));
+  reader.reset();
+  TF_ASSERT_OK(
+      cache.MakeReader(kKey, RangeFactory(10, &num_produced), &reader));
+  EXPECT_EQ(ReadAll(reader.get()), Expected(10));
+  EXPECT_EQ(num_produced, 10);
+}
+
+TEST(ElementCache, DifferentKeysDoNotShare) {
+  ElementCache cache(/*max_bytes=*/1 << 20);
+  int64 num_produced = 0;
+  std::unique_ptr<ElementCache::Reader> reader1;
+  std::unique_ptr<ElementCache::Reader> reader2;
+  TF_ASSERT_OK(
+      cache.MakeReader("key1", RangeFactory(10, &num_produced), &reader1));
+  TF_ASSERT_OK(
+      cache.MakeReader("key2", RangeFactory(10, &num_produced), &reader2));
+  EXPECT_EQ(ReadAll(reader1.get()), Expected(10));
+  EXPECT_EQ(ReadAll(reader2.get()), Expected(10));
+  EXPECT_EQ(num_produced, 20);
+}
+
+TEST(ElementCache, EvictsElementsReadByAllReaders) {
+  ElementCache cache(/*max_bytes=*/1000);
+  int64 num_produced = 0;
+  std::unique_ptr<ElementCache::Reader> reader1;
+  std::unique_ptr<ElementCache::Reader> reader2;
+  TF_ASSERT_OK(
+      cache.MakeReader(kKey, RangeFactory(100, &num_produced), &reader1));
+  TF_ASSERT_OK(
+      cache.MakeReader(kKey, RangeFactory(100, &num_produced), &reader2));
+  std::vector<std::string> expected = Expected(100);
+  for (int64 i = 0; i < 100; ++i) {
+    CompressedElement element;
+    bool end_of_sequence;
+    TF_ASSERT_OK(reader1->GetNext(&element, &end_of_sequence));
+    EXPECT_EQ(element.data(), expected[i]);
+    TF_ASSERT_OK(reader2->GetNext(&element, &end_of_sequence));
+    EXPECT_EQ(element.data(), expected[i]);
+    EXPECT_LE(cache.size_bytes(), 1000);
+  }
+  EXPECT_EQ(num_produced, 100);
+}
+
+TEST(ElementCache, SlowReaderFallsBackToPrivatePass) {
+  ElementCache cache(/*max_bytes=*/1000);
+  int64 num_produced = 0;
+  std::unique_ptr<ElementCache::Reader> fast;
+  std::unique_ptr<ElementCache::Reader> slow;
+  TF_ASSERT_OK(cache.MakeReader(kKey, RangeFactory(50, &num_produced), &fast));
+  TF_ASSERT_OK(cache.MakeReader(kKey, RangeFactory(50, &num_produced), &slow));
+  EXPECT_EQ(ReadAll(fast.get()), Expected(50));
+  EXPECT_LE(cache.size_bytes(), 1000);
+  EXPECT_EQ(ReadAll(slow.get()), Expected(50));
+  EXPECT_EQ(num_produced, 100);
+}
+
+TEST(ElementCache, ProducerError) {
+  ElementCache cache(/*max_bytes=*/1 << 20);
+  std::unique_ptr<ElementCache::Reader> reader;
+  TF_ASSERT_OK(cache.MakeReader(
+      kKey,
+      [](std::unique_ptr<ElementProducer>* out) {
+        return errors::Internal("failed to make producer");
+      },
+      &reader));
+  CompressedElement element;
+  bool end_of_sequence;
+  Status s = reader->GetNext(&element, &end_of_sequence);
+  EXPECT_EQ(s.code(), error::INTERNAL);
+}
+
+}  // namespace data
+}  // namespace tensorflow
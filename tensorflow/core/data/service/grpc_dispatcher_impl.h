@@ -47,6 +47,7 @@ class GrpcDispatcherImpl : public DispatcherService::Service {
                         method##Response* response) override;
   HANDLER(RegisterWorker);
   HANDLER(WorkerUpdate);
+  HANDLER(GetSplit);
   HANDLER(GetOrRegisterDataset);
   HANDLER(CreateJob);
   HANDLER(GetOrCreateJob);
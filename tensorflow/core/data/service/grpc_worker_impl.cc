@@ -26,23 +26,34 @@ using ::grpc::ServerContext;
 
 GrpcWorkerImpl::GrpcWorkerImpl(ServerBuilder* server_builder,
                                const experimental::WorkerConfig& config)
-    : impl_(config) {
+    : impl_(std::make_shared<DataServiceWorkerImpl>(config)) {
   server_builder->RegisterService(this);
   VLOG(1) << "Registered data service worker";
 }
 
 Status GrpcWorkerImpl::Start(const std::string& worker_address) {
-  return impl_.Start(worker_address);
+  TF_RETURN_IF_ERROR(impl_->Start(worker_address));
+  LocalWorkers::Add(worker_address, impl_);
+  worker_address_ = worker_address;
+  return Status::OK();
+}
+
+void GrpcWorkerImpl::Stop() {
+  if (!worker_address_.empty()) {
+    LocalWorkers::Remove(worker_address_);
+    worker_address_.clear();
+  }
 }
 
 #define HANDLER(method)                                                 \
   ::grpc::Status GrpcWorkerImpl::method(ServerContext* context,         \
                                         const method##Request* request, \
                                         method##Response* response) {   \
-    return ToGrpcStatus(impl_.method(request, response));               \
+    return ToGrpcStatus(impl_->method(request, response));              \
   }
 HANDLER(ProcessTask);
 HANDLER(GetElement);
+HANDLER(GetElements);
 #undef HANDLER
 
 }  // namespace data
@@ -37,9 +37,13 @@ class GrpcWorkerImpl : public WorkerService::Service {
  public:
   explicit GrpcWorkerImpl(::grpc::ServerBuilder* server_builder,
                           const experimental::WorkerConfig& config);
-  ~GrpcWorkerImpl() override {}
+  ~GrpcWorkerImpl() override { Stop(); }
 
+  // Starts the worker, and registers it as a local worker so that clients in
+  // this process can bypass gRPC.
   Status Start(const std::string& worker_address);
+  // Unregisters the local worker.
+  void Stop();
 
 #define HANDLER(method)                                 \
   ::grpc::Status method(::grpc::ServerContext* context, \
@@ -47,10 +51,13 @@ class GrpcWorkerImpl : public WorkerService::Service {
                         method##Response* response) override;
   HANDLER(ProcessTask);
   HANDLER(GetElement);
+  HANDLER(GetElements);
 #undef HANDLER
 
  private:
-  DataServiceWorkerImpl impl_;
+  std::string worker_address_;
+  // Shared with `LocalWorkers` while the worker is running.
+  std::shared_ptr<DataServiceWorkerImpl> impl_;
 
   TF_DISALLOW_COPY_AND_ASSIGN(GrpcWorkerImpl);
 };
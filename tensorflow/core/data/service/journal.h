@@ -15,6 +15,8 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_DATA_SERVICE_JOURNAL_H_
 #define TENSORFLOW_CORE_DATA_SERVICE_JOURNAL_H_
 
+#include <vector>
+
 #include "tensorflow/core/data/service/journal.pb.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/io/record_reader.h"
@@ -34,6 +36,9 @@ class JournalWriter {
   virtual ~JournalWriter() = default;
   // Writes and syncs an update to the journal.
   virtual Status Write(const Update& update) = 0;
+  // Writes a batch of updates to the journal, syncing once after all of them
+  // are written instead of once per update.
+  virtual Status WriteBatch(const std::vector<Update>& updates) = 0;
   // Initializes the writer if it is not yet initialized.
   virtual Status EnsureInitialized() = 0;
 };
@@ -64,9 +69,15 @@ class FileJournalWriter : public JournalWriter {
   FileJournalWriter& operator=(const FileJournalWriter&) = delete;
 
   Status Write(const Update& update) override;
+  Status WriteBatch(const std::vector<Update>& updates) override;
   Status EnsureInitialized() override;
 
  private:
+  // Appends `update` to the journal without syncing it.
+  Status WriteRecord(const Update& update);
+  // Flushes and syncs the written records to the journal file.
+  Status Sync();
+
   Env* env_;
   const std::string journal_dir_;
   std::unique_ptr<WritableFile> file_;
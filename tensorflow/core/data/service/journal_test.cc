@@ -95,6 +95,20 @@ TEST(Journal, RoundTripMultiple) {
   TF_EXPECT_OK(CheckJournalContent(journal_dir, updates));
 }
 
+TEST(Journal, RoundTripBatch) {
+  std::string journal_dir;
+  EXPECT_TRUE(NewJournalDir(&journal_dir));
+  std::vector<Update> updates = {MakeCreateJobUpdate(),
+                                 MakeRegisterDatasetUpdate(),
+                                 MakeFinishTaskUpdate()};
+  FileJournalWriter writer(Env::Default(), journal_dir);
+  TF_EXPECT_OK(writer.Write(updates[0]));
+  TF_EXPECT_OK(writer.WriteBatch({updates[1], updates[2]}));
+  TF_EXPECT_OK(writer.WriteBatch({}));
+
+  TF_EXPECT_OK(CheckJournalContent(journal_dir, updates));
+}
+
 TEST(Journal, AppendExistingJournal) {
   std::string journal_dir;
   EXPECT_TRUE(NewJournalDir(&journal_dir));
@@ -58,6 +58,8 @@ class GrpcDataServerBase {
   // Starts the service. This will be called after building the service, so
   // bound_port() will return the actual bound port.
   virtual Status StartServiceInternal() = 0;
+  // Stops the service. This will be called before shutting down the server.
+  virtual void StopServiceInternal() {}
 
   int bound_port() { return bound_port_; }
 
@@ -101,6 +103,7 @@ class WorkerGrpcDataServer : public GrpcDataServerBase {
  protected:
   void AddDataServiceToBuilder(::grpc::ServerBuilder* builder) override;
   Status StartServiceInternal() override;
+  void StopServiceInternal() override;
 
  private:
   const experimental::WorkerConfig config_;
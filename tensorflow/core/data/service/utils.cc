@@ -15,7 +15,10 @@ limitations under the License.
 
 #include "tensorflow/core/data/service/utils.h"
 
+#include "absl/strings/str_cat.h"
 #include "tensorflow/core/data/service/common.pb.h"
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/lib/io/record_reader.h"
 #include "tensorflow/core/lib/io/record_writer.h"
 #include "tensorflow/core/platform/env.h"
@@ -25,6 +28,23 @@ limitations under the License.
 namespace tensorflow {
 namespace data {
 
+namespace {
+// Prefix for the names of the nodes added by `ShardDatasetGraph`.
+constexpr char kShardNodePrefix[] = "tf_data_service_split";
+
+void AddScalarInt64Const(const std::string& name, int64 value,
+                         GraphDef* graph) {
+  NodeDef* node = graph->add_node();
+  node->set_name(name);
+  node->set_op("Const");
+  AddNodeAttr("dtype", DT_INT64, node);
+  Tensor tensor(value);
+  TensorProto proto;
+  tensor.AsProtoTensorContent(&proto);
+  AddNodeAttr("value", proto, node);
+}
+}  // namespace
+
 Status WriteDatasetDef(const std::string& path, const DatasetDef& dataset_def) {
   std::unique_ptr<WritableFile> file;
   TF_RETURN_IF_ERROR(Env::Default()->NewWritableFile(path, &file));
@@ -50,5 +70,60 @@ Status ReadDatasetDef(const std::string& path, DatasetDef& dataset_def) {
   return Status::OK();
 }
 
+Status ShardDatasetGraph(const GraphDef& graph, int64 num_splits,
+                         int64 split_index, GraphDef* sharded) {
+  if (num_splits < 1 || split_index < 0 || split_index >= num_splits) {
+    return errors::InvalidArgument("Invalid split ", split_index, " out of ",
+                                   num_splits, " splits");
+  }
+  *sharded = graph;
+  NodeDef* retval = nullptr;
+  for (NodeDef& node : *sharded->mutable_node()) {
+    if (node.op() == "_Retval") {
+      retval = &node;
+    }
+  }
+  if (retval == nullptr || retval->input_size() < 1) {
+    return errors::NotFound("Failed to find a _Retval op in the given dataset");
+  }
+  const std::string dataset_input = retval->input(0);
+  absl::string_view dataset_node_name =
+      absl::string_view(dataset_input).substr(0, dataset_input.find(':'));
+  const NodeDef* dataset_node = nullptr;
+  for (const NodeDef& node : sharded->node()) {
+    if (node.name() == dataset_node_name) {
+      dataset_node = &node;
+    }
+  }
+  if (dataset_node == nullptr) {
+    return errors::NotFound("Failed to find the dataset node ",
+                            dataset_node_name, " in the given dataset");
+  }
+  DataTypeVector output_types;
+  std::vector<PartialTensorShape> output_shapes;
+  TF_RETURN_IF_ERROR(
+      GetNodeAttr(*dataset_node, "output_types", &output_types));
+  TF_RETURN_IF_ERROR(
+      GetNodeAttr(*dataset_node, "output_shapes", &output_shapes));
+
+  const std::string num_splits_name =
+      absl::StrCat(kShardNodePrefix, "/num_splits");
+  const std::string split_index_name =
+      absl::StrCat(kShardNodePrefix, "/split_index");
+  const std::string shard_name = absl::StrCat(kShardNodePrefix, "/shard");
+  AddScalarInt64Const(num_splits_name, num_splits, sharded);
+  AddScalarInt64Const(split_index_name, split_index, sharded);
+  NodeDef* shard = sharded->add_node();
+  shard->set_name(shard_name);
+  shard->set_op("AutoShardDataset");
+  shard->add_input(dataset_input);
+  shard->add_input(num_splits_name);
+  shard->add_input(split_index_name);
+  AddNodeAttr("output_types", output_types, shard);
+  AddNodeAttr("output_shapes", output_shapes, shard);
+  retval->set_input(0, shard_name);
+  return Status::OK();
+}
+
 }  // namespace data
 }  // namespace tensorflow
@@ -16,6 +16,7 @@ limitations under the License.
 #define TENSORFLOW_CORE_DATA_SERVICE_UTILS_H_
 
 #include "tensorflow/core/data/service/common.pb.h"
+#include "tensorflow/core/framework/graph.pb.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/io/record_reader.h"
 #include "tensorflow/core/platform/env.h"
@@ -32,6 +33,14 @@ Status WriteDatasetDef(const std::string& path, const DatasetDef& dataset_def);
 // `dataset_def`. Returns NOT_FOUND if the path cannot be found.
 Status ReadDatasetDef(const std::string& path, DatasetDef& dataset_def);
 
+// Rewrites the dataset graph `graph` so that it only produces split
+// `split_index` out of `num_splits` splits of the dataset, storing the result
+// in `*sharded`. The splits are computed by an AutoShardDataset applied to the
+// dataset with the AUTO policy, so datasets reading from enough files are split
+// by file, and other datasets are split by element.
+Status ShardDatasetGraph(const GraphDef& graph, int64 num_splits,
+                         int64 split_index, GraphDef* sharded);
+
 }  // namespace data
 }  // namespace tensorflow
 
@@ -16,6 +16,7 @@ limitations under the License.
 
 #include "tensorflow/core/data/service/common.pb.h"
 #include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/framework/node_def_util.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/path.h"
@@ -31,6 +32,21 @@ DatasetDef DatasetDefWithVersion(int32 version) {
   def.mutable_graph()->set_version(version);
   return def;
 }
+
+// Returns a graph with a dataset node feeding a _Retval node.
+GraphDef DatasetGraph() {
+  GraphDef graph;
+  NodeDef* dataset = graph.add_node();
+  dataset->set_name("dataset");
+  dataset->set_op("RangeDataset");
+  AddNodeAttr("output_types", DataTypeVector({DT_INT64}), dataset);
+  AddNodeAttr("output_shapes", std::vector<PartialTensorShape>({{}}), dataset);
+  NodeDef* retval = graph.add_node();
+  retval->set_name("retval");
+  retval->set_op("_Retval");
+  retval->add_input("dataset:0");
+  return graph;
+}
 }  // namespace
 
 TEST(Utils, ReadWriteDataset) {
@@ -58,6 +74,42 @@ TEST(Utils, OverwriteDataset) {
   EXPECT_EQ(result.graph().version(), version_2);
 }
 
+TEST(Utils, ShardDatasetGraph) {
+  GraphDef sharded;
+  TF_ASSERT_OK(ShardDatasetGraph(DatasetGraph(), /*num_splits=*/4,
+                                 /*split_index=*/2, &sharded));
+  const NodeDef* shard = nullptr;
+  const NodeDef* retval = nullptr;
+  for (const NodeDef& node : sharded.node()) {
+    if (node.op() == "AutoShardDataset") {
+      shard = &node;
+    } else if (node.op() == "_Retval") {
+      retval = &node;
+    }
+  }
+  ASSERT_NE(shard, nullptr);
+  ASSERT_NE(retval, nullptr);
+  EXPECT_EQ(shard->input(0), "dataset:0");
+  EXPECT_EQ(retval->input(0), shard->name());
+  DataTypeVector output_types;
+  TF_ASSERT_OK(GetNodeAttr(*shard, "output_types", &output_types));
+  EXPECT_EQ(output_types, DataTypeVector({DT_INT64}));
+}
+
+TEST(Utils, ShardDatasetGraphInvalidSplit) {
+  GraphDef sharded;
+  Status s = ShardDatasetGraph(DatasetGraph(), /*num_splits=*/4,
+                               /*split_index=*/4, &sharded);
+  EXPECT_EQ(s.code(), error::INVALID_ARGUMENT);
+}
+
+TEST(Utils, ShardDatasetGraphNoRetval) {
+  GraphDef sharded;
+  Status s = ShardDatasetGraph(GraphDef(), /*num_splits=*/4,
+                               /*split_index=*/0, &sharded);
+  EXPECT_EQ(s.code(), error::NOT_FOUND);
+}
+
 TEST(Utils, ReadDatasetNotFound) {
   std::string filename = testing::TmpDir();
   ASSERT_TRUE(Env::Default()->CreateUniqueFileName(&filename, "journal_dir"));
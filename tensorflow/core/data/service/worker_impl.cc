@@ -17,6 +17,7 @@ limitations under the License.
 
 #include "grpcpp/create_channel.h"
 #include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
 #include "tensorflow/c/c_api_internal.h"
 #include "tensorflow/c/tf_status_helper.h"
 #include "tensorflow/core/data/dataset.pb.h"
@@ -24,6 +25,7 @@ limitations under the License.
 #include "tensorflow/core/data/service/dispatcher.grpc.pb.h"
 #include "tensorflow/core/data/service/dispatcher.pb.h"
 #include "tensorflow/core/data/service/grpc_util.h"
+#include "tensorflow/core/data/service/utils.h"
 #include "tensorflow/core/data/standalone.h"
 #include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/lib/core/errors.h"
@@ -37,17 +39,88 @@ namespace tensorflow {
 namespace data {
 
 const constexpr uint64 kRetryIntervalMicros = 5ull * 1000 * 1000;
+// How often to send heartbeats to the dispatcher, unless configured otherwise.
+const constexpr int64 kDefaultHeartbeatIntervalMs = 10 * 1000;
+// How many bytes of elements to cache for SHARED_EPOCHS tasks, unless
+// configured otherwise.
+const constexpr int64 kDefaultElementCacheSizeBytes = 512LL * 1024 * 1024;
 
 namespace {
 auto* tf_data_service_created =
     monitoring::Gauge<bool, 0>::New("/tensorflow/data/service/created",
                                     "Whether a tf.data service server "
                                     "has been created.");
+
+// Extracts the compressed element from the outputs of a dataset iterator.
+Status ToCompressedElement(std::vector<Tensor>& outputs,
+                           CompressedElement* element) {
+  if (outputs.size() != 1) {
+    return errors::FailedPrecondition(
+        "Expected dataset to produce a single scalar variant tensor, but the "
+        "dataset produced ",
+        outputs.size(), " outputs");
+  }
+  if (outputs[0].dtype() != DT_VARIANT) {
+    return errors::FailedPrecondition(
+        "Expected dataset to produce a single scalar variant tensor, but "
+        "the dataset produced a tensor with type ",
+        DataTypeString(outputs[0].dtype()));
+  }
+  if (!TensorShapeUtils::IsScalar(outputs[0].shape())) {
+    return errors::FailedPrecondition(
+        "Expected dataset to produce a single scalar variant tensor, but "
+        "the dataset produced a tensor with shape ",
+        outputs[0].shape());
+  }
+  Variant& variant = outputs[0].scalar<Variant>()();
+  CompressedElement* compressed = variant.get<CompressedElement>();
+  if (compressed == nullptr) {
+    return errors::FailedPrecondition(
+        "Expected dataset to produce a CompressedElement variant tensor, but "
+        "it produced ",
+        variant.TypeName());
+  }
+  compressed->Swap(element);
+  return Status::OK();
+}
+
+// Produces the elements of a dataset for the element cache.
+class IteratorElementProducer : public ElementProducer {
+ public:
+  static Status Create(const GraphDef& graph,
+                       std::unique_ptr<ElementProducer>* out) {
+    auto producer = absl::WrapUnique(new IteratorElementProducer());
+    standalone::Dataset::Params params;
+    TF_RETURN_IF_ERROR(
+        standalone::Dataset::FromGraph(params, graph, &producer->dataset_));
+    TF_RETURN_IF_ERROR(producer->dataset_->MakeIterator(&producer->iterator_));
+    *out = std::move(producer);
+    return Status::OK();
+  }
+
+  Status GetNext(CompressedElement* element, bool* end_of_sequence) override {
+    std::vector<Tensor> outputs;
+    TF_RETURN_IF_ERROR(iterator_->GetNext(&outputs, end_of_sequence));
+    if (*end_of_sequence) {
+      return Status::OK();
+    }
+    return ToCompressedElement(outputs, element);
+  }
+
+ private:
+  IteratorElementProducer() = default;
+
+  std::unique_ptr<standalone::Dataset> dataset_;
+  std::unique_ptr<standalone::Iterator> iterator_;
+};
 }  // namespace
 
 DataServiceWorkerImpl::DataServiceWorkerImpl(
     const experimental::WorkerConfig& config)
-    : config_(config) {
+    : config_(config),
+      cache_(config.element_cache_size_bytes() > 0
+                 ? config.element_cache_size_bytes()
+                 : kDefaultElementCacheSizeBytes) {
   tf_data_service_created->GetCell()->Set(true);
 }
 
@@ -63,6 +136,12 @@ Status DataServiceWorkerImpl::Start(const std::string& worker_address) {
 
   std::unique_ptr<DispatcherService::Stub> dispatcher;
   TF_RETURN_IF_ERROR(MakeDispatcherStub(&dispatcher));
+  std::unique_ptr<DispatcherService::Stub> split_dispatcher;
+  TF_RETURN_IF_ERROR(MakeDispatcherStub(&split_dispatcher));
+  {
+    mutex_lock l(mu_);
+    dispatcher_ = std::move(split_dispatcher);
+  }
 
   Status s = Register(dispatcher.get());
   while (!s.ok()) {
@@ -95,22 +174,40 @@ Status DataServiceWorkerImpl::ProcessTask(const ProcessTaskRequest* request,
 Status DataServiceWorkerImpl::ProcessTaskInternal(const TaskDef& task_def)
     EXCLUSIVE_LOCKS_REQUIRED(mu_) {
   VLOG(3) << "Received request to process task " << task_def.task_id();
-  standalone::Dataset::Params params;
+  ProcessingModeDef processing_mode = task_def.processing_mode();
   std::unique_ptr<standalone::Dataset> dataset;
-  TF_RETURN_IF_ERROR(standalone::Dataset::FromGraph(
-      params, task_def.dataset().graph(), &dataset));
-
   std::unique_ptr<standalone::Iterator> iterator;
-  TF_RETURN_IF_ERROR(dataset->MakeIterator(&iterator));
+  if (processing_mode == ProcessingModeDef::PARALLEL_EPOCHS) {
+    standalone::Dataset::Params params;
+    TF_RETURN_IF_ERROR(standalone::Dataset::FromGraph(
+        params, task_def.dataset().graph(), &dataset));
+    TF_RETURN_IF_ERROR(dataset->MakeIterator(&iterator));
+  }
 
   if (tasks_.contains(task_def.task_id())) {
     return errors::AlreadyExists("A task with id ", task_def.task_id(),
                                  " already exists.");
   }
+  std::unique_ptr<ElementCache::Reader> cache_reader;
+  if (processing_mode == ProcessingModeDef::SHARED_EPOCHS) {
+    GraphDef graph = task_def.dataset().graph();
+    TF_RETURN_IF_ERROR(cache_.MakeReader(
+        absl::StrCat(task_def.dataset_fingerprint()),
+        [graph](std::unique_ptr<ElementProducer>* producer) {
+          return IteratorElementProducer::Create(graph, producer);
+        },
+        &cache_reader));
+  }
   Task& task = tasks_[task_def.task_id()];
   task.task_id = task_def.task_id();
+  task.processing_mode = processing_mode;
   task.dataset = std::move(dataset);
   task.iterator = std::move(iterator);
+  task.cache_reader = std::move(cache_reader);
+  if (processing_mode == ProcessingModeDef::ONE_EPOCH) {
+    // The iterator is created once the task gets its first split.
+    task.dataset_def = task_def.dataset();
+  }
   VLOG(3) << "Began processing for task " << task_def.task_id();
   return Status::OK();
 }
@@ -119,6 +216,51 @@ Status DataServiceWorkerImpl::GetElement(const GetElementRequest* request,
                                          GetElementResponse* response) {
   VLOG(3) << "Received GetElement request for task " << request->task_id();
   bool end_of_sequence = false;
+  TF_RETURN_IF_ERROR(GetNextElement(request->task_id(),
+                                    response->mutable_compressed_element(),
+                                    &end_of_sequence));
+  response->set_end_of_sequence(end_of_sequence);
+  return Status::OK();
+}
+
+Status DataServiceWorkerImpl::GetElements(const GetElementsRequest* request,
+                                          GetElementsResponse* response) {
+  VLOG(3) << "Received GetElements request for task " << request->task_id()
+          << " with max_elements=" << request->max_elements()
+          << ", max_bytes=" << request->max_bytes();
+  const int64 max_elements = std::max<int64>(request->max_elements(), 1);
+  int64 num_bytes = 0;
+  while (response->compressed_elements_size() < max_elements &&
+         (request->max_bytes() <= 0 || num_bytes < request->max_bytes())) {
+    CompressedElement element;
+    bool end_of_sequence = false;
+    Status s = GetNextElement(request->task_id(), &element, &end_of_sequence);
+    if (!s.ok()) {
+      if (response->compressed_elements_size() > 0) {
+        // Return the elements produced so far instead of dropping them. If
+        // the error persists, the next request reports it.
+        VLOG(3) << "Returning " << response->compressed_elements_size()
+                << " elements for task " << request->task_id()
+                << " before error: " << s;
+        break;
+      }
+      return s;
+    }
+    if (end_of_sequence) {
+      response->set_end_of_sequence(true);
+      break;
+    }
+    num_bytes += element.data().size();
+    response->add_compressed_elements()->Swap(&element);
+  }
+  return Status::OK();
+}
+
+Status DataServiceWorkerImpl::GetNextElement(int64 task_id,
+                                             CompressedElement* element,
+                                             bool* end_of_sequence)
+    LOCKS_EXCLUDED(mu_) {
+  *end_of_sequence = false;
   std::vector<tensorflow::Tensor> outputs;
   {
     mutex_lock l(mu_);
@@ -129,62 +271,105 @@ Status DataServiceWorkerImpl::GetElement(const GetElementRequest* request,
       return errors::Unavailable(
           "Worker has not yet registered with dispatcher.");
     }
-    auto it = tasks_.find(request->task_id());
+    auto it = tasks_.find(task_id);
     if (it == tasks_.end()) {
       return errors::NotFound("DataServiceWorkerImpl::GetElement failed. ",
-                              "Task id ", request->task_id(), " not found");
+                              "Task id ", task_id, " not found");
     }
-    std::unique_ptr<standalone::Iterator>& iter = it->second.iterator;
-    if (iter == nullptr) {
-      VLOG(3) << "Task " << request->task_id() << " is already finished";
-      response->set_end_of_sequence(true);
-      return Status::OK();
+    Task& task = it->second;
+    if (task.processing_mode == ProcessingModeDef::ONE_EPOCH) {
+      if (task.end_of_splits) {
+        VLOG(3) << "Task " << task_id << " is already finished";
+        *end_of_sequence = true;
+        return Status::OK();
+      }
+      TF_RETURN_IF_ERROR(GetNextFromSplits(task, &outputs, end_of_sequence));
+    } else if (task.processing_mode == ProcessingModeDef::SHARED_EPOCHS) {
+      if (task.cache_reader == nullptr) {
+        VLOG(3) << "Task " << task_id << " is already finished";
+        *end_of_sequence = true;
+        return Status::OK();
+      }
+      TF_RETURN_IF_ERROR(task.cache_reader->GetNext(element, end_of_sequence));
+      if (!*end_of_sequence) {
+        return Status::OK();
+      }
+    } else {
+      if (task.iterator == nullptr) {
+        VLOG(3) << "Task " << task_id << " is already finished";
+        *end_of_sequence = true;
+        return Status::OK();
+      }
+      TF_RETURN_IF_ERROR(task.iterator->GetNext(&outputs, end_of_sequence));
     }
-    TF_RETURN_IF_ERROR(iter->GetNext(&outputs, &end_of_sequence));
-    if (end_of_sequence) {
-      VLOG(3) << "Reached end_of_sequence for task " << request->task_id();
+    if (*end_of_sequence) {
+      VLOG(3) << "Reached end_of_sequence for task " << task_id;
       // Release iterator memory and leave a null entry as a tombstone.
-      iter.reset();
-      pending_completed_tasks_.insert(request->task_id());
+      task.iterator.reset();
+      task.cache_reader.reset();
+      pending_completed_tasks_.insert(task_id);
       background_cv_.notify_one();
     }
   }
 
-  if (!end_of_sequence) {
-    VLOG(3) << "Producing an element for task " << request->task_id();
-    if (outputs.size() != 1) {
-      return errors::FailedPrecondition(
-          "Expected dataset to produce a single scalar variant tensor, but the "
-          "dataset produced ",
-          outputs.size(), " outputs");
-    }
-    if (outputs[0].dtype() != DT_VARIANT) {
-      return errors::FailedPrecondition(
-          "Expected dataset to produce a single scalar variant tensor, but "
-          "the dataset produced a tensor with type ",
-          DataTypeString(outputs[0].dtype()));
-    }
-    if (!TensorShapeUtils::IsScalar(outputs[0].shape())) {
-      return errors::FailedPrecondition(
-          "Expected dataset to produce a single scalar variant tensor, but "
-          "the dataset produced a tensor with shape ",
-          outputs[0].shape());
-    }
-    Variant& variant = outputs[0].scalar<Variant>()();
-    CompressedElement* compressed = variant.get<CompressedElement>();
-    if (compressed == nullptr) {
-      return errors::FailedPrecondition(
-          "Expected dataset to produce a CompressedElement variant tensor, but "
-          "it produced ",
-          variant.TypeName());
-    }
-    compressed->Swap(response->mutable_compressed_element());
+  if (!*end_of_sequence) {
+    VLOG(3) << "Producing an element for task " << task_id;
+    TF_RETURN_IF_ERROR(ToCompressedElement(outputs, element));
   }
-  response->set_end_of_sequence(end_of_sequence);
 
   return Status::OK();
 }
 
+Status DataServiceWorkerImpl::GetNextFromSplits(Task& task,
+                                                std::vector<Tensor>* outputs,
+                                                bool* end_of_sequence)
+    EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+  while (true) {
+    if (task.iterator == nullptr) {
+      GetSplitRequest req;
+      req.set_task_id(task.task_id);
+      for (int64 split_index : task.finished_splits) {
+        req.add_finished_splits(split_index);
+      }
+      GetSplitResponse resp;
+      grpc::ClientContext ctx;
+      grpc::Status s = dispatcher_->GetSplit(&ctx, req, &resp);
+      if (!s.ok()) {
+        return grpc_util::WrapError("Failed to get a split", s);
+      }
+      task.finished_splits.clear();
+      if (resp.end_of_splits()) {
+        task.end_of_splits = true;
+        *end_of_sequence = true;
+        return Status::OK();
+      }
+      if (resp.split_index() < 0) {
+        return errors::Unavailable(
+            "No split is available for task ", task.task_id,
+            " yet. The remaining splits are being processed by other tasks.");
+      }
+      GraphDef graph;
+      TF_RETURN_IF_ERROR(ShardDatasetGraph(task.dataset_def.graph(),
+                                           resp.num_splits(),
+                                           resp.split_index(), &graph));
+      standalone::Dataset::Params params;
+      TF_RETURN_IF_ERROR(
+          standalone::Dataset::FromGraph(params, graph, &task.dataset));
+      TF_RETURN_IF_ERROR(task.dataset->MakeIterator(&task.iterator));
+      task.split_index = resp.split_index();
+      VLOG(3) << "Task " << task.task_id << " began processing split "
+              << task.split_index;
+    }
+    TF_RETURN_IF_ERROR(task.iterator->GetNext(outputs, end_of_sequence));
+    if (!*end_of_sequence) {
+      return Status::OK();
+    }
+    task.finished_splits.push_back(task.split_index);
+    task.iterator.reset();
+    task.dataset.reset();
+  }
+}
+
 Status DataServiceWorkerImpl::MakeDispatcherStub(
     std::unique_ptr<DispatcherService::Stub>* stub) {
   ::grpc::ChannelArguments args;
@@ -220,11 +405,19 @@ void DataServiceWorkerImpl::BackgroundThread(
     DispatcherService::Stub* dispatcher_ptr) LOCKS_EXCLUDED(mu_) {
   std::unique_ptr<DispatcherService::Stub> dispatcher =
       absl::WrapUnique(dispatcher_ptr);
+  const int64 heartbeat_interval_ms = config_.heartbeat_interval_ms() > 0
+                                         ? config_.heartbeat_interval_ms()
+                                         : kDefaultHeartbeatIntervalMs;
   while (true) {
     {
       mutex_lock l(mu_);
-      while (!cancelled_ && pending_completed_tasks_.empty()) {
-        background_cv_.wait(l);
+      const uint64 heartbeat_micros =
+          Env::Default()->NowMicros() + heartbeat_interval_ms * 1000;
+      while (!cancelled_ && pending_completed_tasks_.empty() &&
+             Env::Default()->NowMicros() < heartbeat_micros) {
+        background_cv_.wait_for(
+            l, std::chrono::microseconds(heartbeat_micros -
+                                         Env::Default()->NowMicros()));
       }
       if (cancelled_) {
         VLOG(3) << "Background thread shutting down";
@@ -268,5 +461,33 @@ Status DataServiceWorkerImpl::SendTaskUpdates(
   return Status::OK();
 }
 
+mutex LocalWorkers::mu_(LINKER_INITIALIZED);
+LocalWorkers::AddressToWorkerMap* LocalWorkers::local_workers_ =
+    new AddressToWorkerMap();
+
+void LocalWorkers::Add(absl::string_view worker_address,
+                       std::shared_ptr<DataServiceWorkerImpl> worker) {
+  DCHECK(worker != nullptr) << "Adding a nullptr local worker is disallowed.";
+  VLOG(1) << "Register local worker at address " << worker_address;
+  mutex_lock l(mu_);
+  (*local_workers_)[std::string(worker_address)] = std::move(worker);
+}
+
+std::shared_ptr<DataServiceWorkerImpl> LocalWorkers::Get(
+    absl::string_view worker_address) {
+  tf_shared_lock l(mu_);
+  auto it = local_workers_->find(worker_address);
+  if (it == local_workers_->end()) {
+    return nullptr;
+  }
+  return it->second;
+}
+
+void LocalWorkers::Remove(absl::string_view worker_address) {
+  VLOG(1) << "Remove local worker at address " << worker_address;
+  mutex_lock l(mu_);
+  local_workers_->erase(worker_address);
+}
+
 }  // namespace data
 }  // namespace tensorflow
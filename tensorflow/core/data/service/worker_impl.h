@@ -15,9 +15,14 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_DATA_SERVICE_WORKER_IMPL_H_
 #define TENSORFLOW_CORE_DATA_SERVICE_WORKER_IMPL_H_
 
+#include <memory>
+#include <string>
+
 #include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
 #include "tensorflow/core/data/service/common.pb.h"
 #include "tensorflow/core/data/service/dispatcher.grpc.pb.h"
+#include "tensorflow/core/data/service/element_cache.h"
 #include "tensorflow/core/data/service/worker.pb.h"
 #include "tensorflow/core/data/standalone.h"
 #include "tensorflow/core/lib/core/status.h"
@@ -49,12 +54,19 @@ class DataServiceWorkerImpl {
   /// Client-facing API.
   Status GetElement(const GetElementRequest* request,
                     GetElementResponse* response);
+  Status GetElements(const GetElementsRequest* request,
+                     GetElementsResponse* response);
 
  private:
   Status MakeDispatcherStub(std::unique_ptr<DispatcherService::Stub>* stub);
+  // Produces the next element of task `task_id` into `*element`, or sets
+  // `*end_of_sequence` to true if the task has no more elements.
+  Status GetNextElement(int64 task_id, CompressedElement* element,
+                        bool* end_of_sequence) LOCKS_EXCLUDED(mu_);
   // Registers the worker with the dispatcher.
   Status Register(DispatcherService::Stub* dispatcher) LOCKS_EXCLUDED(mu_);
   // Sends task status to the dispatcher and checks for dispatcher commands.
+  // This also serves as the worker's heartbeat.
   Status SendTaskUpdates(DispatcherService::Stub* dispatcher)
       LOCKS_EXCLUDED(mu_);
   // Creates an iterator to process a task.
@@ -68,17 +80,44 @@ class DataServiceWorkerImpl {
 
   typedef struct Task {
     int64 task_id;
+    ProcessingModeDef processing_mode = ProcessingModeDef::PARALLEL_EPOCHS;
     // TODO(aaudibert): Have standalone::Iterator own a reference to
     // standalone::Dataset so that we don't need to store the dataset here.
     std::unique_ptr<standalone::Dataset> dataset;
     std::unique_ptr<standalone::Iterator> iterator;
+    // Used instead of `iterator` by SHARED_EPOCHS tasks, which read the
+    // elements of their dataset through the worker's element cache.
+    std::unique_ptr<ElementCache::Reader> cache_reader;
+
+    // The fields below are only used by ONE_EPOCH tasks, which iterate over
+    // one split of the dataset at a time, getting the next split from the
+    // dispatcher once they are done with the current one.
+    DatasetDef dataset_def;
+    // The split that `iterator` iterates over.
+    int64 split_index = -1;
+    // Finished splits that haven't been reported to the dispatcher yet.
+    std::vector<int64> finished_splits;
+    bool end_of_splits = false;
   } Task;
 
+  // Gets the next element of a ONE_EPOCH task, moving on to the next split
+  // whenever the current one is exhausted. Returns UNAVAILABLE if the
+  // dispatcher has no split for the task right now, in which case the caller
+  // should try again later.
+  Status GetNextFromSplits(Task& task, std::vector<Tensor>* outputs,
+                           bool* end_of_sequence) EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
   const experimental::WorkerConfig config_;
   // The worker's own address.
   std::string worker_address_;
 
+  // Elements shared between SHARED_EPOCHS tasks. Declared before `tasks_` so
+  // that it outlives the tasks' cache readers.
+  ElementCache cache_;
+
   mutex mu_;
+  // Stub for requesting splits from the dispatcher.
+  std::unique_ptr<DispatcherService::Stub> dispatcher_ TF_GUARDED_BY(mu_);
   // Information about tasks, keyed by task ids.
   absl::flat_hash_map<int64, Task> tasks_ TF_GUARDED_BY(mu_);
   // Completed tasks which haven't yet been communicated to the dispatcher.
@@ -93,6 +132,30 @@ class DataServiceWorkerImpl {
   TF_DISALLOW_COPY_AND_ASSIGN(DataServiceWorkerImpl);
 };
 
+// A process-wide registry of the workers running in this process, keyed by
+// worker address. Clients in the same process as a worker call it directly
+// instead of going through gRPC, which saves serializing each element and
+// sending it over the loopback interface.
+class LocalWorkers {
+ public:
+  // Registers `worker` under `worker_address`, replacing any worker previously
+  // registered there.
+  static void Add(absl::string_view worker_address,
+                  std::shared_ptr<DataServiceWorkerImpl> worker);
+  // Returns the worker registered under `worker_address`, or nullptr if there
+  // is none.
+  static std::shared_ptr<DataServiceWorkerImpl> Get(
+      absl::string_view worker_address);
+  // Unregisters the worker at `worker_address`, if any.
+  static void Remove(absl::string_view worker_address);
+
+ private:
+  using AddressToWorkerMap =
+      absl::flat_hash_map<std::string, std::shared_ptr<DataServiceWorkerImpl>>;
+  static mutex mu_;
+  static AddressToWorkerMap* local_workers_ TF_GUARDED_BY(mu_);
+};
+
 }  // namespace data
 }  // namespace tensorflow
 
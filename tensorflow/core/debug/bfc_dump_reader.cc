@@ -12,8 +12,11 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
+#include <algorithm>
 #include <cinttypes>
+#include <map>
 #include <string>
+#include <vector>
 
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/file_system.h"
@@ -200,6 +203,43 @@ void PrintChunksByOpName(const MemoryDump& md, const string& op_name,
       by_age, freed_at, false /*by_addr*/);
 }
 
+void PrintInUseBytesByOp(const MemoryDump& md) {
+  printf("------------In-use bytes by allocating Op:------------------\n");
+  struct OpUsage {
+    int64 bytes = 0;
+    int64 chunks = 0;
+    uint64 first_alloc_micros = 0;
+  };
+  std::map<string, OpUsage> usage;
+  int64 total_bytes = 0;
+  for (const auto& it : md.chunk()) {
+    if (!it.in_use()) continue;
+    OpUsage& op_usage = usage[it.op_name()];
+    op_usage.bytes += it.size();
+    ++op_usage.chunks;
+    if (op_usage.first_alloc_micros == 0 ||
+        it.alloc_micros() < op_usage.first_alloc_micros) {
+      op_usage.first_alloc_micros = it.alloc_micros();
+    }
+    total_bytes += it.size();
+  }
+  std::vector<std::pair<string, OpUsage>> sorted(usage.begin(), usage.end());
+  std::sort(sorted.begin(), sorted.end(),
+            [](const std::pair<string, OpUsage>& a,
+               const std::pair<string, OpUsage>& b) {
+              return a.second.bytes > b.second.bytes;
+            });
+  for (const auto& it : sorted) {
+    printf("  bytes=%" PRId64 " %3.1f%% chunks=%" PRId64
+           " first_alloc_micros=%" PRIu64 " op=%s\n",
+           static_cast<int64_t>(it.second.bytes),
+           100 * (it.second.bytes / static_cast<float>(total_bytes)),
+           static_cast<int64_t>(it.second.chunks),
+           static_cast<uint64_t>(it.second.first_alloc_micros),
+           it.first.c_str());
+  }
+}
+
 void PrintSizeHistory(const MemoryDump& md, bool by_age) {
   printf("------------Allocated Bytes by Action Count--------\n");
   printf("num snapshots: %d\n", md.snap_shot_size());
@@ -233,6 +273,7 @@ int main(int argc, char** argv) {
   bool by_age = true;
   bool freed_at = false;
   bool size_history = false;
+  bool by_op = false;
   std::string chunk_type = "A";
   std::string op_name = "";
   std::vector<tensorflow::Flag> flag_list = {
@@ -258,6 +299,9 @@ int main(int argc, char** argv) {
                        "(default).  Displays only Chunks of this type."),
       tensorflow::Flag("size_history", &size_history,
                        "If true, show the size history."),
+      tensorflow::Flag("by_op", &by_op,
+                       "Whether to print the bytes in use by each Op, "
+                       "largest first."),
   };
   bool parse_result = tensorflow::Flags::Parse(&argc, argv, flag_list);
   if (!parse_result || path.empty()) {
@@ -276,5 +320,6 @@ int main(int argc, char** argv) {
   if (!op_name.empty()) {
     tensorflow::PrintChunksByOpName(md, op_name, by_age, freed_at);
   }
+  if (by_op) tensorflow::PrintInUseBytesByOp(md);
   if (size_history) tensorflow::PrintSizeHistory(md, by_age);
 }
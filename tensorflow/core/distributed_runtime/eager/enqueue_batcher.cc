@@ -0,0 +1,167 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/eager/enqueue_batcher.h"
+
+#include <memory>
+#include <utility>
+
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+namespace eager {
+namespace {
+
+// Bounds on the size of a merged request. A request larger than
+// kMaxBatchBytes on its own is still sent, unmerged.
+constexpr size_t kMaxRequestsPerBatch = 256;
+constexpr size_t kMaxBatchBytes = 1 << 20;
+
+}  // namespace
+
+EnqueueBatcher::EnqueueBatcher(int max_in_flight, SendFn send)
+    : max_in_flight_(max_in_flight), send_(std::move(send)) {
+  DCHECK_GT(max_in_flight_, 0);
+}
+
+EnqueueBatcher::~EnqueueBatcher() {
+  DCHECK_EQ(in_flight_, 0);
+  DCHECK(pending_.empty());
+}
+
+void EnqueueBatcher::Enqueue(const EnqueueRequest* request,
+                             EnqueueResponse* response, StatusCallback done) {
+  mu_.lock();
+  if (!status_.ok()) {
+    Status s = status_;
+    mu_.unlock();
+    done(s);
+    return;
+  }
+  if (!sending_ && pending_.empty() && in_flight_ < max_in_flight_) {
+    // Nothing is queued, so send the caller's request without copying it.
+    sending_ = true;
+    ++in_flight_;
+    mu_.unlock();
+    Ref();
+    send_(request, response, [this, done = std::move(done)](const Status& s) {
+      done(s);
+      SendDone();
+    });
+    mu_.lock();
+  } else {
+    pending_.push_back({*request, response, std::move(done)});
+    if (sending_) {
+      mu_.unlock();
+      return;
+    }
+    sending_ = true;
+  }
+  SendLoop();
+}
+
+void EnqueueBatcher::SendLoop() {
+  while (!pending_.empty() && in_flight_ < max_in_flight_ && status_.ok()) {
+    std::deque<Pending> batch;
+    size_t batch_bytes = 0;
+    while (!pending_.empty() && batch.size() < kMaxRequestsPerBatch) {
+      const size_t bytes = pending_.front().request.ByteSizeLong();
+      if (!batch.empty() && batch_bytes + bytes > kMaxBatchBytes) break;
+      batch_bytes += bytes;
+      batch.push_back(std::move(pending_.front()));
+      pending_.pop_front();
+    }
+    ++in_flight_;
+    mu_.unlock();
+    SendBatch(std::move(batch));
+    mu_.lock();
+  }
+  sending_ = false;
+  mu_.unlock();
+}
+
+void EnqueueBatcher::SendBatch(std::deque<Pending> batch) {
+  Ref();
+  if (batch.size() == 1) {
+    auto pending = std::make_shared<Pending>(std::move(batch.front()));
+    send_(&pending->request, pending->response,
+          [this, pending](const Status& s) {
+            pending->done(s);
+            SendDone();
+          });
+    return;
+  }
+
+  struct Batch {
+    EnqueueRequest request;
+    EnqueueResponse response;
+    std::deque<Pending> parts;
+  };
+  auto merged = std::make_shared<Batch>();
+  merged->parts = std::move(batch);
+  merged->request.set_context_id(merged->parts.front().request.context_id());
+  for (Pending& part : merged->parts) {
+    // Swapping leaves empty items behind, so queue_size() of every part still
+    // tells how many responses belong to it.
+    for (QueueItem& item : *part.request.mutable_queue()) {
+      merged->request.add_queue()->Swap(&item);
+    }
+  }
+  VLOG(3) << "Sending " << merged->parts.size() << " enqueue requests with "
+          << merged->request.queue_size() << " items as one";
+  send_(&merged->request, &merged->response, [this, merged](const Status& s) {
+    int next = 0;
+    for (Pending& part : merged->parts) {
+      for (int i = 0; i < part.request.queue_size(); ++i, ++next) {
+        // On error the remote side stops early and returns fewer responses.
+        if (next < merged->response.queue_response_size()) {
+          part.response->add_queue_response()->Swap(
+              merged->response.mutable_queue_response(next));
+        }
+      }
+      part.done(s);
+    }
+    SendDone();
+  });
+}
+
+void EnqueueBatcher::SendDone() {
+  mu_.lock();
+  --in_flight_;
+  if (sending_ || pending_.empty()) {
+    // An active sender will pick up the freed slot.
+    mu_.unlock();
+  } else {
+    sending_ = true;
+    SendLoop();
+  }
+  Unref();
+}
+
+void EnqueueBatcher::Shutdown(const Status& status) {
+  DCHECK(!status.ok());
+  std::deque<Pending> pending;
+  {
+    mutex_lock l(mu_);
+    status_ = status;
+    pending.swap(pending_);
+  }
+  for (Pending& p : pending) {
+    p.done(status);
+  }
+}
+
+}  // namespace eager
+}  // namespace tensorflow
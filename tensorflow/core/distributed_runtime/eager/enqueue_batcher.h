@@ -0,0 +1,99 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_EAGER_ENQUEUE_BATCHER_H_
+#define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_EAGER_ENQUEUE_BATCHER_H_
+
+#include <deque>
+#include <functional>
+
+#include "tensorflow/core/lib/core/refcount.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/protobuf/eager_service.pb.h"
+
+namespace tensorflow {
+namespace eager {
+
+// Coalesces the EnqueueRequests streamed to one remote eager context.
+//
+// At most `max_in_flight` requests are outstanding at a time. Requests that
+// arrive while the limit is reached are queued, and when an outstanding
+// request completes the queued ones are merged into a single EnqueueRequest
+// whose queue items are the concatenation of theirs. When the remote side is
+// idle requests are sent as they come, so batching adds no latency; under
+// load the number of round trips drops to one per batch.
+//
+// Requests are sent in the order Enqueue() was called. The remote service
+// stops at the first failing item of a request, so all requests of a failed
+// batch complete with its error, consistent with the streaming call reporting
+// errors of earlier requests to later ones.
+//
+// Thread-safe.
+class EnqueueBatcher : public core::RefCounted {
+ public:
+  // Sends `request`, which may be deleted as soon as the call returns, and
+  // invokes `done` once `response` is filled. `done` may be invoked before
+  // the call returns.
+  typedef std::function<void(const EnqueueRequest* request,
+                             EnqueueResponse* response, StatusCallback done)>
+      SendFn;
+
+  EnqueueBatcher(int max_in_flight, SendFn send);
+  ~EnqueueBatcher() override;
+
+  // Same contract as EagerClient::StreamingEnqueueAsync: `request` can be
+  // deleted as soon as Enqueue returns.
+  void Enqueue(const EnqueueRequest* request, EnqueueResponse* response,
+               StatusCallback done);
+
+  // Completes all queued requests with `status`, which must not be OK, as
+  // well as any request enqueued afterwards.
+  void Shutdown(const Status& status);
+
+ private:
+  struct Pending {
+    EnqueueRequest request;
+    EnqueueResponse* response;
+    StatusCallback done;
+  };
+
+  // Sends queued requests while the in flight limit allows, then clears
+  // sending_ and releases mu_. Only one thread sends at a time, which keeps
+  // requests in order; the others only queue.
+  // REQUIRES: sending_ is true.
+  void SendLoop() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) TF_UNLOCK_FUNCTION(mu_);
+
+  // Sends `batch` as one request.
+  void SendBatch(std::deque<Pending> batch);
+
+  // Called by the `done` callback of every request sent.
+  void SendDone();
+
+  const int max_in_flight_;
+  const SendFn send_;
+
+  mutex mu_;
+  int in_flight_ TF_GUARDED_BY(mu_) = 0;
+  bool sending_ TF_GUARDED_BY(mu_) = false;
+  std::deque<Pending> pending_ TF_GUARDED_BY(mu_);
+  Status status_ TF_GUARDED_BY(mu_);
+};
+
+}  // namespace eager
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_EAGER_ENQUEUE_BATCHER_H_
@@ -0,0 +1,157 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/eager/enqueue_batcher.h"
+
+#include <vector>
+
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace eager {
+namespace {
+
+// Records sent requests and completes them on demand.
+class FakeSender {
+ public:
+  EnqueueBatcher::SendFn AsSendFn() {
+    return [this](const EnqueueRequest* request, EnqueueResponse* response,
+                  StatusCallback done) {
+      sent_.push_back({*request, response, std::move(done)});
+    };
+  }
+
+  int num_sent() const { return sent_.size(); }
+  const EnqueueRequest& request(int i) const { return sent_[i].request; }
+
+  // Completes the i-th sent request, answering each of its queue items with
+  // a response naming the operation.
+  void Complete(int i, const Status& status) {
+    Sent& sent = sent_[i];
+    for (const QueueItem& item : sent.request.queue()) {
+      sent.response->add_queue_response()->add_device(item.operation().name());
+    }
+    StatusCallback done = std::move(sent.done);
+    done(status);
+  }
+
+ private:
+  struct Sent {
+    EnqueueRequest request;
+    EnqueueResponse* response;
+    StatusCallback done;
+  };
+  std::vector<Sent> sent_;
+};
+
+EnqueueRequest MakeRequest(const string& op_name) {
+  EnqueueRequest request;
+  request.set_context_id(7);
+  request.add_queue()->mutable_operation()->set_name(op_name);
+  return request;
+}
+
+TEST(EnqueueBatcherTest, CoalescesRequestsWhileOneIsInFlight) {
+  FakeSender sender;
+  core::RefCountPtr<EnqueueBatcher> batcher(
+      new EnqueueBatcher(/*max_in_flight=*/1, sender.AsSendFn()));
+  EnqueueResponse responses[3];
+  Status statuses[3];
+  for (int i = 0; i < 3; ++i) {
+    EnqueueRequest request = MakeRequest(strings::StrCat("op", i));
+    batcher->Enqueue(&request, &responses[i],
+                     [&statuses, i](const Status& s) { statuses[i] = s; });
+  }
+  // The first request is sent right away, the others wait for it.
+  ASSERT_EQ(1, sender.num_sent());
+  EXPECT_EQ(1, sender.request(0).queue_size());
+
+  sender.Complete(0, Status::OK());
+  ASSERT_EQ(2, sender.num_sent());
+  const EnqueueRequest& merged = sender.request(1);
+  EXPECT_EQ(7, merged.context_id());
+  ASSERT_EQ(2, merged.queue_size());
+  EXPECT_EQ("op1", merged.queue(0).operation().name());
+  EXPECT_EQ("op2", merged.queue(1).operation().name());
+
+  sender.Complete(1, Status::OK());
+  for (int i = 0; i < 3; ++i) {
+    TF_EXPECT_OK(statuses[i]);
+    ASSERT_EQ(1, responses[i].queue_response_size());
+    EXPECT_EQ(strings::StrCat("op", i),
+              responses[i].queue_response(0).device(0));
+  }
+}
+
+TEST(EnqueueBatcherTest, FailedBatchFailsAllOfItsRequests) {
+  FakeSender sender;
+  core::RefCountPtr<EnqueueBatcher> batcher(
+      new EnqueueBatcher(/*max_in_flight=*/1, sender.AsSendFn()));
+  EnqueueResponse responses[3];
+  Status statuses[3];
+  for (int i = 0; i < 3; ++i) {
+    EnqueueRequest request = MakeRequest(strings::StrCat("op", i));
+    batcher->Enqueue(&request, &responses[i],
+                     [&statuses, i](const Status& s) { statuses[i] = s; });
+  }
+  sender.Complete(0, Status::OK());
+  sender.Complete(1, errors::Internal("op1 failed"));
+  TF_EXPECT_OK(statuses[0]);
+  EXPECT_EQ(error::INTERNAL, statuses[1].code());
+  EXPECT_EQ(error::INTERNAL, statuses[2].code());
+
+  // Later requests are sent normally.
+  EnqueueRequest request = MakeRequest("op3");
+  EnqueueResponse response;
+  Status status = errors::Unknown("not done");
+  batcher->Enqueue(&request, &response,
+                   [&status](const Status& s) { status = s; });
+  ASSERT_EQ(3, sender.num_sent());
+  sender.Complete(2, Status::OK());
+  TF_EXPECT_OK(status);
+}
+
+TEST(EnqueueBatcherTest, ShutdownFailsQueuedAndLaterRequests) {
+  FakeSender sender;
+  core::RefCountPtr<EnqueueBatcher> batcher(
+      new EnqueueBatcher(/*max_in_flight=*/1, sender.AsSendFn()));
+  EnqueueResponse responses[3];
+  Status statuses[3];
+  for (int i = 0; i < 2; ++i) {
+    EnqueueRequest request = MakeRequest(strings::StrCat("op", i));
+    batcher->Enqueue(&request, &responses[i],
+                     [&statuses, i](const Status& s) { statuses[i] = s; });
+  }
+  batcher->Shutdown(errors::Cancelled("closed"));
+  EXPECT_EQ(error::CANCELLED, statuses[1].code());
+
+  EnqueueRequest request = MakeRequest("op2");
+  batcher->Enqueue(&request, &responses[2],
+                   [&statuses](const Status& s) { statuses[2] = s; });
+  EXPECT_EQ(error::CANCELLED, statuses[2].code());
+  EXPECT_EQ(1, sender.num_sent());
+
+  // The request sent before shutdown still completes normally.
+  sender.Complete(0, Status::OK());
+  TF_EXPECT_OK(statuses[0]);
+  EXPECT_EQ(1, sender.num_sent());
+}
+
+}  // namespace
+}  // namespace eager
+}  // namespace tensorflow
@@ -197,6 +197,20 @@ Status LocalMaster::ReleaseCallable(CallOptions* call_options,
       WaitForNotification(call_options, default_timeout_in_ms_, &n));
   return ret;
 }
+Status LocalMaster::UpdateSessionWorkers(
+    CallOptions* call_options, const UpdateSessionWorkersRequest* request,
+    UpdateSessionWorkersResponse* response) {
+  Notification n;
+  Status ret;
+  master_impl_->UpdateSessionWorkers(request, response,
+                                     [&n, &ret](const Status& s) {
+                                       ret.Update(s);
+                                       n.Notify();
+                                     });
+  TF_RETURN_IF_ERROR(
+      WaitForNotification(call_options, default_timeout_in_ms_, &n));
+  return ret;
+}
 
 namespace {
 mutex* get_local_master_registry_lock() {
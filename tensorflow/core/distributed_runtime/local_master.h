@@ -80,6 +80,9 @@ class LocalMaster : public MasterInterface {
   Status ReleaseCallable(CallOptions* call_options,
                          const ReleaseCallableRequest* request,
                          ReleaseCallableResponse* response) override;
+  Status UpdateSessionWorkers(CallOptions* call_options,
+                              const UpdateSessionWorkersRequest* request,
+                              UpdateSessionWorkersResponse* response) override;
 
   // Registers the mapping from the given `target` to the given `master`.
   //
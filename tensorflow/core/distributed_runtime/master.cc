@@ -732,4 +732,44 @@ void Master::ReleaseCallable(const ReleaseCallableRequest* req,
   });
 }
 
+void Master::UpdateSessionWorkers(const UpdateSessionWorkersRequest* req,
+                                  UpdateSessionWorkersResponse* resp,
+                                  MyClosure done) {
+  auto session = FindMasterSession(req->session_handle());
+  if (session == nullptr) {
+    done(errors::Aborted("Session ", req->session_handle(), " is not found."));
+    return;
+  }
+
+  SchedClosure([this, session, req, done = std::move(done)]() {
+    Status status;
+    // DeviceFinder does not accept invalid filters, so check the new task
+    // names first.
+    for (const string& task : req->add_task()) {
+      DeviceNameUtils::ParsedName parsed;
+      if (!DeviceNameUtils::ParseFullName(task, &parsed) || !parsed.has_job ||
+          !parsed.has_task) {
+        status = errors::InvalidArgument("Not a fully specified task name: ",
+                                         task);
+        break;
+      }
+    }
+    if (status.ok() && req->remove_task_size() > 0) {
+      status = session->RemoveWorkers(
+          {req->remove_task().begin(), req->remove_task().end()});
+    }
+    if (status.ok() && req->add_task_size() > 0) {
+      // Ping the new workers and build the list of their devices.
+      std::vector<std::unique_ptr<Device>> devices;
+      status = DeviceFinder::GetRemoteDevices(
+          req->add_task(), env_, session->get_worker_cache(), &devices);
+      if (status.ok()) {
+        status = session->AddWorkers(std::move(devices));
+      }
+    }
+    session->Unref();
+    done(status);
+  });
+}
+
 }  // end namespace tensorflow
@@ -69,6 +69,10 @@ class Master {
   void ReleaseCallable(const ReleaseCallableRequest* req,
                        ReleaseCallableResponse* resp, MyClosure done);
 
+  void UpdateSessionWorkers(const UpdateSessionWorkersRequest* req,
+                            UpdateSessionWorkersResponse* resp,
+                            MyClosure done);
+
  private:
   typedef Master ME;
 
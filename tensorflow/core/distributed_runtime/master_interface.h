@@ -102,6 +102,13 @@ class MasterInterface {
                                  const ReleaseCallableRequest* request,
                                  ReleaseCallableResponse* response) = 0;
 
+  virtual Status UpdateSessionWorkers(
+      CallOptions* call_options, const UpdateSessionWorkersRequest* request,
+      UpdateSessionWorkersResponse* response) {
+    return errors::Unimplemented(
+        "UpdateSessionWorkers is not implemented for this master");
+  }
+
  protected:
   // NOTE: This should only be called by implementations of this
   // interface whose CreateRunStepResponse() method returns a
@@ -15,11 +15,13 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/master_session.h"
 
+#include <algorithm>
 #include <memory>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
+#include "absl/memory/memory.h"
 #include "tensorflow/core/common_runtime/process_util.h"
 #include "tensorflow/core/common_runtime/profile_handler.h"
 #include "tensorflow/core/common_runtime/stats_publisher_interface.h"
@@ -121,6 +123,16 @@ class MasterSession::ReffedClientGraph : public core::RefCounted {
     return stats_publisher_->GetProfileHandler(step, execution_count, ropts);
   }
 
+  // Returns true if some partition of this graph runs on one of "tasks", or
+  // if its partitions are not yet known.
+  bool RunsOnAnyTask(const std::unordered_set<string>& tasks) {
+    if (!init_done_.HasBeenNotified()) return true;
+    for (const Part& part : partitions_) {
+      if (tasks.count(part.name) > 0) return true;
+    }
+    return false;
+  }
+
   int64 get_and_increment_execution_count() {
     return execution_count_.fetch_add(1);
   }
@@ -1274,21 +1286,30 @@ Status MasterSession::Create(GraphDef&& graph_def,
     session_opts_.config.mutable_graph_options()->set_place_pruned_graph(false);
   }
 
-  GraphExecutionStateOptions execution_options;
-  execution_options.device_set = devices_.get();
-  execution_options.session_options = &session_opts_;
+  if (options.cluster_def) {
+    cluster_def_ = absl::make_unique<ClusterDef>(*options.cluster_def);
+    protocol_ = *options.protocol;
+  }
+
+  std::vector<string> worker_names;
+  const DeviceSet* devices;
   {
     mutex_lock l(mu_);
+    GraphExecutionStateOptions execution_options;
+    execution_options.device_set = devices_.get();
+    execution_options.session_options = &session_opts_;
     TF_RETURN_IF_ERROR(GraphExecutionState::MakeForBaseGraph(
         std::move(graph_def), execution_options, &execution_state_));
+    worker_names = filtered_worker_list_;
+    devices = devices_.get();
   }
   should_delete_worker_sessions_ = true;
-  return CreateWorkerSessions(options);
+  return CreateWorkerSessions(options, worker_names, *devices);
 }
 
 Status MasterSession::CreateWorkerSessions(
-    const WorkerCacheFactoryOptions& options) {
-  const std::vector<string> worker_names = filtered_worker_list_;
+    const WorkerCacheFactoryOptions& options,
+    const std::vector<string>& worker_names, const DeviceSet& devices) {
   WorkerCacheInterface* worker_cache = get_worker_cache();
 
   struct WorkerGroup {
@@ -1317,10 +1338,10 @@ Status MasterSession::CreateWorkerSessions(
 
   string task_name;
   string local_device_name;
-  DeviceNameUtils::SplitDeviceName(devices_->client_device()->name(),
+  DeviceNameUtils::SplitDeviceName(devices.client_device()->name(),
                                    &task_name, &local_device_name);
   const int64 client_device_incarnation =
-      devices_->client_device()->attributes().incarnation();
+      devices.client_device()->attributes().incarnation();
 
   Status status = Status::OK();
   // Create all the workers & kick off the computations.
@@ -1333,7 +1354,7 @@ Status MasterSession::CreateWorkerSessions(
     if (session_opts_.config.share_cluster_devices_in_session() ||
         session_opts_.config.experimental()
             .share_cluster_devices_in_session()) {
-      for (const auto& remote_dev : devices_->devices()) {
+      for (const auto& remote_dev : devices.devices()) {
         *workers[i].request.add_cluster_device_attributes() =
             remote_dev->attributes();
       }
@@ -1403,9 +1424,9 @@ Status MasterSession::CreateWorkerSessions(
   return status;
 }
 
-Status MasterSession::DeleteWorkerSessions() {
+Status MasterSession::DeleteWorkerSessions(
+    const std::vector<string>& worker_names) {
   WorkerCacheInterface* worker_cache = get_worker_cache();
-  const std::vector<string>& worker_names = filtered_worker_list_;
 
   struct WorkerGroup {
     // The worker name. (Not owned.)
@@ -1461,6 +1482,7 @@ Status MasterSession::DeleteWorkerSessions() {
 }
 
 Status MasterSession::ListDevices(ListDevicesResponse* resp) const {
+  mutex_lock l(mu_);
   if (worker_cache_) {
     // This is a ClusterSpec-propagated session, and thus env_->local_devices
     // are invalid.
@@ -1474,11 +1496,15 @@ Status MasterSession::ListDevices(ListDevicesResponse* resp) const {
     }
     *(resp->add_local_device()) = client_device->attributes();
   } else {
+    std::unordered_set<const Device*> local_devices;
     for (Device* dev : env_->local_devices) {
       *(resp->add_local_device()) = dev->attributes();
+      local_devices.insert(dev);
     }
-    for (auto&& dev : *remote_devs_) {
-      *(resp->add_local_device()) = dev->attributes();
+    for (const Device* dev : devices_->devices()) {
+      if (local_devices.count(dev) == 0) {
+        *(resp->add_local_device()) = dev->attributes();
+      }
     }
   }
   return Status::OK();
@@ -1513,6 +1539,169 @@ Status MasterSession::Extend(const ExtendSessionRequest* req,
   return Status::OK();
 }
 
+Status MasterSession::RemoveWorkers(const std::vector<string>& tasks) {
+  UpdateLastAccessTime();
+  std::unordered_set<string> removed;
+  for (const string& task : tasks) {
+    DeviceNameUtils::ParsedName parsed;
+    string task_name;
+    if (!DeviceNameUtils::ParseFullName(task, &parsed) ||
+        !DeviceNameUtils::GetTaskName(parsed, &task_name)) {
+      return errors::InvalidArgument("Not a fully specified task name: ",
+                                     task);
+    }
+    removed.insert(task_name);
+  }
+
+  std::vector<ReffedClientGraph*> to_unref;
+  std::unique_ptr<GraphExecutionState> new_execution_state;
+  std::vector<string> removed_workers;
+  {
+    mutex_lock l(mu_);
+    if (closed_) {
+      return errors::FailedPrecondition("Session is closed.");
+    }
+
+    auto new_devices = absl::make_unique<DeviceSet>();
+    for (Device* d : devices_->devices()) {
+      string task;
+      string device;
+      if (!DeviceNameUtils::SplitDeviceName(d->name(), &task, &device) ||
+          removed.count(task) == 0) {
+        new_devices->AddDevice(d);
+      } else if (d == devices_->client_device()) {
+        return errors::InvalidArgument("Cannot remove the client task ", task,
+                                       " from session ", handle_, ".");
+      }
+    }
+    if (new_devices->devices().size() == devices_->devices().size()) {
+      return Status::OK();
+    }
+    new_devices->set_client_device(devices_->client_device());
+
+    CHECK(execution_state_);
+    TF_RETURN_IF_ERROR(execution_state_->ReplaceDeviceSet(
+        new_devices.get(), &new_execution_state));
+
+    VLOG(1) << "Session " << handle_ << " removed "
+            << devices_->devices().size() - new_devices->devices().size()
+            << " devices of " << removed.size() << " tasks";
+    // The old execution state will be released outside the lock.
+    execution_state_.swap(new_execution_state);
+    retired_devices_.push_back(std::move(devices_));
+    devices_ = std::move(new_devices);
+    ClearRunsOnTasks(removed, &to_unref, &run_graphs_);
+    ClearRunsOnTasks(removed, &to_unref, &partial_run_graphs_);
+
+    std::vector<string> kept_workers;
+    for (const string& worker : filtered_worker_list_) {
+      DeviceNameUtils::ParsedName parsed;
+      string task;
+      if (DeviceNameUtils::ParseFullName(worker, &parsed) &&
+          DeviceNameUtils::GetTaskName(parsed, &task) &&
+          removed.count(task) > 0) {
+        removed_workers.push_back(worker);
+      } else {
+        kept_workers.push_back(worker);
+      }
+    }
+    filtered_worker_list_.swap(kept_workers);
+  }
+  for (ReffedClientGraph* rcg : to_unref) rcg->Unref();
+  if (should_delete_worker_sessions_ && !removed_workers.empty()) {
+    // The removed workers may be gone already.
+    Status s = DeleteWorkerSessions(removed_workers);
+    if (!s.ok()) {
+      LOG(WARNING) << "Could not delete the worker sessions of removed tasks: "
+                   << s;
+    }
+  }
+  return Status::OK();
+}
+
+Status MasterSession::AddWorkers(std::vector<std::unique_ptr<Device>> devices) {
+  UpdateLastAccessTime();
+  const DeviceSet* old_devices;
+  std::vector<string> new_workers;
+  auto new_devices = absl::make_unique<DeviceSet>();
+  {
+    mutex_lock l(mu_);
+    if (closed_) {
+      return errors::FailedPrecondition("Session is closed.");
+    }
+    old_devices = devices_.get();
+  }
+  // `old_devices` stays alive even if another call replaces it, see
+  // retired_devices_.
+  for (Device* d : old_devices->devices()) new_devices->AddDevice(d);
+  new_devices->set_client_device(old_devices->client_device());
+  std::vector<std::unique_ptr<Device>> added;
+  for (auto& d : devices) {
+    if (new_devices->FindDeviceByName(d->name()) != nullptr) continue;
+    string task;
+    if (!DeviceNameUtils::GetTaskName(d->parsed_name(), &task)) {
+      return errors::InvalidArgument("Device ", d->name(),
+                                     " does not belong to a task.");
+    }
+    if (std::find(new_workers.begin(), new_workers.end(), task) ==
+        new_workers.end()) {
+      new_workers.push_back(task);
+    }
+    new_devices->AddDevice(d.get());
+    added.push_back(std::move(d));
+  }
+  if (added.empty()) {
+    return Status::OK();
+  }
+
+  // The new workers need a session before graphs can be registered on them.
+  if (should_delete_worker_sessions_) {
+    WorkerCacheFactoryOptions options;
+    options.cluster_def = cluster_def_.get();
+    options.protocol = &protocol_;
+    Status s = CreateWorkerSessions(options, new_workers, *new_devices);
+    if (!s.ok()) {
+      DeleteWorkerSessions(new_workers).IgnoreError();
+      return s;
+    }
+  }
+
+  std::vector<ReffedClientGraph*> to_unref;
+  std::unique_ptr<GraphExecutionState> new_execution_state;
+  Status status;
+  {
+    mutex_lock l(mu_);
+    if (closed_) {
+      status = errors::FailedPrecondition("Session is closed.");
+    } else if (devices_.get() != old_devices) {
+      status = errors::Aborted("The workers of session ", handle_,
+                               " were updated concurrently.");
+    } else {
+      CHECK(execution_state_);
+      status = execution_state_->ReplaceDeviceSet(new_devices.get(),
+                                                  &new_execution_state);
+    }
+    if (status.ok()) {
+      VLOG(1) << "Session " << handle_ << " added " << added.size()
+              << " devices of " << new_workers.size() << " tasks";
+      // The old execution state will be released outside the lock.
+      execution_state_.swap(new_execution_state);
+      retired_devices_.push_back(std::move(devices_));
+      devices_ = std::move(new_devices);
+      for (auto& d : added) remote_devs_->push_back(std::move(d));
+      filtered_worker_list_.insert(filtered_worker_list_.end(),
+                                   new_workers.begin(), new_workers.end());
+      ClearRunsTable(&to_unref, &run_graphs_);
+      ClearRunsTable(&to_unref, &partial_run_graphs_);
+    }
+  }
+  for (ReffedClientGraph* rcg : to_unref) rcg->Unref();
+  if (!status.ok() && should_delete_worker_sessions_) {
+    DeleteWorkerSessions(new_workers).IgnoreError();
+  }
+  return status;
+}
+
 WorkerCacheInterface* MasterSession::get_worker_cache() const {
   if (worker_cache_) {
     return worker_cache_.get();
@@ -1567,6 +1756,19 @@ void MasterSession::ClearRunsTable(std::vector<ReffedClientGraph*>* to_unref,
   rcg_map->clear();
 }
 
+void MasterSession::ClearRunsOnTasks(const std::unordered_set<string>& tasks,
+                                     std::vector<ReffedClientGraph*>* to_unref,
+                                     RCGMap* rcg_map) {
+  for (auto it = rcg_map->begin(); it != rcg_map->end();) {
+    if (it->second->RunsOnAnyTask(tasks)) {
+      to_unref->push_back(it->second);
+      it = rcg_map->erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
 uint64 MasterSession::NewStepId(int64 graph_key) {
   if (graph_key == BuildGraphOptions::kNoCollectiveGraphKey) {
     // StepId must leave the most-significant 7 bits empty for future use.
@@ -1678,6 +1880,7 @@ Status MasterSession::BuildAndRegisterPartitions(ReffedClientGraph* rcg) {
     return strings::StrCat(prefix, "_S", next_node_id_++);
   };
   popts.get_incarnation = [this](const string& name) -> int64 {
+    mutex_lock l(mu_);
     Device* d = devices_->FindDeviceByName(name);
     if (d == nullptr) {
       return PartitionOptions::kIllegalIncarnation;
@@ -2123,7 +2326,12 @@ Status MasterSession::Close() {
   }
   for (ReffedClientGraph* rcg : to_unref) rcg->Unref();
   if (should_delete_worker_sessions_) {
-    Status s = DeleteWorkerSessions();
+    std::vector<string> worker_names;
+    {
+      mutex_lock l(mu_);
+      worker_names = filtered_worker_list_;
+    }
+    Status s = DeleteWorkerSessions(worker_names);
     if (!s.ok()) {
       LOG(WARNING) << s;
     }
@@ -17,6 +17,7 @@ limitations under the License.
 #define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_MASTER_SESSION_H_
 
 #include <atomic>
+#include <unordered_set>
 #include <vector>
 
 #include "tensorflow/core/common_runtime/debugger_state_interface.h"
@@ -78,6 +79,35 @@ class MasterSession : public core::RefCounted {
   // Extend() may block the caller thread for a long time.
   Status Extend(const ExtendSessionRequest* req, ExtendSessionResponse* resp);
 
+  // Removes the devices of the given worker tasks (e.g.
+  // "/job:worker/replica:0/task:1") from this session without restarting it.
+  //
+  // The graph is placed again on the remaining devices.  Stateful nodes on
+  // surviving devices keep their placement, and hence their state, while
+  // those that lived on a removed task are placed anew.  Cached graphs whose
+  // partitions touch only surviving tasks stay registered.  Callables are
+  // not affected; those that ran on a removed task must be recreated.  The
+  // worker sessions of the removed tasks are deleted on a best-effort basis.
+  //
+  // The graph version is unchanged.  Steps that are already running are
+  // not interrupted.
+  Status RemoveWorkers(const std::vector<string>& tasks);
+
+  // Adds "devices", which belong to worker tasks reachable through
+  // get_worker_cache(), to this session without restarting it.  Devices that
+  // the session already uses are ignored.
+  //
+  // Worker sessions are created on the new tasks, and the graph is placed
+  // again on the extended device set.  Stateful nodes keep their placement.
+  // Cached graphs are discarded, so that later steps may use the new
+  // devices; callables are not affected.  Workers that were already part of
+  // the session are not told about the new devices, even if
+  // share_cluster_devices_in_session is set.
+  Status AddWorkers(std::vector<std::unique_ptr<Device>> devices);
+
+  // Retrieves either worker_cache_ or the env_->worker_cache as appropriate.
+  WorkerCacheInterface* get_worker_cache() const;
+
   // Setup a partial run call.
   Status PartialRunSetup(const PartialRunSetupRequest* req,
                          PartialRunSetupResponse* resp);
@@ -118,20 +148,29 @@ class MasterSession : public core::RefCounted {
   // The opaque session handle.
   const string handle_;
 
-  std::unique_ptr<std::vector<std::unique_ptr<Device>>> remote_devs_;
+  // Includes the devices of removed workers, which cached graphs may still
+  // point to.
+  std::unique_ptr<std::vector<std::unique_ptr<Device>>> remote_devs_
+      TF_GUARDED_BY(mu_);
 
   // The optional session-specific worker cluster.
   // TODO(saeta): Convert to std::optional when available.
   const std::unique_ptr<WorkerCacheInterface> worker_cache_;
-  // Retrieves either worker_cache_ or the env_->worker_cache as appropriate.
-  WorkerCacheInterface* get_worker_cache() const;
 
-  // The device set used by this session.
-  std::unique_ptr<DeviceSet> devices_;
+  // The cluster and protocol passed to Create(), kept for the worker
+  // sessions that AddWorkers() creates.
+  std::unique_ptr<ClusterDef> cluster_def_;
+  string protocol_;
+
+  // The device set used by this session.  Replaced by RemoveWorkers() and
+  // AddWorkers(), which keep the previous sets alive in retired_devices_, so
+  // a pointer read under mu_ stays valid for the life of the session.
+  std::unique_ptr<DeviceSet> devices_ TF_GUARDED_BY(mu_);
+  std::vector<std::unique_ptr<DeviceSet>> retired_devices_ TF_GUARDED_BY(mu_);
 
   // The (partial device) names of remote worker tasks that this
   // session will contact.
-  const std::vector<string> filtered_worker_list_;
+  std::vector<string> filtered_worker_list_ TF_GUARDED_BY(mu_);
 
   StatsPublisherFactory stats_publisher_factory_;
 
@@ -141,7 +180,7 @@ class MasterSession : public core::RefCounted {
 
   uint64 NewStepId(int64 graph_key);
 
-  mutex mu_;
+  mutable mutex mu_;
   std::unique_ptr<GraphExecutionState> execution_state_ TF_GUARDED_BY(mu_);
   int64 graph_version_;
 
@@ -212,20 +251,26 @@ class MasterSession : public core::RefCounted {
   // Private dtor. The client must call Close().
   virtual ~MasterSession();
 
-  // Creates sessions on all workers.
+  // Creates sessions on "worker_names", which will use "devices".
   //
   // If this session is operating using the new ClusterSpec propagation behavior
   // call this method in order to propagate the cluster membership to all
   // workers.
-  Status CreateWorkerSessions(const WorkerCacheFactoryOptions& server_def);
+  Status CreateWorkerSessions(const WorkerCacheFactoryOptions& server_def,
+                              const std::vector<string>& worker_names,
+                              const DeviceSet& devices);
 
   bool should_delete_worker_sessions_ = false;
-  Status DeleteWorkerSessions();
+  Status DeleteWorkerSessions(const std::vector<string>& worker_names);
 
   Status StartStep(const BuildGraphOptions& opts, bool is_partial,
                    ReffedClientGraph** out_rcg, int64* out_count);
   void ClearRunsTable(std::vector<ReffedClientGraph*>* to_unref,
                       RCGMap* rcg_map) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  // Like ClearRunsTable(), but only for graphs with a partition on "tasks".
+  void ClearRunsOnTasks(const std::unordered_set<string>& tasks,
+                        std::vector<ReffedClientGraph*>* to_unref,
+                        RCGMap* rcg_map) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
   void FillPerStepState(MasterSession::ReffedClientGraph* rcg,
                         const RunOptions& run_options, uint64 step_id,
                         int64 count, PerStepState* out_pss,
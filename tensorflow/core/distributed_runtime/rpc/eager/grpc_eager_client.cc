@@ -17,10 +17,12 @@ limitations under the License.
 
 #include "grpcpp/generic/generic_stub.h"
 #include "tensorflow/core/distributed_runtime/call_options.h"
+#include "tensorflow/core/distributed_runtime/eager/enqueue_batcher.h"
 #include "tensorflow/core/distributed_runtime/rpc/eager/grpc_eager_service.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_client_cq_tag.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_state.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_util.h"
+#include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/refcount.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/platform/env.h"
@@ -63,6 +65,22 @@ bool EnableStreaming() {
   return result;
 }
 
+// Maximum number of streaming enqueue requests outstanding per remote context
+// when "TF_EAGER_CLIENT_MAX_IN_FLIGHT_ENQUEUES" is positive. Requests issued
+// beyond the limit are held back and coalesced into a single request when an
+// outstanding one completes, trading a little latency for many fewer round
+// trips when remote ops are issued faster than the worker acknowledges them.
+// The default of 0 sends every request on its own without a limit.
+int64 MaxInFlightEnqueues() {
+  static int64 max_in_flight = []() {
+    int64 value;
+    TF_CHECK_OK(ReadInt64FromEnvVar("TF_EAGER_CLIENT_MAX_IN_FLIGHT_ENQUEUES",
+                                    0, &value));
+    return value;
+  }();
+  return max_in_flight;
+}
+
 // Ref-counted thread to handle callbacks for completed requests a GRPC
 // completion queue. The thread might be shared by multiple eager clients, and
 // each one of them should hold a reference count to ensure that the thread
@@ -168,6 +186,21 @@ class GrpcEagerClient : public EagerClient {
     VLOG(1) << "Sending RPC to close remote eager context "
             << request->DebugString();
 
+    core::RefCountPtr<EnqueueBatcher> batcher;
+    {
+      mutex_lock l(mu_);
+      auto batcher_it = enqueue_batchers_.find(request->context_id());
+      if (batcher_it != enqueue_batchers_.end()) {
+        batcher = std::move(batcher_it->second);
+        enqueue_batchers_.erase(batcher_it);
+      }
+    }
+    if (batcher != nullptr) {
+      batcher->Shutdown(errors::Cancelled("Remote eager context ",
+                                          request->context_id(),
+                                          " was closed"));
+    }
+
     mutex_lock l(mu_);
     const auto& it = enqueue_dispatchers_.find(request->context_id());
     if (it != enqueue_dispatchers_.end()) {
@@ -184,20 +217,32 @@ class GrpcEagerClient : public EagerClient {
                              EnqueueResponse* response,
                              StatusCallback done) override {
     StatusCallback done_wrapped = callback_wrapper(std::move(done));
-    if (EnableStreaming()) {
-      mutex_lock l(mu_);
-      auto it = enqueue_dispatchers_.find(request->context_id());
-      if (it == enqueue_dispatchers_.end()) {
-        auto it_and_bool = enqueue_dispatchers_.emplace(
-            std::piecewise_construct,
-            std::forward_as_tuple(request->context_id()),
-            std::forward_as_tuple(
-                &stub_, cq_,
-                "/tensorflow.eager.EagerService/StreamingEnqueue"));
-        it = it_and_bool.first;
+    if (EnableStreaming() && MaxInFlightEnqueues() > 0) {
+      core::RefCountPtr<EnqueueBatcher> batcher;
+      {
+        mutex_lock l(mu_);
+        auto& slot = enqueue_batchers_[request->context_id()];
+        if (slot == nullptr) {
+          const uint64 context_id = request->context_id();
+          slot.reset(new EnqueueBatcher(
+              MaxInFlightEnqueues(),
+              [this, context_id](const EnqueueRequest* request,
+                                 EnqueueResponse* response,
+                                 StatusCallback done) {
+                mutex_lock l(mu_);
+                SendNextEnqueueLocked(context_id, *request, response,
+                                      std::move(done));
+              }));
+        }
+        slot->Ref();
+        batcher.reset(slot.get());
       }
-      // TODO(haoyuzhang): Consider supporting cancellation for streaming RPC?
-      it->second.SendNextRequest(*request, response, std::move(done_wrapped));
+      // Called without mu_, which the batcher takes to send.
+      batcher->Enqueue(request, response, std::move(done_wrapped));
+    } else if (EnableStreaming()) {
+      mutex_lock l(mu_);
+      SendNextEnqueueLocked(request->context_id(), *request, response,
+                            std::move(done_wrapped));
     } else {
       Notification n;
       Status status;
@@ -222,6 +267,23 @@ class GrpcEagerClient : public EagerClient {
 
   std::unordered_map<uint64, StreamingRPCDispatcher<EnqueueResponse>>
       enqueue_dispatchers_ TF_GUARDED_BY(mu_);
+  std::unordered_map<uint64, core::RefCountPtr<EnqueueBatcher>>
+      enqueue_batchers_ TF_GUARDED_BY(mu_);
+
+  void SendNextEnqueueLocked(uint64 context_id, const EnqueueRequest& request,
+                             EnqueueResponse* response, StatusCallback done)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    auto it = enqueue_dispatchers_.find(context_id);
+    if (it == enqueue_dispatchers_.end()) {
+      auto it_and_bool = enqueue_dispatchers_.emplace(
+          std::piecewise_construct, std::forward_as_tuple(context_id),
+          std::forward_as_tuple(
+              &stub_, cq_, "/tensorflow.eager.EagerService/StreamingEnqueue"));
+      it = it_and_bool.first;
+    }
+    // TODO(haoyuzhang): Consider supporting cancellation for streaming RPC?
+    it->second.SendNextRequest(request, response, std::move(done));
+  }
 
   StatusCallback callback_wrapper(StatusCallback done) {
     Ref();
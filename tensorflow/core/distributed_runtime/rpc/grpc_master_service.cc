@@ -116,6 +116,7 @@ class GrpcMasterService : public AsyncServiceInterface {
       ENQUEUE_REQUEST(RunCallable, true);
     }
     ENQUEUE_REQUEST(ReleaseCallable, false);
+    ENQUEUE_REQUEST(UpdateSessionWorkers, false);
 
     void* tag;
     bool ok;
@@ -281,6 +282,17 @@ class GrpcMasterService : public AsyncServiceInterface {
     ENQUEUE_REQUEST(ReleaseCallable, false);
   }
 
+  // RPC handler for changing the workers of a session.
+  void UpdateSessionWorkersHandler(
+      MasterCall<UpdateSessionWorkersRequest, UpdateSessionWorkersResponse>*
+          call) {
+    master_impl_->UpdateSessionWorkers(
+        &call->request, &call->response, [call](const Status& status) {
+          call->SendResponse(ToGrpcStatus(status));
+        });
+    ENQUEUE_REQUEST(UpdateSessionWorkers, false);
+  }
+
 #undef ENQUEUE_REQUEST
 
   // Start tracing, including the ID attached to the RPC.
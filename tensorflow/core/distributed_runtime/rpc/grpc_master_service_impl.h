@@ -72,6 +72,10 @@ class MasterService final {
     virtual ::grpc::Status ReleaseCallable(
         ::grpc::ClientContext* context, const ReleaseCallableRequest& request,
         ReleaseCallableResponse* response) = 0;
+    virtual ::grpc::Status UpdateSessionWorkers(
+        ::grpc::ClientContext* context,
+        const UpdateSessionWorkersRequest& request,
+        UpdateSessionWorkersResponse* response) = 0;
   };
   class Stub final : public StubInterface {
    public:
@@ -106,6 +110,10 @@ class MasterService final {
     ::grpc::Status ReleaseCallable(::grpc::ClientContext* context,
                                    const ReleaseCallableRequest& request,
                                    ReleaseCallableResponse* response) override;
+    ::grpc::Status UpdateSessionWorkers(
+        ::grpc::ClientContext* context,
+        const UpdateSessionWorkersRequest& request,
+        UpdateSessionWorkersResponse* response) override;
 
    private:
     std::shared_ptr< ::grpc::ChannelInterface> channel_;
@@ -119,6 +127,7 @@ class MasterService final {
     const ::grpc::internal::RpcMethod rpcmethod_MakeCallable_;
     const ::grpc::internal::RpcMethod rpcmethod_RunCallable_;
     const ::grpc::internal::RpcMethod rpcmethod_ReleaseCallable_;
+    const ::grpc::internal::RpcMethod rpcmethod_UpdateSessionWorkers_;
   };
   static std::unique_ptr<Stub> NewStub(
       const std::shared_ptr< ::grpc::ChannelInterface>& channel,
@@ -208,6 +217,15 @@ class MasterService final {
       ::grpc::Service::RequestAsyncUnary(9, context, request, response,
                                          new_call_cq, notification_cq, tag);
     }
+    void RequestUpdateSessionWorkers(
+        ::grpc::ServerContext* context, UpdateSessionWorkersRequest* request,
+        ::grpc::ServerAsyncResponseWriter<UpdateSessionWorkersResponse>*
+            response,
+        ::grpc::CompletionQueue* new_call_cq,
+        ::grpc::ServerCompletionQueue* notification_cq, void* tag) {
+      ::grpc::Service::RequestAsyncUnary(10, context, request, response,
+                                         new_call_cq, notification_cq, tag);
+    }
   };
 };
 
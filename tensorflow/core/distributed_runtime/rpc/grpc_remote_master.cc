@@ -110,6 +110,12 @@ class GrpcRemoteMaster : public MasterInterface {
     return CallWithRetry(call_options, request, response,
                          &MasterServiceStub::ReleaseCallable);
   }
+  Status UpdateSessionWorkers(CallOptions* call_options,
+                              const UpdateSessionWorkersRequest* request,
+                              UpdateSessionWorkersResponse* response) override {
+    return CallWithRetry(call_options, request, response,
+                         &MasterServiceStub::UpdateSessionWorkers);
+  }
 
  private:
   // Start tracing, attaching a unique ID to both the trace and the RPC.
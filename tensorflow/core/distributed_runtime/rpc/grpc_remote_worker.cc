@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/rpc/grpc_remote_worker.h"
 
+#include <atomic>
+#include <memory>
 #include <utility>
 
 #include "grpcpp/generic/generic_stub.h"
@@ -35,11 +37,26 @@ limitations under the License.
 #include "tensorflow/core/platform/tracing.h"
 #include "tensorflow/core/protobuf/transport_options.pb.h"
 #include "tensorflow/core/protobuf/worker.pb.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 
 const int kMaxWorkerRpcRetries = 10;
 
+namespace {
+
+bool EnableWorkerStreaming() {
+  static const bool enabled = [] {
+    bool result;
+    TF_CHECK_OK(
+        ReadBoolFromEnvVar("TF_GRPC_WORKER_STREAMING", false, &result));
+    return result;
+  }();
+  return enabled;
+}
+
+}  // namespace
+
 class GrpcRemoteWorker : public WorkerInterface {
  public:
   explicit GrpcRemoteWorker(SharedGrpcChannelPtr channel,
@@ -66,8 +83,16 @@ class GrpcRemoteWorker : public WorkerInterface {
         instancesource_(Method(GrpcWorkerMethod::kCompleteInstance)),
         getstepsequence_(Method(GrpcWorkerMethod::kGetStepSequence)),
         markrecvfinished_(Method(GrpcWorkerMethod::kMarkRecvFinished)),
+        recvtensors_(Method(GrpcWorkerMethod::kRecvTensors)),
         logger_(logger),
-        target_(target) {}
+        target_(target) {
+    if (EnableWorkerStreaming()) {
+      rungraph_stream_.reset(new Stream<RunGraphResponse>(
+          &stub_, cq_, Method(GrpcWorkerMethod::kStreamingRunGraph)));
+      cleanupgraph_stream_.reset(new Stream<CleanupGraphResponse>(
+          &stub_, cq_, Method(GrpcWorkerMethod::kStreamingCleanupGraph)));
+    }
+  }
 
   ~GrpcRemoteWorker() override {}
 
@@ -111,6 +136,15 @@ class GrpcRemoteWorker : public WorkerInterface {
   void RunGraphAsync(CallOptions* call_opts, RunGraphRequestWrapper* request,
                      MutableRunGraphResponseWrapper* response,
                      StatusCallback done) override {
+    // Only requests that report errors in the response body are streamed, so
+    // that a failed stream never hides an error of the step itself.
+    if (request->store_errors_in_response_body() &&
+        MaybeIssueStreamingRequest(rungraph_stream_.get(), call_opts,
+                                   &request->ToProto(),
+                                   get_proto_from_wrapper(response),
+                                   rungraph_, &done)) {
+      return;
+    }
     IssueRequest(&request->ToProto(), get_proto_from_wrapper(response),
                  rungraph_, std::move(done), call_opts);
   }
@@ -118,6 +152,11 @@ class GrpcRemoteWorker : public WorkerInterface {
   void CleanupGraphAsync(const CleanupGraphRequest* request,
                          CleanupGraphResponse* response,
                          StatusCallback done) override {
+    if (MaybeIssueStreamingRequest(cleanupgraph_stream_.get(),
+                                   /*call_opts=*/nullptr, request, response,
+                                   cleanupgraph_, &done)) {
+      return;
+    }
     IssueRequest(request, response, cleanupgraph_, std::move(done));
   }
 
@@ -255,6 +294,30 @@ class GrpcRemoteWorker : public WorkerInterface {
     IssueRequest(request, response, recvtensor_, callback, call_opts);
   }
 
+  void RecvTensorsAsync(CallOptions* call_opts,
+                        const RecvTensorsRequest* request,
+                        RecvTensorsResponse* response,
+                        StatusCallback done) override {
+    VLOG(1) << "RecvTensorsAsync req: " << request->request_size()
+            << " tensors";
+    auto callback = [this, request, response, done](const Status& s) {
+      if (s.ok()) {
+        for (int i = 0, end = std::min(request->request_size(),
+                                       response->response_size());
+             i < end; ++i) {
+          if (response->response(i).require_ack()) {
+            IssueMarkRecvFinishedRequest(request->request(i).request_id());
+          }
+        }
+      }
+      // Note done() can delete this worker object, so we need to call done()
+      // last.
+      done(s);
+    };
+    IssueRequest(request, response, recvtensors_, std::move(callback),
+                 call_opts);
+  }
+
   void LoggingAsync(const LoggingRequest* request, LoggingResponse* response,
                     StatusCallback done) override {
     IssueRequest(request, response, logging_, done);
@@ -296,6 +359,67 @@ class GrpcRemoteWorker : public WorkerInterface {
     IssueRequest(&request, response, markrecvfinished_, done);
   }
 
+  // A long-lived streaming call to the worker for one method.
+  template <class Response>
+  struct Stream {
+    Stream(::grpc::GenericStub* stub, ::grpc::CompletionQueue* cq,
+           const ::grpc::string& method)
+        : dispatcher(stub, cq, method) {}
+
+    StreamingRPCDispatcher<Response> dispatcher;
+    // True while a request is outstanding on the stream.
+    std::atomic<bool> busy{false};
+    // Set once the worker is known not to serve the streaming method.
+    std::atomic<bool> unimplemented{false};
+  };
+
+  // Sends `request` over `stream` and returns true if the stream exists and
+  // has no other request outstanding.  The worker answers the requests of a
+  // stream in order, so a request never waits behind another one that might
+  // only complete once this one does.  Otherwise, and for requests with a
+  // timeout, returns false without consuming `done`, and the caller issues a
+  // unary call to `unary_method` instead.
+  template <class Response>
+  bool MaybeIssueStreamingRequest(Stream<Response>* stream,
+                                  CallOptions* call_opts,
+                                  const protobuf::Message* request,
+                                  Response* response,
+                                  const ::grpc::string& unary_method,
+                                  StatusCallback* done) {
+    if (stream == nullptr || stream->unimplemented.load() ||
+        (call_opts != nullptr && call_opts->GetTimeout() > 0) ||
+        stream->busy.exchange(true)) {
+      return false;
+    }
+    if (call_opts != nullptr) {
+      call_opts->SetCancelCallback(
+          [stream]() { stream->dispatcher.CancelCall(); });
+    }
+    StatusCallback callback = std::move(*done);
+    stream->dispatcher.SendNextRequest(
+        *request, response,
+        [this, stream, call_opts, request, response, unary_method,
+         callback](const Status& s) {
+          if (call_opts != nullptr) {
+            call_opts->ClearCancelCallback();
+          }
+          stream->busy.store(false);
+          if (errors::IsUnimplemented(s)) {
+            VLOG(1) << "Worker " << target_ << " does not serve "
+                    << unary_method << " over a stream: " << s;
+            stream->unimplemented.store(true);
+            IssueRequest(request, response, unary_method, callback, call_opts);
+            return;
+          }
+          if (callback_threadpool_ != nullptr) {
+            callback_threadpool_->Schedule([callback, s]() { callback(s); });
+          } else {
+            callback(s);
+          }
+        });
+    return true;
+  }
+
   // Helper function for initializing the RpcMethod objects below.
   const char* Method(GrpcWorkerMethod id) { return GrpcWorkerMethodName(id); }
 
@@ -320,6 +444,11 @@ class GrpcRemoteWorker : public WorkerInterface {
   const ::grpc::string instancesource_;
   const ::grpc::string getstepsequence_;
   const ::grpc::string markrecvfinished_;
+  const ::grpc::string recvtensors_;
+
+  // Null unless TF_GRPC_WORKER_STREAMING is set.
+  std::unique_ptr<Stream<RunGraphResponse>> rungraph_stream_;
+  std::unique_ptr<Stream<CleanupGraphResponse>> cleanupgraph_stream_;
 
   // Support for logging.
   WorkerCacheLogger* logger_;
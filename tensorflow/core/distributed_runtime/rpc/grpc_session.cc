@@ -473,6 +473,18 @@ Status GrpcSession::ReleaseCallable(CallableHandle handle) {
   return master_->ReleaseCallable(&call_options, &req, &resp);
 }
 
+Status GrpcSession::UpdateWorkers(const std::vector<string>& add_tasks,
+                                  const std::vector<string>& remove_tasks) {
+  UpdateSessionWorkersRequest req;
+  TF_RETURN_IF_ERROR(Handle(req.mutable_session_handle()));
+  for (const string& task : add_tasks) req.add_add_task(task);
+  for (const string& task : remove_tasks) req.add_remove_task(task);
+  UpdateSessionWorkersResponse resp;
+  CallOptions call_options;
+  call_options.SetTimeout(options_.config.operation_timeout_in_ms());
+  return master_->UpdateSessionWorkers(&call_options, &req, &resp);
+}
+
 class GrpcSessionFactory : public SessionFactory {
  public:
   bool AcceptsOptions(const SessionOptions& options) override {
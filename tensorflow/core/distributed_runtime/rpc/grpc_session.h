@@ -107,6 +107,14 @@ class GrpcSession : public Session {
                      RunMetadata* run_metadata) override;
   Status ReleaseCallable(CallableHandle handle) override;
 
+  // Makes the session use the devices of the tasks in "add_tasks" and stop
+  // using those of the tasks in "remove_tasks", which are fully specified
+  // task names such as "/job:worker/replica:0/task:1".
+  //
+  // NOTE: This API is still experimental and may change.
+  Status UpdateWorkers(const std::vector<string>& add_tasks,
+                       const std::vector<string>& remove_tasks);
+
  protected:
   // Takes ownership of `*master`.
   void SetRemoteMaster(std::unique_ptr<MasterInterface> master);
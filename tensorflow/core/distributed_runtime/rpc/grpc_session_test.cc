@@ -15,6 +15,9 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/rpc/grpc_session.h"
 
+#include <cstdlib>
+
+#include "absl/strings/match.h"
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_testlib.h"
 #include "tensorflow/core/framework/graph.pb.h"
@@ -120,6 +123,35 @@ TEST(GrpcSessionTest, BasicNonProtoAPI) {
   }
 }
 
+TEST(GrpcSessionTest, StreamingWorkerCalls) {
+  GraphDef graph;
+  string node_names[3];
+  // c = a * b
+  CreateGraphDef(&graph, node_names);
+
+  // The test cluster's processes inherit the environment, so their masters
+  // send RunGraph and CleanupGraph over streaming calls.
+  setenv("TF_GRPC_WORKER_STREAMING", "true", 1);
+  std::unique_ptr<test::TestCluster> cluster;
+  TF_CHECK_OK(test::TestCluster::MakeTestCluster(Devices(1, 0), 2, &cluster));
+  unsetenv("TF_GRPC_WORKER_STREAMING");
+
+  std::unique_ptr<Session> session(
+      NewRemote(Options(cluster->targets()[0], 1)));
+  ASSERT_TRUE(session != nullptr);
+
+  TF_CHECK_OK(session->Create(graph));
+  for (int iters = 0; iters < 25; ++iters) {
+    std::vector<std::pair<string, Tensor>> inputs;
+    std::vector<string> names = {node_names[2] + ":0"};
+    std::vector<Tensor> outputs;
+    TF_CHECK_OK(session->Run(inputs, names, {}, &outputs));
+    ASSERT_TRUE(outputs[0].IsInitialized());
+    ASSERT_EQ(4.0, outputs[0].flat<float>()(0));
+  }
+  TF_CHECK_OK(session->Close());
+}
+
 TEST(GrpcSessionTest, BasicCallable) {
   GraphDef graph;
   string node_names[3];
@@ -259,6 +291,78 @@ TEST(GrpcSessionTest, NonLocalWithFilters) {
   }
 }
 
+// Runs "fetch" and returns the number of partitions that the step used.
+static int RunAndCountPartitions(Session* session, const string& fetch) {
+  RunOptions run_options;
+  run_options.set_output_partition_graphs(true);
+  RunMetadata run_metadata;
+  std::vector<Tensor> outputs;
+  TF_CHECK_OK(
+      session->Run(run_options, {}, {fetch}, {}, &outputs, &run_metadata));
+  IsSingleFloatValue(outputs[0], 4.0);
+  return run_metadata.partition_graphs_size();
+}
+
+TEST(GrpcSessionTest, UpdateWorkers) {
+  const string task0 = "/job:localhost/replica:0/task:0";
+  const string task1 = "/job:localhost/replica:0/task:1";
+
+  // d = identity(a * b), which asks for task 1.
+  Graph graph(OpRegistry::Global());
+  Tensor a_tensor(DT_FLOAT, TensorShape({1, 2}));
+  test::FillValues<float>(&a_tensor, {1, 2});
+  Node* a = test::graph::Constant(&graph, a_tensor);
+  Tensor b_tensor(DT_FLOAT, TensorShape({2, 1}));
+  test::FillValues<float>(&b_tensor, {2, 1});
+  Node* b = test::graph::Constant(&graph, b_tensor);
+  Node* c = test::graph::Matmul(&graph, a, b, false, false);
+  c->set_requested_device(strings::StrCat(task0, "/device:CPU:0"));
+  Node* d = test::graph::Identity(&graph, c);
+  d->set_requested_device(strings::StrCat(task1, "/device:CPU:0"));
+  const string fetch = strings::StrCat(d->name(), ":0");
+  GraphDef graph_def;
+  test::graph::ToGraphDef(&graph, &graph_def);
+
+  std::unique_ptr<test::TestCluster> cluster;
+  TF_CHECK_OK(test::TestCluster::MakeTestCluster(Devices(1, 0), 2, &cluster));
+
+  // The session starts on task 0 only, and places d there.
+  SessionOptions options = Options(cluster->targets()[0], 1);
+  options.config.add_device_filters(task0);
+  options.config.set_allow_soft_placement(true);
+  std::unique_ptr<GrpcSession> session;
+  TF_CHECK_OK(GrpcSession::Create(options, &session));
+  TF_CHECK_OK(session->Create(graph_def));
+  EXPECT_EQ(1, RunAndCountPartitions(session.get(), fetch));
+
+  auto uses_task1 = [&session, &task1]() {
+    std::vector<DeviceAttributes> devices;
+    TF_CHECK_OK(session->ListDevices(&devices));
+    for (const DeviceAttributes& device : devices) {
+      if (absl::StartsWith(device.name(), task1)) return true;
+    }
+    return false;
+  };
+  EXPECT_FALSE(uses_task1());
+
+  // Adding task 1 moves d to it.
+  TF_CHECK_OK(session->UpdateWorkers({task1}, {}));
+  EXPECT_TRUE(uses_task1());
+  EXPECT_EQ(2, RunAndCountPartitions(session.get(), fetch));
+
+  // Removing it again moves d back to task 0.
+  TF_CHECK_OK(session->UpdateWorkers({}, {task1}));
+  EXPECT_FALSE(uses_task1());
+  EXPECT_EQ(1, RunAndCountPartitions(session.get(), fetch));
+
+  // The client task cannot be removed, and tasks must be fully specified.
+  EXPECT_TRUE(errors::IsInvalidArgument(session->UpdateWorkers({}, {task0})));
+  EXPECT_TRUE(errors::IsInvalidArgument(
+      session->UpdateWorkers({"/job:localhost"}, {})));
+
+  TF_CHECK_OK(session->Close());
+}
+
 TEST(GrpcSessionTest, FetchMultipleTimes) {
   GraphDef graph;
   string node_names[3];
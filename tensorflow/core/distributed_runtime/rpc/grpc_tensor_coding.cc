@@ -19,6 +19,7 @@ limitations under the License.
 #include "grpcpp/support/slice.h"
 #include "absl/flags/flag.h"
 #include "tensorflow/core/common_runtime/dma_helper.h"
+#include "tensorflow/core/distributed_runtime/tensor_coding.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/framework/tensor_reference.h"
@@ -139,6 +140,13 @@ static void EncodeSkeleton(const Tensor& val, io::ProtoEncodeHelper* e) {
 
 void EncodeTensorToByteBuffer(bool is_dead, const Tensor& val, bool require_ack,
                               ::grpc::ByteBuffer* result) {
+  EncodeTensorToByteBuffer(is_dead, val, require_ack, TENSOR_CONTENT_RAW,
+                           result);
+}
+
+void EncodeTensorToByteBuffer(bool is_dead, const Tensor& val, bool require_ack,
+                              TensorContentCodec codec,
+                              ::grpc::ByteBuffer* result) {
   const int kLargeTensorBytes = 1024;
   RecvTensorResponse response;
   if (is_dead) {
@@ -162,6 +170,13 @@ void EncodeTensorToByteBuffer(bool is_dead, const Tensor& val, bool require_ack,
     EncodeSkeleton(val, &e_skeleton);
 
     StringPiece tdata = val.tensor_data();
+    string encoded;
+    const bool content_encoded = codec != TENSOR_CONTENT_RAW && !is_dead &&
+                                 EncodeTensorContent(codec, val, &encoded);
+    if (content_encoded) {
+      response.set_tensor_content_codec(codec);
+      tdata = encoded;
+    }
     uint32 overall_tensor_proto_bytesize =
         (e_skeleton.size() +
          VarLengthEncodingSize(TensorProto::kTensorContentFieldNumber,
@@ -183,7 +198,9 @@ void EncodeTensorToByteBuffer(bool is_dead, const Tensor& val, bool require_ack,
     // backing store alive as needed.
     //
     // We enable this behavior if the tensor is large.
-    bool share_tensor_slice_memory = (tdata.size() > kLargeTensorBytes);
+    // Encoded contents live in a local string, so they are always copied.
+    bool share_tensor_slice_memory =
+        (!content_encoded && tdata.size() > kLargeTensorBytes);
 
     // (Omitted internal-only conditional)
 
@@ -245,5 +262,26 @@ void EncodeTensorToByteBuffer(bool is_dead, const Tensor& val, bool require_ack,
   }
 }
 
+void EncodeRecvTensorsResponseToByteBuffer(
+    std::vector<::grpc::ByteBuffer>* responses, ::grpc::ByteBuffer* result) {
+  std::vector<::grpc::Slice> slices;
+  for (::grpc::ByteBuffer& response : *responses) {
+    // Tag and varint length of the RecvTensorsResponse::response entry.
+    char header[1 + core::kMaxVarint32Bytes];
+    io::ProtoEncodeHelper e(header, sizeof(header));
+    e.WriteVarlengthBeginning(RecvTensorsResponse::kResponseFieldNumber,
+                              response.Length());
+    slices.emplace_back(e.data(), e.size());
+
+    std::vector<::grpc::Slice> response_slices;
+    response.Dump(&response_slices);
+    for (::grpc::Slice& slice : response_slices) {
+      slices.push_back(std::move(slice));
+    }
+  }
+  ::grpc::ByteBuffer tmp(slices.data(), slices.size());
+  result->Swap(&tmp);
+}
+
 }  // namespace grpc
 }  // namespace tensorflow
@@ -16,11 +16,13 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_GRPC_TENSOR_CODING_H_
 #define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_GRPC_TENSOR_CODING_H_
 
+#include <vector>
+
 #include "grpcpp/impl/codegen/byte_buffer.h"
+#include "tensorflow/core/protobuf/worker.pb.h"
 
 namespace tensorflow {
 class Tensor;
-class RecvTensorResponse;
 
 // TODO(jeff,sanjay): this should not be grpc specific.  Instead of
 // grpc::ByteBuffer*, it should accept an object of an interface type
@@ -49,6 +51,21 @@ void EncodeRecvTensorResponseToByteBuffer(const RecvTensorResponse& proto,
 void EncodeTensorToByteBuffer(bool is_dead, const Tensor& val, bool require_ack,
                               ::grpc::ByteBuffer* result);
 
+// As above, but the tensor contents are encoded with "codec" when that pays
+// off (see EncodeTensorContent()).
+void EncodeTensorToByteBuffer(bool is_dead, const Tensor& val, bool require_ack,
+                              TensorContentCodec codec,
+                              ::grpc::ByteBuffer* result);
+
+// Concatenate byte buffers that each hold an encoded RecvTensorResponse
+// into a byte buffer in a format that is parseable as a RecvTensorsResponse
+// protocol buffer holding all of them, in order. The slices of "responses"
+// are shared rather than copied.
+//
+// Discards original contents of *result.
+void EncodeRecvTensorsResponseToByteBuffer(
+    std::vector<::grpc::ByteBuffer>* responses, ::grpc::ByteBuffer* result);
+
 }  // namespace grpc
 }  // namespace tensorflow
 
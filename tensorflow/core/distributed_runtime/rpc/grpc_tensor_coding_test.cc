@@ -17,6 +17,7 @@ limitations under the License.
 
 #include "grpcpp/support/byte_buffer.h"
 #include "grpcpp/support/slice.h"
+#include "tensorflow/core/distributed_runtime/tensor_coding.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
@@ -100,4 +101,81 @@ TEST_F(GrpcTensorCodingTest, Simple) {
 
 TEST_F(GrpcTensorCodingTest, StringTensor) { DoTestForStrings(DT_STRING); }
 
+TEST_F(GrpcTensorCodingTest, RecvTensorsResponse) {
+  Tensor small = test::AsTensor<float>({1.0f, 2.0f, 3.0f});
+  Tensor large(DT_INT32, TensorShape({1000}));
+  test::FillIota<int32>(&large, 0);
+
+  std::vector<::grpc::ByteBuffer> responses(3);
+  grpc::EncodeTensorToByteBuffer(false, small, false, &responses[0]);
+  grpc::EncodeTensorToByteBuffer(true, Tensor(DT_FLOAT), false,
+                                 &responses[1]);
+  grpc::EncodeTensorToByteBuffer(false, large, false, &responses[2]);
+  ::grpc::ByteBuffer buf;
+  grpc::EncodeRecvTensorsResponseToByteBuffer(&responses, &buf);
+
+  std::vector<::grpc::Slice> slices;
+  (void)buf.Dump(&slices);
+  string tmp;
+  for (const auto& s : slices) {
+    tmp.append(reinterpret_cast<const char*>(s.begin()), s.size());
+  }
+  RecvTensorsResponse response;
+  ASSERT_TRUE(response.ParseFromString(tmp));
+  ASSERT_EQ(3, response.response_size());
+
+  Tensor result;
+  EXPECT_FALSE(response.response(0).is_dead());
+  ASSERT_TRUE(result.FromProto(response.response(0).tensor()));
+  test::ExpectTensorEqual<float>(small, result);
+  EXPECT_TRUE(response.response(1).is_dead());
+  EXPECT_FALSE(response.response(2).is_dead());
+  ASSERT_TRUE(result.FromProto(response.response(2).tensor()));
+  test::ExpectTensorEqual<int32>(large, result);
+}
+
+TEST_F(GrpcTensorCodingTest, EmptyRecvTensorsResponse) {
+  std::vector<::grpc::ByteBuffer> responses;
+  ::grpc::ByteBuffer buf;
+  grpc::EncodeRecvTensorsResponseToByteBuffer(&responses, &buf);
+  EXPECT_EQ(0, buf.Length());
+}
+
+TEST_F(GrpcTensorCodingTest, EncodedTensorContent) {
+  Tensor sparse(DT_FLOAT, TensorShape({16384}));
+  test::FillFn<float>(&sparse, [](int i) { return i % 10 ? 0.0f : 1.0f * i; });
+  Tensor small = test::AsTensor<float>({1.0f, 2.0f, 3.0f});
+  for (TensorContentCodec codec :
+       {TENSOR_CONTENT_SNAPPY, TENSOR_CONTENT_SHUFFLE_SNAPPY}) {
+    for (const Tensor& t : {sparse, small}) {
+      ::grpc::ByteBuffer buf;
+      grpc::EncodeTensorToByteBuffer(false, t, false, codec, &buf);
+      std::vector<::grpc::Slice> slices;
+      (void)buf.Dump(&slices);
+      string tmp;
+      for (const auto& s : slices) {
+        tmp.append(reinterpret_cast<const char*>(s.begin()), s.size());
+      }
+
+      RecvTensorResponse response;
+      ASSERT_TRUE(response.ParseFromString(tmp));
+      // Only the large tensor is worth encoding.
+      Tensor result(DT_FLOAT, t.shape());
+      if (t.NumElements() == small.NumElements()) {
+        EXPECT_EQ(TENSOR_CONTENT_RAW, response.tensor_content_codec());
+        ASSERT_TRUE(result.FromProto(response.tensor()));
+      } else {
+        EXPECT_EQ(codec, response.tensor_content_codec());
+        EXPECT_LT(response.tensor().tensor_content().size(),
+                  t.TotalBytes() / 2);
+        ASSERT_TRUE(DecodeTensorContent(
+            codec, DT_FLOAT, response.tensor().tensor_content(),
+            const_cast<char*>(result.tensor_data().data()),
+            result.tensor_data().size()));
+      }
+      test::ExpectTensorEqual<float>(t, result);
+    }
+  }
+}
+
 }  // namespace tensorflow
@@ -15,12 +15,34 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/rpc/grpc_util.h"
 #include "tensorflow/core/distributed_runtime/tensor_coding.h"
+#include "tensorflow/core/framework/allocation_description.pb.h"
 #include "tensorflow/core/lib/random/random.h"
 
 namespace tensorflow {
 
 namespace {
 
+// A TensorBuffer aliasing part of a received grpc slice, which it keeps alive.
+class GrpcSliceBuffer : public TensorBuffer {
+ public:
+  GrpcSliceBuffer(const ::grpc::Slice& slice, const char* data, size_t size)
+      : TensorBuffer(const_cast<char*>(data)), slice_(slice), size_(size) {}
+
+  size_t size() const override { return size_; }
+  TensorBuffer* root_buffer() override { return this; }
+  void FillAllocationDescription(AllocationDescription* proto) const override {
+    proto->set_requested_bytes(size_);
+    proto->set_allocator_name("grpc");
+  }
+  // The slice is owned by grpc, so the buffer can't be forwarded and written
+  // in place.
+  bool OwnsMemory() const override { return false; }
+
+ private:
+  ::grpc::Slice slice_;
+  const size_t size_;
+};
+
 double GenerateUniformRandomNumber() {
   return random::New64() * (1.0 / std::numeric_limits<uint64>::max());
 }
@@ -91,6 +113,19 @@ bool GrpcMaybeParseProto(::grpc::ByteBuffer* src, protobuf::Message* dst) {
   return dst->ParseFromZeroCopyStream(&reader);
 }
 
+TensorBuffer* GrpcByteSource::ShareBuffer(const char* data, size_t size) {
+  std::vector<::grpc::Slice> slices;
+  if (!buffer_->Dump(&slices).ok()) return nullptr;
+  for (const ::grpc::Slice& slice : slices) {
+    const char* begin = reinterpret_cast<const char*>(slice.begin());
+    const char* end = reinterpret_cast<const char*>(slice.end());
+    if (data >= begin && data + size <= end) {
+      return new GrpcSliceBuffer(slice, data, size);
+    }
+  }
+  return nullptr;
+}
+
 // Overload of GrpcParseProto so we can decode a TensorResponse without
 // extra copying.  This overload is used by the RPCState class in
 // grpc_state.h.
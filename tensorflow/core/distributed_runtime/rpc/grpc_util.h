@@ -53,6 +53,9 @@ class GrpcByteSource : public TensorResponse::Source {
     return stream_;
   }
 
+  // Shares the grpc slice of buffer_ that contains [data, data + size).
+  TensorBuffer* ShareBuffer(const char* data, size_t size) override;
+
  private:
   void DeleteStream() {
     if (stream_) {
@@ -157,13 +157,25 @@ class GrpcWorkerServiceThread {
          ++i) {
       EnqueueRecvTensorRequestRaw();
     }
+    for (int i = 0;
+         i < gtl::FindWithDefault(
+                 queue_depth_, static_cast<int>(GrpcWorkerMethod::kRecvTensors),
+                 100);
+         ++i) {
+      EnqueueRecvTensorsRequestRaw();
+    }
+
+    // A streaming call accepts the next one once it is opened, so a single
+    // pending call per method is enough.
+    EnqueueStreamingRequests();
 
     void* tag;
     bool ok;
 
     while (cq_->Next(&tag, &ok)) {
-      UntypedCall<GrpcWorkerServiceThread>::Tag* callback_tag =
-          static_cast<UntypedCall<GrpcWorkerServiceThread>::Tag*>(tag);
+      // Both unary and streaming calls hand their tags to the queue.
+      GrpcCallTag<GrpcWorkerServiceThread>* callback_tag =
+          static_cast<GrpcCallTag<GrpcWorkerServiceThread>*>(tag);
       CHECK(callback_tag);
       callback_tag->OnCompleted(this, ok);
     }
@@ -185,6 +197,12 @@ class GrpcWorkerServiceThread {
       Call<GrpcWorkerServiceThread, grpc::WorkerService::AsyncService,
            RequestMessage, ResponseMessage>;
 
+  template <class RequestMessage, class ResponseMessage>
+  using StreamingWorkerCall =
+      ServerBidirectionalStreamingCall<GrpcWorkerServiceThread,
+                                       grpc::WorkerService::AsyncService,
+                                       RequestMessage, ResponseMessage>;
+
   // Handle all non-cancellable simple methods with a standard wrapper.
   // The boolean `may_block_on_compute_pool` indicates whether or not the
   // operation may block on activities (such as op execution) that run on the
@@ -283,6 +301,26 @@ class GrpcWorkerServiceThread {
     EnqueueRecvTensorRequestRaw();
   }
 
+  void RecvTensorsHandlerRaw(
+      WorkerCall<RecvTensorsRequest, ::grpc::ByteBuffer>* call) {
+    Schedule([this, call]() {
+      CallOptions* call_opts = new CallOptions;
+      call->SetCancelCallback([call_opts]() { call_opts->StartCancel(); });
+
+      worker_->GrpcRecvTensorsAsync(
+          call_opts, &call->request, &call->response,
+          [call, call_opts](const Status& s) {
+            call->ClearCancelCallback();
+            delete call_opts;
+            if (!s.ok()) {
+              VLOG(1) << "Bad response from RecvTensors:" << s;
+            }
+            call->SendResponse(ToGrpcStatus(s));
+          });
+    });
+    EnqueueRecvTensorsRequestRaw();
+  }
+
   void RecvBufHandler(WorkerCall<RecvBufRequest, RecvBufResponse>* call) {
     Schedule([this, call]() {
       CallOptions* call_opts = new CallOptions;
@@ -339,6 +377,63 @@ class GrpcWorkerServiceThread {
   }
 #undef ENQUEUE_REQUEST
 
+  // Streaming calls answer one request at a time, in order.  The client only
+  // sends a request on a stream that has no other request outstanding.  Errors
+  // close the stream.
+
+  void StreamingRunGraphHandler(
+      StreamingWorkerCall<RunGraphRequest, RunGraphResponse>* call) {
+    Schedule([this, call]() {
+      CallOptions* call_opts = new CallOptions;
+      ProtoRunGraphRequest* wrapped_request =
+          new ProtoRunGraphRequest(&call->request());
+      NonOwnedProtoRunGraphResponse* wrapped_response =
+          new NonOwnedProtoRunGraphResponse(call->mutable_response());
+      worker_->RunGraphAsync(call_opts, wrapped_request, wrapped_response,
+                             [call, call_opts, wrapped_request,
+                              wrapped_response](const Status& s) {
+                               delete call_opts;
+                               delete wrapped_request;
+                               delete wrapped_response;
+                               if (s.ok()) {
+                                 call->SendResponse();
+                               } else {
+                                 VLOG(1) << "Bad response from "
+                                         << "StreamingRunGraph:" << s;
+                                 call->Finish(ToGrpcStatus(s));
+                               }
+                             });
+    });
+  }
+
+  void StreamingCleanupGraphHandler(
+      StreamingWorkerCall<CleanupGraphRequest, CleanupGraphResponse>* call) {
+    worker_->env()->compute_pool->Schedule([this, call]() {
+      Status s = worker_->CleanupGraph(&call->request(),
+                                       call->mutable_response());
+      if (s.ok()) {
+        call->SendResponse();
+      } else {
+        VLOG(1) << "Bad response from StreamingCleanupGraph: " << s;
+        call->Finish(ToGrpcStatus(s));
+      }
+    });
+  }
+
+  void EnqueueStreamingRequests() {
+    mutex_lock l(shutdown_mu_);
+    if (is_shutdown_) return;
+    StreamingWorkerCall<RunGraphRequest, RunGraphResponse>::EnqueueRequest(
+        worker_service_, cq_.get(),
+        &grpc::WorkerService::AsyncService::RequestStreamingRunGraph,
+        &GrpcWorkerServiceThread::StreamingRunGraphHandler);
+    StreamingWorkerCall<CleanupGraphRequest, CleanupGraphResponse>::
+        EnqueueRequest(
+            worker_service_, cq_.get(),
+            &grpc::WorkerService::AsyncService::RequestStreamingCleanupGraph,
+            &GrpcWorkerServiceThread::StreamingCleanupGraphHandler);
+  }
+
   void EnqueueRecvTensorRequestRaw() {
     mutex_lock l(shutdown_mu_);
     if (!is_shutdown_) {
@@ -352,6 +447,19 @@ class GrpcWorkerServiceThread {
     }
   }
 
+  void EnqueueRecvTensorsRequestRaw() {
+    mutex_lock l(shutdown_mu_);
+    if (!is_shutdown_) {
+      Call<GrpcWorkerServiceThread, grpc::WorkerService::AsyncService,
+           RecvTensorsRequest, ::grpc::ByteBuffer>::
+          EnqueueRequestForMethod(
+              worker_service_, cq_.get(),
+              static_cast<int>(GrpcWorkerMethod::kRecvTensors),
+              &GrpcWorkerServiceThread::RecvTensorsHandlerRaw,
+              true /* supports cancel*/);
+    }
+  }
+
   GrpcWorker* const worker_ = nullptr;  // Not owned.
   std::unique_ptr<::grpc::ServerCompletionQueue> cq_;
   std::unique_ptr<Thread> thread_;
@@ -446,12 +554,14 @@ void GrpcWorker::GrpcRecvTensorAsync(CallOptions* opts,
   const int64 step_id = request->step_id();
 
   bool cache_enabled = (response_cache_ != nullptr && request_id != 0);
+  const TensorContentCodec codec = request->tensor_content_codec();
 
-  auto do_response = [response, done, cache_enabled](const Tensor& tensor,
-                                                     bool is_dead,
-                                                     const Status& status) {
+  auto do_response = [response, done, cache_enabled, codec](
+                         const Tensor& tensor, bool is_dead,
+                         const Status& status) {
     if (status.ok()) {
-      grpc::EncodeTensorToByteBuffer(is_dead, tensor, cache_enabled, response);
+      grpc::EncodeTensorToByteBuffer(is_dead, tensor, cache_enabled, codec,
+                                     response);
     }
     done(status);
   };
@@ -555,6 +665,55 @@ void GrpcWorker::GrpcRecvTensorAsync(CallOptions* opts,
       });
 }
 
+void GrpcWorker::GrpcRecvTensorsAsync(CallOptions* opts,
+                                      const RecvTensorsRequest* request,
+                                      ::grpc::ByteBuffer* response,
+                                      StatusCallback done) {
+  const int num_tensors = request->request_size();
+  if (num_tensors == 0) {
+    std::vector<::grpc::ByteBuffer> no_responses;
+    grpc::EncodeRecvTensorsResponseToByteBuffer(&no_responses, response);
+    done(Status::OK());
+    return;
+  }
+
+  // Each tensor is received independently, and the responses are
+  // concatenated once the last one is ready.
+  struct BatchState {
+    explicit BatchState(int n) : opts(n), responses(n), pending(n) {}
+    std::vector<CallOptions> opts;
+    std::vector<::grpc::ByteBuffer> responses;
+    mutex mu;
+    Status status TF_GUARDED_BY(mu);
+    int pending TF_GUARDED_BY(mu);
+  };
+  auto state = std::make_shared<BatchState>(num_tensors);
+  opts->SetCancelCallback([state]() {
+    for (CallOptions& item_opts : state->opts) {
+      item_opts.StartCancel();
+    }
+  });
+  for (int i = 0; i < num_tensors; ++i) {
+    GrpcRecvTensorAsync(
+        &state->opts[i], &request->request(i), &state->responses[i],
+        [opts, state, response, done](const Status& s) {
+          Status status;
+          {
+            mutex_lock l(state->mu);
+            state->status.Update(s);
+            if (--state->pending > 0) return;
+            status = state->status;
+          }
+          opts->ClearCancelCallback();
+          if (status.ok()) {
+            grpc::EncodeRecvTensorsResponseToByteBuffer(&state->responses,
+                                                        response);
+          }
+          done(status);
+        });
+  }
+}
+
 namespace {
 // If RecvBufRespExtra.tensor_content is a single large string, then gRPC
 // can stall on the recv side when the string buffer needs to be enlarged,
@@ -46,6 +46,13 @@ class GrpcWorker : public Worker {
                                    ::grpc::ByteBuffer* response,
                                    StatusCallback done);
 
+  // Batched version of GrpcRecvTensorAsync. The response is encoded as a
+  // RecvTensorsResponse, and is sent once all the tensors are available.
+  virtual void GrpcRecvTensorsAsync(CallOptions* opts,
+                                    const RecvTensorsRequest* request,
+                                    ::grpc::ByteBuffer* response,
+                                    StatusCallback done);
+
   void LoggingAsync(const LoggingRequest* request, LoggingResponse* response,
                     StatusCallback done) override;
 
@@ -60,6 +60,12 @@ const char* GrpcWorkerMethodName(GrpcWorkerMethod id) {
       return "/tensorflow.WorkerService/GetStepSequence";
     case GrpcWorkerMethod::kMarkRecvFinished:
       return "/tensorflow.WorkerService/MarkRecvFinished";
+    case GrpcWorkerMethod::kRecvTensors:
+      return "/tensorflow.WorkerService/RecvTensors";
+    case GrpcWorkerMethod::kStreamingRunGraph:
+      return "/tensorflow.WorkerService/StreamingRunGraph";
+    case GrpcWorkerMethod::kStreamingCleanupGraph:
+      return "/tensorflow.WorkerService/StreamingCleanupGraph";
   }
   // Shouldn't be reached.
   LOG(FATAL) << "Invalid id: this line shouldn't be reached.";
@@ -70,9 +76,15 @@ namespace grpc {
 
 WorkerService::AsyncService::AsyncService() {
   for (int i = 0; i < kGrpcNumWorkerMethods; ++i) {
+    const GrpcWorkerMethod method = static_cast<GrpcWorkerMethod>(i);
+    const bool is_streaming =
+        method == GrpcWorkerMethod::kStreamingRunGraph ||
+        method == GrpcWorkerMethod::kStreamingCleanupGraph;
     AddMethod(new ::grpc::internal::RpcServiceMethod(
-        GrpcWorkerMethodName(static_cast<GrpcWorkerMethod>(i)),
-        ::grpc::internal::RpcMethod::NORMAL_RPC, nullptr));
+        GrpcWorkerMethodName(method),
+        is_streaming ? ::grpc::internal::RpcMethod::BIDI_STREAMING
+                     : ::grpc::internal::RpcMethod::NORMAL_RPC,
+        nullptr));
     ::grpc::Service::MarkMethodAsync(i);
   }
 }
@@ -15,8 +15,11 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/rpc/rpc_rendezvous_mgr.h"
 
+#include <atomic>
 #include <unordered_set>
 
+#include "absl/container/flat_hash_map.h"
+
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/common_runtime/device_mgr.h"
 #include "tensorflow/core/common_runtime/dma_helper.h"
@@ -33,15 +36,59 @@ limitations under the License.
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/notification.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 
 namespace {
 
+// Returns how long, in microseconds, receives from the same worker are
+// collected before they are sent as one RecvTensors RPC. Zero (the default)
+// sends every receive as its own RecvTensor RPC.
+//
+// A batched response is only sent once all of its tensors are available, so
+// batching receives whose producers depend on each other across workers can
+// stall a step. Only enable it for graphs where that cannot happen.
+int64 RecvTensorBatchWindowMicros() {
+  static const int64 batch_window_us = []() {
+    int64 value;
+    Status s = ReadInt64FromEnvVar("TF_RPC_RECV_TENSOR_BATCH_WINDOW_US", 0,
+                                   &value);
+    if (!s.ok()) {
+      LOG(ERROR) << "Invalid TF_RPC_RECV_TENSOR_BATCH_WINDOW_US: " << s;
+      return int64{0};
+    }
+    return value;
+  }();
+  return batch_window_us;
+}
+
+// Returns the codec that senders may apply to the tensors received by this
+// process, from TF_RPC_TENSOR_CONTENT_CODEC ("snappy" or "shuffle_snappy").
+// By default tensors are sent unencoded.
+//
+// The variable is read for every step, so that it can differ between
+// sessions of the same process.
+TensorContentCodec RecvTensorContentCodec() {
+  string value;
+  Status s = ReadStringFromEnvVar("TF_RPC_TENSOR_CONTENT_CODEC", "", &value);
+  if (s.ok() && value.empty()) return TENSOR_CONTENT_RAW;
+  if (s.ok() && value == "snappy") return TENSOR_CONTENT_SNAPPY;
+  if (s.ok() && value == "shuffle_snappy") {
+    return TENSOR_CONTENT_SHUFFLE_SNAPPY;
+  }
+  LOG(ERROR) << "Invalid TF_RPC_TENSOR_CONTENT_CODEC: " << value;
+  return TENSOR_CONTENT_RAW;
+}
+
+class RpcRecvTensorCall;
+
 class RpcRemoteRendezvous : public BaseRemoteRendezvous {
  public:
   RpcRemoteRendezvous(const WorkerEnv* env, int64 step_id)
-      : BaseRemoteRendezvous(env, step_id) {}
+      : BaseRemoteRendezvous(env, step_id),
+        batch_window_us_(RecvTensorBatchWindowMicros()),
+        tensor_content_codec_(RecvTensorContentCodec()) {}
 
  protected:
   void RecvFromRemoteAsync(const Rendezvous::ParsedKey& parsed,
@@ -51,6 +98,24 @@ class RpcRemoteRendezvous : public BaseRemoteRendezvous {
  private:
   ~RpcRemoteRendezvous() override {}
 
+  // Queues `call` to be sent in the next RecvTensors batch to its worker.
+  void EnqueueBatchedCall(RpcRecvTensorCall* call,
+                          std::shared_ptr<WorkerCacheInterface> worker_cache);
+
+  // Sends all calls queued for `src_worker`.
+  void FlushBatchedCalls(const string& src_worker,
+                         std::shared_ptr<WorkerCacheInterface> worker_cache);
+
+  // Delivers the result of the finished `call` and releases it.
+  void FinishCall(RpcRecvTensorCall* call);
+
+  const int64 batch_window_us_;
+  const TensorContentCodec tensor_content_codec_;
+
+  mutex batch_mu_;
+  absl::flat_hash_map<string, std::vector<RpcRecvTensorCall*>> batched_calls_
+      TF_GUARDED_BY(batch_mu_);
+
   TF_DISALLOW_COPY_AND_ASSIGN(RpcRemoteRendezvous);
 };
 
@@ -61,7 +126,8 @@ class RpcRecvTensorCall : public BaseRecvTensorCall {
 
   void Init(WorkerInterface* wi, int64 step_id, StringPiece key,
             AllocatorAttributes alloc_attrs, Device* dst_device,
-            const Rendezvous::Args& recv_args, Rendezvous::DoneCallback done) {
+            const Rendezvous::Args& recv_args, TensorContentCodec codec,
+            Rendezvous::DoneCallback done) {
     wi_ = wi;
     alloc_attrs_ = alloc_attrs;
     dst_device_ = dst_device;
@@ -70,6 +136,7 @@ class RpcRecvTensorCall : public BaseRecvTensorCall {
     req_.set_step_id(step_id);
     req_.set_rendezvous_key(key.data(), key.size());
     req_.set_request_id(GetUniqueRequestId());
+    req_.set_tensor_content_codec(codec);
   }
 
   void Reset() {
@@ -133,6 +200,7 @@ class RpcRecvTensorCall : public BaseRecvTensorCall {
 
  private:
   friend class RpcRemoteRendezvous;
+  friend class RpcRecvTensorsBatch;
 
   // Start the main RecvTensor call, checking for an async abort.
   void StartRTCall(std::function<void()> recv_done) {
@@ -185,6 +253,89 @@ class RpcRecvTensorCall : public BaseRecvTensorCall {
   TF_DISALLOW_COPY_AND_ASSIGN(RpcRecvTensorCall);
 };
 
+// Retrieves the tensors of several calls to the same worker with one
+// RecvTensors RPC.
+class RpcRecvTensorsBatch {
+ public:
+  explicit RpcRecvTensorsBatch(std::vector<RpcRecvTensorCall*> calls)
+      : calls_(std::move(calls)) {
+    DCHECK(!calls_.empty());
+  }
+
+  const std::vector<RpcRecvTensorCall*>& calls() const { return calls_; }
+
+  // Runs `recv_done` once every call in the batch has finished. The status and
+  // tensor of each call are set as if it had been started on its own.
+  void Start(std::function<void()> recv_done) {
+    for (RpcRecvTensorCall* call : calls_) {
+      *req_.add_request() = call->req_;
+      // Aborting any call of the batch cancels the whole RPC.
+      call->opts_.SetCancelCallback([this]() { opts_.StartCancel(); });
+    }
+    auto abort_checked = std::make_shared<Notification>();
+    auto cb = [this, abort_checked,
+               recv_done = std::move(recv_done)](const Status& s) {
+      abort_checked->WaitForNotification();
+      for (RpcRecvTensorCall* call : calls_) {
+        call->opts_.ClearCancelCallback();
+      }
+      if (errors::IsUnimplemented(s)) {
+        // The remote worker predates RecvTensors.
+        StartIndividually(std::move(recv_done));
+        return;
+      }
+      Status status = s;
+      if (status.ok() &&
+          resp_.response_size() != static_cast<int>(calls_.size())) {
+        status = errors::Internal("RecvTensors returned ",
+                                  resp_.response_size(), " tensors, expected ",
+                                  calls_.size());
+      }
+      for (int i = 0; i < calls_.size(); ++i) {
+        RpcRecvTensorCall* call = calls_[i];
+        Status call_status = status;
+        if (call_status.ok()) {
+          call->resp_.InitAlloc(call->dst_device_, call->alloc_attrs_);
+          call_status = call->resp_.InitFrom(resp_.mutable_response(i));
+        }
+        if (!call_status.ok()) {
+          mutex_lock l(call->mu_);
+          call->status_.Update(call_status);
+        }
+      }
+      recv_done();
+    };
+    calls_[0]->wi_->RecvTensorsAsync(&opts_, &req_, &resp_, std::move(cb));
+
+    // As in RpcRecvTensorCall::StartRTCall, a call may have been aborted
+    // before its cancellation was forwarded to `opts_`.
+    for (RpcRecvTensorCall* call : calls_) {
+      if (!call->status().ok()) {
+        opts_.StartCancel();
+        break;
+      }
+    }
+    abort_checked->Notify();
+  }
+
+ private:
+  void StartIndividually(std::function<void()> recv_done) {
+    auto pending = std::make_shared<std::atomic<int>>(calls_.size());
+    for (RpcRecvTensorCall* call : calls_) {
+      call->Start([pending, recv_done]() {
+        if (--*pending == 0) recv_done();
+      });
+    }
+  }
+
+  const std::vector<RpcRecvTensorCall*> calls_;
+  CallOptions opts_;
+  RecvTensorsRequest req_;
+  RecvTensorsResponse resp_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(RpcRecvTensorsBatch);
+};
+
 class RpcRecvTensorFreeList {
  public:
   RpcRecvTensorFreeList() {}
@@ -270,7 +421,7 @@ void RpcRemoteRendezvous::RecvFromRemoteAsync(
   }
 
   call->Init(rwi, step_id_, parsed.FullKey(), recv_args.alloc_attrs, dst_device,
-             recv_args, std::move(done));
+             recv_args, tensor_content_codec_, std::move(done));
 
   // Record "call" in active_ so that it can be aborted cleanly.
   RegisterCall(call, recv_args);
@@ -289,22 +440,75 @@ void RpcRemoteRendezvous::RecvFromRemoteAsync(
 
   // Start "call".
   Ref();
-  call->Start([this, call, worker_cache]() {
-    // Removes "call" from active_. Prevent StartAbort().
-    DeregisterCall(call);
-    // If StartAbort was called prior to DeregisterCall, then the
-    // current status should be bad.
-    Status s = call->status();
-    // NOTE: `*session()` can potentially be deleted before we return from
-    // `call->done()(...)`, so we must release the worker before calling the
-    // callback.
-    call->ReleaseWorker(session()->worker_cache());
-    call->done()(s, Args(), call->recv_args(), call->tensor(), call->is_dead());
-    get_call_freelist()->Release(call);
-    Unref();
+  if (batch_window_us_ > 0) {
+    EnqueueBatchedCall(call, std::move(worker_cache));
+    return;
+  }
+  call->Start([this, call, worker_cache]() { FinishCall(call); });
+}
+
+void RpcRemoteRendezvous::EnqueueBatchedCall(
+    RpcRecvTensorCall* call,
+    std::shared_ptr<WorkerCacheInterface> worker_cache) {
+  // `call` may be finished by a concurrent flush once it is queued.
+  const string src_worker = call->src_worker_;
+  bool schedule_flush;
+  {
+    mutex_lock l(batch_mu_);
+    std::vector<RpcRecvTensorCall*>& calls = batched_calls_[src_worker];
+    schedule_flush = calls.empty();
+    calls.push_back(call);
+  }
+  if (schedule_flush) {
+    Ref();
+    env_->env->SchedClosureAfter(
+        batch_window_us_, [this, src_worker, worker_cache]() {
+          FlushBatchedCalls(src_worker, worker_cache);
+          Unref();
+        });
+  }
+}
+
+void RpcRemoteRendezvous::FlushBatchedCalls(
+    const string& src_worker,
+    std::shared_ptr<WorkerCacheInterface> worker_cache) {
+  std::vector<RpcRecvTensorCall*> calls;
+  {
+    mutex_lock l(batch_mu_);
+    auto it = batched_calls_.find(src_worker);
+    if (it == batched_calls_.end()) return;
+    calls.swap(it->second);
+    batched_calls_.erase(it);
+  }
+  if (calls.size() == 1) {
+    RpcRecvTensorCall* call = calls[0];
+    call->Start([this, call, worker_cache]() { FinishCall(call); });
+    return;
+  }
+  auto* batch = new RpcRecvTensorsBatch(std::move(calls));
+  batch->Start([this, batch, worker_cache]() {
+    for (RpcRecvTensorCall* call : batch->calls()) {
+      FinishCall(call);
+    }
+    delete batch;
   });
 }
 
+void RpcRemoteRendezvous::FinishCall(RpcRecvTensorCall* call) {
+  // Removes "call" from active_. Prevent StartAbort().
+  DeregisterCall(call);
+  // If StartAbort was called prior to DeregisterCall, then the
+  // current status should be bad.
+  Status s = call->status();
+  // NOTE: `*session()` can potentially be deleted before we return from
+  // `call->done()(...)`, so we must release the worker before calling the
+  // callback.
+  call->ReleaseWorker(session()->worker_cache());
+  call->done()(s, Args(), call->recv_args(), call->tensor(), call->is_dead());
+  get_call_freelist()->Release(call);
+  Unref();
+}
+
 }  // namespace
 
 RpcRendezvousMgr::RpcRendezvousMgr(const WorkerEnv* env)
@@ -14,6 +14,7 @@ limitations under the License.
 ==============================================================================*/
 
 #include <cstdio>
+#include <cstdlib>
 #include <functional>
 #include <string>
 #include <vector>
@@ -166,8 +167,11 @@ string DebugString(const Tensor& x, const Tensor& y, int tensor_size) {
 }
 
 // TODO: Support sharding and depth.
+//
+// If "sparse_input" is true, nine in ten elements of the input are zero, as
+// in embedding gradients.
 static void BM_Helper(int iters, int width, int num_stages, int tensor_size,
-                      bool use_multiple_devices) {
+                      bool use_multiple_devices, bool sparse_input = false) {
   testing::StopTiming();
   const Cluster* cluster = GetCluster();
 
@@ -181,6 +185,13 @@ static void BM_Helper(int iters, int width, int num_stages, int tensor_size,
 
   // Randomly initialize the input.
   Tensor x(DT_FLOAT, TensorShape({tensor_size, 1}));
+  if (sparse_input) {
+    x.flat<float>().setRandom();
+    auto x_flat = x.flat<float>();
+    for (int i = 0; i < tensor_size; ++i) {
+      if (i % 10 != 0) x_flat(i) = 0.0f;
+    }
+  }
 
   testing::SetLabel(
       strings::StrCat(def.node_size(), " nodes; ",
@@ -237,6 +248,24 @@ static void BM_RPC(int iters, int width, int tensor_size) {
 }
 BENCHMARK(BM_RPC)->ArgPair(30, 2)->ArgPair(30, 1000)->ArgPair(30, 100000);
 
+// As BM_RPC with a mostly-zero input, with the tensor contents sent
+// unencoded (codec 0), Snappy-compressed (1) or byte-shuffled and
+// Snappy-compressed (2).
+static void BM_RPCEncoded(int iters, int codec, int tensor_size) {
+  const char* const kCodecs[] = {"", "snappy", "shuffle_snappy"};
+  setenv("TF_RPC_TENSOR_CONTENT_CODEC", kCodecs[codec], 1);
+  BM_Helper(iters, 30 /*width*/, 2 /*num_stages*/, tensor_size,
+            true /*multi-device*/, true /*sparse_input*/);
+  unsetenv("TF_RPC_TENSOR_CONTENT_CODEC");
+}
+BENCHMARK(BM_RPCEncoded)
+    ->ArgPair(0, 100000)
+    ->ArgPair(1, 100000)
+    ->ArgPair(2, 100000)
+    ->ArgPair(0, 1000000)
+    ->ArgPair(1, 1000000)
+    ->ArgPair(2, 1000000);
+
 static void BM_SingleDevice(int iters, int width, int num_stages) {
   BM_Helper(iters, width, num_stages, 2 /*tensor_size*/,
             false /*not multi-device*/);
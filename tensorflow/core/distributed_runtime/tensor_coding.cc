@@ -15,18 +15,75 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/tensor_coding.h"
 
+#include <memory>
+
 #include "google/protobuf/any.pb.h"
 
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/framework/tensor_shape.pb.h"
+#include "tensorflow/core/platform/snappy.h"
 
 namespace tensorflow {
 
+namespace {
+
+// Below this size, encoding the tensor contents costs more time than it
+// saves on the wire.
+constexpr size_t kMinEncodedTensorBytes = 16 << 10;
+
+// Stores the "element_size" bytes of each of the "n" elements at "in" so
+// that the b-th bytes of all elements are contiguous in "out".
+void ShuffleBytes(const char* in, size_t n, size_t element_size, char* out) {
+  for (size_t i = 0; i < n; ++i) {
+    for (size_t b = 0; b < element_size; ++b) {
+      out[b * n + i] = in[i * element_size + b];
+    }
+  }
+}
+
+// Inverse of ShuffleBytes().
+void UnshuffleBytes(const char* in, size_t n, size_t element_size, char* out) {
+  for (size_t i = 0; i < n; ++i) {
+    for (size_t b = 0; b < element_size; ++b) {
+      out[i * element_size + b] = in[b * n + i];
+    }
+  }
+}
+
+// Replaces the encoded tensor_content of "response", if any, by the raw
+// bytes.
+Status DecodeResponseTensorContent(RecvTensorResponse* response) {
+  if (response->tensor_content_codec() == TENSOR_CONTENT_RAW) {
+    return Status::OK();
+  }
+  TensorProto* tensor = response->mutable_tensor();
+  if (!DataTypeCanUseMemcpy(tensor->dtype()) ||
+      !TensorShape::IsValid(tensor->tensor_shape())) {
+    return errors::InvalidArgument("Cannot parse tensor from response");
+  }
+  const TensorShape shape(tensor->tensor_shape());
+  string raw;
+  raw.resize(shape.num_elements() * DataTypeSize(tensor->dtype()));
+  if (!DecodeTensorContent(response->tensor_content_codec(), tensor->dtype(),
+                           tensor->tensor_content(), &raw[0], raw.size())) {
+    return errors::DataLoss("Cannot decode ",
+                            TensorContentCodec_Name(
+                                response->tensor_content_codec()),
+                            " tensor content of response");
+  }
+  tensor->set_tensor_content(std::move(raw));
+  response->set_tensor_content_codec(TENSOR_CONTENT_RAW);
+  return Status::OK();
+}
+
+}  // namespace
+
 TensorResponse::Source::~Source() {}
 
 void TensorResponse::Clear() {
   on_host_ = false;
+  share_source_memory_ = false;
   device_ = nullptr;
   alloc_attrs_ = AllocatorAttributes();
   allocator_ = nullptr;
@@ -47,13 +104,19 @@ void TensorResponse::InitAlloc(DeviceBase* d, const AllocatorAttributes& aa) {
   if (alloc_attrs_.on_host() || da.device_type() == "CPU") {
     on_host_ = true;
   }
+  // Memory destined for a GPU has to come from the (pinned) allocator, so we
+  // only alias the received bytes for plain CPU tensors.
+  share_source_memory_ =
+      da.device_type() == "CPU" && !alloc_attrs_.gpu_compatible();
   allocator_ = device_->GetAllocator(alloc_attrs_);
 }
 
 Status TensorResponse::InitFrom(RecvTensorResponse* response) {
-  Status s;
   meta_.Swap(response);
-  if (on_host_) {
+  Status s = DecodeResponseTensorContent(&meta_);
+  if (!s.ok()) {
+    // Leave tensor_ empty.
+  } else if (on_host_) {
     if (!tensor_.FromProto(allocator_, meta_.tensor())) {
       s = errors::InvalidArgument("Cannot parse tensor from response");
     }
@@ -88,8 +151,10 @@ Status TensorResponse::ParseFrom(Source* source) {
     if (!meta_.ParseFromCodedStream(&input) || !input.ConsumedEntireMessage()) {
       return errors::InvalidArgument("Cannot parse tensor from response");
     }
-    Status s =
-        device_->MakeTensorFromProto(meta_.tensor(), alloc_attrs_, &tensor_);
+    Status s = DecodeResponseTensorContent(&meta_);
+    if (s.ok()) {
+      s = device_->MakeTensorFromProto(meta_.tensor(), alloc_attrs_, &tensor_);
+    }
     // Reduce memory usage for big tensors.
     {
       TensorProto empty;
@@ -130,6 +195,10 @@ bool ReadVarintSizeAsInt(protobuf::io::CodedInputStream* input, int* result) {
   }
 }
 
+// Below this size, copying the tensor contents is cheaper than keeping the
+// memory of the source alive.
+constexpr int kMinSharedTensorBytes = 1024;
+
 bool ReadNestedMessage(protobuf::io::CodedInputStream* input,
                        protobuf::Message* value) {
   int length;
@@ -144,8 +213,33 @@ bool ReadNestedMessage(protobuf::io::CodedInputStream* input,
 
 }  // namespace
 
+bool TensorResponse::ShareTensorContent(protobuf::io::CodedInputStream* input,
+                                        Source* source, DataType dtype,
+                                        const TensorShape& shape,
+                                        int num_bytes) {
+  if (!share_source_memory_ || num_bytes < kMinSharedTensorBytes ||
+      shape.num_elements() * DataTypeSize(dtype) != num_bytes) {
+    return false;
+  }
+  // The contents can only be aliased if they are contiguous in the current
+  // chunk of the stream, and aligned as if they came from allocator_.
+  const void* data;
+  int size;
+  if (!input->GetDirectBufferPointer(&data, &size) || size < num_bytes ||
+      reinterpret_cast<uintptr_t>(data) % Allocator::kAllocatorAlignment != 0) {
+    return false;
+  }
+  TensorBuffer* buf =
+      source->ShareBuffer(static_cast<const char*>(data), num_bytes);
+  if (buf == nullptr) return false;
+  tensor_ = Tensor(dtype, shape, buf);
+  buf->Unref();
+  return input->Skip(num_bytes);
+}
+
 bool TensorResponse::ParseTensorSubmessage(
-    protobuf::io::CodedInputStream* input, TensorProto* tensor_meta) {
+    protobuf::io::CodedInputStream* input, TensorProto* tensor_meta,
+    Source* source) {
   bool seen_tensor_content = false;
   while (true) {
     auto p = input->ReadTagWithCutoff(127);
@@ -196,12 +290,27 @@ bool TensorResponse::ParseTensorSubmessage(
         if (!ReadVarintSizeAsInt(input, &num_bytes)) return false;
         seen_tensor_content = true;
         TensorShape shape(tensor_meta->tensor_shape());
+        if (meta_.tensor_content_codec() != TENSOR_CONTENT_RAW) {
+          string encoded;
+          if (!input->ReadString(&encoded, num_bytes)) return false;
+          Tensor t(allocator_, tensor_meta->dtype(), shape);
+          StringPiece buf = t.tensor_data();
+          if (!DecodeTensorContent(meta_.tensor_content_codec(),
+                                   tensor_meta->dtype(), encoded,
+                                   const_cast<char*>(buf.data()),
+                                   buf.size())) {
+            return false;
+          }
+          tensor_ = std::move(t);
+          break;
+        }
+        if (ShareTensorContent(input, source, tensor_meta->dtype(), shape,
+                               num_bytes)) {
+          break;
+        }
         Tensor t(allocator_, tensor_meta->dtype(), shape);
         StringPiece buf = t.tensor_data();
         if (static_cast<size_t>(num_bytes) != buf.size()) return false;
-        // TODO(jeff,sanjay): Figure out a way to avoid this copy if
-        // the underlying ZeroCopyInputStream data is properly aligned
-        // and compatible with what allocator_ wants.
         if (!input->ReadRaw(const_cast<char*>(buf.data()), num_bytes))
           return false;
         tensor_ = std::move(t);
@@ -235,7 +344,7 @@ bool TensorResponse::ParseFast(Source* source) {
         std::pair<protobuf::io::CodedInputStream::Limit, int> p =
             input.IncrementRecursionDepthAndPushLimit(length);
         if (p.second < 0 ||
-            !ParseTensorSubmessage(&input, meta_.mutable_tensor())) {
+            !ParseTensorSubmessage(&input, meta_.mutable_tensor(), source)) {
           return false;
         }
         if (!input.DecrementRecursionDepthAndPopLimit(p.first)) {
@@ -267,6 +376,15 @@ bool TensorResponse::ParseFast(Source* source) {
         meta_.set_require_ack(v != 0);
         break;
       }
+      case RecvTensorResponse::kTensorContentCodecFieldNumber: {
+        uint32 v;
+        if ((wt != WIRETYPE_VARINT) || !input.ReadVarint32(&v)) return false;
+        // The contents can only be decoded on the fast path if the codec
+        // precedes them.
+        if (meta_.has_tensor()) return false;
+        meta_.set_tensor_content_codec(static_cast<TensorContentCodec>(v));
+        break;
+      }
       default: {
         // Unknown tag, so don't handle we can't handle on the fast path
         return false;
@@ -278,7 +396,8 @@ bool TensorResponse::ParseFast(Source* source) {
 }
 
 bool TensorResponse::ParseSlow(Source* source) {
-  if (!meta_.ParseFromZeroCopyStream(source->contents())) {
+  if (!meta_.ParseFromZeroCopyStream(source->contents()) ||
+      !DecodeResponseTensorContent(&meta_).ok()) {
     return false;
   }
 
@@ -298,4 +417,62 @@ bool TensorResponse::ParseSlow(Source* source) {
   return true;
 }
 
+bool EncodeTensorContent(TensorContentCodec codec, const Tensor& val,
+                         string* out) {
+  if (!DataTypeCanUseMemcpy(val.dtype())) return false;
+  const StringPiece data = val.tensor_data();
+  if (data.size() < kMinEncodedTensorBytes) return false;
+  const size_t element_size = DataTypeSize(val.dtype());
+  bool ok;
+  switch (codec) {
+    case TENSOR_CONTENT_SNAPPY:
+      ok = port::Snappy_Compress(data.data(), data.size(), out);
+      break;
+    case TENSOR_CONTENT_SHUFFLE_SNAPPY:
+      if (element_size <= 1) {
+        ok = port::Snappy_Compress(data.data(), data.size(), out);
+      } else {
+        std::unique_ptr<char[]> shuffled(new char[data.size()]);
+        ShuffleBytes(data.data(), data.size() / element_size, element_size,
+                     shuffled.get());
+        ok = port::Snappy_Compress(shuffled.get(), data.size(), out);
+      }
+      break;
+    default:
+      return false;
+  }
+  // Only worth it if at least an eighth of the bytes is saved.
+  return ok && out->size() <= data.size() - data.size() / 8;
+}
+
+bool DecodeTensorContent(TensorContentCodec codec, DataType dtype,
+                         StringPiece encoded, char* out, size_t size) {
+  size_t decoded_size;
+  if (!port::Snappy_GetUncompressedLength(encoded.data(), encoded.size(),
+                                          &decoded_size) ||
+      decoded_size != size) {
+    return false;
+  }
+  const size_t element_size = DataTypeSize(dtype);
+  switch (codec) {
+    case TENSOR_CONTENT_SNAPPY:
+      return port::Snappy_Uncompress(encoded.data(), encoded.size(), out);
+    case TENSOR_CONTENT_SHUFFLE_SNAPPY: {
+      if (element_size <= 1) {
+        return port::Snappy_Uncompress(encoded.data(), encoded.size(), out);
+      }
+      if (size % element_size != 0) return false;
+      std::unique_ptr<char[]> shuffled(new char[size]);
+      if (!port::Snappy_Uncompress(encoded.data(), encoded.size(),
+                                   shuffled.get())) {
+        return false;
+      }
+      UnshuffleBytes(shuffled.get(), size / element_size, element_size, out);
+      return true;
+    }
+    default:
+      return false;
+  }
+}
+
 }  // namespace tensorflow
@@ -64,6 +64,17 @@ class TensorResponse {
     // Ownership of the returned stream is retained by the Source and
     // should not be deleted by the caller.
     virtual ::tensorflow::protobuf::io::ZeroCopyInputStream* contents() = 0;
+
+    // If the 'size' bytes at 'data', which lie in a buffer returned by the
+    // current contents() stream, can be kept alive beyond the lifetime of the
+    // Source, returns a new TensorBuffer aliasing them. ParseFrom then uses
+    // the returned buffer as the tensor contents instead of copying them.
+    //
+    // The caller owns a reference on the returned buffer. Returns nullptr
+    // (the default) if the bytes can't be shared.
+    virtual TensorBuffer* ShareBuffer(const char* data, size_t size) {
+      return nullptr;
+    }
   };
 
   // Parse the RecvTensorResponse encoded in the data yielded by
@@ -93,11 +104,17 @@ class TensorResponse {
 
  private:
   bool ParseTensorSubmessage(protobuf::io::CodedInputStream* input,
-                             TensorProto* tensor_meta);
+                             TensorProto* tensor_meta, Source* source);
+  bool ShareTensorContent(protobuf::io::CodedInputStream* input,
+                          Source* source, DataType dtype,
+                          const TensorShape& shape, int num_bytes);
   bool ParseFast(Source* source);
   bool ParseSlow(Source* source);
 
   bool on_host_ = false;
+  // True if the tensor contents may alias the memory of the Source rather
+  // than being copied into memory from allocator_.
+  bool share_source_memory_ = false;
   DeviceBase* device_ = nullptr;
   AllocatorAttributes alloc_attrs_;
   Allocator* allocator_ = nullptr;
@@ -106,6 +123,20 @@ class TensorResponse {
   RecvTensorResponse meta_;
 };
 
+// Encodes the contents of "val" with "codec" into "*out" for sending as the
+// tensor_content of a RecvTensorResponse.  Returns false, leaving "*out"
+// unspecified, if the contents should be sent unencoded instead: the codec
+// is TENSOR_CONTENT_RAW or unavailable, "val" is too small, or encoding
+// does not save enough space.
+bool EncodeTensorContent(TensorContentCodec codec, const Tensor& val,
+                         string* out);
+
+// Decodes "encoded", the output of EncodeTensorContent() with "codec" for a
+// tensor of type "dtype", into the "size" bytes at "out".  Returns false if
+// "encoded" is corrupt or does not decode to exactly "size" bytes.
+bool DecodeTensorContent(TensorContentCodec codec, DataType dtype,
+                         StringPiece encoded, char* out, size_t size);
+
 }  // namespace tensorflow
 
 #endif  // TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_TENSOR_CODING_H_
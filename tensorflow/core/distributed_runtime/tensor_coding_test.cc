@@ -15,13 +15,16 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/tensor_coding.h"
 
+#include "tensorflow/core/framework/allocation_description.pb.h"
 #include "tensorflow/core/framework/device_attributes.pb.h"
 #include "tensorflow/core/framework/device_base.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mem.h"
 #include "tensorflow/core/platform/protobuf.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/test_benchmark.h"
@@ -156,6 +159,188 @@ TEST_F(TensorResponseTest, Simple) {
 
 TEST_F(TensorResponseTest, StringTensor) { DoTestForStrings(DT_STRING); }
 
+// A TensorBuffer aliasing memory owned by the test.
+class UnownedTensorBuffer : public TensorBuffer {
+ public:
+  UnownedTensorBuffer(const char* data, size_t size)
+      : TensorBuffer(const_cast<char*>(data)), size_(size) {}
+
+  size_t size() const override { return size_; }
+  TensorBuffer* root_buffer() override { return this; }
+  void FillAllocationDescription(AllocationDescription* proto) const override {
+    proto->set_requested_bytes(size_);
+  }
+  bool OwnsMemory() const override { return false; }
+
+ private:
+  const size_t size_;
+};
+
+// A Source that copies 'encoded' to 'offset' bytes past an aligned address,
+// and lets TensorResponse alias its memory.
+class SharingSource : public TensorResponse::Source {
+ public:
+  SharingSource(const string& encoded, int offset) : size_(encoded.size()) {
+    base_ = static_cast<char*>(port::AlignedMalloc(
+        offset + encoded.size(), Allocator::kAllocatorAlignment));
+    data_ = base_ + offset;
+    memcpy(data_, encoded.data(), encoded.size());
+  }
+  ~SharingSource() override {
+    stream_.reset();
+    port::AlignedFree(base_);
+  }
+
+  protobuf::io::ZeroCopyInputStream* contents() override {
+    stream_.reset(new protobuf::io::ArrayInputStream(data_, size_));
+    return stream_.get();
+  }
+
+  TensorBuffer* ShareBuffer(const char* data, size_t size) override {
+    return new UnownedTensorBuffer(data, size);
+  }
+
+  const char* data() const { return data_; }
+
+ private:
+  char* base_;
+  char* data_;
+  const size_t size_;
+  std::unique_ptr<protobuf::io::ArrayInputStream> stream_;
+};
+
+// Parses a 4KB float tensor whose contents start 'misalignment' bytes past an
+// aligned address, and returns whether they were aliased.
+bool ParseAndCheckAliasing(int misalignment) {
+  Tensor src(DT_FLOAT, TensorShape({1024}));
+  test::FillIota<float>(&src, 0.0f);
+  RecvTensorResponse proto;
+  proto.set_send_start_micros(123456);
+  src.AsProtoTensorContent(proto.mutable_tensor());
+  string encoded;
+  proto.AppendToString(&encoded);
+  const size_t content_offset = encoded.find(string(src.tensor_data()));
+  CHECK_NE(content_offset, string::npos);
+
+  const int alignment = Allocator::kAllocatorAlignment;
+  SharingSource source(
+      encoded,
+      (alignment - content_offset % alignment) % alignment + misalignment);
+  TensorResponse response;
+  DummyDevice cpu_device(Env::Default());
+  response.InitAlloc(&cpu_device, AllocatorAttributes());
+  TF_CHECK_OK(response.ParseFrom(&source));
+  EXPECT_EQ(response.metadata().send_start_micros(), 123456);
+  test::ExpectTensorEqual<float>(src, response.tensor());
+  return response.tensor().tensor_data().data() ==
+         source.data() + content_offset;
+}
+
+TEST_F(TensorResponseTest, SharesAlignedTensorContent) {
+  EXPECT_TRUE(ParseAndCheckAliasing(0));
+}
+
+TEST_F(TensorResponseTest, CopiesMisalignedTensorContent) {
+  EXPECT_FALSE(ParseAndCheckAliasing(1));
+}
+
+// A float tensor of "num_elems" elements, most of which are zero.
+Tensor MakeSparseFloatTensor(int num_elems) {
+  Tensor t(DT_FLOAT, TensorShape({num_elems}));
+  auto flat = t.flat<float>();
+  for (int i = 0; i < num_elems; i++) {
+    flat(i) = (i % 10 == 0) ? 0.5f + i : 0.0f;
+  }
+  return t;
+}
+
+TEST(TensorContentCodecTest, RoundTrip) {
+  for (TensorContentCodec codec :
+       {TENSOR_CONTENT_SNAPPY, TENSOR_CONTENT_SHUFFLE_SNAPPY}) {
+    Tensor src = MakeSparseFloatTensor(16384);
+    string encoded;
+    ASSERT_TRUE(EncodeTensorContent(codec, src, &encoded));
+    EXPECT_LT(encoded.size(), src.tensor_data().size() / 2);
+
+    Tensor dst(DT_FLOAT, src.shape());
+    ASSERT_TRUE(DecodeTensorContent(codec, DT_FLOAT, encoded,
+                                    const_cast<char*>(dst.tensor_data().data()),
+                                    dst.tensor_data().size()));
+    test::ExpectTensorEqual<float>(src, dst);
+    // The decoded size must match exactly.
+    EXPECT_FALSE(DecodeTensorContent(
+        codec, DT_FLOAT, encoded, const_cast<char*>(dst.tensor_data().data()),
+        dst.tensor_data().size() - 4));
+  }
+}
+
+TEST(TensorContentCodecTest, SkipsSmallAndIncompressibleTensors) {
+  string encoded;
+  EXPECT_FALSE(EncodeTensorContent(TENSOR_CONTENT_RAW,
+                                   MakeSparseFloatTensor(16384), &encoded));
+  EXPECT_FALSE(EncodeTensorContent(TENSOR_CONTENT_SNAPPY,
+                                   MakeSparseFloatTensor(16), &encoded));
+  Tensor random(DT_INT64, TensorShape({16384}));
+  random.flat<int64>().setRandom();
+  EXPECT_FALSE(EncodeTensorContent(TENSOR_CONTENT_SNAPPY, random, &encoded));
+}
+
+// Parses a response whose contents are encoded with "codec", with the codec
+// field serialized before the tensor if "codec_first" is true.
+void ParseEncodedResponse(TensorContentCodec codec, bool codec_first) {
+  Tensor src = MakeSparseFloatTensor(16384);
+  RecvTensorResponse tensor_proto;
+  tensor_proto.set_send_start_micros(123456);
+  src.AsProtoTensorContent(tensor_proto.mutable_tensor());
+  ASSERT_TRUE(EncodeTensorContent(
+      codec, src, tensor_proto.mutable_tensor()->mutable_tensor_content()));
+  RecvTensorResponse codec_proto;
+  codec_proto.set_tensor_content_codec(codec);
+  // Concatenated messages are merged when parsed.
+  string encoded;
+  if (codec_first) codec_proto.AppendToString(&encoded);
+  tensor_proto.AppendToString(&encoded);
+  if (!codec_first) codec_proto.AppendToString(&encoded);
+
+  StringSource source(&encoded, 1024);
+  TensorResponse response;
+  DummyDevice cpu_device(Env::Default());
+  response.InitAlloc(&cpu_device, AllocatorAttributes());
+  TF_ASSERT_OK(response.ParseFrom(&source));
+  EXPECT_EQ(response.metadata().send_start_micros(), 123456);
+  test::ExpectTensorEqual<float>(src, response.tensor());
+
+  RecvTensorResponse merged;
+  ASSERT_TRUE(merged.ParseFromString(encoded));
+  response.InitAlloc(&cpu_device, AllocatorAttributes());
+  TF_ASSERT_OK(response.InitFrom(&merged));
+  test::ExpectTensorEqual<float>(src, response.tensor());
+}
+
+TEST_F(TensorResponseTest, ParsesEncodedTensorContent) {
+  for (TensorContentCodec codec :
+       {TENSOR_CONTENT_SNAPPY, TENSOR_CONTENT_SHUFFLE_SNAPPY}) {
+    ParseEncodedResponse(codec, /*codec_first=*/true);
+    ParseEncodedResponse(codec, /*codec_first=*/false);
+  }
+}
+
+TEST_F(TensorResponseTest, RejectsCorruptEncodedTensorContent) {
+  Tensor src = MakeSparseFloatTensor(16384);
+  RecvTensorResponse proto;
+  src.AsProtoTensorContent(proto.mutable_tensor());
+  proto.mutable_tensor()->set_tensor_content("not snappy");
+  proto.set_tensor_content_codec(TENSOR_CONTENT_SNAPPY);
+  string encoded;
+  proto.AppendToString(&encoded);
+
+  StringSource source(&encoded, 1024);
+  TensorResponse response;
+  DummyDevice cpu_device(Env::Default());
+  response.InitAlloc(&cpu_device, AllocatorAttributes());
+  EXPECT_FALSE(response.ParseFrom(&source).ok());
+}
+
 string MakeFloatTensorTestCase(int num_elems) {
   std::vector<int8> v(num_elems);
   for (int i = 0; i < num_elems; i++) {
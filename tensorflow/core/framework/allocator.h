@@ -163,6 +163,14 @@ struct AllocatorStats {
   absl::optional<int64> bytes_reservable_limit;
 
   int64 largest_free_block_bytes;  // Largest free block's size in heap.
+  // The fraction of free reserved memory that lies outside the largest free
+  // block, within [0, 1]. Zero if the allocator does not report it.
+  double fragmentation;
+
+  // Stats for allocators that serve some requests from per-thread caches of
+  // recently freed buffers. `num_allocs` includes the cache hits.
+  int64 num_thread_cache_hits;
+  int64 num_thread_cache_misses;
 
   AllocatorStats()
       : num_allocs(0),
@@ -171,7 +179,10 @@ struct AllocatorStats {
         largest_alloc_size(0),
         bytes_reserved(0),
         peak_bytes_reserved(0),
-        largest_free_block_bytes(0) {}
+        largest_free_block_bytes(0),
+        fragmentation(0),
+        num_thread_cache_hits(0),
+        num_thread_cache_misses(0) {}
 
   std::string DebugString() const;
 };
@@ -286,6 +297,12 @@ class Allocator {
   virtual void ClearStats() {}
 
   virtual void SetSafeFrontier(uint64 count) {}
+
+  // Called when a step that allocates from this allocator begins and ends.
+  // Allocators that plan memory from the allocations of previous steps use
+  // these to find step boundaries.
+  virtual void BeginStep(int64 step_id) {}
+  virtual void EndStep(int64 step_id) {}
 };
 
 // An implementation of Allocator that delegates all calls to another Allocator.
@@ -145,7 +145,7 @@ string CollectiveParams::ToString() const {
   strings::StrAppend(&v, " ", task.ToString());
   strings::StrAppend(&v, " default_rank=", default_rank,
                      " is_source=", is_source, " source_rank=", source_rank,
-                     " subdiv_rank={");
+                     " launch_priority=", launch_priority, " subdiv_rank={");
   for (const auto& r : subdiv_rank) {
     strings::StrAppend(&v, r, ",");
   }
@@ -144,6 +144,13 @@ struct CollectiveParams {
   std::vector<int> subdiv_rank;
   std::unique_ptr<OpKernel> merge_op;  // reduction only
   std::unique_ptr<OpKernel> final_op;  // reduction only
+  // Cast chunks to and from a narrower data type for transfer between
+  // devices.  Both null if values are sent uncompressed.  Reduction only.
+  std::unique_ptr<OpKernel> encode_op;
+  std::unique_ptr<OpKernel> decode_op;
+  // Launch order among the reductions of a step, smaller values first.
+  // Negative if the launch is not ordered.  Reduction only.
+  int64 launch_priority = -1;
   string ToString() const;
 };
 
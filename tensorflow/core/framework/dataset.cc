@@ -348,7 +348,8 @@ Status IteratorBase::InitializeBase(IteratorContext* ctx,
     auto factory = [ctx, this](model::Node::Args args) {
       return CreateNode(ctx, std::move(args));
     };
-    model->AddNode(std::move(factory), prefix(), parent->model_node(), &node_);
+    model->AddNode(std::move(factory), prefix(),
+                   parent ? parent->model_node() : nullptr, &node_);
     cleanup_fns_.push_back([this, model]() { model->RemoveNode(node_); });
   }
   return Status::OK();
@@ -505,6 +506,14 @@ string DatasetBaseIterator::BuildTraceMeName() {
   if (parent_) {
     strings::StrAppend(&result, ",parent_id=", parent_id_);
   }
+  // The occupancy of the iterator's buffer (if any) when GetNext is called,
+  // which tells whether the time spent in GetNext is spent waiting for it, and
+  // the time GetNext calls have waited for the buffer so far.
+  if (node_) {
+    strings::StrAppend(&result, ",buffered_elements=",
+                       node_->buffered_elements(), ",wait_time=",
+                       node_->wait_time());
+  }
 
   TraceMeMetadata metadata = GetTraceMeMetadata();
   for (const auto& pair : metadata) {
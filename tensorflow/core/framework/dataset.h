@@ -998,6 +998,26 @@ class DatasetBaseIterator : public IteratorBase {
     }
   }
 
+  // When modeling is enabled, this method records the fact that a consumer of
+  // this iterator has stopped work to wait for an element of its buffer.
+  void RecordWaitStart(IteratorContext* ctx) {
+    if (collect_resource_usage(ctx)) {
+      int64 now_nanos = EnvTime::NowNanos();
+      node_->record_stop(now_nanos);
+      node_->record_wait_start(now_nanos);
+    }
+  }
+
+  // When modeling is enabled, this method records the fact that a consumer of
+  // this iterator has stopped waiting and resumed work.
+  void RecordWaitStop(IteratorContext* ctx) {
+    if (collect_resource_usage(ctx)) {
+      int64 now_nanos = EnvTime::NowNanos();
+      node_->record_wait_stop(now_nanos);
+      node_->record_start(now_nanos);
+    }
+  }
+
  private:
   bool collect_resource_usage(IteratorContext* ctx) {
     auto model = ctx->model();
@@ -97,11 +97,27 @@ void LocalRendezvous::ItemQueue::push_back(Item* item) {
 }
 
 LocalRendezvous::~LocalRendezvous() {
-  if (!table_.empty()) {
-    StartAbort(errors::Cancelled("LocalRendezvous deleted"));
+  for (Shard& shard : shards_) {
+    bool empty;
+    {
+      mutex_lock l(shard.mu);
+      empty = shard.table.empty();
+    }
+    if (!empty) {
+      StartAbort(errors::Cancelled("LocalRendezvous deleted"));
+      return;
+    }
   }
 }
 
+Status LocalRendezvous::AbortStatus() {
+  if (TF_PREDICT_TRUE(!aborted_.load(std::memory_order_acquire))) {
+    return Status::OK();
+  }
+  mutex_lock l(status_mu_);
+  return status_;
+}
+
 namespace {
 uint64 KeyHash(const StringPiece& k) { return Hash64(k.data(), k.size()); }
 }  // namespace
@@ -122,15 +138,16 @@ Status LocalRendezvous::Send(const Rendezvous::ParsedKey& key,
         ->IncrementBy(1);
   }
 
-  mu_.lock();
-  if (!status_.ok()) {
+  Shard* shard = &shards_[ShardIndex(key_hash)];
+  shard->mu.lock();
+  Status abort_status = AbortStatus();
+  if (!abort_status.ok()) {
     // Rendezvous has been aborted.
-    Status s = status_;
-    mu_.unlock();
-    return s;
+    shard->mu.unlock();
+    return abort_status;
   }
 
-  ItemQueue* queue = &table_[key_hash];
+  ItemQueue* queue = &shard->table[key_hash];
   if (queue->head == nullptr || queue->head->type == Item::kSend) {
     // There is no waiter for this message. Append the message
     // into the queue. The waiter will pick it up when arrives.
@@ -139,7 +156,7 @@ Status LocalRendezvous::Send(const Rendezvous::ParsedKey& key,
     // the lock.
     DVLOG(2) << "Enqueue Send Item (key:" << key.FullKey() << "). ";
     queue->push_back(new Item(send_args, val, is_dead));
-    mu_.unlock();
+    shard->mu.unlock();
     return Status::OK();
   }
 
@@ -150,11 +167,11 @@ Status LocalRendezvous::Send(const Rendezvous::ParsedKey& key,
   // Delete the queue when the last element has been consumed.
   if (item->next == nullptr) {
     DVLOG(2) << "Clean up Send/Recv queue (key:" << key.FullKey() << "). ";
-    table_.erase(key_hash);
+    shard->table.erase(key_hash);
   } else {
     queue->head = item->next;
   }
-  mu_.unlock();
+  shard->mu.unlock();
 
   // Notify the waiter by invoking its done closure, outside the
   // lock.
@@ -170,16 +187,17 @@ void LocalRendezvous::RecvAsync(const Rendezvous::ParsedKey& key,
   uint64 key_hash = KeyHash(key.FullKey());
   DVLOG(2) << "Recv " << this << " " << key_hash << " " << key.FullKey();
 
-  mu_.lock();
-  if (!status_.ok()) {
+  Shard* shard = &shards_[ShardIndex(key_hash)];
+  shard->mu.lock();
+  Status abort_status = AbortStatus();
+  if (!abort_status.ok()) {
     // Rendezvous has been aborted.
-    Status s = status_;
-    mu_.unlock();
-    done(s, Rendezvous::Args(), recv_args, Tensor(), false);
+    shard->mu.unlock();
+    done(abort_status, Rendezvous::Args(), recv_args, Tensor(), false);
     return;
   }
 
-  ItemQueue* queue = &table_[key_hash];
+  ItemQueue* queue = &shard->table[key_hash];
   if (queue->head == nullptr || queue->head->type == Item::kRecv) {
     // There is no message to pick up.
     // Only recv-related fields need to be filled.
@@ -189,10 +207,11 @@ void LocalRendezvous::RecvAsync(const Rendezvous::ParsedKey& key,
     if (cm != nullptr) {
       token = cm->get_cancellation_token();
       already_cancelled = !cm->RegisterCallback(token, [this, token, key_hash] {
+        Shard* shard = &shards_[ShardIndex(key_hash)];
         Item* item = nullptr;
         {
-          mutex_lock l(mu_);
-          ItemQueue* queue = &table_[key_hash];
+          mutex_lock l(shard->mu);
+          ItemQueue* queue = &shard->table[key_hash];
           // Find an item in the queue with a cancellation token that matches
           // `token`, and remove it.
           if (queue->head != nullptr && queue->head->type == Item::kRecv) {
@@ -203,7 +222,7 @@ void LocalRendezvous::RecvAsync(const Rendezvous::ParsedKey& key,
                 if (queue->head->next == nullptr) {
                   // We have a single-element queue, so we can erase it from
                   // the table.
-                  table_.erase(key_hash);
+                  shard->table.erase(key_hash);
                 } else {
                   // Remove the current item from the queue.
                   if (curr == queue->head) {
@@ -233,7 +252,7 @@ void LocalRendezvous::RecvAsync(const Rendezvous::ParsedKey& key,
       });
     }
     if (already_cancelled) {
-      mu_.unlock();
+      shard->mu.unlock();
       done(StatusGroup::MakeDerived(
                errors::Cancelled("RecvAsync is cancelled.")),
            Rendezvous::Args(), recv_args, Tensor(), /*is_dead=*/false);
@@ -261,7 +280,7 @@ void LocalRendezvous::RecvAsync(const Rendezvous::ParsedKey& key,
       queue->push_back(new Item(recv_args, std::move(done), token));
     }
 
-    mu_.unlock();
+    shard->mu.unlock();
     return;
   }
 
@@ -273,11 +292,11 @@ void LocalRendezvous::RecvAsync(const Rendezvous::ParsedKey& key,
   // Delete the queue when the last element has been consumed.
   if (item->next == nullptr) {
     DVLOG(2) << "Clean up Send/Recv queue (key:" << key.FullKey() << "). ";
-    table_.erase(key_hash);
+    shard->table.erase(key_hash);
   } else {
     queue->head = item->next;
   }
-  mu_.unlock();
+  shard->mu.unlock();
 
   // Invoke done() without holding the table lock.
   DCHECK_EQ(item->type, Item::kSend);
@@ -288,22 +307,28 @@ void LocalRendezvous::RecvAsync(const Rendezvous::ParsedKey& key,
 
 void LocalRendezvous::StartAbort(const Status& status) {
   CHECK(!status.ok());
-  Table table;
   {
-    mutex_lock l(mu_);
+    mutex_lock l(status_mu_);
     status_.Update(status);
-    table_.swap(table);
   }
-  for (auto& p : table) {
-    Item* item = p.second.head;
-    while (item != nullptr) {
-      if (item->type == Item::kRecv) {
-        (*item->recv_state.waiter)(status, Rendezvous::Args(),
-                                   Rendezvous::Args(), Tensor(), false);
+  aborted_.store(true, std::memory_order_release);
+  for (Shard& shard : shards_) {
+    Table table;
+    {
+      mutex_lock l(shard.mu);
+      shard.table.swap(table);
+    }
+    for (auto& p : table) {
+      Item* item = p.second.head;
+      while (item != nullptr) {
+        if (item->type == Item::kRecv) {
+          (*item->recv_state.waiter)(status, Rendezvous::Args(),
+                                     Rendezvous::Args(), Tensor(), false);
+        }
+        Item* to_delete = item;
+        item = item->next;
+        delete to_delete;
       }
-      Item* to_delete = item;
-      item = item->next;
-      delete to_delete;
     }
   }
 }
@@ -16,6 +16,8 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_FRAMEWORK_LOCAL_RENDEZVOUS_H_
 #define TENSORFLOW_CORE_FRAMEWORK_LOCAL_RENDEZVOUS_H_
 
+#include <atomic>
+
 #include "tensorflow/core/framework/rendezvous.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/lib/core/status.h"
@@ -62,10 +64,34 @@ class LocalRendezvous {
 
   typedef gtl::FlatMap<uint64, ItemQueue> Table;
 
-  // TODO(zhifengc): shard table_.
-  mutex mu_;
-  Table table_ TF_GUARDED_BY(mu_);
-  Status status_ TF_GUARDED_BY(mu_);
+  // The table is split into `kNumShards` independently locked shards, chosen
+  // by the high bits of the key hash, so that Send() and RecvAsync() calls
+  // for unrelated keys do not contend on a single mutex.
+  static constexpr int kNumShardBits = 3;
+  static constexpr int kNumShards = 1 << kNumShardBits;
+
+  struct Shard {
+    mutex mu;
+    Table table TF_GUARDED_BY(mu);
+  };
+
+  static int ShardIndex(uint64 key_hash) {
+    return static_cast<int>(key_hash >> (64 - kNumShardBits));
+  }
+
+  // Returns the abort status if StartAbort() has been called, or OK
+  // otherwise. Only reads `status_` under `status_mu_` once `aborted_` is set.
+  Status AbortStatus();
+
+  Shard shards_[kNumShards];
+
+  // Set by StartAbort() before it drains each shard. Callers must read it
+  // while holding the lock of the shard they intend to modify: StartAbort()
+  // takes every shard lock after setting it, so a caller that observes false
+  // is guaranteed that its update will be seen (and aborted) by StartAbort().
+  std::atomic<bool> aborted_{false};
+  mutex status_mu_;
+  Status status_ TF_GUARDED_BY(status_mu_);
 
   TF_DISALLOW_COPY_AND_ASSIGN(LocalRendezvous);
 };
@@ -16,6 +16,7 @@ limitations under the License.
 #include "tensorflow/core/framework/metrics.h"
 #include "tensorflow/core/lib/monitoring/counter.h"
 #include "tensorflow/core/lib/monitoring/sampler.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 
 namespace tensorflow {
 namespace metrics {
@@ -108,6 +109,15 @@ auto* tf_data_getnext_time_between_msecs_histogram =
                                         200., 225., 250., 300., 350., 400.,
                                         450., 500., 1000., 10000.})});
 
+auto* tf_data_multi_device_iterator_bytes_counter = monitoring::Counter<1>::New(
+    "/tensorflow/data/multi_device_iterator_bytes",
+    "The number of bytes a tf.data MultiDeviceIterator produced for a device.",
+    "device");
+
+auto* tf_data_file_handle_cache_counter = monitoring::Counter<1>::New(
+    "/tensorflow/data/file_handle_cache",
+    "The number of lookups in the tf.data file handle cache.", "result");
+
 auto* tf_data_optimization_counter = monitoring::Counter<1>::New(
     "/tensorflow/data/optimization", "tf.data optimization", "name");
 
@@ -140,6 +150,13 @@ auto* build_graph_time_usecs = monitoring::Counter<0>::New(
     "spent optimizing the graph with Grappler, and time spent pruning the "
     "sub-graph.");
 
+auto* graph_optimization_cache_counter = monitoring::Counter<1>::New(
+    "/tensorflow/core/graph_optimization_cache",
+    "The number of client graph builds that found (\"hit\") or did not find "
+    "(\"miss\") an already-optimized graph for the same set of feeds, "
+    "fetches and targets.",
+    "result");
+
 auto* xla_compilations = monitoring::Counter<0>::New(
     "/tensorflow/core/xla_compilations",
     "The number of XLA compilations used to collect "
@@ -158,6 +175,53 @@ auto* bfc_allocator_delay =
                                 "The total time spent running each graph "
                                 "optimization pass in microseconds.");
 
+auto* step_breakdown_usecs = monitoring::Counter<1>::New(
+    "/tensorflow/core/step_breakdown_usecs",
+    "The total time the executor spent on the nodes of graph runs, in "
+    "microseconds, by component.",
+    "component");
+
+auto* step_breakdown_usecs_histogram = monitoring::Sampler<1>::New(
+    {"/tensorflow/core/step_breakdown_usecs_histogram",
+     "The time the executor spent on the nodes of a graph run, in "
+     "microseconds, by component.",
+     "component"},
+    // Power of 2 with bucket count 30 (> 8 minutes)
+    {monitoring::Buckets::Exponential(1, 2, 30)});
+
+auto* step_bytes_transferred = monitoring::Sampler<0>::New(
+    {"/tensorflow/core/step_bytes_transferred",
+     "The bytes of the tensors received by the Recv kernels of a graph run."},
+    // Power of 4 with bucket count 20 (> 256GB)
+    {monitoring::Buckets::Exponential(1, 4, 20)});
+
+thread_local uint64 thread_allocation_nsecs = 0;
+
+auto* run_handler_queueing_delay_usecs_histogram = monitoring::Sampler<1>::New(
+    {"/tensorflow/core/run_handler_queueing_delay_usecs_histogram",
+     "The time inter-op closures scheduled through a RunHandler spent queued "
+     "before running, in microseconds.",
+     "priority"},
+    // Power of 2 with bucket count 24 (> 8 seconds)
+    {monitoring::Buckets::Exponential(1, 2, 24)});
+
+auto* run_handler_wait_usecs_histogram = monitoring::Sampler<1>::New(
+    {"/tensorflow/core/run_handler_wait_usecs_histogram",
+     "The time RunHandlerPool::Get() waited for a free handler, in "
+     "microseconds.",
+     "priority"},
+    // Power of 2 with bucket count 24 (> 8 seconds)
+    {monitoring::Buckets::Exponential(1, 2, 24)});
+
+auto* embedding_cache_lookups = monitoring::Counter<1>::New(
+    "/tensorflow/core/embedding_cache/lookups",
+    "The number of ids looked up in device embedding caches.", "result");
+
+auto* embedding_cache_writebacks = monitoring::Counter<0>::New(
+    "/tensorflow/core/embedding_cache/writebacks",
+    "The number of rows evicted from device embedding caches and written "
+    "back to their host tables.");
+
 }  // namespace
 
 void RecordTFDataAutotune(const string& name) {
@@ -184,6 +248,17 @@ void RecordTFDataBytesFetched(int64 num_bytes) {
   tf_data_bytes_fetched_counter->GetCell()->IncrementBy(num_bytes);
 }
 
+void RecordTFDataMultiDeviceIteratorBytes(const string& device,
+                                          int64 num_bytes) {
+  tf_data_multi_device_iterator_bytes_counter->GetCell(device)->IncrementBy(
+      num_bytes);
+}
+
+void RecordTFDataFileHandleCacheLookup(bool hit) {
+  tf_data_file_handle_cache_counter->GetCell(hit ? "hit" : "miss")
+      ->IncrementBy(1);
+}
+
 void RecordTFDataExperiment(const string& name) {
   tf_data_experiment_counter->GetCell(name)->IncrementBy(1);
 }
@@ -252,6 +327,11 @@ void UpdateGraphExecTime(const uint64 running_time_usecs) {
   }
 }
 
+monitoring::CounterCell* GetGraphOptimizationCacheCounter(
+    const string& result) {
+  return graph_optimization_cache_counter->GetCell(result);
+}
+
 void UpdateGraphOptimizationPassTime(const string& pass_name,
                                      const uint64 running_time_usecs) {
   if (running_time_usecs > 0) {
@@ -295,12 +375,68 @@ void UpdateBfcAllocatorDelayTime(const uint64 delay_usecs) {
   }
 }
 
+void RecordStepBreakdown(const StepBreakdown& breakdown) {
+  struct ComponentCells {
+    monitoring::CounterCell* total;
+    monitoring::SamplerCell* histogram;
+  };
+  auto component_cells = [](const char* component) {
+    return ComponentCells{step_breakdown_usecs->GetCell(component),
+                          step_breakdown_usecs_histogram->GetCell(component)};
+  };
+  static const ComponentCells scheduling_delay_cells =
+      component_cells("scheduling_delay");
+  static const ComponentCells compute_cells = component_cells("compute");
+  static const ComponentCells rendezvous_wait_cells =
+      component_cells("rendezvous_wait");
+  static const ComponentCells allocator_cells = component_cells("allocator");
+  static const ComponentCells input_wait_cells = component_cells("input_wait");
+  static auto* step_bytes_transferred_cell = step_bytes_transferred->GetCell();
+
+  auto record = [](const ComponentCells& cells, uint64 usecs) {
+    cells.total->IncrementBy(usecs);
+    cells.histogram->Add(usecs);
+  };
+  record(scheduling_delay_cells, breakdown.scheduling_delay_usecs);
+  record(compute_cells, breakdown.compute_usecs);
+  record(rendezvous_wait_cells, breakdown.rendezvous_wait_usecs);
+  record(allocator_cells, breakdown.allocator_usecs);
+  record(input_wait_cells, breakdown.input_wait_usecs);
+  step_bytes_transferred_cell->Add(breakdown.bytes_transferred);
+}
+
+void AddThreadAllocationTime(uint64 nsecs) { thread_allocation_nsecs += nsecs; }
+
+uint64 GetThreadAllocationTime() { return thread_allocation_nsecs; }
+
+monitoring::SamplerCell* GetRunHandlerQueueingDelayCell(int64 priority) {
+  return run_handler_queueing_delay_usecs_histogram->GetCell(
+      strings::StrCat(priority));
+}
+
+void RecordRunHandlerWaitTime(int64 priority, uint64 wait_usecs) {
+  run_handler_wait_usecs_histogram->GetCell(strings::StrCat(priority))
+      ->Add(wait_usecs);
+}
+
 void IncrementMLIRImportFailureCount() {
   static auto* mlir_import_failure_count_cell =
       mlir_import_failure_count->GetCell();
   mlir_import_failure_count_cell->IncrementBy(1);
 }
 
+void RecordEmbeddingCacheLookups(int64 hits, int64 misses) {
+  static auto* hit_cell = embedding_cache_lookups->GetCell("hit");
+  static auto* miss_cell = embedding_cache_lookups->GetCell("miss");
+  hit_cell->IncrementBy(hits);
+  miss_cell->IncrementBy(misses);
+}
+
+void RecordEmbeddingCacheWritebacks(int64 num_rows) {
+  static auto* writebacks_cell = embedding_cache_writebacks->GetCell();
+  writebacks_cell->IncrementBy(num_rows);
+}
+
 void RecordUnusedOutput(const string& op_name) {
   graph_unused_outputs->GetCell(op_name)->IncrementBy(1);
 }
@@ -17,6 +17,7 @@ limitations under the License.
 #define TENSORFLOW_CORE_FRAMEWORK_METRICS_H_
 
 #include "tensorflow/core/lib/monitoring/counter.h"
+#include "tensorflow/core/lib/monitoring/sampler.h"
 #include "tensorflow/core/platform/types.h"
 
 namespace tensorflow {
@@ -56,6 +57,17 @@ monitoring::CounterCell* GetTFDataElementsCounter(const string& name);
 // Records the number of bytes fetched from tf.data.Dataset iterator.
 void RecordTFDataBytesFetched(int64 num_bytes);
 
+// Records the number of bytes a tf.data MultiDeviceIterator produced for a
+// device.
+//
+// The `device` argument is the name of the device.
+void RecordTFDataMultiDeviceIteratorBytes(const string& device,
+                                          int64 num_bytes);
+
+// Records a lookup in the tf.data file handle cache, and whether it found an
+// open handle.
+void RecordTFDataFileHandleCacheLookup(bool hit);
+
 // Records the number of times tf.data experiment is applied to input pipelines.
 void RecordTFDataExperiment(const string& name);
 
@@ -114,6 +126,12 @@ void RecordUnusedOutput(const string& op_name);
 // TODO(jtkeeling): Should we record building/optimizing tf.functions?
 void UpdateGraphBuildTime(const uint64 running_time_usecs);
 
+// Returns a counter that can be used to record lookups in the cache of
+// Grappler-optimized graphs kept by GraphExecutionState.
+//
+// The `result` argument is either "hit" or "miss".
+monitoring::CounterCell* GetGraphOptimizationCacheCounter(const string& result);
+
 // Updates the metrics stored about graph optimizations.
 void UpdateGraphOptimizationPassTime(const string& pass_name,
                                      const uint64 running_time_usecs);
@@ -126,6 +144,54 @@ void UpdateXlaCompilationTime(const uint64 compilation_time_usecs);
 // Updates the metrics stored about time BFC allocator spents during delay.
 void UpdateBfcAllocatorDelayTime(const uint64 delay_usecs);
 
+// The time the executor spent on the nodes of one run of a graph, i.e. on one
+// graph partition for one step, broken down by what the nodes were doing. The
+// times are summed over the nodes, so they can exceed the wall-clock time of
+// the run when nodes run in parallel.
+struct StepBreakdown {
+  // Time between a node becoming ready and the executor processing it.
+  uint64 scheduling_delay_usecs = 0;
+  // Time spent in the kernels, except for the components below.
+  uint64 compute_usecs = 0;
+  // Time spent in the Send and Recv kernels, waiting for tensors.
+  uint64 rendezvous_wait_usecs = 0;
+  // Time the kernels spent in BFCAllocator::AllocateRaw().
+  uint64 allocator_usecs = 0;
+  // Time spent waiting for the next element of tf.data iterators.
+  uint64 input_wait_usecs = 0;
+  // Bytes of the tensors received by the Recv kernels.
+  uint64 bytes_transferred = 0;
+};
+
+// Records the breakdown of one run of a graph by the executor.
+void RecordStepBreakdown(const StepBreakdown& breakdown);
+
+// Adds `nsecs` to the time the calling thread spent allocating memory, which
+// lets the executor tell allocation apart from the compute time of kernels.
+void AddThreadAllocationTime(uint64 nsecs);
+
+// Returns the time, in nanoseconds, the calling thread spent allocating memory
+// since it started.
+uint64 GetThreadAllocationTime();
+
+// Returns a sampler cell that can be used to record the time, in microseconds,
+// that inter-op closures scheduled through a RunHandler spend queued before
+// they start running.
+//
+// The `priority` argument is the RunHandlerPoolOptions priority of the request.
+monitoring::SamplerCell* GetRunHandlerQueueingDelayCell(int64 priority);
+
+// Records the time, in microseconds, that RunHandlerPool::Get() waited for a
+// free handler for a request with the given `priority`.
+void RecordRunHandlerWaitTime(int64 priority, uint64 wait_usecs);
+
+// Records the ids an embedding cache found in device memory and the ids it
+// fetched from its host table.
+void RecordEmbeddingCacheLookups(int64 hits, int64 misses);
+
+// Records rows an embedding cache evicted and wrote back to its host table.
+void RecordEmbeddingCacheWritebacks(int64 num_rows);
+
 // Increment the number of jobs that failed during import to mlir.
 void IncrementMLIRImportFailureCount();
 
@@ -28,6 +28,14 @@ namespace {
 // Wrapper for the square function to reduce verbosity.
 inline double Square(double x) { return x * x; }
 
+// The number of live models, and the sums of the bytes and the parallelism
+// reserved by them. Concurrent input pipelines share the memory and cores of
+// the host, so each model leaves the resources reserved by the others out of
+// its budgets.
+std::atomic<int64> num_models(0);
+std::atomic<int64> total_ram_reserved(0);
+std::atomic<int64> total_cpu_reserved(0);
+
 // The first input of InterleaveMany corresponds to the input dataset whose
 // elements are used to create the (derived) input datasets whose elements are
 // interleaved as output.
@@ -722,6 +730,7 @@ class Unknown : public Node {
 }  // namespace
 
 thread_local int64 Node::work_start_;
+thread_local int64 Node::wait_start_;
 
 std::shared_ptr<Parameter> MakeParameter(const string& name,
                                          std::shared_ptr<SharedState> state,
@@ -1166,6 +1175,7 @@ void Node::DebugStringHelper(absl::flat_hash_map<string, string>* debug_strings)
                      "\n");
   strings::StrAppend(&result, "  processing_time=", processing_time_.load(),
                      "\n");
+  strings::StrAppend(&result, "  wait_time=", wait_time_.load(), "\n");
   strings::StrAppend(&result, "  num_elements=", num_elements_.load(), "\n");
   string inputs;
   for (auto& input : inputs_) {
@@ -1195,6 +1205,7 @@ std::shared_ptr<Node> Node::SnapshotHelper(
     cloned_current->num_elements_.store(num_elements_);
     cloned_current->record_metrics_.store(false);
     cloned_current->processing_time_.store(processing_time_);
+    cloned_current->wait_time_.store(wait_time_);
     mutex_lock l2(cloned_current->mu_);
     cloned_current->parameters_ = parameters_;
   }
@@ -1249,6 +1260,14 @@ void Node::TotalMaximumBufferedBytesHelper(
   total_bytes->insert(std::make_pair(long_name(), result));
 }
 
+Model::Model() : collect_resource_usage_(false) { ++num_models; }
+
+Model::~Model() {
+  --num_models;
+  total_ram_reserved -= ram_reserved_;
+  total_cpu_reserved -= cpu_reserved_;
+}
+
 void Model::AddNode(Node::Factory factory, const string& name,
                     std::shared_ptr<Node> parent,
                     std::shared_ptr<Node>* out_node) {
@@ -1290,6 +1309,10 @@ void Model::FlushMetrics() {
 
 void Model::Optimize(AutotuneAlgorithm algorithm, int64 cpu_budget,
                      int64 ram_budget, double model_input_time) {
+  ram_budget -= total_ram_reserved - ram_reserved_;
+  const int64 even_cpu_share = std::max<int64>(1, cpu_budget / num_models);
+  cpu_budget = std::max(even_cpu_share,
+                        cpu_budget - (total_cpu_reserved - cpu_reserved_));
   switch (algorithm) {
     case AutotuneAlgorithm::HILL_CLIMB:
       OptimizeHillClimb(cpu_budget, ram_budget, model_input_time);
@@ -1369,7 +1392,16 @@ void Model::OptimizeGradientDescent(int64 cpu_budget, int64 ram_budget,
   double output_time = 0;
   double new_output_time;
   double new_value;
+  absl::flat_hash_map<string, double> previous_values;
   for (int i = 0; i < kMaxIterations; ++i) {
+    // We terminate once the worst-case total buffer size exceeds the memory
+    // budget, going back to the last parameters that kept within it.
+    if (TotalMaximumBufferedBytes(snapshot) > ram_budget) {
+      for (auto& pair : previous_values) {
+        parameters[pair.first]->value = pair.second;
+      }
+      break;
+    }
     absl::flat_hash_map<string, double> gradients;
     new_output_time = OutputTime(snapshot, model_input_time, &gradients);
     int64 model_parallelism = 0;
@@ -1377,11 +1409,9 @@ void Model::OptimizeGradientDescent(int64 cpu_budget, int64 ram_budget,
       model_parallelism += std::round(pair.second->value);
     }
     // We terminate once the improvement of the output latency is too small or
-    // the essential transformations' parallelism reaches the CPU budget or the
-    // worst-case total buffer size exceeds the memory budget.
+    // the essential transformations' parallelism reaches the CPU budget.
     if (std::abs(output_time - new_output_time) < kOptimizationPrecision ||
-        model_parallelism > cpu_budget ||
-        TotalMaximumBufferedBytes(snapshot) > ram_budget) {
+        model_parallelism > cpu_budget) {
       break;
     }
     double max_abs_derivative = 1.0;
@@ -1392,6 +1422,7 @@ void Model::OptimizeGradientDescent(int64 cpu_budget, int64 ram_budget,
       }
     }
     for (auto& pair : parameters) {
+      previous_values[pair.first] = pair.second->value;
       new_value = pair.second->value -
                   kDescentStep * gradients[pair.first] / max_abs_derivative;
       // Projection on a feasible interval.
@@ -1407,7 +1438,13 @@ void Model::OptimizeGradientDescent(int64 cpu_budget, int64 ram_budget,
   }
   VLOG(2) << "Number of tunable parameters: " << parameters.size();
   for (auto& pair : parameters) {
-    pair.second->value = std::round(pair.second->value);
+    // Round down where rounding to nearest could go over the memory budget.
+    const double value = pair.second->value;
+    pair.second->value = std::round(value);
+    if (pair.second->value > value &&
+        TotalMaximumBufferedBytes(snapshot) > ram_budget) {
+      pair.second->value = std::floor(value);
+    }
     auto& parameter = pair.second;
     VLOG(2) << "Setting tunable parameter " << pair.first << " to "
             << parameter->value;
@@ -1415,6 +1452,7 @@ void Model::OptimizeGradientDescent(int64 cpu_budget, int64 ram_budget,
     parameter->state->value = parameter->value;
     parameter->state->cond_var->notify_all();
   }
+  ReserveResources(snapshot, parameters);
 }
 
 void Model::OptimizeHillClimb(int64 cpu_budget, int64 ram_budget,
@@ -1427,6 +1465,7 @@ void Model::OptimizeHillClimb(int64 cpu_budget, int64 ram_budget,
   VLOG(2) << "Starting optimization of tunable parameters with HillClimb";
   const double processing_time = TotalProcessingTime(snapshot);
   auto parameters = CollectTunableParameters(snapshot);
+  auto essential_parameters = CollectEssentialParallelism(snapshot, parameters);
   // We add the number of model's buffered bytes because it is excluded from the
   // memory budget, but it is included in the maximum number of buffered bytes.
   ram_budget += TotalBufferedBytes(snapshot);
@@ -1447,17 +1486,31 @@ void Model::OptimizeHillClimb(int64 cpu_budget, int64 ram_budget,
         break;
       }
     }
-    if (output_time < processing_time / cpu_budget || all_max ||
-        TotalMaximumBufferedBytes(snapshot) > ram_budget) {
+    if (output_time < processing_time / cpu_budget || all_max) {
       break;
     }
+    int64 model_parallelism = 0;
+    for (auto& pair : essential_parameters) {
+      model_parallelism += std::round(pair.second->value);
+    }
     double best_delta = -1.0L;
     Parameter* best_parameter = nullptr;
+    bool over_budget = false;
     for (auto& pair : parameters) {
       if (pair.second->value == pair.second->max) {
         continue;
       }
+      if (model_parallelism >= cpu_budget &&
+          essential_parameters.contains(pair.first)) {
+        over_budget = true;
+        continue;
+      }
       pair.second->value++;
+      if (TotalMaximumBufferedBytes(snapshot) > ram_budget) {
+        over_budget = true;
+        pair.second->value--;
+        continue;
+      }
       double new_output_time =
           OutputTime(snapshot, model_input_time, /*gradients=*/nullptr);
       double delta = output_time - new_output_time;
@@ -1468,6 +1521,13 @@ void Model::OptimizeHillClimb(int64 cpu_budget, int64 ram_budget,
       }
       pair.second->value--;
     }
+    if (!best_parameter && over_budget) {
+      VLOG(2) << "Increasing any tunable parameter further would exceed the "
+                 "CPU budget of "
+              << cpu_budget << " or the memory budget of " << ram_budget
+              << " bytes.";
+      break;
+    }
     if (!best_parameter) {
       VLOG(2) << "Failed to find a tunable parameter that would decrease the "
                  "output time. This means that the autotuning optimization got "
@@ -1486,6 +1546,23 @@ void Model::OptimizeHillClimb(int64 cpu_budget, int64 ram_budget,
     parameter->state->value = parameter->value;
     parameter->state->cond_var->notify_all();
   }
+  ReserveResources(snapshot, parameters);
+}
+
+void Model::ReserveResources(
+    std::shared_ptr<Node> snapshot,
+    const absl::flat_hash_map<string, std::shared_ptr<Parameter>>&
+        parameters) {
+  const int64 ram_reserved = std::max<int64>(
+      0, TotalMaximumBufferedBytes(snapshot) - TotalBufferedBytes(snapshot));
+  total_ram_reserved += ram_reserved - ram_reserved_.exchange(ram_reserved);
+  int64 cpu_reserved = 0;
+  for (auto& pair : parameters) {
+    if (pair.second->name == kParallelism) {
+      cpu_reserved += std::round(pair.second->value);
+    }
+  }
+  total_cpu_reserved += cpu_reserved - cpu_reserved_.exchange(cpu_reserved);
 }
 
 double Model::OutputTime(std::shared_ptr<Node> node, double model_input_time,
@@ -146,6 +146,7 @@ class Node {
         bytes_produced_(0),
         num_elements_(0),
         processing_time_(0),
+        wait_time_(0),
         record_metrics_(true),
         metrics_(name_),
         output_(args.output.get()) {}
@@ -249,6 +250,10 @@ class Node {
     return processing_time_;
   }
 
+  // Returns the aggregate time node threads have waited for elements of the
+  // node's buffer, which is not part of the processing time.
+  int64 wait_time() const TF_LOCKS_EXCLUDED(mu_) { return wait_time_; }
+
   // Records that the node consumed the given number of bytes.
   void record_bytes_consumed(int64 num_bytes) { bytes_consumed_ += num_bytes; }
 
@@ -283,6 +288,25 @@ class Node {
     }
   }
 
+  // Records that a node thread has started waiting for an element of the
+  // node's buffer.
+  void record_wait_start(int64 time_nanos) TF_LOCKS_EXCLUDED(mu_) {
+    DCHECK_EQ(wait_start_, 0);
+    wait_start_ = time_nanos;
+  }
+
+  // Records that a node thread has stopped waiting for an element of the
+  // node's buffer.
+  void record_wait_stop(int64 time_nanos) TF_LOCKS_EXCLUDED(mu_) {
+    if (wait_start_ != 0) {
+      wait_time_ += time_nanos - wait_start_;
+      wait_start_ = 0;
+    } else {
+      VLOG(1) << "Encountered a wait stop event without a matching start "
+                 "event.";
+    }
+  }
+
   // Removes an input.
   void remove_input(std::shared_ptr<Node> input) TF_LOCKS_EXCLUDED(mu_) {
     mutex_lock l(mu_);
@@ -517,6 +541,10 @@ class Node {
   // to `Node::record_start()` (for any node).
   static thread_local int64 work_start_;  // Will be initialized to zero.
 
+  // Stores the time passed to the last call to `Node::record_wait_start()` on
+  // the current thread, with the same invariant as `work_start_`.
+  static thread_local int64 wait_start_;  // Will be initialized to zero.
+
   mutable mutex mu_;
   const int64 id_;
   const string name_;
@@ -531,6 +559,7 @@ class Node {
   std::atomic<int64> bytes_produced_;
   std::atomic<int64> num_elements_;
   std::atomic<int64> processing_time_;
+  std::atomic<int64> wait_time_;
   std::atomic<bool> record_metrics_;
   Metrics metrics_;
   absl::flat_hash_map<string, std::shared_ptr<Parameter>> parameters_
@@ -595,7 +624,8 @@ std::shared_ptr<Node> MakeUnknownNode(Node::Args args);
 class Model {
  public:
   // Creates a new model.
-  Model() : collect_resource_usage_(false) {}
+  Model();
+  ~Model();
 
   // Indicates whether to collect resource usage.
   bool collect_resource_usage() const { return collect_resource_usage_; }
@@ -609,6 +639,15 @@ class Model {
   void FlushMetrics() TF_LOCKS_EXCLUDED(mu_);
 
   // Uses the given algorithm to perform the autotuning optimization.
+  //
+  // The models of concurrent input pipelines share the host, so their budgets
+  // are split between them. The worst-case bytes buffered by the tunable nodes
+  // are kept within `ram_budget`, less the bytes by which the buffers of the
+  // other models in the process may still grow under their current
+  // parameters. The parallelism of the essential transformations is kept
+  // within `cpu_budget`, less the parallelism chosen by the other models, but
+  // is always allowed an even share of `cpu_budget` among the live models.
+  // Models with little demand thereby leave cores to those with more.
   void Optimize(AutotuneAlgorithm algorithm, int64 cpu_budget, int64 ram_budget,
                 double model_input_time) TF_LOCKS_EXCLUDED(mu_);
 
@@ -634,10 +673,12 @@ class Model {
 
   // This optimization algorithm starts by setting all tunable parallelism
   // parameters to the minimum value. It then repeatedly identifies the
-  // parameter whose increase in parallelism decreases the output time the most.
-  // This process is repeated until all parameters reach their maximum values or
-  // the projected output time is less than or equal to the processing time
-  // needed to produce an element divided by CPU budget.
+  // parameter whose increase in parallelism decreases the output time the most
+  // among those whose increase keeps the worst-case buffered bytes within the
+  // memory budget and the essential parallelism within the CPU budget. This
+  // process is repeated until no parameter can be increased or the projected
+  // output time is less than or equal to the processing time needed to
+  // produce an element divided by CPU budget.
   void OptimizeHillClimb(int64 cpu_budget, int64 ram_budget,
                          double model_input_time);
 
@@ -647,10 +688,20 @@ class Model {
   // projecting resulting values on the feasible intervals. Improvement step is
   // repeated until either the output time improvement is smaller than threshold
   // value or the output time is less than the processing time needed to produce
-  // an element divided by CPU budget.
+  // an element divided by CPU budget. A step that would take the worst-case
+  // buffered bytes over the memory budget is undone and ends the search.
   void OptimizeGradientDescent(int64 cpu_budget, int64 ram_budget,
                                double model_input_time);
 
+  // Records the bytes by which the buffers of the model in `snapshot` may
+  // still grow under its current parameters, and the total parallelism of
+  // `parameters`, so that the other models in the process leave them out of
+  // their budgets.
+  void ReserveResources(
+      std::shared_ptr<Node> snapshot,
+      const absl::flat_hash_map<string, std::shared_ptr<Parameter>>&
+          parameters);
+
   // Collects the output time and if `gradients` is not `nullptr`, the output
   // time gradient w.r.t. tunable parameters of the subtree rooted in the given
   // node.
@@ -684,6 +735,10 @@ class Model {
   // tunable parameter (because the information is used for for tuning the value
   // of the parameter) and never stops.
   std::atomic<bool> collect_resource_usage_;
+
+  // The bytes and parallelism last recorded by `ReserveResources`.
+  std::atomic<int64> ram_reserved_{0};
+  std::atomic<int64> cpu_reserved_{0};
 };
 
 }  // namespace model
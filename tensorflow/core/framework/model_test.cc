@@ -447,6 +447,13 @@ TEST(SetterGetterTest, Node) {
   node->add_processing_time(2);
   EXPECT_EQ(node->processing_time(), 42);
 
+  EXPECT_EQ(node->wait_time(), 0);
+  node->record_wait_start(50);
+  EXPECT_EQ(node->wait_time(), 0);
+  node->record_wait_stop(60);
+  EXPECT_EQ(node->wait_time(), 10);
+  EXPECT_EQ(node->processing_time(), 42);
+
   std::shared_ptr<TestNode> input =
       std::make_shared<TestNode>(model::Node::Args{-1, "TestInput", node});
   EXPECT_EQ(input->output(), node.get());
@@ -879,6 +886,88 @@ TEST_P(SelfProcessingTimeTest, Model) {
 INSTANTIATE_TEST_SUITE_P(Test, SelfProcessingTimeTest,
                          ::testing::Values(0, 1, 2, 5, 10, 20, 40));
 
+// Adds to `model` an asynchronous node with a tunable parallelism of up to 100
+// that buffers elements of 1000 bytes, fed by a source node. Returns the state
+// of the parallelism.
+std::shared_ptr<SharedState> AddParallelNode(Model* model) {
+  auto state = std::make_shared<SharedState>(
+      kAutotune, std::make_shared<mutex>(),
+      std::make_shared<condition_variable>());
+  std::shared_ptr<Node> node;
+  model->AddNode(
+      [state](Node::Args args) {
+        return MakeAsyncKnownRatioNode(
+            std::move(args), 1, {MakeParameter(kParallelism, state, 1, 100)});
+      },
+      "parallel", nullptr, &node);
+  std::shared_ptr<Node> source;
+  model->AddNode(
+      [](Node::Args args) { return MakeSourceNode(std::move(args)); },
+      "source", node, &source);
+  node->record_buffer_event(1000, 1);
+  node->add_processing_time(100000);
+  node->record_element();
+  source->add_processing_time(100);
+  source->record_element();
+  return state;
+}
+
+TEST(OptimizeTest, RamBudget) {
+  Model model;
+  std::shared_ptr<SharedState> state = AddParallelNode(&model);
+  // The 1000 bytes already buffered are not counted against the budget, so
+  // the parallelism can grow to 6 elements of 1000 bytes.
+  model.Optimize(AutotuneAlgorithm::HILL_CLIMB, /*cpu_budget=*/1 << 20,
+                 /*ram_budget=*/5000, /*model_input_time=*/0);
+  EXPECT_EQ(6, state->value);
+  model.Optimize(AutotuneAlgorithm::GRADIENT_DESCENT, /*cpu_budget=*/1 << 20,
+                 /*ram_budget=*/5000, /*model_input_time=*/0);
+  EXPECT_LE(state->value, 6);
+}
+
+TEST(OptimizeTest, RamBudgetSharedByModels) {
+  Model model;
+  std::shared_ptr<SharedState> state = AddParallelNode(&model);
+  {
+    Model other_model;
+    std::shared_ptr<SharedState> other_state = AddParallelNode(&other_model);
+    other_model.Optimize(AutotuneAlgorithm::HILL_CLIMB, /*cpu_budget=*/1 << 20,
+                         /*ram_budget=*/5000, /*model_input_time=*/0);
+    EXPECT_EQ(6, other_state->value);
+    // The other model may still buffer 5000 more bytes, which leaves no room
+    // to grow the buffers of this model.
+    model.Optimize(AutotuneAlgorithm::HILL_CLIMB, /*cpu_budget=*/1 << 20,
+                   /*ram_budget=*/5000, /*model_input_time=*/0);
+    EXPECT_EQ(1, state->value);
+  }
+  model.Optimize(AutotuneAlgorithm::HILL_CLIMB, /*cpu_budget=*/1 << 20,
+                 /*ram_budget=*/5000, /*model_input_time=*/0);
+  EXPECT_EQ(6, state->value);
+}
+
+TEST(OptimizeTest, CpuBudgetSharedByModels) {
+  Model model;
+  std::shared_ptr<SharedState> state = AddParallelNode(&model);
+  model.Optimize(AutotuneAlgorithm::HILL_CLIMB, /*cpu_budget=*/4,
+                 /*ram_budget=*/1 << 30, /*model_input_time=*/0);
+  EXPECT_EQ(4, state->value);
+  {
+    Model other_model;
+    std::shared_ptr<SharedState> other_state = AddParallelNode(&other_model);
+    // All cores are taken by the first model, but each of the two models is
+    // entitled to an even share of them.
+    other_model.Optimize(AutotuneAlgorithm::HILL_CLIMB, /*cpu_budget=*/4,
+                         /*ram_budget=*/1 << 30, /*model_input_time=*/0);
+    EXPECT_EQ(2, other_state->value);
+    model.Optimize(AutotuneAlgorithm::HILL_CLIMB, /*cpu_budget=*/4,
+                   /*ram_budget=*/1 << 30, /*model_input_time=*/0);
+    EXPECT_EQ(2, state->value);
+  }
+  model.Optimize(AutotuneAlgorithm::HILL_CLIMB, /*cpu_budget=*/4,
+                 /*ram_budget=*/1 << 30, /*model_input_time=*/0);
+  EXPECT_EQ(4, state->value);
+}
+
 }  // namespace
 }  // namespace model
 }  // namespace data
@@ -388,6 +388,18 @@ Allocator* OpKernelContext::get_allocator(AllocatorAttributes attr) {
   }
 }
 
+Allocator* OpKernelContext::get_temp_allocator(
+    AllocatorAttributes attr, const AllocationAttributes& allocation_attr) {
+  // The step allocator only stands in for the device allocator, so it is not
+  // used when the attributes could select a different allocator, or when the
+  // allocations are tracked per kernel.
+  if (params_->step_temp_allocator != nullptr && attr.value == 0 &&
+      allocation_attr.freed_by_func == nullptr && !track_allocations()) {
+    return params_->step_temp_allocator;
+  }
+  return get_allocator(attr);
+}
+
 void OpKernelContext::SetStatus(const Status& status) {
   status_.Update(status);
 }
@@ -708,7 +720,13 @@ Status OpKernelContext::allocate_output(StringPiece name,
 Status OpKernelContext::allocate_tensor(
     DataType type, const TensorShape& shape, Tensor* out_tensor,
     AllocatorAttributes attr, const AllocationAttributes& allocation_attr) {
-  Allocator* a = get_allocator(attr);
+  return allocate_tensor(get_allocator(attr), type, shape, out_tensor,
+                         allocation_attr);
+}
+
+Status OpKernelContext::allocate_tensor(
+    Allocator* a, DataType type, const TensorShape& shape, Tensor* out_tensor,
+    const AllocationAttributes& allocation_attr) {
   Tensor new_tensor(
       a, type, shape,
       AllocationAttributes(
@@ -796,10 +814,9 @@ Status OpKernelContext::allocate_temp(
   }
   ScopedMemoryDebugAnnotation op_annotation(op_kernel().name_view().data(),
                                             step_id(), "temp", type, &shape);
-  Status s =
-      allocate_tensor(type, shape, out_temp, allocator_attr, allocation_attr);
+  Allocator* a = get_temp_allocator(allocator_attr, allocation_attr);
+  Status s = allocate_tensor(a, type, shape, out_temp, allocation_attr);
   if (track_allocations() && s.ok() && out_temp->TotalBytes() > 0) {
-    Allocator* a = get_allocator(allocator_attr);
     if (a->TracksAllocationSizes()) {
       int64 alloc_size = a->AllocatedSize(out_temp->tensor_data().data());
       record_temp_memory_allocation(alloc_size, *out_temp);
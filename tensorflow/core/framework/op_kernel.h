@@ -643,6 +643,12 @@ class OpKernelContext {
     // stored in this container..
     ScopedStepContainer* step_container = nullptr;
 
+    // If not null, allocate_temp() uses this allocator instead of the device
+    // allocator for requests with default allocator attributes. Allocations
+    // made through it may outlive the step, so it must be safe to deallocate
+    // from it at any time.
+    Allocator* step_temp_allocator = nullptr;
+
     // Mechanism used by this op kernel invocation to communicate with
     // computations running on other devices.
     RendezvousInterface* rendezvous = nullptr;
@@ -1282,6 +1288,14 @@ class OpKernelContext {
                          Tensor* out_tensor, AllocatorAttributes allocator_attr,
                          const AllocationAttributes& allocation_attr);
 
+  Status allocate_tensor(Allocator* a, DataType type, const TensorShape& shape,
+                         Tensor* out_tensor,
+                         const AllocationAttributes& allocation_attr);
+
+  // Returns the allocator that allocate_temp() should use.
+  Allocator* get_temp_allocator(AllocatorAttributes attr,
+                                const AllocationAttributes& allocation_attr);
+
   // Helpers for `set_output()`.
 
   // Returns `true` if the tensor was copied into an allocated output.
@@ -21,6 +21,7 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/tensor_types.h"
 #include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
@@ -368,6 +369,29 @@ TEST_F(LocalRendezvousTest, RecvAbort) {
   EXPECT_TRUE(errors::IsAborted(status));
 }
 
+// Pending receives under many different keys must all be woken up by
+// StartAbort(), regardless of which part of the table they are stored in.
+TEST_F(LocalRendezvousTest, AbortManyKeys) {
+  const int kNumKeys = 64;
+  BlockingCounter counter(kNumKeys);
+  std::atomic<int> num_aborted(0);
+  Rendezvous::Args args;
+  for (int i = 0; i < kNumKeys; ++i) {
+    rendez_->RecvAsync(
+        MakeKey(strings::StrCat("key", i)), args,
+        [&counter, &num_aborted](const Status& s, const Rendezvous::Args&,
+                                 const Rendezvous::Args&, const Tensor&, bool) {
+          if (errors::IsAborted(s)) ++num_aborted;
+          counter.DecrementCount();
+        });
+  }
+  rendez_->StartAbort(errors::Aborted(""));
+  counter.Wait();
+  EXPECT_EQ(kNumKeys, num_aborted);
+  EXPECT_TRUE(errors::IsAborted(rendez_->Send(KeyFoo(), args, V("hello"),
+                                              /*is_dead=*/false)));
+}
+
 // Similar to RecvAbort. But this test case ensures the main thread
 // Recv() call happens after StartAbort().
 TEST_F(LocalRendezvousTest, RecvSleepAbort) {
@@ -477,6 +501,39 @@ void BM_RecvSend(int iters) {
 }
 BENCHMARK(BM_RecvSend);
 
+// Each of `num_threads` threads repeatedly sends and receives a value under
+// its own key, so that all contention is on the rendezvous' internal state.
+void BM_SendRecvContended(int iters, int num_threads) {
+  testing::StopTiming();
+  Rendezvous* rendez = NewLocalRendezvous();
+  std::vector<Rendezvous::ParsedKey> keys;
+  for (int i = 0; i < num_threads; ++i) {
+    keys.push_back(MakeKey(strings::StrCat("key", i)));
+  }
+  thread::ThreadPool* pool =
+      new thread::ThreadPool(Env::Default(), "test", num_threads);
+  BlockingCounter counter(num_threads);
+  testing::StartTiming();
+  for (int i = 0; i < num_threads; ++i) {
+    pool->Schedule([rendez, &keys, &counter, i, iters]() {
+      Tensor orig = V("val");
+      Tensor val(DT_STRING, TensorShape({}));
+      bool is_dead = false;
+      Rendezvous::Args args;
+      for (int j = 0; j < iters; ++j) {
+        TF_CHECK_OK(rendez->Send(keys[i], args, orig, is_dead));
+        TF_CHECK_OK(rendez->Recv(keys[i], args, &val, &is_dead));
+      }
+      counter.DecrementCount();
+    });
+  }
+  counter.Wait();
+  testing::StopTiming();
+  delete pool;
+  rendez->Unref();
+}
+BENCHMARK(BM_SendRecvContended)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->Arg(16);
+
 void BM_PingPong(int iters) {
   CHECK_GT(iters, 0);
   auto* cm = new CancellationManager();
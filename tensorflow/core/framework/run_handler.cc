@@ -23,6 +23,7 @@ limitations under the License.
 #include <memory>
 
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/core/framework/metrics.h"
 #include "tensorflow/core/framework/run_handler_util.h"
 #include "tensorflow/core/lib/core/threadpool_interface.h"
 #include "tensorflow/core/lib/strings/strcat.h"
@@ -41,6 +42,9 @@ namespace {
 static constexpr int32 kMaxConcurrentHandlers = 128;
 // LINT.ThenChange(//tensorflow/core/framework/run_handler_test.cc)
 
+// Default for TF_RUN_HANDLER_STARVATION_THRESHOLD_MS.
+static constexpr int32 kDefaultStarvationThresholdMs = 1000;
+
 typedef typename internal::RunHandlerEnvironment::Task Task;
 typedef Eigen::RunQueue<Task, 1024> Queue;
 
@@ -77,6 +81,7 @@ RunHandlerEnvironment::Task RunHandlerEnvironment::CreateTask(
           std::move(f),
           Context(ContextKind::kThread),
           id,
+          EnvTime::NowMicros(),
       }),
   };
 }
@@ -131,6 +136,7 @@ ThreadWorkSource::ThreadWorkSource()
       blocking_inflight_(0),
       non_blocking_inflight_(0),
       traceme_id_(0),
+      queueing_delay_cell_(nullptr),
       version_(0),
       sub_thread_pool_waiter_(nullptr) {
   queue_waiters_.next = &queue_waiters_;
@@ -260,6 +266,19 @@ int64 ThreadWorkSource::GetTracemeId() {
 
 void ThreadWorkSource::SetTracemeId(int64 value) { traceme_id_ = value; }
 
+void ThreadWorkSource::SetQueueingDelayCell(monitoring::SamplerCell* cell) {
+  queueing_delay_cell_.store(cell, std::memory_order_relaxed);
+}
+
+void ThreadWorkSource::RecordQueueingDelay(const Task& t) {
+  monitoring::SamplerCell* cell =
+      queueing_delay_cell_.load(std::memory_order_relaxed);
+  if (cell != nullptr) {
+    const uint64 now = EnvTime::NowMicros();
+    cell->Add(now > t.f->enqueue_time_us ? now - t.f->enqueue_time_us : 0);
+  }
+}
+
 void ThreadWorkSource::SetWaiter(uint64 version, Waiter* waiter, mutex* mutex) {
   {
     tf_shared_lock lock(run_handler_waiter_mu_);
@@ -624,6 +643,9 @@ void RunHandlerThreadPool::WorkerLoop(int thread_id,
           profiler::TraceMeLevel::kInfo);
       VLOG(2) << "Running " << (task_from_blocking_queue ? "inter" : "intra")
               << " work from " << tws->GetTracemeId();
+      if (task_from_blocking_queue) {
+        tws->RecordQueueingDelay(t);
+      }
       tws->IncrementInflightTaskCount(task_from_blocking_queue);
       env_.ExecuteTask(t);
       tws->DecrementInflightTaskCount(task_from_blocking_queue);
@@ -728,6 +750,9 @@ class RunHandler::Impl {
   // Stores now time (in microseconds) since unix epoch when the handler is
   // requested via RunHandlerPool::Get().
   uint64 start_time_us() const { return start_time_us_; }
+  // Returns the absolute deadline of the request in microseconds since unix
+  // epoch, or kuint64max if the request does not have one.
+  uint64 deadline_us() const { return deadline_us_; }
   int64 step_id() const { return step_id_; }
   void ScheduleInterOpClosure(std::function<void()> fn);
   void ScheduleIntraOpClosure(std::function<void()> fn);
@@ -739,7 +764,7 @@ class RunHandler::Impl {
 
   internal::ThreadWorkSource* tws() { return &tws_; }
 
-  int64 priority() { return options_.priority(); }
+  int64 priority() const { return options_.priority(); }
 
  private:
   class ThreadPoolInterfaceWrapper : public thread::ThreadPoolInterface {
@@ -757,6 +782,7 @@ class RunHandler::Impl {
 
   RunHandlerPool::Impl* pool_impl_;  // NOT OWNED.
   uint64 start_time_us_;
+  uint64 deadline_us_;
   int64 step_id_;
   std::unique_ptr<thread::ThreadPoolInterface> thread_pool_interface_;
   internal::ThreadWorkSource tws_;
@@ -779,6 +805,10 @@ class RunHandlerPool::Impl {
             num_inter_op_threads, num_intra_op_threads, Env::Default(),
             ThreadOptions(), "tf_run_handler_pool", &waiters_mu_,
             &queue_waiters_)),
+        starvation_threshold_us_(static_cast<uint64>(
+            1000 * std::max(0.0, ParamFromEnvWithDefault(
+                                     "TF_RUN_HANDLER_STARVATION_THRESHOLD_MS",
+                                     kDefaultStarvationThresholdMs)))),
         iterations_(0),
         version_(0),
         sub_thread_pool_end_request_percentage_(ParamFromEnvWithDefault(
@@ -837,9 +867,11 @@ class RunHandlerPool::Impl {
     uint64 version;
     int num_active_requests;
     RunHandler::Impl* handler_impl;
+    uint64 wait_start_us = 0;
     {
       mutex_lock l(mu_);
       if (!has_free_handler()) {
+        wait_start_us = EnvTime::NowMicros();
         profiler::TraceMe activity(
             [&] {
               return strings::StrCat("WaitingForHandler#step_id=", step_id,
@@ -859,25 +891,29 @@ class RunHandlerPool::Impl {
       handler_impl = free_handlers_.back();
       handler_impl->Reset(step_id, options);
       free_handlers_.pop_back();
-
-      num_active_requests = sorted_active_handlers_.size() + 1;
+      sorted_active_handlers_.push_back(handler_impl);
+
+      // Re-sort all active handlers, since handlers may have become starved
+      // since the last call. The new handler has the latest start time, so it
+      // can serve as the current time. std::list::sort() is stable, which
+      // keeps handlers that compare equal in arrival order.
+      const uint64 now_us = handler_impl->start_time_us();
+      sorted_active_handlers_.sort(
+          [this, now_us](const RunHandler::Impl* a, const RunHandler::Impl* b) {
+            return ScheduleBefore(a, b, now_us);
+          });
+
+      num_active_requests = sorted_active_handlers_.size();
       thread_work_sources->resize(num_active_requests);
-      int priority = options.priority();
       auto it = sorted_active_handlers_.cbegin();
-      bool new_handler_inserted = false;
-      for (int i = 0; i < num_active_requests; ++i) {
-        if (!new_handler_inserted && (it == sorted_active_handlers_.cend() ||
-                                      priority > (*it)->priority())) {
-          sorted_active_handlers_.insert(it, handler_impl);
-          new_handler_inserted = true;
-          // Point to the newly added handler.
-          --it;
-        }
+      for (int i = 0; i < num_active_requests; ++i, ++it) {
         (*thread_work_sources)[i] = (*it)->tws();
-        ++it;
       }
       version = ++version_;
     }
+    const uint64 wait_us =
+        wait_start_us == 0 ? 0 : handler_impl->start_time_us() - wait_start_us;
+    metrics::RecordRunHandlerWaitTime(options.priority(), wait_us);
     RecomputePoolStats(num_active_requests, version, *thread_work_sources);
     return WrapUnique<RunHandler>(new RunHandler(handler_impl));
   }
@@ -923,7 +959,41 @@ class RunHandlerPool::Impl {
     return ret;
   }
 
+  std::vector<int64> GetActiveHandlerStepIdsForTesting()
+      TF_LOCKS_EXCLUDED(mu_) {
+    mutex_lock l(mu_);
+    std::vector<int64> ret;
+    for (const auto& handler_impl : sorted_active_handlers_) {
+      ret.push_back(handler_impl->step_id());
+    }
+    return ret;
+  }
+
  private:
+  // Returns true if work from `a` should be attempted before work from `b`.
+  //
+  // Handlers that have been active for at least `starvation_threshold_us_`
+  // come first, oldest first. The remaining handlers are ordered by
+  // decreasing priority, then earliest deadline, then earliest start time.
+  bool ScheduleBefore(const RunHandler::Impl* a, const RunHandler::Impl* b,
+                      uint64 now_us) const {
+    const bool a_starved = IsStarved(a, now_us);
+    const bool b_starved = IsStarved(b, now_us);
+    if (a_starved != b_starved) return a_starved;
+    if (!a_starved) {
+      if (a->priority() != b->priority()) return a->priority() > b->priority();
+      if (a->deadline_us() != b->deadline_us()) {
+        return a->deadline_us() < b->deadline_us();
+      }
+    }
+    return a->start_time_us() < b->start_time_us();
+  }
+
+  bool IsStarved(const RunHandler::Impl* handler, uint64 now_us) const {
+    return starvation_threshold_us_ > 0 && now_us > handler->start_time_us() &&
+           now_us - handler->start_time_us() >= starvation_threshold_us_;
+  }
+
   void RecomputePoolStats(
       int num_active_requests, uint64 version,
       const Eigen::MaxSizeVector<internal::ThreadWorkSource*>&
@@ -942,8 +1012,7 @@ class RunHandlerPool::Impl {
 
   std::unique_ptr<internal::RunHandlerThreadPool> run_handler_thread_pool_;
   // Thread compatible part used only by lock under RunHandlerPool.
-  // Handlers are sorted by start time.
-  // TODO(azaks): sort by the remaining latency budget.
+  // Handlers are sorted by ScheduleBefore().
   // TODO(chaox): Consider other data structure for maintaining the sorted
   // active handlers if the searching overhead(currently O(n)) becomes the
   // bottleneck.
@@ -954,6 +1023,10 @@ class RunHandlerPool::Impl {
   // Histogram of elapsed runtime of every handler (in ms).
   histogram::Histogram time_hist_ TF_GUARDED_BY(mu_);
 
+  // Handlers active for longer than this are scheduled ahead of all other
+  // handlers. Zero disables starvation protection.
+  const uint64 starvation_threshold_us_;
+
   int64 iterations_ TF_GUARDED_BY(mu_);
   mutex mu_;
   int64 version_ TF_GUARDED_BY(mu_);
@@ -1067,9 +1140,13 @@ void RunHandler::Impl::Reset(
     int64 step_id,
     const RunOptions::Experimental::RunHandlerPoolOptions& options) {
   start_time_us_ = tensorflow::Env::Default()->NowMicros();
+  deadline_us_ = options.deadline_micros() > 0 ? options.deadline_micros()
+                                                : kuint64max;
   step_id_ = step_id;
   options_ = options;
   tws_.SetTracemeId(step_id);
+  tws_.SetQueueingDelayCell(
+      metrics::GetRunHandlerQueueingDelayCell(options.priority()));
 }
 
 RunHandlerPool::RunHandlerPool(int num_inter_op_threads)
@@ -1092,6 +1169,10 @@ std::vector<int64> RunHandlerPool::GetActiveHandlerPrioritiesForTesting()
   return impl_->GetActiveHandlerPrioritiesForTesting();
 }
 
+std::vector<int64> RunHandlerPool::GetActiveHandlerStepIdsForTesting() const {
+  return impl_->GetActiveHandlerStepIdsForTesting();
+}
+
 RunHandler::RunHandler(Impl* impl) : impl_(impl) {}
 
 void RunHandler::ScheduleInterOpClosure(std::function<void()> fn) {
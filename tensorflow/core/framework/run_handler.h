@@ -18,6 +18,7 @@ limitations under the License.
 
 #include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/histogram/histogram.h"
+#include "tensorflow/core/lib/monitoring/sampler.h"
 #include "tensorflow/core/platform/context.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/thread_annotations.h"
@@ -72,6 +73,10 @@ class RunHandlerPool {
   // order of the active handler list.
   std::vector<int64> GetActiveHandlerPrioritiesForTesting() const;
 
+  // Get the step ids for active handlers. The return result is with the same
+  // order of the active handler list.
+  std::vector<int64> GetActiveHandlerStepIdsForTesting() const;
+
  private:
   class Impl;
   friend class RunHandler;
@@ -81,8 +86,12 @@ class RunHandlerPool {
 
 // RunHandler can be used to schedule inter/intra-op closures to run on a global
 // pool shared across all Session::Run(s). The closures are enqueued to a
-// handler specific queue, from which the work is stolen in a priority order
-// (time of the Get() call).
+// handler specific queue, from which the work is stolen in a priority order:
+// handlers are ordered by decreasing RunHandlerPoolOptions priority, then by
+// earliest deadline, then by the time of the Get() call. A handler that has
+// been active for longer than TF_RUN_HANDLER_STARVATION_THRESHOLD_MS is moved
+// ahead of all non-starved handlers, so that low priority requests still make
+// progress under sustained high priority load.
 //
 // It can only be created via RunHandlerPool::Get().
 //
@@ -116,6 +125,7 @@ class RunHandlerEnvironment {
     std::function<void()> f;
     Context context;
     uint64 trace_id;
+    uint64 enqueue_time_us;
   };
   Env* const env_;
   const ThreadOptions thread_options_;
@@ -173,6 +183,12 @@ class ThreadWorkSource {
 
   void SetTracemeId(int64 value);
 
+  // Sets the cell used to record how long blocking tasks from this work source
+  // wait in the queue. May be null, in which case nothing is recorded.
+  void SetQueueingDelayCell(monitoring::SamplerCell* cell);
+
+  void RecordQueueingDelay(const Task& t);
+
   void SetWaiter(uint64 version, Waiter* waiter, mutex* mutex);
 
   int64 GetInflightTaskCount(bool is_blocking);
@@ -204,6 +220,7 @@ class ThreadWorkSource {
   mutex waiters_mu_;
   Waiter queue_waiters_ TF_GUARDED_BY(waiters_mu_);
   std::atomic<int64> traceme_id_;
+  std::atomic<monitoring::SamplerCell*> queueing_delay_cell_;
 
   mutex run_handler_waiter_mu_;
   uint64 version_ TF_GUARDED_BY(run_handler_waiter_mu_);
@@ -113,6 +113,55 @@ TEST(RunHandlerUtilTest, PrioritySchedulingTest) {
   EXPECT_EQ(sorted_active_list[3], 1);
 }
 
+TEST(RunHandlerUtilTest, DeadlineSchedulingTest) {
+  int num_threads = 2;
+  std::unique_ptr<RunHandlerPool> pool(
+      new RunHandlerPool(num_threads, num_threads));
+
+  const int64 now_us = Env::Default()->NowMicros();
+  RunOptions::Experimental::RunHandlerPoolOptions options =
+      RunOptions::Experimental::RunHandlerPoolOptions();
+  options.set_priority(1);
+  auto handler1 = pool->Get(/*step_id=*/1, /*timeout_in_ms=*/0, options);
+  options.set_deadline_micros(now_us + 3000000);
+  auto handler2 = pool->Get(/*step_id=*/2, /*timeout_in_ms=*/0, options);
+  options.set_deadline_micros(now_us + 1000000);
+  auto handler3 = pool->Get(/*step_id=*/3, /*timeout_in_ms=*/0, options);
+  options.set_deadline_micros(now_us + 2000000);
+  auto handler4 = pool->Get(/*step_id=*/4, /*timeout_in_ms=*/0, options);
+  options.set_priority(2);
+  options.set_deadline_micros(0);
+  auto handler5 = pool->Get(/*step_id=*/5, /*timeout_in_ms=*/0, options);
+
+  // Higher priority first, then earliest deadline first. Requests without a
+  // deadline come last within their priority.
+  std::vector<int64> sorted_step_ids =
+      pool->GetActiveHandlerStepIdsForTesting();
+  EXPECT_EQ(sorted_step_ids, std::vector<int64>({5, 3, 4, 2, 1}));
+}
+
+TEST(RunHandlerUtilTest, StarvationProtectionTest) {
+  ASSERT_EQ(setenv("TF_RUN_HANDLER_STARVATION_THRESHOLD_MS", "10", true), 0);
+  int num_threads = 2;
+  std::unique_ptr<RunHandlerPool> pool(
+      new RunHandlerPool(num_threads, num_threads));
+  ASSERT_EQ(unsetenv("TF_RUN_HANDLER_STARVATION_THRESHOLD_MS"), 0);
+
+  RunOptions::Experimental::RunHandlerPoolOptions options =
+      RunOptions::Experimental::RunHandlerPoolOptions();
+  options.set_priority(1);
+  auto handler1 = pool->Get(/*step_id=*/1, /*timeout_in_ms=*/0, options);
+  Env::Default()->SleepForMicroseconds(20 * 1000);
+  options.set_priority(2);
+  auto handler2 = pool->Get(/*step_id=*/2, /*timeout_in_ms=*/0, options);
+
+  // The low priority request has been active for longer than the starvation
+  // threshold, so it is scheduled ahead of the new high priority one.
+  std::vector<int64> sorted_step_ids =
+      pool->GetActiveHandlerStepIdsForTesting();
+  EXPECT_EQ(sorted_step_ids, std::vector<int64>({1, 2}));
+}
+
 TEST(RunHandlerThreadPool, EnqueueTask) {
   Eigen::MaxSizeVector<mutex> waiters_mu(2);
   waiters_mu.resize(2);
@@ -953,6 +953,8 @@ class AutoMixedPrecisionImpl {
                                                              cudnn_version_);
       case AutoMixedPrecisionMode::MKL:
         return std::make_unique<AutoMixedPrecisionListsMkl>();
+      case AutoMixedPrecisionMode::CPU:
+        return std::make_unique<AutoMixedPrecisionListsCpu>();
     }
   }
   Status PrintDebugLogs(bool preop, size_t timestamp);
@@ -1244,12 +1246,12 @@ Status AutoMixedPrecisionImpl::Optimize() {
       "TF_AUTO_MIXED_PRECISION_GRAPH_REWRITE_LEVEL", "", &optimization_level));
   optimization_level = absl::AsciiStrToUpper(optimization_level);
   force_all_fp16_ = optimization_level == "UNSAFE_FORCE_ALL";
-  if (force_all_fp16_ && mode_ == AutoMixedPrecisionMode::MKL) {
+  if (force_all_fp16_ && mode_ != AutoMixedPrecisionMode::CUDA) {
     // Many ops do not support bfloat16 on the CPU so we disallowing forcing to
     // bfloat16.
     return errors::InvalidArgument(
         "TF_AUTO_MIXED_PRECISION_GRAPH_REWRITE_LEVEL cannot be set to "
-        "UNSAFE_FORCE_ALL when MKL is used");
+        "UNSAFE_FORCE_ALL when converting to bfloat16 on the CPU");
   }
 
   std::unique_ptr<AutoMixedPrecisionLists> mp_lists =
@@ -1274,6 +1276,7 @@ Status AutoMixedPrecisionImpl::Optimize() {
             (ShouldIgnorePerformance() || IsOnSuitableGPUArch(node));
         break;
       case AutoMixedPrecisionMode::MKL:
+      case AutoMixedPrecisionMode::CPU:
         should_process = !MustPreserve(node) && IsOnDevice(node, DEVICE_CPU);
         break;
     }
@@ -439,6 +439,99 @@ class AutoMixedPrecisionListsMkl : public AutoMixedPrecisionLists {
   }
 };
 
+// Lists for converting to bfloat16 on CPUs without MKL, using the Eigen
+// bfloat16 kernels. These benefit from CPUs with native bfloat16 support
+// (e.g. AVX512-BF16 or AMX), where the halved memory traffic and the faster
+// dot products outweigh the cost of the extra casts.
+class AutoMixedPrecisionListsCpu : public AutoMixedPrecisionLists {
+ public:
+  AutoMixedPrecisionListsCpu() {}
+
+  // Only ops with a bfloat16 CPU kernel should be added to the allow list,
+  // infer list, or clear list.
+  gtl::FlatSet<string> AllowList() override {
+    auto list = gtl::FlatSet<string>{"Conv2D", "MatMul"};
+    UpdateList("ALLOWLIST", &list);
+    return list;
+  }
+
+  gtl::FlatSet<string> InferList() override {
+    auto list = gtl::FlatSet<string>{
+        "Add",
+        "AddN",
+        "AddV2",
+        "BiasAdd",
+        "BiasAddGrad",
+        "BiasAddV1",
+        "LeakyRelu",
+        "Mul",
+        "Sigmoid",
+        "Sub",
+        "Tanh",
+    };
+    UpdateList("INFERLIST", &list);
+    return list;
+  }
+
+  gtl::FlatSet<string> DenyList() override {
+    auto list = gtl::FlatSet<string>{
+        "Exp",
+        "Expm1",
+        "L2Loss",
+        "Log",
+        "Log1p",
+        "LogSoftmax",
+        "Mean",
+        "Pow",
+        "SaveV2",
+        "Softmax",
+        "SoftmaxCrossEntropyWithLogits",
+        "SparseSoftmaxCrossEntropyWithLogits",
+        "Sum",
+    };
+    UpdateList("DENYLIST", &list);
+    return list;
+  }
+
+  gtl::FlatSet<string> ClearList() override {
+    auto list = gtl::FlatSet<string>{
+        "Concat",
+        "ConcatV2",
+        "Enter",
+        "EnsureShape",
+        "Equal",
+        "Exit",
+        "ExpandDims",
+        "Identity",
+        "MaxPool",
+        "Maximum",
+        "Merge",
+        "NextIteration",
+        "PreventGradient",
+        "Relu",
+        "Relu6",
+        "Relu6Grad",
+        "ReluGrad",
+        "Reshape",
+        "Select",
+        "SelectV2",
+        "Shape",
+        "ShapeN",
+        "Slice",
+        "Split",
+        "SplitV",
+        "Squeeze",
+        "StopGradient",
+        "Switch",
+        "Transpose",
+        "ZerosLike",
+    };
+    AddTensorListOps(&list);
+    UpdateList("CLEARLIST", &list);
+    return list;
+  }
+};
+
 }  // end namespace grappler
 }  // end namespace tensorflow
 
@@ -17,6 +17,7 @@ limitations under the License.
 
 #include "tensorflow/core/grappler/optimizers/constant_folding.h"
 
+#include <algorithm>
 #include <cmath>
 
 #include "absl/strings/string_view.h"
@@ -40,8 +41,10 @@ limitations under the License.
 #include "tensorflow/core/grappler/optimizers/evaluation_utils.h"
 #include "tensorflow/core/grappler/utils.h"
 #include "tensorflow/core/grappler/utils/symbolic_shapes.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/stringpiece.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/gtl/cleanup.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/lib/strings/numbers.h"
@@ -62,6 +65,14 @@ using TensorVector = gtl::InlinedVector<TensorValue, 4>;
 // We only fold/materialize constants smaller than 10 MiB.
 const int64 kMaxConstantSize = 10 * 1024 * 1024;
 
+// Constants larger than kMaxConstantSize are still materialized if computing
+// them requires reading at least as many bytes as they occupy, up to this hard
+// limit.
+const int64 kMaxFoldedConstantSize = 4 * kMaxConstantSize;
+
+// Maximum number of threads used to evaluate independent foldable nodes.
+constexpr int kMaxConstantFoldingThreads = 8;
+
 namespace {
 template <typename T>
 bool AllValuesAre(const TensorProto& proto, const T& value) {
@@ -1003,12 +1014,14 @@ bool ConstantFolding::IsFoldableUncached(
             input_shape.num_elements() * DataTypeSize(input_prop.dtype());
       }
     }
+    const int64 size_budget = MaterializedSizeBudget(
+        input_size_bytes, input_size_bytes + FoldedInputBytes(node));
     for (const auto& output_prop : output_props) {
       const PartialTensorShape output_shape(output_prop.shape());
       if (output_shape.IsFullyDefined()) {
         const int64 num_bytes =
             output_shape.num_elements() * DataTypeSize(output_prop.dtype());
-        if (num_bytes > input_size_bytes && num_bytes > kMaxConstantSize) {
+        if (num_bytes > size_budget && num_bytes > kMaxConstantSize) {
           // Do not fold nodes if the in-memory size of output is too large.
           // Notice that this is not exactly the same check used in
           // CreateNodeDef() where the actual encoded size is checked.
@@ -1021,6 +1034,25 @@ bool ConstantFolding::IsFoldableUncached(
   return true;
 }
 
+int64 ConstantFolding::FoldedInputBytes(const NodeDef& node) const {
+  int64 folded_bytes = 0;
+  for (const auto& input : node.input()) {
+    if (IsControlInput(input)) continue;
+    auto it = folded_subgraph_bytes_.find(NodeName(input));
+    if (it != folded_subgraph_bytes_.end()) {
+      folded_bytes += it->second;
+    }
+  }
+  return folded_bytes;
+}
+
+// static
+int64 ConstantFolding::MaterializedSizeBudget(int64 input_size_bytes,
+                                              int64 subgraph_bytes) {
+  return std::max(input_size_bytes,
+                  std::min(subgraph_bytes, kMaxFoldedConstantSize));
+}
+
 bool ConstantFolding::MaybeFoldable(const NodeDef& node,
                                     const GraphProperties* properties) const {
   // Skip constants, they're already folded
@@ -1308,7 +1340,8 @@ Status ConstantFolding::EvaluateNode(const NodeDef& node,
 
 Status ConstantFolding::EvaluateOneFoldable(const NodeDef& node,
                                             std::vector<NodeDef>* outputs,
-                                            bool* result_too_large) {
+                                            bool* result_too_large,
+                                            int64* subgraph_bytes) {
   TensorVector inputs;
   TensorVector output_tensors;
   auto inputs_cleanup = gtl::MakeCleanup([&inputs, &output_tensors] {
@@ -1348,6 +1381,13 @@ Status ConstantFolding::EvaluateOneFoldable(const NodeDef& node,
     return Status(error::INVALID_ARGUMENT, "Expected at least one output.");
   }
 
+  // Outputs larger than their inputs are materialized as long as they don't
+  // exceed the number of bytes read by the whole folded subgraph: the runtime
+  // would otherwise have to recompute them at every step.
+  *subgraph_bytes = total_inputs_size + FoldedInputBytes(node);
+  const int64 size_budget =
+      MaterializedSizeBudget(total_inputs_size, *subgraph_bytes);
+
   outputs->resize(output_tensors.size());
   for (size_t i = 0; i < output_tensors.size(); i++) {
     string node_name = OptimizedNodeName(node, "-folded");
@@ -1356,7 +1396,7 @@ Status ConstantFolding::EvaluateOneFoldable(const NodeDef& node,
     }
     if (output_tensors[i].tensor) {
       Status s = CreateNodeDef(node_name, output_tensors[i], &outputs->at(i),
-                               total_inputs_size);
+                               size_budget);
       if (!s.ok()) {
         *result_too_large = true;
         return s;
@@ -1462,16 +1502,14 @@ Status ConstantFolding::FoldMergeNode(NodeDef* node, GraphDef* output_graph) {
   return Status::OK();
 }
 
-Status ConstantFolding::FoldNode(NodeDef* node, GraphDef* output_graph,
-                                 bool* result_too_large) {
-  *result_too_large = false;
+Status ConstantFolding::FoldNode(NodeDef* node,
+                                 std::vector<NodeDef>* const_nodes_ptr,
+                                 GraphDef* output_graph) {
   if (IsMerge(*node)) {
     return FoldMergeNode(node, output_graph);
   }
 
-  std::vector<NodeDef> const_nodes;
-  TF_RETURN_IF_ERROR(
-      EvaluateOneFoldable(*node, &const_nodes, result_too_large));
+  std::vector<NodeDef>& const_nodes = *const_nodes_ptr;
   VLOG(2) << "Folded node: " << SummarizeNodeDef(*node);
 
   NodeDef* constant_output = nullptr;
@@ -1600,29 +1638,103 @@ Status ConstantFolding::FoldGraph(
       queue.push_back(graph_->mutable_node(i));
     }
   }
-  while (!queue.empty()) {
-    NodeDef* node = queue.front();
-    queue.pop_front();
-    if (processed_nodes.count(node->name())) {
-      continue;
-    }
-    // We need to record a copy of output nodes before FoldNode() modifies it.
-    // We also need to ensure that the fanout is sorted deterministically.
-    std::vector<NodeDef*> fanout =
-        node_map_->GetOutputsOrderedByNodeName(node->name());
+
+  // The inputs of every queued node are already constant, so the nodes present
+  // in the queue at a given time can be evaluated independently of each other.
+  // We evaluate them in batches on a thread pool, and then rewrite the graph
+  // sequentially in queue order to keep the output deterministic.
+  struct FoldedValue {
+    std::vector<NodeDef> const_nodes;
+    Status status;
     bool result_too_large = false;
-    Status s = FoldNode(node, output, &result_too_large);
-    processed_nodes.insert(node->name());
-    if (!s.ok()) {
-      VLOG(1) << "Failed to fold node " << node->DebugString()
-              << "\nError message: " << s;
-      if (result_too_large) {
-        nodes_to_not_simplify->emplace(node->name());
+    int64 subgraph_bytes = 0;
+  };
+  const int num_threads =
+      std::min(port::MaxParallelism(), kMaxConstantFoldingThreads);
+  std::unique_ptr<thread::ThreadPool> thread_pool;
+  std::vector<NodeDef*> batch;
+  std::vector<FoldedValue> values;
+  while (!queue.empty()) {
+    batch.clear();
+    absl::flat_hash_set<string> batch_names;
+    while (!queue.empty()) {
+      NodeDef* node = queue.front();
+      queue.pop_front();
+      if (processed_nodes.count(node->name()) ||
+          !batch_names.insert(node->name()).second) {
+        continue;
+      }
+      batch.push_back(node);
+    }
+
+    values.clear();
+    values.resize(batch.size());
+    auto evaluate = [this, &batch, &values](int i) {
+      // Rounding and denormal modes are thread local: make sure the worker
+      // threads match the ones set in Optimize().
+      port::ScopedFlushDenormal flush;
+      port::ScopedSetRound round(FE_TONEAREST);
+      FoldedValue* value = &values[i];
+      if (!IsMerge(*batch[i])) {
+        value->status = EvaluateOneFoldable(*batch[i], &value->const_nodes,
+                                            &value->result_too_large,
+                                            &value->subgraph_bytes);
+      }
+    };
+    if (num_threads > 1 && batch.size() > 1) {
+      if (thread_pool == nullptr) {
+        thread_pool.reset(new thread::ThreadPool(
+            Env::Default(), "constant_folding", num_threads));
+      }
+      VLOG(2) << "Evaluating " << batch.size() << " foldable nodes using "
+              << num_threads << " threads";
+      BlockingCounter counter(batch.size());
+      for (int i = 0, end = batch.size(); i < end; ++i) {
+        thread_pool->Schedule([&evaluate, &counter, i]() {
+          evaluate(i);
+          counter.DecrementCount();
+        });
       }
+      counter.Wait();
     } else {
-      for (auto& output : fanout) {
-        if (IsFoldable(*output, &properties)) {
-          queue.push_back(output);
+      for (int i = 0, end = batch.size(); i < end; ++i) {
+        evaluate(i);
+      }
+    }
+
+    for (int i = 0, end = batch.size(); i < end; ++i) {
+      NodeDef* node = batch[i];
+      FoldedValue* value = &values[i];
+      // We need to record a copy of output nodes before FoldNode() modifies
+      // it. We also need to ensure that the fanout is sorted
+      // deterministically.
+      std::vector<NodeDef*> fanout =
+          node_map_->GetOutputsOrderedByNodeName(node->name());
+      Status s = value->status;
+      if (s.ok()) {
+        s = FoldNode(node, &value->const_nodes, output);
+      }
+      processed_nodes.insert(node->name());
+      if (!s.ok()) {
+        VLOG(1) << "Failed to fold node " << node->DebugString()
+                << "\nError message: " << s;
+        if (value->result_too_large) {
+          nodes_to_not_simplify->emplace(node->name());
+        }
+      } else {
+        if (value->const_nodes.size() == 1) {
+          folded_subgraph_bytes_[node->name()] = value->subgraph_bytes;
+        } else {
+          for (const NodeDef& const_node : value->const_nodes) {
+            if (!const_node.name().empty()) {
+              folded_subgraph_bytes_[const_node.name()] = value->subgraph_bytes;
+            }
+          }
+        }
+        for (auto& output : fanout) {
+          if (IsFoldable(*output, &properties)) {
+            queue.push_back(output);
+          }
         }
       }
     }
@@ -89,16 +89,29 @@ class ConstantFolding : public GraphOptimizer {
   bool MaybeFoldable(const NodeDef& node,
                      const GraphProperties* properties) const;
 
+  // Returns the number of bytes read by the already folded subgraphs feeding
+  // `node`, which approximates the compute saved by keeping them folded.
+  int64 FoldedInputBytes(const NodeDef& node) const;
+  // Returns the maximum size of a constant that can be materialized for a node
+  // whose inputs take `input_size_bytes` and whose folded subgraph reads
+  // `subgraph_bytes` overall.
+  static int64 MaterializedSizeBudget(int64 input_size_bytes,
+                                      int64 subgraph_bytes);
+
   Status EvaluateNode(const NodeDef& node,
                       const gtl::InlinedVector<TensorValue, 4>& inputs,
                       gtl::InlinedVector<TensorValue, 4>* output) const;
 
+  // Evaluates `node` and encodes its outputs as constant nodes. Only reads the
+  // graph, so it is safe to call concurrently for different nodes.
   Status EvaluateOneFoldable(const NodeDef& node, std::vector<NodeDef>* outputs,
-                             bool* result_too_large);
+                             bool* result_too_large, int64* subgraph_bytes);
 
   Status FoldMergeNode(NodeDef* node, GraphDef* output_graph);
-  Status FoldNode(NodeDef* node, GraphDef* output_graph,
-                  bool* result_too_large);
+  // Replaces `node` with the constants computed by EvaluateOneFoldable().
+  // `const_nodes` is ignored for Merge nodes.
+  Status FoldNode(NodeDef* node, std::vector<NodeDef>* const_nodes,
+                  GraphDef* output_graph);
 
   bool IsOnes(const NodeDef& node) const;
   bool IsZeros(const NodeDef& node) const;
@@ -333,6 +346,8 @@ class ConstantFolding : public GraphOptimizer {
   absl::flat_hash_set<string> nodes_allowlist_;
   absl::flat_hash_set<string> feed_nodes_;
   absl::flat_hash_map<string, bool> maybe_foldable_nodes_;
+  // Number of bytes read by the subgraph folded into each constant.
+  absl::flat_hash_map<string, int64> folded_subgraph_bytes_;
   bool has_fetch_;
   bool graph_modified_;
   bool graph_contains_assign_or_inplace_op_;
@@ -3029,6 +3029,93 @@ TEST_F(ConstantFoldingTest, LargeConstantNoSizeIncrease) {
   EXPECT_LT(output.ByteSizeLong(), sizeof(float) * large_constant_size + 500);
 }
 
+TEST_F(ConstantFoldingTest, LargeConstantFromFoldedSubgraph) {
+  // Outputs larger than kMaxConstantSize that grow beyond the size of their
+  // inputs are only folded if the subgraph they replace reads at least as many
+  // bytes as they occupy.
+  tensorflow::Scope scope = tensorflow::Scope::NewRootScope();
+  const int64 num_elements = 6 * 1024 * 1024 / sizeof(float);
+  Tensor x_t = GenerateRandomTensor<DT_FLOAT>(TensorShape({num_elements}));
+  Output x = ops::Const(scope.WithOpName("x"), Input::Initializer(x_t));
+  Output multiples = ops::Const(scope.WithOpName("multiples"), {2}, {1});
+  // 'y' reads 6MiB, so tiling it in 't1' materializes 12MiB worth of
+  // constants for 12MiB of inputs read by the folded subgraph.
+  Output y = ops::Square(scope.WithOpName("y"), x);
+  Output t1 = ops::Tile(scope.WithOpName("t1"), y, multiples);
+  // Tiling the original constant directly would only save reading 6MiB.
+  Output t2 = ops::Tile(scope.WithOpName("t2"), x, multiples);
+
+  GrapplerItem item;
+  TF_CHECK_OK(scope.ToGraphDef(&item.graph));
+
+  ConstantFolding optimizer(/*cpu_device=*/nullptr);
+  GraphDef output;
+  Status status = optimizer.Optimize(/*cluster=*/nullptr, item, &output);
+  TF_EXPECT_OK(status);
+
+  int found = 0;
+  for (const auto& node : output.node()) {
+    if (node.name() == "y") {
+      ++found;
+      EXPECT_EQ("Const", node.op());
+    } else if (node.name() == "t1") {
+      ++found;
+      EXPECT_EQ("Const", node.op());
+      Tensor t1_t;
+      ASSERT_TRUE(t1_t.FromProto(node.attr().at("value").tensor()));
+      ASSERT_EQ(2 * num_elements, t1_t.NumElements());
+      EXPECT_EQ(x_t.flat<float>()(0) * x_t.flat<float>()(0),
+                t1_t.flat<float>()(num_elements));
+    } else if (node.name() == "t2") {
+      ++found;
+      EXPECT_EQ("Tile", node.op());
+    }
+  }
+  EXPECT_EQ(3, found);
+}
+
+TEST_F(ConstantFoldingTest, FoldIndependentNodes) {
+  // Independent foldable nodes are evaluated concurrently: make sure they all
+  // get folded to the right values, with deterministic names.
+  tensorflow::Scope scope = tensorflow::Scope::NewRootScope();
+  const int kNumNodes = 32;
+  std::vector<string> fetch_nodes;
+  for (int i = 0; i < kNumNodes; ++i) {
+    Output a = ops::Const(scope.WithOpName(strings::StrCat("a", i)),
+                          static_cast<float>(i), {16});
+    Output b =
+        ops::Const(scope.WithOpName(strings::StrCat("b", i)), 1.0f, {16});
+    Output add = ops::Add(scope.WithOpName(strings::StrCat("add", i)), a, b);
+    Output mul =
+        ops::Mul(scope.WithOpName(strings::StrCat("mul", i)), add, add);
+    Output neg = ops::Neg(scope.WithOpName(strings::StrCat("neg", i)), mul);
+    fetch_nodes.push_back(strings::StrCat("neg", i));
+  }
+
+  GrapplerItem item;
+  item.fetch = fetch_nodes;
+  TF_CHECK_OK(scope.ToGraphDef(&item.graph));
+
+  ConstantFolding optimizer(/*cpu_device=*/nullptr);
+  GraphDef output;
+  Status status = optimizer.Optimize(/*cluster=*/nullptr, item, &output);
+  TF_EXPECT_OK(status);
+
+  EXPECT_EQ(kNumNodes, output.node_size());
+  for (const auto& node : output.node()) {
+    EXPECT_EQ("Const", node.op());
+    EXPECT_EQ(0, node.input_size());
+  }
+
+  auto tensors_expected = EvaluateNodes(item.graph, fetch_nodes);
+  auto tensors = EvaluateNodes(output, fetch_nodes);
+  ASSERT_EQ(fetch_nodes.size(), tensors_expected.size());
+  ASSERT_EQ(fetch_nodes.size(), tensors.size());
+  for (int i = 0; i < fetch_nodes.size(); ++i) {
+    test::ExpectTensorEqual<float>(tensors_expected[i], tensors[i]);
+  }
+}
+
 TEST_F(ConstantFoldingTest, MaterializeBroadcastGradientArgs) {
   tensorflow::Scope s = tensorflow::Scope::NewRootScope();
   Output a =
@@ -33,11 +33,11 @@ namespace {
 constexpr char kLegacyAutotune[] = "legacy_autotune";
 constexpr char kPrefetchDataset[] = "PrefetchDataset";
 
-constexpr std::array<const char*, 7> kAsyncDatasetOps = {
+constexpr std::array<const char*, 8> kAsyncDatasetOps = {
     "ExperimentalMapAndBatchDataset", "MapAndBatchDataset",
-    "ParallelInterleaveDatasetV2",    "ParallelInterleaveDatasetV3",
-    "ParallelInterleaveDatasetV4",    "ParallelMapDataset",
-    "ParallelMapDatasetV2",
+    "ParallelFilterDataset",          "ParallelInterleaveDatasetV2",
+    "ParallelInterleaveDatasetV3",    "ParallelInterleaveDatasetV4",
+    "ParallelMapDataset",             "ParallelMapDatasetV2",
 };
 
 }  // namespace
@@ -32,8 +32,9 @@ constexpr std::array<const char*, 3> kSloppyAttrOps = {
     "ParseExampleDataset",
 };
 
-constexpr std::array<const char*, 4> kDeterministicAttrOps = {
+constexpr std::array<const char*, 5> kDeterministicAttrOps = {
     "LegacyParallelInterleaveDatasetV2",
+    "ParallelFilterDataset",
     "ParallelInterleaveDatasetV3",
     "ParallelInterleaveDatasetV4",
     "ParallelMapDatasetV2",
@@ -35,7 +35,7 @@ using ConfigMap =
     std::map<string, tensorflow::RewriterConfig_CustomGraphOptimizer>;
 
 // tf.data optimizations, in the order we want to perform them.
-constexpr std::array<const char*, 17> kTFDataOptimizations = {
+constexpr std::array<const char*, 18> kTFDataOptimizations = {
     "noop_elimination",
     "disable_intra_op_parallelism",
     "shuffle_and_repeat_fusion",
@@ -43,6 +43,7 @@ constexpr std::array<const char*, 17> kTFDataOptimizations = {
     "filter_fusion",
     "filter_with_random_uniform_fusion",
     "map_and_filter_fusion",
+    "ragged_variant_elimination",
     "hoist_random_uniform",
     "map_parallelization",
     "map_and_batch_fusion",
@@ -0,0 +1,146 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/data/ragged_variant_elimination.h"
+
+#include "absl/container/flat_hash_set.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/grappler/clusters/cluster.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/mutable_graph_view.h"
+#include "tensorflow/core/grappler/op_types.h"
+#include "tensorflow/core/grappler/optimizers/custom_graph_optimizer_registry.h"
+#include "tensorflow/core/grappler/utils.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+constexpr char kToVariant[] = "RaggedTensorToVariant";
+constexpr char kFromVariant[] = "RaggedTensorFromVariant";
+
+// Returns true if `decode`, a RaggedTensorFromVariant, restores exactly the
+// ragged tensor that `encode`, a RaggedTensorToVariant, encoded. A batched
+// encoding holds one variant per row, whose ragged rank is one less than the
+// rank of the encoded tensor.
+bool IsRoundTrip(const NodeDef& encode, const NodeDef& decode) {
+  int64 ragged_rank;
+  bool batched_input;
+  DataType encode_values, encode_splits;
+  int64 input_ragged_rank, output_ragged_rank;
+  DataType decode_values, decode_splits;
+  if (!GetNodeAttr(encode, "RAGGED_RANK", &ragged_rank).ok() ||
+      !GetNodeAttr(encode, "batched_input", &batched_input).ok() ||
+      !GetNodeAttr(encode, "Tvalues", &encode_values).ok() ||
+      !GetNodeAttr(encode, "Tsplits", &encode_splits).ok() ||
+      !GetNodeAttr(decode, "input_ragged_rank", &input_ragged_rank).ok() ||
+      !GetNodeAttr(decode, "output_ragged_rank", &output_ragged_rank).ok() ||
+      !GetNodeAttr(decode, "Tvalues", &decode_values).ok() ||
+      !GetNodeAttr(decode, "Tsplits", &decode_splits).ok()) {
+    return false;
+  }
+  if (batched_input && ragged_rank == 0) return false;
+  // An input ragged rank of -1 is inferred from the rank of the variants,
+  // which always agrees with the encoding.
+  const int64 encoded_ragged_rank =
+      batched_input ? ragged_rank - 1 : ragged_rank;
+  return output_ragged_rank == ragged_rank &&
+         (input_ragged_rank == -1 ||
+          input_ragged_rank == encoded_ragged_rank) &&
+         encode_values == decode_values && encode_splits == decode_splits &&
+         encode.input_size() >= ragged_rank + 1;
+}
+
+}  // namespace
+
+Status RaggedVariantElimination::OptimizeAndCollectStats(
+    Cluster* cluster, const GrapplerItem& item, GraphDef* output,
+    OptimizationStats* stats) {
+  *output = item.graph;
+  MutableGraphView graph(output);
+  const auto nodes_to_preserve = item.NodesToPreserve();
+  absl::flat_hash_set<string> nodes_to_delete;
+  absl::flat_hash_set<string> encoders;
+
+  for (const NodeDef& node : item.graph.node()) {
+    if (node.op() != kFromVariant || nodes_to_preserve.count(node.name())) {
+      continue;
+    }
+    NodeDef* decode = graph.GetNode(node.name());
+    NodeDef* encode =
+        graph.GetRegularFanin(MutableGraphView::InputPort(decode, 0)).node;
+    if (encode == nullptr || encode->op() != kToVariant ||
+        !IsRoundTrip(*encode, *decode)) {
+      continue;
+    }
+    // The nodes controlled by the decoding node would lose their dependency.
+    if (!graph
+             .GetFanout(
+                 MutableGraphView::OutputPort(decode, Graph::kControlSlot))
+             .empty()) {
+      continue;
+    }
+
+    // Output i of the decoding node is input i of the encoding node: the
+    // nested splits followed by the dense values.
+    const int num_outputs = decode->attr().at("output_ragged_rank").i() + 1;
+    for (int i = 0; i < num_outputs; ++i) {
+      const string encoded_name = encode->input(i);
+      const TensorId encoded = ParseTensorName(encoded_name);
+      if (IsControlInput(encoded)) {
+        return errors::Internal("Malformed ", kToVariant, " node ",
+                                encode->name());
+      }
+      // Copy the fanouts, which the updates modify.
+      const auto fanouts =
+          graph.GetFanout(MutableGraphView::OutputPort(decode, i));
+      for (const MutableGraphView::InputPort& fanout : fanouts) {
+        TF_RETURN_IF_ERROR(graph.UpdateRegularFaninByPort(
+            fanout.node->name(), fanout.port_id, encoded));
+      }
+    }
+    nodes_to_delete.insert(decode->name());
+    encoders.insert(encode->name());
+    stats->num_changes++;
+  }
+  TF_RETURN_IF_ERROR(graph.DeleteNodes(nodes_to_delete));
+
+  // Delete the encoding nodes whose variants are no longer used.
+  nodes_to_delete.clear();
+  for (const string& name : encoders) {
+    const NodeDef* encode = graph.GetNode(name);
+    if (!nodes_to_preserve.count(name) &&
+        graph.NumFanouts(*encode, /*include_controlled_nodes=*/true) == 0) {
+      nodes_to_delete.insert(name);
+    }
+  }
+  TF_RETURN_IF_ERROR(graph.DeleteNodes(nodes_to_delete));
+  return Status::OK();
+}
+
+void RaggedVariantElimination::Feedback(Cluster* cluster,
+                                        const GrapplerItem& item,
+                                        const GraphDef& optimize_output,
+                                        double result) {
+  // no-op
+}
+
+REGISTER_GRAPH_OPTIMIZER_AS(RaggedVariantElimination,
+                            "ragged_variant_elimination");
+
+}  // namespace grappler
+}  // namespace tensorflow
@@ -0,0 +1,124 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/data/ragged_variant_elimination.h"
+
+#include "tensorflow/core/framework/attr_value_util.h"
+#include "tensorflow/core/framework/function_testlib.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/optimizers/data/graph_utils.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+using test::function::NDef;
+
+NodeDef MakeEncodeNode(const string& name, bool batched_input) {
+  return NDef(name, "RaggedTensorToVariant", {"splits", "values"},
+              {{"RAGGED_RANK", 1},
+               {"Tvalues", DT_FLOAT},
+               {"Tsplits", DT_INT64},
+               {"batched_input", batched_input}});
+}
+
+NodeDef MakeDecodeNode(const string& name, const string& input,
+                       int input_ragged_rank, int output_ragged_rank) {
+  return NDef(name, "RaggedTensorFromVariant", {input},
+              {{"input_ragged_rank", input_ragged_rank},
+               {"output_ragged_rank", output_ragged_rank},
+               {"Tvalues", DT_FLOAT},
+               {"Tsplits", DT_INT64}});
+}
+
+GrapplerItem MakeItem(const NodeDef& encode, const NodeDef& decode) {
+  GrapplerItem item;
+  item.graph = test::function::GDef(
+      {NDef("splits", "Const", {}, {{"value", 0}, {"dtype", DT_INT64}}),
+       NDef("values", "Const", {}, {{"value", 0.0f}, {"dtype", DT_FLOAT}}),
+       encode, decode,
+       NDef("use_splits", "Identity", {decode.name() + ":0"},
+            {{"T", DT_INT64}}),
+       NDef("use_values", "Identity", {decode.name() + ":1"},
+            {{"T", DT_FLOAT}})},
+      {});
+  return item;
+}
+
+TEST(RaggedVariantEliminationTest, EliminatesRoundTrip) {
+  GrapplerItem item =
+      MakeItem(MakeEncodeNode("encode", /*batched_input=*/false),
+               MakeDecodeNode("decode", "encode", 1, 1));
+
+  RaggedVariantElimination optimizer;
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+  EXPECT_FALSE(graph_utils::ContainsGraphNodeWithName("encode", output));
+  EXPECT_FALSE(graph_utils::ContainsGraphNodeWithName("decode", output));
+  const NodeDef& use_splits =
+      output.node(graph_utils::FindGraphNodeWithName("use_splits", output));
+  const NodeDef& use_values =
+      output.node(graph_utils::FindGraphNodeWithName("use_values", output));
+  EXPECT_EQ("splits", use_splits.input(0));
+  EXPECT_EQ("values", use_values.input(0));
+}
+
+TEST(RaggedVariantEliminationTest, EliminatesBatchedRoundTrip) {
+  GrapplerItem item =
+      MakeItem(MakeEncodeNode("encode", /*batched_input=*/true),
+               MakeDecodeNode("decode", "encode", -1, 1));
+
+  RaggedVariantElimination optimizer;
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+  EXPECT_FALSE(
+      graph_utils::ContainsNodeWithOp("RaggedTensorToVariant", output));
+  EXPECT_FALSE(
+      graph_utils::ContainsNodeWithOp("RaggedTensorFromVariant", output));
+}
+
+TEST(RaggedVariantEliminationTest, KeepsDecodingOfRows) {
+  // Decodes the rows of a batched encoding one by one, which differs from the
+  // encoded tensor.
+  GrapplerItem item =
+      MakeItem(MakeEncodeNode("encode", /*batched_input=*/true),
+               MakeDecodeNode("decode", "encode", 0, 0));
+
+  RaggedVariantElimination optimizer;
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+  EXPECT_TRUE(graph_utils::ContainsGraphNodeWithName("encode", output));
+  EXPECT_TRUE(graph_utils::ContainsGraphNodeWithName("decode", output));
+}
+
+TEST(RaggedVariantEliminationTest, KeepsEncodingWithOtherUses) {
+  GrapplerItem item =
+      MakeItem(MakeEncodeNode("encode", /*batched_input=*/false),
+               MakeDecodeNode("decode", "encode", 1, 1));
+  *item.graph.add_node() =
+      NDef("use_variant", "Identity", {"encode"}, {{"T", DT_VARIANT}});
+
+  RaggedVariantElimination optimizer;
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+  EXPECT_TRUE(graph_utils::ContainsGraphNodeWithName("encode", output));
+  EXPECT_FALSE(graph_utils::ContainsGraphNodeWithName("decode", output));
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
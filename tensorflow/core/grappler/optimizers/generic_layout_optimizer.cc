@@ -117,6 +117,18 @@ inline std::pair<string, string> GetSrcAndDstDataFormats(
   return {src_format, dst_format};
 }
 
+// Returns true if the graph has a layout sensitive op in `data_format`, which
+// is cheap to check before initializing the TransposeContext.
+bool HasLayoutSensitiveOpWithDataFormat(const GraphDef& graph,
+                                        absl::string_view data_format) {
+  for (const NodeDef& node : graph.node()) {
+    if (!IsLayoutSensitiveOp(node)) continue;
+    auto it = node.attr().find("data_format");
+    if (it != node.attr().end() && it->second.s() == data_format) return true;
+  }
+  return false;
+}
+
 Status ExpandLayoutSensitiveOp(TransposeContext* context,
                                TransposerFactory* transposer_factory) {
   const int num_nodes = context->num_nodes;
@@ -403,9 +415,22 @@ Status GenericLayoutOptimizer::Optimize(Cluster* cluster,
   const auto num_gpus_and_num_volta = GetNumGPUs(*cluster);
   const int num_gpus = num_gpus_and_num_volta.first;
   if (num_gpus < 1) {
-    return errors::Aborted(
-        "No GPUs found: GenericLayoutOptimizer is currently only tuned for "
-        "GPU.");
+    // CPU kernels are implemented for NHWC, and converting NCHW graphs must be
+    // requested explicitly. MKL builds convert layouts in mkl_layout_pass.
+#ifdef INTEL_MKL
+    const bool convert_on_cpu = false;
+#else
+    const bool convert_on_cpu =
+        cpu_layout_conversion_ == RewriterConfig::NCHW_TO_NHWC;
+#endif  // INTEL_MKL
+    if (!convert_on_cpu) {
+      return errors::Aborted(
+          "No GPUs found: GenericLayoutOptimizer is currently only tuned for "
+          "GPU.");
+    }
+    if (!HasLayoutSensitiveOpWithDataFormat(item.graph, kNCHW)) {
+      return errors::Aborted("Nothing to do.");
+    }
   }
 
   const bool is_aggressive = opt_level_ == RewriterConfig::AGGRESSIVE;
@@ -414,10 +439,14 @@ Status GenericLayoutOptimizer::Optimize(Cluster* cluster,
   TF_RETURN_IF_ERROR(
       TransposeContext::InitializeTransposeContext(item, cluster, &context));
 
-  const auto src_dst_formats =
-      GetSrcAndDstDataFormats(context, num_gpus, num_gpus_and_num_volta.second);
-  context.AssignDeviceAndDataFormats(kGPU, src_dst_formats.first,
-                                     src_dst_formats.second);
+  if (num_gpus > 0) {
+    const auto src_dst_formats = GetSrcAndDstDataFormats(
+        context, num_gpus, num_gpus_and_num_volta.second);
+    context.AssignDeviceAndDataFormats(kGPU, src_dst_formats.first,
+                                       src_dst_formats.second);
+  } else {
+    context.AssignDeviceAndDataFormats(kCPU, kNCHW, kNHWC);
+  }
 
   TransposerFactory transposer_factory;
   TF_RETURN_IF_ERROR(ExpandLayoutSensitiveOp(&context, &transposer_factory));
@@ -27,7 +27,11 @@ class GenericLayoutOptimizer : public GraphOptimizer {
  public:
   GenericLayoutOptimizer() : GenericLayoutOptimizer(RewriterConfig::DEFAULT) {}
   explicit GenericLayoutOptimizer(RewriterConfig::Toggle opt_level)
-      : opt_level_(opt_level) {}
+      : GenericLayoutOptimizer(opt_level,
+                               RewriterConfig::NO_CONVERSION_ON_CPU) {}
+  GenericLayoutOptimizer(RewriterConfig::Toggle opt_level,
+                         RewriterConfig::CpuLayout cpu_layout_conversion)
+      : opt_level_(opt_level), cpu_layout_conversion_(cpu_layout_conversion) {}
   ~GenericLayoutOptimizer() override = default;
 
   string name() const override { return "layout"; };
@@ -42,6 +46,7 @@ class GenericLayoutOptimizer : public GraphOptimizer {
 
  private:
   RewriterConfig::Toggle opt_level_;
+  RewriterConfig::CpuLayout cpu_layout_conversion_;
 };
 
 }  // namespace grappler
@@ -315,6 +315,84 @@ TEST_F(GenericLayoutOptimizerTest, CPUDevice) {
   VerifyDataFormatAttributeMatch(conv_node, "NHWC");
 }
 
+TEST_F(GenericLayoutOptimizerTest, CPUDeviceNCHWToNHWC) {
+  DeviceProperties cpu_device;
+  cpu_device.set_type("CPU");
+  cpu_device.set_frequency(1000);
+  cpu_device.set_num_cores(4);
+  cpu_device.set_memory_size(1024 * 1024);
+  VirtualCluster cpu_cluster({{"/CPU:0", cpu_device}});
+  TF_ASSERT_OK(cpu_cluster.Provision());
+
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Tensor input_data(DT_FLOAT, TensorShape({8, 3, 4, 4}));
+  test::FillIota<float>(&input_data, 1.0f);
+  Output input =
+      ops::Const(s.WithOpName("Input"), Input::Initializer(input_data));
+  Tensor filter_data(DT_FLOAT, TensorShape({2, 2, 3, 2}));
+  test::FillIota<float>(&filter_data, 1.0f);
+  Output filter =
+      ops::Const(s.WithOpName("Filter"), Input::Initializer(filter_data));
+  Tensor bias_data(DT_FLOAT, TensorShape({2}));
+  test::FillIota<float>(&bias_data, 1.0f);
+  Output bias = ops::Const(s.WithOpName("Bias"), Input::Initializer(bias_data));
+
+  Output conv = ops::Conv2D(s.WithOpName("Conv2D").WithDevice("/CPU:0"), input,
+                            filter, {1, 1, 1, 1}, "VALID",
+                            ops::Conv2D::DataFormat("NCHW"));
+  Output relu = ops::Relu(s.WithOpName("Relu").WithDevice("/CPU:0"), conv);
+  Output bias_add =
+      ops::BiasAdd(s.WithOpName("BiasAdd").WithDevice("/CPU:0"), relu, bias,
+                   ops::BiasAdd::DataFormat("NCHW"));
+  Output fetch = ops::Identity(s.WithOpName("Fetch"), {bias_add});
+  GrapplerItem item;
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+  item.fetch = {"Fetch"};
+
+  // Without explicit CPU layout conversion the graph is left as is.
+  {
+    GenericLayoutOptimizer optimizer;
+    GraphDef output;
+    Status status = optimizer.Optimize(&cpu_cluster, item, &output);
+    EXPECT_EQ(status.code(), error::ABORTED);
+  }
+
+  GenericLayoutOptimizer optimizer(RewriterConfig::DEFAULT,
+                                   RewriterConfig::NCHW_TO_NHWC);
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(&cpu_cluster, item, &output));
+
+  Status status;
+  utils::GraphView graph_view(&output, &status);
+  TF_ASSERT_OK(status);
+  auto* conv_node = graph_view.GetNode("Conv2D");
+  ASSERT_NE(conv_node, nullptr);
+  VerifyDataFormatAttributeMatch(conv_node, "NHWC");
+  auto* bias_add_node = graph_view.GetNode("BiasAdd");
+  ASSERT_NE(bias_add_node, nullptr);
+  VerifyDataFormatAttributeMatch(bias_add_node, "NHWC");
+
+  // NHWC is kept across Conv2D, Relu and BiasAdd, so only the input of the
+  // convolution and the output of the chain are transposed.
+  int num_transposes = 0;
+  for (const NodeDef& node : output.node()) {
+    if (node.op() == "Transpose") ++num_transposes;
+  }
+  EXPECT_EQ(num_transposes, 2);
+  auto* relu_node = graph_view.GetNode("Relu");
+  ASSERT_NE(relu_node, nullptr);
+  VerifyRegularFaninMatch(relu_node, 0, "Conv2D", 0);
+  VerifyRegularFaninMatch(bias_add_node, 0, "Relu", 0);
+
+  // CPU kernels do not implement NCHW Conv2D, so only the converted graph can
+  // be evaluated.
+  auto tensors = EvaluateNodes(output, item.fetch);
+  ASSERT_EQ(tensors.size(), 1);
+  EXPECT_EQ(tensors[0].shape(), TensorShape({8, 2, 3, 3}));
+
+  TF_ASSERT_OK(cpu_cluster.Shutdown());
+}
+
 TEST_F(GenericLayoutOptimizerTest, Connectivity) {
 #if !(GOOGLE_CUDA || TENSORFLOW_USE_ROCM)
   GTEST_SKIP() << "Neither CUDA nor ROCm is enabled";
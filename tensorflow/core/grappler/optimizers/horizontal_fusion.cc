@@ -0,0 +1,194 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/horizontal_fusion.h"
+
+#include <algorithm>
+#include <map>
+#include <tuple>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/grappler/clusters/cluster.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/op_types.h"
+#include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/grappler/utils/topological_sort.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/util/device_name_utils.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+// Maximum number of nodes fused together. Larger groups are split, so that a
+// single fused node doesn't delay the fanout of too many independent ops.
+constexpr int kMaxFusedNodes = 32;
+
+bool IsSupportedOp(const NodeDef& node) {
+  static const auto* const kSupportedOps = new absl::flat_hash_set<string>(
+      {"Abs", "BiasAdd", "Exp", "Neg", "Relu", "Relu6", "Rsqrt", "Sigmoid",
+       "Sqrt", "Square", "Tanh"});
+  return kSupportedOps->contains(node.op());
+}
+
+bool IsOnGpu(const NodeDef& node) {
+  DeviceNameUtils::ParsedName parsed_name;
+  return DeviceNameUtils::ParseFullName(node.device(), &parsed_name) &&
+         parsed_name.has_type && parsed_name.type == DEVICE_GPU;
+}
+
+bool HasGpu(const Cluster& cluster) {
+  for (const auto& device : cluster.GetDevices()) {
+    if (device.second.type() == DEVICE_GPU) return true;
+  }
+  return false;
+}
+
+bool IsFusible(const NodeDef& node,
+               const std::unordered_set<string>& nodes_to_preserve) {
+  if (!IsSupportedOp(node) || !IsOnGpu(node) ||
+      nodes_to_preserve.count(node.name()) > 0 ||
+      node.attr().count("_class") > 0) {
+    return false;
+  }
+  const DataType dtype = GetDataTypeFromAttr(node, "T");
+  if (dtype != DT_HALF && dtype != DT_FLOAT && dtype != DT_DOUBLE) {
+    return false;
+  }
+  if (IsBiasAdd(node)) {
+    if (node.input_size() < 2 || IsControlInput(node.input(1))) return false;
+    auto it = node.attr().find("data_format");
+    if (it != node.attr().end() && it->second.s() != "NHWC") return false;
+  } else if (node.input_size() < 1 || IsControlInput(node.input(0))) {
+    return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+Status HorizontalFusion::Optimize(Cluster* cluster, const GrapplerItem& item,
+                                  GraphDef* optimized_graph) {
+  if (cluster == nullptr || !HasGpu(*cluster)) {
+    return errors::Aborted("Nothing to do.");
+  }
+  // A dead input would propagate to all the outputs of a fused node, so we
+  // don't fuse anything in graphs with v1 control flow.
+  for (const NodeDef& node : item.graph.node()) {
+    if (IsSwitch(node) || IsMerge(node) || IsEnter(node)) {
+      return errors::Aborted("Nothing to do.");
+    }
+  }
+
+  *optimized_graph = item.graph;
+  GraphDef* graph = optimized_graph;
+  const std::unordered_set<string> nodes_to_preserve = item.NodesToPreserve();
+
+  std::vector<const NodeDef*> topo_order;
+  TF_RETURN_IF_ERROR(ComputeTopologicalOrder(*graph, &topo_order));
+  NodeMap node_map(graph);
+
+  // Nodes at the same depth (the length of the longest path from a source of
+  // the graph) can't depend on each other, so fusing them can't introduce a
+  // cycle.
+  absl::flat_hash_map<const NodeDef*, int> depth;
+  for (const NodeDef* node : topo_order) {
+    int node_depth = 0;
+    for (const string& input : node->input()) {
+      const NodeDef* fanin = node_map.GetNode(input);
+      if (fanin != nullptr) node_depth = std::max(node_depth, depth[fanin] + 1);
+    }
+    depth[node] = node_depth;
+  }
+
+  using GroupKey = std::tuple<int, string, DataType, string>;
+  std::map<GroupKey, std::vector<NodeDef*>> groups;
+  for (int i = 0; i < graph->node_size(); ++i) {
+    NodeDef* node = graph->mutable_node(i);
+    if (!IsFusible(*node, nodes_to_preserve)) continue;
+    groups[GroupKey(depth[node], node->op(), GetDataTypeFromAttr(*node, "T"),
+                    node->device())]
+        .push_back(node);
+  }
+
+  bool changed = false;
+  for (auto& group : groups) {
+    std::vector<NodeDef*>& nodes = group.second;
+    for (int begin = 0, end = nodes.size(); begin < end;
+         begin += kMaxFusedNodes) {
+      const int num_fused = std::min<int>(kMaxFusedNodes, end - begin);
+      if (num_fused < 2) continue;
+      const std::vector<NodeDef*> fused_nodes(
+          nodes.begin() + begin, nodes.begin() + begin + num_fused);
+      const NodeDef& first = *fused_nodes.front();
+      const string fused_name =
+          AddPrefixToNodeName(first.name(), kHorizontalFusion);
+      if (node_map.NodeExists(fused_name)) continue;
+
+      NodeDef* fused = graph->add_node();
+      fused->set_name(fused_name);
+      fused->set_op("_MultiTensorCwise");
+      fused->set_device(first.device());
+      const bool is_bias_add = IsBiasAdd(first);
+      for (const NodeDef* node : fused_nodes) {
+        fused->add_input(node->input(0));
+      }
+      if (is_bias_add) {
+        for (const NodeDef* node : fused_nodes) {
+          fused->add_input(node->input(1));
+        }
+      }
+      absl::flat_hash_set<string> control_inputs;
+      for (const NodeDef* node : fused_nodes) {
+        for (const string& input : node->input()) {
+          if (IsControlInput(input) && control_inputs.insert(input).second) {
+            fused->add_input(input);
+          }
+        }
+      }
+      auto* attr = fused->mutable_attr();
+      (*attr)["T"].set_type(GetDataTypeFromAttr(first, "T"));
+      (*attr)["N"].set_i(num_fused);
+      (*attr)["num_bias"].set_i(is_bias_add ? num_fused : 0);
+      (*attr)["op"].set_s(first.op());
+      node_map.AddNode(fused_name, fused);
+
+      for (int i = 0; i < num_fused; ++i) {
+        NodeDef* node = fused_nodes[i];
+        VLOG(2) << "Fusing " << node->name() << " into " << fused_name;
+        const DataType dtype = GetDataTypeFromAttr(*node, "T");
+        node->set_op("Identity");
+        node->clear_input();
+        node->add_input(strings::StrCat(fused_name, ":", i));
+        node->clear_attr();
+        (*node->mutable_attr())["T"].set_type(dtype);
+      }
+      changed = true;
+    }
+  }
+
+  if (!changed) {
+    return errors::Aborted("Nothing to do.");
+  }
+  return Status::OK();
+}
+
+}  // end namespace grappler
+}  // end namespace tensorflow
@@ -0,0 +1,57 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_HORIZONTAL_FUSION_H_
+#define TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_HORIZONTAL_FUSION_H_
+
+#include "tensorflow/core/grappler/optimizers/graph_optimizer.h"
+#include "tensorflow/core/protobuf/rewriter_config.pb.h"
+
+namespace tensorflow {
+namespace grappler {
+
+constexpr char kHorizontalFusion[] = "HorizontalFusion";
+
+// Fuses independent element-wise ops of the same type and data type placed on
+// the same GPU into a single _MultiTensorCwise node, which processes all the
+// tensors with one kernel launch. Each fused node is replaced by an Identity
+// reading the corresponding output of the _MultiTensorCwise node, so that its
+// fanout and name are preserved.
+class HorizontalFusion : public GraphOptimizer {
+ public:
+  HorizontalFusion() : HorizontalFusion(RewriterConfig::ON) {}
+  explicit HorizontalFusion(RewriterConfig::Toggle opt_level)
+      : opt_level_(opt_level) {}
+
+  ~HorizontalFusion() override {}
+
+  string name() const override { return "horizontal_fusion"; };
+
+  bool UsesFunctionLibrary() const override { return false; }
+
+  Status Optimize(Cluster* cluster, const GrapplerItem& item,
+                  GraphDef* optimized_graph) override;
+
+  void Feedback(Cluster* cluster, const GrapplerItem& item,
+                const GraphDef& optimized_graph, double result) override {}
+
+ private:
+  RewriterConfig::Toggle opt_level_;
+};
+
+}  // end namespace grappler
+}  // end namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_HORIZONTAL_FUSION_H_
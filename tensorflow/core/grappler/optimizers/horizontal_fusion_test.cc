@@ -0,0 +1,177 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/horizontal_fusion.h"
+
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/grappler/clusters/virtual_cluster.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/utils/grappler_test.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/protobuf/device_properties.pb.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+constexpr char kGpu[] = "/job:localhost/replica:0/task:0/device:GPU:0";
+
+class HorizontalFusionTest : public GrapplerTest {
+ protected:
+  void SetUp() override {
+    DeviceProperties cpu_device;
+    cpu_device.set_type("CPU");
+    DeviceProperties gpu_device;
+    gpu_device.set_type("GPU");
+    cluster_.reset(new VirtualCluster(
+        {{"/job:localhost/replica:0/task:0/device:CPU:0", cpu_device},
+         {kGpu, gpu_device}}));
+    TF_CHECK_OK(cluster_->Provision());
+  }
+
+  void TearDown() override { TF_CHECK_OK(cluster_->Shutdown()); }
+
+  std::unique_ptr<Cluster> cluster_;
+};
+
+TEST_F(HorizontalFusionTest, FuseIndependentRelus) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope().WithDevice(kGpu);
+  Output a = ops::Placeholder(s.WithOpName("a"), DT_FLOAT);
+  Output b = ops::Placeholder(s.WithOpName("b"), DT_FLOAT);
+  Output c = ops::Placeholder(s.WithOpName("c"), DT_FLOAT);
+  Output relu_a = ops::Relu(s.WithOpName("relu_a"), a);
+  Output relu_b = ops::Relu(s.WithOpName("relu_b"), b);
+  // Depends on relu_a, so it can't be fused with it.
+  Output relu_c = ops::Relu(s.WithOpName("relu_c"), relu_a);
+  Output tanh_c = ops::Tanh(s.WithOpName("tanh_c"), c);
+  Output sum = ops::AddN(s.WithOpName("sum"), {relu_b, relu_c, tanh_c});
+
+  GrapplerItem item;
+  item.fetch = {"sum"};
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  HorizontalFusion optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(cluster_.get(), item, &output));
+
+  EXPECT_EQ(output.node_size(), item.graph.node_size() + 1);
+  int found = 0;
+  for (const NodeDef& node : output.node()) {
+    if (node.name() == "HorizontalFusion/relu_a") {
+      ++found;
+      EXPECT_EQ(node.op(), "_MultiTensorCwise");
+      EXPECT_EQ(node.device(), kGpu);
+      ASSERT_EQ(node.input_size(), 2);
+      EXPECT_EQ(node.input(0), "a");
+      EXPECT_EQ(node.input(1), "b");
+      EXPECT_EQ(node.attr().at("N").i(), 2);
+      EXPECT_EQ(node.attr().at("num_bias").i(), 0);
+      EXPECT_EQ(node.attr().at("op").s(), "Relu");
+      EXPECT_EQ(node.attr().at("T").type(), DT_FLOAT);
+    } else if (node.name() == "relu_a" || node.name() == "relu_b") {
+      ++found;
+      EXPECT_EQ(node.op(), "Identity");
+      ASSERT_EQ(node.input_size(), 1);
+      EXPECT_EQ(node.input(0), node.name() == "relu_a"
+                                   ? "HorizontalFusion/relu_a:0"
+                                   : "HorizontalFusion/relu_a:1");
+    } else if (node.name() == "relu_c" || node.name() == "tanh_c") {
+      ++found;
+      EXPECT_NE(node.op(), "Identity");
+    }
+  }
+  EXPECT_EQ(found, 5);
+}
+
+TEST_F(HorizontalFusionTest, FuseBiasAdds) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope().WithDevice(kGpu);
+  Output a = ops::Placeholder(s.WithOpName("a"), DT_FLOAT);
+  Output b = ops::Placeholder(s.WithOpName("b"), DT_FLOAT);
+  Output bias_a = ops::Placeholder(s.WithOpName("bias_a"), DT_FLOAT);
+  Output bias_b = ops::Placeholder(s.WithOpName("bias_b"), DT_FLOAT);
+  Output add_a = ops::BiasAdd(s.WithOpName("add_a"), a, bias_a);
+  Output add_b = ops::BiasAdd(s.WithOpName("add_b"), b, bias_b);
+  Output nchw = ops::BiasAdd(s.WithOpName("nchw"), b, bias_a,
+                             ops::BiasAdd::DataFormat("NCHW"));
+  Output sum = ops::AddN(s.WithOpName("sum"), {add_a, add_b, nchw});
+
+  GrapplerItem item;
+  item.fetch = {"sum"};
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  HorizontalFusion optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(cluster_.get(), item, &output));
+
+  int found = 0;
+  for (const NodeDef& node : output.node()) {
+    if (node.op() == "_MultiTensorCwise") {
+      ++found;
+      ASSERT_EQ(node.input_size(), 4);
+      EXPECT_EQ(node.input(0), "a");
+      EXPECT_EQ(node.input(1), "b");
+      EXPECT_EQ(node.input(2), "bias_a");
+      EXPECT_EQ(node.input(3), "bias_b");
+      EXPECT_EQ(node.attr().at("num_bias").i(), 2);
+      EXPECT_EQ(node.attr().at("op").s(), "BiasAdd");
+    } else if (node.name() == "nchw") {
+      ++found;
+      EXPECT_EQ(node.op(), "BiasAdd");
+    }
+  }
+  EXPECT_EQ(found, 2);
+}
+
+TEST_F(HorizontalFusionTest, NoFusionOnCpu) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope().WithDevice(
+      "/job:localhost/replica:0/task:0/device:CPU:0");
+  Output a = ops::Placeholder(s.WithOpName("a"), DT_FLOAT);
+  Output b = ops::Placeholder(s.WithOpName("b"), DT_FLOAT);
+  Output relu_a = ops::Relu(s.WithOpName("relu_a"), a);
+  Output relu_b = ops::Relu(s.WithOpName("relu_b"), b);
+  Output sum = ops::AddN(s.WithOpName("sum"), {relu_a, relu_b});
+
+  GrapplerItem item;
+  item.fetch = {"sum"};
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  HorizontalFusion optimizer;
+  GraphDef output;
+  Status status = optimizer.Optimize(cluster_.get(), item, &output);
+  EXPECT_TRUE(errors::IsAborted(status));
+}
+
+TEST_F(HorizontalFusionTest, KeepNodesToPreserve) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope().WithDevice(kGpu);
+  Output a = ops::Placeholder(s.WithOpName("a"), DT_FLOAT);
+  Output b = ops::Placeholder(s.WithOpName("b"), DT_FLOAT);
+  Output relu_a = ops::Relu(s.WithOpName("relu_a"), a);
+  Output relu_b = ops::Relu(s.WithOpName("relu_b"), b);
+
+  GrapplerItem item;
+  item.fetch = {"relu_a", "relu_b"};
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  HorizontalFusion optimizer;
+  GraphDef output;
+  Status status = optimizer.Optimize(cluster_.get(), item, &output);
+  EXPECT_TRUE(errors::IsAborted(status));
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
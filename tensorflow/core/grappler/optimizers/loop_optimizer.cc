@@ -22,12 +22,17 @@ limitations under the License.
 #include <unordered_set>
 #include <vector>
 
+#include "absl/algorithm/container.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
+#include "absl/strings/str_replace.h"
 #include "absl/strings/string_view.h"
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/function.h"
 #include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/node_def_util.h"
 #include "tensorflow/core/framework/op.h"
 #include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/framework/types.h"
@@ -38,10 +43,13 @@ limitations under the License.
 #include "tensorflow/core/grappler/optimizers/constant_folding.h"
 #include "tensorflow/core/grappler/optimizers/evaluation_utils.h"
 #include "tensorflow/core/grappler/utils/frame.h"
+#include "tensorflow/core/grappler/utils/functions.h"
 #include "tensorflow/core/grappler/utils/traversal.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/stringpiece.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
+#include "tensorflow/core/lib/strings/numbers.h"
+#include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/tensor_coding.h"
 #include "tensorflow/core/public/version.h"
@@ -714,6 +722,398 @@ Status CheckForDeadFanout(const MutableGraphView& view,
   return Status::OK();
 }
 
+// Returns true if `node`, from the body of a functional While loop, can be
+// evaluated once before the loop when all its inputs are loop invariant.
+bool IsHoistableFromWhileBody(const NodeDef& node,
+                              const FunctionLibraryDefinition& flib) {
+  if (flib.Find(node.op()) != nullptr) return false;
+  const OpDef* op_def = nullptr;
+  if (!OpRegistry::Global()->LookUpOpDef(node.op(), &op_def).ok() ||
+      op_def->is_stateful()) {
+    return false;
+  }
+  if (IsSwitch(node) || IsMerge(node) || ModifiesFrameInfo(node)) {
+    return false;
+  }
+  // Skip ops calling functions, e.g. StatelessIf: their bodies could not be
+  // checked for loop-dependent side effects.
+  for (const auto& attr : node.attr()) {
+    if (attr.second.has_func() || attr.second.list().func_size() > 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Turns a FunctionDef node input of the form "node:output:index" into the
+// name of the producing node and the position of the tensor in its outputs.
+bool ParseFunctionBodyInput(
+    const string& input,
+    const absl::flat_hash_map<string, const NodeDef*>& body_nodes,
+    string* node_name, int* port) {
+  const std::vector<string> parts = str_util::Split(input, ':');
+  if (parts.size() < 2 || parts.size() > 3) return false;
+  auto it = body_nodes.find(parts[0]);
+  if (it == body_nodes.end()) return false;
+  int index = 0;
+  if (parts.size() == 3 && !strings::safe_strto32(parts[2], &index)) {
+    return false;
+  }
+  const OpDef* op_def = nullptr;
+  if (!OpRegistry::Global()->LookUpOpDef(it->second->op(), &op_def).ok()) {
+    return false;
+  }
+  NameRangeMap outputs;
+  if (!NameRangesForNode(*it->second, *op_def, nullptr, &outputs).ok()) {
+    return false;
+  }
+  auto range = outputs.find(parts[1]);
+  if (range == outputs.end() ||
+      index >= range->second.second - range->second.first) {
+    return false;
+  }
+  *node_name = parts[0];
+  *port = range->second.first + index;
+  return true;
+}
+
+string FunctionBodyNodeName(const string& input) {
+  const string& name = IsControlInput(input) ? input.substr(1) : input;
+  return str_util::Split(name, ':')[0];
+}
+
+string UniqueFunctionName(const string& prefix,
+                          const FunctionLibraryDefinition& flib) {
+  string name = prefix;
+  for (int i = 1; flib.Find(name) != nullptr; ++i) {
+    name = strings::StrCat(prefix, "_", i);
+  }
+  return name;
+}
+
+// Moves the nodes of the body of a functional While loop that only depend on
+// loop invariant inputs out of the loop. Every hoisted tensor is computed once
+// before the loop, and is passed to the body as an additional loop variable
+// that the body forwards unchanged. Nodes that are only used to compute hoisted
+// tensors, including constants, are removed from the body. Loops whose body or
+// condition is used by other callers get specialized copies of the functions.
+Status HoistWhileLoopInvariants(NodeDef* while_node,
+                                const absl::flat_hash_set<string>& graph_nodes,
+                                FunctionLibraryDefinition* flib,
+                                GraphDef* optimized_graph) {
+  const auto& attr = while_node->attr();
+  const FunctionDef* body = flib->Find(attr.at("body").func().name());
+  const FunctionDef* cond = flib->Find(attr.at("cond").func().name());
+  if (body == nullptr || cond == nullptr || IsParametrized(*body) ||
+      IsParametrized(*cond)) {
+    return Status::OK();
+  }
+  const int num_loop_vars = body->signature().input_arg_size();
+  if (body->signature().output_arg_size() != num_loop_vars ||
+      attr.at("T").list().type_size() != num_loop_vars ||
+      NumNonControlInputs(*while_node) != num_loop_vars) {
+    return Status::OK();
+  }
+
+  absl::flat_hash_map<string, const NodeDef*> body_nodes;
+  for (const NodeDef& node : body->node_def()) {
+    body_nodes[node.name()] = &node;
+  }
+
+  // A loop variable is invariant if the body returns it unchanged, either
+  // directly or through an Identity node.
+  absl::flat_hash_map<string, int> invariant_args;
+  for (int i = 0; i < num_loop_vars; ++i) {
+    const string& arg_name = body->signature().input_arg(i).name();
+    auto ret = body->ret().find(body->signature().output_arg(i).name());
+    if (ret == body->ret().end()) return Status::OK();
+    const string& ret_input = ret->second;
+    bool is_invariant = ret_input == arg_name;
+    if (!is_invariant) {
+      auto it = body_nodes.find(FunctionBodyNodeName(ret_input));
+      is_invariant = it != body_nodes.end() && IsIdentity(*it->second) &&
+                     it->second->input_size() == 1 &&
+                     it->second->input(0) == arg_name;
+    }
+    if (is_invariant) invariant_args[arg_name] = i;
+  }
+
+  absl::flat_hash_set<string> control_ret_nodes;
+  for (const auto& control_ret : body->control_ret()) {
+    control_ret_nodes.insert(control_ret.second);
+  }
+
+  // Find the loop invariant nodes. The function body is not necessarily
+  // sorted topologically, so we iterate until we reach a fixed point.
+  absl::flat_hash_set<string> invariant_nodes;
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (const NodeDef& node : body->node_def()) {
+      if (invariant_nodes.contains(node.name()) ||
+          control_ret_nodes.contains(node.name()) ||
+          !IsHoistableFromWhileBody(node, *flib)) {
+        continue;
+      }
+      bool is_invariant = true;
+      for (const string& input : node.input()) {
+        if (IsControlInput(input) ||
+            (!invariant_args.contains(input) &&
+             !invariant_nodes.contains(FunctionBodyNodeName(input)))) {
+          is_invariant = false;
+          break;
+        }
+      }
+      if (is_invariant) {
+        invariant_nodes.insert(node.name());
+        changed = true;
+      }
+    }
+  }
+
+  // Collect the invariant tensors consumed by the rest of the loop. Constants
+  // and forwarded loop variables are cheap to produce at every iteration, so
+  // they are not worth an additional loop variable.
+  std::vector<std::pair<string, int>> hoisted_tensors;
+  absl::flat_hash_map<string, int> hoisted_inputs;
+  const auto maybe_hoist = [&](const string& input) {
+    if (IsControlInput(input) || invariant_args.contains(input)) return;
+    string node_name;
+    int port;
+    if (!ParseFunctionBodyInput(input, body_nodes, &node_name, &port) ||
+        !invariant_nodes.contains(node_name)) {
+      return;
+    }
+    const NodeDef& node = *body_nodes[node_name];
+    if (IsConstant(node) || IsIdentity(node)) return;
+    const auto tensor = std::make_pair(node_name, port);
+    auto it = absl::c_find(hoisted_tensors, tensor);
+    if (it == hoisted_tensors.end()) {
+      it = hoisted_tensors.insert(hoisted_tensors.end(), tensor);
+    }
+    hoisted_inputs[input] = it - hoisted_tensors.begin();
+  };
+  for (const NodeDef& node : body->node_def()) {
+    if (invariant_nodes.contains(node.name())) continue;
+    for (const string& input : node.input()) maybe_hoist(input);
+  }
+  for (const auto& output_arg : body->signature().output_arg()) {
+    maybe_hoist(body->ret().at(output_arg.name()));
+  }
+  if (hoisted_tensors.empty()) return Status::OK();
+
+  // Copy the nodes computing the hoisted tensors in front of the loop.
+  absl::flat_hash_set<string> nodes_to_copy;
+  std::vector<string> stack;
+  for (const auto& tensor : hoisted_tensors) stack.push_back(tensor.first);
+  while (!stack.empty()) {
+    const string node_name = stack.back();
+    stack.pop_back();
+    if (!nodes_to_copy.insert(node_name).second) continue;
+    for (const string& input : body_nodes[node_name]->input()) {
+      if (!invariant_args.contains(input)) {
+        stack.push_back(FunctionBodyNodeName(input));
+      }
+    }
+  }
+  const auto hoisted_node_name = [while_node](const string& node_name) {
+    return strings::StrCat(while_node->name(), "/", kLoopOptimizer, "/",
+                           node_name);
+  };
+  for (const string& node_name : nodes_to_copy) {
+    if (graph_nodes.contains(hoisted_node_name(node_name))) {
+      return Status::OK();
+    }
+  }
+  std::vector<DataType> hoisted_types;
+  for (const auto& tensor : hoisted_tensors) {
+    const NodeDef& node = *body_nodes[tensor.first];
+    const OpDef* op_def = nullptr;
+    TF_RETURN_IF_ERROR(OpRegistry::Global()->LookUpOpDef(node.op(), &op_def));
+    DataType type;
+    TF_RETURN_IF_ERROR(OutputTypeForNode(node, *op_def, tensor.second, &type));
+    hoisted_types.push_back(type);
+  }
+
+  for (const NodeDef& node : body->node_def()) {
+    if (!nodes_to_copy.contains(node.name())) continue;
+    NodeDef* hoisted = optimized_graph->add_node();
+    *hoisted = node;
+    hoisted->set_name(hoisted_node_name(node.name()));
+    hoisted->set_device(while_node->device());
+    hoisted->clear_input();
+    for (const string& input : node.input()) {
+      auto arg = invariant_args.find(input);
+      if (arg != invariant_args.end()) {
+        hoisted->add_input(while_node->input(arg->second));
+        continue;
+      }
+      string node_name;
+      int port;
+      if (!ParseFunctionBodyInput(input, body_nodes, &node_name, &port)) {
+        return errors::Internal("Unexpected input ", input, " in ",
+                                SummarizeNodeDef(node));
+      }
+      hoisted->add_input(
+          strings::StrCat(hoisted_node_name(node_name), ":", port));
+    }
+    // Preserve the execution order of the constants with respect to the
+    // control dependencies of the loop.
+    if (node.input_size() == 0) {
+      for (const string& input : while_node->input()) {
+        if (IsControlInput(input)) hoisted->add_input(input);
+      }
+    }
+    VLOG(1) << "Hoisted " << node.name() << " out of the body of "
+            << while_node->name();
+  }
+
+  // Pass the hoisted tensors to the body and condition as extra loop
+  // variables, forwarded unchanged from one iteration to the next.
+  const string sanitized_name =
+      absl::StrReplaceAll(while_node->name(), {{"/", "_"}});
+  FunctionDef new_body = *body;
+  new_body.clear_node_def();
+  new_body.mutable_signature()->set_name(UniqueFunctionName(
+      strings::StrCat(body->signature().name(), "_", sanitized_name), *flib));
+  FunctionDef new_cond = *cond;
+  new_cond.mutable_signature()->set_name(UniqueFunctionName(
+      strings::StrCat(cond->signature().name(), "_", sanitized_name), *flib));
+  absl::flat_hash_set<string> used_names;
+  for (const FunctionDef* func : {body, cond}) {
+    for (const auto& arg : func->signature().input_arg()) {
+      used_names.insert(arg.name());
+    }
+    for (const auto& arg : func->signature().output_arg()) {
+      used_names.insert(arg.name());
+    }
+    for (const NodeDef& node : func->node_def()) used_names.insert(node.name());
+  }
+  std::vector<string> hoisted_arg_names;
+  for (int i = 0, end = hoisted_tensors.size(); i < end; ++i) {
+    string arg_name = strings::StrCat("loop_invariant_", i);
+    while (used_names.contains(arg_name) ||
+           used_names.contains(strings::StrCat(arg_name, "_out"))) {
+      arg_name = strings::StrCat(arg_name, "_");
+    }
+    hoisted_arg_names.push_back(arg_name);
+    const string output_name = strings::StrCat(arg_name, "_out");
+    for (FunctionDef* func : {&new_body, &new_cond}) {
+      OpDef::ArgDef* input_arg = func->mutable_signature()->add_input_arg();
+      input_arg->set_name(arg_name);
+      input_arg->set_type(hoisted_types[i]);
+    }
+    OpDef::ArgDef* output_arg = new_body.mutable_signature()->add_output_arg();
+    output_arg->set_name(output_name);
+    output_arg->set_type(hoisted_types[i]);
+    (*new_body.mutable_ret())[output_name] = arg_name;
+  }
+  for (auto& ret : *new_body.mutable_ret()) {
+    auto it = hoisted_inputs.find(ret.second);
+    if (it != hoisted_inputs.end()) ret.second = hoisted_arg_names[it->second];
+  }
+
+  // Keep the nodes that are still needed once the hoisted tensors are read
+  // from the new loop variables.
+  absl::flat_hash_set<string> live_nodes;
+  for (const NodeDef& node : body->node_def()) {
+    if (!invariant_nodes.contains(node.name())) stack.push_back(node.name());
+  }
+  for (const auto& ret : new_body.ret()) {
+    stack.push_back(FunctionBodyNodeName(ret.second));
+  }
+  while (!stack.empty()) {
+    const string node_name = stack.back();
+    stack.pop_back();
+    auto it = body_nodes.find(node_name);
+    if (it == body_nodes.end() || !live_nodes.insert(node_name).second) {
+      continue;
+    }
+    const bool reads_hoisted_tensors = !invariant_nodes.contains(node_name);
+    for (const string& input : it->second->input()) {
+      if (reads_hoisted_tensors && hoisted_inputs.contains(input)) continue;
+      stack.push_back(FunctionBodyNodeName(input));
+    }
+  }
+  for (const NodeDef& node : body->node_def()) {
+    if (!live_nodes.contains(node.name())) continue;
+    NodeDef* new_node = new_body.add_node_def();
+    *new_node = node;
+    if (invariant_nodes.contains(node.name())) continue;
+    for (int i = 0; i < new_node->input_size(); ++i) {
+      auto it = hoisted_inputs.find(new_node->input(i));
+      if (it != hoisted_inputs.end()) {
+        new_node->set_input(i, hoisted_arg_names[it->second]);
+      }
+    }
+  }
+
+  // Finally update the loop itself.
+  std::vector<string> control_inputs;
+  while (IsControlInput(while_node->input(while_node->input_size() - 1))) {
+    control_inputs.push_back(while_node->input(while_node->input_size() - 1));
+    while_node->mutable_input()->RemoveLast();
+  }
+  for (const auto& tensor : hoisted_tensors) {
+    while_node->add_input(strings::StrCat(hoisted_node_name(tensor.first), ":",
+                                          tensor.second));
+  }
+  for (auto it = control_inputs.rbegin(); it != control_inputs.rend(); ++it) {
+    while_node->add_input(*it);
+  }
+  auto* mutable_attr = while_node->mutable_attr();
+  for (DataType type : hoisted_types) {
+    (*mutable_attr)["T"].mutable_list()->add_type(type);
+  }
+  for (const char* shapes_attr : {"output_shapes", "_output_shapes"}) {
+    auto it = mutable_attr->find(shapes_attr);
+    if (it == mutable_attr->end()) continue;
+    if (it->second.list().shape_size() != num_loop_vars) {
+      mutable_attr->erase(it);
+      continue;
+    }
+    for (int i = 0, end = hoisted_tensors.size(); i < end; ++i) {
+      it->second.mutable_list()->add_shape()->set_unknown_rank(true);
+    }
+  }
+  (*mutable_attr)["body"].mutable_func()->set_name(
+      new_body.signature().name());
+  (*mutable_attr)["cond"].mutable_func()->set_name(
+      new_cond.signature().name());
+
+  TF_RETURN_IF_ERROR(flib->AddFunctionDef(new_body));
+  TF_RETURN_IF_ERROR(flib->AddFunctionDef(new_cond));
+  *optimized_graph->mutable_library()->add_function() = std::move(new_body);
+  *optimized_graph->mutable_library()->add_function() = std::move(new_cond);
+  return Status::OK();
+}
+
+Status HoistWhileLoopInvariants(GraphDef* optimized_graph) {
+  FrameView frame_view;
+  TF_RETURN_IF_ERROR(frame_view.InferFromGraph(*optimized_graph));
+  std::vector<int> while_nodes;
+  absl::flat_hash_set<string> graph_nodes;
+  for (int i = 0; i < optimized_graph->node_size(); ++i) {
+    const NodeDef& node = optimized_graph->node(i);
+    graph_nodes.insert(node.name());
+    // Hoisting out of a loop nested in a v1 frame would also require moving
+    // the hoisted nodes into the frame.
+    if (IsWhile(node) && frame_view.Frames(node).empty()) {
+      while_nodes.push_back(i);
+    }
+  }
+  if (while_nodes.empty()) return Status::OK();
+
+  FunctionLibraryDefinition flib(OpRegistry::Global(),
+                                 optimized_graph->library());
+  for (int i : while_nodes) {
+    TF_RETURN_IF_ERROR(
+        HoistWhileLoopInvariants(optimized_graph->mutable_node(i), graph_nodes,
+                                 &flib, optimized_graph));
+  }
+  return Status::OK();
+}
+
 }  // namespace
 
 LoopOptimizer::LoopOptimizer()
@@ -725,13 +1125,14 @@ LoopOptimizer::LoopOptimizer(RewriterConfig::Toggle opt_level,
                              DeviceBase* cpu_device)
     : opt_level_(opt_level),
       cpu_device_(cpu_device),
-      options_(LoopOptimizerOptions::Default(RewriterConfig::ON)) {
+      options_(LoopOptimizerOptions::Default(opt_level)) {
   resource_mgr_.reset(new ResourceMgr());
 }
 
 Status LoopOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
                                GraphDef* optimized_graph) {
   if (!options_.enable_loop_invariant_node_motion &&
+      !options_.enable_while_loop_invariant_node_motion &&
       !options_.enable_stack_push_removal &&
       !options_.enable_dead_branch_removal) {
     return errors::Aborted("Nothing to do.");
@@ -742,6 +1143,9 @@ Status LoopOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
     LoopInvariantNodeMotionOptimizer linm_optimizer(optimized_graph);
     TF_RETURN_IF_ERROR(linm_optimizer.Optimize());
   }
+  if (options_.enable_while_loop_invariant_node_motion) {
+    TF_RETURN_IF_ERROR(HoistWhileLoopInvariants(optimized_graph));
+  }
   if (options_.enable_stack_push_removal) {
     TF_RETURN_IF_ERROR(RemoveStackOps(item.NodesToPreserve(), optimized_graph));
   }
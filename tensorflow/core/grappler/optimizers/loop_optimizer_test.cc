@@ -16,6 +16,7 @@ limitations under the License.
 #include "tensorflow/core/grappler/optimizers/loop_optimizer.h"
 
 #include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/framework/function_testlib.h"
 #include "tensorflow/core/framework/node_def.pb.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/grappler/grappler_item.h"
@@ -65,6 +66,11 @@ class LoopOptimizerTest : public GrapplerTest {
     optimizer->options_.enable_loop_invariant_node_motion = true;
   }
 
+  void EnableOnlyWhileLoopInvariantNodeMotion(LoopOptimizer* optimizer) {
+    DisableAllStages(optimizer);
+    optimizer->options_.enable_while_loop_invariant_node_motion = true;
+  }
+
   void EnableOnlyStackPushRemoval(LoopOptimizer* optimizer) {
     DisableAllStages(optimizer);
     optimizer->options_.enable_stack_push_removal = true;
@@ -74,6 +80,7 @@ class LoopOptimizerTest : public GrapplerTest {
   void DisableAllStages(LoopOptimizer* optimizer) {
     LoopOptimizer::LoopOptimizerOptions options;
     options.enable_loop_invariant_node_motion = false;
+    options.enable_while_loop_invariant_node_motion = false;
     options.enable_stack_push_removal = false;
     optimizer->options_ = options;
   }
@@ -628,6 +635,116 @@ void VerifyGraphsEqual(const GraphDef& original_graph,
   }
 }
 
+TEST_F(LoopOptimizerTest, FunctionalWhileLoopInvariants) {
+  using test::function::NDef;
+  using FDH = FunctionDefHelper;
+
+  // x_next = x + Square(w * 2) where w is forwarded unchanged by the body.
+  FunctionDef body = FDH::Create(
+      "LoopBody", {"i: int32", "x: float", "w: float"},
+      {"i_out: int32", "x_out: float", "w_out: float"}, {},
+      {FDH::Const<int32>("one", 1),
+       {{"i_next"}, "Add", {"i", "one:output:0"}, {{"T", DT_INT32}}},
+       {{"w_id"}, "Identity", {"w"}, {{"T", DT_FLOAT}}},
+       FDH::Const<float>("scale", 2.0f),
+       {{"w_scaled"},
+        "Mul",
+        {"w_id:output:0", "scale:output:0"},
+        {{"T", DT_FLOAT}}},
+       {{"w_sq"}, "Square", {"w_scaled:z:0"}, {{"T", DT_FLOAT}}},
+       {{"x_next"}, "Add", {"x", "w_sq:y:0"}, {{"T", DT_FLOAT}}}},
+      {{"i_out", "i_next:z:0"},
+       {"x_out", "x_next:z:0"},
+       {"w_out", "w_id:output:0"}});
+  FunctionDef cond = FDH::Create(
+      "LoopCond", {"i: int32", "x: float", "w: float"}, {"cond: bool"}, {},
+      {FDH::Const<int32>("limit", 10),
+       {{"less"}, "Less", {"i", "limit:output:0"}, {{"T", DT_INT32}}}},
+      {{"cond", "less:z:0"}});
+
+  GrapplerItem item;
+  item.graph = test::function::GDef(
+      {NDef("i0", "Placeholder", {}, {{"dtype", DT_INT32}}),
+       NDef("x0", "Placeholder", {}, {{"dtype", DT_FLOAT}}),
+       NDef("w0", "Placeholder", {}, {{"dtype", DT_FLOAT}}),
+       NDef("ctrl", "NoOp", {}, {}),
+       NDef("while", "While", {"i0", "x0", "w0", "^ctrl"},
+            {{"T", DataTypeSlice{DT_INT32, DT_FLOAT, DT_FLOAT}},
+             {"cond", FDH::FunctionRef("LoopCond")},
+             {"body", FDH::FunctionRef("LoopBody")}}),
+       NDef("out", "Identity", {"while:1"}, {{"T", DT_FLOAT}})},
+      {body, cond});
+
+  LoopOptimizer optimizer;
+  EnableOnlyWhileLoopInvariantNodeMotion(&optimizer);
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  int found = 0;
+  for (const NodeDef& node : output.node()) {
+    if (node.name() == "while") {
+      ++found;
+      ASSERT_EQ(5, node.input_size());
+      EXPECT_EQ("w0", node.input(2));
+      EXPECT_EQ("while/LoopOptimizer/w_sq:0", node.input(3));
+      EXPECT_EQ("^ctrl", node.input(4));
+      EXPECT_EQ(4, node.attr().at("T").list().type_size());
+      EXPECT_EQ("LoopBody_while", node.attr().at("body").func().name());
+      EXPECT_EQ("LoopCond_while", node.attr().at("cond").func().name());
+    } else if (node.name() == "while/LoopOptimizer/w_sq") {
+      ++found;
+      EXPECT_EQ("Square", node.op());
+      ASSERT_EQ(1, node.input_size());
+      EXPECT_EQ("while/LoopOptimizer/w_scaled:0", node.input(0));
+    } else if (node.name() == "while/LoopOptimizer/w_scaled") {
+      ++found;
+      ASSERT_EQ(2, node.input_size());
+      EXPECT_EQ("while/LoopOptimizer/w_id:0", node.input(0));
+      EXPECT_EQ("while/LoopOptimizer/scale:0", node.input(1));
+    } else if (node.name() == "while/LoopOptimizer/w_id") {
+      ++found;
+      ASSERT_EQ(1, node.input_size());
+      EXPECT_EQ("w0", node.input(0));
+    } else if (node.name() == "while/LoopOptimizer/scale") {
+      ++found;
+      ASSERT_EQ(1, node.input_size());
+      EXPECT_EQ("^ctrl", node.input(0));
+    }
+  }
+  EXPECT_EQ(5, found);
+
+  found = 0;
+  for (const FunctionDef& func : output.library().function()) {
+    if (func.signature().name() == "LoopBody_while") {
+      ++found;
+      EXPECT_EQ(4, func.signature().input_arg_size());
+      EXPECT_EQ(4, func.signature().output_arg_size());
+      std::vector<string> nodes;
+      for (const NodeDef& node : func.node_def()) {
+        nodes.push_back(node.name());
+        if (node.name() == "x_next") {
+          EXPECT_EQ("loop_invariant_0", node.input(1));
+        }
+      }
+      EXPECT_EQ(std::vector<string>({"one", "i_next", "w_id", "x_next"}),
+                nodes);
+      EXPECT_EQ("loop_invariant_0", func.ret().at("loop_invariant_0_out"));
+    } else if (func.signature().name() == "LoopCond_while") {
+      ++found;
+      EXPECT_EQ(4, func.signature().input_arg_size());
+      EXPECT_EQ(2, func.node_def_size());
+    }
+  }
+  EXPECT_EQ(2, found);
+
+  // Nothing to hoist once the invariant computation was moved out.
+  item.graph.Swap(&output);
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+  EXPECT_EQ(item.graph.node_size(), output.node_size());
+  EXPECT_EQ(item.graph.library().function_size(),
+            output.library().function_size());
+}
+
 TEST_F(LoopOptimizerTest, NoOp) {
   // This trivial graph is so basic there's nothing to optimize.
   TrivialTestGraphInputYielder fake_input(4, 1, 10, false, {"CPU:0"});
@@ -28,6 +28,7 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor.pb.h"  // NOLINT
 #include "tensorflow/core/framework/tensor_shape.pb.h"
 #include "tensorflow/core/grappler/clusters/virtual_cluster.h"
+#include "tensorflow/core/grappler/costs/analytical_cost_estimator.h"
 #include "tensorflow/core/grappler/costs/graph_memory.h"
 #include "tensorflow/core/grappler/costs/graph_properties.h"
 #include "tensorflow/core/grappler/costs/utils.h"
@@ -440,9 +441,109 @@ void RecomputeSubgraph(
   }
 }
 
+// Selects nodes to recompute among `candidates` using the cost model, so that
+// the estimated peak memory usage of every device fits into
+// `memory_limit_bytes` while adding as little compute as possible. Similar to
+// XLA's HloRematerialization, nodes whose outputs are alive at the peak are
+// picked greedily by the memory they save per unit of recomputation time.
+// Recomputing a node extends the lifetime of its inputs, which is subtracted
+// from the memory it saves.
+Status SelectNodesToRecompute(
+    Cluster* cluster, const GrapplerItem& item, int64 memory_limit_bytes,
+    const std::unordered_set<const NodeDef*>& candidates,
+    std::unordered_set<string>* nodes_to_recompute) {
+  GraphMemory memory(item);
+  TF_RETURN_IF_ERROR(memory.InferStatically(cluster->GetDevices()));
+
+  AnalyticalCostEstimator estimator(cluster, /*use_static_shapes=*/true,
+                                    /*use_aggressive_shape_inference=*/false);
+  TF_RETURN_IF_ERROR(estimator.Initialize(item));
+  RunMetadata metadata;
+  Costs costs;
+  TF_RETURN_IF_ERROR(estimator.PredictCosts(item.graph, &metadata, &costs));
+  std::unordered_map<string, const CostGraphDef::Node*> name_to_cost;
+  for (const auto& node : metadata.cost_graph().node()) {
+    name_to_cost[node.name()] = &node;
+  }
+  const auto output_bytes = [&name_to_cost](const string& node) -> int64 {
+    auto it = name_to_cost.find(node);
+    if (it == name_to_cost.end()) return 0;
+    int64 bytes = 0;
+    for (const auto& output : it->second->output_info()) {
+      bytes += output.size();
+    }
+    return bytes;
+  };
+
+  std::unordered_map<string, const NodeDef*> name_to_candidate;
+  for (const NodeDef* node : candidates) {
+    name_to_candidate[node->name()] = node;
+  }
+
+  struct Candidate {
+    const NodeDef* node;
+    int64 saved_bytes;
+    int64 compute_cost;
+  };
+  for (const auto& device : cluster->GetDevices()) {
+    const GraphMemory::MemoryUsage& mem_usage =
+        memory.GetPeakMemoryUsage(device.first);
+    if (mem_usage.used_memory <= memory_limit_bytes) {
+      continue;
+    }
+
+    std::unordered_map<string, int64> live_bytes;
+    for (const auto& live : mem_usage.live_tensors) {
+      live_bytes[live.node] += live.memory_used;
+    }
+
+    std::vector<Candidate> device_candidates;
+    for (const auto& live : live_bytes) {
+      auto it = name_to_candidate.find(live.first);
+      if (it == name_to_candidate.end()) continue;
+      const NodeDef* node = it->second;
+      int64 saved_bytes = live.second;
+      std::unordered_set<string> inputs;
+      for (const string& input : node->input()) {
+        if (IsControlInput(input)) break;
+        inputs.insert(NodeName(input));
+      }
+      for (const string& input : inputs) {
+        if (live_bytes.count(input) == 0) saved_bytes -= output_bytes(input);
+      }
+      if (saved_bytes <= 0) continue;
+      auto cost_it = name_to_cost.find(node->name());
+      const int64 compute_cost =
+          cost_it == name_to_cost.end() ? 0 : cost_it->second->compute_cost();
+      device_candidates.push_back(
+          {node, saved_bytes, std::max<int64>(1, compute_cost)});
+    }
+    std::sort(device_candidates.begin(), device_candidates.end(),
+              [](const Candidate& lhs, const Candidate& rhs) {
+                return static_cast<double>(lhs.saved_bytes) * rhs.compute_cost >
+                       static_cast<double>(rhs.saved_bytes) * lhs.compute_cost;
+              });
+
+    int64 required_bytes = mem_usage.used_memory - memory_limit_bytes;
+    for (const Candidate& candidate : device_candidates) {
+      if (required_bytes <= 0) break;
+      nodes_to_recompute->insert(candidate.node->name());
+      required_bytes -= candidate.saved_bytes;
+    }
+    if (required_bytes > 0) {
+      VLOG(1) << "Recomputation can't fit the peak memory usage of "
+              << device.first << " into " << memory_limit_bytes
+              << " bytes, missing " << required_bytes << " bytes";
+    }
+  }
+  return Status::OK();
+}
+
 void RecomputationRewritingPass(RewriterConfig::MemOptType optimization_level,
                                 const string& recomputation_targets_name_scope,
-                                GraphDef* graph, const GrapplerItem& item) {
+                                int64 recomputation_memory_limit_bytes,
+                                Cluster* cluster, GraphDef* graph,
+                                const GrapplerItem& item) {
   // The topological numberings and NodeMap will be stale as soon as we start
   // modifying the graph in RecomputeSubgraph. However, RecomputeSubgraph only
   // looks up nodes which were in the original graph, and preserves the graph
@@ -472,8 +573,46 @@ void RecomputationRewritingPass(RewriterConfig::MemOptType optimization_level,
                    "/" + recomputation_targets_name_scope)) != -1;
       };
 
-  if (optimization_level == RewriterConfig::RECOMPUTATION_HEURISTICS ||
-      optimization_level == RewriterConfig::HEURISTICS) {
+  bool use_cost_model = false;
+  std::unordered_set<string> nodes_to_recompute;
+  if ((optimization_level == RewriterConfig::RECOMPUTATION_HEURISTICS ||
+       optimization_level == RewriterConfig::HEURISTICS) &&
+      recomputation_memory_limit_bytes > 0 && cluster != nullptr &&
+      !item.fetch.empty()) {
+    // Any node without side effects may be recomputed, the cost model decides
+    // which of them are worth it.
+    const std::unordered_set<string> nodes_to_preserve =
+        item.NodesToPreserve();
+    std::unordered_set<const NodeDef*> candidates = FindCandidateRecomputeNodes(
+        node_map, graph,
+        [&feeds, &is_target](const NodeDef& node) {
+          return !is_target(node) && feeds.count(node.name()) == 0 &&
+                 !IsPersistent(node) && !IsControlFlow(node) &&
+                 !IsStateful(node) && !ModifiesInputsInPlace(node);
+        },
+        is_target);
+    Status s = SelectNodesToRecompute(cluster, item,
+                                      recomputation_memory_limit_bytes,
+                                      candidates, &nodes_to_recompute);
+    if (s.ok()) {
+      use_cost_model = true;
+    } else {
+      VLOG(1) << "Failed to select nodes to recompute with the cost model, "
+                 "falling back to op type heuristics: "
+              << s.error_message();
+    }
+  }
+
+  if (use_cost_model) {
+    recomputed_subgraphs = GetOpGroupsToRecompute(
+        graph, node_map,
+        [&nodes_to_recompute](const NodeDef& node) {
+          return nodes_to_recompute.count(node.name()) > 0 ||
+                 node.attr().count(kRecomputeHint) > 0;
+        },
+        is_target);
+  } else if (optimization_level == RewriterConfig::RECOMPUTATION_HEURISTICS ||
+             optimization_level == RewriterConfig::HEURISTICS) {
     // TODO(allenl): Handle ResNet-like architectures better. Right now all of
     // the cheap forward ops get grouped into a single subgraph which must
     // execute before gradients start executing (unless layers are manually
@@ -740,6 +879,254 @@ bool SchedulingPass(Cluster* cluster, std::unique_ptr<GraphMemory>* memory_ptr,
   return updated_graph;
 }
 
+// Nodes that allocate and free less than this fraction of the peak memory usage
+// are not ordered by the reordering pass, and are left to the runtime.
+constexpr double kMinReorderedFractionOfPeakMemory = 0.01;
+
+// Ready node in the memory-aware list scheduler. Nodes freeing the most memory
+// net of their own allocations come first, ties are broken by the original
+// topological order.
+struct ReadyNode {
+  int64 priority;
+  int topo_index;
+  int node;
+
+  bool operator<(const ReadyNode& other) const {
+    if (priority != other.priority) return priority > other.priority;
+    return topo_index < other.topo_index;
+  }
+};
+
+// Computes a topological order of the graph nodes that greedily minimizes the
+// memory in use, similar to the list scheduler in XLA's hlo_memory_scheduler:
+// out of the ready nodes, it always picks the one with the largest difference
+// between the bytes it frees (inputs for which it is the last consumer) and
+// the bytes it allocates (its outputs). Returns false if the graph has cycles.
+bool ComputeMemoryAwareSchedule(
+    const GraphTopologyView& topology,
+    const std::vector<std::vector<int>>& data_fanins,
+    const std::vector<int64>& allocated_bytes,
+    const std::vector<bool>& is_releasable, const std::vector<int>& topo_index,
+    std::vector<int>* schedule, std::vector<int64>* freed_bytes) {
+  const int num_nodes = topology.num_nodes();
+
+  // Number of unscheduled nodes consuming outputs of each node.
+  std::vector<int> pending_uses(num_nodes, 0);
+  for (int i = 0; i < num_nodes; ++i) {
+    for (int fanin : data_fanins[i]) ++pending_uses[fanin];
+  }
+  std::vector<int> pending_fanins(num_nodes);
+  for (int i = 0; i < num_nodes; ++i) {
+    pending_fanins[i] = topology.GetFanin(i).size();
+  }
+
+  const auto bytes_freed_by = [&](int node) -> int64 {
+    int64 freed = 0;
+    for (int fanin : data_fanins[node]) {
+      if (is_releasable[fanin] && pending_uses[fanin] == 1) {
+        freed += allocated_bytes[fanin];
+      }
+    }
+    return freed;
+  };
+
+  std::set<ReadyNode> ready;
+  std::vector<int64> priority(num_nodes, 0);
+  std::vector<bool> scheduled(num_nodes, false);
+  const auto add_ready = [&](int node) {
+    priority[node] = bytes_freed_by(node) - allocated_bytes[node];
+    ready.insert({priority[node], topo_index[node], node});
+  };
+  for (int i = 0; i < num_nodes; ++i) {
+    if (pending_fanins[i] == 0) add_ready(i);
+  }
+
+  schedule->clear();
+  schedule->reserve(num_nodes);
+  freed_bytes->assign(num_nodes, 0);
+  while (!ready.empty()) {
+    const int node = ready.begin()->node;
+    ready.erase(ready.begin());
+    scheduled[node] = true;
+    schedule->push_back(node);
+    (*freed_bytes)[node] = bytes_freed_by(node);
+
+    for (int fanin : data_fanins[node]) {
+      if (--pending_uses[fanin] != 1 || !is_releasable[fanin]) continue;
+      // The remaining consumer of `fanin` will now free its outputs, so it
+      // must be reprioritized if it is already ready.
+      for (int consumer : topology.GetFanout(fanin)) {
+        if (scheduled[consumer] || pending_fanins[consumer] != 0) continue;
+        ready.erase({priority[consumer], topo_index[consumer], consumer});
+        add_ready(consumer);
+      }
+    }
+    for (int fanout : topology.GetFanout(node)) {
+      if (--pending_fanins[fanout] == 0) add_ready(fanout);
+    }
+  }
+
+  return schedule->size() == num_nodes;
+}
+
+// Reorders independent nodes to lower the peak memory usage. The runtime runs
+// ready nodes in an arbitrary order, so we compute a memory-aware schedule and
+// enforce it with control dependencies between the nodes placed on the same
+// device that allocate or free a significant amount of memory. The new order is
+// kept only if the cost model agrees that it lowers the peak memory usage.
+bool ReorderingPass(Cluster* cluster, std::unique_ptr<GraphMemory>* memory_ptr,
+                    GrapplerItem* item) {
+  // Control dependencies can't cross frame boundaries, so we leave graphs with
+  // control flow as is.
+  for (const NodeDef& node : item->graph.node()) {
+    if (IsControlFlow(node)) return false;
+  }
+
+  if ((*memory_ptr) == nullptr) {
+    memory_ptr->reset(new GraphMemory(*item));
+    Status s = (*memory_ptr)->InferStatically(cluster->GetDevices());
+    if (!s.ok()) {
+      memory_ptr->reset();
+      VLOG(1) << "Failed to infer memory usage: " << s.error_message();
+      return false;
+    }
+  }
+  const GraphMemory& memory = **memory_ptr;
+
+  // Added control dependencies take some scheduling freedom away from the
+  // runtime, so only reorder graphs that are close to running out of memory.
+  bool is_memory_constrained = false;
+  for (const auto& device : cluster->GetDevices()) {
+    const DeviceProperties& prop = device.second;
+    if (prop.memory_size() <= 0) continue;
+    const GraphMemory::MemoryUsage& mem_usage =
+        memory.GetPeakMemoryUsage(device.first);
+    if (mem_usage.used_memory > prop.memory_size() * 0.8) {
+      is_memory_constrained = true;
+    }
+  }
+  if (!is_memory_constrained) {
+    return false;
+  }
+  const int64 peak_memory = memory.GetWorstCaseMemoryUsage();
+
+  GraphProperties properties(*item);
+  Status s = properties.InferStatically(/*assume_valid_feeds=*/false,
+                                        /*aggressive_shape_inference=*/false,
+                                        /*include_tensor_values=*/false);
+  if (!s.ok()) {
+    VLOG(1) << "Failed to infer shapes: " << s.error_message();
+    return false;
+  }
+
+  GraphTopologyView topology;
+  s = topology.InitializeFromGraph(item->graph);
+  if (!s.ok()) {
+    VLOG(1) << "Failed to initialize graph topology view: "
+            << s.error_message();
+    return false;
+  }
+  std::vector<const NodeDef*> topo_order;
+  s = ComputeTopologicalOrder(item->graph, &topo_order);
+  if (!s.ok()) {
+    VLOG(1) << "Failed to compute topological order: " << s.error_message();
+    return false;
+  }
+
+  const int num_nodes = item->graph.node_size();
+  const std::unordered_set<string> nodes_to_preserve = item->NodesToPreserve();
+  std::vector<int> topo_index(num_nodes);
+  for (int i = 0; i < topo_order.size(); ++i) {
+    topo_index[*topology.GetNodeIndex(*topo_order[i])] = i;
+  }
+  std::vector<std::vector<int>> data_fanins(num_nodes);
+  std::vector<int64> allocated_bytes(num_nodes, 0);
+  std::vector<bool> is_releasable(num_nodes, false);
+  for (int i = 0; i < num_nodes; ++i) {
+    const NodeDef& node = item->graph.node(i);
+    if (!IsPersistent(node) && properties.HasOutputProperties(node.name())) {
+      for (const auto& prop : properties.GetOutputProperties(node.name())) {
+        allocated_bytes[i] += CalculateTensorSize(prop);
+      }
+    }
+    // Outputs of the fetch nodes stay alive until the end of the step.
+    is_releasable[i] =
+        !IsPersistent(node) && !nodes_to_preserve.count(node.name());
+    for (const string& input : node.input()) {
+      if (IsControlInput(input)) break;
+      const absl::optional<int> fanin = topology.GetNodeIndex(NodeName(input));
+      if (fanin.has_value()) data_fanins[i].push_back(*fanin);
+    }
+    std::sort(data_fanins[i].begin(), data_fanins[i].end());
+    data_fanins[i].erase(
+        std::unique(data_fanins[i].begin(), data_fanins[i].end()),
+        data_fanins[i].end());
+  }
+
+  std::vector<int> schedule;
+  std::vector<int64> freed_bytes;
+  if (!ComputeMemoryAwareSchedule(topology, data_fanins, allocated_bytes,
+                                  is_releasable, topo_index, &schedule,
+                                  &freed_bytes)) {
+    VLOG(1) << "Failed to compute memory aware schedule";
+    return false;
+  }
+
+  // All the added control dependencies follow the computed topological order,
+  // so they can't introduce cycles.
+  const int64 min_reordered_bytes = std::max<int64>(
+      1, static_cast<int64>(peak_memory * kMinReorderedFractionOfPeakMemory));
+  GraphDef reordered_graph = item->graph;
+  std::unordered_map<string, int> last_reordered_node;
+  int num_control_dependencies = 0;
+  for (int node : schedule) {
+    const NodeDef& node_def = item->graph.node(node);
+    if (IsPersistent(node_def) || nodes_to_preserve.count(node_def.name())) {
+      continue;
+    }
+    if (allocated_bytes[node] < min_reordered_bytes &&
+        freed_bytes[node] < min_reordered_bytes) {
+      continue;
+    }
+    auto it = last_reordered_node.find(node_def.device());
+    if (it == last_reordered_node.end()) {
+      last_reordered_node[node_def.device()] = node;
+      continue;
+    }
+    const auto& fanins = topology.GetFanin(node);
+    if (std::find(fanins.begin(), fanins.end(), it->second) == fanins.end()) {
+      *reordered_graph.mutable_node(node)->add_input() =
+          AsControlDependency(item->graph.node(it->second).name());
+      ++num_control_dependencies;
+    }
+    it->second = node;
+  }
+  if (num_control_dependencies == 0) {
+    return false;
+  }
+
+  GrapplerItem reordered_item = item->WithGraph(std::move(reordered_graph));
+  GraphMemory reordered_memory(reordered_item);
+  s = reordered_memory.InferStatically(cluster->GetDevices());
+  if (!s.ok()) {
+    VLOG(1) << "Failed to infer memory usage: " << s.error_message();
+    return false;
+  }
+  const int64 reordered_peak_memory =
+      reordered_memory.GetWorstCaseMemoryUsage();
+  if (reordered_peak_memory >= peak_memory) {
+    VLOG(1) << "Reordering does not reduce peak memory usage: "
+            << reordered_peak_memory << " vs " << peak_memory;
+    return false;
+  }
+
+  VLOG(1) << "Reordering with " << num_control_dependencies
+          << " control dependencies reduces peak memory usage from "
+          << peak_memory << " to " << reordered_peak_memory;
+  item->graph.Swap(&reordered_item.graph);
+  return true;
+}
+
 Status BuildSwapPair(NodeDef* node, int input_to_swap,
                      const std::unordered_map<string, const NodeDef*>& name_map,
                      GraphDef* graph,
@@ -797,16 +1184,16 @@ Status BuildSwapPair(NodeDef* node, int input_to_swap,
   return Status::OK();
 }
 
-struct SwapInfo {
-  std::vector<int> inputs_to_swap;
-  Costs::NanoSeconds time_to_swap = 0;
-};
+}  // namespace
 
-static const NodeDef* FindSwapInTrigger(
+namespace internal {
+
+const NodeDef* FindSwapInTrigger(
     const NodeDef* node, const SwapInfo& swap_info,
     const std::unordered_map<string, const NodeDef*>& name_map,
     const std::unordered_map<const NodeDef*, Costs::NanoSeconds>&
-        execution_times) {
+        execution_times,
+    const std::unordered_map<const NodeDef*, int>& topo_order) {
   // max_trigger_time stores the time before which the swap operation needs to
   // be started in order to load the data back onto the accelerator without
   // delaying the downstream computation.
@@ -820,11 +1207,12 @@ static const NodeDef* FindSwapInTrigger(
     }
     const NodeDef* input_node = it1->second;
 
+    // Inputs without a time estimate can't delay the node any further than
+    // the ones we know about.
     auto it2 = execution_times.find(input_node);
-    if (it2 == execution_times.end()) {
-      return nullptr;
+    if (it2 != execution_times.end()) {
+      max_trigger_time = std::max(max_trigger_time, it2->second);
     }
-    max_trigger_time = std::max(max_trigger_time, it2->second);
     possible_inputs.insert(input_node_name);
   }
 
@@ -838,7 +1226,10 @@ static const NodeDef* FindSwapInTrigger(
 
   max_trigger_time -= swap_info.time_to_swap;
 
-  std::map<Costs::NanoSeconds, const NodeDef*> candidates;
+  // Candidates are ordered by estimated execution time, and then by position
+  // in the topological order, so that among nodes the cost model can't tell
+  // apart we pick the one that runs last.
+  std::map<std::pair<Costs::NanoSeconds, int>, const NodeDef*> candidates;
   std::set<string> already_processed;
 
   while (!possible_inputs.empty()) {
@@ -858,12 +1249,13 @@ static const NodeDef* FindSwapInTrigger(
       continue;
     }
     auto it2 = execution_times.find(input_node);
-    if (it2 == execution_times.end()) {
-      return nullptr;
-    }
-    if (it2->second < max_trigger_time) {
-      candidates[it2->second] = input_node;
+    if (it2 != execution_times.end() && it2->second < max_trigger_time) {
+      auto it3 = topo_order.find(input_node);
+      const int topo_index = it3 == topo_order.end() ? -1 : it3->second;
+      candidates[{it2->second, topo_index}] = input_node;
     } else {
+      // Nodes that run too late, or whose time we don't know, are skipped
+      // over in favor of their fanins.
       for (const string& fanin : input_node->input()) {
         string name = NodeName(fanin);
         if (already_processed.find(name) == already_processed.end()) {
@@ -882,6 +1274,32 @@ static const NodeDef* FindSwapInTrigger(
   return nullptr;
 }
 
+double SwappingFitness(Costs::Duration allocation_time,
+                       Costs::Duration earliest_use, Costs::Duration peak_time,
+                       int num_uses_left, int64 memory_used) {
+  // We need the tensor to be generated way away of the time of peak memory
+  // usage (to ensure there is enough time to swap it out). We also need to
+  // ensure it's used way after the peak time, to ensure that swapping the
+  // tensor back in won't recreate the memory bottleneck. Last but not least,
+  // we want the tensor to have as few remaining uses as possible. All else
+  // being equal, swapping a larger tensor saves more memory for the same
+  // number of copies, so the fitness is scaled by the size of the tensor.
+  //
+  // Note that we must perform the arithmetic inexactly as "double", since the
+  // values do not fit into any integral type.
+  const double fitness =
+      MathUtil::IPow<double>((earliest_use - peak_time).count(), 2) /
+          MathUtil::IPow<double>(num_uses_left, 2) +
+      MathUtil::IPow<double>((allocation_time - peak_time).count(), 2);
+  return fitness * static_cast<double>(memory_used);
+}
+
+}  // namespace internal
+
+namespace {
+
+using internal::SwapInfo;
+
 static bool IsSwappable(const MutableGraphView& graph,
                         MutableGraphView::OutputPort output) {
   const NodeDef& node = *output.node;
@@ -1104,20 +1522,10 @@ static bool IdentifySwappingCandidates(
         earliest_use = std::min(earliest_use, it->second);
       }
       if (valid && !mem_info.uses_left.empty()) {
-        // Compute the fitness: we need the tensor to be generated way away of
-        // the time of peak memory usage (to ensure there is enough time to swap
-        // it out). We also need to ensure it's used way after the peak time, to
-        // ensure that swapping the tensor back in won't recreate the memory
-        // bottleneck. Last but not least, we want the tensor to have as few
-        // remaining uses as possible.
-        //
-        // Note that we must perform the arithmetic inexactly as "double", since
-        // the values do not fit into any integral type.
-        mem_info.fitness =
-            MathUtil::IPow<double>((earliest_use - peak_time).count(), 2) /
-                MathUtil::IPow<double>(mem_info.uses_left.size(), 2) +
-            MathUtil::IPow<double>((allocation_time - peak_time).count(), 2);
-        mem_info.fitness = -mem_info.fitness;
+        // Sort the fittest tensors first.
+        mem_info.fitness = -internal::SwappingFitness(
+            allocation_time, earliest_use, peak_time, mem_info.uses_left.size(),
+            mem_info.memory_used);
         mem_state.push_back(mem_info);
       }
     }
@@ -1209,6 +1617,18 @@ bool SwappingPass(RewriterConfig::MemOptType optimization_level,
   for (const auto& node : item->graph.node()) {
     name_map[node.name()] = &node;
   }
+  // The topological order breaks ties between nodes with the same estimated
+  // execution time when picking swap-in triggers. It's best effort: if the
+  // graph has cycles, only the time estimates are used.
+  std::unordered_map<const NodeDef*, int> topo_order;
+  {
+    std::vector<const NodeDef*> topo_nodes;
+    if (ComputeTopologicalOrder(item->graph, &topo_nodes).ok()) {
+      for (int i = 0; i < topo_nodes.size(); ++i) {
+        topo_order[topo_nodes[i]] = i;
+      }
+    }
+  }
   MutableGraphView view(&item->graph);
 
   bool updated_graph = false;
@@ -1223,8 +1643,8 @@ bool SwappingPass(RewriterConfig::MemOptType optimization_level,
     // Make sure the tensor isn't swapped back in right away: look for node that
     // will execute just before we need to swap the data back, and add a control
     // dependency from that node to the swap node.
-    const NodeDef* in_trigger =
-        FindSwapInTrigger(node, swap_info, name_map, execution_times);
+    const NodeDef* in_trigger = internal::FindSwapInTrigger(
+        node, swap_info, name_map, execution_times, topo_order);
     // If we failed, don't attempt to reprocess this node in a subsequent pass.
     if (!in_trigger) {
       skip_list->insert(node->name());
@@ -1395,9 +1815,10 @@ Status MemoryOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
   RelaxAssignNodes(nodes_to_relax, &optimized_item.graph);
 
   if (run_recomputation_pass) {
-    RecomputationRewritingPass(optimization_level_,
-                               recomputation_targets_name_scope_,
-                               &optimized_item.graph, item);
+    RecomputationRewritingPass(
+        optimization_level_, recomputation_targets_name_scope_,
+        recomputation_memory_limit_bytes_, cluster, &optimized_item.graph,
+        item);
   }
 
   std::unordered_set<string> skip_list;
@@ -1407,6 +1828,17 @@ Status MemoryOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
   // infer the memory usage, so skip optimization if there are no fetches.
   std::unique_ptr<GraphMemory> memory;
   if (!item.fetch.empty() && cluster != nullptr) {
+    // Reorder independent nodes before resorting to graph rewrites, since
+    // it's cheaper at runtime and can make the other rewrites unnecessary.
+    if (optimization_level_ == RewriterConfig::SCHEDULING_HEURISTICS ||
+        optimization_level_ == RewriterConfig::HEURISTICS) {
+      GRAPPLER_RETURN_IF_DEADLINE_EXCEEDED();
+      if (ReorderingPass(cluster, &memory, &optimized_item)) {
+        // Reset the inferred memory usage since the graph changed.
+        memory.reset();
+      }
+    }
+
     bool updated_graph = true;
     for (int i = 0; i < 25 && updated_graph; ++i) {
       GRAPPLER_RETURN_IF_DEADLINE_EXCEEDED();
@@ -17,13 +17,47 @@ limitations under the License.
 #define TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_MEMORY_OPTIMIZER_H_
 
 #include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "tensorflow/core/framework/node_def.pb.h"
 #include "tensorflow/core/grappler/clusters/cluster.h"
+#include "tensorflow/core/grappler/costs/cost_estimator.h"
 #include "tensorflow/core/grappler/grappler_item.h"
 #include "tensorflow/core/grappler/optimizers/graph_optimizer.h"
 #include "tensorflow/core/protobuf/rewriter_config.pb.h"
 
 namespace tensorflow {
 namespace grappler {
+namespace internal {
+
+// Inputs of a node to swap out to host memory, and the time it takes to swap
+// them back in.
+struct SwapInfo {
+  std::vector<int> inputs_to_swap;
+  Costs::NanoSeconds time_to_swap = 0;
+};
+
+// Returns the node after which the inputs of `node` listed in `swap_info`
+// should be swapped back in, or nullptr if there is none. This is the fanin of
+// `node`, direct or not, that runs last while leaving `time_to_swap` before
+// the other inputs of `node` are ready. Fanins without an estimate in
+// `execution_times` are searched through. Ties are broken by `topo_order`.
+const NodeDef* FindSwapInTrigger(
+    const NodeDef* node, const SwapInfo& swap_info,
+    const std::unordered_map<string, const NodeDef*>& name_map,
+    const std::unordered_map<const NodeDef*, Costs::NanoSeconds>&
+        execution_times,
+    const std::unordered_map<const NodeDef*, int>& topo_order);
+
+// Returns how good a candidate for swapping a tensor of `memory_used` bytes
+// is, given when it is allocated, its first use after the memory peak at
+// `peak_time`, and its number of uses after the peak. Higher is better.
+double SwappingFitness(Costs::Duration allocation_time,
+                       Costs::Duration earliest_use, Costs::Duration peak_time,
+                       int num_uses_left, int64 memory_used);
+
+}  // end namespace internal
 
 // Swap tensors in and out of device memory.
 class MemoryOptimizer : public GraphOptimizer {
@@ -33,11 +67,16 @@ class MemoryOptimizer : public GraphOptimizer {
   // recomputation_targets_name_scope: Name scope for potential outputs of
   //   recomputations. See
   //   RewriterConfig::memory_optimizer_target_node_name_scope.
+  // recomputation_memory_limit_bytes: Memory limit used to select nodes to
+  //   recompute with the cost model, or 0 to select them by op type. See
+  //   RewriterConfig::memory_optimizer_recomputation_memory_limit_bytes.
   explicit MemoryOptimizer(
       RewriterConfig::MemOptType optimization_level,
-      const string& recomputation_targets_name_scope = "gradients/")
+      const string& recomputation_targets_name_scope = "gradients/",
+      int64 recomputation_memory_limit_bytes = 0)
       : optimization_level_(optimization_level),
-        recomputation_targets_name_scope_(recomputation_targets_name_scope) {}
+        recomputation_targets_name_scope_(recomputation_targets_name_scope),
+        recomputation_memory_limit_bytes_(recomputation_memory_limit_bytes) {}
   ~MemoryOptimizer() override {}
 
   string name() const override { return "memory_optimizer"; };
@@ -53,6 +92,7 @@ class MemoryOptimizer : public GraphOptimizer {
  private:
   RewriterConfig::MemOptType optimization_level_;
   string recomputation_targets_name_scope_;
+  int64 recomputation_memory_limit_bytes_;
 };
 
 }  // end namespace grappler
@@ -20,12 +20,14 @@ limitations under the License.
 #include <utility>
 #include <vector>
 
+#include "absl/strings/match.h"
 #include "tensorflow/cc/ops/standard_ops.h"
 #include "tensorflow/core/framework/graph.pb.h"
 #include "tensorflow/core/framework/node_def.pb.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/grappler/clusters/virtual_cluster.h"
+#include "tensorflow/core/grappler/costs/graph_memory.h"
 #include "tensorflow/core/grappler/grappler_item.h"
 #include "tensorflow/core/grappler/utils.h"
 #include "tensorflow/core/grappler/utils/grappler_test.h"
@@ -224,6 +226,55 @@ class MemoryOptimizerTest : public GrapplerTest {
   }
 };
 
+TEST_F(MemoryOptimizerTest, RecomputationWithMemoryLimit) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output a = ops::Variable(s.WithOpName("a").WithDevice("/cpu:0"),
+                           {128, 128, 8}, DT_FLOAT);
+  // Neither Tanh nor Exp are recomputed by the op type heuristics.
+  Output b = ops::Tanh(s.WithOpName("b").WithDevice("/cpu:0"), a);
+  Output c = ops::Exp(s.WithOpName("c").WithDevice("/cpu:0"), b);
+  Output d = ops::AddN(s.WithOpName("gradients/d").WithDevice("/cpu:0"), {c});
+  Output e =
+      ops::AddN(s.WithOpName("gradients/e").WithDevice("/cpu:0"), {d, b});
+
+  GrapplerItem item;
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+  item.fetch = {"gradients/e"};
+
+  std::unique_ptr<VirtualCluster> cluster(CreateVirtualCluster());
+
+  const auto count_recomputed_nodes = [](const GraphDef& graph) {
+    int count = 0;
+    for (const NodeDef& node : graph.node()) {
+      if (absl::StartsWith(node.name(), "Recomputed/")) count++;
+    }
+    return count;
+  };
+
+  {
+    MemoryOptimizer optimizer(RewriterConfig::RECOMPUTATION_HEURISTICS);
+    GraphDef output;
+    TF_EXPECT_OK(optimizer.Optimize(cluster.get(), item, &output));
+    EXPECT_EQ(0, count_recomputed_nodes(output));
+  }
+
+  {
+    MemoryOptimizer optimizer(RewriterConfig::RECOMPUTATION_HEURISTICS,
+                              "gradients/",
+                              /*recomputation_memory_limit_bytes=*/1);
+    GraphDef output;
+    TF_EXPECT_OK(optimizer.Optimize(cluster.get(), item, &output));
+    EXPECT_LT(0, count_recomputed_nodes(output));
+
+    NodeMap node_map(&output);
+    const NodeDef* new_e = node_map.GetNode("gradients/e");
+    ASSERT_NE(new_e, nullptr);
+    ASSERT_EQ(2, new_e->input_size());
+    EXPECT_EQ("Recomputed/b", new_e->input(1));
+    EXPECT_NE(node_map.GetNode("Recomputed/b"), nullptr);
+  }
+}
+
 TEST_F(MemoryOptimizerTest, SimpleSwapping) {
   // Build a simple graph with an op that's marked for swapping.
   tensorflow::Scope s = tensorflow::Scope::NewRootScope();
@@ -393,6 +444,123 @@ TEST_F(MemoryOptimizerTest, UnswappableInputs) {
 #endif
 }
 
+TEST(SwappingFitnessTest, PrefersLargerTensors) {
+  const Costs::Duration peak_time(100);
+  EXPECT_GT(internal::SwappingFitness(Costs::Duration(10), Costs::Duration(200),
+                                      peak_time, /*num_uses_left=*/1,
+                                      /*memory_used=*/4096),
+            internal::SwappingFitness(Costs::Duration(10), Costs::Duration(200),
+                                      peak_time, /*num_uses_left=*/1,
+                                      /*memory_used=*/2048));
+}
+
+TEST(SwappingFitnessTest, PrefersFewerUsesAndLongerGaps) {
+  const Costs::Duration peak_time(100);
+  const double fitness = internal::SwappingFitness(
+      Costs::Duration(10), Costs::Duration(200), peak_time,
+      /*num_uses_left=*/1, /*memory_used=*/2048);
+  EXPECT_GT(fitness, internal::SwappingFitness(
+                         Costs::Duration(10), Costs::Duration(200), peak_time,
+                         /*num_uses_left=*/2, /*memory_used=*/2048));
+  EXPECT_GT(fitness, internal::SwappingFitness(
+                         Costs::Duration(90), Costs::Duration(200), peak_time,
+                         /*num_uses_left=*/1, /*memory_used=*/2048));
+  EXPECT_GT(fitness, internal::SwappingFitness(
+                         Costs::Duration(10), Costs::Duration(110), peak_time,
+                         /*num_uses_left=*/1, /*memory_used=*/2048));
+}
+
+class SwapInTriggerTest : public ::testing::Test {
+ protected:
+  void AddNode(const string& name, const std::vector<string>& inputs) {
+    NodeDef* node = graph_.add_node();
+    node->set_name(name);
+    node->set_op("Identity");
+    for (const string& input : inputs) {
+      node->add_input(input);
+    }
+  }
+
+  // Looks for the trigger to swap in input 0 of `node`, which takes 5ns to
+  // swap, given the execution time and topological index of each node. Nodes
+  // missing from `times` have no estimate.
+  const NodeDef* FindTrigger(
+      const string& node, const std::unordered_map<string, int64>& times,
+      const std::unordered_map<string, int>& topo_indices) {
+    for (const NodeDef& n : graph_.node()) {
+      name_map_[n.name()] = &n;
+    }
+    for (const auto& time : times) {
+      execution_times_[name_map_.at(time.first)] =
+          Costs::NanoSeconds(time.second);
+    }
+    for (const auto& index : topo_indices) {
+      topo_order_[name_map_.at(index.first)] = index.second;
+    }
+    internal::SwapInfo swap_info;
+    swap_info.inputs_to_swap = {0};
+    swap_info.time_to_swap = Costs::NanoSeconds(5);
+    return internal::FindSwapInTrigger(name_map_.at(node), swap_info,
+                                       name_map_, execution_times_,
+                                       topo_order_);
+  }
+
+  GraphDef graph_;
+  std::unordered_map<string, const NodeDef*> name_map_;
+  std::unordered_map<const NodeDef*, Costs::NanoSeconds> execution_times_;
+  std::unordered_map<const NodeDef*, int> topo_order_;
+};
+
+// The trigger is the last fanin that leaves enough time to swap before the
+// other inputs of the node are ready.
+TEST_F(SwapInTriggerTest, PicksLastFaninBeforeDeadline) {
+  AddNode("w", {});
+  AddNode("a", {});
+  AddNode("b", {"a"});
+  AddNode("c", {"b"});
+  AddNode("e", {"w", "c"});
+  const NodeDef* trigger = FindTrigger(
+      "e", {{"w", 5}, {"a", 10}, {"b", 20}, {"c", 30}, {"e", 40}}, {});
+  ASSERT_NE(trigger, nullptr);
+  EXPECT_EQ("b", trigger->name());
+}
+
+TEST_F(SwapInTriggerTest, SearchesThroughFaninsWithoutEstimates) {
+  AddNode("w", {});
+  AddNode("a", {});
+  AddNode("b", {"a"});
+  AddNode("c", {"b"});
+  AddNode("e", {"w", "c"});
+  const NodeDef* trigger =
+      FindTrigger("e", {{"w", 5}, {"a", 10}, {"c", 30}, {"e", 40}}, {});
+  ASSERT_NE(trigger, nullptr);
+  EXPECT_EQ("a", trigger->name());
+}
+
+TEST_F(SwapInTriggerTest, BreaksTiesByTopologicalOrder) {
+  AddNode("w", {});
+  AddNode("b1", {});
+  AddNode("b2", {});
+  AddNode("c", {"b1", "b2"});
+  AddNode("e", {"w", "c"});
+  const std::unordered_map<string, int64> times = {
+      {"w", 5}, {"b1", 20}, {"b2", 20}, {"c", 30}, {"e", 40}};
+  const NodeDef* trigger =
+      FindTrigger("e", times, {{"b1", 2}, {"b2", 1}, {"c", 3}});
+  ASSERT_NE(trigger, nullptr);
+  EXPECT_EQ("b1", trigger->name());
+
+  trigger = FindTrigger("e", times, {{"b1", 1}, {"b2", 2}, {"c", 3}});
+  ASSERT_NE(trigger, nullptr);
+  EXPECT_EQ("b2", trigger->name());
+}
+
+TEST_F(SwapInTriggerTest, NoTriggerWithoutOtherInputs) {
+  AddNode("w", {});
+  AddNode("e", {"w"});
+  EXPECT_EQ(nullptr, FindTrigger("e", {{"w", 5}, {"e", 40}}, {}));
+}
+
 TEST_F(MemoryOptimizerTest, AccumulationRewrites) {
   tensorflow::Scope s = tensorflow::Scope::NewRootScope();
   Output a = ops::RandomNormal(s.WithOpName("a").WithDevice("/cpu:0"),
@@ -448,6 +616,56 @@ TEST_F(MemoryOptimizerTest, AccumulationRewrites) {
   }
 }
 
+TEST_F(MemoryOptimizerTest, ReorderingHeuristics) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  // Each of the random tensors takes half of the device memory. Running all
+  // the RandomNormal ops before the reductions runs out of memory, while
+  // reducing each tensor right after it was produced does not.
+  Output a = ops::RandomNormal(s.WithOpName("a").WithDevice("/cpu:0"),
+                               {128, 128, 8}, DT_FLOAT);
+  Output b = ops::RandomNormal(s.WithOpName("b").WithDevice("/cpu:0"),
+                               {128, 128, 8}, DT_FLOAT);
+  Output c = ops::RandomNormal(s.WithOpName("c").WithDevice("/cpu:0"),
+                               {128, 128, 8}, DT_FLOAT);
+  Output a_sum =
+      ops::Sum(s.WithOpName("a_sum").WithDevice("/cpu:0"), a, {0, 1, 2});
+  Output b_sum =
+      ops::Sum(s.WithOpName("b_sum").WithDevice("/cpu:0"), b, {0, 1, 2});
+  Output c_sum =
+      ops::Sum(s.WithOpName("c_sum").WithDevice("/cpu:0"), c, {0, 1, 2});
+  Output ab = ops::Add(s.WithOpName("ab").WithDevice("/cpu:0"), a_sum, b_sum);
+  Output abc = ops::Add(s.WithOpName("abc").WithDevice("/cpu:0"), ab, c_sum);
+
+  GrapplerItem item;
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+  item.fetch = {"abc"};
+
+  std::unique_ptr<VirtualCluster> cluster(CreateVirtualCluster());
+  MemoryOptimizer optimizer(RewriterConfig::SCHEDULING_HEURISTICS);
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(cluster.get(), item, &output));
+
+  int count = 0;
+  for (const auto& node : output.node()) {
+    if (node.name() == "b") {
+      EXPECT_EQ("^a_sum", node.input(node.input_size() - 1));
+      count++;
+    } else if (node.name() == "c") {
+      EXPECT_EQ("^b_sum", node.input(node.input_size() - 1));
+      count++;
+    }
+  }
+  EXPECT_EQ(2, count);
+
+  GraphMemory memory(item);
+  TF_EXPECT_OK(memory.InferStatically(cluster->GetDevices()));
+  GrapplerItem reordered_item = item.WithGraph(std::move(output));
+  GraphMemory reordered_memory(reordered_item);
+  TF_EXPECT_OK(reordered_memory.InferStatically(cluster->GetDevices()));
+  EXPECT_LT(reordered_memory.GetWorstCaseMemoryUsage(),
+            memory.GetWorstCaseMemoryUsage());
+}
+
 class RelaxAllocatorConstraintsTest : public GrapplerTest {};
 
 TEST_F(RelaxAllocatorConstraintsTest, SameDevice) {
@@ -15,6 +15,9 @@ limitations under the License.
 
 #include "tensorflow/core/grappler/optimizers/meta_optimizer.h"
 
+#include <deque>
+
+#include "absl/container/flat_hash_map.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_join.h"
 #include "absl/strings/substitute.h"
@@ -37,6 +40,7 @@ limitations under the License.
 #include "tensorflow/core/grappler/optimizers/dependency_optimizer.h"
 #include "tensorflow/core/grappler/optimizers/function_optimizer.h"
 #include "tensorflow/core/grappler/optimizers/generic_layout_optimizer.h"
+#include "tensorflow/core/grappler/optimizers/horizontal_fusion.h"
 #include "tensorflow/core/grappler/optimizers/implementation_selector.h"
 #include "tensorflow/core/grappler/optimizers/loop_optimizer.h"
 #include "tensorflow/core/grappler/optimizers/memory_optimizer.h"
@@ -51,8 +55,13 @@ limitations under the License.
 #include "tensorflow/core/grappler/utils/topological_sort.h"
 #include "tensorflow/core/grappler/utils/tpu.h"
 #include "tensorflow/core/grappler/verifiers/structure_verifier.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/gtl/map_util.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
+#include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/platform/fingerprint.h"
 #include "tensorflow/core/util/dump_graph.h"
 #include "tensorflow/core/util/ptr_util.h"
 #include "tensorflow/core/util/xla_config_registry.h"
@@ -64,6 +73,11 @@ namespace {
 
 constexpr int kDefaultNumberOfIterations = 2;
 constexpr int kDefaultMinGraphNodes = 4;
+// Upper bound on the number of threads used to optimize the functions of a
+// library in parallel.
+constexpr int kMaxFunctionOptimizationThreads = 16;
+// Number of optimized functions kept in the process-wide function cache.
+constexpr int kOptimizedFunctionCacheCapacity = 4096;
 
 int64 NumEdges(const GraphDef& graph) {
   int64 num_edges = 0;
@@ -90,7 +104,8 @@ int NumIterations(const RewriterConfig& cfg) {
 bool IsRunOnceOptimizer(const string& name) {
   return name == "layout" || name == "memory_optimizer" ||
          name == "loop_optimizer" || name == "auto_mixed_precision" ||
-         name == "auto_mixed_precision_mkl";
+         name == "auto_mixed_precision_mkl" ||
+         name == "auto_mixed_precision_cpu";
 }
 
 bool IsTFDataFunction(const FunctionDef& func) {
@@ -115,6 +130,78 @@ FunctionDefLibrary GetFunctionDefLibraryStub(
   return stub;
 }
 
+// Fingerprint of a graph, used to detect optimizer runs which leave the graph
+// unchanged.
+uint64 GraphFingerprint(const GraphDef& graph) {
+  string serialized;
+  SerializeToStringDeterministic(graph, &serialized);
+  return Fingerprint64(serialized);
+}
+
+// The result of optimizing a function, which can be reused for any function
+// with the same definition, reachable library and optimization settings.
+struct OptimizedFunction {
+  FunctionDef function;
+  // Specialized functions created while optimizing the function body.
+  std::vector<FunctionDef> new_functions;
+};
+
+// A process-wide cache of optimized functions, so that a function which is
+// optimized repeatedly, e.g. by several sessions or for several graphs calling
+// it, only goes through the optimizers once.
+class OptimizedFunctionCache {
+ public:
+  static OptimizedFunctionCache* Global() {
+    static OptimizedFunctionCache* cache = new OptimizedFunctionCache();
+    return cache;
+  }
+
+  std::shared_ptr<const OptimizedFunction> Lookup(const Fprint128& key) {
+    mutex_lock l(mu_);
+    auto it = functions_.find(key);
+    return it == functions_.end() ? nullptr : it->second;
+  }
+
+  void Insert(const Fprint128& key,
+              std::shared_ptr<const OptimizedFunction> function) {
+    mutex_lock l(mu_);
+    if (!functions_.emplace(key, std::move(function)).second) return;
+    insertion_order_.push_back(key);
+    if (insertion_order_.size() > kOptimizedFunctionCacheCapacity) {
+      functions_.erase(insertion_order_.front());
+      insertion_order_.pop_front();
+    }
+  }
+
+ private:
+  mutex mu_;
+  absl::flat_hash_map<Fprint128, std::shared_ptr<const OptimizedFunction>,
+                      Fprint128Hasher>
+      functions_ TF_GUARDED_BY(mu_);
+  std::deque<Fprint128> insertion_order_ TF_GUARDED_BY(mu_);
+};
+
+// Computes the key of a function in the optimized function cache. Besides the
+// function itself, the optimized function depends on the functions it can
+// reach, the optimization settings and the devices of the cluster.
+Fprint128 OptimizedFunctionCacheKey(
+    const FunctionDef& func, const FunctionLibraryDefinition& flib,
+    int producer, bool allow_non_differentiable_rewrites, bool is_tpu_graph,
+    const ConfigProto& config_proto, const std::vector<string>& device_names) {
+  string key;
+  string serialized;
+  SerializeToStringDeterministic(func, &serialized);
+  absl::StrAppend(&key, serialized.size(), ":", serialized);
+  SerializeToStringDeterministic(flib.ReachableDefinitions(func).ToProto(),
+                                 &serialized);
+  absl::StrAppend(&key, serialized.size(), ":", serialized);
+  SerializeToStringDeterministic(config_proto, &serialized);
+  absl::StrAppend(&key, serialized.size(), ":", serialized);
+  absl::StrAppend(&key, producer, ":", allow_non_differentiable_rewrites, ":",
+                  is_tpu_graph, ":", absl::StrJoin(device_names, ","));
+  return Fingerprint128(key);
+}
+
 uint64 DeadlineMicroSeconds(const RewriterConfig& cfg) {
   const uint64 kTwentyMinutesInUsec = 20 * 60 * 1000 * 1000;
   if (cfg.meta_optimizer_timeout_ms() < 0) {
@@ -191,11 +278,15 @@ std::unique_ptr<GraphOptimizer> MetaOptimizer::MakeNewOptimizer(
              cfg_.experimental_disable_compressed_tensor_optimization()));
   MK_OPT("shape", new ShapeOptimizer());
   MK_OPT("remap", new Remapper(cfg_.remapping()));
-  MK_OPT("layout", new GenericLayoutOptimizer());
+  MK_OPT("horizontal_fusion", new HorizontalFusion(cfg_.horizontal_fusion()));
+  MK_OPT("layout", new GenericLayoutOptimizer(RewriterConfig::DEFAULT,
+                                              cfg_.cpu_layout_conversion()));
   MK_OPT("auto_mixed_precision",
          new AutoMixedPrecision(AutoMixedPrecisionMode::CUDA));
   MK_OPT("auto_mixed_precision_mkl",
          new AutoMixedPrecision(AutoMixedPrecisionMode::MKL));
+  MK_OPT("auto_mixed_precision_cpu",
+         new AutoMixedPrecision(AutoMixedPrecisionMode::CPU));
   MK_OPT("memory", new MemoryOptimizer(RewriterConfig::MANUAL));
   MK_OPT("common_subgraph_elimination",
          new CommonSubgraphElimination(cfg_.common_subgraph_elimination()));
@@ -263,6 +354,10 @@ Status MetaOptimizer::InitializeOptimizers(
     optimizers->push_back(
         MakeUnique<AutoMixedPrecision>(AutoMixedPrecisionMode::MKL));
   }
+  if (AutoMixedPrecisionEnabled(cfg_.auto_mixed_precision_cpu())) {
+    optimizers->push_back(
+        MakeUnique<AutoMixedPrecision>(AutoMixedPrecisionMode::CPU));
+  }
   if (cfg_.pin_to_host_optimization() == RewriterConfig::ON) {
     optimizers->push_back(MakeUnique<PinToHostOptimizer>());
   }
@@ -271,11 +366,16 @@ Status MetaOptimizer::InitializeOptimizers(
         MakeUnique<ArithmeticOptimizer>(cfg_.arithmetic_optimization()));
   }
   if (cfg_.layout_optimizer() != RewriterConfig::OFF) {
-    optimizers->push_back(MakeUnique<GenericLayoutOptimizer>());
+    optimizers->push_back(MakeUnique<GenericLayoutOptimizer>(
+        RewriterConfig::DEFAULT, cfg_.cpu_layout_conversion()));
   }
   if (cfg_.remapping() != RewriterConfig::OFF) {
     optimizers->push_back(MakeUnique<Remapper>(cfg_.remapping()));
   }
+  if (cfg_.horizontal_fusion() == RewriterConfig::ON) {
+    optimizers->push_back(
+        MakeUnique<HorizontalFusion>(cfg_.horizontal_fusion()));
+  }
   if (cfg_.loop_optimization() != RewriterConfig::OFF) {
     optimizers->push_back(
         MakeUnique<LoopOptimizer>(cfg_.loop_optimization(), cpu_device_));
@@ -287,15 +387,14 @@ Status MetaOptimizer::InitializeOptimizers(
   auto global_jit_level =
       config_proto_.graph_options().optimizer_options().global_jit_level();
   if (MemoryOptimizerEnabled(cfg_.memory_optimization(), global_jit_level)) {
-    if (cfg_.memory_optimizer_target_node_name_scope().empty()) {
-      optimizers->push_back(
-          // Use the default target node name prefix "gradients/"
-          MakeUnique<MemoryOptimizer>(cfg_.memory_optimization()));
-    } else {
-      optimizers->push_back(MakeUnique<MemoryOptimizer>(
-          cfg_.memory_optimization(),
-          cfg_.memory_optimizer_target_node_name_scope()));
-    }
+    // Use the default target node name prefix "gradients/" if not set.
+    const string target_node_name_scope =
+        cfg_.memory_optimizer_target_node_name_scope().empty()
+            ? "gradients/"
+            : cfg_.memory_optimizer_target_node_name_scope();
+    optimizers->push_back(MakeUnique<MemoryOptimizer>(
+        cfg_.memory_optimization(), target_node_name_scope,
+        cfg_.memory_optimizer_recomputation_memory_limit_bytes()));
   }
   if (cfg_.auto_parallel().enable()) {
     optimizers->push_back(
@@ -372,6 +471,14 @@ Status MetaOptimizer::InitializeCustomGraphOptimizers(
   return Status::OK();
 }
 
+bool MetaOptimizer::UsesCustomOptimizers() const {
+  if (!cfg_.custom_optimizers().empty()) return true;
+  for (const string& optimizer_name : cfg_.optimizers()) {
+    if (!MakeNewOptimizer(optimizer_name)) return true;
+  }
+  return false;
+}
+
 const RewriterConfig::CustomGraphOptimizer*
 MetaOptimizer::GetCustomGraphOptimizerConfig(const string& name) const {
   for (const auto& config : cfg_.custom_optimizers()) {
@@ -457,6 +564,14 @@ Status MetaOptimizer::OptimizeGraph(Cluster* cluster, GrapplerItem&& item,
     CompressConstants(optimized_graph);
   }
 
+  // With multiple iterations, optimizers which left the graph unchanged are
+  // skipped until another optimizer changes it, and iteration stops once a
+  // whole iteration leaves the graph unchanged. `unchanged_graphs` maps each
+  // such optimizer to the fingerprint of the graph it didn't change.
+  const bool detect_fixpoint = NumIterations(cfg_) > 1;
+  absl::flat_hash_map<const GraphOptimizer*, uint64> unchanged_graphs;
+  uint64 fingerprint = detect_fixpoint ? GraphFingerprint(*optimized_graph) : 0;
+
   for (int iteration = 0; iteration < NumIterations(cfg_); ++iteration) {
     // Don't bother optimizing further if the graph is already tiny.
     if (optimized_graph->node_size() < min_graph_nodes) {
@@ -465,6 +580,7 @@ Status MetaOptimizer::OptimizeGraph(Cluster* cluster, GrapplerItem&& item,
               << "  < " << min_graph_nodes << ")";
       break;
     }
+    const uint64 iteration_start_fingerprint = fingerprint;
 
     VLOG(4) << "Starting optimization iteration " << iteration;
     if (VLOG_IS_ON(4)) {
@@ -483,6 +599,15 @@ Status MetaOptimizer::OptimizeGraph(Cluster* cluster, GrapplerItem&& item,
         if (sa_optimizer == nullptr) sa_optimizer = optimizer.get();
         continue;
       }
+      if (detect_fixpoint) {
+        auto unchanged = unchanged_graphs.find(optimizer.get());
+        if (unchanged != unchanged_graphs.end() &&
+            unchanged->second == fingerprint) {
+          VLOG(3) << "Skipping " << optimizer->name()
+                  << ", it didn't change the graph in its previous run";
+          continue;
+        }
+      }
 
       TF_RETURN_IF_ERROR(RunOptimizer(optimizer.get(), cluster, &item,
                                       optimized_graph, &optimization_result));
@@ -490,6 +615,13 @@ Status MetaOptimizer::OptimizeGraph(Cluster* cluster, GrapplerItem&& item,
       if (iteration == 0 && optimizer->name() == "model_pruner") {
         CompressConstants(optimized_graph);
       }
+      if (detect_fixpoint) {
+        const uint64 new_fingerprint = GraphFingerprint(*optimized_graph);
+        if (new_fingerprint == fingerprint) {
+          unchanged_graphs[optimizer.get()] = fingerprint;
+        }
+        fingerprint = new_fingerprint;
+      }
 
       if (VLOG_IS_ON(4)) {
         DumpGraphDefToFile(
@@ -513,6 +645,11 @@ Status MetaOptimizer::OptimizeGraph(Cluster* cluster, GrapplerItem&& item,
     for (const auto& verifier : post_optimization_verifiers) {
       TF_RETURN_IF_ERROR(verifier->Verify(*optimized_graph));
     }
+    if (detect_fixpoint && fingerprint == iteration_start_fingerprint) {
+      VLOG(3) << "Stopping after iteration " << iteration
+              << ", the graph didn't change";
+      break;
+    }
   }
 
   // ScopedAllocatorOptimizer must run last.
@@ -529,7 +666,10 @@ Status MetaOptimizer::OptimizeGraph(Cluster* cluster, GrapplerItem&& item,
                                    }) != optimization_result.results.end();
 
   // Record graph optimization result.
-  optimization_results_.push_back(optimization_result);
+  {
+    mutex_lock l(optimization_results_mu_);
+    optimization_results_.push_back(optimization_result);
+  }
 
   if (is_optimized) {
     TF_RETURN_IF_ERROR(TopologicalSort(optimized_graph));
@@ -544,6 +684,36 @@ Status MetaOptimizer::OptimizeGraph(Cluster* cluster, GrapplerItem&& item,
   return Status::OK();
 }
 
+Status MetaOptimizer::OptimizeFunctionBody(Cluster* cluster,
+                                           bool is_tpu_graph,
+                                           GrapplerItem&& func_item,
+                                           GraphDef* optimized_func_graph) {
+  if (!is_tpu_graph) {
+    return OptimizeGraph(cluster, std::move(func_item), optimized_func_graph);
+  }
+  // Skip optimizing functions if this is a TPU graph. Currently, Grappler
+  // passes do not handle TPU functions correctly in a variety of ways (Note
+  // that due to the pre-placement TPU graph rewriting passes, the TPU-related
+  // ops are encapsulated away into functions). For example, TPU graphs contain
+  // TPUReplicateMetadata node that carries relevant TPU metadata and Grappler
+  // passes could prune that away. Grappler passes could also cause issues
+  // around shape inference. Since the desired and existing behavior is to not
+  // optimize TPU functions with Grappler, this check preserves that. The only
+  // exception is implementation selector what is required to swap in some TPU
+  // specific lowering code and is verified the work correctly on TPUs.
+  ImplementationSelector implementation_selector;
+
+  // Implementation selector needs to have access to valid function signature
+  // and attributes, and it doesn't need actual function body.
+  FunctionDefLibrary func_item_function_library;
+  func_item_function_library.Swap(func_item.graph.mutable_library());
+  *func_item.graph.mutable_library() =
+      GetFunctionDefLibraryStub(func_item_function_library);
+
+  return implementation_selector.Optimize(cluster, func_item,
+                                          optimized_func_graph);
+}
+
 Status MetaOptimizer::RunOptimizer(
     GraphOptimizer* optimizer, Cluster* cluster, GrapplerItem* optimized_item,
     GraphDef* optimized_graph, GraphOptimizationResult* optimization_result) {
@@ -616,7 +786,10 @@ Status MetaOptimizer::OptimizeConsumeItem(Cluster* cluster, GrapplerItem&& item,
   const uint64 start_us = Env::Default()->NowMicros();
 
   VLOG(1) << "Starting optimization for grappler item: " << item.id;
-  optimization_results_.clear();
+  {
+    mutex_lock l(optimization_results_mu_);
+    optimization_results_.clear();
+  }
 
   // Constructs a FunctionLibraryDefinition with functions that are reachable
   // from the nodes of the graph.
@@ -698,9 +871,33 @@ Status MetaOptimizer::OptimizeConsumeItem(Cluster* cluster, GrapplerItem&& item,
 
   // Optimize each function only once.
   absl::flat_hash_set<string> optimized_funcs;
+  const bool is_tpu_graph = IsTPUGraphDef(*optimized_graph);
+  // Functions are optimized in parallel and cached across runs, unless custom
+  // optimizers are involved.
+  const bool parallel_and_cached = !UsesCustomOptimizers();
+  const std::vector<string> device_names =
+      cluster != nullptr ? cluster->GetDeviceNames() : std::vector<string>();
+
+  // A function to optimize in the current pass over the library.
+  struct FunctionOptimization {
+    string name;
+    GrapplerFunctionItem item;
+    Fprint128 cache_key;
+    // Set if the optimized function was found in the cache.
+    std::shared_ptr<const OptimizedFunction> cached;
+    Status status;
+    GraphDef optimized_body;
+    // Specialized functions created while optimizing the body.
+    std::vector<FunctionDef> new_functions;
+  };
+
   while (optimize_function_library) {
     optimize_function_library = false;
 
+    // The functions of a pass are optimized independently of each other,
+    // against the library as it was at the start of the pass, and merged
+    // back into the library in library order once they are all optimized.
+    std::vector<FunctionOptimization> functions;
     int function_idx = 0;
     for (const FunctionDef& func : optimized_graph->library().function()) {
       GRAPPLER_RETURN_IF_DEADLINE_EXCEEDED();
@@ -732,8 +929,12 @@ Status MetaOptimizer::OptimizeConsumeItem(Cluster* cluster, GrapplerItem&& item,
       optimize_function_library = true;
       optimized_funcs.insert(func_name);
 
+      functions.emplace_back();
+      FunctionOptimization& function = functions.back();
+      function.name = func_name;
+
       // Make a GrapplerItem from a FunctionDef.
-      GrapplerFunctionItem func_item;
+      GrapplerFunctionItem& func_item = function.item;
       TF_RETURN_IF_ERROR(
           MakeGrapplerFunctionItem(func, flib, producer, &func_item));
 
@@ -757,53 +958,96 @@ Status MetaOptimizer::OptimizeConsumeItem(Cluster* cluster, GrapplerItem&& item,
       func_item.optimization_options().allow_pruning_stateful_and_dataset_ops =
           false;
 
-      // Optimize function body graph.
-      GraphDef optimized_func_graph;
-      if (IsTPUGraphDef(*optimized_graph)) {
-        // Skip optimizing functions if this is a TPU graph. Currently, Grappler
-        // passes do not handle TPU functions correctly in a variety of ways
-        // (Note that due to the pre-placement TPU graph rewriting passes, the
-        // TPU-related ops are encapsulated away into functions). For example,
-        // TPU graphs contain TPUReplicateMetadata node that carries relevant
-        // TPU metadata and Grappler passes could prune that away. Grappler
-        // passes could also cause issues around shape inference. Since the
-        // desired and existing behavior is to not optimize TPU functions with
-        // Grappler, this check preserves that. The only exception is
-        // implementation selector what is required to swap in some TPU specific
-        // lowering code and is verified the work correctly on TPUs.
-        ImplementationSelector implementation_selector;
-
-        // Implementation selector needs to have access to valid function
-        // signature and attributes, and it doesn't need actual function body.
-        FunctionDefLibrary func_item_function_library;
-        func_item_function_library.Swap(func_item.graph.mutable_library());
-        *func_item.graph.mutable_library() =
-            GetFunctionDefLibraryStub(func_item_function_library);
-
-        TF_RETURN_IF_ERROR(implementation_selector.Optimize(
-            cluster, func_item, &optimized_func_graph));
-      } else {
-        GrapplerFunctionItem func_item_copy = func_item;
-        TF_RETURN_IF_ERROR(OptimizeGraph(cluster, std::move(func_item_copy),
-                                         &optimized_func_graph));
+      if (parallel_and_cached) {
+        function.cache_key = OptimizedFunctionCacheKey(
+            func, flib, producer,
+            func_item.optimization_options().allow_non_differentiable_rewrites,
+            is_tpu_graph, config_proto_, device_names);
+        function.cached =
+            OptimizedFunctionCache::Global()->Lookup(function.cache_key);
+        if (function.cached) {
+          VLOG(3) << "Found optimized function " << func_name << " in cache";
+        }
       }
+    }
 
-      // Function body optimization might have created new specialized
-      // functions for each instantiation context. Add them to the library.
+    // Optimize function bodies which weren't found in the cache.
+    std::vector<FunctionOptimization*> to_optimize;
+    for (FunctionOptimization& function : functions) {
+      if (!function.cached) to_optimize.push_back(&function);
+    }
+    const auto optimize = [&](FunctionOptimization* function) {
+      GrapplerFunctionItem func_item_copy = function->item;
+      function->status =
+          OptimizeFunctionBody(cluster, is_tpu_graph, std::move(func_item_copy),
+                               &function->optimized_body);
+      if (!function->status.ok()) return;
       for (const FunctionDef& func_def :
-           optimized_func_graph.library().function()) {
-        if (flib.Find(func_def.signature().name()) == nullptr) {
-          TF_RETURN_IF_ERROR(flib.AddFunctionDef(func_def));
+           function->optimized_body.library().function()) {
+        if (!flib.Contains(func_def.signature().name())) {
+          function->new_functions.push_back(func_def);
         }
       }
+    };
+    const int num_threads =
+        parallel_and_cached
+            ? std::min({static_cast<int>(to_optimize.size()),
+                        port::MaxParallelism(),
+                        kMaxFunctionOptimizationThreads})
+            : 1;
+    if (num_threads > 1) {
+      VLOG(2) << "Optimizing " << to_optimize.size() << " functions using "
+              << num_threads << " threads";
+      thread::ThreadPool pool(Env::Default(), "meta_optimizer_functions",
+                              num_threads);
+      BlockingCounter counter(to_optimize.size());
+      for (FunctionOptimization* function : to_optimize) {
+        pool.Schedule([&optimize, &counter, function]() {
+          optimize(function);
+          counter.DecrementCount();
+        });
+      }
+      counter.Wait();
+    } else {
+      for (FunctionOptimization* function : to_optimize) {
+        optimize(function);
+        if (!function->status.ok()) break;
+      }
+    }
 
-      // Convert optimized graph back to FunctionDef.
-      FunctionDef optimized_func;
-      func_item.SwapFunctionBody(std::move(optimized_func_graph));
-      TF_RETURN_IF_ERROR(MakeFunctionDef(func_item, flib, &optimized_func));
+    for (FunctionOptimization& function : functions) {
+      std::shared_ptr<const OptimizedFunction> optimized = function.cached;
+      if (!optimized) {
+        TF_RETURN_IF_ERROR(function.status);
+        auto new_optimized = std::make_shared<OptimizedFunction>();
+        new_optimized->new_functions = std::move(function.new_functions);
+        // Function body optimization might have created new specialized
+        // functions for each instantiation context. Add them to the library
+        // before converting the optimized graph back to a FunctionDef.
+        for (const FunctionDef& func_def : new_optimized->new_functions) {
+          if (flib.Find(func_def.signature().name()) == nullptr) {
+            TF_RETURN_IF_ERROR(flib.AddFunctionDef(func_def));
+          }
+        }
+        function.item.SwapFunctionBody(std::move(function.optimized_body));
+        TF_RETURN_IF_ERROR(
+            MakeFunctionDef(function.item, flib, &new_optimized->function));
+        if (parallel_and_cached) {
+          OptimizedFunctionCache::Global()->Insert(function.cache_key,
+                                                   new_optimized);
+        }
+        optimized = std::move(new_optimized);
+      } else {
+        for (const FunctionDef& func_def : optimized->new_functions) {
+          if (flib.Find(func_def.signature().name()) == nullptr) {
+            TF_RETURN_IF_ERROR(flib.AddFunctionDef(func_def));
+          }
+        }
+      }
 
       // Replace optimized function with a new FunctionDef.
-      TF_RETURN_IF_ERROR(flib.ReplaceFunction(func_name, optimized_func));
+      TF_RETURN_IF_ERROR(
+          flib.ReplaceFunction(function.name, optimized->function));
     }
 
     // If optimized at least one function, update the graph library.
@@ -829,6 +1073,7 @@ Status MetaOptimizer::OptimizeConsumeItem(Cluster* cluster, GrapplerItem&& item,
 }
 
 string MetaOptimizer::GetResultString() const {
+  mutex_lock l(optimization_results_mu_);
   std::string result_string;
   for (const GraphOptimizationResult& graph_result : optimization_results_) {
     absl::StrAppend(&result_string,
@@ -864,8 +1109,10 @@ bool MetaOptimizerEnabled(const ConfigProto& cfg) {
          rewrite_cfg.debug_stripper() == RewriterConfig::ON ||
          rewrite_cfg.scoped_allocator_optimization() == RewriterConfig::ON ||
          rewrite_cfg.pin_to_host_optimization() == RewriterConfig::ON ||
+         rewrite_cfg.horizontal_fusion() == RewriterConfig::ON ||
          AutoMixedPrecisionEnabled(rewrite_cfg.auto_mixed_precision()) ||
          AutoMixedPrecisionEnabled(rewrite_cfg.auto_mixed_precision_mkl()) ||
+         AutoMixedPrecisionEnabled(rewrite_cfg.auto_mixed_precision_cpu()) ||
          !rewrite_cfg.optimizers().empty() ||
          !rewrite_cfg.custom_optimizers().empty();
 }
@@ -880,6 +1127,39 @@ Status RunMetaOptimizer(GrapplerItem&& item, const ConfigProto& cfg,
                                        optimized_graph);
 }
 
+namespace {
+
+// Returns `config_proto` with the optimizers that the MLIR graph optimization
+// pipeline already ran on the function graphs turned off, unless they were
+// explicitly turned on.
+ConfigProto WithoutMlirReplacedOptimizers(const ConfigProto& config_proto,
+                                          const DeviceSet& device_set) {
+  if (!config_proto.experimental().enable_mlir_graph_optimization()) {
+    return config_proto;
+  }
+  ConfigProto config = config_proto;
+  RewriterConfig* rewriter_config =
+      config.mutable_graph_options()->mutable_rewrite_options();
+  if (rewriter_config->layout_optimizer() == RewriterConfig::DEFAULT) {
+    rewriter_config->set_layout_optimizer(RewriterConfig::OFF);
+  }
+  if (rewriter_config->constant_folding() == RewriterConfig::DEFAULT) {
+    rewriter_config->set_constant_folding(RewriterConfig::OFF);
+  }
+  // The pipeline only fuses kernels when there are no GPUs, as in
+  // MlirGraphOptimizationPass.
+  bool has_gpus = false;
+  for (const Device* device : device_set.devices()) {
+    has_gpus |= device->device_type() == DEVICE_GPU;
+  }
+  if (!has_gpus && rewriter_config->remapping() == RewriterConfig::DEFAULT) {
+    rewriter_config->set_remapping(RewriterConfig::OFF);
+  }
+  return config;
+}
+
+}  // namespace
+
 Status OptimizeGraph(
     std::vector<string> ret_node_names, std::vector<string> keep_node_names,
     FunctionLibraryDefinition* flib, const DeviceSet& device_set,
@@ -920,7 +1200,8 @@ Status OptimizeGraph(
   // TODO(nareshmodi): Consider adding and using the more generic GraphOptions
   // proto (which also contain the OptimizerOptions).
   TF_RETURN_IF_ERROR(tensorflow::grappler::RunMetaOptimizer(
-      std::move(item), config_proto, cpu_device, &cluster, &out_graph));
+      std::move(item), WithoutMlirReplacedOptimizers(config_proto, device_set),
+      cpu_device, &cluster, &out_graph));
 
   std::unique_ptr<tensorflow::Graph> optimized_graph(
       new tensorflow::Graph(OpRegistry::Global()));
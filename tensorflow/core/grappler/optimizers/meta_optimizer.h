@@ -24,6 +24,7 @@ limitations under the License.
 #include "tensorflow/core/grappler/optimizers/graph_optimizer.h"
 #include "tensorflow/core/grappler/verifiers/graph_verifier.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/protobuf/config.pb.h"
 #include "tensorflow/core/protobuf/rewriter_config.pb.h"
 #include "tensorflow/core/protobuf/verifier_config.pb.h"
@@ -77,6 +78,12 @@ class MetaOptimizer : public GraphOptimizer {
   const RewriterConfig::CustomGraphOptimizer* GetCustomGraphOptimizerConfig(
       const string& name) const;
 
+  // Returns true if any of the configured optimizers is a custom graph
+  // optimizer. Custom optimizers aren't known to be thread-safe or to depend
+  // only on the graph they optimize, so functions are then optimized
+  // sequentially and without caching.
+  bool UsesCustomOptimizers() const;
+
   // Initialize active verifiers from the RewriterConfig toggles.
   void InitializeVerifiers(
       std::vector<std::unique_ptr<GraphVerifier>>* inter_optimizer_verifiers,
@@ -88,6 +95,12 @@ class MetaOptimizer : public GraphOptimizer {
   Status OptimizeGraph(Cluster* cluster, GrapplerItem&& item,
                        GraphDef* optimized_graph);
 
+  // Optimizes the body of a function. This is thread-safe, so that the
+  // functions of a library can be optimized in parallel.
+  Status OptimizeFunctionBody(Cluster* cluster, bool is_tpu_graph,
+                              GrapplerItem&& func_item,
+                              GraphDef* optimized_func_graph);
+
   DeviceBase* const cpu_device_;  // may be NULL
   ConfigProto config_proto_;
   RewriterConfig& cfg_;
@@ -108,7 +121,9 @@ class MetaOptimizer : public GraphOptimizer {
                       GrapplerItem* optimized_item, GraphDef* optimized_graph,
                       GraphOptimizationResult* optimization_result);
 
-  std::vector<GraphOptimizationResult> optimization_results_;
+  mutable mutex optimization_results_mu_;
+  std::vector<GraphOptimizationResult> optimization_results_
+      TF_GUARDED_BY(optimization_results_mu_);
 };
 
 bool MetaOptimizerEnabled(const ConfigProto& cfg);
@@ -132,6 +132,39 @@ gtl::FlatMap<string, GrapplerItem::OptimizationOptions>*
 
 REGISTER_GRAPH_OPTIMIZER(GrapplerItemPropertiesAccumulator);
 
+// Counts its runs, leaving the graph unchanged.
+class CountingOptimizer : public CustomGraphOptimizer {
+ public:
+  static void ResetNumRuns() { num_runs_ = 0; }
+  static int NumRuns() { return num_runs_; }
+
+  CountingOptimizer() {}
+  string name() const override { return "counting_optimizer"; }
+  bool UsesFunctionLibrary() const override { return false; }
+
+  Status Init(
+      const tensorflow::RewriterConfig_CustomGraphOptimizer* config) override {
+    return Status::OK();
+  }
+
+  Status Optimize(Cluster* cluster, const GrapplerItem& item,
+                  GraphDef* optimized_graph) override {
+    num_runs_++;
+    *optimized_graph = item.graph;
+    return Status::OK();
+  }
+
+  void Feedback(Cluster* cluster, const GrapplerItem& item,
+                const GraphDef& optimized_graph, double result) override {}
+
+ private:
+  static int num_runs_;
+};
+
+int CountingOptimizer::num_runs_;
+
+REGISTER_GRAPH_OPTIMIZER(CountingOptimizer);
+
 class MetaOptimizerTest : public GrapplerTest {};
 
 TEST_F(MetaOptimizerTest, RunsCustomOptimizer) {
@@ -234,6 +267,70 @@ TEST_F(MetaOptimizerTest, RunToggleOptimizersAndCustomGraphOptimizerTwice) {
   EXPECT_TRUE(TestGraphOptimizer::IsOptimized());
 }
 
+TEST_F(MetaOptimizerTest, SkipsOptimizersWhichLeftGraphUnchanged) {
+  TrivialTestGraphInputYielder fake_input(4, 1, 10, false, {"CPU:0"});
+  GrapplerItem item;
+  ASSERT_TRUE(fake_input.NextItem(&item));
+
+  ConfigProto config_proto;
+  auto& rewriter_config =
+      *config_proto.mutable_graph_options()->mutable_rewrite_options();
+  rewriter_config.add_optimizers("CountingOptimizer");
+  rewriter_config.set_meta_optimizer_iterations(RewriterConfig::TWO);
+  rewriter_config.set_min_graph_nodes(-1);
+
+  CountingOptimizer::ResetNumRuns();
+  MetaOptimizer optimizer(nullptr, config_proto);
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+  // The second iteration is skipped, since the first one didn't change the
+  // graph.
+  EXPECT_EQ(CountingOptimizer::NumRuns(), 1);
+}
+
+TEST_F(MetaOptimizerTest, ReusesOptimizedFunctions) {
+  using test::function::NDef;
+
+  ConfigProto config_proto;
+  auto& rewriter_config =
+      *config_proto.mutable_graph_options()->mutable_rewrite_options();
+  rewriter_config.add_optimizers("pruning");
+  rewriter_config.set_min_graph_nodes(-1);
+
+  FunctionDef mul_func = FunctionDefHelper::Create(
+      "ReusedMul", {"x:float", "y:float"}, {"z:float"}, {},
+      {{{"mul"}, "Mul", {"x", "y"}, {{"T", DT_FLOAT}}},
+       {{"id"}, "Identity", {"mul:z:0"}, {{"T", DT_FLOAT}}}},
+      /*ret_def=*/
+      {{"z", "id:output:0"}});
+
+  GrapplerItem item;
+  item.id = "main";
+  item.graph = test::function::GDef(
+      {NDef("x", "Placeholder", {}, {{"dtype", DT_FLOAT}}, kDevice),
+       NDef("mul", "ReusedMul", {"x", "x"}, {}, kDevice)},
+      /*funcs=*/
+      {mul_func});
+  item.fetch = {"mul"};
+
+  MetaOptimizer optimizer1(nullptr, config_proto);
+  GraphDef output1;
+  TF_EXPECT_OK(optimizer1.Optimize(nullptr, item, &output1));
+  EXPECT_THAT(optimizer1.GetResultString(),
+              ::testing::HasSubstr("grappler item: ReusedMul"));
+
+  // The function is taken from the cache instead of being optimized again.
+  MetaOptimizer optimizer2(nullptr, config_proto);
+  GraphDef output2;
+  TF_EXPECT_OK(optimizer2.Optimize(nullptr, item, &output2));
+  EXPECT_THAT(optimizer2.GetResultString(),
+              ::testing::Not(::testing::HasSubstr("grappler item: ReusedMul")));
+  CompareGraphs(output1, output2);
+  ASSERT_EQ(output2.library().function_size(), 1);
+  EXPECT_EQ(output1.library().function(0).SerializeAsString(),
+            output2.library().function(0).SerializeAsString());
+}
+
 TEST_F(MetaOptimizerTest, OptimizeFunctionLibrary) {
   using test::function::NDef;
 
@@ -15,7 +15,10 @@ limitations under the License.
 
 #include "tensorflow/core/grappler/optimizers/remapper.h"
 
+#include <algorithm>
+
 #include "absl/container/flat_hash_set.h"
+#include "absl/strings/str_join.h"
 #include "tensorflow/core/framework/versions.pb.h"
 #include "tensorflow/core/grappler/costs/graph_properties.h"
 #include "tensorflow/core/grappler/graph_view.h"
@@ -27,6 +30,7 @@ limitations under the License.
 #include "tensorflow/core/grappler/utils/symbolic_shapes.h"
 #include "tensorflow/core/grappler/utils/topological_sort.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/util/env_var.h"
 
@@ -56,14 +60,36 @@ namespace grappler {
 //
 // In all cases, the supported activation functions are Relu, Relu6, and Elu.
 //
+// On CPU, Conv2D and MatMul followed by BiasAdd can also absorb a chain of
+// unary element-wise ops (e.g. BiasAdd + Tanh + Square), which is evaluated
+// in the contraction output kernel while the output block is still in cache:
+//
+//   {Conv2D,MatMul} + BiasAdd + <Op> + ... + <Op> -> _Fused{Conv2D,MatMul}
+//
 // Both Conv2D and MatMul implemented as Tensor contraction (on CPU), so all the
 // patterns are "ContractionWith...".
+//
+// Scaled dot-product attention is computed by _FusedAttention without
+// materializing the scores, on CPU and GPU:
+//
+//   BatchMatMul(Softmax(BatchMatMul(q, k, adj_y) [* scale]), v)
+//     -> _FusedAttention(q, k, v)
+//
+// MatMul with a large constant weight that is mostly zeros is computed as a
+// sparse-dense product with the CSR kernels, on CPU and GPU. The weight is
+// converted to sparse components once here:
+//
+//   MatMul(x, w) -> SparseMatrixMatMul(SparseTensorToCSRSparseMatrix(w'), x)
 namespace {
 
 constexpr char kFusedConv2D[] = "_FusedConv2D";
 constexpr char kFusedMatMul[] = "_FusedMatMul";
 constexpr char kFusedDepthwiseConv2dNative[] = "_FusedDepthwiseConv2dNative";
 constexpr char kFusedBatchNormEx[] = "_FusedBatchNormEx";
+constexpr char kFusedAttention[] = "_FusedAttention";
+constexpr char kSparseMatrixMatMul[] = "SparseMatrixMatMul";
+constexpr char kSparseTensorToCSRSparseMatrix[] =
+    "SparseTensorToCSRSparseMatrix";
 
 constexpr char kDataFormat[] = "data_format";
 constexpr char kIsTraining[] = "is_training";
@@ -125,6 +151,41 @@ struct ContractionWithBiasAddAndActivation {
   int activation = kMissingIndex;
 };
 
+// Contraction node followed by a BiasAdd and a chain of unary element-wise
+// ops. Element-wise ops are stored in the order they are applied.
+struct ContractionWithBiasAddAndElementwiseChain {
+  ContractionWithBiasAddAndElementwiseChain() = default;
+  ContractionWithBiasAddAndElementwiseChain(int contraction, int bias_add,
+                                            std::vector<int> elementwise_chain)
+      : contraction(contraction),
+        bias_add(bias_add),
+        elementwise_chain(std::move(elementwise_chain)) {}
+
+  int contraction = kMissingIndex;
+  int bias_add = kMissingIndex;
+  std::vector<int> elementwise_chain;
+};
+
+// Softmax over the scores of two batched matrix multiplications, optionally
+// scaled by a constant: BatchMatMul(Softmax(BatchMatMul(q, k^T) * scale), v).
+struct Attention {
+  Attention() = default;
+
+  int scores = kMissingIndex;
+  int scale = kMissingIndex;
+  int softmax = kMissingIndex;
+  int output = kMissingIndex;
+  float scale_value = 1.0f;
+};
+
+// MatMul whose second input is a constant weight that is mostly zeros.
+struct SparseWeightMatMul {
+  SparseWeightMatMul() = default;
+
+  int matmul = kMissingIndex;
+  int weight = kMissingIndex;
+};
+
 // Contraction node followed by a Squeeze and BiasAdd.
 struct ContractionWithSqueezeAndBiasAdd {
   ContractionWithSqueezeAndBiasAdd() = default;
@@ -283,6 +344,59 @@ bool IsGpuCompatibleConv2D(const NodeDef* conv2d) {
          IsGpuCompatibleDataFormat(conv2d);
 }
 
+// Weights with fewer elements are multiplied densely, the CSR kernels do not
+// pay off for them.
+constexpr int64 kMinSparseWeightSize = 64 * 64;
+
+// Returns the minimum fraction of zeros of a constant MatMul weight for which
+// the MatMul is computed as a sparse-dense product. It can be changed with
+// TF_REMAPPER_SPARSE_MATMUL_MIN_SPARSITY, a value above 1 disables the rewrite.
+float SparseWeightMinSparsity() {
+  static float min_sparsity = [] {
+    float min_sparsity = 0.8f;
+    TF_CHECK_OK(tensorflow::ReadFloatFromEnvVar(
+        "TF_REMAPPER_SPARSE_MATMUL_MIN_SPARSITY",
+        /*default_val=*/0.8f, &min_sparsity));
+    return min_sparsity;
+  }();
+  return min_sparsity;
+}
+
+// Returns true if `node` is a large constant 2-D float matrix whose fraction
+// of zeros is at least SparseWeightMinSparsity().
+bool IsSparseConstWeight(const NodeDef& node) {
+  if (!IsConstant(node) || !HasDataType(&node, DT_FLOAT, "dtype")) return false;
+  const TensorProto& proto = node.attr().at("value").tensor();
+  const TensorShapeProto& shape = proto.tensor_shape();
+  if (shape.dim_size() != 2) return false;
+  const int64 num_elements = shape.dim(0).size() * shape.dim(1).size();
+  if (num_elements < kMinSparseWeightSize) return false;
+
+  Tensor tensor;
+  if (!tensor.FromProto(proto)) return false;
+  // Stop at the first non-zero over the limit, dense weights are rejected
+  // without scanning them entirely.
+  const auto values = tensor.flat<float>();
+  const double max_nonzeros =
+      (1.0 - SparseWeightMinSparsity()) * static_cast<double>(num_elements);
+  int64 num_nonzeros = 0;
+  for (int64 i = 0; i < num_elements; ++i) {
+    if (values(i) != 0.0f && ++num_nonzeros > max_nonzeros) return false;
+  }
+  return true;
+}
+
+// Returns true if `matmul` multiplies by a sparse constant weight, and should
+// be rewritten to a SparseMatrixMatMul instead of being fused.
+bool HasSparseConstWeight(const RemapperContext& ctx, const NodeDef& matmul) {
+  if (!IsMatMul(matmul) || !HasDataType(&matmul, DT_FLOAT)) return false;
+  const auto* matmul_view = ctx.graph_view.GetNode(matmul.name());
+  if (matmul_view == nullptr || matmul_view->NumRegularFanins() != 2)
+    return false;
+  const auto* weight_view = matmul_view->GetRegularFanin(1).node_view();
+  return IsSparseConstWeight(*weight_view->node());
+}
+
 bool IsCpuCompatibleMatMul(const NodeDef* matmul) {
   DCHECK(IsMatMul(*matmul)) << "Expected MatMul op";
   return NodeIsOnCpu(matmul) && IsCpuCompatibleDataType(matmul);
@@ -307,7 +421,7 @@ bool IsCpuCompatible(const RemapperContext& ctx, const Pattern& matched) {
     return false;
 #endif  // INTEL_MKL
   } else if (IsMatMul(node)) {
-    return IsCpuCompatibleMatMul(&node);
+    return IsCpuCompatibleMatMul(&node) && !HasSparseConstWeight(ctx, node);
   } else {
     return false;
   }
@@ -353,6 +467,11 @@ bool IsGpuCompatible(const RemapperContext& ctx,
                      const ContractionWithSqueezeAndBiasAdd& matched) {
   return false;
 }
+bool IsGpuCompatible(
+    const RemapperContext& ctx,
+    const ContractionWithBiasAddAndElementwiseChain& matched) {
+  return false;
+}
 
 // Returns true if the given pattern is supported on the assigned device.
 template <typename Pattern>
@@ -364,6 +483,15 @@ bool IsSupportedActivation(const NodeDef& node) {
   return IsRelu(node) || IsRelu6(node) || IsElu(node);
 }
 
+// Returns true if the node is a unary element-wise op that can be evaluated
+// by the contraction output kernel (see kernels/fused_eigen_output_kernels.h).
+bool IsSupportedElementwiseChainOp(const NodeDef& node) {
+  static const auto* const kSupportedOps = new absl::flat_hash_set<string>(
+      {"Abs", "Elu", "Exp", "Log", "Neg", "Relu", "Relu6", "Rsqrt", "Sigmoid",
+       "Sqrt", "Square", "Tanh"});
+  return kSupportedOps->contains(node.op());
+}
+
 inline bool HasControlFaninOrFanout(const utils::MutableNodeView& node_view) {
   return node_view.NumControllingFanins() > 0 ||
          node_view.NumControlledFanouts() > 0;
@@ -461,6 +589,211 @@ bool FindContractionWithBiasAndActivation(
   return true;
 }
 
+bool FindContractionWithBiasAndElementwiseChain(
+    const RemapperContext& ctx, int node_index,
+    ContractionWithBiasAddAndElementwiseChain* matched) {
+  const auto* node_view = ctx.graph_view.GetNode(node_index);
+  // Root of the pattern must be the last element-wise op in the chain.
+  if (HasControlFaninOrFanout(*node_view)) return false;
+
+  const auto* node_def = node_view->node();
+  if (!IsSupportedElementwiseChainOp(*node_def)) return false;
+
+  // Walk up the chain of element-wise ops until we reach a non element-wise
+  // node, which must match the ContractionWithBiasAdd pattern. All nodes
+  // except the root are removed from the graph, and must not be observable.
+  std::vector<int> elementwise_chain;
+  const auto* chain_node_view = node_view;
+  while (IsSupportedElementwiseChainOp(*chain_node_view->node())) {
+    elementwise_chain.push_back(chain_node_view->node_index());
+
+    if (chain_node_view->NumRegularFanins() < 1) return false;
+    const auto* input_node_view =
+        chain_node_view->GetRegularFanin(0).node_view();
+    const auto* input_node_def = input_node_view->node();
+    if (HasControlFaninOrFanout(*input_node_view) ||
+        !HasAtMostOneFanoutAtPort0(*input_node_view) ||
+        !HaveSameDataType(node_def, input_node_def) ||
+        IsInPreserveSet(ctx, input_node_def))
+      return false;
+
+    chain_node_view = input_node_view;
+  }
+
+  ContractionWithBiasAdd base;
+  if (!FindContractionWithBias(ctx, chain_node_view->node_index(), &base,
+                               /*check_device_compatible=*/false))
+    return false;
+
+  std::reverse(elementwise_chain.begin(), elementwise_chain.end());
+  ContractionWithBiasAddAndElementwiseChain pattern{
+      base.contraction, base.bias_add, std::move(elementwise_chain)};
+
+  // DepthwiseConv2dNative kernel does not support element-wise op chains.
+  const NodeDef& contraction = ctx.graph_view.graph()->node(base.contraction);
+  if (IsDepthwiseConv2dNative(contraction)) return false;
+
+  // Check that data type and data format are supported on assigned device.
+  if (!IsDeviceCompatible(ctx, pattern)) return false;
+
+  // We successfully found a {Conv2D, MatMul}+BiasAdd+<Op>+... pattern.
+  *matched = std::move(pattern);
+
+  return true;
+}
+
+// Returns the `value` of a scalar float constant.
+bool GetScalarConstValue(const NodeDef& node, float* value) {
+  if (!IsConstant(node) || !HasDataType(&node, DT_FLOAT, "dtype")) return false;
+  Tensor tensor;
+  if (!tensor.FromProto(node.attr().at("value").tensor()) ||
+      tensor.NumElements() != 1)
+    return false;
+  *value = tensor.flat<float>()(0);
+  return true;
+}
+
+// Returns true if both shapes have a known rank of at least 3 and the same
+// batch dimensions. _FusedAttention does not broadcast them like BatchMatMul.
+bool HaveSameBatchDimensions(const TensorShapeProto& lhs,
+                             const TensorShapeProto& rhs) {
+  const int rank = Rank(lhs);
+  if (rank < 3 || Rank(rhs) != rank) return false;
+  for (int i = 0; i < rank - 2; ++i) {
+    if (!IsKnownSymbolically(lhs.dim(i)) ||
+        lhs.dim(i).size() != rhs.dim(i).size())
+      return false;
+  }
+  return true;
+}
+
+// Checks that the inputs of a matched attention pattern are supported by the
+// _FusedAttention kernel on the assigned device.
+bool IsAttentionCompatible(const RemapperContext& ctx,
+                           const Attention& matched) {
+  const GraphDef* graph = ctx.graph_view.graph();
+  const NodeDef& scores = graph->node(matched.scores);
+  const NodeDef& output = graph->node(matched.output);
+
+  const auto& scores_props =
+      ctx.graph_properties.GetInputProperties(scores.name());
+  const auto& output_props =
+      ctx.graph_properties.GetInputProperties(output.name());
+  if (scores_props.size() < 2 || output_props.size() < 2) return false;
+  const TensorShapeProto& query = scores_props[0].shape();
+  const TensorShapeProto& key = scores_props[1].shape();
+  const TensorShapeProto& value = output_props[1].shape();
+  if (!HaveSameBatchDimensions(query, key) ||
+      !HaveSameBatchDimensions(query, value))
+    return false;
+
+  if (NodeIsOnCpu(&output)) return true;
+
+#if GOOGLE_CUDA
+  // The GPU kernel keeps a row of the output per warp in registers, see
+  // kernels/fused_attention_op.h.
+  constexpr int64 kMaxGpuDepth = 128;
+  const auto is_supported_gpu_depth = [](const TensorShapeProto& shape) {
+    const auto& depth = shape.dim(Rank(shape) - 1);
+    return IsKnown(depth) && depth.size() <= kMaxGpuDepth;
+  };
+  return NodeIsOnGpu(&output) && is_supported_gpu_depth(query) &&
+         is_supported_gpu_depth(value);
+#else
+  return false;
+#endif  // GOOGLE_CUDA
+}
+
+bool FindAttention(const RemapperContext& ctx, int node_index,
+                   Attention* matched) {
+  const auto* node_view = ctx.graph_view.GetNode(node_index);
+  // Root of the pattern must be the BatchMatMul of the probabilities with the
+  // values.
+  if (HasControlFaninOrFanout(*node_view)) return false;
+
+  const auto* node_def = node_view->node();
+  const auto is_batch_matmul = [](const NodeDef& node, bool adj_y) -> bool {
+    if (!IsAnyBatchMatMul(node) || !HasDataType(&node, DT_FLOAT)) return false;
+    bool node_adj_x = false;
+    bool node_adj_y = false;
+    if (!TryGetNodeAttr(node, "adj_x", &node_adj_x) ||
+        !TryGetNodeAttr(node, "adj_y", &node_adj_y))
+      return false;
+    return !node_adj_x && node_adj_y == adj_y;
+  };
+  if (!is_batch_matmul(*node_def, /*adj_y=*/false)) return false;
+
+  // All nodes except the root are removed from the graph, and must not be
+  // observable.
+  const auto is_intermediate = [&](const utils::MutableNodeView& view) {
+    return !HasControlFaninOrFanout(view) && HasAtMostOneFanoutAtPort0(view) &&
+           view.node()->device() == node_def->device() &&
+           !IsInPreserveSet(ctx, view.node());
+  };
+
+  if (node_view->NumRegularFanins() < 2) return false;
+  const auto* softmax_view = node_view->GetRegularFanin(0).node_view();
+  if (!IsSoftmax(*softmax_view->node()) ||
+      !HaveSameDataType(node_def, softmax_view->node()) ||
+      !is_intermediate(*softmax_view) || softmax_view->NumRegularFanins() < 1)
+    return false;
+
+  Attention pattern;
+  pattern.softmax = softmax_view->node_index();
+  pattern.output = node_index;
+
+  // Optional scaling of the scores by a scalar constant.
+  const auto* scores_view = softmax_view->GetRegularFanin(0).node_view();
+  if (IsMul(*scores_view->node()) && scores_view->NumRegularFanins() == 2) {
+    const auto* scale_view = scores_view;
+    if (!is_intermediate(*scale_view)) return false;
+    const auto* lhs = scale_view->GetRegularFanin(0).node_view();
+    const auto* rhs = scale_view->GetRegularFanin(1).node_view();
+    if (GetScalarConstValue(*rhs->node(), &pattern.scale_value)) {
+      scores_view = lhs;
+    } else if (GetScalarConstValue(*lhs->node(), &pattern.scale_value)) {
+      scores_view = rhs;
+    } else {
+      return false;
+    }
+    pattern.scale = scale_view->node_index();
+  }
+
+  if (!is_batch_matmul(*scores_view->node(), /*adj_y=*/true) ||
+      !is_intermediate(*scores_view))
+    return false;
+  pattern.scores = scores_view->node_index();
+
+  if (!IsAttentionCompatible(ctx, pattern)) return false;
+
+  // We successfully found a BatchMatMul+[Mul]+Softmax+BatchMatMul pattern.
+  *matched = pattern;
+
+  return true;
+}
+
+bool FindSparseWeightMatMul(const RemapperContext& ctx, int node_index,
+                            SparseWeightMatMul* matched) {
+  const auto* node_view = ctx.graph_view.GetNode(node_index);
+  if (HasControlFaninOrFanout(*node_view)) return false;
+
+  const auto* node_def = node_view->node();
+  if (!IsMatMul(*node_def) || !HasSparseConstWeight(ctx, *node_def))
+    return false;
+
+#if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+  if (!NodeIsOnCpu(node_def) && !NodeIsOnGpu(node_def)) return false;
+#else
+  if (!NodeIsOnCpu(node_def)) return false;
+#endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+
+  // We successfully found a MatMul with a sparse constant weight.
+  matched->matmul = node_index;
+  matched->weight = node_view->GetRegularFanin(1).node_index();
+
+  return true;
+}
+
 bool FindConv2DWithSqueezeAndBias(const RemapperContext& ctx, int node_index,
                                   ContractionWithSqueezeAndBiasAdd* matched) {
   const auto* node_view = ctx.graph_view.GetNode(node_index);
@@ -1088,6 +1421,62 @@ Status AddFusedContractionNode(
   return Status::OK();
 }
 
+Status AddFusedContractionNode(
+    RemapperContext* ctx,
+    const ContractionWithBiasAddAndElementwiseChain& matched,
+    std::vector<bool>* invalidated_nodes, std::vector<bool>* nodes_to_delete) {
+  DCHECK(IsDeviceCompatible(*ctx, matched)) << "Unsupported fusion pattern";
+  DCHECK(!matched.elementwise_chain.empty()) << "Empty element-wise chain";
+
+  const GraphDef* graph = ctx->graph_view.graph();
+  const NodeDef& contraction = graph->node(matched.contraction);
+  const NodeDef& bias_add = graph->node(matched.bias_add);
+  const NodeDef& root = graph->node(matched.elementwise_chain.back());
+
+  std::vector<absl::string_view> fused_ops = {"BiasAdd"};
+  for (int elementwise : matched.elementwise_chain) {
+    fused_ops.push_back(graph->node(elementwise).op());
+  }
+  VLOG(2) << "Fuse " << contraction.op() << " with BiasAdd and element-wise "
+          << "ops [" << absl::StrJoin(fused_ops.begin() + 1, fused_ops.end(),
+                                      ", ")
+          << "]:"
+          << " root=" << root.name() << " bias_add=" << bias_add.name()
+          << " contraction=" << contraction.name();
+
+  NodeDef fused_op;
+  fused_op.set_name(root.name());
+  fused_op.set_device(contraction.device());
+  fused_op.add_input(contraction.input(0));  // 0: input
+  fused_op.add_input(contraction.input(1));  // 1: filter
+  fused_op.add_input(bias_add.input(1));     // 2: bias
+
+  if (IsConv2D(contraction)) {
+    fused_op.set_op(kFusedConv2D);
+    CopyConv2DAttributes(contraction, &fused_op);
+  } else if (IsMatMul(contraction)) {
+    fused_op.set_op(kFusedMatMul);
+    CopyMatMulAttributes(contraction, &fused_op);
+  }
+
+  SetFusedOpAttributes(&fused_op, fused_ops);
+
+  utils::Mutation* mutation = ctx->graph_view.GetMutationBuilder();
+  Status status;
+  mutation->AddNode(std::move(fused_op), &status);
+  TF_RETURN_IF_ERROR(status);
+  TF_RETURN_IF_ERROR(mutation->Apply());
+
+  (*nodes_to_delete)[matched.contraction] = true;
+  (*nodes_to_delete)[matched.bias_add] = true;
+  for (size_t i = 0; i + 1 < matched.elementwise_chain.size(); ++i) {
+    (*nodes_to_delete)[matched.elementwise_chain[i]] = true;
+  }
+  (*invalidated_nodes)[matched.elementwise_chain.back()] = true;
+
+  return Status::OK();
+}
+
 Status AddFusedConv2DNode(RemapperContext* ctx,
                           const ContractionWithSqueezeAndBiasAdd& matched,
                           std::vector<bool>* invalidated_nodes,
@@ -1301,6 +1690,161 @@ Status AddFusedContractionNode(
 }
 #endif
 
+Status AddFusedAttentionNode(RemapperContext* ctx, const Attention& matched,
+                             std::vector<bool>* invalidated_nodes,
+                             std::vector<bool>* nodes_to_delete) {
+  const GraphDef* graph = ctx->graph_view.graph();
+  const NodeDef& scores = graph->node(matched.scores);
+  const NodeDef& output = graph->node(matched.output);
+  VLOG(2) << "Fuse attention:"
+          << " scores=" << scores.name() << " output=" << output.name()
+          << " scale=" << matched.scale_value;
+
+  NodeDef fused_op;
+  fused_op.set_name(output.name());
+  fused_op.set_op(kFusedAttention);
+  fused_op.set_device(output.device());
+  fused_op.add_input(scores.input(0));  // 0: query
+  fused_op.add_input(scores.input(1));  // 1: key
+  fused_op.add_input(output.input(1));  // 2: value
+
+  auto* attr = fused_op.mutable_attr();
+  (*attr)["T"] = output.attr().at("T");
+  SetAttrValue(matched.scale_value, &(*attr)["scale"]);
+
+  utils::Mutation* mutation = ctx->graph_view.GetMutationBuilder();
+  Status status;
+  mutation->AddNode(std::move(fused_op), &status);
+  TF_RETURN_IF_ERROR(status);
+  TF_RETURN_IF_ERROR(mutation->Apply());
+
+  (*invalidated_nodes)[matched.output] = true;
+  (*nodes_to_delete)[matched.softmax] = true;
+  (*nodes_to_delete)[matched.scores] = true;
+  if (matched.scale != kMissingIndex) {
+    (*nodes_to_delete)[matched.scale] = true;
+  }
+
+  return Status::OK();
+}
+
+// Replaces x * op(w) by (a * op(x)^T)^T, where `a` = op(w)^T is stored in CSR
+// form. This way the kernel iterates over the rows of the sparse matrix, which
+// it parallelizes without transposing the sparse matrix:
+//
+//   MatMul(x, w) -> SparseMatrixMatMul(csr(w^T), x, transpose_b=true,
+//                                      transpose_output=true)
+Status AddSparseWeightMatMulNodes(RemapperContext* ctx,
+                                  const SparseWeightMatMul& matched,
+                                  std::vector<bool>* invalidated_nodes) {
+  const GraphDef* graph = ctx->graph_view.graph();
+  const NodeDef& matmul = graph->node(matched.matmul);
+  const NodeDef& weight = graph->node(matched.weight);
+
+  Tensor weight_tensor;
+  if (!weight_tensor.FromProto(weight.attr().at("value").tensor())) {
+    return errors::InvalidArgument("Cannot parse the weight of ",
+                                   matmul.name());
+  }
+  bool transpose_a = false;
+  bool transpose_b = false;
+  TF_RETURN_IF_ERROR(GetNodeAttr(matmul, "transpose_a", &transpose_a));
+  TF_RETURN_IF_ERROR(GetNodeAttr(matmul, "transpose_b", &transpose_b));
+
+  const auto w = weight_tensor.matrix<float>();
+  const int64 num_rows = transpose_b ? w.dimension(0) : w.dimension(1);
+  const int64 num_cols = transpose_b ? w.dimension(1) : w.dimension(0);
+  const auto a = [&](int64 row, int64 col) {
+    return transpose_b ? w(row, col) : w(col, row);
+  };
+
+  // The components of `a` as a SparseTensor, in row-major order.
+  int64 nnz = 0;
+  for (int64 row = 0; row < num_rows; ++row) {
+    for (int64 col = 0; col < num_cols; ++col) {
+      if (a(row, col) != 0.0f) ++nnz;
+    }
+  }
+  Tensor indices(DT_INT64, TensorShape({nnz, 2}));
+  Tensor values(DT_FLOAT, TensorShape({nnz}));
+  Tensor dense_shape(DT_INT64, TensorShape({2}));
+  auto indices_matrix = indices.matrix<int64>();
+  auto values_vec = values.vec<float>();
+  int64 index = 0;
+  for (int64 row = 0; row < num_rows; ++row) {
+    for (int64 col = 0; col < num_cols; ++col) {
+      const float value = a(row, col);
+      if (value == 0.0f) continue;
+      indices_matrix(index, 0) = row;
+      indices_matrix(index, 1) = col;
+      values_vec(index) = value;
+      ++index;
+    }
+  }
+  dense_shape.vec<int64>()(0) = num_rows;
+  dense_shape.vec<int64>()(1) = num_cols;
+  VLOG(2) << "Multiply by a sparse weight:"
+          << " matmul=" << matmul.name() << " weight=" << weight.name()
+          << " nnz=" << nnz << "/" << num_rows * num_cols;
+
+  const string prefix = strings::StrCat(matmul.name(), "/sparse_weight");
+  const auto make_const = [&](const string& name, const Tensor& tensor) {
+    NodeDef node;
+    node.set_name(strings::StrCat(prefix, "/", name));
+    node.set_op("Const");
+    node.set_device(matmul.device());
+    SetAttrValue(tensor.dtype(), &(*node.mutable_attr())["dtype"]);
+    tensor.AsProtoTensorContent(
+        (*node.mutable_attr())["value"].mutable_tensor());
+    return node;
+  };
+  NodeDef indices_node = make_const("indices", indices);
+  NodeDef values_node = make_const("values", values);
+  NodeDef dense_shape_node = make_const("dense_shape", dense_shape);
+
+  NodeDef csr;
+  csr.set_name(prefix);
+  csr.set_op(kSparseTensorToCSRSparseMatrix);
+  csr.set_device(matmul.device());
+  csr.add_input(indices_node.name());
+  csr.add_input(values_node.name());
+  csr.add_input(dense_shape_node.name());
+  SetAttrValue(DT_FLOAT, &(*csr.mutable_attr())["T"]);
+
+  NodeDef sparse_matmul;
+  sparse_matmul.set_name(matmul.name());
+  sparse_matmul.set_op(kSparseMatrixMatMul);
+  sparse_matmul.set_device(matmul.device());
+  sparse_matmul.add_input(csr.name());      // 0: a
+  sparse_matmul.add_input(matmul.input(0));  // 1: b
+  auto* attr = sparse_matmul.mutable_attr();
+  SetAttrValue(DT_FLOAT, &(*attr)["T"]);
+  SetAttrValue(false, &(*attr)["transpose_a"]);
+  SetAttrValue(!transpose_a, &(*attr)["transpose_b"]);
+  SetAttrValue(false, &(*attr)["adjoint_a"]);
+  SetAttrValue(false, &(*attr)["adjoint_b"]);
+  SetAttrValue(true, &(*attr)["transpose_output"]);
+  SetAttrValue(false, &(*attr)["conjugate_output"]);
+
+  utils::Mutation* mutation = ctx->graph_view.GetMutationBuilder();
+  Status status;
+  mutation->AddNode(std::move(indices_node), &status);
+  TF_RETURN_IF_ERROR(status);
+  mutation->AddNode(std::move(values_node), &status);
+  TF_RETURN_IF_ERROR(status);
+  mutation->AddNode(std::move(dense_shape_node), &status);
+  TF_RETURN_IF_ERROR(status);
+  mutation->AddNode(std::move(csr), &status);
+  TF_RETURN_IF_ERROR(status);
+  mutation->AddNode(std::move(sparse_matmul), &status);
+  TF_RETURN_IF_ERROR(status);
+  TF_RETURN_IF_ERROR(mutation->Apply());
+
+  (*invalidated_nodes)[matched.matmul] = true;
+
+  return Status::OK();
+}
+
 Status AddFusedBatchNormExNode(RemapperContext* ctx,
                                const FusedBatchNormEx& matched,
                                std::vector<bool>* invalidated_nodes,
@@ -1600,6 +2144,7 @@ bool IsConv2DWithAdd(const RemapperContext& ctx, int node_index) {
 //   (2) Fusing side input and/or activation into FusedBatchNorm.
 //   (3) Fusing Conv2D biasadd and relu on GPU
 //   (4) INTEL_MKL specific: Conv2D -> Add or Conv2D -> BiasAdd -> Add.
+//   (5) Fusing attention, whose inputs must have the same batch dimensions.
 bool RequiresInferredShapes(const RemapperContext& ctx, int node_index) {
   // Candidate for a FusedBatchNorm splitting.
   const auto* node_view = ctx.graph_view.GetNode(node_index);
@@ -1670,12 +2215,19 @@ bool RequiresInferredShapes(const RemapperContext& ctx, int node_index) {
     return false;
   };
 
+  // Candidate for an attention fusion.
+  const auto is_attention_candidate = [&]() -> bool {
+    if (!IsAnyBatchMatMul(*node_def)) return false;
+    if (node_view->NumRegularFanins() < 1) return false;
+    return IsSoftmax(*node_view->GetRegularFanin(0).node_view()->node());
+  };
+
 #ifdef INTEL_MKL
   return is_batch_norm_candidate() || is_batch_norm_fusion_candidate() ||
-         IsConv2DWithAdd(ctx, node_index);
+         IsConv2DWithAdd(ctx, node_index) || is_attention_candidate();
 #else
   return is_relu_biasadd_conv2d_candidate() || is_batch_norm_candidate() ||
-         is_batch_norm_fusion_candidate();
+         is_batch_norm_fusion_candidate() || is_attention_candidate();
 #endif  // INTEL_MKL
 }
 
@@ -1778,6 +2330,21 @@ Status Remapper::Optimize(Cluster* cluster, const GrapplerItem& item,
       continue;
     }
 
+// MKL kernels for _Fused{Conv2D,MatMul} do not support element-wise op chains.
+#ifndef INTEL_MKL
+    // Remap {Conv2D,MatMul}+BiasAdd+<Op>+...+<Op> into the
+    // _Fused{Conv2D,MatMul}.
+    ContractionWithBiasAddAndElementwiseChain contract_with_elementwise_chain;
+    if (allow_non_differentiable_rewrites &&
+        FindContractionWithBiasAndElementwiseChain(
+            ctx, i, &contract_with_elementwise_chain)) {
+      TF_RETURN_IF_ERROR(
+          AddFusedContractionNode(&ctx, contract_with_elementwise_chain,
+                                  &invalidated_nodes, &nodes_to_delete));
+      continue;
+    }
+#endif  // !INTEL_MKL
+
 // NOTE: We can only fuse BatchNorm into Conv2D nodes. In theory we can do
 // it for MatMul as well, but in practice this pattern does not appear in
 // real Tensorflow graphs.
@@ -1818,6 +2385,24 @@ Status Remapper::Optimize(Cluster* cluster, const GrapplerItem& item,
     }
 #endif  // !INTEL_MKL
 
+    // Remap BatchMatMul+[Mul]+Softmax+BatchMatMul into the _FusedAttention.
+    Attention attention;
+    if (allow_non_differentiable_rewrites &&
+        FindAttention(ctx, i, &attention)) {
+      TF_RETURN_IF_ERROR(AddFusedAttentionNode(
+          &ctx, attention, &invalidated_nodes, &nodes_to_delete));
+      continue;
+    }
+
+    // Remap MatMul with a sparse constant weight into a SparseMatrixMatMul.
+    SparseWeightMatMul sparse_weight_matmul;
+    if (allow_non_differentiable_rewrites &&
+        FindSparseWeightMatMul(ctx, i, &sparse_weight_matmul)) {
+      TF_RETURN_IF_ERROR(AddSparseWeightMatMulNodes(&ctx, sparse_weight_matmul,
+                                                    &invalidated_nodes));
+      continue;
+    }
+
     // Remap FusedBatchNorm+<SideInput>+<Activation> into the _FusedBatchNormEx.
     FusedBatchNormEx fused_batch_norm_ex;
     if (allow_non_differentiable_rewrites &&
@@ -714,6 +714,149 @@ TEST_F(RemapperFuseMatMulWithBiasAndActivationTest, Bf16) {
 }
 
 #ifndef INTEL_MKL
+TEST_F(RemapperTest, FuseMatMulWithBiasAndElementwiseChain) {
+  using ::tensorflow::ops::Placeholder;
+
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+  auto lhs_shape = ops::Placeholder::Shape({8, 32});
+  auto rhs_shape = ops::Placeholder::Shape({32, 64});
+  auto bias_shape = ops::Placeholder::Shape({64});
+
+  auto lhs = Placeholder(s.WithOpName("lhs"), DT_FLOAT, lhs_shape);
+  auto rhs = Placeholder(s.WithOpName("rhs"), DT_FLOAT, rhs_shape);
+  auto bias = Placeholder(s.WithOpName("bias"), DT_FLOAT, bias_shape);
+
+  auto matmul = ops::MatMul(s.WithOpName("matmul"), lhs, rhs);
+  auto bias_add = ops::BiasAdd(s.WithOpName("bias_add"), matmul, bias);
+  auto tanh = ops::Tanh(s.WithOpName("tanh"), bias_add);
+  auto square = ops::Square(s.WithOpName("square"), tanh);
+  auto neg = ops::Neg(s.WithOpName("neg"), square);
+  auto fetch = ops::Identity(s.WithOpName("fetch"), neg);
+
+  auto lhs_t = GenerateRandomTensor<DT_FLOAT>({8, 32});
+  auto rhs_t = GenerateRandomTensor<DT_FLOAT>({32, 64});
+  auto bias_t = GenerateRandomTensor<DT_FLOAT>({64});
+
+  GrapplerItem item;
+  item.fetch = {"fetch"};
+  item.feed = {{"lhs", lhs_t}, {"rhs", rhs_t}, {"bias", bias_t}};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+  // Place all nodes on CPU.
+  for (int i = 0; i < item.graph.node_size(); ++i) {
+    item.graph.mutable_node(i)->set_device("/device:CPU:0");
+  }
+
+  Remapper optimizer(RewriterConfig::ON);
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  int found = 0;
+  for (const NodeDef& node : output.node()) {
+    EXPECT_NE(node.name(), "matmul");
+    EXPECT_NE(node.name(), "bias_add");
+    EXPECT_NE(node.name(), "tanh");
+    EXPECT_NE(node.name(), "square");
+    if (node.name() == "neg") {
+      EXPECT_EQ(node.op(), "_FusedMatMul");
+      ASSERT_GE(node.input_size(), 3);
+      EXPECT_EQ(node.input(0), "lhs");
+      EXPECT_EQ(node.input(1), "rhs");
+
+      EXPECT_EQ(node.attr().at("num_args").i(), 1);
+      EXPECT_EQ(node.input(2), "bias");
+
+      const auto fused_ops = node.attr().at("fused_ops").list().s();
+      ASSERT_EQ(fused_ops.size(), 4);
+      EXPECT_EQ(fused_ops[0], "BiasAdd");
+      EXPECT_EQ(fused_ops[1], "Tanh");
+      EXPECT_EQ(fused_ops[2], "Square");
+      EXPECT_EQ(fused_ops[3], "Neg");
+      found++;
+    }
+  }
+  EXPECT_EQ(found, 1);
+
+  auto tensors_expected = EvaluateNodes(item.graph, item.fetch, item.feed);
+  ASSERT_EQ(tensors_expected.size(), 1);
+  auto tensors = EvaluateNodes(output, item.fetch, item.feed);
+  ASSERT_EQ(tensors.size(), 1);
+  test::ExpectTensorNear<float>(tensors[0], tensors_expected[0], 1e-6);
+}
+
+TEST_F(RemapperTest, FuseConv2DWithBiasAndElementwiseChainStopsAtFanout) {
+  using ::tensorflow::ops::Placeholder;
+
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+  auto input_shape = Placeholder::Shape({8, 32, 32, 3});
+  auto filter_shape = Placeholder::Shape({1, 1, 3, 128});
+  auto bias_shape = Placeholder::Shape({128});
+
+  auto input = Placeholder(s.WithOpName("input"), DT_FLOAT, input_shape);
+  auto filter = Placeholder(s.WithOpName("filter"), DT_FLOAT, filter_shape);
+  auto bias = Placeholder(s.WithOpName("bias"), DT_FLOAT, bias_shape);
+
+  std::vector<int> strides = {1, 1, 1, 1};
+  auto conv = ops::Conv2D(s.WithOpName("conv"), input, filter, strides, "SAME");
+  auto bias_add = ops::BiasAdd(s.WithOpName("bias_add"), conv, bias);
+  auto sigmoid = ops::Sigmoid(s.WithOpName("sigmoid"), bias_add);
+  auto sqrt = ops::Sqrt(s.WithOpName("sqrt"), sigmoid);
+  // Output of `sqrt` has two consumers, so `exp` and `log` can't be fused.
+  auto exp = ops::Exp(s.WithOpName("exp"), sqrt);
+  auto log = ops::Log(s.WithOpName("log"), sqrt);
+  auto fetch0 = ops::Identity(s.WithOpName("fetch0"), exp);
+  auto fetch1 = ops::Identity(s.WithOpName("fetch1"), log);
+
+  auto input_t = GenerateRandomTensor<DT_FLOAT>({8, 32, 32, 3});
+  auto filter_t = GenerateRandomTensor<DT_FLOAT>({1, 1, 3, 128});
+  auto bias_t = GenerateRandomTensor<DT_FLOAT>({128});
+
+  GrapplerItem item;
+  item.fetch = {"fetch0", "fetch1"};
+  item.feed = {{"input", input_t}, {"filter", filter_t}, {"bias", bias_t}};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+  // Place all nodes on CPU.
+  for (int i = 0; i < item.graph.node_size(); ++i) {
+    item.graph.mutable_node(i)->set_device("/device:CPU:0");
+  }
+
+  Remapper optimizer(RewriterConfig::ON);
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  int found = 0;
+  for (const NodeDef& node : output.node()) {
+    if (node.name() == "exp" || node.name() == "log") {
+      EXPECT_EQ(node.input(0), "sqrt");
+    }
+    if (node.name() == "sqrt") {
+      EXPECT_EQ(node.op(), "_FusedConv2D");
+      ASSERT_GE(node.input_size(), 3);
+      EXPECT_EQ(node.input(0), "input");
+      EXPECT_EQ(node.input(1), "filter");
+      EXPECT_EQ(node.input(2), "bias");
+
+      const auto fused_ops = node.attr().at("fused_ops").list().s();
+      ASSERT_EQ(fused_ops.size(), 3);
+      EXPECT_EQ(fused_ops[0], "BiasAdd");
+      EXPECT_EQ(fused_ops[1], "Sigmoid");
+      EXPECT_EQ(fused_ops[2], "Sqrt");
+      found++;
+    }
+  }
+  EXPECT_EQ(found, 1);
+
+  auto tensors_expected = EvaluateNodes(item.graph, item.fetch, item.feed);
+  ASSERT_EQ(tensors_expected.size(), 2);
+  auto tensors = EvaluateNodes(output, item.fetch, item.feed);
+  ASSERT_EQ(tensors.size(), 2);
+  test::ExpectTensorNear<float>(tensors[0], tensors_expected[0], 1e-6);
+  test::ExpectTensorNear<float>(tensors[1], tensors_expected[1], 1e-6);
+}
+
 TEST_F(RemapperTest, FuseConv2DWithBatchNorm) {
   using ops::Placeholder;
 
@@ -959,5 +1102,211 @@ TEST_F(RemapperTest, FuseConv2DWithSqueezeAndBias) {
 }
 #endif
 
+TEST_F(RemapperTest, FuseAttention) {
+  using ::tensorflow::ops::Placeholder;
+
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+  auto query_shape = ops::Placeholder::Shape({2, 3, 8, 16});
+  auto key_shape = ops::Placeholder::Shape({2, 3, 12, 16});
+  auto value_shape = ops::Placeholder::Shape({2, 3, 12, 4});
+
+  auto query = Placeholder(s.WithOpName("query"), DT_FLOAT, query_shape);
+  auto key = Placeholder(s.WithOpName("key"), DT_FLOAT, key_shape);
+  auto value = Placeholder(s.WithOpName("value"), DT_FLOAT, value_shape);
+
+  auto scores = ops::BatchMatMulV2(s.WithOpName("scores"), query, key,
+                                   ops::BatchMatMulV2::AdjY(true));
+  auto scale = ops::Const(s.WithOpName("scale"), 0.25f, {});
+  auto scaled = ops::Mul(s.WithOpName("scaled"), scale, scores);
+  auto softmax = ops::Softmax(s.WithOpName("softmax"), scaled);
+  auto attention =
+      ops::BatchMatMulV2(s.WithOpName("attention"), softmax, value);
+  auto fetch = ops::Identity(s.WithOpName("fetch"), attention);
+
+  auto query_t = GenerateRandomTensor<DT_FLOAT>({2, 3, 8, 16});
+  auto key_t = GenerateRandomTensor<DT_FLOAT>({2, 3, 12, 16});
+  auto value_t = GenerateRandomTensor<DT_FLOAT>({2, 3, 12, 4});
+
+  GrapplerItem item;
+  item.fetch = {"fetch"};
+  item.feed = {{"query", query_t}, {"key", key_t}, {"value", value_t}};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+  // Place all nodes on CPU.
+  for (int i = 0; i < item.graph.node_size(); ++i) {
+    item.graph.mutable_node(i)->set_device("/device:CPU:0");
+  }
+
+  Remapper optimizer(RewriterConfig::ON);
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  int found = 0;
+  for (const NodeDef& node : output.node()) {
+    EXPECT_NE(node.name(), "scores");
+    EXPECT_NE(node.name(), "scaled");
+    EXPECT_NE(node.name(), "softmax");
+    if (node.name() == "attention") {
+      EXPECT_EQ(node.op(), "_FusedAttention");
+      ASSERT_EQ(node.input_size(), 3);
+      EXPECT_EQ(node.input(0), "query");
+      EXPECT_EQ(node.input(1), "key");
+      EXPECT_EQ(node.input(2), "value");
+      EXPECT_EQ(node.attr().at("scale").f(), 0.25f);
+      found++;
+    }
+  }
+  EXPECT_EQ(found, 1);
+
+  auto tensors_expected = EvaluateNodes(item.graph, item.fetch, item.feed);
+  ASSERT_EQ(tensors_expected.size(), 1);
+  auto tensors = EvaluateNodes(output, item.fetch, item.feed);
+  ASSERT_EQ(tensors.size(), 1);
+  test::ExpectTensorNear<float>(tensors[0], tensors_expected[0], 1e-5);
+}
+
+TEST_F(RemapperTest, DoNotFuseAttentionWithBroadcastBatch) {
+  using ::tensorflow::ops::Placeholder;
+
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+  // The key is shared by all batches, which BatchMatMulV2 broadcasts.
+  auto query = Placeholder(s.WithOpName("query"), DT_FLOAT,
+                           ops::Placeholder::Shape({4, 8, 16}));
+  auto key = Placeholder(s.WithOpName("key"), DT_FLOAT,
+                         ops::Placeholder::Shape({1, 12, 16}));
+  auto value = Placeholder(s.WithOpName("value"), DT_FLOAT,
+                           ops::Placeholder::Shape({4, 12, 4}));
+
+  auto scores = ops::BatchMatMulV2(s.WithOpName("scores"), query, key,
+                                   ops::BatchMatMulV2::AdjY(true));
+  auto softmax = ops::Softmax(s.WithOpName("softmax"), scores);
+  auto attention =
+      ops::BatchMatMulV2(s.WithOpName("attention"), softmax, value);
+  auto fetch = ops::Identity(s.WithOpName("fetch"), attention);
+
+  GrapplerItem item;
+  item.fetch = {"fetch"};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+  for (int i = 0; i < item.graph.node_size(); ++i) {
+    item.graph.mutable_node(i)->set_device("/device:CPU:0");
+  }
+
+  Remapper optimizer(RewriterConfig::ON);
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  for (const NodeDef& node : output.node()) {
+    EXPECT_NE(node.op(), "_FusedAttention");
+  }
+}
+
+class RemapperSparseWeightMatMulTest : public RemapperTest {
+ protected:
+  // Returns a [rows, cols] weight where all but every `stride`-th element is
+  // zero.
+  Tensor MakeWeight(int rows, int cols, int stride) {
+    Tensor weight = GenerateRandomTensor<DT_FLOAT>({rows, cols});
+    auto values = weight.flat<float>();
+    for (int i = 0; i < values.size(); ++i) {
+      if (i % stride != 0) values(i) = 0.0f;
+    }
+    return weight;
+  }
+
+  void RunTest(bool transpose_a, bool transpose_b) {
+    using ::tensorflow::ops::Placeholder;
+
+    tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+    const int m = 8, k = 64, n = 96;
+    auto x_shape = transpose_a ? TensorShape({k, m}) : TensorShape({m, k});
+    auto w_shape = transpose_b ? TensorShape({n, k}) : TensorShape({k, n});
+
+    auto x = Placeholder(s.WithOpName("x"), DT_FLOAT,
+                         ops::Placeholder::Shape(x_shape));
+    auto w = ops::Const(s.WithOpName("w"),
+                        Input::Initializer(MakeWeight(w_shape.dim_size(0),
+                                                      w_shape.dim_size(1),
+                                                      /*stride=*/10)));
+    auto matmul = ops::MatMul(s.WithOpName("matmul"), x, w,
+                              ops::MatMul::Attrs()
+                                  .TransposeA(transpose_a)
+                                  .TransposeB(transpose_b));
+    auto fetch = ops::Identity(s.WithOpName("fetch"), matmul);
+
+    auto x_t = GenerateRandomTensor<DT_FLOAT>(x_shape);
+
+    GrapplerItem item;
+    item.fetch = {"fetch"};
+    item.feed = {{"x", x_t}};
+    TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+    for (int i = 0; i < item.graph.node_size(); ++i) {
+      item.graph.mutable_node(i)->set_device("/device:CPU:0");
+    }
+
+    Remapper optimizer(RewriterConfig::ON);
+    GraphDef output;
+    TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+    int found = 0;
+    for (const NodeDef& node : output.node()) {
+      if (node.name() == "matmul") {
+        EXPECT_EQ(node.op(), "SparseMatrixMatMul");
+        ASSERT_EQ(node.input_size(), 2);
+        EXPECT_EQ(node.input(0), "matmul/sparse_weight");
+        EXPECT_EQ(node.input(1), "x");
+        EXPECT_EQ(node.attr().at("transpose_b").b(), !transpose_a);
+        EXPECT_TRUE(node.attr().at("transpose_output").b());
+        found++;
+      } else if (node.name() == "matmul/sparse_weight") {
+        EXPECT_EQ(node.op(), "SparseTensorToCSRSparseMatrix");
+        found++;
+      }
+    }
+    EXPECT_EQ(found, 2);
+
+    auto tensors_expected = EvaluateNodes(item.graph, item.fetch, item.feed);
+    ASSERT_EQ(tensors_expected.size(), 1);
+    auto tensors = EvaluateNodes(output, item.fetch, item.feed);
+    ASSERT_EQ(tensors.size(), 1);
+    test::ExpectTensorNear<float>(tensors[0], tensors_expected[0], 1e-5);
+  }
+};
+
+TEST_F(RemapperSparseWeightMatMulTest, NoTranspose) { RunTest(false, false); }
+TEST_F(RemapperSparseWeightMatMulTest, TransposeA) { RunTest(true, false); }
+TEST_F(RemapperSparseWeightMatMulTest, TransposeB) { RunTest(false, true); }
+
+TEST_F(RemapperSparseWeightMatMulTest, DoNotRewriteDenseWeight) {
+  using ::tensorflow::ops::Placeholder;
+
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+  // Half of the weight is zero, which is below the sparsity threshold.
+  auto x = Placeholder(s.WithOpName("x"), DT_FLOAT,
+                       ops::Placeholder::Shape({8, 64}));
+  auto w = ops::Const(s.WithOpName("w"),
+                      Input::Initializer(MakeWeight(64, 96, /*stride=*/2)));
+  auto matmul = ops::MatMul(s.WithOpName("matmul"), x, w);
+  auto fetch = ops::Identity(s.WithOpName("fetch"), matmul);
+
+  GrapplerItem item;
+  item.fetch = {"fetch"};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+  for (int i = 0; i < item.graph.node_size(); ++i) {
+    item.graph.mutable_node(i)->set_device("/device:CPU:0");
+  }
+
+  Remapper optimizer(RewriterConfig::ON);
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  for (const NodeDef& node : output.node()) {
+    EXPECT_NE(node.op(), "SparseMatrixMatMul");
+  }
+}
+
 }  // namespace grappler
 }  // namespace tensorflow
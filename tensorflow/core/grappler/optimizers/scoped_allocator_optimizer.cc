@@ -14,8 +14,11 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/grappler/optimizers/scoped_allocator_optimizer.h"
 
+#include "absl/strings/match.h"
+#include "absl/strings/str_join.h"
 #include "tensorflow/core/common_runtime/scoped_allocator.h"
 #include "tensorflow/core/common_runtime/scoped_allocator_mgr.h"
+#include "tensorflow/core/framework/attr_value_util.h"
 #include "tensorflow/core/framework/graph.pb.h"
 #include "tensorflow/core/framework/node_def_builder.h"
 #include "tensorflow/core/framework/node_def_util.h"
@@ -43,6 +46,9 @@ namespace {
 
 const char kScopedAllocatorAttrName[] = "_scoped_allocator";
 
+// Bound on the inputs of merged collectives when none is configured.
+constexpr int64 kDefaultCollectiveBucketBytes = 32 << 20;
+
 // Node names often have some kind of name_scope prefix, with slashes,
 // and a _nn numeric suffix.  Returns true if the main part of the node_name
 // matches op_name, i.e. it looks from the name like this node is
@@ -890,6 +896,13 @@ ScopedAllocatorOptimizer::ScopedAllocatorOptimizer(
     RewriterConfig::Toggle opt_level, const ScopedAllocatorOptions& opts)
     : opt_level_(opt_level) {
   VLOG(1) << "ScopedAllocatorOptimizer::ScopedAllocatorOptimizer";
+  if (opts.collective_bucket_bytes() > 0) {
+    collective_bucket_bytes_ = opts.collective_bucket_bytes();
+  } else if (opts.collective_bucket_bytes() == 0) {
+    collective_bucket_bytes_ = kDefaultCollectiveBucketBytes;
+  } else {
+    collective_bucket_bytes_ = kint64max;
+  }
   Rewriter* r = new UnaryElementwiseRewriter();
   to_delete_.push_back(r);
   if (opts.enable_op_size() == 0) {
@@ -1073,6 +1086,166 @@ void IdentifyRepeatedInputs(const std::vector<NodeDef*>& nodes,
   }
 }
 
+struct InstanceKeyLess {
+  bool operator()(const NodeDef* a, const NodeDef* b) const {
+    AttrSlice a_attrs = AttrSlice(*a);
+    AttrSlice b_attrs = AttrSlice(*b);
+    int32 a_key = -1;
+    int32 b_key = -1;
+    Status s = GetNodeAttr(a_attrs, "instance_key", &a_key);
+    CHECK(s.ok());
+    s = GetNodeAttr(b_attrs, "instance_key", &b_key);
+    CHECK(s.ok());
+    return a_key < b_key;
+  }
+};
+
+struct NameLess {
+  bool operator()(const NodeDef* a, const NodeDef* b) const {
+    return a->name() < b->name();
+  }
+};
+
+bool IsCollectiveNode(const NodeDef& n) {
+  AttrSlice attrs = AttrSlice(n);
+  int key = -1;
+  if (!IsCollective(n)) return false;
+  Status s = GetNodeAttr(attrs, "instance_key", &key);
+  if (s.ok() && key >= 0) {
+    return true;
+  }
+  return false;
+}
+
+// Returns the attrs on which collectives must agree to be merged into one
+// instance, i.e. all but instance_key and the internal ones, as a string.
+string CollectiveAttrSignature(const NodeDef& n) {
+  std::vector<string> attrs;
+  for (const auto& it : n.attr()) {
+    if (it.first == "instance_key" || absl::StartsWith(it.first, "_")) {
+      continue;
+    }
+    attrs.push_back(
+        strings::StrCat(it.first, "=", SummarizeAttrValue(it.second)));
+  }
+  std::sort(attrs.begin(), attrs.end());
+  return absl::StrJoin(attrs, ",");
+}
+
+// Returns the bytes that the output of `n` takes in a ScopedAllocator
+// backing buffer, or -1 if its shape is not fully known.
+int64 AlignedOutputBytes(const GraphProperties& graph_properties,
+                         const NodeDef& n) {
+  if (!graph_properties.HasOutputProperties(n.name())) return -1;
+  const std::vector<OpInfo::TensorProperties>& props =
+      graph_properties.GetOutputProperties(n.name());
+  if (props.size() != 1) return -1;
+  const PartialTensorShape shape(props[0].shape());
+  if (!shape.IsFullyDefined()) return -1;
+  const int64 num_bytes =
+      shape.num_elements() * DataTypeSize(props[0].dtype());
+  return (num_bytes + Allocator::kAllocatorAlignment - 1) /
+         Allocator::kAllocatorAlignment * Allocator::kAllocatorAlignment;
+}
+
+// Returns the members of `nodes` that are transitively reachable from
+// another member.  Back edges out of NextIteration are not followed.
+absl::flat_hash_set<const NodeDef*> FindDependentNodes(
+    NodeMap* node_map, const std::vector<NodeDef*>& nodes) {
+  const absl::flat_hash_set<const NodeDef*> members(nodes.begin(),
+                                                    nodes.end());
+  std::deque<const NodeDef*> queue;
+  for (const NodeDef* n : nodes) {
+    for (const NodeDef* output : node_map->GetOutputs(n->name())) {
+      queue.push_back(output);
+    }
+  }
+  absl::flat_hash_set<const NodeDef*> visited;
+  absl::flat_hash_set<const NodeDef*> dependent;
+  while (!queue.empty()) {
+    const NodeDef* node = queue.front();
+    queue.pop_front();
+    if (!visited.insert(node).second) {
+      continue;
+    }
+    if (members.contains(node)) {
+      dependent.insert(node);
+    }
+    if (IsNextIteration(*node)) {
+      continue;
+    }
+    for (const NodeDef* output : node_map->GetOutputs(node->name())) {
+      queue.push_back(output);
+    }
+  }
+  return dependent;
+}
+
+// Groups collectives regardless of their name scopes, so that e.g. the
+// gradient all-reduces of all layers share backing buffers.  Collectives
+// that do not depend on one another, have fully known output shapes, and
+// agree on loop nesting and attrs are ordered by instance_key and cut into
+// buckets of at most `max_bytes` of input.  Buckets of more than one node
+// are moved from `nodes` to `buckets`; the rest are left in `nodes`.
+//
+// Since no member of a bucket is reachable from any node in `nodes`, merging
+// a bucket cannot create a cycle with any other rewritten group.  Every
+// worker sees the same instance_keys and shapes, so all workers agree on
+// the buckets and hence on the instance_key of each merged collective.
+void BucketCollectives(const FrameView& frame_view,
+                       const GraphProperties& graph_properties,
+                       NodeMap* node_map, int64 max_bytes,
+                       std::vector<NodeDef*>* nodes,
+                       std::vector<std::vector<NodeDef*>>* buckets) {
+  const absl::flat_hash_set<const NodeDef*> dependent =
+      FindDependentNodes(node_map, *nodes);
+  absl::flat_hash_map<const NodeDef*, int64> node_bytes;
+  std::vector<NodeDef*> candidates;
+  std::vector<NodeDef*> rest;
+  for (NodeDef* n : *nodes) {
+    const int64 num_bytes = AlignedOutputBytes(graph_properties, *n);
+    if (IsCollectiveNode(*n) && num_bytes >= 0 && !dependent.contains(n)) {
+      node_bytes[n] = num_bytes;
+      candidates.push_back(n);
+    } else {
+      rest.push_back(n);
+    }
+  }
+  std::vector<std::vector<NodeDef*>> loop_groups;
+  PartitionByLoopStructure(frame_view, candidates, &loop_groups);
+  for (const auto& lg : loop_groups) {
+    std::map<string, std::vector<NodeDef*>> attr_groups;
+    for (NodeDef* n : lg) {
+      attr_groups[CollectiveAttrSignature(*n)].push_back(n);
+    }
+    for (auto& ag : attr_groups) {
+      std::vector<NodeDef*>& group = ag.second;
+      std::sort(group.begin(), group.end(), InstanceKeyLess());
+      std::vector<std::vector<NodeDef*>> group_buckets(1);
+      int64 bucket_bytes = 0;
+      for (NodeDef* n : group) {
+        const int64 num_bytes = node_bytes[n];
+        if (!group_buckets.back().empty() &&
+            bucket_bytes > max_bytes - num_bytes) {
+          group_buckets.emplace_back();
+          bucket_bytes = 0;
+        }
+        group_buckets.back().push_back(n);
+        bucket_bytes += num_bytes;
+      }
+      for (auto& bucket : group_buckets) {
+        VLOG(1) << "Bucket of " << bucket.size() << " collectives";
+        if (bucket.size() > 1) {
+          buckets->push_back(std::move(bucket));
+        } else {
+          rest.insert(rest.end(), bucket.begin(), bucket.end());
+        }
+      }
+    }
+  }
+  nodes->swap(rest);
+}
+
 }  // namespace
 
 Status ScopedAllocatorOptimizer::ProcessGraphDef(
@@ -1107,9 +1280,20 @@ Status ScopedAllocatorOptimizer::ProcessGraphDef(
           continue;
         }
         rewriter->SetGraphProperties(graph_properties);
-        std::unique_ptr<Tree> root(ComputeScopeTree(it.first, it.second));
-        // Record outputs that are inputs to multiple Tree nodes.
+        // Collectives that can be merged across name scopes are bucketed
+        // first; the remaining nodes are grouped by name scope.
+        std::vector<NodeDef*> nodes = it.second;
+        std::vector<std::vector<NodeDef*>> buckets;
+        if (IsCollectiveNode(*nodes[0])) {
+          BucketCollectives(frame_view, graph_properties, node_map_.get(),
+                            collective_bucket_bytes_, &nodes, &buckets);
+        }
+        std::unique_ptr<Tree> root(ComputeScopeTree(it.first, nodes));
+        // Record outputs that are inputs to multiple buckets or Tree nodes.
         absl::flat_hash_set<string> seen_outputs;
+        for (const auto& bucket : buckets) {
+          IdentifyRepeatedInputs(bucket, &seen_outputs, &repeated_outputs_);
+        }
         status = ApplyToAll(root.get(), [this, &seen_outputs](Tree* t) {
           IdentifyRepeatedInputs(t->nodes_, &seen_outputs, &repeated_outputs_);
           return Status::OK();
@@ -1117,6 +1301,19 @@ Status ScopedAllocatorOptimizer::ProcessGraphDef(
         if (!status.ok()) {
           break;
         }
+        for (const auto& bucket : buckets) {
+          bool applied = false;
+          VLOG(1) << "Applying Rewriter for " << op_name << " to a bucket of "
+                  << bucket.size();
+          status = rewriter->Rewrite(this, invocation_count, graph, op_name,
+                                     bucket, &applied);
+          if (!status.ok()) {
+            break;
+          }
+        }
+        if (!status.ok()) {
+          break;
+        }
         // Nodes with a common depth and root path are now grouped
         // in the same Tree struct.  Split those groups into subgroups that
         // share identical loop nesting.
@@ -1157,39 +1354,6 @@ Status ScopedAllocatorOptimizer::ProcessGraphDef(
   return status;
 }
 
-namespace {
-struct InstanceKeyLess {
-  bool operator()(const NodeDef* a, const NodeDef* b) const {
-    AttrSlice a_attrs = AttrSlice(*a);
-    AttrSlice b_attrs = AttrSlice(*b);
-    int32 a_key = -1;
-    int32 b_key = -1;
-    Status s = GetNodeAttr(a_attrs, "instance_key", &a_key);
-    CHECK(s.ok());
-    s = GetNodeAttr(b_attrs, "instance_key", &b_key);
-    CHECK(s.ok());
-    return a_key < b_key;
-  }
-};
-
-struct NameLess {
-  bool operator()(const NodeDef* a, const NodeDef* b) const {
-    return a->name() < b->name();
-  }
-};
-
-bool IsCollectiveNode(const NodeDef& n) {
-  AttrSlice attrs = AttrSlice(n);
-  int key = -1;
-  if (!IsCollective(n)) return false;
-  Status s = GetNodeAttr(attrs, "instance_key", &key);
-  if (s.ok() && key >= 0) {
-    return true;
-  }
-  return false;
-}
-}  // namespace
-
 Status ScopedAllocatorOptimizer::OrderNodeSet(
     std::vector<NodeDef*>* nodes) const {
   // Nodes should be identical type.  Default order is by name but for
@@ -111,6 +111,9 @@ class ScopedAllocatorOptimizer : public GraphOptimizer {
   Status OrderNodeSet(std::vector<NodeDef*>* nodes) const;
 
   RewriterConfig::Toggle opt_level_;
+  // Upper bound on the bytes that one ScopedAllocator holds for the inputs
+  // of merged collectives, or kint64max if unbounded.
+  int64 collective_bucket_bytes_;
   std::unordered_set<string> nodes_to_preserve_;
   OpNameSet op_name_set_;
   absl::flat_hash_map<string, Rewriter*> rewriters_;
@@ -14,11 +14,13 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/grappler/optimizers/scoped_allocator_optimizer.h"
 
+#include <set>
 #include <unordered_set>
 
 #include "tensorflow/cc/ops/array_ops.h"
 #include "tensorflow/cc/ops/standard_ops.h"
 #include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/node_def_builder.h"
 #include "tensorflow/core/framework/tensor.pb.h"  // NOLINT
 #include "tensorflow/core/framework/tensor_shape.pb.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
@@ -267,6 +269,56 @@ class ScopedAllocatorOptimizerTest : public ::testing::Test {
     TF_CHECK_OK(s.ToGraphDef(graph_def));
   }
 
+  // Constructs a graph with an all-reduce in each of `scopes`, like the
+  // gradient all-reduces of the layers of a model.  In scope i, Const ci of
+  // sizes[i] floats feeds Abs <scope>/abs, which feeds CollectiveReduce
+  // <scope>/all_reduce with instance_key i + 1.  If `chain` is true, each
+  // Abs but the first reads the previous all-reduce instead of its Const.
+  void BuildCollectiveGraph(GraphDef* graph_def,
+                            const std::vector<string>& scopes,
+                            const std::vector<int>& sizes, bool chain) {
+    const string device = "/job:localhost/replica:0/task:0/device:CPU:0";
+    Scope s = Scope::NewRootScope().WithDevice(device);
+    for (int i = 0; i < scopes.size(); ++i) {
+      Tensor t(DT_FLOAT, TensorShape({sizes[i]}));
+      t.flat<float>().setConstant(1.0);
+      ops::Const(s.WithOpName(strings::StrCat("c", i)), t);
+    }
+    TF_CHECK_OK(s.ToGraphDef(graph_def));
+    for (int i = 0; i < scopes.size(); ++i) {
+      const string input = chain && i > 0
+                               ? strings::StrCat(scopes[i - 1], "/all_reduce")
+                               : strings::StrCat("c", i);
+      TF_CHECK_OK(NodeDefBuilder(strings::StrCat(scopes[i], "/abs"), "Abs")
+                      .Device(device)
+                      .Input(input, 0, DT_FLOAT)
+                      .Finalize(graph_def->add_node()));
+      TF_CHECK_OK(NodeDefBuilder(strings::StrCat(scopes[i], "/all_reduce"),
+                                 "CollectiveReduce")
+                      .Device(device)
+                      .Input(strings::StrCat(scopes[i], "/abs"), 0, DT_FLOAT)
+                      .Attr("group_size", 2)
+                      .Attr("group_key", 1)
+                      .Attr("instance_key", i + 1)
+                      .Attr("merge_op", "Add")
+                      .Attr("final_op", "Id")
+                      .Attr("subdiv_offsets", std::vector<int>({0}))
+                      .Finalize(graph_def->add_node()));
+    }
+  }
+
+  // Returns the nodes of `graph` with op `op`.
+  std::vector<const NodeDef*> NodesWithOp(const GraphDef& graph,
+                                          const string& op) {
+    std::vector<const NodeDef*> nodes;
+    for (const NodeDef& node : graph.node()) {
+      if (node.op() == op) {
+        nodes.push_back(&node);
+      }
+    }
+    return nodes;
+  }
+
   void SetShapes(GraphDef* graph_def) {
     TensorShapeProto shape_proto;
     shape_proto.add_dim()->set_size(2);
@@ -597,6 +649,72 @@ TEST_F(ScopedAllocatorOptimizerTest, ConstInput) {
   EXPECT_EQ(num_identity_ops, 2);
 }
 
+// Tests that all-reduces in different name scopes share one backing buffer
+// and become a single all-reduce with the smallest instance_key.
+TEST_F(ScopedAllocatorOptimizerTest, CollectivesMergedAcrossScopes) {
+  GrapplerItem item;
+  BuildCollectiveGraph(&item.graph, {"layer1", "layer2", "layer3/dense"},
+                       {4, 8, 16}, /*chain=*/false);
+
+  ScopedAllocatorOptimizer sao(RewriterConfig::ON, ScopedAllocatorOptions());
+  GraphDef optimized_graph;
+  TF_ASSERT_OK(sao.Optimize(nullptr /*cluster*/, item, &optimized_graph));
+
+  std::vector<const NodeDef*> sa_nodes =
+      NodesWithOp(optimized_graph, "_ScopedAllocator");
+  ASSERT_EQ(1, sa_nodes.size());
+  int64 expected_call_count = 0;
+  TF_ASSERT_OK(GetNodeAttr(*sa_nodes[0], "expected_call_count",
+                           &expected_call_count));
+  EXPECT_EQ(3, expected_call_count);
+  std::vector<const NodeDef*> reduce_nodes =
+      NodesWithOp(optimized_graph, "CollectiveReduce");
+  ASSERT_EQ(1, reduce_nodes.size());
+  int instance_key = -1;
+  TF_ASSERT_OK(GetNodeAttr(*reduce_nodes[0], "instance_key", &instance_key));
+  EXPECT_EQ(1, instance_key);
+}
+
+// Tests that merged all-reduces are cut into buckets of at most
+// collective_bucket_bytes, in order of instance_key.
+TEST_F(ScopedAllocatorOptimizerTest, CollectiveBuckets) {
+  GrapplerItem item;
+  BuildCollectiveGraph(&item.graph, {"layer1", "layer2", "layer3", "layer4"},
+                       {4, 4, 4, 4}, /*chain=*/false);
+
+  // Each input takes kAllocatorAlignment bytes, so two fit in a bucket.
+  ScopedAllocatorOptions opts;
+  opts.set_collective_bucket_bytes(2 * Allocator::kAllocatorAlignment);
+  ScopedAllocatorOptimizer sao(RewriterConfig::ON, opts);
+  GraphDef optimized_graph;
+  TF_ASSERT_OK(sao.Optimize(nullptr /*cluster*/, item, &optimized_graph));
+
+  EXPECT_EQ(2, NodesWithOp(optimized_graph, "_ScopedAllocator").size());
+  std::set<int> instance_keys;
+  for (const NodeDef* node :
+       NodesWithOp(optimized_graph, "CollectiveReduce")) {
+    int instance_key = -1;
+    TF_ASSERT_OK(GetNodeAttr(*node, "instance_key", &instance_key));
+    instance_keys.insert(instance_key);
+  }
+  EXPECT_EQ(std::set<int>({1, 3}), instance_keys);
+}
+
+// Tests that an all-reduce that depends on another one is not merged with
+// it, since the merged all-reduce would depend on itself.
+TEST_F(ScopedAllocatorOptimizerTest, DependentCollectivesNotMerged) {
+  GrapplerItem item;
+  BuildCollectiveGraph(&item.graph, {"layer1", "layer2"}, {4, 4},
+                       /*chain=*/true);
+
+  ScopedAllocatorOptimizer sao(RewriterConfig::ON, ScopedAllocatorOptions());
+  GraphDef optimized_graph;
+  TF_ASSERT_OK(sao.Optimize(nullptr /*cluster*/, item, &optimized_graph));
+
+  EXPECT_TRUE(NodesWithOp(optimized_graph, "_ScopedAllocator").empty());
+  EXPECT_EQ(2, NodesWithOp(optimized_graph, "CollectiveReduce").size());
+}
+
 }  // namespace
 }  // namespace grappler
 }  // namespace tensorflow
@@ -0,0 +1,115 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <vector>
+
+#include "tensorflow/core/common_runtime/process_function_library_runtime.h"
+#include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/function.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/node_properties.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/public/version.h"
+
+namespace tensorflow {
+namespace {
+
+class BatchFunctionKernelTest : public OpsTestBase {
+ protected:
+  // Builds a BatchFunction node that runs an identity function over a single
+  // input of `dtype`.
+  Status Init(DataType dtype, int max_batch_size,
+              const std::vector<int>& allowed_batch_sizes) {
+    TF_RETURN_IF_ERROR(flib_def_->AddFunctionDef(FunctionDefHelper::Define(
+        "IdentityFn", {"x: T"}, {"y: T"}, {"T: type"},
+        {{{"y"}, "Identity", {"x"}, {{"T", "$T"}}}})));
+
+    AttrValue f;
+    f.mutable_func()->set_name("IdentityFn");
+    (*f.mutable_func()->mutable_attr())["T"].set_type(dtype);
+    TF_RETURN_IF_ERROR(
+        NodeDefBuilder("batch", "BatchFunction")
+            .Input(FakeInput({dtype}))
+            .Input(FakeInput(DataTypeVector{}))
+            .Attr("f", f)
+            .Attr("num_batch_threads", 1)
+            .Attr("max_batch_size", max_batch_size)
+            .Attr("batch_timeout_micros", 1000)
+            .Attr("allowed_batch_sizes", allowed_batch_sizes)
+            .Attr("Tout", DataTypeVector{dtype})
+            .Finalize(node_def()));
+
+    // InitOp() creates kernels without a function library, which
+    // BatchFunction needs at construction time.
+    std::shared_ptr<const NodeProperties> props;
+    TF_RETURN_IF_ERROR(NodeProperties::CreateFromNodeDef(
+        *node_def(), OpRegistry::Global(), &props));
+    OpKernel* kernel;
+    TF_RETURN_IF_ERROR(CreateOpKernel(
+        device_type_, device_, allocator(), pflr_->GetFLR(device_->name()),
+        device_->resource_manager(), props, TF_GRAPH_DEF_VERSION, &kernel));
+    kernel_.reset(kernel);
+    input_types_ = kernel_->input_types();
+    return Status::OK();
+  }
+};
+
+// A batch padded to an allowed size is split back into its task's slice.
+TEST_F(BatchFunctionKernelTest, PaddedBatchIsSliced) {
+  TF_ASSERT_OK(Init(DT_FLOAT, /*max_batch_size=*/4,
+                    /*allowed_batch_sizes=*/{4}));
+  std::vector<float> values(3 * 16);
+  for (int i = 0; i < 3 * 16; ++i) values[i] = i;
+  AddInputFromArray<float>(TensorShape({3, 16}), values);
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected(allocator(), DT_FLOAT, TensorShape({3, 16}));
+  test::FillValues<float>(&expected, values);
+  test::ExpectTensorEqual<float>(expected, *GetOutput(0));
+}
+
+// A single unpadded task gets the function's output back unchanged.
+TEST_F(BatchFunctionKernelTest, SingleTaskPassesThrough) {
+  TF_ASSERT_OK(Init(DT_FLOAT, /*max_batch_size=*/4,
+                    /*allowed_batch_sizes=*/{}));
+  AddInputFromArray<float>(TensorShape({2, 2}), {1, 2, 3, 4});
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected(allocator(), DT_FLOAT, TensorShape({2, 2}));
+  test::FillValues<float>(&expected, {1, 2, 3, 4});
+  test::ExpectTensorEqual<float>(expected, *GetOutput(0));
+}
+
+// Outputs of types outside the concat_split_util fast path are split with
+// tensor::Split.
+TEST_F(BatchFunctionKernelTest, QuantizedOutputIsSplit) {
+  TF_ASSERT_OK(Init(DT_QUINT8, /*max_batch_size=*/4,
+                    /*allowed_batch_sizes=*/{}));
+  AddInputFromArray<quint8>(TensorShape({3, 2}), {1, 2, 3, 4, 5, 6});
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected(allocator(), DT_QUINT8, TensorShape({3, 2}));
+  test::FillValues<quint8>(&expected, {1, 2, 3, 4, 5, 6});
+  test::ExpectTensorEqual<quint8>(expected, *GetOutput(0));
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -20,6 +20,9 @@ limitations under the License.
 
 #define EIGEN_USE_THREADS
 
+#include <array>
+#include <limits>
+#include <map>
 #include <vector>
 
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
@@ -33,8 +36,12 @@ limitations under the License.
 #include "tensorflow/core/kernels/fill_functor.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/threadpool.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/matmul_autotune.h"
 #include "tensorflow/core/util/matmul_bcast.h"
 #include "tensorflow/core/util/work_sharder.h"
 
@@ -112,6 +119,28 @@ struct ParallelMatMulKernel {
       }
     }
   }
+
+  // Multiplies all matrices of `in_x` with the only matrix of `in_y` as one
+  // contraction, by folding the batch dimension into the rows of x.
+  // REQUIRES: !adj_x && !trans_x and in_y has a batch size of one.
+  static void RunFoldedBatch(const OpKernelContext* context,
+                             const Tensor& in_x, const Tensor& in_y,
+                             bool adj_y, bool trans_y, Tensor* out) {
+    static_assert(IsComplex, "Complex type expected.");
+    auto x = in_x.shaped<Scalar, 2>(
+        {in_x.dim_size(0) * in_x.dim_size(1), in_x.dim_size(2)});
+    auto y = in_y.shaped<Scalar, 2>({in_y.dim_size(1), in_y.dim_size(2)});
+    auto z = out->shaped<Scalar, 2>(
+        {out->dim_size(0) * out->dim_size(1), out->dim_size(2)});
+    Eigen::array<Eigen::IndexPair<Eigen::DenseIndex>, 1> contract_pairs;
+    contract_pairs[0] = ContractionDims(false, adj_y || trans_y);
+    const Eigen::ThreadPoolDevice d = context->eigen_cpu_device();
+    if (adj_y) {
+      z.device(d) = x.contract(y.conjugate(), contract_pairs);
+    } else {
+      z.device(d) = x.contract(y, contract_pairs);
+    }
+  }
 };
 
 // The Eigen contraction kernel used here is very large and slow to compile,
@@ -145,6 +174,20 @@ struct ParallelMatMulKernel<Scalar, false> {
       z.device(d) = x.contract(y, contract_pairs);
     }
   }
+
+  static void RunFoldedBatch(const OpKernelContext* context,
+                             const Tensor& in_x, const Tensor& in_y,
+                             bool adj_y, bool trans_y, Tensor* out) {
+    auto x = in_x.shaped<Scalar, 2>(
+        {in_x.dim_size(0) * in_x.dim_size(1), in_x.dim_size(2)});
+    auto y = in_y.shaped<Scalar, 2>({in_y.dim_size(1), in_y.dim_size(2)});
+    auto z = out->shaped<Scalar, 2>(
+        {out->dim_size(0) * out->dim_size(1), out->dim_size(2)});
+    Eigen::array<Eigen::IndexPair<Eigen::DenseIndex>, 1> contract_pairs;
+    contract_pairs[0] = ContractionDims(false, adj_y || trans_y);
+    const Eigen::ThreadPoolDevice d = context->eigen_cpu_device();
+    z.device(d) = x.contract(y, contract_pairs);
+  }
 };
 
 // Sequential batch matmul kernel that calls the regular Eigen matmul.
@@ -213,6 +256,75 @@ struct SequentialMatMulKernel {
   }
 };
 
+// The ways LaunchBatchMatMul<CPUDevice> can spread the matrix multiplies of a
+// batch over the intra-op threads.
+enum class CpuBatchMatMulStrategy {
+  // A single contraction with the batch folded into the rows of x. Only
+  // possible when every matrix of x is multiplied with the same matrix of y.
+  kFoldBatch,
+  // One multi-threaded contraction per matrix.
+  kParallelInner,
+  // Single-threaded matmuls, sharded over the batch by their cost.
+  kShardOuter,
+  // Single-threaded matmuls, one contiguous block of the batch per thread.
+  kBlockOuter,
+};
+
+// Remembers, per matmul shape, the strategy that ran fastest when
+// TF_MATMUL_AUTOTUNE_ENABLE is set. Each candidate strategy is timed on the
+// first few launches of a shape; as every strategy computes the same result,
+// those launches produce correct outputs too.
+template <typename Scalar>
+class CpuBatchMatMulAutotuner {
+ public:
+  // Batch size, the three matrix dimensions and the adjoint and transpose
+  // flags of the matmul.
+  typedef std::array<int64, 5> Key;
+
+  static CpuBatchMatMulAutotuner* Get() {
+    static CpuBatchMatMulAutotuner* autotuner = new CpuBatchMatMulAutotuner;
+    return autotuner;
+  }
+
+  // Returns the strategy to run for `key`, among `candidates`, and whether
+  // the launch should be timed and reported to Record().
+  CpuBatchMatMulStrategy Lookup(
+      const Key& key, const std::vector<CpuBatchMatMulStrategy>& candidates,
+      bool* measure) {
+    mutex_lock l(mu_);
+    Entry& entry = entries_[key];
+    const int num_trials = kTrialsPerCandidate * candidates.size();
+    *measure = entry.trials < num_trials;
+    if (*measure) {
+      return candidates[entry.trials++ % candidates.size()];
+    }
+    return entry.best;
+  }
+
+  void Record(const Key& key, CpuBatchMatMulStrategy strategy, int64 micros) {
+    mutex_lock l(mu_);
+    Entry& entry = entries_[key];
+    if (micros < entry.best_micros) {
+      entry.best = strategy;
+      entry.best_micros = micros;
+    }
+  }
+
+ private:
+  // The first launch of a shape runs with cold caches, so every candidate is
+  // tried more than once and judged by its fastest launch.
+  static constexpr int kTrialsPerCandidate = 2;
+
+  struct Entry {
+    int trials = 0;
+    CpuBatchMatMulStrategy best = CpuBatchMatMulStrategy::kParallelInner;
+    int64 best_micros = std::numeric_limits<int64>::max();
+  };
+
+  mutex mu_;
+  std::map<Key, Entry> entries_ TF_GUARDED_BY(mu_);
+};
+
 }  // namespace
 
 template <typename Device, typename Scalar>
@@ -223,39 +335,116 @@ struct LaunchBatchMatMul<CPUDevice, Scalar> {
   static void Launch(OpKernelContext* context, const Tensor& in_x,
                      const Tensor& in_y, bool adj_x, bool adj_y, bool trans_x,
                      bool trans_y, const MatMulBCast& bcast, Tensor* out) {
-    typedef ParallelMatMulKernel<Scalar, Eigen::NumTraits<Scalar>::IsComplex>
-        ParallelMatMulKernel;
-    bool conjugate_result = false;
-
     // Number of matrix multiplies i.e. size of the batch.
     const int64 batch_size = bcast.output_batch_size();
     const int64 cost_per_unit =
         in_x.dim_size(1) * in_x.dim_size(2) * out->dim_size(2);
     const int64 small_dim = std::min(
         std::min(in_x.dim_size(1), in_x.dim_size(2)), out->dim_size(2));
+    // With a single matrix of y and no transposition of x, the matrices of x
+    // are contiguous rows of one large matrix.
+    const bool can_fold_batch = batch_size > 1 && !adj_x && !trans_x &&
+                                in_y.dim_size(0) == 1 &&
+                                in_x.dim_size(0) == batch_size;
+
+    CpuBatchMatMulStrategy strategy;
     // NOTE(nikhilsarda): This heuristic is optimal in benchmarks as of
     // Jan 21, 2020.
     const int64 kMaxCostOuterParallelism = 128 * 128;  // heuristic.
-    auto worker_threads = *(context->device()->tensorflow_cpu_worker_threads());
-    if (small_dim > 1 &&
-        (batch_size == 1 || cost_per_unit > kMaxCostOuterParallelism)) {
+    if (can_fold_batch) {
+      strategy = CpuBatchMatMulStrategy::kFoldBatch;
+    } else if (small_dim > 1 &&
+               (batch_size == 1 || cost_per_unit > kMaxCostOuterParallelism)) {
       // Parallelize over inner dims.
       // For large matrix products it is counter-productive to parallelize
       // over the batch dimension.
-      ParallelMatMulKernel::Run(context, in_x, in_y, adj_x, adj_y, trans_x,
-                                trans_y, bcast, out, 0, batch_size);
-      conjugate_result = adj_x;
+      strategy = CpuBatchMatMulStrategy::kParallelInner;
     } else {
       // Parallelize over outer dims. For small matrices and large batches, it
       // is counter-productive to parallelize the inner matrix multiplies.
-      Shard(worker_threads.num_threads, worker_threads.workers, batch_size,
-            cost_per_unit,
-            [&in_x, &in_y, adj_x, adj_y, trans_x, trans_y, &bcast, out](
-                int start, int limit) {
-              SequentialMatMulKernel<Scalar>::Run(in_x, in_y, adj_x, adj_y,
-                                                  trans_x, trans_y, bcast, out,
-                                                  start, limit);
-            });
+      strategy = CpuBatchMatMulStrategy::kShardOuter;
+    }
+
+    static const bool autotune = MatmulAutotuneEnable();
+    if (!autotune || batch_size == 1) {
+      RunStrategy(context, strategy, in_x, in_y, adj_x, adj_y, trans_x,
+                  trans_y, bcast, out);
+      return;
+    }
+
+    std::vector<CpuBatchMatMulStrategy> candidates;
+    if (can_fold_batch) {
+      candidates.push_back(CpuBatchMatMulStrategy::kFoldBatch);
+    }
+    candidates.push_back(CpuBatchMatMulStrategy::kParallelInner);
+    candidates.push_back(CpuBatchMatMulStrategy::kShardOuter);
+    candidates.push_back(CpuBatchMatMulStrategy::kBlockOuter);
+    const typename CpuBatchMatMulAutotuner<Scalar>::Key key = {
+        batch_size, in_x.dim_size(1), in_x.dim_size(2), out->dim_size(2),
+        adj_x | trans_x << 1 | adj_y << 2 | trans_y << 3 |
+            static_cast<int64>(bcast.IsBroadcastingRequired()) << 4};
+    auto* autotuner = CpuBatchMatMulAutotuner<Scalar>::Get();
+    bool measure;
+    strategy = autotuner->Lookup(key, candidates, &measure);
+    if (!measure) {
+      RunStrategy(context, strategy, in_x, in_y, adj_x, adj_y, trans_x,
+                  trans_y, bcast, out);
+      return;
+    }
+    const uint64 start_micros = Env::Default()->NowMicros();
+    RunStrategy(context, strategy, in_x, in_y, adj_x, adj_y, trans_x, trans_y,
+                bcast, out);
+    const uint64 micros = Env::Default()->NowMicros() - start_micros;
+    VLOG(2) << "BatchMatMul strategy " << static_cast<int>(strategy)
+            << " ran in " << micros << "us for batch " << batch_size << " of "
+            << in_x.dim_size(1) << "x" << in_x.dim_size(2) << "x"
+            << out->dim_size(2);
+    autotuner->Record(key, strategy, micros);
+  }
+
+ private:
+  static void RunStrategy(OpKernelContext* context,
+                          CpuBatchMatMulStrategy strategy, const Tensor& in_x,
+                          const Tensor& in_y, bool adj_x, bool adj_y,
+                          bool trans_x, bool trans_y, const MatMulBCast& bcast,
+                          Tensor* out) {
+    typedef ParallelMatMulKernel<Scalar, Eigen::NumTraits<Scalar>::IsComplex>
+        ParallelMatMulKernel;
+    bool conjugate_result = false;
+    const int64 batch_size = bcast.output_batch_size();
+    const int64 cost_per_unit =
+        in_x.dim_size(1) * in_x.dim_size(2) * out->dim_size(2);
+    auto worker_threads = *(context->device()->tensorflow_cpu_worker_threads());
+    auto sequential = [&in_x, &in_y, adj_x, adj_y, trans_x, trans_y, &bcast,
+                       out](int64 start, int64 limit) {
+      SequentialMatMulKernel<Scalar>::Run(in_x, in_y, adj_x, adj_y, trans_x,
+                                          trans_y, bcast, out, start, limit);
+    };
+    switch (strategy) {
+      case CpuBatchMatMulStrategy::kFoldBatch:
+        ParallelMatMulKernel::RunFoldedBatch(context, in_x, in_y, adj_y,
+                                             trans_y, out);
+        break;
+      case CpuBatchMatMulStrategy::kParallelInner:
+        ParallelMatMulKernel::Run(context, in_x, in_y, adj_x, adj_y, trans_x,
+                                  trans_y, bcast, out, 0, batch_size);
+        conjugate_result = adj_x;
+        break;
+      case CpuBatchMatMulStrategy::kShardOuter:
+        Shard(worker_threads.num_threads, worker_threads.workers, batch_size,
+              cost_per_unit, sequential);
+        break;
+      case CpuBatchMatMulStrategy::kBlockOuter: {
+        const int64 num_blocks = worker_threads.workers->NumThreads() + 1;
+        const int64 block_size = (batch_size + num_blocks - 1) / num_blocks;
+        worker_threads.workers->ParallelFor(
+            batch_size,
+            thread::ThreadPool::SchedulingParams(
+                thread::ThreadPool::SchedulingStrategy::kFixedBlockSize,
+                absl::nullopt, block_size),
+            sequential);
+        break;
+      }
     }
     if (conjugate_result) {
       // We used one of the identities
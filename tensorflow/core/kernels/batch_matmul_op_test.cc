@@ -180,6 +180,10 @@ BM_BatchMatmulBCast(1, 128, 1, 200, 10000, false);
 BM_BatchMatmulBCast(128, 1, 1, 200, 10000, true);
 BM_BatchMatmulBCast(128, 1, 1, 200, 10000, false);
 
+// Many small matrices, as in multi-head attention.
+BM_BatchMatmulBCast(1024, 1, 64, 64, 64, true);
+BM_BatchMatmulBCast(1024, 1, 64, 64, 64, false);
+
 // Typical fully connected layers
 BM_BatchMatmul(1, 1, 1024, 1024, false, false);
 BM_BatchMatmul(1, 8, 1024, 1024, false, false);
@@ -224,6 +228,8 @@ BM_BatchMatmul(32, 128, 128, 128, false, false);
 BM_BatchMatmul(32, 256, 256, 256, false, false);
 BM_BatchMatmul(32, 1024, 1024, 1024, false, false);
 BM_BatchMatmul(32, 2048, 2048, 2048, false, false);
+BM_BatchMatmul(1024, 64, 64, 64, false, false);
+BM_BatchMatmul(1024, 64, 64, 64, false, true);
 
 // Matrix-vector multiplies.
 BM_BatchMatmul(1, 10000, 200, 1, false, false);
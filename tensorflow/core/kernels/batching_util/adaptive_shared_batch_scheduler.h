@@ -70,6 +70,14 @@ class ASBSQueue;
 // CPU utilization - If the batch processing is cpu dominated, you can reap
 //   latency gains when underutilized by increasing the processing rate, but
 //   back the rate off when the load increases to avoid overload.
+//
+// Sharing between queues - By default all queues compete for the in flight
+// batches by age only, so a high traffic queue can starve the others. With
+// enable_weighted_fair_scheduling, the batches are instead handed out by
+// weighted fair queuing: each queue gets a share of the processed tasks
+// proportional to its scheduling_weight, whatever its load. Inside a queue,
+// tasks can also be split into priority levels, whose batches are scheduled
+// before those of the lower levels of the same queue.
 
 template <typename TaskType>
 class AdaptiveSharedBatchScheduler
@@ -117,6 +125,12 @@ class AdaptiveSharedBatchScheduler
     // numbers will give less noisy latency measurements, but will be less
     // responsive to changes in workload.
     int64 batches_to_average_over = 1000;
+    // If true, the next batch is taken from the queue with the smallest
+    // processed size relative to its QueueOptions::scheduling_weight (start
+    // time fair queuing), instead of being chosen by age across all queues.
+    // Batch age and full_batch_scheduling_boost_micros still order the
+    // batches of a queue.
+    bool enable_weighted_fair_scheduling = false;
   };
 
   // Ownership is shared between the caller of Create() and any queues created
@@ -134,10 +148,44 @@ class AdaptiveSharedBatchScheduler
     // A non-zero value can improve performance by limiting the scheduling of
     // nearly empty batches.
     int64 batch_timeout_micros = 0;
+    // Relative share of the processed tasks given to this queue when
+    // Options::enable_weighted_fair_scheduling is set. Must be positive.
+    double scheduling_weight = 1.0;
+    // Number of priority levels of the tasks. Tasks of different levels are
+    // placed in different batches, and a schedulable batch of a level is
+    // always scheduled before the batches of the queue with a larger level.
+    // If larger than 1, task_priority_func must be set.
+    int num_priority_levels = 1;
+    // Returns the priority level of a task, in [0, num_priority_levels), 0
+    // being the most urgent.
+    std::function<int(const TaskType&)> task_priority_func;
+    // If set, returns the deadline of a task, as an absolute time of
+    // Options::env in microseconds, or 0 if the task has none. Schedule()
+    // rejects a task with DEADLINE_EXCEEDED right away when its predicted
+    // latency, i.e. the average queueing delay plus processing latency of the
+    // queue's recent batches, would exceed its deadline.
+    std::function<int64(const TaskType&)> task_deadline_func;
   };
 
   using BatchProcessor = std::function<void(std::unique_ptr<Batch<TaskType>>)>;
 
+  // Statistics of the batches of a queue, see GetQueueStats().
+  struct QueueStats {
+    // Number of batches and tasks scheduled for processing so far.
+    int64 num_scheduled_batches = 0;
+    int64 num_scheduled_tasks = 0;
+    // Number of tasks rejected by Schedule() as they would miss their
+    // deadline.
+    int64 num_rejected_tasks = 0;
+    // Exponential moving averages of the time the batches waited to be
+    // scheduled (since their creation), and took to be processed.
+    double avg_queueing_delay_micros = 0;
+    double avg_processing_latency_micros = 0;
+    // Fraction of the batch processing time of all the queues of the
+    // scheduler spent on this queue.
+    double processing_share = 0;
+  };
+
   // Adds queue (and its callback) to be managed by this scheduler.
   Status AddQueue(const QueueOptions& options,
                   BatchProcessor process_batch_callback,
@@ -148,6 +196,11 @@ class AdaptiveSharedBatchScheduler
     return in_flight_batches_limit_;
   }
 
+  // Gets the statistics of 'queue', which must have been added by AddQueue()
+  // and not deleted yet.
+  Status GetQueueStats(const BatchScheduler<TaskType>* queue,
+                       QueueStats* stats);
+
  private:
   // access to AddBatch, RemoveQueue, GetEnv.
   friend class internal::ASBSQueue<TaskType>;
@@ -168,6 +221,12 @@ class AdaptiveSharedBatchScheduler
   // their latencies will not affect in_flight_batches_limit_.
   void MaybeScheduleClosedBatch() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
 
+  // Removes the batch at 'it' from batches_, releases it from its queue and
+  // schedules its processing.
+  void ScheduleBatch(
+      typename std::vector<const internal::ASBSBatch<TaskType>*>::iterator it,
+      bool is_express) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
   // Notifies scheduler of non-empty batch which is eligible for processing.
   void AddBatch(const internal::ASBSBatch<TaskType>* batch,
                 bool also_schedule_closed_batch);
@@ -175,6 +234,11 @@ class AdaptiveSharedBatchScheduler
   // Removes queue from scheduler.
   void RemoveQueue(const internal::ASBSQueue<TaskType>* queue);
 
+  // Returns whether a task of 'queue' with the deadline 'deadline_micros' can
+  // be accepted, and counts it as rejected otherwise.
+  bool AdmitTask(const internal::ASBSQueue<TaskType>* queue,
+                 int64 deadline_micros);
+
   Env* GetEnv() const { return options_.env; }
 
   const Options options_;
@@ -183,9 +247,31 @@ class AdaptiveSharedBatchScheduler
   // until they are released for processing.
   std::vector<const internal::ASBSBatch<TaskType>*> batches_ TF_GUARDED_BY(mu_);
 
-  // Unowned queues and callbacks added by AddQueue.
-  std::unordered_map<const internal::ASBSQueue<TaskType>*, BatchProcessor>
-      queues_and_callbacks_ TF_GUARDED_BY(mu_);
+  // The scheduling state of a queue added by AddQueue.
+  struct QueueState {
+    BatchProcessor callback;
+    double scheduling_weight = 1.0;
+    // Total size of the scheduled batches divided by scheduling_weight, i.e.
+    // the virtual time at which the next batch of the queue starts.
+    double virtual_time = 0;
+    // Total processing time of the batches of the queue.
+    int64 processing_micros = 0;
+    QueueStats stats;
+  };
+
+  // Unowned queues added by AddQueue, and their state.
+  std::unordered_map<const internal::ASBSQueue<TaskType>*, QueueState>
+      queue_states_ TF_GUARDED_BY(mu_);
+
+  // Virtual time of the last batch scheduled, which idle queues catch up with
+  // so they can't bank shares while they have no batches.
+  double virtual_time_ TF_GUARDED_BY(mu_) = 0;
+
+  // Total processing time of the batches of all the queues.
+  int64 processing_micros_ TF_GUARDED_BY(mu_) = 0;
+
+  // Weight of the last sample in the moving averages of QueueStats.
+  constexpr static double kQueueStatsSampleWeight = 0.1;
 
   mutex mu_;
 
@@ -264,8 +350,9 @@ class ASBSQueue : public BatchScheduler<TaskType> {
  private:
   std::shared_ptr<AdaptiveSharedBatchScheduler<TaskType>> scheduler_;
   const QueueOptions options_;
-  // Owned by scheduler_.
-  ASBSBatch<TaskType>* current_batch_ TF_GUARDED_BY(mu_) = nullptr;
+  // The batch being filled for each priority level, if any. Owned by
+  // scheduler_.
+  std::vector<ASBSBatch<TaskType>*> current_batches_ TF_GUARDED_BY(mu_);
   int64 num_enqueued_batches_ TF_GUARDED_BY(mu_) = 0;
   int64 num_enqueued_tasks_ TF_GUARDED_BY(mu_) = 0;
   mutable mutex mu_;
@@ -277,15 +364,19 @@ template <typename TaskType>
 class ASBSBatch : public Batch<TaskType> {
  public:
   ASBSBatch(ASBSQueue<TaskType>* queue, int64 creation_time_micros,
-            int64 batch_timeout_micros)
+            int64 batch_timeout_micros, int priority = 0)
       : queue_(queue),
         creation_time_micros_(creation_time_micros),
-        schedulable_time_micros_(creation_time_micros + batch_timeout_micros) {}
+        schedulable_time_micros_(creation_time_micros + batch_timeout_micros),
+        priority_(priority) {}
 
   ~ASBSBatch() override {}
 
   ASBSQueue<TaskType>* queue() const { return queue_; }
 
+  // Priority level of the tasks of the batch, 0 being the most urgent.
+  int priority() const { return priority_; }
+
   int64 creation_time_micros() const { return creation_time_micros_; }
 
   int64 schedulable_time_micros() const { return schedulable_time_micros_; }
@@ -294,6 +385,7 @@ class ASBSBatch : public Batch<TaskType> {
   ASBSQueue<TaskType>* queue_;
   const int64 creation_time_micros_;
   const int64 schedulable_time_micros_;
+  const int priority_;
   TF_DISALLOW_COPY_AND_ASSIGN(ASBSBatch);
 };
 }  // namespace internal
@@ -306,6 +398,10 @@ constexpr double AdaptiveSharedBatchScheduler<TaskType>::kMaxStepSizeMultiplier;
 template <typename TaskType>
 constexpr double AdaptiveSharedBatchScheduler<TaskType>::kMinStepSizeMultiplier;
 
+template <typename TaskType>
+constexpr double
+    AdaptiveSharedBatchScheduler<TaskType>::kQueueStatsSampleWeight;
+
 template <typename TaskType>
 Status AdaptiveSharedBatchScheduler<TaskType>::Create(
     const Options& options,
@@ -382,14 +478,68 @@ Status AdaptiveSharedBatchScheduler<TaskType>::AddQueue(
         "max_enqueued_batches must be positive; was ",
         options.max_enqueued_batches);
   }
+  if (options.scheduling_weight <= 0) {
+    return errors::InvalidArgument("scheduling_weight must be positive; was ",
+                                   options.scheduling_weight);
+  }
+  if (options.num_priority_levels <= 0) {
+    return errors::InvalidArgument(
+        "num_priority_levels must be positive; was ",
+        options.num_priority_levels);
+  }
+  if (options.num_priority_levels > 1 &&
+      options.task_priority_func == nullptr) {
+    return errors::InvalidArgument(
+        "task_priority_func must be specified when num_priority_levels is ",
+        options.num_priority_levels);
+  }
   internal::ASBSQueue<TaskType>* asbs_queue_raw;
   queue->reset(asbs_queue_raw = new internal::ASBSQueue<TaskType>(
                    this->shared_from_this(), options));
   mutex_lock l(mu_);
-  queues_and_callbacks_[asbs_queue_raw] = process_batch_callback;
+  QueueState& state = queue_states_[asbs_queue_raw];
+  state.callback = process_batch_callback;
+  state.scheduling_weight = options.scheduling_weight;
   return Status::OK();
 }
 
+template <typename TaskType>
+Status AdaptiveSharedBatchScheduler<TaskType>::GetQueueStats(
+    const BatchScheduler<TaskType>* queue, QueueStats* stats) {
+  mutex_lock l(mu_);
+  for (const auto& queue_and_state : queue_states_) {
+    if (static_cast<const BatchScheduler<TaskType>*>(queue_and_state.first) ==
+        queue) {
+      *stats = queue_and_state.second.stats;
+      stats->processing_share =
+          processing_micros_ > 0
+              ? queue_and_state.second.processing_micros /
+                    static_cast<double>(processing_micros_)
+              : 0;
+      return Status::OK();
+    }
+  }
+  return errors::NotFound("Queue not managed by this scheduler");
+}
+
+template <typename TaskType>
+bool AdaptiveSharedBatchScheduler<TaskType>::AdmitTask(
+    const internal::ASBSQueue<TaskType>* queue, int64 deadline_micros) {
+  mutex_lock l(mu_);
+  auto it = queue_states_.find(queue);
+  if (it == queue_states_.end()) return true;
+  QueueStats& stats = it->second.stats;
+  // Nothing to predict the latency from yet.
+  if (stats.num_scheduled_batches == 0) return true;
+  const double predicted_latency_micros =
+      stats.avg_queueing_delay_micros + stats.avg_processing_latency_micros;
+  if (GetEnv()->NowMicros() + predicted_latency_micros <= deadline_micros) {
+    return true;
+  }
+  stats.num_rejected_tasks++;
+  return false;
+}
+
 template <typename TaskType>
 void AdaptiveSharedBatchScheduler<TaskType>::AddBatch(
     const internal::ASBSBatch<TaskType>* batch,
@@ -411,7 +561,7 @@ template <typename TaskType>
 void AdaptiveSharedBatchScheduler<TaskType>::RemoveQueue(
     const internal::ASBSQueue<TaskType>* queue) {
   mutex_lock l(mu_);
-  queues_and_callbacks_.erase(queue);
+  queue_states_.erase(queue);
 }
 
 template <typename TaskType>
@@ -424,30 +574,81 @@ void AdaptiveSharedBatchScheduler<TaskType>::MaybeScheduleNextBatch() {
           in_flight_batches_limit_ - in_flight_batches_) {
     return;
   }
+  int64 now_micros = GetEnv()->NowMicros();
+  auto score = [this](const internal::ASBSBatch<TaskType>* batch) {
+    return batch->creation_time_micros() -
+           options_.full_batch_scheduling_boost_micros * batch->size() /
+               static_cast<double>(batch->queue()->max_task_size());
+  };
+  // First pick the queue to schedule from: the one of the best scoring batch,
+  // or the one furthest behind its share with weighted fair scheduling.
   auto best_it = batches_.end();
   double best_score;
-  int64 now_micros = GetEnv()->NowMicros();
   for (auto it = batches_.begin(); it != batches_.end(); it++) {
     if ((*it)->schedulable_time_micros() > now_micros) continue;
-    const double score =
-        (*it)->creation_time_micros() -
-        options_.full_batch_scheduling_boost_micros * (*it)->size() /
-            static_cast<double>((*it)->queue()->max_task_size());
-    if (best_it == batches_.end() || score < best_score) {
-      best_score = score;
+    // With weighted fair scheduling, the virtual time at which the next batch
+    // of the queue starts.
+    const double batch_score =
+        options_.enable_weighted_fair_scheduling
+            ? std::max(virtual_time_,
+                       queue_states_[(*it)->queue()].virtual_time)
+            : score(*it);
+    if (best_it == batches_.end() || batch_score < best_score) {
+      best_score = batch_score;
       best_it = it;
     }
   }
   // No schedulable batches.
   if (best_it == batches_.end()) return;
-  const internal::ASBSBatch<TaskType>* batch = *best_it;
-  batches_.erase(best_it);
+  // Then the best scoring batch of that queue, of the most urgent priority.
+  const internal::ASBSQueue<TaskType>* queue = (*best_it)->queue();
+  for (auto it = batches_.begin(); it != batches_.end(); it++) {
+    if ((*it)->queue() != queue ||
+        (*it)->schedulable_time_micros() > now_micros) {
+      continue;
+    }
+    if ((*it)->priority() < (*best_it)->priority() ||
+        ((*it)->priority() == (*best_it)->priority() &&
+         score(*it) < score(*best_it))) {
+      best_it = it;
+    }
+  }
+  ScheduleBatch(best_it, /*is_express=*/false);
+}
+
+template <typename TaskType>
+void AdaptiveSharedBatchScheduler<TaskType>::ScheduleBatch(
+    typename std::vector<const internal::ASBSBatch<TaskType>*>::iterator it,
+    bool is_express) {
+  const internal::ASBSBatch<TaskType>* batch = *it;
+  batches_.erase(it);
+  QueueState& state = queue_states_[batch->queue()];
+  const double start_virtual_time =
+      std::max(virtual_time_, state.virtual_time);
+  virtual_time_ = start_virtual_time;
+  state.virtual_time =
+      start_virtual_time + batch->size() / state.scheduling_weight;
+  QueueStats& stats = state.stats;
+  const int64 queueing_delay_micros =
+      GetEnv()->NowMicros() - batch->creation_time_micros();
+  stats.avg_queueing_delay_micros =
+      stats.num_scheduled_batches == 0
+          ? queueing_delay_micros
+          : stats.avg_queueing_delay_micros +
+                kQueueStatsSampleWeight *
+                    (queueing_delay_micros - stats.avg_queueing_delay_micros);
+  stats.num_scheduled_batches++;
+  stats.num_scheduled_tasks += batch->num_tasks();
   // Queue may destroy itself after ReleaseBatch is called.
   batch->queue()->ReleaseBatch(batch);
   batch_thread_pool_->Schedule(
       std::bind(&AdaptiveSharedBatchScheduler<TaskType>::CallbackWrapper, this,
-                batch, queues_and_callbacks_[batch->queue()], false));
-  in_flight_batches_++;
+                batch, state.callback, is_express));
+  if (is_express) {
+    in_flight_express_batches_++;
+  } else {
+    in_flight_batches_++;
+  }
 }
 
 template <typename TaskType>
@@ -458,13 +659,7 @@ void AdaptiveSharedBatchScheduler<TaskType>::MaybeScheduleClosedBatch() {
   }
   for (auto it = batches_.begin(); it != batches_.end(); it++) {
     if ((*it)->IsClosed()) {
-      const internal::ASBSBatch<TaskType>* batch = *it;
-      batches_.erase(it);
-      batch->queue()->ReleaseBatch(batch);
-      batch_thread_pool_->Schedule(
-          std::bind(&AdaptiveSharedBatchScheduler<TaskType>::CallbackWrapper,
-                    this, batch, queues_and_callbacks_[batch->queue()], true));
-      in_flight_express_batches_++;
+      ScheduleBatch(it, /*is_express=*/true);
       return;
     }
   }
@@ -476,10 +671,28 @@ void AdaptiveSharedBatchScheduler<TaskType>::CallbackWrapper(
     AdaptiveSharedBatchScheduler<TaskType>::BatchProcessor callback,
     bool is_express) {
   int64 start_time = batch->creation_time_micros();
+  // The queue may be destroyed while the batch is processed, so only its
+  // address is used afterwards.
+  const internal::ASBSQueue<TaskType>* queue = batch->queue();
+  const int64 processing_start_time = GetEnv()->NowMicros();
   callback(std::unique_ptr<Batch<TaskType>>(
       const_cast<internal::ASBSBatch<TaskType>*>(batch)));
   int64 end_time = GetEnv()->NowMicros();
   mutex_lock l(mu_);
+  const int64 processing_micros = end_time - processing_start_time;
+  processing_micros_ += processing_micros;
+  auto state_it = queue_states_.find(queue);
+  if (state_it != queue_states_.end()) {
+    QueueState& state = state_it->second;
+    QueueStats& stats = state.stats;
+    stats.avg_processing_latency_micros =
+        state.processing_micros == 0
+            ? processing_micros
+            : stats.avg_processing_latency_micros +
+                  kQueueStatsSampleWeight *
+                      (processing_micros - stats.avg_processing_latency_micros);
+    state.processing_micros += processing_micros;
+  }
   if (is_express) {
     in_flight_express_batches_--;
     MaybeScheduleClosedBatch();
@@ -534,7 +747,9 @@ template <typename TaskType>
 ASBSQueue<TaskType>::ASBSQueue(
     std::shared_ptr<AdaptiveSharedBatchScheduler<TaskType>> scheduler,
     const QueueOptions& options)
-    : scheduler_(scheduler), options_(options) {}
+    : scheduler_(scheduler),
+      options_(options),
+      current_batches_(options.num_priority_levels, nullptr) {}
 
 template <typename TaskType>
 ASBSQueue<TaskType>::~ASBSQueue() {
@@ -561,26 +776,48 @@ Status ASBSQueue<TaskType>::Schedule(std::unique_ptr<TaskType>* task) {
                                    " is larger than maximum batch size ",
                                    options_.max_batch_size);
   }
+  int priority = 0;
+  if (options_.task_priority_func) {
+    priority = options_.task_priority_func(**task);
+    if (priority < 0 || priority >= options_.num_priority_levels) {
+      return errors::InvalidArgument("Task priority ", priority,
+                                     " is not in [0, ",
+                                     options_.num_priority_levels, ")");
+    }
+  }
+  if (options_.task_deadline_func) {
+    const int64 deadline_micros = options_.task_deadline_func(**task);
+    if (deadline_micros > 0 && !scheduler_->AdmitTask(this, deadline_micros)) {
+      return errors::DeadlineExceeded(
+          "The task would miss its deadline in the batch scheduling queue");
+    }
+  }
   bool is_old_batch_closed = false;
   {
     mutex_lock l(mu_);
+    ASBSBatch<TaskType>*& current_batch = current_batches_[priority];
     // Current batch is full, create another if allowed.
-    if (current_batch_ &&
-        current_batch_->size() + size > options_.max_batch_size) {
+    if (current_batch &&
+        current_batch->size() + size > options_.max_batch_size) {
       if (num_enqueued_batches_ >= options_.max_enqueued_batches) {
         return errors::Unavailable("The batch scheduling queue is full");
       }
-      current_batch_->Close();
+      current_batch->Close();
       is_old_batch_closed = true;
-      current_batch_ = nullptr;
+      current_batch = nullptr;
     }
-    if (!current_batch_) {
+    if (!current_batch) {
+      if (num_enqueued_batches_ >= options_.max_enqueued_batches) {
+        // Only possible with several priority levels, as a batch of each
+        // level may be open.
+        return errors::Unavailable("The batch scheduling queue is full");
+      }
       num_enqueued_batches_++;
-      current_batch_ = new_batch =
-          new ASBSBatch<TaskType>(this, scheduler_->GetEnv()->NowMicros(),
-                                  options_.batch_timeout_micros);
+      current_batch = new_batch = new ASBSBatch<TaskType>(
+          this, scheduler_->GetEnv()->NowMicros(),
+          options_.batch_timeout_micros, priority);
     }
-    current_batch_->AddTask(std::move(*task));
+    current_batch->AddTask(std::move(*task));
     num_enqueued_tasks_++;
   }
   // AddBatch must be called outside of lock, since it may call ReleaseBatch.
@@ -594,9 +831,10 @@ void ASBSQueue<TaskType>::ReleaseBatch(const ASBSBatch<TaskType>* batch) {
   mutex_lock l(mu_);
   num_enqueued_batches_--;
   num_enqueued_tasks_ -= batch->num_tasks();
-  if (batch == current_batch_) {
-    current_batch_->Close();
-    current_batch_ = nullptr;
+  ASBSBatch<TaskType>*& current_batch = current_batches_[batch->priority()];
+  if (batch == current_batch) {
+    current_batch->Close();
+    current_batch = nullptr;
   }
 }
 
@@ -609,8 +847,12 @@ size_t ASBSQueue<TaskType>::NumEnqueuedTasks() const {
 template <typename TaskType>
 size_t ASBSQueue<TaskType>::SchedulingCapacity() const {
   mutex_lock l(mu_);
-  const int current_batch_capacity =
-      current_batch_ ? options_.max_batch_size - current_batch_->size() : 0;
+  int current_batch_capacity = 0;
+  for (const ASBSBatch<TaskType>* current_batch : current_batches_) {
+    if (current_batch) {
+      current_batch_capacity += options_.max_batch_size - current_batch->size();
+    }
+  }
   const int spare_batches =
       options_.max_enqueued_batches - num_enqueued_batches_;
   return spare_batches * options_.max_batch_size + current_batch_capacity;
@@ -20,6 +20,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/protobuf/error_codes.pb.h"
 
 namespace tensorflow {
 namespace serving {
@@ -381,6 +382,202 @@ TEST(AdaptiveSharedBatchSchedulerTest, QueueCapacityInfo) {
   EXPECT_EQ(queue->SchedulingCapacity(), 8 * 1000 + 300);
   finish_processing.Notify();
 }
+
+TEST(AdaptiveSharedBatchSchedulerTest, BadQueueOptions) {
+  auto queue_callback = [](std::unique_ptr<Batch<FakeTask>> batch) {};
+  std::shared_ptr<AdaptiveSharedBatchScheduler<FakeTask>> scheduler;
+  TF_ASSERT_OK(AdaptiveSharedBatchScheduler<FakeTask>::Create({}, &scheduler));
+  std::unique_ptr<BatchScheduler<FakeTask>> queue;
+  AdaptiveSharedBatchScheduler<FakeTask>::QueueOptions queue_options;
+  queue_options.scheduling_weight = 0;
+  EXPECT_FALSE(scheduler->AddQueue(queue_options, queue_callback, &queue).ok());
+  queue_options.scheduling_weight = 1;
+  queue_options.num_priority_levels = 0;
+  EXPECT_FALSE(scheduler->AddQueue(queue_options, queue_callback, &queue).ok());
+  queue_options.num_priority_levels = 2;
+  EXPECT_FALSE(scheduler->AddQueue(queue_options, queue_callback, &queue).ok());
+}
+
+TEST(AdaptiveSharedBatchSchedulerTest, WeightedFairScheduling) {
+  for (const bool enable_weighted_fair_scheduling : {false, true}) {
+    AdaptiveSharedBatchScheduler<FakeTask>::Options options;
+    options.num_batch_threads = 1;
+    options.initial_in_flight_batches_limit = 1;
+    options.batches_to_average_over = 1000;
+    options.enable_weighted_fair_scheduling = enable_weighted_fair_scheduling;
+    mutex mu;
+    std::vector<int> processed_queues;
+    Notification first_batch_started, finish_processing, all_processed;
+    auto make_queue_callback = [&](int queue_id) {
+      return [&, queue_id](std::unique_ptr<Batch<FakeTask>> batch) {
+        ASSERT_TRUE(batch->IsClosed());
+        if (!first_batch_started.HasBeenNotified()) {
+          first_batch_started.Notify();
+        }
+        finish_processing.WaitForNotification();
+        mutex_lock l(mu);
+        processed_queues.push_back(queue_id);
+        if (processed_queues.size() == 7) {
+          all_processed.Notify();
+        }
+      };
+    };
+    std::shared_ptr<AdaptiveSharedBatchScheduler<FakeTask>> scheduler;
+    TF_ASSERT_OK(
+        AdaptiveSharedBatchScheduler<FakeTask>::Create(options, &scheduler));
+    AdaptiveSharedBatchScheduler<FakeTask>::QueueOptions queue_options;
+    queue_options.max_batch_size = 10;
+    std::unique_ptr<BatchScheduler<FakeTask>> queue0;
+    std::unique_ptr<BatchScheduler<FakeTask>> queue1;
+    TF_ASSERT_OK(
+        scheduler->AddQueue(queue_options, make_queue_callback(0), &queue0));
+    queue_options.scheduling_weight = 3;
+    TF_ASSERT_OK(
+        scheduler->AddQueue(queue_options, make_queue_callback(1), &queue1));
+
+    // The first batch of queue 0 is processed right away, and blocks the
+    // others.
+    TF_ASSERT_OK(ScheduleTask(10, queue0.get()));
+    first_batch_started.WaitForNotification();
+    for (int i = 0; i < 3; i++) {
+      TF_ASSERT_OK(ScheduleTask(10, queue0.get()));
+    }
+    for (int i = 0; i < 3; i++) {
+      TF_ASSERT_OK(ScheduleTask(10, queue1.get()));
+    }
+    finish_processing.Notify();
+    all_processed.WaitForNotification();
+
+    mutex_lock l(mu);
+    if (enable_weighted_fair_scheduling) {
+      // Queue 1 gets 3 batches for each batch of queue 0.
+      EXPECT_EQ(processed_queues, std::vector<int>({0, 1, 1, 1, 0, 0, 0}));
+    } else {
+      // The oldest batches first.
+      EXPECT_EQ(processed_queues, std::vector<int>({0, 0, 0, 0, 1, 1, 1}));
+    }
+  }
+}
+
+TEST(AdaptiveSharedBatchSchedulerTest, PriorityLevels) {
+  AdaptiveSharedBatchScheduler<FakeTask>::Options options;
+  options.num_batch_threads = 1;
+  options.initial_in_flight_batches_limit = 1;
+  options.batches_to_average_over = 1000;
+  mutex mu;
+  std::vector<size_t> processed_batch_sizes;
+  Notification first_batch_started, finish_processing, all_processed;
+  auto queue_callback = [&](std::unique_ptr<Batch<FakeTask>> batch) {
+    ASSERT_TRUE(batch->IsClosed());
+    if (!first_batch_started.HasBeenNotified()) {
+      first_batch_started.Notify();
+    }
+    finish_processing.WaitForNotification();
+    mutex_lock l(mu);
+    processed_batch_sizes.push_back(batch->size());
+    if (processed_batch_sizes.size() == 4) {
+      all_processed.Notify();
+    }
+  };
+  std::shared_ptr<AdaptiveSharedBatchScheduler<FakeTask>> scheduler;
+  TF_ASSERT_OK(
+      AdaptiveSharedBatchScheduler<FakeTask>::Create(options, &scheduler));
+  AdaptiveSharedBatchScheduler<FakeTask>::QueueOptions queue_options;
+  queue_options.max_batch_size = 2;
+  queue_options.num_priority_levels = 2;
+  // Tasks of size 1 are urgent.
+  queue_options.task_priority_func = [](const FakeTask& task) {
+    return task.size() == 1 ? 0 : 1;
+  };
+  std::unique_ptr<BatchScheduler<FakeTask>> queue;
+  TF_ASSERT_OK(scheduler->AddQueue(queue_options, queue_callback, &queue));
+
+  TF_ASSERT_OK(ScheduleTask(2, queue.get()));
+  first_batch_started.WaitForNotification();
+  // Two batches of the low priority level, then one of the urgent level which
+  // is processed before them.
+  TF_ASSERT_OK(ScheduleTask(2, queue.get()));
+  TF_ASSERT_OK(ScheduleTask(2, queue.get()));
+  TF_ASSERT_OK(ScheduleTask(1, queue.get()));
+  finish_processing.Notify();
+  all_processed.WaitForNotification();
+
+  mutex_lock l(mu);
+  EXPECT_EQ(processed_batch_sizes, std::vector<size_t>({2, 1, 2, 2}));
+}
+
+TEST(AdaptiveSharedBatchSchedulerTest, QueueStatsAndDeadlines) {
+  test_util::FakeClockEnv env(Env::Default());
+  Notification start_teardown, stop_teardown;
+  std::unique_ptr<Thread> teardown_thread =
+      CreateFakeClockAdvancerThread(&env, &start_teardown, &stop_teardown);
+  {
+    AdaptiveSharedBatchScheduler<FakeTask>::Options options;
+    options.env = &env;
+    options.initial_in_flight_batches_limit = 1;
+    options.batches_to_average_over = 1000;
+    mutex mu;
+    int processed_batches = 0;
+    Notification first_batch_processed, second_batch_processed;
+    auto queue_callback = [&](std::unique_ptr<Batch<FakeTask>> batch) {
+      // Every batch takes 100 microseconds to process.
+      env.AdvanceByMicroseconds(100);
+      mutex_lock l(mu);
+      processed_batches++;
+      if (processed_batches == 1) {
+        first_batch_processed.Notify();
+      } else if (processed_batches == 2) {
+        second_batch_processed.Notify();
+      }
+    };
+    std::shared_ptr<AdaptiveSharedBatchScheduler<FakeTask>> scheduler;
+    TF_ASSERT_OK(
+        AdaptiveSharedBatchScheduler<FakeTask>::Create(options, &scheduler));
+    AdaptiveSharedBatchScheduler<FakeTask>::QueueOptions queue_options;
+    int64 deadline_micros = 0;
+    queue_options.task_deadline_func = [&deadline_micros](const FakeTask&) {
+      return deadline_micros;
+    };
+    std::unique_ptr<BatchScheduler<FakeTask>> queue;
+    TF_ASSERT_OK(scheduler->AddQueue(queue_options, queue_callback, &queue));
+
+    TF_ASSERT_OK(ScheduleTask(100, queue.get()));
+    first_batch_processed.WaitForNotification();
+    // The second batch is only scheduled once the first one is accounted for.
+    TF_ASSERT_OK(ScheduleTask(100, queue.get()));
+    second_batch_processed.WaitForNotification();
+
+    AdaptiveSharedBatchScheduler<FakeTask>::QueueStats stats;
+    TF_ASSERT_OK(scheduler->GetQueueStats(queue.get(), &stats));
+    EXPECT_EQ(2, stats.num_scheduled_batches);
+    EXPECT_EQ(2, stats.num_scheduled_tasks);
+    EXPECT_EQ(0, stats.avg_queueing_delay_micros);
+    EXPECT_EQ(100, stats.avg_processing_latency_micros);
+    EXPECT_EQ(1.0, stats.processing_share);
+
+    // The predicted latency of a task is 100 microseconds.
+    deadline_micros = env.NowMicros() + 50;
+    EXPECT_EQ(error::DEADLINE_EXCEEDED,
+              ScheduleTask(100, queue.get()).code());
+    deadline_micros = env.NowMicros() + 150;
+    TF_EXPECT_OK(ScheduleTask(100, queue.get()));
+    TF_ASSERT_OK(scheduler->GetQueueStats(queue.get(), &stats));
+    EXPECT_EQ(1, stats.num_rejected_tasks);
+
+    std::unique_ptr<BatchScheduler<FakeTask>> other_queue;
+    TF_ASSERT_OK(
+        scheduler->AddQueue(queue_options, queue_callback, &other_queue));
+    TF_EXPECT_OK(scheduler->GetQueueStats(other_queue.get(), &stats));
+    EXPECT_EQ(0, stats.num_scheduled_batches);
+    BatchScheduler<FakeTask>* deleted_queue = other_queue.get();
+    other_queue.reset();
+    EXPECT_EQ(error::NOT_FOUND,
+              scheduler->GetQueueStats(deleted_queue, &stats).code());
+
+    start_teardown.Notify();
+  }
+  stop_teardown.Notify();
+}
 }  // namespace anonymous
 }  // namespace serving
 }  // namespace tensorflow
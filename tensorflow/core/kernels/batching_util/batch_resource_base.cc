@@ -79,6 +79,18 @@ const string& GetModelName(OpKernelContext* ctx) {
   return ctx->session_metadata()->name();
 }
 
+// Returns true if concat_split_util::Split supports tensors of `dtype`.
+bool IsSplitFastPathType(DataType dtype) {
+  switch (dtype) {
+#define CASE(type) case DataTypeToEnum<type>::value:
+    TF_CALL_ALL_TYPES(CASE)
+#undef CASE
+    return true;
+    default:
+      return false;
+  }
+}
+
 }  // namespace
 
 using ::tensorflow::concat_split_util::Concat;
@@ -140,6 +152,7 @@ BatchResourceBase::GetBatcherQueueOptions(
   batcher_queue_options.input_batch_size_limit = max_batch_size;
   batcher_queue_options.max_enqueued_batches = max_enqueued_batches;
   batcher_queue_options.batch_timeout_micros = batch_timeout_micros;
+  batcher_queue_options.allowed_batch_sizes = allowed_batch_sizes;
   // Support for splitting large batch is still in progress.
   batcher_queue_options.enable_large_batch_splitting =
       enable_large_batch_splitting;
@@ -239,6 +252,12 @@ Status BatchResourceBase::ConcatInputTensors(
       }
     }
 
+    // A batch of a single unpadded task is its input, no need to copy it.
+    if (to_concatenate.size() == 1) {
+      concatenated_tensors->push_back(to_concatenate[0]);
+      continue;
+    }
+
     Tensor concatenated_tensor;
     Status concat_status =
         Concat(context, to_concatenate, &concatenated_tensor);
@@ -401,10 +420,20 @@ Status BatchResourceBase::SplitOutputTensors(
           "the 0th dimension sizes of the input tensors");
     }
 
+    // The tasks' outputs are slices sharing the buffer of the batched output
+    // when they are aligned, and are only copied otherwise. Copies are
+    // allocated with the last task's context: all tasks run on the same
+    // device, the buffers are reference counted, and that context stays alive
+    // until the batch's done callbacks run after the split, just as for the
+    // batched inputs in ConcatInputTensors. Types that Split does not handle,
+    // e.g. quantized ones, go through tensor::Split instead.
     std::vector<Tensor> split_tensor;
-    const Status split_status = tensor::Split(
-        output_tensor, task_sizes_plus_optional_padding, &split_tensor);
-    DCHECK(split_status.ok()) << split_status.ToString();
+    const Status split_status =
+        IsSplitFastPathType(output_tensor.dtype())
+            ? Split(batch->task(batch->num_tasks() - 1).context, output_tensor,
+                    task_sizes_plus_optional_padding, &split_tensor)
+            : tensor::Split(output_tensor, task_sizes_plus_optional_padding,
+                            &split_tensor);
     if (!split_status.ok()) {
       return errors::Internal("Tensor split operation failed: ",
                               split_status.ToString());
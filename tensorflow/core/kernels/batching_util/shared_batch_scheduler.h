@@ -18,6 +18,8 @@ limitations under the License.
 
 #include <stddef.h>
 
+#include <algorithm>
+#include <cmath>
 #include <deque>
 #include <functional>
 #include <list>
@@ -193,6 +195,27 @@ class SharedBatchScheduler
     // submit batches whose size is in a small set of allowed sizes, that can be
     // done by adding padding in the process-batch callback.
     size_t max_execution_batch_size = 1000;
+
+    // The batch sizes the process-batch callback pads the batches to, if any.
+    // The entries must be positive, increase monotonically and not exceed the
+    // maximum batch size. Only used to form batches when `latency_slo_micros`
+    // is set.
+    std::vector<int32> allowed_batch_sizes;
+
+    // If positive, the target latency (in microseconds) of a task, from its
+    // submission to the end of the processing of its batch. The queue then
+    // estimates online the arrival rate of the tasks and the 99th percentile
+    // processing latency of each (padded) batch size, and closes the open
+    // batch
+    //  - once its oldest task can't wait any longer and still meet the target,
+    //    but never later than after `batch_timeout_micros` (which becomes an
+    //    upper bound), or
+    //  - as soon as it needs no padding, if at the observed arrival rate the
+    //    tasks filling the next allowed batch size wouldn't arrive in time to
+    //    meet the target.
+    // This trades batch size for latency under low load, and still forms
+    // large batches under high load.
+    int64 latency_slo_micros = 0;
   };
   Status AddQueue(const QueueOptions& options,
                   std::function<void(std::unique_ptr<Batch<TaskType>>)>
@@ -344,6 +367,38 @@ class Queue {
   // currently schedulable.
   bool IsOpenBatchSchedulable() const TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
 
+  // Determines whether the open batch, of 'batch_size' and whose oldest task
+  // has waited for 'waited_micros', must be closed to meet
+  // 'options_.latency_slo_micros'.
+  bool IsOpenBatchDueForLatencySlo(int batch_size, int64 waited_micros) const
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Returns the smallest entry of 'options_.allowed_batch_sizes' greater than
+  // or equal to 'batch_size', or 'batch_size' if there is none.
+  int RoundToAllowedBatchSize(int batch_size) const;
+
+  // Returns the batch size the open batch of 'batch_size' tasks reaches next
+  // without padding, capped to the maximum batch size.
+  int NextAllowedBatchSize(int batch_size) const;
+
+  // Returns the index in 'latency_estimates_' of the (padded) 'batch_size'.
+  int LatencyEstimateIndex(int batch_size) const;
+
+  // Returns the estimated 99th percentile processing latency of 'batch_size',
+  // or 0 if no batch of that size was processed yet.
+  int64 EstimatedProcessingMicros(int batch_size) const
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Updates the arrival rate estimate with a task of 'task_size' submitted at
+  // 'now_micros'.
+  void RecordArrival(size_t task_size, uint64 now_micros)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Updates the processing latency estimate of 'batch_size' with a batch that
+  // took 'latency_micros' to be processed.
+  void RecordProcessingLatency(int batch_size, int64 latency_micros)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
   const typename SharedBatchScheduler<TaskType>::QueueOptions options_;
 
   // The environment to use.
@@ -389,6 +444,27 @@ class Queue {
   // 'empty_notification_->Notify()'.
   Notification* empty_notification_ TF_GUARDED_BY(mu_) = nullptr;
 
+  // An exponentially weighted estimate of the processing latency of a batch
+  // size, for 'options_.latency_slo_micros'.
+  struct LatencyEstimate {
+    int64 num_samples = 0;
+    double mean_micros = 0;
+    double variance = 0;
+  };
+
+  // The estimates of each allowed batch size, or of all the batch sizes if no
+  // allowed batch sizes are given. Only maintained when
+  // 'options_.latency_slo_micros' is set, as the following arrival estimates.
+  std::vector<LatencyEstimate> latency_estimates_ TF_GUARDED_BY(mu_);
+
+  // The time the last task was submitted at, or 0 if none was.
+  uint64 last_arrival_micros_ TF_GUARDED_BY(mu_) = 0;
+
+  // Exponentially weighted means of the time between two task submissions and
+  // of the size of the tasks, whose ratio estimates the arrival rate.
+  double mean_interarrival_micros_ TF_GUARDED_BY(mu_) = 0;
+  double mean_task_size_ TF_GUARDED_BY(mu_) = 0;
+
   TF_DISALLOW_COPY_AND_ASSIGN(Queue);
 };
 
@@ -472,6 +548,30 @@ Status SharedBatchScheduler<TaskType>::AddQueue(
         "max_enqueued_batches must be non-negative; was ",
         options.max_enqueued_batches);
   }
+  if (options.latency_slo_micros < 0) {
+    return errors::InvalidArgument(
+        "latency_slo_micros must be non-negative; was ",
+        options.latency_slo_micros);
+  }
+
+  const size_t max_execution_batch_size =
+      options.enable_large_batch_splitting ? options.max_execution_batch_size
+                                           : options.input_batch_size_limit;
+  int32 last_allowed_batch_size = 0;
+  for (const int32 allowed_batch_size : options.allowed_batch_sizes) {
+    if (allowed_batch_size <= last_allowed_batch_size) {
+      return errors::InvalidArgument(
+          "allowed_batch_sizes entries must be positive and monotonically "
+          "increasing");
+    }
+    last_allowed_batch_size = allowed_batch_size;
+  }
+  if (static_cast<size_t>(last_allowed_batch_size) >
+      max_execution_batch_size) {
+    return errors::InvalidArgument(
+        "allowed_batch_sizes entries must not exceed the maximum batch size ",
+        max_execution_batch_size, "; was ", last_allowed_batch_size);
+  }
 
   if (options.enable_large_batch_splitting &&
       options.split_input_task_func == nullptr) {
@@ -595,6 +695,10 @@ Queue<TaskType>::Queue(
       schedulable_batch_callback_(schedulable_batch_callback) {
   // Create an initial, open batch.
   batches_.emplace_back(new Batch<TaskType>);
+  if (options_.latency_slo_micros > 0) {
+    latency_estimates_.resize(
+        std::max<size_t>(options_.allowed_batch_sizes.size(), 1));
+  }
 }
 
 template <typename TaskType>
@@ -637,8 +741,12 @@ Status Queue<TaskType>::ScheduleWithoutSplit(std::unique_ptr<TaskType>* task) {
       }
       StartNewBatch();
     }
+    const uint64 now_micros = env_->NowMicros();
     if (batches_.back()->empty()) {
-      open_batch_start_time_micros_ = env_->NowMicros();
+      open_batch_start_time_micros_ = now_micros;
+    }
+    if (options_.latency_slo_micros > 0) {
+      RecordArrival((*task)->size(), now_micros);
     }
     profiler::TraceMeProducer trace_me(
         [&] { return strings::StrCat("Schedule:", (*task)->size()); },
@@ -711,6 +819,10 @@ Status Queue<TaskType>::ScheduleWithSplit(std::unique_ptr<TaskType>* task) {
 
     std::vector<std::unique_ptr<TaskType>> output_tasks;
 
+    if (options_.latency_slo_micros > 0) {
+      RecordArrival(input_task_size, env_->NowMicros());
+    }
+
     if (input_task_size <= open_batch_remaining_slot) {
       // This is the fast path when input doesn't need to be split.
       output_tasks.push_back(std::move(*task));
@@ -798,10 +910,16 @@ void Queue<TaskType>::ProcessBatch(std::unique_ptr<Batch<TaskType>> batch) {
       [&batch] { return strings::StrCat("ProcessBatch:", batch->size()); },
       profiler::ContextType::kSharedBatchScheduler,
       batch->traceme_context_id());
+  const int batch_size = batch->size();
+  const uint64 start_time_micros = env_->NowMicros();
   process_batch_callback_(std::move(batch));
+  const uint64 end_time_micros = env_->NowMicros();
 
   {
     mutex_lock l(mu_);
+    if (options_.latency_slo_micros > 0) {
+      RecordProcessingLatency(batch_size, end_time_micros - start_time_micros);
+    }
     --num_batches_being_processed_;
     if (empty_notification_ != nullptr && IsEmptyInternal()) {
       empty_notification_->Notify();
@@ -860,9 +978,126 @@ bool Queue<TaskType>::IsOpenBatchSchedulable() const {
   if (open_batch->empty()) {
     return false;
   }
-  return closed_ || open_batch->size() >= max_execution_batch_size() ||
-         env_->NowMicros() >=
-             open_batch_start_time_micros_ + options_.batch_timeout_micros;
+  if (closed_ || open_batch->size() >= max_execution_batch_size()) {
+    return true;
+  }
+  const uint64 now_micros = env_->NowMicros();
+  if (now_micros >=
+      open_batch_start_time_micros_ + options_.batch_timeout_micros) {
+    return true;
+  }
+  return options_.latency_slo_micros > 0 &&
+         IsOpenBatchDueForLatencySlo(
+             open_batch->size(), now_micros - open_batch_start_time_micros_);
+}
+
+template <typename TaskType>
+bool Queue<TaskType>::IsOpenBatchDueForLatencySlo(int batch_size,
+                                                  int64 waited_micros) const {
+  const int64 latency_slo_micros = options_.latency_slo_micros;
+  // Waiting any longer would miss the target even without more tasks.
+  if (waited_micros + EstimatedProcessingMicros(batch_size) >=
+      latency_slo_micros) {
+    return true;
+  }
+  // A padded batch is filled up for free, so keep waiting.
+  if (RoundToAllowedBatchSize(batch_size) != batch_size ||
+      mean_interarrival_micros_ <= 0 || mean_task_size_ <= 0) {
+    return false;
+  }
+  const int next_batch_size = NextAllowedBatchSize(batch_size);
+  const double fill_micros = (next_batch_size - batch_size) *
+                             mean_interarrival_micros_ / mean_task_size_;
+  return waited_micros + fill_micros +
+             EstimatedProcessingMicros(next_batch_size) >
+         latency_slo_micros;
+}
+
+template <typename TaskType>
+int Queue<TaskType>::RoundToAllowedBatchSize(int batch_size) const {
+  for (const int32 allowed_batch_size : options_.allowed_batch_sizes) {
+    if (allowed_batch_size >= batch_size) {
+      return allowed_batch_size;
+    }
+  }
+  return batch_size;
+}
+
+template <typename TaskType>
+int Queue<TaskType>::NextAllowedBatchSize(int batch_size) const {
+  int next_batch_size = batch_size + 1;
+  for (const int32 allowed_batch_size : options_.allowed_batch_sizes) {
+    if (allowed_batch_size > batch_size) {
+      next_batch_size = allowed_batch_size;
+      break;
+    }
+  }
+  return std::min<int>(next_batch_size, max_execution_batch_size());
+}
+
+template <typename TaskType>
+int Queue<TaskType>::LatencyEstimateIndex(int batch_size) const {
+  const std::vector<int32>& allowed_batch_sizes = options_.allowed_batch_sizes;
+  for (int i = 0; i < allowed_batch_sizes.size(); ++i) {
+    if (allowed_batch_sizes[i] >= batch_size) {
+      return i;
+    }
+  }
+  // Larger than all the allowed batch sizes: use the largest one's estimate.
+  return latency_estimates_.size() - 1;
+}
+
+template <typename TaskType>
+int64 Queue<TaskType>::EstimatedProcessingMicros(int batch_size) const {
+  const LatencyEstimate& estimate =
+      latency_estimates_[LatencyEstimateIndex(batch_size)];
+  if (estimate.num_samples == 0) {
+    return 0;
+  }
+  // The 99th percentile of a normal distribution.
+  constexpr double kStandardDeviationsOf99thPercentile = 2.33;
+  return static_cast<int64>(
+      estimate.mean_micros +
+      kStandardDeviationsOf99thPercentile * std::sqrt(estimate.variance));
+}
+
+// The weight of a new sample in the exponentially weighted estimates of the
+// queue, which then follow the load over the last few tens of samples.
+constexpr double kLatencySloEstimateWeight = 0.1;
+
+template <typename TaskType>
+void Queue<TaskType>::RecordArrival(size_t task_size, uint64 now_micros) {
+  if (last_arrival_micros_ != 0) {
+    const double interarrival_micros = now_micros - last_arrival_micros_;
+    if (mean_task_size_ == 0) {
+      mean_interarrival_micros_ = interarrival_micros;
+      mean_task_size_ = task_size;
+    } else {
+      mean_interarrival_micros_ +=
+          kLatencySloEstimateWeight *
+          (interarrival_micros - mean_interarrival_micros_);
+      mean_task_size_ +=
+          kLatencySloEstimateWeight * (task_size - mean_task_size_);
+    }
+  }
+  last_arrival_micros_ = now_micros;
+}
+
+template <typename TaskType>
+void Queue<TaskType>::RecordProcessingLatency(int batch_size,
+                                              int64 latency_micros) {
+  LatencyEstimate& estimate =
+      latency_estimates_[LatencyEstimateIndex(batch_size)];
+  if (estimate.num_samples++ == 0) {
+    estimate.mean_micros = latency_micros;
+    return;
+  }
+  // Welford's update, with exponentially decaying weights.
+  const double delta = latency_micros - estimate.mean_micros;
+  estimate.mean_micros += kLatencySloEstimateWeight * delta;
+  estimate.variance = (1 - kLatencySloEstimateWeight) *
+                      (estimate.variance +
+                       kLatencySloEstimateWeight * delta * delta);
 }
 
 template <typename TaskType>
@@ -254,6 +254,138 @@ TEST(SharedBatchSchedulerTest, ObeysTimeout) {
   stop_teardown.Notify();
 }
 
+TEST(SharedBatchSchedulerTest, RejectsInvalidLatencySloOptions) {
+  auto callback = [](std::unique_ptr<Batch<FakeTask>> batch) {};
+  SharedBatchScheduler<FakeTask>::Options options;
+  options.num_batch_threads = 1;
+  std::shared_ptr<SharedBatchScheduler<FakeTask>> scheduler;
+  TF_ASSERT_OK(SharedBatchScheduler<FakeTask>::Create(options, &scheduler));
+  std::unique_ptr<BatchScheduler<FakeTask>> queue;
+
+  SharedBatchScheduler<FakeTask>::QueueOptions queue_options;
+  queue_options.input_batch_size_limit = 4;
+  queue_options.latency_slo_micros = -1;
+  EXPECT_EQ(error::INVALID_ARGUMENT,
+            scheduler->AddQueue(queue_options, callback, &queue).code());
+
+  queue_options.latency_slo_micros = 100;
+  for (const std::vector<int32>& allowed_batch_sizes :
+       std::vector<std::vector<int32>>{{0, 4}, {2, 2, 4}, {4, 2}, {2, 8}}) {
+    queue_options.allowed_batch_sizes = allowed_batch_sizes;
+    EXPECT_EQ(error::INVALID_ARGUMENT,
+              scheduler->AddQueue(queue_options, callback, &queue).code());
+  }
+
+  queue_options.allowed_batch_sizes = {2, 4};
+  TF_EXPECT_OK(scheduler->AddQueue(queue_options, callback, &queue));
+}
+
+TEST(SharedBatchSchedulerTest, LatencySloBoundsTimeout) {
+  test_util::FakeClockEnv env(Env::Default());
+  Notification start_teardown, stop_teardown;
+  std::unique_ptr<Thread> teardown_thread =
+      CreateFakeClockAdvancerThread(&env, &start_teardown, &stop_teardown);
+
+  {
+    Notification full_batch_processed, underfull_batch_processed;
+    auto callback = [&env, &full_batch_processed, &underfull_batch_processed](
+                        std::unique_ptr<Batch<FakeTask>> batch) {
+      ASSERT_TRUE(batch->IsClosed());
+      if (batch->size() == 4) {
+        // Takes 60 microseconds to process.
+        env.AdvanceByMicroseconds(60);
+        full_batch_processed.Notify();
+      } else if (batch->size() == 1) {
+        underfull_batch_processed.Notify();
+      } else {
+        EXPECT_TRUE(false) << "Unexpected batch size";
+      }
+    };
+
+    SharedBatchScheduler<FakeTask>::Options options;
+    options.num_batch_threads = 1;
+    options.env = &env;
+    std::shared_ptr<SharedBatchScheduler<FakeTask>> scheduler;
+    TF_ASSERT_OK(SharedBatchScheduler<FakeTask>::Create(options, &scheduler));
+    SharedBatchScheduler<FakeTask>::QueueOptions queue_options;
+    queue_options.input_batch_size_limit = 4;
+    queue_options.batch_timeout_micros = 10 * 1000;
+    queue_options.max_enqueued_batches = 2;
+    queue_options.allowed_batch_sizes = {4};
+    queue_options.latency_slo_micros = 100;
+    std::unique_ptr<BatchScheduler<FakeTask>> queue;
+    TF_ASSERT_OK(scheduler->AddQueue(queue_options, callback, &queue));
+
+    // Without any processed batch, the tasks wait for the target latency.
+    TF_ASSERT_OK(ScheduleTask(4, queue.get()));
+    full_batch_processed.WaitForNotification();
+
+    // The batches of 4 now take 60 microseconds to process, which leaves 40
+    // microseconds to a task padded to such a batch.
+    TF_ASSERT_OK(ScheduleTask(1, queue.get()));
+    env.AdvanceByMicroseconds(39);
+    Env::Default()->SleepForMicroseconds(10 * 1000 /* 10 milliseconds */);
+    EXPECT_FALSE(underfull_batch_processed.HasBeenNotified());
+    env.AdvanceByMicroseconds(1);
+    underfull_batch_processed.WaitForNotification();
+
+    start_teardown.Notify();
+  }
+  stop_teardown.Notify();
+}
+
+TEST(SharedBatchSchedulerTest, LatencySloClosesBatchesWithoutPadding) {
+  for (const int64 latency_slo_micros : {100, 1000}) {
+    test_util::FakeClockEnv env(Env::Default());
+    Notification start_teardown, stop_teardown;
+    std::unique_ptr<Thread> teardown_thread =
+        CreateFakeClockAdvancerThread(&env, &start_teardown, &stop_teardown);
+
+    {
+      Notification batch_processed;
+      auto callback =
+          [&batch_processed](std::unique_ptr<Batch<FakeTask>> batch) {
+            ASSERT_TRUE(batch->IsClosed());
+            EXPECT_EQ(2, batch->size());
+            batch_processed.Notify();
+          };
+
+      SharedBatchScheduler<FakeTask>::Options options;
+      options.num_batch_threads = 1;
+      options.env = &env;
+      std::shared_ptr<SharedBatchScheduler<FakeTask>> scheduler;
+      TF_ASSERT_OK(SharedBatchScheduler<FakeTask>::Create(options, &scheduler));
+      SharedBatchScheduler<FakeTask>::QueueOptions queue_options;
+      queue_options.input_batch_size_limit = 4;
+      queue_options.batch_timeout_micros = 10 * 1000;
+      queue_options.max_enqueued_batches = 2;
+      queue_options.allowed_batch_sizes = {2, 4};
+      queue_options.latency_slo_micros = latency_slo_micros;
+      std::unique_ptr<BatchScheduler<FakeTask>> queue;
+      TF_ASSERT_OK(scheduler->AddQueue(queue_options, callback, &queue));
+
+      // A task of size 1 arrives every 50 microseconds, so the batch of 2
+      // would only fill up to 4 after 150 microseconds.
+      TF_ASSERT_OK(ScheduleTask(1, queue.get()));
+      env.AdvanceByMicroseconds(50);
+      TF_ASSERT_OK(ScheduleTask(1, queue.get()));
+      Env::Default()->SleepForMicroseconds(10 * 1000 /* 10 milliseconds */);
+      if (latency_slo_micros == 100) {
+        // Which misses the target, so the batch of 2 is closed right away.
+        EXPECT_TRUE(batch_processed.HasBeenNotified());
+      } else {
+        // Which meets it, so the batch stays open until the target latency.
+        EXPECT_FALSE(batch_processed.HasBeenNotified());
+        env.AdvanceByMicroseconds(latency_slo_micros - 50);
+      }
+      batch_processed.WaitForNotification();
+
+      start_teardown.Notify();
+    }
+    stop_teardown.Notify();
+  }
+}
+
 TEST(SharedBatchSchedulerTest, ObeysTimeoutWithRealClock) {
   Notification first_batch_processed, second_batch_processed;
   auto callback = [&first_batch_processed, &second_batch_processed](
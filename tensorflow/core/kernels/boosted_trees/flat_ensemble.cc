@@ -0,0 +1,191 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/boosted_trees/flat_ensemble.h"
+
+#include <algorithm>
+
+#include "tensorflow/core/kernels/boosted_trees/boosted_trees.pb.h"
+#include "tensorflow/core/lib/core/errors.h"
+
+namespace tensorflow {
+
+constexpr int FlatTreeEnsemble::kBlockSize;
+
+Status FlatTreeEnsemble::Create(const boosted_trees::TreeEnsemble& ensemble,
+                                int32 logits_dimension,
+                                std::unique_ptr<FlatTreeEnsemble>* result) {
+  if (ensemble.tree_weights_size() < ensemble.trees_size()) {
+    return errors::InvalidArgument("The ensemble has ", ensemble.trees_size(),
+                                   " trees but ", ensemble.tree_weights_size(),
+                                   " tree weights.");
+  }
+  std::unique_ptr<FlatTreeEnsemble> flat(
+      new FlatTreeEnsemble(logits_dimension));
+  for (int32 tree_id = 0; tree_id < ensemble.trees_size(); ++tree_id) {
+    const auto& tree = ensemble.trees(tree_id);
+    const float weight = ensemble.tree_weights(tree_id);
+    const int32 base = flat->nodes_.size();
+    const int32 num_nodes = tree.nodes_size();
+    flat->roots_.push_back(num_nodes == 0 ? -1 : base);
+
+    for (int32 node_id = 0; node_id < num_nodes; ++node_id) {
+      const auto& node = tree.nodes(node_id);
+      Node flat_node;
+      int32 left_id = 0;
+      int32 right_id = 0;
+      switch (node.node_case()) {
+        case boosted_trees::Node::kLeaf: {
+          const auto& leaf = node.leaf();
+          const int32 num_values =
+              leaf.has_vector() ? leaf.vector().value_size() : 1;
+          if (num_values != logits_dimension) {
+            return errors::InvalidArgument(
+                "Leaf ", node_id, " of tree ", tree_id, " has ", num_values,
+                " values, expected ", logits_dimension, ".");
+          }
+          flat_node = {NodeType::kLeaf, 0, 0, 0,
+                       static_cast<int32>(flat->leaf_values_.size()), -1};
+          if (leaf.has_vector()) {
+            for (const float value : leaf.vector().value()) {
+              flat->leaf_values_.push_back(weight * value);
+            }
+          } else {
+            flat->leaf_values_.push_back(weight * leaf.scalar());
+          }
+          flat->nodes_.push_back(flat_node);
+          continue;
+        }
+        case boosted_trees::Node::kBucketizedSplit: {
+          const auto& split = node.bucketized_split();
+          flat_node = {NodeType::kBucketizedSplit, split.feature_id(),
+                       split.dimension_id(), split.threshold()};
+          left_id = split.left_id();
+          right_id = split.right_id();
+          break;
+        }
+        case boosted_trees::Node::kCategoricalSplit: {
+          const auto& split = node.categorical_split();
+          flat_node = {NodeType::kCategoricalSplit, split.feature_id(),
+                       split.dimension_id(), split.value()};
+          left_id = split.left_id();
+          right_id = split.right_id();
+          break;
+        }
+        default:
+          return errors::Unimplemented("Node ", node_id, " of tree ", tree_id,
+                                       " has type ", node.node_case(),
+                                       ", which prediction does not support.");
+      }
+      if (left_id < 0 || left_id >= num_nodes || right_id < 0 ||
+          right_id >= num_nodes) {
+        return errors::InvalidArgument("Node ", node_id, " of tree ", tree_id,
+                                       " has children out of range.");
+      }
+      if (flat_node.feature_id < 0 || flat_node.dimension_id < 0) {
+        return errors::InvalidArgument("Node ", node_id, " of tree ", tree_id,
+                                       " splits on a negative feature.");
+      }
+      flat_node.left = base + left_id;
+      flat_node.right = base + right_id;
+      flat->nodes_.push_back(flat_node);
+
+      auto& dimensions = flat->feature_dimensions_;
+      if (dimensions.size() <= flat_node.feature_id) {
+        dimensions.resize(flat_node.feature_id + 1, 0);
+      }
+      dimensions[flat_node.feature_id] = std::max(
+          dimensions[flat_node.feature_id], flat_node.dimension_id + 1);
+    }
+  }
+  *result = std::move(flat);
+  return Status::OK();
+}
+
+Status FlatTreeEnsemble::ValidateFeatures(
+    const std::vector<TTypes<int32>::ConstMatrix>& bucketized_features) const {
+  for (int32 feature_id = 0; feature_id < feature_dimensions_.size();
+       ++feature_id) {
+    const int32 num_dimensions = feature_dimensions_[feature_id];
+    if (num_dimensions == 0) continue;
+    if (feature_id >= bucketized_features.size()) {
+      return errors::InvalidArgument("The ensemble splits on feature ",
+                                     feature_id, " but only ",
+                                     bucketized_features.size(),
+                                     " bucketized features were given.");
+    }
+    if (bucketized_features[feature_id].dimension(1) < num_dimensions) {
+      return errors::InvalidArgument(
+          "The ensemble splits on dimension ", num_dimensions - 1,
+          " of feature ", feature_id, ", which has ",
+          bucketized_features[feature_id].dimension(1), " dimensions.");
+    }
+  }
+  return Status::OK();
+}
+
+void FlatTreeEnsemble::Predict(
+    const std::vector<TTypes<int32>::ConstMatrix>& bucketized_features,
+    int32 start, int32 end, float* logits) const {
+  // Raw rows of the features, which are cheaper to index than the maps.
+  struct Feature {
+    const int32* data;
+    int64 num_dimensions;
+  };
+  std::vector<Feature> features;
+  features.reserve(bucketized_features.size());
+  for (const auto& feature : bucketized_features) {
+    features.push_back({feature.data(), feature.dimension(1)});
+  }
+
+  const int32 dim = logits_dimension_;
+  std::fill(logits + start * dim, logits + end * dim, 0.0f);
+  int32 current[kBlockSize];
+  for (int32 block = start; block < end; block += kBlockSize) {
+    const int32 size = std::min(kBlockSize, end - block);
+    for (const int32 root : roots_) {
+      if (root < 0) continue;
+      std::fill_n(current, size, root);
+      // Every example of the block goes down one level per pass until all
+      // of them reached a leaf.
+      bool done = false;
+      while (!done) {
+        done = true;
+        for (int32 i = 0; i < size; ++i) {
+          const Node& node = nodes_[current[i]];
+          if (node.type == NodeType::kLeaf) continue;
+          done = false;
+          const Feature& feature = features[node.feature_id];
+          const int32 value =
+              feature.data[(block + i) * feature.num_dimensions +
+                           node.dimension_id];
+          const bool go_left = node.type == NodeType::kBucketizedSplit
+                                   ? value <= node.threshold
+                                   : value == node.threshold;
+          current[i] = go_left ? node.left : node.right;
+        }
+      }
+      for (int32 i = 0; i < size; ++i) {
+        const float* values = &leaf_values_[nodes_[current[i]].left];
+        float* example_logits = logits + (block + i) * dim;
+        for (int32 j = 0; j < dim; ++j) {
+          example_logits[j] += values[j];
+        }
+      }
+    }
+  }
+}
+
+}  // namespace tensorflow
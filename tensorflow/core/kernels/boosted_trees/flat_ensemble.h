@@ -0,0 +1,95 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_KERNELS_BOOSTED_TREES_FLAT_ENSEMBLE_H_
+#define TENSORFLOW_CORE_KERNELS_BOOSTED_TREES_FLAT_ENSEMBLE_H_
+
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/framework/tensor_types.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+namespace boosted_trees {
+class TreeEnsemble;
+}  // namespace boosted_trees
+
+// A tree ensemble flattened for inference.
+//
+// The nodes of all trees are stored in one array of small fixed-size records
+// whose children are absolute indices, and the leaf values, already scaled by
+// the weights of their trees, in another. Examples are traversed in blocks:
+// every tree is walked by all examples of a block in lockstep, so that the
+// loads of the nodes of different examples overlap instead of each example
+// waiting on its own chain of nodes.
+class FlatTreeEnsemble {
+ public:
+  // Flattens `ensemble`, whose leaves must hold `logits_dimension` values.
+  static Status Create(const boosted_trees::TreeEnsemble& ensemble,
+                       int32 logits_dimension,
+                       std::unique_ptr<FlatTreeEnsemble>* result);
+
+  int32 num_trees() const { return roots_.size(); }
+  int32 logits_dimension() const { return logits_dimension_; }
+
+  // Checks that the splits only read features and dimensions that exist in
+  // `bucketized_features`.
+  Status ValidateFeatures(
+      const std::vector<TTypes<int32>::ConstMatrix>& bucketized_features)
+      const;
+
+  // Sets row i of `logits`, a [batch_size, logits_dimension] row-major
+  // matrix, to the sum of the weighted leaf values reached by example i, for
+  // the examples in [start, end). The features must have been validated.
+  void Predict(
+      const std::vector<TTypes<int32>::ConstMatrix>& bucketized_features,
+      int32 start, int32 end, float* logits) const;
+
+ private:
+  enum class NodeType : int32 { kLeaf, kBucketizedSplit, kCategoricalSplit };
+
+  // A split sends the examples whose feature equals (categorical) or is at
+  // most (bucketized) `threshold` to `left` and the others to `right`. A leaf
+  // has its values at `left` in `leaf_values_`.
+  struct Node {
+    NodeType type;
+    int32 feature_id;
+    int32 dimension_id;
+    int32 threshold;
+    int32 left;
+    int32 right;
+  };
+
+  // The number of examples that walk the trees together.
+  static constexpr int kBlockSize = 16;
+
+  explicit FlatTreeEnsemble(int32 logits_dimension)
+      : logits_dimension_(logits_dimension) {}
+
+  const int32 logits_dimension_;
+  std::vector<Node> nodes_;
+  std::vector<float> leaf_values_;
+  // The index of the root node of each tree, or -1 for empty trees.
+  std::vector<int32> roots_;
+  // The number of dimensions read from each feature.
+  std::vector<int32> feature_dimensions_;
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_BOOSTED_TREES_FLAT_ENSEMBLE_H_
@@ -0,0 +1,126 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/boosted_trees/flat_ensemble.h"
+
+#include <vector>
+
+#include "tensorflow/core/kernels/boosted_trees/boosted_trees.pb.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/protobuf.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+// Tree 0 sends feature 0 <= 5 to leaf 1 and the others to a split on
+// dimension 1 of feature 1 == 3. Tree 1 is a single leaf.
+constexpr char kEnsemble[] = R"(
+  trees {
+    nodes {
+      bucketized_split { feature_id: 0 threshold: 5 left_id: 1 right_id: 2 }
+    }
+    nodes { leaf { scalar: 1.0 } }
+    nodes {
+      categorical_split {
+        feature_id: 1 dimension_id: 1 value: 3 left_id: 3 right_id: 4
+      }
+    }
+    nodes { leaf { scalar: 2.0 } }
+    nodes { leaf { scalar: 3.0 } }
+  }
+  trees { nodes { leaf { scalar: 10.0 } } }
+  tree_weights: 1.0
+  tree_weights: 0.5
+)";
+
+boosted_trees::TreeEnsemble ParseEnsemble(const char* text) {
+  boosted_trees::TreeEnsemble ensemble;
+  CHECK(protobuf::TextFormat::ParseFromString(text, &ensemble));
+  return ensemble;
+}
+
+TEST(FlatTreeEnsembleTest, PredictsWeightedLeaves) {
+  std::unique_ptr<FlatTreeEnsemble> flat;
+  TF_ASSERT_OK(FlatTreeEnsemble::Create(ParseEnsemble(kEnsemble), 1, &flat));
+  EXPECT_EQ(2, flat->num_trees());
+
+  // More examples than a block.
+  const int kBatchSize = 40;
+  std::vector<int32> feature_0(kBatchSize);
+  std::vector<int32> feature_1(kBatchSize * 2);
+  for (int i = 0; i < kBatchSize; ++i) {
+    feature_0[i] = i % 10;
+    feature_1[2 * i + 1] = i % 4;
+  }
+  std::vector<TTypes<int32>::ConstMatrix> features;
+  features.emplace_back(feature_0.data(), kBatchSize, 1);
+  features.emplace_back(feature_1.data(), kBatchSize, 2);
+  TF_ASSERT_OK(flat->ValidateFeatures(features));
+
+  std::vector<float> logits(kBatchSize, -1);
+  flat->Predict(features, 3, kBatchSize, logits.data());
+  for (int i = 0; i < kBatchSize; ++i) {
+    float expected = -1;
+    if (i >= 3) {
+      expected = feature_0[i] <= 5 ? 1 : (feature_1[2 * i + 1] == 3 ? 2 : 3);
+      expected += 5;
+    }
+    EXPECT_EQ(expected, logits[i]) << "example " << i;
+  }
+}
+
+TEST(FlatTreeEnsembleTest, PredictsVectorLeaves) {
+  std::unique_ptr<FlatTreeEnsemble> flat;
+  TF_ASSERT_OK(FlatTreeEnsemble::Create(ParseEnsemble(R"(
+    trees {
+      nodes {
+        bucketized_split { feature_id: 0 threshold: 0 left_id: 1 right_id: 2 }
+      }
+      nodes { leaf { vector { value: 1 value: 2 } } }
+      nodes { leaf { vector { value: 3 value: 4 } } }
+    }
+    tree_weights: 2.0
+  )"),
+                                        2, &flat));
+  const std::vector<int32> feature = {0, 1};
+  std::vector<TTypes<int32>::ConstMatrix> features;
+  features.emplace_back(feature.data(), 2, 1);
+  std::vector<float> logits(4);
+  flat->Predict(features, 0, 2, logits.data());
+  EXPECT_EQ(std::vector<float>({2, 4, 6, 8}), logits);
+}
+
+TEST(FlatTreeEnsembleTest, RejectsMissingFeatures) {
+  std::unique_ptr<FlatTreeEnsemble> flat;
+  TF_ASSERT_OK(FlatTreeEnsemble::Create(ParseEnsemble(kEnsemble), 1, &flat));
+  const std::vector<int32> feature(4);
+  std::vector<TTypes<int32>::ConstMatrix> features;
+  features.emplace_back(feature.data(), 4, 1);
+  EXPECT_TRUE(errors::IsInvalidArgument(flat->ValidateFeatures(features)));
+  // Feature 1 lacks the dimension the categorical split reads.
+  features.emplace_back(feature.data(), 4, 1);
+  EXPECT_TRUE(errors::IsInvalidArgument(flat->ValidateFeatures(features)));
+}
+
+TEST(FlatTreeEnsembleTest, RejectsLeavesOfWrongDimension) {
+  std::unique_ptr<FlatTreeEnsemble> flat;
+  EXPECT_TRUE(errors::IsInvalidArgument(
+      FlatTreeEnsemble::Create(ParseEnsemble(kEnsemble), 2, &flat)));
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -14,6 +14,7 @@ limitations under the License.
 ==============================================================================*/
 
 #include <algorithm>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -24,6 +25,7 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/kernels/boosted_trees/boosted_trees.pb.h"
+#include "tensorflow/core/kernels/boosted_trees/flat_ensemble.h"
 #include "tensorflow/core/kernels/boosted_trees/resources.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/refcount.h"
@@ -235,42 +237,23 @@ class BoostedTreesPredictOp : public OpKernel {
       return;
     }
 
-    const int32 last_tree = resource->num_trees() - 1;
-    auto do_work = [&resource, &bucketized_features, &output_logits, last_tree,
-                    this](int32 start, int32 end) {
-      for (int32 i = start; i < end; ++i) {
-        std::vector<float> tree_logits(logits_dimension_, 0.0);
-        int32 tree_id = 0;
-        int32 node_id = 0;
-        while (true) {
-          if (resource->is_leaf(tree_id, node_id)) {
-            const float tree_weight = resource->GetTreeWeight(tree_id);
-            const auto& leaf_logits = resource->node_value(tree_id, node_id);
-            DCHECK_EQ(leaf_logits.size(), logits_dimension_);
-            for (int32 j = 0; j < logits_dimension_; ++j) {
-              tree_logits[j] += tree_weight * leaf_logits[j];
-            }
-            // Stop if it was the last tree.
-            if (tree_id == last_tree) {
-              break;
-            }
-            // Move onto other trees.
-            ++tree_id;
-            node_id = 0;
-          } else {
-            node_id =
-                resource->next_node(tree_id, node_id, i, bucketized_features);
-          }
-        }
-        for (int32 j = 0; j < logits_dimension_; ++j) {
-          output_logits(i, j) = tree_logits[j];
-        }
-      }
+    // The ensemble is walked in its flat form, which is rebuilt only when the
+    // ensemble changes.
+    std::shared_ptr<const FlatTreeEnsemble> flat_ensemble;
+    OP_REQUIRES_OK(context, resource->GetFlatEnsemble(logits_dimension_,
+                                                      &flat_ensemble));
+    OP_REQUIRES_OK(context,
+                   flat_ensemble->ValidateFeatures(bucketized_features));
+
+    float* logits = output_logits.data();
+    auto do_work = [&flat_ensemble, &bucketized_features, logits](int32 start,
+                                                                  int32 end) {
+      flat_ensemble->Predict(bucketized_features, start, end, logits);
     };
     // 10 is the magic number. The actual number might depend on (the number of
     // layers in the trees) and (cpu cycles spent on each layer), but this
     // value would work for many cases. May be tuned later.
-    const int64 cost = (last_tree + 1) * 10;
+    const int64 cost = flat_ensemble->num_trees() * 10;
     thread::ThreadPool* const worker_threads =
         context->device()->tensorflow_cpu_worker_threads()->workers;
     Shard(worker_threads->NumThreads(), worker_threads, batch_size,
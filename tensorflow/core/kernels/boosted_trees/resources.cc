@@ -206,6 +206,28 @@ std::vector<float> BoostedTreesEnsembleResource::GetTreeWeights() const {
           tree_ensemble_->tree_weights().end()};
 }
 
+Status BoostedTreesEnsembleResource::GetFlatEnsemble(
+    const int32 logits_dimension,
+    std::shared_ptr<const FlatTreeEnsemble>* result) {
+  // The ops that change the ensemble hold the mutex exclusively and change
+  // the stamp.
+  tf_shared_lock l(mu_);
+  mutex_lock flat_lock(flat_mu_);
+  if (flat_ensemble_ == nullptr || flat_stamp_ != stamp() ||
+      flat_num_resets_ != num_resets_ ||
+      flat_logits_dimension_ != logits_dimension) {
+    std::unique_ptr<FlatTreeEnsemble> flat_ensemble;
+    TF_RETURN_IF_ERROR(FlatTreeEnsemble::Create(
+        *tree_ensemble_, logits_dimension, &flat_ensemble));
+    flat_ensemble_ = std::move(flat_ensemble);
+    flat_stamp_ = stamp();
+    flat_num_resets_ = num_resets_;
+    flat_logits_dimension_ = logits_dimension;
+  }
+  *result = flat_ensemble_;
+  return Status::OK();
+}
+
 float BoostedTreesEnsembleResource::GetTreeWeight(const int32 tree_id) const {
   return tree_ensemble_->tree_weights(tree_id);
 }
@@ -369,6 +391,7 @@ boosted_trees::Node* BoostedTreesEnsembleResource::AddLeafNodes(
 void BoostedTreesEnsembleResource::Reset() {
   // Reset stamp.
   set_stamp(-1);
+  ++num_resets_;
 
   // Clear tree ensemle.
   arena_.Reset();
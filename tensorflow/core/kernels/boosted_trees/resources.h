@@ -16,7 +16,10 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_KERNELS_BOOSTED_TREES_RESOURCES_H_
 #define TENSORFLOW_CORE_KERNELS_BOOSTED_TREES_RESOURCES_H_
 
+#include <memory>
+
 #include "tensorflow/core/framework/resource_mgr.h"
+#include "tensorflow/core/kernels/boosted_trees/flat_ensemble.h"
 #include "tensorflow/core/kernels/boosted_trees/tree_helper.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/protobuf.h"
@@ -150,6 +153,14 @@ class BoostedTreesEnsembleResource : public StampedResource {
   void GetPostPruneCorrection(const int32 tree_id, const int32 initial_node_id,
                               int32* current_node_id,
                               std::vector<float>* logit_updates) const;
+
+  // Returns the ensemble flattened for inference with `logits_dimension`
+  // values per leaf. The flat ensemble is cached and flattened again only
+  // after the stamp changed or the ensemble was reset. Must be called without
+  // holding the mutex.
+  Status GetFlatEnsemble(int32 logits_dimension,
+                         std::shared_ptr<const FlatTreeEnsemble>* result);
+
   mutex* get_mutex() { return &mu_; }
 
  private:
@@ -171,6 +182,18 @@ class BoostedTreesEnsembleResource : public StampedResource {
       std::vector<int32>* nodes_to_delete,
       std::vector<std::pair<int32, std::vector<float>>>* nodes_meta);
 
+  // Counts the resets, which may keep the stamp.
+  int64 num_resets_ = 0;
+
+  mutex flat_mu_;
+  std::shared_ptr<const FlatTreeEnsemble> flat_ensemble_
+      TF_GUARDED_BY(flat_mu_);
+  // The stamp, number of resets and logits dimension `flat_ensemble_` was
+  // flattened for.
+  int64 flat_stamp_ TF_GUARDED_BY(flat_mu_) = -1;
+  int64 flat_num_resets_ TF_GUARDED_BY(flat_mu_) = -1;
+  int32 flat_logits_dimension_ TF_GUARDED_BY(flat_mu_) = -1;
+
  protected:
   protobuf::Arena arena_;
   mutex mu_;
@@ -207,6 +207,12 @@ class CollectiveReduceOpKernel : public CollectiveOpKernel {
     OP_REQUIRES_OK(
         c, c->GetAttr("timeout_seconds",
                       &col_params_.instance.impl_details.timeout_seconds));
+    // Optional priority set from Python to order launches when the executor
+    // bounds the number of concurrent reductions.
+    if (HasNodeAttr(c->def(), "_collective_priority")) {
+      OP_REQUIRES_OK(c, c->GetAttr("_collective_priority",
+                                   &col_params_.launch_priority));
+    }
     VLOG(2) << "CollectiveReduce instance " << col_params_.instance.instance_key
             << " merge_op " << merge_op_name << " final_op " << final_op_name
             << " communication_hint "
@@ -228,6 +234,30 @@ class CollectiveReduceOpKernel : public CollectiveOpKernel {
                  &(*sub_node.mutable_attr())["T"]);
     col_params_.merge_op = BuildOpKernel(c, merge_op_name, &sub_node);
     col_params_.final_op = BuildOpKernel(c, final_op_name, &sub_node);
+
+    string compression;
+    OP_REQUIRES_OK(c, c->GetAttr("compression", &compression));
+    if (compression != "none") {
+      const DataType data_type = col_params_.instance.data_type;
+      OP_REQUIRES(c, data_type == DT_FLOAT || data_type == DT_DOUBLE,
+                  errors::InvalidArgument(
+                      "compression ", compression,
+                      " requires a float or double input but got ",
+                      DataTypeString(data_type)));
+      const DataType wire_type =
+          (compression == "fp16") ? DT_HALF : DT_BFLOAT16;
+      NodeDef cast_node;
+      cast_node.add_input(real_node.input(0));
+      cast_node.set_device(real_node.device());
+      auto* attr = cast_node.mutable_attr();
+      SetAttrValue(false, &(*attr)["Truncate"]);
+      SetAttrValue(data_type, &(*attr)["SrcT"]);
+      SetAttrValue(wire_type, &(*attr)["DstT"]);
+      col_params_.encode_op = BuildOpKernel(c, "Cast", &cast_node);
+      SetAttrValue(wire_type, &(*attr)["SrcT"]);
+      SetAttrValue(data_type, &(*attr)["DstT"]);
+      col_params_.decode_op = BuildOpKernel(c, "Cast", &cast_node);
+    }
   }
 
   void ComputeAsync(OpKernelContext* c, DoneCallback done) override {
@@ -38,6 +38,7 @@ limitations under the License.
 #include "tensorflow/core/graph/graph_node_util.h"
 #include "tensorflow/core/kernels/fill_functor.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/util/tensor_bundle/shared_tensor_store.h"
 
 #ifdef TENSORFLOW_USE_SYCL
 #include "tensorflow/core/common_runtime/sycl/sycl_util.h"
@@ -85,6 +86,11 @@ ConstantOp::ConstantOp(OpKernelConstruction* ctx)
       errors::InvalidArgument("Type mismatch between value (",
                               DataTypeString(tensor_.dtype()), ") and dtype (",
                               DataTypeString(ctx->output_type(0)), ")"));
+  // Constants are never written, so the host ones can share their buffers
+  // with the equal constants of other sessions.
+  if (ctx->device_type() == DEVICE_CPU && SharedTensorStore::IsEnabled()) {
+    tensor_ = SharedTensorStore::Global()->Share(tensor_);
+  }
 }
 
 void ConstantOp::Compute(OpKernelContext* ctx) {
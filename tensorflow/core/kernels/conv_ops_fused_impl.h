@@ -219,6 +219,11 @@ struct LaunchFusedConv2DOp<CPUDevice, T> {
         conv2d(WithBiasAddAndElu<T>(bias_add_args), context, input, filter,
                output);
         break;
+      case FusedComputationType::kBiasAddWithElementwiseChain:
+        conv2d(WithBiasAddAndElementwiseChain<T>(bias_add_args,
+                                                 fusion_args.elementwise_chain),
+               context, input, filter, output);
+        break;
       case FusedComputationType::kFusedBatchNorm:
         conv2d(
             WithFusedBatchNorm<T>(fusion_args.epsilon, fused_batch_norm_args),
@@ -686,6 +691,7 @@ class FusedConv2DOp : public OpKernel {
           {FCT::kFusedBatchNormWithRelu, {"FusedBatchNorm", "Relu"}},
           {FCT::kFusedBatchNormWithRelu6, {"FusedBatchNorm", "Relu6"}},
           {FCT::kFusedBatchNormWithElu, {"FusedBatchNorm", "Elu"}},
+          {FCT::kBiasAddWithElementwiseChain, {"BiasAdd"}},
       };
     }
 
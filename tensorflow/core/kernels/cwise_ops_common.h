@@ -34,6 +34,7 @@ limitations under the License.
 #include "tensorflow/core/framework/variant_op_registry.h"
 #include "tensorflow/core/kernels/cwise_ops.h"
 #include "tensorflow/core/kernels/cwise_ops_gradients.h"
+#include "tensorflow/core/kernels/cwise_ops_upcast.h"
 #include "tensorflow/core/kernels/fill_functor.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/util/bcast.h"
@@ -601,14 +602,28 @@ struct BinaryFunctor<CPUDevice, Functor, NDIMS, true> {
 };
 
 // Partial specialization of UnaryFunctor<Device=CPUDevice, Functor>.
-template <typename Functor>
-struct UnaryFunctor<CPUDevice, Functor> {
+template <typename Functor, bool upcast = UpcastToFloat<Functor>::value>
+struct UnaryFunctorCPU {
   void operator()(const CPUDevice& d, typename Functor::tout_type out,
                   typename Functor::tin_type in) {
     Assign(d, out, in.unaryExpr(typename Functor::func()));
   }
 };
 
+// Transcendental functions on Eigen::half and bfloat16 are evaluated in
+// float, see cwise_ops_upcast.h.
+template <typename Functor>
+struct UnaryFunctorCPU<Functor, true> {
+  void operator()(const CPUDevice& d, typename Functor::tout_type out,
+                  typename Functor::tin_type in) {
+    UpcastUnaryApply<typename Functor::in_type,
+                     typename UpcastToFloat<Functor>::type>(d, out, in);
+  }
+};
+
+template <typename Functor>
+struct UnaryFunctor<CPUDevice, Functor> : UnaryFunctorCPU<Functor> {};
+
 // Partial specialization of ApproximateEqual<Device=CPUDevice, T>.
 template <typename T>
 struct ApproximateEqual<CPUDevice, T> {
@@ -95,6 +95,22 @@ BM_UNARY(cpu, Round, float, DT_FLOAT);
 BM_UNARY(gpu, Round, float, DT_FLOAT);
 #endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
 
+// Transcendental functions, which are evaluated in float for the 16 bit types.
+BM_UNARY(cpu, Exp, float, DT_FLOAT);
+BM_UNARY(cpu, Exp, Eigen::half, DT_HALF);
+BM_UNARY(cpu, Exp, bfloat16, DT_BFLOAT16);
+BM_UNARY(cpu, Log, float, DT_FLOAT);
+BM_UNARY(cpu, Log, Eigen::half, DT_HALF);
+BM_UNARY(cpu, Log, bfloat16, DT_BFLOAT16);
+BM_UNARY(cpu, Tanh, float, DT_FLOAT);
+BM_UNARY(cpu, Tanh, Eigen::half, DT_HALF);
+BM_UNARY(cpu, Tanh, bfloat16, DT_BFLOAT16);
+BM_UNARY(cpu, Sigmoid, float, DT_FLOAT);
+BM_UNARY(cpu, Sigmoid, Eigen::half, DT_HALF);
+BM_UNARY(cpu, Sigmoid, bfloat16, DT_BFLOAT16);
+BM_UNARY(cpu, Erf, float, DT_FLOAT);
+BM_UNARY(cpu, Erf, Eigen::half, DT_HALF);
+
 // data func scalar.
 Graph* BinaryScalar(int num, const string& func) {
   Graph* g = new Graph(OpRegistry::Global());
@@ -0,0 +1,111 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_KERNELS_CWISE_OPS_UPCAST_H_
+#define TENSORFLOW_CORE_KERNELS_CWISE_OPS_UPCAST_H_
+
+#define EIGEN_USE_THREADS
+
+#include <algorithm>
+
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/core/framework/tensor_types.h"
+#include "tensorflow/core/kernels/cwise_ops.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace functor {
+
+// Eigen evaluates most transcendental functions on Eigen::half and bfloat16
+// one element at a time, converting every element to float and back. The
+// unary functors listed below are instead evaluated on CPU in blocks: every
+// block is converted to float, the float functor is applied with the
+// vectorized packet math of Eigen (SSE, AVX, AVX-512 or NEON, whichever the
+// kernels are compiled for), and the results are rounded back.
+//
+// The float polynomial approximations of Eigen are accurate to a few float
+// ulps, far below the precision of the 16 bit types, so the results are
+// within one ulp of the 16 bit type of the correctly rounded value, as with
+// the scalar conversions.
+//
+// `UpcastToFloat<Functor>::value` is true if Functor is evaluated this way,
+// and `UpcastToFloat<Functor>::type` is then its float version.
+template <typename Functor>
+struct UpcastToFloat {
+  static constexpr bool value = false;
+};
+
+#define UPCAST_TO_FLOAT(F)                      \
+  template <>                                   \
+  struct UpcastToFloat<F<Eigen::half>> {        \
+    static constexpr bool value = true;         \
+    typedef F<float> type;                      \
+  };                                            \
+  template <>                                   \
+  struct UpcastToFloat<F<bfloat16>> {           \
+    static constexpr bool value = true;         \
+    typedef F<float> type;                      \
+  };
+
+UPCAST_TO_FLOAT(exp);
+UPCAST_TO_FLOAT(expm1);
+UPCAST_TO_FLOAT(log);
+UPCAST_TO_FLOAT(log1p);
+UPCAST_TO_FLOAT(tanh);
+UPCAST_TO_FLOAT(sigmoid);
+UPCAST_TO_FLOAT(erf);
+UPCAST_TO_FLOAT(erfc);
+UPCAST_TO_FLOAT(sqrt);
+UPCAST_TO_FLOAT(rsqrt);
+UPCAST_TO_FLOAT(sin);
+UPCAST_TO_FLOAT(cos);
+#undef UPCAST_TO_FLOAT
+
+// Computes out = FloatFunctor(in) for T = Eigen::half or bfloat16 on the
+// threads of `d`. `out` may alias `in`.
+template <typename T, typename FloatFunctor>
+void UpcastUnaryApply(const Eigen::ThreadPoolDevice& d,
+                      typename TTypes<T>::Flat out,
+                      typename TTypes<T>::ConstFlat in) {
+  // A block of floats stays in L1.
+  constexpr int64 kBlockSize = 1024;
+  using FloatFunc = typename FloatFunctor::func;
+  const int64 size = in.size();
+  const int64 num_blocks = (size + kBlockSize - 1) / kBlockSize;
+  const Eigen::TensorOpCost cost(
+      kBlockSize * sizeof(T), kBlockSize * sizeof(T),
+      kBlockSize * (Eigen::internal::functor_traits<FloatFunc>::Cost + 2));
+
+  d.parallelFor(num_blocks, cost, [&](Eigen::Index first, Eigen::Index last) {
+    EIGEN_ALIGN_MAX float buffer[kBlockSize];
+    for (Eigen::Index b = first; b < last; ++b) {
+      const int64 start = b * kBlockSize;
+      const int64 n = std::min(kBlockSize, size - start);
+      typename TTypes<float>::Flat values(buffer, n);
+      // Three separate assignments, so that the float one is vectorized even
+      // when the conversions are not.
+      values = typename TTypes<T>::ConstFlat(in.data() + start, n)
+                   .template cast<float>();
+      values = values.unaryExpr(FloatFunc());
+      typename TTypes<T>::Flat(out.data() + start, n) =
+          values.template cast<T>();
+    }
+  });
+}
+
+}  // namespace functor
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_CWISE_OPS_UPCAST_H_
@@ -44,6 +44,24 @@ namespace data {
 constexpr char kInputImplEmpty[] = "input_impl_empty";
 constexpr char kBatchDataset[] = "BatchDataset";
 
+// Batches of up to this many elements may be allocated before the elements
+// are produced. Larger batch sizes are typically used to stack a whole
+// dataset, and would allocate far more memory than the dataset needs.
+constexpr int64 kMaxPreallocatedBatchSize = 1 << 16;
+
+// Returns true if the batches of `input` can be allocated before their
+// elements are produced without holding much more memory than needed, i.e.
+// if at most one batch per epoch is partial.
+bool CanPreallocateBatches(const DatasetBase* input, int64 batch_size,
+                           bool drop_remainder, bool parallel_copy) {
+  if (parallel_copy || batch_size > kMaxPreallocatedBatchSize) {
+    return false;
+  }
+  const int64 cardinality = input->Cardinality();
+  return drop_remainder || cardinality == kInfiniteCardinality ||
+         cardinality >= batch_size;
+}
+
 class BatchDatasetOp::Dataset : public DatasetBase {
  public:
   Dataset(OpKernelContext* ctx, int64 batch_size, bool drop_remainder,
@@ -58,6 +76,8 @@ class BatchDatasetOp::Dataset : public DatasetBase {
                                      : std::min<int64>(batch_size, 1 << 16)),
         drop_remainder_(drop_remainder),
         parallel_copy_(parallel_copy),
+        preallocate_(CanPreallocateBatches(input, batch_size, drop_remainder,
+                                           parallel_copy)),
         input_(input),
         op_version_(op_version),
         traceme_metadata_(
@@ -151,6 +171,10 @@ class BatchDatasetOp::Dataset : public DatasetBase {
     Status GetNextInternal(IteratorContext* ctx,
                            std::vector<Tensor>* out_tensors,
                            bool* end_of_sequence) override {
+      if (dataset()->preallocate_) {
+        mutex_lock l(mu_);
+        return GetNextIntoBatch(ctx, out_tensors, end_of_sequence);
+      }
       // Each row of `batch_elements` is a tuple of tensors from the
       // input iterator.
       std::vector<std::vector<Tensor>> batch_elements;
@@ -188,11 +212,6 @@ class BatchDatasetOp::Dataset : public DatasetBase {
       // Copy the retrieved batch elements into one output tensor per tuple
       // component.
       //
-      // NOTE(mrry): If the input or output sizes are statically known, we
-      // could potentially read the input values in-place into their
-      // respective slice locations. This would require a different GetNext()
-      // overload that supports zero-copy, and might make sense in an
-      // optimization pass.
       const size_t num_tuple_components = batch_elements[0].size();
       out_tensors->reserve(num_tuple_components);
       const int64 num_batch_elements = batch_elements.size();
@@ -291,6 +310,120 @@ class BatchDatasetOp::Dataset : public DatasetBase {
     }
 
    private:
+    // Copies each input element into one preallocated tensor per tuple
+    // component as soon as the element is produced, instead of holding on
+    // to the whole batch of elements and copying them at the end. The
+    // element buffers are then released, and can be reused upstream, while
+    // they are still hot in cache, and the memory for a batch is never held
+    // twice. A partial final batch is a slice of the preallocated tensors.
+    Status GetNextIntoBatch(IteratorContext* ctx,
+                            std::vector<Tensor>* out_tensors,
+                            bool* end_of_sequence)
+        TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      if (!input_impl_) {
+        *end_of_sequence = true;
+        return Status::OK();
+      }
+      std::vector<Tensor> batch;
+      std::vector<TensorShape> element_shapes;
+      // Elements are consumed up to the end of the batch even after a copy
+      // fails, so that the iterator advances as if they had been batched.
+      Status status;
+      int64 num_batch_elements = 0;
+      *end_of_sequence = false;
+      while (num_batch_elements < dataset()->batch_size_) {
+        std::vector<Tensor> batch_element_tuple;
+        TF_RETURN_IF_ERROR(
+            input_impl_->GetNext(ctx, &batch_element_tuple, end_of_sequence));
+        if (*end_of_sequence) {
+          input_impl_.reset();
+          break;
+        }
+        if (status.ok() && num_batch_elements == 0) {
+          status = AllocateBatch(ctx, batch_element_tuple, &batch,
+                                 &element_shapes);
+        }
+        if (status.ok()) {
+          status = CopyElementToBatch(std::move(batch_element_tuple),
+                                      num_batch_elements, element_shapes,
+                                      &batch);
+        }
+        ++num_batch_elements;
+      }
+
+      if (num_batch_elements == 0) {
+        DCHECK(*end_of_sequence);
+        return Status::OK();
+      }
+
+      if (dataset()->drop_remainder_ &&
+          num_batch_elements < dataset()->batch_size_) {
+        *end_of_sequence = true;
+        return Status::OK();
+      }
+      TF_RETURN_IF_ERROR(status);
+
+      out_tensors->reserve(batch.size());
+      for (Tensor& batch_component : batch) {
+        out_tensors->push_back(
+            num_batch_elements < dataset()->batch_size_
+                ? batch_component.Slice(0, num_batch_elements)
+                : std::move(batch_component));
+      }
+      *end_of_sequence = false;
+      return Status::OK();
+    }
+
+    // Allocates one tensor of `batch_size_` rows of the shape of each
+    // component of `first_element`.
+    Status AllocateBatch(IteratorContext* ctx,
+                         const std::vector<Tensor>& first_element,
+                         std::vector<Tensor>* batch,
+                         std::vector<TensorShape>* element_shapes) {
+      batch->reserve(first_element.size());
+      element_shapes->reserve(first_element.size());
+      for (size_t component_index = 0; component_index < first_element.size();
+           ++component_index) {
+        const Tensor& component = first_element[component_index];
+        element_shapes->push_back(component.shape());
+        TensorShape batch_component_shape({dataset()->batch_size_});
+        batch_component_shape.AppendShape(component.shape());
+        batch->emplace_back(ctx->allocator({}), component.dtype(),
+                            batch_component_shape);
+        if (!batch->back().IsInitialized()) {
+          return errors::ResourceExhausted(
+              "Failed to allocate memory for the batch of component ",
+              component_index);
+        }
+      }
+      return Status::OK();
+    }
+
+    // Copies the components of the `index`-th element of the batch into
+    // `batch`, after checking that they have `element_shapes`.
+    Status CopyElementToBatch(std::vector<Tensor> element, int64 index,
+                              const std::vector<TensorShape>& element_shapes,
+                              std::vector<Tensor>* batch) {
+      for (size_t component_index = 0; component_index < element.size();
+           ++component_index) {
+        const TensorShape& first_element_shape =
+            element_shapes[component_index];
+        if (element[component_index].shape() != first_element_shape) {
+          return errors::InvalidArgument(
+              "Cannot batch tensors with different shapes in "
+              "component ",
+              component_index, ". First element had shape ",
+              first_element_shape.DebugString(), " and element ", index,
+              " had shape ", element[component_index].shape().DebugString(),
+              ".");
+        }
+        TF_RETURN_IF_ERROR(batch_util::CopyElementToSlice(
+            std::move(element[component_index]), &(*batch)[component_index],
+            index));
+      }
+      return Status::OK();
+    }
+
     mutex mu_;
     std::unique_ptr<IteratorBase> input_impl_ TF_GUARDED_BY(mu_);
   };
@@ -299,6 +432,8 @@ class BatchDatasetOp::Dataset : public DatasetBase {
   const int64 reserve_size_;
   const bool drop_remainder_;
   const bool parallel_copy_;
+  // Whether each batch is allocated when its first element is produced.
+  const bool preallocate_;
   const DatasetBase* const input_;
   const int op_version_;
   std::vector<PartialTensorShape> output_shapes_;
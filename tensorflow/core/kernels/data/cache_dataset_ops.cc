@@ -14,9 +14,13 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/kernels/data/cache_dataset_ops.h"
 
+#include <algorithm>
+
+#include "tensorflow/core/framework/allocation_description.pb.h"
 #include "tensorflow/core/framework/partial_tensor_shape.h"
 #include "tensorflow/core/framework/resource_mgr.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/kernels/data/cache_ops.h"
 #include "tensorflow/core/kernels/data/dataset_utils.h"
 #include "tensorflow/core/kernels/data/name_utils.h"
@@ -57,6 +61,127 @@ constexpr char kCacheCompleted[] = "cache_completed";
 constexpr char kIndex[] = "index";
 constexpr char kImpl[] = "Impl";
 constexpr char kCacheDataset[] = "CacheDataset";
+constexpr char kColumnSuffix[] = ".column_";
+constexpr char kColumnShardSizeKey[] = "column_shard_size_";
+
+namespace {
+
+// Returns the name of the file holding component `tensor_index` of the
+// elements of the cache shard with prefix `shard_prefix`.
+string ColumnFilename(StringPiece shard_prefix, size_t tensor_index) {
+  return strings::StrCat(shard_prefix, kColumnSuffix, tensor_index);
+}
+
+// Returns the bundle key of the number of elements in shard `shard_id` of a
+// columnar cache.
+string ColumnShardSizeKey(size_t shard_id) {
+  return strings::StrCat(kColumnShardSizeKey, shard_id);
+}
+
+// A tensor buffer that aliases an element of a column file mapped into
+// memory. Each buffer holds a reference to the mapping, which is released
+// when the last tensor viewing it is destroyed.
+class MappedColumnBuffer : public TensorBuffer {
+ public:
+  MappedColumnBuffer(std::shared_ptr<ReadOnlyMemoryRegion> region,
+                     size_t offset, size_t size)
+      : TensorBuffer(const_cast<char*>(
+            static_cast<const char*>(region->data()) + offset)),
+        region_(std::move(region)),
+        size_(size) {}
+
+  size_t size() const override { return size_; }
+  TensorBuffer* root_buffer() override { return this; }
+  void FillAllocationDescription(AllocationDescription* proto) const override {
+    proto->set_requested_bytes(size_);
+    proto->set_allocator_name("MappedCacheColumn");
+    proto->set_ptr(reinterpret_cast<uintptr_t>(data()));
+  }
+  // The mapping is read-only, so kernels must not reuse it for their outputs.
+  bool OwnsMemory() const override { return false; }
+
+ private:
+  const std::shared_ptr<ReadOnlyMemoryRegion> region_;
+  const size_t size_;
+};
+
+// One component of the elements of a cache shard, stored back to back in a
+// file. The file is mapped into memory when the file system supports it, and
+// read through a `RandomAccessFile` otherwise.
+class CacheColumn {
+ public:
+  static Status Open(Env* env, const string& filename, DataType dtype,
+                     const TensorShape& shape, size_t num_elements,
+                     std::unique_ptr<CacheColumn>* column) {
+    const size_t element_bytes = shape.num_elements() * DataTypeSize(dtype);
+    column->reset(new CacheColumn(dtype, shape, element_bytes));
+    const uint64 expected_bytes = element_bytes * num_elements;
+    if (expected_bytes == 0) {
+      return Status::OK();
+    }
+    std::unique_ptr<ReadOnlyMemoryRegion> region;
+    Status s = env->NewReadOnlyMemoryRegionFromFile(filename, &region);
+    uint64 file_bytes;
+    if (s.ok()) {
+      file_bytes = region->length();
+      (*column)->region_ = std::move(region);
+    } else if (errors::IsUnimplemented(s)) {
+      TF_RETURN_IF_ERROR(env->GetFileSize(filename, &file_bytes));
+      TF_RETURN_IF_ERROR(
+          env->NewRandomAccessFile(filename, &(*column)->file_));
+    } else {
+      return s;
+    }
+    if (file_bytes != expected_bytes) {
+      return errors::DataLoss("Cache file ", filename, " has ", file_bytes,
+                              " bytes, expected ", expected_bytes);
+    }
+    return Status::OK();
+  }
+
+  // Reads the element at `index`. Elements of mapped columns whose size is a
+  // multiple of the allocator alignment are returned without a copy.
+  Status Read(size_t index, Tensor* out) const {
+    const size_t offset = index * element_bytes_;
+    if (region_ && element_bytes_ % Allocator::kAllocatorAlignment == 0) {
+      auto* buf = new MappedColumnBuffer(region_, offset, element_bytes_);
+      *out = Tensor(dtype_, shape_, buf);
+      buf->Unref();
+      return Status::OK();
+    }
+    *out = Tensor(dtype_, shape_);
+    if (element_bytes_ == 0) {
+      return Status::OK();
+    }
+    char* dst = const_cast<char*>(out->tensor_data().data());
+    if (region_) {
+      memcpy(dst, static_cast<const char*>(region_->data()) + offset,
+             element_bytes_);
+      return Status::OK();
+    }
+    StringPiece result;
+    TF_RETURN_IF_ERROR(file_->Read(offset, element_bytes_, &result, dst));
+    if (result.size() != element_bytes_) {
+      return errors::DataLoss("Unexpected end of cache column file");
+    }
+    if (result.data() != dst) {
+      memcpy(dst, result.data(), element_bytes_);
+    }
+    return Status::OK();
+  }
+
+ private:
+  CacheColumn(DataType dtype, const TensorShape& shape, size_t element_bytes)
+      : dtype_(dtype), shape_(shape), element_bytes_(element_bytes) {}
+
+  const DataType dtype_;
+  const TensorShape shape_;
+  const size_t element_bytes_;
+  std::shared_ptr<ReadOnlyMemoryRegion> region_;
+  std::unique_ptr<RandomAccessFile> file_;
+};
+
+}  // namespace
 
 class CacheDatasetOp::FileDatasetBase : public DatasetBase {
  public:
@@ -74,6 +199,18 @@ class CacheDatasetOp::FileDatasetBase : public DatasetBase {
                                               tensor_index_padding_size_)) {
     input_->Ref();
     DCHECK_EQ(item_index_padding_size_, 7);
+    // Elements whose components all have a fixed shape and a memcpy-able
+    // type are cached in one file per component, which the reader maps into
+    // memory. Other elements are cached in a tensor bundle.
+    for (size_t i = 0; i < num_tensors_; ++i) {
+      TensorShape shape;
+      if (!DataTypeCanUseMemcpy(input_->output_dtypes()[i]) ||
+          !input_->output_shapes()[i].AsTensorShape(&shape)) {
+        column_shapes_.clear();
+        break;
+      }
+      column_shapes_.push_back(shape);
+    }
   }
 
   ~FileDatasetBase() override { input_->Unref(); }
@@ -120,6 +257,8 @@ class CacheDatasetOp::FileDatasetBase : public DatasetBase {
                            tensor_index);
   }
 
+  bool columnar() const { return !column_shapes_.empty(); }
+
   class FileIterator : public DatasetIterator<FileDatasetBase> {
    public:
     explicit FileIterator(const Params& params)
@@ -193,14 +332,18 @@ class CacheDatasetOp::FileDatasetBase : public DatasetBase {
     // elements.
     //
     // Caching is performed by writing the input tensors to disk using the
-    // `BundleWriter`. Note that the cache gets fully flushed to disk only
-    // after the input iterator has been fully exhausted. If the program
-    // exits, before completion of an epoch, the cached state would be lost.
-    // To ensure that the partial cache persists across sessions, one should
-    // checkpoint the input pipeline. On each call to `SaveInternal` the
-    // partial cache gets flushed to disk in files with prefix
-    // <filename>_<shard_id> where shard_id is unique for each checkpoint.
-    // When all elements have been produced, these shards get coalesced.
+    // `BundleWriter`, or, when all components have a fixed shape and a
+    // memcpy-able type, by appending the raw contents of each component to a
+    // column file <shard prefix>.column_<index>. In the latter case the bundle
+    // only records the number of elements in each shard. Note that the cache
+    // gets fully flushed to disk only after the input iterator has been fully
+    // exhausted. If the program exits, before completion of an epoch, the
+    // cached state would be lost. To ensure that the partial cache persists
+    // across sessions, one should checkpoint the input pipeline. On each call
+    // to `SaveInternal` the partial cache gets flushed to disk in files with
+    // prefix <filename>_<shard_id> where shard_id is unique for each
+    // checkpoint. When all elements have been produced, these shards get
+    // coalesced.
     class FileWriterIterator : public DatasetIterator<FileDatasetBase> {
      public:
       explicit FileWriterIterator(const Params& params)
@@ -271,11 +414,15 @@ class CacheDatasetOp::FileDatasetBase : public DatasetBase {
               "Expected ",
               dataset()->num_tensors_, " got: ", out_tensors->size());
         }
-        size_t tensor_index = 0;
-        for (const Tensor& t : *out_tensors) {
-          DCHECK_LT(tensor_index, dataset()->num_tensors_);
-          string key = dataset()->FormatName(cur_index_, tensor_index++);
-          TF_RETURN_IF_ERROR(writer_->Add(key, t));
+        if (dataset()->columnar()) {
+          TF_RETURN_IF_ERROR(AppendToColumns(*out_tensors));
+        } else {
+          size_t tensor_index = 0;
+          for (const Tensor& t : *out_tensors) {
+            DCHECK_LT(tensor_index, dataset()->num_tensors_);
+            string key = dataset()->FormatName(cur_index_, tensor_index++);
+            TF_RETURN_IF_ERROR(writer_->Add(key, t));
+          }
         }
         if (*end_of_sequence) {
           TF_RETURN_IF_ERROR(Finish());
@@ -310,7 +457,7 @@ class CacheDatasetOp::FileDatasetBase : public DatasetBase {
         // empty shards.
         if (lockfile_created_) {
           // Flush the current bundle.
-          TF_RETURN_IF_ERROR(writer_->Finish());
+          TF_RETURN_IF_ERROR(FinishShard());
 
           // Note: We do not delete the lockfile here. We keep lockfiles of
           // all shards around until the entire cache has been written to
@@ -423,13 +570,56 @@ class CacheDatasetOp::FileDatasetBase : public DatasetBase {
         // BundleWriter in another Session.
         writer_ = absl::make_unique<BundleWriter>(dataset()->env_, filename_);
         lockfile_created_ = true;
+        shard_size_ = 0;
+        if (dataset()->columnar()) {
+          column_files_.resize(dataset()->num_tensors_);
+          for (size_t i = 0; i < dataset()->num_tensors_; ++i) {
+            TF_RETURN_IF_ERROR(dataset()->env_->NewWritableFile(
+                ColumnFilename(filename_, i), &column_files_[i]));
+          }
+        }
+        return Status::OK();
+      }
+
+      Status AppendToColumns(const std::vector<Tensor>& tensors)
+          TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        for (size_t i = 0; i < tensors.size(); ++i) {
+          const Tensor& t = tensors[i];
+          if (t.dtype() != dataset()->output_dtypes()[i] ||
+              t.shape() != dataset()->column_shapes_[i]) {
+            return errors::InvalidArgument(
+                "Upstream iterator produced a tensor of type ",
+                DataTypeString(t.dtype()), " and shape ",
+                t.shape().DebugString(), " for component ", i,
+                ", which does not match the declared type ",
+                DataTypeString(dataset()->output_dtypes()[i]), " and shape ",
+                dataset()->column_shapes_[i].DebugString(), ".");
+          }
+          TF_RETURN_IF_ERROR(column_files_[i]->Append(t.tensor_data()));
+        }
+        shard_size_++;
         return Status::OK();
       }
 
+      // Flushes the bundle and the column files of the current shard.
+      Status FinishShard() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        if (dataset()->columnar()) {
+          for (auto& file : column_files_) {
+            TF_RETURN_IF_ERROR(file->Close());
+          }
+          column_files_.clear();
+          Tensor shard_size(DT_INT64, TensorShape({}));
+          shard_size.scalar<int64>()() = shard_size_;
+          TF_RETURN_IF_ERROR(
+              writer_->Add(ColumnShardSizeKey(shard_id_), shard_size));
+        }
+        return writer_->Finish();
+      }
+
       Status Finish() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
         iteration_completed_ = true;
         // Flush the current bundle.
-        TF_RETURN_IF_ERROR(writer_->Finish());
+        TF_RETURN_IF_ERROR(FinishShard());
         // Merge all the bundles.
         // Currently there are `shard_id_ + 1` bundles, one for each
         // checkpoint. Each bundle has prefix <filename>_<id> where `id` is an
@@ -465,6 +655,11 @@ class CacheDatasetOp::FileDatasetBase : public DatasetBase {
       // `StrCat(dataset()->filename_, "_", shard_id_)`.
       string filename_;
       std::unique_ptr<BundleWriter> writer_ TF_GUARDED_BY(mu_);
+      // The column files of the current shard, if the cache is columnar.
+      std::vector<std::unique_ptr<WritableFile>> column_files_
+          TF_GUARDED_BY(mu_);
+      // The number of elements written to the current shard.
+      size_t shard_size_ TF_GUARDED_BY(mu_) = 0;
       string lockfile_ TF_GUARDED_BY(mu_);
       bool lockfile_created_ TF_GUARDED_BY(mu_);
       bool iteration_completed_ TF_GUARDED_BY(mu_);
@@ -478,11 +673,46 @@ class CacheDatasetOp::FileDatasetBase : public DatasetBase {
             reader_(dataset()->env_, dataset()->filename_),
             iterator_restored_(false) {}
 
+      Status Initialize(IteratorContext* ctx) override {
+        mutex_lock l(mu_);
+        // Caches written before column files were introduced are read from
+        // the bundle.
+        if (!dataset()->columnar() || !reader_.status().ok() ||
+            !reader_.Contains(ColumnShardSizeKey(0))) {
+          return Status::OK();
+        }
+        for (size_t shard_id = 0;; ++shard_id) {
+          const string key = ColumnShardSizeKey(shard_id);
+          if (!reader_.Contains(key)) {
+            break;
+          }
+          Tensor shard_size;
+          TF_RETURN_IF_ERROR(reader_.Lookup(key, &shard_size));
+          ColumnShard shard;
+          shard.begin = num_column_elements_;
+          shard.columns.resize(dataset()->num_tensors_);
+          const string shard_prefix =
+              strings::StrCat(dataset()->filename_, "_", shard_id);
+          for (size_t i = 0; i < dataset()->num_tensors_; ++i) {
+            TF_RETURN_IF_ERROR(CacheColumn::Open(
+                dataset()->env_, ColumnFilename(shard_prefix, i),
+                dataset()->output_dtypes()[i], dataset()->column_shapes_[i],
+                shard_size.scalar<int64>()(), &shard.columns[i]));
+          }
+          num_column_elements_ += shard_size.scalar<int64>()();
+          column_shards_.push_back(std::move(shard));
+        }
+        return Status::OK();
+      }
+
       Status GetNextInternal(IteratorContext* ctx,
                              std::vector<Tensor>* out_tensors,
                              bool* end_of_sequence) override {
         mutex_lock l(mu_);
         *end_of_sequence = false;
+        if (!column_shards_.empty()) {
+          return ReadFromColumns(out_tensors, end_of_sequence);
+        }
         TF_RETURN_IF_ERROR(reader_.status());
         if (!reader_.Valid()) {
           *end_of_sequence = true;
@@ -544,6 +774,9 @@ class CacheDatasetOp::FileDatasetBase : public DatasetBase {
             return errors::Internal("Invalid value for cur_index ", temp);
           }
         }
+        if (!column_shards_.empty()) {
+          return Status::OK();
+        }
         if (!reader_.Valid()) {
           return errors::Internal("Error initializing BundleReader.");
         }
@@ -553,10 +786,45 @@ class CacheDatasetOp::FileDatasetBase : public DatasetBase {
       }
 
      private:
+      struct ColumnShard {
+        // The index of the first element of the shard.
+        size_t begin;
+        std::vector<std::unique_ptr<CacheColumn>> columns;
+      };
+
+      Status ReadFromColumns(std::vector<Tensor>* out_tensors,
+                             bool* end_of_sequence)
+          TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        if (cur_index_ >= num_column_elements_) {
+          *end_of_sequence = true;
+          return Status::OK();
+        }
+        // Find the last shard that begins at or before `cur_index_`. Empty
+        // shards begin at the same index as the next one and are skipped.
+        auto shard = std::upper_bound(
+            column_shards_.begin(), column_shards_.end(), cur_index_,
+            [](size_t index, const ColumnShard& shard) {
+              return index < shard.begin;
+            });
+        --shard;
+        out_tensors->clear();
+        out_tensors->resize(dataset()->num_tensors_);
+        for (size_t i = 0; i < dataset()->num_tensors_; ++i) {
+          TF_RETURN_IF_ERROR(shard->columns[i]->Read(cur_index_ - shard->begin,
+                                                     &(*out_tensors)[i]));
+        }
+        cur_index_++;
+        return Status::OK();
+      }
+
       mutex mu_;
       size_t cur_index_ TF_GUARDED_BY(mu_);
       BundleReader reader_ TF_GUARDED_BY(mu_);
       bool iterator_restored_ TF_GUARDED_BY(mu_);
+      // The shards of a columnar cache, in order. Empty if the cache is read
+      // from the bundle.
+      std::vector<ColumnShard> column_shards_ TF_GUARDED_BY(mu_);
+      size_t num_column_elements_ TF_GUARDED_BY(mu_) = 0;
     };  // FileReaderIterator
 
     Status InitializeIterator(IteratorContext* ctx)
@@ -596,6 +864,9 @@ class CacheDatasetOp::FileDatasetBase : public DatasetBase {
   static constexpr size_t kMaxItems = 10000000;  // 10 million
   const size_t item_index_padding_size_;
   const string tensor_format_string_;
+  // The shapes of the components if elements are cached in column files, or
+  // empty if they are cached in a tensor bundle.
+  std::vector<TensorShape> column_shapes_;
 };  // FileDatasetBase
 
 class CacheDatasetOp::FileDataset : public CacheDatasetOp::FileDatasetBase {
@@ -11,6 +11,8 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/kernels/data/cache_dataset_ops.h"
 
+#include <numeric>
+
 #include "tensorflow/core/kernels/data/dataset_test_base.h"
 #include "tensorflow/core/kernels/data/dataset_utils.h"
 #include "tensorflow/core/platform/path.h"
@@ -145,6 +147,40 @@ CacheDatasetParams CacheDatasetParams4() {
                             kNodeName);
 }
 
+// Test case 5: cache data with a type that cannot be stored in column files.
+CacheDatasetParams CacheDatasetParams5() {
+  auto tensor_slice_dataset_params = TensorSliceDatasetParams(
+      /*components=*/{CreateTensor<tstring>(TensorShape{3, 1},
+                                            {"a", "b", "c"})},
+      /*node_name=*/"tensor_slice");
+  return CacheDatasetParams(
+      std::move(tensor_slice_dataset_params),
+      /*filename=*/io::JoinPath(testing::TmpDir(), "cache_data"),
+      /*output_dtypes=*/{DT_STRING},
+      /*output_shapes=*/{PartialTensorShape({1})}, kNodeName);
+}
+
+// Test case 6: cache data whose elements are read back without a copy.
+CacheDatasetParams CacheDatasetParams6() {
+  std::vector<int64> values(32);
+  std::iota(values.begin(), values.end(), 0);
+  auto tensor_slice_dataset_params = TensorSliceDatasetParams(
+      /*components=*/{CreateTensor<int64>(TensorShape{2, 16}, values)},
+      /*node_name=*/"tensor_slice");
+  return CacheDatasetParams(
+      std::move(tensor_slice_dataset_params),
+      /*filename=*/io::JoinPath(testing::TmpDir(), "cache_data"),
+      /*output_dtypes=*/{DT_INT64},
+      /*output_shapes=*/{PartialTensorShape({16})}, kNodeName);
+}
+
+std::vector<Tensor> CacheDatasetParams6Outputs() {
+  std::vector<int64> first(16), second(16);
+  std::iota(first.begin(), first.end(), 0);
+  std::iota(second.begin(), second.end(), 16);
+  return CreateTensors<int64>(TensorShape({16}), {first, second});
+}
+
 std::vector<GetNextTestCase<CacheDatasetParams>> GetNextTestCases() {
   return {{/*dataset_params=*/CacheDatasetParams1(),
            /*expected_outputs=*/
@@ -157,7 +193,12 @@ std::vector<GetNextTestCase<CacheDatasetParams>> GetNextTestCases() {
            CreateTensors<int64>(TensorShape({3, 1}),
                                 {{0, 1, 2}, {3, 4, 5}, {6, 7, 8}})},
           {/*dataset_params=*/CacheDatasetParams4(),
-           /*expected_outputs=*/{}}};
+           /*expected_outputs=*/{}},
+          {/*dataset_params=*/CacheDatasetParams5(),
+           /*expected_outputs=*/
+           CreateTensors<tstring>(TensorShape({1}), {{"a"}, {"b"}, {"c"}})},
+          {/*dataset_params=*/CacheDatasetParams6(),
+           /*expected_outputs=*/CacheDatasetParams6Outputs()}};
 }
 
 class ParameterizedGetNextTest : public CacheDatasetOpTest,
@@ -298,7 +339,14 @@ IteratorSaveAndRestoreTestCases() {
                                 {{0, 1, 2}, {3, 4, 5}, {6, 7, 8}})},
           {/*dataset_params=*/CacheDatasetParams4(),
            /*breakpoints=*/{0, 2, 4, 11},
-           /*expected_outputs=*/{}}};
+           /*expected_outputs=*/{}},
+          {/*dataset_params=*/CacheDatasetParams5(),
+           /*breakpoints=*/{0, 2, 4, 11},
+           /*expected_outputs=*/
+           CreateTensors<tstring>(TensorShape({1}), {{"a"}, {"b"}, {"c"}})},
+          {/*dataset_params=*/CacheDatasetParams6(),
+           /*breakpoints=*/{0, 1, 4},
+           /*expected_outputs=*/CacheDatasetParams6Outputs()}};
 }
 
 class ParameterizedIteratorSaveAndRestoreTest
@@ -365,6 +413,48 @@ INSTANTIATE_TEST_CASE_P(CacheDatasetOpTest,
                         ParameterizedIteratorSaveAndRestoreTest,
                         ::testing::ValuesIn(IteratorSaveAndRestoreTestCases()));
 
+TEST_F(CacheDatasetOpTest, ColumnFiles) {
+  auto dataset_params = CacheDatasetParams6();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  bool end_of_sequence = false;
+  std::vector<Tensor> out_tensors;
+  while (!end_of_sequence) {
+    TF_ASSERT_OK(iterator_->GetNext(iterator_ctx_.get(), &out_tensors,
+                                    &end_of_sequence));
+  }
+  TF_EXPECT_OK(device_->env()->FileExists(
+      strings::StrCat(cache_filename_, "_0.column_0")));
+
+  // The second epoch reads its elements from the mapped column file.
+  TF_ASSERT_OK(dataset_->MakeIterator(iterator_ctx_.get(), /*parent=*/nullptr,
+                                      dataset_params.iterator_prefix(),
+                                      &iterator_));
+  std::vector<Tensor> expected_outputs = CacheDatasetParams6Outputs();
+  for (const Tensor& expected : expected_outputs) {
+    TF_ASSERT_OK(iterator_->GetNext(iterator_ctx_.get(), &out_tensors,
+                                    &end_of_sequence));
+    ASSERT_FALSE(end_of_sequence);
+    TF_EXPECT_OK(ExpectEqual(out_tensors[0], expected));
+    EXPECT_TRUE(out_tensors[0].IsAligned());
+  }
+  TF_ASSERT_OK(iterator_->GetNext(iterator_ctx_.get(), &out_tensors,
+                                  &end_of_sequence));
+  EXPECT_TRUE(end_of_sequence);
+}
+
+TEST_F(CacheDatasetOpTest, NoColumnFilesForStrings) {
+  auto dataset_params = CacheDatasetParams5();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  bool end_of_sequence = false;
+  std::vector<Tensor> out_tensors;
+  while (!end_of_sequence) {
+    TF_ASSERT_OK(iterator_->GetNext(iterator_ctx_.get(), &out_tensors,
+                                    &end_of_sequence));
+  }
+  EXPECT_TRUE(errors::IsNotFound(device_->env()->FileExists(
+      strings::StrCat(cache_filename_, "_0.column_0"))));
+}
+
 }  // namespace
 }  // namespace data
 }  // namespace tensorflow
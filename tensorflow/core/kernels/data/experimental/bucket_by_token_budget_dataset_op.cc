@@ -0,0 +1,624 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/data/experimental/bucket_by_token_budget_dataset_op.h"
+
+#include <algorithm>
+#include <deque>
+
+#include "tensorflow/core/framework/partial_tensor_shape.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_util.h"
+#include "tensorflow/core/kernels/data/dataset_utils.h"
+#include "tensorflow/core/kernels/data/name_utils.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/stringprintf.h"
+#include "tensorflow/core/util/batch_util.h"
+
+namespace tensorflow {
+namespace data {
+namespace experimental {
+
+/* static */ constexpr const char* const
+    BucketByTokenBudgetDatasetOp::kDatasetType;
+/* static */ constexpr const char* const
+    BucketByTokenBudgetDatasetOp::kInputDataset;
+/* static */ constexpr const char* const
+    BucketByTokenBudgetDatasetOp::kTokenBudget;
+/* static */ constexpr const char* const
+    BucketByTokenBudgetDatasetOp::kMaxPaddingFraction;
+/* static */ constexpr const char* const
+    BucketByTokenBudgetDatasetOp::kMaxBuckets;
+/* static */ constexpr const char* const
+    BucketByTokenBudgetDatasetOp::kPaddingValues;
+/* static */ constexpr const char* const
+    BucketByTokenBudgetDatasetOp::kToutputTypes;
+/* static */ constexpr const char* const
+    BucketByTokenBudgetDatasetOp::kOutputShapes;
+
+constexpr char kExhausted[] = "exhausted";
+constexpr char kLengthCounts[] = "length_counts";
+constexpr char kNumElements[] = "num_elements";
+constexpr char kNumElementsSinceUpdate[] = "num_elements_since_update";
+constexpr char kBoundaries[] = "boundaries";
+constexpr char kBuckets[] = "buckets";
+constexpr char kLengths[] = "lengths";
+constexpr char kReadyBatches[] = "ready_batches";
+constexpr char kSize[] = "size";
+
+// The boundaries are recomputed once the number of elements seen has doubled
+// since the last update, and at least every `kMaxUpdateInterval` elements, so
+// that they settle quickly at the start of the input and are cheap to maintain
+// after.
+constexpr int64 kMaxUpdateInterval = 1024;
+
+namespace {
+
+// Returns the boundaries of `num_buckets` buckets holding about equal numbers
+// of the elements counted in `length_counts`, and sets `*padding_fraction` to
+// the fraction of padding tokens if every element were padded to the largest
+// length in its bucket. Batches only pad to the largest length in the batch,
+// so this overestimates the padding of the batches produced.
+std::vector<int64> EqualCountBoundaries(
+    const std::map<int64, int64>& length_counts, int64 num_elements,
+    int64 num_buckets, double* padding_fraction) {
+  std::vector<int64> boundaries;
+  int64 padded_tokens = 0;
+  int64 padding_tokens = 0;
+  int64 count = 0;
+  int64 bucket_count = 0;
+  int64 bucket_tokens = 0;
+  for (auto it = length_counts.begin(); it != length_counts.end(); ++it) {
+    count += it->second;
+    bucket_count += it->second;
+    bucket_tokens += it->first * it->second;
+    auto next = std::next(it);
+    const int64 num_boundaries = boundaries.size();
+    if (next == length_counts.end() ||
+        (num_boundaries + 1 < num_buckets &&
+         count * num_buckets >= (num_boundaries + 1) * num_elements)) {
+      padded_tokens += bucket_count * it->first;
+      padding_tokens += bucket_count * it->first - bucket_tokens;
+      bucket_count = 0;
+      bucket_tokens = 0;
+      if (next != length_counts.end()) {
+        boundaries.push_back(it->first + 1);
+      }
+    }
+  }
+  *padding_fraction =
+      padded_tokens == 0 ? 0.0
+                         : static_cast<double>(padding_tokens) / padded_tokens;
+  return boundaries;
+}
+
+}  // namespace
+
+/* static */ std::vector<int64> BucketByTokenBudgetDatasetOp::ComputeBoundaries(
+    const std::map<int64, int64>& length_counts, double max_padding_fraction,
+    int64 max_buckets) {
+  int64 num_elements = 0;
+  for (const auto& length_count : length_counts) {
+    num_elements += length_count.second;
+  }
+  std::vector<int64> boundaries;
+  for (int64 num_buckets = 1; num_buckets <= max_buckets; ++num_buckets) {
+    double padding_fraction;
+    boundaries = EqualCountBoundaries(length_counts, num_elements, num_buckets,
+                                      &padding_fraction);
+    // Stop if the target is met, or if every distinct length already has its
+    // own bucket.
+    if (padding_fraction <= max_padding_fraction ||
+        boundaries.size() + 1 < num_buckets) {
+      break;
+    }
+  }
+  return boundaries;
+}
+
+class BucketByTokenBudgetDatasetOp::Dataset : public DatasetBase {
+ public:
+  Dataset(OpKernelContext* ctx, const DatasetBase* input, int64 token_budget,
+          float max_padding_fraction, int64 max_buckets,
+          std::vector<Tensor> padding_values,
+          const DataTypeVector& output_types,
+          const std::vector<PartialTensorShape>& output_shapes)
+      : DatasetBase(DatasetContext(ctx)),
+        input_(input),
+        token_budget_(token_budget),
+        max_padding_fraction_(max_padding_fraction),
+        max_buckets_(max_buckets),
+        padding_values_(std::move(padding_values)),
+        output_types_(output_types),
+        output_shapes_(output_shapes),
+        traceme_metadata_(
+            {{"token_budget",
+              strings::Printf("%lld", static_cast<long long>(token_budget))},
+             {"max_buckets",
+              strings::Printf("%lld", static_cast<long long>(max_buckets))}}) {
+    input_->Ref();
+  }
+
+  ~Dataset() override { input_->Unref(); }
+
+  std::unique_ptr<IteratorBase> MakeIteratorInternal(
+      const string& prefix) const override {
+    return absl::make_unique<Iterator>(Iterator::Params{
+        this, name_utils::IteratorPrefix(kDatasetType, prefix)});
+  }
+
+  const DataTypeVector& output_dtypes() const override { return output_types_; }
+
+  const std::vector<PartialTensorShape>& output_shapes() const override {
+    return output_shapes_;
+  }
+
+  string DebugString() const override {
+    name_utils::DatasetDebugStringParams params;
+    params.set_args(token_budget_, max_buckets_);
+    return name_utils::DatasetDebugString(kDatasetType, params);
+  }
+
+  int64 Cardinality() const override {
+    int64 n = input_->Cardinality();
+    if (n == kInfiniteCardinality) {
+      return n;
+    }
+    return kUnknownCardinality;
+  }
+
+  Status CheckExternalState() const override {
+    return input_->CheckExternalState();
+  }
+
+ protected:
+  Status AsGraphDefInternal(SerializationContext* ctx,
+                            DatasetGraphDefBuilder* b,
+                            Node** output) const override {
+    Node* input_graph_node = nullptr;
+    TF_RETURN_IF_ERROR(b->AddInputDataset(ctx, input_, &input_graph_node));
+    Node* token_budget = nullptr;
+    TF_RETURN_IF_ERROR(b->AddScalar(token_budget_, &token_budget));
+    Node* max_padding_fraction = nullptr;
+    TF_RETURN_IF_ERROR(
+        b->AddScalar(max_padding_fraction_, &max_padding_fraction));
+    Node* max_buckets = nullptr;
+    TF_RETURN_IF_ERROR(b->AddScalar(max_buckets_, &max_buckets));
+
+    std::vector<Node*> padding_values;
+    padding_values.reserve(padding_values_.size());
+    for (const Tensor& t : padding_values_) {
+      Node* node;
+      TF_RETURN_IF_ERROR(b->AddTensor(t, &node));
+      padding_values.emplace_back(node);
+    }
+
+    AttrValue output_types;
+    b->BuildAttrValue(output_types_, &output_types);
+
+    TF_RETURN_IF_ERROR(b->AddDataset(
+        this,
+        {{0, input_graph_node},
+         {1, token_budget},
+         {2, max_padding_fraction},
+         {3, max_buckets}},
+        {{4, padding_values}}, {{kToutputTypes, output_types}}, output));
+    return Status::OK();
+  }
+
+ private:
+  class Iterator : public DatasetIterator<Dataset> {
+   public:
+    explicit Iterator(const Params& params)
+        : DatasetIterator<Dataset>(params) {}
+
+    Status Initialize(IteratorContext* ctx) override {
+      buckets_.resize(1);
+      return dataset()->input_->MakeIterator(ctx, this, prefix(), &input_impl_);
+    }
+
+    Status GetNextInternal(IteratorContext* ctx,
+                           std::vector<Tensor>* out_tensors,
+                           bool* end_of_sequence) override {
+      std::vector<std::vector<Tensor>> batch_elements;
+      {
+        mutex_lock l(mu_);
+        while (ready_batches_.empty() && input_impl_) {
+          std::vector<Tensor> element;
+          bool end_of_input;
+          TF_RETURN_IF_ERROR(
+              input_impl_->GetNext(ctx, &element, &end_of_input));
+          if (end_of_input) {
+            input_impl_.reset();
+            for (Bucket& bucket : buckets_) {
+              FlushBucket(&bucket);
+            }
+            break;
+          }
+          TF_RETURN_IF_ERROR(AddElement(std::move(element)));
+        }
+        if (ready_batches_.empty()) {
+          *end_of_sequence = true;
+          return Status::OK();
+        }
+        batch_elements = std::move(ready_batches_.front());
+        ready_batches_.pop_front();
+      }
+      *end_of_sequence = false;
+      return CopyBatch(ctx, batch_elements, out_tensors);
+    }
+
+   protected:
+    std::shared_ptr<model::Node> CreateNode(
+        IteratorContext* ctx, model::Node::Args args) const override {
+      return model::MakeUnknownRatioNode(std::move(args));
+    }
+
+    Status SaveInternal(SerializationContext* ctx,
+                        IteratorStateWriter* writer) override {
+      mutex_lock l(mu_);
+      if (input_impl_) {
+        TF_RETURN_IF_ERROR(SaveInput(ctx, writer, input_impl_));
+      } else {
+        TF_RETURN_IF_ERROR(writer->WriteScalar(full_name(kExhausted), ""));
+      }
+      Tensor length_counts(DT_INT64,
+                           TensorShape({static_cast<int64>(
+                                            length_counts_.size()),
+                                        2}));
+      auto length_counts_matrix = length_counts.matrix<int64>();
+      int64 i = 0;
+      for (const auto& length_count : length_counts_) {
+        length_counts_matrix(i, 0) = length_count.first;
+        length_counts_matrix(i, 1) = length_count.second;
+        ++i;
+      }
+      TF_RETURN_IF_ERROR(
+          writer->WriteTensor(full_name(kLengthCounts), length_counts));
+      TF_RETURN_IF_ERROR(
+          writer->WriteScalar(full_name(kNumElements), num_elements_));
+      TF_RETURN_IF_ERROR(writer->WriteScalar(full_name(kNumElementsSinceUpdate),
+                                             num_elements_since_update_));
+      TF_RETURN_IF_ERROR(writer->WriteTensor(full_name(kBoundaries),
+                                             VectorTensor(boundaries_)));
+      for (int i = 0; i < buckets_.size(); ++i) {
+        const string bucket_prefix =
+            full_name(strings::StrCat(kBuckets, "[", i, "]"));
+        TF_RETURN_IF_ERROR(writer->WriteTensor(
+            bucket_prefix, kLengths, VectorTensor(buckets_[i].lengths)));
+        TF_RETURN_IF_ERROR(WriteElementsToCheckpoint(writer, bucket_prefix,
+                                                     buckets_[i].elements));
+      }
+      TF_RETURN_IF_ERROR(writer->WriteScalar(full_name(kReadyBatches), kSize,
+                                             ready_batches_.size()));
+      for (int i = 0; i < ready_batches_.size(); ++i) {
+        TF_RETURN_IF_ERROR(WriteElementsToCheckpoint(
+            writer, full_name(strings::StrCat(kReadyBatches, "[", i, "]")),
+            ready_batches_[i]));
+      }
+      return Status::OK();
+    }
+
+    Status RestoreInternal(IteratorContext* ctx,
+                           IteratorStateReader* reader) override {
+      mutex_lock l(mu_);
+      if (reader->Contains(full_name(kExhausted))) {
+        input_impl_.reset();
+      } else {
+        TF_RETURN_IF_ERROR(
+            dataset()->input_->MakeIterator(ctx, this, prefix(), &input_impl_));
+        TF_RETURN_IF_ERROR(RestoreInput(ctx, reader, input_impl_));
+      }
+      Tensor length_counts;
+      TF_RETURN_IF_ERROR(
+          reader->ReadTensor(full_name(kLengthCounts), &length_counts));
+      auto length_counts_matrix = length_counts.matrix<int64>();
+      length_counts_.clear();
+      for (int64 i = 0; i < length_counts.dim_size(0); ++i) {
+        length_counts_[length_counts_matrix(i, 0)] = length_counts_matrix(i, 1);
+      }
+      TF_RETURN_IF_ERROR(
+          reader->ReadScalar(full_name(kNumElements), &num_elements_));
+      TF_RETURN_IF_ERROR(reader->ReadScalar(full_name(kNumElementsSinceUpdate),
+                                            &num_elements_since_update_));
+      Tensor boundaries;
+      TF_RETURN_IF_ERROR(
+          reader->ReadTensor(full_name(kBoundaries), &boundaries));
+      boundaries_.assign(boundaries.vec<int64>().data(),
+                         boundaries.vec<int64>().data() +
+                             boundaries.NumElements());
+      buckets_.clear();
+      buckets_.resize(boundaries_.size() + 1);
+      for (int i = 0; i < buckets_.size(); ++i) {
+        Bucket& bucket = buckets_[i];
+        const string bucket_prefix =
+            full_name(strings::StrCat(kBuckets, "[", i, "]"));
+        Tensor lengths;
+        TF_RETURN_IF_ERROR(
+            reader->ReadTensor(bucket_prefix, kLengths, &lengths));
+        bucket.lengths.assign(lengths.vec<int64>().data(),
+                              lengths.vec<int64>().data() +
+                                  lengths.NumElements());
+        for (int64 length : bucket.lengths) {
+          bucket.max_length = std::max(bucket.max_length, length);
+        }
+        TF_RETURN_IF_ERROR(ReadElementsFromCheckpoint(reader, bucket_prefix,
+                                                      &bucket.elements));
+      }
+      int64 num_ready_batches;
+      TF_RETURN_IF_ERROR(reader->ReadScalar(full_name(kReadyBatches), kSize,
+                                            &num_ready_batches));
+      ready_batches_.clear();
+      for (int64 i = 0; i < num_ready_batches; ++i) {
+        ready_batches_.emplace_back();
+        TF_RETURN_IF_ERROR(ReadElementsFromCheckpoint(
+            reader, full_name(strings::StrCat(kReadyBatches, "[", i, "]")),
+            &ready_batches_.back()));
+      }
+      return Status::OK();
+    }
+
+    TraceMeMetadata GetTraceMeMetadata() const override {
+      return dataset()->traceme_metadata_;
+    }
+
+   private:
+    // The elements waiting for a batch in one bucket, without their lengths.
+    struct Bucket {
+      int64 max_length = 0;
+      std::vector<int64> lengths;
+      std::vector<std::vector<Tensor>> elements;
+    };
+
+    static Tensor VectorTensor(const std::vector<int64>& values) {
+      Tensor t(DT_INT64, TensorShape({static_cast<int64>(values.size())}));
+      std::copy(values.begin(), values.end(), t.vec<int64>().data());
+      return t;
+    }
+
+    // Returns the number of tokens in a batch of `batch_size` elements padded
+    // to `max_length`. Empty elements count as one token, so that a bucket of
+    // empty elements still fills up.
+    static int64 NumTokens(int64 batch_size, int64 max_length) {
+      return batch_size * std::max<int64>(max_length, 1);
+    }
+
+    Status AddElement(std::vector<Tensor> element)
+        TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      const Tensor& length_t = element[0];
+      if (length_t.dtype() != DT_INT64 ||
+          !TensorShapeUtils::IsScalar(length_t.shape())) {
+        return errors::InvalidArgument(
+            "The length of each element must be an int64 scalar, but got ",
+            DataTypeString(length_t.dtype()), " tensor of shape ",
+            length_t.shape().DebugString());
+      }
+      const int64 length = length_t.scalar<int64>()();
+      if (length < 0) {
+        return errors::InvalidArgument(
+            "The length of each element must be non-negative, but got ",
+            length);
+      }
+      element.erase(element.begin());
+      ++length_counts_[length];
+      ++num_elements_;
+      ++num_elements_since_update_;
+      if (num_elements_since_update_ >=
+          std::min(num_elements_ - num_elements_since_update_,
+                   kMaxUpdateInterval)) {
+        UpdateBoundaries();
+      }
+      InsertIntoBucket(length, std::move(element));
+      return Status::OK();
+    }
+
+    // Recomputes the bucket boundaries from the lengths seen so far, and
+    // moves the buffered elements to their new buckets.
+    void UpdateBoundaries() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      num_elements_since_update_ = 0;
+      std::vector<int64> boundaries =
+          ComputeBoundaries(length_counts_, dataset()->max_padding_fraction_,
+                            dataset()->max_buckets_);
+      if (boundaries == boundaries_) {
+        return;
+      }
+      boundaries_ = std::move(boundaries);
+      std::vector<Bucket> old_buckets = std::move(buckets_);
+      buckets_.clear();
+      buckets_.resize(boundaries_.size() + 1);
+      for (Bucket& bucket : old_buckets) {
+        for (int i = 0; i < bucket.elements.size(); ++i) {
+          InsertIntoBucket(bucket.lengths[i], std::move(bucket.elements[i]));
+        }
+      }
+    }
+
+    // Adds `element` to its bucket. A bucket becomes a batch when the next
+    // element could not be added without exceeding the token budget.
+    void InsertIntoBucket(int64 length, std::vector<Tensor> element)
+        TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      Bucket& bucket =
+          buckets_[std::upper_bound(boundaries_.begin(), boundaries_.end(),
+                                    length) -
+                   boundaries_.begin()];
+      const int64 token_budget = dataset()->token_budget_;
+      if (!bucket.elements.empty() &&
+          NumTokens(bucket.elements.size() + 1,
+                    std::max(bucket.max_length, length)) > token_budget) {
+        FlushBucket(&bucket);
+      }
+      bucket.max_length = std::max(bucket.max_length, length);
+      bucket.lengths.push_back(length);
+      bucket.elements.push_back(std::move(element));
+      if (NumTokens(bucket.elements.size() + 1, bucket.max_length) >
+          token_budget) {
+        FlushBucket(&bucket);
+      }
+    }
+
+    void FlushBucket(Bucket* bucket) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      if (bucket->elements.empty()) {
+        return;
+      }
+      ready_batches_.push_back(std::move(bucket->elements));
+      bucket->elements.clear();
+      bucket->lengths.clear();
+      bucket->max_length = 0;
+    }
+
+    // Pads each component of `batch_elements` to the largest size of each of
+    // its dimensions in the batch, and stacks the components.
+    Status CopyBatch(IteratorContext* ctx,
+                     const std::vector<std::vector<Tensor>>& batch_elements,
+                     std::vector<Tensor>* out_tensors) {
+      const size_t num_tuple_components = batch_elements[0].size();
+      const int64 num_batch_elements = batch_elements.size();
+      for (size_t component_index = 0; component_index < num_tuple_components;
+           ++component_index) {
+        const int rank = batch_elements[0][component_index].dims();
+        TensorShape batch_component_shape({num_batch_elements});
+        for (int dim = 0; dim < rank; ++dim) {
+          batch_component_shape.AddDim(0);
+        }
+        for (int64 i = 0; i < num_batch_elements; ++i) {
+          const TensorShape& element_shape =
+              batch_elements[i][component_index].shape();
+          if (element_shape.dims() != rank) {
+            return errors::InvalidArgument(
+                "All elements in a batch must have the same rank for "
+                "component ",
+                component_index, ": expected rank ", rank,
+                " but got element with rank ", element_shape.dims());
+          }
+          for (int dim = 0; dim < rank; ++dim) {
+            if (element_shape.dim_size(dim) >
+                batch_component_shape.dim_size(dim + 1)) {
+              batch_component_shape.set_dim(dim + 1,
+                                            element_shape.dim_size(dim));
+            }
+          }
+        }
+
+        out_tensors->emplace_back(ctx->allocator({}),
+                                  output_dtypes()[component_index],
+                                  batch_component_shape);
+        Tensor& batch_component = out_tensors->back();
+        TF_RETURN_IF_ERROR(batch_util::SetElementZero(
+            &batch_component, dataset()->padding_values_[component_index]));
+        TensorShape component_shape = batch_component_shape;
+        component_shape.RemoveDim(0);
+        for (int64 i = 0; i < num_batch_elements; ++i) {
+          const Tensor& element = batch_elements[i][component_index];
+          if (element.shape() == component_shape) {
+            TF_RETURN_IF_ERROR(
+                batch_util::CopyElementToSlice(element, &batch_component, i));
+          } else {
+            TF_RETURN_IF_ERROR(batch_util::CopyElementToLargerSlice(
+                element, &batch_component, i));
+          }
+        }
+      }
+      return Status::OK();
+    }
+
+    mutex mu_;
+    std::unique_ptr<IteratorBase> input_impl_ TF_GUARDED_BY(mu_);
+    // Maps each length seen so far to its number of elements.
+    std::map<int64, int64> length_counts_ TF_GUARDED_BY(mu_);
+    int64 num_elements_ TF_GUARDED_BY(mu_) = 0;
+    int64 num_elements_since_update_ TF_GUARDED_BY(mu_) = 0;
+    std::vector<int64> boundaries_ TF_GUARDED_BY(mu_);
+    std::vector<Bucket> buckets_ TF_GUARDED_BY(mu_);
+    std::deque<std::vector<std::vector<Tensor>>> ready_batches_
+        TF_GUARDED_BY(mu_);
+  };
+
+  const DatasetBase* const input_;
+  const int64 token_budget_;
+  const float max_padding_fraction_;
+  const int64 max_buckets_;
+  const std::vector<Tensor> padding_values_;
+  const DataTypeVector output_types_;
+  const std::vector<PartialTensorShape> output_shapes_;
+  const TraceMeMetadata traceme_metadata_;
+};
+
+BucketByTokenBudgetDatasetOp::BucketByTokenBudgetDatasetOp(
+    OpKernelConstruction* ctx)
+    : UnaryDatasetOpKernel(ctx) {
+  OP_REQUIRES_OK(ctx, ctx->GetAttr(kToutputTypes, &output_types_));
+  OP_REQUIRES_OK(ctx, ctx->GetAttr(kOutputShapes, &output_shapes_));
+}
+
+void BucketByTokenBudgetDatasetOp::MakeDataset(OpKernelContext* ctx,
+                                               DatasetBase* input,
+                                               DatasetBase** output) {
+  int64 token_budget;
+  OP_REQUIRES_OK(ctx,
+                 ParseScalarArgument<int64>(ctx, kTokenBudget, &token_budget));
+  OP_REQUIRES(
+      ctx, token_budget > 0,
+      errors::InvalidArgument("Token budget must be greater than zero."));
+
+  float max_padding_fraction;
+  OP_REQUIRES_OK(ctx, ParseScalarArgument<float>(ctx, kMaxPaddingFraction,
+                                                 &max_padding_fraction));
+  OP_REQUIRES(ctx, max_padding_fraction >= 0 && max_padding_fraction < 1,
+              errors::InvalidArgument(
+                  "Maximum padding fraction must be in [0, 1), but got ",
+                  max_padding_fraction, "."));
+
+  int64 max_buckets;
+  OP_REQUIRES_OK(ctx,
+                 ParseScalarArgument<int64>(ctx, kMaxBuckets, &max_buckets));
+  OP_REQUIRES(
+      ctx, max_buckets > 0,
+      errors::InvalidArgument("Maximum number of buckets must be greater "
+                              "than zero."));
+
+  OP_REQUIRES(ctx, input->output_dtypes().size() == output_types_.size() + 1,
+              errors::InvalidArgument(
+                  "The input dataset must have one more component than the "
+                  "output, for the length of each element, but got ",
+                  input->output_dtypes().size(), " input and ",
+                  output_types_.size(), " output components."));
+
+  OpInputList padding_values_list;
+  OP_REQUIRES_OK(ctx, ctx->input_list(kPaddingValues, &padding_values_list));
+  std::vector<Tensor> padding_values;
+  for (int i = 0; i < padding_values_list.size(); ++i) {
+    const Tensor& padding_value_t = padding_values_list[i];
+    OP_REQUIRES(ctx, TensorShapeUtils::IsScalar(padding_value_t.shape()),
+                errors::InvalidArgument("All padding values must be scalars"));
+    OP_REQUIRES(ctx, padding_value_t.dtype() == input->output_dtypes()[i + 1],
+                errors::InvalidArgument(
+                    "Mismatched type between padding value ", i,
+                    " and input dataset's component ", i + 1, ": ",
+                    DataTypeString(padding_value_t.dtype()), " vs. ",
+                    DataTypeString(input->output_dtypes()[i + 1])));
+    padding_values.push_back(tensor::DeepCopy(padding_value_t));
+  }
+
+  *output = new Dataset(ctx, input, token_budget, max_padding_fraction,
+                        max_buckets, std::move(padding_values), output_types_,
+                        output_shapes_);
+}
+
+namespace {
+REGISTER_KERNEL_BUILDER(Name("BucketByTokenBudgetDataset").Device(DEVICE_CPU),
+                        BucketByTokenBudgetDatasetOp);
+}  // namespace
+}  // namespace experimental
+}  // namespace data
+}  // namespace tensorflow
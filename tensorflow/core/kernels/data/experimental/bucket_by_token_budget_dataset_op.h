@@ -0,0 +1,69 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_KERNELS_DATA_EXPERIMENTAL_BUCKET_BY_TOKEN_BUDGET_DATASET_OP_H_
+#define TENSORFLOW_CORE_KERNELS_DATA_EXPERIMENTAL_BUCKET_BY_TOKEN_BUDGET_DATASET_OP_H_
+
+#include <map>
+#include <vector>
+
+#include "tensorflow/core/framework/dataset.h"
+
+namespace tensorflow {
+namespace data {
+namespace experimental {
+
+// See tensorflow/core/api_def/base_api/api_def_BucketByTokenBudgetDataset.pbtxt
+// for the API definition that corresponds to this kernel.
+class BucketByTokenBudgetDatasetOp : public UnaryDatasetOpKernel {
+ public:
+  // Names of op parameters, public so that they can be accessed by test cases.
+  // Make sure that these are kept in sync with the REGISTER_OP call in
+  // tensorflow/core/ops/experimental_dataset_ops.cc
+  static constexpr const char* const kDatasetType = "BucketByTokenBudget";
+  static constexpr const char* const kInputDataset = "input_dataset";
+  static constexpr const char* const kTokenBudget = "token_budget";
+  static constexpr const char* const kMaxPaddingFraction =
+      "max_padding_fraction";
+  static constexpr const char* const kMaxBuckets = "max_buckets";
+  static constexpr const char* const kPaddingValues = "padding_values";
+  static constexpr const char* const kToutputTypes = "Toutput_types";
+  static constexpr const char* const kOutputShapes = "output_shapes";
+
+  explicit BucketByTokenBudgetDatasetOp(OpKernelConstruction* ctx);
+
+  // Returns the boundaries of the fewest buckets, at most `max_buckets`, that
+  // split the lengths counted in `length_counts` into buckets of about equal
+  // numbers of elements with an expected padding fraction of at most
+  // `max_padding_fraction`. Bucket `i` holds the lengths smaller than
+  // `boundaries[i]`, and the last bucket holds the rest.
+  static std::vector<int64> ComputeBoundaries(
+      const std::map<int64, int64>& length_counts, double max_padding_fraction,
+      int64 max_buckets);
+
+ protected:
+  void MakeDataset(OpKernelContext* ctx, DatasetBase* input,
+                   DatasetBase** output) override;
+
+ private:
+  class Dataset;
+  DataTypeVector output_types_;
+  std::vector<PartialTensorShape> output_shapes_;
+};
+
+}  // namespace experimental
+}  // namespace data
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_DATA_EXPERIMENTAL_BUCKET_BY_TOKEN_BUDGET_DATASET_OP_H_
@@ -0,0 +1,65 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/data/experimental/bucket_by_token_budget_dataset_op.h"
+
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace data {
+namespace experimental {
+namespace {
+
+std::vector<int64> ComputeBoundaries(
+    const std::map<int64, int64>& length_counts, double max_padding_fraction,
+    int64 max_buckets) {
+  return BucketByTokenBudgetDatasetOp::ComputeBoundaries(
+      length_counts, max_padding_fraction, max_buckets);
+}
+
+TEST(ComputeBoundariesTest, NoLengths) {
+  EXPECT_TRUE(ComputeBoundaries({}, 0.1, 8).empty());
+}
+
+TEST(ComputeBoundariesTest, SingleLength) {
+  EXPECT_TRUE(ComputeBoundaries({{5, 100}}, 0.0, 8).empty());
+}
+
+TEST(ComputeBoundariesTest, SplitsClusters) {
+  // One bucket would pad half of the tokens.
+  EXPECT_EQ(ComputeBoundaries({{2, 50}, {100, 50}}, 0.1, 8),
+            std::vector<int64>({3}));
+}
+
+TEST(ComputeBoundariesTest, UsesFewestBuckets) {
+  // Two buckets pad the elements of length 1 to 2, three buckets pad nothing.
+  EXPECT_EQ(ComputeBoundaries({{1, 10}, {2, 10}, {3, 10}}, 0.0, 8),
+            std::vector<int64>({2, 3}));
+  EXPECT_EQ(ComputeBoundaries({{1, 10}, {2, 10}, {3, 10}}, 0.2, 8),
+            std::vector<int64>({3}));
+}
+
+TEST(ComputeBoundariesTest, RespectsMaxBuckets) {
+  std::map<int64, int64> length_counts;
+  for (int64 length = 1; length <= 100; ++length) {
+    length_counts[length] = 1;
+  }
+  EXPECT_EQ(ComputeBoundaries(length_counts, 0.0, 4),
+            std::vector<int64>({26, 51, 76}));
+}
+
+}  // namespace
+}  // namespace experimental
+}  // namespace data
+}  // namespace tensorflow
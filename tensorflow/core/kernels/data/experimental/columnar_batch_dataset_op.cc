@@ -0,0 +1,301 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/data/experimental/columnar_batch_dataset_op.h"
+
+#include <numeric>
+
+#include "tensorflow/core/framework/partial_tensor_shape.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_util.h"
+#include "tensorflow/core/kernels/data/dataset_utils.h"
+#include "tensorflow/core/kernels/data/name_utils.h"
+#include "tensorflow/core/lib/random/philox_random.h"
+#include "tensorflow/core/lib/random/random_distributions.h"
+#include "tensorflow/core/util/batch_util.h"
+
+namespace tensorflow {
+namespace data {
+namespace experimental {
+
+/* static */ constexpr const char* const ColumnarBatchDatasetOp::kDatasetType;
+/* static */ constexpr const char* const ColumnarBatchDatasetOp::kColumns;
+/* static */ constexpr const char* const ColumnarBatchDatasetOp::kBatchSize;
+/* static */ constexpr const char* const ColumnarBatchDatasetOp::kDropRemainder;
+/* static */ constexpr const char* const ColumnarBatchDatasetOp::kSeed;
+/* static */ constexpr const char* const ColumnarBatchDatasetOp::kSeed2;
+/* static */ constexpr const char* const ColumnarBatchDatasetOp::kShuffle;
+/* static */ constexpr const char* const ColumnarBatchDatasetOp::kTcolumns;
+/* static */ constexpr const char* const ColumnarBatchDatasetOp::kOutputShapes;
+
+constexpr char kCurIndex[] = "i";
+constexpr char kSeedState[] = "seed";
+constexpr char kSeed2State[] = "seed2";
+
+class ColumnarBatchDatasetOp::Dataset : public DatasetBase {
+ public:
+  Dataset(OpKernelContext* ctx, std::vector<Tensor> columns, int64 batch_size,
+          bool drop_remainder, bool shuffle, int64 seed, int64 seed2)
+      : DatasetBase(DatasetContext(ctx)),
+        columns_(std::move(columns)),
+        num_rows_(columns_[0].dim_size(0)),
+        batch_size_(batch_size),
+        drop_remainder_(drop_remainder),
+        shuffle_(shuffle),
+        seeds_(seed, seed2) {
+    for (const Tensor& t : columns_) {
+      dtypes_.push_back(t.dtype());
+      gtl::InlinedVector<int64, 4> batch_dim_sizes;
+      batch_dim_sizes.push_back(drop_remainder_ || num_rows_ % batch_size_ == 0
+                                    ? batch_size_
+                                    : -1);
+      for (int i = 1; i < t.dims(); ++i) {
+        batch_dim_sizes.push_back(t.dim_size(i));
+      }
+      shapes_.emplace_back(std::move(batch_dim_sizes));
+    }
+  }
+
+  std::unique_ptr<IteratorBase> MakeIteratorInternal(
+      const string& prefix) const override {
+    return absl::make_unique<Iterator>(Iterator::Params{
+        this, name_utils::IteratorPrefix(kDatasetType, prefix)});
+  }
+
+  const DataTypeVector& output_dtypes() const override { return dtypes_; }
+
+  const std::vector<PartialTensorShape>& output_shapes() const override {
+    return shapes_;
+  }
+
+  string DebugString() const override {
+    name_utils::DatasetDebugStringParams params;
+    params.set_args(batch_size_);
+    return name_utils::DatasetDebugString(kDatasetType, params);
+  }
+
+  int64 Cardinality() const override {
+    return num_rows_ / batch_size_ +
+           (num_rows_ % batch_size_ == 0 || drop_remainder_ ? 0 : 1);
+  }
+
+  Status CheckExternalState() const override { return Status::OK(); }
+
+ protected:
+  Status AsGraphDefInternal(SerializationContext* ctx,
+                            DatasetGraphDefBuilder* b,
+                            Node** output) const override {
+    std::vector<Node*> columns;
+    columns.reserve(columns_.size());
+    for (const Tensor& t : columns_) {
+      Node* node;
+      if (ctx->serialize_data_tensors()) {
+        TF_RETURN_IF_ERROR(b->AddDatasetOrTensor(ctx, t, &node));
+      } else {
+        TF_RETURN_IF_ERROR(b->AddPlaceholder(t, &node));
+        DCHECK_NE(ctx->input_list(), nullptr);
+        ctx->input_list()->emplace_back(node->name(), t);
+      }
+      columns.emplace_back(node);
+    }
+    Node* batch_size = nullptr;
+    TF_RETURN_IF_ERROR(b->AddScalar(batch_size_, &batch_size));
+    Node* drop_remainder = nullptr;
+    TF_RETURN_IF_ERROR(b->AddScalar(drop_remainder_, &drop_remainder));
+    Node* seed = nullptr;
+    TF_RETURN_IF_ERROR(b->AddScalar(seeds_.first, &seed));
+    Node* seed2 = nullptr;
+    TF_RETURN_IF_ERROR(b->AddScalar(seeds_.second, &seed2));
+    AttrValue dtypes;
+    b->BuildAttrValue(dtypes_, &dtypes);
+    AttrValue shuffle;
+    b->BuildAttrValue(shuffle_, &shuffle);
+    TF_RETURN_IF_ERROR(b->AddDataset(
+        this, {{1, batch_size}, {2, drop_remainder}, {3, seed}, {4, seed2}},
+        {{0, columns}}, {{kTcolumns, dtypes}, {kShuffle, shuffle}}, output));
+    return Status::OK();
+  }
+
+ private:
+  class Iterator : public DatasetIterator<Dataset> {
+   public:
+    explicit Iterator(const Params& params)
+        : DatasetIterator<Dataset>(params),
+          seeds_(MaybeOverrideSeeds(params.dataset->seeds_)) {}
+
+    Status Initialize(IteratorContext* ctx) override {
+      mutex_lock l(mu_);
+      if (dataset()->shuffle_) ShuffleIndicesLocked();
+      return Status::OK();
+    }
+
+    Status GetNextInternal(IteratorContext* ctx,
+                           std::vector<Tensor>* out_tensors,
+                           bool* end_of_sequence) override {
+      const int64 num_rows = dataset()->num_rows_;
+      const int64 batch_size = dataset()->batch_size_;
+      mutex_lock l(mu_);
+      if (i_ >= num_rows ||
+          (dataset()->drop_remainder_ && num_rows - i_ < batch_size)) {
+        *end_of_sequence = true;
+        return Status::OK();
+      }
+      const int64 start = i_;
+      const int64 end = std::min(start + batch_size, num_rows);
+      i_ = end;
+
+      out_tensors->clear();
+      out_tensors->reserve(dataset()->columns_.size());
+      for (const Tensor& column : dataset()->columns_) {
+        if (indices_.empty()) {
+          // Consecutive rows are already contiguous in the column, so the
+          // batch can share its buffer, unless the slice would be misaligned
+          // for downstream kernels.
+          Tensor slice = column.Slice(start, end);
+          if (!slice.IsAligned()) slice = tensor::DeepCopy(slice);
+          out_tensors->push_back(std::move(slice));
+          continue;
+        }
+        TensorShape shape = column.shape();
+        shape.set_dim(0, end - start);
+        out_tensors->emplace_back(ctx->allocator({}), column.dtype(), shape);
+        for (int64 row = start; row < end; ++row) {
+          TF_RETURN_IF_ERROR(batch_util::CopyContiguousSlices(
+              column, indices_[row], row - start, /*num_slices=*/1,
+              &out_tensors->back()));
+        }
+      }
+      *end_of_sequence = false;
+      return Status::OK();
+    }
+
+   protected:
+    std::shared_ptr<model::Node> CreateNode(
+        IteratorContext* ctx, model::Node::Args args) const override {
+      return model::MakeSourceNode(std::move(args));
+    }
+
+    Status SaveInternal(SerializationContext* ctx,
+                        IteratorStateWriter* writer) override {
+      mutex_lock l(mu_);
+      TF_RETURN_IF_ERROR(writer->WriteScalar(full_name(kCurIndex), i_));
+      TF_RETURN_IF_ERROR(
+          writer->WriteScalar(full_name(kSeedState), seeds_.first));
+      TF_RETURN_IF_ERROR(
+          writer->WriteScalar(full_name(kSeed2State), seeds_.second));
+      return Status::OK();
+    }
+
+    Status RestoreInternal(IteratorContext* ctx,
+                           IteratorStateReader* reader) override {
+      mutex_lock l(mu_);
+      TF_RETURN_IF_ERROR(reader->ReadScalar(full_name(kCurIndex), &i_));
+      TF_RETURN_IF_ERROR(
+          reader->ReadScalar(full_name(kSeedState), &seeds_.first));
+      TF_RETURN_IF_ERROR(
+          reader->ReadScalar(full_name(kSeed2State), &seeds_.second));
+      if (dataset()->shuffle_) ShuffleIndicesLocked();
+      return Status::OK();
+    }
+
+   private:
+    // Permutes the row indices rather than the rows, so that shuffling never
+    // moves column data.
+    void ShuffleIndicesLocked() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      indices_.resize(dataset()->num_rows_);
+      std::iota(indices_.begin(), indices_.end(), 0);
+      random::PhiloxRandom parent_generator(seeds_.first, seeds_.second);
+      random::SingleSampleAdapter<random::PhiloxRandom> generator(
+          &parent_generator);
+      for (int64 i = indices_.size() - 1; i > 0; --i) {
+        std::swap(indices_[i], indices_[generator() % (i + 1)]);
+      }
+    }
+
+    mutex mu_;
+    int64 i_ TF_GUARDED_BY(mu_) = 0;
+    std::pair<int64, int64> seeds_ TF_GUARDED_BY(mu_);
+    // The order in which rows are produced, or empty to produce them in
+    // column order.
+    std::vector<int64> indices_ TF_GUARDED_BY(mu_);
+  };
+
+  const std::vector<Tensor> columns_;
+  const int64 num_rows_;
+  const int64 batch_size_;
+  const bool drop_remainder_;
+  const bool shuffle_;
+  const std::pair<int64, int64> seeds_;
+  DataTypeVector dtypes_;
+  std::vector<PartialTensorShape> shapes_;
+};
+
+ColumnarBatchDatasetOp::ColumnarBatchDatasetOp(OpKernelConstruction* ctx)
+    : DatasetOpKernel(ctx) {
+  OP_REQUIRES_OK(ctx, ctx->GetAttr(kShuffle, &shuffle_));
+  OP_REQUIRES_OK(ctx, ctx->GetAttr(kTcolumns, &output_types_));
+  OP_REQUIRES_OK(ctx, ctx->GetAttr(kOutputShapes, &output_shapes_));
+}
+
+void ColumnarBatchDatasetOp::MakeDataset(OpKernelContext* ctx,
+                                         DatasetBase** output) {
+  OpInputList inputs;
+  OP_REQUIRES_OK(ctx, ctx->input_list(kColumns, &inputs));
+  OP_REQUIRES(
+      ctx, inputs[0].dims() > 0,
+      errors::InvalidArgument("All columns must be at least 1-dimensional"));
+  const int64 num_rows = inputs[0].dim_size(0);
+  std::vector<Tensor> columns;
+  columns.reserve(inputs.size());
+  for (const Tensor& t : inputs) {
+    OP_REQUIRES(ctx, t.dims() > 0,
+                errors::InvalidArgument(
+                    "All columns must be at least 1-dimensional"));
+    OP_REQUIRES(
+        ctx, t.dim_size(0) == num_rows,
+        errors::InvalidArgument(
+            "All columns must have the same size in the 0th dimension"));
+    columns.push_back(t);
+  }
+
+  int64 batch_size;
+  OP_REQUIRES_OK(ctx,
+                 ParseScalarArgument<int64>(ctx, kBatchSize, &batch_size));
+  OP_REQUIRES(ctx, batch_size > 0,
+              errors::InvalidArgument("Batch size must be greater than zero."));
+  bool drop_remainder;
+  OP_REQUIRES_OK(
+      ctx, ParseScalarArgument<bool>(ctx, kDropRemainder, &drop_remainder));
+  int64 seed;
+  OP_REQUIRES_OK(ctx, ParseScalarArgument<int64>(ctx, kSeed, &seed));
+  int64 seed2;
+  OP_REQUIRES_OK(ctx, ParseScalarArgument<int64>(ctx, kSeed2, &seed2));
+
+  *output = new Dataset(ctx, std::move(columns), batch_size, drop_remainder,
+                        shuffle_, seed, seed2);
+  OP_REQUIRES_OK(ctx,
+                 VerifyTypesMatch((*output)->output_dtypes(), output_types_));
+  OP_REQUIRES_OK(
+      ctx, VerifyShapesCompatible((*output)->output_shapes(), output_shapes_));
+}
+
+namespace {
+
+REGISTER_KERNEL_BUILDER(Name("ColumnarBatchDataset").Device(DEVICE_CPU),
+                        ColumnarBatchDatasetOp);
+
+}  // namespace
+}  // namespace experimental
+}  // namespace data
+}  // namespace tensorflow
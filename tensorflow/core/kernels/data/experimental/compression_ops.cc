@@ -15,15 +15,27 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/data/experimental/compression_ops.h"
 
-#include "tensorflow/core/data/compression_utils.h"
 #include "tensorflow/core/platform/errors.h"
 
 namespace tensorflow {
 namespace data {
 namespace experimental {
 
+constexpr const char* const CompressElementOp::kCompression;
+constexpr const char* const CompressElementOp::kNone;
+constexpr const char* const CompressElementOp::kSnappy;
+constexpr const char* const CompressElementOp::kAuto;
+
 CompressElementOp::CompressElementOp(OpKernelConstruction* ctx)
-    : OpKernel(ctx) {}
+    : OpKernel(ctx) {
+  OP_REQUIRES_OK(ctx, ctx->GetAttr(kCompression, &compression_));
+  OP_REQUIRES(
+      ctx,
+      compression_ == kNone || compression_ == kSnappy || compression_ == kAuto,
+      errors::InvalidArgument("Unsupported compression: ", compression_,
+                              ". Expected one of \"", kNone, "\", \"",
+                              kSnappy, "\" or \"", kAuto, "\"."));
+}
 
 void CompressElementOp::Compute(OpKernelContext* ctx) {
   std::vector<Tensor> components;
@@ -31,7 +43,15 @@ void CompressElementOp::Compute(OpKernelContext* ctx) {
     components.push_back(ctx->input(i));
   }
   CompressedElement compressed;
-  OP_REQUIRES_OK(ctx, CompressElement(components, &compressed));
+  if (compression_ == kAuto) {
+    OP_REQUIRES_OK(ctx, adaptive_compressor_.Compress(components, &compressed));
+  } else {
+    OP_REQUIRES_OK(
+        ctx, CompressElement(components,
+                             compression_ == kNone ? CompressedElement::NONE
+                                                   : CompressedElement::SNAPPY,
+                             &compressed));
+  }
 
   Tensor* output;
   OP_REQUIRES_OK(ctx, ctx->allocate_output(0, TensorShape({}), &output));
@@ -15,6 +15,7 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_KERNELS_DATA_EXPERIMENTAL_COMPRESSION_OPS_H_
 #define TENSORFLOW_CORE_KERNELS_DATA_EXPERIMENTAL_COMPRESSION_OPS_H_
 
+#include "tensorflow/core/data/compression_utils.h"
 #include "tensorflow/core/framework/dataset.h"
 
 namespace tensorflow {
@@ -23,9 +24,20 @@ namespace experimental {
 
 class CompressElementOp : public OpKernel {
  public:
+  static constexpr const char* const kCompression = "compression";
+  static constexpr const char* const kNone = "none";
+  static constexpr const char* const kSnappy = "snappy";
+  static constexpr const char* const kAuto = "auto";
+
   explicit CompressElementOp(OpKernelConstruction* ctx);
 
   void Compute(OpKernelContext* ctx) override;
+
+ private:
+  std::string compression_;
+  // Used when `compression_` is `kAuto`, so that the skipping decisions are
+  // shared by all elements compressed by this kernel.
+  AdaptiveElementCompressor adaptive_compressor_;
 };
 
 class UncompressElementOp : public OpKernel {
@@ -12,6 +12,8 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
+#include <cstring>
+
 #include "tensorflow/core/framework/common_shape_fns.h"
 #include "tensorflow/core/framework/dataset.h"
 #include "tensorflow/core/framework/op.h"
@@ -26,6 +28,43 @@ namespace data {
 namespace experimental {
 namespace {
 
+// Returns a word with every byte set to `c`.
+constexpr uint64 Broadcast(unsigned char c) {
+  return 0x0101010101010101ULL * c;
+}
+
+// Returns a nonzero value iff some byte of `word` is zero.
+inline uint64 HasZeroByte(uint64 word) {
+  return (word - Broadcast(0x01)) & ~word & Broadcast(0x80);
+}
+
+// Returns the position of the first byte in `data[pos, size)` that can end
+// an unquoted field: `delim`, a line break, or (if `use_quote_delim`) a
+// quotation mark. Returns `size` if there is none. Compares eight bytes at a
+// time, since most bytes of a record are field contents.
+size_t FindUnquotedFieldEnd(const char* data, size_t pos, size_t size,
+                            char delim, bool use_quote_delim) {
+  const uint64 delims = Broadcast(delim);
+  // Without quote delimiting, look for a second line break in place of quotes.
+  const uint64 quotes = Broadcast(use_quote_delim ? '"' : '\n');
+  for (; pos + sizeof(uint64) <= size; pos += sizeof(uint64)) {
+    uint64 word;
+    std::memcpy(&word, data + pos, sizeof(word));
+    if (HasZeroByte(word ^ delims) | HasZeroByte(word ^ Broadcast('\n')) |
+        HasZeroByte(word ^ Broadcast('\r')) | HasZeroByte(word ^ quotes)) {
+      break;
+    }
+  }
+  for (; pos < size; ++pos) {
+    const char ch = data[pos];
+    if (ch == delim || ch == '\n' || ch == '\r' ||
+        (use_quote_delim && ch == '"')) {
+      break;
+    }
+  }
+  return pos;
+}
+
 class CSVDatasetOp : public DatasetOpKernel {
  public:
   explicit CSVDatasetOp(OpKernelConstruction* ctx)
@@ -556,7 +595,13 @@ class CSVDatasetOp : public DatasetOpKernel {
             }
 
           } else {
-            pos_++;
+            // Skip ahead to the next quote, which is the only character that
+            // can end a quoted field.
+            const void* next_quote = std::memchr(
+                buffer_.data() + pos_, '"', buffer_.size() - pos_);
+            pos_ = next_quote == nullptr
+                       ? buffer_.size()
+                       : static_cast<const char*>(next_quote) - buffer_.data();
           }
         }
       }
@@ -651,6 +696,10 @@ class CSVDatasetOp : public DatasetOpKernel {
             }
           }
 
+          pos_ = FindUnquotedFieldEnd(buffer_.data(), pos_, buffer_.size(),
+                                      dataset()->delim_,
+                                      dataset()->use_quote_delim_);
+          if (pos_ >= buffer_.size()) continue;
           char ch = buffer_[pos_];
 
           if (ch == dataset()->delim_) {
@@ -671,12 +720,10 @@ class CSVDatasetOp : public DatasetOpKernel {
             if (ch == '\r') SkipNewLineIfNecessary();
             return parse_result;
           }
-          if (dataset()->use_quote_delim_ && ch == '"') {
-            // Take note of the error, but keep going to end of field.
-            parse_result.Update(errors::InvalidArgument(
-                "Unquoted fields cannot have quotes inside"));
-          }
-          // Otherwise, go to next character
+          // Otherwise this is a quote. Take note of the error, but keep going
+          // to end of field.
+          parse_result.Update(errors::InvalidArgument(
+              "Unquoted fields cannot have quotes inside"));
           pos_++;
         }
       }
@@ -65,6 +65,15 @@ const int64 kRetryTimeoutMicros = 1000LL * 1000 * 60 * 60;  // 60 minutes.
 // Default interval between task list refreshes.
 const int64 kDefaultTaskRefreshIntervalMs = 1000;  // 1 second.
 
+// A single GetElements request fetches at most this many elements...
+const int64 kMaxElementsPerRequest = 64;
+// ... and stops adding elements once they add up to this many bytes.
+const int64 kMaxBytesPerRequest = 4 << 20;  // 4 MB.
+// When `max_outstanding_requests` is autotuned, this many elements may be
+// buffered or requested for each task, so that each round trip to a worker can
+// fetch several elements.
+const int64 kAutotuneElementsPerTask = 8;
+
 }  // namespace
 
 // Dataset for reading data from the tf.data service non-deterministically.
@@ -388,13 +397,17 @@ class DataServiceDatasetOp::Dataset : public DatasetBase {
       }
       if (dataset()->max_outstanding_requests_ == model::kAutotune) {
         // Adjust max_outstanding_requests to account for newly added tasks.
-        max_outstanding_requests_ = tasks_.size();
+        max_outstanding_requests_ = tasks_.size() * kAutotuneElementsPerTask;
       }
     }
 
     void UpdateWorkerThreads(IteratorContext* ctx) LOCKS_EXCLUDED(mu_) {
       mutex_lock l(mu_);
-      while (num_running_worker_threads_ < max_outstanding_requests_) {
+      // Each task is processed by at most one thread at a time, so more
+      // threads than tasks would sit idle.
+      const int64 max_threads =
+          std::min<int64>(max_outstanding_requests_, tasks_.size());
+      while (num_running_worker_threads_ < max_threads) {
         num_running_worker_threads_++;
         outstanding_requests_++;
         auto done = [this]() {
@@ -416,6 +429,7 @@ class DataServiceDatasetOp::Dataset : public DatasetBase {
       });
       VLOG(1) << "Starting worker thread";
       std::shared_ptr<Task> task_to_process;
+      int64 num_elements = 0;
       while (true) {
         {
           mutex_lock l(mu_);
@@ -453,14 +467,19 @@ class DataServiceDatasetOp::Dataset : public DatasetBase {
             }
           }
           DCHECK(task_to_process != nullptr);
-          VLOG(3) << "Processing task " << task_to_process->task_id;
+          num_elements = ElementsPerRequest();
+          reserved_elements_ += num_elements;
+          VLOG(3) << "Processing task " << task_to_process->task_id
+                  << ", requesting up to " << num_elements << " elements";
         }
         int64 deadline_micros =
             Env::Default()->NowMicros() + kRetryTimeoutMicros;
-        Status s = GetElement(task_to_process.get(), deadline_micros);
+        Status s =
+            GetElements(task_to_process.get(), num_elements, deadline_micros);
+        mutex_lock l(mu_);
+        reserved_elements_ -= num_elements;
         if (!s.ok()) {
-          mutex_lock l(mu_);
-          VLOG(1) << "Failed to get element for task "
+          VLOG(1) << "Failed to get elements for task "
                   << task_to_process->task_id << ": " << s;
           task_to_process->in_use = false;
           status_ = s;
@@ -470,21 +489,24 @@ class DataServiceDatasetOp::Dataset : public DatasetBase {
       }
     }
 
-    // Gets an element from a task and adds the element to `results_`.
+    // Gets up to `num_elements` elements from a task in one round trip and
+    // adds them to `results_`.
     //
     // If the task reaches end_of_sequence or is cancelled (e.g. due to a
-    // worker dying), GetElement returns Status::OK() without adding to
-    // `results_`.
-    Status GetElement(Task* task, int64 deadline_micros)
+    // worker dying), GetElements returns Status::OK() after adding the
+    // elements it got, if any, to `results_`.
+    Status GetElements(Task* task, int64 num_elements, int64 deadline_micros)
         TF_LOCKS_EXCLUDED(mu_) {
-      VLOG(3) << "Getting an element for task id " << task->task_id;
+      VLOG(3) << "Getting " << num_elements << " elements for task id "
+              << task->task_id;
       tensorflow::profiler::TraceMe activity(
           "GetDataServiceElement", tensorflow::profiler::TraceMeLevel::kInfo);
-      CompressedElement compressed;
+      std::vector<CompressedElement> compressed;
       bool end_of_sequence;
       for (int num_retries = 0;; ++num_retries) {
-        Status s = task->worker->GetElement(task->task_id, &compressed,
-                                            &end_of_sequence);
+        Status s = task->worker->GetElements(task->task_id, num_elements,
+                                             kMaxBytesPerRequest, &compressed,
+                                             &end_of_sequence);
         if (s.ok()) {
           break;
         }
@@ -517,27 +539,40 @@ class DataServiceDatasetOp::Dataset : public DatasetBase {
         Env::Default()->SleepForMicroseconds(backoff_until - now_micros);
       }
 
-      std::vector<Tensor> element;
-      if (!end_of_sequence) {
+      mutex_lock l(mu_);
+      for (CompressedElement& element : compressed) {
         Tensor tensor(DT_VARIANT, TensorShape{});
-        tensor.scalar<Variant>()() = std::move(compressed);
-        element.push_back(tensor);
+        tensor.scalar<Variant>()() = std::move(element);
+        results_.push({std::move(tensor)});
       }
-      mutex_lock l(mu_);
+      if (!compressed.empty()) {
+        get_next_cv_.notify_all();
+      }
+      VLOG(3) << "Got " << compressed.size() << " elements for task id "
+              << task->task_id;
       if (end_of_sequence) {
         task->end_of_sequence = true;
         finished_tasks_++;
-        return Status::OK();
       }
-      results_.push(std::move(element));
-      get_next_cv_.notify_all();
-      VLOG(3) << "Got an element for task id " << task->task_id;
       return Status::OK();
     }
 
     bool SpaceInBuffer() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
-      return results_.size() + outstanding_requests_ <
-             max_outstanding_requests_;
+      return results_.size() + reserved_elements_ < max_outstanding_requests_;
+    }
+
+    // Returns how many elements the next request should ask for. The free
+    // space in the buffer is shared between the tasks waiting for a request,
+    // so requests grow when the consumer keeps the buffer drained, and shrink
+    // to single elements when it falls behind.
+    int64 ElementsPerRequest() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      int64 free_space =
+          max_outstanding_requests_ - results_.size() - reserved_elements_;
+      // The calling thread is already counted in `outstanding_requests_`.
+      int64 waiting_tasks = std::max<int64>(
+          tasks_.size() - finished_tasks_ - outstanding_requests_ + 1, 1);
+      return std::max<int64>(
+          std::min(free_space / waiting_tasks, kMaxElementsPerRequest), 1);
     }
 
     bool TaskAvailable() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
@@ -555,6 +590,8 @@ class DataServiceDatasetOp::Dataset : public DatasetBase {
     std::function<void()> deregister_fn_;
 
     int64 outstanding_requests_ TF_GUARDED_BY(mu_) = 0;
+    // The number of elements asked for by in-progress requests.
+    int64 reserved_elements_ TF_GUARDED_BY(mu_) = 0;
     // max_outstanding_requests controls how many elements may be held in memory
     // at the same time. This count includes both in-progress requests for
     // elements as well as completed requests which haven't yet been produced.
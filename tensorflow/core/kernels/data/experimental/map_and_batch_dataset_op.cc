@@ -553,22 +553,11 @@ class MapAndBatchDatasetOp::Dataset : public DatasetBase {
           *end_of_sequence = true;
           return Status::OK();
         }
-        const std::vector<Tensor>& output = result->output;
-        for (size_t i = 0; i < output.size(); ++i) {
-          TensorShape component_shape(result->output[i].shape());
-          component_shape.set_dim(0, result->num_elements);
-          AllocatorAttributes attr;
-          attr.set_gpu_compatible(true);
-          out_tensors->emplace_back(ctx->allocator(attr), output[i].dtype(),
-                                    component_shape);
-          if (!out_tensors->back().IsInitialized()) {
-            return errors::ResourceExhausted(
-                "Failed to allocate memory for the batch of component ", i);
-          }
-          TF_RETURN_IF_ERROR(CopyPartialBatch(&out_tensors->back(), output[i],
-                                              result->num_elements));
+        // The partial batch is a prefix of the tensors allocated for a full
+        // batch, so slice them instead of copying the prefix.
+        for (const Tensor& output : result->output) {
+          out_tensors->push_back(output.Slice(0, result->num_elements));
         }
-        // Deallocate tensors allocated for the output.
         result->output.clear();
       } else {
         *out_tensors = std::move(result->output);
@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/data/experimental/snapshot_util.h"
 
+#include <algorithm>
 #include <queue>
 
 #include "absl/memory/memory.h"
@@ -23,6 +24,7 @@ limitations under the License.
 #include "tensorflow/core/framework/graph.pb.h"
 #include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/kernels/data/name_utils.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
 #include "tensorflow/core/lib/io/buffered_inputstream.h"
 #include "tensorflow/core/lib/io/random_inputstream.h"
 #include "tensorflow/core/lib/io/record_writer.h"
@@ -32,6 +34,7 @@ limitations under the License.
 #include "tensorflow/core/lib/io/zlib_inputstream.h"
 #include "tensorflow/core/lib/io/zlib_outputbuffer.h"
 #include "tensorflow/core/platform/coding.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/file_system.h"
 #include "tensorflow/core/platform/path.h"
@@ -39,6 +42,7 @@ limitations under the License.
 #include "tensorflow/core/platform/stringprintf.h"
 #include "tensorflow/core/profiler/lib/traceme.h"
 #include "tensorflow/core/protobuf/data/experimental/snapshot.pb.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 namespace data {
@@ -48,6 +52,31 @@ namespace snapshot_util {
     CustomReader::kSnappyReaderInputBufferSizeBytes;
 /* static */ constexpr const int64
     CustomReader::kSnappyReaderOutputBufferSizeBytes;
+/* static */ constexpr const int CustomReader::kMaxDecompressionThreads;
+/* static */ constexpr const int CustomReader::kElementsPerDecompressionThread;
+/* static */ constexpr const int64 CustomReader::kMaxDecompressionBatchBytes;
+
+namespace {
+
+// Returns the number of threads a reader uses to decompress version 1 snappy
+// elements, read from TF_DATA_SNAPSHOT_DECOMPRESSION_THREADS. Zero or less
+// picks a count from the number of available cores.
+int NumDecompressionThreads() {
+  int64 num_threads;
+  Status s = ReadInt64FromEnvVar("TF_DATA_SNAPSHOT_DECOMPRESSION_THREADS",
+                                 /*default_val=*/0, &num_threads);
+  if (!s.ok()) {
+    LOG(ERROR) << "Invalid TF_DATA_SNAPSHOT_DECOMPRESSION_THREADS: " << s;
+    num_threads = 0;
+  }
+  if (num_threads <= 0) {
+    return std::min(port::MaxParallelism(),
+                    CustomReader::kMaxDecompressionThreads);
+  }
+  return static_cast<int>(num_threads);
+}
+
+}  // namespace
 
 std::string HashDirectory(const std::string& path, uint64 hash) {
   return io::JoinPath(
@@ -656,6 +685,12 @@ Status CustomReader::Initialize(Env* env) {
     } else {
       input_stream_ =
           absl::make_unique<io::BufferedInputStream>(file_.get(), 64 << 20);
+      num_decompression_threads_ = NumDecompressionThreads();
+      if (num_decompression_threads_ > 1) {
+        thread_pool_ = absl::make_unique<thread::ThreadPool>(
+            env, ThreadOptions(), "snapshot_decompression",
+            num_decompression_threads_, /*low_latency_hint=*/false);
+      }
     }
   }
 #endif  // IS_SLIM_BUILD
@@ -688,9 +723,59 @@ Status CustomReader::ReadTensors(std::vector<Tensor>* read_tensors) {
                                    " is not supported.");
   }
 
-  experimental::SnapshotTensorMetadata metadata;
+  if (thread_pool_ != nullptr) {
+    return ReadTensorsParallel(read_tensors);
+  }
+
   tstring metadata_str;
   TF_RETURN_IF_ERROR(ReadRecord(&metadata_str));
+  tstring compressed;
+  TF_RETURN_IF_ERROR(ReadRecord(&compressed));
+  return ParseTensors(metadata_str, compressed, read_tensors);
+}
+
+Status CustomReader::ReadTensorsParallel(std::vector<Tensor>* read_tensors) {
+  if (ready_.empty()) {
+    TF_RETURN_IF_ERROR(read_status_);
+    // Elements are stored independently compressed, so only reading the
+    // records has to be sequential.
+    std::vector<std::pair<tstring, tstring>> records;
+    const int max_elements =
+        num_decompression_threads_ * kElementsPerDecompressionThread;
+    int64 batch_bytes = 0;
+    while (static_cast<int>(records.size()) < max_elements &&
+           batch_bytes < kMaxDecompressionBatchBytes) {
+      std::pair<tstring, tstring> record;
+      read_status_ = ReadRecord(&record.first);
+      if (read_status_.ok()) read_status_ = ReadRecord(&record.second);
+      if (!read_status_.ok()) break;
+      batch_bytes += record.first.size() + record.second.size();
+      records.push_back(std::move(record));
+    }
+    if (records.empty()) return read_status_;
+
+    ready_.resize(records.size());
+    BlockingCounter counter(records.size());
+    for (int i = 0, end = records.size(); i < end; ++i) {
+      thread_pool_->Schedule([this, &records, &counter, i]() {
+        auto& element = ready_[i];
+        element.first = ParseTensors(records[i].first, records[i].second,
+                                     &element.second);
+        counter.DecrementCount();
+      });
+    }
+    counter.Wait();
+  }
+  Status s = ready_.front().first;
+  *read_tensors = std::move(ready_.front().second);
+  ready_.pop_front();
+  return s;
+}
+
+Status CustomReader::ParseTensors(const tstring& metadata_str,
+                                  const tstring& compressed,
+                                  std::vector<Tensor>* read_tensors) const {
+  experimental::SnapshotTensorMetadata metadata;
   if (!metadata.ParseFromArray(metadata_str.data(), metadata_str.size())) {
     return errors::DataLoss("Could not parse SnapshotTensorMetadata");
   }
@@ -700,8 +785,8 @@ Status CustomReader::ReadTensors(std::vector<Tensor>* read_tensors) {
   simple_tensors.reserve(num_simple_);
   std::vector<std::pair<std::unique_ptr<char[]>, size_t>> tensor_proto_strs;
   tensor_proto_strs.reserve(num_complex_);
-  TF_RETURN_IF_ERROR(
-      SnappyUncompress(&metadata, &simple_tensors, &tensor_proto_strs));
+  TF_RETURN_IF_ERROR(SnappyUncompress(&metadata, compressed, &simple_tensors,
+                                      &tensor_proto_strs));
 
   int simple_index = 0;
   int complex_index = 0;
@@ -760,11 +845,9 @@ Status CustomReader::ReadTensorsV0(std::vector<Tensor>* read_tensors) {
 
 Status CustomReader::SnappyUncompress(
     const experimental::SnapshotTensorMetadata* metadata,
-    std::vector<Tensor>* simple_tensors,
+    const tstring& compressed, std::vector<Tensor>* simple_tensors,
     std::vector<std::pair<std::unique_ptr<char[]>, size_t>>*
-        tensor_proto_strs) {
-  tstring compressed;
-  TF_RETURN_IF_ERROR(ReadRecord(&compressed));
+        tensor_proto_strs) const {
   size_t size;
   if (!port::Snappy_GetUncompressedLength(compressed.data(), compressed.size(),
                                           &size)) {
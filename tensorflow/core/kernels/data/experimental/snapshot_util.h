@@ -16,6 +16,8 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_KERNELS_DATA_EXPERIMENTAL_SNAPSHOT_UTIL_H_
 #define TENSORFLOW_CORE_KERNELS_DATA_EXPERIMENTAL_SNAPSHOT_UTIL_H_
 
+#include <deque>
+
 #include "tensorflow/core/framework/dataset.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/types.h"
@@ -27,6 +29,7 @@ limitations under the License.
 #include "tensorflow/core/platform/file_system.h"
 #include "tensorflow/core/platform/path.h"
 #include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/threadpool.h"
 
 namespace tensorflow {
 
@@ -238,6 +241,13 @@ class CustomReader : public Reader {
   static constexpr const int64 kSnappyReaderOutputBufferSizeBytes =
       32 << 20;  // 32 MiB
   static constexpr const size_t kHeaderSize = sizeof(uint64);
+  // Upper bound on the number of threads used to decompress snappy elements
+  // when the thread count is picked automatically.
+  static constexpr const int kMaxDecompressionThreads = 8;
+  // Each batch read ahead for parallel decompression holds up to this many
+  // elements per decompression thread, and at most this many compressed bytes.
+  static constexpr const int kElementsPerDecompressionThread = 4;
+  static constexpr const int64 kMaxDecompressionBatchBytes = 64 << 20;
 
   static constexpr const char* const kClassName = "SnapshotReader";
   static constexpr const char* const kReadString = "ReadString";
@@ -257,11 +267,21 @@ class CustomReader : public Reader {
  private:
   Status ReadTensorsV0(std::vector<Tensor>* read_tensors);
 
+  // Reads a batch of elements ahead and decompresses them on `thread_pool_`,
+  // then returns them one at a time, in file order.
+  Status ReadTensorsParallel(std::vector<Tensor>* read_tensors);
+
+  // Parses a version 1 snappy element from its metadata and compressed
+  // records. Does not touch the input stream, so it is safe to call
+  // concurrently.
+  Status ParseTensors(const tstring& metadata_str, const tstring& compressed,
+                      std::vector<Tensor>* read_tensors) const;
+
   Status SnappyUncompress(
       const experimental::SnapshotTensorMetadata* metadata,
-      std::vector<Tensor>* simple_tensors,
+      const tstring& compressed, std::vector<Tensor>* simple_tensors,
       std::vector<std::pair<std::unique_ptr<char[]>, size_t>>*
-          tensor_proto_strs);
+          tensor_proto_strs) const;
 
   Status ReadRecord(tstring* record);
 
@@ -278,6 +298,15 @@ class CustomReader : public Reader {
   int num_simple_ = 0;
   int num_complex_ = 0;
   std::vector<bool> simple_tensor_mask_;  // true for simple, false for complex.
+
+  // Set when version 1 snappy elements are decompressed on more than one
+  // thread.
+  std::unique_ptr<thread::ThreadPool> thread_pool_;
+  int num_decompression_threads_ = 1;
+  // Elements decompressed ahead of the caller, and the status to return once
+  // they are consumed.
+  std::deque<std::pair<Status, std::vector<Tensor>>> ready_;
+  Status read_status_;
 };
 
 // Writes snapshot metadata to the given directory.
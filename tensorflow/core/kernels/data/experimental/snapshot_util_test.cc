@@ -91,6 +91,48 @@ TEST(SnapshotUtilTest, CombinationRoundTripTest) {
   SnapshotRoundTrip(io::compression::kSnappy, 2);
 }
 
+TEST(SnapshotUtilTest, ParallelDecompressionRoundTripTest) {
+  for (const char* num_threads : {"1", "4"}) {
+    setenv("TF_DATA_SNAPSHOT_DECOMPRESSION_THREADS", num_threads,
+           /*overwrite=*/1);
+    SnapshotRoundTrip(io::compression::kSnappy, 1);
+  }
+  unsetenv("TF_DATA_SNAPSHOT_DECOMPRESSION_THREADS");
+}
+
+TEST(SnapshotUtilTest, ParallelDecompressionEndOfFile) {
+  setenv("TF_DATA_SNAPSHOT_DECOMPRESSION_THREADS", "4", /*overwrite=*/1);
+  std::vector<Tensor> tensors;
+  tensorflow::DataTypeVector dtypes;
+  GenerateTensorVector(dtypes, tensors);
+
+  std::string filename;
+  EXPECT_TRUE(Env::Default()->LocalTempFilename(&filename));
+  std::unique_ptr<Writer> writer;
+  TF_ASSERT_OK(Writer::Create(Env::Default(), filename,
+                              io::compression::kSnappy, 1, dtypes, &writer));
+  // Not a multiple of the read-ahead batch size.
+  for (int i = 0; i < 21; ++i) {
+    TF_ASSERT_OK(writer->WriteTensors(tensors));
+  }
+  TF_ASSERT_OK(writer->Close());
+
+  std::unique_ptr<Reader> reader;
+  TF_ASSERT_OK(Reader::Create(Env::Default(), filename,
+                              io::compression::kSnappy, 1, dtypes, &reader));
+  for (int i = 0; i < 21; ++i) {
+    std::vector<Tensor> read_tensors;
+    TF_ASSERT_OK(reader->ReadTensors(&read_tensors));
+    EXPECT_EQ(tensors.size(), read_tensors.size());
+  }
+  std::vector<Tensor> read_tensors;
+  EXPECT_TRUE(errors::IsOutOfRange(reader->ReadTensors(&read_tensors)));
+  EXPECT_TRUE(errors::IsOutOfRange(reader->ReadTensors(&read_tensors)));
+
+  TF_ASSERT_OK(Env::Default()->DeleteFile(filename));
+  unsetenv("TF_DATA_SNAPSHOT_DECOMPRESSION_THREADS");
+}
+
 void SnapshotReaderBenchmarkLoop(int iters, std::string compression_type,
                                  int version) {
   tensorflow::testing::StopTiming();
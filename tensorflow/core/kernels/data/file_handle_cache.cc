@@ -0,0 +1,83 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/data/file_handle_cache.h"
+
+#include "tensorflow/core/framework/metrics.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/util/env_var.h"
+
+namespace tensorflow {
+namespace data {
+
+FileHandleCache::FileHandleCache(int64 capacity) : capacity_(capacity) {}
+
+/* static */ FileHandleCache* FileHandleCache::Global() {
+  static FileHandleCache* cache = []() -> FileHandleCache* {
+    int64 capacity;
+    Status s = ReadInt64FromEnvVar("TF_DATA_FILE_HANDLE_CACHE_SIZE", 0,
+                                   &capacity);
+    if (!s.ok()) {
+      LOG(ERROR) << s;
+      return nullptr;
+    }
+    if (capacity <= 0) return nullptr;
+    return new FileHandleCache(capacity);
+  }();
+  return cache;
+}
+
+Status FileHandleCache::Lookup(Env* env, const string& filename,
+                               std::shared_ptr<RandomAccessFile>* file) {
+  {
+    mutex_lock l(mu_);
+    auto it = cache_.find(filename);
+    if (it != cache_.end()) {
+      lru_list_.splice(lru_list_.begin(), lru_list_, it->second);
+      *file = it->second->second;
+      metrics::RecordTFDataFileHandleCacheLookup(/*hit=*/true);
+      return Status::OK();
+    }
+  }
+  metrics::RecordTFDataFileHandleCacheLookup(/*hit=*/false);
+  // Open the file without holding the lock, since opening a remote file can
+  // take a long time.
+  std::unique_ptr<RandomAccessFile> new_file;
+  TF_RETURN_IF_ERROR(env->NewRandomAccessFile(filename, &new_file));
+  *file = std::move(new_file);
+
+  mutex_lock l(mu_);
+  auto it = cache_.find(filename);
+  if (it != cache_.end()) {
+    // Another thread opened the file concurrently; keep its handle.
+    lru_list_.splice(lru_list_.begin(), lru_list_, it->second);
+    *file = it->second->second;
+    return Status::OK();
+  }
+  lru_list_.emplace_front(filename, *file);
+  cache_[filename] = lru_list_.begin();
+  while (static_cast<int64>(lru_list_.size()) > capacity_) {
+    cache_.erase(lru_list_.back().first);
+    lru_list_.pop_back();
+  }
+  return Status::OK();
+}
+
+int64 FileHandleCache::Size() {
+  mutex_lock l(mu_);
+  return lru_list_.size();
+}
+
+}  // namespace data
+}  // namespace tensorflow
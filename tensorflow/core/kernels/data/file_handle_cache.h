@@ -0,0 +1,79 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_KERNELS_DATA_FILE_HANDLE_CACHE_H_
+#define TENSORFLOW_CORE_KERNELS_DATA_FILE_HANDLE_CACHE_H_
+
+#include <list>
+#include <memory>
+#include <utility>
+
+#include "absl/container/flat_hash_map.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/file_system.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace data {
+
+// An LRU cache of open `RandomAccessFile`s, keyed by file name.
+//
+// File datasets that read many small files open every file again in each
+// epoch, which is dominated by the open itself (and, on remote filesystems,
+// by its metadata lookups). Sharing the handles through this cache lets
+// iterators in later epochs and other pipelines skip the open. Handles are
+// shared, so a handle evicted while in use stays open until its last user
+// releases it.
+//
+// Cached handles are not revalidated, so the cache must not be used for files
+// that are rewritten while the process reads them.
+//
+// This class is thread-safe.
+class FileHandleCache {
+ public:
+  // Creates a cache holding at most `capacity` handles.
+  explicit FileHandleCache(int64 capacity);
+
+  // Returns the process-wide cache, sized by TF_DATA_FILE_HANDLE_CACHE_SIZE,
+  // or nullptr if the variable is unset or not positive.
+  static FileHandleCache* Global();
+
+  // Stores in `*file` an open handle to `filename`, opening it with `env` if
+  // it is not in the cache.
+  Status Lookup(Env* env, const string& filename,
+                std::shared_ptr<RandomAccessFile>* file);
+
+  // Returns the number of cached handles.
+  int64 Size();
+
+ private:
+  using LruList =
+      std::list<std::pair<string, std::shared_ptr<RandomAccessFile>>>;
+
+  const int64 capacity_;
+  mutex mu_;
+  // Most recently used handles first.
+  LruList lru_list_ TF_GUARDED_BY(mu_);
+  absl::flat_hash_map<string, LruList::iterator> cache_ TF_GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(FileHandleCache);
+};
+
+}  // namespace data
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_DATA_FILE_HANDLE_CACHE_H_
@@ -0,0 +1,82 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/data/file_handle_cache.h"
+
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/path.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+string WriteFile(const string& name, const string& contents) {
+  string filename = io::JoinPath(testing::TmpDir(), name);
+  TF_CHECK_OK(WriteStringToFile(Env::Default(), filename, contents));
+  return filename;
+}
+
+TEST(FileHandleCacheTest, ReusesHandles) {
+  const string filename = WriteFile("reuse", "abc");
+  FileHandleCache cache(/*capacity=*/2);
+  std::shared_ptr<RandomAccessFile> first, second;
+  TF_ASSERT_OK(cache.Lookup(Env::Default(), filename, &first));
+  TF_ASSERT_OK(cache.Lookup(Env::Default(), filename, &second));
+  EXPECT_EQ(first.get(), second.get());
+  EXPECT_EQ(cache.Size(), 1);
+
+  StringPiece result;
+  char scratch[3];
+  TF_ASSERT_OK(second->Read(0, 3, &result, scratch));
+  EXPECT_EQ(result, "abc");
+}
+
+TEST(FileHandleCacheTest, EvictsLeastRecentlyUsed) {
+  const string a = WriteFile("evict_a", "a");
+  const string b = WriteFile("evict_b", "b");
+  const string c = WriteFile("evict_c", "c");
+  FileHandleCache cache(/*capacity=*/2);
+  std::shared_ptr<RandomAccessFile> file_a, file_b, file_c, file;
+  TF_ASSERT_OK(cache.Lookup(Env::Default(), a, &file_a));
+  TF_ASSERT_OK(cache.Lookup(Env::Default(), b, &file_b));
+  // Makes `b` the least recently used handle.
+  TF_ASSERT_OK(cache.Lookup(Env::Default(), a, &file));
+  TF_ASSERT_OK(cache.Lookup(Env::Default(), c, &file_c));
+  EXPECT_EQ(cache.Size(), 2);
+
+  TF_ASSERT_OK(cache.Lookup(Env::Default(), a, &file));
+  EXPECT_EQ(file.get(), file_a.get());
+  TF_ASSERT_OK(cache.Lookup(Env::Default(), b, &file));
+  EXPECT_NE(file.get(), file_b.get());
+
+  // The evicted handle stays usable by its holder.
+  StringPiece result;
+  char scratch[1];
+  TF_ASSERT_OK(file_b->Read(0, 1, &result, scratch));
+  EXPECT_EQ(result, "b");
+}
+
+TEST(FileHandleCacheTest, MissingFile) {
+  FileHandleCache cache(/*capacity=*/2);
+  std::shared_ptr<RandomAccessFile> file;
+  EXPECT_TRUE(errors::IsNotFound(cache.Lookup(
+      Env::Default(), io::JoinPath(testing::TmpDir(), "missing"), &file)));
+  EXPECT_EQ(cache.Size(), 0);
+}
+
+}  // namespace
+}  // namespace data
+}  // namespace tensorflow
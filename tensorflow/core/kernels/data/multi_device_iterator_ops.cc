@@ -12,6 +12,7 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
+#include <cstring>
 #include <deque>
 
 #include "tensorflow/core/common_runtime/input_colocation_exemption_registry.h"
@@ -20,6 +21,7 @@ limitations under the License.
 #include "tensorflow/core/framework/dataset.h"
 #include "tensorflow/core/framework/function.h"
 #include "tensorflow/core/framework/function_handle_cache.h"
+#include "tensorflow/core/framework/metrics.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/resource_op_kernel.h"
 #include "tensorflow/core/kernels/data/dataset_utils.h"
@@ -30,6 +32,7 @@ limitations under the License.
 #include "tensorflow/core/lib/gtl/cleanup.h"
 #include "tensorflow/core/lib/random/random.h"
 #include "tensorflow/core/util/device_name_utils.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 namespace data {
@@ -49,6 +52,54 @@ struct HostBufferElement {
 using MultiDeviceIteratorCallback =
     std::function<void(const HostBufferElement&)>;
 
+// Returns whether elements for GPUs should be staged in host memory that the
+// GPUs can copy from asynchronously (e.g. pinned memory).
+bool StageInGpuCompatibleMemory() {
+  bool stage;
+  Status s = ReadBoolFromEnvVar("TF_DATA_MULTI_DEVICE_ITERATOR_PINNED_STAGING",
+                                /*default_val=*/false, &stage);
+  if (!s.ok()) {
+    LOG(ERROR) << s;
+    return false;
+  }
+  return stage;
+}
+
+bool IsGpuDevice(const string& device) {
+  DeviceNameUtils::ParsedName parsed;
+  return DeviceNameUtils::ParseFullName(device, &parsed) && parsed.has_type &&
+         parsed.type == DEVICE_GPU;
+}
+
+// Copies the components of `element` to host memory allocated with the
+// `gpu_compatible` attribute. When the element is later sent to a GPU, its
+// copy can then be issued on the GPU's host-to-device stream without an extra
+// synchronous copy out of pageable memory, overlapping with computation.
+Status CopyToGpuCompatibleMemory(IteratorContext* ctx,
+                                 std::vector<Tensor>* element) {
+  AllocatorAttributes attr;
+  attr.set_gpu_compatible(true);
+  Allocator* allocator = ctx->allocator(attr);
+  for (Tensor& component : *element) {
+    if (!DataTypeCanUseMemcpy(component.dtype()) ||
+        component.TotalBytes() == 0) {
+      continue;
+    }
+    Tensor staged(allocator, component.dtype(), component.shape());
+    if (!staged.IsInitialized()) {
+      return errors::ResourceExhausted(
+          "Failed to allocate ", component.TotalBytes(),
+          " bytes of GPU compatible host memory for a MultiDeviceIterator "
+          "element.");
+    }
+    const StringPiece src = component.tensor_data();
+    std::memcpy(const_cast<char*>(staged.tensor_data().data()), src.data(),
+                src.size());
+    component = std::move(staged);
+  }
+  return Status::OK();
+}
+
 class MultiDeviceIterator : public ResourceBase {
  public:
   MultiDeviceIterator(
@@ -68,6 +119,10 @@ class MultiDeviceIterator : public ResourceBase {
         pflr_(std::move(pflr)),
         function_handle_cache_(std::move(function_handle_cache)) {
     DCHECK(flr_ != nullptr);
+    const bool stage = StageInGpuCompatibleMemory();
+    for (const string& device : devices_) {
+      stage_in_gpu_compatible_memory_.push_back(stage && IsGpuDevice(device));
+    }
   }
 
   string DebugString() const override {
@@ -313,6 +368,16 @@ class MultiDeviceIterator : public ResourceBase {
 
         if (elem.status.ok() && elem.end_of_sequence) {
           end_of_iterator = true;
+        } else if (elem.status.ok()) {
+          if (parent_->stage_in_gpu_compatible_memory_[shard_to_fetch]) {
+            elem.status = CopyToGpuCompatibleMemory(ctx.get(), &elem.value);
+          }
+          int64 num_bytes = 0;
+          for (const Tensor& component : elem.value) {
+            num_bytes += component.TotalBytes();
+          }
+          metrics::RecordTFDataMultiDeviceIteratorBytes(
+              parent_->devices_[shard_to_fetch], num_bytes);
         }
 
         {
@@ -375,6 +440,8 @@ class MultiDeviceIterator : public ResourceBase {
   const DataTypeVector output_types_;
   const std::vector<PartialTensorShape> output_shapes_;
   const std::vector<string> devices_;
+  // Whether to stage the elements for each device in GPU compatible memory.
+  std::vector<bool> stage_in_gpu_compatible_memory_;
   const std::unique_ptr<FunctionLibraryDefinition> flib_def_;
   FunctionLibraryRuntime* const flr_ = nullptr;  // not owned.
   const std::unique_ptr<ProcessFunctionLibraryRuntime> pflr_;
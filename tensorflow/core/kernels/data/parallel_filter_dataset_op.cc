@@ -0,0 +1,654 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/data/parallel_filter_dataset_op.h"
+
+#include <deque>
+
+#include "tensorflow/core/common_runtime/function.h"
+#include "tensorflow/core/common_runtime/input_colocation_exemption_registry.h"
+#include "tensorflow/core/common_runtime/metrics.h"
+#include "tensorflow/core/framework/model.h"
+#include "tensorflow/core/framework/partial_tensor_shape.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/kernels/data/dataset_utils.h"
+#include "tensorflow/core/kernels/data/name_utils.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/gtl/cleanup.h"
+#include "tensorflow/core/platform/stringprintf.h"
+#include "tensorflow/core/profiler/lib/traceme.h"
+#include "tensorflow/core/profiler/lib/traceme_encode.h"
+#include "tensorflow/core/protobuf/error_codes.pb.h"
+
+namespace tensorflow {
+namespace data {
+
+// See documentation in ../../ops/dataset_ops.cc for a high-level
+// description of the following op.
+
+/* static */ constexpr const char* const ParallelFilterDatasetOp::kDatasetType;
+/* static */ constexpr const char* const ParallelFilterDatasetOp::kInputDataset;
+/* static */ constexpr const char* const
+    ParallelFilterDatasetOp::kOtherArguments;
+/* static */ constexpr const char* const
+    ParallelFilterDatasetOp::kNumParallelCalls;
+/* static */ constexpr const char* const ParallelFilterDatasetOp::kPredicate;
+/* static */ constexpr const char* const
+    ParallelFilterDatasetOp::kDeterministic;
+/* static */ constexpr const char* const ParallelFilterDatasetOp::kTarguments;
+/* static */ constexpr const char* const ParallelFilterDatasetOp::kOutputTypes;
+/* static */ constexpr const char* const ParallelFilterDatasetOp::kOutputShapes;
+
+namespace {
+
+constexpr char kInvocationResults[] = "invocation_results";
+constexpr char kSizeSuffix[] = ".size";
+constexpr char kEndOfInputSuffix[] = ".end_of_input";
+constexpr char kPredicateValueSuffix[] = ".predicate_value";
+constexpr char kCodeSuffix[] = ".code";
+constexpr char kErrorMessage[] = ".error_message";
+
+}  // namespace
+
+class ParallelFilterDatasetOp::Dataset : public DatasetBase {
+ public:
+  Dataset(OpKernelContext* ctx, const DatasetBase* input,
+          int64 num_parallel_calls, DeterminismPolicy deterministic,
+          std::unique_ptr<CapturedFunction> captured_func)
+      : DatasetBase(DatasetContext(ctx)),
+        input_(input),
+        num_parallel_calls_(num_parallel_calls),
+        deterministic_(deterministic),
+        captured_func_(std::move(captured_func)) {
+    input_->Ref();
+  }
+
+  ~Dataset() override { input_->Unref(); }
+
+  std::unique_ptr<IteratorBase> MakeIteratorInternal(
+      const string& prefix) const override {
+    return absl::make_unique<Iterator>(Iterator::Params{
+        this, name_utils::IteratorPrefix(kDatasetType, prefix)});
+  }
+
+  const DataTypeVector& output_dtypes() const override {
+    return input_->output_dtypes();
+  }
+
+  const std::vector<PartialTensorShape>& output_shapes() const override {
+    return input_->output_shapes();
+  }
+
+  string DebugString() const override {
+    return name_utils::DatasetDebugString(kDatasetType);
+  }
+
+  Status CheckExternalState() const override {
+    TF_RETURN_IF_ERROR(captured_func_->CheckExternalState());
+    return input_->CheckExternalState();
+  }
+
+ protected:
+  Status AsGraphDefInternal(SerializationContext* ctx,
+                            DatasetGraphDefBuilder* b,
+                            Node** output) const override {
+    // Input: input_dataset
+    Node* input_graph_node = nullptr;
+    TF_RETURN_IF_ERROR(b->AddInputDataset(ctx, input_, &input_graph_node));
+
+    // Input: other_arguments
+    std::vector<Node*> other_arguments;
+    DataTypeVector other_arguments_types;
+    TF_RETURN_IF_ERROR(captured_func_->AddToGraph(ctx, b, &other_arguments,
+                                                  &other_arguments_types));
+
+    // Input: num_parallel_calls
+    Node* num_parallel_calls = nullptr;
+    TF_RETURN_IF_ERROR(b->AddScalar(num_parallel_calls_, &num_parallel_calls));
+
+    // Attr: predicate
+    AttrValue predicate_attr;
+    b->BuildAttrValue(captured_func_->func(), &predicate_attr);
+
+    // Attr: deterministic
+    AttrValue deterministic_attr;
+    b->BuildAttrValue(deterministic_.String(), &deterministic_attr);
+
+    // Attr: Targuments
+    AttrValue other_arguments_types_attr;
+    b->BuildAttrValue(other_arguments_types, &other_arguments_types_attr);
+
+    TF_RETURN_IF_ERROR(
+        b->AddDataset(this,
+                      {std::make_pair(0, input_graph_node),
+                       std::make_pair(2, num_parallel_calls)},
+                      {std::make_pair(1, other_arguments)},
+                      {std::make_pair(kPredicate, predicate_attr),
+                       std::make_pair(kDeterministic, deterministic_attr),
+                       std::make_pair(kTarguments, other_arguments_types_attr)},
+                      output));
+    return Status::OK();
+  }
+
+ private:
+  class Iterator : public DatasetIterator<Dataset> {
+   public:
+    explicit Iterator(const Params& params)
+        : DatasetIterator<Dataset>(params),
+          mu_(std::make_shared<mutex>()),
+          cond_var_(std::make_shared<condition_variable>()),
+          num_parallel_calls_(std::make_shared<model::SharedState>(
+              params.dataset->num_parallel_calls_, mu_, cond_var_)),
+          deterministic_(params.dataset->deterministic_.IsDeterministic() ||
+                         params.dataset->deterministic_.IsDefault()),
+          autotune_(params.dataset->num_parallel_calls_ == model::kAutotune) {}
+
+    ~Iterator() override {
+      CancelThreads(/*wait=*/true);
+      if (deregister_fn_) deregister_fn_();
+    }
+
+    Status Initialize(IteratorContext* ctx) override {
+      mutex_lock l(*mu_);
+      if (num_parallel_calls_->value == model::kAutotune) {
+        num_parallel_calls_->value = ctx->runner_threadpool_size();
+      }
+      TF_RETURN_IF_ERROR(RegisterCancellationCallback(
+          ctx->cancellation_manager(),
+          [this]() { CancelThreads(/*wait=*/false); }, &deregister_fn_));
+      TF_RETURN_IF_ERROR(
+          dataset()->input_->MakeIterator(ctx, this, prefix(), &input_impl_));
+      return dataset()->captured_func_->Instantiate(
+          ctx, &instantiated_captured_func_);
+    }
+
+    Status GetNextInternal(IteratorContext* ctx,
+                           std::vector<Tensor>* out_tensors,
+                           bool* end_of_sequence) override {
+      while (true) {
+        std::shared_ptr<InvocationResult> result;
+        {
+          mutex_lock l(*mu_);
+          EnsureThreadsStarted(ctx);
+          while (ShouldWait(&result)) {
+            RecordStop(ctx);
+            cond_var_->wait(l);
+            RecordStart(ctx);
+          }
+          if (cancelled_) {
+            return errors::Cancelled("Iterator was cancelled");
+          }
+        }
+        RecordStop(ctx);
+        result->notification.WaitForNotification();
+        RecordStart(ctx);
+        profiler::TraceMe traceme([&] {
+          return profiler::TraceMeEncode("ParallelFilterConsume",
+                                         {{"element_id", result->id}});
+        });
+        bool matched;
+        TF_RETURN_IF_ERROR(ProcessResult(ctx, result, out_tensors,
+                                         end_of_sequence, &matched));
+        if (matched || *end_of_sequence) {
+          return Status::OK();
+        }
+      }
+    }
+
+   protected:
+    std::shared_ptr<model::Node> CreateNode(
+        IteratorContext* ctx, model::Node::Args args) const override {
+      // The model has no asynchronous node with an unknown ratio, so the
+      // filter is modeled as producing one element per input element. This
+      // overestimates the output rate of selective predicates, but still lets
+      // the parallelism be tuned.
+      return model::MakeAsyncKnownRatioNode(
+          std::move(args),
+          /*ratio=*/1,
+          {model::MakeParameter("parallelism", num_parallel_calls_, /*min=*/1,
+                                /*max=*/ctx->runner_threadpool_size())});
+    }
+
+    Status SaveInternal(SerializationContext* ctx,
+                        IteratorStateWriter* writer) override {
+      TF_RETURN_IF_ERROR(ctx->HandleCheckExternalStateStatus(
+          dataset()->captured_func_->CheckExternalState()));
+      mutex_lock l(*mu_);
+      // Wait for all in-flight calls to complete.
+      while (num_calls_ > 0) {
+        cond_var_->wait(l);
+      }
+      if (num_calls_ != 0) {
+        return errors::FailedPrecondition(
+            "Unexpected outstanding calls encountered.");
+      }
+      TF_RETURN_IF_ERROR(SaveInput(ctx, writer, input_impl_));
+      TF_RETURN_IF_ERROR(writer->WriteScalar(
+          full_name(strings::StrCat(kInvocationResults, kSizeSuffix)),
+          invocation_results_.size()));
+      for (size_t i = 0; i < invocation_results_.size(); i++) {
+        const auto& result = *(invocation_results_[i]);
+        TF_RETURN_IF_ERROR(WriteStatusLocked(writer, i, result.status));
+        TF_RETURN_IF_ERROR(writer->WriteScalar(
+            full_name(
+                strings::StrCat(kInvocationResults, "[", i, "]", kSizeSuffix)),
+            result.return_values.size()));
+        for (size_t j = 0; j < result.return_values.size(); j++) {
+          TF_RETURN_IF_ERROR(writer->WriteTensor(
+              full_name(
+                  strings::StrCat(kInvocationResults, "[", i, "][", j, "]")),
+              result.return_values[j]));
+        }
+        if (result.end_of_input) {
+          TF_RETURN_IF_ERROR(writer->WriteScalar(
+              full_name(strings::StrCat(kInvocationResults, "[", i, "]",
+                                        kEndOfInputSuffix)),
+              ""));
+        }
+        if (result.predicate_value) {
+          TF_RETURN_IF_ERROR(writer->WriteScalar(
+              full_name(strings::StrCat(kInvocationResults, "[", i, "]",
+                                        kPredicateValueSuffix)),
+              ""));
+        }
+      }
+      return Status::OK();
+    }
+
+    Status RestoreInternal(IteratorContext* ctx,
+                           IteratorStateReader* reader) override {
+      mutex_lock l(*mu_);
+      TF_RETURN_IF_ERROR(RestoreInput(ctx, reader, input_impl_));
+      int64 invocation_results_size;
+      TF_RETURN_IF_ERROR(reader->ReadScalar(
+          full_name(strings::StrCat(kInvocationResults, kSizeSuffix)),
+          &invocation_results_size));
+      if (!invocation_results_.empty()) invocation_results_.clear();
+      for (size_t i = 0; i < invocation_results_size; i++) {
+        invocation_results_.push_back(std::make_shared<InvocationResult>());
+        auto& result = *invocation_results_.back();
+        TF_RETURN_IF_ERROR(ReadStatusLocked(reader, i, &result.status));
+        size_t num_return_values;
+        {
+          int64 size;
+          TF_RETURN_IF_ERROR(reader->ReadScalar(
+              full_name(strings::StrCat(kInvocationResults, "[", i, "]",
+                                        kSizeSuffix)),
+              &size));
+          num_return_values = static_cast<size_t>(size);
+          if (num_return_values != size) {
+            return errors::InvalidArgument(strings::StrCat(
+                full_name(strings::StrCat(kInvocationResults, "[", i, "]",
+                                          kSizeSuffix)),
+                ": ", size, " is not a valid value of type size_t."));
+          }
+        }
+        result.return_values.reserve(num_return_values);
+        for (size_t j = 0; j < num_return_values; j++) {
+          result.return_values.emplace_back();
+          TF_RETURN_IF_ERROR(
+              reader->ReadTensor(full_name(strings::StrCat(
+                                     kInvocationResults, "[", i, "][", j, "]")),
+                                 &result.return_values.back()));
+        }
+        result.end_of_input = reader->Contains(full_name(strings::StrCat(
+            kInvocationResults, "[", i, "]", kEndOfInputSuffix)));
+        result.predicate_value = reader->Contains(full_name(strings::StrCat(
+            kInvocationResults, "[", i, "]", kPredicateValueSuffix)));
+        result.notification.Notify();
+      }
+      return Status::OK();
+    }
+
+    TraceMeMetadata GetTraceMeMetadata() const override {
+      int64 parallelism = -1;
+      // NOTE: We only set the parallelism value if the lock can be acquired
+      // right away to avoid introducing tracing overhead.
+      if (mu_->try_lock()) {
+        parallelism = num_parallel_calls_->value;
+        mu_->unlock();
+      }
+      data::TraceMeMetadata result;
+      result.push_back(
+          std::make_pair("autotune", autotune_ ? "true" : "false"));
+      result.push_back(
+          std::make_pair("deterministic", deterministic_ ? "true" : "false"));
+      result.push_back(std::make_pair(
+          "parallelism",
+          strings::Printf("%lld", static_cast<long long>(parallelism))));
+      return result;
+    }
+
+   private:
+    struct InvocationResult {
+      InvocationResult() = default;
+      explicit InvocationResult(int64 id) : id(id) {}
+
+      Notification notification;
+      Status status;
+      // The input element, which is produced if `predicate_value` is true.
+      std::vector<Tensor> return_values;
+      bool predicate_value = false;
+      bool end_of_input = false;
+      int64 id = -1;
+    };
+
+    void CancelThreads(bool wait) TF_LOCKS_EXCLUDED(mu_) {
+      mutex_lock l(*mu_);
+      cancelled_ = true;
+      cond_var_->notify_all();
+      // Wait for all in-flight calls to complete.
+      while (wait && num_calls_ > 0) {
+        cond_var_->wait(l);
+      }
+    }
+
+    void EnsureThreadsStarted(IteratorContext* ctx)
+        TF_EXCLUSIVE_LOCKS_REQUIRED(*mu_) {
+      if (!runner_thread_) {
+        auto ctx_copy = std::make_shared<IteratorContext>(*ctx);
+        runner_thread_ = ctx->StartThread(
+            "tf_data_parallel_filter",
+            std::bind(&Iterator::RunnerThread, this, ctx_copy));
+      }
+    }
+
+    void CallCompleted(const std::shared_ptr<IteratorContext>& ctx,
+                       const std::shared_ptr<InvocationResult>& result)
+        TF_LOCKS_EXCLUDED(*mu_) {
+      mutex_lock l(*mu_);
+      num_calls_--;
+      RecordBufferEnqueue(ctx.get(), result->return_values);
+      result->notification.Notify();
+      cond_var_->notify_all();
+    }
+
+    void CallFunction(const std::shared_ptr<IteratorContext>& ctx,
+                      const std::shared_ptr<InvocationResult>& result)
+        TF_LOCKS_EXCLUDED(*mu_) {
+      profiler::TraceMe traceme([&] {
+        return profiler::TraceMeEncode("ParallelFilterProduce",
+                                       {{"element_id", result->id}});
+      });
+      // Get the next input element.
+      result->status = input_impl_->GetNext(ctx.get(), &result->return_values,
+                                            &result->end_of_input);
+      if (result->end_of_input || !result->status.ok()) {
+        CallCompleted(ctx, result);
+        return;
+      }
+
+      auto predicate_values = std::make_shared<std::vector<Tensor>>();
+      auto done = [this, ctx, result, predicate_values](Status status) {
+        if (status.ok()) {
+          if (predicate_values->size() != 1 ||
+              (*predicate_values)[0].dtype() != DT_BOOL ||
+              (*predicate_values)[0].NumElements() != 1) {
+            status = errors::InvalidArgument(
+                "Filter predicate `predicate` must return a scalar bool.");
+          } else {
+            result->predicate_value = (*predicate_values)[0].scalar<bool>()();
+          }
+        }
+        result->status.Update(status);
+        if (!result->predicate_value) {
+          // Drop the element early, as it will not be produced.
+          result->return_values.clear();
+        }
+        CallCompleted(ctx, result);
+      };
+
+      // Apply the predicate on `result->return_values`, which the predicate
+      // borrows, and invoke `done` when finished.
+      if (dataset()->captured_func_->use_inter_op_parallelism()) {
+        instantiated_captured_func_->RunAsync(
+            ctx.get(), std::vector<Tensor>(result->return_values),
+            predicate_values.get(), std::move(done), model_node());
+      } else {
+        // In this case, the function will be executed using single-threaded
+        // executor. We schedule it using `ctx->runner()` to enable concurrent
+        // application of the function over different input elements.
+        auto fn = [this, ctx, result, predicate_values]() {
+          return instantiated_captured_func_->RunWithBorrowedArgs(
+              ctx.get(), result->return_values, predicate_values.get());
+        };
+        // `ctx->runner()` may execute its logic synchronously so we wrap it in
+        // `RecordStop` and `RecordStart` to prevent invalid nesting of
+        // `RecordStart` calls.
+        RecordStop(ctx.get());
+        (*ctx->runner())(
+            [this, ctx, fn = std::move(fn), done = std::move(done)]() {
+              RecordStart(ctx.get());
+              auto cleanup =
+                  gtl::MakeCleanup([this, ctx] { RecordStop(ctx.get()); });
+              done(fn());
+            });
+        RecordStart(ctx.get());
+      }
+    }
+
+    Status ProcessResult(IteratorContext* ctx,
+                         const std::shared_ptr<InvocationResult>& result,
+                         std::vector<Tensor>* out_tensors,
+                         bool* end_of_sequence, bool* matched)
+        TF_LOCKS_EXCLUDED(*mu_) {
+      *matched = false;
+      *end_of_sequence = false;
+      if (!result->end_of_input && result->status.ok()) {
+        if (result->predicate_value) {
+          *out_tensors = std::move(result->return_values);
+          RecordBufferDequeue(ctx, *out_tensors);
+          *matched = true;
+        }
+        return Status::OK();
+      }
+      if (errors::IsOutOfRange(result->status)) {
+        // `predicate` may deliberately raise `errors::OutOfRange` to indicate
+        // that we should terminate the iteration early.
+        *end_of_sequence = true;
+        return Status::OK();
+      }
+      *end_of_sequence = result->end_of_input;
+      return result->status;
+    }
+
+    void RunnerThread(const std::shared_ptr<IteratorContext>& ctx)
+        TF_LOCKS_EXCLUDED(*mu_) {
+      RecordStart(ctx.get());
+      auto cleanup = gtl::MakeCleanup([this, ctx] { RecordStop(ctx.get()); });
+      std::vector<std::shared_ptr<InvocationResult>> new_calls;
+      {
+        tf_shared_lock l(*mu_);  // mu_ == num_parallel_calls_->mu
+        new_calls.reserve(num_parallel_calls_->value);
+      }
+      auto busy = [this]() TF_EXCLUSIVE_LOCKS_REQUIRED(*mu_) -> bool {
+        int64 num_parallel_calls = num_parallel_calls_->value;
+        return num_calls_ >= num_parallel_calls ||
+               invocation_results_.size() >= num_parallel_calls;
+      };
+      // Counts the total number of calls to use as an id of InvocationResult.
+      int64 num_total_calls = 0;
+      while (true) {
+        {
+          mutex_lock l(*mu_);
+          while (!cancelled_ && busy()) {
+            RecordStop(ctx.get());
+            cond_var_->wait(l);
+            RecordStart(ctx.get());
+          }
+          if (cancelled_) {
+            return;
+          }
+          while (!busy()) {
+            invocation_results_.push_back(
+                std::make_shared<InvocationResult>(num_total_calls++));
+            new_calls.push_back(invocation_results_.back());
+            num_calls_++;
+          }
+          cond_var_->notify_all();
+        }
+        for (const auto& call : new_calls) {
+          CallFunction(ctx, call);
+        }
+        new_calls.clear();
+      }
+    }
+
+    // Determines whether the caller needs to wait for a result. Upon returning
+    // false, `result` will point to the result.
+    bool ShouldWait(std::shared_ptr<InvocationResult>* result)
+        TF_EXCLUSIVE_LOCKS_REQUIRED(*mu_) {
+      if (cancelled_) {
+        return false;
+      }
+      if (!deterministic_) {
+        // Iterate through in-flight results and return the first one that is
+        // found to be available and not end-of-input. If the first result (in
+        // order) is end-of-input, we know that all earlier iterations have
+        // already been completed, so it is safe to return that result for the
+        // caller to process end of iteration.
+        for (auto it = invocation_results_.begin();
+             it != invocation_results_.end(); ++it) {
+          if ((*it)->notification.HasBeenNotified() &&
+              (it == invocation_results_.begin() || !(*it)->end_of_input)) {
+            std::swap(*result, *it);
+            invocation_results_.erase(it);
+            cond_var_->notify_all();
+            return false;
+          }
+        }
+      } else if (!invocation_results_.empty()) {
+        std::swap(*result, invocation_results_.front());
+        invocation_results_.pop_front();
+        cond_var_->notify_all();
+        return false;
+      }
+      return true;
+    }
+
+    Status WriteStatusLocked(IteratorStateWriter* writer, size_t index,
+                             const Status& status)
+        TF_EXCLUSIVE_LOCKS_REQUIRED(*mu_) {
+      TF_RETURN_IF_ERROR(writer->WriteScalar(
+          CodeKey(index), static_cast<int64>(status.code())));
+      if (!status.ok()) {
+        TF_RETURN_IF_ERROR(writer->WriteScalar(ErrorMessageKey(index),
+                                               status.error_message()));
+      }
+      return Status::OK();
+    }
+
+    Status ReadStatusLocked(IteratorStateReader* reader, size_t index,
+                            Status* status) TF_EXCLUSIVE_LOCKS_REQUIRED(*mu_) {
+      int64 code_int;
+      TF_RETURN_IF_ERROR(reader->ReadScalar(CodeKey(index), &code_int));
+      error::Code code = static_cast<error::Code>(code_int);
+
+      if (code != error::Code::OK) {
+        tstring error_message;
+        TF_RETURN_IF_ERROR(
+            reader->ReadScalar(ErrorMessageKey(index), &error_message));
+        *status = Status(code, error_message);
+      } else {
+        *status = Status::OK();
+      }
+      return Status::OK();
+    }
+
+    string CodeKey(size_t index) {
+      return full_name(
+          strings::StrCat(kInvocationResults, "[", index, "]", kCodeSuffix));
+    }
+
+    string ErrorMessageKey(size_t index) {
+      return full_name(
+          strings::StrCat(kInvocationResults, "[", index, "]", kErrorMessage));
+    }
+
+    // Used for coordination between the main thread and the runner thread.
+    const std::shared_ptr<mutex> mu_;
+    // Used for coordination between the main thread and the runner thread. In
+    // particular, the runner thread should only schedule new calls when the
+    // number of in-flight calls is less than the user specified level of
+    // parallelism and there are slots available in the `invocation_results_`
+    // buffer.
+    const std::shared_ptr<condition_variable> cond_var_;
+    // Identifies the maximum number of parallel calls.
+    const std::shared_ptr<model::SharedState> num_parallel_calls_;
+    const bool deterministic_;
+    const bool autotune_;
+    // Counts the number of outstanding calls.
+    int64 num_calls_ TF_GUARDED_BY(*mu_) = 0;
+    std::unique_ptr<InstantiatedCapturedFunction> instantiated_captured_func_;
+    std::unique_ptr<IteratorBase> input_impl_;
+    // Buffer for storing the invocation results.
+    std::deque<std::shared_ptr<InvocationResult>> invocation_results_
+        TF_GUARDED_BY(*mu_);
+
+    std::unique_ptr<Thread> runner_thread_ TF_GUARDED_BY(*mu_);
+    bool cancelled_ TF_GUARDED_BY(*mu_) = false;
+
+    // Method for deregistering the cancellation callback.
+    std::function<void()> deregister_fn_;
+  };
+
+  const DatasetBase* const input_;
+  const int64 num_parallel_calls_;
+  const DeterminismPolicy deterministic_;
+  const std::unique_ptr<CapturedFunction> captured_func_;
+};
+
+ParallelFilterDatasetOp::ParallelFilterDatasetOp(OpKernelConstruction* ctx)
+    : UnaryDatasetOpKernel(ctx) {
+  OP_REQUIRES_OK(ctx, FunctionMetadata::Create(ctx, kPredicate, /*params=*/{},
+                                               &func_metadata_));
+  OP_REQUIRES(ctx, func_metadata_->short_circuit_info().indices.size() <= 1,
+              errors::InvalidArgument(
+                  "predicate function has more than one return value."));
+  std::string deterministic;
+  OP_REQUIRES_OK(ctx, ctx->GetAttr(kDeterministic, &deterministic));
+  OP_REQUIRES_OK(ctx,
+                 DeterminismPolicy::FromString(deterministic, &deterministic_));
+}
+
+void ParallelFilterDatasetOp::MakeDataset(OpKernelContext* ctx,
+                                          DatasetBase* input,
+                                          DatasetBase** output) {
+  int64 num_parallel_calls;
+  OP_REQUIRES_OK(
+      ctx, ParseScalarArgument(ctx, kNumParallelCalls, &num_parallel_calls));
+  OP_REQUIRES(
+      ctx, num_parallel_calls > 0 || num_parallel_calls == model::kAutotune,
+      errors::InvalidArgument("num_parallel_calls must be greater than zero."));
+
+  std::unique_ptr<CapturedFunction> captured_func;
+  OP_REQUIRES_OK(ctx,
+                 CapturedFunction::Create(ctx, func_metadata_, kOtherArguments,
+                                          &captured_func));
+
+  if (num_parallel_calls == model::kAutotune) {
+    metrics::RecordTFDataAutotune(kDatasetType);
+  }
+
+  *output = new Dataset(ctx, input, num_parallel_calls, deterministic_,
+                        std::move(captured_func));
+}
+
+namespace {
+REGISTER_KERNEL_BUILDER(Name("ParallelFilterDataset").Device(DEVICE_CPU),
+                        ParallelFilterDatasetOp);
+REGISTER_INPUT_COLOCATION_EXEMPTION("ParallelFilterDataset");
+}  // namespace
+}  // namespace data
+}  // namespace tensorflow
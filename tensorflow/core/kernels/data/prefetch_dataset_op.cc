@@ -157,16 +157,16 @@ class PrefetchDatasetOp::Dataset : public DatasetBase {
                  auto_tuner_.buffer_limit() != 0) {
             auto_tuner_.RecordEmpty();
             buffer_size_->value = auto_tuner_.buffer_limit();
-            RecordStop(ctx);
+            RecordWaitStart(ctx);
             cond_var_->wait(l);
-            RecordStart(ctx);
+            RecordWaitStop(ctx);
           }
         } else {
           while (!cancelled_ && buffer_.empty() && !prefetch_thread_finished_ &&
                  buffer_size_->value != 0) {
-            RecordStop(ctx);
+            RecordWaitStart(ctx);
             cond_var_->wait(l);
-            RecordStart(ctx);
+            RecordWaitStop(ctx);
           }
         }
 
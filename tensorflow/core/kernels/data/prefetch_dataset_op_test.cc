@@ -12,6 +12,8 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/data/prefetch_dataset_op.h"
 
+#include "absl/strings/match.h"
+#include "tensorflow/core/framework/model.h"
 #include "tensorflow/core/kernels/data/dataset_test_base.h"
 
 namespace tensorflow {
@@ -295,6 +297,33 @@ IteratorSaveAndRestoreTestCases() {
 ITERATOR_SAVE_AND_RESTORE_TEST_P(PrefetchDatasetOpTest, PrefetchDatasetParams,
                                  IteratorSaveAndRestoreTestCases())
 
+// With an autotuned buffer the iterator's TraceMe name carries the buffer
+// occupancy and the time its consumer spent waiting on the buffer.
+TEST_F(PrefetchDatasetOpTest, TraceMeNameReportsBufferAndWaitTime) {
+  auto dataset_params = PrefetchDatasetParams3();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  IteratorContext::Params params(iterator_ctx_.get());
+  params.model = std::make_shared<model::Model>();
+  IteratorContext ctx(std::move(params));
+  std::unique_ptr<IteratorBase> iterator;
+  TF_ASSERT_OK(dataset_->MakeIterator(
+      &ctx, /*parent=*/nullptr, dataset_params.iterator_prefix(), &iterator));
+  auto* dataset_iterator = static_cast<DatasetBaseIterator*>(iterator.get());
+  EXPECT_TRUE(absl::StrContains(dataset_iterator->BuildTraceMeName(),
+                                ",buffered_elements=0,wait_time=0"));
+
+  bool end_of_sequence = false;
+  std::vector<Tensor> out_tensors;
+  int num_elements = 0;
+  while (!end_of_sequence) {
+    TF_ASSERT_OK(iterator->GetNext(&ctx, &out_tensors, &end_of_sequence));
+    if (!end_of_sequence) ++num_elements;
+  }
+  EXPECT_EQ(num_elements, 10);
+  EXPECT_TRUE(absl::StrContains(dataset_iterator->BuildTraceMeName(),
+                                ",wait_time="));
+}
+
 TEST_F(PrefetchDatasetOpTest, InvalidBufferSize) {
   auto dataset_params = InvalidBufferSizePrefetchDatasetParams();
   EXPECT_EQ(Initialize(dataset_params).code(), error::INVALID_ARGUMENT);
@@ -18,19 +18,26 @@ limitations under the License.
 #include <tuple>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "tensorflow/core/framework/dataset.h"
 #include "tensorflow/core/framework/partial_tensor_shape.h"
 #include "tensorflow/core/framework/resource_mgr.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/kernels/data/dataset_utils.h"
 #include "tensorflow/core/kernels/data/name_utils.h"
 #include "tensorflow/core/kernels/data/random_seed_ops.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/io/record_reader.h"
+#include "tensorflow/core/lib/io/record_writer.h"
 #include "tensorflow/core/lib/random/philox_random.h"
 #include "tensorflow/core/lib/random/random.h"
 #include "tensorflow/core/lib/random/random_distributions.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/stringprintf.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 namespace data {
@@ -75,6 +82,187 @@ constexpr char kShuffleDatasetV3[] = "ShuffleDatasetV3";
 constexpr char kShuffleAndRepeatDatasetV1[] = "ShuffleAndRepeatDataset";
 constexpr char kShuffleAndRepeatDatasetV2[] = "ShuffleAndRepeatDatasetV2";
 
+// Spilled elements are appended to segment files of about this size, so that
+// disk space is reclaimed as segments are drained.
+constexpr uint64 kSpillSegmentBytes = 64 << 20;
+
+namespace {
+
+// Returns the number of bytes of elements that a shuffle buffer may hold in
+// memory, or 0 if it may hold all of its elements in memory. Elements beyond
+// the budget are spilled to local disk.
+int64 ShuffleBufferMemoryBudget() {
+  int64 budget;
+  Status s = ReadInt64FromEnvVar("TF_DATA_SHUFFLE_BUFFER_MEMORY_BUDGET_BYTES",
+                                 /*default_val=*/0, &budget);
+  if (!s.ok()) {
+    LOG(ERROR) << s;
+    return 0;
+  }
+  return budget;
+}
+
+// Returns the directory where shuffle buffers spill elements, or an empty
+// string to use a local temporary directory.
+string ShuffleSpillDirectory() {
+  string dir;
+  Status s = ReadStringFromEnvVar("TF_DATA_SHUFFLE_SPILL_DIR",
+                                  /*default_val=*/"", &dir);
+  if (!s.ok()) {
+    LOG(ERROR) << s;
+  }
+  return dir;
+}
+
+// Stores the elements of a shuffle buffer that do not fit in its memory
+// budget in segment files. Each component is written as a checksummed record
+// holding its `TensorProto`. A segment file is deleted once all of its
+// elements have been released.
+//
+// Not thread-safe.
+class SpillStore {
+ public:
+  struct Location {
+    int64 segment;
+    uint64 offset;
+  };
+
+  SpillStore(Env* env, string prefix)
+      : env_(env), prefix_(std::move(prefix)) {}
+
+  ~SpillStore() {
+    for (auto& segment : segments_) {
+      CloseAndDelete(&segment.second);
+    }
+  }
+
+  Status Write(const std::vector<Tensor>& element, Location* location) {
+    if (current_segment_ < 0 ||
+        segments_[current_segment_].bytes_written >= kSpillSegmentBytes) {
+      TF_RETURN_IF_ERROR(StartSegment());
+    }
+    Segment& segment = segments_[current_segment_];
+    location->segment = current_segment_;
+    location->offset = segment.bytes_written;
+    for (const Tensor& tensor : element) {
+      TensorProto proto;
+      tensor.AsProtoTensorContent(&proto);
+      if (!proto.SerializeToString(&scratch_)) {
+        return errors::Internal("Failed to serialize a shuffle buffer element");
+      }
+      TF_RETURN_IF_ERROR(segment.writer->WriteRecord(scratch_));
+      segment.bytes_written += io::RecordWriter::kHeaderSize +
+                               scratch_.size() + io::RecordWriter::kFooterSize;
+    }
+    segment.num_elements++;
+    segment.needs_flush = true;
+    return Status::OK();
+  }
+
+  Status Read(const Location& location, size_t num_components,
+              std::vector<Tensor>* element) {
+    auto it = segments_.find(location.segment);
+    if (it == segments_.end()) {
+      return errors::Internal("Shuffle buffer spill segment ",
+                              location.segment, " does not exist");
+    }
+    Segment& segment = it->second;
+    if (segment.needs_flush) {
+      TF_RETURN_IF_ERROR(segment.writer->Flush());
+      TF_RETURN_IF_ERROR(segment.file->Flush());
+      segment.needs_flush = false;
+    }
+    if (!segment.reader) {
+      TF_RETURN_IF_ERROR(
+          env_->NewRandomAccessFile(segment.filename, &segment.read_file));
+      segment.reader =
+          absl::make_unique<io::RecordReader>(segment.read_file.get());
+    }
+    uint64 offset = location.offset;
+    element->clear();
+    element->reserve(num_components);
+    for (size_t i = 0; i < num_components; ++i) {
+      tstring record;
+      TF_RETURN_IF_ERROR(segment.reader->ReadRecord(&offset, &record));
+      TensorProto proto;
+      element->emplace_back();
+      if (!proto.ParseFromArray(record.data(), record.size()) ||
+          !element->back().FromProto(proto)) {
+        return errors::DataLoss("Corrupted shuffle buffer spill file ",
+                                segment.filename);
+      }
+    }
+    return Status::OK();
+  }
+
+  // Forgets the element at `location`, deleting its segment file if it holds
+  // no other elements.
+  void Release(const Location& location) {
+    auto it = segments_.find(location.segment);
+    if (it == segments_.end()) {
+      return;
+    }
+    if (--it->second.num_elements == 0 &&
+        location.segment != current_segment_) {
+      CloseAndDelete(&it->second);
+      segments_.erase(it);
+    }
+  }
+
+ private:
+  struct Segment {
+    string filename;
+    std::unique_ptr<WritableFile> file;
+    std::unique_ptr<io::RecordWriter> writer;
+    std::unique_ptr<RandomAccessFile> read_file;
+    std::unique_ptr<io::RecordReader> reader;
+    uint64 bytes_written = 0;
+    // The number of elements that have not been released.
+    int64 num_elements = 0;
+    bool needs_flush = false;
+  };
+
+  Status StartSegment() {
+    if (current_segment_ >= 0) {
+      Segment& previous = segments_[current_segment_];
+      TF_RETURN_IF_ERROR(previous.writer->Close());
+      TF_RETURN_IF_ERROR(previous.file->Close());
+      previous.writer.reset();
+      previous.file.reset();
+      previous.needs_flush = false;
+      if (previous.num_elements == 0) {
+        CloseAndDelete(&previous);
+        segments_.erase(current_segment_);
+      }
+    }
+    ++current_segment_;
+    Segment& segment = segments_[current_segment_];
+    segment.filename = strings::StrCat(prefix_, "_", current_segment_);
+    TF_RETURN_IF_ERROR(env_->NewWritableFile(segment.filename, &segment.file));
+    segment.writer = absl::make_unique<io::RecordWriter>(segment.file.get());
+    return Status::OK();
+  }
+
+  void CloseAndDelete(Segment* segment) {
+    segment->reader.reset();
+    segment->read_file.reset();
+    segment->writer.reset();
+    segment->file.reset();
+    Status s = env_->DeleteFile(segment->filename);
+    if (!s.ok()) {
+      LOG(WARNING) << "Failed to delete " << segment->filename << ": " << s;
+    }
+  }
+
+  Env* const env_;
+  const string prefix_;
+  absl::flat_hash_map<int64, Segment> segments_;
+  int64 current_segment_ = -1;
+  std::string scratch_;
+};
+
+}  // namespace
+
 ShuffleDatasetOpBase::ShuffleDatasetOpBase(OpKernelConstruction* ctx)
     : UnaryDatasetOpKernel(ctx) {}
 
@@ -91,8 +279,16 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
         count_(count),
         traceme_metadata_(
             {{"buffer_size",
-              strings::Printf("%lld", static_cast<long long>(buffer_size))}}) {
+              strings::Printf("%lld", static_cast<long long>(buffer_size))}}),
+        memory_budget_bytes_(ShuffleBufferMemoryBudget()) {
     input_->Ref();
+    // Datasets and resources cannot be serialized, so elements that contain
+    // them always stay in memory.
+    for (DataType dtype : input_->output_dtypes()) {
+      if (dtype == DT_VARIANT || dtype == DT_RESOURCE) {
+        memory_budget_bytes_ = 0;
+      }
+    }
   }
 
   ~ShuffleDatasetBase() override { input_->Unref(); }
@@ -200,9 +396,14 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
             VLOG(1) << "Starting to fill up shuffle buffer of size: "
                     << this->dataset()->buffer_size_;
           }
-          this->RecordBufferEnqueue(ctx, input_element);
-          buffer_->at(slices_.back()->end % this->dataset()->buffer_size_) =
-              std::move(input_element);
+          const int64 slot =
+              slices_.back()->end % this->dataset()->buffer_size_;
+          buffer_->at(slot) = std::move(input_element);
+          bool spilled;
+          TF_RETURN_IF_ERROR(MaybeSpill(slot, &spilled));
+          if (!spilled) {
+            this->RecordBufferEnqueue(ctx, buffer_->at(slot));
+          }
           num_elements_++;
           slices_.back()->end++;
         } else {
@@ -239,11 +440,27 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
             Random() % (slices_.front()->end - slices_.front()->start);
         int64 index =
             (slices_.front()->start + offset) % this->dataset()->buffer_size_;
-        *out_tensors = std::move(buffer_->at(index));
-        this->RecordBufferDequeue(ctx, *out_tensors);
-        std::swap(buffer_->at(index),
-                  buffer_->at(slices_.front()->start %
-                              this->dataset()->buffer_size_));
+        auto spilled = spilled_.find(index);
+        if (spilled != spilled_.end()) {
+          TF_RETURN_IF_ERROR(spill_store_->Read(
+              spilled->second, this->dataset()->output_dtypes().size(),
+              out_tensors));
+          spill_store_->Release(spilled->second);
+          spilled_.erase(spilled);
+        } else {
+          *out_tensors = std::move(buffer_->at(index));
+          this->RecordBufferDequeue(ctx, *out_tensors);
+          buffered_bytes_ -= GetTotalBytes(*out_tensors);
+        }
+        const int64 start =
+            slices_.front()->start % this->dataset()->buffer_size_;
+        std::swap(buffer_->at(index), buffer_->at(start));
+        spilled = spilled_.find(start);
+        if (spilled != spilled_.end()) {
+          SpillStore::Location location = spilled->second;
+          spilled_.erase(spilled);
+          spilled_[index] = location;
+        }
         slices_.front()->start++;
         num_elements_--;
       } else {
@@ -293,7 +510,21 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
       TF_RETURN_IF_ERROR(writer->WriteScalar(this->full_name(kEpoch), epoch_));
       TF_RETURN_IF_ERROR(
           writer->WriteScalar(this->full_name(kNumElements), num_elements_));
-      TF_RETURN_IF_ERROR(WriteElementsToCheckpoint(writer, prefix(), *buffer_));
+      if (spilled_.empty()) {
+        TF_RETURN_IF_ERROR(
+            WriteElementsToCheckpoint(writer, prefix(), *buffer_));
+      } else {
+        // The checkpoint holds the whole buffer, so read the spilled elements
+        // back for the duration of the save.
+        std::vector<std::vector<Tensor>> elements(*buffer_);
+        for (const auto& spilled : spilled_) {
+          TF_RETURN_IF_ERROR(spill_store_->Read(
+              spilled.second, this->dataset()->output_dtypes().size(),
+              &elements[spilled.first]));
+        }
+        TF_RETURN_IF_ERROR(
+            WriteElementsToCheckpoint(writer, prefix(), elements));
+      }
       TF_RETURN_IF_ERROR(
           writer->WriteScalar(this->full_name(kSlicesSize), slices_.size()));
       for (size_t i = 0; i < slices_.size(); ++i) {
@@ -352,6 +583,15 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
           this->dataset()->buffer_size_);
       TF_RETURN_IF_ERROR(
           ReadElementsFromCheckpoint(reader, prefix(), buffer_.get()));
+      spilled_.clear();
+      spill_store_.reset();
+      buffered_bytes_ = 0;
+      for (int64 slot = 0; slot < buffer_->size(); ++slot) {
+        if (!buffer_->at(slot).empty()) {
+          bool spilled;
+          TF_RETURN_IF_ERROR(MaybeSpill(slot, &spilled));
+        }
+      }
       slices_.clear();
       for (size_t i = 0; i < slices_size; ++i) {
         int64 start;
@@ -394,6 +634,52 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
       return out;
     }
 
+    // Moves the element in `buffer_[slot]` to the spill store if keeping it in
+    // memory would exceed the memory budget. Which elements are spilled does
+    // not affect the order in which elements are produced.
+    Status MaybeSpill(int64 slot, bool* spilled)
+        TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      std::vector<Tensor>& element = buffer_->at(slot);
+      const int64 bytes = GetTotalBytes(element);
+      const int64 budget = this->dataset()->memory_budget_bytes_;
+      *spilled = budget > 0 && buffered_bytes_ + bytes > budget;
+      if (!*spilled) {
+        buffered_bytes_ += bytes;
+        return Status::OK();
+      }
+      if (!spill_store_) {
+        TF_RETURN_IF_ERROR(CreateSpillStore());
+      }
+      SpillStore::Location location;
+      TF_RETURN_IF_ERROR(spill_store_->Write(element, &location));
+      spilled_[slot] = location;
+      element.clear();
+      return Status::OK();
+    }
+
+    Status CreateSpillStore() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      Env* env = Env::Default();
+      string dir = ShuffleSpillDirectory();
+      string prefix;
+      if (dir.empty()) {
+        if (!env->LocalTempFilename(&prefix)) {
+          return errors::Unavailable(
+              "Failed to create a local file to spill the shuffle buffer to");
+        }
+      } else {
+        TF_RETURN_IF_ERROR(env->RecursivelyCreateDir(dir));
+        prefix = io::JoinPath(
+            dir, strings::Printf("shuffle_buffer_%llx",
+                                 static_cast<unsigned long long>(
+                                     random::New64())));
+      }
+      LOG(INFO) << "Shuffle buffer exceeds its memory budget of "
+                << this->dataset()->memory_budget_bytes_
+                << " bytes; spilling elements to " << prefix << "_*";
+      spill_store_ = absl::make_unique<SpillStore>(env, std::move(prefix));
+      return Status::OK();
+    }
+
     mutex mu_;
     SeedGenerator* const seed_generator_ TF_GUARDED_BY(mu_);  // Not owned.
     std::unique_ptr<std::vector<std::vector<Tensor>>> buffer_
@@ -413,6 +699,14 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
         TF_GUARDED_BY(mu_);
     int64 num_random_samples_ TF_GUARDED_BY(mu_) = 0;
     bool data_produced_ TF_GUARDED_BY(mu_) = false;
+    // The number of bytes of the elements held in memory in `buffer_`.
+    int64 buffered_bytes_ TF_GUARDED_BY(mu_) = 0;
+    // Created on the first spill.
+    std::unique_ptr<SpillStore> spill_store_ TF_GUARDED_BY(mu_);
+    // Maps the slots of `buffer_` whose elements are spilled to where they
+    // are in `spill_store_`.
+    absl::flat_hash_map<int64, SpillStore::Location> spilled_
+        TF_GUARDED_BY(mu_);
   };
 
   const DatasetBase* const input_;
@@ -423,6 +717,9 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
   // responsible for repeating as well.
   const int64 count_;
   const TraceMeMetadata traceme_metadata_;
+  // The number of bytes of elements that each iterator keeps in memory, or 0
+  // if iterators keep all of their buffer in memory.
+  int64 memory_budget_bytes_;
 };  // ShuffleDatasetBase
 
 // This version of memory dataset has an exclusive ownership of the seed
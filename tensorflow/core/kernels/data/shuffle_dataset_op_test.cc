@@ -13,6 +13,7 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/data/dataset_test_base.h"
 #include "tensorflow/core/kernels/data/dataset_utils.h"
+#include "tensorflow/core/platform/path.h"
 
 namespace tensorflow {
 namespace data {
@@ -549,6 +550,60 @@ INSTANTIATE_TEST_CASE_P(ShuffleDatasetOpTest,
                         ParameterizedIteratorSaveAndRestoreTest,
                         ::testing::ValuesIn(IteratorSaveAndRestoreTestCases()));
 
+// Elements beyond the memory budget are spilled to disk, which does not
+// change the order in which they are produced.
+TEST_F(ShuffleDatasetOpTest, SpillsBeyondMemoryBudget) {
+  const string spill_dir = io::JoinPath(testing::TmpDir(), "shuffle_spill");
+  setenv("TF_DATA_SHUFFLE_BUFFER_MEMORY_BUDGET_BYTES", "16", /*overwrite=*/1);
+  setenv("TF_DATA_SHUFFLE_SPILL_DIR", spill_dir.c_str(), /*overwrite=*/1);
+  auto dataset_params = ShuffleDatasetParams7();
+  Status s = Initialize(dataset_params);
+  unsetenv("TF_DATA_SHUFFLE_BUFFER_MEMORY_BUDGET_BYTES");
+  unsetenv("TF_DATA_SHUFFLE_SPILL_DIR");
+  TF_ASSERT_OK(s);
+
+  std::unique_ptr<SerializationContext> serialization_ctx;
+  TF_ASSERT_OK(CreateSerializationContext(&serialization_ctx));
+  bool end_of_sequence = false;
+  std::vector<Tensor> out_tensors;
+  while (!end_of_sequence) {
+    std::vector<Tensor> next;
+    TF_ASSERT_OK(
+        iterator_->GetNext(iterator_ctx_.get(), &next, &end_of_sequence));
+    out_tensors.insert(out_tensors.end(), next.begin(), next.end());
+    if (out_tensors.size() == 1) {
+      std::vector<string> spill_files;
+      TF_ASSERT_OK(device_->env()->GetMatchingPaths(
+          io::JoinPath(spill_dir, "shuffle_buffer_*"), &spill_files));
+      EXPECT_FALSE(spill_files.empty());
+    }
+    // Restore from a checkpoint of a partially spilled buffer.
+    if (out_tensors.size() == 5) {
+      VariantTensorDataWriter writer;
+      TF_ASSERT_OK(iterator_->Save(serialization_ctx.get(), &writer));
+      std::vector<const VariantTensorData*> data;
+      writer.GetData(&data);
+      VariantTensorDataReader reader(data);
+      TF_ASSERT_OK(RestoreIterator(iterator_ctx_.get(), &reader,
+                                   dataset_params.iterator_prefix(),
+                                   *dataset_, &iterator_));
+    }
+  }
+  TF_EXPECT_OK(ExpectEqual(
+      out_tensors,
+      CreateTensors<int64>(TensorShape({}), {{9}, {0}, {8}, {6}, {1}, {3}, {7},
+                                             {2}, {4}, {5}, {9}, {0}, {8}, {6},
+                                             {1}, {3}, {7}, {2}, {4}, {5}}),
+      /*compare_order=*/true));
+
+  // The spill files are deleted with the iterator.
+  iterator_.reset();
+  std::vector<string> spill_files;
+  TF_ASSERT_OK(device_->env()->GetMatchingPaths(
+      io::JoinPath(spill_dir, "shuffle_buffer_*"), &spill_files));
+  EXPECT_TRUE(spill_files.empty());
+}
+
 TEST_F(ShuffleDatasetOpTest, InvalidArguments) {
   std::vector<ShuffleDatasetParams> dataset_params_vec(
       {ShuffleDatasetParamsWithInvalidBufferSize(),
@@ -15,12 +15,15 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/data/single_threaded_executor.h"
 
+#include <algorithm>
+
 #include "tensorflow/core/common_runtime/entry.h"
 #include "tensorflow/core/common_runtime/executor.h"
 #include "tensorflow/core/common_runtime/executor_factory.h"
 #include "tensorflow/core/graph/algorithm.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/mutex.h"
 
 namespace tensorflow {
 namespace data {
@@ -58,6 +61,13 @@ class SingleThreadedExecutorImpl : public Executor {
                                      ordered_nodes.size());
     }
 
+    // Conditionals (Switch and Merge nodes) are supported by propagating
+    // deadness in topological order. Loops are not, because they would require
+    // executing a subgraph multiple times per invocation.
+    has_control_flow_ = std::any_of(
+        ordered_nodes.begin(), ordered_nodes.end(),
+        [](const Node* n) { return n->IsSwitch() || n->IsMerge(); });
+
     kernels_.reserve(ordered_nodes.size());
     std::vector<Node*> nodes_with_kernels;
     std::vector<Node*> nodes_with_const_tensor_kernels;
@@ -76,9 +86,9 @@ class SingleThreadedExecutorImpl : public Executor {
               DataTypeString(dt), " in outputs of node ", n->name());
         }
       }
-      if (n->IsControlFlow()) {
+      if (n->IsEnter() || n->IsExit() || n->IsNextIteration()) {
         return errors::FailedPrecondition(
-            "Single-threaded executor does not support low level control flow, "
+            "Single-threaded executor does not support low level loops, "
             " but saw control flow node ",
             n->name(),
             ".  Perhaps your graph contains old-style control flow primitives? "
@@ -113,8 +123,12 @@ class SingleThreadedExecutorImpl : public Executor {
       OpKernel* kernel;
       TF_RETURN_IF_ERROR(params_.create_kernel(n->properties(), &kernel));
 
+      // NOTE: In a graph with conditionals, a constant with a control input may
+      // be in an untaken branch, and so must be run as a regular kernel in
+      // order for its deadness to be propagated.
       const Tensor* const_tensor;
-      if (n->num_outputs() == 1 && (const_tensor = kernel->const_tensor())) {
+      if (n->num_outputs() == 1 && (const_tensor = kernel->const_tensor()) &&
+          !(has_control_flow_ && HasControlInputs(*n))) {
         // Nodes that produce a single constant tensor are handled specially:
         // we evaluate the tensor once, and propagate it to its consumers as
         // a `const Tensor*`, to avoid refcount manipulation.
@@ -133,6 +147,7 @@ class SingleThreadedExecutorImpl : public Executor {
         kernel_state.kernel = kernel;
         kernel_state.num_inputs = n->num_inputs();
         kernel_state.num_outputs = n->num_outputs();
+        kernel_state.is_merge = n->IsMerge();
         node_to_index_map[n] = kernel_index;
         if (kernel_index == 0) {
           kernel_state.input_start_index = 0;
@@ -201,6 +216,11 @@ class SingleThreadedExecutorImpl : public Executor {
           kernel_state.output_locations[e->src_output()].push_back(
               kernels_[node_to_index_map[e->dst()]].input_start_index +
               e->dst_input());
+        } else if (has_control_flow_) {
+          auto it = node_to_index_map.find(e->dst());
+          if (it != node_to_index_map.end()) {
+            kernel_state.control_output_kernels.push_back(it->second);
+          }
         }
       }
 
@@ -241,6 +261,32 @@ class SingleThreadedExecutorImpl : public Executor {
   }
 
   Status Run(const Args& args) override {
+    std::unique_ptr<RunState> state = GetRunState();
+    Status s = RunInternal(args, state.get());
+    if (!s.ok()) {
+      // On error, some inputs may still hold values, and some kernels may
+      // still be marked as having dead control inputs, that would otherwise
+      // be consumed by the kernels that did not run.
+      for (Entry& input : state->inputs) {
+        input.ClearVal();
+      }
+      state->dead_control_inputs.assign(state->dead_control_inputs.size(),
+                                        false);
+    }
+    ReturnRunState(std::move(state));
+    return s;
+  }
+
+  void RunAsync(const Args& args, DoneCallback done) override {
+    done(Run(args));
+  }
+
+ private:
+  // The state of a single invocation of `Run()`, which is cached across
+  // invocations to avoid reallocating the flat input vector and reinitializing
+  // the `OpKernelContext::Params` for every call. This matters for functions
+  // that are invoked once per element by tf.data transformations.
+  struct RunState {
     // The inputs to each kernel are stored contiguously in `inputs`.
     //
     // We use `kernels_[i].input_start_index` and `kernels_[i].num_inputs` to
@@ -264,48 +310,61 @@ class SingleThreadedExecutorImpl : public Executor {
     // Note that kernels with zero inputs do not correspond to any elements in
     // this vector.
     //
-    // We use `ManualConstructor<Tensor>` to avoid the overhead of
-    // default-constructing an invalid `Tensor` for each slot at the beginning
-    // of execution:
+    // Every element is in the `NO_VALUE` state between invocations:
     // * Elements are initialized when the outputs of a kernel execution are
     //   propagated to the inputs of kernels that depend on them.
-    // * The elements corresponding to the inputs for kernel `i` are destroyed
-    //   after kernel `i` executes.
-    // * In an error case (see below), we use the connectivity information in
-    //   `KernelState::output_locations` to determine which locations have been
-    //   initialized, and manually destroy them.
-    std::vector<Entry> inputs(total_num_inputs_);
+    // * The elements corresponding to the inputs for kernel `i` are cleared
+    //   after kernel `i` executes (or is found to be dead).
+    // * In an error case, `Run()` clears all elements.
+    //
+    // In a graph with conditionals, an element that is still in the `NO_VALUE`
+    // state when its kernel executes is a dead input.
+    std::vector<Entry> inputs;
+
+    // For graphs with conditionals, `dead_control_inputs[i]` is true if kernel
+    // `i` has a dead control input. All elements are false between
+    // invocations: in an error case, `Run()` resets them.
+    std::vector<bool> dead_control_inputs;
 
     // TODO(mrry): Can we avoid copying into these vectors? Consider modifying
     // OpKernelContext to take the TensorValueVec as a pointer into `inputs`.
     TensorValueVec node_inputs;
     AllocatorAttributeVec input_alloc_attrs;
 
-    // Prepare the parameters that will be the same for all kernels.
+    Args::Runner runner;
     OpKernelContext::Params params;
-    params.step_id = args.step_id;
+  };
+
+  std::unique_ptr<RunState> GetRunState() {
+    {
+      mutex_lock l(run_states_mu_);
+      if (!run_states_.empty()) {
+        std::unique_ptr<RunState> state = std::move(run_states_.back());
+        run_states_.pop_back();
+        return state;
+      }
+    }
+    auto state = absl::make_unique<RunState>();
+    state->inputs.resize(total_num_inputs_);
+    if (has_control_flow_) {
+      state->dead_control_inputs.resize(kernels_.size(), false);
+    }
+
+    // Prepare the parameters that will be the same for all kernels and all
+    // invocations.
+    OpKernelContext::Params& params = state->params;
     Device* device = params_.device;
     params.device = device;
     params.log_memory = false;              // TODO(mrry): Too severe?
-    params.rendezvous = args.rendezvous;
-    params.session_state = args.session_state;
-    params.tensor_store = args.tensor_store;
-    params.cancellation_manager = args.cancellation_manager;
-    params.call_frame = args.call_frame;
     params.function_library = params_.function_library;
     params.resource_manager = device->resource_manager();
-    params.step_container = args.step_container;
     params.slice_reader_cache = nullptr;  // TODO(mrry): Too severe?
-    params.inputs = &node_inputs;
-    params.input_alloc_attrs = &input_alloc_attrs;
-
-    Args::Runner runner_copy = args.runner;
-    params.runner = &runner_copy;
-    params.run_all_kernels_inline = args.run_all_kernels_inline;
-    params.stats_collector = args.stats_collector;
+    params.inputs = &state->node_inputs;
+    params.input_alloc_attrs = &state->input_alloc_attrs;
+    params.runner = &state->runner;
     params.executor_type = &kSingleThreadedExecutor;
 
-    // NOTE(mrry): We are assuming that the graph is loopless and condless.
+    // NOTE(mrry): We are assuming that the graph is loopless.
     params.frame_iter = FrameAndIter(0, 0);
     params.is_input_dead = false;
 
@@ -313,6 +372,32 @@ class SingleThreadedExecutorImpl : public Executor {
     params.op_device_context = nullptr;
     // TODO(mrry): Consider implementing forwarding.
     params.forward_from_array = nullptr;
+    return state;
+  }
+
+  void ReturnRunState(std::unique_ptr<RunState> state) {
+    mutex_lock l(run_states_mu_);
+    run_states_.push_back(std::move(state));
+  }
+
+  Status RunInternal(const Args& args, RunState* state) {
+    std::vector<Entry>& inputs = state->inputs;
+    TensorValueVec& node_inputs = state->node_inputs;
+    AllocatorAttributeVec& input_alloc_attrs = state->input_alloc_attrs;
+
+    // Prepare the parameters that will be the same for all kernels.
+    OpKernelContext::Params& params = state->params;
+    params.step_id = args.step_id;
+    Device* device = params_.device;
+    params.rendezvous = args.rendezvous;
+    params.session_state = args.session_state;
+    params.tensor_store = args.tensor_store;
+    params.cancellation_manager = args.cancellation_manager;
+    params.call_frame = args.call_frame;
+    params.step_container = args.step_container;
+    state->runner = args.runner;
+    params.run_all_kernels_inline = args.run_all_kernels_inline;
+    params.stats_collector = args.stats_collector;
 
     const size_t received_args =
         args.call_frame ? args.call_frame->num_args() : 0;
@@ -384,6 +469,7 @@ class SingleThreadedExecutorImpl : public Executor {
       const size_t num_inputs = kernel_state.num_inputs;
       const size_t num_outputs = kernel_state.num_outputs;
 
+      size_t num_dead_inputs = 0;
       node_inputs.clear();
       node_inputs.resize(num_inputs);
       input_alloc_attrs.clear();
@@ -401,11 +487,43 @@ class SingleThreadedExecutorImpl : public Executor {
           case Entry::State::HAS_VALUE:
             node_inputs[j].tensor = input.val.get();
             break;
+          case Entry::State::NO_VALUE:
+            if (has_control_flow_) {
+              // The input was produced by a dead node, or is the untaken
+              // output of a Switch.
+              ++num_dead_inputs;
+              break;
+            }
+            TF_FALLTHROUGH_INTENDED;
           default:
             DCHECK(false) << "Input did not have a valid value.";
         }
         input_alloc_attrs[j] = input_alloc_attrs_[input_start_index + j];
       }
+
+      if (has_control_flow_) {
+        // As in the default executor, a Merge is dead iff all of its data
+        // inputs are dead, and any other node is dead if any of its data or
+        // control inputs is dead.
+        bool is_dead;
+        if (kernel_state.is_merge) {
+          is_dead = num_dead_inputs == num_inputs;
+        } else {
+          is_dead = num_dead_inputs > 0 || state->dead_control_inputs[i];
+        }
+        state->dead_control_inputs[i] = false;
+        if (is_dead) {
+          // Skip the kernel, and leave its outputs in the `NO_VALUE` state.
+          for (size_t j = 0; j < num_inputs; ++j) {
+            inputs[input_start_index + j].ClearVal();
+          }
+          for (size_t dst : kernel_state.control_output_kernels) {
+            state->dead_control_inputs[dst] = true;
+          }
+          continue;
+        }
+      }
+
       params.op_kernel = kernel_state.kernel;
       params.output_attr_array = kernel_state.output_alloc_attrs.data();
       OpKernelContext ctx(&params, num_outputs);
@@ -422,6 +540,11 @@ class SingleThreadedExecutorImpl : public Executor {
       // Forward the outputs of the kernel to the inputs of subsequent kernels.
       for (size_t j = 0; j < num_outputs; ++j) {
         TensorValue val = ctx.release_output(j);
+        if (val.tensor == nullptr) {
+          // The kernel did not produce this output (e.g. the untaken output of
+          // a Switch), so its consumers will observe a dead input.
+          continue;
+        }
         const size_t num_destinations = kernel_state.output_locations[j].size();
         if (num_destinations > 0) {
           // TODO(mrry): Consider flattening the `output_locations` vector
@@ -445,20 +568,26 @@ class SingleThreadedExecutorImpl : public Executor {
     return Status::OK();
   }
 
-  void RunAsync(const Args& args, DoneCallback done) override {
-    done(Run(args));
+  static bool HasControlInputs(const Node& n) {
+    for (const Edge* e : n.in_edges()) {
+      if (e->IsControlEdge() && !e->src()->IsSource()) return true;
+    }
+    return false;
   }
 
- private:
   const LocalExecutorParams params_;
 
   // All following members are read-only after Initialize().
 
   // The sum of the number of inputs for each node in the graph. This determines
-  // the length of the flat `inputs` vector. See comment at the beginning of
-  // `RunAsync()` for details.
+  // the length of the flat `inputs` vector. See comment on `RunState::inputs`
+  // for details.
   size_t total_num_inputs_;
 
+  // True iff the graph contains Switch or Merge nodes, in which case deadness
+  // is tracked during execution.
+  bool has_control_flow_ = false;
+
   // Represents cached graph structure state for each kernel.
   struct KernelState {
     // The kernel object. Not owned.
@@ -476,10 +605,18 @@ class SingleThreadedExecutorImpl : public Executor {
 
     // For the `j`th output of `kernel`, `output_locations[j]` contains the
     // locations in the flat `inputs` vector to which that output must be
-    // copied. See comment at the beginning of `Run()` for details.
+    // copied. See comment on `RunState::inputs` for details.
     std::vector<std::vector<size_t>>
         output_locations;  // Length = `num_outputs`.
 
+    // True iff `kernel` is a Merge, which is only dead if all of its data
+    // inputs are dead.
+    bool is_merge;
+
+    // The indices in `kernels_` of the destinations of the control edges from
+    // this kernel. Only populated for graphs with conditionals.
+    std::vector<size_t> control_output_kernels;
+
     // Memory space information for each output of `kernel`.
     std::vector<AllocatorAttributes>
         output_alloc_attrs;  // Length = `num_outputs`.
@@ -510,7 +647,7 @@ class SingleThreadedExecutorImpl : public Executor {
 
     // For the single output of `kernel`, `output_locations` contains the
     // locations in the flat `inputs` vector to which that output must be
-    // copied. See comment at the beginning of `Run()` for details.
+    // copied. See comment on `RunState::inputs` for details.
     std::vector<size_t> output_locations;  // Length = `num_outputs`.
 
     // Memory space information for the single output of `kernel`.
@@ -519,10 +656,16 @@ class SingleThreadedExecutorImpl : public Executor {
   std::vector<ConstTensorKernelState> const_tensor_kernels_;
 
   // Memory space information for each input. This information is stored in the
-  // same order as the flat `inputs` vector. See comment at the beginning of
-  // `RunAsync()` for details.
+  // same order as the flat `inputs` vector. See comment on `RunState::inputs`
+  // for details.
   std::vector<AllocatorAttributes>
       input_alloc_attrs_;  // Length = `total_num_inputs_`.
+
+  // Run states that are not in use by a current invocation. `Run()` may be
+  // called concurrently, so this holds up to one state per concurrent caller.
+  mutex run_states_mu_;
+  std::vector<std::unique_ptr<RunState>> run_states_
+      TF_GUARDED_BY(run_states_mu_);
 };
 
 class SingleThreadedExecutorRegistrar {
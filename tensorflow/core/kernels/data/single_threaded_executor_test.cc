@@ -56,6 +56,10 @@ class ExecutorTest : public ::testing::Test {
 
   // Resets executor_ with a new executor based on a graph 'gdef'.
   void Create(std::unique_ptr<const Graph> graph) {
+    TF_CHECK_OK(TryCreate(std::move(graph)));
+  }
+
+  Status TryCreate(std::unique_ptr<const Graph> graph) {
     const int version = graph->versions().producer();
     LocalExecutorParams params;
     params.device = device_.get();
@@ -69,9 +73,10 @@ class ExecutorTest : public ::testing::Test {
       DeleteNonCachedKernel(kernel);
     };
     delete exec_;
-    TF_CHECK_OK(NewSingleThreadedExecutor(params, *graph, &exec_));
+    exec_ = nullptr;
     runner_ = [](const std::function<void()>& fn) { fn(); };
     rendez_ = NewLocalRendezvous();
+    return NewSingleThreadedExecutor(params, *graph, &exec_);
   }
 
   Status Run(Rendezvous* rendez) {
@@ -273,6 +278,123 @@ TEST_F(ExecutorTest, ControlDependenciesFromSpecialNodes) {
   EXPECT_EQ(3.0, V(retvals[0]));  // out = 1.0 + 2.0 = 3.0
 }
 
+// Builds a graph that computes `pred ? x + 2 : x + 1`, where the constant in
+// each branch has a control dependency on the branch's pivot.
+void BuildCond(Graph* g) {
+  auto x = test::graph::Arg(g, 0, DT_FLOAT);
+  auto pred = test::graph::Arg(g, 1, DT_BOOL);
+  auto sw = test::graph::Switch(g, x, pred);
+  auto pivot_f = test::graph::Identity(g, sw, 0);
+  auto pivot_t = test::graph::Identity(g, sw, 1);
+  auto one = test::graph::Constant(g, V(1.0));
+  g->AddControlEdge(pivot_f, one);
+  auto two = test::graph::Constant(g, V(2.0));
+  g->AddControlEdge(pivot_t, two);
+  auto add_f = test::graph::Add(g, pivot_f, one);
+  auto add_t = test::graph::Add(g, pivot_t, two);
+  auto merge = test::graph::Merge(g, add_f, add_t);
+  test::graph::Retval(g, 0, merge);
+  FixupSourceAndSinkEdges(g);
+}
+
+TEST_F(ExecutorTest, Cond) {
+  auto g = absl::make_unique<Graph>(OpRegistry::Global());
+  BuildCond(g.get());
+  Create(std::move(g));
+  // Alternate between the branches, to check that no deadness leaks from one
+  // invocation to the next.
+  for (int i = 0; i < 4; ++i) {
+    const bool pred = i % 2 == 0;
+    FunctionCallFrame call_frame({DT_FLOAT, DT_BOOL}, {DT_FLOAT});
+    TF_ASSERT_OK(call_frame.SetArgs({V(10.0), VB(pred)}));
+    TF_ASSERT_OK(Run(&call_frame));
+    std::vector<Tensor> retvals;
+    TF_ASSERT_OK(call_frame.ConsumeRetvals(&retvals, false));
+    EXPECT_EQ(pred ? 12.0 : 11.0, V(retvals[0]));
+  }
+}
+
+TEST_F(ExecutorTest, LoopsAreNotSupported) {
+  auto g = absl::make_unique<Graph>(OpRegistry::Global());
+  auto in0 = test::graph::Arg(g.get(), 0, DT_FLOAT);
+  auto enter = test::graph::Enter(g.get(), in0, "frame");
+  test::graph::Retval(g.get(), 0, test::graph::Exit(g.get(), enter));
+  FixupSourceAndSinkEdges(g.get());
+  EXPECT_TRUE(errors::IsFailedPrecondition(TryCreate(std::move(g))));
+}
+
+TEST_F(ExecutorTest, RepeatedRunsReuseState) {
+  auto g = absl::make_unique<Graph>(OpRegistry::Global());
+  BuildTree(64, g.get());
+  Create(std::move(g));
+  for (int i = 0; i < 100; ++i) {
+    FunctionCallFrame call_frame({DT_FLOAT}, {DT_FLOAT});
+    TF_ASSERT_OK(call_frame.SetArgs({V(static_cast<float>(i))}));
+    TF_ASSERT_OK(Run(&call_frame));
+    std::vector<Tensor> retvals;
+    TF_ASSERT_OK(call_frame.ConsumeRetvals(&retvals, false));
+    EXPECT_EQ(64.0 * i, V(retvals[0]));
+  }
+}
+
+TEST_F(ExecutorTest, ErrorThenSuccess) {
+  // An error part-way through a run must not leave values behind for the
+  // next run.
+  auto g = absl::make_unique<Graph>(OpRegistry::Global());
+  auto x = test::graph::Arg(g.get(), 0, DT_FLOAT);
+  auto check = test::graph::CheckNumerics(
+      g.get(), test::graph::Unary(g.get(), "Reciprocal", x), "message");
+  test::graph::Retval(g.get(), 0, test::graph::Add(g.get(), check, x));
+  FixupSourceAndSinkEdges(g.get());
+  Create(std::move(g));
+  {
+    FunctionCallFrame call_frame({DT_FLOAT}, {DT_FLOAT});
+    TF_ASSERT_OK(call_frame.SetArgs({V(0.0)}));
+    EXPECT_TRUE(errors::IsInvalidArgument(Run(&call_frame)));
+  }
+  {
+    FunctionCallFrame call_frame({DT_FLOAT}, {DT_FLOAT});
+    TF_ASSERT_OK(call_frame.SetArgs({V(2.0)}));
+    TF_ASSERT_OK(Run(&call_frame));
+    std::vector<Tensor> retvals;
+    TF_ASSERT_OK(call_frame.ConsumeRetvals(&retvals, false));
+    EXPECT_EQ(2.5, V(retvals[0]));
+  }
+}
+
+TEST_F(ExecutorTest, ErrorThenSuccessWithDeadControlInput) {
+  // An error part-way through a run must not leave a dead control input
+  // behind for the next run. `out` has a control input from the false branch
+  // of a conditional and a data input that fails when `x` is 0.
+  auto g = absl::make_unique<Graph>(OpRegistry::Global());
+  auto x = test::graph::Arg(g.get(), 0, DT_FLOAT);
+  auto pred = test::graph::Arg(g.get(), 1, DT_BOOL);
+  auto sw = test::graph::Switch(g.get(), x, pred);
+  auto pivot_f = test::graph::Identity(g.get(), sw, 0);
+  auto pivot_t = test::graph::Identity(g.get(), sw, 1);
+  auto merge = test::graph::Merge(g.get(), pivot_f, pivot_t);
+  auto check = test::graph::CheckNumerics(
+      g.get(), test::graph::Unary(g.get(), "Reciprocal", merge), "message");
+  auto out = test::graph::Add(g.get(), check, x);
+  g->AddControlEdge(pivot_f, out);
+  test::graph::Retval(g.get(), 0, out);
+  FixupSourceAndSinkEdges(g.get());
+  Create(std::move(g));
+  {
+    FunctionCallFrame call_frame({DT_FLOAT, DT_BOOL}, {DT_FLOAT});
+    TF_ASSERT_OK(call_frame.SetArgs({V(0.0), VB(true)}));
+    EXPECT_TRUE(errors::IsInvalidArgument(Run(&call_frame)));
+  }
+  {
+    FunctionCallFrame call_frame({DT_FLOAT, DT_BOOL}, {DT_FLOAT});
+    TF_ASSERT_OK(call_frame.SetArgs({V(2.0), VB(false)}));
+    TF_ASSERT_OK(Run(&call_frame));
+    std::vector<Tensor> retvals;
+    TF_ASSERT_OK(call_frame.ConsumeRetvals(&retvals, false));
+    EXPECT_EQ(2.5, V(retvals[0]));
+  }
+}
+
 static void BM_executor(int iters, int width, int depth) {
 #ifdef PLATFORM_GOOGLE
   BenchmarkUseRealTime();
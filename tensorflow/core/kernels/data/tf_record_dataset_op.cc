@@ -17,6 +17,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/metrics.h"
 #include "tensorflow/core/framework/partial_tensor_shape.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/kernels/data/file_handle_cache.h"
 #include "tensorflow/core/kernels/data/name_utils.h"
 #include "tensorflow/core/lib/io/buffered_inputstream.h"
 #include "tensorflow/core/lib/io/inputbuffer.h"
@@ -24,6 +25,7 @@ limitations under the License.
 #include "tensorflow/core/lib/io/record_reader.h"
 #include "tensorflow/core/lib/io/zlib_compression_options.h"
 #include "tensorflow/core/lib/io/zlib_inputstream.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 namespace data {
@@ -43,6 +45,19 @@ constexpr char kS3FsPrefix[] = "s3://";
 constexpr int64 kCloudTpuBlockSize = 127LL << 20;  // 127MB.
 constexpr int64 kS3BlockSize = kCloudTpuBlockSize;
 
+// Returns the number of bytes of records to read ahead of the consumer on a
+// background thread, or 0 to read records on the thread calling `GetNext`.
+int64 ReadaheadBytes() {
+  int64 readahead_bytes;
+  Status s = ReadInt64FromEnvVar("TF_DATA_TFRECORD_READAHEAD_BYTES", 0,
+                                 &readahead_bytes);
+  if (!s.ok()) {
+    LOG(ERROR) << s;
+    return 0;
+  }
+  return readahead_bytes;
+}
+
 bool is_cloud_tpu_gcs_fs() {
 #if defined(PLATFORM_CLOUD_TPU) && defined(TPU_GCS_FS)
   return true;
@@ -58,7 +73,8 @@ class TFRecordDatasetOp::Dataset : public DatasetBase {
         filenames_(std::move(filenames)),
         compression_type_(compression_type),
         options_(io::RecordReaderOptions::CreateRecordReaderOptions(
-            compression_type)) {
+            compression_type)),
+        readahead_bytes_(ReadaheadBytes()) {
     if (buffer_size > 0) {
       options_.buffer_size = buffer_size;
     }
@@ -201,9 +217,16 @@ class TFRecordDatasetOp::Dataset : public DatasetBase {
 
       // Actually move on to next file.
       const string& next_filename = dataset()->filenames_[current_file_index_];
-      TF_RETURN_IF_ERROR(env->NewRandomAccessFile(next_filename, &file_));
-      reader_ = absl::make_unique<io::SequentialRecordReader>(
-          file_.get(), dataset()->options_);
+      FileHandleCache* cache = FileHandleCache::Global();
+      if (cache != nullptr) {
+        TF_RETURN_IF_ERROR(cache->Lookup(env, next_filename, &file_));
+      } else {
+        std::unique_ptr<RandomAccessFile> file;
+        TF_RETURN_IF_ERROR(env->NewRandomAccessFile(next_filename, &file));
+        file_ = std::move(file);
+      }
+      reader_ = absl::make_unique<io::PrefetchingRecordReader>(
+          env, file_.get(), dataset()->options_, dataset()->readahead_bytes_);
       return Status::OK();
     }
 
@@ -217,14 +240,16 @@ class TFRecordDatasetOp::Dataset : public DatasetBase {
     size_t current_file_index_ TF_GUARDED_BY(mu_) = 0;
 
     // `reader_` will borrow the object that `file_` points to, so
-    // we must destroy `reader_` before `file_`.
-    std::unique_ptr<RandomAccessFile> file_ TF_GUARDED_BY(mu_);
-    std::unique_ptr<io::SequentialRecordReader> reader_ TF_GUARDED_BY(mu_);
+    // we must destroy `reader_` before `file_`. `file_` may be shared with
+    // other iterators through the `FileHandleCache`.
+    std::shared_ptr<RandomAccessFile> file_ TF_GUARDED_BY(mu_);
+    std::unique_ptr<io::PrefetchingRecordReader> reader_ TF_GUARDED_BY(mu_);
   };
 
   const std::vector<string> filenames_;
   const tstring compression_type_;
   io::RecordReaderOptions options_;
+  const int64 readahead_bytes_;
 };
 
 TFRecordDatasetOp::TFRecordDatasetOp(OpKernelConstruction* ctx)
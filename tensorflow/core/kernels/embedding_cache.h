@@ -0,0 +1,257 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_KERNELS_EMBEDDING_CACHE_H_
+#define TENSORFLOW_CORE_KERNELS_EMBEDDING_CACHE_H_
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/core/framework/metrics.h"
+#include "tensorflow/core/framework/resource_mgr.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/kernels/embedding_variable.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+
+namespace tensorflow {
+
+// Key of the empty slots of an embedding cache. All its bytes are ones, so
+// the keys of a cache are emptied with a memset. The id itself is never
+// cached.
+constexpr int64 kEmbeddingCacheEmptyKey = -1;
+
+// Returns the set that holds `id` in a cache of `num_sets` sets, a power of
+// two. Used by the host and the device, which must agree on it.
+EIGEN_DEVICE_FUNC inline int64 EmbeddingCacheSet(int64 id, int64 num_sets) {
+  const uint64 hash = static_cast<uint64>(id) * 0x9E3779B97F4A7C15ull;
+  return static_cast<int64>((hash >> 32) & (num_sets - 1));
+}
+
+// The host side directory of a set-associative cache of `num_sets` sets of
+// `ways` slots, where slot s belongs to set s / ways.
+//
+// The directory mirrors the keys of the slots, which live on the device, and
+// keeps their access stamps so that misses are assigned the least recently
+// used slot of their set without reading device memory.
+class EmbeddingCacheDirectory {
+ public:
+  EmbeddingCacheDirectory(int64 num_sets, int64 ways)
+      : num_sets_(num_sets),
+        ways_(ways),
+        keys_(num_sets * ways, kEmbeddingCacheEmptyKey),
+        stamps_(num_sets * ways, 0) {}
+
+  int64 num_sets() const { return num_sets_; }
+  int64 ways() const { return ways_; }
+  int64 num_slots() const { return keys_.size(); }
+
+  // The id cached in `slot`, or kEmbeddingCacheEmptyKey.
+  int64 key(int64 slot) const { return keys_[slot]; }
+
+  // Starts a batch of accesses. Slots touched or admitted during a batch are
+  // not evicted before the next batch, so that every id of a batch keeps the
+  // slot it was given.
+  void StartBatch() { ++clock_; }
+
+  // Marks `slot` as used by the current batch.
+  void Touch(int64 slot) { stamps_[slot] = clock_; }
+
+  // Gives `id`, which must not be cached, the least recently used slot of its
+  // set and returns the slot, setting `*evicted` to the id the slot held or
+  // to kEmbeddingCacheEmptyKey. Returns -1 without caching `id` if every slot
+  // of the set is used by the current batch.
+  int64 Admit(int64 id, int64* evicted) {
+    *evicted = kEmbeddingCacheEmptyKey;
+    if (id == kEmbeddingCacheEmptyKey) {
+      return -1;
+    }
+    const int64 first = EmbeddingCacheSet(id, num_sets_) * ways_;
+    int64 victim = first;
+    for (int64 slot = first + 1; slot < first + ways_; ++slot) {
+      if (stamps_[slot] < stamps_[victim]) {
+        victim = slot;
+      }
+    }
+    if (stamps_[victim] == clock_) {
+      return -1;
+    }
+    *evicted = keys_[victim];
+    keys_[victim] = id;
+    stamps_[victim] = clock_;
+    return victim;
+  }
+
+  // Empties all slots.
+  void Clear() {
+    std::fill(keys_.begin(), keys_.end(), kEmbeddingCacheEmptyKey);
+    std::fill(stamps_.begin(), stamps_.end(), 0);
+  }
+
+ private:
+  const int64 num_sets_;
+  const int64 ways_;
+  std::vector<int64> keys_;
+  std::vector<int64> stamps_;
+  int64 clock_ = 0;
+};
+
+// An embedding table of `dim` columns whose rows live in host memory, with
+// the recently used rows cached in device memory.
+//
+// The device holds the keys and rows of the cache slots and finds the slots
+// of a batch of ids by probing their sets. The host holds the directory and
+// the full table, an EmbeddingVariable that never evicts. The rows of misses
+// are fetched from the full table in one copy per batch. Rows evicted from
+// the cache are copied back on the device stream without waiting, and reach
+// the full table once the next operation on the cache synchronizes with the
+// device.
+template <typename T>
+class EmbeddingCache : public ResourceBase {
+ public:
+  struct Options {
+    int64 dim = 1;
+    int64 num_sets = 1;
+    int64 ways = 1;
+  };
+
+  // A batch of evicted rows being copied back into `rows`, which is in host
+  // memory, by the device stream.
+  struct Writeback {
+    std::vector<int64> ids;
+    Tensor rows;
+  };
+
+  // `keys` and `values` are the device tensors of the slots, of shapes
+  // [num_sets * ways] and [num_sets * ways, dim]. `keys` must be empty.
+  EmbeddingCache(const Options& options, Tensor keys, Tensor values)
+      : options_(options),
+        directory_(options.num_sets, options.ways),
+        table_(new EmbeddingVariable<T>(TableOptions(options))),
+        keys_(std::move(keys)),
+        values_(std::move(values)) {}
+
+  std::string DebugString() const override {
+    tf_shared_lock l(mu_);
+    return strings::StrCat("EmbeddingCache(", DataTypeString(dtype()),
+                           ", dim=", options_.dim,
+                           ", slots=", directory_.num_slots(), ")");
+  }
+
+  int64 MemoryUsed() const override {
+    tf_shared_lock l(mu_);
+    return sizeof(EmbeddingCache) + keys_.AllocatedBytes() +
+           values_.AllocatedBytes() + table_->MemoryUsed();
+  }
+
+  DataType dtype() const { return DataTypeToEnum<T>::value; }
+  const Options& options() const { return options_; }
+  mutex* mu() const TF_LOCK_RETURNED(mu_) { return &mu_; }
+
+  EmbeddingCacheDirectory* directory() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    return &directory_;
+  }
+  // The full table. Its own mutex guards its rows.
+  EmbeddingVariable<T>* table() { return table_.get(); }
+  Tensor* keys() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) { return &keys_; }
+  Tensor* values() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) { return &values_; }
+
+  void AddWriteback(Writeback writeback) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    writebacks_.push_back(std::move(writeback));
+  }
+
+  // Stores the rows written back into the full table. The device stream must
+  // have finished the copies.
+  void ApplyWritebacks() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    if (writebacks_.empty()) {
+      return;
+    }
+    const int64 dim = options_.dim;
+    int64 num_rows = 0;
+    mutex_lock l(*table_->mu());
+    for (const Writeback& writeback : writebacks_) {
+      const T* rows = writeback.rows.flat<T>().data();
+      for (size_t i = 0; i < writeback.ids.size(); ++i) {
+        T* row = table_->Find(writeback.ids[i]);
+        if (row == nullptr) {
+          row = table_->Insert(writeback.ids[i], 0);
+        }
+        std::copy_n(rows + i * dim, dim, row);
+      }
+      num_rows += writeback.ids.size();
+    }
+    writebacks_.clear();
+    metrics::RecordEmbeddingCacheWritebacks(num_rows);
+  }
+
+  // Drops the rows being written back.
+  void ClearWritebacks() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    writebacks_.clear();
+  }
+
+ private:
+  static typename EmbeddingVariable<T>::Options TableOptions(
+      const Options& options) {
+    typename EmbeddingVariable<T>::Options table_options;
+    table_options.dim = options.dim;
+    return table_options;
+  }
+
+  const Options options_;
+
+  mutable mutex mu_;
+  EmbeddingCacheDirectory directory_ TF_GUARDED_BY(mu_);
+  const core::RefCountPtr<EmbeddingVariable<T>> table_;
+  Tensor keys_ TF_GUARDED_BY(mu_);
+  Tensor values_ TF_GUARDED_BY(mu_);
+  std::vector<Writeback> writebacks_ TF_GUARDED_BY(mu_);
+};
+
+namespace functor {
+
+// Sets slots[i] to the slot that caches ids[i], or to -1.
+template <typename Device, typename Index>
+struct EmbeddingCacheProbe {
+  void operator()(const Device& d, const Index* ids, int64 num_ids,
+                  const int64* keys, int64 num_sets, int64 ways,
+                  int32* slots);
+};
+
+// Copies row src_rows[i] of `src` to row dst_rows[i] of `dst` for the
+// `num_rows` values of i, skipping negative rows. A null `src_rows` or
+// `dst_rows` stands for i itself.
+template <typename Device, typename T>
+struct EmbeddingCacheCopyRows {
+  void operator()(const Device& d, const T* src, const int32* src_rows,
+                  const int32* dst_rows, int64 num_rows, int64 dim, T* dst);
+};
+
+// Adds row i of `updates` to row slots[i] of `values` for the `num_rows`
+// values of i, skipping negative slots. Slots may repeat.
+template <typename Device, typename T>
+struct EmbeddingCacheAddRows {
+  void operator()(const Device& d, const T* updates, const int32* slots,
+                  int64 num_rows, int64 dim, T* values);
+};
+
+}  // namespace functor
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_EMBEDDING_CACHE_H_
@@ -0,0 +1,625 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// See docs in ../ops/resource_variable_ops.cc.
+
+#if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+
+#define EIGEN_USE_GPU
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "tensorflow/core/common_runtime/gpu/gpu_event_mgr.h"
+#include "tensorflow/core/framework/metrics.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/framework/resource_mgr.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_reference.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/kernels/embedding_cache.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/stream_executor.h"
+
+namespace tensorflow {
+
+typedef Eigen::GpuDevice GPUDevice;
+
+namespace {
+
+Status AllocateHostTemp(OpKernelContext* ctx, DataType dtype,
+                        const TensorShape& shape, Tensor* tensor) {
+  AllocatorAttributes attr;
+  attr.set_on_host(true);
+  attr.set_gpu_compatible(true);
+  return ctx->allocate_temp(dtype, shape, tensor, attr);
+}
+
+// Enqueues the copy of the host tensor `host` to a new device tensor, keeping
+// `host` alive until the copy is done.
+Status CopyToDevice(OpKernelContext* ctx, const Tensor& host, Tensor* device) {
+  TF_RETURN_IF_ERROR(ctx->allocate_temp(host.dtype(), host.shape(), device));
+  const uint64 bytes = host.TotalBytes();
+  if (bytes == 0) {
+    return Status::OK();
+  }
+  se::DeviceMemoryBase dst(const_cast<char*>(device->tensor_data().data()),
+                           bytes);
+  se::Stream* stream = ctx->op_device_context()->stream();
+  if (!stream->ThenMemcpy(&dst, host.tensor_data().data(), bytes).ok()) {
+    return errors::Internal("EmbeddingCache failed to copy ", bytes,
+                            " bytes to the device");
+  }
+  TensorReference host_ref(host);
+  ctx->device()->tensorflow_gpu_device_info()->event_mgr->ThenExecute(
+      stream, [host_ref]() { host_ref.Unref(); });
+  return Status::OK();
+}
+
+// Enqueues the copy of the device tensor `device` to `host`, a host tensor of
+// the same shape that must stay alive until the copy is done.
+Status CopyToHost(OpKernelContext* ctx, const Tensor& device, Tensor* host) {
+  const uint64 bytes = device.TotalBytes();
+  if (bytes == 0) {
+    return Status::OK();
+  }
+  se::DeviceMemoryBase src(const_cast<char*>(device.tensor_data().data()),
+                           bytes);
+  se::Stream* stream = ctx->op_device_context()->stream();
+  if (!stream
+           ->ThenMemcpy(const_cast<char*>(host->tensor_data().data()), src,
+                        bytes)
+           .ok()) {
+    return errors::Internal("EmbeddingCache failed to copy ", bytes,
+                            " bytes from the device");
+  }
+  return Status::OK();
+}
+
+// The host decides what a batch of ids does once it knows which of them the
+// device found, so the kernels wait for the device stream rather than running
+// asynchronously. Waiting also finishes the writebacks of earlier kernels.
+Status Synchronize(OpKernelContext* ctx) {
+  return ctx->op_device_context()->stream()->BlockHostUntilDone();
+}
+
+// Enqueues the emptying of all slots of `keys`.
+Status ClearKeys(OpKernelContext* ctx, Tensor* keys) {
+  const uint64 bytes = keys->TotalBytes();
+  se::DeviceMemoryBase mem(keys->flat<int64>().data(), bytes);
+  static_assert(kEmbeddingCacheEmptyKey == -1,
+                "The empty key must consist of bytes 0xFF");
+  if (!ctx->op_device_context()
+           ->stream()
+           ->ThenMemset32(&mem, 0xFFFFFFFF, bytes)
+           .ok()) {
+    return errors::Internal("EmbeddingCache failed to clear ", bytes,
+                            " bytes of keys");
+  }
+  return Status::OK();
+}
+
+// Finds the slots of the host tensor `ids`, into the device tensor `*slots`
+// and the host tensor `*slots_host`, and stores the finished writebacks in the
+// full table. The mutex of `cache` must be held.
+template <typename T, typename Index>
+Status FindSlots(OpKernelContext* ctx, EmbeddingCache<T>* cache,
+                 const Tensor& ids, Tensor* slots, Tensor* slots_host) {
+  const int64 n = ids.NumElements();
+  Tensor ids_device;
+  TF_RETURN_IF_ERROR(CopyToDevice(ctx, ids, &ids_device));
+  TF_RETURN_IF_ERROR(ctx->allocate_temp(DT_INT32, TensorShape({n}), slots));
+  functor::EmbeddingCacheProbe<GPUDevice, Index>()(
+      ctx->eigen_device<GPUDevice>(), ids_device.flat<Index>().data(), n,
+      cache->keys()->template flat<int64>().data(), cache->options().num_sets,
+      cache->options().ways, slots->flat<int32>().data());
+  TF_RETURN_IF_ERROR(
+      AllocateHostTemp(ctx, DT_INT32, TensorShape({n}), slots_host));
+  TF_RETURN_IF_ERROR(CopyToHost(ctx, *slots, slots_host));
+  TF_RETURN_IF_ERROR(Synchronize(ctx));
+  cache->ApplyWritebacks();
+  return Status::OK();
+}
+
+// Copies `values` to a new host tensor of int32.
+Status MakeHostIndices(OpKernelContext* ctx, const std::vector<int32>& values,
+                       Tensor* tensor) {
+  TF_RETURN_IF_ERROR(AllocateHostTemp(
+      ctx, DT_INT32, TensorShape({static_cast<int64>(values.size())}),
+      tensor));
+  std::copy(values.begin(), values.end(), tensor->flat<int32>().data());
+  return Status::OK();
+}
+
+}  // namespace
+
+template <typename T>
+class EmbeddingCacheOp : public OpKernel {
+ public:
+  explicit EmbeddingCacheOp(OpKernelConstruction* c) : OpKernel(c) {
+    OP_REQUIRES_OK(c, c->GetAttr("container", &container_));
+    OP_REQUIRES_OK(c, c->GetAttr("shared_name", &name_));
+    if (name_.empty()) {
+      name_ = name();
+    }
+    OP_REQUIRES_OK(c, c->GetAttr("dim", &options_.dim));
+    OP_REQUIRES_OK(c, c->GetAttr("num_sets", &options_.num_sets));
+    OP_REQUIRES_OK(c, c->GetAttr("ways", &options_.ways));
+    OP_REQUIRES(c, (options_.num_sets & (options_.num_sets - 1)) == 0,
+                errors::InvalidArgument("num_sets must be a power of two, got ",
+                                        options_.num_sets));
+    OP_REQUIRES(c,
+                options_.num_sets <=
+                    std::numeric_limits<int32>::max() / options_.ways,
+                errors::InvalidArgument(
+                    "EmbeddingCache must have fewer than 2^31 slots, got ",
+                    options_.num_sets, " sets of ", options_.ways, " ways"));
+  }
+
+  void Compute(OpKernelContext* ctx) override {
+    const ResourceHandle handle =
+        MakeResourceHandle<EmbeddingCache<T>>(ctx, container_, name_);
+    core::RefCountPtr<EmbeddingCache<T>> cache;
+    OP_REQUIRES_OK(ctx, LookupOrCreateResource<EmbeddingCache<T>>(
+                            ctx, handle, &cache,
+                            [this, ctx](EmbeddingCache<T>** ptr) {
+                              return CreateCache(ctx, ptr);
+                            }));
+    OP_REQUIRES(
+        ctx,
+        cache->options().dim == options_.dim &&
+            cache->options().num_sets == options_.num_sets &&
+            cache->options().ways == options_.ways,
+        errors::InvalidArgument(
+            "EmbeddingCache ", name_, " exists with dim ",
+            cache->options().dim, " and ", cache->options().num_sets,
+            " sets of ", cache->options().ways, " ways, requested dim ",
+            options_.dim, " and ", options_.num_sets, " sets of ",
+            options_.ways, " ways"));
+
+    Tensor* output;
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(0, TensorShape({}), &output));
+    output->scalar<ResourceHandle>()() = handle;
+  }
+
+ private:
+  Status CreateCache(OpKernelContext* ctx, EmbeddingCache<T>** cache) {
+    const int64 num_slots = options_.num_sets * options_.ways;
+    Tensor keys;
+    Tensor values;
+    TF_RETURN_IF_ERROR(
+        ctx->allocate_temp(DT_INT64, TensorShape({num_slots}), &keys));
+    TF_RETURN_IF_ERROR(ctx->allocate_temp(
+        DataTypeToEnum<T>::value, TensorShape({num_slots, options_.dim}),
+        &values));
+    TF_RETURN_IF_ERROR(ClearKeys(ctx, &keys));
+    *cache =
+        new EmbeddingCache<T>(options_, std::move(keys), std::move(values));
+    return Status::OK();
+  }
+
+  string container_;
+  string name_;
+  typename EmbeddingCache<T>::Options options_;
+};
+
+// Gathers the rows of `ids`. The rows of misses are fetched from the full
+// table, admitted with `default_value` if new, and cached in the least
+// recently used slots of their sets, whose rows are written back.
+template <typename T, typename Index>
+class EmbeddingCacheLookupOp : public OpKernel {
+ public:
+  explicit EmbeddingCacheLookupOp(OpKernelConstruction* c) : OpKernel(c) {}
+
+  void Compute(OpKernelContext* ctx) override {
+    core::RefCountPtr<EmbeddingCache<T>> cache;
+    OP_REQUIRES_OK(ctx, LookupResource(ctx, HandleFromInput(ctx, 0), &cache));
+    const Tensor& ids = ctx->input(1);
+    const Tensor& default_value = ctx->input(2);
+    const int64 dim = cache->options().dim;
+    OP_REQUIRES(ctx,
+                TensorShapeUtils::IsVector(default_value.shape()) &&
+                    default_value.NumElements() == dim,
+                errors::InvalidArgument("default_value must be of shape [",
+                                        dim, "], got ",
+                                        default_value.shape().DebugString()));
+
+    TensorShape output_shape = ids.shape();
+    output_shape.AddDim(dim);
+    Tensor* output;
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(0, output_shape, &output));
+    const int64 n = ids.NumElements();
+    if (n == 0) {
+      return;
+    }
+    const GPUDevice& d = ctx->eigen_device<GPUDevice>();
+    T* out = output->flat<T>().data();
+
+    mutex_lock l(*cache->mu());
+    Tensor slots;
+    Tensor slots_host;
+    OP_REQUIRES_OK(
+        ctx, FindSlots<T, Index>(ctx, cache.get(), ids, &slots, &slots_host));
+    T* values = cache->values()->template flat<T>().data();
+    functor::EmbeddingCacheCopyRows<GPUDevice, T>()(
+        d, values, slots.flat<int32>().data(), nullptr, n, dim, out);
+
+    // Each distinct missing id is fetched once, into row k of `fetched_ids`.
+    const auto ids_flat = ids.flat<Index>();
+    const int32* slots_data = slots_host.flat<int32>().data();
+    EmbeddingCacheDirectory* directory = cache->directory();
+    directory->StartBatch();
+    absl::flat_hash_map<int64, int32> fetched;
+    std::vector<int64> fetched_ids;
+    // Position i of the output reads row fetched_rows[i] of the fetched rows.
+    std::vector<int32> miss_positions;
+    std::vector<int32> fetched_rows;
+    for (int64 i = 0; i < n; ++i) {
+      if (slots_data[i] >= 0) {
+        directory->Touch(slots_data[i]);
+        continue;
+      }
+      const int64 id = ids_flat(i);
+      auto it = fetched.emplace(id, fetched_ids.size());
+      if (it.second) {
+        fetched_ids.push_back(id);
+      }
+      miss_positions.push_back(i);
+      fetched_rows.push_back(it.first->second);
+    }
+    metrics::RecordEmbeddingCacheLookups(n - miss_positions.size(),
+                                         miss_positions.size());
+    if (fetched_ids.empty()) {
+      return;
+    }
+
+    const int64 num_fetched = fetched_ids.size();
+    Tensor fetched_host;
+    OP_REQUIRES_OK(ctx, AllocateHostTemp(ctx, DataTypeToEnum<T>::value,
+                                         TensorShape({num_fetched, dim}),
+                                         &fetched_host));
+    T* fetched_data = fetched_host.flat<T>().data();
+    {
+      const T* default_row = default_value.flat<T>().data();
+      EmbeddingVariable<T>* table = cache->table();
+      mutex_lock table_lock(*table->mu());
+      for (int64 k = 0; k < num_fetched; ++k) {
+        // The full table admits every id on its first lookup.
+        std::copy_n(table->LookupOrAdmit(fetched_ids[k], default_row), dim,
+                    fetched_data + k * dim);
+      }
+    }
+
+    // Fetched row k moves into slot admitted_slots[k]; the rows of the
+    // evicted ids leave the slots first.
+    std::vector<int32> admitted_slots(num_fetched, -1);
+    std::vector<int64> admitted_ids(num_fetched, kEmbeddingCacheEmptyKey);
+    std::vector<int32> evicted_slots;
+    typename EmbeddingCache<T>::Writeback writeback;
+    for (int64 k = 0; k < num_fetched; ++k) {
+      int64 evicted;
+      const int64 slot = directory->Admit(fetched_ids[k], &evicted);
+      if (slot < 0) {
+        continue;
+      }
+      admitted_slots[k] = slot;
+      admitted_ids[k] = fetched_ids[k];
+      if (evicted != kEmbeddingCacheEmptyKey) {
+        evicted_slots.push_back(slot);
+        writeback.ids.push_back(evicted);
+      }
+    }
+
+    Tensor fetched_device;
+    OP_REQUIRES_OK(ctx, CopyToDevice(ctx, fetched_host, &fetched_device));
+    const T* fetched_device_data = fetched_device.flat<T>().data();
+    if (!evicted_slots.empty()) {
+      const int64 num_evicted = evicted_slots.size();
+      Tensor evicted_slots_host;
+      Tensor evicted_slots_device;
+      OP_REQUIRES_OK(ctx,
+                     MakeHostIndices(ctx, evicted_slots, &evicted_slots_host));
+      OP_REQUIRES_OK(ctx, CopyToDevice(ctx, evicted_slots_host,
+                                       &evicted_slots_device));
+      Tensor evicted_rows;
+      OP_REQUIRES_OK(ctx, ctx->allocate_temp(DataTypeToEnum<T>::value,
+                                             TensorShape({num_evicted, dim}),
+                                             &evicted_rows));
+      functor::EmbeddingCacheCopyRows<GPUDevice, T>()(
+          d, values, evicted_slots_device.flat<int32>().data(), nullptr,
+          num_evicted, dim, evicted_rows.flat<T>().data());
+      OP_REQUIRES_OK(ctx, AllocateHostTemp(ctx, DataTypeToEnum<T>::value,
+                                           TensorShape({num_evicted, dim}),
+                                           &writeback.rows));
+      OP_REQUIRES_OK(ctx, CopyToHost(ctx, evicted_rows, &writeback.rows));
+      cache->AddWriteback(std::move(writeback));
+    }
+
+    Tensor admitted_slots_host;
+    Tensor admitted_slots_device;
+    OP_REQUIRES_OK(ctx,
+                   MakeHostIndices(ctx, admitted_slots, &admitted_slots_host));
+    OP_REQUIRES_OK(ctx, CopyToDevice(ctx, admitted_slots_host,
+                                     &admitted_slots_device));
+    const int32* admitted_slots_data =
+        admitted_slots_device.flat<int32>().data();
+    Tensor admitted_ids_host;
+    Tensor admitted_ids_device;
+    OP_REQUIRES_OK(ctx, AllocateHostTemp(ctx, DT_INT64,
+                                         TensorShape({num_fetched}),
+                                         &admitted_ids_host));
+    std::copy(admitted_ids.begin(), admitted_ids.end(),
+              admitted_ids_host.flat<int64>().data());
+    OP_REQUIRES_OK(ctx,
+                   CopyToDevice(ctx, admitted_ids_host, &admitted_ids_device));
+    functor::EmbeddingCacheCopyRows<GPUDevice, T>()(
+        d, fetched_device_data, nullptr, admitted_slots_data, num_fetched, dim,
+        values);
+    functor::EmbeddingCacheCopyRows<GPUDevice, int64>()(
+        d, admitted_ids_device.flat<int64>().data(), nullptr,
+        admitted_slots_data, num_fetched, 1,
+        cache->keys()->template flat<int64>().data());
+
+    Tensor miss_positions_host;
+    Tensor miss_positions_device;
+    Tensor fetched_rows_host;
+    Tensor fetched_rows_device;
+    OP_REQUIRES_OK(ctx,
+                   MakeHostIndices(ctx, miss_positions, &miss_positions_host));
+    OP_REQUIRES_OK(ctx, CopyToDevice(ctx, miss_positions_host,
+                                     &miss_positions_device));
+    OP_REQUIRES_OK(ctx, MakeHostIndices(ctx, fetched_rows, &fetched_rows_host));
+    OP_REQUIRES_OK(ctx,
+                   CopyToDevice(ctx, fetched_rows_host, &fetched_rows_device));
+    functor::EmbeddingCacheCopyRows<GPUDevice, T>()(
+        d, fetched_device_data, fetched_rows_device.flat<int32>().data(),
+        miss_positions_device.flat<int32>().data(), miss_positions.size(), dim,
+        out);
+  }
+};
+
+// Adds `updates` to the rows of `ids`. Rows that are not cached are updated
+// in the full table and stay uncached; updates of ids without a row are
+// dropped.
+template <typename T, typename Index>
+class EmbeddingCacheScatterAddOp : public OpKernel {
+ public:
+  explicit EmbeddingCacheScatterAddOp(OpKernelConstruction* c)
+      : OpKernel(c) {}
+
+  void Compute(OpKernelContext* ctx) override {
+    core::RefCountPtr<EmbeddingCache<T>> cache;
+    OP_REQUIRES_OK(ctx, LookupResource(ctx, HandleFromInput(ctx, 0), &cache));
+    const Tensor& ids = ctx->input(1);
+    const Tensor& updates = ctx->input(2);
+    const int64 dim = cache->options().dim;
+    OP_REQUIRES(ctx, TensorShapeUtils::IsVector(ids.shape()),
+                errors::InvalidArgument("ids must be a vector, got shape ",
+                                        ids.shape().DebugString()));
+    const int64 n = ids.NumElements();
+    OP_REQUIRES(ctx, updates.shape() == TensorShape({n, dim}),
+                errors::InvalidArgument("updates must be of shape [", n, ", ",
+                                        dim, "], got ",
+                                        updates.shape().DebugString()));
+    if (n == 0) {
+      return;
+    }
+    const GPUDevice& d = ctx->eigen_device<GPUDevice>();
+
+    mutex_lock l(*cache->mu());
+    Tensor slots;
+    Tensor slots_host;
+    OP_REQUIRES_OK(
+        ctx, FindSlots<T, Index>(ctx, cache.get(), ids, &slots, &slots_host));
+    const T* updates_data = updates.flat<T>().data();
+    functor::EmbeddingCacheAddRows<GPUDevice, T>()(
+        d, updates_data, slots.flat<int32>().data(), n, dim,
+        cache->values()->template flat<T>().data());
+
+    const int32* slots_data = slots_host.flat<int32>().data();
+    std::vector<int32> miss_positions;
+    for (int64 i = 0; i < n; ++i) {
+      if (slots_data[i] < 0) {
+        miss_positions.push_back(i);
+      }
+    }
+    if (miss_positions.empty()) {
+      return;
+    }
+    const int64 num_misses = miss_positions.size();
+    Tensor miss_positions_host;
+    Tensor miss_positions_device;
+    OP_REQUIRES_OK(ctx,
+                   MakeHostIndices(ctx, miss_positions, &miss_positions_host));
+    OP_REQUIRES_OK(ctx, CopyToDevice(ctx, miss_positions_host,
+                                     &miss_positions_device));
+    Tensor miss_updates;
+    OP_REQUIRES_OK(ctx, ctx->allocate_temp(DataTypeToEnum<T>::value,
+                                           TensorShape({num_misses, dim}),
+                                           &miss_updates));
+    functor::EmbeddingCacheCopyRows<GPUDevice, T>()(
+        d, updates_data, miss_positions_device.flat<int32>().data(), nullptr,
+        num_misses, dim, miss_updates.flat<T>().data());
+    Tensor miss_updates_host;
+    OP_REQUIRES_OK(ctx, AllocateHostTemp(ctx, DataTypeToEnum<T>::value,
+                                         TensorShape({num_misses, dim}),
+                                         &miss_updates_host));
+    OP_REQUIRES_OK(ctx, CopyToHost(ctx, miss_updates, &miss_updates_host));
+    OP_REQUIRES_OK(ctx, Synchronize(ctx));
+
+    const auto ids_flat = ids.flat<Index>();
+    const T* miss_updates_data = miss_updates_host.flat<T>().data();
+    EmbeddingVariable<T>* table = cache->table();
+    mutex_lock table_lock(*table->mu());
+    for (int64 k = 0; k < num_misses; ++k) {
+      T* row = table->Find(ids_flat(miss_positions[k]));
+      if (row != nullptr) {
+        const T* update = miss_updates_data + k * dim;
+        for (int64 j = 0; j < dim; ++j) {
+          row[j] += update[j];
+        }
+      }
+    }
+  }
+};
+
+// Outputs the ids and values of all rows, cached or not.
+template <typename T>
+class EmbeddingCacheExportOp : public OpKernel {
+ public:
+  explicit EmbeddingCacheExportOp(OpKernelConstruction* c) : OpKernel(c) {}
+
+  void Compute(OpKernelContext* ctx) override {
+    core::RefCountPtr<EmbeddingCache<T>> cache;
+    OP_REQUIRES_OK(ctx, LookupResource(ctx, HandleFromInput(ctx, 0), &cache));
+    const int64 dim = cache->options().dim;
+
+    mutex_lock l(*cache->mu());
+    const Tensor& values = *cache->values();
+    Tensor values_host;
+    OP_REQUIRES_OK(ctx, AllocateHostTemp(ctx, DataTypeToEnum<T>::value,
+                                         values.shape(), &values_host));
+    OP_REQUIRES_OK(ctx, CopyToHost(ctx, values, &values_host));
+    OP_REQUIRES_OK(ctx, Synchronize(ctx));
+    cache->ApplyWritebacks();
+
+    // The cached rows are newer than their rows in the full table.
+    const EmbeddingCacheDirectory& directory = *cache->directory();
+    absl::flat_hash_map<int64, int64> cached_slots;
+    for (int64 slot = 0; slot < directory.num_slots(); ++slot) {
+      if (directory.key(slot) != kEmbeddingCacheEmptyKey) {
+        cached_slots[directory.key(slot)] = slot;
+      }
+    }
+    const T* cached_rows = values_host.flat<T>().data();
+
+    const EmbeddingVariable<T>& table = *cache->table();
+    tf_shared_lock table_lock(*table.mu());
+    const int64 num_rows = table.num_rows();
+    Tensor* ids;
+    Tensor* rows;
+    OP_REQUIRES_OK(ctx,
+                   ctx->allocate_output(0, TensorShape({num_rows}), &ids));
+    OP_REQUIRES_OK(
+        ctx, ctx->allocate_output(1, TensorShape({num_rows, dim}), &rows));
+    auto ids_flat = ids->flat<int64>();
+    T* rows_data = rows->flat<T>().data();
+    int64 i = 0;
+    table.ForEachRow([&](int64 id, int64 frequency, const T* row) {
+      auto it = cached_slots.find(id);
+      if (it != cached_slots.end()) {
+        row = cached_rows + it->second * dim;
+      }
+      ids_flat(i) = id;
+      std::copy_n(row, dim, rows_data + i * dim);
+      ++i;
+    });
+  }
+};
+
+// Replaces the rows with the exported rows and empties the cache.
+template <typename T>
+class EmbeddingCacheImportOp : public OpKernel {
+ public:
+  explicit EmbeddingCacheImportOp(OpKernelConstruction* c) : OpKernel(c) {}
+
+  void Compute(OpKernelContext* ctx) override {
+    core::RefCountPtr<EmbeddingCache<T>> cache;
+    OP_REQUIRES_OK(ctx, LookupResource(ctx, HandleFromInput(ctx, 0), &cache));
+    const Tensor& ids = ctx->input(1);
+    const Tensor& values = ctx->input(2);
+    const int64 dim = cache->options().dim;
+    OP_REQUIRES(ctx, TensorShapeUtils::IsVector(ids.shape()),
+                errors::InvalidArgument("ids must be a vector, got shape ",
+                                        ids.shape().DebugString()));
+    const int64 num_rows = ids.NumElements();
+    OP_REQUIRES(ctx, values.shape() == TensorShape({num_rows, dim}),
+                errors::InvalidArgument("values must be of shape [", num_rows,
+                                        ", ", dim, "], got ",
+                                        values.shape().DebugString()));
+
+    mutex_lock l(*cache->mu());
+    // Pending writebacks still copy into their buffers.
+    OP_REQUIRES_OK(ctx, Synchronize(ctx));
+    cache->ClearWritebacks();
+    cache->directory()->Clear();
+    OP_REQUIRES_OK(ctx, ClearKeys(ctx, cache->keys()));
+
+    const auto ids_flat = ids.flat<int64>();
+    const T* values_data = values.flat<T>().data();
+    EmbeddingVariable<T>* table = cache->table();
+    mutex_lock table_lock(*table->mu());
+    table->Clear();
+    for (int64 i = 0; i < num_rows; ++i) {
+      OP_REQUIRES(ctx, table->Find(ids_flat(i)) == nullptr,
+                  errors::InvalidArgument("Duplicate id ", ids_flat(i)));
+      std::copy_n(values_data + i * dim, dim, table->Insert(ids_flat(i), 1));
+    }
+  }
+};
+
+#define REGISTER_KERNELS_WITH_INDEX(T, Index)                     \
+  REGISTER_KERNEL_BUILDER(Name("EmbeddingCacheLookup")            \
+                              .Device(DEVICE_GPU)                 \
+                              .HostMemory("resource")             \
+                              .HostMemory("ids")                  \
+                              .HostMemory("default_value")        \
+                              .TypeConstraint<T>("dtype")         \
+                              .TypeConstraint<Index>("Tindices"), \
+                          EmbeddingCacheLookupOp<T, Index>);      \
+  REGISTER_KERNEL_BUILDER(Name("EmbeddingCacheScatterAdd")        \
+                              .Device(DEVICE_GPU)                 \
+                              .HostMemory("resource")             \
+                              .HostMemory("ids")                  \
+                              .TypeConstraint<T>("dtype")         \
+                              .TypeConstraint<Index>("Tindices"), \
+                          EmbeddingCacheScatterAddOp<T, Index>);
+
+#define REGISTER_KERNELS(T)                                       \
+  REGISTER_KERNEL_BUILDER(Name("EmbeddingCache")                  \
+                              .Device(DEVICE_GPU)                 \
+                              .HostMemory("resource")             \
+                              .TypeConstraint<T>("dtype"),        \
+                          EmbeddingCacheOp<T>);                   \
+  REGISTER_KERNEL_BUILDER(Name("EmbeddingCacheExport")            \
+                              .Device(DEVICE_GPU)                 \
+                              .HostMemory("resource")             \
+                              .HostMemory("ids")                  \
+                              .HostMemory("values")               \
+                              .TypeConstraint<T>("dtype"),        \
+                          EmbeddingCacheExportOp<T>);             \
+  REGISTER_KERNEL_BUILDER(Name("EmbeddingCacheImport")            \
+                              .Device(DEVICE_GPU)                 \
+                              .HostMemory("resource")             \
+                              .HostMemory("ids")                  \
+                              .HostMemory("values")               \
+                              .TypeConstraint<T>("dtype"),        \
+                          EmbeddingCacheImportOp<T>);             \
+  REGISTER_KERNELS_WITH_INDEX(T, int32);                          \
+  REGISTER_KERNELS_WITH_INDEX(T, int64);
+
+TF_CALL_float(REGISTER_KERNELS);
+TF_CALL_double(REGISTER_KERNELS);
+
+#undef REGISTER_KERNELS
+#undef REGISTER_KERNELS_WITH_INDEX
+
+}  // namespace tensorflow
+
+#endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
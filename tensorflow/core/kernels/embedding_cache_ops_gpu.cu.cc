@@ -0,0 +1,143 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+
+#define EIGEN_USE_GPU
+
+#include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/kernels/embedding_cache.h"
+#include "tensorflow/core/util/gpu_kernel_helper.h"
+
+namespace tensorflow {
+
+typedef Eigen::GpuDevice GPUDevice;
+
+namespace {
+
+template <typename Index>
+__global__ void EmbeddingCacheProbeKernel(const Index* __restrict__ ids,
+                                          int64 num_ids,
+                                          const int64* __restrict__ keys,
+                                          int64 num_sets, int64 ways,
+                                          int32* __restrict__ slots) {
+  GPU_1D_KERNEL_LOOP(i, num_ids) {
+    const int64 id = static_cast<int64>(ldg(ids + i));
+    int32 slot = -1;
+    if (id != kEmbeddingCacheEmptyKey) {
+      const int64 first = EmbeddingCacheSet(id, num_sets) * ways;
+      for (int64 way = 0; way < ways; ++way) {
+        if (ldg(keys + first + way) == id) {
+          slot = static_cast<int32>(first + way);
+          break;
+        }
+      }
+    }
+    slots[i] = slot;
+  }
+}
+
+template <typename T>
+__global__ void EmbeddingCacheCopyRowsKernel(
+    const T* __restrict__ src, const int32* __restrict__ src_rows,
+    const int32* __restrict__ dst_rows, int64 num_rows, int64 dim,
+    T* __restrict__ dst) {
+  GPU_1D_KERNEL_LOOP(i, num_rows * dim) {
+    const int64 row = i / dim;
+    const int64 col = i % dim;
+    const int64 src_row = src_rows == nullptr ? row : ldg(src_rows + row);
+    const int64 dst_row = dst_rows == nullptr ? row : ldg(dst_rows + row);
+    if (src_row >= 0 && dst_row >= 0) {
+      dst[dst_row * dim + col] = ldg(src + src_row * dim + col);
+    }
+  }
+}
+
+template <typename T>
+__global__ void EmbeddingCacheAddRowsKernel(const T* __restrict__ updates,
+                                            const int32* __restrict__ slots,
+                                            int64 num_rows, int64 dim,
+                                            T* __restrict__ values) {
+  GPU_1D_KERNEL_LOOP(i, num_rows * dim) {
+    const int64 slot = ldg(slots + i / dim);
+    if (slot >= 0) {
+      GpuAtomicAdd(values + slot * dim + i % dim, ldg(updates + i));
+    }
+  }
+}
+
+}  // namespace
+
+namespace functor {
+
+template <typename Index>
+struct EmbeddingCacheProbe<GPUDevice, Index> {
+  void operator()(const GPUDevice& d, const Index* ids, int64 num_ids,
+                  const int64* keys, int64 num_sets, int64 ways,
+                  int32* slots) {
+    if (num_ids == 0) return;
+    GpuLaunchConfig config = GetGpuLaunchConfig(num_ids, d);
+    TF_CHECK_OK(GpuLaunchKernel(EmbeddingCacheProbeKernel<Index>,
+                                config.block_count, config.thread_per_block,
+                                0, d.stream(), ids, num_ids, keys, num_sets,
+                                ways, slots));
+  }
+};
+
+template <typename T>
+struct EmbeddingCacheCopyRows<GPUDevice, T> {
+  void operator()(const GPUDevice& d, const T* src, const int32* src_rows,
+                  const int32* dst_rows, int64 num_rows, int64 dim, T* dst) {
+    if (num_rows == 0) return;
+    GpuLaunchConfig config = GetGpuLaunchConfig(num_rows * dim, d);
+    TF_CHECK_OK(GpuLaunchKernel(EmbeddingCacheCopyRowsKernel<T>,
+                                config.block_count, config.thread_per_block,
+                                0, d.stream(), src, src_rows, dst_rows,
+                                num_rows, dim, dst));
+  }
+};
+
+template <typename T>
+struct EmbeddingCacheAddRows<GPUDevice, T> {
+  void operator()(const GPUDevice& d, const T* updates, const int32* slots,
+                  int64 num_rows, int64 dim, T* values) {
+    if (num_rows == 0) return;
+    GpuLaunchConfig config = GetGpuLaunchConfig(num_rows * dim, d);
+    TF_CHECK_OK(GpuLaunchKernel(EmbeddingCacheAddRowsKernel<T>,
+                                config.block_count, config.thread_per_block,
+                                0, d.stream(), updates, slots, num_rows, dim,
+                                values));
+  }
+};
+
+}  // namespace functor
+
+template struct functor::EmbeddingCacheProbe<GPUDevice, int32>;
+template struct functor::EmbeddingCacheProbe<GPUDevice, int64>;
+
+#define DEFINE_GPU_SPECS(T)                                      \
+  template struct functor::EmbeddingCacheCopyRows<GPUDevice, T>; \
+  template struct functor::EmbeddingCacheAddRows<GPUDevice, T>;
+
+TF_CALL_float(DEFINE_GPU_SPECS);
+TF_CALL_double(DEFINE_GPU_SPECS);
+#undef DEFINE_GPU_SPECS
+
+// The keys of the slots are copied as rows of one element.
+template struct functor::EmbeddingCacheCopyRows<GPUDevice, int64>;
+
+}  // namespace tensorflow
+
+#endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
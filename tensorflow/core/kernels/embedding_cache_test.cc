@@ -0,0 +1,104 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/embedding_cache.h"
+
+#include <vector>
+
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+// Returns `count` ids that map to the same set as `id`, starting with `id`.
+std::vector<int64> IdsOfSet(int64 id, int64 num_sets, int count) {
+  std::vector<int64> ids;
+  const int64 set = EmbeddingCacheSet(id, num_sets);
+  for (int64 candidate = id; ids.size() < count; ++candidate) {
+    if (EmbeddingCacheSet(candidate, num_sets) == set) {
+      ids.push_back(candidate);
+    }
+  }
+  return ids;
+}
+
+TEST(EmbeddingCacheDirectoryTest, AdmitsIntoTheSetOfTheId) {
+  EmbeddingCacheDirectory directory(16, 4);
+  EXPECT_EQ(64, directory.num_slots());
+  directory.StartBatch();
+  for (int64 id = 0; id < 8; ++id) {
+    int64 evicted;
+    const int64 slot = directory.Admit(id, &evicted);
+    ASSERT_GE(slot, 0);
+    EXPECT_EQ(EmbeddingCacheSet(id, 16), slot / 4);
+    EXPECT_EQ(id, directory.key(slot));
+    EXPECT_EQ(kEmbeddingCacheEmptyKey, evicted);
+  }
+}
+
+TEST(EmbeddingCacheDirectoryTest, EvictsLeastRecentlyUsedWay) {
+  EmbeddingCacheDirectory directory(8, 2);
+  const std::vector<int64> ids = IdsOfSet(5, 8, 3);
+  int64 evicted;
+  directory.StartBatch();
+  const int64 first = directory.Admit(ids[0], &evicted);
+  directory.StartBatch();
+  const int64 second = directory.Admit(ids[1], &evicted);
+  ASSERT_NE(first, second);
+
+  // Touching the first id makes the second the least recently used.
+  directory.StartBatch();
+  directory.Touch(first);
+  directory.StartBatch();
+  EXPECT_EQ(second, directory.Admit(ids[2], &evicted));
+  EXPECT_EQ(ids[1], evicted);
+  EXPECT_EQ(ids[0], directory.key(first));
+}
+
+TEST(EmbeddingCacheDirectoryTest, DoesNotEvictSlotsOfTheCurrentBatch) {
+  EmbeddingCacheDirectory directory(4, 2);
+  const std::vector<int64> ids = IdsOfSet(3, 4, 3);
+  int64 evicted;
+  directory.StartBatch();
+  EXPECT_GE(directory.Admit(ids[0], &evicted), 0);
+  EXPECT_GE(directory.Admit(ids[1], &evicted), 0);
+  EXPECT_EQ(-1, directory.Admit(ids[2], &evicted));
+  EXPECT_EQ(kEmbeddingCacheEmptyKey, evicted);
+
+  directory.StartBatch();
+  EXPECT_GE(directory.Admit(ids[2], &evicted), 0);
+  EXPECT_EQ(ids[0], evicted);
+}
+
+TEST(EmbeddingCacheDirectoryTest, NeverCachesTheEmptyKey) {
+  EmbeddingCacheDirectory directory(4, 2);
+  int64 evicted;
+  directory.StartBatch();
+  EXPECT_EQ(-1, directory.Admit(kEmbeddingCacheEmptyKey, &evicted));
+}
+
+TEST(EmbeddingCacheDirectoryTest, Clear) {
+  EmbeddingCacheDirectory directory(4, 2);
+  int64 evicted;
+  directory.StartBatch();
+  const int64 slot = directory.Admit(7, &evicted);
+  directory.Clear();
+  EXPECT_EQ(kEmbeddingCacheEmptyKey, directory.key(slot));
+  EXPECT_GE(directory.Admit(7, &evicted), 0);
+  EXPECT_EQ(kEmbeddingCacheEmptyKey, evicted);
+}
+
+}  // namespace
+}  // namespace tensorflow
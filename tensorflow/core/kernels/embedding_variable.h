@@ -0,0 +1,209 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_KERNELS_EMBEDDING_VARIABLE_H_
+#define TENSORFLOW_CORE_KERNELS_EMBEDDING_VARIABLE_H_
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "tensorflow/core/framework/resource_mgr.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+
+namespace tensorflow {
+
+// Embedding rows of `dim` elements for an unbounded space of int64 ids.
+//
+// Rows are allocated from slabs the first time an id has been looked up
+// `min_frequency` times; until then lookups of the id read a default value.
+// When `max_rows` is positive and the variable is full, admitting a row first
+// evicts the least recently (or least frequently) used eighth of the rows.
+//
+// Every row is followed by `num_slots` slot vectors of `dim` elements, which
+// hold the optimizer state of the row and are zero when the row is admitted.
+template <typename T>
+class EmbeddingVariable : public ResourceBase {
+ public:
+  enum class EvictionPolicy { kLru, kLfu };
+
+  struct Options {
+    int64 dim = 1;
+    int64 num_slots = 0;
+    int64 min_frequency = 0;
+    int64 max_rows = 0;
+    EvictionPolicy eviction_policy = EvictionPolicy::kLru;
+  };
+
+  explicit EmbeddingVariable(const Options& options)
+      : options_(options), row_size_(options.dim * (1 + options.num_slots)) {}
+
+  std::string DebugString() const override {
+    tf_shared_lock l(mu_);
+    return strings::StrCat("EmbeddingVariable(", DataTypeString(dtype()),
+                           ", dim=", options_.dim, ", rows=", num_rows_, ")");
+  }
+
+  int64 MemoryUsed() const override {
+    tf_shared_lock l(mu_);
+    return sizeof(EmbeddingVariable) +
+           slabs_.size() * kRowsPerSlab * row_size_ * sizeof(T) +
+           entries_.capacity() * (sizeof(int64) + sizeof(Entry));
+  }
+
+  DataType dtype() const { return DataTypeToEnum<T>::value; }
+  const Options& options() const { return options_; }
+  mutex* mu() const TF_LOCK_RETURNED(mu_) { return &mu_; }
+
+  int64 num_rows() const TF_SHARED_LOCKS_REQUIRED(mu_) { return num_rows_; }
+
+  // Counts an access of `id` and returns its row, admitting the row with the
+  // value `default_value` once `id` is frequent enough. Returns nullptr while
+  // `id` is not admitted. The row stays valid until it is evicted.
+  T* LookupOrAdmit(int64 id, const T* default_value)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    Entry& entry = entries_[id];
+    ++entry.frequency;
+    entry.last_access = ++clock_;
+    if (entry.row >= 0) {
+      return Row(entry.row);
+    }
+    if (entry.frequency < options_.min_frequency) {
+      return nullptr;
+    }
+    if (options_.max_rows > 0 && num_rows_ >= options_.max_rows) {
+      Evict(id);
+    }
+    entries_[id].row = AllocateRow();
+    T* row = Row(entries_[id].row);
+    std::copy_n(default_value, options_.dim, row);
+    std::fill_n(row + options_.dim, row_size_ - options_.dim, T(0));
+    return row;
+  }
+
+  // Returns the row of `id`, or nullptr if `id` has no row.
+  T* Find(int64 id) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    auto it = entries_.find(id);
+    return it == entries_.end() || it->second.row < 0 ? nullptr
+                                                       : Row(it->second.row);
+  }
+
+  // Calls fn(id, frequency, row) for every row.
+  template <typename Fn>
+  void ForEachRow(Fn fn) const TF_SHARED_LOCKS_REQUIRED(mu_) {
+    for (const auto& it : entries_) {
+      if (it.second.row >= 0) {
+        fn(it.first, it.second.frequency,
+           static_cast<const T*>(Row(it.second.row)));
+      }
+    }
+  }
+
+  // Removes all ids and rows.
+  void Clear() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    entries_.clear();
+    slabs_.clear();
+    free_rows_.clear();
+    num_rows_ = 0;
+    next_row_ = 0;
+    clock_ = 0;
+  }
+
+  // Returns a new row of `id` with the access count `frequency`, which must
+  // not have a row already. Does not evict.
+  T* Insert(int64 id, int64 frequency) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    Entry& entry = entries_[id];
+    entry.frequency = frequency;
+    entry.last_access = ++clock_;
+    entry.row = AllocateRow();
+    return Row(entry.row);
+  }
+
+ private:
+  static constexpr int64 kRowsPerSlab = 1024;
+
+  struct Entry {
+    // Index of the row in the slabs, or -1 if the id is not admitted.
+    int64 row = -1;
+    int64 frequency = 0;
+    int64 last_access = 0;
+  };
+
+  T* Row(int64 row) const TF_SHARED_LOCKS_REQUIRED(mu_) {
+    return slabs_[row / kRowsPerSlab].get() + (row % kRowsPerSlab) * row_size_;
+  }
+
+  int64 AllocateRow() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    ++num_rows_;
+    if (!free_rows_.empty()) {
+      const int64 row = free_rows_.back();
+      free_rows_.pop_back();
+      return row;
+    }
+    const int64 row = next_row_++;
+    if (row % kRowsPerSlab == 0) {
+      slabs_.emplace_back(new T[kRowsPerSlab * row_size_]);
+    }
+    return row;
+  }
+
+  // Frees the rows of the least recently or frequently used eighth of the
+  // admitted ids, other than `keep`.
+  void Evict(int64 keep) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    const bool lfu = options_.eviction_policy == EvictionPolicy::kLfu;
+    std::vector<std::pair<std::pair<int64, int64>, int64>> candidates;
+    candidates.reserve(num_rows_);
+    for (const auto& it : entries_) {
+      if (it.second.row >= 0 && it.first != keep) {
+        candidates.push_back(
+            {{lfu ? it.second.frequency : it.second.last_access,
+              it.second.last_access},
+             it.first});
+      }
+    }
+    const int64 num_evicted = std::min<int64>(
+        candidates.size(), std::max<int64>(1, options_.max_rows / 8));
+    std::nth_element(candidates.begin(), candidates.begin() + num_evicted,
+                     candidates.end());
+    for (int64 i = 0; i < num_evicted; ++i) {
+      auto it = entries_.find(candidates[i].second);
+      free_rows_.push_back(it->second.row);
+      entries_.erase(it);
+    }
+    num_rows_ -= num_evicted;
+  }
+
+  const Options options_;
+  const int64 row_size_;
+
+  mutable mutex mu_;
+  absl::flat_hash_map<int64, Entry> entries_ TF_GUARDED_BY(mu_);
+  std::vector<std::unique_ptr<T[]>> slabs_ TF_GUARDED_BY(mu_);
+  std::vector<int64> free_rows_ TF_GUARDED_BY(mu_);
+  // Number of rows in use and number of rows ever taken from the slabs.
+  int64 num_rows_ TF_GUARDED_BY(mu_) = 0;
+  int64 next_row_ TF_GUARDED_BY(mu_) = 0;
+  int64 clock_ TF_GUARDED_BY(mu_) = 0;
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_EMBEDDING_VARIABLE_H_
@@ -0,0 +1,370 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// See docs in ../ops/resource_variable_ops.cc and ../ops/training_ops.cc.
+
+#include <algorithm>
+#include <cmath>
+
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/framework/resource_mgr.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/kernels/embedding_variable.h"
+#include "tensorflow/core/lib/core/errors.h"
+
+namespace tensorflow {
+
+template <typename T>
+class EmbeddingVariableOp : public OpKernel {
+ public:
+  explicit EmbeddingVariableOp(OpKernelConstruction* c) : OpKernel(c) {
+    OP_REQUIRES_OK(c, c->GetAttr("container", &container_));
+    OP_REQUIRES_OK(c, c->GetAttr("shared_name", &name_));
+    if (name_.empty()) {
+      name_ = name();
+    }
+    OP_REQUIRES_OK(c, c->GetAttr("dim", &options_.dim));
+    OP_REQUIRES_OK(c, c->GetAttr("num_slots", &options_.num_slots));
+    OP_REQUIRES_OK(c, c->GetAttr("min_frequency", &options_.min_frequency));
+    OP_REQUIRES_OK(c, c->GetAttr("max_rows", &options_.max_rows));
+    string eviction_policy;
+    OP_REQUIRES_OK(c, c->GetAttr("eviction_policy", &eviction_policy));
+    options_.eviction_policy =
+        eviction_policy == "lfu"
+            ? EmbeddingVariable<T>::EvictionPolicy::kLfu
+            : EmbeddingVariable<T>::EvictionPolicy::kLru;
+  }
+
+  void Compute(OpKernelContext* ctx) override {
+    const ResourceHandle handle =
+        MakeResourceHandle<EmbeddingVariable<T>>(ctx, container_, name_);
+    core::RefCountPtr<EmbeddingVariable<T>> variable;
+    OP_REQUIRES_OK(ctx, LookupOrCreateResource<EmbeddingVariable<T>>(
+                            ctx, handle, &variable,
+                            [this](EmbeddingVariable<T>** ptr) {
+                              *ptr = new EmbeddingVariable<T>(options_);
+                              return Status::OK();
+                            }));
+    OP_REQUIRES(
+        ctx,
+        variable->options().dim == options_.dim &&
+            variable->options().num_slots == options_.num_slots,
+        errors::InvalidArgument(
+            "EmbeddingVariable ", name_, " exists with dim ",
+            variable->options().dim, " and ", variable->options().num_slots,
+            " slots, requested dim ", options_.dim, " and ",
+            options_.num_slots, " slots"));
+
+    Tensor* output;
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(0, TensorShape({}), &output));
+    output->scalar<ResourceHandle>()() = handle;
+  }
+
+ private:
+  string container_;
+  string name_;
+  typename EmbeddingVariable<T>::Options options_;
+};
+
+// Gathers the rows of `ids`, admitting the rows of frequent enough ids.
+template <typename T, typename Index>
+class EmbeddingVariableLookupOp : public OpKernel {
+ public:
+  explicit EmbeddingVariableLookupOp(OpKernelConstruction* c) : OpKernel(c) {}
+
+  void Compute(OpKernelContext* ctx) override {
+    core::RefCountPtr<EmbeddingVariable<T>> variable;
+    OP_REQUIRES_OK(ctx,
+                   LookupResource(ctx, HandleFromInput(ctx, 0), &variable));
+    const Tensor& ids = ctx->input(1);
+    const Tensor& default_value = ctx->input(2);
+    const int64 dim = variable->options().dim;
+    OP_REQUIRES(ctx,
+                TensorShapeUtils::IsVector(default_value.shape()) &&
+                    default_value.NumElements() == dim,
+                errors::InvalidArgument("default_value must be of shape [",
+                                        dim, "], got ",
+                                        default_value.shape().DebugString()));
+
+    TensorShape output_shape = ids.shape();
+    output_shape.AddDim(dim);
+    Tensor* output;
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(0, output_shape, &output));
+
+    const auto ids_flat = ids.flat<Index>();
+    const T* default_row = default_value.flat<T>().data();
+    T* out = output->flat<T>().data();
+    mutex_lock l(*variable->mu());
+    for (int64 i = 0; i < ids_flat.size(); ++i) {
+      const T* row = variable->LookupOrAdmit(ids_flat(i), default_row);
+      std::copy_n(row == nullptr ? default_row : row, dim, out + i * dim);
+    }
+  }
+};
+
+// Outputs the ids, values, slots and access counts of all rows.
+template <typename T>
+class EmbeddingVariableExportOp : public OpKernel {
+ public:
+  explicit EmbeddingVariableExportOp(OpKernelConstruction* c) : OpKernel(c) {}
+
+  void Compute(OpKernelContext* ctx) override {
+    core::RefCountPtr<EmbeddingVariable<T>> variable;
+    OP_REQUIRES_OK(ctx,
+                   LookupResource(ctx, HandleFromInput(ctx, 0), &variable));
+    const int64 dim = variable->options().dim;
+    const int64 num_slots = variable->options().num_slots;
+
+    tf_shared_lock l(*variable->mu());
+    const int64 num_rows = variable->num_rows();
+    Tensor* ids;
+    Tensor* values;
+    Tensor* slots;
+    Tensor* frequencies;
+    OP_REQUIRES_OK(ctx,
+                   ctx->allocate_output(0, TensorShape({num_rows}), &ids));
+    OP_REQUIRES_OK(
+        ctx, ctx->allocate_output(1, TensorShape({num_rows, dim}), &values));
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(
+                            2, TensorShape({num_rows, num_slots, dim}),
+                            &slots));
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(3, TensorShape({num_rows}),
+                                             &frequencies));
+
+    auto ids_flat = ids->flat<int64>();
+    auto frequencies_flat = frequencies->flat<int64>();
+    T* values_data = values->flat<T>().data();
+    T* slots_data = slots->flat<T>().data();
+    int64 i = 0;
+    variable->ForEachRow([&](int64 id, int64 frequency, const T* row) {
+      ids_flat(i) = id;
+      frequencies_flat(i) = frequency;
+      std::copy_n(row, dim, values_data + i * dim);
+      std::copy_n(row + dim, num_slots * dim, slots_data + i * num_slots * dim);
+      ++i;
+    });
+  }
+};
+
+// Replaces the rows of the variable with the exported rows.
+template <typename T>
+class EmbeddingVariableImportOp : public OpKernel {
+ public:
+  explicit EmbeddingVariableImportOp(OpKernelConstruction* c) : OpKernel(c) {}
+
+  void Compute(OpKernelContext* ctx) override {
+    core::RefCountPtr<EmbeddingVariable<T>> variable;
+    OP_REQUIRES_OK(ctx,
+                   LookupResource(ctx, HandleFromInput(ctx, 0), &variable));
+    const Tensor& ids = ctx->input(1);
+    const Tensor& values = ctx->input(2);
+    const Tensor& slots = ctx->input(3);
+    const Tensor& frequencies = ctx->input(4);
+    const int64 dim = variable->options().dim;
+    const int64 num_slots = variable->options().num_slots;
+    OP_REQUIRES(ctx, TensorShapeUtils::IsVector(ids.shape()),
+                errors::InvalidArgument("ids must be a vector, got shape ",
+                                        ids.shape().DebugString()));
+    const int64 num_rows = ids.NumElements();
+    OP_REQUIRES(ctx, values.shape() == TensorShape({num_rows, dim}),
+                errors::InvalidArgument("values must be of shape [", num_rows,
+                                        ", ", dim, "], got ",
+                                        values.shape().DebugString()));
+    OP_REQUIRES(
+        ctx, slots.shape() == TensorShape({num_rows, num_slots, dim}),
+        errors::InvalidArgument("slots must be of shape [", num_rows, ", ",
+                                num_slots, ", ", dim, "], got ",
+                                slots.shape().DebugString()));
+    OP_REQUIRES(ctx, frequencies.shape() == ids.shape(),
+                errors::InvalidArgument(
+                    "frequencies must be of shape [", num_rows, "], got ",
+                    frequencies.shape().DebugString()));
+
+    const auto ids_flat = ids.flat<int64>();
+    const auto frequencies_flat = frequencies.flat<int64>();
+    const T* values_data = values.flat<T>().data();
+    const T* slots_data = slots.flat<T>().data();
+    mutex_lock l(*variable->mu());
+    variable->Clear();
+    for (int64 i = 0; i < num_rows; ++i) {
+      OP_REQUIRES(ctx, variable->Find(ids_flat(i)) == nullptr,
+                  errors::InvalidArgument("Duplicate id ", ids_flat(i)));
+      T* row = variable->Insert(ids_flat(i), frequencies_flat(i));
+      std::copy_n(values_data + i * dim, dim, row);
+      std::copy_n(slots_data + i * num_slots * dim, num_slots * dim,
+                  row + dim);
+    }
+  }
+};
+
+// Base class of the optimizers that update the admitted rows of `indices`
+// in place. Gradients of ids without a row are dropped.
+template <typename T, typename Index>
+class EmbeddingVariableSparseApplyOp : public OpKernel {
+ public:
+  EmbeddingVariableSparseApplyOp(OpKernelConstruction* c, int num_slots,
+                                 int num_scalars)
+      : OpKernel(c), num_slots_(num_slots), num_scalars_(num_scalars) {}
+
+  void Compute(OpKernelContext* ctx) override {
+    core::RefCountPtr<EmbeddingVariable<T>> variable;
+    OP_REQUIRES_OK(ctx,
+                   LookupResource(ctx, HandleFromInput(ctx, 0), &variable));
+    const int64 dim = variable->options().dim;
+    OP_REQUIRES(ctx, variable->options().num_slots >= num_slots_,
+                errors::InvalidArgument(
+                    name(), " needs an EmbeddingVariable with at least ",
+                    num_slots_, " slots, got ",
+                    variable->options().num_slots));
+
+    T scalars[8];
+    for (int i = 0; i < num_scalars_; ++i) {
+      const Tensor& scalar = ctx->input(1 + i);
+      OP_REQUIRES(ctx, TensorShapeUtils::IsScalar(scalar.shape()),
+                  errors::InvalidArgument(
+                      "Input ", 1 + i, " must be a scalar, got shape ",
+                      scalar.shape().DebugString()));
+      scalars[i] = scalar.scalar<T>()();
+    }
+    const Tensor& grad = ctx->input(1 + num_scalars_);
+    const Tensor& indices = ctx->input(2 + num_scalars_);
+    OP_REQUIRES(ctx, TensorShapeUtils::IsVector(indices.shape()),
+                errors::InvalidArgument("indices must be a vector, got shape ",
+                                        indices.shape().DebugString()));
+    const int64 n = indices.NumElements();
+    OP_REQUIRES(ctx, grad.shape() == TensorShape({n, dim}),
+                errors::InvalidArgument("grad must be of shape [", n, ", ",
+                                        dim, "], got ",
+                                        grad.shape().DebugString()));
+
+    const auto indices_flat = indices.flat<Index>();
+    const T* grad_data = grad.flat<T>().data();
+    mutex_lock l(*variable->mu());
+    for (int64 i = 0; i < n; ++i) {
+      T* row = variable->Find(indices_flat(i));
+      if (row != nullptr) {
+        Update(scalars, grad_data + i * dim, dim, row);
+      }
+    }
+  }
+
+ protected:
+  // Updates the `dim` values of `row` with `grad`, where the slots of the row
+  // follow its values.
+  virtual void Update(const T* scalars, const T* grad, int64 dim,
+                      T* row) const = 0;
+
+ private:
+  const int num_slots_;
+  const int num_scalars_;
+};
+
+// accum += grad * grad
+// var -= lr * grad / (sqrt(accum) + epsilon)
+template <typename T, typename Index>
+class EmbeddingVariableSparseApplyAdagradOp
+    : public EmbeddingVariableSparseApplyOp<T, Index> {
+ public:
+  explicit EmbeddingVariableSparseApplyAdagradOp(OpKernelConstruction* c)
+      : EmbeddingVariableSparseApplyOp<T, Index>(c, /*num_slots=*/1,
+                                                 /*num_scalars=*/2) {}
+
+ protected:
+  void Update(const T* scalars, const T* grad, int64 dim,
+              T* row) const override {
+    const T lr = scalars[0];
+    const T epsilon = scalars[1];
+    T* accum = row + dim;
+    for (int64 j = 0; j < dim; ++j) {
+      accum[j] += grad[j] * grad[j];
+      row[j] -= lr * grad[j] / (std::sqrt(accum[j]) + epsilon);
+    }
+  }
+};
+
+// m += (grad - m) * (1 - beta1)
+// v += (grad * grad - v) * (1 - beta2)
+// var -= lr * sqrt(1 - beta2_power) / (1 - beta1_power) * m /
+//        (sqrt(v) + epsilon)
+template <typename T, typename Index>
+class EmbeddingVariableSparseApplyAdamOp
+    : public EmbeddingVariableSparseApplyOp<T, Index> {
+ public:
+  explicit EmbeddingVariableSparseApplyAdamOp(OpKernelConstruction* c)
+      : EmbeddingVariableSparseApplyOp<T, Index>(c, /*num_slots=*/2,
+                                                 /*num_scalars=*/6) {}
+
+ protected:
+  void Update(const T* scalars, const T* grad, int64 dim,
+              T* row) const override {
+    const T beta1_power = scalars[0];
+    const T beta2_power = scalars[1];
+    const T lr = scalars[2];
+    const T beta1 = scalars[3];
+    const T beta2 = scalars[4];
+    const T epsilon = scalars[5];
+    const T alpha = lr * std::sqrt(T(1) - beta2_power) / (T(1) - beta1_power);
+    T* m = row + dim;
+    T* v = row + 2 * dim;
+    for (int64 j = 0; j < dim; ++j) {
+      m[j] += (grad[j] - m[j]) * (T(1) - beta1);
+      v[j] += (grad[j] * grad[j] - v[j]) * (T(1) - beta2);
+      row[j] -= alpha * m[j] / (std::sqrt(v[j]) + epsilon);
+    }
+  }
+};
+
+#define REGISTER_KERNELS_WITH_INDEX(T, Index)                              \
+  REGISTER_KERNEL_BUILDER(Name("EmbeddingVariableLookup")                  \
+                              .Device(DEVICE_CPU)                          \
+                              .TypeConstraint<T>("dtype")                  \
+                              .TypeConstraint<Index>("Tindices"),          \
+                          EmbeddingVariableLookupOp<T, Index>);            \
+  REGISTER_KERNEL_BUILDER(Name("EmbeddingVariableSparseApplyAdagrad")      \
+                              .Device(DEVICE_CPU)                          \
+                              .TypeConstraint<T>("T")                      \
+                              .TypeConstraint<Index>("Tindices"),          \
+                          EmbeddingVariableSparseApplyAdagradOp<T, Index>); \
+  REGISTER_KERNEL_BUILDER(Name("EmbeddingVariableSparseApplyAdam")         \
+                              .Device(DEVICE_CPU)                          \
+                              .TypeConstraint<T>("T")                      \
+                              .TypeConstraint<Index>("Tindices"),          \
+                          EmbeddingVariableSparseApplyAdamOp<T, Index>);
+
+#define REGISTER_KERNELS(T)                                                 \
+  REGISTER_KERNEL_BUILDER(Name("EmbeddingVariable")                         \
+                              .Device(DEVICE_CPU)                           \
+                              .TypeConstraint<T>("dtype"),                  \
+                          EmbeddingVariableOp<T>);                          \
+  REGISTER_KERNEL_BUILDER(Name("EmbeddingVariableExport")                   \
+                              .Device(DEVICE_CPU)                           \
+                              .TypeConstraint<T>("dtype"),                  \
+                          EmbeddingVariableExportOp<T>);                    \
+  REGISTER_KERNEL_BUILDER(Name("EmbeddingVariableImport")                   \
+                              .Device(DEVICE_CPU)                           \
+                              .TypeConstraint<T>("dtype"),                  \
+                          EmbeddingVariableImportOp<T>);                    \
+  REGISTER_KERNELS_WITH_INDEX(T, int32);                                    \
+  REGISTER_KERNELS_WITH_INDEX(T, int64);
+
+TF_CALL_float(REGISTER_KERNELS);
+TF_CALL_double(REGISTER_KERNELS);
+
+#undef REGISTER_KERNELS
+#undef REGISTER_KERNELS_WITH_INDEX
+
+}  // namespace tensorflow
@@ -0,0 +1,151 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/embedding_variable.h"
+
+#include <map>
+
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+typedef EmbeddingVariable<float> Variable;
+
+Variable::Options MakeOptions(int64 min_frequency, int64 max_rows,
+                              Variable::EvictionPolicy policy) {
+  Variable::Options options;
+  options.dim = 2;
+  options.num_slots = 1;
+  options.min_frequency = min_frequency;
+  options.max_rows = max_rows;
+  options.eviction_policy = policy;
+  return options;
+}
+
+// Returns the ids of the rows of `variable`.
+std::map<int64, int64> Rows(const Variable& variable) {
+  std::map<int64, int64> rows;
+  tf_shared_lock l(*variable.mu());
+  variable.ForEachRow([&rows](int64 id, int64 frequency, const float* row) {
+    rows[id] = frequency;
+  });
+  return rows;
+}
+
+TEST(EmbeddingVariableTest, AdmitsAfterMinFrequency) {
+  core::RefCountPtr<Variable> variable(
+      new Variable(MakeOptions(3, 0, Variable::EvictionPolicy::kLru)));
+  const float default_value[] = {1, 2};
+  mutex_lock l(*variable->mu());
+  EXPECT_EQ(nullptr, variable->LookupOrAdmit(7, default_value));
+  EXPECT_EQ(nullptr, variable->LookupOrAdmit(7, default_value));
+  EXPECT_EQ(nullptr, variable->Find(7));
+
+  float* row = variable->LookupOrAdmit(7, default_value);
+  ASSERT_NE(nullptr, row);
+  EXPECT_EQ(1, row[0]);
+  EXPECT_EQ(2, row[1]);
+  // The slot starts at zero.
+  EXPECT_EQ(0, row[2]);
+  EXPECT_EQ(0, row[3]);
+  EXPECT_EQ(row, variable->Find(7));
+  EXPECT_EQ(1, variable->num_rows());
+}
+
+TEST(EmbeddingVariableTest, RowsSurviveSlabGrowth) {
+  core::RefCountPtr<Variable> variable(
+      new Variable(MakeOptions(0, 0, Variable::EvictionPolicy::kLru)));
+  mutex_lock l(*variable->mu());
+  for (int64 id = 0; id < 3000; ++id) {
+    const float value[] = {static_cast<float>(id), static_cast<float>(-id)};
+    variable->LookupOrAdmit(id, value);
+  }
+  EXPECT_EQ(3000, variable->num_rows());
+  for (int64 id = 0; id < 3000; ++id) {
+    const float* row = variable->Find(id);
+    ASSERT_NE(nullptr, row);
+    EXPECT_EQ(id, row[0]);
+    EXPECT_EQ(-id, row[1]);
+  }
+}
+
+TEST(EmbeddingVariableTest, EvictsLeastRecentlyUsed) {
+  core::RefCountPtr<Variable> variable(
+      new Variable(MakeOptions(0, 16, Variable::EvictionPolicy::kLru)));
+  const float default_value[] = {0, 0};
+  {
+    mutex_lock l(*variable->mu());
+    for (int64 id = 0; id < 16; ++id) {
+      variable->LookupOrAdmit(id, default_value);
+    }
+    // Ids 0 and 1 become the most recently used.
+    variable->LookupOrAdmit(0, default_value);
+    variable->LookupOrAdmit(1, default_value);
+    // Evicts an eighth of the rows, ids 2 and 3.
+    variable->LookupOrAdmit(100, default_value);
+    EXPECT_EQ(15, variable->num_rows());
+  }
+  std::map<int64, int64> rows = Rows(*variable);
+  EXPECT_EQ(1, rows.count(0));
+  EXPECT_EQ(1, rows.count(1));
+  EXPECT_EQ(0, rows.count(2));
+  EXPECT_EQ(0, rows.count(3));
+  EXPECT_EQ(1, rows.count(4));
+  EXPECT_EQ(1, rows.count(100));
+}
+
+TEST(EmbeddingVariableTest, EvictsLeastFrequentlyUsed) {
+  core::RefCountPtr<Variable> variable(
+      new Variable(MakeOptions(0, 8, Variable::EvictionPolicy::kLfu)));
+  const float default_value[] = {0, 0};
+  {
+    mutex_lock l(*variable->mu());
+    for (int64 id = 0; id < 8; ++id) {
+      for (int i = 0; i <= 8 - id; ++i) {
+        variable->LookupOrAdmit(id, default_value);
+      }
+    }
+    variable->LookupOrAdmit(100, default_value);
+  }
+  std::map<int64, int64> rows = Rows(*variable);
+  EXPECT_EQ(8, rows.size());
+  EXPECT_EQ(0, rows.count(7));
+  EXPECT_EQ(9, rows[0]);
+  EXPECT_EQ(1, rows[100]);
+}
+
+TEST(EmbeddingVariableTest, ClearAndInsert) {
+  core::RefCountPtr<Variable> variable(
+      new Variable(MakeOptions(0, 0, Variable::EvictionPolicy::kLru)));
+  const float default_value[] = {0, 0};
+  {
+    mutex_lock l(*variable->mu());
+    variable->LookupOrAdmit(1, default_value);
+    variable->Clear();
+    EXPECT_EQ(0, variable->num_rows());
+    EXPECT_EQ(nullptr, variable->Find(1));
+
+    float* row = variable->Insert(5, 42);
+    row[0] = 3;
+    EXPECT_EQ(3, variable->Find(5)[0]);
+  }
+  std::map<int64, int64> rows = Rows(*variable);
+  ASSERT_EQ(1, rows.size());
+  EXPECT_EQ(42, rows[5]);
+}
+
+}  // namespace
+}  // namespace tensorflow
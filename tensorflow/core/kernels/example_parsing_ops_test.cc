@@ -28,6 +28,8 @@ limitations under the License.
 #include "tensorflow/core/graph/graph.h"
 #include "tensorflow/core/graph/node_builder.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/random/philox_random.h"
+#include "tensorflow/core/lib/random/simple_philox.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/test_benchmark.h"
@@ -471,4 +473,97 @@ BM_AllParseSingleExample(SparseFloat);
 BM_AllParseSingleExample(DenseFloat);
 BM_AllParseSingleExample(VarLenDenseFloat);
 
+// A schema modeled on click-through-rate models: many sparse categorical
+// features with a few hashed ids each, plus dense floats and short strings.
+constexpr int kAdClickIdFeatures = 240;
+constexpr int kAdClickFloatFeatures = 80;
+constexpr int kAdClickStringFeatures = 16;
+
+static Tensor MakeAdClickExamples(int batch_size) {
+  random::PhiloxRandom philox(301, 17);
+  random::SimplePhilox rnd(&philox);
+  Tensor serialized(DT_STRING, TensorShape({batch_size}));
+  for (int b = 0; b < batch_size; ++b) {
+    Example example;
+    auto& features = *example.mutable_features()->mutable_feature();
+    for (int k = 0; k < kAdClickIdFeatures; ++k) {
+      Int64List* ids =
+          features[strings::Printf("id_%d", k)].mutable_int64_list();
+      const int num_ids = 1 + rnd.Uniform(8);
+      for (int i = 0; i < num_ids; ++i) {
+        // A quarter of the features have small vocabularies, whose ids take
+        // one byte. Hashed ids take up to nine.
+        ids->add_value(k % 4 == 0 ? rnd.Uniform(100) : rnd.Rand64() >> 2);
+      }
+    }
+    for (int k = 0; k < kAdClickFloatFeatures; ++k) {
+      features[strings::Printf("float_%d", k)].mutable_float_list()->add_value(
+          rnd.RandFloat());
+    }
+    for (int k = 0; k < kAdClickStringFeatures; ++k) {
+      features[strings::Printf("string_%d", k)]
+          .mutable_bytes_list()
+          ->add_value(strings::StrCat("token_", rnd.Uniform(1000)));
+    }
+    CHECK(SerializeToTString(example, &serialized.vec<tstring>()(b)));
+  }
+  return serialized;
+}
+
+static Graph* ParseAdClickExamples(int batch_size) {
+  Graph* g = new Graph(OpRegistry::Global());
+  const int num_sparse = kAdClickIdFeatures + kAdClickStringFeatures;
+  Tensor sparse_keys(DT_STRING, {num_sparse});
+  std::vector<DataType> sparse_types;
+  for (int k = 0; k < kAdClickIdFeatures; ++k) {
+    sparse_keys.vec<tstring>()(k) = strings::Printf("id_%d", k);
+    sparse_types.push_back(DT_INT64);
+  }
+  for (int k = 0; k < kAdClickStringFeatures; ++k) {
+    sparse_keys.vec<tstring>()(kAdClickIdFeatures + k) =
+        strings::Printf("string_%d", k);
+    sparse_types.push_back(DT_STRING);
+  }
+  Tensor dense_keys(DT_STRING, {kAdClickFloatFeatures});
+  std::vector<NodeBuilder::NodeOut> dense_defaults;
+  std::vector<PartialTensorShape> dense_shapes;
+  for (int k = 0; k < kAdClickFloatFeatures; ++k) {
+    dense_keys.vec<tstring>()(k) = strings::Printf("float_%d", k);
+    dense_defaults.emplace_back(
+        test::graph::Constant(g, Tensor(DT_FLOAT, TensorShape({1}))));
+    dense_shapes.push_back(PartialTensorShape({1}));
+  }
+
+  Node* ret;
+  TF_EXPECT_OK(
+      NodeBuilder(g->NewName("n"), "ParseExampleV2")
+          .Input(test::graph::Constant(g, MakeAdClickExamples(batch_size)))
+          .Input(test::graph::Constant(
+              g, Tensor(DT_STRING, TensorShape({batch_size}))))
+          .Input(test::graph::Constant(g, sparse_keys))
+          .Input(test::graph::Constant(g, dense_keys))
+          .Input(test::graph::Constant(g, Tensor(DT_STRING, {0})))
+          .Input(dense_defaults)
+          .Attr("num_sparse", num_sparse)
+          .Attr("sparse_types", sparse_types)
+          .Attr("ragged_value_types", DataTypeVector())
+          .Attr("ragged_split_types", DataTypeVector())
+          .Attr("dense_shapes", dense_shapes)
+          .Finalize(g, &ret));
+
+  FixupSourceAndSinkEdges(g);
+  return g;
+}
+
+static void BM_ParseAdClickExamples(int iters, int batch_size) {
+  // Generating the examples is slow, so keep it out of the measurement.
+  testing::StopTiming();
+  testing::UseRealTime();
+  testing::ItemsProcessed(static_cast<int64>(iters) * batch_size);
+  test::Benchmark("cpu", ParseAdClickExamples(batch_size), nullptr, nullptr,
+                  nullptr, "SINGLE_THREADED_EXECUTOR")
+      .Run(iters);
+}
+BENCHMARK(BM_ParseAdClickExamples)->Arg(1)->Arg(128)->Arg(512);
+
 }  // end namespace tensorflow
@@ -0,0 +1,244 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// See docs in ../ops/nn_ops.cc.
+
+#define EIGEN_USE_THREADS
+
+#include "tensorflow/core/kernels/fused_attention_op.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "third_party/eigen3/Eigen/Core"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/kernels/fill_functor.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/util/work_sharder.h"
+
+namespace tensorflow {
+
+typedef Eigen::ThreadPoolDevice CPUDevice;
+typedef Eigen::GpuDevice GPUDevice;
+
+namespace functor {
+
+template <typename T>
+struct FusedAttention<CPUDevice, T> {
+  // A block of query rows and its scores for one block of keys stay in L2:
+  // with kQueryBlock x kKeyBlock floats the scores take 32KB.
+  static constexpr int64 kQueryBlock = 64;
+  static constexpr int64 kKeyBlock = 128;
+
+  void operator()(OpKernelContext* context, const FusedAttentionArgs& args,
+                  const T* query, const T* key, const T* value, T* output) {
+    using Matrix =
+        Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+    using Vector = Eigen::Matrix<T, Eigen::Dynamic, 1>;
+    using ConstMatrixMap = Eigen::Map<const Matrix>;
+    using MatrixMap = Eigen::Map<Matrix>;
+
+    const int64 depth = args.depth;
+    const int64 value_depth = args.value_depth;
+    const int64 query_length = args.query_length;
+    const int64 key_length = args.key_length;
+    const T scale = static_cast<T>(args.scale);
+    const int64 num_query_blocks =
+        (query_length + kQueryBlock - 1) / kQueryBlock;
+
+    // Every shard computes whole blocks of output rows, so shards never
+    // write to the same memory.
+    auto compute = [&](int64 start, int64 limit) {
+      Matrix scores;
+      Matrix partial;
+      Vector row_max;
+      Vector row_sum;
+      for (int64 i = start; i < limit; ++i) {
+        const int64 b = i / num_query_blocks;
+        const int64 first_row = (i % num_query_blocks) * kQueryBlock;
+        const int64 rows = std::min(kQueryBlock, query_length - first_row);
+
+        const ConstMatrixMap q(query + (b * query_length + first_row) * depth,
+                               rows, depth);
+        partial.setZero(rows, value_depth);
+        row_max.setConstant(rows, -std::numeric_limits<T>::infinity());
+        row_sum.setZero(rows);
+
+        for (int64 first_key = 0; first_key < key_length;
+             first_key += kKeyBlock) {
+          const int64 keys = std::min(kKeyBlock, key_length - first_key);
+          const ConstMatrixMap k(key + (b * key_length + first_key) * depth,
+                                 keys, depth);
+          const ConstMatrixMap v(
+              value + (b * key_length + first_key) * value_depth, keys,
+              value_depth);
+
+          scores.noalias() = q * k.transpose();
+          scores *= scale;
+          for (int64 r = 0; r < rows; ++r) {
+            auto row = scores.row(r);
+            const T new_max = std::max(row_max(r), row.maxCoeff());
+            // Zero in the first block, where row_max(r) is -infinity.
+            const T correction = Eigen::numext::exp(row_max(r) - new_max);
+            row = (row.array() - new_max).exp();
+            row_sum(r) = row_sum(r) * correction + row.sum();
+            partial.row(r) *= correction;
+            row_max(r) = new_max;
+          }
+          partial.noalias() += scores * v;
+        }
+
+        MatrixMap out(output + (b * query_length + first_row) * value_depth,
+                      rows, value_depth);
+        out.noalias() = row_sum.cwiseInverse().asDiagonal() * partial;
+      }
+    };
+
+    const int64 cost_per_block =
+        2 * kQueryBlock * key_length * (depth + value_depth);
+    auto worker_threads = *(context->device()->tensorflow_cpu_worker_threads());
+    Shard(worker_threads.num_threads, worker_threads.workers,
+          args.batch * num_query_blocks, cost_per_block, compute);
+  }
+};
+
+}  // namespace functor
+
+template <typename Device, typename T>
+class FusedAttentionOp : public OpKernel {
+ public:
+  explicit FusedAttentionOp(OpKernelConstruction* context)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("scale", &scale_));
+    max_depth_ = context->device_type() == DEVICE_GPU
+                     ? kFusedAttentionGpuMaxDepth
+                     : std::numeric_limits<int64>::max();
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& query = context->input(0);
+    const Tensor& key = context->input(1);
+    const Tensor& value = context->input(2);
+
+    const int dims = query.dims();
+    OP_REQUIRES(context, dims >= 3,
+                errors::InvalidArgument("query must be at least rank 3: ",
+                                        query.shape().DebugString()));
+    OP_REQUIRES(
+        context, key.dims() == dims && value.dims() == dims,
+        errors::InvalidArgument(
+            "query, key and value must have the same rank: ",
+            query.shape().DebugString(), " vs. ", key.shape().DebugString(),
+            " vs. ", value.shape().DebugString()));
+
+    TensorShape output_shape;
+    FusedAttentionArgs args;
+    args.batch = 1;
+    for (int i = 0; i < dims - 2; ++i) {
+      OP_REQUIRES(context,
+                  key.dim_size(i) == query.dim_size(i) &&
+                      value.dim_size(i) == query.dim_size(i),
+                  errors::InvalidArgument(
+                      "query, key and value must have the same batch "
+                      "dimensions: ",
+                      query.shape().DebugString(), " vs. ",
+                      key.shape().DebugString(), " vs. ",
+                      value.shape().DebugString()));
+      args.batch *= query.dim_size(i);
+      output_shape.AddDim(query.dim_size(i));
+    }
+    args.query_length = query.dim_size(dims - 2);
+    args.depth = query.dim_size(dims - 1);
+    args.key_length = key.dim_size(dims - 2);
+    args.value_depth = value.dim_size(dims - 1);
+    args.scale = scale_;
+
+    OP_REQUIRES(context, key.dim_size(dims - 1) == args.depth,
+                errors::InvalidArgument(
+                    "query and key must have the same depth: ",
+                    query.shape().DebugString(), " vs. ",
+                    key.shape().DebugString()));
+    OP_REQUIRES(context, value.dim_size(dims - 2) == args.key_length,
+                errors::InvalidArgument(
+                    "key and value must have the same length: ",
+                    key.shape().DebugString(), " vs. ",
+                    value.shape().DebugString()));
+    OP_REQUIRES(context,
+                args.depth <= max_depth_ && args.value_depth <= max_depth_,
+                errors::Unimplemented(
+                    "_FusedAttention supports depths of at most ", max_depth_,
+                    " on this device, got ", args.depth, " and ",
+                    args.value_depth));
+
+    output_shape.AddDim(args.query_length);
+    output_shape.AddDim(args.value_depth);
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(0, output_shape, &output));
+    if (output->NumElements() == 0) return;
+
+    // Softmax over no keys weights nothing.
+    if (args.key_length == 0) {
+      functor::SetZeroFunctor<Device, T>()(context->eigen_device<Device>(),
+                                           output->flat<T>());
+      return;
+    }
+
+    functor::FusedAttention<Device, T>()(
+        context, args, query.flat<T>().data(), key.flat<T>().data(),
+        value.flat<T>().data(), output->flat<T>().data());
+  }
+
+ private:
+  float scale_;
+  int64 max_depth_;
+};
+
+#define REGISTER_CPU(T)                                                  \
+  REGISTER_KERNEL_BUILDER(                                               \
+      Name("_FusedAttention").Device(DEVICE_CPU).TypeConstraint<T>("T"), \
+      FusedAttentionOp<CPUDevice, T>);
+
+TF_CALL_float(REGISTER_CPU);
+#undef REGISTER_CPU
+
+#if GOOGLE_CUDA
+
+// Forward declarations of the functor specializations for GPU.
+namespace functor {
+#define DECLARE_GPU_SPEC(T)                                                  \
+  template <>                                                                \
+  void FusedAttention<GPUDevice, T>::operator()(                             \
+      OpKernelContext* context, const FusedAttentionArgs& args,              \
+      const T* query, const T* key, const T* value, T* output);              \
+  extern template struct FusedAttention<GPUDevice, T>;
+
+DECLARE_GPU_SPEC(float);
+#undef DECLARE_GPU_SPEC
+}  // namespace functor
+
+#define REGISTER_GPU(T)                                                  \
+  REGISTER_KERNEL_BUILDER(                                               \
+      Name("_FusedAttention").Device(DEVICE_GPU).TypeConstraint<T>("T"), \
+      FusedAttentionOp<GPUDevice, T>);
+
+TF_CALL_float(REGISTER_GPU);
+#undef REGISTER_GPU
+
+#endif  // GOOGLE_CUDA
+
+}  // namespace tensorflow
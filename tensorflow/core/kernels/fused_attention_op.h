@@ -0,0 +1,57 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_KERNELS_FUSED_ATTENTION_OP_H_
+#define TENSORFLOW_CORE_KERNELS_FUSED_ATTENTION_OP_H_
+
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/types.h"
+
+namespace tensorflow {
+
+// Largest depth and value_depth of the GPU kernel, which keeps a row of the
+// output per warp in registers.
+constexpr int64 kFusedAttentionGpuMaxDepth = 128;
+
+struct FusedAttentionArgs {
+  int64 batch = 0;
+  int64 query_length = 0;
+  int64 key_length = 0;
+  int64 depth = 0;
+  int64 value_depth = 0;
+  float scale = 1.0f;
+};
+
+namespace functor {
+
+// Computes output = softmax(query * key^T * scale) * value for every batch,
+// with row-major query [batch, query_length, depth], key
+// [batch, key_length, depth], value [batch, key_length, value_depth] and
+// output [batch, query_length, value_depth].
+//
+// Keys are processed in blocks with an online softmax: every query row keeps
+// the running maximum and sum of its exponentiated scores, and rescales its
+// partial output whenever the maximum grows. The [query_length, key_length]
+// scores are therefore never stored, only one block of them at a time.
+template <typename Device, typename T>
+struct FusedAttention {
+  void operator()(OpKernelContext* context, const FusedAttentionArgs& args,
+                  const T* query, const T* key, const T* value, T* output);
+};
+
+}  // namespace functor
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_FUSED_ATTENTION_OP_H_
@@ -0,0 +1,178 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#if GOOGLE_CUDA
+
+#define EIGEN_USE_GPU
+
+#include <limits>
+
+#include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/kernels/fused_attention_op.h"
+#include "tensorflow/core/util/gpu_kernel_helper.h"
+
+namespace tensorflow {
+typedef Eigen::GpuDevice GPUDevice;
+
+namespace functor {
+namespace {
+
+constexpr int kWarpSize = 32;
+// Query rows per thread block, one per warp.
+constexpr int kRowsPerBlock = 4;
+// Keys per tile, one per lane.
+constexpr int kKeyTile = kWarpSize;
+constexpr int kMaxDepth = kFusedAttentionGpuMaxDepth;
+constexpr int kOutputsPerLane = kMaxDepth / kWarpSize;
+
+// Every warp computes one output row. The block loads tiles of kKeyTile keys
+// and values into shared memory; each lane scores one key of the tile against
+// the warp's query row, the warp updates the running maximum and sum of the
+// row with shuffles, and every lane accumulates kOutputsPerLane columns of the
+// output in registers.
+template <typename T>
+__global__ void __launch_bounds__(kRowsPerBlock* kWarpSize)
+    FusedAttentionKernel(const T* __restrict__ query,
+                         const T* __restrict__ key,
+                         const T* __restrict__ value, T* __restrict__ output,
+                         int64 query_length, int64 key_length, int depth,
+                         int value_depth, int64 row_blocks, float scale) {
+  __shared__ float query_rows[kRowsPerBlock][kMaxDepth];
+  // Odd row stride, so lanes reading the same column of different keys hit
+  // different banks.
+  __shared__ float key_tile[kKeyTile][kMaxDepth + 1];
+  __shared__ float value_tile[kKeyTile][kMaxDepth];
+
+  const int warp = threadIdx.x / kWarpSize;
+  const int lane = threadIdx.x % kWarpSize;
+  const int64 batch = blockIdx.x / row_blocks;
+  const int64 row = (blockIdx.x % row_blocks) * kRowsPerBlock + warp;
+  const bool active = row < query_length;
+
+  query += (batch * query_length + row) * depth;
+  key += batch * key_length * depth;
+  value += batch * key_length * value_depth;
+
+  if (active) {
+    for (int c = lane; c < depth; c += kWarpSize) {
+      query_rows[warp][c] = scale * static_cast<float>(ldg(query + c));
+    }
+  }
+
+  float partial[kOutputsPerLane];
+#pragma unroll
+  for (int i = 0; i < kOutputsPerLane; ++i) partial[i] = 0.0f;
+  float row_max = -std::numeric_limits<float>::infinity();
+  float row_sum = 0.0f;
+
+  for (int64 first_key = 0; first_key < key_length; first_key += kKeyTile) {
+    const int keys = min(static_cast<int64>(kKeyTile), key_length - first_key);
+
+    // Wait until everyone is done with the previous tile.
+    __syncthreads();
+    for (int i = threadIdx.x; i < keys * depth; i += blockDim.x) {
+      key_tile[i / depth][i % depth] =
+          static_cast<float>(ldg(key + first_key * depth + i));
+    }
+    for (int i = threadIdx.x; i < keys * value_depth; i += blockDim.x) {
+      value_tile[i / value_depth][i % value_depth] =
+          static_cast<float>(ldg(value + first_key * value_depth + i));
+    }
+    __syncthreads();
+    if (!active) continue;
+
+    float score = -std::numeric_limits<float>::infinity();
+    if (lane < keys) {
+      score = 0.0f;
+      for (int c = 0; c < depth; ++c) {
+        score += query_rows[warp][c] * key_tile[lane][c];
+      }
+    }
+
+    float tile_max = score;
+    for (int offset = kWarpSize / 2; offset > 0; offset /= 2) {
+      tile_max =
+          fmaxf(tile_max, GpuShuffleXorSync(kCudaWarpAll, tile_max, offset));
+    }
+    const float new_max = fmaxf(row_max, tile_max);
+    // Zero in the first tile, where row_max is -infinity.
+    const float correction = __expf(row_max - new_max);
+    const float weight = lane < keys ? __expf(score - new_max) : 0.0f;
+
+    float tile_sum = weight;
+    for (int offset = kWarpSize / 2; offset > 0; offset /= 2) {
+      tile_sum += GpuShuffleXorSync(kCudaWarpAll, tile_sum, offset);
+    }
+    row_sum = row_sum * correction + tile_sum;
+    row_max = new_max;
+
+#pragma unroll
+    for (int i = 0; i < kOutputsPerLane; ++i) partial[i] *= correction;
+    for (int k = 0; k < keys; ++k) {
+      const float w = GpuShuffleSync(kCudaWarpAll, weight, k);
+#pragma unroll
+      for (int i = 0; i < kOutputsPerLane; ++i) {
+        const int c = lane + i * kWarpSize;
+        if (c < value_depth) partial[i] += w * value_tile[k][c];
+      }
+    }
+  }
+
+  if (!active) return;
+  T* out = output + (batch * query_length + row) * value_depth;
+#pragma unroll
+  for (int i = 0; i < kOutputsPerLane; ++i) {
+    const int c = lane + i * kWarpSize;
+    if (c < value_depth) out[c] = static_cast<T>(partial[i] / row_sum);
+  }
+}
+
+template <typename T>
+void LaunchFusedAttention(OpKernelContext* context,
+                          const FusedAttentionArgs& args, const T* query,
+                          const T* key, const T* value, T* output) {
+  DCHECK_LE(args.depth, kMaxDepth);
+  DCHECK_LE(args.value_depth, kMaxDepth);
+  const GPUDevice& d = context->eigen_device<GPUDevice>();
+  const int64 row_blocks =
+      (args.query_length + kRowsPerBlock - 1) / kRowsPerBlock;
+  OP_REQUIRES_OK(
+      context,
+      GpuLaunchKernel(FusedAttentionKernel<T>, args.batch * row_blocks,
+                      kRowsPerBlock * kWarpSize, 0, d.stream(), query, key,
+                      value, output, args.query_length, args.key_length,
+                      static_cast<int>(args.depth),
+                      static_cast<int>(args.value_depth), row_blocks,
+                      args.scale));
+}
+
+}  // namespace
+
+#define DEFINE_GPU_SPEC(T)                                                     \
+  template <>                                                                  \
+  void FusedAttention<GPUDevice, T>::operator()(                               \
+      OpKernelContext* context, const FusedAttentionArgs& args,                \
+      const T* query, const T* key, const T* value, T* output) {               \
+    LaunchFusedAttention(context, args, query, key, value, output);            \
+  }                                                                            \
+  template struct FusedAttention<GPUDevice, T>;
+
+DEFINE_GPU_SPEC(float);
+#undef DEFINE_GPU_SPEC
+
+}  // namespace functor
+}  // namespace tensorflow
+
+#endif  // GOOGLE_CUDA
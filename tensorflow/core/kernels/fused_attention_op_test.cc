@@ -0,0 +1,143 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+
+class FusedAttentionOpTest : public OpsTestBase {
+ protected:
+  // Runs _FusedAttention on random inputs of the given sizes, and compares
+  // the result with softmax(q * k^T * scale) * v computed row by row.
+  void RunAndCompare(int64 batch, int64 query_length, int64 key_length,
+                     int64 depth, int64 value_depth, float scale) {
+    TF_ASSERT_OK(NodeDefBuilder("attention", "_FusedAttention")
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Attr("scale", scale)
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+
+    Tensor* query =
+        AddInput(DT_FLOAT, TensorShape({batch, query_length, depth}));
+    Tensor* key = AddInput(DT_FLOAT, TensorShape({batch, key_length, depth}));
+    Tensor* value =
+        AddInput(DT_FLOAT, TensorShape({batch, key_length, value_depth}));
+    query->flat<float>().setRandom();
+    key->flat<float>().setRandom();
+    value->flat<float>().setRandom();
+    TF_ASSERT_OK(RunOpKernel());
+
+    Tensor expected(DT_FLOAT, TensorShape({batch, query_length, value_depth}));
+    auto q = query->tensor<float, 3>();
+    auto k = key->tensor<float, 3>();
+    auto v = value->tensor<float, 3>();
+    auto out = expected.tensor<float, 3>();
+    std::vector<float> scores(key_length);
+    for (int64 b = 0; b < batch; ++b) {
+      for (int64 i = 0; i < query_length; ++i) {
+        float max_score = -INFINITY;
+        for (int64 j = 0; j < key_length; ++j) {
+          float score = 0;
+          for (int64 c = 0; c < depth; ++c) score += q(b, i, c) * k(b, j, c);
+          scores[j] = score * scale;
+          max_score = std::max(max_score, scores[j]);
+        }
+        float sum = 0;
+        for (int64 j = 0; j < key_length; ++j) {
+          scores[j] = std::exp(scores[j] - max_score);
+          sum += scores[j];
+        }
+        for (int64 c = 0; c < value_depth; ++c) {
+          float result = 0;
+          for (int64 j = 0; j < key_length; ++j) {
+            result += scores[j] * v(b, j, c);
+          }
+          out(b, i, c) = result / sum;
+        }
+      }
+    }
+    test::ExpectTensorNear<float>(expected, *GetOutput(0), 1e-4);
+  }
+};
+
+TEST_F(FusedAttentionOpTest, Small) { RunAndCompare(2, 3, 5, 4, 6, 0.5f); }
+
+// Spans several query and key blocks, with partial blocks at the end.
+TEST_F(FusedAttentionOpTest, MultipleBlocks) {
+  RunAndCompare(3, 70, 300, 32, 16, 1.0f / std::sqrt(32.0f));
+}
+
+TEST_F(FusedAttentionOpTest, BatchDimensions) {
+  TF_ASSERT_OK(NodeDefBuilder("attention", "_FusedAttention")
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+  // With zero queries every key is weighted equally.
+  AddInputFromArray<float>(TensorShape({2, 1, 1, 2}), {0, 0, 0, 0});
+  AddInputFromArray<float>(TensorShape({2, 1, 2, 2}), {1, 2, 3, 4, 5, 6, 7, 8});
+  AddInputFromArray<float>(TensorShape({2, 1, 2, 1}), {1, 3, 5, 9});
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected(allocator(), DT_FLOAT, TensorShape({2, 1, 1, 1}));
+  test::FillValues<float>(&expected, {2, 7});
+  test::ExpectTensorNear<float>(expected, *GetOutput(0), 1e-6);
+}
+
+TEST_F(FusedAttentionOpTest, NoKeys) {
+  TF_ASSERT_OK(NodeDefBuilder("attention", "_FusedAttention")
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+  AddInputFromArray<float>(TensorShape({1, 2, 2}), {1, 2, 3, 4});
+  AddInputFromArray<float>(TensorShape({1, 0, 2}), {});
+  AddInputFromArray<float>(TensorShape({1, 0, 3}), {});
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected(allocator(), DT_FLOAT, TensorShape({1, 2, 3}));
+  test::FillValues<float>(&expected, {0, 0, 0, 0, 0, 0});
+  test::ExpectTensorEqual<float>(expected, *GetOutput(0));
+}
+
+TEST_F(FusedAttentionOpTest, MismatchedBatch) {
+  TF_ASSERT_OK(NodeDefBuilder("attention", "_FusedAttention")
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+  AddInputFromArray<float>(TensorShape({2, 1, 2}), {1, 2, 3, 4});
+  AddInputFromArray<float>(TensorShape({1, 1, 2}), {1, 2});
+  AddInputFromArray<float>(TensorShape({1, 1, 2}), {1, 2});
+  Status s = RunOpKernel();
+  EXPECT_TRUE(errors::IsInvalidArgument(s)) << s;
+}
+
+}  // namespace tensorflow
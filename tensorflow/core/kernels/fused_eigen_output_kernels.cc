@@ -15,11 +15,59 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/fused_eigen_output_kernels.h"
 
+#include <algorithm>
+#include <unordered_map>
+
 #include "absl/strings/str_join.h"
 #include "absl/strings/substitute.h"
 
 namespace tensorflow {
 
+bool ParseElementwiseOp(const string& name, ElementwiseOp* op) {
+  static const auto* const ops =
+      new std::unordered_map<string, ElementwiseOp>({
+          {"Abs", ElementwiseOp::kAbs},
+          {"Elu", ElementwiseOp::kElu},
+          {"Exp", ElementwiseOp::kExp},
+          {"Log", ElementwiseOp::kLog},
+          {"Neg", ElementwiseOp::kNeg},
+          {"Relu", ElementwiseOp::kRelu},
+          {"Relu6", ElementwiseOp::kRelu6},
+          {"Rsqrt", ElementwiseOp::kRsqrt},
+          {"Sigmoid", ElementwiseOp::kSigmoid},
+          {"Sqrt", ElementwiseOp::kSqrt},
+          {"Square", ElementwiseOp::kSquare},
+          {"Tanh", ElementwiseOp::kTanh},
+      });
+  auto it = ops->find(name);
+  if (it == ops->end()) return false;
+  *op = it->second;
+  return true;
+}
+
+namespace {
+
+// Matches `fused_ops` against an element-wise chain pattern, storing the
+// element-wise ops following the pattern's prefix in `*elementwise_chain`.
+bool MatchesElementwiseChain(const std::vector<string>& fused_ops,
+                             const FusedComputationPattern& pattern,
+                             std::vector<ElementwiseOp>* elementwise_chain) {
+  const std::vector<string>& prefix = pattern.fused_ops;
+  if (fused_ops.size() <= prefix.size() ||
+      !std::equal(prefix.begin(), prefix.end(), fused_ops.begin())) {
+    return false;
+  }
+  elementwise_chain->clear();
+  for (size_t i = prefix.size(); i < fused_ops.size(); ++i) {
+    ElementwiseOp op;
+    if (!ParseElementwiseOp(fused_ops[i], &op)) return false;
+    elementwise_chain->push_back(op);
+  }
+  return true;
+}
+
+}  // namespace
+
 Status InitializeFusedComputation(
     OpKernelConstruction* context, const string& kernel_name,
     const std::vector<FusedComputationPattern>& patterns,
@@ -38,15 +86,20 @@ Status InitializeFusedComputation(
   int num_args;
   TF_RETURN_IF_ERROR(context->GetAttr("num_args", &num_args));
 
-  // TODO(ezhulenev): Add support for fusion element-wise op chains defined
-  // at runtime, e.g. Relu+Sqrt+Tanh+etc.
-
   // Reset fused computation type.
   *fused_computation = FusedComputationType::kUndefined;
 
   // Match op fusion to one of the supported patterns.
   for (const auto& pattern : patterns) {
-    if (fused_ops == pattern.fused_ops) {
+    if (pattern.fused_computation ==
+        FusedComputationType::kBiasAddWithElementwiseChain) {
+      if (MatchesElementwiseChain(
+              fused_ops, pattern,
+              &fused_computation_args->elementwise_chain)) {
+        *fused_computation = pattern.fused_computation;
+        break;
+      }
+    } else if (fused_ops == pattern.fused_ops) {
       *fused_computation = pattern.fused_computation;
       break;
     }
@@ -60,7 +113,9 @@ Status InitializeFusedComputation(
   if (*fused_computation == FusedComputationType::kBiasAdd ||
       *fused_computation == FusedComputationType::kBiasAddWithRelu ||
       *fused_computation == FusedComputationType::kBiasAddWithRelu6 ||
-      *fused_computation == FusedComputationType::kBiasAddWithElu) {
+      *fused_computation == FusedComputationType::kBiasAddWithElu ||
+      *fused_computation ==
+          FusedComputationType::kBiasAddWithElementwiseChain) {
     if (num_args != 1) {
       return errors::InvalidArgument(
           "Fused ", kernel_name,
@@ -20,8 +20,11 @@ limitations under the License.
 // Supported fused computations:
 //   (1) {Conv2D/MatMul} + BiasAdd + <Activation>
 //   (2) {Conv2D/MatMul} + FusedBatchNorm + <Activation>
+//   (3) {Conv2D/MatMul} + BiasAdd + <Element-wise op chain>
 //
 // Activation: Relu, Relu6, Elu, etc...
+// Element-wise op chain: any sequence of the unary ops in `ElementwiseOp`,
+// e.g. Tanh+Square, defined at runtime by the `fused_ops` attribute.
 
 #ifndef TENSORFLOW_CORE_KERNELS_FUSED_EIGEN_OUTPUT_KERNELS_H_
 #define TENSORFLOW_CORE_KERNELS_FUSED_EIGEN_OUTPUT_KERNELS_H_
@@ -42,14 +45,40 @@ enum class FusedComputationType {
   kFusedBatchNorm,
   kFusedBatchNormWithRelu,
   kFusedBatchNormWithRelu6,
-  kFusedBatchNormWithElu
+  kFusedBatchNormWithElu,
+  kBiasAddWithElementwiseChain
 };
 
+// Unary element-wise ops that can be chained after a BiasAdd.
+enum class ElementwiseOp {
+  kAbs,
+  kElu,
+  kExp,
+  kLog,
+  kNeg,
+  kRelu,
+  kRelu6,
+  kRsqrt,
+  kSigmoid,
+  kSqrt,
+  kSquare,
+  kTanh
+};
+
+// Parses the name of a TensorFlow op into `*op`. Returns false if the op is
+// not a supported element-wise op.
+bool ParseElementwiseOp(const string& name, ElementwiseOp* op);
+
 // We have to pass around additional arguments for all possible fusion types.
 struct FusedComputationArgs {
   float epsilon = 0.0;  // Used by `FusedBatchNorm` fusion only
+  // Used by `BiasAddWithElementwiseChain` fusion only.
+  std::vector<ElementwiseOp> elementwise_chain;
 };
 
+// A pattern matches `fused_ops` that are equal to its `fused_ops`. A pattern
+// of type `kBiasAddWithElementwiseChain` instead matches `fused_ops` that
+// start with its `fused_ops` and continue with one or more element-wise ops.
 struct FusedComputationPattern {
   FusedComputationType fused_computation;
   std::vector<string> fused_ops;
@@ -111,6 +140,52 @@ struct Elu {
   };
 };
 
+// Applies an element-wise op in place to the passed tensor.
+template <typename TensorType>
+EIGEN_ALWAYS_INLINE void ApplyElementwiseOp(ElementwiseOp op,
+                                            TensorType& tensor) {
+  using Scalar = typename TensorType::Scalar;
+  switch (op) {
+    case ElementwiseOp::kAbs:
+      tensor = tensor.abs();
+      break;
+    case ElementwiseOp::kElu:
+      tensor = Elu::apply(tensor);
+      break;
+    case ElementwiseOp::kExp:
+      tensor = tensor.exp();
+      break;
+    case ElementwiseOp::kLog:
+      tensor = tensor.log();
+      break;
+    case ElementwiseOp::kNeg:
+      tensor = -tensor;
+      break;
+    case ElementwiseOp::kRelu:
+      tensor = tensor.cwiseMax(static_cast<Scalar>(0));
+      break;
+    case ElementwiseOp::kRelu6:
+      tensor = tensor.cwiseMax(static_cast<Scalar>(0))
+                   .cwiseMin(static_cast<Scalar>(6));
+      break;
+    case ElementwiseOp::kRsqrt:
+      tensor = tensor.rsqrt();
+      break;
+    case ElementwiseOp::kSigmoid:
+      tensor = tensor.sigmoid();
+      break;
+    case ElementwiseOp::kSqrt:
+      tensor = tensor.sqrt();
+      break;
+    case ElementwiseOp::kSquare:
+      tensor = tensor.square();
+      break;
+    case ElementwiseOp::kTanh:
+      tensor = tensor.tanh();
+      break;
+  }
+}
+
 template <typename T>
 struct BiasAddArgs {
   const T* bias_add_data = nullptr;
@@ -119,7 +194,8 @@ struct BiasAddArgs {
     return fusion == FusedComputationType::kBiasAdd ||
            fusion == FusedComputationType::kBiasAddWithRelu ||
            fusion == FusedComputationType::kBiasAddWithRelu6 ||
-           fusion == FusedComputationType::kBiasAddWithElu;
+           fusion == FusedComputationType::kBiasAddWithElu ||
+           fusion == FusedComputationType::kBiasAddWithElementwiseChain;
   }
 };
 
@@ -203,6 +279,45 @@ struct BiasAddOutputKernel {
   const T* bias_data;
 };
 
+// Output kernel that fuses BiasAdd operation into the output of tensor
+// contraction, followed by a chain of element-wise ops defined at runtime. The
+// ops are applied one after another to each output block column while it is
+// still in cache, so each op costs a pass over the column instead of a pass
+// over the whole output tensor.
+template <typename T>
+struct BiasAddWithElementwiseChainOutputKernel {
+  BiasAddWithElementwiseChainOutputKernel(
+      const BiasAddArgs<T>& args,
+      const std::vector<ElementwiseOp>& elementwise_chain)
+      : bias_data(args.bias_add_data), elementwise_chain(&elementwise_chain) {}
+
+  template <typename StorageIndex, typename Scalar>
+  EIGEN_ALWAYS_INLINE void operator()(
+      const ContractionOutputMapper<Scalar, StorageIndex>& output_mapper,
+      const Eigen::TensorContractionParams& params, StorageIndex i,
+      StorageIndex j, StorageIndex num_rows, StorageIndex num_cols) const {
+    DCHECK(params.swapped_arguments);
+
+    const T* bias_base = bias_data + i;
+    typename TTypes<T>::UnalignedConstTensor bias(bias_base, num_rows);
+
+    for (int col = 0; col < num_cols; ++col) {
+      T* output_base = &output_mapper(0, col);
+      typename TTypes<T>::UnalignedTensor output(output_base, num_rows);
+      output = output + bias;
+      for (ElementwiseOp op : *elementwise_chain) {
+        ApplyElementwiseOp(op, output);
+      }
+    }
+  }
+
+ private:
+  const T* bias_data;
+  // Owned by the kernel's `FusedComputationArgs`, which outlive the
+  // contraction.
+  const std::vector<ElementwiseOp>* elementwise_chain;
+};
+
 // Output kernel that fuses FusedBatchNorm operation into the output of tensor
 // contraction + activation function defined by Activation.
 template <typename T, typename Activation = Identity>
@@ -258,6 +373,9 @@ using WithBiasAddAndRelu6 = BiasAddOutputKernel<T, Relu6>;
 template <typename T>
 using WithBiasAddAndElu = BiasAddOutputKernel<T, Elu>;
 template <typename T>
+using WithBiasAddAndElementwiseChain =
+    BiasAddWithElementwiseChainOutputKernel<T>;
+template <typename T>
 using WithFusedBatchNorm = FusedBatchNormOutputKernel<T>;
 template <typename T>
 using WithFusedBatchNormAndRelu = FusedBatchNormOutputKernel<T, Relu>;
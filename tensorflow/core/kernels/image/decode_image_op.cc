@@ -15,8 +15,11 @@ limitations under the License.
 
 // See docs in ../ops/image_ops.cc
 
+#include <algorithm>
 #include <cstdint>
+#include <cstring>
 #include <memory>
+#include <vector>
 
 #define EIGEN_USE_THREADS
 
@@ -30,11 +33,13 @@ limitations under the License.
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/gif/gif_io.h"
 #include "tensorflow/core/lib/jpeg/jpeg_mem.h"
+#include "tensorflow/core/lib/math/math_util.h"
 #include "tensorflow/core/lib/png/png_io.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/platform/byte_order.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/util/tensor_bundle/byte_swap.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 namespace {
@@ -963,5 +968,155 @@ void DecodeImageV2Op::DecodeBMP(const uint8* input, const int row_size,
   }
 }
 
+// Decodes a batch of JPEG images on the intra-op threads, each image directly
+// into its slot of the output. Every slot is as large as the largest image and
+// the smaller images are zero-padded at the bottom and right.
+class DecodeJpegBatchOp : public OpKernel {
+ public:
+  explicit DecodeJpegBatchOp(OpKernelConstruction* context)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("channels", &flags_.components));
+    OP_REQUIRES(context, flags_.components == 1 || flags_.components == 3,
+                errors::InvalidArgument("channels must be 1 or 3, got ",
+                                        flags_.components));
+    OP_REQUIRES_OK(context, context->GetAttr("ratio", &flags_.ratio));
+    OP_REQUIRES(context,
+                flags_.ratio == 1 || flags_.ratio == 2 || flags_.ratio == 4 ||
+                    flags_.ratio == 8,
+                errors::InvalidArgument("ratio must be 1, 2, 4, or 8, got ",
+                                        flags_.ratio));
+    OP_REQUIRES_OK(context, context->GetAttr("fancy_upscaling",
+                                             &flags_.fancy_upscaling));
+    OP_REQUIRES_OK(context,
+                   context->GetAttr("try_recover_truncated",
+                                    &flags_.try_recover_truncated_jpeg));
+    OP_REQUIRES_OK(context, context->GetAttr("acceptable_fraction",
+                                             &flags_.min_acceptable_fraction));
+
+    string dct_method;
+    OP_REQUIRES_OK(context, context->GetAttr("dct_method", &dct_method));
+    OP_REQUIRES(
+        context,
+        (dct_method.empty() || dct_method == "INTEGER_FAST" ||
+         dct_method == "INTEGER_ACCURATE"),
+        errors::InvalidArgument("dct_method must be one of "
+                                "{'', 'INTEGER_FAST', 'INTEGER_ACCURATE'}"));
+    // The TensorFlow-chosen default for JPEG decoding is IFAST, sacrificing
+    // image quality for speed.
+    flags_.dct_method =
+        dct_method == "INTEGER_ACCURATE" ? JDCT_ISLOW : JDCT_IFAST;
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& contents = context->input(0);
+    OP_REQUIRES(context, TensorShapeUtils::IsVector(contents.shape()),
+                errors::InvalidArgument("contents must be a vector, got shape ",
+                                        contents.shape().DebugString()));
+    const auto inputs = contents.vec<tstring>();
+    const int64 batch = inputs.size();
+
+    Tensor* image_size = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(
+                                1, TensorShape({batch, 2}), &image_size));
+    auto sizes = image_size->matrix<int32>();
+
+    // Only the headers are read here, to size the output.
+    int max_height = 0;
+    int max_width = 0;
+    for (int64 i = 0; i < batch; ++i) {
+      const tstring& input = inputs(i);
+      OP_REQUIRES(context, input.size() <= std::numeric_limits<int>::max(),
+                  errors::InvalidArgument("JPEG contents of image ", i,
+                                          " are too large for int: ",
+                                          input.size()));
+      int width;
+      int height;
+      OP_REQUIRES(context,
+                  jpeg::GetImageInfo(input.data(), input.size(), &width,
+                                     &height, nullptr),
+                  errors::InvalidArgument("Invalid JPEG header for image ", i,
+                                          ", data size ", input.size()));
+      // libjpeg rounds the scaled sizes up.
+      max_height =
+          std::max(max_height, MathUtil::CeilOfRatio(height, flags_.ratio));
+      max_width =
+          std::max(max_width, MathUtil::CeilOfRatio(width, flags_.ratio));
+    }
+
+    const int channels = flags_.components;
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context,
+                   context->allocate_output(
+                       0, TensorShape({batch, max_height, max_width, channels}),
+                       &output));
+    if (output->NumElements() == 0) {
+      sizes.setZero();
+      return;
+    }
+
+    const int row_bytes = max_width * channels;
+    const int64 image_bytes = static_cast<int64>(max_height) * row_bytes;
+    uint8* const output_data = output->flat<uint8>().data();
+    // One status per image, so that the shards never share one.
+    std::vector<Status> statuses(batch);
+
+    auto decode = [&](int64 begin, int64 end) {
+      // The rows of every image are the rows of its slot.
+      jpeg::UncompressFlags flags = flags_;
+      flags.stride = row_bytes;
+      for (int64 i = begin; i < end; ++i) {
+        const tstring& input = inputs(i);
+        uint8* const image = output_data + i * image_bytes;
+        int height = 0;
+        int width = 0;
+        const uint8* decoded = jpeg::Uncompress(
+            input.data(), input.size(), flags, nullptr /* nwarn */,
+            [&](int w, int h, int c) -> uint8* {
+              if (h > max_height || w > max_width || c != channels) {
+                return nullptr;
+              }
+              height = h;
+              width = w;
+              return image;
+            });
+        if (decoded == nullptr) {
+          statuses[i] = errors::InvalidArgument(
+              "Invalid JPEG data for image ", i, ", data size ", input.size());
+          height = 0;
+          width = 0;
+        }
+        sizes(i, 0) = height;
+        sizes(i, 1) = width;
+
+        // Zero the padding.
+        const int row_padding = row_bytes - width * channels;
+        if (row_padding > 0) {
+          for (int y = 0; y < height; ++y) {
+            std::memset(image + y * row_bytes + width * channels, 0,
+                        row_padding);
+          }
+        }
+        std::memset(image + static_cast<int64>(height) * row_bytes, 0,
+                    image_bytes - static_cast<int64>(height) * row_bytes);
+      }
+    };
+    // Decoding costs a few hundred cycles per output byte.
+    const int64 cost_per_image = 200 * image_bytes;
+    auto worker_threads = context->device()->tensorflow_cpu_worker_threads();
+    Shard(worker_threads->num_threads, worker_threads->workers, batch,
+          cost_per_image, decode);
+
+    for (const Status& status : statuses) {
+      OP_REQUIRES_OK(context, status);
+    }
+  }
+
+ private:
+  jpeg::UncompressFlags flags_;
+};
+
+REGISTER_KERNEL_BUILDER(Name("DecodeJpegBatch").Device(DEVICE_CPU),
+                        DecodeJpegBatchOp);
+
 }  // namespace
 }  // namespace tensorflow
@@ -0,0 +1,309 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// See docs in ../ops/image_ops.cc
+
+#define EIGEN_USE_THREADS
+
+#include "tensorflow/core/kernels/image/fused_image_augmentation_op.h"
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/work_sharder.h"
+
+namespace tensorflow {
+
+typedef Eigen::ThreadPoolDevice CPUDevice;
+typedef Eigen::GpuDevice GPUDevice;
+
+template <typename Device, typename T>
+class FusedImageAugmentationOp : public OpKernel {
+ public:
+  explicit FusedImageAugmentationOp(OpKernelConstruction* context)
+      : OpKernel(context) {
+    string method;
+    OP_REQUIRES_OK(context, context->GetAttr("method", &method));
+    OP_REQUIRES(context, method == "bilinear" || method == "nearest",
+                errors::InvalidArgument(
+                    "method must be 'bilinear' or 'nearest'", method));
+    nearest_ = method == "nearest";
+  }
+
+  void Compute(OpKernelContext* context) override {
+    // The shape of 'images' is [batch_size, height, width, channels].
+    const Tensor& images = context->input(0);
+    // The shape of 'boxes' is [batch_size, 4].
+    const Tensor& boxes = context->input(1);
+    // The shape of 'size' is [2].
+    const Tensor& size = context->input(2);
+
+    OP_REQUIRES(context, images.dims() == 4,
+                errors::InvalidArgument("images must be 4-D",
+                                        images.shape().DebugString()));
+    const int64 batch_size = images.dim_size(0);
+    const int64 image_height = images.dim_size(1);
+    const int64 image_width = images.dim_size(2);
+    const int64 channels = images.dim_size(3);
+    OP_REQUIRES(context, image_height > 0 && image_width > 0,
+                errors::InvalidArgument("image dimensions must be positive"));
+    OP_REQUIRES(
+        context,
+        boxes.dims() == 2 && boxes.dim_size(0) == batch_size &&
+            boxes.dim_size(1) == 4,
+        errors::InvalidArgument("boxes must be of shape [batch_size, 4]: ",
+                                boxes.shape().DebugString()));
+    OP_REQUIRES(context,
+                TensorShapeUtils::IsVector(size.shape()) &&
+                    size.NumElements() == 2,
+                errors::InvalidArgument("size must be a 1-D tensor with 2 "
+                                        "elements: ",
+                                        size.shape().DebugString()));
+    const int32 out_height = size.vec<int32>()(0);
+    const int32 out_width = size.vec<int32>()(1);
+    OP_REQUIRES(context, out_height > 0 && out_width > 0,
+                errors::InvalidArgument("size must be positive"));
+
+    static const char* const kPerImageInputs[] = {
+        "flip", "brightness_delta", "saturation_factor", "contrast_factor"};
+    for (int i = 0; i < 4; ++i) {
+      const Tensor& input = context->input(3 + i);
+      OP_REQUIRES(context,
+                  TensorShapeUtils::IsVector(input.shape()) &&
+                      input.dim_size(0) == batch_size,
+                  errors::InvalidArgument(
+                      kPerImageInputs[i], " must be of shape [batch_size]: ",
+                      input.shape().DebugString()));
+    }
+    const Tensor& mean = context->input(7);
+    const Tensor& stddev = context->input(8);
+    OP_REQUIRES(context,
+                TensorShapeUtils::IsVector(mean.shape()) &&
+                    mean.dim_size(0) == channels &&
+                    TensorShapeUtils::IsVector(stddev.shape()) &&
+                    stddev.dim_size(0) == channels,
+                errors::InvalidArgument(
+                    "mean and stddev must be of shape [channels]: ",
+                    mean.shape().DebugString(), " and ",
+                    stddev.shape().DebugString()));
+
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context,
+                   context->allocate_output(
+                       0,
+                       TensorShape({batch_size, out_height, out_width,
+                                    channels}),
+                       &output));
+    if (output->NumElements() == 0) return;
+
+    // Integer images are converted to [0, 1] first, as by
+    // tf.image.convert_image_dtype.
+    const float value_scale = std::is_same<T, uint8>::value ? 1.0f / 255 : 1.0f;
+    functor::FusedImageAugmentation<Device, T>()(
+        context, images.tensor<T, 4>(), boxes.tensor<float, 2>(),
+        context->input(3).vec<bool>(), context->input(4).vec<float>(),
+        context->input(5).vec<float>(), context->input(6).vec<float>(),
+        mean.vec<float>(), stddev.vec<float>(), nearest_, value_scale,
+        output->tensor<float, 4>());
+  }
+
+ private:
+  bool nearest_;
+};
+
+namespace functor {
+
+// The CPU kernel samples every output row in a single pass: it interpolates
+// the crop, adjusts brightness and saturation, and records the channel sums
+// of the row. A second pass over the output, once the image means are known,
+// applies contrast and normalization as one multiply-add per value.
+template <typename T>
+struct FusedImageAugmentation<CPUDevice, T> {
+  void operator()(OpKernelContext* context,
+                  typename TTypes<T, 4>::ConstTensor images,
+                  typename TTypes<float, 2>::ConstTensor boxes,
+                  typename TTypes<bool>::ConstVec flip,
+                  typename TTypes<float>::ConstVec brightness_delta,
+                  typename TTypes<float>::ConstVec saturation_factor,
+                  typename TTypes<float>::ConstVec contrast_factor,
+                  typename TTypes<float>::ConstVec mean,
+                  typename TTypes<float>::ConstVec stddev, bool nearest,
+                  float value_scale, typename TTypes<float, 4>::Tensor output) {
+    const int batch_size = images.dimension(0);
+    const int image_height = images.dimension(1);
+    const int image_width = images.dimension(2);
+    const int channels = images.dimension(3);
+    const int out_height = output.dimension(1);
+    const int out_width = output.dimension(2);
+    const int64 num_rows = static_cast<int64>(batch_size) * out_height;
+
+    Tensor row_sums_tensor;
+    OP_REQUIRES_OK(context, context->allocate_temp(
+                                DT_FLOAT, TensorShape({num_rows, channels}),
+                                &row_sums_tensor));
+    float* row_sums = row_sums_tensor.flat<float>().data();
+    const T* images_data = images.data();
+    float* output_data = output.data();
+    const int64 row_size = static_cast<int64>(out_width) * channels;
+
+    auto sample_rows = [&](int64 start, int64 limit) {
+      // The input offsets and weights of every output column, which only
+      // change with the image.
+      std::vector<int64> left(out_width);
+      std::vector<int64> right(out_width);
+      std::vector<float> x_lerp(out_width);
+      int cached_b = -1;
+      for (int64 row = start; row < limit; ++row) {
+        const int b = row / out_height;
+        const int y = row % out_height;
+        if (b != cached_b) {
+          for (int x = 0; x < out_width; ++x) {
+            const float in_x = FusedAugmentationSourceCoord(
+                boxes(b, 1), boxes(b, 3), image_width, out_width,
+                flip(b) ? out_width - 1 - x : x);
+            const int64 left_x = nearest ? roundf(in_x) : floorf(in_x);
+            const int64 right_x = nearest ? left_x : ceilf(in_x);
+            left[x] = left_x * channels;
+            right[x] = right_x * channels;
+            x_lerp[x] = in_x - left_x;
+          }
+          cached_b = b;
+        }
+        const float in_y = FusedAugmentationSourceCoord(
+            boxes(b, 0), boxes(b, 2), image_height, out_height, y);
+        const int64 top_y = nearest ? roundf(in_y) : floorf(in_y);
+        const int64 bottom_y = nearest ? top_y : ceilf(in_y);
+        const float y_lerp = in_y - top_y;
+        const T* top_row =
+            images_data + (b * image_height + top_y) * image_width * channels;
+        const T* bottom_row = images_data + (b * image_height + bottom_y) *
+                                                image_width * channels;
+
+        float* out_row = output_data + row * row_size;
+        float* sums = row_sums + row * channels;
+        std::fill(sums, sums + channels, 0.0f);
+        const float delta = brightness_delta(b);
+        const float saturation = saturation_factor(b);
+        const bool adjust_saturation = channels == 3 && saturation != 1.0f;
+        for (int x = 0; x < out_width; ++x) {
+          float* out = out_row + x * channels;
+          const T* top_left = top_row + left[x];
+          const T* top_right = top_row + right[x];
+          const T* bottom_left = bottom_row + left[x];
+          const T* bottom_right = bottom_row + right[x];
+          for (int c = 0; c < channels; ++c) {
+            const float tl = static_cast<float>(top_left[c]);
+            const float tr = static_cast<float>(top_right[c]);
+            const float bl = static_cast<float>(bottom_left[c]);
+            const float br = static_cast<float>(bottom_right[c]);
+            const float top = tl + (tr - tl) * x_lerp[x];
+            const float bottom = bl + (br - bl) * x_lerp[x];
+            out[c] = (top + (bottom - top) * y_lerp) * value_scale + delta;
+          }
+          if (adjust_saturation) {
+            FusedAugmentationSaturation(saturation, &out[0], &out[1], &out[2]);
+          }
+          for (int c = 0; c < channels; ++c) {
+            sums[c] += out[c];
+          }
+        }
+      }
+    };
+    const DeviceBase::CpuWorkerThreads& worker_threads =
+        *context->device()->tensorflow_cpu_worker_threads();
+    Shard(worker_threads.num_threads, worker_threads.workers, num_rows,
+          row_size * 20, sample_rows);
+
+    // Contrast around the image mean followed by normalization is
+    // out * scale + offset for every channel of an image.
+    std::vector<float> scale(batch_size * channels);
+    std::vector<float> offset(batch_size * channels);
+    const float inv_num_pixels = 1.0f / (out_height * out_width);
+    for (int b = 0; b < batch_size; ++b) {
+      for (int c = 0; c < channels; ++c) {
+        float sum = 0;
+        for (int y = 0; y < out_height; ++y) {
+          sum += row_sums[(b * out_height + y) * channels + c];
+        }
+        const float image_mean = sum * inv_num_pixels;
+        const float factor = contrast_factor(b);
+        scale[b * channels + c] = factor / stddev(c);
+        offset[b * channels + c] =
+            (image_mean * (1.0f - factor) - mean(c)) / stddev(c);
+      }
+    }
+
+    auto normalize_rows = [&](int64 start, int64 limit) {
+      for (int64 row = start; row < limit; ++row) {
+        const int b = row / out_height;
+        const float* s = scale.data() + b * channels;
+        const float* o = offset.data() + b * channels;
+        float* out = output_data + row * row_size;
+        for (int x = 0; x < out_width; ++x, out += channels) {
+          for (int c = 0; c < channels; ++c) {
+            out[c] = out[c] * s[c] + o[c];
+          }
+        }
+      }
+    };
+    Shard(worker_threads.num_threads, worker_threads.workers, num_rows,
+          row_size * 2, normalize_rows);
+  }
+};
+
+}  // namespace functor
+
+#define REGISTER_KERNEL(T)                                     \
+  REGISTER_KERNEL_BUILDER(Name("FusedImageAugmentation")       \
+                              .Device(DEVICE_CPU)              \
+                              .TypeConstraint<T>("T"),         \
+                          FusedImageAugmentationOp<CPUDevice, T>);
+
+TF_CALL_uint8(REGISTER_KERNEL);
+TF_CALL_half(REGISTER_KERNEL);
+TF_CALL_float(REGISTER_KERNEL);
+
+#undef REGISTER_KERNEL
+
+#if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+
+#define REGISTER_KERNEL(T)                                     \
+  REGISTER_KERNEL_BUILDER(Name("FusedImageAugmentation")       \
+                              .Device(DEVICE_GPU)              \
+                              .TypeConstraint<T>("T")          \
+                              .HostMemory("size"),             \
+                          FusedImageAugmentationOp<GPUDevice, T>);
+
+TF_CALL_uint8(REGISTER_KERNEL);
+TF_CALL_half(REGISTER_KERNEL);
+TF_CALL_float(REGISTER_KERNEL);
+
+#undef REGISTER_KERNEL
+
+#endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+
+}  // namespace tensorflow
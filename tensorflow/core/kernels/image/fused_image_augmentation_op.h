@@ -0,0 +1,80 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_KERNELS_IMAGE_FUSED_IMAGE_AUGMENTATION_OP_H_
+#define TENSORFLOW_CORE_KERNELS_IMAGE_FUSED_IMAGE_AUGMENTATION_OP_H_
+
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/core/framework/numeric_types.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor_types.h"
+
+namespace tensorflow {
+namespace functor {
+
+// Returns the position in an input dimension of `in_size` pixels that output
+// pixel `out` samples, for a crop from `start` to `end` in normalized
+// coordinates that is resized to `out_size` pixels. This is the mapping of
+// CropAndResize, except that positions outside of the image are clamped to its
+// border.
+EIGEN_DEVICE_FUNC EIGEN_ALWAYS_INLINE float FusedAugmentationSourceCoord(
+    float start, float end, int in_size, int out_size, int out) {
+  const float in =
+      out_size > 1
+          ? start * (in_size - 1) + out * (end - start) * (in_size - 1) /
+                                        (out_size - 1)
+          : 0.5f * (start + end) * (in_size - 1);
+  return Eigen::numext::mini(Eigen::numext::maxi(in, 0.0f),
+                             static_cast<float>(in_size - 1));
+}
+
+// Scales the HSV saturation of an RGB pixel by `factor`, clamping it to
+// [0, 1]. Hue and value are kept, so every channel moves along the line to the
+// largest one and no conversion to HSV and back is needed.
+EIGEN_DEVICE_FUNC EIGEN_ALWAYS_INLINE void FusedAugmentationSaturation(
+    float factor, float* r, float* g, float* b) {
+  const float v = Eigen::numext::maxi(*r, Eigen::numext::maxi(*g, *b));
+  const float range =
+      v - Eigen::numext::mini(*r, Eigen::numext::mini(*g, *b));
+  if (v <= 0.0f || range <= 0.0f) return;
+  const float s = range / v;
+  const float new_s =
+      Eigen::numext::mini(Eigen::numext::maxi(s * factor, 0.0f), 1.0f);
+  const float ratio = new_s / s;
+  *r = v - (v - *r) * ratio;
+  *g = v - (v - *g) * ratio;
+  *b = v - (v - *b) * ratio;
+}
+
+template <typename Device, typename T>
+struct FusedImageAugmentation {
+  // We assume that the tensor sizes are correct. The input values are
+  // multiplied by `value_scale` when they are converted to float.
+  void operator()(OpKernelContext* context,
+                  typename TTypes<T, 4>::ConstTensor images,
+                  typename TTypes<float, 2>::ConstTensor boxes,
+                  typename TTypes<bool>::ConstVec flip,
+                  typename TTypes<float>::ConstVec brightness_delta,
+                  typename TTypes<float>::ConstVec saturation_factor,
+                  typename TTypes<float>::ConstVec contrast_factor,
+                  typename TTypes<float>::ConstVec mean,
+                  typename TTypes<float>::ConstVec stddev, bool nearest,
+                  float value_scale, typename TTypes<float, 4>::Tensor output);
+};
+
+}  // namespace functor
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_IMAGE_FUSED_IMAGE_AUGMENTATION_OP_H_
@@ -0,0 +1,201 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// See docs in ../ops/image_ops.cc.
+
+#if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+
+#define EIGEN_USE_GPU
+
+#include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_types.h"
+#include "tensorflow/core/kernels/image/fused_image_augmentation_op.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/gpu_kernel_helper.h"
+
+namespace tensorflow {
+
+typedef Eigen::GpuDevice GPUDevice;
+
+namespace {
+
+constexpr int kSumThreadsPerBlock = 256;
+
+// Samples one output pixel and adjusts its brightness and saturation.
+template <typename T>
+__global__ void FusedAugmentationSampleKernel(
+    const int32 nthreads, const T* __restrict__ images,
+    const float* __restrict__ boxes, const bool* __restrict__ flip,
+    const float* __restrict__ brightness_delta,
+    const float* __restrict__ saturation_factor, int image_height,
+    int image_width, int out_height, int out_width, int channels,
+    bool nearest, float value_scale, float* __restrict__ output) {
+  GPU_1D_KERNEL_LOOP(out_idx, nthreads) {
+    // out_idx = x + out_width * (y + out_height * b)
+    int idx = out_idx;
+    const int x = idx % out_width;
+    idx /= out_width;
+    const int y = idx % out_height;
+    const int b = idx / out_height;
+
+    const float in_y = functor::FusedAugmentationSourceCoord(
+        boxes[b * 4], boxes[b * 4 + 2], image_height, out_height, y);
+    const float in_x = functor::FusedAugmentationSourceCoord(
+        boxes[b * 4 + 1], boxes[b * 4 + 3], image_width, out_width,
+        flip[b] ? out_width - 1 - x : x);
+    const int top_y = nearest ? roundf(in_y) : floorf(in_y);
+    const int bottom_y = nearest ? top_y : ceilf(in_y);
+    const int left_x = nearest ? roundf(in_x) : floorf(in_x);
+    const int right_x = nearest ? left_x : ceilf(in_x);
+    const float y_lerp = in_y - top_y;
+    const float x_lerp = in_x - left_x;
+
+    const T* top_row =
+        images + static_cast<int64>(b * image_height + top_y) * image_width *
+                     channels;
+    const T* bottom_row =
+        images + static_cast<int64>(b * image_height + bottom_y) *
+                     image_width * channels;
+    float* out = output + static_cast<int64>(out_idx) * channels;
+    const float delta = brightness_delta[b];
+    for (int c = 0; c < channels; ++c) {
+      const float tl = static_cast<float>(top_row[left_x * channels + c]);
+      const float tr = static_cast<float>(top_row[right_x * channels + c]);
+      const float bl = static_cast<float>(bottom_row[left_x * channels + c]);
+      const float br = static_cast<float>(bottom_row[right_x * channels + c]);
+      const float top = tl + (tr - tl) * x_lerp;
+      const float bottom = bl + (br - bl) * x_lerp;
+      out[c] = (top + (bottom - top) * y_lerp) * value_scale + delta;
+    }
+    if (channels == 3 && saturation_factor[b] != 1.0f) {
+      functor::FusedAugmentationSaturation(saturation_factor[b], &out[0],
+                                           &out[1], &out[2]);
+    }
+  }
+}
+
+// Sums one channel of one image with a block of kSumThreadsPerBlock threads.
+__global__ void FusedAugmentationChannelSumKernel(
+    const float* __restrict__ output, int num_pixels, int channels,
+    float* __restrict__ sums) {
+  __shared__ float partial[kSumThreadsPerBlock];
+  const int b = blockIdx.x / channels;
+  const int c = blockIdx.x % channels;
+  const float* image = output + static_cast<int64>(b) * num_pixels * channels;
+  float sum = 0;
+  for (int i = threadIdx.x; i < num_pixels; i += kSumThreadsPerBlock) {
+    sum += image[static_cast<int64>(i) * channels + c];
+  }
+  partial[threadIdx.x] = sum;
+  __syncthreads();
+  for (int stride = kSumThreadsPerBlock / 2; stride > 0; stride /= 2) {
+    if (threadIdx.x < stride) {
+      partial[threadIdx.x] += partial[threadIdx.x + stride];
+    }
+    __syncthreads();
+  }
+  if (threadIdx.x == 0) {
+    sums[blockIdx.x] = partial[0];
+  }
+}
+
+// Applies contrast around the image mean and normalizes, in place.
+__global__ void FusedAugmentationNormalizeKernel(
+    const int32 nthreads, const float* __restrict__ sums,
+    const float* __restrict__ contrast_factor,
+    const float* __restrict__ mean, const float* __restrict__ stddev,
+    int num_pixels, int channels, float* __restrict__ output) {
+  GPU_1D_KERNEL_LOOP(idx, nthreads) {
+    const int c = idx % channels;
+    const int b = idx / (num_pixels * channels);
+    const float image_mean = sums[b * channels + c] / num_pixels;
+    const float factor = contrast_factor[b];
+    output[idx] =
+        ((output[idx] - image_mean) * factor + image_mean - mean[c]) /
+        stddev[c];
+  }
+}
+
+}  // namespace
+
+namespace functor {
+
+template <typename T>
+struct FusedImageAugmentation<GPUDevice, T> {
+  void operator()(OpKernelContext* context,
+                  typename TTypes<T, 4>::ConstTensor images,
+                  typename TTypes<float, 2>::ConstTensor boxes,
+                  typename TTypes<bool>::ConstVec flip,
+                  typename TTypes<float>::ConstVec brightness_delta,
+                  typename TTypes<float>::ConstVec saturation_factor,
+                  typename TTypes<float>::ConstVec contrast_factor,
+                  typename TTypes<float>::ConstVec mean,
+                  typename TTypes<float>::ConstVec stddev, bool nearest,
+                  float value_scale, typename TTypes<float, 4>::Tensor output) {
+    const int batch_size = images.dimension(0);
+    const int image_height = images.dimension(1);
+    const int image_width = images.dimension(2);
+    const int channels = images.dimension(3);
+    const int out_height = output.dimension(1);
+    const int out_width = output.dimension(2);
+    const int num_pixels = out_height * out_width;
+    const GPUDevice& d = context->eigen_device<GPUDevice>();
+
+    Tensor sums;
+    OP_REQUIRES_OK(context, context->allocate_temp(
+                                DT_FLOAT, TensorShape({batch_size, channels}),
+                                &sums));
+
+    GpuLaunchConfig config = GetGpuLaunchConfig(batch_size * num_pixels, d);
+    OP_REQUIRES_OK(
+        context,
+        GpuLaunchKernel(FusedAugmentationSampleKernel<T>, config.block_count,
+                        config.thread_per_block, 0, d.stream(),
+                        config.virtual_thread_count, images.data(),
+                        boxes.data(), flip.data(), brightness_delta.data(),
+                        saturation_factor.data(), image_height, image_width,
+                        out_height, out_width, channels, nearest, value_scale,
+                        output.data()));
+    OP_REQUIRES_OK(
+        context,
+        GpuLaunchKernel(FusedAugmentationChannelSumKernel,
+                        batch_size * channels, kSumThreadsPerBlock, 0,
+                        d.stream(), output.data(), num_pixels, channels,
+                        sums.flat<float>().data()));
+    config = GetGpuLaunchConfig(output.size(), d);
+    OP_REQUIRES_OK(
+        context,
+        GpuLaunchKernel(FusedAugmentationNormalizeKernel, config.block_count,
+                        config.thread_per_block, 0, d.stream(),
+                        config.virtual_thread_count, sums.flat<float>().data(),
+                        contrast_factor.data(), mean.data(), stddev.data(),
+                        num_pixels, channels, output.data()));
+  }
+};
+
+#define DEFINE_GPU_SPECS(T) \
+  template struct FusedImageAugmentation<GPUDevice, T>;
+
+TF_CALL_uint8(DEFINE_GPU_SPECS);
+TF_CALL_half(DEFINE_GPU_SPECS);
+TF_CALL_float(DEFINE_GPU_SPECS);
+
+#undef DEFINE_GPU_SPECS
+
+}  // namespace functor
+}  // namespace tensorflow
+
+#endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
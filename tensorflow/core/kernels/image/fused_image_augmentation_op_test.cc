@@ -0,0 +1,161 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <vector>
+
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+
+class FusedImageAugmentationOpTest : public OpsTestBase {
+ protected:
+  template <typename T>
+  void MakeOp(const string& method) {
+    TF_EXPECT_OK(
+        NodeDefBuilder("fused_image_augmentation_op", "FusedImageAugmentation")
+            .Input(FakeInput(DataTypeToEnum<T>::value))
+            .Input(FakeInput(DT_FLOAT))
+            .Input(FakeInput(DT_INT32))
+            .Input(FakeInput(DT_BOOL))
+            .Input(FakeInput(DT_FLOAT))
+            .Input(FakeInput(DT_FLOAT))
+            .Input(FakeInput(DT_FLOAT))
+            .Input(FakeInput(DT_FLOAT))
+            .Input(FakeInput(DT_FLOAT))
+            .Attr("method", method)
+            .Finalize(node_def()));
+    TF_EXPECT_OK(InitOp());
+  }
+
+  // Adds the inputs after the images for a single image with `channels`
+  // channels that is resized to `height` x `width`.
+  void AddAugmentation(int height, int width, int channels, bool flip,
+                       float brightness_delta, float saturation_factor,
+                       float contrast_factor, float mean, float stddev) {
+    AddInputFromArray<float>(TensorShape({1, 4}), {0, 0, 1, 1});
+    AddInputFromArray<int32>(TensorShape({2}), {height, width});
+    AddInputFromArray<bool>(TensorShape({1}), {flip});
+    AddInputFromArray<float>(TensorShape({1}), {brightness_delta});
+    AddInputFromArray<float>(TensorShape({1}), {saturation_factor});
+    AddInputFromArray<float>(TensorShape({1}), {contrast_factor});
+    AddInputFromList<float>(TensorShape({channels}),
+                            std::vector<float>(channels, mean));
+    AddInputFromList<float>(TensorShape({channels}),
+                            std::vector<float>(channels, stddev));
+  }
+};
+
+TEST_F(FusedImageAugmentationOpTest, Identity) {
+  MakeOp<float>("bilinear");
+  AddInputFromArray<float>(TensorShape({1, 2, 2, 1}), {1, 2, 3, 4});
+  AddAugmentation(2, 2, 1, false, 0, 1, 1, 0, 1);
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected(allocator(), DT_FLOAT, TensorShape({1, 2, 2, 1}));
+  test::FillValues<float>(&expected, {1, 2, 3, 4});
+  test::ExpectTensorEqual<float>(expected, *GetOutput(0));
+}
+
+TEST_F(FusedImageAugmentationOpTest, Bilinear) {
+  MakeOp<float>("bilinear");
+  AddInputFromArray<float>(TensorShape({1, 2, 2, 1}), {1, 2, 3, 4});
+  AddAugmentation(3, 3, 1, false, 0, 1, 1, 0, 1);
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected(allocator(), DT_FLOAT, TensorShape({1, 3, 3, 1}));
+  test::FillValues<float>(&expected, {1, 1.5, 2, 2, 2.5, 3, 3, 3.5, 4});
+  test::ExpectTensorNear<float>(expected, *GetOutput(0), 1e-5);
+}
+
+TEST_F(FusedImageAugmentationOpTest, Nearest) {
+  MakeOp<float>("nearest");
+  AddInputFromArray<float>(TensorShape({1, 2, 2, 1}), {1, 2, 3, 4});
+  AddAugmentation(1, 1, 1, false, 0, 1, 1, 0, 1);
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected(allocator(), DT_FLOAT, TensorShape({1, 1, 1, 1}));
+  test::FillValues<float>(&expected, {4});
+  test::ExpectTensorEqual<float>(expected, *GetOutput(0));
+}
+
+TEST_F(FusedImageAugmentationOpTest, FlipBrightnessAndNormalize) {
+  MakeOp<float>("bilinear");
+  AddInputFromArray<float>(TensorShape({1, 2, 2, 1}), {1, 2, 3, 4});
+  AddAugmentation(2, 2, 1, true, 1, 1, 1, 2, 2);
+  TF_ASSERT_OK(RunOpKernel());
+
+  // ((flipped + 1) - 2) / 2.
+  Tensor expected(allocator(), DT_FLOAT, TensorShape({1, 2, 2, 1}));
+  test::FillValues<float>(&expected, {0.5, 0, 1.5, 1});
+  test::ExpectTensorNear<float>(expected, *GetOutput(0), 1e-5);
+}
+
+TEST_F(FusedImageAugmentationOpTest, Contrast) {
+  MakeOp<float>("bilinear");
+  AddInputFromArray<float>(TensorShape({1, 1, 2, 2}), {1, 10, 3, 30});
+  AddAugmentation(1, 2, 2, false, 0, 1, 2, 0, 1);
+  TF_ASSERT_OK(RunOpKernel());
+
+  // The channel means are 2 and 20.
+  Tensor expected(allocator(), DT_FLOAT, TensorShape({1, 1, 2, 2}));
+  test::FillValues<float>(&expected, {0, 0, 4, 40});
+  test::ExpectTensorNear<float>(expected, *GetOutput(0), 1e-5);
+}
+
+TEST_F(FusedImageAugmentationOpTest, Saturation) {
+  MakeOp<float>("bilinear");
+  AddInputFromArray<float>(TensorShape({1, 1, 2, 3}),
+                           {0.2, 0.4, 0.6, 0.5, 0.25, 0});
+  AddAugmentation(1, 2, 3, false, 0, 0, 1, 0, 1);
+  TF_ASSERT_OK(RunOpKernel());
+
+  // A saturation of 0 makes every channel equal to the value.
+  Tensor expected(allocator(), DT_FLOAT, TensorShape({1, 1, 2, 3}));
+  test::FillValues<float>(&expected, {0.6, 0.6, 0.6, 0.5, 0.5, 0.5});
+  test::ExpectTensorNear<float>(expected, *GetOutput(0), 1e-5);
+}
+
+TEST_F(FusedImageAugmentationOpTest, Uint8IsScaled) {
+  MakeOp<uint8>("bilinear");
+  AddInputFromArray<uint8>(TensorShape({1, 1, 2, 1}), {0, 255});
+  AddAugmentation(1, 2, 1, false, 0, 1, 1, 0, 1);
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected(allocator(), DT_FLOAT, TensorShape({1, 1, 2, 1}));
+  test::FillValues<float>(&expected, {0, 1});
+  test::ExpectTensorNear<float>(expected, *GetOutput(0), 1e-6);
+}
+
+TEST_F(FusedImageAugmentationOpTest, InvalidMeanShape) {
+  MakeOp<float>("bilinear");
+  AddInputFromArray<float>(TensorShape({1, 1, 2, 1}), {1, 2});
+  AddAugmentation(1, 2, 2, false, 0, 1, 1, 0, 1);
+  Status s = RunOpKernel();
+  ASSERT_FALSE(s.ok());
+  EXPECT_TRUE(absl::StrContains(s.ToString(),
+                                "mean and stddev must be of shape [channels]"))
+      << s;
+}
+
+}  // namespace tensorflow
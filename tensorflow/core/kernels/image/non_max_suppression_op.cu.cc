@@ -719,6 +719,486 @@ class NonMaxSuppressionV4GPUOp : public OpKernel {
   bool pad_to_max_output_size_;
 };
 
+// Combined non-max suppression.
+//
+// All (image, class) pairs are processed at once, without copying anything to
+// the host: the scores of every pair are sorted with a segmented sort, every
+// pair runs the greedy selection in its own block, and the boxes selected for
+// each image are sorted again by score before being gathered into the
+// outputs. The selection follows the CPU kernel exactly.
+
+constexpr int kCombinedNmsTileSize = 256;
+constexpr int kCombinedNmsTileWords = kCombinedNmsTileSize / kNmsBoxesPerThread;
+
+// Whether boxes a and b, whose corners are ordered, have an IoU above the
+// threshold. Unlike OverThreshold this matches the CPU kernels: boxes without
+// area never overlap and the IoU must be strictly above the threshold.
+__device__ EIGEN_STRONG_INLINE bool IouAboveThreshold(
+    const Box& a, const Box& b, const float iou_threshold) {
+  const float a_area = (a.x2 - a.x1) * (a.y2 - a.y1);
+  const float b_area = (b.x2 - b.x1) * (b.y2 - b.y1);
+  if (a_area <= 0.0f || b_area <= 0.0f) return false;
+  const float w = fmaxf(fminf(a.x2, b.x2) - fmaxf(a.x1, b.x1), 0.0f);
+  const float h = fmaxf(fminf(a.y2, b.y2) - fmaxf(a.y1, b.y1), 0.0f);
+  const float intersection = w * h;
+  return intersection > iou_threshold * (a_area + b_area - intersection);
+}
+
+// Writes the scores of class c for the boxes of image b to segment
+// b * num_classes + c of `class_scores`, along with the box indices.
+__global__ void CombinedNmsTransposeScores(const int num_elements,
+                                           const float* scores,
+                                           const int num_boxes,
+                                           const int num_classes,
+                                           float* class_scores,
+                                           int* box_indices) {
+  for (int idx : GpuGridRangeX(num_elements)) {
+    const int box = idx % num_boxes;
+    const int segment = idx / num_boxes;
+    const int image = segment / num_classes;
+    const int class_idx = segment % num_classes;
+    class_scores[idx] =
+        scores[(static_cast<int64>(image) * num_boxes + box) * num_classes +
+               class_idx];
+    box_indices[idx] = box;
+  }
+}
+
+// Selects the boxes of every (image, class) segment greedily, one block per
+// segment. The candidates, sorted by decreasing score, are taken a tile at a
+// time. Each thread checks its candidate against the boxes selected from
+// earlier tiles and computes the bitmask of the later candidates of the tile
+// that it overlaps; one thread then walks the tile in order and selects the
+// candidates that no selected candidate masked. The walk stops at the first
+// score below the threshold or when size_per_class boxes are selected.
+__launch_bounds__(kCombinedNmsTileSize) __global__ void CombinedNmsKernel(
+    const Box* boxes, const int num_boxes, const int q, const int num_classes,
+    const float* sorted_scores, const int* sorted_box_indices,
+    const float iou_threshold, const float score_threshold,
+    const int size_per_class, Box* selected_boxes, float* selected_scores,
+    int* selected_box_indices, int* num_selected_per_class) {
+  __shared__ Box tile_boxes[kCombinedNmsTileSize];
+  __shared__ unsigned int tile_masks[kCombinedNmsTileSize]
+                                    [kCombinedNmsTileWords];
+  __shared__ bool tile_keep[kCombinedNmsTileSize];
+  __shared__ int num_selected;
+
+  const int segment = blockIdx.x;
+  const int image = segment / num_classes;
+  const int class_idx = segment % num_classes;
+  const int64 segment_begin = static_cast<int64>(segment) * num_boxes;
+  const float* segment_scores = sorted_scores + segment_begin;
+  const int* segment_box_indices = sorted_box_indices + segment_begin;
+  const int64 selected_begin = static_cast<int64>(segment) * size_per_class;
+  Box* segment_selected_boxes = selected_boxes + selected_begin;
+  float* segment_selected_scores = selected_scores + selected_begin;
+  int* segment_selected_box_indices = selected_box_indices + selected_begin;
+  if (threadIdx.x == 0) num_selected = 0;
+  __syncthreads();
+
+  // The loop conditions are common to all threads of the block.
+  for (int tile = 0; tile < num_boxes; tile += kCombinedNmsTileSize) {
+    const int i = tile + threadIdx.x;
+    const bool valid = i < num_boxes && segment_scores[i] > score_threshold;
+    Box box = {0.0f, 0.0f, 0.0f, 0.0f};
+    if (valid) {
+      box = boxes[(static_cast<int64>(image) * num_boxes +
+                   segment_box_indices[i]) *
+                      q +
+                  (q > 1 ? class_idx : 0)];
+      Flipped<true>(box);
+    }
+    bool keep = valid;
+    for (int j = 0; keep && j < num_selected; ++j) {
+      keep = !IouAboveThreshold(box, segment_selected_boxes[j], iou_threshold);
+    }
+    tile_boxes[threadIdx.x] = box;
+    tile_keep[threadIdx.x] = keep;
+    // The scores are sorted, so all candidates after an invalid one are
+    // invalid too.
+    const int num_valid = __syncthreads_count(valid);
+
+    for (int word = 0; word < kCombinedNmsTileWords; ++word) {
+      unsigned int mask = 0;
+      for (int bit = 0; keep && bit < kNmsBoxesPerThread; ++bit) {
+        const int j = word * kNmsBoxesPerThread + bit;
+        if (j > static_cast<int>(threadIdx.x) && tile_keep[j] &&
+            IouAboveThreshold(box, tile_boxes[j], iou_threshold)) {
+          mask |= 1U << bit;
+        }
+      }
+      tile_masks[threadIdx.x][word] = mask;
+    }
+    __syncthreads();
+
+    if (threadIdx.x == 0) {
+      unsigned int removed[kCombinedNmsTileWords] = {0};
+      int n = num_selected;
+      for (int t = 0; t < kCombinedNmsTileSize && n < size_per_class; ++t) {
+        if (!tile_keep[t] ||
+            ((removed[t >> kNmsBoxesPerThreadShiftBits] >>
+              (t & kNmsBoxesPerThreadModuloMask)) &
+             1)) {
+          continue;
+        }
+        segment_selected_boxes[n] = tile_boxes[t];
+        segment_selected_scores[n] = segment_scores[tile + t];
+        segment_selected_box_indices[n] = segment_box_indices[tile + t];
+        ++n;
+        for (int word = 0; word < kCombinedNmsTileWords; ++word) {
+          removed[word] |= tile_masks[t][word];
+        }
+      }
+      num_selected = n;
+    }
+    __syncthreads();
+    if (num_valid < kCombinedNmsTileSize || num_selected >= size_per_class) {
+      break;
+    }
+  }
+
+  // Unused slots sort after all selected boxes of the image.
+  for (int j = num_selected + threadIdx.x; j < size_per_class;
+       j += blockDim.x) {
+    segment_selected_scores[j] = -Eigen::NumTraits<float>::infinity();
+  }
+  if (threadIdx.x == 0) num_selected_per_class[segment] = num_selected;
+}
+
+// Numbers the candidates of every image, class by class.
+__global__ void CombinedNmsCandidates(const int num_elements,
+                                      const int num_candidates,
+                                      int* candidates) {
+  for (int idx : GpuGridRangeX(num_elements)) {
+    candidates[idx] = idx % num_candidates;
+  }
+}
+
+__global__ void CombinedNmsCountDetections(const int num_images,
+                                           const int num_classes,
+                                           const int* num_selected_per_class,
+                                           const int max_detections,
+                                           int* valid_detections) {
+  for (int image : GpuGridRangeX(num_images)) {
+    int num_selected = 0;
+    for (int c = 0; c < num_classes; ++c) {
+      num_selected += num_selected_per_class[image * num_classes + c];
+    }
+    valid_detections[image] = min(num_selected, max_detections);
+  }
+}
+
+// Writes detection j of every image: the j-th selected box of the image by
+// decreasing score, or zeros past the valid detections.
+__global__ void CombinedNmsGatherDetections(
+    const int num_elements, const int per_batch_size, const int num_classes,
+    const int size_per_class, const Box* boxes, const int num_boxes,
+    const int q, const float* sorted_selected_scores,
+    const int* sorted_candidates, const int* selected_box_indices,
+    const int* valid_detections, const bool clip_boxes, float* nmsed_boxes,
+    float* nmsed_scores, float* nmsed_classes) {
+  const int num_candidates = num_classes * size_per_class;
+  for (int idx : GpuGridRangeX(num_elements)) {
+    const int image = idx / per_batch_size;
+    const int j = idx % per_batch_size;
+    Box box = {0.0f, 0.0f, 0.0f, 0.0f};
+    float score = 0.0f;
+    int class_idx = 0;
+    if (j < valid_detections[image]) {
+      const int64 image_begin = static_cast<int64>(image) * num_candidates;
+      const int candidate = sorted_candidates[image_begin + j];
+      class_idx = candidate / size_per_class;
+      const int box_idx = selected_box_indices[image_begin + candidate];
+      box = boxes[(static_cast<int64>(image) * num_boxes + box_idx) * q +
+                  (q > 1 ? class_idx : 0)];
+      if (clip_boxes) {
+        box.x1 = fmaxf(fminf(box.x1, 1.0f), 0.0f);
+        box.y1 = fmaxf(fminf(box.y1, 1.0f), 0.0f);
+        box.x2 = fmaxf(fminf(box.x2, 1.0f), 0.0f);
+        box.y2 = fmaxf(fminf(box.y2, 1.0f), 0.0f);
+      }
+      score = sorted_selected_scores[image_begin + j];
+    }
+    reinterpret_cast<Box*>(nmsed_boxes)[idx] = box;
+    nmsed_scores[idx] = score;
+    nmsed_classes[idx] = class_idx;
+  }
+}
+
+struct SegmentOffsetCreator {
+  EIGEN_DEVICE_FUNC
+  SegmentOffsetCreator(int segment_size) : segment_size_(segment_size) {}
+
+  EIGEN_DEVICE_FUNC EIGEN_STRONG_INLINE int operator()(int idx) const {
+    return idx * segment_size_;
+  }
+
+  int segment_size_;
+};
+
+// Sorts `num_segments` segments of `segment_size` (key, value) pairs by
+// decreasing key.
+Status SegmentedSortPairsDescending(OpKernelContext* context,
+                                    const float* keys_in, float* keys_out,
+                                    const int* values_in, int* values_out,
+                                    const int num_segments,
+                                    const int segment_size) {
+  gpuprim::CountingInputIterator<int> counting_iter(0);
+  gpuprim::TransformInputIterator<int, SegmentOffsetCreator,
+                                  gpuprim::CountingInputIterator<int>>
+      segment_offsets(counting_iter, SegmentOffsetCreator(segment_size));
+  auto cuda_stream = GetGpuStream(context);
+  size_t temp_storage_bytes = 0;
+  TF_RETURN_IF_CUDA_ERROR(
+      gpuprim::DeviceSegmentedRadixSort::SortPairsDescending(
+          nullptr, temp_storage_bytes, keys_in, keys_out, values_in,
+          values_out, num_segments * segment_size, num_segments,
+          segment_offsets, segment_offsets + 1, 0, 8 * sizeof(float),
+          cuda_stream));
+  Tensor temp_storage;
+  TF_RETURN_IF_ERROR(context->allocate_temp(
+      DataType::DT_INT8, TensorShape({(int64)temp_storage_bytes}),
+      &temp_storage));
+  TF_RETURN_IF_CUDA_ERROR(
+      gpuprim::DeviceSegmentedRadixSort::SortPairsDescending(
+          temp_storage.flat<int8>().data(), temp_storage_bytes, keys_in,
+          keys_out, values_in, values_out, num_segments * segment_size,
+          num_segments, segment_offsets, segment_offsets + 1, 0,
+          8 * sizeof(float), cuda_stream));
+  return Status::OK();
+}
+
+class CombinedNonMaxSuppressionGPUOp : public OpKernel {
+ public:
+  explicit CombinedNonMaxSuppressionGPUOp(OpKernelConstruction* context)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("pad_per_class", &pad_per_class_));
+    OP_REQUIRES_OK(context, context->GetAttr("clip_boxes", &clip_boxes_));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    // boxes: [batch_size, num_anchors, q, 4]
+    const Tensor& boxes = context->input(0);
+    // scores: [batch_size, num_anchors, num_classes]
+    const Tensor& scores = context->input(1);
+    OP_REQUIRES(context, boxes.dims() == 4,
+                errors::InvalidArgument("boxes must be 4-D",
+                                        boxes.shape().DebugString()));
+    OP_REQUIRES(context, scores.dims() == 3,
+                errors::InvalidArgument("scores must be 3-D",
+                                        scores.shape().DebugString()));
+    OP_REQUIRES(
+        context, (boxes.dim_size(0) == scores.dim_size(0)),
+        errors::InvalidArgument("boxes and scores must have same batch size"));
+    const int num_classes = scores.dim_size(2);
+    const bool box_check =
+        boxes.dim_size(2) == 1 || boxes.dim_size(2) == num_classes;
+    OP_REQUIRES(context, box_check,
+                errors::InvalidArgument("third dimension of boxes must be "
+                                        "either 1 or num classes"));
+    OP_REQUIRES(context, boxes.dim_size(3) == 4,
+                errors::InvalidArgument("boxes must have 4 columns"));
+    const int num_boxes = boxes.dim_size(1);
+    OP_REQUIRES(context, scores.dim_size(1) == num_boxes,
+                errors::InvalidArgument("scores has incompatible shape"));
+    OP_REQUIRES(context,
+                scores.NumElements() <= std::numeric_limits<int>::max(),
+                errors::InvalidArgument("scores has too many elements: ",
+                                        scores.NumElements()));
+
+    const Tensor& max_output_size = context->input(2);
+    OP_REQUIRES(
+        context, TensorShapeUtils::IsScalar(max_output_size.shape()),
+        errors::InvalidArgument("max_size_per_class must be 0-D, got shape ",
+                                max_output_size.shape().DebugString()));
+    const int max_size_per_class = max_output_size.scalar<int>()();
+    const Tensor& max_total_size = context->input(3);
+    OP_REQUIRES(
+        context, TensorShapeUtils::IsScalar(max_total_size.shape()),
+        errors::InvalidArgument("max_total_size must be 0-D, got shape ",
+                                max_total_size.shape().DebugString()));
+    const int max_total_size_per_batch = max_total_size.scalar<int>()();
+    OP_REQUIRES(context, max_total_size_per_batch > 0,
+                errors::InvalidArgument("max_total_size must be > 0"));
+    const Tensor& iou_threshold = context->input(4);
+    OP_REQUIRES(context, TensorShapeUtils::IsScalar(iou_threshold.shape()),
+                errors::InvalidArgument("iou_threshold must be 0-D, got shape ",
+                                        iou_threshold.shape().DebugString()));
+    const float iou_threshold_val = iou_threshold.scalar<float>()();
+    const Tensor& score_threshold = context->input(5);
+    OP_REQUIRES(
+        context, TensorShapeUtils::IsScalar(score_threshold.shape()),
+        errors::InvalidArgument("score_threshold must be 0-D, got shape ",
+                                score_threshold.shape().DebugString()));
+    const float score_threshold_val = score_threshold.scalar<float>()();
+    OP_REQUIRES(context, iou_threshold_val >= 0 && iou_threshold_val <= 1,
+                errors::InvalidArgument("iou_threshold must be in [0, 1]"));
+
+    const int num_images = boxes.dim_size(0);
+    const int q = boxes.dim_size(2);
+    const int size_per_class = std::min(max_size_per_class, num_boxes);
+    int per_batch_size = max_total_size_per_batch;
+    if (pad_per_class_) {
+      per_batch_size =
+          std::min(max_total_size_per_batch, max_size_per_class * num_classes);
+    }
+
+    Tensor* nmsed_boxes = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(
+                                0, TensorShape({num_images, per_batch_size, 4}),
+                                &nmsed_boxes));
+    Tensor* nmsed_scores = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(
+                                1, TensorShape({num_images, per_batch_size}),
+                                &nmsed_scores));
+    Tensor* nmsed_classes = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(
+                                2, TensorShape({num_images, per_batch_size}),
+                                &nmsed_classes));
+    Tensor* valid_detections = nullptr;
+    OP_REQUIRES_OK(context,
+                   context->allocate_output(3, TensorShape({num_images}),
+                                            &valid_detections));
+    if (num_images == 0) return;
+    auto device = context->eigen_gpu_device();
+    if (num_boxes == 0 || num_classes == 0 || size_per_class <= 0 ||
+        per_batch_size <= 0) {
+      device.memset(nmsed_boxes->flat<float>().data(), 0,
+                    nmsed_boxes->TotalBytes());
+      device.memset(nmsed_scores->flat<float>().data(), 0,
+                    nmsed_scores->TotalBytes());
+      device.memset(nmsed_classes->flat<float>().data(), 0,
+                    nmsed_classes->TotalBytes());
+      device.memset(valid_detections->flat<int>().data(), 0,
+                    valid_detections->TotalBytes());
+      return;
+    }
+
+    // Sort the boxes of every (image, class) segment by decreasing score.
+    const int num_segments = num_images * num_classes;
+    const int num_elements = num_segments * num_boxes;
+    Tensor class_scores, box_indices, sorted_scores, sorted_box_indices;
+    OP_REQUIRES_OK(context, context->allocate_temp(DT_FLOAT,
+                                                   TensorShape({num_elements}),
+                                                   &class_scores));
+    OP_REQUIRES_OK(context, context->allocate_temp(DT_INT32,
+                                                   TensorShape({num_elements}),
+                                                   &box_indices));
+    OP_REQUIRES_OK(context, context->allocate_temp(DT_FLOAT,
+                                                   TensorShape({num_elements}),
+                                                   &sorted_scores));
+    OP_REQUIRES_OK(context, context->allocate_temp(DT_INT32,
+                                                   TensorShape({num_elements}),
+                                                   &sorted_box_indices));
+    auto config = GetGpuLaunchConfig(num_elements, device);
+    OP_REQUIRES_OK(
+        context,
+        GpuLaunchKernel(CombinedNmsTransposeScores, config.block_count,
+                        config.thread_per_block, 0, device.stream(),
+                        num_elements, scores.flat<float>().data(), num_boxes,
+                        num_classes, class_scores.flat<float>().data(),
+                        box_indices.flat<int>().data()));
+    OP_REQUIRES_OK(context,
+                   SegmentedSortPairsDescending(
+                       context, class_scores.flat<float>().data(),
+                       sorted_scores.flat<float>().data(),
+                       box_indices.flat<int>().data(),
+                       sorted_box_indices.flat<int>().data(), num_segments,
+                       num_boxes));
+
+    // Select the boxes of every segment.
+    const int num_candidates = num_classes * size_per_class;
+    Tensor selected_boxes, selected_scores, selected_box_indices,
+        num_selected_per_class;
+    OP_REQUIRES_OK(context,
+                   context->allocate_temp(
+                       DT_FLOAT, TensorShape({num_images, num_candidates, 4}),
+                       &selected_boxes));
+    OP_REQUIRES_OK(context, context->allocate_temp(
+                                DT_FLOAT,
+                                TensorShape({num_images, num_candidates}),
+                                &selected_scores));
+    OP_REQUIRES_OK(context, context->allocate_temp(
+                                DT_INT32,
+                                TensorShape({num_images, num_candidates}),
+                                &selected_box_indices));
+    OP_REQUIRES_OK(context, context->allocate_temp(
+                                DT_INT32, TensorShape({num_segments}),
+                                &num_selected_per_class));
+    const Box* input_boxes =
+        reinterpret_cast<const Box*>(boxes.flat<float>().data());
+    OP_REQUIRES_OK(
+        context,
+        GpuLaunchKernel(
+            CombinedNmsKernel, num_segments, kCombinedNmsTileSize, 0,
+            device.stream(), input_boxes, num_boxes, q, num_classes,
+            sorted_scores.flat<float>().data(),
+            sorted_box_indices.flat<int>().data(), iou_threshold_val,
+            score_threshold_val, size_per_class,
+            reinterpret_cast<Box*>(selected_boxes.flat<float>().data()),
+            selected_scores.flat<float>().data(),
+            selected_box_indices.flat<int>().data(),
+            num_selected_per_class.flat<int>().data()));
+
+    // Sort the selected boxes of every image by decreasing score.
+    Tensor candidates, sorted_selected_scores, sorted_candidates;
+    OP_REQUIRES_OK(context,
+                   context->allocate_temp(
+                       DT_INT32, TensorShape({num_images * num_candidates}),
+                       &candidates));
+    OP_REQUIRES_OK(context,
+                   context->allocate_temp(
+                       DT_FLOAT, TensorShape({num_images * num_candidates}),
+                       &sorted_selected_scores));
+    OP_REQUIRES_OK(context,
+                   context->allocate_temp(
+                       DT_INT32, TensorShape({num_images * num_candidates}),
+                       &sorted_candidates));
+    config = GetGpuLaunchConfig(num_images * num_candidates, device);
+    OP_REQUIRES_OK(
+        context,
+        GpuLaunchKernel(CombinedNmsCandidates, config.block_count,
+                        config.thread_per_block, 0, device.stream(),
+                        num_images * num_candidates, num_candidates,
+                        candidates.flat<int>().data()));
+    OP_REQUIRES_OK(context,
+                   SegmentedSortPairsDescending(
+                       context, selected_scores.flat<float>().data(),
+                       sorted_selected_scores.flat<float>().data(),
+                       candidates.flat<int>().data(),
+                       sorted_candidates.flat<int>().data(), num_images,
+                       num_candidates));
+
+    config = GetGpuLaunchConfig(num_images, device);
+    OP_REQUIRES_OK(
+        context,
+        GpuLaunchKernel(CombinedNmsCountDetections, config.block_count,
+                        config.thread_per_block, 0, device.stream(),
+                        num_images, num_classes,
+                        num_selected_per_class.flat<int>().data(),
+                        per_batch_size, valid_detections->flat<int>().data()));
+    const int num_detections = num_images * per_batch_size;
+    config = GetGpuLaunchConfig(num_detections, device);
+    OP_REQUIRES_OK(
+        context,
+        GpuLaunchKernel(
+            CombinedNmsGatherDetections, config.block_count,
+            config.thread_per_block, 0, device.stream(), num_detections,
+            per_batch_size, num_classes, size_per_class, input_boxes,
+            num_boxes, q, sorted_selected_scores.flat<float>().data(),
+            sorted_candidates.flat<int>().data(),
+            selected_box_indices.flat<int>().data(),
+            valid_detections->flat<int>().data(), clip_boxes_,
+            nmsed_boxes->flat<float>().data(),
+            nmsed_scores->flat<float>().data(),
+            nmsed_classes->flat<float>().data()));
+  }
+
+ private:
+  bool pad_per_class_;
+  bool clip_boxes_;
+};
+
 REGISTER_KERNEL_BUILDER(Name("NonMaxSuppressionV2")
                             .TypeConstraint<float>("T")
                             .Device(DEVICE_GPU)
@@ -742,5 +1222,13 @@ REGISTER_KERNEL_BUILDER(Name("NonMaxSuppressionV4")
                             .HostMemory("score_threshold"),
                         NonMaxSuppressionV4GPUOp);
 
+REGISTER_KERNEL_BUILDER(Name("CombinedNonMaxSuppression")
+                            .Device(DEVICE_GPU)
+                            .HostMemory("max_output_size_per_class")
+                            .HostMemory("max_total_size")
+                            .HostMemory("iou_threshold")
+                            .HostMemory("score_threshold"),
+                        CombinedNonMaxSuppressionGPUOp);
+
 }  // namespace tensorflow
 #endif
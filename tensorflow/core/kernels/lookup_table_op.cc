@@ -16,25 +16,225 @@ limitations under the License.
 #include "tensorflow/core/kernels/lookup_table_op.h"
 #define EIGEN_USE_THREADS
 
+#include <algorithm>
 #include <string>
 #include <type_traits>
+#include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/variant.h"
 #include "tensorflow/core/kernels/initializable_lookup_table.h"
+#include "tensorflow/core/kernels/memmapped_lookup_table.h"
+#include "tensorflow/core/lib/gtl/array_slice.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 namespace lookup {
 
+namespace {
+
+template <typename T>
+inline uint64 HashScalar(const T& key) {
+  return static_cast<uint64>(key);
+}
+
+inline uint64 HashScalar(const tstring& key) { return Hash64(key); }
+
+// If the given shape is a scalar return {1} instead. Otherwise leave it alone.
+TensorShape MaybeVectorizeShape(const TensorShape& shape) {
+  if (shape.dims() == 0) {
+    return TensorShape({1});
+  }
+  return shape;
+}
+
+// An unordered_map split into kNumShards maps by the hash of the keys, each
+// guarded by its own mutex. Lookups and updates of keys in different shards
+// do not contend, and a rehash only blocks the keys of the shard that grows.
+//
+// A batch of keys is grouped by shard first, so that every shard it touches is
+// locked once per batch rather than once per key. Large batches process their
+// shards in parallel on the intra-op threads.
+template <class K, class V>
+class ShardedHashMap {
+ public:
+  typedef std::unordered_map<K, V> Map;
+
+  size_t size() const {
+    size_t size = 0;
+    for (const MapShard& shard : shards_) {
+      tf_shared_lock l(shard.mu);
+      size += shard.map.size();
+    }
+    return size;
+  }
+
+  // Number of buckets in use, counting empty buckets as one entry.
+  int64 BucketMemory() const {
+    int64 ret = 0;
+    for (const MapShard& shard : shards_) {
+      tf_shared_lock l(shard.mu);
+      for (unsigned i = 0; i < shard.map.bucket_count(); ++i) {
+        size_t bucket_size = shard.map.bucket_size(i);
+        if (bucket_size == 0) {
+          ret++;
+        } else {
+          ret += bucket_size;
+        }
+      }
+    }
+    return ret;
+  }
+
+  // Calls fn(map, i) for every index i of `keys`, where map is the shard of
+  // keys(i) and is held under a shared lock.
+  template <typename Fn>
+  void ReadBatch(OpKernelContext* ctx, typename TTypes<K>::ConstFlat keys,
+                 Fn fn) const {
+    ForEachShardOfBatch(
+        ctx, keys, [this, &fn](int s, const int64* begin, const int64* end) {
+          const MapShard& shard = shards_[s];
+          tf_shared_lock l(shard.mu);
+          for (const int64* i = begin; i != end; ++i) {
+            fn(shard.map, *i);
+          }
+        });
+  }
+
+  // Calls fn(&map, i) for every index i of `keys`, where map is the shard of
+  // keys(i) and is held under an exclusive lock. Indices of one shard are
+  // visited in increasing order, so the last of duplicate keys wins.
+  template <typename Fn>
+  void WriteBatch(OpKernelContext* ctx, typename TTypes<K>::ConstFlat keys,
+                  Fn fn) {
+    ForEachShardOfBatch(
+        ctx, keys, [this, &fn](int s, const int64* begin, const int64* end) {
+          MapShard& shard = shards_[s];
+          mutex_lock l(shard.mu);
+          for (const int64* i = begin; i != end; ++i) {
+            fn(&shard.map, *i);
+          }
+        });
+  }
+
+  // Clears the map and then calls fn(&map, i) for every index i of `keys`,
+  // holding the locks of all shards throughout so that no reader observes a
+  // partially replaced map.
+  template <typename Fn>
+  void Replace(typename TTypes<K>::ConstFlat keys, Fn fn)
+      TF_NO_THREAD_SAFETY_ANALYSIS {
+    for (MapShard& shard : shards_) {
+      shard.mu.lock();
+    }
+    for (MapShard& shard : shards_) {
+      shard.map.clear();
+    }
+    for (int64 i = 0; i < keys.size(); ++i) {
+      fn(&shards_[ShardOf(keys(i))].map, i);
+    }
+    for (MapShard& shard : shards_) {
+      shard.mu.unlock();
+    }
+  }
+
+  // Calls fn(maps) with the maps of all shards, holding a shared lock on every
+  // shard so that fn observes a consistent snapshot.
+  template <typename Fn>
+  Status ReadAll(Fn fn) const TF_NO_THREAD_SAFETY_ANALYSIS {
+    gtl::InlinedVector<const Map*, kNumShards> maps;
+    for (const MapShard& shard : shards_) {
+      shard.mu.lock_shared();
+      maps.push_back(&shard.map);
+    }
+    Status s = fn(maps);
+    for (const MapShard& shard : shards_) {
+      shard.mu.unlock_shared();
+    }
+    return s;
+  }
+
+ private:
+  static constexpr int kShardBits = 5;
+  static constexpr int kNumShards = 1 << kShardBits;
+  // Batches with fewer keys are processed on the calling thread.
+  static constexpr int64 kMinParallelBatchSize = 8192;
+
+  struct MapShard {
+    mutable mutex mu;
+    Map map TF_GUARDED_BY(mu);
+  };
+
+  static int ShardOf(const K& key) {
+    // Mixes the hash so that integer keys, which hash to themselves, spread
+    // over the shards.
+    return (HashScalar(key) * 0x9E3779B97F4A7C15ull) >> (64 - kShardBits);
+  }
+
+  // Calls fn(s, begin, end) for every shard s with keys in the batch, where
+  // [begin, end) are the increasing indices of the keys in shard s.
+  template <typename Fn>
+  static void ForEachShardOfBatch(OpKernelContext* ctx,
+                                  typename TTypes<K>::ConstFlat keys, Fn fn) {
+    const int64 num_keys = keys.size();
+    if (num_keys == 0) {
+      return;
+    }
+    if (num_keys == 1) {
+      const int64 index = 0;
+      fn(ShardOf(keys(0)), &index, &index + 1);
+      return;
+    }
+
+    // Counting sort of the indices by shard.
+    std::vector<uint8> key_shards(num_keys);
+    int64 offsets[kNumShards + 1] = {};
+    for (int64 i = 0; i < num_keys; ++i) {
+      key_shards[i] = ShardOf(SubtleMustCopyIfIntegral(keys(i)));
+      ++offsets[key_shards[i] + 1];
+    }
+    for (int s = 0; s < kNumShards; ++s) {
+      offsets[s + 1] += offsets[s];
+    }
+    std::vector<int64> order(num_keys);
+    int64 next[kNumShards];
+    std::copy(offsets, offsets + kNumShards, next);
+    for (int64 i = 0; i < num_keys; ++i) {
+      order[next[key_shards[i]]++] = i;
+    }
+
+    auto process_shards = [&](int64 first, int64 last) {
+      for (int64 s = first; s < last; ++s) {
+        if (offsets[s] < offsets[s + 1]) {
+          fn(s, order.data() + offsets[s], order.data() + offsets[s + 1]);
+        }
+      }
+    };
+    if (ctx != nullptr && num_keys >= kMinParallelBatchSize) {
+      auto worker_threads = ctx->device()->tensorflow_cpu_worker_threads();
+      Shard(worker_threads->num_threads, worker_threads->workers, kNumShards,
+            /*cost_per_unit=*/50 * num_keys / kNumShards, process_shards);
+    } else {
+      process_shards(0, kNumShards);
+    }
+  }
+
+  MapShard shards_[kNumShards];
+};
+
+}  // namespace
+
 // Lookup table that wraps an unordered_map, where the key and value data type
 // is specified. Each individual value must be a scalar. If vector values are
 // required, use MutableHashTableOfTensors.
 //
 // This table is mutable and thread safe - Insert can be called at any time.
+// The map is sharded by key, so concurrent lookups and updates only contend
+// when they touch the same shard.
 //
 // Sample use case:
 //
@@ -49,10 +249,7 @@ class MutableHashTableOfScalars final : public LookupInterface {
  public:
   MutableHashTableOfScalars(OpKernelContext* ctx, OpKernel* kernel) {}
 
-  size_t size() const override {
-    tf_shared_lock l(mu_);
-    return table_.size();
-  }
+  size_t size() const override { return table_.size(); }
 
   Status Find(OpKernelContext* ctx, const Tensor& key, Tensor* value,
               const Tensor& default_value) override {
@@ -60,69 +257,75 @@ class MutableHashTableOfScalars final : public LookupInterface {
     const auto key_values = key.flat<K>();
     auto value_values = value->flat<V>();
 
-    tf_shared_lock l(mu_);
-    for (int64 i = 0; i < key_values.size(); ++i) {
+    table_.ReadBatch(ctx, key_values, [&](const Map& map, int64 i) {
       value_values(i) = gtl::FindWithDefault(
-          table_, SubtleMustCopyIfIntegral(key_values(i)), default_val);
-    }
+          map, SubtleMustCopyIfIntegral(key_values(i)), default_val);
+    });
 
     return Status::OK();
   }
 
-  Status DoInsert(bool clear, const Tensor& keys, const Tensor& values) {
+  Status DoInsert(OpKernelContext* ctx, bool clear, const Tensor& keys,
+                  const Tensor& values) {
     const auto key_values = keys.flat<K>();
     const auto value_values = values.flat<V>();
 
-    mutex_lock l(mu_);
-    if (clear) {
-      table_.clear();
-    }
-    for (int64 i = 0; i < key_values.size(); ++i) {
-      gtl::InsertOrUpdate(&table_, SubtleMustCopyIfIntegral(key_values(i)),
+    auto insert = [&](Map* map, int64 i) {
+      gtl::InsertOrUpdate(map, SubtleMustCopyIfIntegral(key_values(i)),
                           SubtleMustCopyIfIntegral(value_values(i)));
+    };
+    if (clear) {
+      table_.Replace(key_values, insert);
+    } else {
+      table_.WriteBatch(ctx, key_values, insert);
     }
     return Status::OK();
   }
 
   Status Insert(OpKernelContext* ctx, const Tensor& keys,
                 const Tensor& values) override {
-    return DoInsert(false, keys, values);
+    return DoInsert(ctx, false, keys, values);
   }
 
   Status Remove(OpKernelContext* ctx, const Tensor& keys) override {
     const auto key_values = keys.flat<K>();
 
-    mutex_lock l(mu_);
-    for (int64 i = 0; i < key_values.size(); ++i) {
-      table_.erase(SubtleMustCopyIfIntegral(key_values(i)));
-    }
+    table_.WriteBatch(ctx, key_values, [&](Map* map, int64 i) {
+      map->erase(SubtleMustCopyIfIntegral(key_values(i)));
+    });
     return Status::OK();
   }
 
   Status ImportValues(OpKernelContext* ctx, const Tensor& keys,
                       const Tensor& values) override {
-    return DoInsert(true, keys, values);
+    return DoInsert(ctx, true, keys, values);
   }
 
   Status ExportValues(OpKernelContext* ctx) override {
-    tf_shared_lock l(mu_);
-    int64 size = table_.size();
-
-    Tensor* keys;
-    Tensor* values;
-    TF_RETURN_IF_ERROR(
-        ctx->allocate_output("keys", TensorShape({size}), &keys));
-    TF_RETURN_IF_ERROR(
-        ctx->allocate_output("values", TensorShape({size}), &values));
+    return table_.ReadAll([ctx](gtl::ArraySlice<const Map*> maps) {
+      int64 size = 0;
+      for (const Map* map : maps) {
+        size += map->size();
+      }
 
-    auto keys_data = keys->flat<K>();
-    auto values_data = values->flat<V>();
-    int64 i = 0;
-    for (auto it = table_.begin(); it != table_.end(); ++it, ++i) {
-      keys_data(i) = it->first;
-      values_data(i) = it->second;
-    }
-    return Status::OK();
+      Tensor* keys;
+      Tensor* values;
+      TF_RETURN_IF_ERROR(
+          ctx->allocate_output("keys", TensorShape({size}), &keys));
+      TF_RETURN_IF_ERROR(
+          ctx->allocate_output("values", TensorShape({size}), &values));
+
+      auto keys_data = keys->flat<K>();
+      auto values_data = values->flat<V>();
+      int64 i = 0;
+      for (const Map* map : maps) {
+        for (auto it = map->begin(); it != map->end(); ++it, ++i) {
+          keys_data(i) = it->first;
+          values_data(i) = it->second;
+        }
+      }
+      return Status::OK();
+    });
   }
 
   DataType key_dtype() const override { return DataTypeToEnum<K>::v(); }
@@ -134,22 +337,12 @@ class MutableHashTableOfScalars final : public LookupInterface {
   TensorShape value_shape() const override { return TensorShape(); }
 
   int64 MemoryUsed() const override {
-    int64 ret = 0;
-    tf_shared_lock l(mu_);
-    for (unsigned i = 0; i < table_.bucket_count(); ++i) {
-      size_t bucket_size = table_.bucket_size(i);
-      if (bucket_size == 0) {
-        ret++;
-      } else {
-        ret += bucket_size;
-      }
-    }
-    return sizeof(MutableHashTableOfScalars) + ret;
+    return sizeof(MutableHashTableOfScalars) + table_.BucketMemory();
   }
 
  private:
-  mutable mutex mu_;
-  std::unordered_map<K, V> table_ TF_GUARDED_BY(mu_);
+  typedef typename ShardedHashMap<K, V>::Map Map;
+  ShardedHashMap<K, V> table_;
 };
 
 // Lookup table that wraps an unordered_map. Behaves identical to
@@ -166,10 +359,7 @@ class MutableHashTableOfTensors final : public LookupInterface {
                                 value_shape_.DebugString()));
   }
 
-  size_t size() const override {
-    tf_shared_lock l(mu_);
-    return table_.size();
-  }
+  size_t size() const override { return table_.size(); }
 
   Status Find(OpKernelContext* ctx, const Tensor& key, Tensor* value,
               const Tensor& default_value) override {
@@ -178,10 +368,9 @@ class MutableHashTableOfTensors final : public LookupInterface {
     auto value_values = value->flat_inner_dims<V, 2>();
     int64 value_dim = value_shape_.dim_size(0);
 
-    tf_shared_lock l(mu_);
-    for (int64 i = 0; i < key_values.size(); ++i) {
-      ValueArray* value_vec =
-          gtl::FindOrNull(table_, SubtleMustCopyIfIntegral(key_values(i)));
+    table_.ReadBatch(ctx, key_values, [&](const Map& map, int64 i) {
+      const ValueArray* value_vec =
+          gtl::FindOrNull(map, SubtleMustCopyIfIntegral(key_values(i)));
       if (value_vec != nullptr) {
         for (int64 j = 0; j < value_dim; j++) {
           value_values(i, j) = value_vec->at(j);
@@ -191,76 +380,82 @@ class MutableHashTableOfTensors final : public LookupInterface {
           value_values(i, j) = default_flat(j);
         }
       }
-    }
+    });
 
     return Status::OK();
   }
 
-  Status DoInsert(bool clear, const Tensor& keys, const Tensor& values) {
+  Status DoInsert(OpKernelContext* ctx, bool clear, const Tensor& keys,
+                  const Tensor& values) {
     const auto key_values = keys.flat<K>();
     const auto value_values = values.flat_inner_dims<V, 2>();
     int64 value_dim = value_shape_.dim_size(0);
 
-    mutex_lock l(mu_);
-    if (clear) {
-      table_.clear();
-    }
-    for (int64 i = 0; i < key_values.size(); ++i) {
+    auto insert = [&](Map* map, int64 i) {
       ValueArray value_vec;
       for (int64 j = 0; j < value_dim; j++) {
         V value = value_values(i, j);
         value_vec.push_back(value);
       }
-      gtl::InsertOrUpdate(&table_, SubtleMustCopyIfIntegral(key_values(i)),
+      gtl::InsertOrUpdate(map, SubtleMustCopyIfIntegral(key_values(i)),
                           value_vec);
+    };
+    if (clear) {
+      table_.Replace(key_values, insert);
+    } else {
+      table_.WriteBatch(ctx, key_values, insert);
     }
     return Status::OK();
   }
 
   Status Insert(OpKernelContext* ctx, const Tensor& keys,
                 const Tensor& values) override {
-    return DoInsert(false, keys, values);
+    return DoInsert(ctx, false, keys, values);
   }
 
   Status Remove(OpKernelContext* ctx, const Tensor& keys) override {
     const auto key_values = keys.flat<K>();
 
-    mutex_lock l(mu_);
-    for (int64 i = 0; i < key_values.size(); ++i) {
-      table_.erase(SubtleMustCopyIfIntegral(key_values(i)));
-    }
+    table_.WriteBatch(ctx, key_values, [&](Map* map, int64 i) {
+      map->erase(SubtleMustCopyIfIntegral(key_values(i)));
+    });
     return Status::OK();
   }
 
   Status ImportValues(OpKernelContext* ctx, const Tensor& keys,
                       const Tensor& values) override {
-    return DoInsert(true, keys, values);
+    return DoInsert(ctx, true, keys, values);
   }
 
   Status ExportValues(OpKernelContext* ctx) override {
-    tf_shared_lock l(mu_);
-    int64 size = table_.size();
     int64 value_dim = value_shape_.dim_size(0);
+    return table_.ReadAll([ctx, value_dim](gtl::ArraySlice<const Map*> maps) {
+      int64 size = 0;
+      for (const Map* map : maps) {
+        size += map->size();
+      }
 
-    Tensor* keys;
-    Tensor* values;
-    TF_RETURN_IF_ERROR(
-        ctx->allocate_output("keys", TensorShape({size}), &keys));
-    TF_RETURN_IF_ERROR(ctx->allocate_output(
-        "values", TensorShape({size, value_dim}), &values));
-
-    auto keys_data = keys->flat<K>();
-    auto values_data = values->matrix<V>();
-    int64 i = 0;
-    for (auto it = table_.begin(); it != table_.end(); ++it, ++i) {
-      K key = it->first;
-      ValueArray value = it->second;
-      keys_data(i) = key;
-      for (int64 j = 0; j < value_dim; j++) {
-        values_data(i, j) = value[j];
+      Tensor* keys;
+      Tensor* values;
+      TF_RETURN_IF_ERROR(
+          ctx->allocate_output("keys", TensorShape({size}), &keys));
+      TF_RETURN_IF_ERROR(ctx->allocate_output(
+          "values", TensorShape({size, value_dim}), &values));
+
+      auto keys_data = keys->flat<K>();
+      auto values_data = values->matrix<V>();
+      int64 i = 0;
+      for (const Map* map : maps) {
+        for (auto it = map->begin(); it != map->end(); ++it, ++i) {
+          keys_data(i) = it->first;
+          const ValueArray& value = it->second;
+          for (int64 j = 0; j < value_dim; j++) {
+            values_data(i, j) = value[j];
+          }
+        }
       }
-    }
-    return Status::OK();
+      return Status::OK();
+    });
   }
 
   DataType key_dtype() const override { return DataTypeToEnum<K>::v(); }
@@ -272,44 +467,16 @@ class MutableHashTableOfTensors final : public LookupInterface {
   TensorShape value_shape() const override { return value_shape_; }
 
   int64 MemoryUsed() const override {
-    int64 ret = 0;
-    tf_shared_lock l(mu_);
-    for (unsigned i = 0; i < table_.bucket_count(); ++i) {
-      size_t bucket_size = table_.bucket_size(i);
-      if (bucket_size == 0) {
-        ret++;
-      } else {
-        ret += bucket_size;
-      }
-    }
-    return sizeof(MutableHashTableOfTensors) + ret;
+    return sizeof(MutableHashTableOfTensors) + table_.BucketMemory();
   }
 
  private:
-  TensorShape value_shape_;
-  mutable mutex mu_;
   typedef gtl::InlinedVector<V, 4> ValueArray;
-  std::unordered_map<K, ValueArray> table_ TF_GUARDED_BY(mu_);
-};
-
-namespace {
-
-template <typename T>
-inline uint64 HashScalar(const T& key) {
-  return static_cast<uint64>(key);
-}
-
-inline uint64 HashScalar(const tstring& key) { return Hash64(key); }
-
-// If the given shape is a scalar return {1} instead. Otherwise leave it alone.
-TensorShape MaybeVectorizeShape(const TensorShape& shape) {
-  if (shape.dims() == 0) {
-    return TensorShape({1});
-  }
-  return shape;
-}
+  typedef typename ShardedHashMap<K, ValueArray>::Map Map;
 
-}  // namespace
+  TensorShape value_shape_;
+  ShardedHashMap<K, ValueArray> table_;
+};
 
 // Modeled after densehashtable in https://github.com/sparsehash/sparsehash
 template <class K, class V>
@@ -776,6 +943,99 @@ class MutableDenseHashTable final : public LookupInterface {
   uint64 deleted_key_hash_;
 };
 
+// Lookup table backed by a MemmappedTableData. Lookups binary search the sorted
+// keys. The table cannot be modified.
+template <class K, class V>
+class MemmappedTable final : public LookupInterface {
+ public:
+  MemmappedTable(OpKernelContext* ctx, OpKernel* kernel) {
+    string filename;
+    OP_REQUIRES_OK(ctx, GetNodeAttr(kernel->def(), "filename", &filename));
+    OP_REQUIRES_OK(ctx, MemmappedTableData::Get(
+                            ctx->env(), filename, DataTypeToEnum<K>::v(),
+                            DataTypeToEnum<V>::v(), &data_));
+  }
+
+  size_t size() const override { return data_->size(); }
+
+  Status Find(OpKernelContext* ctx, const Tensor& key, Tensor* value,
+              const Tensor& default_value) override {
+    const V default_val = default_value.flat<V>()(0);
+    const auto key_values = key.flat<K>();
+    auto value_values = value->flat<V>();
+
+    for (int64 i = 0; i < key_values.size(); ++i) {
+      const Key k = SubtleMustCopyIfIntegral(key_values(i));
+      int64 lo = 0;
+      int64 hi = data_->size();
+      while (lo < hi) {
+        const int64 mid = lo + (hi - lo) / 2;
+        if (data_->key<K>(mid) < k) {
+          lo = mid + 1;
+        } else {
+          hi = mid;
+        }
+      }
+      if (lo < data_->size() && data_->key<K>(lo) == k) {
+        value_values(i) = data_->value<V>(lo);
+      } else {
+        value_values(i) = default_val;
+      }
+    }
+    return Status::OK();
+  }
+
+  Status Insert(OpKernelContext* ctx, const Tensor& keys,
+                const Tensor& values) override {
+    return errors::Unimplemented("MemmappedTable is read-only.");
+  }
+
+  Status Remove(OpKernelContext* ctx, const Tensor& keys) override {
+    return errors::Unimplemented("MemmappedTable is read-only.");
+  }
+
+  Status ImportValues(OpKernelContext* ctx, const Tensor& keys,
+                      const Tensor& values) override {
+    return errors::Unimplemented("MemmappedTable is read-only.");
+  }
+
+  Status ExportValues(OpKernelContext* ctx) override {
+    const int64 size = data_->size();
+
+    Tensor* keys;
+    Tensor* values;
+    TF_RETURN_IF_ERROR(
+        ctx->allocate_output("keys", TensorShape({size}), &keys));
+    TF_RETURN_IF_ERROR(
+        ctx->allocate_output("values", TensorShape({size}), &values));
+
+    auto keys_data = keys->flat<K>();
+    auto values_data = values->flat<V>();
+    for (int64 i = 0; i < size; ++i) {
+      keys_data(i) = data_->key<K>(i);
+      values_data(i) = data_->value<V>(i);
+    }
+    return Status::OK();
+  }
+
+  DataType key_dtype() const override { return DataTypeToEnum<K>::v(); }
+
+  DataType value_dtype() const override { return DataTypeToEnum<V>::v(); }
+
+  TensorShape key_shape() const final { return TensorShape(); }
+
+  TensorShape value_shape() const override { return TensorShape(); }
+
+  // The mapped file is shared with the other tables of the file and is not
+  // counted.
+  int64 MemoryUsed() const override { return sizeof(MemmappedTable); }
+
+ private:
+  typedef MemmappedTableData::ElementType<K> Key;
+
+  std::shared_ptr<const MemmappedTableData> data_;
+};
+
 }  // namespace lookup
 
 // Base class for kernels that take a LookupTable handle as the 0th input.
@@ -974,6 +1234,35 @@ REGISTER_KERNEL_BUILDER(Name("LookupTableImport").Device(DEVICE_CPU),
 REGISTER_KERNEL_BUILDER(Name("LookupTableImportV2").Device(DEVICE_CPU),
                         LookupTableImportOp);
 
+// Writes keys and values to a file that MemmappedTableV2 can map.
+class WriteMemmappedTableOp : public OpKernel {
+ public:
+  using OpKernel::OpKernel;
+
+  void Compute(OpKernelContext* ctx) override {
+    const Tensor& filename = ctx->input(0);
+    OP_REQUIRES(ctx, TensorShapeUtils::IsScalar(filename.shape()),
+                errors::InvalidArgument("filename must be a scalar, got shape ",
+                                        filename.shape().DebugString()));
+    const Tensor& keys = ctx->input(1);
+    const Tensor& values = ctx->input(2);
+    OP_REQUIRES(ctx, TensorShapeUtils::IsVector(keys.shape()),
+                errors::InvalidArgument("keys must be a vector, got shape ",
+                                        keys.shape().DebugString()));
+    OP_REQUIRES(ctx, keys.shape() == values.shape(),
+                errors::InvalidArgument(
+                    "keys and values must have the same shape, got ",
+                    keys.shape().DebugString(), " and ",
+                    values.shape().DebugString()));
+    OP_REQUIRES_OK(ctx, lookup::WriteMemmappedTable(
+                            ctx->env(), filename.scalar<tstring>()(), keys,
+                            values));
+  }
+};
+
+REGISTER_KERNEL_BUILDER(Name("WriteMemmappedTable").Device(DEVICE_CPU),
+                        WriteMemmappedTableOp);
+
 // Register the HashTable op with the currently supported key and value types.
 #define REGISTER_KERNEL(key_dtype, value_dtype)                           \
   REGISTER_KERNEL_BUILDER(                                                \
@@ -1111,4 +1400,27 @@ REGISTER_KERNEL(tstring, ResourceHandle);
 
 #undef REGISTER_KERNEL
 
+// Register the MemmappedTable op.
+#define REGISTER_KERNEL(key_dtype, value_dtype)                     \
+  REGISTER_KERNEL_BUILDER(                                          \
+      Name("MemmappedTableV2")                                      \
+          .Device(DEVICE_CPU)                                       \
+          .TypeConstraint<key_dtype>("key_dtype")                   \
+          .TypeConstraint<value_dtype>("value_dtype"),              \
+      LookupTableOp<lookup::MemmappedTable<key_dtype, value_dtype>, \
+                    key_dtype, value_dtype>)
+
+REGISTER_KERNEL(int64, double);
+REGISTER_KERNEL(int64, float);
+REGISTER_KERNEL(int64, int32);
+REGISTER_KERNEL(int64, int64);
+REGISTER_KERNEL(int64, tstring);
+REGISTER_KERNEL(tstring, double);
+REGISTER_KERNEL(tstring, float);
+REGISTER_KERNEL(tstring, int32);
+REGISTER_KERNEL(tstring, int64);
+REGISTER_KERNEL(tstring, tstring);
+
+#undef REGISTER_KERNEL
+
 }  // namespace tensorflow
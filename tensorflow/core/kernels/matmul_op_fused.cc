@@ -92,6 +92,12 @@ struct LaunchFusedMatMulOp<CPUDevice, T> {
         out.device(d) =
             lhs.contract(rhs, dim_pair, WithBiasAddAndElu<T>(bias_add_args));
         break;
+      case FusedComputationType::kBiasAddWithElementwiseChain:
+        out.device(d) = lhs.contract(
+            rhs, dim_pair,
+            WithBiasAddAndElementwiseChain<T>(bias_add_args,
+                                              fusion_args.elementwise_chain));
+        break;
       case FusedComputationType::kUndefined:
         OP_REQUIRES_OK(context, errors::Internal("Fusion type is undefined"));
         break;
@@ -116,7 +122,8 @@ class FusedMatMulOp : public OpKernel {
       patterns = {{FCT::kBiasAdd, {"BiasAdd"}},
                   {FCT::kBiasAddWithRelu, {"BiasAdd", "Relu"}},
                   {FCT::kBiasAddWithRelu6, {"BiasAdd", "Relu6"}},
-                  {FCT::kBiasAddWithElu, {"BiasAdd", "Elu"}}};
+                  {FCT::kBiasAddWithElu, {"BiasAdd", "Elu"}},
+                  {FCT::kBiasAddWithElementwiseChain, {"BiasAdd"}}};
     }
 
     OP_REQUIRES_OK(context, InitializeFusedComputation(
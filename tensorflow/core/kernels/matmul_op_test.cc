@@ -143,6 +143,52 @@ class FusedMatMulOpTest : public OpsTestBase {
     RunAndFetch(root, "with_activation", output, allow_gpu_device);
   }
 
+  void RunMatMulWithBiasAndElementwiseChain(
+      const Tensor& lhs_data, const Tensor& rhs_data, const Tensor& bias_data,
+      bool transpose_a, bool transpose_b,
+      const std::vector<string>& elementwise_chain, Tensor* output) {
+    Scope root = tensorflow::Scope::NewRootScope();
+
+    ops::MatMul matmul = ops::MatMul(
+        root.WithOpName("matmul"),
+        ops::Const(root.WithOpName("lhs"), Input::Initializer(lhs_data)),
+        ops::Const(root.WithOpName("rhs"), Input::Initializer(rhs_data)),
+        ops::MatMul::Attrs().TransposeA(transpose_a).TransposeB(transpose_b));
+
+    Output result = ops::BiasAdd(
+        root.WithOpName("with_bias"), matmul,
+        ops::Const(root.WithOpName("bias"), Input::Initializer(bias_data)));
+
+    for (size_t i = 0; i < elementwise_chain.size(); ++i) {
+      const string& op = elementwise_chain[i];
+      Scope scope = root.WithOpName(absl::StrCat("elementwise", i));
+      if (op == "Abs") {
+        result = ops::Abs(scope, result);
+      } else if (op == "Exp") {
+        result = ops::Exp(scope, result);
+      } else if (op == "Log") {
+        result = ops::Log(scope, result);
+      } else if (op == "Neg") {
+        result = ops::Neg(scope, result);
+      } else if (op == "Sigmoid") {
+        result = ops::Sigmoid(scope, result);
+      } else if (op == "Sqrt") {
+        result = ops::Sqrt(scope, result);
+      } else if (op == "Square") {
+        result = ops::Square(scope, result);
+      } else if (op == "Tanh") {
+        result = ops::Tanh(scope, result);
+      } else {
+        FAIL() << "Unsupported element-wise op: " << op;
+      }
+    }
+
+    ops::Identity(root.WithOpName("with_elementwise_chain"), result);
+
+    RunAndFetch(root, "with_elementwise_chain", output,
+                /*allow_gpu_device=*/false);
+  }
+
   void RunFusedMatMulOp(const Tensor& lhs_data, const Tensor& rhs_data,
                         const std::vector<Tensor>& args_data,
                         const std::vector<string>& fused_ops, bool transpose_a,
@@ -256,6 +302,35 @@ class FusedMatMulOpTest : public OpsTestBase {
 
     VerifyBiasAddTensorsNear(m, k, n, run_default, run_fused);
   }
+
+  // Verifies that computing MatMul+BiasAdd+<Op>+...+<Op> in a graph is
+  // identical to FusedMatMul.
+  void VerifyMatMulWithBiasAndElementwiseChain(
+      int m, int k, int n, bool transpose_a, bool transpose_b,
+      const std::vector<string>& elementwise_chain) {
+    const BiasAddGraphRunner run_default = [&](const Tensor& input_data,
+                                               const Tensor& filter_data,
+                                               const Tensor& bias_data,
+                                               Tensor* out) {
+      RunMatMulWithBiasAndElementwiseChain(input_data, filter_data, bias_data,
+                                           transpose_a, transpose_b,
+                                           elementwise_chain, out);
+    };
+
+    std::vector<string> fused_ops = {"BiasAdd"};
+    fused_ops.insert(fused_ops.end(), elementwise_chain.begin(),
+                     elementwise_chain.end());
+
+    const BiasAddGraphRunner run_fused = [&](const Tensor& input_data,
+                                             const Tensor& filter_data,
+                                             const Tensor& bias_data,
+                                             Tensor* out) {
+      RunFusedMatMulOp(input_data, filter_data, {bias_data}, fused_ops,
+                       transpose_a, transpose_b, out);
+    };
+
+    VerifyBiasAddTensorsNear(m, k, n, run_default, run_fused);
+  }
 };
 
 // MatMul with BatchNorm can be tested only with `T=float`, because default
@@ -323,6 +398,20 @@ TYPED_TEST_P(FusedMatMulWithBiasOpTest, MatMul1x256x1WithActivation) {
   }
 }
 
+TYPED_TEST_P(FusedMatMulWithBiasOpTest, MatMul256x256x256WithElementwiseChain) {
+  const std::vector<std::vector<string>> elementwise_chains = {
+      {"Tanh", "Square", "Neg"},
+      {"Sigmoid", "Sqrt", "Log"},
+      {"Abs", "Neg", "Exp"},
+  };
+  for (const std::vector<string>& elementwise_chain : elementwise_chains) {
+    this->VerifyMatMulWithBiasAndElementwiseChain(256, 256, 256, false, false,
+                                                  elementwise_chain);
+    this->VerifyMatMulWithBiasAndElementwiseChain(256, 256, 256, true, true,
+                                                  elementwise_chain);
+  }
+}
+
 REGISTER_TYPED_TEST_SUITE_P(FusedMatMulWithBiasOpTest,        //
                             MatMul256x256x256,                //
                             MatMul1x256x256,                  //
@@ -331,7 +420,8 @@ REGISTER_TYPED_TEST_SUITE_P(FusedMatMulWithBiasOpTest,        //
                             MatMul256x256x256WithActivation,  //
                             MatMul1x256x256WithActivation,    //
                             MatMul256x256x1WithActivation,    //
-                            MatMul1x256x1WithActivation);
+                            MatMul1x256x1WithActivation,      //
+                            MatMul256x256x256WithElementwiseChain);
 
 // TODO(ezhulenev): Add support for more data types.
 using FusedBiasAddDataTypes = ::testing::Types<float>;
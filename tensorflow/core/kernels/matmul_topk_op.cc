@@ -0,0 +1,233 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// See docs in ../ops/nn_ops.cc.
+
+#define EIGEN_USE_THREADS
+
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/gtl/top_n.h"
+#include "tensorflow/core/util/work_sharder.h"
+
+namespace tensorflow {
+
+namespace {
+
+// The number of scores computed at once by a shard, which bounds the memory
+// used for them whatever the number of items.
+constexpr int64 kScoreBlockSize = 1 << 16;
+
+// Orders (score, item) pairs by decreasing score, breaking ties in favor of
+// the lower item.
+template <typename T>
+struct ScoreGreater {
+  bool operator()(const std::pair<T, int32>& a,
+                  const std::pair<T, int32>& b) const {
+    if (b.first < a.first) {
+      return true;
+    } else if (b.first > a.first) {
+      return false;
+    } else {
+      return a.second < b.second;
+    }
+  }
+};
+
+}  // namespace
+
+// Computes TopKV2(MatMul(a, b, transpose_b=transpose_b), k). The items, the
+// columns of the product, are split into shards. Every shard computes the
+// scores of its items a block at a time and keeps the top k of every row, and
+// the candidates of the shards are merged at the end, so that the scores of
+// all items never exist at once.
+template <typename T>
+class MatMulTopKOp : public OpKernel {
+ public:
+  explicit MatMulTopKOp(OpKernelConstruction* context) : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("transpose_b", &transpose_b_));
+    OP_REQUIRES_OK(context, context->GetAttr("sorted", &sorted_));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& a_in = context->input(0);
+    const Tensor& b_in = context->input(1);
+    const Tensor& k_in = context->input(2);
+    OP_REQUIRES(context, TensorShapeUtils::IsMatrix(a_in.shape()),
+                errors::InvalidArgument("a must be a matrix, got shape ",
+                                        a_in.shape().DebugString()));
+    OP_REQUIRES(context, TensorShapeUtils::IsMatrix(b_in.shape()),
+                errors::InvalidArgument("b must be a matrix, got shape ",
+                                        b_in.shape().DebugString()));
+    OP_REQUIRES(context, TensorShapeUtils::IsScalar(k_in.shape()),
+                errors::InvalidArgument("k must be scalar, got shape ",
+                                        k_in.shape().DebugString()));
+    const int64 num_rows = a_in.dim_size(0);
+    const int64 depth = a_in.dim_size(1);
+    const int64 num_items = b_in.dim_size(transpose_b_ ? 0 : 1);
+    OP_REQUIRES(context, b_in.dim_size(transpose_b_ ? 1 : 0) == depth,
+                errors::InvalidArgument(
+                    "Matrix size-incompatible: a: ", a_in.shape().DebugString(),
+                    ", b: ", b_in.shape().DebugString(),
+                    ", transpose_b: ", transpose_b_));
+    OP_REQUIRES(context, num_items <= std::numeric_limits<int32>::max(),
+                errors::InvalidArgument(
+                    "b has too many items for int32 indices: ", num_items));
+    const int k = k_in.scalar<int32>()();
+    OP_REQUIRES(context, k >= 0,
+                errors::InvalidArgument("Need k >= 0, got ", k));
+    OP_REQUIRES(context, num_items >= k,
+                errors::InvalidArgument("b must have at least k items. Had ",
+                                        num_items, ", needed ", k));
+
+    Tensor* values_out = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(
+                                0, TensorShape({num_rows, k}), &values_out));
+    Tensor* indices_out = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(
+                                1, TensorShape({num_rows, k}), &indices_out));
+    if (k == 0 || num_rows == 0) return;
+
+    auto a = a_in.matrix<T>();
+    auto b = b_in.matrix<T>();
+    auto values = values_out->matrix<T>();
+    auto indices = indices_out->matrix<int32>();
+
+    // Blocks of items whose scores fit in kScoreBlockSize, and shards made of
+    // whole blocks, one per thread at most.
+    const int64 block_items =
+        std::max<int64>(1, std::min(num_items, kScoreBlockSize / num_rows));
+    const int64 num_blocks = Eigen::divup(num_items, block_items);
+    auto worker_threads = *(context->device()->tensorflow_cpu_worker_threads());
+    const int64 num_shards =
+        std::min<int64>(worker_threads.num_threads, num_blocks);
+    const int64 shard_items =
+        Eigen::divup(num_blocks, num_shards) * block_items;
+
+    typedef std::pair<T, int32> ScoredItem;
+    typedef gtl::TopN<ScoredItem, ScoreGreater<T>> Filter;
+    // The candidates of row r from shard s start at (s * num_rows + r) * k.
+    std::vector<ScoredItem> candidates(num_shards * num_rows * k);
+    std::vector<int32> num_candidates(num_shards * num_rows);
+
+    auto SelectShards = [&](int64 start_shard, int64 limit_shard) {
+      Eigen::array<Eigen::IndexPair<Eigen::DenseIndex>, 1> contract_dims;
+      contract_dims[0] =
+          Eigen::IndexPair<Eigen::DenseIndex>(1, transpose_b_ ? 1 : 0);
+      std::vector<T> scores_buffer(num_rows * block_items);
+      for (int64 shard = start_shard; shard < limit_shard; ++shard) {
+        std::vector<Filter> filters(num_rows, Filter(k));
+        const int64 shard_end = std::min(num_items, (shard + 1) * shard_items);
+        for (int64 begin = shard * shard_items; begin < shard_end;
+             begin += block_items) {
+          const int64 size = std::min(block_items, shard_end - begin);
+          typename TTypes<T>::Matrix scores(scores_buffer.data(), num_rows,
+                                            size);
+          if (transpose_b_) {
+            // The items of the block are contiguous rows of b.
+            typename TTypes<T>::ConstMatrix b_block(&b(begin, 0), size, depth);
+            scores = a.contract(b_block, contract_dims);
+          } else {
+            scores = a.contract(
+                b.slice(Eigen::DSizes<Eigen::DenseIndex, 2>(0, begin),
+                        Eigen::DSizes<Eigen::DenseIndex, 2>(depth, size)),
+                contract_dims);
+          }
+          for (int64 row = 0; row < num_rows; ++row) {
+            for (int64 i = 0; i < size; ++i) {
+              filters[row].push(
+                  ScoredItem(scores(row, i), static_cast<int32>(begin + i)));
+            }
+          }
+        }
+        for (int64 row = 0; row < num_rows; ++row) {
+          const int64 i = shard * num_rows + row;
+          num_candidates[i] = filters[row].size();
+          std::copy(filters[row].unsorted_begin(),
+                    filters[row].unsorted_end(), &candidates[i * k]);
+        }
+      }
+    };
+    const double shard_cost =
+        static_cast<double>(num_rows) * shard_items *
+        (depth * (Eigen::TensorOpCost::MulCost<T>() +
+                  Eigen::TensorOpCost::AddCost<T>()) +
+         4 * Eigen::numext::log2(static_cast<float>(k + 1)) *
+             Eigen::TensorOpCost::AddCost<T>());
+    const int64 final_shard_cost =
+        (shard_cost >= static_cast<double>(kint64max))
+            ? kint64max
+            : static_cast<int64>(shard_cost);
+    Shard(worker_threads.num_threads, worker_threads.workers, num_shards,
+          final_shard_cost, SelectShards);
+
+    auto MergeShards = [&](int64 start_row, int64 limit_row) {
+      for (int64 row = start_row; row < limit_row; ++row) {
+        Filter filter(k);
+        for (int64 shard = 0; shard < num_shards; ++shard) {
+          const int64 i = shard * num_rows + row;
+          for (int32 j = 0; j < num_candidates[i]; ++j) {
+            filter.push(candidates[i * k + j]);
+          }
+        }
+        int32 j = 0;
+        if (sorted_) {
+          std::unique_ptr<std::vector<ScoredItem>> top_k(filter.Extract());
+          for (const ScoredItem& item : *top_k) {
+            values(row, j) = item.first;
+            indices(row, j++) = item.second;
+          }
+        } else {
+          for (auto it = filter.unsorted_begin(); it != filter.unsorted_end();
+               ++it) {
+            values(row, j) = it->first;
+            indices(row, j++) = it->second;
+          }
+        }
+      }
+    };
+    const int64 merge_cost =
+        static_cast<int64>(4 * num_shards * k *
+                           Eigen::numext::log2(static_cast<float>(k + 1)) *
+                           Eigen::TensorOpCost::AddCost<T>());
+    Shard(worker_threads.num_threads, worker_threads.workers, num_rows,
+          merge_cost, MergeShards);
+  }
+
+ private:
+  bool transpose_b_;
+  bool sorted_;
+};
+
+#define REGISTER_KERNELS(type)                                         \
+  REGISTER_KERNEL_BUILDER(                                             \
+      Name("MatMulTopK").Device(DEVICE_CPU).TypeConstraint<type>("T"), \
+      MatMulTopKOp<type>)
+
+TF_CALL_float(REGISTER_KERNELS);
+TF_CALL_double(REGISTER_KERNELS);
+#undef REGISTER_KERNELS
+
+}  // namespace tensorflow
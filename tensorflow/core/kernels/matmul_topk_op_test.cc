@@ -0,0 +1,127 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/shape_inference.h"
+#include "tensorflow/core/framework/shape_inference_testutil.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+class MatMulTopKOpTest : public OpsTestBase {
+ protected:
+  void BuildGraph(bool transpose_b, bool sorted = true) {
+    TF_ASSERT_OK(NodeDefBuilder("matmul_topk", "MatMulTopK")
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_INT32))
+                     .Attr("transpose_b", transpose_b)
+                     .Attr("sorted", sorted)
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+  }
+};
+
+TEST_F(MatMulTopKOpTest, TopK) {
+  BuildGraph(/*transpose_b=*/false);
+  // The scores are [[1, 3, 2, 0], [1, 1, 4, 2]].
+  AddInputFromArray<float>(TensorShape({2, 2}), {1, 0, 0, 1});
+  AddInputFromArray<float>(TensorShape({2, 4}), {1, 3, 2, 0, 1, 1, 4, 2});
+  AddInputFromArray<int32>(TensorShape({}), {3});
+  TF_ASSERT_OK(RunOpKernel());
+
+  test::ExpectTensorEqual<float>(
+      *GetOutput(0), test::AsTensor<float>({3, 2, 1, 4, 2, 1}, {2, 3}));
+  // Equal scores are in increasing item order.
+  test::ExpectTensorEqual<int32>(
+      *GetOutput(1), test::AsTensor<int32>({1, 2, 0, 2, 3, 0}, {2, 3}));
+}
+
+TEST_F(MatMulTopKOpTest, TopKOfManyItems) {
+  BuildGraph(/*transpose_b=*/true);
+  // More items than are scored at once, with scores 2 * (i % 1000) for the
+  // query [1, 1].
+  const int kNumItems = 100000;
+  std::vector<float> items(2 * kNumItems);
+  for (int i = 0; i < kNumItems; ++i) {
+    items[2 * i] = i % 1000;
+    items[2 * i + 1] = i % 1000;
+  }
+  AddInputFromArray<float>(TensorShape({1, 2}), {1, 1});
+  AddInputFromArray<float>(TensorShape({kNumItems, 2}), items);
+  AddInputFromArray<int32>(TensorShape({}), {150});
+  TF_ASSERT_OK(RunOpKernel());
+
+  std::vector<int32> expected_indices(150);
+  for (int i = 0; i < 150; ++i) {
+    expected_indices[i] = 999 + 1000 * (i % 100) - i / 100;
+  }
+  std::vector<float> expected_values(150);
+  for (int i = 0; i < 150; ++i) {
+    expected_values[i] = 2 * (999 - i / 100);
+  }
+  test::ExpectTensorEqual<float>(
+      *GetOutput(0), test::AsTensor<float>(expected_values, {1, 150}));
+  test::ExpectTensorEqual<int32>(
+      *GetOutput(1), test::AsTensor<int32>(expected_indices, {1, 150}));
+}
+
+TEST_F(MatMulTopKOpTest, Unsorted) {
+  BuildGraph(/*transpose_b=*/true, /*sorted=*/false);
+  AddInputFromArray<float>(TensorShape({1, 1}), {2});
+  AddInputFromArray<float>(TensorShape({5, 1}), {5, 1, 4, 2, 3});
+  AddInputFromArray<int32>(TensorShape({}), {2});
+  TF_ASSERT_OK(RunOpKernel());
+
+  std::vector<int32> indices(GetOutput(1)->flat<int32>().data(),
+                             GetOutput(1)->flat<int32>().data() + 2);
+  std::sort(indices.begin(), indices.end());
+  EXPECT_EQ(std::vector<int32>({0, 2}), indices);
+}
+
+TEST_F(MatMulTopKOpTest, KTooLarge) {
+  BuildGraph(/*transpose_b=*/false);
+  AddInputFromArray<float>(TensorShape({1, 1}), {1});
+  AddInputFromArray<float>(TensorShape({1, 2}), {1, 2});
+  AddInputFromArray<int32>(TensorShape({}), {3});
+  EXPECT_TRUE(errors::IsInvalidArgument(RunOpKernel()));
+}
+
+TEST(MatMulTopKOpShapeTest, Shapes) {
+  ShapeInferenceTestOp op("MatMulTopK");
+  TF_ASSERT_OK(NodeDefBuilder("test", "MatMulTopK")
+                   .Input("a", 0, DT_FLOAT)
+                   .Input("b", 1, DT_FLOAT)
+                   .Input("k", 2, DT_INT32)
+                   .Attr("transpose_b", true)
+                   .Finalize(&op.node_def));
+  INFER_OK(op, "[3,4];[10,4];[]", "[d0_0,?];[d0_0,?]");
+  INFER_ERROR("Dimensions must be equal", op, "[3,4];[10,5];[]");
+  INFER_ERROR("must be rank 2", op, "[3];[10,4];[]");
+}
+
+}  // namespace
+}  // namespace tensorflow
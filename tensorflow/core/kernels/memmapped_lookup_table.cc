@@ -0,0 +1,283 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/memmapped_lookup_table.h"
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+#include <unordered_map>
+#include <vector>
+
+#include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/platform/mutex.h"
+
+namespace tensorflow {
+namespace lookup {
+
+namespace {
+
+constexpr char kMagic[8] = {'T', 'F', 'M', 'M', 'T', 'B', 'L', '1'};
+
+struct Header {
+  char magic[8];
+  uint32 key_dtype;
+  uint32 value_dtype;
+  uint64 reserved;
+  uint64 num_entries;
+};
+static_assert(sizeof(Header) == 32, "Header must be 32 bytes");
+
+uint64 Align8(uint64 n) { return (n + 7) & ~uint64{7}; }
+
+bool IsSupportedDataType(DataType dtype) {
+  switch (dtype) {
+    case DT_INT32:
+    case DT_INT64:
+    case DT_FLOAT:
+    case DT_DOUBLE:
+    case DT_STRING:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// The contents of a file read into memory, for file systems that cannot map
+// files.
+class StringMemoryRegion : public ReadOnlyMemoryRegion {
+ public:
+  explicit StringMemoryRegion(string data) : data_(std::move(data)) {}
+
+  const void* data() override { return data_.data(); }
+  uint64 length() override { return data_.size(); }
+
+ private:
+  const string data_;
+};
+
+// Appends `t` in the order of `order`, padded to a multiple of 8 bytes.
+template <typename T>
+Status AppendSection(const Tensor& t, const std::vector<int64>& order,
+                     WritableFile* file) {
+  const auto flat = t.flat<T>();
+  std::vector<T> sorted(order.size());
+  for (size_t i = 0; i < order.size(); ++i) {
+    sorted[i] = flat(order[i]);
+  }
+  const uint64 bytes = sorted.size() * sizeof(T);
+  TF_RETURN_IF_ERROR(file->Append(
+      StringPiece(reinterpret_cast<const char*>(sorted.data()), bytes)));
+  return file->Append(string(Align8(bytes) - bytes, '\0'));
+}
+
+template <>
+Status AppendSection<tstring>(const Tensor& t, const std::vector<int64>& order,
+                              WritableFile* file) {
+  const auto flat = t.flat<tstring>();
+  std::vector<uint64> offsets(order.size() + 1);
+  offsets[0] = 0;
+  for (size_t i = 0; i < order.size(); ++i) {
+    offsets[i + 1] = offsets[i] + flat(order[i]).size();
+  }
+  TF_RETURN_IF_ERROR(file->Append(
+      StringPiece(reinterpret_cast<const char*>(offsets.data()),
+                  offsets.size() * sizeof(uint64))));
+  for (int64 i : order) {
+    TF_RETURN_IF_ERROR(file->Append(flat(i)));
+  }
+  const uint64 bytes = offsets.back();
+  return file->Append(string(Align8(bytes) - bytes, '\0'));
+}
+
+Status AppendSection(const Tensor& t, const std::vector<int64>& order,
+                     WritableFile* file) {
+  switch (t.dtype()) {
+#define HANDLE_TYPE(T)                        \
+  case DataTypeToEnum<T>::value:              \
+    return AppendSection<T>(t, order, file);
+    TF_CALL_int32(HANDLE_TYPE);
+    TF_CALL_int64(HANDLE_TYPE);
+    TF_CALL_float(HANDLE_TYPE);
+    TF_CALL_double(HANDLE_TYPE);
+    TF_CALL_tstring(HANDLE_TYPE);
+#undef HANDLE_TYPE
+    default:
+      return errors::Unimplemented("MemmappedTable does not support ",
+                                   DataTypeString(t.dtype()));
+  }
+}
+
+// Returns the indices of `keys` in increasing order of the keys.
+template <typename K>
+Status SortKeys(const Tensor& keys, std::vector<int64>* order) {
+  const auto flat = keys.flat<K>();
+  order->resize(flat.size());
+  std::iota(order->begin(), order->end(), 0);
+  std::sort(order->begin(), order->end(),
+            [&flat](int64 a, int64 b) { return flat(a) < flat(b); });
+  for (size_t i = 1; i < order->size(); ++i) {
+    if (flat((*order)[i - 1]) == flat((*order)[i])) {
+      return errors::InvalidArgument("Duplicate key in MemmappedTable: ",
+                                     flat((*order)[i]));
+    }
+  }
+  return Status::OK();
+}
+
+}  // namespace
+
+Status MemmappedTableData::Get(
+    Env* env, const string& filename, DataType key_dtype, DataType value_dtype,
+    std::shared_ptr<const MemmappedTableData>* data) {
+  // Tables of the same file share the mapping until the last one is deleted.
+  static mutex* mu = new mutex;
+  static auto* tables =
+      new std::unordered_map<string, std::weak_ptr<const MemmappedTableData>>;
+
+  mutex_lock l(*mu);
+  std::shared_ptr<const MemmappedTableData>& cached = *data;
+  cached = (*tables)[filename].lock();
+  if (cached == nullptr) {
+    std::unique_ptr<ReadOnlyMemoryRegion> region;
+    Status s = env->NewReadOnlyMemoryRegionFromFile(filename, &region);
+    if (errors::IsUnimplemented(s)) {
+      string contents;
+      TF_RETURN_IF_ERROR(ReadFileToString(env, filename, &contents));
+      region.reset(new StringMemoryRegion(std::move(contents)));
+    } else {
+      TF_RETURN_IF_ERROR(s);
+    }
+    std::shared_ptr<MemmappedTableData> table(new MemmappedTableData);
+    table->region_ = std::move(region);
+    TF_RETURN_IF_ERROR(table->Parse(filename));
+    cached = table;
+    (*tables)[filename] = cached;
+  }
+
+  if (cached->key_dtype_ != key_dtype || cached->value_dtype_ != value_dtype) {
+    return errors::InvalidArgument(
+        "MemmappedTable file ", filename, " maps ",
+        DataTypeString(cached->key_dtype_), " keys to ",
+        DataTypeString(cached->value_dtype_), " values, expected ",
+        DataTypeString(key_dtype), " to ", DataTypeString(value_dtype));
+  }
+  return Status::OK();
+}
+
+Status MemmappedTableData::Parse(const string& filename) {
+  const char* base = static_cast<const char*>(region_->data());
+  const uint64 length = region_->length();
+  if (length < sizeof(Header)) {
+    return errors::DataLoss("MemmappedTable file ", filename,
+                            " is too short for the header");
+  }
+  Header header;
+  std::memcpy(&header, base, sizeof(Header));
+  if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) {
+    return errors::DataLoss("MemmappedTable file ", filename,
+                            " has an invalid magic number");
+  }
+  key_dtype_ = static_cast<DataType>(header.key_dtype);
+  value_dtype_ = static_cast<DataType>(header.value_dtype);
+  if (!IsSupportedDataType(key_dtype_) || !IsSupportedDataType(value_dtype_)) {
+    return errors::DataLoss("MemmappedTable file ", filename,
+                            " has unsupported data types ", header.key_dtype,
+                            " and ", header.value_dtype);
+  }
+  const uint64 num_entries = header.num_entries;
+  if (num_entries > length / sizeof(uint64)) {
+    return errors::DataLoss("MemmappedTable file ", filename, " with ",
+                            length, " bytes cannot hold ", num_entries,
+                            " entries");
+  }
+  num_entries_ = num_entries;
+
+  // num_entries is at most length / 8, so the section sizes cannot overflow.
+  uint64 offset = sizeof(Header);
+  auto parse_section = [&](DataType dtype, Section* section) -> Status {
+    if (dtype == DT_STRING) {
+      const uint64 offsets_bytes = (num_entries + 1) * sizeof(uint64);
+      if (offsets_bytes > length - offset) {
+        return errors::DataLoss("MemmappedTable file ", filename,
+                                " is truncated");
+      }
+      section->offsets = reinterpret_cast<const uint64*>(base + offset);
+      offset += offsets_bytes;
+      uint64 previous = 0;
+      for (uint64 i = 0; i <= num_entries; ++i) {
+        if (section->offsets[i] < previous ||
+            section->offsets[i] > length - offset) {
+          return errors::DataLoss("MemmappedTable file ", filename,
+                                  " has invalid string offsets");
+        }
+        previous = section->offsets[i];
+      }
+      section->data = base + offset;
+      offset += Align8(previous);
+    } else {
+      const uint64 bytes = num_entries * DataTypeSize(dtype);
+      section->data = base + offset;
+      offset += Align8(bytes);
+    }
+    if (offset > length) {
+      return errors::DataLoss("MemmappedTable file ", filename,
+                              " is truncated");
+    }
+    return Status::OK();
+  };
+  TF_RETURN_IF_ERROR(parse_section(key_dtype_, &keys_));
+  return parse_section(value_dtype_, &values_);
+}
+
+Status WriteMemmappedTable(Env* env, const string& filename, const Tensor& keys,
+                           const Tensor& values) {
+  if (keys.NumElements() != values.NumElements()) {
+    return errors::InvalidArgument("Expected as many values as keys, got ",
+                                   values.NumElements(), " values and ",
+                                   keys.NumElements(), " keys");
+  }
+  std::vector<int64> order;
+  switch (keys.dtype()) {
+    case DT_INT64:
+      TF_RETURN_IF_ERROR(SortKeys<int64>(keys, &order));
+      break;
+    case DT_STRING:
+      TF_RETURN_IF_ERROR(SortKeys<tstring>(keys, &order));
+      break;
+    default:
+      return errors::Unimplemented("MemmappedTable does not support ",
+                                   DataTypeString(keys.dtype()), " keys");
+  }
+
+  Header header;
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.key_dtype = keys.dtype();
+  header.value_dtype = values.dtype();
+  header.reserved = 0;
+  header.num_entries = order.size();
+
+  std::unique_ptr<WritableFile> file;
+  TF_RETURN_IF_ERROR(env->NewWritableFile(filename, &file));
+  TF_RETURN_IF_ERROR(file->Append(
+      StringPiece(reinterpret_cast<const char*>(&header), sizeof(Header))));
+  TF_RETURN_IF_ERROR(AppendSection(keys, order, file.get()));
+  TF_RETURN_IF_ERROR(AppendSection(values, order, file.get()));
+  return file->Close();
+}
+
+}  // namespace lookup
+}  // namespace tensorflow
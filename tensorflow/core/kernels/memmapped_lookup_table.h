@@ -0,0 +1,116 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_KERNELS_MEMMAPPED_LOOKUP_TABLE_H_
+#define TENSORFLOW_CORE_KERNELS_MEMMAPPED_LOOKUP_TABLE_H_
+
+#include <memory>
+#include <string>
+#include <type_traits>
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/stringpiece.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/file_system.h"
+
+namespace tensorflow {
+namespace lookup {
+
+// A read-only table stored as sorted arrays in a file that is memory mapped,
+// so that loading it costs no parsing and its pages are only read from disk
+// when a lookup touches them.
+//
+// The file is in host byte order and consists of a 32 byte header
+//
+//   char magic[8] = "TFMMTBL1"
+//   uint32 key_dtype, value_dtype   (DataType enum values)
+//   uint64 reserved, num_entries
+//
+// followed by the keys and then the values, each padded to a multiple of 8
+// bytes. Keys are strictly increasing. A section of a fixed width type is the
+// array of its num_entries elements; a section of strings is an array of
+// num_entries + 1 uint64 offsets followed by the concatenated bytes, where
+// string i spans [offsets[i], offsets[i + 1]) of the bytes.
+class MemmappedTableData {
+ public:
+  // Returns the data of the table in `filename`, mapping the file if no other
+  // table in the process has it mapped already. The file must not change while
+  // it is mapped.
+  static Status Get(Env* env, const string& filename, DataType key_dtype,
+                    DataType value_dtype,
+                    std::shared_ptr<const MemmappedTableData>* data);
+
+  // Strings are returned as views into the mapped file.
+  template <typename T>
+  using ElementType =
+      typename std::conditional<std::is_same<T, tstring>::value, StringPiece,
+                                T>::type;
+
+  int64 size() const { return num_entries_; }
+
+  // The i-th key or value. T must match the dtype of the section.
+  template <typename T>
+  ElementType<T> key(int64 i) const {
+    return Element<T>(keys_, i);
+  }
+  template <typename T>
+  ElementType<T> value(int64 i) const {
+    return Element<T>(values_, i);
+  }
+
+ private:
+  // A parsed keys or values section of the file.
+  struct Section {
+    const char* data = nullptr;
+    // For strings, the num_entries + 1 offsets into `data`.
+    const uint64* offsets = nullptr;
+  };
+
+  MemmappedTableData() = default;
+
+  // Validates the header and locates the sections of region_.
+  Status Parse(const string& filename);
+
+  template <typename T>
+  static ElementType<T> Element(const Section& section, int64 i) {
+    return reinterpret_cast<const T*>(section.data)[i];
+  }
+
+  std::unique_ptr<ReadOnlyMemoryRegion> region_;
+  DataType key_dtype_ = DT_INVALID;
+  DataType value_dtype_ = DT_INVALID;
+  int64 num_entries_ = 0;
+  Section keys_;
+  Section values_;
+};
+
+template <>
+inline StringPiece MemmappedTableData::Element<tstring>(const Section& section,
+                                                        int64 i) {
+  const uint64 begin = section.offsets[i];
+  return StringPiece(section.data + begin, section.offsets[i + 1] - begin);
+}
+
+// Writes the table that maps `keys` to `values` to `filename` in the format
+// read by MemmappedTableData. The keys must be unique.
+Status WriteMemmappedTable(Env* env, const string& filename, const Tensor& keys,
+                           const Tensor& values);
+
+}  // namespace lookup
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_MEMMAPPED_LOOKUP_TABLE_H_
@@ -157,6 +157,11 @@ class MklDnnQuantizedMatMulOp : public MklDnnMatMulOpBase<Tweight, Toutput> {
   }
 
   void Compute(OpKernelContext* context) override {
+    OP_REQUIRES(context,
+                context->input(5).NumElements() == 1 &&
+                    context->input(6).NumElements() == 1,
+                errors::Unimplemented(
+                    "Per-channel ranges of b are not supported with MKL"));
     try {
       // Input tensors
       const Tensor& src_tensor = MklGetInput(context, this->kInputIndexSrc);
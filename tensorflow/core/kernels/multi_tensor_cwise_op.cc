@@ -0,0 +1,218 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// See docs in ../ops/math_ops.cc.
+
+#define EIGEN_USE_THREADS
+
+#include "tensorflow/core/kernels/multi_tensor_cwise_op.h"
+
+#include <unordered_map>
+
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_types.h"
+#include "tensorflow/core/lib/core/errors.h"
+
+namespace tensorflow {
+
+typedef Eigen::ThreadPoolDevice CPUDevice;
+typedef Eigen::GpuDevice GPUDevice;
+
+namespace {
+
+Status ParseMultiTensorCwiseOp(const string& name, MultiTensorCwiseOp* op) {
+  static const auto* const kOps =
+      new std::unordered_map<string, MultiTensorCwiseOp>({
+          {"Abs", MultiTensorCwiseOp::kAbs},
+          {"BiasAdd", MultiTensorCwiseOp::kBiasAdd},
+          {"Exp", MultiTensorCwiseOp::kExp},
+          {"Neg", MultiTensorCwiseOp::kNeg},
+          {"Relu", MultiTensorCwiseOp::kRelu},
+          {"Relu6", MultiTensorCwiseOp::kRelu6},
+          {"Rsqrt", MultiTensorCwiseOp::kRsqrt},
+          {"Sigmoid", MultiTensorCwiseOp::kSigmoid},
+          {"Sqrt", MultiTensorCwiseOp::kSqrt},
+          {"Square", MultiTensorCwiseOp::kSquare},
+          {"Tanh", MultiTensorCwiseOp::kTanh},
+      });
+  auto it = kOps->find(name);
+  if (it == kOps->end()) {
+    return errors::InvalidArgument("Unsupported multi-tensor element-wise op: ",
+                                   name);
+  }
+  *op = it->second;
+  return Status::OK();
+}
+
+}  // namespace
+
+namespace functor {
+
+template <typename T>
+struct MultiTensorCwise<CPUDevice, T> {
+  void operator()(const CPUDevice& d, MultiTensorCwiseOp op,
+                  const MultiTensorCwiseArgs<T>& args) {
+    for (int i = 0; i < args.num_tensors; ++i) {
+      typename TTypes<T>::ConstFlat in(args.inputs[i], args.sizes[i]);
+      typename TTypes<T>::Flat out(args.outputs[i], args.sizes[i]);
+      switch (op) {
+#define UNARY_CASE(OP)                                                  \
+  case MultiTensorCwiseOp::OP:                                          \
+    out.device(d) =                                                     \
+        in.unaryExpr(MultiTensorCwiseUnaryOp<T, MultiTensorCwiseOp::OP>()); \
+    break;
+        UNARY_CASE(kAbs)
+        UNARY_CASE(kExp)
+        UNARY_CASE(kNeg)
+        UNARY_CASE(kRelu)
+        UNARY_CASE(kRelu6)
+        UNARY_CASE(kRsqrt)
+        UNARY_CASE(kSigmoid)
+        UNARY_CASE(kSqrt)
+        UNARY_CASE(kSquare)
+        UNARY_CASE(kTanh)
+#undef UNARY_CASE
+        case MultiTensorCwiseOp::kBiasAdd: {
+          const int64 bias_size = args.bias_sizes[i];
+          const int64 rows = args.sizes[i] / bias_size;
+          typename TTypes<T>::ConstMatrix value(args.inputs[i], rows,
+                                                bias_size);
+          typename TTypes<T>::ConstMatrix bias(args.biases[i], 1, bias_size);
+          typename TTypes<T>::Matrix output(args.outputs[i], rows, bias_size);
+          Eigen::array<Eigen::Index, 2> broadcast{rows, 1};
+          output.device(d) = value + bias.broadcast(broadcast);
+          break;
+        }
+      }
+    }
+  }
+};
+
+}  // namespace functor
+
+template <typename Device, typename T>
+class MultiTensorCwiseOpKernel : public OpKernel {
+ public:
+  explicit MultiTensorCwiseOpKernel(OpKernelConstruction* context)
+      : OpKernel(context) {
+    string op_name;
+    OP_REQUIRES_OK(context, context->GetAttr("op", &op_name));
+    OP_REQUIRES_OK(context, ParseMultiTensorCwiseOp(op_name, &op_));
+    int num_inputs;
+    int num_bias;
+    OP_REQUIRES_OK(context, context->GetAttr("N", &num_inputs));
+    OP_REQUIRES_OK(context, context->GetAttr("num_bias", &num_bias));
+    const int expected_num_bias =
+        op_ == MultiTensorCwiseOp::kBiasAdd ? num_inputs : 0;
+    OP_REQUIRES(context, num_bias == expected_num_bias,
+                errors::InvalidArgument("Expected ", expected_num_bias,
+                                        " bias tensors for ", op_name,
+                                        ", got ", num_bias));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    OpInputList inputs;
+    OpInputList biases;
+    OP_REQUIRES_OK(context, context->input_list("x", &inputs));
+    OP_REQUIRES_OK(context, context->input_list("bias", &biases));
+
+    functor::MultiTensorCwiseArgs<T> args;
+    const auto launch = [&]() {
+      if (args.num_tensors == 0) return;
+      functor::MultiTensorCwise<Device, T>()(context->eigen_device<Device>(),
+                                              op_, args);
+      args.num_tensors = 0;
+    };
+    for (int i = 0; i < inputs.size(); ++i) {
+      const Tensor& input = inputs[i];
+      Tensor* output = nullptr;
+      OP_REQUIRES_OK(context, context->forward_input_or_allocate_output(
+                                  {i}, i, input.shape(), &output));
+      if (op_ == MultiTensorCwiseOp::kBiasAdd) {
+        const Tensor& bias = biases[i];
+        OP_REQUIRES(context, TensorShapeUtils::IsVector(bias.shape()),
+                    errors::InvalidArgument("Biases must be 1D: ",
+                                            bias.shape().DebugString()));
+        OP_REQUIRES(
+            context,
+            input.dims() >= 1 && input.dim_size(input.dims() - 1) ==
+                                     bias.shape().dim_size(0),
+            errors::InvalidArgument(
+                "Must provide as many biases as the last dimension of the "
+                "input tensor: ",
+                bias.shape().DebugString(), " vs. ",
+                input.shape().DebugString()));
+      }
+      if (input.NumElements() == 0) continue;
+
+      const int index = args.num_tensors++;
+      args.inputs[index] = input.flat<T>().data();
+      args.outputs[index] = output->flat<T>().data();
+      args.sizes[index] = input.NumElements();
+      if (op_ == MultiTensorCwiseOp::kBiasAdd) {
+        args.biases[index] = biases[i].flat<T>().data();
+        args.bias_sizes[index] = biases[i].NumElements();
+      }
+      if (args.num_tensors == kMaxMultiTensorCwiseTensors) launch();
+    }
+    launch();
+  }
+
+ private:
+  MultiTensorCwiseOp op_;
+};
+
+#define REGISTER_CPU(T)                                                   \
+  REGISTER_KERNEL_BUILDER(                                                \
+      Name("_MultiTensorCwise").Device(DEVICE_CPU).TypeConstraint<T>("T"), \
+      MultiTensorCwiseOpKernel<CPUDevice, T>);
+
+TF_CALL_half(REGISTER_CPU);
+TF_CALL_float(REGISTER_CPU);
+TF_CALL_double(REGISTER_CPU);
+#undef REGISTER_CPU
+
+#if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+
+namespace functor {
+#define DECLARE_GPU_SPEC(T)                                     \
+  template <>                                                   \
+  void MultiTensorCwise<GPUDevice, T>::operator()(              \
+      const GPUDevice& d, MultiTensorCwiseOp op,                \
+      const MultiTensorCwiseArgs<T>& args);                     \
+  extern template struct MultiTensorCwise<GPUDevice, T>;
+
+TF_CALL_half(DECLARE_GPU_SPEC);
+TF_CALL_float(DECLARE_GPU_SPEC);
+TF_CALL_double(DECLARE_GPU_SPEC);
+#undef DECLARE_GPU_SPEC
+}  // namespace functor
+
+#define REGISTER_GPU(T)                                                   \
+  REGISTER_KERNEL_BUILDER(                                                \
+      Name("_MultiTensorCwise").Device(DEVICE_GPU).TypeConstraint<T>("T"), \
+      MultiTensorCwiseOpKernel<GPUDevice, T>);
+
+TF_CALL_half(REGISTER_GPU);
+TF_CALL_float(REGISTER_GPU);
+TF_CALL_double(REGISTER_GPU);
+#undef REGISTER_GPU
+
+#endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+
+}  // namespace tensorflow
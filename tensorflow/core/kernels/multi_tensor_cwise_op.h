@@ -0,0 +1,96 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_KERNELS_MULTI_TENSOR_CWISE_OP_H_
+#define TENSORFLOW_CORE_KERNELS_MULTI_TENSOR_CWISE_OP_H_
+
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/core/framework/types.h"
+
+namespace tensorflow {
+
+// Element-wise ops supported by the _MultiTensorCwise op.
+enum class MultiTensorCwiseOp {
+  kAbs,
+  kBiasAdd,
+  kExp,
+  kNeg,
+  kRelu,
+  kRelu6,
+  kRsqrt,
+  kSigmoid,
+  kSqrt,
+  kSquare,
+  kTanh,
+};
+
+// Maximum number of tensors processed by a single functor invocation. The
+// arguments are passed by value to the GPU kernel, so they must fit in the
+// kernel parameter space.
+constexpr int kMaxMultiTensorCwiseTensors = 32;
+
+namespace functor {
+
+template <typename T>
+struct MultiTensorCwiseArgs {
+  const T* inputs[kMaxMultiTensorCwiseTensors];
+  // Only set for kBiasAdd: the bias is broadcast along the inner dimension of
+  // the inputs, whose size is bias_sizes[i].
+  const T* biases[kMaxMultiTensorCwiseTensors];
+  T* outputs[kMaxMultiTensorCwiseTensors];
+  int64 sizes[kMaxMultiTensorCwiseTensors];
+  int64 bias_sizes[kMaxMultiTensorCwiseTensors];
+  int num_tensors = 0;
+};
+
+template <typename T, MultiTensorCwiseOp Op>
+struct MultiTensorCwiseUnaryOp;
+
+#define DEFINE_MULTI_TENSOR_CWISE_UNARY_OP(OP, EXPR)               \
+  template <typename T>                                            \
+  struct MultiTensorCwiseUnaryOp<T, MultiTensorCwiseOp::OP> {      \
+    EIGEN_DEVICE_FUNC EIGEN_STRONG_INLINE T operator()(T x) const { \
+      return EXPR;                                                 \
+    }                                                              \
+  };
+
+DEFINE_MULTI_TENSOR_CWISE_UNARY_OP(kAbs, Eigen::numext::abs(x));
+DEFINE_MULTI_TENSOR_CWISE_UNARY_OP(kExp, Eigen::numext::exp(x));
+DEFINE_MULTI_TENSOR_CWISE_UNARY_OP(kNeg, -x);
+DEFINE_MULTI_TENSOR_CWISE_UNARY_OP(kRelu, x > T(0) ? x : T(0));
+DEFINE_MULTI_TENSOR_CWISE_UNARY_OP(kRelu6,
+                                   x > T(0) ? (x < T(6) ? x : T(6)) : T(0));
+DEFINE_MULTI_TENSOR_CWISE_UNARY_OP(kRsqrt, T(1) / Eigen::numext::sqrt(x));
+DEFINE_MULTI_TENSOR_CWISE_UNARY_OP(kSigmoid,
+                                   T(1) / (T(1) + Eigen::numext::exp(-x)));
+DEFINE_MULTI_TENSOR_CWISE_UNARY_OP(kSqrt, Eigen::numext::sqrt(x));
+DEFINE_MULTI_TENSOR_CWISE_UNARY_OP(kSquare, x* x);
+DEFINE_MULTI_TENSOR_CWISE_UNARY_OP(kTanh, Eigen::numext::tanh(x));
+
+#undef DEFINE_MULTI_TENSOR_CWISE_UNARY_OP
+
+// Applies `op` to all the tensors described by `args`. Implemented for
+// CPUDevice and, when building with GPU support, GPUDevice, where all the
+// tensors are processed by a single kernel launch.
+template <typename Device, typename T>
+struct MultiTensorCwise {
+  void operator()(const Device& d, MultiTensorCwiseOp op,
+                  const MultiTensorCwiseArgs<T>& args);
+};
+
+}  // namespace functor
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_MULTI_TENSOR_CWISE_OP_H_
@@ -0,0 +1,117 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+
+#define EIGEN_USE_GPU
+
+#include <algorithm>
+
+#include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/kernels/multi_tensor_cwise_op.h"
+#include "tensorflow/core/util/gpu_kernel_helper.h"
+
+namespace tensorflow {
+
+typedef Eigen::GpuDevice GPUDevice;
+
+namespace functor {
+namespace {
+
+// Each row of blocks (blockIdx.y) processes one of the tensors, so that all
+// the tensors are processed by a single kernel launch.
+template <typename T, MultiTensorCwiseOp Op>
+__global__ void MultiTensorCwiseUnaryKernel(MultiTensorCwiseArgs<T> args) {
+  const int tensor = blockIdx.y;
+  const T* __restrict__ input = args.inputs[tensor];
+  T* __restrict__ output = args.outputs[tensor];
+  const int64 size = args.sizes[tensor];
+  const MultiTensorCwiseUnaryOp<T, Op> op;
+  for (int64 i = blockIdx.x * blockDim.x + threadIdx.x; i < size;
+       i += blockDim.x * gridDim.x) {
+    output[i] = op(ldg(input + i));
+  }
+}
+
+template <typename T>
+__global__ void MultiTensorBiasAddKernel(MultiTensorCwiseArgs<T> args) {
+  const int tensor = blockIdx.y;
+  const T* __restrict__ input = args.inputs[tensor];
+  const T* __restrict__ bias = args.biases[tensor];
+  T* __restrict__ output = args.outputs[tensor];
+  const int64 size = args.sizes[tensor];
+  const int64 bias_size = args.bias_sizes[tensor];
+  for (int64 i = blockIdx.x * blockDim.x + threadIdx.x; i < size;
+       i += blockDim.x * gridDim.x) {
+    output[i] = ldg(input + i) + ldg(bias + i % bias_size);
+  }
+}
+
+template <typename T>
+void LaunchMultiTensorCwise(const GPUDevice& d, MultiTensorCwiseOp op,
+                            const MultiTensorCwiseArgs<T>& args) {
+  if (args.num_tensors == 0) return;
+  const int64 max_size =
+      *std::max_element(args.sizes, args.sizes + args.num_tensors);
+  // Size the grid for the largest tensor: blocks of the smaller tensors
+  // return early.
+  GpuLaunchConfig config = GetGpuLaunchConfig(max_size, d);
+  const dim3 grid(config.block_count, args.num_tensors);
+  switch (op) {
+#define UNARY_CASE(OP)                                                        \
+  case MultiTensorCwiseOp::OP:                                                \
+    TF_CHECK_OK(GpuLaunchKernel(                                              \
+        MultiTensorCwiseUnaryKernel<T, MultiTensorCwiseOp::OP>, grid,         \
+        config.thread_per_block, 0, d.stream(), args));                       \
+    break;
+    UNARY_CASE(kAbs)
+    UNARY_CASE(kExp)
+    UNARY_CASE(kNeg)
+    UNARY_CASE(kRelu)
+    UNARY_CASE(kRelu6)
+    UNARY_CASE(kRsqrt)
+    UNARY_CASE(kSigmoid)
+    UNARY_CASE(kSqrt)
+    UNARY_CASE(kSquare)
+    UNARY_CASE(kTanh)
+#undef UNARY_CASE
+    case MultiTensorCwiseOp::kBiasAdd:
+      TF_CHECK_OK(GpuLaunchKernel(MultiTensorBiasAddKernel<T>, grid,
+                                  config.thread_per_block, 0, d.stream(),
+                                  args));
+      break;
+  }
+}
+
+}  // namespace
+
+#define DEFINE_GPU_SPEC(T)                                               \
+  template <>                                                            \
+  void MultiTensorCwise<GPUDevice, T>::operator()(                       \
+      const GPUDevice& d, MultiTensorCwiseOp op,                         \
+      const MultiTensorCwiseArgs<T>& args) {                             \
+    LaunchMultiTensorCwise<T>(d, op, args);                              \
+  }                                                                      \
+  template struct MultiTensorCwise<GPUDevice, T>;
+
+TF_CALL_half(DEFINE_GPU_SPEC);
+TF_CALL_float(DEFINE_GPU_SPEC);
+TF_CALL_double(DEFINE_GPU_SPEC);
+#undef DEFINE_GPU_SPEC
+
+}  // namespace functor
+}  // namespace tensorflow
+
+#endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
@@ -0,0 +1,174 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <cmath>
+
+#include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/kernels/ops_util.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+namespace {
+
+class MultiTensorCwiseTest : public OpsTestBase {
+ protected:
+  Status MakeOp(const string& op, int num_inputs, int num_bias) {
+    TF_RETURN_IF_ERROR(
+        NodeDefBuilder("multi_tensor_cwise", "_MultiTensorCwise")
+            .Input(FakeInput(num_inputs, DT_FLOAT))
+            .Input(FakeInput(num_bias, DT_FLOAT))
+            .Attr("T", DT_FLOAT)
+            .Attr("op", op)
+            .Finalize(node_def()));
+    return InitOp();
+  }
+};
+
+TEST_F(MultiTensorCwiseTest, Relu) {
+  TF_ASSERT_OK(MakeOp("Relu", 3, 0));
+  AddInputFromArray<float>(TensorShape({4}), {-1, 2, -3, 4});
+  AddInputFromArray<float>(TensorShape({0}), {});
+  AddInputFromArray<float>(TensorShape({2, 1}), {5, -6});
+  TF_ASSERT_OK(RunOpKernel());
+
+  test::ExpectTensorEqual<float>(
+      test::AsTensor<float>({0, 2, 0, 4}, TensorShape({4})), *GetOutput(0));
+  EXPECT_EQ(TensorShape({0}), GetOutput(1)->shape());
+  test::ExpectTensorEqual<float>(
+      test::AsTensor<float>({5, 0}, TensorShape({2, 1})), *GetOutput(2));
+}
+
+TEST_F(MultiTensorCwiseTest, Tanh) {
+  TF_ASSERT_OK(MakeOp("Tanh", 2, 0));
+  AddInputFromArray<float>(TensorShape({2}), {0.5, -1});
+  AddInputFromArray<float>(TensorShape({1}), {2});
+  TF_ASSERT_OK(RunOpKernel());
+
+  test::ExpectClose(test::AsTensor<float>({std::tanh(0.5f), std::tanh(-1.0f)}),
+                    *GetOutput(0));
+  test::ExpectClose(test::AsTensor<float>({std::tanh(2.0f)}), *GetOutput(1));
+}
+
+TEST_F(MultiTensorCwiseTest, BiasAdd) {
+  TF_ASSERT_OK(MakeOp("BiasAdd", 2, 2));
+  AddInputFromArray<float>(TensorShape({2, 3}), {1, 2, 3, 4, 5, 6});
+  AddInputFromArray<float>(TensorShape({2}), {1, 2});
+  AddInputFromArray<float>(TensorShape({3}), {10, 20, 30});
+  AddInputFromArray<float>(TensorShape({2}), {-1, -2});
+  TF_ASSERT_OK(RunOpKernel());
+
+  test::ExpectTensorEqual<float>(
+      test::AsTensor<float>({11, 22, 33, 14, 25, 36}, TensorShape({2, 3})),
+      *GetOutput(0));
+  test::ExpectTensorEqual<float>(test::AsTensor<float>({0, 0}),
+                                 *GetOutput(1));
+}
+
+TEST_F(MultiTensorCwiseTest, BiasAddShapeMismatch) {
+  TF_ASSERT_OK(MakeOp("BiasAdd", 1, 1));
+  AddInputFromArray<float>(TensorShape({2, 3}), {1, 2, 3, 4, 5, 6});
+  AddInputFromArray<float>(TensorShape({2}), {1, 2});
+  Status s = RunOpKernel();
+  EXPECT_TRUE(errors::IsInvalidArgument(s)) << s;
+}
+
+TEST_F(MultiTensorCwiseTest, MoreTensorsThanPerLaunch) {
+  const int kNumInputs = 70;
+  TF_ASSERT_OK(MakeOp("Neg", kNumInputs, 0));
+  for (int i = 0; i < kNumInputs; ++i) {
+    AddInputFromArray<float>(TensorShape({2}), {static_cast<float>(i), 1});
+  }
+  TF_ASSERT_OK(RunOpKernel());
+  for (int i = 0; i < kNumInputs; ++i) {
+    test::ExpectTensorEqual<float>(
+        test::AsTensor<float>({-static_cast<float>(i), -1}), *GetOutput(i));
+  }
+}
+
+TEST_F(MultiTensorCwiseTest, UnsupportedOp) {
+  Status s = MakeOp("Log", 1, 0);
+  EXPECT_TRUE(errors::IsInvalidArgument(s)) << s;
+}
+
+TEST_F(MultiTensorCwiseTest, UnexpectedBias) {
+  Status s = MakeOp("Relu", 2, 2);
+  EXPECT_TRUE(errors::IsInvalidArgument(s)) << s;
+}
+
+// Performance benchmarks below.
+
+// `num_tensors` independent Relu nodes.
+static Graph* IndependentRelus(int num_tensors, int tensor_size) {
+  Graph* g = new Graph(OpRegistry::Global());
+  Tensor t(DT_FLOAT, TensorShape({tensor_size}));
+  t.flat<float>().setRandom();
+  for (int i = 0; i < num_tensors; ++i) {
+    Node* node;
+    TF_CHECK_OK(NodeBuilder(g->NewName("relu"), "Relu")
+                    .Input(test::graph::Constant(g, t))
+                    .Attr("T", DT_FLOAT)
+                    .Finalize(g, &node));
+  }
+  return g;
+}
+
+// The same Relus computed by a single _MultiTensorCwise node.
+static Graph* MultiTensorRelu(int num_tensors, int tensor_size) {
+  Graph* g = new Graph(OpRegistry::Global());
+  Tensor t(DT_FLOAT, TensorShape({tensor_size}));
+  t.flat<float>().setRandom();
+  std::vector<NodeBuilder::NodeOut> inputs;
+  for (int i = 0; i < num_tensors; ++i) {
+    inputs.emplace_back(test::graph::Constant(g, t));
+  }
+  Node* node;
+  TF_CHECK_OK(NodeBuilder(g->NewName("relu"), "_MultiTensorCwise")
+                  .Input(inputs)
+                  .Input(std::vector<NodeBuilder::NodeOut>())
+                  .Attr("T", DT_FLOAT)
+                  .Attr("op", "Relu")
+                  .Finalize(g, &node));
+  return g;
+}
+
+#define BM_MultiTensorRelu(N, S, type)                                      \
+  static void BM_IndependentRelus##_##type##_##N##_##S(int iters) {        \
+    testing::ItemsProcessed(static_cast<int64>(iters) * N * S);            \
+    test::Benchmark(#type, IndependentRelus(N, S)).Run(iters);             \
+  }                                                                         \
+  BENCHMARK(BM_IndependentRelus##_##type##_##N##_##S);                      \
+  static void BM_MultiTensorRelu##_##type##_##N##_##S(int iters) {          \
+    testing::ItemsProcessed(static_cast<int64>(iters) * N * S);            \
+    test::Benchmark(#type, MultiTensorRelu(N, S)).Run(iters);              \
+  }                                                                         \
+  BENCHMARK(BM_MultiTensorRelu##_##type##_##N##_##S);
+
+BM_MultiTensorRelu(32, 128, cpu);
+BM_MultiTensorRelu(128, 1024, cpu);
+#if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+BM_MultiTensorRelu(32, 128, gpu);
+BM_MultiTensorRelu(128, 1024, gpu);
+#endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+
+}  // namespace
+}  // namespace tensorflow
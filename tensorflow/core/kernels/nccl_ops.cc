@@ -45,6 +45,11 @@ class NcclAsyncOpBase : public AsyncOpKernel {
   explicit NcclAsyncOpBase(OpKernelConstruction* c) : AsyncOpKernel(c) {
     OP_REQUIRES_OK(c, c->GetAttr("num_devices", &num_devices_));
     OP_REQUIRES_OK(c, c->GetAttr("shared_name", &collective_prefix_));
+    // Kernels are constructed when the graph is instantiated, so the
+    // communicators are ready by the time the first step runs.
+    NcclManager::instance()->PrepareCommunicators(
+        collective_prefix_, num_devices_,
+        c->device()->tensorflow_gpu_device_info());
   }
 
   string GetCollectiveKey(OpKernelContext* c) {
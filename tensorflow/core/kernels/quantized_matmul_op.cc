@@ -17,6 +17,11 @@ limitations under the License.
 
 #define EIGEN_USE_THREADS
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
 #define GEMMLOWP_ALLOW_SLOW_SCALAR_FALLBACK
 #include "public/gemmlowp.h"
 #include "tensorflow/core/framework/op_kernel.h"
@@ -25,6 +30,7 @@ limitations under the License.
 #include "tensorflow/core/kernels/quantization_utils.h"
 #include "tensorflow/core/kernels/reference_gemm.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
@@ -198,4 +204,259 @@ REGISTER_KERNEL_BUILDER(Name("QuantizedMatMul")
                             .TypeConstraint<qint32>("Toutput"),
                         QuantizedMatMulOp<quint8, quint8, qint32>);
 
+// Implements the QuantizedMatMulWithBias family of fused ops for quint8 `a`
+// and qint8 `b`, without MKL. MKL builds register their own kernels for these
+// ops.
+//
+// `b` is quantized symmetrically, per tensor or per output channel: column j
+// of `b` has the scale max(|min_b[j]|, |max_b[j]|) / 127, where min_b and max_b
+// are scalars or vectors with one element per column. `a` is quantized in the
+// MIN_FIRST or SCALED mode of input_quant_mode. A float bias is added in real
+// units; a qint32 bias is already in the units of the int32 accumulators (and
+// includes the MIN_FIRST correction), as for the MKL kernels.
+//
+// The int32 product is computed with the multi-threaded gemmlowp GEMM, and a
+// single epilogue pass sharded over the rows then adds the bias, applies the
+// relu if any and converts every accumulator to the output type: a qint32
+// with a common scale for all the channels, a quint8 or qint8 in the range
+// [min_freezed_output, max_freezed_output], or a float. This replaces the
+// separate BiasAdd, Relu, RequantizationRange and Requantize passes over the
+// int32 product.
+template <class Tbias, class Toutput, bool Relu>
+class QuantizedMatMulWithBiasOp : public OpKernel {
+ public:
+  explicit QuantizedMatMulWithBiasOp(OpKernelConstruction* context)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("transpose_a", &transpose_a_));
+    OP_REQUIRES_OK(context, context->GetAttr("transpose_b", &transpose_b_));
+    string mode;
+    OP_REQUIRES_OK(context, context->GetAttr("input_quant_mode", &mode));
+    OP_REQUIRES(context, mode == "MIN_FIRST" || mode == "SCALED",
+                errors::InvalidArgument(
+                    "input_quant_mode must be either MIN_FIRST or SCALED, "
+                    "but received ",
+                    mode));
+    min_first_ = mode == "MIN_FIRST";
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& a = context->input(0);
+    const Tensor& b = context->input(1);
+    const Tensor& bias = context->input(2);
+    const float min_a = context->input(3).flat<float>()(0);
+    const float max_a = context->input(4).flat<float>()(0);
+    const Tensor& min_b = context->input(5);
+    const Tensor& max_b = context->input(6);
+
+    OP_REQUIRES(context, TensorShapeUtils::IsMatrix(a.shape()),
+                errors::InvalidArgument("In[0] is not a matrix"));
+    OP_REQUIRES(context, TensorShapeUtils::IsMatrix(b.shape()),
+                errors::InvalidArgument("In[1] is not a matrix"));
+    const int k_dim_a = transpose_a_ ? 0 : 1;
+    const int k_dim_b = transpose_b_ ? 1 : 0;
+    OP_REQUIRES(context, a.dim_size(k_dim_a) == b.dim_size(k_dim_b),
+                errors::InvalidArgument("Matrix size-incompatible: In[0]: ",
+                                        a.shape().DebugString(),
+                                        ", In[1]: ", b.shape().DebugString()));
+    const int64 m = a.dim_size(1 - k_dim_a);
+    const int64 n = b.dim_size(1 - k_dim_b);
+    const int64 k = a.dim_size(k_dim_a);
+    OP_REQUIRES(context, bias.dims() == 1 && bias.dim_size(0) == n,
+                errors::InvalidArgument("bias must have ", n,
+                                        " elements, but has shape ",
+                                        bias.shape().DebugString()));
+    OP_REQUIRES(context, max_a > min_a,
+                errors::InvalidArgument("max_a must be larger than min_a."));
+    const int64 num_b_ranges = min_b.NumElements();
+    OP_REQUIRES(
+        context,
+        (num_b_ranges == 1 || num_b_ranges == n) &&
+            max_b.NumElements() == num_b_ranges,
+        errors::InvalidArgument("min_b and max_b must have 1 or ", n,
+                                " elements, but have ", num_b_ranges, " and ",
+                                max_b.NumElements()));
+
+    // Real value of one quantized level of `a`. Real values of the products
+    // are acc * scale[j] + offset[j] for the int32 accumulators acc of column
+    // j.
+    const float scale_a =
+        min_first_ ? (max_a - min_a) / 255.0f : max_a / 255.0f;
+    std::vector<float> scale(n);
+    std::vector<float> offset(n);
+    float max_scale = 0.0f;
+    for (int64 j = 0; j < n; ++j) {
+      const int64 r = num_b_ranges == 1 ? 0 : j;
+      const float scale_b = std::max(std::abs(min_b.flat<float>()(r)),
+                                     std::abs(max_b.flat<float>()(r))) /
+                            127.0f;
+      OP_REQUIRES(context, scale_b > 0.0f,
+                  errors::InvalidArgument("The range of b must not be empty"));
+      scale[j] = scale_a * scale_b;
+      max_scale = std::max(max_scale, scale[j]);
+    }
+    // The zero point of `a` is not subtracted in the GEMM, so with a float
+    // bias the products lack min_a times the column sums of b.
+    std::vector<int64> column_sums(n, 0);
+    if (std::is_same<Tbias, float>::value && min_first_ && min_a != 0.0f) {
+      const auto b_matrix = b.matrix<qint8>();
+      for (int64 r = 0; r < b.dim_size(0); ++r) {
+        for (int64 c = 0; c < b.dim_size(1); ++c) {
+          column_sums[transpose_b_ ? r : c] += b_matrix(r, c).value;
+        }
+      }
+    }
+    const auto bias_flat = bias.flat<Tbias>();
+    for (int64 j = 0; j < n; ++j) {
+      if (std::is_same<Tbias, qint32>::value) {
+        offset[j] = scale[j] * static_cast<float>(bias_flat(j));
+      } else {
+        offset[j] = static_cast<float>(bias_flat(j)) +
+                    min_a * column_sums[j] * (scale[j] / scale_a);
+      }
+    }
+
+    // The output is out = round(acc * mult[j] + add[j]), clamped to
+    // [out_lowest, out_highest] and, with a relu, at least the output of a
+    // real 0.
+    float min_out = 0.0f;
+    float max_out = 0.0f;
+    float out_lowest = FloatToQuantizedStruct<Toutput>::lower_bound_float();
+    float out_highest = FloatToQuantizedStruct<Toutput>::upper_bound_float();
+    float out_per_real = 1.0f;
+    float out_of_zero = 0.0f;
+    if (std::is_same<Toutput, qint32>::value) {
+      out_per_real = 1.0f / max_scale;
+      min_out = max_scale * static_cast<float>(
+                                Eigen::NumTraits<Toutput>::lowest());
+      max_out = max_scale * static_cast<float>(
+                                Eigen::NumTraits<Toutput>::highest());
+    } else if (!std::is_same<Toutput, float>::value) {
+      min_out = context->input(7).flat<float>()(0);
+      max_out = context->input(8).flat<float>()(0);
+      OP_REQUIRES(context, max_out > min_out,
+                  errors::InvalidArgument(
+                      "max_freezed_output must be larger than "
+                      "min_freezed_output."));
+      out_per_real = 255.0f / (max_out - min_out);
+      out_of_zero = FloatToQuantizedStruct<Toutput>::lowest_quantized() -
+                    min_out * out_per_real;
+    }
+    if (std::is_same<Toutput, float>::value) {
+      out_lowest = -std::numeric_limits<float>::infinity();
+      out_highest = std::numeric_limits<float>::infinity();
+    }
+    if (Relu) out_lowest = std::max(out_lowest, out_of_zero);
+    std::vector<float> mult(n);
+    std::vector<float> add(n);
+    for (int64 j = 0; j < n; ++j) {
+      mult[j] = scale[j] * out_per_real;
+      add[j] = offset[j] * out_per_real + out_of_zero;
+    }
+
+    Tensor* out = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(0, {m, n}, &out));
+    if (!std::is_same<Toutput, float>::value) {
+      Tensor* out_min = nullptr;
+      OP_REQUIRES_OK(context, context->allocate_output(1, {}, &out_min));
+      out_min->flat<float>()(0) = min_out;
+      Tensor* out_max = nullptr;
+      OP_REQUIRES_OK(context, context->allocate_output(2, {}, &out_max));
+      out_max->flat<float>()(0) = max_out;
+    }
+    if (out->NumElements() == 0) return;
+
+    // gemmlowp multiplies unsigned 8 bit matrices, so b is moved to uint8 and
+    // its zero point to 128.
+    Tensor b_unsigned;
+    OP_REQUIRES_OK(context,
+                   context->allocate_temp(DT_QUINT8, b.shape(), &b_unsigned));
+    const qint8* b_data = b.flat<qint8>().data();
+    quint8* b_unsigned_data = b_unsigned.flat<quint8>().data();
+    for (int64 i = 0; i < b.NumElements(); ++i) {
+      b_unsigned_data[i] = static_cast<uint8>(b_data[i].value) ^ 0x80;
+    }
+    Tensor acc;
+    OP_REQUIRES_OK(context, context->allocate_temp(DT_QINT32, {m, n}, &acc));
+    const quint8* a_data = a.flat<quint8>().data();
+    qint32* acc_data = acc.flat<qint32>().data();
+    const int lda = a.dim_size(1);
+    const int ldb = b.dim_size(1);
+    if (transpose_a_) {
+      if (transpose_b_) {
+        GemmlowpMultiply<true, true, false>(context, a_data, b_unsigned_data,
+                                            acc_data, m, n, k, 0, 128, lda,
+                                            ldb, n);
+      } else {
+        GemmlowpMultiply<true, false, false>(context, a_data, b_unsigned_data,
+                                             acc_data, m, n, k, 0, 128, lda,
+                                             ldb, n);
+      }
+    } else {
+      if (transpose_b_) {
+        GemmlowpMultiply<false, true, false>(context, a_data, b_unsigned_data,
+                                             acc_data, m, n, k, 0, 128, lda,
+                                             ldb, n);
+      } else {
+        GemmlowpMultiply<false, false, false>(context, a_data, b_unsigned_data,
+                                              acc_data, m, n, k, 0, 128, lda,
+                                              ldb, n);
+      }
+    }
+
+    Toutput* out_data = out->flat<Toutput>().data();
+    auto epilogue = [&](int64 begin, int64 end) {
+      for (int64 i = begin; i < end; ++i) {
+        const qint32* acc_row = acc_data + i * n;
+        Toutput* out_row = out_data + i * n;
+        for (int64 j = 0; j < n; ++j) {
+          float value = static_cast<float>(acc_row[j].value) * mult[j] + add[j];
+          if (!std::is_same<Toutput, float>::value) value = std::round(value);
+          value = std::min(std::max(value, out_lowest), out_highest);
+          out_row[j] = static_cast<Toutput>(value);
+        }
+      }
+    };
+    auto& worker_threads =
+        *(context->device()->tensorflow_cpu_worker_threads());
+    Shard(worker_threads.num_threads, worker_threads.workers, m, 6 * n,
+          epilogue);
+  }
+
+ private:
+  bool transpose_a_;
+  bool transpose_b_;
+  bool min_first_;
+};
+
+#ifndef INTEL_MKL
+#define REGISTER_WITH_BIAS(OP, Tbias, Toutput, Relu)             \
+  REGISTER_KERNEL_BUILDER(Name(OP)                                 \
+                              .Device(DEVICE_CPU)                  \
+                              .TypeConstraint<quint8>("T1")        \
+                              .TypeConstraint<qint8>("T2")         \
+                              .TypeConstraint<Tbias>("Tbias")      \
+                              .TypeConstraint<Toutput>("Toutput"), \
+                          QuantizedMatMulWithBiasOp<Tbias, Toutput, Relu>)
+
+#define REGISTER_ALL_BIAS(OP, Toutput, Relu)    \
+  REGISTER_WITH_BIAS(OP, float, Toutput, Relu); \
+  REGISTER_WITH_BIAS(OP, qint32, Toutput, Relu)
+
+REGISTER_ALL_BIAS("QuantizedMatMulWithBias", qint32, false);
+REGISTER_ALL_BIAS("QuantizedMatMulWithBiasAndRequantize", quint8, false);
+REGISTER_ALL_BIAS("QuantizedMatMulWithBiasAndRequantize", qint8, false);
+REGISTER_ALL_BIAS("QuantizedMatMulWithBiasAndReluAndRequantize", quint8, true);
+REGISTER_ALL_BIAS("QuantizedMatMulWithBiasAndDequantize", float, false);
+// QuantizedMatMulWithBiasAndRelu only takes a float bias.
+REGISTER_KERNEL_BUILDER(Name("QuantizedMatMulWithBiasAndRelu")
+                            .Device(DEVICE_CPU)
+                            .TypeConstraint<quint8>("T1")
+                            .TypeConstraint<qint8>("T2")
+                            .TypeConstraint<qint32>("Toutput"),
+                        QuantizedMatMulWithBiasOp<float, qint32, true>);
+
+#undef REGISTER_ALL_BIAS
+#undef REGISTER_WITH_BIAS
+#endif  // INTEL_MKL
+
 }  // namespace tensorflow
@@ -355,4 +355,209 @@ TEST_F(QuantizedMatMulTest, Medium_WithParams) {
   test::ExpectTensorNear<float>(expected_float, output_float, 15.0);
 }
 
+#ifndef INTEL_MKL
+class QuantizedMatMulWithBiasTest : public OpsTestBase {
+ protected:
+  // Runs `op` on a [3, 5] quint8 a and a [5, 4] qint8 b, with num_b_ranges
+  // ranges for b, and compares the dequantized output with the float product
+  // of the dequantized inputs.
+  void RunAndCompare(const string& op, DataType bias_type, DataType out_type,
+                     bool transpose_b, int num_b_ranges, const string& mode,
+                     bool relu) {
+    const int m = 3;
+    const int k = 5;
+    const int n = 4;
+    const bool min_first = mode == "MIN_FIRST";
+    const bool requantize =
+        out_type == DT_QUINT8 || out_type == DT_QINT8 || out_type == DT_FLOAT;
+    NodeDefBuilder builder("quantized_mat_mul_op", op);
+    builder.Input(FakeInput(DT_QUINT8))
+        .Input(FakeInput(DT_QINT8))
+        .Input(FakeInput(bias_type))
+        .Input(FakeInput(DT_FLOAT))
+        .Input(FakeInput(DT_FLOAT))
+        .Input(FakeInput(DT_FLOAT))
+        .Input(FakeInput(DT_FLOAT));
+    if (requantize) {
+      builder.Input(FakeInput(DT_FLOAT)).Input(FakeInput(DT_FLOAT));
+    }
+    if (op != "QuantizedMatMulWithBiasAndRelu") {
+      builder.Attr("Tbias", bias_type);
+    }
+    TF_ASSERT_OK(builder.Attr("Toutput", out_type)
+                     .Attr("transpose_b", transpose_b)
+                     .Attr("input_quant_mode", mode)
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+
+    const float min_a = min_first ? -2.0f : 0.0f;
+    const float max_a = 6.0f;
+    const float scale_a = min_first ? (max_a - min_a) / 255 : max_a / 255;
+    std::vector<quint8> a(m * k);
+    std::vector<float> a_float(m * k);
+    for (int i = 0; i < m * k; ++i) {
+      a[i] = (i * 37 + 11) % 256;
+      a_float[i] = (min_first ? min_a : 0.0f) + a[i].value * scale_a;
+    }
+    std::vector<float> min_b(num_b_ranges);
+    std::vector<float> max_b(num_b_ranges);
+    for (int j = 0; j < num_b_ranges; ++j) {
+      max_b[j] = 0.5f * (j + 1);
+      min_b[j] = -max_b[j];
+    }
+    // b is stored as [n, k] when transposed.
+    std::vector<qint8> b(k * n);
+    std::vector<float> b_float(k * n);
+    for (int r = 0; r < k; ++r) {
+      for (int c = 0; c < n; ++c) {
+        const int index = transpose_b ? c * k + r : r * n + c;
+        b[index] = static_cast<int8>((r * 29 + c * 13) % 255 - 127);
+        b_float[r * n + c] = b[index].value * max_b[c % num_b_ranges] / 127;
+      }
+    }
+    std::vector<float> bias_float(n);
+    for (int j = 0; j < n; ++j) bias_float[j] = 0.25f * j - 0.5f;
+    std::vector<qint32> bias_quantized(n);
+    if (bias_type == DT_QINT32) {
+      for (int j = 0; j < n; ++j) {
+        const float scale_b = max_b[j % num_b_ranges] / 127;
+        bias_quantized[j] = static_cast<int32>(10000 * j - 15000);
+        bias_float[j] = bias_quantized[j].value * scale_a * scale_b;
+      }
+    }
+
+    std::vector<float> expected(m * n);
+    float min_expected = 0.0f;
+    float max_expected = 0.0f;
+    for (int i = 0; i < m; ++i) {
+      for (int j = 0; j < n; ++j) {
+        float sum = bias_float[j];
+        for (int c = 0; c < k; ++c) {
+          sum += a_float[i * k + c] * b_float[c * n + j];
+        }
+        if (relu) sum = std::max(sum, 0.0f);
+        expected[i * n + j] = sum;
+        min_expected = std::min(min_expected, sum);
+        max_expected = std::max(max_expected, sum);
+      }
+    }
+
+    AddInputFromArray<quint8>(TensorShape({m, k}), a);
+    AddInputFromArray<qint8>(
+        transpose_b ? TensorShape({n, k}) : TensorShape({k, n}), b);
+    if (bias_type == DT_QINT32) {
+      AddInputFromArray<qint32>(TensorShape({n}), bias_quantized);
+    } else {
+      AddInputFromArray<float>(TensorShape({n}), bias_float);
+    }
+    AddInputFromArray<float>(TensorShape({}), {min_a});
+    AddInputFromArray<float>(TensorShape({}), {max_a});
+    const TensorShape b_range_shape =
+        num_b_ranges == 1 ? TensorShape({}) : TensorShape({num_b_ranges});
+    AddInputFromArray<float>(b_range_shape, min_b);
+    AddInputFromArray<float>(b_range_shape, max_b);
+    if (requantize) {
+      AddInputFromArray<float>(TensorShape({}), {min_expected - 1.0f});
+      AddInputFromArray<float>(TensorShape({}), {max_expected + 1.0f});
+    }
+    TF_ASSERT_OK(RunOpKernel());
+
+    Tensor expected_tensor(DT_FLOAT, TensorShape({m, n}));
+    test::FillValues<float>(&expected_tensor, expected);
+    const Tensor& output = *GetOutput(0);
+    if (out_type == DT_FLOAT) {
+      test::ExpectTensorNear<float>(expected_tensor, output, 1e-4);
+      return;
+    }
+    const float output_min = GetOutput(1)->flat<float>()(0);
+    const float output_max = GetOutput(2)->flat<float>()(0);
+    if (out_type == DT_QINT32) {
+      test::ExpectTensorNear<float>(
+          expected_tensor,
+          QuantizedTensorToFloat<qint32>(output, output_min, output_max),
+          1e-3);
+      return;
+    }
+    EXPECT_EQ(min_expected - 1.0f, output_min);
+    EXPECT_EQ(max_expected + 1.0f, output_max);
+    // Half a step of rounding, and the rounding of the ranges.
+    const float tolerance = (output_max - output_min) / 255;
+    if (out_type == DT_QUINT8) {
+      test::ExpectTensorNear<float>(
+          expected_tensor,
+          QuantizedTensorToFloat<quint8>(output, output_min, output_max),
+          tolerance);
+    } else {
+      test::ExpectTensorNear<float>(
+          expected_tensor,
+          QuantizedTensorToFloat<qint8>(output, output_min, output_max),
+          tolerance);
+    }
+  }
+};
+
+TEST_F(QuantizedMatMulWithBiasTest, Int32Output) {
+  RunAndCompare("QuantizedMatMulWithBias", DT_FLOAT, DT_QINT32, false, 1,
+                "MIN_FIRST", false);
+}
+
+TEST_F(QuantizedMatMulWithBiasTest, Int32OutputPerChannel) {
+  RunAndCompare("QuantizedMatMulWithBias", DT_FLOAT, DT_QINT32, true, 4,
+                "MIN_FIRST", false);
+}
+
+TEST_F(QuantizedMatMulWithBiasTest, Int32Bias) {
+  RunAndCompare("QuantizedMatMulWithBias", DT_QINT32, DT_QINT32, false, 4,
+                "SCALED", false);
+}
+
+TEST_F(QuantizedMatMulWithBiasTest, Relu) {
+  RunAndCompare("QuantizedMatMulWithBiasAndRelu", DT_FLOAT, DT_QINT32, false,
+                1, "MIN_FIRST", true);
+}
+
+TEST_F(QuantizedMatMulWithBiasTest, Requantize) {
+  RunAndCompare("QuantizedMatMulWithBiasAndRequantize", DT_FLOAT, DT_QUINT8,
+                false, 4, "MIN_FIRST", false);
+}
+
+TEST_F(QuantizedMatMulWithBiasTest, RequantizeToInt8) {
+  RunAndCompare("QuantizedMatMulWithBiasAndRequantize", DT_FLOAT, DT_QINT8,
+                true, 1, "SCALED", false);
+}
+
+TEST_F(QuantizedMatMulWithBiasTest, ReluAndRequantize) {
+  RunAndCompare("QuantizedMatMulWithBiasAndReluAndRequantize", DT_QINT32,
+                DT_QUINT8, true, 4, "SCALED", true);
+}
+
+TEST_F(QuantizedMatMulWithBiasTest, Dequantize) {
+  RunAndCompare("QuantizedMatMulWithBiasAndDequantize", DT_FLOAT, DT_FLOAT,
+                false, 4, "MIN_FIRST", false);
+}
+
+TEST_F(QuantizedMatMulWithBiasTest, WrongNumberOfRanges) {
+  TF_ASSERT_OK(NodeDefBuilder("quantized_mat_mul_op", "QuantizedMatMulWithBias")
+                   .Input(FakeInput(DT_QUINT8))
+                   .Input(FakeInput(DT_QINT8))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Attr("Tbias", DT_FLOAT)
+                   .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+  AddInputFromArray<quint8>(TensorShape({1, 2}), {1, 2});
+  AddInputFromArray<qint8>(TensorShape({2, 3}), {1, 2, 3, 4, 5, 6});
+  AddInputFromArray<float>(TensorShape({3}), {0, 0, 0});
+  AddInputFromArray<float>(TensorShape({}), {0});
+  AddInputFromArray<float>(TensorShape({}), {1});
+  AddInputFromArray<float>(TensorShape({2}), {-1, -1});
+  AddInputFromArray<float>(TensorShape({2}), {1, 1});
+  Status s = RunOpKernel();
+  EXPECT_TRUE(errors::IsInvalidArgument(s)) << s;
+}
+#endif  // INTEL_MKL
+
 }  // namespace tensorflow
@@ -0,0 +1,373 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Kernels that compute over the rows of a ragged tensor directly from its
+// `row_splits` and `flat_values`, without padding it to a dense tensor.
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "third_party/eigen3/Eigen/Core"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/util/work_sharder.h"
+
+namespace tensorflow {
+
+using errors::InvalidArgument;
+
+namespace {
+
+// Checks that `splits` are the row splits of a ragged tensor whose flat values
+// have `nvals` rows.
+template <typename SPLITS_TYPE>
+Status ValidateRowSplits(const Tensor& splits, int64 nvals) {
+  if (splits.dims() != 1 || splits.NumElements() == 0) {
+    return InvalidArgument("rt_row_splits must be a non-empty vector, got ",
+                           splits.shape().DebugString());
+  }
+  const auto flat = splits.flat<SPLITS_TYPE>();
+  if (flat(0) != 0) {
+    return InvalidArgument("rt_row_splits must start with 0, got ", flat(0));
+  }
+  for (int64 i = 1; i < flat.size(); ++i) {
+    if (flat(i) < flat(i - 1)) {
+      return InvalidArgument("rt_row_splits must be sorted, got ", flat(i - 1),
+                             " followed by ", flat(i));
+    }
+  }
+  if (flat(flat.size() - 1) != nvals) {
+    return InvalidArgument("rt_row_splits must end with the number of values ",
+                           nvals, ", got ", flat(flat.size() - 1));
+  }
+  return Status::OK();
+}
+
+// Runs `work(begin, end)` on the rows [begin, end) of a ragged tensor with
+// `nrows` rows, in parallel when the rows cost about `cost_per_row` cycles.
+template <typename Work>
+void ShardRows(OpKernelContext* context, int64 nrows, int64 cost_per_row,
+               Work work) {
+  auto worker_threads = context->device()->tensorflow_cpu_worker_threads();
+  Shard(worker_threads->num_threads, worker_threads->workers, nrows,
+        std::max<int64>(cost_per_row, 1), work);
+}
+
+// The type in which values of type T are accumulated.
+template <typename T>
+using AccumulatorType =
+    typename std::conditional<std::is_same<T, double>::value, double,
+                              float>::type;
+
+}  // namespace
+
+// Computes a softmax over each row of a ragged tensor, separately for every
+// inner element of its values.
+template <typename T, typename SPLITS_TYPE>
+class RaggedSegmentSoftmaxOp : public OpKernel {
+ public:
+  using OpKernel::OpKernel;
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& splits_in = context->input(0);
+    const Tensor& values_in = context->input(1);
+    OP_REQUIRES(context, values_in.dims() >= 1,
+                InvalidArgument("rt_dense_values must have rank at least 1"));
+    const int64 nvals = values_in.dim_size(0);
+    OP_REQUIRES_OK(context, ValidateRowSplits<SPLITS_TYPE>(splits_in, nvals));
+
+    Tensor* values_out = nullptr;
+    OP_REQUIRES_OK(context,
+                   context->forward_input_or_allocate_output(
+                       {1}, 0, values_in.shape(), &values_out));
+    if (values_in.NumElements() == 0) return;
+
+    const auto splits = splits_in.flat<SPLITS_TYPE>();
+    const auto values = values_in.flat_outer_dims<T>();
+    auto output = values_out->flat_outer_dims<T>();
+    const int64 nrows = splits.size() - 1;
+    const int64 inner = values.dimension(1);
+
+    auto work = [&](int64 begin, int64 end) {
+      std::vector<Acc> max(inner);
+      std::vector<Acc> sum(inner);
+      for (int64 row = begin; row < end; ++row) {
+        const int64 start = splits(row);
+        const int64 limit = splits(row + 1);
+        if (start == limit) continue;
+        for (int64 j = 0; j < inner; ++j) {
+          max[j] = static_cast<Acc>(values(start, j));
+        }
+        for (int64 i = start + 1; i < limit; ++i) {
+          for (int64 j = 0; j < inner; ++j) {
+            max[j] = std::max(max[j], static_cast<Acc>(values(i, j)));
+          }
+        }
+        std::fill(sum.begin(), sum.end(), Acc(0));
+        for (int64 i = start; i < limit; ++i) {
+          for (int64 j = 0; j < inner; ++j) {
+            const Acc e = std::exp(static_cast<Acc>(values(i, j)) - max[j]);
+            sum[j] += e;
+            output(i, j) = static_cast<T>(e);
+          }
+        }
+        for (int64 i = start; i < limit; ++i) {
+          for (int64 j = 0; j < inner; ++j) {
+            output(i, j) =
+                static_cast<T>(static_cast<Acc>(output(i, j)) / sum[j]);
+          }
+        }
+      }
+    };
+    // Each value is read three times and goes through an exponential.
+    ShardRows(context, nrows,
+              (nvals / std::max<int64>(nrows, 1) + 1) * inner *
+                  (3 * Eigen::TensorOpCost::AddCost<Acc>() +
+                   Eigen::TensorOpCost::DivCost<Acc>() + 20),
+              work);
+  }
+
+ private:
+  using Acc = AccumulatorType<T>;
+};
+
+#define REGISTER_CPU_KERNEL(TYPE)                                \
+  REGISTER_KERNEL_BUILDER(Name("RaggedSegmentSoftmax")           \
+                              .Device(DEVICE_CPU)                \
+                              .TypeConstraint<TYPE>("T")         \
+                              .TypeConstraint<int32>("Tsplits"), \
+                          RaggedSegmentSoftmaxOp<TYPE, int32>);  \
+  REGISTER_KERNEL_BUILDER(Name("RaggedSegmentSoftmax")           \
+                              .Device(DEVICE_CPU)                \
+                              .TypeConstraint<TYPE>("T")         \
+                              .TypeConstraint<int64>("Tsplits"), \
+                          RaggedSegmentSoftmaxOp<TYPE, int64>);
+TF_CALL_bfloat16(REGISTER_CPU_KERNEL);
+TF_CALL_half(REGISTER_CPU_KERNEL);
+TF_CALL_float(REGISTER_CPU_KERNEL);
+TF_CALL_double(REGISTER_CPU_KERNEL);
+#undef REGISTER_CPU_KERNEL
+
+// Reduces each row of a ragged tensor to a single row of values. Empty rows
+// reduce to the identity of the reduction: 0 for "sum", 1 for "prod" and the
+// lowest and highest value of T for "max" and "min", as the unsorted segment
+// reductions do. The mean of an empty row is 0.
+template <typename T, typename SPLITS_TYPE>
+class RaggedSegmentReduceOp : public OpKernel {
+ public:
+  explicit RaggedSegmentReduceOp(OpKernelConstruction* context)
+      : OpKernel(context) {
+    string reduction;
+    OP_REQUIRES_OK(context, context->GetAttr("reduction", &reduction));
+    if (reduction == "sum") {
+      reduction_ = Reduction::kSum;
+    } else if (reduction == "mean") {
+      reduction_ = Reduction::kMean;
+    } else if (reduction == "max") {
+      reduction_ = Reduction::kMax;
+    } else if (reduction == "min") {
+      reduction_ = Reduction::kMin;
+    } else if (reduction == "prod") {
+      reduction_ = Reduction::kProd;
+    } else {
+      OP_REQUIRES(context, false,
+                  InvalidArgument("Unknown reduction: ", reduction));
+    }
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& splits_in = context->input(0);
+    const Tensor& values_in = context->input(1);
+    OP_REQUIRES(context, values_in.dims() >= 1,
+                InvalidArgument("rt_dense_values must have rank at least 1"));
+    const int64 nvals = values_in.dim_size(0);
+    OP_REQUIRES_OK(context, ValidateRowSplits<SPLITS_TYPE>(splits_in, nvals));
+
+    const auto splits = splits_in.flat<SPLITS_TYPE>();
+    const int64 nrows = splits.size() - 1;
+    TensorShape output_shape = values_in.shape();
+    output_shape.set_dim(0, nrows);
+    Tensor* output_out = nullptr;
+    OP_REQUIRES_OK(context,
+                   context->allocate_output(0, output_shape, &output_out));
+    if (output_out->NumElements() == 0) return;
+
+    const auto values = values_in.flat_outer_dims<T>();
+    auto output = output_out->flat_outer_dims<T>();
+    const int64 inner = output.dimension(1);
+
+    auto work = [&](int64 begin, int64 end) {
+      for (int64 row = begin; row < end; ++row) {
+        const int64 start = splits(row);
+        const int64 limit = splits(row + 1);
+        T* out = &output(row, 0);
+        std::fill(out, out + inner, Identity());
+        for (int64 i = start; i < limit; ++i) {
+          const T* in = &values(i, 0);
+          switch (reduction_) {
+            case Reduction::kSum:
+            case Reduction::kMean:
+              for (int64 j = 0; j < inner; ++j) out[j] += in[j];
+              break;
+            case Reduction::kMax:
+              for (int64 j = 0; j < inner; ++j) {
+                out[j] = std::max(out[j], in[j]);
+              }
+              break;
+            case Reduction::kMin:
+              for (int64 j = 0; j < inner; ++j) {
+                out[j] = std::min(out[j], in[j]);
+              }
+              break;
+            case Reduction::kProd:
+              for (int64 j = 0; j < inner; ++j) out[j] *= in[j];
+              break;
+          }
+        }
+        if (reduction_ == Reduction::kMean && limit > start) {
+          const T count = static_cast<T>(limit - start);
+          for (int64 j = 0; j < inner; ++j) out[j] /= count;
+        }
+      }
+    };
+    ShardRows(context, nrows,
+              (nvals / nrows + 1) * inner * Eigen::TensorOpCost::AddCost<T>(),
+              work);
+  }
+
+ private:
+  enum class Reduction { kSum, kMean, kMax, kMin, kProd };
+
+  T Identity() const {
+    switch (reduction_) {
+      case Reduction::kMax:
+        return std::numeric_limits<T>::lowest();
+      case Reduction::kMin:
+        return std::numeric_limits<T>::max();
+      case Reduction::kProd:
+        return T(1);
+      default:
+        return T(0);
+    }
+  }
+
+  Reduction reduction_;
+};
+
+#define REGISTER_CPU_KERNEL(TYPE)                                \
+  REGISTER_KERNEL_BUILDER(Name("RaggedSegmentReduce")            \
+                              .Device(DEVICE_CPU)                \
+                              .TypeConstraint<TYPE>("T")         \
+                              .TypeConstraint<int32>("Tsplits"), \
+                          RaggedSegmentReduceOp<TYPE, int32>);   \
+  REGISTER_KERNEL_BUILDER(Name("RaggedSegmentReduce")            \
+                              .Device(DEVICE_CPU)                \
+                              .TypeConstraint<TYPE>("T")         \
+                              .TypeConstraint<int64>("Tsplits"), \
+                          RaggedSegmentReduceOp<TYPE, int64>);
+TF_CALL_float(REGISTER_CPU_KERNEL);
+TF_CALL_double(REGISTER_CPU_KERNEL);
+TF_CALL_int32(REGISTER_CPU_KERNEL);
+TF_CALL_int64(REGISTER_CPU_KERNEL);
+#undef REGISTER_CPU_KERNEL
+
+// Multiplies row i of a ragged tensor, a [row_length(i), k] matrix, by the
+// [k, m] matrix b[i]. The products are the flat values of a ragged tensor with
+// the same row splits.
+template <typename T, typename SPLITS_TYPE>
+class RaggedBatchMatMulOp : public OpKernel {
+ public:
+  using OpKernel::OpKernel;
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& splits_in = context->input(0);
+    const Tensor& values_in = context->input(1);
+    const Tensor& b_in = context->input(2);
+    OP_REQUIRES(context, values_in.dims() == 2,
+                InvalidArgument("rt_dense_values must be a matrix, got ",
+                                values_in.shape().DebugString()));
+    OP_REQUIRES(context, b_in.dims() == 3,
+                InvalidArgument("b must have rank 3, got ",
+                                b_in.shape().DebugString()));
+    const int64 nvals = values_in.dim_size(0);
+    OP_REQUIRES_OK(context, ValidateRowSplits<SPLITS_TYPE>(splits_in, nvals));
+    const auto splits = splits_in.flat<SPLITS_TYPE>();
+    const int64 nrows = splits.size() - 1;
+    OP_REQUIRES(context, b_in.dim_size(0) == nrows,
+                InvalidArgument("b must have one matrix per row: ", nrows,
+                                " rows but ", b_in.dim_size(0), " matrices"));
+    const int64 k = values_in.dim_size(1);
+    OP_REQUIRES(context, b_in.dim_size(1) == k,
+                InvalidArgument("The inner dimensions of rt_dense_values and b "
+                                "must match: ",
+                                k, " vs. ", b_in.dim_size(1)));
+    const int64 m = b_in.dim_size(2);
+
+    Tensor* output_out = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(
+                                0, TensorShape({nvals, m}), &output_out));
+    if (output_out->NumElements() == 0) return;
+    if (k == 0) {
+      output_out->flat<T>().setZero();
+      return;
+    }
+
+    using Matrix =
+        Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+    const T* values = values_in.flat<T>().data();
+    const T* b = b_in.flat<T>().data();
+    T* output = output_out->flat<T>().data();
+
+    auto work = [&](int64 begin, int64 end) {
+      for (int64 row = begin; row < end; ++row) {
+        const int64 start = splits(row);
+        const int64 length = splits(row + 1) - start;
+        if (length == 0) continue;
+        Eigen::Map<const Matrix> lhs(values + start * k, length, k);
+        Eigen::Map<const Matrix> rhs(b + row * k * m, k, m);
+        Eigen::Map<Matrix> product(output + start * m, length, m);
+        product.noalias() = lhs * rhs;
+      }
+    };
+    ShardRows(context, nrows,
+              (nvals / nrows + 1) * k * m *
+                  (Eigen::TensorOpCost::AddCost<T>() +
+                   Eigen::TensorOpCost::MulCost<T>()),
+              work);
+  }
+};
+
+#define REGISTER_CPU_KERNEL(TYPE)                                \
+  REGISTER_KERNEL_BUILDER(Name("RaggedBatchMatMul")              \
+                              .Device(DEVICE_CPU)                \
+                              .TypeConstraint<TYPE>("T")         \
+                              .TypeConstraint<int32>("Tsplits"), \
+                          RaggedBatchMatMulOp<TYPE, int32>);     \
+  REGISTER_KERNEL_BUILDER(Name("RaggedBatchMatMul")              \
+                              .Device(DEVICE_CPU)                \
+                              .TypeConstraint<TYPE>("T")         \
+                              .TypeConstraint<int64>("Tsplits"), \
+                          RaggedBatchMatMulOp<TYPE, int64>);
+TF_CALL_float(REGISTER_CPU_KERNEL);
+TF_CALL_double(REGISTER_CPU_KERNEL);
+#undef REGISTER_CPU_KERNEL
+
+}  // namespace tensorflow
@@ -0,0 +1,145 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <cmath>
+#include <limits>
+
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/shape_inference.h"
+#include "tensorflow/core/framework/shape_inference_testutil.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+class RaggedSegmentOpsTest : public ::tensorflow::OpsTestBase {
+ protected:
+  // Builds the tensorflow test graph for a ragged segment op on float values
+  // with int64 row splits.
+  void BuildGraph(const string& op, int num_extra_inputs,
+                  const string& reduction = "") {
+    NodeDefBuilder builder("tested_op", op);
+    builder.Input(FakeInput(DT_INT64))  // rt_row_splits
+        .Input(FakeInput(DT_FLOAT));  // rt_dense_values
+    for (int i = 0; i < num_extra_inputs; ++i) {
+      builder.Input(FakeInput(DT_FLOAT));
+    }
+    if (!reduction.empty()) {
+      builder.Attr("reduction", reduction);
+    }
+    TF_ASSERT_OK(builder.Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+  }
+};
+
+TEST_F(RaggedSegmentOpsTest, Softmax) {
+  BuildGraph("RaggedSegmentSoftmax", 0);
+  // rt = [[[0, 1], [0, 3]], [], [[5, 5]]]
+  AddInputFromArray<int64>(TensorShape({4}), {0, 2, 2, 3});
+  AddInputFromArray<float>(TensorShape({3, 2}), {0, 1, 0, 3, 5, 5});
+  TF_ASSERT_OK(RunOpKernel());
+
+  const float e2 = std::exp(2.0f);
+  test::ExpectTensorNear<float>(
+      *GetOutput(0),
+      test::AsTensor<float>({0.5, 1 / (1 + e2), 0.5, e2 / (1 + e2), 1, 1},
+                            {3, 2}),
+      1e-5);
+}
+
+TEST_F(RaggedSegmentOpsTest, ReduceSum) {
+  BuildGraph("RaggedSegmentReduce", 0, "sum");
+  // rt = [[1, 2, 3], [], [4, 5]]
+  AddInputFromArray<int64>(TensorShape({4}), {0, 3, 3, 5});
+  AddInputFromArray<float>(TensorShape({5}), {1, 2, 3, 4, 5});
+  TF_ASSERT_OK(RunOpKernel());
+
+  test::ExpectTensorEqual<float>(*GetOutput(0),
+                                 test::AsTensor<float>({6, 0, 9}));
+}
+
+TEST_F(RaggedSegmentOpsTest, ReduceMeanOfInnerDimensions) {
+  BuildGraph("RaggedSegmentReduce", 0, "mean");
+  // rt = [[[1, 2], [3, 6]], [[5, 7]], []]
+  AddInputFromArray<int64>(TensorShape({4}), {0, 2, 3, 3});
+  AddInputFromArray<float>(TensorShape({3, 2}), {1, 2, 3, 6, 5, 7});
+  TF_ASSERT_OK(RunOpKernel());
+
+  test::ExpectTensorEqual<float>(
+      *GetOutput(0), test::AsTensor<float>({2, 4, 5, 7, 0, 0}, {3, 2}));
+}
+
+TEST_F(RaggedSegmentOpsTest, ReduceMax) {
+  BuildGraph("RaggedSegmentReduce", 0, "max");
+  AddInputFromArray<int64>(TensorShape({3}), {0, 3, 3});
+  AddInputFromArray<float>(TensorShape({3}), {-1, -7, -2});
+  TF_ASSERT_OK(RunOpKernel());
+
+  test::ExpectTensorEqual<float>(
+      *GetOutput(0),
+      test::AsTensor<float>({-1, std::numeric_limits<float>::lowest()}));
+}
+
+TEST_F(RaggedSegmentOpsTest, BatchMatMul) {
+  BuildGraph("RaggedBatchMatMul", 1);
+  // rt = [[[1, 2]], [], [[1, 0], [0, 1]]]
+  AddInputFromArray<int64>(TensorShape({4}), {0, 1, 1, 3});
+  AddInputFromArray<float>(TensorShape({3, 2}), {1, 2, 1, 0, 0, 1});
+  // b = [[[1, 1], [1, 2]], [[0, 0], [0, 0]], [[3, 4], [5, 6]]]
+  AddInputFromArray<float>(TensorShape({3, 2, 2}),
+                           {1, 1, 1, 2, 0, 0, 0, 0, 3, 4, 5, 6});
+  TF_ASSERT_OK(RunOpKernel());
+
+  test::ExpectTensorEqual<float>(
+      *GetOutput(0), test::AsTensor<float>({3, 5, 3, 4, 5, 6}, {3, 2}));
+}
+
+TEST_F(RaggedSegmentOpsTest, InvalidRowSplits) {
+  BuildGraph("RaggedSegmentReduce", 0, "sum");
+  AddInputFromArray<int64>(TensorShape({3}), {0, 3, 2});
+  AddInputFromArray<float>(TensorShape({2}), {1, 2});
+  EXPECT_TRUE(errors::IsInvalidArgument(RunOpKernel()));
+}
+
+TEST_F(RaggedSegmentOpsTest, BatchMatMulMismatchedBatch) {
+  BuildGraph("RaggedBatchMatMul", 1);
+  AddInputFromArray<int64>(TensorShape({2}), {0, 1});
+  AddInputFromArray<float>(TensorShape({1, 2}), {1, 2});
+  AddInputFromArray<float>(TensorShape({2, 2, 1}), {1, 1, 1, 1});
+  EXPECT_TRUE(errors::IsInvalidArgument(RunOpKernel()));
+}
+
+TEST(RaggedSegmentOpsShapeTest, Shapes) {
+  ShapeInferenceTestOp reduce("RaggedSegmentReduce");
+  INFER_OK(reduce, "[4];[?,2,3]", "[3,d1_1,d1_2]");
+  INFER_OK(reduce, "?;[?]", "[?]");
+  INFER_ERROR("must be at least rank 1", reduce, "[4];[]");
+
+  ShapeInferenceTestOp softmax("RaggedSegmentSoftmax");
+  INFER_OK(softmax, "[4];[?,2]", "in1");
+
+  ShapeInferenceTestOp matmul("RaggedBatchMatMul");
+  INFER_OK(matmul, "[4];[?,2];[?,?,5]", "[d1_0,d2_2]");
+  INFER_ERROR("Dimensions must be equal", matmul, "[4];[?,2];[2,2,5]");
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -26,14 +26,17 @@ limitations under the License.
 #include "tensorflow/core/framework/node_def_builder.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/types.pb.h"
 #include "tensorflow/core/kernels/ops_testutil.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/public/session_options.h"
 #include "tensorflow/core/public/version.h"
+#include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
 
 namespace tensorflow {
 namespace {
@@ -60,6 +63,17 @@ class RestoreV2OpTest : public OpsTestBase {
     TF_ASSERT_OK(InitOp());
   }
 
+  // Makes an operation to restore tensors of the given types.
+  void MakeRestoreOp(const DataTypeVector& dtypes) {
+    TF_ASSERT_OK(NodeDefBuilder("myop", "RestoreV2")
+                     .Input(FakeInput())  // prefix
+                     .Input(FakeInput())  // tensor_names
+                     .Input(FakeInput())  // shape_and_slices
+                     .Attr("dtypes", dtypes)
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+  }
+
   void RunTest(StringPiece save_op_to_use) {
     const string filename =
         io::JoinPath(testing::TmpDir(), "tensor_simple-", save_op_to_use);
@@ -356,5 +370,48 @@ TEST_F(RestoreV2OpTest, RestoreAfterSaveV2) { RunTest("SaveV2"); }
 TEST_F(RestoreV2OpTest, RestoreAfterSaveSlicesV1) { RunTest("SaveSlices"); }
 TEST_F(RestoreV2OpTest, RestoreAfterSaveV1) { RunTest("Save"); }
 
+// Tensors in several data files, which are restored in parallel groups.
+TEST_F(RestoreV2OpTest, RestoreFromDataShards) {
+  const string prefix = io::JoinPath(testing::TmpDir(), "tensor_shards");
+  const int kNumFloatTensors = 4;
+  const int64 kNumElements = 1 << 20;
+  std::vector<string> tensor_names;
+  {
+    BundleWriter::Options options;
+    options.num_data_shards = 2;
+    BundleWriter writer(Env::Default(), prefix, options);
+    for (int t = 0; t < kNumFloatTensors; ++t) {
+      tensor_names.push_back(strings::StrCat("tensor_float_", t));
+      TF_ASSERT_OK(writer.Add(
+          tensor_names.back(),
+          MakeInput<float>(TensorShape({kNumElements}),
+                           [t](int x) -> float { return x + t; })));
+    }
+    tensor_names.push_back("tensor_int");
+    TF_ASSERT_OK(writer.Add(tensor_names.back(),
+                            test::AsTensor<int32>({1, 2, 3}, {3})));
+    TF_ASSERT_OK(writer.Finish());
+  }
+
+  DataTypeVector dtypes(kNumFloatTensors, DT_FLOAT);
+  dtypes.push_back(DT_INT32);
+  MakeRestoreOp(dtypes);
+  AddInput<tstring>(TensorShape({}),
+                    [&prefix](int x) -> tstring { return prefix; });
+  AddInput<tstring>(TensorShape({kNumFloatTensors + 1}),
+                    [&](int x) -> tstring { return tensor_names[x]; });
+  AddInput<tstring>(TensorShape({kNumFloatTensors + 1}),
+                    [](int x) -> tstring { return ""; });
+  TF_ASSERT_OK(RunOpKernel());
+  for (int t = 0; t < kNumFloatTensors; ++t) {
+    test::ExpectTensorEqual<float>(
+        MakeInput<float>(TensorShape({kNumElements}),
+                         [t](int x) -> float { return x + t; }),
+        *GetOutput(t));
+  }
+  test::ExpectTensorEqual<int32>(test::AsTensor<int32>({1, 2, 3}, {3}),
+                                 *GetOutput(kNumFloatTensors));
+}
+
 }  // namespace
 }  // namespace tensorflow
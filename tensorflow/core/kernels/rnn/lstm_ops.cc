@@ -21,6 +21,7 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/rnn/lstm_ops.h"
 
+#include <algorithm>
 #include <memory>
 #include <vector>
 
@@ -33,6 +34,7 @@ limitations under the License.
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
@@ -825,6 +827,192 @@ class SliceHelper {
 
 }  // namespace
 
+namespace functor {
+
+// Runs the forward pass of BlockLSTM over timesteps [0, seq_len_max) in one
+// call, on the devices where kSupported is true. The others run
+// LSTMBlockCellFprop for every timestep instead.
+template <typename Device, typename T, GateLayout gate_layout>
+struct BlockLSTMFusedFprop {
+  static constexpr bool kSupported = false;
+
+  Status operator()(OpKernelContext* ctx, const float forget_bias,
+                    const float cell_clip, const bool use_peephole,
+                    const int64 seq_len_max, const Tensor& x,
+                    const Tensor& cs_prev, const Tensor& h_prev,
+                    const Tensor& w, const Tensor& wci, const Tensor& wcf,
+                    const Tensor& wco, const Tensor& b, Tensor* i, Tensor* cs,
+                    Tensor* f, Tensor* o, Tensor* ci, Tensor* co, Tensor* h) {
+    return errors::Unimplemented("Fused BlockLSTM is not supported.");
+  }
+};
+
+// On CPU the input projections x[t] * w_x of many timesteps are computed by a
+// single matrix product, which packs w_x once for all of them, and every
+// timestep is left with h[t - 1] * w_h only. The activations of the gates of
+// an example then run in one pass over its row of gates while it is in cache,
+// and write the outputs directly instead of going through temporaries.
+template <typename T, GateLayout gate_layout>
+struct BlockLSTMFusedFprop<CPUDevice, T, gate_layout> {
+  static constexpr bool kSupported = true;
+
+  // The most gates computed at once by the input projection.
+  static constexpr int64 kMaxProjectedGates = 1 << 22;
+
+  Status operator()(OpKernelContext* ctx, const float forget_bias,
+                    const float cell_clip, const bool use_peephole,
+                    const int64 seq_len_max, const Tensor& x,
+                    const Tensor& cs_prev, const Tensor& h_prev,
+                    const Tensor& w, const Tensor& wci, const Tensor& wcf,
+                    const Tensor& wco, const Tensor& b, Tensor* i, Tensor* cs,
+                    Tensor* f, Tensor* o, Tensor* ci, Tensor* co, Tensor* h) {
+    const CPUDevice& d = ctx->eigen_device<CPUDevice>();
+    const int64 batch_size = x.dim_size(1);
+    const int64 input_size = x.dim_size(2);
+    const int64 cell_size = cs_prev.dim_size(1);
+    const int64 num_gates = cell_size * 4;
+    if (seq_len_max <= 0 || batch_size == 0 || cell_size == 0) {
+      return Status::OK();
+    }
+
+    // w is [w_x; w_h], whose blocks of rows are contiguous. The timesteps
+    // are contiguous too, but not necessarily aligned.
+    typedef typename TTypes<T>::UnalignedConstMatrix ConstMatrix;
+    typedef typename TTypes<T>::UnalignedMatrix Matrix;
+    const T* w_data = w.flat<T>().data();
+    ConstMatrix w_x(w_data, input_size, num_gates);
+    ConstMatrix w_h(w_data + input_size * num_gates, cell_size, num_gates);
+    const int64 step_gates = batch_size * num_gates;
+    const int64 chunk_steps = std::max<int64>(
+        1, std::min(seq_len_max, kMaxProjectedGates / step_gates));
+    Tensor gates_tensor;
+    TF_RETURN_IF_ERROR(ctx->allocate_temp(
+        DataTypeToEnum<T>::v(),
+        TensorShape({chunk_steps * batch_size, num_gates}), &gates_tensor));
+    T* gates_data = gates_tensor.flat<T>().data();
+
+    Eigen::array<Eigen::IndexPair<Eigen::DenseIndex>, 1> contract_pairs;
+    contract_pairs[0] = Eigen::IndexPair<Eigen::DenseIndex>(1, 0);
+    const int64 step_size = batch_size * cell_size;
+    auto worker_threads = *(ctx->device()->tensorflow_cpu_worker_threads());
+    const int64 row_cost = cell_size * 60;
+
+    for (int64 chunk = 0; chunk < seq_len_max; chunk += chunk_steps) {
+      const int64 num_steps = std::min(chunk_steps, seq_len_max - chunk);
+      Matrix chunk_gates(gates_data, num_steps * batch_size, num_gates);
+      if (input_size > 0) {
+        const T* x_data = x.flat<T>().data() + chunk * batch_size * input_size;
+        ConstMatrix chunk_x(x_data, num_steps * batch_size, input_size);
+        chunk_gates.device(d) = chunk_x.contract(w_x, contract_pairs);
+      } else {
+        chunk_gates.device(d) = chunk_gates.constant(T(0));
+      }
+
+      for (int64 t = chunk; t < chunk + num_steps; ++t) {
+        T* gates_data_t = gates_data + (t - chunk) * step_gates;
+        const T* step_h_prev = t == 0
+                                   ? h_prev.flat<T>().data()
+                                   : h->flat<T>().data() + (t - 1) * step_size;
+        const T* step_cs_prev =
+            t == 0 ? cs_prev.flat<T>().data()
+                   : cs->flat<T>().data() + (t - 1) * step_size;
+        Matrix gates(gates_data_t, batch_size, num_gates);
+        ConstMatrix h_prev_matrix(step_h_prev, batch_size, cell_size);
+        gates.device(d) += h_prev_matrix.contract(w_h, contract_pairs);
+
+        const int64 offset = t * step_size;
+        auto ActivateRows = [&](int64 start, int64 limit) {
+          for (int64 row = start; row < limit; ++row) {
+            const int64 cells = offset + row * cell_size;
+            ActivateRow(forget_bias, cell_clip, use_peephole, cell_size,
+                        gates_data_t + row * num_gates, b.flat<T>().data(),
+                        wci.flat<T>().data(), wcf.flat<T>().data(),
+                        wco.flat<T>().data(), step_cs_prev + row * cell_size,
+                        i->flat<T>().data() + cells,
+                        cs->flat<T>().data() + cells,
+                        f->flat<T>().data() + cells,
+                        o->flat<T>().data() + cells,
+                        ci->flat<T>().data() + cells,
+                        co->flat<T>().data() + cells,
+                        h->flat<T>().data() + cells);
+          }
+        };
+        Shard(worker_threads.num_threads, worker_threads.workers, batch_size,
+              row_cost, ActivateRows);
+      }
+    }
+    return Status::OK();
+  }
+
+ private:
+  // Computes the outputs of one example from its row of gates x * w_x +
+  // h_prev * w_h, with the same operations as LSTMBlockCellFpropWithEigen.
+  static void ActivateRow(const float forget_bias, const float cell_clip,
+                          const bool use_peephole, const int64 cell_size,
+                          const T* gates_data, const T* b_data,
+                          const T* wci_data, const T* wcf_data,
+                          const T* wco_data, const T* cs_prev_data, T* i_data,
+                          T* cs_data, T* f_data, T* o_data, T* ci_data,
+                          T* co_data, T* h_data) {
+    typedef typename TTypes<T>::UnalignedConstVec ConstRow;
+    typedef typename TTypes<T>::UnalignedVec Row;
+    auto Gate = [&](const T* data, int64 offset) {
+      return ConstRow(data + offset, cell_size);
+    };
+    const int64 c_offset = gate_c_offset(gate_layout, cell_size);
+    const int64 f_offset = gate_f_offset(gate_layout, cell_size);
+    const int64 o_offset = cell_size * 3;
+    ConstRow cs_prev(cs_prev_data, cell_size);
+    Row i(i_data, cell_size);
+    Row cs(cs_data, cell_size);
+    Row f(f_data, cell_size);
+    Row o(o_data, cell_size);
+    Row ci(ci_data, cell_size);
+    Row co(co_data, cell_size);
+    Row h(h_data, cell_size);
+
+    if (use_peephole) {
+      i = (Gate(gates_data, 0) + Gate(b_data, 0) +
+           cs_prev * ConstRow(wci_data, cell_size))
+              .sigmoid();
+    } else {
+      i = (Gate(gates_data, 0) + Gate(b_data, 0)).sigmoid();
+    }
+
+    ci = (Gate(gates_data, c_offset) + Gate(b_data, c_offset)).tanh();
+
+    if (use_peephole) {
+      f = (Gate(gates_data, f_offset) + Gate(b_data, f_offset) +
+           f.constant(T(forget_bias)) + cs_prev * ConstRow(wcf_data, cell_size))
+              .sigmoid();
+    } else {
+      f = (Gate(gates_data, f_offset) + Gate(b_data, f_offset) +
+           f.constant(T(forget_bias)))
+              .sigmoid();
+    }
+
+    cs = i * ci + f * cs_prev;
+    if (cell_clip > 0.0f) {
+      cs = cs.binaryExpr(cs.constant(T(cell_clip)),
+                         Eigen::scalar_clip_op<T>());
+    }
+
+    co = cs.tanh();
+
+    if (use_peephole) {
+      o = (Gate(gates_data, o_offset) + Gate(b_data, o_offset) +
+           cs * ConstRow(wco_data, cell_size))
+              .sigmoid();
+    } else {
+      o = (Gate(gates_data, o_offset) + Gate(b_data, o_offset)).sigmoid();
+    }
+
+    h = o * co;
+  }
+};
+
+}  // namespace functor
+
 template <typename Device, typename T, bool USE_CUBLAS, GateLayout gate_layout>
 class BlockLSTMOp : public OpKernel {
  public:
@@ -955,49 +1143,62 @@ class BlockLSTMOp : public OpKernel {
     Tensor* h_out;
     OP_REQUIRES_OK(ctx, ctx->allocate_output("h", batch_cell_shape, &h_out));
 
-    Tensor xh_tensor;
-    OP_REQUIRES_OK(ctx, ctx->allocate_temp(
-                            DataTypeToEnum<T>::v(),
-                            TensorShape({batch_size, input_size + cell_size}),
-                            &xh_tensor));
-
-    Tensor gates_tensor;
-    OP_REQUIRES_OK(ctx,
-                   ctx->allocate_temp(DataTypeToEnum<T>::v(),
-                                      TensorShape({batch_size, cell_size * 4}),
-                                      &gates_tensor));
-
     const Device& device = ctx->eigen_device<Device>();
 
     const int64 seq_len_max = seq_len_max_tensor->scalar<int64>()();
-    SliceHelper<Device, T> slicer(ctx);
-    for (int64 t = 0; t < seq_len_max; ++t) {
-      const Tensor x_tensor = slicer.InputSlice(*x, t, "x");
-      const Tensor& cs_prev_tensor2 =
-          t == 0 ? *cs_prev_tensor
-                 : slicer.OutputSlice(cs_out, t - 1, "cs_prev");
-      const Tensor& h_prev_tensor2 =
-          t == 0 ? *h_prev_tensor : slicer.OutputSlice(h_out, t - 1, "h_prev");
-
-      Tensor i_tensor = slicer.OutputSlice(i_out, t, "i_out");
-      Tensor cs_tensor = slicer.OutputSlice(cs_out, t, "cs_out");
-      Tensor f_tensor = slicer.OutputSlice(f_out, t, "f_out");
-      Tensor o_tensor = slicer.OutputSlice(o_out, t, "o_out");
-      Tensor ci_tensor = slicer.OutputSlice(ci_out, t, "ci_out");
-      Tensor co_tensor = slicer.OutputSlice(co_out, t, "co_out");
-      Tensor h_tensor = slicer.OutputSlice(h_out, t, "h_out");
-
-      functor::LSTMBlockCellFprop<Device, T, USE_CUBLAS, gate_layout>(
-          batch_size, input_size, cell_size)(
-          ctx, device, forget_bias_, cell_clip_, use_peephole_,
-          x_tensor.matrix<T>(), cs_prev_tensor2.matrix<T>(),
-          h_prev_tensor2.matrix<T>(), w_tensor->matrix<T>(),
-          wci_tensor->vec<T>(), wcf_tensor->vec<T>(), wco_tensor->vec<T>(),
-          b_tensor->vec<T>(), xh_tensor.matrix<T>(), i_tensor.matrix<T>(),
-          cs_tensor.matrix<T>(), f_tensor.matrix<T>(), o_tensor.matrix<T>(),
-          ci_tensor.matrix<T>(), co_tensor.matrix<T>(),
-          gates_tensor.matrix<T>(), h_tensor.matrix<T>());
-      slicer.FinishTimeStep();
+    typedef functor::BlockLSTMFusedFprop<Device, T, gate_layout> FusedFprop;
+    if (FusedFprop::kSupported) {
+      OP_REQUIRES_OK(
+          ctx, FusedFprop()(ctx, forget_bias_, cell_clip_, use_peephole_,
+                            std::min(seq_len_max, timelen), *x,
+                            *cs_prev_tensor, *h_prev_tensor, *w_tensor,
+                            *wci_tensor, *wcf_tensor, *wco_tensor, *b_tensor,
+                            i_out, cs_out, f_out, o_out, ci_out, co_out,
+                            h_out));
+    } else {
+      Tensor xh_tensor;
+      OP_REQUIRES_OK(
+          ctx, ctx->allocate_temp(
+                   DataTypeToEnum<T>::v(),
+                   TensorShape({batch_size, input_size + cell_size}),
+                   &xh_tensor));
+
+      Tensor gates_tensor;
+      OP_REQUIRES_OK(
+          ctx, ctx->allocate_temp(DataTypeToEnum<T>::v(),
+                                  TensorShape({batch_size, cell_size * 4}),
+                                  &gates_tensor));
+
+      SliceHelper<Device, T> slicer(ctx);
+      for (int64 t = 0; t < seq_len_max; ++t) {
+        const Tensor x_tensor = slicer.InputSlice(*x, t, "x");
+        const Tensor& cs_prev_tensor2 =
+            t == 0 ? *cs_prev_tensor
+                   : slicer.OutputSlice(cs_out, t - 1, "cs_prev");
+        const Tensor& h_prev_tensor2 =
+            t == 0 ? *h_prev_tensor
+                   : slicer.OutputSlice(h_out, t - 1, "h_prev");
+
+        Tensor i_tensor = slicer.OutputSlice(i_out, t, "i_out");
+        Tensor cs_tensor = slicer.OutputSlice(cs_out, t, "cs_out");
+        Tensor f_tensor = slicer.OutputSlice(f_out, t, "f_out");
+        Tensor o_tensor = slicer.OutputSlice(o_out, t, "o_out");
+        Tensor ci_tensor = slicer.OutputSlice(ci_out, t, "ci_out");
+        Tensor co_tensor = slicer.OutputSlice(co_out, t, "co_out");
+        Tensor h_tensor = slicer.OutputSlice(h_out, t, "h_out");
+
+        functor::LSTMBlockCellFprop<Device, T, USE_CUBLAS, gate_layout>(
+            batch_size, input_size, cell_size)(
+            ctx, device, forget_bias_, cell_clip_, use_peephole_,
+            x_tensor.matrix<T>(), cs_prev_tensor2.matrix<T>(),
+            h_prev_tensor2.matrix<T>(), w_tensor->matrix<T>(),
+            wci_tensor->vec<T>(), wcf_tensor->vec<T>(), wco_tensor->vec<T>(),
+            b_tensor->vec<T>(), xh_tensor.matrix<T>(), i_tensor.matrix<T>(),
+            cs_tensor.matrix<T>(), f_tensor.matrix<T>(), o_tensor.matrix<T>(),
+            ci_tensor.matrix<T>(), co_tensor.matrix<T>(),
+            gates_tensor.matrix<T>(), h_tensor.matrix<T>());
+        slicer.FinishTimeStep();
+      }
     }
 
     if (seq_len_max < timelen) {
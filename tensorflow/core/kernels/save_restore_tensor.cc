@@ -14,6 +14,7 @@ limitations under the License.
 ==============================================================================*/
 
 #include "tensorflow/core/kernels/save_restore_tensor.h"
+#include <algorithm>
 #include <numeric>
 #include <unordered_map>
 #include <utility>
@@ -30,6 +31,7 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/tensor_bundle/shared_tensor_store.h"
 #include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
 #include "tensorflow/core/util/tensor_slice_reader.h"
 #include "tensorflow/core/util/tensor_slice_reader_cache.h"
@@ -234,38 +236,20 @@ void RestoreTensor(OpKernelContext* context,
 
 namespace {
 
-// Tensors larger than this threshold will be restored from a thread-pool.
-const int64 kLargeShapeThreshold = 16 << 20;  // 16M
+// The tensors are restored in groups of about this many bytes, which are
+// read from a thread pool when there are several.
+const int64 kRestoreGroupBytes = 64 << 20;  // 64MB
 
-// A restore operation for a single tensor.  Small tensors may be restored
-// directly from the op thread to improve read locality.  Large tensors can be
-// restored from a thread pool: this requires creating a separate BundleReader
-// for each restore.
+// The most threads restoring groups at once.
+const int kMaxRestoreThreads = 8;
+
+// A restore operation for a single tensor. The operations are ordered by where
+// their data is in the data files, so that the reads of a group of them are
+// sequential, and every group restored from a thread pool needs a separate
+// BundleReader.
 struct RestoreOp {
   RestoreOp& operator=(const RestoreOp&) = delete;
 
-  bool should_run_in_pool(BundleReader* reader) const {
-    TensorShape restored_full_shape;
-
-    // Ignore status here; we'll catch the error later.
-    if (!reader->LookupTensorShape(tensor_name, &restored_full_shape).ok()) {
-      return false;
-    }
-
-    return restored_full_shape.num_elements() > kLargeShapeThreshold;
-  }
-
-  // Run this restore operation using a new BundleReader.
-  void run_with_new_reader() {
-    BundleReader reader(Env::Default(), reader_prefix);
-    if (!reader.status().ok()) {
-      status = reader.status();
-      return;
-    }
-
-    status = run(&reader);
-  }
-
   Status run(BundleReader* reader) {
     TensorShape restored_full_shape;
     TF_RETURN_IF_ERROR(
@@ -279,6 +263,11 @@ struct RestoreOp {
       TF_RETURN_IF_ERROR(
           context->allocate_output(idx, restored_full_shape, &restored_tensor));
       TF_RETURN_IF_ERROR(reader->Lookup(tensor_name, restored_tensor));
+      if (SharedTensorStore::IsEnabled()) {
+        context->set_output(
+            idx, SharedTensorStore::Global()->Share(*restored_tensor));
+        restored_tensor = context->mutable_output(idx);
+      }
     } else {
       // Lookup the slice.
       TensorShape parsed_full_shape;
@@ -326,11 +315,25 @@ struct RestoreOp {
   size_t idx;
   string tensor_name;
   string shape_and_slice;
-  string reader_prefix;
 
-  ::tensorflow::Status status;
+  // Where the data of the tensor is, with partitioned tensors, which are read
+  // from several entries, ordered last.
+  int32 shard_id;
+  int64 offset;
+  int64 size;
 };
 
+// Restores a group of tensors with its own reader.
+Status RunRestoreGroup(const string& prefix,
+                       const std::vector<RestoreOp*>& restore_ops) {
+  BundleReader reader(Env::Default(), prefix);
+  TF_RETURN_IF_ERROR(reader.status());
+  for (RestoreOp* op : restore_ops) {
+    TF_RETURN_IF_ERROR(op->run(&reader));
+  }
+  return Status::OK();
+}
+
 }  // namespace
 
 Status RestoreTensorsV2(OpKernelContext* context, const Tensor& prefix,
@@ -350,9 +353,6 @@ Status RestoreTensorsV2(OpKernelContext* context, const Tensor& prefix,
               return tensor_names_flat(a) < tensor_names_flat(b);
             });
 
-  std::vector<std::unique_ptr<RestoreOp> > pool_restore_ops;
-  std::vector<std::unique_ptr<RestoreOp> > direct_restore_ops;
-
   BundleReader default_reader(Env::Default(), prefix_string);
   TF_RETURN_IF_ERROR(default_reader.status());
 
@@ -376,39 +376,66 @@ Status RestoreTensorsV2(OpKernelContext* context, const Tensor& prefix,
     return errors::InvalidArgument(error_msg);
   }
 
+  std::vector<std::unique_ptr<RestoreOp> > restore_ops;
   for (auto i : sorted_name_idx) {
     const string& tensor_name = tensor_names_flat(i);
-    const string& shape_and_slice = shape_and_slices_flat(i);
-    auto op =
-        new RestoreOp{context, i, tensor_name, shape_and_slice, prefix_string};
-    if (op->should_run_in_pool(&default_reader)) {
-      pool_restore_ops.emplace_back(op);
+    BundleEntryProto entry;
+    TF_RETURN_IF_ERROR(default_reader.GetBundleEntryProto(tensor_name, &entry));
+    RestoreOp* op = new RestoreOp{context, i, tensor_name,
+                                  shape_and_slices_flat(i)};
+    if (entry.slices().empty()) {
+      op->shard_id = entry.shard_id();
+      op->offset = entry.offset();
+      op->size = entry.size();
     } else {
-      direct_restore_ops.emplace_back(op);
+      op->shard_id = kint32max;
+      op->offset = 0;
+      op->size = TensorShape(entry.shape()).num_elements() *
+                 DataTypeSize(entry.dtype());
     }
+    restore_ops.emplace_back(op);
   }
-
-  {
-    // Schedule any threaded operations first, skipping thread pool creation if
-    // we don't have any expensive operations.
-    std::unique_ptr<thread::ThreadPool> reader_pool;
-    if (!pool_restore_ops.empty()) {
-      reader_pool.reset(
-          new thread::ThreadPool(Env::Default(), "restore_tensors", 8));
-      for (auto& op : pool_restore_ops) {
-        reader_pool->Schedule([&op]() { op->run_with_new_reader(); });
-      }
+  std::stable_sort(restore_ops.begin(), restore_ops.end(),
+                   [](const std::unique_ptr<RestoreOp>& a,
+                      const std::unique_ptr<RestoreOp>& b) {
+                     return std::make_pair(a->shard_id, a->offset) <
+                            std::make_pair(b->shard_id, b->offset);
+                   });
+
+  // Groups of neighboring tensors of the same data file.
+  std::vector<std::vector<RestoreOp*> > groups;
+  int64 group_bytes = 0;
+  for (const auto& op : restore_ops) {
+    if (groups.empty() || group_bytes >= kRestoreGroupBytes ||
+        groups.back().back()->shard_id != op->shard_id) {
+      groups.emplace_back();
+      group_bytes = 0;
     }
+    groups.back().push_back(op.get());
+    group_bytes += op->size;
+  }
 
-    // Read small tensors from the op thread
-    for (auto& op : direct_restore_ops) {
+  if (groups.size() == 1) {
+    // Reads everything from the op thread.
+    for (RestoreOp* op : groups[0]) {
       TF_RETURN_IF_ERROR(op->run(&default_reader));
     }
-  }
-
-  // Check status of pool ops; this must come after the pool shuts down.
-  for (auto& op : pool_restore_ops) {
-    TF_RETURN_IF_ERROR(op->status);
+  } else if (groups.size() > 1) {
+    std::vector<Status> statuses(groups.size());
+    {
+      thread::ThreadPool reader_pool(
+          Env::Default(), "restore_tensors",
+          std::min<int>(kMaxRestoreThreads, groups.size()));
+      for (int i = 0; i < groups.size(); ++i) {
+        reader_pool.Schedule([&prefix_string, &groups, &statuses, i]() {
+          statuses[i] = RunRestoreGroup(prefix_string, groups[i]);
+        });
+      }
+    }
+    // Checks the statuses once the pool has shut down.
+    for (const Status& status : statuses) {
+      TF_RETURN_IF_ERROR(status);
+    }
   }
 
   for (auto i : sorted_name_idx) {
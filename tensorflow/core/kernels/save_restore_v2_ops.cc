@@ -29,6 +29,7 @@ limitations under the License.
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/saved_tensor_slice_util.h"
 #include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
 #include "tensorflow/core/util/tensor_slice_reader.h"
@@ -105,7 +106,13 @@ class SaveV2 : public OpKernel {
     const auto& tensor_names_flat = tensor_names.flat<tstring>();
     const auto& shape_and_slices_flat = shape_and_slices.flat<tstring>();
 
-    BundleWriter writer(Env::Default(), prefix_string);
+    // Spreading the tensors over several data files writes them in parallel.
+    int64 num_data_shards;
+    OP_REQUIRES_OK(context, ReadInt64FromEnvVar("TF_SAVE_V2_NUM_DATA_SHARDS",
+                                                1, &num_data_shards));
+    BundleWriter::Options options;
+    options.num_data_shards = static_cast<int>(num_data_shards);
+    BundleWriter writer(Env::Default(), prefix_string, options);
     OP_REQUIRES_OK(context, writer.status());
     VLOG(1) << "BundleWriter, prefix_string: " << prefix_string;
 
@@ -16,7 +16,9 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_KERNELS_SCATTER_FUNCTOR_H_
 #define TENSORFLOW_CORE_KERNELS_SCATTER_FUNCTOR_H_
 
+#include <algorithm>
 #include <type_traits>
+#include <vector>
 
 #include "third_party/eigen3/Eigen/Core"
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
@@ -25,6 +27,7 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/variant_op_registry.h"
 #include "tensorflow/core/kernels/dense_update_functor.h"
+#include "tensorflow/core/platform/prefetch.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/util/work_sharder.h"
 
@@ -125,6 +128,100 @@ struct Assign<scatter_op::UpdateOp::MAX> {
   }
 };
 
+// Applies `num_updates` row updates to a tensor of `num_rows` rows on the
+// threads of `d` without locks or atomics.
+//
+// `get_row(i, &row)` returns false if update i is out of bounds, and
+// otherwise sets the row it updates. `apply(i, row)` applies update i, and
+// `prefetch(row)` is called for the row of the next update before the
+// current one is applied.
+//
+// The rows are split into contiguous ranges, about four per thread to
+// balance skewed indices, and the updates are bucketed by range with a
+// counting sort that keeps their order. Every range is then updated by a
+// single shard, so repeated indices are applied in order as in a serial
+// loop. Returns the position of the first index out of bounds, in which case
+// no update is applied, or -1.
+template <typename Device, typename Index, typename GetRow, typename Apply,
+          typename Prefetch>
+Index PartitionedScatter(const Device& d, Index num_updates, Index num_rows,
+                         int64 row_bytes, GetRow get_row, Apply apply,
+                         Prefetch prefetch) {
+  const Index num_ranges =
+      std::max<Index>(1, std::min<Index>(4 * d.numThreads(), num_rows));
+  const Index rows_per_range = (num_rows + num_ranges - 1) / num_ranges;
+  const Index num_blocks = num_ranges;
+  const Index block_size = (num_updates + num_blocks - 1) / num_blocks;
+
+  // offsets[b * num_ranges + r] counts, and then locates, the updates of
+  // block b that land in range r.
+  std::vector<Index> rows(num_updates);
+  std::vector<Index> offsets(num_blocks * num_ranges, 0);
+  std::vector<Index> bad_index(num_blocks, -1);
+  const Eigen::TensorOpCost bucket_cost(sizeof(Index) * block_size,
+                                        sizeof(Index) * block_size,
+                                        5 * block_size);
+  d.parallelFor(num_blocks, bucket_cost, [&](Index start, Index limit) {
+    for (Index b = start; b < limit; ++b) {
+      Index* counts = &offsets[b * num_ranges];
+      const Index end = std::min(num_updates, (b + 1) * block_size);
+      for (Index i = b * block_size; i < end; ++i) {
+        Index row;
+        if (!get_row(i, &row)) {
+          bad_index[b] = i;
+          break;
+        }
+        rows[i] = row;
+        ++counts[row / rows_per_range];
+      }
+    }
+  });
+  for (Index b = 0; b < num_blocks; ++b) {
+    if (bad_index[b] >= 0) return bad_index[b];
+  }
+
+  // Exclusive prefix sum in range-major order, so that the updates of every
+  // range are contiguous and sorted by position.
+  std::vector<Index> range_starts(num_ranges + 1);
+  Index total = 0;
+  for (Index r = 0; r < num_ranges; ++r) {
+    range_starts[r] = total;
+    for (Index b = 0; b < num_blocks; ++b) {
+      const Index count = offsets[b * num_ranges + r];
+      offsets[b * num_ranges + r] = total;
+      total += count;
+    }
+  }
+  range_starts[num_ranges] = total;
+
+  std::vector<Index> order(num_updates);
+  d.parallelFor(num_blocks, bucket_cost, [&](Index start, Index limit) {
+    for (Index b = start; b < limit; ++b) {
+      Index* next = &offsets[b * num_ranges];
+      const Index end = std::min(num_updates, (b + 1) * block_size);
+      for (Index i = b * block_size; i < end; ++i) {
+        order[next[rows[i] / rows_per_range]++] = i;
+      }
+    }
+  });
+
+  const int64 updates_per_range = num_updates / num_ranges + 1;
+  const Eigen::TensorOpCost apply_cost(2 * row_bytes * updates_per_range,
+                                       row_bytes * updates_per_range,
+                                       row_bytes * updates_per_range);
+  d.parallelFor(num_ranges, apply_cost, [&](Index start, Index limit) {
+    for (Index r = start; r < limit; ++r) {
+      const Index end = range_starts[r + 1];
+      for (Index k = range_starts[r]; k < end; ++k) {
+        const Index i = order[k];
+        if (k + 1 < end) prefetch(rows[order[k + 1]]);
+        apply(i, rows[i]);
+      }
+    }
+  });
+  return -1;
+}
+
 #ifdef TENSORFLOW_USE_SYCL
 template <scatter_op::UpdateOp Op>
 struct AssignSYCL {};
@@ -205,40 +302,26 @@ struct ScatterFunctorBase {
                         typename TTypes<Index>::ConstFlat indices) {
     const Index N = static_cast<Index>(indices.size());
     const Index limit = static_cast<Index>(params.dimension(0));
-    const Index kMaxLocks = 1024;
-    const Index entries_per_lock = (limit + kMaxLocks - 1) / kMaxLocks;
-    // To reduce the number of locks and the memory usage, we divide the whole
-    // index space into kMaxLocks regions with each lock serializing access to
-    // a region.
-    mutex accessed[kMaxLocks];
-    std::atomic<Index> bad_index(-1);
-    auto ParallelScatter = [&](Index start, Index end) {
-      for (Index i = start; i < end; ++i) {
-        // Grab the index and check its validity.  Do this carefully,
-        // to avoid checking the value and grabbing it again from
-        // memory a second time (a security risk since it may change in
-        // between).
-        const Index index = ::tensorflow::internal::SubtleMustCopy(indices(i));
-        if (!FastBoundsCheck(index, limit)) {
-          bad_index = i;
-          return;
-        }
-        const Index lock_id = index / entries_per_lock;
-        // Copy last Ndim-1 dimensions of updates[i] to params[index]
-        {
-          mutex_lock l(accessed[lock_id]);
-          scatter_op::internal::Assign<op>::Run(params.template chip<0>(index),
-                                                updates.template chip<0>(i));
-        }
-      }
+    const int64 cols = params.dimension(1);
+    auto get_row = [&](Index i, Index* row) {
+      // Grab the index and check its validity.  Do this carefully,
+      // to avoid checking the value and grabbing it again from
+      // memory a second time (a security risk since it may change in
+      // between).
+      *row = ::tensorflow::internal::SubtleMustCopy(indices(i));
+      return FastBoundsCheck(*row, limit);
     };
-    const float kMovingCost = 2.5f;
-    float shard_cost = kMovingCost * params.dimension(1);
-    const DeviceBase::CpuWorkerThreads& worker_threads =
-        *(c->device()->tensorflow_cpu_worker_threads());
-    Shard(worker_threads.num_threads, worker_threads.workers, N, shard_cost,
-          ParallelScatter);  // TODO: Come up with a good cost estimate.
-    return bad_index;
+    auto apply = [&](Index i, Index row) {
+      // Copy last Ndim-1 dimensions of updates[i] to params[row]
+      scatter_op::internal::Assign<op>::Run(params.template chip<0>(row),
+                                            updates.template chip<0>(i));
+    };
+    auto prefetch = [&](Index row) {
+      port::prefetch<port::PREFETCH_HINT_T0>(
+          reinterpret_cast<const char*>(params.data() + row * cols));
+    };
+    return scatter_op::internal::PartitionedScatter(
+        d, N, limit, cols * sizeof(T), get_row, apply, prefetch);
   }
   Index SerialExecute(OpKernelContext* c, const Device& d,
                       typename TTypes<T>::Matrix params,
@@ -264,31 +347,16 @@ struct ScatterFunctorBase {
                    typename TTypes<T>::Matrix params,
                    typename TTypes<T>::ConstMatrix updates,
                    typename TTypes<Index>::ConstFlat indices) {
-#ifdef PLATFORM_GOOGLE
-    // The parallel version is significantly slower internally. Only call the
-    // serial version for now.
-    // TODO(penporn): Avoid locking in parallelization (sort beforehand).
-    return SerialExecute(c, d, params, updates, indices);
-#else
     // indices and params sizes were validated in DoCompute().
     const Index N = static_cast<Index>(indices.size());
-    const Index limit = static_cast<Index>(params.dimension(0));
     const Index min_n_threshold = 1024;
-    const Index ser_par_ratio = 10000;
-    // For parallelizing the updates, duplicate entries need to be handled
-    // correctly. Multiple updates to the same index has to be serialized.
-    // This can lead to lock contention which may nullify the benefits of
-    // parallelization. Assuming uniform random distribution of the indices, we
-    // come up with a rough heuristic and determine whether the updates execute
-    // serially or parallelly. Also if 'N' is small, overheads of parallel
-    // execution outweigh its benefits and hence we check the value of N.
-    const bool execute_serial =
-        ((N < min_n_threshold) || ((N / limit) > ser_par_ratio));
+    // Bucketing the updates by destination row costs a few passes over the
+    // indices, which only pays off for enough updates.
+    const bool execute_serial = N < min_n_threshold || d.numThreads() <= 1;
     if (execute_serial)
       return SerialExecute(c, d, params, updates, indices);
     else
       return ParallelExecute(c, d, params, updates, indices);
-#endif  // PLATFORM_GOOGLE
   }
 };
 
@@ -30,8 +30,10 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/kernels/fill_functor.h"
+#include "tensorflow/core/kernels/scatter_functor.h"
 #include "tensorflow/core/kernels/scatter_nd_op.h"
 #include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/prefetch.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/util/util.h"
 
@@ -131,6 +133,44 @@ struct ScatterNdFunctor<CPUDevice, T, Index, OP, IXDIM> {
       }
     }
 
+    // Large batches are bucketed by destination slice and applied on all
+    // threads, each slice by a single thread and in the order of the batch.
+    if (batch_size >= kMinParallelBatchSize && d.numThreads() > 1) {
+      Index num_slices = 1;
+      for (int dim = 0; dim < IXDIM; ++dim) {
+        num_slices *= output_shape_prefix[dim];
+      }
+      auto get_slice = [&](Index loc, Index* i) {
+        *i = 0;
+        bool out_of_bounds = false;
+        for (int dim = 0; dim < IXDIM; ++dim) {
+          const Index ix_d = internal::SubtleMustCopy(Tindices(loc, dim));
+          out_of_bounds |= !FastBoundsCheck(ix_d, output_shape_prefix[dim]);
+          *i += ix_d * batch_strides[dim];
+        }
+        return !out_of_bounds;
+      };
+      // Every slice is updated on the calling thread of its shard.
+      const Eigen::DefaultDevice device;
+      auto apply = [&](Index loc, Index i) {
+        auto input_chip = Toutput.template chip<0>(i);
+        auto output_chip = input_chip;
+        auto update_chip = Tupdates.template chip<0>(loc);
+        update_executor::UpdateExecutor<
+            Eigen::DefaultDevice, decltype(input_chip), decltype(update_chip),
+            decltype(output_chip), OP>::Execute(device, input_chip,
+                                                update_chip, output_chip);
+      };
+      auto prefetch = [&](Index i) {
+        port::prefetch<port::PREFETCH_HINT_T0>(
+            reinterpret_cast<const char*>(Toutput.data() + i * slice_size));
+      };
+      return scatter_op::internal::PartitionedScatter(
+          d, static_cast<Index>(batch_size), num_slices,
+          static_cast<int64>(slice_size) * sizeof(T), get_slice, apply,
+          prefetch);
+    }
+
     for (Eigen::DenseIndex loc = 0; loc < batch_size; ++loc) {
       Index i = 0;
       bool out_of_bounds = false;
@@ -155,6 +195,11 @@ struct ScatterNdFunctor<CPUDevice, T, Index, OP, IXDIM> {
 
     return error_loc;
   }
+
+ private:
+  // Smaller batches are applied serially, since bucketing them costs more
+  // than the threads save.
+  static constexpr Eigen::DenseIndex kMinParallelBatchSize = 1024;
 };
 
 #define REGISTER_SCATTER_ND_FULL(T, Index, op)                               \
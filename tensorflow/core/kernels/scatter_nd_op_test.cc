@@ -174,6 +174,32 @@ TEST_F(ScatterNdUpdateOpTest, HigherRank) {
   test::ExpectTensorEqual<float>(expected, params_tensor);
 }
 
+// Enough updates to be applied on several threads. The last update of every
+// slice wins.
+TEST_F(ScatterNdUpdateOpTest, ParallelRepeatedIndices) {
+  MakeOp(DT_FLOAT_REF, DT_INT32);
+  const int kRows = 100;
+  const int kNumUpdates = 5000;
+  std::vector<int32> indices(kNumUpdates);
+  std::vector<float> updates(kNumUpdates);
+  std::vector<float> expected_values(kRows, 0);
+  for (int i = 0; i < kNumUpdates; ++i) {
+    indices[i] = (i * 7) % kRows;
+    updates[i] = i;
+    expected_values[indices[i]] = i;
+  }
+  AddInputFromArray<float>(TensorShape({kRows}),
+                           std::vector<float>(kRows, 0));
+  AddInputFromArray<int32>(TensorShape({kNumUpdates, 1}), indices);
+  AddInputFromArray<float>(TensorShape({kNumUpdates}), updates);
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor params_tensor = *mutable_input(0).tensor;
+  Tensor expected(allocator(), DT_FLOAT, TensorShape({kRows}));
+  test::FillValues<float>(&expected, expected_values);
+  test::ExpectTensorEqual<float>(expected, params_tensor);
+}
+
 TEST_F(ScatterNdUpdateOpTest, Error_IndexOutOfRange) {
   MakeOp(DT_FLOAT_REF, DT_INT32);
 
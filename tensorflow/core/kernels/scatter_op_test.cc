@@ -217,6 +217,49 @@ TEST_F(ScatterSubOpTest, StressIndexTest) {
   test::ExpectTensorEqual<int32>(expected, params_tensor);
 }
 
+// Enough updates to be applied on several threads.
+TEST_F(ScatterSubOpTest, ParallelRepeatedIndices) {
+  MakeOp(DT_FLOAT_REF, DT_INT32);
+  const int kRows = 100;
+  const int kNumUpdates = 5000;
+  std::vector<int32> indices(kNumUpdates);
+  std::vector<float> updates(2 * kNumUpdates);
+  std::vector<float> expected_values(2 * kRows, 0);
+  for (int i = 0; i < kNumUpdates; ++i) {
+    indices[i] = (i * 7) % kRows;
+    updates[2 * i] = i;
+    updates[2 * i + 1] = 1;
+    expected_values[2 * indices[i]] -= i;
+    expected_values[2 * indices[i] + 1] -= 1;
+  }
+  AddInputFromArray<float>(TensorShape({kRows, 2}),
+                           std::vector<float>(2 * kRows, 0));
+  AddInputFromArray<int32>(TensorShape({kNumUpdates}), indices);
+  AddInputFromArray<float>(TensorShape({kNumUpdates, 2}), updates);
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor params_tensor = *mutable_input(0).tensor;
+  Tensor expected(allocator(), DT_FLOAT, TensorShape({kRows, 2}));
+  test::FillValues<float>(&expected, expected_values);
+  test::ExpectTensorEqual<float>(expected, params_tensor);
+}
+
+TEST_F(ScatterSubOpTest, Error_ParallelIndexOutOfRange) {
+  MakeOp(DT_FLOAT_REF, DT_INT32);
+  const int kNumUpdates = 5000;
+  std::vector<int32> indices(kNumUpdates, 3);
+  indices[4000] = 99;
+  indices[4500] = -1;
+  AddInputFromArray<float>(TensorShape({14}), std::vector<float>(14, 0));
+  AddInputFromArray<int32>(TensorShape({kNumUpdates}), indices);
+  AddInputFromArray<float>(TensorShape({kNumUpdates}),
+                           std::vector<float>(kNumUpdates, 1));
+  Status s = RunOpKernel();
+  EXPECT_TRUE(
+      absl::StrContains(s.ToString(), "indices[4000] = 99 is not in [0, 14)"))
+      << s;
+}
+
 TEST_F(ScatterUpdateOpTest, Error_WrongDimsIndices) {
   MakeOp(DT_FLOAT_REF, DT_INT32);
 
@@ -34,24 +34,49 @@ class OpKernelContext;
 
 namespace functor {
 
+// How the rows of a segment are combined: their sum, their sum divided by the
+// number of rows, or by its square root. With row weights, the weighted sum
+// is divided by the sum of the weights, or by the square root of the sum of
+// their squares.
+enum class SegmentReductionCombiner { kSum, kMean, kSqrtN };
+
 #if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
 typedef Eigen::GpuDevice GPUDevice;
-// Functor for SegmentSumGPUOp.
-// output_rows: the number of output segments (unique segment ids in
-//                'segment_ids').
-// segment_ids_shape: shape of 'segment_ids' tensor.
-// segment_ids: unsorted map from input to output segment ids at which to
-//                perform segment sum operation.
-// data_size: size of input data tensor.
+
+// Functor for the sorted segment reductions on GPU.
+// combiner: how the rows of each segment are combined.
+// num_rows: the number of rows to reduce.
+// segment_ids: sorted segment id of each of the 'num_rows' rows. Rows with ids
+//                outside of [0, output rows) are ignored.
+// indices: if not null, row i is row 'indices[i]' of 'data', as in the
+//                SparseSegment* ops, otherwise it is row i of 'data'. Rows
+//                with indices outside of [0, data_rows) are read as zeros.
+// weights: if not null, row i is multiplied by 'weights[i]'.
+// data_rows: number of rows of 'data'.
 // data: input data tensor.
 // output: output reshaped to {output_rows, output.size/output_rows}
-template <typename T, typename Index>
-struct SegmentSumFunctor {
-  void operator()(OpKernelContext* ctx, const GPUDevice& d,
-                  const Index output_rows, const TensorShape& segment_ids_shape,
-                  typename TTypes<Index>::ConstFlat segment_ids,
-                  const Index data_size, const T* data,
-                  typename TTypes<T, 2>::Tensor output);
+//
+// Rows are split into tiles of equal size, independently of the segment
+// sizes. The segments of a tile that also appear in its neighbors are reduced
+// again from the partial results of all tiles, until a single tile remains.
+// The order of all additions is fixed, so the results are deterministic.
+template <typename T, typename Index, typename SegmentId>
+struct SortedSegmentReductionFunctor {
+  Status operator()(OpKernelContext* ctx, SegmentReductionCombiner combiner,
+                    int64 num_rows, const SegmentId* segment_ids,
+                    const Index* indices, const T* weights, int64 data_rows,
+                    const T* data, typename TTypes<T, 2>::Tensor output);
+};
+
+// Functor for the gradient of SortedSegmentReductionFunctor with respect to
+// its rows: row i of 'output' is row 'segment_ids[i]' of 'grad', multiplied
+// by 'weights[i]' if 'weights' is not null and by the scale of its segment.
+template <typename T, typename SegmentId>
+struct SortedSegmentReductionGradFunctor {
+  Status operator()(OpKernelContext* ctx, SegmentReductionCombiner combiner,
+                    int64 num_rows, const SegmentId* segment_ids,
+                    const T* weights, typename TTypes<T, 2>::ConstTensor grad,
+                    typename TTypes<T, 2>::Tensor output);
 };
 
 #endif
@@ -25,79 +25,195 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/segment_reduction_ops.h"
 #include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/kernels/gpu_prim.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/gpu_device_functions.h"
 
 namespace tensorflow {
 
 using GPUDevice = Eigen::GpuDevice;
 
-// SortedSegmentSumFunctor kernel reduces input data just as
-// UnsortedSegmentSumCustomKernel does except that input data
-// is partitioned along the outer reduction dimension. This is
-// because consecutive rows (elements in a row share the same
-// outer dimension index) in the flattened 2D input data likely
-// belong to the same segment in sorted segment sum operation.
-// Therefore such partitioning strategy has two advantages over
-// the UnsortedSegmentSumFunctor kernel:
-// 1. Each thread reduces across multiple rows before writing
-// answers to the global memory, we can therefore
-// write reduction results to global memory less often.
-// 2. We may know that the current thread is the only contributor
-// to an output element because of the increasing nature of segment
-// ids. In such cases, we do not need to use atomic operations
-// to write results to global memory.
-// In the flattened view of input data (with only outer and inner
-// dimension), every thread processes a strip of input data of
-// size OuterDimTileSize x 1. This strip runs across multiple
-// rows of input data and all reduction elements share one inner
-// dimension index.
-template <typename T, typename Index, int OuterDimTileSize>
-__global__ void SortedSegmentSumCustomKernel(
-    const Index input_outer_dim_size, const Index inner_dim_size,
-    const Index output_outer_dim_size, const Index* __restrict__ segment_ids,
-    const T* __restrict__ input, T* __restrict__ output,
-    const Index total_stripe_count) {
-  for (int stripe_index : GpuGridRangeX(total_stripe_count)) {
-    const Index segment_offset = stripe_index % inner_dim_size;
-    const Index input_outer_dim_index_base =
-        stripe_index / inner_dim_size * Index(OuterDimTileSize);
-
-    T sum = T(0);
-    Index first_segment_id = segment_ids[input_outer_dim_index_base];
-    Index last_output_segment_id = output_outer_dim_size;
-
-    const Index actual_stripe_height =
-        min(Index(OuterDimTileSize),
-            input_outer_dim_size - input_outer_dim_index_base);
-    for (Index j = 0; j < actual_stripe_height; j++) {
-      Index current_output_segment_id =
-          segment_ids[input_outer_dim_index_base + j];
-      // Decide whether to write result to global memory.
-      // Result is only written to global memory if we move
-      // to another segment. Otherwise we can keep accumulating
-      // locally.
-      if (current_output_segment_id > last_output_segment_id) {
-        const Index output_index =
-            last_output_segment_id * inner_dim_size + segment_offset;
-        // decide whether to write result to global memory using atomic
-        // operations
-        if (last_output_segment_id == first_segment_id) {
-          GpuAtomicAdd(output + output_index, sum);
+// Rows reduced sequentially by one thread of the sorted segment reduction.
+constexpr int64 kSegmentTileRows = 32;
+
+// Half precision inputs are accumulated in float.
+template <typename T>
+struct SegmentAccumulatorType {
+  using type = T;
+};
+template <>
+struct SegmentAccumulatorType<Eigen::half> {
+  using type = float;
+};
+
+// Reads the input rows of the sorted segment reduction: row 'row' of 'data',
+// or row 'indices[row]' of it when 'indices' is not null, times 'weights[row]'
+// when 'weights' is not null.
+template <typename T, typename AccT, typename Index>
+struct DataRowReader {
+  const T* __restrict__ data;
+  const Index* __restrict__ indices;
+  const T* __restrict__ weights;
+  int64 data_rows;
+  int64 inner_dim_size;
+
+  __device__ AccT operator()(int64 row, int64 column) const {
+    AccT weight = AccT(1);
+    if (weights != nullptr) weight = static_cast<AccT>(ldg(weights + row));
+    if (indices != nullptr) {
+      row = ldg(indices + row);
+      if (row < 0 || row >= data_rows) return AccT(0);
+    }
+    return weight *
+           static_cast<AccT>(ldg(data + row * inner_dim_size + column));
+  }
+};
+
+// Reads the partial results of the previous level of the reduction.
+template <typename AccT>
+struct PartialRowReader {
+  const AccT* __restrict__ partials;
+  int64 inner_dim_size;
+
+  __device__ AccT operator()(int64 row, int64 column) const {
+    return ldg(partials + row * inner_dim_size + column);
+  }
+};
+
+// SortedSegmentReduceKernel splits the 'num_rows' rows into tiles of
+// kSegmentTileRows rows, and every thread reduces one column of one tile,
+// so the work per thread does not depend on the segment sizes. Segments that
+// lie entirely within the tile are final and added to 'output', after
+// multiplication with their 'scales' if those are given. Since the segment
+// ids are sorted, only the first and the last segment of a tile can be
+// shared with the neighboring tiles: their sums are stored in the two
+// 'partial_values' rows of the tile, with their ids in 'partial_ids', and
+// reduced by the next level. A tile always emits both partial rows, with
+// zeros when its first or last segment is final, which keeps the partial ids
+// sorted and only adds zeros to the output later on.
+template <typename T, typename AccT, typename SegmentId, typename RowReader>
+__global__ void SortedSegmentReduceKernel(
+    const int64 num_rows, const int64 inner_dim_size, const int64 output_rows,
+    const SegmentId* __restrict__ segment_ids, RowReader reader,
+    const AccT* __restrict__ scales, T* __restrict__ output,
+    SegmentId* __restrict__ partial_ids, AccT* __restrict__ partial_values,
+    const int64 total_tile_columns) {
+  for (int64 index : GpuGridRangeX(total_tile_columns)) {
+    const int64 tile = index / inner_dim_size;
+    const int64 column = index % inner_dim_size;
+    const int64 begin = tile * kSegmentTileRows;
+    const int64 end = min(begin + kSegmentTileRows, num_rows);
+
+    const SegmentId first_id = ldg(segment_ids + begin);
+    const SegmentId last_id = ldg(segment_ids + end - 1);
+    const bool first_shared =
+        begin > 0 && ldg(segment_ids + begin - 1) == first_id;
+    const bool last_shared =
+        end < num_rows && ldg(segment_ids + end) == last_id;
+
+    auto write = [&](SegmentId id, AccT sum) {
+      if (id < 0 || id >= output_rows) return;
+      if (scales != nullptr) sum *= scales[id];
+      T* out = output + id * inner_dim_size + column;
+      *out = static_cast<T>(static_cast<AccT>(*out) + sum);
+    };
+
+    AccT first_sum = AccT(0);
+    AccT last_sum = AccT(0);
+    AccT sum = AccT(0);
+    SegmentId current_id = first_id;
+    for (int64 row = begin; row < end; ++row) {
+      const SegmentId id = ldg(segment_ids + row);
+      if (id != current_id) {
+        if (current_id == first_id && first_shared) {
+          first_sum = sum;
         } else {
-          *(output + output_index) = sum;
+          write(current_id, sum);
         }
-        sum = T(0);
+        sum = AccT(0);
+        current_id = id;
       }
-      sum += ldg(input + (input_outer_dim_index_base + j) * inner_dim_size +
-                 segment_offset);
-      last_output_segment_id = current_output_segment_id;
+      sum += reader(row, column);
     }
-    // For the last result in a strip, always write using atomic operations
-    // due to possible race conditions with threads computing
-    // the following strip.
-    const Index output_index =
-        last_output_segment_id * inner_dim_size + segment_offset;
-    GpuAtomicAdd(output + output_index, sum);
+    if (current_id == first_id && first_shared) {
+      first_sum = sum;
+    } else if (last_shared) {
+      last_sum = sum;
+    } else {
+      write(current_id, sum);
+    }
+
+    if (partial_values != nullptr) {
+      if (column == 0) {
+        partial_ids[2 * tile] = first_id;
+        partial_ids[2 * tile + 1] = last_id;
+      }
+      partial_values[2 * tile * inner_dim_size + column] = first_sum;
+      partial_values[(2 * tile + 1) * inner_dim_size + column] = last_sum;
+    }
+  }
+}
+
+// Computes the scale of every output segment for the mean and sqrtn
+// combiners from the number of rows with its id, or from the sum of their
+// weights or squared weights if 'weights' is not null.
+template <typename T, typename AccT, typename SegmentId>
+__global__ void SortedSegmentScalesKernel(
+    const int64 num_rows, const int64 output_rows,
+    const SegmentId* __restrict__ segment_ids, const T* __restrict__ weights,
+    const functor::SegmentReductionCombiner combiner,
+    AccT* __restrict__ scales) {
+  const bool is_mean = combiner == functor::SegmentReductionCombiner::kMean;
+  for (int64 segment : GpuGridRangeX(output_rows)) {
+    const int64 begin = gpu_helper::lower_bound(
+        segment_ids, num_rows, static_cast<SegmentId>(segment));
+    const int64 end = gpu_helper::lower_bound(
+        segment_ids, num_rows, static_cast<SegmentId>(segment + 1));
+    double total = end - begin;
+    if (weights != nullptr) {
+      total = 0.0;
+      for (int64 row = begin; row < end; ++row) {
+        const double weight = static_cast<double>(ldg(weights + row));
+        total += is_mean ? weight : weight * weight;
+      }
+    }
+    double scale = 1.0;
+    if (end > begin) {
+      scale = is_mean ? 1.0 / total : rsqrt(total);
+    }
+    scales[segment] = static_cast<AccT>(scale);
+  }
+}
+
+// Expands 'grad' to one row per input row of the sorted segment reduction,
+// scaled by the weight of the row and the scale of its segment.
+template <typename T, typename AccT, typename SegmentId>
+__global__ void SortedSegmentReductionGradKernel(
+    const int64 num_rows, const int64 inner_dim_size, const int64 grad_rows,
+    const SegmentId* __restrict__ segment_ids, const T* __restrict__ weights,
+    const AccT* __restrict__ scales, const T* __restrict__ grad,
+    T* __restrict__ output) {
+  for (int64 index : GpuGridRangeX(num_rows * inner_dim_size)) {
+    const int64 row = index / inner_dim_size;
+    const int64 column = index % inner_dim_size;
+    const SegmentId segment = ldg(segment_ids + row);
+    if (segment < 0 || segment >= grad_rows) {
+      output[index] = T(0);
+      continue;
+    }
+    AccT value =
+        static_cast<AccT>(ldg(grad + segment * inner_dim_size + column));
+    if (weights != nullptr) value *= static_cast<AccT>(ldg(weights + row));
+    if (scales != nullptr) value *= scales[segment];
+    output[index] = static_cast<T>(value);
+  }
+}
+
+// Fills 'out' with 0, 1, ..., size - 1.
+template <typename Index>
+__global__ void SegmentRangeInitKernel(const int64 size, Index* out) {
+  for (int64 i : GpuGridRangeX(size)) {
+    out[i] = static_cast<Index>(i);
   }
 }
 
@@ -126,49 +242,248 @@ __global__ void UnsortedSegmentCustomKernel(
 
 namespace functor {
 
-template <typename T, typename Index>
-void SegmentSumFunctor<T, Index>::operator()(
-    OpKernelContext* ctx, const GPUDevice& d, const Index output_rows,
-    const TensorShape& segment_ids_shape,
-    typename TTypes<Index>::ConstFlat segment_ids, const Index data_size,
-    const T* data, typename TTypes<T, 2>::Tensor output) {
+namespace {
+
+// Allocates 'scales' and computes the scale of every segment, or leaves
+// 'scales' null for the sum combiner.
+template <typename T, typename AccT, typename SegmentId>
+Status ComputeSortedSegmentScales(OpKernelContext* ctx,
+                                  SegmentReductionCombiner combiner,
+                                  int64 num_rows, const SegmentId* segment_ids,
+                                  const T* weights, int64 output_rows,
+                                  Tensor* scales_tensor, const AccT** scales) {
+  *scales = nullptr;
+  if (combiner == SegmentReductionCombiner::kSum || output_rows == 0) {
+    return Status::OK();
+  }
+  const GPUDevice& d = ctx->eigen_device<GPUDevice>();
+  TF_RETURN_IF_ERROR(ctx->allocate_temp(DataTypeToEnum<AccT>::value,
+                                        TensorShape({output_rows}),
+                                        scales_tensor));
+  GpuLaunchConfig config = GetGpuLaunchConfig(output_rows, d);
+  TF_RETURN_IF_ERROR(GpuLaunchKernel(
+      SortedSegmentScalesKernel<T, AccT, SegmentId>, config.block_count,
+      config.thread_per_block, 0, d.stream(), num_rows, output_rows,
+      segment_ids, weights, combiner, scales_tensor->flat<AccT>().data()));
+  *scales = scales_tensor->flat<AccT>().data();
+  return Status::OK();
+}
+
+}  // namespace
+
+template <typename T, typename Index, typename SegmentId>
+Status SortedSegmentReductionFunctor<T, Index, SegmentId>::operator()(
+    OpKernelContext* ctx, SegmentReductionCombiner combiner, int64 num_rows,
+    const SegmentId* segment_ids, const Index* indices, const T* weights,
+    int64 data_rows, const T* data, typename TTypes<T, 2>::Tensor output) {
+  using AccT = typename SegmentAccumulatorType<T>::type;
   if (output.size() == 0) {
-    return;
+    return Status::OK();
   }
+  const GPUDevice& d = ctx->eigen_device<GPUDevice>();
   // Set 'output' to zeros.
   GpuLaunchConfig config = GetGpuLaunchConfig(output.size(), d);
-  TF_CHECK_OK(GpuLaunchKernel(SetZero<T>, config.block_count,
-                              config.thread_per_block, 0, d.stream(),
-                              output.size(), output.data()));
-  if (data_size == 0 || segment_ids_shape.num_elements() == 0) {
-    return;
+  TF_RETURN_IF_ERROR(GpuLaunchKernel(SetZero<T>, config.block_count,
+                                     config.thread_per_block, 0, d.stream(),
+                                     output.size(), output.data()));
+  if (num_rows == 0) {
+    return Status::OK();
+  }
+  const int64 inner_dim_size = output.dimension(1);
+  const int64 output_rows = output.dimension(0);
+
+  const AccT* scales = nullptr;
+  Tensor scales_tensor;
+  TF_RETURN_IF_ERROR(ComputeSortedSegmentScales(ctx, combiner, num_rows,
+                                                segment_ids, weights,
+                                                output_rows, &scales_tensor,
+                                                &scales));
+
+  // Two buffers for the partial results, the first one large enough for the
+  // first level and the second one for the second level. Later levels are
+  // smaller and alternate between them.
+  int64 num_tiles = Eigen::divup(num_rows, kSegmentTileRows);
+  Tensor partial_ids[2];
+  Tensor partial_values[2];
+  if (num_tiles > 1) {
+    int64 level_tiles = num_tiles;
+    for (int i = 0; i < 2 && level_tiles > 1; ++i) {
+      TF_RETURN_IF_ERROR(ctx->allocate_temp(DataTypeToEnum<SegmentId>::value,
+                                            TensorShape({2 * level_tiles}),
+                                            &partial_ids[i]));
+      TF_RETURN_IF_ERROR(ctx->allocate_temp(
+          DataTypeToEnum<AccT>::value,
+          TensorShape({2 * level_tiles, inner_dim_size}), &partial_values[i]));
+      level_tiles = Eigen::divup(2 * level_tiles, kSegmentTileRows);
+    }
+  }
+  auto partial_ids_data = [&](int i) {
+    return num_tiles > 1 ? partial_ids[i].flat<SegmentId>().data() : nullptr;
+  };
+  auto partial_values_data = [&](int i) {
+    return num_tiles > 1 ? partial_values[i].flat<AccT>().data() : nullptr;
+  };
+
+  DataRowReader<T, AccT, Index> data_reader{data, indices, weights, data_rows,
+                                            inner_dim_size};
+  config = GetGpuLaunchConfig(num_tiles * inner_dim_size, d);
+  TF_RETURN_IF_ERROR(GpuLaunchKernel(
+      SortedSegmentReduceKernel<T, AccT, SegmentId,
+                                DataRowReader<T, AccT, Index>>,
+      config.block_count, config.thread_per_block, 0, d.stream(), num_rows,
+      inner_dim_size, output_rows, segment_ids, data_reader, scales,
+      output.data(), partial_ids_data(0), partial_values_data(0),
+      num_tiles * inner_dim_size));
+
+  // Reduce the partial results, which are again sorted by segment id, until
+  // a single tile is left.
+  int buffer = 0;
+  while (num_tiles > 1) {
+    const int64 level_rows = 2 * num_tiles;
+    num_tiles = Eigen::divup(level_rows, kSegmentTileRows);
+    const SegmentId* level_ids = partial_ids[buffer].flat<SegmentId>().data();
+    PartialRowReader<AccT> partial_reader{
+        partial_values[buffer].flat<AccT>().data(), inner_dim_size};
+    buffer = 1 - buffer;
+    config = GetGpuLaunchConfig(num_tiles * inner_dim_size, d);
+    TF_RETURN_IF_ERROR(GpuLaunchKernel(
+        SortedSegmentReduceKernel<T, AccT, SegmentId, PartialRowReader<AccT>>,
+        config.block_count, config.thread_per_block, 0, d.stream(), level_rows,
+        inner_dim_size, output_rows, level_ids, partial_reader, scales,
+        output.data(), partial_ids_data(buffer), partial_values_data(buffer),
+        num_tiles * inner_dim_size));
   }
+  return Status::OK();
+}
+
+template <typename T, typename SegmentId>
+Status SortedSegmentReductionGradFunctor<T, SegmentId>::operator()(
+    OpKernelContext* ctx, SegmentReductionCombiner combiner, int64 num_rows,
+    const SegmentId* segment_ids, const T* weights,
+    typename TTypes<T, 2>::ConstTensor grad,
+    typename TTypes<T, 2>::Tensor output) {
+  using AccT = typename SegmentAccumulatorType<T>::type;
+  if (output.size() == 0) {
+    return Status::OK();
+  }
+  const GPUDevice& d = ctx->eigen_device<GPUDevice>();
+  const int64 grad_rows = grad.dimension(0);
+  const AccT* scales = nullptr;
+  Tensor scales_tensor;
+  TF_RETURN_IF_ERROR(ComputeSortedSegmentScales(ctx, combiner, num_rows,
+                                                segment_ids, weights,
+                                                grad_rows, &scales_tensor,
+                                                &scales));
+  GpuLaunchConfig config = GetGpuLaunchConfig(output.size(), d);
+  return GpuLaunchKernel(SortedSegmentReductionGradKernel<T, AccT, SegmentId>,
+                         config.block_count, config.thread_per_block, 0,
+                         d.stream(), num_rows, output.dimension(1), grad_rows,
+                         segment_ids, weights, scales, grad.data(),
+                         output.data());
+}
+
+namespace {
+
+// Returns true if TF_DETERMINISTIC_OPS asks for deterministic results, which
+// the unsorted segment sums of floating point types then provide by sorting
+// the segment ids and running the sorted reduction.
+bool RequireDeterministicSegmentReductions() {
+  static bool require_determinism = [] {
+    bool deterministic_ops = false;
+    TF_CHECK_OK(tensorflow::ReadBoolFromEnvVar("TF_DETERMINISTIC_OPS",
+                                               /*default_val=*/false,
+                                               &deterministic_ops));
+    return deterministic_ops;
+  }();
+  return require_determinism;
+}
+
+template <typename T, typename ReductionF>
+struct IsDeterministicUnsortedSegmentReduction {
+  static constexpr bool value = false;
+};
+#define DETERMINISTIC_UNSORTED_SEGMENT_REDUCTION(T)                       \
+  template <>                                                             \
+  struct IsDeterministicUnsortedSegmentReduction<T, SumOpGpu<T>> {        \
+    static constexpr bool value = true;                                   \
+  };
+TF_CALL_GPU_NUMBER_TYPES(DETERMINISTIC_UNSORTED_SEGMENT_REDUCTION);
+#undef DETERMINISTIC_UNSORTED_SEGMENT_REDUCTION
+
+// Sorts the (segment id, row) pairs and sums the sorted rows.
+template <typename T, typename Index>
+void DeterministicUnsortedSegmentSum(
+    OpKernelContext* ctx, typename TTypes<Index>::ConstFlat segment_ids,
+    typename TTypes<T, 2>::ConstTensor data,
+    typename TTypes<T, 2>::Tensor output) {
+  const GPUDevice& d = ctx->eigen_device<GPUDevice>();
+  const int64 num_rows = segment_ids.dimension(0);
+  Tensor rows_in;
+  Tensor sorted_ids;
+  Tensor sorted_rows;
+  OP_REQUIRES_OK(ctx, ctx->allocate_temp(DataTypeToEnum<Index>::value,
+                                         TensorShape({num_rows}), &rows_in));
+  OP_REQUIRES_OK(ctx, ctx->allocate_temp(DataTypeToEnum<Index>::value,
+                                         TensorShape({num_rows}), &sorted_ids));
+  OP_REQUIRES_OK(ctx,
+                 ctx->allocate_temp(DataTypeToEnum<Index>::value,
+                                    TensorShape({num_rows}), &sorted_rows));
+  GpuLaunchConfig config = GetGpuLaunchConfig(num_rows, d);
+  OP_REQUIRES_OK(ctx, GpuLaunchKernel(SegmentRangeInitKernel<Index>,
+                                      config.block_count,
+                                      config.thread_per_block, 0, d.stream(),
+                                      num_rows, rows_in.flat<Index>().data()));
+
+  // Determine the temporary storage size, then sort.
+  size_t temp_storage_bytes = 0;
+  const Index* ids_in = segment_ids.data();
+  Index* ids_out = sorted_ids.flat<Index>().data();
+  const Index* rows_in_ptr = rows_in.flat<Index>().data();
+  Index* rows_out = sorted_rows.flat<Index>().data();
+  auto sort = [&](void* temp_storage) {
+    return gpuprim::DeviceRadixSort::SortPairs(
+        temp_storage, temp_storage_bytes, ids_in, ids_out, rows_in_ptr,
+        rows_out, static_cast<int>(num_rows), 0, sizeof(Index) * 8,
+        d.stream());
+  };
+  OP_REQUIRES(ctx, sort(nullptr) == gpuSuccess,
+              errors::Internal("UnsortedSegmentSum: failed to compute the "
+                               "temporary storage size of the sort"));
+  Tensor temp_storage;
+  OP_REQUIRES_OK(
+      ctx, ctx->allocate_temp(
+               DT_INT8, TensorShape({static_cast<int64>(temp_storage_bytes)}),
+               &temp_storage));
+  OP_REQUIRES(ctx, sort(temp_storage.flat<int8>().data()) == gpuSuccess,
+              errors::Internal("UnsortedSegmentSum: failed to sort the "
+                               "segment ids"));
+
+  OP_REQUIRES_OK(ctx, SortedSegmentReductionFunctor<T, Index, Index>()(
+                          ctx, SegmentReductionCombiner::kSum, num_rows,
+                          ids_out, rows_out, /*weights=*/nullptr,
+                          data.dimension(0), data.data(), output));
+}
 
-  // Launch kernel to compute sorted segment sum.
-  // Notes:
-  // *) 'input_total_size' is the total number of elements to process.
-  // *) 'segment_ids.shape' is a prefix of data's shape.
-  // *) 'input_outer_dim_size' is the total number of segments to process.
-  const Index input_total_size = data_size;
-  const Index input_outer_dim_size = segment_ids.dimension(0);
-  const Index input_inner_dim_size = input_total_size / input_outer_dim_size;
-
-  const int OuterDimTileSize = 8;
-
-  const Index input_outer_dim_num_stripe =
-      Eigen::divup(input_outer_dim_size, Index(OuterDimTileSize));
-
-  const Index total_stripe_count =
-      input_inner_dim_size * input_outer_dim_num_stripe;
-
-  config = GetGpuLaunchConfig(total_stripe_count, d);
-  TF_CHECK_OK(GpuLaunchKernel(
-      SortedSegmentSumCustomKernel<T, Index, OuterDimTileSize>,
-      config.block_count, config.thread_per_block, 0, d.stream(),
-      input_outer_dim_size, input_inner_dim_size, output_rows,
-      segment_ids.data(), data, output.data(), total_stripe_count));
+template <typename T, typename Index>
+bool MaybeDeterministicUnsortedSegmentReduction(
+    OpKernelContext* ctx, typename TTypes<Index>::ConstFlat segment_ids,
+    typename TTypes<T, 2>::ConstTensor data,
+    typename TTypes<T, 2>::Tensor output, std::true_type) {
+  if (!RequireDeterministicSegmentReductions()) return false;
+  DeterministicUnsortedSegmentSum<T, Index>(ctx, segment_ids, data, output);
+  return true;
+}
+
+template <typename T, typename Index>
+bool MaybeDeterministicUnsortedSegmentReduction(
+    OpKernelContext* ctx, typename TTypes<Index>::ConstFlat segment_ids,
+    typename TTypes<T, 2>::ConstTensor data,
+    typename TTypes<T, 2>::Tensor output, std::false_type) {
+  return false;
 }
 
+}  // namespace
+
 template <typename T, typename Index, typename InitialValueF,
           typename ReductionF>
 struct UnsortedSegmentFunctor<GPUDevice, T, Index, InitialValueF, ReductionF> {
@@ -179,6 +494,14 @@ struct UnsortedSegmentFunctor<GPUDevice, T, Index, InitialValueF, ReductionF> {
     if (output.size() == 0) {
       return;
     }
+    if (segment_ids_shape.num_elements() > 0 &&
+        MaybeDeterministicUnsortedSegmentReduction<T, Index>(
+            ctx, segment_ids, data, output,
+            std::integral_constant<bool,
+                                   IsDeterministicUnsortedSegmentReduction<
+                                       T, ReductionF>::value>())) {
+      return;
+    }
     // Set 'output' to initial value.
     GPUDevice d = ctx->template eigen_device<GPUDevice>();
     GpuLaunchConfig config = GetGpuLaunchConfig(output.size(), d);
@@ -207,12 +530,15 @@ struct UnsortedSegmentFunctor<GPUDevice, T, Index, InitialValueF, ReductionF> {
   }
 };
 
-#define DEFINE_SORTED_GPU_SPECS_INDEX(T, Index) \
-  template struct SegmentSumFunctor<T, Index>
+#define DEFINE_SORTED_GPU_SPECS_INDEX(T, Index)                 \
+  template struct SortedSegmentReductionFunctor<T, Index, int32>; \
+  template struct SortedSegmentReductionFunctor<T, Index, int64>;
 
-#define DEFINE_SORTED_GPU_SPECS(T)         \
-  DEFINE_SORTED_GPU_SPECS_INDEX(T, int32); \
-  DEFINE_SORTED_GPU_SPECS_INDEX(T, int64);
+#define DEFINE_SORTED_GPU_SPECS(T)                             \
+  DEFINE_SORTED_GPU_SPECS_INDEX(T, int32)                      \
+  DEFINE_SORTED_GPU_SPECS_INDEX(T, int64)                      \
+  template struct SortedSegmentReductionGradFunctor<T, int32>; \
+  template struct SortedSegmentReductionGradFunctor<T, int64>;
 
 TF_CALL_GPU_NUMBER_TYPES(DEFINE_SORTED_GPU_SPECS);
 
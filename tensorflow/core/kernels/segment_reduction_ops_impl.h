@@ -38,7 +38,9 @@ limitations under the License.
 #include "tensorflow/core/kernels/segment_reduction_ops.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/prefetch.h"
 #include "tensorflow/core/util/util.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 #if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
 #include "tensorflow/core/common_runtime/gpu/gpu_event_mgr.h"
@@ -77,6 +79,9 @@ extern bool UnsortedSegmentReductionDoValidation(OpKernel* op_kernel,
                                                  const Tensor& data,
                                                  const Tensor& segment_ids,
                                                  const Tensor& num_segments);
+// Returns the "combiner" attr of the FusedEmbeddingLookupSparse ops.
+extern functor::SegmentReductionCombiner GetSegmentReductionCombiner(
+    OpKernelConstruction* context);
 }  // namespace internal
 
 // This operator handles reducing segments along the first dimension.
@@ -206,103 +211,292 @@ class SegmentReductionOp : public OpKernel {
 };
 
 #if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
-//  SegmentSumGPUOp is a segment sum operator implemented for GPU only.
-//  TODO: This implementation of SegmentSumGPUOp is sometimes slower than
-//  its unsorted counterpart (mostly when problem size is small).
-//  This is due to the following two main reasons and a cost-effective way
-//  to resolve these problems is desirable.
-//  1. Sorted segment sum requires a memory transfer from device to host in
-//     order to know the size of the output dimension whereas unsorted segment
-//     sum receives the size of the output dimension as an input parameter.
-//  2. Sorted segment sum is essentially a tiled version of unsorted segment
-//     sum and therefore such optimization comes at an inherent cost. However
-//     such cost may not be justified when the problem size is small. When to
-//     use the tiled version or the untiled version depends on many factors
-//     including data alignments, ratio of calculation to memory traffic and
-//     obviously, the problem sizes.
-template <class T, class Index>
-class SegmentSumGPUOp : public AsyncOpKernel {
+// Base class of the sorted segment reductions on GPU: SegmentSum and
+// SegmentMean, and the SparseSegment{Sum,Mean,SqrtN}[WithNumSegments] ops,
+// which read row indices[i] of the input instead of row i.
+//
+// Without num_segments the number of output rows is the last segment id
+// plus one, which has to be copied from the device to the host before the
+// output can be allocated. Segment ids outside of [0, output rows) and, for
+// the sparse ops, indices outside of the input are not checked on the device.
+// Their rows are ignored, or read as zeros respectively.
+template <typename T, typename Index, typename SegmentId>
+class SortedSegmentReductionGPUOpBase : public AsyncOpKernel {
  public:
-  explicit SegmentSumGPUOp(OpKernelConstruction* context)
-      : AsyncOpKernel(context) {}
+  SortedSegmentReductionGPUOpBase(OpKernelConstruction* context,
+                                  functor::SegmentReductionCombiner combiner,
+                                  bool is_sparse, bool has_num_segments,
+                                  bool has_weights = false)
+      : AsyncOpKernel(context),
+        combiner_(combiner),
+        is_sparse_(is_sparse),
+        has_num_segments_(has_num_segments),
+        has_weights_(has_weights) {}
 
   void ComputeAsync(OpKernelContext* context, DoneCallback done) override {
     const Tensor& input = context->input(0);
-    const Tensor& segment_ids = context->input(1);
+    const Tensor* indices = is_sparse_ ? &context->input(1) : nullptr;
+    const Tensor& segment_ids = context->input(is_sparse_ ? 2 : 1);
 
+    OP_REQUIRES_ASYNC(
+        context, TensorShapeUtils::IsVectorOrHigher(input.shape()),
+        errors::InvalidArgument("input must be at least rank 1"), done);
     OP_REQUIRES_ASYNC(
         context, TensorShapeUtils::IsVector(segment_ids.shape()),
         errors::InvalidArgument("segment_ids should be a vector."), done);
-
     const int64 num_indices = segment_ids.NumElements();
-    OP_REQUIRES_ASYNC(
-        context, num_indices == input.dim_size(0),
-        errors::InvalidArgument(
-            "segment_ids should be the same size as dimension 0 of"
-            " input."),
-        done);
+    if (is_sparse_) {
+      OP_REQUIRES_ASYNC(context, TensorShapeUtils::IsVector(indices->shape()),
+                        errors::InvalidArgument("indices should be a vector."),
+                        done);
+      OP_REQUIRES_ASYNC(context, num_indices == indices->NumElements(),
+                        errors::InvalidArgument(
+                            "segment_ids and indices should have same size."),
+                        done);
+    } else {
+      OP_REQUIRES_ASYNC(
+          context, num_indices == input.dim_size(0),
+          errors::InvalidArgument(
+              "segment_ids should be the same size as dimension 0 of"
+              " input."),
+          done);
+    }
+    const Tensor* weights = nullptr;
+    if (has_weights_) {
+      const Tensor& weights_in = context->input(3);
+      OP_REQUIRES_ASYNC(
+          context,
+          TensorShapeUtils::IsVector(weights_in.shape()) &&
+              (weights_in.NumElements() == 0 ||
+               weights_in.NumElements() == num_indices),
+          errors::InvalidArgument(
+              "weights should be empty or have the same size as ids."),
+          done);
+      if (weights_in.NumElements() > 0) weights = &weights_in;
+    }
 
-    if (num_indices == 0) {
-      TensorShape output_shape = input.shape();
-      output_shape.set_dim(0, 0);
+    if (has_num_segments_) {
+      const Tensor& num_segments = context->input(3);
+      OP_REQUIRES_ASYNC(
+          context, num_segments.shape().dims() == 0,
+          errors::InvalidArgument("num_segments should be a scalar, not shape ",
+                                  num_segments.shape().DebugString()),
+          done);
+      const int64 output_rows =
+          num_segments.dtype() == DT_INT32
+              ? internal::SubtleMustCopy(num_segments.scalar<int32>()())
+              : internal::SubtleMustCopy(num_segments.scalar<int64>()());
+      OP_REQUIRES_ASYNC(context, output_rows >= 0,
+                        errors::InvalidArgument("segment ids must be >= 0"),
+                        done);
+      ComputeOutput(context, output_rows, input, indices, segment_ids,
+                    weights);
+      done();
+      return;
+    }
 
-      Tensor* output = nullptr;
-      OP_REQUIRES_OK_ASYNC(
-          context, context->allocate_output(0, output_shape, &output), done);
+    if (num_indices == 0) {
+      ComputeOutput(context, 0, input, indices, segment_ids, weights);
       done();
       return;
     }
 
     se::DeviceMemoryBase output_rows_device(
-        const_cast<Tensor&>(segment_ids).template flat<Index>().data() +
+        const_cast<Tensor&>(segment_ids).template flat<SegmentId>().data() +
         (num_indices - 1));
-    ScratchSpace<Index> output_rows_host(context, 1, /* on_host */ true);
+    ScratchSpace<SegmentId> output_rows_host(context, 1, /* on_host */ true);
 
     auto stream = context->op_device_context()->stream();
     OP_REQUIRES_ASYNC(
         context,
         stream
             ->ThenMemcpy(output_rows_host.mutable_data(), output_rows_device,
-                         sizeof(Index))
+                         sizeof(SegmentId))
             .ok(),
-        errors::Internal(
-            "SegmentSumGPUOp: failed to copy output_rows from device"),
+        errors::Internal(type_string(),
+                         ": failed to copy output_rows from device"),
         done);
 
-    functor::SegmentSumFunctor<T, Index> functor_;
-    auto create_and_check_output = [context, output_rows_host, &input,
-                                    &segment_ids, &functor_, done]() {
+    auto create_and_check_output = [this, context, output_rows_host, &input,
+                                    indices, &segment_ids, weights, done]() {
       // Ensure that within the callback, the proper GPU settings are
       // configured.
       auto stream = context->op_device_context()->stream();
       ScopedActivateExecutorContext scoped_activation{stream->parent()};
 
-      Index output_rows = *output_rows_host.data();
-      output_rows++;
+      const int64 output_rows = *output_rows_host.data() + 1;
       OP_REQUIRES_ASYNC(context, output_rows > 0,
                         errors::InvalidArgument("segment ids must be >= 0"),
                         done);
-
-      TensorShape output_shape = input.shape();
-      output_shape.set_dim(0, output_rows);
-
-      Tensor* output = nullptr;
-      OP_REQUIRES_OK_ASYNC(
-          context, context->allocate_output(0, output_shape, &output), done);
-
-      auto output_flat = output->flat_outer_dims<T>();
-      auto data_ptr = input.template flat<T>().data();
-      auto segment_flat = segment_ids.flat<Index>();
-      functor_(context, context->eigen_device<GPUDevice>(), output_rows,
-               segment_ids.shape(), segment_flat, input.NumElements(), data_ptr,
-               output_flat);
-
+      ComputeOutput(context, output_rows, input, indices, segment_ids,
+                    weights);
       done();
     };
 
     context->device()->tensorflow_gpu_device_info()->event_mgr->ThenExecute(
         stream, create_and_check_output);
   }
+
+ private:
+  void ComputeOutput(OpKernelContext* context, int64 output_rows,
+                     const Tensor& input, const Tensor* indices,
+                     const Tensor& segment_ids, const Tensor* weights) {
+    TensorShape output_shape = input.shape();
+    output_shape.set_dim(0, output_rows);
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context,
+                   context->allocate_output(0, output_shape, &output));
+    functor::SortedSegmentReductionFunctor<T, Index, SegmentId> functor;
+    OP_REQUIRES_OK(
+        context,
+        functor(context, combiner_, segment_ids.NumElements(),
+                segment_ids.flat<SegmentId>().data(),
+                indices ? indices->flat<Index>().data() : nullptr,
+                weights ? weights->flat<T>().data() : nullptr,
+                input.dim_size(0), input.flat<T>().data(),
+                output->flat_outer_dims<T>()));
+  }
+
+  const functor::SegmentReductionCombiner combiner_;
+  const bool is_sparse_;
+  const bool has_num_segments_;
+  const bool has_weights_;
+};
+
+template <typename T, typename Index>
+class SegmentSumGPUOp
+    : public SortedSegmentReductionGPUOpBase<T, Index, Index> {
+ public:
+  explicit SegmentSumGPUOp(OpKernelConstruction* context)
+      : SortedSegmentReductionGPUOpBase<T, Index, Index>(
+            context, functor::SegmentReductionCombiner::kSum,
+            false /* is_sparse */, false /* has_num_segments */) {}
+};
+
+template <typename T, typename Index>
+class SegmentMeanGPUOp
+    : public SortedSegmentReductionGPUOpBase<T, Index, Index> {
+ public:
+  explicit SegmentMeanGPUOp(OpKernelConstruction* context)
+      : SortedSegmentReductionGPUOpBase<T, Index, Index>(
+            context, functor::SegmentReductionCombiner::kMean,
+            false /* is_sparse */, false /* has_num_segments */) {}
+};
+
+template <typename T, typename Index, typename SegmentId>
+class SparseSegmentReductionSumGPUOp
+    : public SortedSegmentReductionGPUOpBase<T, Index, SegmentId> {
+ public:
+  explicit SparseSegmentReductionSumGPUOp(OpKernelConstruction* context)
+      : SortedSegmentReductionGPUOpBase<T, Index, SegmentId>(
+            context, functor::SegmentReductionCombiner::kSum,
+            true /* is_sparse */, false /* has_num_segments */) {}
+};
+
+template <typename T, typename Index, typename SegmentId>
+class SparseSegmentReductionSumWithNumSegmentsGPUOp
+    : public SortedSegmentReductionGPUOpBase<T, Index, SegmentId> {
+ public:
+  explicit SparseSegmentReductionSumWithNumSegmentsGPUOp(
+      OpKernelConstruction* context)
+      : SortedSegmentReductionGPUOpBase<T, Index, SegmentId>(
+            context, functor::SegmentReductionCombiner::kSum,
+            true /* is_sparse */, true /* has_num_segments */) {}
+};
+
+template <typename T, typename Index, typename SegmentId>
+class SparseSegmentReductionMeanGPUOp
+    : public SortedSegmentReductionGPUOpBase<T, Index, SegmentId> {
+ public:
+  explicit SparseSegmentReductionMeanGPUOp(OpKernelConstruction* context)
+      : SortedSegmentReductionGPUOpBase<T, Index, SegmentId>(
+            context, functor::SegmentReductionCombiner::kMean,
+            true /* is_sparse */, false /* has_num_segments */) {}
+};
+
+template <typename T, typename Index, typename SegmentId>
+class SparseSegmentReductionMeanWithNumSegmentsGPUOp
+    : public SortedSegmentReductionGPUOpBase<T, Index, SegmentId> {
+ public:
+  explicit SparseSegmentReductionMeanWithNumSegmentsGPUOp(
+      OpKernelConstruction* context)
+      : SortedSegmentReductionGPUOpBase<T, Index, SegmentId>(
+            context, functor::SegmentReductionCombiner::kMean,
+            true /* is_sparse */, true /* has_num_segments */) {}
+};
+
+template <typename T, typename Index, typename SegmentId>
+class SparseSegmentReductionSqrtNGPUOp
+    : public SortedSegmentReductionGPUOpBase<T, Index, SegmentId> {
+ public:
+  explicit SparseSegmentReductionSqrtNGPUOp(OpKernelConstruction* context)
+      : SortedSegmentReductionGPUOpBase<T, Index, SegmentId>(
+            context, functor::SegmentReductionCombiner::kSqrtN,
+            true /* is_sparse */, false /* has_num_segments */) {}
+};
+
+template <typename T, typename Index, typename SegmentId>
+class SparseSegmentReductionSqrtNWithNumSegmentsGPUOp
+    : public SortedSegmentReductionGPUOpBase<T, Index, SegmentId> {
+ public:
+  explicit SparseSegmentReductionSqrtNWithNumSegmentsGPUOp(
+      OpKernelConstruction* context)
+      : SortedSegmentReductionGPUOpBase<T, Index, SegmentId>(
+            context, functor::SegmentReductionCombiner::kSqrtN,
+            true /* is_sparse */, true /* has_num_segments */) {}
+};
+
+template <typename T, typename Index, typename SegmentId>
+class FusedEmbeddingLookupSparseGPUOp
+    : public SortedSegmentReductionGPUOpBase<T, Index, SegmentId> {
+ public:
+  explicit FusedEmbeddingLookupSparseGPUOp(OpKernelConstruction* context)
+      : SortedSegmentReductionGPUOpBase<T, Index, SegmentId>(
+            context, internal::GetSegmentReductionCombiner(context),
+            true /* is_sparse */, false /* has_num_segments */,
+            true /* has_weights */) {}
+};
+
+// The segment ids stay on the device, so rows with segment ids outside of
+// the gradient get zero gradients instead of an error.
+template <typename T, typename SegmentId>
+class FusedEmbeddingLookupSparseGradGPUOp : public OpKernel {
+ public:
+  explicit FusedEmbeddingLookupSparseGradGPUOp(OpKernelConstruction* context)
+      : OpKernel(context),
+        combiner_(internal::GetSegmentReductionCombiner(context)) {}
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& grad = context->input(0);
+    const Tensor& segment_ids = context->input(1);
+    const Tensor& weights = context->input(2);
+    OP_REQUIRES(context, TensorShapeUtils::IsVectorOrHigher(grad.shape()),
+                errors::InvalidArgument("grad must be at least rank 1"));
+    OP_REQUIRES(context, TensorShapeUtils::IsVector(segment_ids.shape()),
+                errors::InvalidArgument("segment_ids should be a vector."));
+    const int64 num_ids = segment_ids.NumElements();
+    OP_REQUIRES(context,
+                TensorShapeUtils::IsVector(weights.shape()) &&
+                    (weights.NumElements() == 0 ||
+                     weights.NumElements() == num_ids),
+                errors::InvalidArgument(
+                    "weights should be empty or have the same size as ids."));
+
+    TensorShape output_shape = grad.shape();
+    output_shape.set_dim(0, num_ids);
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(0, output_shape, &output));
+    functor::SortedSegmentReductionGradFunctor<T, SegmentId> functor;
+    OP_REQUIRES_OK(
+        context,
+        functor(context, combiner_, num_ids,
+                segment_ids.flat<SegmentId>().data(),
+                weights.NumElements() > 0 ? weights.flat<T>().data() : nullptr,
+                grad.flat_outer_dims<T>(), output->flat_outer_dims<T>()));
+  }
+
+ private:
+  const functor::SegmentReductionCombiner combiner_;
 };
 #endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
 
@@ -826,6 +1020,216 @@ class SparseSegmentReductionSumWithNumSegmentsOp
             true /* has_num_segments */, T(0) /* default_value */) {}
 };
 
+// FusedEmbeddingLookupSparseOp computes the same result as a gather of the
+// rows params[ids], a multiplication with the weights and a sparse segment
+// reduction, but accumulates every looked up row directly into its output
+// segment. Segments are sharded across threads, and the next row of a
+// segment is prefetched while the current one is accumulated.
+template <typename T, typename Index, typename SegmentId>
+class FusedEmbeddingLookupSparseOp : public OpKernel {
+ public:
+  explicit FusedEmbeddingLookupSparseOp(OpKernelConstruction* context)
+      : OpKernel(context),
+        combiner_(internal::GetSegmentReductionCombiner(context)) {}
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& params = context->input(0);
+    const Tensor& ids = context->input(1);
+    const Tensor& segment_ids = context->input(2);
+    const Tensor& weights = context->input(3);
+
+    OP_REQUIRES(context, TensorShapeUtils::IsVectorOrHigher(params.shape()),
+                errors::InvalidArgument("params must be at least rank 1"));
+    OP_REQUIRES(context, TensorShapeUtils::IsVector(ids.shape()),
+                errors::InvalidArgument("ids should be a vector."));
+    OP_REQUIRES(context, TensorShapeUtils::IsVector(segment_ids.shape()),
+                errors::InvalidArgument("segment_ids should be a vector."));
+    const int64 num_ids = ids.NumElements();
+    OP_REQUIRES(
+        context, num_ids == segment_ids.NumElements(),
+        errors::InvalidArgument("segment_ids and ids should have same size."));
+    OP_REQUIRES(context,
+                TensorShapeUtils::IsVector(weights.shape()) &&
+                    (weights.NumElements() == 0 ||
+                     weights.NumElements() == num_ids),
+                errors::InvalidArgument(
+                    "weights should be empty or have the same size as ids."));
+
+    const auto ids_vec = ids.vec<Index>();
+    const auto segment_vec = segment_ids.vec<SegmentId>();
+    const int64 num_params = params.dim_size(0);
+    const int64 output_rows =
+        num_ids > 0 ? internal::SubtleMustCopy(segment_vec(num_ids - 1)) + 1
+                    : 0;
+    OP_REQUIRES(context, output_rows >= 0,
+                errors::InvalidArgument("segment ids must be >= 0"));
+
+    // Validates the ids and computes the first row of every segment.
+    std::vector<int64> segment_starts(output_rows + 1, num_ids);
+    SegmentId previous = 0;
+    for (int64 i = num_ids - 1; i >= 0; --i) {
+      const Index id = internal::SubtleMustCopy(ids_vec(i));
+      OP_REQUIRES(context, FastBoundsCheck(id, num_params),
+                  errors::InvalidArgument("ids[", i, "] == ", id,
+                                          " out of range [0, ", num_params,
+                                          ")"));
+      const SegmentId segment = internal::SubtleMustCopy(segment_vec(i));
+      OP_REQUIRES(
+          context,
+          FastBoundsCheck(segment, output_rows) &&
+              (i == num_ids - 1 || segment <= previous),
+          errors::InvalidArgument("segment ids are not increasing"));
+      segment_starts[segment] = i;
+      previous = segment;
+    }
+    // Empty segments start where the next one does.
+    for (int64 segment = output_rows - 1; segment >= 0; --segment) {
+      segment_starts[segment] =
+          std::min(segment_starts[segment], segment_starts[segment + 1]);
+    }
+
+    TensorShape output_shape = params.shape();
+    output_shape.set_dim(0, output_rows);
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(0, output_shape, &output));
+    if (output->NumElements() == 0) return;
+
+    using Row = Eigen::Map<Eigen::Matrix<T, Eigen::Dynamic, 1>>;
+    using ConstRow = Eigen::Map<const Eigen::Matrix<T, Eigen::Dynamic, 1>>;
+    const T* params_data = params.flat<T>().data();
+    const T* weights_data =
+        weights.NumElements() > 0 ? weights.flat<T>().data() : nullptr;
+    T* output_data = output->flat<T>().data();
+    const int64 num_cols = output->NumElements() / output_rows;
+    const functor::SegmentReductionCombiner combiner = combiner_;
+
+    auto work = [&](int64 begin_segment, int64 end_segment) {
+      for (int64 segment = begin_segment; segment < end_segment; ++segment) {
+        Row out(output_data + segment * num_cols, num_cols);
+        out.setZero();
+        const int64 begin = segment_starts[segment];
+        const int64 end = segment_starts[segment + 1];
+        T total = T(0);
+        for (int64 i = begin; i < end; ++i) {
+          if (i + 1 < end) {
+            const Index next = internal::SubtleMustCopy(ids_vec(i + 1));
+            if (FastBoundsCheck(next, num_params)) {
+              port::prefetch<port::PREFETCH_HINT_T0>(params_data +
+                                                     next * num_cols);
+            }
+          }
+          const Index id = internal::SubtleMustCopy(ids_vec(i));
+          if (!FastBoundsCheck(id, num_params)) continue;
+          const T weight = weights_data ? weights_data[i] : T(1);
+          out += weight * ConstRow(params_data + id * num_cols, num_cols);
+          total += combiner == functor::SegmentReductionCombiner::kMean
+                       ? weight
+                       : weight * weight;
+        }
+        if (combiner != functor::SegmentReductionCombiner::kSum &&
+            end > begin) {
+          out *= combiner == functor::SegmentReductionCombiner::kMean
+                     ? T(1) / total
+                     : T(1) / Eigen::numext::sqrt(total);
+        }
+      }
+    };
+    const int64 cost_per_segment =
+        2 * num_cols * std::max<int64>(1, num_ids / output_rows);
+    auto worker_threads = context->device()->tensorflow_cpu_worker_threads();
+    Shard(worker_threads->num_threads, worker_threads->workers, output_rows,
+          cost_per_segment, work);
+  }
+
+ private:
+  const functor::SegmentReductionCombiner combiner_;
+};
+
+// Computes the gradient of FusedEmbeddingLookupSparseOp with respect to the
+// looked up rows params[ids]: row i is row segment_ids[i] of the incoming
+// gradient, times the weight of the id and the scale of its segment.
+template <typename T, typename SegmentId>
+class FusedEmbeddingLookupSparseGradOp : public OpKernel {
+ public:
+  explicit FusedEmbeddingLookupSparseGradOp(OpKernelConstruction* context)
+      : OpKernel(context),
+        combiner_(internal::GetSegmentReductionCombiner(context)) {}
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& grad = context->input(0);
+    const Tensor& segment_ids = context->input(1);
+    const Tensor& weights = context->input(2);
+
+    OP_REQUIRES(context, TensorShapeUtils::IsVectorOrHigher(grad.shape()),
+                errors::InvalidArgument("grad must be at least rank 1"));
+    OP_REQUIRES(context, TensorShapeUtils::IsVector(segment_ids.shape()),
+                errors::InvalidArgument("segment_ids should be a vector."));
+    const int64 num_ids = segment_ids.NumElements();
+    OP_REQUIRES(context,
+                TensorShapeUtils::IsVector(weights.shape()) &&
+                    (weights.NumElements() == 0 ||
+                     weights.NumElements() == num_ids),
+                errors::InvalidArgument(
+                    "weights should be empty or have the same size as ids."));
+
+    const auto segment_vec = segment_ids.vec<SegmentId>();
+    const int64 grad_rows = grad.dim_size(0);
+    const T* weights_data =
+        weights.NumElements() > 0 ? weights.flat<T>().data() : nullptr;
+
+    // Scale of every segment, from its count or sum of (squared) weights.
+    std::vector<T> scales(grad_rows, T(1));
+    std::vector<SegmentId> segments(num_ids);
+    if (combiner_ != functor::SegmentReductionCombiner::kSum) {
+      std::fill(scales.begin(), scales.end(), T(0));
+    }
+    for (int64 i = 0; i < num_ids; ++i) {
+      segments[i] = internal::SubtleMustCopy(segment_vec(i));
+      OP_REQUIRES(context, FastBoundsCheck(segments[i], grad_rows),
+                  errors::InvalidArgument("Segment id ", segments[i],
+                                          " out of range [0, ", grad_rows,
+                                          ")"));
+      const T weight = weights_data ? weights_data[i] : T(1);
+      if (combiner_ == functor::SegmentReductionCombiner::kMean) {
+        scales[segments[i]] += weight;
+      } else if (combiner_ == functor::SegmentReductionCombiner::kSqrtN) {
+        scales[segments[i]] += weight * weight;
+      }
+    }
+    if (combiner_ != functor::SegmentReductionCombiner::kSum) {
+      for (T& scale : scales) {
+        scale = combiner_ == functor::SegmentReductionCombiner::kMean
+                    ? T(1) / scale
+                    : T(1) / Eigen::numext::sqrt(scale);
+      }
+    }
+
+    TensorShape output_shape = grad.shape();
+    output_shape.set_dim(0, num_ids);
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(0, output_shape, &output));
+    if (output->NumElements() == 0) return;
+
+    auto grad_flat = grad.flat_outer_dims<T>();
+    auto output_flat = output->flat_outer_dims<T>();
+    const int64 num_cols = output_flat.dimension(1);
+    auto work = [&](int64 begin, int64 end) {
+      for (int64 i = begin; i < end; ++i) {
+        const T weight = weights_data ? weights_data[i] : T(1);
+        output_flat.template chip<0>(i) =
+            grad_flat.template chip<0>(segments[i]) *
+            (weight * scales[segments[i]]);
+      }
+    };
+    auto worker_threads = context->device()->tensorflow_cpu_worker_threads();
+    Shard(worker_threads->num_threads, worker_threads->workers, num_ids,
+          2 * num_cols, work);
+  }
+
+ private:
+  const functor::SegmentReductionCombiner combiner_;
+};
+
 // Implements the common logic for the gradients of SparseSegmentReduction
 // kernels.
 //
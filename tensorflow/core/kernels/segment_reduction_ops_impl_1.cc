@@ -118,7 +118,12 @@ REGISTER_COMPLEX_CPU_KERNELS_ALL(complex128);
                               .Device(DEVICE_GPU)                      \
                               .TypeConstraint<type>("T")               \
                               .TypeConstraint<index_type>("Tindices"), \
-                          SegmentSumGPUOp<type, index_type>)
+                          SegmentSumGPUOp<type, index_type>);          \
+  REGISTER_KERNEL_BUILDER(Name("SegmentMean")                          \
+                              .Device(DEVICE_GPU)                      \
+                              .TypeConstraint<type>("T")               \
+                              .TypeConstraint<index_type>("Tindices"), \
+                          SegmentMeanGPUOp<type, index_type>)
 
 #define REGISTER_GPU_SORTED_KERNELS_ALL(type) \
   REGISTER_GPU_SORTED_KERNELS(type, int32)
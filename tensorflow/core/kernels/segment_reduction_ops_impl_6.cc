@@ -0,0 +1,100 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// See docs in ../ops/math_ops.cc.
+#include "tensorflow/core/kernels/segment_reduction_ops_impl.h"
+
+namespace tensorflow {
+
+namespace internal {
+
+functor::SegmentReductionCombiner GetSegmentReductionCombiner(
+    OpKernelConstruction* context) {
+  string combiner;
+  Status s = context->GetAttr("combiner", &combiner);
+  if (!s.ok()) {
+    context->CtxFailure(s);
+    return functor::SegmentReductionCombiner::kSum;
+  }
+  if (combiner == "mean") return functor::SegmentReductionCombiner::kMean;
+  if (combiner == "sqrtn") return functor::SegmentReductionCombiner::kSqrtN;
+  return functor::SegmentReductionCombiner::kSum;
+}
+
+}  // namespace internal
+
+#define REGISTER_CPU_KERNELS(type, index_type, segment_ids_type)          \
+  REGISTER_KERNEL_BUILDER(Name("FusedEmbeddingLookupSparse")              \
+                              .Device(DEVICE_CPU)                         \
+                              .TypeConstraint<type>("T")                  \
+                              .TypeConstraint<index_type>("Tidx")         \
+                              .TypeConstraint<segment_ids_type>(          \
+                                  "Tsegmentids"),                         \
+                          FusedEmbeddingLookupSparseOp<type, index_type,  \
+                                                       segment_ids_type>);
+#define REGISTER_CPU_KERNELS_FOR_EACH_INDEX_TYPE(type)                     \
+  REGISTER_CPU_KERNELS(type, int32, int32)                                 \
+  REGISTER_CPU_KERNELS(type, int32, int64)                                 \
+  REGISTER_CPU_KERNELS(type, int64, int32)                                 \
+  REGISTER_CPU_KERNELS(type, int64, int64)                                 \
+  REGISTER_KERNEL_BUILDER(Name("FusedEmbeddingLookupSparseGrad")           \
+                              .Device(DEVICE_CPU)                          \
+                              .TypeConstraint<type>("T")                   \
+                              .TypeConstraint<int32>("Tsegmentids"),       \
+                          FusedEmbeddingLookupSparseGradOp<type, int32>);  \
+  REGISTER_KERNEL_BUILDER(Name("FusedEmbeddingLookupSparseGrad")           \
+                              .Device(DEVICE_CPU)                          \
+                              .TypeConstraint<type>("T")                   \
+                              .TypeConstraint<int64>("Tsegmentids"),       \
+                          FusedEmbeddingLookupSparseGradOp<type, int64>);
+
+TF_CALL_float(REGISTER_CPU_KERNELS_FOR_EACH_INDEX_TYPE);
+TF_CALL_double(REGISTER_CPU_KERNELS_FOR_EACH_INDEX_TYPE);
+#undef REGISTER_CPU_KERNELS
+#undef REGISTER_CPU_KERNELS_FOR_EACH_INDEX_TYPE
+
+#if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+#define REGISTER_GPU_KERNELS(type, index_type, segment_ids_type)             \
+  REGISTER_KERNEL_BUILDER(Name("FusedEmbeddingLookupSparse")                 \
+                              .Device(DEVICE_GPU)                            \
+                              .TypeConstraint<type>("T")                     \
+                              .TypeConstraint<index_type>("Tidx")            \
+                              .TypeConstraint<segment_ids_type>(             \
+                                  "Tsegmentids"),                            \
+                          FusedEmbeddingLookupSparseGPUOp<type, index_type,  \
+                                                          segment_ids_type>);
+#define REGISTER_GPU_KERNELS_FOR_EACH_INDEX_TYPE(type)                       \
+  REGISTER_GPU_KERNELS(type, int32, int32)                                   \
+  REGISTER_GPU_KERNELS(type, int32, int64)                                   \
+  REGISTER_GPU_KERNELS(type, int64, int32)                                   \
+  REGISTER_GPU_KERNELS(type, int64, int64)                                   \
+  REGISTER_KERNEL_BUILDER(Name("FusedEmbeddingLookupSparseGrad")             \
+                              .Device(DEVICE_GPU)                            \
+                              .TypeConstraint<type>("T")                     \
+                              .TypeConstraint<int32>("Tsegmentids"),         \
+                          FusedEmbeddingLookupSparseGradGPUOp<type, int32>); \
+  REGISTER_KERNEL_BUILDER(Name("FusedEmbeddingLookupSparseGrad")             \
+                              .Device(DEVICE_GPU)                            \
+                              .TypeConstraint<type>("T")                     \
+                              .TypeConstraint<int64>("Tsegmentids"),         \
+                          FusedEmbeddingLookupSparseGradGPUOp<type, int64>);
+
+TF_CALL_float(REGISTER_GPU_KERNELS_FOR_EACH_INDEX_TYPE);
+TF_CALL_double(REGISTER_GPU_KERNELS_FOR_EACH_INDEX_TYPE);
+#undef REGISTER_GPU_KERNELS
+#undef REGISTER_GPU_KERNELS_FOR_EACH_INDEX_TYPE
+#endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+
+}  // namespace tensorflow
@@ -13,9 +13,11 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <cmath>
 #include <functional>
 #include <vector>
 
+#include "absl/strings/match.h"
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/common_runtime/device_factory.h"
 #include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
@@ -31,6 +33,7 @@ limitations under the License.
 #include "tensorflow/core/graph/testlib.h"
 #include "tensorflow/core/kernels/ops_testutil.h"
 #include "tensorflow/core/kernels/ops_util.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/test_benchmark.h"
 #include "tensorflow/core/public/session_options.h"
@@ -166,4 +169,153 @@ static void BM_SparseSegmentMeanGrad_High(int iters, int size) {
 BENCHMARK(BM_SparseSegmentMeanGrad_Low)->Arg(1000)->Arg(100000);
 BENCHMARK(BM_SparseSegmentMeanGrad_High)->Arg(1000)->Arg(100000);
 
+class FusedEmbeddingLookupSparseOpTest : public OpsTestBase {
+ protected:
+  void MakeOp(const string& op, const string& combiner) {
+    if (op == "FusedEmbeddingLookupSparse") {
+      TF_ASSERT_OK(NodeDefBuilder("op", op)
+                       .Input(FakeInput(DT_FLOAT))
+                       .Input(FakeInput(DT_INT64))
+                       .Input(FakeInput(DT_INT64))
+                       .Input(FakeInput(DT_FLOAT))
+                       .Attr("combiner", combiner)
+                       .Finalize(node_def()));
+    } else {
+      TF_ASSERT_OK(NodeDefBuilder("op", op)
+                       .Input(FakeInput(DT_FLOAT))
+                       .Input(FakeInput(DT_INT64))
+                       .Input(FakeInput(DT_FLOAT))
+                       .Attr("combiner", combiner)
+                       .Finalize(node_def()));
+    }
+    TF_ASSERT_OK(InitOp());
+  }
+};
+
+TEST_F(FusedEmbeddingLookupSparseOpTest, Unweighted) {
+  for (const string combiner : {"sum", "mean", "sqrtn"}) {
+    MakeOp("FusedEmbeddingLookupSparse", combiner);
+    AddInputFromArray<float>(TensorShape({4, 2}), {1, 2, 3, 4, 5, 6, 7, 8});
+    AddInputFromArray<int64>(TensorShape({5}), {3, 0, 0, 2, 1});
+    AddInputFromArray<int64>(TensorShape({5}), {0, 0, 2, 2, 2});
+    AddInputFromArray<float>(TensorShape({0}), {});
+    TF_ASSERT_OK(RunOpKernel());
+
+    // Segment 1 is empty.
+    Tensor expected(allocator(), DT_FLOAT, TensorShape({3, 2}));
+    if (combiner == "sum") {
+      test::FillValues<float>(&expected, {8, 10, 0, 0, 9, 12});
+    } else if (combiner == "mean") {
+      test::FillValues<float>(&expected, {4, 5, 0, 0, 3, 4});
+    } else {
+      const float s2 = std::sqrt(2.0f);
+      const float s3 = std::sqrt(3.0f);
+      test::FillValues<float>(&expected,
+                              {8 / s2, 10 / s2, 0, 0, 9 / s3, 12 / s3});
+    }
+    test::ExpectTensorNear<float>(expected, *GetOutput(0), 1e-5);
+  }
+}
+
+TEST_F(FusedEmbeddingLookupSparseOpTest, Weighted) {
+  for (const string combiner : {"sum", "mean", "sqrtn"}) {
+    MakeOp("FusedEmbeddingLookupSparse", combiner);
+    AddInputFromArray<float>(TensorShape({3, 2}), {1, 2, 3, 4, 5, 6});
+    AddInputFromArray<int64>(TensorShape({3}), {1, 2, 0});
+    AddInputFromArray<int64>(TensorShape({3}), {0, 0, 1});
+    AddInputFromArray<float>(TensorShape({3}), {2, 1, 4});
+    TF_ASSERT_OK(RunOpKernel());
+
+    Tensor expected(allocator(), DT_FLOAT, TensorShape({2, 2}));
+    if (combiner == "sum") {
+      test::FillValues<float>(&expected, {11, 14, 4, 8});
+    } else if (combiner == "mean") {
+      test::FillValues<float>(&expected, {11 / 3.0f, 14 / 3.0f, 1, 2});
+    } else {
+      const float s5 = std::sqrt(5.0f);
+      test::FillValues<float>(&expected, {11 / s5, 14 / s5, 1, 2});
+    }
+    test::ExpectTensorNear<float>(expected, *GetOutput(0), 1e-5);
+  }
+}
+
+TEST_F(FusedEmbeddingLookupSparseOpTest, IdOutOfRange) {
+  MakeOp("FusedEmbeddingLookupSparse", "sum");
+  AddInputFromArray<float>(TensorShape({2, 1}), {1, 2});
+  AddInputFromArray<int64>(TensorShape({2}), {0, 2});
+  AddInputFromArray<int64>(TensorShape({2}), {0, 0});
+  AddInputFromArray<float>(TensorShape({0}), {});
+  Status s = RunOpKernel();
+  EXPECT_TRUE(absl::StrContains(s.ToString(), "out of range")) << s;
+}
+
+TEST_F(FusedEmbeddingLookupSparseOpTest, SegmentsNotSorted) {
+  MakeOp("FusedEmbeddingLookupSparse", "sum");
+  AddInputFromArray<float>(TensorShape({2, 1}), {1, 2});
+  AddInputFromArray<int64>(TensorShape({3}), {0, 1, 0});
+  AddInputFromArray<int64>(TensorShape({3}), {0, 1, 0});
+  AddInputFromArray<float>(TensorShape({0}), {});
+  Status s = RunOpKernel();
+  EXPECT_TRUE(absl::StrContains(s.ToString(), "not increasing")) << s;
+}
+
+TEST_F(FusedEmbeddingLookupSparseOpTest, Grad) {
+  for (const string combiner : {"sum", "mean", "sqrtn"}) {
+    MakeOp("FusedEmbeddingLookupSparseGrad", combiner);
+    AddInputFromArray<float>(TensorShape({2, 2}), {1, 2, 3, 4});
+    AddInputFromArray<int64>(TensorShape({3}), {0, 0, 1});
+    AddInputFromArray<float>(TensorShape({3}), {3, 1, 2});
+    TF_ASSERT_OK(RunOpKernel());
+
+    Tensor expected(allocator(), DT_FLOAT, TensorShape({3, 2}));
+    if (combiner == "sum") {
+      test::FillValues<float>(&expected, {3, 6, 1, 2, 6, 8});
+    } else if (combiner == "mean") {
+      test::FillValues<float>(&expected,
+                              {0.75f, 1.5f, 0.25f, 0.5f, 3, 4});
+    } else {
+      const float s10 = std::sqrt(10.0f);
+      test::FillValues<float>(
+          &expected, {3 / s10, 6 / s10, 1 / s10, 2 / s10, 3, 4});
+    }
+    test::ExpectTensorNear<float>(expected, *GetOutput(0), 1e-5);
+  }
+}
+
+static void BM_FusedEmbeddingLookupSparse(int iters, int num_ids, int dim) {
+  testing::StopTiming();
+  Graph* g = new Graph(OpRegistry::Global());
+  const int kNumParams = 100000;
+  const int kIdsPerSegment = 16;
+  Tensor params(DT_FLOAT, TensorShape({kNumParams, dim}));
+  params.flat<float>().setRandom();
+  Tensor ids(DT_INT64, TensorShape({num_ids}));
+  Tensor segments(DT_INT64, TensorShape({num_ids}));
+  for (int i = 0; i < num_ids; ++i) {
+    ids.flat<int64>()(i) = (i * 7919) % kNumParams;
+    segments.flat<int64>()(i) = i / kIdsPerSegment;
+  }
+  Tensor weights(DT_FLOAT, TensorShape({0}));
+
+  Node* node;
+  TF_CHECK_OK(NodeBuilder(g->NewName("n"), "FusedEmbeddingLookupSparse")
+                  .Input(test::graph::Constant(g, params))
+                  .Input(test::graph::Constant(g, ids))
+                  .Input(test::graph::Constant(g, segments))
+                  .Input(test::graph::Constant(g, weights))
+                  .Attr("combiner", "mean")
+                  .Finalize(g, &node));
+
+  testing::UseRealTime();
+  testing::BytesProcessed(static_cast<int64>(iters) * num_ids * dim *
+                          sizeof(float));
+  testing::StartTiming();
+  test::Benchmark("cpu", g).Run(iters);
+}
+
+BENCHMARK(BM_FusedEmbeddingLookupSparse)
+    ->ArgPair(1024, 64)
+    ->ArgPair(65536, 64)
+    ->ArgPair(65536, 256);
+
 }  // namespace tensorflow
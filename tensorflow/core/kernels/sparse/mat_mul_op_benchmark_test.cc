@@ -0,0 +1,125 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+
+// Returns a [k, n] weight in which `sparsity` percent of the elements are
+// zero.
+static Tensor SparseWeight(int k, int n, int sparsity) {
+  Tensor weight(DT_FLOAT, TensorShape({k, n}));
+  weight.flat<float>().setRandom();
+  auto values = weight.flat<float>();
+  for (int64 i = 0; i < values.size(); ++i) {
+    if (i % 100 < sparsity) values(i) = 0.0f;
+  }
+  return weight;
+}
+
+// x * w with a dense MatMul.
+static Graph* DenseMatMul(int m, int k, int n, int sparsity) {
+  Graph* g = new Graph(OpRegistry::Global());
+  Tensor x(DT_FLOAT, TensorShape({m, k}));
+  x.flat<float>().setRandom();
+  test::graph::Matmul(g, test::graph::Constant(g, x),
+                      test::graph::Constant(g, SparseWeight(k, n, sparsity)),
+                      false, false);
+  return g;
+}
+
+// x * w as computed after the Grappler remapper rewrite of a MatMul with a
+// sparse constant weight: (csr(w^T) * x^T)^T.
+static Graph* SparseWeightMatMul(int m, int k, int n, int sparsity) {
+  Graph* g = new Graph(OpRegistry::Global());
+  Tensor x(DT_FLOAT, TensorShape({m, k}));
+  x.flat<float>().setRandom();
+  const Tensor weight = SparseWeight(k, n, sparsity);
+  const auto w = weight.matrix<float>();
+
+  int64 nnz = 0;
+  for (int64 i = 0; i < weight.NumElements(); ++i) {
+    if (weight.flat<float>()(i) != 0.0f) ++nnz;
+  }
+  Tensor indices(DT_INT64, TensorShape({nnz, 2}));
+  Tensor values(DT_FLOAT, TensorShape({nnz}));
+  Tensor dense_shape(DT_INT64, TensorShape({2}));
+  int64 index = 0;
+  for (int row = 0; row < n; ++row) {
+    for (int col = 0; col < k; ++col) {
+      if (w(col, row) == 0.0f) continue;
+      indices.matrix<int64>()(index, 0) = row;
+      indices.matrix<int64>()(index, 1) = col;
+      values.vec<float>()(index) = w(col, row);
+      ++index;
+    }
+  }
+  dense_shape.vec<int64>()(0) = n;
+  dense_shape.vec<int64>()(1) = k;
+
+  Node* csr;
+  TF_CHECK_OK(NodeBuilder(g->NewName("csr"), "SparseTensorToCSRSparseMatrix")
+                  .Input(test::graph::Constant(g, indices))
+                  .Input(test::graph::Constant(g, values))
+                  .Input(test::graph::Constant(g, dense_shape))
+                  .Attr("T", DT_FLOAT)
+                  .Finalize(g, &csr));
+  Node* ret;
+  TF_CHECK_OK(NodeBuilder(g->NewName("matmul"), "SparseMatrixMatMul")
+                  .Input(csr)
+                  .Input(test::graph::Constant(g, x))
+                  .Attr("T", DT_FLOAT)
+                  .Attr("transpose_b", true)
+                  .Attr("transpose_output", true)
+                  .Finalize(g, &ret));
+  return g;
+}
+
+#define BM_SparseWeightMatMulDev(DEVICE, M, K, N, S)                          \
+  static void BM_DenseMatMul_##DEVICE##_##M##_##K##_##N##_##S(int iters) {    \
+    testing::UseRealTime();                                                   \
+    testing::ItemsProcessed(static_cast<int64>(iters) * M * K * N * 2);       \
+    test::Benchmark(#DEVICE, DenseMatMul(M, K, N, S)).Run(iters);             \
+  }                                                                           \
+  BENCHMARK(BM_DenseMatMul_##DEVICE##_##M##_##K##_##N##_##S);                 \
+  static void BM_SparseWeightMatMul_##DEVICE##_##M##_##K##_##N##_##S(         \
+      int iters) {                                                            \
+    testing::UseRealTime();                                                   \
+    testing::ItemsProcessed(static_cast<int64>(iters) * M * K * N * 2);       \
+    test::Benchmark(#DEVICE, SparseWeightMatMul(M, K, N, S)).Run(iters);      \
+  }                                                                           \
+  BENCHMARK(BM_SparseWeightMatMul_##DEVICE##_##M##_##K##_##N##_##S);
+
+// The items processed are the flops of the dense MatMul in both cases, so the
+// rates of the two benchmarks are directly comparable.
+#define BM_SparseWeightMatMul(M, K, N, S) \
+  BM_SparseWeightMatMulDev(cpu, M, K, N, S);
+
+BM_SparseWeightMatMul(1, 1024, 1024, 80);
+BM_SparseWeightMatMul(1, 1024, 1024, 90);
+BM_SparseWeightMatMul(1, 1024, 1024, 95);
+BM_SparseWeightMatMul(32, 1024, 1024, 80);
+BM_SparseWeightMatMul(32, 1024, 1024, 90);
+BM_SparseWeightMatMul(32, 1024, 1024, 95);
+BM_SparseWeightMatMul(256, 1024, 1024, 80);
+BM_SparseWeightMatMul(256, 1024, 1024, 90);
+BM_SparseWeightMatMul(256, 1024, 1024, 95);
+BM_SparseWeightMatMul(32, 4096, 1024, 90);
+
+}  // namespace tensorflow
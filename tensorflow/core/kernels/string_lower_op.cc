@@ -17,7 +17,6 @@ limitations under the License.
 
 #include <string>
 
-#include "absl/strings/ascii.h"
 #include "unicode/unistr.h"  // from @icu
 #include "tensorflow/core/framework/kernel_def_builder.h"
 #include "tensorflow/core/framework/op_kernel.h"
@@ -27,6 +26,19 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/str_util.h"
 
 namespace tensorflow {
+namespace {
+
+// Writes the `size` characters of `src` to `dst`, which may be `src`, with
+// the ASCII upper case letters lowered. The loop has no branches so that the
+// compiler vectorizes it.
+void AsciiToLower(const char* src, size_t size, char* dst) {
+  for (size_t i = 0; i < size; ++i) {
+    const unsigned char c = src[i];
+    dst[i] = c + (static_cast<unsigned char>(c - 'A') < 26 ? 'a' - 'A' : 0);
+  }
+}
+
+}  // namespace
 
 class StringLowerOp : public OpKernel {
  public:
@@ -42,22 +54,30 @@ class StringLowerOp : public OpKernel {
     const Tensor* input_tensor;
     OP_REQUIRES_OK(ctx, ctx->input("input", &input_tensor));
     Tensor* output_tensor;
-    OP_REQUIRES_OK(
-        ctx, ctx->allocate_output(0, input_tensor->shape(), &output_tensor));
+    OP_REQUIRES_OK(ctx, ctx->forward_input_or_allocate_output(
+                            {0}, 0, input_tensor->shape(), &output_tensor));
+    const bool in_place = output_tensor->SharesBufferWith(*input_tensor);
 
     const auto input = input_tensor->flat<tstring>();
     auto output = output_tensor->flat<tstring>();
 
     if (encoding_.empty()) {
       for (int64 i = 0; i < input.size(); ++i) {
-        StringPiece entry(input(i));
-        output(i) = absl::AsciiStrToLower(entry);
+        const size_t size = input(i).size();
+        if (in_place) {
+          char* data = output(i).mdata();
+          AsciiToLower(data, size, data);
+        } else {
+          output(i).resize_uninitialized(size);
+          AsciiToLower(input(i).data(), size, output(i).mdata());
+        }
       }
     } else {
       // The validation of utf-8 has already been done in GetAttr above.
       for (int64 i = 0; i < input.size(); ++i) {
         icu::UnicodeString us(input(i).c_str(), "UTF-8");
         us.toLower();
+        output(i).clear();
         us.toUTF8String(output(i));
       }
     }
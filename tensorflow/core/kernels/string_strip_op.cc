@@ -15,6 +15,7 @@ limitations under the License.
 
 // See docs in ../ops/string_ops.cc.
 
+#include <cstring>
 #include <string>
 
 #include "tensorflow/core/framework/kernel_def_builder.h"
@@ -34,8 +35,9 @@ class StringStripOp : public OpKernel {
     const Tensor* input_tensor;
     OP_REQUIRES_OK(ctx, ctx->input("input", &input_tensor));
     Tensor* output_tensor;
-    OP_REQUIRES_OK(
-        ctx, ctx->allocate_output(0, input_tensor->shape(), &output_tensor));
+    OP_REQUIRES_OK(ctx, ctx->forward_input_or_allocate_output(
+                            {0}, 0, input_tensor->shape(), &output_tensor));
+    const bool in_place = output_tensor->SharesBufferWith(*input_tensor);
 
     const auto input = input_tensor->flat<tstring>();
     auto output = output_tensor->flat<tstring>();
@@ -43,7 +45,16 @@ class StringStripOp : public OpKernel {
     for (int64 i = 0; i < input.size(); ++i) {
       StringPiece entry(input(i));
       str_util::RemoveWhitespaceContext(&entry);
-      output(i) = string(entry);
+      if (!in_place) {
+        output(i).assign(entry.data(), entry.size());
+      } else if (entry.size() != output(i).size()) {
+        // Shift the stripped characters to the front of the string, which
+        // mdata() makes owned if it is a view.
+        const size_t offset = entry.data() - input(i).data();
+        char* data = output(i).mdata();
+        std::memmove(data, data + offset, entry.size());
+        output(i).resize(entry.size());
+      }
     }
   }
 };
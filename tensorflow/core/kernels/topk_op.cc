@@ -99,6 +99,103 @@ class TopK : public OpKernel {
 
 namespace functor {
 
+namespace {
+
+// Rows with at least this many columns are split into shards that are
+// selected in parallel when there are fewer rows than threads.
+constexpr int64 kMinColumnsToPartition = 1 << 16;
+
+// Orders the columns of a row by decreasing value, breaking ties in favor of
+// the lower column.
+template <typename T>
+struct StableGreater {
+  bool operator()(const int32 a, const int32 b) const {
+    if (input_data[b] < input_data[a]) {
+      return true;
+    } else if (input_data[b] > input_data[a]) {
+      return false;
+    } else {
+      return a < b;
+    }
+  }
+  const T* input_data;
+};
+
+// Writes the columns kept by `filter` to `out`, in decreasing order if
+// `sorted`.
+template <typename Filter>
+void ExtractTopK(Filter* filter, bool sorted, int32* out) {
+  if (sorted) {
+    std::unique_ptr<std::vector<int32>> top_k(filter->Extract());
+    std::copy(top_k->begin(), top_k->end(), out);
+  } else {
+    std::copy(filter->unsorted_begin(), filter->unsorted_end(), out);
+  }
+}
+
+// Selects the top k of each row by splitting its columns into `num_shards`
+// shards, keeping the top k columns of every shard and merging those
+// candidates. The top k of a row under StableGreater are among the top k of
+// the shards, so the result is the same as selecting from the whole row.
+template <typename T>
+void PartitionedTopK(OpKernelContext* context, bool sorted, int k,
+                     const typename TTypes<T, 2>::ConstTensor& input,
+                     const int64 num_rows, const int64 num_cols,
+                     const int64 num_shards,
+                     typename TTypes<T, 2>::Tensor values,
+                     typename TTypes<int, 2>::Tensor indices) {
+  const int64 shard_cols = Eigen::divup(num_cols, num_shards);
+  // The candidates of shard s of row r start at (r * num_shards + s) * k.
+  std::vector<int32> candidates(num_rows * num_shards * k);
+  std::vector<int32> num_candidates(num_rows * num_shards);
+
+  auto SelectShards = [&](int64 start, int64 limit) {
+    for (int64 i = start; i < limit; ++i) {
+      const int64 row = i / num_shards;
+      const int64 begin = (i % num_shards) * shard_cols;
+      const int64 end = std::min(begin + shard_cols, num_cols);
+      gtl::TopN<int32, StableGreater<T>> filter(
+          k, StableGreater<T>{&input(row, 0)});
+      filter.reserve(end - begin);
+      for (int64 c = begin; c < end; ++c) {
+        filter.push(c);
+      }
+      num_candidates[i] = filter.size();
+      ExtractTopK(&filter, /*sorted=*/false, &candidates[i * k]);
+    }
+  };
+  auto worker_threads = *(context->device()->tensorflow_cpu_worker_threads());
+  const double cmp_cost = 3 * Eigen::TensorOpCost::AddCost<int32>() +
+                          Eigen::TensorOpCost::AddCost<T>();
+  const double log_k = Eigen::numext::log2(static_cast<float>(k + 1));
+  Shard(worker_threads.num_threads, worker_threads.workers,
+        num_rows * num_shards,
+        static_cast<int64>(4 * cmp_cost * shard_cols * log_k), SelectShards);
+
+  auto MergeShards = [&](int64 start, int64 limit) {
+    for (int64 row = start; row < limit; ++row) {
+      gtl::TopN<int32, StableGreater<T>> filter(
+          k, StableGreater<T>{&input(row, 0)});
+      filter.reserve(num_shards * k);
+      for (int64 shard = 0; shard < num_shards; ++shard) {
+        const int64 i = row * num_shards + shard;
+        for (int32 j = 0; j < num_candidates[i]; ++j) {
+          filter.push(candidates[i * k + j]);
+        }
+      }
+      ExtractTopK(&filter, sorted, &indices(row, 0));
+      std::transform(
+          &indices(row, 0), &indices(row, k), &values(row, 0),
+          [row, &input](const int32 loc) { return input(row, loc); });
+    }
+  };
+  Shard(worker_threads.num_threads, worker_threads.workers, num_rows,
+        static_cast<int64>(4 * cmp_cost * num_shards * k * log_k),
+        MergeShards);
+}
+
+}  // namespace
+
 template <typename T>
 struct TopKFunctor<CPUDevice, T> {
   static EIGEN_ALWAYS_INLINE Status
@@ -136,18 +233,26 @@ struct TopKFunctor<CPUDevice, T> {
       return Status::OK();
     }
 
+    // A few huge rows would keep only as many threads busy as there are rows,
+    // so split their columns instead, keeping shards much longer than k for
+    // the merge to stay cheap.
+    auto worker_threads = *(context->device()->tensorflow_cpu_worker_threads());
+    if (k < num_cols && num_cols >= kMinColumnsToPartition &&
+        num_rows < worker_threads.num_threads) {
+      const int64 num_shards =
+          std::min<int64>(Eigen::divup<int64>(worker_threads.num_threads,
+                                              num_rows),
+                          num_cols / (4 * static_cast<int64>(k)));
+      if (num_shards > 1) {
+        PartitionedTopK<T>(context, sorted, k, input, num_rows, num_cols,
+                           num_shards, values, indices);
+        return Status::OK();
+      }
+    }
+
     auto SortIndices = [&](int start_batch, int limit_batch) {
       for (int32 b = start_batch; b < limit_batch; ++b) {
         const T* input_data = &input(b, 0);
-        const auto stable_comp = [input_data](const int32 a, const int32 b) {
-          if (input_data[b] < input_data[a]) {
-            return true;
-          } else if (input_data[b] > input_data[a]) {
-            return false;
-          } else {
-            return a < b;
-          }
-        };
         const auto comp = [input_data](const int32 a, const int32 b) {
           return input_data[b] < input_data[a];
         };
@@ -180,25 +285,13 @@ struct TopKFunctor<CPUDevice, T> {
           }
         } else {
           // Use the TopN heap object to sort.
-          gtl::TopN<int32, decltype(stable_comp)> filter(k, stable_comp);
+          gtl::TopN<int32, StableGreater<T>> filter(
+              k, StableGreater<T>{input_data});
           filter.reserve(num_cols);
           for (int32 c = 0; c < num_cols; ++c) {
             filter.push(c);
           }
-
-          int32 i = 0;
-          if (sorted) {
-            std::unique_ptr<std::vector<int32>> top_k(filter.Extract());
-            for (auto top_k_it = top_k->begin(); top_k_it != top_k->end();
-                 ++top_k_it, ++i) {
-              indices(b, i) = *top_k_it;
-            }
-          } else {
-            for (auto top_k_it = filter.unsorted_begin();
-                 top_k_it != filter.unsorted_end(); ++top_k_it, ++i) {
-              indices(b, i) = *top_k_it;
-            }
-          }
+          ExtractTopK(&filter, sorted, &indices(b, 0));
         }
         // Now that the indices are sorted, copy the values over in
         // sorted order.
@@ -221,7 +314,6 @@ struct TopKFunctor<CPUDevice, T> {
     const int64 final_cost = (total_cost >= static_cast<double>(kint64max))
                                  ? kint64max
                                  : static_cast<int64>(total_cost);
-    auto worker_threads = *(context->device()->tensorflow_cpu_worker_threads());
     Shard(worker_threads.num_threads, worker_threads.workers, num_rows,
           final_cost, SortIndices);
 
@@ -20,6 +20,7 @@ limitations under the License.
 #define EIGEN_USE_GPU
 
 #include <cmath>
+#include <type_traits>
 #include <vector>
 
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
@@ -531,6 +532,380 @@ Status LaunchSortKernel(OpKernelContext* ctx, const T* input, int num_rows,
   return Status::OK();
 }
 
+// Radix select.
+//
+// For large k the heap kernel does not fit in shared memory, and sorting
+// whole rows moves every element through global memory several times. The
+// radix select instead finds the k-th largest key of every row one digit at a
+// time, from the most significant, from the histogram of that digit over the
+// elements whose higher digits match the ones found so far. The elements
+// greater than the k-th key and the lowest-index elements equal to it are
+// then gathered in index order, and only those k elements are sorted. Every
+// pass is spread over several blocks per row, so that a single huge row
+// still occupies the whole device.
+
+constexpr int kRadixBits = 8;
+constexpr int kRadixBins = 1 << kRadixBits;
+constexpr int kRadixThreads = 256;
+// Each block of a row handles at least this many tiles of kRadixThreads.
+constexpr int kRadixMinTilesPerBlock = 16;
+constexpr int kRadixMaxBlocksPerRow = 1024;
+// Rows shorter than this are sorted whole.
+constexpr int kRadixSelectMinCols = 1 << 15;
+
+// Maps values to unsigned keys of the same width that have the same order,
+// with the bit twiddling of the cub radix sort.
+template <typename T>
+struct RadixKey {
+  typedef typename std::make_unsigned<T>::type Type;
+
+  __device__ static Type Convert(T value) {
+    const Type bits = static_cast<Type>(value);
+    if (!std::is_signed<T>::value) return bits;
+    return static_cast<Type>(bits ^ (Type(1) << (sizeof(T) * 8 - 1)));
+  }
+};
+
+template <>
+struct RadixKey<float> {
+  typedef uint32 Type;
+
+  __device__ static Type Convert(float value) {
+    const Type bits = __float_as_uint(value);
+    return (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+  }
+};
+
+template <>
+struct RadixKey<double> {
+  typedef uint64 Type;
+
+  __device__ static Type Convert(double value) {
+    const Type bits = static_cast<Type>(__double_as_longlong(value));
+    return (bits & 0x8000000000000000ull) ? ~bits
+                                          : (bits | 0x8000000000000000ull);
+  }
+};
+
+template <>
+struct RadixKey<Eigen::half> {
+  typedef uint16 Type;
+
+  __device__ static Type Convert(Eigen::half value) {
+    const Type bits = value.x;
+    return static_cast<Type>((bits & 0x8000u) ? ~bits : (bits | 0x8000u));
+  }
+};
+
+// The progress of the selection in one row: the bits of the k-th key selected
+// by `mask` are `prefix`, and `num_greater` elements are known to be greater
+// than the k-th key. All zeros is the initial state.
+template <typename Key>
+struct RadixSelectState {
+  Key prefix;
+  Key mask;
+  int num_greater;
+};
+
+// Adds the digit at `shift` of the keys of the columns of block (row, y) that
+// match the state of the row to the histogram of the row.
+template <typename T>
+__global__ void RadixHistogramKernel(
+    const T* __restrict__ input, int num_cols, int cols_per_block, int shift,
+    const RadixSelectState<typename RadixKey<T>::Type>* __restrict__ states,
+    int* __restrict__ histograms) {
+  typedef typename RadixKey<T>::Type Key;
+  __shared__ int histogram[kRadixBins];
+  for (int i = threadIdx.x; i < kRadixBins; i += blockDim.x) {
+    histogram[i] = 0;
+  }
+  __syncthreads();
+
+  const int row = blockIdx.x;
+  const RadixSelectState<Key> state = states[row];
+  const T* row_input = input + static_cast<int64>(row) * num_cols;
+  const int begin = blockIdx.y * cols_per_block;
+  const int end = min(begin + cols_per_block, num_cols);
+  for (int c = begin + threadIdx.x; c < end; c += blockDim.x) {
+    const Key key = RadixKey<T>::Convert(row_input[c]);
+    if ((key & state.mask) == state.prefix) {
+      atomicAdd(&histogram[(key >> shift) & (kRadixBins - 1)], 1);
+    }
+  }
+  __syncthreads();
+
+  int* row_histogram = histograms + row * kRadixBins;
+  for (int i = threadIdx.x; i < kRadixBins; i += blockDim.x) {
+    if (histogram[i] > 0) atomicAdd(&row_histogram[i], histogram[i]);
+  }
+}
+
+// Picks the digit at `shift` of the k-th key of every row from its histogram,
+// and clears the histogram for the next digit.
+template <typename Key>
+__global__ void RadixSelectDigitKernel(
+    int num_rows, int k, int shift, int* __restrict__ histograms,
+    RadixSelectState<Key>* __restrict__ states) {
+  for (int row : GpuGridRangeX(num_rows)) {
+    RadixSelectState<Key>& state = states[row];
+    int* histogram = histograms + row * kRadixBins;
+    const int remaining = k - state.num_greater;
+    int num_greater = 0;
+    int digit = kRadixBins - 1;
+    for (; digit > 0; --digit) {
+      if (num_greater + histogram[digit] >= remaining) break;
+      num_greater += histogram[digit];
+    }
+    state.num_greater += num_greater;
+    state.prefix |= static_cast<Key>(static_cast<Key>(digit) << shift);
+    state.mask |= static_cast<Key>(static_cast<Key>(kRadixBins - 1) << shift);
+    for (int i = 0; i < kRadixBins; ++i) {
+      histogram[i] = 0;
+    }
+  }
+}
+
+// Counts the keys of block (row, y) that are greater than and equal to the
+// k-th key of the row into block_counts[row][y][0] and [1].
+template <typename T>
+__global__ void RadixCountKernel(
+    const T* __restrict__ input, int num_cols, int cols_per_block,
+    const RadixSelectState<typename RadixKey<T>::Type>* __restrict__ states,
+    int* __restrict__ block_counts) {
+  typedef typename RadixKey<T>::Type Key;
+  __shared__ int counts[2];
+  if (threadIdx.x < 2) counts[threadIdx.x] = 0;
+  __syncthreads();
+
+  const int row = blockIdx.x;
+  const Key kth_key = states[row].prefix;
+  const T* row_input = input + static_cast<int64>(row) * num_cols;
+  const int begin = blockIdx.y * cols_per_block;
+  const int end = min(begin + cols_per_block, num_cols);
+  int num_greater = 0;
+  int num_equal = 0;
+  for (int c = begin + threadIdx.x; c < end; c += blockDim.x) {
+    const Key key = RadixKey<T>::Convert(row_input[c]);
+    num_greater += key > kth_key;
+    num_equal += key == kth_key;
+  }
+  if (num_greater > 0) atomicAdd(&counts[0], num_greater);
+  if (num_equal > 0) atomicAdd(&counts[1], num_equal);
+  __syncthreads();
+
+  if (threadIdx.x < 2) {
+    block_counts[(row * gridDim.y + blockIdx.y) * 2 + threadIdx.x] =
+        counts[threadIdx.x];
+  }
+}
+
+// Turns the counts of the blocks of every row into exclusive prefix sums.
+__global__ void RadixOffsetsKernel(int num_rows, int num_blocks,
+                                   int* __restrict__ block_counts) {
+  for (int row : GpuGridRangeX(num_rows)) {
+    int* counts = block_counts + row * num_blocks * 2;
+    int num_greater = 0;
+    int num_equal = 0;
+    for (int i = 0; i < num_blocks; ++i) {
+      const int block_greater = counts[2 * i];
+      const int block_equal = counts[2 * i + 1];
+      counts[2 * i] = num_greater;
+      counts[2 * i + 1] = num_equal;
+      num_greater += block_greater;
+      num_equal += block_equal;
+    }
+  }
+}
+
+// Writes the elements of block (row, y) that are in the top k of the row in
+// index order: first all the greater ones, then as many of the equal ones as
+// fit in k.
+template <typename T>
+__global__ void RadixGatherKernel(
+    const T* __restrict__ input, int num_cols, int cols_per_block, int k,
+    const RadixSelectState<typename RadixKey<T>::Type>* __restrict__ states,
+    const int* __restrict__ block_offsets, T* __restrict__ values,
+    int* __restrict__ indices) {
+  typedef typename RadixKey<T>::Type Key;
+  typedef cub::BlockScan<int, kRadixThreads> BlockScan;
+  __shared__ typename BlockScan::TempStorage temp_storage;
+
+  const int row = blockIdx.x;
+  const RadixSelectState<Key> state = states[row];
+  const T* row_input = input + static_cast<int64>(row) * num_cols;
+  T* row_values = values + static_cast<int64>(row) * k;
+  int* row_indices = indices + static_cast<int64>(row) * k;
+  const int* offsets = block_offsets + (row * gridDim.y + blockIdx.y) * 2;
+  int greater_offset = offsets[0];
+  int equal_offset = offsets[1];
+  const int num_equal_to_take = k - state.num_greater;
+
+  const int begin = blockIdx.y * cols_per_block;
+  const int end = min(begin + cols_per_block, num_cols);
+  // All threads go through the same tiles, as the scans need all of them.
+  for (int tile = begin; tile < end; tile += kRadixThreads) {
+    const int c = tile + threadIdx.x;
+    T value = T(0);
+    int is_greater = 0;
+    int is_equal = 0;
+    if (c < end) {
+      value = row_input[c];
+      const Key key = RadixKey<T>::Convert(value);
+      is_greater = key > state.prefix;
+      is_equal = key == state.prefix;
+    }
+    int greater_rank;
+    int tile_greater;
+    BlockScan(temp_storage)
+        .ExclusiveSum(is_greater, greater_rank, tile_greater);
+    __syncthreads();
+    int equal_rank;
+    int tile_equal;
+    BlockScan(temp_storage).ExclusiveSum(is_equal, equal_rank, tile_equal);
+    __syncthreads();
+
+    if (is_greater) {
+      const int i = greater_offset + greater_rank;
+      row_values[i] = value;
+      row_indices[i] = c;
+    } else if (is_equal && equal_offset + equal_rank < num_equal_to_take) {
+      const int i = state.num_greater + equal_offset + equal_rank;
+      row_values[i] = value;
+      row_indices[i] = c;
+    }
+    greater_offset += tile_greater;
+    equal_offset += tile_equal;
+  }
+}
+
+template <typename T>
+Status LaunchRadixSelectKernel(OpKernelContext* ctx, const T* input,
+                               int num_rows, int num_cols, int k, bool sorted,
+                               typename TTypes<T, 2>::Tensor values,
+                               TTypes<int, 2>::Tensor indices) {
+  typedef typename RadixKey<T>::Type Key;
+  const GPUDevice& d = ctx->eigen_device<GPUDevice>();
+  const auto& cu_stream = GetGpuStream(ctx);
+
+  const int num_blocks = std::max(
+      1, std::min(kRadixMaxBlocksPerRow,
+                  num_cols / (kRadixThreads * kRadixMinTilesPerBlock)));
+  const int cols_per_block = Eigen::divup(num_cols, num_blocks);
+
+  Tensor states_t;
+  TF_RETURN_IF_ERROR(ctx->allocate_temp(
+      DT_INT8,
+      TensorShape({static_cast<int64>(num_rows *
+                                      sizeof(RadixSelectState<Key>))}),
+      &states_t));
+  auto* states =
+      reinterpret_cast<RadixSelectState<Key>*>(states_t.flat<int8>().data());
+  Tensor histograms_t;
+  TF_RETURN_IF_ERROR(ctx->allocate_temp(
+      DT_INT32, TensorShape({num_rows, kRadixBins}), &histograms_t));
+  int* histograms = histograms_t.flat<int32>().data();
+  Tensor block_counts_t;
+  TF_RETURN_IF_ERROR(ctx->allocate_temp(
+      DT_INT32, TensorShape({num_rows, num_blocks, 2}), &block_counts_t));
+  int* block_counts = block_counts_t.flat<int32>().data();
+  d.memset(states, 0, states_t.TotalBytes());
+  d.memset(histograms, 0, histograms_t.TotalBytes());
+
+  const dim3 grid(num_rows, num_blocks);
+  const GpuLaunchConfig row_config = GetGpuLaunchConfig(num_rows, d);
+  for (int shift = sizeof(Key) * 8 - kRadixBits; shift >= 0;
+       shift -= kRadixBits) {
+    TF_RETURN_IF_ERROR(GpuLaunchKernel(RadixHistogramKernel<T>, grid,
+                                       kRadixThreads, 0, cu_stream, input,
+                                       num_cols, cols_per_block, shift,
+                                       states, histograms));
+    TF_RETURN_IF_ERROR(GpuLaunchKernel(
+        RadixSelectDigitKernel<Key>, row_config.block_count,
+        row_config.thread_per_block, 0, cu_stream, num_rows, k, shift,
+        histograms, states));
+  }
+  TF_RETURN_IF_ERROR(GpuLaunchKernel(RadixCountKernel<T>, grid, kRadixThreads,
+                                     0, cu_stream, input, num_cols,
+                                     cols_per_block, states, block_counts));
+  TF_RETURN_IF_ERROR(GpuLaunchKernel(
+      RadixOffsetsKernel, row_config.block_count, row_config.thread_per_block,
+      0, cu_stream, num_rows, num_blocks, block_counts));
+
+  if (!sorted) {
+    return GpuLaunchKernel(RadixGatherKernel<T>, grid, kRadixThreads, 0,
+                           cu_stream, input, num_cols, cols_per_block, k,
+                           states, block_counts, values.data(),
+                           indices.data());
+  }
+
+  // Gather in index order, so that the stable sort of the selected elements
+  // keeps equal values in increasing index order.
+  Tensor selected_values;
+  Tensor selected_indices;
+  TF_RETURN_IF_ERROR(ctx->allocate_temp(DataTypeToEnum<T>::value,
+                                        TensorShape({num_rows, k}),
+                                        &selected_values));
+  TF_RETURN_IF_ERROR(ctx->allocate_temp(DT_INT32, TensorShape({num_rows, k}),
+                                        &selected_indices));
+  TF_RETURN_IF_ERROR(GpuLaunchKernel(
+      RadixGatherKernel<T>, grid, kRadixThreads, 0, cu_stream, input,
+      num_cols, cols_per_block, k, states, block_counts,
+      selected_values.flat<T>().data(), selected_indices.flat<int32>().data()));
+
+  cub::CountingInputIterator<int> counting_iter(0);
+  cub::TransformInputIterator<int, SegmentOffsetCreator,
+                              cub::CountingInputIterator<int>>
+      segment_offsets_t(counting_iter, SegmentOffsetCreator(k));
+  size_t temp_storage_bytes = 0;
+  auto err = cub::DeviceSegmentedRadixSort::SortPairsDescending(
+      /* d_temp_storage */ nullptr,
+      /* temp_storage_bytes */ temp_storage_bytes,
+      /* d_keys_in */ selected_values.flat<T>().data(),
+      /* d_keys_out */ values.data(),
+      /* d_values_in */ selected_indices.flat<int32>().data(),
+      /* d_values_out */ indices.data(),
+      /* num_items */ num_rows * k,
+      /* num_segments */ num_rows,
+      /* d_begin_offsets */ segment_offsets_t,
+      /* d_end_offsets */ segment_offsets_t + 1,
+      /* begin_bit */ 0,
+      /* end_bit */ sizeof(T) * 8,
+      /* stream */ cu_stream);
+  if (err != cudaSuccess) {
+    return errors::Internal(
+        "TopKOp: Could not launch "
+        "cub::DeviceSegmentedRadixSort::SortPairsDescending to calculate "
+        "temp_storage_bytes, status: ",
+        cudaGetErrorString(err));
+  }
+  Tensor temp_storage;
+  TF_RETURN_IF_ERROR(ctx->allocate_temp(
+      DT_INT8, TensorShape({static_cast<int64>(temp_storage_bytes)}),
+      &temp_storage));
+  err = cub::DeviceSegmentedRadixSort::SortPairsDescending(
+      /* d_temp_storage */ temp_storage.flat<int8>().data(),
+      /* temp_storage_bytes */ temp_storage_bytes,
+      /* d_keys_in */ selected_values.flat<T>().data(),
+      /* d_keys_out */ values.data(),
+      /* d_values_in */ selected_indices.flat<int32>().data(),
+      /* d_values_out */ indices.data(),
+      /* num_items */ num_rows * k,
+      /* num_segments */ num_rows,
+      /* d_begin_offsets */ segment_offsets_t,
+      /* d_end_offsets */ segment_offsets_t + 1,
+      /* begin_bit */ 0,
+      /* end_bit */ sizeof(T) * 8,
+      /* stream */ cu_stream);
+  if (err != cudaSuccess) {
+    return errors::Internal(
+        "TopKOp: Could not launch "
+        "cub::DeviceSegmentedRadixSort::SortPairsDescending to sort the "
+        "selected elements, temp_storage_bytes: ",
+        temp_storage_bytes, ", status: ", cudaGetErrorString(err));
+  }
+  return Status::OK();
+}
+
 }  // end namespace impl
 
 namespace functor {
@@ -545,8 +920,13 @@ struct TopKFunctor<GPUDevice, T> {
     // For small k, use the heap implementation.  For larger k, use
     // the in-place cub sort.  For k == num_cols, always use the
     // in-place cub sort.  The thresholds for n and k were determined
-    // empirically.
-    if (num_cols <= 1000 || k == num_cols || k >= 100) {
+    // empirically.  Long rows use the radix select instead of the sort, which
+    // only sorts the k selected elements.
+    if (k >= 100 && k < num_cols && num_cols >= impl::kRadixSelectMinCols) {
+      return impl::LaunchRadixSelectKernel(context, input.data(), num_rows,
+                                           num_cols, k, sorted, values,
+                                           indices);
+    } else if (num_cols <= 1000 || k == num_cols || k >= 100) {
       return impl::LaunchSortKernel(context, input.data(), num_rows, num_cols,
                                     k, values, indices);
     } else {
@@ -153,35 +153,31 @@ VariableInputLockHolder MaybeLockVariableInputMutexesInOrder(
   }
   std::vector<Var*> vars;
   std::vector<mutex*> mutexes;
-  std::vector<int> acquire_order;
   for (auto input : input_ids) {
     Var* var;
     mutex* mutex =
         GetTrainingVariableMutex<Device, T>(ctx, input, sparse, &var);
     if (var) vars.push_back(var);
-    // Only lock each mutex once if duplicates exist (n^2 but n is 2 or 3).
-    if (std::find(mutexes.begin(), mutexes.end(), mutex) == mutexes.end()) {
-      acquire_order.push_back(mutexes.size());
-      mutexes.push_back(mutex);
-    }
+    if (mutex != nullptr) mutexes.push_back(mutex);
   }
-  std::sort(acquire_order.begin(), acquire_order.end(),
-            [&mutexes](int a, int b) { return mutexes[a] < mutexes[b]; });
+  // Lock each mutex once if duplicates exist. The variables in `vars` keep
+  // the mutexes alive.
+  std::sort(mutexes.begin(), mutexes.end());
+  mutexes.erase(std::unique(mutexes.begin(), mutexes.end()), mutexes.end());
 
   auto locks = absl::make_unique<std::vector<mutex_lock>>();
   auto shared_locks = absl::make_unique<std::vector<tf_shared_lock>>();
-  locks->reserve(acquire_order.size());
+  if (!sparse || do_lock) {
+    locks->reserve(mutexes.size());
+  } else {
+    shared_locks->reserve(mutexes.size());
+  }
 
-  for (auto input : acquire_order) {
-    Var* var;
-    mutex* mu = GetTrainingVariableMutex<Device, T>(ctx, input, sparse, &var);
-    core::ScopedUnref scoped_unref(var);
-    if (mu != nullptr) {
-      if (!sparse || do_lock) {
-        locks->emplace_back(*mu);
-      } else {
-        shared_locks->emplace_back(*mu);
-      }
+  for (mutex* mu : mutexes) {
+    if (!sparse || do_lock) {
+      locks->emplace_back(*mu);
+    } else {
+      shared_locks->emplace_back(*mu);
     }
   }
   return VariableInputLockHolder(std::move(vars), std::move(locks),
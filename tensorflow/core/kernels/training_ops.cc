@@ -17,6 +17,7 @@ limitations under the License.
 #include "tensorflow/core/kernels/training_ops.h"
 
 #include <algorithm>  // NOLINT
+#include <numeric>
 
 #include "tensorflow/core/framework/bounds_check.h"
 #include "tensorflow/core/framework/op_kernel.h"
@@ -48,6 +49,57 @@ inline T sgn(const T x) {
 }  // namespace
 
 namespace functor {
+namespace {
+
+// Elements of every operand updated at a time on CPU, so that a block of up to
+// 6 operands stays in L2.
+constexpr Index kApplyBlockSize = 4096;
+
+// An unaligned map of `size` elements of the flat tensor `x`, from `begin`.
+template <typename Scalar>
+Eigen::TensorMap<Eigen::Tensor<Scalar, 1, Eigen::RowMajor, Eigen::DenseIndex>,
+                 Eigen::Unaligned>
+FlatBlock(Eigen::TensorMap<
+              Eigen::Tensor<Scalar, 1, Eigen::RowMajor, Eigen::DenseIndex>,
+              Eigen::Aligned>
+              x,
+          Index begin, Index size) {
+  return Eigen::TensorMap<
+      Eigen::Tensor<Scalar, 1, Eigen::RowMajor, Eigen::DenseIndex>,
+      Eigen::Unaligned>(x.data() + begin, size);
+}
+
+// Per element cost of an update that reads `inputs` and writes `outputs`
+// tensors of type T.
+template <typename T>
+Eigen::TensorOpCost UpdateCost(int inputs, int outputs, int adds, int muls,
+                               int divs) {
+  return Eigen::TensorOpCost(
+      inputs * sizeof(T), outputs * sizeof(T),
+      adds * Eigen::TensorOpCost::AddCost<T>() +
+          muls * Eigen::TensorOpCost::MulCost<T>() +
+          divs * Eigen::TensorOpCost::DivCost<T>());
+}
+
+// Calls update(operands...) on blocks of `size` elements of the flat
+// operands, on the threads of `d`. Every call gets the same block of all the
+// operands, so an update made of several Eigen expressions reads and writes
+// each operand once while the block is in cache, instead of once per
+// expression as with `x.device(d) = ...`.
+template <typename Update, typename... Operands>
+void ApplyInBlocks(const CPUDevice& d, Index size,
+                   const Eigen::TensorOpCost& cost, Update update,
+                   Operands... operands) {
+  d.parallelFor(size, cost, [&](Index first, Index last) {
+    for (Index begin = first; begin < last; begin += kApplyBlockSize) {
+      const Index block_size = std::min(kApplyBlockSize, last - begin);
+      update(FlatBlock(operands, begin, block_size)...);
+    }
+  });
+}
+
+}  // namespace
+
 template <typename T>
 struct ApplyGradientDescent<CPUDevice, T> {
   void operator()(const CPUDevice& d, typename TTypes<T>::Flat var,
@@ -76,13 +128,21 @@ struct ApplyAdadelta<CPUDevice, T> {
                   typename TTypes<T>::ConstScalar rho,
                   typename TTypes<T>::ConstScalar epsilon,
                   typename TTypes<T>::ConstFlat grad) {
-    accum.device(d) =
-        accum * rho() + grad.square() * (static_cast<T>(1) - rho());
-    const auto update =
-        (accum_update + epsilon()).sqrt() * (accum + epsilon()).rsqrt() * grad;
-    var.device(d) -= update * lr();
-    accum_update.device(d) =
-        accum_update * rho() + update.square() * (static_cast<T>(1) - rho());
+    const T lr_v = lr();
+    const T rho_v = rho();
+    const T epsilon_v = epsilon();
+    ApplyInBlocks(
+        d, var.size(), UpdateCost<T>(4, 3, 6, 9, 2),
+        [&](auto var_b, auto accum_b, auto accum_update_b, auto grad_b) {
+          accum_b = accum_b * rho_v +
+                    grad_b.square() * (static_cast<T>(1) - rho_v);
+          const auto update = (accum_update_b + epsilon_v).sqrt() *
+                              (accum_b + epsilon_v).rsqrt() * grad_b;
+          var_b -= update * lr_v;
+          accum_update_b = accum_update_b * rho_v +
+                           update.square() * (static_cast<T>(1) - rho_v);
+        },
+        var, accum, accum_update, grad);
   }
 };
 
@@ -156,10 +216,16 @@ struct ApplyAdagrad<CPUDevice, T> {
                   typename TTypes<T>::Flat accum,
                   typename TTypes<T>::ConstScalar lr,
                   typename TTypes<T>::ConstFlat grad, bool update_slots) {
-    if (update_slots) {
-      accum.device(d) += grad.square();
-    }
-    var.device(d) -= grad * lr() * accum.rsqrt();
+    const T lr_v = lr();
+    ApplyInBlocks(
+        d, var.size(), UpdateCost<T>(3, 2, 2, 3, 1),
+        [&](auto var_b, auto accum_b, auto grad_b) {
+          if (update_slots) {
+            accum_b += grad_b.square();
+          }
+          var_b -= grad_b * lr_v * accum_b.rsqrt();
+        },
+        var, accum, grad);
   }
 };
 
@@ -170,10 +236,17 @@ struct ApplyAdagradV2<CPUDevice, T> {
                   typename TTypes<T>::ConstScalar lr,
                   typename TTypes<T>::ConstScalar epsilon,
                   typename TTypes<T>::ConstFlat grad, bool update_slots) {
-    if (update_slots) {
-      accum.device(d) += grad.square();
-    }
-    var.device(d) -= grad * lr() / (accum.sqrt() + epsilon());
+    const T lr_v = lr();
+    const T epsilon_v = epsilon();
+    ApplyInBlocks(
+        d, var.size(), UpdateCost<T>(3, 2, 3, 2, 2),
+        [&](auto var_b, auto accum_b, auto grad_b) {
+          if (update_slots) {
+            accum_b += grad_b.square();
+          }
+          var_b -= grad_b * lr_v / (accum_b.sqrt() + epsilon_v);
+        },
+        var, accum, grad);
   }
 };
 
@@ -370,12 +443,19 @@ struct ApplyMomentum<CPUDevice, T> {
                   typename TTypes<T>::ConstScalar lr,
                   typename TTypes<T>::ConstFlat grad,
                   typename TTypes<T>::ConstScalar momentum, bool use_nesterov) {
-    accum.device(d) = accum * momentum() + grad;
-    if (use_nesterov) {
-      var.device(d) -= grad * lr() + accum * momentum() * lr();
-    } else {
-      var.device(d) -= accum * lr();
-    }
+    const T lr_v = lr();
+    const T momentum_v = momentum();
+    ApplyInBlocks(
+        d, var.size(), UpdateCost<T>(3, 2, 3, 4, 0),
+        [&](auto var_b, auto accum_b, auto grad_b) {
+          accum_b = accum_b * momentum_v + grad_b;
+          if (use_nesterov) {
+            var_b -= grad_b * lr_v + accum_b * momentum_v * lr_v;
+          } else {
+            var_b -= accum_b * lr_v;
+          }
+        },
+        var, accum, grad);
   }
 };
 
@@ -386,12 +466,19 @@ struct ApplyKerasMomentum<CPUDevice, T> {
                   typename TTypes<T>::ConstScalar lr,
                   typename TTypes<T>::ConstFlat grad,
                   typename TTypes<T>::ConstScalar momentum, bool use_nesterov) {
-    accum.device(d) = accum * momentum() - grad * lr();
-    if (use_nesterov) {
-      var.device(d) += (accum * momentum() - grad * lr());
-    } else {
-      var.device(d) += accum;
-    }
+    const T lr_v = lr();
+    const T momentum_v = momentum();
+    ApplyInBlocks(
+        d, var.size(), UpdateCost<T>(3, 2, 3, 4, 0),
+        [&](auto var_b, auto accum_b, auto grad_b) {
+          accum_b = accum_b * momentum_v - grad_b * lr_v;
+          if (use_nesterov) {
+            var_b += (accum_b * momentum_v - grad_b * lr_v);
+          } else {
+            var_b += accum_b;
+          }
+        },
+        var, accum, grad);
   }
 };
 
@@ -423,6 +510,23 @@ struct SparseApplyKerasMomentum<CPUDevice, T, Tindex> {
   }
 };
 
+// The Adam update of one block of var, m and v, with the bias corrected
+// learning rate alpha.
+template <typename T, typename Block, typename ConstBlock>
+void AdamUpdate(Block var, Block m, Block v, ConstBlock g, const T alpha,
+                const T beta1, const T beta2, const T epsilon,
+                bool use_nesterov) {
+  if (use_nesterov) {
+    m += (g - m) * (T(1) - beta1);
+    v += (g.square() - v) * (T(1) - beta2);
+    var -= ((g * (T(1) - beta1) + beta1 * m) * alpha) / (v.sqrt() + epsilon);
+  } else {
+    m += (g - m) * (T(1) - beta1);
+    v += (g.square() - v) * (T(1) - beta2);
+    var -= (m * alpha) / (v.sqrt() + epsilon);
+  }
+}
+
 template <typename Device, typename T>
 struct ApplyAdamNonCuda {
   void operator()(const Device& d, typename TTypes<T>::Flat var,
@@ -462,17 +566,8 @@ struct ApplyAdamNonCuda {
       auto m = typename TTypes<T>::UnalignedTensor(m_ptr + begin, t_size);
       auto v = typename TTypes<T>::UnalignedTensor(v_ptr + begin, t_size);
       auto g = typename TTypes<T>::UnalignedConstTensor(g_ptr + begin, t_size);
-
-      if (use_nesterov) {
-        m += (g - m) * (T(1) - beta1());
-        v += (g.square() - v) * (T(1) - beta2());
-        var -= ((g * (T(1) - beta1()) + beta1() * m) * alpha) /
-               (v.sqrt() + epsilon());
-      } else {
-        m += (g - m) * (T(1) - beta1());
-        v += (g.square() - v) * (T(1) - beta2());
-        var -= (m * alpha) / (v.sqrt() + epsilon());
-      }
+      AdamUpdate(var, m, v, g, alpha, beta1(), beta2(), epsilon(),
+                 use_nesterov);
     };
 
     // Input data: var, v, m, grad.
@@ -515,6 +610,50 @@ struct ApplyAdamSYCL {
 template <typename T>
 struct ApplyAdam<CPUDevice, T> : ApplyAdamNonCuda<CPUDevice, T> {};
 
+template <typename T>
+struct ApplyAdamMultiTensor<CPUDevice, T> {
+  void operator()(OpKernelContext* ctx, const CPUDevice& d,
+                  const std::vector<AdamTensors<T>>& tensors,
+                  typename TTypes<T>::ConstScalar beta1_power,
+                  typename TTypes<T>::ConstScalar beta2_power,
+                  typename TTypes<T>::ConstScalar lr,
+                  typename TTypes<T>::ConstScalar beta1,
+                  typename TTypes<T>::ConstScalar beta2,
+                  typename TTypes<T>::ConstScalar epsilon, bool use_nesterov) {
+    const T alpha = lr() * Eigen::numext::sqrt(T(1) - beta2_power()) /
+                    (T(1) - beta1_power());
+    const T beta1_v = beta1();
+    const T beta2_v = beta2();
+    const T epsilon_v = epsilon();
+    // The variables are laid end to end in a single index space, so that the
+    // shards of the loop have the same cost whatever the sizes of the
+    // variables.
+    std::vector<Index> offsets(tensors.size() + 1, 0);
+    for (size_t i = 0; i < tensors.size(); ++i) {
+      offsets[i + 1] = offsets[i] + tensors[i].size;
+    }
+    auto shard = [&](Index first, Index last) {
+      size_t i = std::upper_bound(offsets.begin(), offsets.end(), first) -
+                 offsets.begin() - 1;
+      for (Index begin = first; begin < last;) {
+        const Index end =
+            std::min({last, offsets[i + 1], begin + kApplyBlockSize});
+        const AdamTensors<T>& t = tensors[i];
+        const Index offset = begin - offsets[i];
+        const Index size = end - begin;
+        using Flat = typename TTypes<T>::UnalignedFlat;
+        using ConstFlat = typename TTypes<T>::UnalignedConstFlat;
+        AdamUpdate(Flat(t.var + offset, size), Flat(t.m + offset, size),
+                   Flat(t.v + offset, size), ConstFlat(t.grad + offset, size),
+                   alpha, beta1_v, beta2_v, epsilon_v, use_nesterov);
+        if (end == offsets[i + 1]) ++i;
+        begin = end;
+      }
+    };
+    d.parallelFor(offsets.back(), UpdateCost<T>(4, 3, 10, 6, 2), shard);
+  }
+};
+
 template <typename T>
 struct ApplyAdamWithAmsgrad<CPUDevice, T> {
   void operator()(const CPUDevice& d, typename TTypes<T>::Flat var,
@@ -530,16 +669,24 @@ struct ApplyAdamWithAmsgrad<CPUDevice, T> {
     const T alpha = lr() * Eigen::numext::sqrt(T(1) - beta2_power()) /
                     (T(1) - beta1_power());
 
-    m.device(d) += (grad - m) * (T(1) - beta1());
-    v.device(d) += (grad.square() - v) * (T(1) - beta2());
-    vhat.device(d) = vhat.cwiseMax(v);
-    var.device(d) -= (m * alpha) / (vhat.sqrt() + epsilon());
+    const T beta1_v = beta1();
+    const T beta2_v = beta2();
+    const T epsilon_v = epsilon();
+    ApplyInBlocks(
+        d, var.size(), UpdateCost<T>(5, 4, 7, 4, 2),
+        [&](auto var_b, auto m_b, auto v_b, auto vhat_b, auto grad_b) {
+          m_b += (grad_b - m_b) * (T(1) - beta1_v);
+          v_b += (grad_b.square() - v_b) * (T(1) - beta2_v);
+          vhat_b = vhat_b.cwiseMax(v_b);
+          var_b -= (m_b * alpha) / (vhat_b.sqrt() + epsilon_v);
+        },
+        var, m, v, vhat, grad);
   }
 };
 
-template <typename Device, typename T>
-struct ApplyAdaMaxNonCuda {
-  void operator()(const Device& d, typename TTypes<T>::Flat var,
+template <typename T>
+struct ApplyAdaMax<CPUDevice, T> {
+  void operator()(const CPUDevice& d, typename TTypes<T>::Flat var,
                   typename TTypes<T>::Flat m, typename TTypes<T>::Flat v,
                   typename TTypes<T>::ConstScalar beta1_power,
                   typename TTypes<T>::ConstScalar lr,
@@ -547,17 +694,23 @@ struct ApplyAdaMaxNonCuda {
                   typename TTypes<T>::ConstScalar beta2,
                   typename TTypes<T>::ConstScalar epsilon,
                   typename TTypes<T>::ConstFlat grad) {
-    m.device(d) += (grad - m) * (T(1) - beta1());
-    // Here v is u in section 7.1
-    v.device(d) = (beta2() * v).cwiseMax(grad.abs());
-    // var is θ in section 7.1
-    var.device(d) -= lr() / (T(1) - beta1_power()) * (m / (v + epsilon()));
+    const T beta1_v = beta1();
+    const T beta2_v = beta2();
+    const T epsilon_v = epsilon();
+    const T alpha = lr() / (T(1) - beta1_power());
+    ApplyInBlocks(
+        d, var.size(), UpdateCost<T>(4, 3, 5, 3, 1),
+        [&](auto var_b, auto m_b, auto v_b, auto grad_b) {
+          m_b += (grad_b - m_b) * (T(1) - beta1_v);
+          // Here v is u in section 7.1
+          v_b = (beta2_v * v_b).cwiseMax(grad_b.abs());
+          // var is θ in section 7.1
+          var_b -= alpha * (m_b / (v_b + epsilon_v));
+        },
+        var, m, v, grad);
   }
 };
 
-template <typename T>
-struct ApplyAdaMax<CPUDevice, T> : ApplyAdaMaxNonCuda<CPUDevice, T> {};
-
 template <typename T>
 struct ApplyRMSProp<CPUDevice, T> {
   void operator()(const CPUDevice& d, typename TTypes<T>::Flat var,
@@ -567,10 +720,19 @@ struct ApplyRMSProp<CPUDevice, T> {
                   typename TTypes<T>::ConstScalar momentum,
                   typename TTypes<T>::ConstScalar epsilon,
                   typename TTypes<T>::ConstFlat grad) {
-    ms.device(d) += (grad.square() - ms) * (static_cast<T>(1) - rho());
-    mom.device(d) =
-        mom * momentum() + (grad * lr()) / ((ms + epsilon()).sqrt());
-    var.device(d) -= mom;
+    const T lr_v = lr();
+    const T rho_v = rho();
+    const T momentum_v = momentum();
+    const T epsilon_v = epsilon();
+    ApplyInBlocks(
+        d, var.size(), UpdateCost<T>(4, 3, 5, 4, 2),
+        [&](auto var_b, auto ms_b, auto mom_b, auto grad_b) {
+          ms_b += (grad_b.square() - ms_b) * (static_cast<T>(1) - rho_v);
+          mom_b = mom_b * momentum_v +
+                  (grad_b * lr_v) / ((ms_b + epsilon_v).sqrt());
+          var_b -= mom_b;
+        },
+        var, ms, mom, grad);
   }
 };
 
@@ -584,11 +746,20 @@ struct ApplyCenteredRMSProp<CPUDevice, T> {
                   typename TTypes<T>::ConstScalar momentum,
                   typename TTypes<T>::ConstScalar epsilon,
                   typename TTypes<T>::ConstFlat grad) {
-    ms.device(d) += (grad.square() - ms) * (static_cast<T>(1) - rho());
-    mg.device(d) += (grad - mg) * (static_cast<T>(1) - rho());
-    auto denom = (ms - mg.square()) + epsilon();
-    mom.device(d) = mom * momentum() + (grad * lr()) / denom.sqrt();
-    var.device(d) -= mom;
+    const T lr_v = lr();
+    const T rho_v = rho();
+    const T momentum_v = momentum();
+    const T epsilon_v = epsilon();
+    ApplyInBlocks(
+        d, var.size(), UpdateCost<T>(5, 4, 9, 6, 2),
+        [&](auto var_b, auto mg_b, auto ms_b, auto mom_b, auto grad_b) {
+          ms_b += (grad_b.square() - ms_b) * (static_cast<T>(1) - rho_v);
+          mg_b += (grad_b - mg_b) * (static_cast<T>(1) - rho_v);
+          auto denom = (ms_b - mg_b.square()) + epsilon_v;
+          mom_b = mom_b * momentum_v + (grad_b * lr_v) / denom.sqrt();
+          var_b -= mom_b;
+        },
+        var, mg, ms, mom, grad);
   }
 };
 
@@ -3705,6 +3876,142 @@ REGISTER_KERNELS(GPU, complex128);
 #undef REGISTER_CPU_KERNELS
 #undef REGISTER_KERNELS
 
+template <typename Device, typename T>
+class ApplyAdamMultiTensorOp : public OpKernel {
+ public:
+  explicit ApplyAdamMultiTensorOp(OpKernelConstruction* ctx) : OpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("use_locking", &use_exclusive_lock_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("use_nesterov", &use_nesterov_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("N", &num_variables_));
+  }
+
+  void Compute(OpKernelContext* ctx) override {
+    const bool sparse = false;
+    const int n = num_variables_;
+    // The var, m and v inputs of all the variables come first.
+    std::vector<int> variable_inputs(3 * n);
+    std::iota(variable_inputs.begin(), variable_inputs.end(), 0);
+    auto locks = MaybeLockVariableInputMutexesInOrder<Device, T>(
+        ctx, use_exclusive_lock_, sparse, variable_inputs);
+
+    std::vector<Tensor> variables(3 * n);
+    for (int i = 0; i < 3 * n; ++i) {
+      OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<Device, T>(
+                              ctx, i, use_exclusive_lock_, sparse,
+                              &variables[i]));
+      OP_REQUIRES(ctx, variables[i].IsInitialized(),
+                  errors::FailedPrecondition(
+                      "Attempting to use uninitialized variables: ",
+                      requested_input(i)));
+    }
+
+    const Tensor& beta1_power = ctx->input(3 * n);
+    const Tensor& beta2_power = ctx->input(3 * n + 1);
+    const Tensor& lr = ctx->input(3 * n + 2);
+    const Tensor& beta1 = ctx->input(3 * n + 3);
+    const Tensor& beta2 = ctx->input(3 * n + 4);
+    const Tensor& epsilon = ctx->input(3 * n + 5);
+    OP_REQUIRES(ctx, TensorShapeUtils::IsScalar(beta1_power.shape()),
+                errors::InvalidArgument("beta1_power is not a scalar: ",
+                                        beta1_power.shape().DebugString()));
+    OP_REQUIRES(ctx, TensorShapeUtils::IsScalar(beta2_power.shape()),
+                errors::InvalidArgument("beta2_power is not a scalar: ",
+                                        beta2_power.shape().DebugString()));
+    OP_REQUIRES(ctx, TensorShapeUtils::IsScalar(lr.shape()),
+                errors::InvalidArgument("lr is not a scalar : ",
+                                        lr.shape().DebugString()));
+    OP_REQUIRES(ctx, TensorShapeUtils::IsScalar(beta1.shape()),
+                errors::InvalidArgument("beta1 is not a scalar: ",
+                                        beta1.shape().DebugString()));
+    OP_REQUIRES(ctx, TensorShapeUtils::IsScalar(beta2.shape()),
+                errors::InvalidArgument("beta2 is not a scalar: ",
+                                        beta2.shape().DebugString()));
+    OP_REQUIRES(ctx, TensorShapeUtils::IsScalar(epsilon.shape()),
+                errors::InvalidArgument("epsilon is not a scalar: ",
+                                        epsilon.shape().DebugString()));
+
+    std::vector<functor::AdamTensors<T>> tensors(n);
+    for (int i = 0; i < n; ++i) {
+      Tensor& var = variables[i];
+      Tensor& m = variables[n + i];
+      Tensor& v = variables[2 * n + i];
+      const Tensor& grad = ctx->input(3 * n + 6 + i);
+      OP_REQUIRES(
+          ctx, var.shape().IsSameSize(m.shape()),
+          errors::InvalidArgument("var and m do not have the same shape for ",
+                                  "variable ", i, ": ",
+                                  var.shape().DebugString(), " ",
+                                  m.shape().DebugString()));
+      OP_REQUIRES(
+          ctx, var.shape().IsSameSize(v.shape()),
+          errors::InvalidArgument("var and v do not have the same shape for ",
+                                  "variable ", i, ": ",
+                                  var.shape().DebugString(), " ",
+                                  v.shape().DebugString()));
+      OP_REQUIRES(
+          ctx, var.shape().IsSameSize(grad.shape()),
+          errors::InvalidArgument(
+              "var and grad do not have the same shape for variable ", i, ": ",
+              var.shape().DebugString(), " ", grad.shape().DebugString()));
+      tensors[i] = {var.flat<T>().data(), m.flat<T>().data(),
+                    v.flat<T>().data(), grad.flat<T>().data(),
+                    var.NumElements()};
+    }
+
+    const Device& device = ctx->template eigen_device<Device>();
+    functor::ApplyAdamMultiTensor<Device, T>()(
+        ctx, device, tensors, beta1_power.scalar<T>(), beta2_power.scalar<T>(),
+        lr.scalar<T>(), beta1.scalar<T>(), beta2.scalar<T>(),
+        epsilon.scalar<T>(), use_nesterov_);
+  }
+
+ private:
+  bool use_exclusive_lock_;
+  bool use_nesterov_;
+  int num_variables_;
+};
+
+#define REGISTER_KERNELS(D, T)                                 \
+  REGISTER_KERNEL_BUILDER(Name("ResourceApplyAdamMultiTensor") \
+                              .HostMemory("var")               \
+                              .HostMemory("m")                 \
+                              .HostMemory("v")                 \
+                              .Device(DEVICE_##D)              \
+                              .TypeConstraint<T>("T"),         \
+                          ApplyAdamMultiTensorOp<D##Device, T>);
+#define REGISTER_CPU_KERNELS(T) REGISTER_KERNELS(CPU, T);
+
+TF_CALL_FLOAT_TYPES(REGISTER_CPU_KERNELS);
+TF_CALL_COMPLEX_TYPES(REGISTER_CPU_KERNELS);
+
+#if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+// Forward declarations of the functor specializations for GPU.
+namespace functor {
+#define DECLARE_GPU_SPEC(T)                                                \
+  template <>                                                              \
+  void ApplyAdamMultiTensor<GPUDevice, T>::operator()(                     \
+      OpKernelContext* ctx, const GPUDevice& d,                            \
+      const std::vector<AdamTensors<T>>& tensors,                          \
+      typename TTypes<T>::ConstScalar beta1_power,                         \
+      typename TTypes<T>::ConstScalar beta2_power,                         \
+      typename TTypes<T>::ConstScalar lr,                                  \
+      typename TTypes<T>::ConstScalar beta1,                               \
+      typename TTypes<T>::ConstScalar beta2,                               \
+      typename TTypes<T>::ConstScalar epsilon, bool use_nesterov);         \
+  extern template struct ApplyAdamMultiTensor<GPUDevice, T>;
+DECLARE_GPU_SPEC(Eigen::half);
+DECLARE_GPU_SPEC(float);
+DECLARE_GPU_SPEC(double);
+#undef DECLARE_GPU_SPEC
+}  // namespace functor
+
+REGISTER_KERNELS(GPU, Eigen::half);
+REGISTER_KERNELS(GPU, float);
+REGISTER_KERNELS(GPU, double);
+#endif
+#undef REGISTER_CPU_KERNELS
+#undef REGISTER_KERNELS
+
 template <typename Device, typename T>
 class ApplyAdamWithAmsgradOp : public OpKernel {
  public:
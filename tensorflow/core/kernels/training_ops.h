@@ -16,11 +16,16 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_KERNELS_TRAINING_OPS_H_
 #define TENSORFLOW_CORE_KERNELS_TRAINING_OPS_H_
 
+#include <vector>
+
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/framework/tensor_types.h"
 #include "tensorflow/core/platform/types.h"
 
 namespace tensorflow {
+
+class OpKernelContext;
+
 namespace functor {
 
 // Each training algorithm has a ApplyXYZ functor struct declared in
@@ -193,6 +198,30 @@ struct ApplyAdam {
                   typename TTypes<T>::ConstFlat grad, bool use_nesterov);
 };
 
+// The operands of one of the variables of ApplyAdamMultiTensor.
+template <typename T>
+struct AdamTensors {
+  T* var;
+  T* m;
+  T* v;
+  const T* grad;
+  int64 size;
+};
+
+// Applies the same Adam update to all the variables of `tensors`, in a single
+// parallel loop on CPU and a single kernel launch on GPU.
+template <typename Device, typename T>
+struct ApplyAdamMultiTensor {
+  void operator()(OpKernelContext* ctx, const Device& d,
+                  const std::vector<AdamTensors<T>>& tensors,
+                  typename TTypes<T>::ConstScalar beta1_power,
+                  typename TTypes<T>::ConstScalar beta2_power,
+                  typename TTypes<T>::ConstScalar lr,
+                  typename TTypes<T>::ConstScalar beta1,
+                  typename TTypes<T>::ConstScalar beta2,
+                  typename TTypes<T>::ConstScalar epsilon, bool use_nesterov);
+};
+
 template <typename Device, typename T>
 struct ApplyAdamWithAmsgrad {
   void operator()(const Device& d, typename TTypes<T>::Flat var,
@@ -18,7 +18,9 @@ limitations under the License.
 #define EIGEN_USE_GPU
 
 #include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/kernels/gpu_device_array.h"
 #include "tensorflow/core/kernels/training_ops.h"
+#include "tensorflow/core/lib/math/math_util.h"
 #include "tensorflow/core/util/gpu_kernel_helper.h"
 
 namespace tensorflow {
@@ -27,6 +29,28 @@ typedef Eigen::GpuDevice GPUDevice;
 
 namespace functor {
 
+template <typename T>
+__device__ EIGEN_STRONG_INLINE void ApplyAdamElement(
+    T* var, T* m, T* v, const T* grad, int64 i, const T mul_factor,
+    const T epsilon, const T beta1, const T one_minus_beta1,
+    const T one_minus_beta2, bool use_nesterov) {
+  auto m_i = m[i];
+  auto g_i = grad[i];
+  auto v_i = v[i];
+
+  m_i += one_minus_beta1 * (g_i - m_i);
+  v_i += one_minus_beta2 * (g_i * g_i - v_i);
+  if (use_nesterov) {
+    var[i] -= mul_factor * (m_i * beta1 + one_minus_beta1 * g_i) /
+              (epsilon + sqrt(v_i));
+  } else {
+    var[i] -= mul_factor * m_i / (epsilon + sqrt(v_i));
+  }
+
+  m[i] = m_i;
+  v[i] = v_i;
+}
+
 template <typename T>
 __global__ __launch_bounds__(1024) void ApplyAdamKernel(
     int32 data_dim, T* var, T* m, T* v, const T* const beta1_power_,
@@ -48,21 +72,31 @@ __global__ __launch_bounds__(1024) void ApplyAdamKernel(
 
   for (int32 i = blockIdx.x * blockDim.x + threadIdx.x; i < data_dim;
        i += stripe) {
-    auto m_i = m[i];
-    auto g_i = grad[i];
-    auto v_i = v[i];
+    ApplyAdamElement(var, m, v, grad, i, mul_factor, epsilon, beta1,
+                     one_minus_beta1, one_minus_beta2, use_nesterov);
+  }
+}
 
-    m_i += one_minus_beta1 * (g_i - m_i);
-    v_i += one_minus_beta2 * (g_i * g_i - v_i);
-    if (use_nesterov) {
-      var[i] -= mul_factor * (m_i * beta1 + one_minus_beta1 * g_i) /
-                (epsilon + sqrt(v_i));
-    } else {
-      var[i] -= mul_factor * m_i / (epsilon + sqrt(v_i));
-    }
+// Every block updates one chunk of at most kAdamMultiTensorChunk elements of
+// one of the variables.
+template <typename T>
+__global__ __launch_bounds__(1024) void ApplyAdamMultiTensorKernel(
+    GpuDeviceArrayStruct<AdamTensors<T>> chunks, const T* const beta1_power_,
+    const T* const beta2_power_, const T* const lr_, const T* const beta1_,
+    const T* const beta2_, const T* const epsilon_, bool use_nesterov) {
+  const AdamTensors<T> chunk =
+      GetGpuDeviceArrayOnDevice(&chunks)[blockIdx.x];
+  const T mul_factor = (*lr_) * sqrt(static_cast<T>(1.0) - (*beta2_power_)) /
+                       (static_cast<T>(1.0) - (*beta1_power_));
+  const T epsilon = (*epsilon_);
+  const T beta1 = (*beta1_);
+  const T one_minus_beta1 = static_cast<T>(1.0) - (beta1);
+  const T one_minus_beta2 = static_cast<T>(1.0) - (*beta2_);
 
-    m[i] = m_i;
-    v[i] = v_i;
+  for (int64 i = threadIdx.x; i < chunk.size; i += blockDim.x) {
+    ApplyAdamElement(chunk.var, chunk.m, chunk.v, chunk.grad, i, mul_factor,
+                     epsilon, beta1, one_minus_beta1, one_minus_beta2,
+                     use_nesterov);
   }
 }
 
@@ -118,10 +152,14 @@ struct ApplyGradientDescent<GPUDevice, T> {
 };
 
 #if TENSORFLOW_USE_ROCM
-
 #include "rocm/include/hip/hip_complex.h"
+#endif
 
-// if any kernels involving complex sqrt/rsqrt are compiled with ROCm, build
+// The kernels below update a variable and all its slots in a single pass,
+// reading every operand once, where Eigen evaluates each assignment of the
+// update in a pass of its own.
+//
+// If any kernels involving complex sqrt/rsqrt are compiled with ROCm, build
 // process completes without errors,but the resulting executable ends up
 // unusable (throwing errors "no device code available for function" for
 /// completely unrelated kernels.)
@@ -138,11 +176,11 @@ __device__ T impl_rsqrt(T x) {
 }
 template <>
 __device__ Eigen::half impl_sqrt(Eigen::half x) {
-  return __float2half(sqrt(__half2float(x)));
+  return Eigen::half(sqrt(static_cast<float>(x)));
 }
 template <>
 __device__ Eigen::half impl_rsqrt(Eigen::half x) {
-  return __float2half(rsqrt(__half2float(x)));
+  return Eigen::half(rsqrt(static_cast<float>(x)));
 }
 
 template <class T>
@@ -256,6 +294,87 @@ __global__ __launch_bounds__(1024) void ApplyCenteredRMSPropKernel(
   }
 }
 
+template <typename T>
+__global__ __launch_bounds__(1024) void ApplyMomentumKernel(
+    GpuLaunchConfig cfg, T* var, T* accum, const T* plr, const T* grad,
+    const T* pmomentum, bool use_nesterov) {
+  T lr = plr[0];
+  T momentum = pmomentum[0];
+  GPU_1D_KERNEL_LOOP(i, cfg.virtual_thread_count) {
+    T g = grad[i];
+    T a = accum[i] * momentum + g;
+    accum[i] = a;
+    if (use_nesterov) {
+      var[i] -= g * lr + a * momentum * lr;
+    } else {
+      var[i] -= lr * a;
+    }
+  }
+}
+
+template <typename T>
+__global__ __launch_bounds__(1024) void ApplyKerasMomentumKernel(
+    GpuLaunchConfig cfg, T* var, T* accum, const T* plr, const T* grad,
+    const T* pmomentum, bool use_nesterov) {
+  T lr = plr[0];
+  T momentum = pmomentum[0];
+  GPU_1D_KERNEL_LOOP(i, cfg.virtual_thread_count) {
+    T g = grad[i];
+    T a = accum[i] * momentum - g * lr;
+    accum[i] = a;
+    if (use_nesterov) {
+      var[i] += a * momentum - g * lr;
+    } else {
+      var[i] += a;
+    }
+  }
+}
+
+template <typename T>
+__global__ __launch_bounds__(1024) void ApplyAdamWithAmsgradKernel(
+    GpuLaunchConfig cfg, T* var, T* m, T* v, T* vhat, const T* pbeta1_power,
+    const T* pbeta2_power, const T* plr, const T* pbeta1, const T* pbeta2,
+    const T* peps, const T* grad) {
+  const T one = T(1.0);
+  const T alpha = plr[0] * impl_sqrt(one - pbeta2_power[0]) /
+                  (one - pbeta1_power[0]);
+  const T one_minus_beta1 = one - pbeta1[0];
+  const T one_minus_beta2 = one - pbeta2[0];
+  const T eps = peps[0];
+  GPU_1D_KERNEL_LOOP(i, cfg.virtual_thread_count) {
+    T g = grad[i];
+    T m_i = m[i] + one_minus_beta1 * (g - m[i]);
+    T v_i = v[i] + one_minus_beta2 * (g * g - v[i]);
+    T vhat_i = vhat[i];
+    if (v_i > vhat_i) vhat_i = v_i;
+    m[i] = m_i;
+    v[i] = v_i;
+    vhat[i] = vhat_i;
+    var[i] -= alpha * m_i / (eps + impl_sqrt(vhat_i));
+  }
+}
+
+template <typename T>
+__global__ __launch_bounds__(1024) void ApplyAdaMaxKernel(
+    GpuLaunchConfig cfg, T* var, T* m, T* v, const T* pbeta1_power,
+    const T* plr, const T* pbeta1, const T* pbeta2, const T* peps,
+    const T* grad) {
+  const T alpha = plr[0] / (T(1.0) - pbeta1_power[0]);
+  const T one_minus_beta1 = T(1.0) - pbeta1[0];
+  const T beta2 = pbeta2[0];
+  const T eps = peps[0];
+  GPU_1D_KERNEL_LOOP(i, cfg.virtual_thread_count) {
+    T g = grad[i];
+    T abs_g = g < T(0) ? -g : g;
+    T m_i = m[i] + one_minus_beta1 * (g - m[i]);
+    T v_i = beta2 * v[i];
+    if (abs_g > v_i) v_i = abs_g;
+    m[i] = m_i;
+    v[i] = v_i;
+    var[i] -= alpha * (m_i / (v_i + eps));
+  }
+}
+
 namespace kernel_forward {
 bool to_pointers(bool x) { return x; }
 template <class T>
@@ -280,26 +399,14 @@ void wrap_kernel_call(void (*func)(KernelArgs...), const GPUDevice& d, T var,
 
 using kernel_forward::wrap_kernel_call;
 
-#endif
-
 template <typename T>
 struct ApplyAdagrad<GPUDevice, T> {
   void operator()(const GPUDevice& d, typename TTypes<T>::Flat var,
                   typename TTypes<T>::Flat accum,
                   typename TTypes<T>::ConstScalar lr,
                   typename TTypes<T>::ConstFlat grad, bool update_slots) {
-#if TENSORFLOW_USE_ROCM
     wrap_kernel_call(ApplyAdagradKernel<T>, d, var, accum, lr, grad,
                      update_slots);
-#else
-    if (update_slots) {
-      accum.device(d) += grad.square();
-    }
-    Eigen::array<typename TTypes<T>::Tensor::Index, 1> bcast;
-    bcast[0] = grad.dimension(0);
-    Eigen::Sizes<1> single;
-    var.device(d) -= lr.reshape(single).broadcast(bcast) * grad * accum.rsqrt();
-#endif
   }
 };
 
@@ -310,20 +417,8 @@ struct ApplyAdagradV2<GPUDevice, T> {
                   typename TTypes<T>::ConstScalar lr,
                   typename TTypes<T>::ConstScalar epsilon,
                   typename TTypes<T>::ConstFlat grad, bool update_slots) {
-#if TENSORFLOW_USE_ROCM
     wrap_kernel_call(ApplyAdagradV2Kernel<T>, d, var, accum, lr, epsilon, grad,
                      update_slots);
-#else
-    Eigen::array<typename TTypes<T>::Tensor::Index, 1> bcast;
-    bcast[0] = grad.dimension(0);
-    Eigen::Sizes<1> single;
-    if (update_slots) {
-      accum.device(d) += grad.square();
-    }
-    const auto update =
-        grad / (accum.sqrt() + epsilon.reshape(single).broadcast(bcast));
-    var.device(d) -= lr.reshape(single).broadcast(bcast) * update;
-#endif
   }
 };
 template <typename T>
@@ -335,26 +430,8 @@ struct ApplyAdadelta<GPUDevice, T> {
                   typename TTypes<T>::ConstScalar rho,
                   typename TTypes<T>::ConstScalar epsilon,
                   typename TTypes<T>::ConstFlat grad) {
-#if TENSORFLOW_USE_ROCM
     wrap_kernel_call(ApplyAdadeltaKernel<T>, d, var, accum, accum_update, lr,
                      rho, epsilon, grad);
-#else
-    Eigen::array<typename TTypes<T>::Tensor::Index, 1> bcast;
-    bcast[0] = grad.dimension(0);
-    Eigen::Sizes<1> single;
-
-    accum.device(d) = accum * rho.reshape(single).broadcast(bcast) +
-                      grad.square() * (grad.constant(T(1)) -
-                                       rho.reshape(single).broadcast(bcast));
-    const auto update =
-        (accum_update + epsilon.reshape(single).broadcast(bcast)).sqrt() *
-        (accum + epsilon.reshape(single).broadcast(bcast)).rsqrt() * grad;
-    var.device(d) -= update * lr.reshape(single).broadcast(bcast);
-    accum_update.device(d) =
-        accum_update * rho.reshape(single).broadcast(bcast) +
-        update.square() *
-            (grad.constant(T(1)) - rho.reshape(single).broadcast(bcast));
-#endif
   }
 };
 
@@ -515,17 +592,8 @@ struct ApplyMomentum<GPUDevice, T> {
                   typename TTypes<T>::ConstScalar lr,
                   typename TTypes<T>::ConstFlat grad,
                   typename TTypes<T>::ConstScalar momentum, bool use_nesterov) {
-    Eigen::array<typename TTypes<T>::Tensor::Index, 1> bcast;
-    bcast[0] = grad.dimension(0);
-    Eigen::Sizes<1> single;
-    accum.device(d) = accum * momentum.reshape(single).broadcast(bcast) + grad;
-    if (use_nesterov) {
-      var.device(d) -= grad * lr.reshape(single).broadcast(bcast) +
-                       accum * momentum.reshape(single).broadcast(bcast) *
-                           lr.reshape(single).broadcast(bcast);
-    } else {
-      var.device(d) -= lr.reshape(single).broadcast(bcast) * accum;
-    }
+    wrap_kernel_call(ApplyMomentumKernel<T>, d, var, accum, lr, grad, momentum,
+                     use_nesterov);
   }
 };
 
@@ -536,17 +604,8 @@ struct ApplyKerasMomentum<GPUDevice, T> {
                   typename TTypes<T>::ConstScalar lr,
                   typename TTypes<T>::ConstFlat grad,
                   typename TTypes<T>::ConstScalar momentum, bool use_nesterov) {
-    Eigen::array<typename TTypes<T>::Tensor::Index, 1> bcast;
-    bcast[0] = grad.dimension(0);
-    Eigen::Sizes<1> single;
-    accum.device(d) = (accum * momentum.reshape(single).broadcast(bcast) -
-                       grad * lr.reshape(single).broadcast(bcast));
-    if (use_nesterov) {
-      var.device(d) += (accum * momentum.reshape(single).broadcast(bcast) -
-                        grad * lr.reshape(single).broadcast(bcast));
-    } else {
-      var.device(d) += accum;
-    }
+    wrap_kernel_call(ApplyKerasMomentumKernel<T>, d, var, accum, lr, grad,
+                     momentum, use_nesterov);
   }
 };
 
@@ -598,6 +657,48 @@ struct ApplyAdam<GPUDevice, T> {
   }
 };
 
+template <typename T>
+struct ApplyAdamMultiTensor<GPUDevice, T> {
+  void operator()(OpKernelContext* ctx, const GPUDevice& d,
+                  const std::vector<AdamTensors<T>>& tensors,
+                  typename TTypes<T>::ConstScalar beta1_power,
+                  typename TTypes<T>::ConstScalar beta2_power,
+                  typename TTypes<T>::ConstScalar lr,
+                  typename TTypes<T>::ConstScalar beta1,
+                  typename TTypes<T>::ConstScalar beta2,
+                  typename TTypes<T>::ConstScalar epsilon, bool use_nesterov) {
+    // Large enough for a block to stream through, small enough for a few
+    // large variables to still spread over all the multiprocessors.
+    constexpr int64 kAdamMultiTensorChunk = 64 * 1024;
+    int64 num_chunks = 0;
+    for (const AdamTensors<T>& t : tensors) {
+      num_chunks += MathUtil::CeilOfRatio(t.size, kAdamMultiTensorChunk);
+    }
+    if (num_chunks == 0) return;
+    OP_REQUIRES(ctx, num_chunks <= std::numeric_limits<int32>::max(),
+                errors::InvalidArgument("Too many elements to update: ",
+                                        num_chunks, " chunks"));
+
+    GpuDeviceArrayOnHost<AdamTensors<T>> chunks(ctx, num_chunks);
+    OP_REQUIRES_OK(ctx, chunks.Init());
+    int chunk_index = 0;
+    for (const AdamTensors<T>& t : tensors) {
+      for (int64 begin = 0; begin < t.size; begin += kAdamMultiTensorChunk) {
+        chunks.Set(chunk_index++,
+                   {t.var + begin, t.m + begin, t.v + begin, t.grad + begin,
+                    std::min(kAdamMultiTensorChunk, t.size - begin)});
+      }
+    }
+    OP_REQUIRES_OK(ctx, chunks.Finalize());
+
+    OP_REQUIRES_OK(
+        ctx, GpuLaunchKernel(ApplyAdamMultiTensorKernel<T>, num_chunks, 256, 0,
+                             d.stream(), chunks.data(), beta1_power.data(),
+                             beta2_power.data(), lr.data(), beta1.data(),
+                             beta2.data(), epsilon.data(), use_nesterov));
+  }
+};
+
 template <typename T>
 struct ApplyAdamWithAmsgrad<GPUDevice, T> {
   void operator()(const GPUDevice& d, typename TTypes<T>::Flat var,
@@ -610,24 +711,8 @@ struct ApplyAdamWithAmsgrad<GPUDevice, T> {
                   typename TTypes<T>::ConstScalar beta2,
                   typename TTypes<T>::ConstScalar epsilon,
                   typename TTypes<T>::ConstFlat grad) {
-    Eigen::array<typename TTypes<T>::Tensor::Index, 1> bcast;
-    bcast[0] = grad.dimension(0);
-    Eigen::Sizes<1> single;
-    const auto one = static_cast<T>(1.0);
-    m.device(d) =
-        m + (beta1.constant(one) - beta1).reshape(single).broadcast(bcast) *
-                (grad - m);
-    v.device(d) =
-        v + (beta2.constant(one) - beta2).reshape(single).broadcast(bcast) *
-                (grad.square() - v);
-    vhat.device(d) = vhat.cwiseMax(v);
-
-    var.device(d) -= (lr * (beta2_power.constant(one) - beta2_power).sqrt() /
-                      (beta1_power.constant(one) - beta1_power))
-                         .reshape(single)
-                         .broadcast(bcast) *
-                     m /
-                     (epsilon.reshape(single).broadcast(bcast) + vhat.sqrt());
+    wrap_kernel_call(ApplyAdamWithAmsgradKernel<T>, d, var, m, v, vhat,
+                     beta1_power, beta2_power, lr, beta1, beta2, epsilon, grad);
   }
 };
 
@@ -641,20 +726,8 @@ struct ApplyAdaMax<GPUDevice, T> {
                   typename TTypes<T>::ConstScalar beta2,
                   typename TTypes<T>::ConstScalar epsilon,
                   typename TTypes<T>::ConstFlat grad) {
-    Eigen::array<typename TTypes<T>::Tensor::Index, 1> bcast;
-    bcast[0] = grad.dimension(0);
-    Eigen::Sizes<1> single;
-    const auto one = static_cast<T>(1.0);
-    m.device(d) +=
-        (beta1.constant(one) - beta1).reshape(single).broadcast(bcast) *
-        (grad - m);
-    v.device(d) =
-        (beta2.reshape(single).broadcast(bcast) * v).cwiseMax(grad.abs());
-    var.device(d) -= lr.reshape(single).broadcast(bcast) /
-                     (beta1_power.constant(one) - beta1_power)
-                         .reshape(single)
-                         .broadcast(bcast) *
-                     (m / (v + epsilon.reshape(single).broadcast(bcast)));
+    wrap_kernel_call(ApplyAdaMaxKernel<T>, d, var, m, v, beta1_power, lr, beta1,
+                     beta2, epsilon, grad);
   }
 };
 
@@ -667,23 +740,8 @@ struct ApplyRMSProp<GPUDevice, T> {
                   typename TTypes<T>::ConstScalar momentum,
                   typename TTypes<T>::ConstScalar epsilon,
                   typename TTypes<T>::ConstFlat grad) {
-#if TENSORFLOW_USE_ROCM
     wrap_kernel_call(ApplyRMSPropKernel<T>, d, var, ms, mom, lr, rho, momentum,
                      epsilon, grad);
-#else
-    Eigen::array<typename TTypes<T>::Tensor::Index, 1> bcast;
-    bcast[0] = grad.dimension(0);
-    Eigen::Sizes<1> single;
-    const auto one = static_cast<T>(1.0);
-    ms.device(d) =
-        ms + (rho.constant(one) - rho).reshape(single).broadcast(bcast) *
-                 (grad.square() - ms);
-    mom.device(d) =
-        mom * momentum.reshape(single).broadcast(bcast) +
-        lr.reshape(single).broadcast(bcast) * grad /
-            ((epsilon.reshape(single).broadcast(bcast) + ms).sqrt());
-    var.device(d) -= mom;
-#endif
   }
 };
 
@@ -697,23 +755,8 @@ struct ApplyCenteredRMSProp<GPUDevice, T> {
                   typename TTypes<T>::ConstScalar momentum,
                   typename TTypes<T>::ConstScalar epsilon,
                   typename TTypes<T>::ConstFlat grad) {
-#if TENSORFLOW_USE_ROCM
     wrap_kernel_call(ApplyCenteredRMSPropKernel<T>, d, var, mg, ms, mom, lr,
                      rho, momentum, epsilon, grad);
-#else
-    Eigen::array<typename TTypes<T>::Tensor::Index, 1> bcast;
-    bcast[0] = grad.dimension(0);
-    Eigen::Sizes<1> single;
-    const auto one = static_cast<T>(1.0);
-    const auto one_minus_rho =
-        (rho.constant(one) - rho).reshape(single).broadcast(bcast);
-    ms.device(d) = ms + one_minus_rho * (grad.square() - ms);
-    mg.device(d) = mg + one_minus_rho * (grad - mg);
-    auto denom = (ms - mg.square()) + epsilon.reshape(single).broadcast(bcast);
-    mom.device(d) = mom * momentum.reshape(single).broadcast(bcast) +
-                    lr.reshape(single).broadcast(bcast) * grad / denom.sqrt();
-    var.device(d) -= mom;
-#endif
   }
 };
 
@@ -883,6 +926,10 @@ template struct functor::ApplyAdam<GPUDevice, complex64>;
 template struct functor::ApplyAdam<GPUDevice, complex128>;
 #endif
 
+template struct functor::ApplyAdamMultiTensor<GPUDevice, Eigen::half>;
+template struct functor::ApplyAdamMultiTensor<GPUDevice, float>;
+template struct functor::ApplyAdamMultiTensor<GPUDevice, double>;
+
 template struct functor::ApplyAdamWithAmsgrad<GPUDevice, Eigen::half>;
 template struct functor::ApplyAdamWithAmsgrad<GPUDevice, float>;
 template struct functor::ApplyAdamWithAmsgrad<GPUDevice, double>;
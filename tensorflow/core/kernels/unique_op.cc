@@ -13,9 +13,11 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <algorithm>
 #include <functional>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include "absl/container/flat_hash_map.h"
 #include "tensorflow/core/framework/bounds_check.h"
@@ -26,6 +28,7 @@ limitations under the License.
 #include "tensorflow/core/lib/bfloat16/bfloat16.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 namespace {
@@ -68,6 +71,10 @@ struct UniqueOpHashMap<bfloat16, TIndex> {
   using map_type = std::unordered_map<bfloat16, TIndex>;
 };
 
+// Inputs with fewer elements are uniquified on a single thread, since
+// partitioning them costs more than it saves.
+constexpr int64 kParallelUniqueMinSize = 32 * 1024;
+
 // `UniqueOp` computes the unique elements in the input tensor.
 //
 // * `T` is the element type.
@@ -150,6 +157,13 @@ class UniqueOp : public OpKernel {
       auto Tin = input.flat<T>();
       const int64 N = static_cast<int64>(Tin.size());
 
+      const auto& worker_threads =
+          *context->device()->tensorflow_cpu_worker_threads();
+      if (N >= kParallelUniqueMinSize && worker_threads.num_threads > 1) {
+        ComputeParallel(context, input, axis, idx_vec);
+        return;
+      }
+
       typename UniqueOpHashMap<T, TIndex>::map_type uniq;
       uniq.reserve(2 * N);
       for (Eigen::Index i = 0, j = 0; i < N; ++i) {
@@ -237,6 +251,118 @@ class UniqueOp : public OpKernel {
       }
     }
   }
+
+ private:
+  // Uniquifies the elements of a large vector on all intra-op threads.
+  //
+  // The elements are split into partitions by hash, and every partition is
+  // uniquified by one shard with its own hash map, so no map is ever shared.
+  // Each shard numbers its unique elements locally and marks their first
+  // occurrences. Counting the marks in contiguous blocks of the input then
+  // numbers the unique elements in the order of their first occurrence, as
+  // in the sequential implementation, and a last pass over the partitions
+  // translates the local numbers in `idx` and counts the occurrences.
+  void ComputeParallel(OpKernelContext* context, const Tensor& input,
+                       int64 axis, typename TTypes<TIndex>::Vec idx_vec) {
+    auto Tin = input.flat<T>();
+    const int64 N = static_cast<int64>(Tin.size());
+    const auto& worker_threads =
+        *context->device()->tensorflow_cpu_worker_threads();
+    // A partition has to fit in uint8.
+    const int num_partitions = std::min(worker_threads.num_threads, 256);
+    const int64 block_size = (N + num_partitions - 1) / num_partitions;
+
+    // Multiplicative hashing of the element hash spreads the elements over
+    // the partitions even when `hash<T>` is the identity.
+    std::vector<uint8> partitions(N);
+    Shard(worker_threads.num_threads, worker_threads.workers, N,
+          /*cost_per_unit=*/10, [&](int64 start, int64 limit) {
+            for (int64 i = start; i < limit; ++i) {
+              const uint64 h = static_cast<uint64>(hash<T>{}(Tin(i))) *
+                               0x9E3779B97F4A7C15ULL;
+              partitions[i] = static_cast<uint8>(
+                  ((h >> 32) * static_cast<uint64>(num_partitions)) >> 32);
+            }
+          });
+
+    std::vector<uint8> is_first(N, 0);
+    std::vector<std::vector<TIndex>> global_ids(num_partitions);
+    Shard(worker_threads.num_threads, worker_threads.workers, num_partitions,
+          /*cost_per_unit=*/50 * N, [&](int64 start, int64 limit) {
+            for (int64 p = start; p < limit; ++p) {
+              typename UniqueOpHashMap<T, TIndex>::map_type uniq;
+              uniq.reserve(block_size);
+              TIndex num_unique = 0;
+              for (int64 i = 0; i < N; ++i) {
+                if (partitions[i] != p) continue;
+                auto it = uniq.emplace(Tin(i), num_unique);
+                idx_vec(i) = it.first->second;
+                if (it.second) {
+                  is_first[i] = 1;
+                  ++num_unique;
+                }
+              }
+              global_ids[p].resize(num_unique);
+            }
+          });
+
+    std::vector<int64> block_offsets(num_partitions + 1, 0);
+    Shard(worker_threads.num_threads, worker_threads.workers, num_partitions,
+          /*cost_per_unit=*/block_size, [&](int64 start, int64 limit) {
+            for (int64 b = start; b < limit; ++b) {
+              const int64 first = std::min(N, b * block_size);
+              const int64 last = std::min(N, first + block_size);
+              block_offsets[b + 1] = std::count(
+                  is_first.begin() + first, is_first.begin() + last, 1);
+            }
+          });
+    for (int b = 0; b < num_partitions; ++b) {
+      block_offsets[b + 1] += block_offsets[b];
+    }
+    const int64 uniq_size = block_offsets[num_partitions];
+
+    TensorShape output_shape(input.shape());
+    output_shape.set_dim(axis, uniq_size);
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(0, output_shape, &output));
+    auto Tout = output->flat<T>();
+    Shard(worker_threads.num_threads, worker_threads.workers, num_partitions,
+          /*cost_per_unit=*/block_size, [&](int64 start, int64 limit) {
+            for (int64 b = start; b < limit; ++b) {
+              const int64 last = std::min(N, (b + 1) * block_size);
+              int64 next_id = block_offsets[b];
+              for (int64 i = std::min(N, b * block_size); i < last; ++i) {
+                if (!is_first[i]) continue;
+                global_ids[partitions[i]][idx_vec(i)] = next_id;
+                Tout(next_id++) = Tin(i);
+              }
+            }
+          });
+
+    TIndex* counts = nullptr;
+    if (num_outputs() > 2) {
+      Tensor* count_output = nullptr;
+      OP_REQUIRES_OK(context,
+                     context->allocate_output(2, TensorShape({uniq_size}),
+                                              &count_output));
+      count_output->flat<TIndex>().setZero();
+      counts = count_output->flat<TIndex>().data();
+    }
+    // Every unique element belongs to a single partition, so the shards never
+    // update the same count.
+    Shard(worker_threads.num_threads, worker_threads.workers, num_partitions,
+          /*cost_per_unit=*/10 * N, [&](int64 start, int64 limit) {
+            for (int64 p = start; p < limit; ++p) {
+              const std::vector<TIndex>& ids = global_ids[p];
+              for (int64 i = 0; i < N; ++i) {
+                if (partitions[i] != p) continue;
+                const TIndex id = ids[idx_vec(i)];
+                idx_vec(i) = id;
+                if (counts != nullptr) ++counts[id];
+              }
+            }
+          });
+  }
 };
 
 #define REGISTER_UNIQUE(type)                                    \
@@ -285,10 +411,11 @@ REGISTER_UNIQUE(tstring)
 REGISTER_UNIQUE(bool)
 #undef REGISTER_UNIQUE
 
-// Fake integer GPU kernels so that the use of Unique in optimizers (to
+// Fake int32 GPU kernels so that the use of Unique in optimizers (to
 // de-duplicate sparse gradient indices) does not conflict with gradients being
 // located on a GPU. These kernels run on the CPU, their inputs and outputs
-// residing in host (not GPU) memory.
+// residing in host (not GPU) memory. The int64 GPU kernels are in
+// unique_op_gpu.cu.cc.
 REGISTER_KERNEL_BUILDER(Name("Unique")
                             .Device(DEVICE_GPU)
                             .TypeConstraint<int32>("T")
@@ -305,22 +432,6 @@ REGISTER_KERNEL_BUILDER(Name("Unique")
                             .HostMemory("y")
                             .HostMemory("idx"),
                         UniqueOp<int32, int64>);
-REGISTER_KERNEL_BUILDER(Name("Unique")
-                            .Device(DEVICE_GPU)
-                            .TypeConstraint<int64>("T")
-                            .TypeConstraint<int32>("out_idx")
-                            .HostMemory("x")
-                            .HostMemory("y")
-                            .HostMemory("idx"),
-                        UniqueOp<int64, int32>);
-REGISTER_KERNEL_BUILDER(Name("Unique")
-                            .Device(DEVICE_GPU)
-                            .TypeConstraint<int64>("T")
-                            .TypeConstraint<int64>("out_idx")
-                            .HostMemory("x")
-                            .HostMemory("y")
-                            .HostMemory("idx"),
-                        UniqueOp<int64, int64>);
 
 #ifdef TENSORFLOW_USE_SYCL
 REGISTER_KERNEL_BUILDER(Name("Unique")
@@ -0,0 +1,393 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// The GPU implementation of Unique and UniqueWithCounts sorts instead of
+// hashing. Let N be the size of the input:
+// 1. The pairs (input[i], i) are radix sorted by value. The sort is stable,
+//    so the first element of every run of equal values in sorted_input is
+//    the first occurrence of that value in the input.
+// 2. An inclusive scan over the run heads numbers the runs. The number of
+//    unique elements, the last run number, is copied to the host so that
+//    the outputs can be allocated.
+// 3. The runs are numbered in the order of the first occurrences by radix
+//    sorting the pairs (first occurrence, run), which gives y, the counts
+//    from the run lengths, and idx by scattering the numbers through
+//    sorted_indices.
+
+#if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+
+#define EIGEN_USE_GPU
+
+#include <algorithm>
+#include <limits>
+
+#include "tensorflow/core/common_runtime/gpu/gpu_event_mgr.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/kernels/gpu_prim.h"
+#include "tensorflow/core/lib/core/bits.h"
+#include "tensorflow/core/util/gpu_kernel_helper.h"
+
+namespace tensorflow {
+
+typedef Eigen::GpuDevice GPUDevice;
+
+namespace {
+
+template <typename TIndex>
+__global__ void UniqueRangeInitKernel(TIndex size, TIndex* out) {
+  GPU_1D_KERNEL_LOOP(i, size) { out[i] = i; }
+}
+
+// Sets run_heads[i] to one if sorted_input[i] starts a run of equal values.
+template <typename T, typename TIndex>
+__global__ void MarkRunHeadsKernel(TIndex size, const T* sorted_input,
+                                   TIndex* run_heads) {
+  GPU_1D_KERNEL_LOOP(i, size) {
+    run_heads[i] = i == 0 || ldg(sorted_input + i) != ldg(sorted_input + i - 1);
+  }
+}
+
+// run_ends[i] is the inclusive sum of the run heads, one more than the number
+// of the run of sorted element i. Records the position of the first element
+// of every run in the sorted and in the original input.
+template <typename TIndex>
+__global__ void ExtractRunsKernel(TIndex size, const TIndex* run_ends,
+                                  const TIndex* sorted_indices,
+                                  TIndex* run_starts,
+                                  TIndex* first_occurrences) {
+  GPU_1D_KERNEL_LOOP(i, size) {
+    const TIndex run = ldg(run_ends + i) - 1;
+    if (i == 0 || ldg(run_ends + i - 1) != run + 1) {
+      run_starts[run] = i;
+      first_occurrences[run] = ldg(sorted_indices + i);
+    }
+  }
+}
+
+// Unique element k, in the order of first occurrence, is run runs[k].
+template <typename T, typename TIndex>
+__global__ void GatherUniqueKernel(TIndex size, TIndex num_unique,
+                                   const T* input, const TIndex* runs,
+                                   const TIndex* first_occurrences,
+                                   const TIndex* run_starts, T* output,
+                                   TIndex* unique_ids, TIndex* counts) {
+  GPU_1D_KERNEL_LOOP(k, num_unique) {
+    const TIndex run = ldg(runs + k);
+    unique_ids[run] = k;
+    output[k] = ldg(input + ldg(first_occurrences + k));
+    if (counts != nullptr) {
+      const TIndex end =
+          run + 1 < num_unique ? ldg(run_starts + run + 1) : size;
+      counts[k] = end - ldg(run_starts + run);
+    }
+  }
+}
+
+template <typename TIndex>
+__global__ void ScatterIdsKernel(TIndex size, const TIndex* run_ends,
+                                 const TIndex* sorted_indices,
+                                 const TIndex* unique_ids, TIndex* idx) {
+  GPU_1D_KERNEL_LOOP(i, size) {
+    idx[ldg(sorted_indices + i)] = ldg(unique_ids + ldg(run_ends + i) - 1);
+  }
+}
+
+template <typename Kernel, typename... Args>
+Status LaunchUniqueKernel(const GPUDevice& d, int64 size, Kernel kernel,
+                          Args... args) {
+  GpuLaunchConfig config = GetGpuLaunchConfig(size, d);
+  return GpuLaunchKernel(kernel, config.block_count, config.thread_per_block,
+                         0, d.stream(), args...);
+}
+
+// Runs a gpuprim device algorithm, which is called once with a null temporary
+// storage to query its size and then again to do the work.
+template <typename Algorithm>
+Status RunGpuPrim(OpKernelContext* context, const char* name,
+                  Algorithm algorithm) {
+  size_t temp_storage_bytes = 0;
+  auto err = algorithm(nullptr, temp_storage_bytes);
+  if (err != 0) {
+    return errors::Internal("Failed to query the temporary storage of ", name,
+                            ", status: ", GpuGetErrorString(err));
+  }
+  Tensor temp_storage;
+  TF_RETURN_IF_ERROR(context->allocate_temp(
+      DT_INT8, TensorShape({static_cast<int64>(temp_storage_bytes)}),
+      &temp_storage));
+  err = algorithm(temp_storage.flat<int8>().data(), temp_storage_bytes);
+  if (err != 0) {
+    return errors::Internal("Failed to launch ", name,
+                            ", status: ", GpuGetErrorString(err));
+  }
+  return Status::OK();
+}
+
+}  // namespace
+
+// The memory cost on the GPU is about 6N indices and N elements on top of the
+// input and the outputs, plus the temporary storage of the radix sort.
+template <typename T, typename TIndex>
+class UniqueOpGPU : public AsyncOpKernel {
+ public:
+  explicit UniqueOpGPU(OpKernelConstruction* context)
+      : AsyncOpKernel(context) {}
+
+  void ComputeAsync(OpKernelContext* context, DoneCallback done) override {
+    const Tensor& input = context->input(0);
+    OP_REQUIRES_ASYNC(context, TensorShapeUtils::IsVector(input.shape()),
+                      errors::InvalidArgument("unique expects a 1D vector."),
+                      done);
+    OP_REQUIRES_ASYNC(
+        context, input.NumElements() <= std::numeric_limits<int32>::max(),
+        errors::InvalidArgument(
+            "unique does not support input tensors larger than ",
+            std::numeric_limits<int32>::max(), " elements"),
+        done);
+    const TIndex N = static_cast<TIndex>(input.NumElements());
+
+    Tensor* idx = nullptr;
+    OP_REQUIRES_OK_ASYNC(
+        context, context->allocate_output(1, TensorShape({N}), &idx), done);
+    if (N == 0) {
+      OP_REQUIRES_OK_ASYNC(context, AllocateOutputs(context, 0, nullptr),
+                           done);
+      done();
+      return;
+    }
+
+    const GPUDevice& d = context->eigen_device<GPUDevice>();
+    const auto& stream = d.stream();
+    const DataType index_type = DataTypeToEnum<TIndex>::value;
+    Tensor indices, sorted_input, sorted_indices, run_ends;
+    OP_REQUIRES_OK_ASYNC(
+        context,
+        context->allocate_temp(index_type, TensorShape({N}), &indices), done);
+    OP_REQUIRES_OK_ASYNC(context,
+                         context->allocate_temp(DataTypeToEnum<T>::value,
+                                                TensorShape({N}),
+                                                &sorted_input),
+                         done);
+    OP_REQUIRES_OK_ASYNC(
+        context,
+        context->allocate_temp(index_type, TensorShape({N}), &sorted_indices),
+        done);
+    OP_REQUIRES_OK_ASYNC(
+        context,
+        context->allocate_temp(index_type, TensorShape({N}), &run_ends),
+        done);
+
+    const T* input_ptr = input.flat<T>().data();
+    TIndex* indices_ptr = indices.flat<TIndex>().data();
+    T* sorted_input_ptr = sorted_input.flat<T>().data();
+    TIndex* sorted_indices_ptr = sorted_indices.flat<TIndex>().data();
+    TIndex* run_ends_ptr = run_ends.flat<TIndex>().data();
+
+    OP_REQUIRES_OK_ASYNC(
+        context,
+        LaunchUniqueKernel(d, N, UniqueRangeInitKernel<TIndex>, N,
+                           indices_ptr),
+        done);
+    OP_REQUIRES_OK_ASYNC(
+        context,
+        RunGpuPrim(context, "DeviceRadixSort::SortPairs",
+                   [&](void* temp_storage, size_t& temp_storage_bytes) {
+                     return gpuprim::DeviceRadixSort::SortPairs(
+                         temp_storage, temp_storage_bytes, input_ptr,
+                         sorted_input_ptr, indices_ptr, sorted_indices_ptr,
+                         static_cast<int>(N), 0, sizeof(T) * 8, stream);
+                   }),
+        done);
+    // The run heads go to indices, which is not needed any more.
+    OP_REQUIRES_OK_ASYNC(
+        context,
+        LaunchUniqueKernel(d, N, MarkRunHeadsKernel<T, TIndex>, N,
+                           static_cast<const T*>(sorted_input_ptr),
+                           indices_ptr),
+        done);
+    OP_REQUIRES_OK_ASYNC(
+        context,
+        RunGpuPrim(context, "DeviceScan::InclusiveSum",
+                   [&](void* temp_storage, size_t& temp_storage_bytes) {
+                     return gpuprim::DeviceScan::InclusiveSum(
+                         temp_storage, temp_storage_bytes, indices_ptr,
+                         run_ends_ptr, static_cast<int>(N), stream);
+                   }),
+        done);
+
+    AllocatorAttributes alloc_attr;
+    alloc_attr.set_on_host(true);
+    alloc_attr.set_gpu_compatible(true);
+    Tensor num_unique_host;
+    OP_REQUIRES_OK_ASYNC(
+        context,
+        context->allocate_temp(index_type, TensorShape({}), &num_unique_host,
+                               alloc_attr),
+        done);
+    se::DeviceMemoryBase num_unique_device(run_ends_ptr + (N - 1),
+                                           sizeof(TIndex));
+    se::Stream* se_stream = context->op_device_context()->stream();
+    OP_REQUIRES_ASYNC(
+        context,
+        se_stream
+            ->ThenMemcpy(num_unique_host.flat<TIndex>().data(),
+                         num_unique_device, sizeof(TIndex))
+            .ok(),
+        errors::Internal("Unique: failed to copy the number of unique "
+                         "elements from device"),
+        done);
+
+    // The temporaries are captured by value, so that they live until the
+    // callback has enqueued the rest of the work.
+    auto finish = [this, context, &input, idx, N, num_unique_host,
+                   sorted_indices, run_ends, done]() {
+      auto se_stream = context->op_device_context()->stream();
+      ScopedActivateExecutorContext scoped_activation{se_stream->parent()};
+      const GPUDevice& d = context->eigen_device<GPUDevice>();
+      const auto& stream = d.stream();
+      const TIndex num_unique = num_unique_host.scalar<TIndex>()();
+      const DataType index_type = DataTypeToEnum<TIndex>::value;
+
+      Tensor* output = nullptr;
+      OP_REQUIRES_OK_ASYNC(context,
+                           AllocateOutputs(context, num_unique, &output), done);
+      Tensor* counts = num_outputs() > 2 ? context->mutable_output(2) : nullptr;
+
+      Tensor run_starts, first_occurrences, runs, sorted_first_occurrences;
+      for (Tensor* t : {&run_starts, &first_occurrences, &runs,
+                        &sorted_first_occurrences}) {
+        OP_REQUIRES_OK_ASYNC(
+            context,
+            context->allocate_temp(index_type, TensorShape({num_unique}), t),
+            done);
+      }
+      const TIndex* run_ends_ptr = run_ends.flat<TIndex>().data();
+      const TIndex* sorted_indices_ptr = sorted_indices.flat<TIndex>().data();
+      TIndex* run_starts_ptr = run_starts.flat<TIndex>().data();
+      TIndex* first_occurrences_ptr = first_occurrences.flat<TIndex>().data();
+      TIndex* runs_ptr = runs.flat<TIndex>().data();
+      TIndex* sorted_first_occurrences_ptr =
+          sorted_first_occurrences.flat<TIndex>().data();
+
+      OP_REQUIRES_OK_ASYNC(
+          context,
+          LaunchUniqueKernel(d, N, ExtractRunsKernel<TIndex>, N, run_ends_ptr,
+                             sorted_indices_ptr, run_starts_ptr,
+                             first_occurrences_ptr),
+          done);
+      Tensor run_ids;
+      OP_REQUIRES_OK_ASYNC(context,
+                           context->allocate_temp(index_type,
+                                                  TensorShape({num_unique}),
+                                                  &run_ids),
+                           done);
+      TIndex* run_ids_ptr = run_ids.flat<TIndex>().data();
+      OP_REQUIRES_OK_ASYNC(
+          context,
+          LaunchUniqueKernel(d, num_unique, UniqueRangeInitKernel<TIndex>,
+                             num_unique, run_ids_ptr),
+          done);
+      // First occurrences are below N, so the sort can skip the high bits.
+      const int end_bit = std::max(1, Log2Ceiling64(N));
+      OP_REQUIRES_OK_ASYNC(
+          context,
+          RunGpuPrim(context, "DeviceRadixSort::SortPairs",
+                     [&](void* temp_storage, size_t& temp_storage_bytes) {
+                       return gpuprim::DeviceRadixSort::SortPairs(
+                           temp_storage, temp_storage_bytes,
+                           static_cast<const TIndex*>(first_occurrences_ptr),
+                           sorted_first_occurrences_ptr,
+                           static_cast<const TIndex*>(run_ids_ptr), runs_ptr,
+                           static_cast<int>(num_unique), 0, end_bit, stream);
+                     }),
+          done);
+
+      // The first occurrences are not needed any more, so their buffer holds
+      // the number of every run in the order of first occurrence.
+      TIndex* unique_ids_ptr = first_occurrences_ptr;
+      OP_REQUIRES_OK_ASYNC(
+          context,
+          LaunchUniqueKernel(
+              d, num_unique, GatherUniqueKernel<T, TIndex>, N, num_unique,
+              input.flat<T>().data(),
+              static_cast<const TIndex*>(runs_ptr),
+              static_cast<const TIndex*>(sorted_first_occurrences_ptr),
+              static_cast<const TIndex*>(run_starts_ptr),
+              output->flat<T>().data(), unique_ids_ptr,
+              counts ? counts->flat<TIndex>().data() : nullptr),
+          done);
+      OP_REQUIRES_OK_ASYNC(
+          context,
+          LaunchUniqueKernel(d, N, ScatterIdsKernel<TIndex>, N, run_ends_ptr,
+                             sorted_indices_ptr,
+                             static_cast<const TIndex*>(unique_ids_ptr),
+                             idx->flat<TIndex>().data()),
+          done);
+      done();
+    };
+
+    context->device()->tensorflow_gpu_device_info()->event_mgr->ThenExecute(
+        se_stream, finish);
+  }
+
+ private:
+  // Allocates y and, for UniqueWithCounts, count.
+  Status AllocateOutputs(OpKernelContext* context, TIndex num_unique,
+                         Tensor** output) {
+    Tensor* y = nullptr;
+    TF_RETURN_IF_ERROR(
+        context->allocate_output(0, TensorShape({num_unique}), &y));
+    if (output != nullptr) *output = y;
+    if (num_outputs() > 2) {
+      Tensor* counts = nullptr;
+      TF_RETURN_IF_ERROR(
+          context->allocate_output(2, TensorShape({num_unique}), &counts));
+    }
+    return Status::OK();
+  }
+};
+
+#define REGISTER_UNIQUE_GPU(type)                                \
+  REGISTER_KERNEL_BUILDER(Name("Unique")                         \
+                              .Device(DEVICE_GPU)                \
+                              .TypeConstraint<type>("T")         \
+                              .TypeConstraint<int32>("out_idx"), \
+                          UniqueOpGPU<type, int32>);             \
+  REGISTER_KERNEL_BUILDER(Name("Unique")                         \
+                              .Device(DEVICE_GPU)                \
+                              .TypeConstraint<type>("T")         \
+                              .TypeConstraint<int64>("out_idx"), \
+                          UniqueOpGPU<type, int64>);             \
+  REGISTER_KERNEL_BUILDER(Name("UniqueWithCounts")               \
+                              .Device(DEVICE_GPU)                \
+                              .TypeConstraint<type>("T")         \
+                              .TypeConstraint<int32>("out_idx"), \
+                          UniqueOpGPU<type, int32>);             \
+  REGISTER_KERNEL_BUILDER(Name("UniqueWithCounts")               \
+                              .Device(DEVICE_GPU)                \
+                              .TypeConstraint<type>("T")         \
+                              .TypeConstraint<int64>("out_idx"), \
+                          UniqueOpGPU<type, int64>)
+
+// int32 inputs stay in host memory, see unique_op.cc.
+TF_CALL_int64(REGISTER_UNIQUE_GPU);
+#undef REGISTER_UNIQUE_GPU
+
+}  // namespace tensorflow
+
+#endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
@@ -21,6 +21,7 @@ limitations under the License.
 #include "absl/synchronization/blocking_counter.h"
 #include "absl/types/optional.h"
 #include "tensorflow/core/platform/context.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/test.h"
@@ -370,6 +371,48 @@ TEST(ThreadPool, Parallelism) {
   }
 }
 
+TEST(ThreadPool, Stats) {
+  ThreadPool pool(Env::Default(), "test", 4);
+  constexpr int kNumChildren = 10;
+  absl::BlockingCounter children_done(kNumChildren);
+  absl::BlockingCounter parent_done(1);
+  pool.Schedule([&]() {
+    // The parent blocks its worker, so that the other workers steal all the
+    // children from its queue.
+    for (int i = 0; i < kNumChildren; ++i) {
+      pool.Schedule([&]() { children_done.DecrementCount(); });
+    }
+    children_done.Wait();
+    parent_done.DecrementCount();
+  });
+  parent_done.Wait();
+
+  const ThreadPool::Stats stats = pool.GetStats();
+  EXPECT_EQ(stats.num_scheduled, kNumChildren + 1);
+  EXPECT_EQ(stats.queue_length, 0);
+  EXPECT_EQ(stats.num_stolen, kNumChildren);
+}
+
+TEST(ThreadPool, PartitionSchedulableCPUs) {
+  const std::vector<int> weights = {1, 2, 1};
+  const std::vector<std::vector<int>> partitions =
+      PartitionSchedulableCPUs(weights);
+  ASSERT_EQ(partitions.size(), weights.size());
+  const std::vector<int> cpus = port::SchedulableCPUs();
+  if (cpus.size() < weights.size()) {
+    for (const auto& partition : partitions) EXPECT_TRUE(partition.empty());
+    return;
+  }
+  std::vector<int> all_cpus;
+  for (const auto& partition : partitions) {
+    EXPECT_FALSE(partition.empty());
+    all_cpus.insert(all_cpus.end(), partition.begin(), partition.end());
+  }
+  // The partitions are disjoint and cover all the CPUs.
+  EXPECT_EQ(all_cpus, cpus);
+  EXPECT_GE(partitions[1].size(), partitions[0].size());
+}
+
 static void BM_Sequential(int iters) {
   ThreadPool pool(Env::Default(), "test", kNumThreads);
   // Decrement count sequentially until 0.
@@ -17,6 +17,9 @@ limitations under the License.
 
 #include <limits.h>
 
+#include <algorithm>
+#include <vector>
+
 #include "tensorflow/core/lib/core/coding.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/hash/crc32c.h"
@@ -245,5 +248,132 @@ SequentialRecordReader::SequentialRecordReader(
     RandomAccessFile* file, const RecordReaderOptions& options)
     : underlying_(file, options), offset_(0) {}
 
+/* static */ constexpr int64 PrefetchingRecordReader::kMaxBatchBytes;
+/* static */ constexpr size_t PrefetchingRecordReader::kMaxBatchRecords;
+
+PrefetchingRecordReader::PrefetchingRecordReader(
+    Env* env, RandomAccessFile* file, const RecordReaderOptions& options,
+    int64 readahead_bytes)
+    : env_(env),
+      readahead_bytes_(readahead_bytes),
+      underlying_(file, options) {}
+
+PrefetchingRecordReader::~PrefetchingRecordReader() { StopPrefetching(); }
+
+Status PrefetchingRecordReader::ReadRecord(tstring* record) {
+  if (readahead_bytes_ <= 0) {
+    return underlying_.ReadRecord(&offset_, record);
+  }
+  if (!thread_) {
+    StartPrefetching();
+  }
+  if (ready_.empty()) {
+    // Takes all the records read so far at once, so that the consumer
+    // synchronizes with the background thread once per batch rather than
+    // once per record.
+    mutex_lock l(mu_);
+    while (records_.empty() && !done_) {
+      cond_var_.wait(l);
+    }
+    if (records_.empty()) {
+      return status_;
+    }
+    ready_.swap(records_);
+    buffered_bytes_ = 0;
+    cond_var_.notify_all();
+  }
+  Entry& entry = ready_.front();
+  *record = std::move(entry.record);
+  offset_ = entry.next_offset;
+  ready_.pop_front();
+  return Status::OK();
+}
+
+Status PrefetchingRecordReader::SeekOffset(uint64 offset) {
+  if (offset < offset_) {
+    return errors::InvalidArgument(
+        "Trying to seek offset: ", offset,
+        " which is less than the current offset: ", offset_);
+  }
+  if (offset != offset_) {
+    // Records read ahead of `offset` are dropped; reading restarts from the
+    // new offset on the next call to `ReadRecord`.
+    StopPrefetching();
+    offset_ = offset;
+  }
+  return Status::OK();
+}
+
+void PrefetchingRecordReader::StartPrefetching() {
+  {
+    mutex_lock l(mu_);
+    records_.clear();
+    buffered_bytes_ = 0;
+    status_ = Status::OK();
+    done_ = false;
+    cancelled_ = false;
+  }
+  ready_.clear();
+  const uint64 offset = offset_;
+  thread_.reset(env_->StartThread({}, "tf_record_prefetch",
+                                  [this, offset]() { PrefetchLoop(offset); }));
+}
+
+void PrefetchingRecordReader::StopPrefetching() {
+  if (!thread_) {
+    return;
+  }
+  {
+    mutex_lock l(mu_);
+    cancelled_ = true;
+    cond_var_.notify_all();
+  }
+  // Joins the thread.
+  thread_.reset();
+}
+
+void PrefetchingRecordReader::PrefetchLoop(uint64 offset) {
+  const int64 batch_bytes = std::min(readahead_bytes_, kMaxBatchBytes);
+  std::vector<Entry> batch;
+  while (true) {
+    {
+      mutex_lock l(mu_);
+      while (!cancelled_ && !records_.empty() &&
+             buffered_bytes_ >= readahead_bytes_) {
+        cond_var_.wait(l);
+      }
+      if (cancelled_) {
+        return;
+      }
+    }
+    // Reads a batch of records without holding `mu_`.
+    Status s;
+    int64 bytes = 0;
+    while (bytes < batch_bytes && batch.size() < kMaxBatchRecords) {
+      tstring record;
+      s = underlying_.ReadRecord(&offset, &record);
+      if (!s.ok()) {
+        break;
+      }
+      bytes += record.size();
+      batch.push_back({std::move(record), offset});
+    }
+    mutex_lock l(mu_);
+    for (Entry& entry : batch) {
+      records_.push_back(std::move(entry));
+    }
+    batch.clear();
+    buffered_bytes_ += bytes;
+    if (!s.ok()) {
+      status_ = s;
+      done_ = true;
+    }
+    cond_var_.notify_all();
+    if (done_) {
+      return;
+    }
+  }
+}
+
 }  // namespace io
 }  // namespace tensorflow
@@ -16,6 +16,9 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_LIB_IO_RECORD_READER_H_
 #define TENSORFLOW_CORE_LIB_IO_RECORD_READER_H_
 
+#include <deque>
+#include <memory>
+
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/stringpiece.h"
 #include "tensorflow/core/lib/io/inputstream_interface.h"
@@ -25,7 +28,10 @@ limitations under the License.
 #include "tensorflow/core/lib/io/zlib_compression_options.h"
 #include "tensorflow/core/lib/io/zlib_inputstream.h"
 #endif  // IS_SLIM_BUILD
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
 #include "tensorflow/core/platform/types.h"
 
 namespace tensorflow {
@@ -174,6 +180,74 @@ class SequentialRecordReader {
   uint64 offset_ = 0;
 };
 
+// Like SequentialRecordReader, but reads records ahead of the consumer on a
+// background thread, which also verifies their checksums and decompresses
+// them. The thread keeps up to `readahead_bytes` of records ready, or at
+// least one record. If `readahead_bytes` is 0, records are read on the calling
+// thread.
+//
+// Records are handed over in batches of up to kMaxBatchBytes or
+// kMaxBatchRecords, so that small records do not pay for a lock handoff
+// each. The consumer takes all the ready records at once, so up to twice
+// `readahead_bytes` may be buffered.
+//
+// Note: this class is not thread safe; external synchronization required.
+class PrefetchingRecordReader {
+ public:
+  static constexpr int64 kMaxBatchBytes = 256 << 10;
+  static constexpr size_t kMaxBatchRecords = 1024;
+
+  // "*file" must remain live while this Reader is in use.
+  PrefetchingRecordReader(Env* env, RandomAccessFile* file,
+                          const RecordReaderOptions& options,
+                          int64 readahead_bytes);
+
+  // Stops the background thread.
+  ~PrefetchingRecordReader();
+
+  // Read the next record in the file into *record. Returns OK on success,
+  // OUT_OF_RANGE for end of file, or something else for an error.
+  Status ReadRecord(tstring* record);
+
+  // Return the offset of the record following the last one returned.
+  uint64 TellOffset() const { return offset_; }
+
+  // Seek to this offset within the file and set this offset as the current
+  // offset. Trying to seek backward will throw error.
+  Status SeekOffset(uint64 offset);
+
+ private:
+  struct Entry {
+    tstring record;
+    // The offset of the record following `record`.
+    uint64 next_offset;
+  };
+
+  void StartPrefetching();
+  void StopPrefetching();
+  void PrefetchLoop(uint64 offset);
+
+  Env* const env_;
+  const int64 readahead_bytes_;
+  RecordReader underlying_;
+  uint64 offset_ = 0;
+  // Records taken from `records_` that the consumer has not read yet.
+  std::deque<Entry> ready_;
+
+  mutex mu_;
+  condition_variable cond_var_;
+  std::deque<Entry> records_ TF_GUARDED_BY(mu_);
+  int64 buffered_bytes_ TF_GUARDED_BY(mu_) = 0;
+  // The status that ended prefetching, e.g. OUT_OF_RANGE at the end of the
+  // file. Returned once `records_` is drained.
+  Status status_ TF_GUARDED_BY(mu_);
+  bool done_ TF_GUARDED_BY(mu_) = false;
+  bool cancelled_ TF_GUARDED_BY(mu_) = false;
+  std::unique_ptr<Thread> thread_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(PrefetchingRecordReader);
+};
+
 }  // namespace io
 }  // namespace tensorflow
 
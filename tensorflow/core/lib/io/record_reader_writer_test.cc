@@ -305,6 +305,83 @@ TEST(RecordReaderWriterTest, TestZlib) {
   }
 }
 
+TEST(RecordReaderWriterTest, TestPrefetching) {
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/record_reader_writer_prefetch_test";
+  std::vector<string> records;
+  std::vector<uint64> offsets;
+  {
+    std::unique_ptr<WritableFile> file;
+    TF_CHECK_OK(env->NewWritableFile(fname, &file));
+    io::RecordWriter writer(file.get(), io::RecordWriterOptions());
+    for (int i = 0; i < 100; ++i) {
+      records.push_back(string(i, 'a' + i % 26));
+      TF_EXPECT_OK(writer.WriteRecord(records.back()));
+      // Each record has 16 bytes of header/footer.
+      offsets.push_back((offsets.empty() ? 0 : offsets.back()) + 16 + i);
+    }
+    TF_CHECK_OK(writer.Flush());
+  }
+
+  std::unique_ptr<RandomAccessFile> read_file;
+  TF_CHECK_OK(env->NewRandomAccessFile(fname, &read_file));
+  for (int64 readahead_bytes : {0, 1, 64, 1 << 20}) {
+    io::PrefetchingRecordReader reader(env, read_file.get(),
+                                       io::RecordReaderOptions(),
+                                       readahead_bytes);
+    tstring record;
+    for (int i = 0; i < 50; ++i) {
+      TF_ASSERT_OK(reader.ReadRecord(&record));
+      EXPECT_EQ(records[i], record);
+      EXPECT_EQ(offsets[i], reader.TellOffset());
+    }
+    // Seeking to the current offset keeps the records read ahead.
+    TF_ASSERT_OK(reader.SeekOffset(offsets[49]));
+    TF_ASSERT_OK(reader.ReadRecord(&record));
+    EXPECT_EQ(records[50], record);
+    // Seeking forward drops them.
+    TF_ASSERT_OK(reader.SeekOffset(offsets[79]));
+    for (int i = 80; i < 100; ++i) {
+      TF_ASSERT_OK(reader.ReadRecord(&record));
+      EXPECT_EQ(records[i], record);
+    }
+    EXPECT_TRUE(errors::IsOutOfRange(reader.ReadRecord(&record)));
+    EXPECT_TRUE(errors::IsOutOfRange(reader.ReadRecord(&record)));
+    EXPECT_TRUE(errors::IsInvalidArgument(reader.SeekOffset(offsets[0])));
+  }
+}
+
+TEST(RecordReaderWriterTest, TestPrefetchingBatches) {
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/record_reader_writer_batch_test";
+  // More small records than fit in one batch, compressed.
+  const int kNumRecords = 3 * io::PrefetchingRecordReader::kMaxBatchRecords;
+  {
+    std::unique_ptr<WritableFile> file;
+    TF_CHECK_OK(env->NewWritableFile(fname, &file));
+    io::RecordWriterOptions options;
+    options.compression_type = io::RecordWriterOptions::ZLIB_COMPRESSION;
+    io::RecordWriter writer(file.get(), options);
+    for (int i = 0; i < kNumRecords; ++i) {
+      TF_EXPECT_OK(writer.WriteRecord(strings::StrCat(i)));
+    }
+    TF_CHECK_OK(writer.Close());
+  }
+
+  std::unique_ptr<RandomAccessFile> read_file;
+  TF_CHECK_OK(env->NewRandomAccessFile(fname, &read_file));
+  io::RecordReaderOptions options;
+  options.compression_type = io::RecordReaderOptions::ZLIB_COMPRESSION;
+  io::PrefetchingRecordReader reader(env, read_file.get(), options,
+                                     /*readahead_bytes=*/1 << 20);
+  tstring record;
+  for (int i = 0; i < kNumRecords; ++i) {
+    TF_ASSERT_OK(reader.ReadRecord(&record));
+    EXPECT_EQ(strings::StrCat(i), record);
+  }
+  EXPECT_TRUE(errors::IsOutOfRange(reader.ReadRecord(&record)));
+}
+
 TEST(RecordReaderWriterTest, TestUseAfterClose) {
   Env* env = Env::Default();
   string fname = testing::TmpDir() + "/record_reader_writer_flush_close_test";
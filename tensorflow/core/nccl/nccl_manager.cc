@@ -14,6 +14,7 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/nccl/nccl_manager.h"
 
+#include <algorithm>
 #include <utility>
 
 #if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
@@ -26,6 +27,7 @@ limitations under the License.
 #include "tensorflow/core/profiler/lib/annotated_traceme.h"
 #include "tensorflow/core/profiler/lib/connected_traceme.h"
 #include "tensorflow/core/profiler/lib/traceme.h"
+#include "tensorflow/core/util/env_var.h"
 #if GOOGLE_CUDA
 #include "tensorflow/stream_executor/cuda/cuda_activation.h"
 #elif TENSORFLOW_USE_ROCM
@@ -119,6 +121,22 @@ struct NcclManager::Communicator {
 
 namespace {
 
+int CommunicatorsPerGroupFromEnv() {
+#if TENSORFLOW_USE_ROCM
+  // On ROCm all communication streams of a device borrow the same stream, so
+  // more communicators would not overlap.
+  return 1;
+#else
+  int64 value;
+  Status s = ReadInt64FromEnvVar("TF_NCCL_COMMUNICATORS_PER_GROUP", 1, &value);
+  if (!s.ok()) {
+    LOG(ERROR) << "Invalid TF_NCCL_COMMUNICATORS_PER_GROUP: " << s;
+    return 1;
+  }
+  return static_cast<int>(value);
+#endif
+}
+
 static constexpr DataTypeSet kValidDataTypes =
     ToSet(DT_HALF) | ToSet(DT_FLOAT) | ToSet(DT_DOUBLE) | ToSet(DT_INT32) |
     ToSet(DT_INT64);
@@ -223,8 +241,11 @@ struct NcclManager::Collective : public core::RefCounted {
   Status status;
 };
 
-NcclManager::NcclManager() {
-  VLOG(2) << "New NcclManager " << this;
+NcclManager::NcclManager() : NcclManager(CommunicatorsPerGroupFromEnv()) {}
+NcclManager::NcclManager(int communicators_per_group)
+    : communicators_per_group_(std::max(communicators_per_group, 1)) {
+  VLOG(2) << "New NcclManager " << this << " with "
+          << communicators_per_group_ << " communicators per group";
 #if TENSORFLOW_USE_ROCM
   ++instance_count;
 #endif
@@ -234,6 +255,12 @@ NcclManager::~NcclManager() {
 #if TENSORFLOW_USE_ROCM
   --instance_count;
 #endif
+  {
+    mutex_lock l(mu_);
+    while (num_preparing_groups_ > 0) {
+      preparing_done_.wait(l);
+    }
+  }
   for (auto& it : device_to_comm_streams_) {
     for (NcclStream* nccl_stream : it.second) {
       {
@@ -277,18 +304,28 @@ Status NcclManager::GetCommunicator(NcclManager::Collective* collective,
               }
               return a->global_rank < b->global_rank;
             });
+  std::vector<CommunicatorDevice> devices;
+  devices.reserve(collective->num_local_devices);
+  for (const auto& p : collective->participants) {
+#if TENSORFLOW_USE_ROCM
+    devices.push_back({p->executor, p->gpu_device_id, p->context,
+                       p->global_rank});
+#else
+    devices.push_back({p->executor, p->gpu_device_id, p->global_rank});
+#endif
+  }
 
   mutex_lock l(mu_);
 
   if (collective->communicator_key.empty()) {
     // For single-node collectives, when the caller does not specify a
-    // `communicator_key`, we identify a communicator uniquely by the set of
-    // devices participating in the collective.  For example, if a collective is
-    // for GPUs 0, 1, and 2 then this will scan to find the communicator for
-    // GPUs 0, 1, and 2.
+    // `communicator_key`, we identify a pool of communicators uniquely by the
+    // set of devices participating in the collective.  For example, if a
+    // collective is for GPUs 0, 1, and 2 then this will scan to find the
+    // communicators for GPUs 0, 1, and 2.
     //
     // Note that each executor identifies a context on one device, so this is
-    // the same as getting the communicator connecting the devices in the
+    // the same as getting the communicators connecting the devices in the
     // collective. A device can be in different communicators as well - for
     // example, a communicator for GPUs 0 and 1 is separate from one for GPUs 0,
     // 1, and 2.
@@ -297,79 +334,101 @@ Status NcclManager::GetCommunicator(NcclManager::Collective* collective,
     // be needed, communicators_ is not garbage collected currently.
     //
     // Launching of kernels must be serialized so that, given collectives A and
-    // B, and an order of them (e.g., A before B), then for each comm_stream
-    // involved, the kernel for A is launched before the kernel for B. This is
-    // guaranteed currently be a global mutex controlling additions of the
-    // kernels to per-stream launch queues.  The launch queues are processed by
-    // LoopKernelLaunches.
-    for (auto& comm : communicators_) {
-      if (comm->num_devices == collective->num_global_devices) {
-        int i;
-        for (i = 0; i < collective->num_local_devices; ++i) {
-          if (comm->members[i].nccl_stream->executor !=
-              collective->participants[i]->executor) {
-            break;
-          }
-        }
-        if (i == collective->num_local_devices) {
-          *communicator = comm.get();
-          return Status::OK();
-        }
-      }
-    }
-  } else {
+    // B on the same communicator, and an order of them (e.g., A before B),
+    // then for each comm_stream involved, the kernel for A is launched before
+    // the kernel for B. This is guaranteed currently be a global mutex
+    // controlling additions of the kernels to per-stream launch queues.  The
+    // launch queues are processed by LoopKernelLaunches.  Collectives on
+    // different communicators of a pool use different streams, so they may
+    // run concurrently.
+    std::vector<Communicator*> pool;
+    TF_RETURN_IF_ERROR(GetCommunicatorPool(devices, &pool));
+    *communicator = pool[next_pool_index_++ % pool.size()];
+    return Status::OK();
+  }
+
 #if NCCL_MAJOR < 2
-    return errors::Internal(
-        "Cannot use multi-node NCCL collectives with NCCL 1.x");
+  return errors::Internal(
+      "Cannot use multi-node NCCL collectives with NCCL 1.x");
 #endif
-    if (collective->communicator_key.size() != NCCL_UNIQUE_ID_BYTES) {
-      return errors::Internal("Expected communicator_key of size ",
-                              NCCL_UNIQUE_ID_BYTES, " but found size ",
-                              collective->communicator_key.size());
+  if (collective->communicator_key.size() != NCCL_UNIQUE_ID_BYTES) {
+    return errors::Internal("Expected communicator_key of size ",
+                            NCCL_UNIQUE_ID_BYTES, " but found size ",
+                            collective->communicator_key.size());
+  }
+  // This is an instance of multi-node collective.  We have previously
+  // created a NCCL unique id and shared with all workers.  Now we find the
+  // `Communicator` corresponding to this id.  A unique id can only be used to
+  // initialize a single communicator, so these are not pooled.
+  for (auto& comm : communicators_) {
+    if (comm->key == collective->communicator_key) {
+      *communicator = comm.get();
+      return Status::OK();
     }
-    // This is an instance of multi-node collective.  We have previously
-    // created a NCCL unique id and shared with all workers.  Now we find the
-    // `Communicator` corresponding to this id.
-    for (auto& comm : communicators_) {
-      if (comm->key == collective->communicator_key) {
-        *communicator = comm.get();
-        return Status::OK();
+  }
+  return CreateCommunicator(devices, collective->num_global_devices,
+                            collective->communicator_key, /*stream_index=*/0,
+                            communicator);
+}
+
+Status NcclManager::GetCommunicatorPool(
+    const std::vector<CommunicatorDevice>& devices,
+    std::vector<Communicator*>* pool) {
+  const int num_devices = devices.size();
+  for (auto& comm : communicators_) {
+    if (!comm->key.empty() || comm->num_devices != num_devices) continue;
+    int i;
+    for (i = 0; i < num_devices; ++i) {
+      if (comm->members[i].nccl_stream->executor != devices[i].executor) {
+        break;
       }
     }
+    if (i == num_devices) pool->push_back(comm.get());
   }
+  while (static_cast<int>(pool->size()) < communicators_per_group_) {
+    Communicator* comm;
+    TF_RETURN_IF_ERROR(CreateCommunicator(
+        devices, num_devices, /*communicator_key=*/"",
+        /*stream_index=*/pool->size(), &comm));
+    pool->push_back(comm);
+  }
+  return Status::OK();
+}
 
+Status NcclManager::CreateCommunicator(
+    const std::vector<CommunicatorDevice>& devices, int num_global_devices,
+    const string& communicator_key, int stream_index,
+    Communicator** communicator) {
   auto* env = Env::Default();
-  std::set<NcclStream*> used_streams;
+  const int num_local_devices = devices.size();
+  // Number of times each executor was seen so far, so that a device appearing
+  // several times uses a different stream for each occurrence.
+  absl::flat_hash_map<se::StreamExecutor*, int> occurrences;
 
   // Create and initialize a new communicator.
   // Note that this is done under the lock; performance is not expected to
   // matter as this happens a very small number of times.
-  std::vector<CommunicatorMember> members(collective->num_local_devices);
-  std::vector<int> devices(collective->num_local_devices);
-  for (int i = 0; i < collective->num_local_devices; ++i) {
-    auto* executor = collective->participants[i]->executor;
-
-    // Find a communication stream to use for the device.
+  std::vector<CommunicatorMember> members(num_local_devices);
+  std::vector<int> device_ids(num_local_devices);
+  for (int i = 0; i < num_local_devices; ++i) {
+    auto* executor = devices[i].executor;
+
+    // Find the communication stream to use for the device, creating it and
+    // those before it if needed.
+    const int slot =
+        stream_index + occurrences[executor]++ * communicators_per_group_;
     auto& streams = device_to_comm_streams_[executor];
-    NcclStream* nccl_stream = nullptr;
-    for (const auto& s : streams) {
-      if (used_streams.insert(s).second) {
-        nccl_stream = s;
-        break;
-      }
-    }
-    if (nccl_stream == nullptr) {
-      nccl_stream = new NcclStream();
+    while (static_cast<int>(streams.size()) <= slot) {
+      NcclStream* nccl_stream = new NcclStream();
       nccl_stream->executor = executor;
 #if TENSORFLOW_USE_ROCM
-      nccl_stream->stream = collective->participants[i]->context->nccl_stream();
+      nccl_stream->stream = devices[i].context->nccl_stream();
 #else
       nccl_stream->stream.reset(new se::Stream(executor));
       nccl_stream->stream->Init();
 #endif
 
       streams.emplace_back(nccl_stream);
-      used_streams.insert(nccl_stream);
 
       nccl_stream->Ref();
       env->SchedClosure([this, nccl_stream]() {
@@ -378,31 +437,30 @@ Status NcclManager::GetCommunicator(NcclManager::Collective* collective,
       });
     }
 
-    members[i].nccl_stream = nccl_stream;
-    devices[i] = collective->participants[i]->gpu_device_id;
+    members[i].nccl_stream = streams[slot];
+    device_ids[i] = devices[i].gpu_device_id;
   }
 
-  std::vector<ncclComm_t> nccl_comms(collective->num_local_devices);
+  std::vector<ncclComm_t> nccl_comms(num_local_devices);
 #if NCCL_MAJOR >= 2
   // For NCCL 2, we always initialize using ncclCommInitRank guarded by NCCL
   // group primitives.
   ncclUniqueId nccl_id;
-  if (collective->single_node) {
+  if (num_local_devices == num_global_devices) {
     NCCL_RETURN_IF_ERROR(ncclGetUniqueId(&nccl_id));
   } else {
-    StringToNcclUniqueId(collective->communicator_key, &nccl_id);
+    StringToNcclUniqueId(communicator_key, &nccl_id);
   }
   int saved_device = 0;
   CUDA_RETURN_IF_ERROR(cudaGetDevice(&saved_device));
   NCCL_RETURN_IF_ERROR(ncclGroupStart());
-  for (int i = 0; i < collective->num_local_devices; ++i) {
-    // Set rank to `participant->global_rank` if provided, else `i`.
-    const int rank = collective->participants[i]->global_rank >= 0
-                         ? collective->participants[i]->global_rank
-                         : i;
-    CUDA_RETURN_IF_ERROR(cudaSetDevice(devices[i]));
+  for (int i = 0; i < num_local_devices; ++i) {
+    // Set rank to `global_rank` if provided, else `i`.
+    const int rank =
+        devices[i].global_rank >= 0 ? devices[i].global_rank : i;
+    CUDA_RETURN_IF_ERROR(cudaSetDevice(device_ids[i]));
     NCCL_RETURN_IF_ERROR(ncclCommInitRank(
-        nccl_comms.data() + i, collective->num_global_devices, nccl_id, rank));
+        nccl_comms.data() + i, num_global_devices, nccl_id, rank));
   }
   NCCL_RETURN_IF_ERROR(ncclGroupEnd());
   CUDA_RETURN_IF_ERROR(cudaSetDevice(saved_device));
@@ -411,19 +469,65 @@ Status NcclManager::GetCommunicator(NcclManager::Collective* collective,
   // used ncclCommInitRank with NCCL 1 as well, but then we would have to
   // issue each init call from a different thread
   // (https://docs.nvidia.com/deeplearning/sdk/nccl-developer-guide/docs/nccl1.html).
-  NCCL_RETURN_IF_ERROR(ncclCommInitAll(
-      nccl_comms.data(), collective->num_local_devices, devices.data()));
+  NCCL_RETURN_IF_ERROR(ncclCommInitAll(nccl_comms.data(), num_local_devices,
+                                       device_ids.data()));
 #endif
 
-  for (int i = 0; i < collective->num_local_devices; ++i) {
+  for (int i = 0; i < num_local_devices; ++i) {
     members[i].nccl_comm = nccl_comms[i];
   }
   communicators_.emplace_back(
-      new Communicator(std::move(members), collective->communicator_key));
+      new Communicator(std::move(members), communicator_key));
   *communicator = communicators_.back().get();
   return Status::OK();
 }
 
+void NcclManager::PrepareCommunicators(const string& group_key,
+                                       int num_devices,
+                                       const DeviceBase::GpuDeviceInfo* info) {
+  if (info == nullptr || info->stream == nullptr || num_devices <= 1) return;
+#if TENSORFLOW_USE_ROCM
+  CommunicatorDevice device{info->stream->parent(), info->gpu_id,
+                            static_cast<GPUDeviceContext*>(
+                                info->default_context),
+                            /*global_rank=*/-1};
+#else
+  CommunicatorDevice device{info->stream->parent(), info->gpu_id,
+                            /*global_rank=*/-1};
+#endif
+  std::vector<CommunicatorDevice> devices;
+  {
+    mutex_lock l(mu_);
+    std::vector<CommunicatorDevice>& pending = pending_groups_[group_key];
+    for (const CommunicatorDevice& d : pending) {
+      if (d.executor == device.executor) return;
+    }
+    pending.push_back(device);
+    if (static_cast<int>(pending.size()) < num_devices) return;
+    devices = std::move(pending);
+    pending_groups_.erase(group_key);
+    ++num_preparing_groups_;
+  }
+  // Same order as the participants in GetCommunicator().
+  std::sort(devices.begin(), devices.end(),
+            [](const CommunicatorDevice& a, const CommunicatorDevice& b) {
+              if (a.gpu_device_id != b.gpu_device_id) {
+                return a.gpu_device_id < b.gpu_device_id;
+              }
+              return a.executor < b.executor;
+            });
+  Env::Default()->SchedClosure([this, group_key, devices]() {
+    mutex_lock l(mu_);
+    std::vector<Communicator*> pool;
+    Status s = GetCommunicatorPool(devices, &pool);
+    if (!s.ok()) {
+      LOG(WARNING) << "Failed to create NCCL communicators for " << group_key
+                   << " ahead of use: " << s;
+    }
+    if (--num_preparing_groups_ == 0) preparing_done_.notify_all();
+  });
+}
+
 void NcclManager::AddToAllReduce(std::unique_ptr<Participant> participant,
                                  const Context& context,
                                  ncclRedOp_t reduction_op) {
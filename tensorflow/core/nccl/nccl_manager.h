@@ -45,12 +45,19 @@ namespace tensorflow {
 // NCCL manager is used to make the asynchronous communicator calls and to
 // manage the per-device streams used for communication.
 //
+// Single-node collectives among the same devices share a pool of
+// communicators, each of which runs on its own stream on every device, so
+// that independent collectives can overlap.  The pool has one communicator
+// unless TF_NCCL_COMMUNICATORS_PER_GROUP says otherwise.
+//
 // See nccl_ops.cc for example usage, including description of memory
 // management and stream synchronization.
 class NcclManager {
  public:
   typedef std::function<void(Status)> DoneCallback;
   NcclManager();
+  // Uses pools of `communicators_per_group` communicators.
+  explicit NcclManager(int communicators_per_group);
   ~NcclManager();
 
   static NcclManager* instance();
@@ -194,6 +201,17 @@ class NcclManager {
   void AddReduceRecv(std::unique_ptr<Participant> participant,
                      const Context& context, ncclRedOp_t reduction_op);
 
+  // Registers the device of `info` as one of the `num_devices` devices of the
+  // single-node collectives named `group_key`, e.g. by the kernels of those
+  // collectives when they are constructed.  Once all the devices are known,
+  // the communicators connecting them are created in the background, so that
+  // the first collective does not wait for NCCL initialization.
+  //
+  // Registering the same device twice for a group has no effect.  Failures
+  // are only logged; the communicators are then created on first use.
+  void PrepareCommunicators(const string& group_key, int num_devices,
+                            const DeviceBase::GpuDeviceInfo* info);
+
   // Signals that the `Collective` corresponding to `key` is ready to launch
   // across all nodes participating in this multi-node collective operation.
   //
@@ -214,6 +232,18 @@ class NcclManager {
   struct CommunicatorMember;
   struct NcclStream;
 
+  // A local device of a communicator.
+  struct CommunicatorDevice {
+    se::StreamExecutor* executor;
+    int gpu_device_id;
+#if TENSORFLOW_USE_ROCM
+    GPUDeviceContext* context;
+#endif
+    // Rank across all devices and all nodes, or -1 for single-node
+    // communicators.
+    int global_rank;
+  };
+
   // Gets the `Communicator` object that will be used to enqueue NCCL kernels
   // for `collective`, and returns it via `communicator`.
   //
@@ -222,6 +252,21 @@ class NcclManager {
   // the corresponding NCCL/CUDA error string.
   Status GetCommunicator(Collective* collective, Communicator** communicator);
 
+  // Returns via `pool` the communicators of the single-node collectives among
+  // `devices`, creating those that do not exist yet.
+  Status GetCommunicatorPool(const std::vector<CommunicatorDevice>& devices,
+                             std::vector<Communicator*>* pool)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Creates a communicator among the local `devices` and returns it via
+  // `communicator`.  Its NCCL kernels are launched on the `stream_index`-th
+  // communication stream of each device.
+  Status CreateCommunicator(const std::vector<CommunicatorDevice>& devices,
+                            int num_global_devices,
+                            const string& communicator_key, int stream_index,
+                            Communicator** communicator)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
   // Adds a participant device to the local `Collective` instance corresponding
   // to `collective_key`.  Launches the `Collective` if it is ready, which it
   // checks by calling `CheckReady()`.  Also performs consistency and sanity
@@ -244,8 +289,26 @@ class NcclManager {
   void RunCollective(Collective* collective);
   void LoopKernelLaunches(NcclStream* stream);
 
+  // Number of communicators per pool.
+  const int communicators_per_group_;
+
   mutex mu_;
 
+  // Index of the pool member to use for the next single-node collective.
+  // Collectives are enqueued on the streams of each communicator in the
+  // order in which they take an index.
+  uint64 next_pool_index_ TF_GUARDED_BY(mu_) = 0;
+
+  // Devices registered by PrepareCommunicators() for groups that are not
+  // complete yet.
+  absl::flat_hash_map<string, std::vector<CommunicatorDevice>>
+      pending_groups_ TF_GUARDED_BY(mu_);
+
+  // Number of groups whose communicators are being created in the
+  // background.
+  int num_preparing_groups_ TF_GUARDED_BY(mu_) = 0;
+  condition_variable preparing_done_;
+
   // Maps key to collectives currently being assembled or run.
   absl::flat_hash_map<string, Collective*> collectives_ TF_GUARDED_BY(mu_);
 
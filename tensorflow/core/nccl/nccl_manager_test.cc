@@ -566,6 +566,49 @@ TYPED_TEST(NcclManagerTest, MultipleCallers) {
   }
 }
 
+// Runs independent all-reduces, launched in different orders on each device,
+// over a pool of communicators created ahead of their first use.
+TYPED_TEST(NcclManagerTest, CommunicatorPool) {
+  const int num_ranks = this->NumGPUs();
+  const int num_collectives = 8;
+  NcclManager nccl_manager(/*communicators_per_group=*/3);
+  for (int rank = 0; rank < num_ranks; ++rank) {
+    auto* device = this->GetDevice(num_ranks, /*node=*/0, rank);
+    nccl_manager.PrepareCommunicators("pool", num_ranks,
+                                      device->tensorflow_gpu_device_info());
+  }
+
+  std::vector<std::unique_ptr<typename TestFixture::TestCase>> test_cases;
+  for (int i = 0; i < num_collectives; ++i) {
+    test_cases.emplace_back(this->MakeReductionTestCase(
+        /*num_nodes=*/1, num_ranks, ncclSum, TensorShape({64, i + 1}),
+        1.0f * i));
+  }
+  for (int rank = 0; rank < num_ranks; ++rank) {
+    auto* device = this->GetDevice(num_ranks, /*node=*/0, rank);
+    auto* info = device->tensorflow_gpu_device_info();
+    auto* stream = device->tensorflow_gpu_device_info()->stream;
+    for (int j = 0; j < num_collectives; ++j) {
+      const int i = (rank % 2 == 0) ? j : num_collectives - 1 - j;
+      typename TestFixture::TestCase* test_case = test_cases[i].get();
+      auto participant = absl::make_unique<NcclManager::Participant>(
+          device->executor(), stream, info, &test_case->ins[rank],
+          &test_case->outs[rank], /*global_rank=*/-1,
+          this->CreateDoneCallback(test_case));
+      nccl_manager.AddToAllReduce(
+          std::move(participant),
+          {strings::StrCat("pool_allreduce", i),
+           /*num_local_devices=*/num_ranks,
+           /*num_global_devices=*/num_ranks, /*communicator_key=*/"",
+           /*source_rank=*/-1},
+          ncclSum);
+    }
+  }
+  for (int i = 0; i < num_collectives; ++i) {
+    this->VerifyResults(test_cases[i].get());
+  }
+}
+
 // Test basic all-gather.
 TYPED_TEST(NcclManagerTest, BasicAllGather) {
   const int num_ranks = this->NumGPUs();
@@ -32,6 +32,7 @@ REGISTER_OP("CollectiveReduce")
     .Attr("wait_for: list(int) = []")
     .Attr("communication_hint: string = 'auto'")
     .Attr("timeout_seconds: float = 0")
+    .Attr("compression: {'none', 'fp16', 'bf16'} = 'none'")
     .SetIsStateful()
     .SetShapeFn(shape_inference::UnchangedShape);
 
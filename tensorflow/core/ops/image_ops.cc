@@ -511,6 +511,33 @@ REGISTER_OP("DecodeAndCropJpeg")
       return Status::OK();
     });
 
+// --------------------------------------------------------------------------
+REGISTER_OP("DecodeJpegBatch")
+    .Input("contents: string")
+    .Attr("channels: int = 3")
+    .Attr("ratio: int = 1")
+    .Attr("fancy_upscaling: bool = true")
+    .Attr("try_recover_truncated: bool = false")
+    .Attr("acceptable_fraction: float = 1.0")
+    .Attr("dct_method: string = ''")
+    .Output("image: uint8")
+    .Output("image_size: int32")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle contents;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 1, &contents));
+      int32 channels;
+      TF_RETURN_IF_ERROR(c->GetAttr("channels", &channels));
+      if (channels != 1 && channels != 3) {
+        return errors::InvalidArgument("channels must be 1 or 3, got ",
+                                       channels);
+      }
+      DimensionHandle batch = c->Dim(contents, 0);
+      c->set_output(0, c->MakeShape({batch, InferenceContext::kUnknownDim,
+                                     InferenceContext::kUnknownDim, channels}));
+      c->set_output(1, c->MakeShape({batch, 2}));
+      return Status::OK();
+    });
+
 // --------------------------------------------------------------------------
 REGISTER_OP("EncodeJpeg")
     .Input("image: uint8")
@@ -938,6 +965,50 @@ REGISTER_OP("CropAndResizeGradBoxes")
 
 // --------------------------------------------------------------------------
 
+REGISTER_OP("FusedImageAugmentation")
+    .Input("images: T")
+    .Input("boxes: float")
+    .Input("size: int32")
+    .Input("flip: bool")
+    .Input("brightness_delta: float")
+    .Input("saturation_factor: float")
+    .Input("contrast_factor: float")
+    .Input("mean: float")
+    .Input("stddev: float")
+    .Output("output: float")
+    .Attr("T: {uint8, half, float}")
+    .Attr("method: {'bilinear', 'nearest'} = 'bilinear'")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle input;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 4, &input));
+      DimensionHandle batch = c->Dim(input, 0);
+      DimensionHandle channels = c->Dim(input, 3);
+
+      ShapeHandle boxes;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 2, &boxes));
+      DimensionHandle unused;
+      TF_RETURN_IF_ERROR(c->WithValue(c->Dim(boxes, 1), 4, &unused));
+      TF_RETURN_IF_ERROR(c->Merge(batch, c->Dim(boxes, 0), &batch));
+
+      // flip, brightness_delta, saturation_factor and contrast_factor have one
+      // value per image, mean and stddev one value per channel.
+      for (int i = 3; i < 7; ++i) {
+        ShapeHandle per_image;
+        TF_RETURN_IF_ERROR(c->WithRank(c->input(i), 1, &per_image));
+        TF_RETURN_IF_ERROR(c->Merge(batch, c->Dim(per_image, 0), &batch));
+      }
+      for (int i = 7; i < 9; ++i) {
+        ShapeHandle per_channel;
+        TF_RETURN_IF_ERROR(c->WithRank(c->input(i), 1, &per_channel));
+        TF_RETURN_IF_ERROR(
+            c->Merge(channels, c->Dim(per_channel, 0), &channels));
+      }
+      return SetOutputToSizedImage(c, batch, 2 /* size_input_idx */,
+                                   channels);
+    });
+
+// --------------------------------------------------------------------------
+
 REGISTER_OP("NonMaxSuppression")
     .Input("boxes: float")
     .Input("scores: float")
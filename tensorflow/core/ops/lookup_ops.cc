@@ -439,6 +439,34 @@ REGISTER_OP("MutableDenseHashTableV2")
       return MutableHashTableShape(c, /*key=*/c->input(0), /*value=*/value_s);
     });
 
+REGISTER_OP("MemmappedTableV2")
+    .Output("table_handle: resource")
+    .Attr("container: string = ''")
+    .Attr("shared_name: string = ''")
+    .Attr("use_node_name_sharing: bool = false")
+    .Attr("key_dtype: {int64, string}")
+    .Attr("value_dtype: {int32, int64, float, double, string}")
+    .Attr("filename: string")
+    .SetIsStateful()
+    .SetShapeFn(ScalarOutput);
+
+REGISTER_OP("WriteMemmappedTable")
+    .Input("filename: string")
+    .Input("keys: Tkey")
+    .Input("values: Tval")
+    .Attr("Tkey: {int64, string}")
+    .Attr("Tval: {int32, int64, float, double, string}")
+    .SetIsStateful()
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle handle;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 0, &handle));
+
+      ShapeHandle keys;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 1, &keys));
+      TF_RETURN_IF_ERROR(c->Merge(keys, c->input(2), &keys));
+      return Status::OK();
+    });
+
 REGISTER_OP("InitializeTable")
     .Input("table_handle: Ref(string)")
     .Input("keys: Tkey")
@@ -308,6 +308,34 @@ REGISTER_OP("_UnaryOpsComposition")
 expected to create these operators.
 )doc");
 
+REGISTER_OP("_MultiTensorCwise")
+    .Input("x: N * T")
+    .Input("bias: num_bias * T")
+    .Output("y: N * T")
+    .Attr("N: int >= 1")
+    .Attr("num_bias: int >= 0")
+    .Attr("T: {float, half, double}")
+    .Attr("op: string")
+    .SetShapeFn([](InferenceContext* c) {
+      int n;
+      TF_RETURN_IF_ERROR(c->GetAttr("N", &n));
+      for (int i = 0; i < n; ++i) {
+        c->set_output(i, c->input(i));
+      }
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Applies the element-wise op `op` to each of the `N` tensors in `x`.
+
+`op` is one of "Abs", "Exp", "Neg", "Relu", "Relu6", "Rsqrt", "Sigmoid",
+"Sqrt", "Square" or "Tanh", in which case `num_bias` must be 0, or "BiasAdd",
+in which case `num_bias` must be `N` and `bias[i]` is added to the last
+dimension of `x[i]`.
+
+*NOTE*: Do not invoke this operator directly in Python. Graph rewrite pass is
+expected to create these operators.
+)doc");
+
 #undef UNARY
 #undef UNARY_REAL
 #undef UNARY_COMPLEX
@@ -1404,6 +1432,47 @@ REGISTER_OP("SparseSegmentSqrtNGrad")
     .Attr("Tsegmentids: {int32, int64} = DT_INT32")
     .SetShapeFn(SparseSegmentReductionGradShapeFn);
 
+REGISTER_OP("FusedEmbeddingLookupSparse")
+    .Input("params: T")
+    .Input("ids: Tidx")
+    .Input("segment_ids: Tsegmentids")
+    .Input("weights: T")
+    .Output("output: T")
+    .Attr("combiner: {'sum', 'mean', 'sqrtn'} = 'mean'")
+    .Attr("T: {float, double}")
+    .Attr("Tidx: {int32, int64} = DT_INT32")
+    .Attr("Tsegmentids: {int32, int64} = DT_INT32")
+    .SetShapeFn([](InferenceContext* c) {
+      TF_RETURN_IF_ERROR(SparseSegmentReductionShapeFn(c));
+      // weights are either empty or have one entry per id.
+      ShapeHandle unused;
+      return c->WithRank(c->input(3), 1, &unused);
+    });
+
+REGISTER_OP("FusedEmbeddingLookupSparseGrad")
+    .Input("grad: T")
+    .Input("segment_ids: Tsegmentids")
+    .Input("weights: T")
+    .Output("output: T")
+    .Attr("combiner: {'sum', 'mean', 'sqrtn'} = 'mean'")
+    .Attr("T: {float, double}")
+    .Attr("Tsegmentids: {int32, int64} = DT_INT32")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle grad_shape;
+      TF_RETURN_IF_ERROR(c->WithRankAtLeast(c->input(0), 1, &grad_shape));
+      ShapeHandle segment_ids_shape;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 1, &segment_ids_shape));
+      ShapeHandle unused;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(2), 1, &unused));
+
+      ShapeHandle subshape;
+      TF_RETURN_IF_ERROR(c->Subshape(grad_shape, 1, &subshape));
+      ShapeHandle out;
+      TF_RETURN_IF_ERROR(c->Concatenate(segment_ids_shape, subshape, &out));
+      c->set_output(0, out);
+      return Status::OK();
+    });
+
 REGISTER_OP("All")
     .Input("input: bool")
     .Input("reduction_indices: Tidx")
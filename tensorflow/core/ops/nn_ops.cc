@@ -1196,6 +1196,58 @@ REGISTER_OP("Softmax")
 
 // --------------------------------------------------------------------------
 
+REGISTER_OP("_FusedAttention")
+    .Input("query: T")
+    .Input("key: T")
+    .Input("value: T")
+    .Output("output: T")
+    .Attr("T: {float}")
+    .Attr("scale: float = 1.0")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle query;
+      ShapeHandle key;
+      ShapeHandle value;
+      TF_RETURN_IF_ERROR(c->WithRankAtLeast(c->input(0), 3, &query));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), c->Rank(query), &key));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(2), c->Rank(query), &value));
+
+      // All inputs have the same batch dimensions.
+      ShapeHandle batch;
+      ShapeHandle key_batch;
+      ShapeHandle value_batch;
+      TF_RETURN_IF_ERROR(c->Subshape(query, 0, -2, &batch));
+      TF_RETURN_IF_ERROR(c->Subshape(key, 0, -2, &key_batch));
+      TF_RETURN_IF_ERROR(c->Subshape(value, 0, -2, &value_batch));
+      TF_RETURN_IF_ERROR(c->Merge(batch, key_batch, &batch));
+      TF_RETURN_IF_ERROR(c->Merge(batch, value_batch, &batch));
+
+      // Query and key share the depth, key and value the sequence length.
+      DimensionHandle unused;
+      TF_RETURN_IF_ERROR(
+          c->Merge(c->Dim(query, -1), c->Dim(key, -1), &unused));
+      TF_RETURN_IF_ERROR(
+          c->Merge(c->Dim(key, -2), c->Dim(value, -2), &unused));
+
+      ShapeHandle out;
+      TF_RETURN_IF_ERROR(c->Concatenate(
+          batch, c->Matrix(c->Dim(query, -2), c->Dim(value, -1)), &out));
+      c->set_output(0, out);
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Computes softmax(query * key^T * scale) * value without materializing the
+attention scores.
+
+`query` is [..., query_length, depth], `key` is [..., key_length, depth] and
+`value` is [..., key_length, value_depth], with the same batch dimensions. The
+softmax is taken over the key dimension of the scores.
+
+*NOTE*: Do not invoke this operator directly in Python. Grappler is
+expected to create these operators.
+)doc");
+
+// --------------------------------------------------------------------------
+
 REGISTER_OP("LogSoftmax")
     .Input("logits: T")
     .Output("logsoftmax: T")
@@ -1358,6 +1410,42 @@ REGISTER_OP("TopKV2")
     .Attr("T: realnumbertype")
     .SetShapeFn(TopKShapeFn);
 
+// This is the same as `TopKV2` of `MatMul(a, b)`, without the full product.
+REGISTER_OP("MatMulTopK")
+    .Input("a: T")
+    .Input("b: T")
+    .Input("k: int32")
+    .Output("values: T")
+    .Output("indices: int32")
+    .Attr("transpose_b: bool = false")
+    .Attr("sorted: bool = true")
+    .Attr("T: {float, double}")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle a;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 2, &a));
+      ShapeHandle b;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 2, &b));
+      bool transpose_b;
+      TF_RETURN_IF_ERROR(c->GetAttr("transpose_b", &transpose_b));
+      DimensionHandle unused;
+      TF_RETURN_IF_ERROR(
+          c->Merge(c->Dim(a, 1), c->Dim(b, transpose_b ? 1 : 0), &unused));
+
+      DimensionHandle k_dim;
+      TF_RETURN_IF_ERROR(c->MakeDimForScalarInput(2, &k_dim));
+      DimensionHandle num_items = c->Dim(b, transpose_b ? 0 : 1);
+      if (c->ValueKnown(num_items) && c->ValueKnown(k_dim) &&
+          c->Value(num_items) < c->Value(k_dim)) {
+        return errors::InvalidArgument("b must have at least k = ",
+                                       c->Value(k_dim), " items but has ",
+                                       c->Value(num_items));
+      }
+      ShapeHandle output = c->Matrix(c->Dim(a, 0), k_dim);
+      c->set_output(0, output);
+      c->set_output(1, output);
+      return Status::OK();
+    });
+
 // --------------------------------------------------------------------------
 
 REGISTER_OP("NthElement")
@@ -3159,8 +3247,8 @@ REGISTER_OP("QuantizedMatMulWithBias")
       TF_RETURN_IF_ERROR(c->WithRank(c->input(2), 1, &unused));
       TF_RETURN_IF_ERROR(c->WithRank(c->input(3), 0, &unused));
       TF_RETURN_IF_ERROR(c->WithRank(c->input(4), 0, &unused));
-      TF_RETURN_IF_ERROR(c->WithRank(c->input(5), 0, &unused));
-      TF_RETURN_IF_ERROR(c->WithRank(c->input(6), 0, &unused));
+      TF_RETURN_IF_ERROR(c->WithRankAtMost(c->input(5), 1, &unused));
+      TF_RETURN_IF_ERROR(c->WithRankAtMost(c->input(6), 1, &unused));
       c->set_output(1, c->Scalar());
       c->set_output(2, c->Scalar());
       return Status::OK();
@@ -3189,8 +3277,8 @@ REGISTER_OP("QuantizedMatMulWithBiasAndRelu")
       TF_RETURN_IF_ERROR(c->WithRank(c->input(2), 1, &unused));
       TF_RETURN_IF_ERROR(c->WithRank(c->input(3), 0, &unused));
       TF_RETURN_IF_ERROR(c->WithRank(c->input(4), 0, &unused));
-      TF_RETURN_IF_ERROR(c->WithRank(c->input(5), 0, &unused));
-      TF_RETURN_IF_ERROR(c->WithRank(c->input(6), 0, &unused));
+      TF_RETURN_IF_ERROR(c->WithRankAtMost(c->input(5), 1, &unused));
+      TF_RETURN_IF_ERROR(c->WithRankAtMost(c->input(6), 1, &unused));
       c->set_output(1, c->Scalar());
       c->set_output(2, c->Scalar());
       return Status::OK();
@@ -3222,8 +3310,8 @@ REGISTER_OP("QuantizedMatMulWithBiasAndReluAndRequantize")
       TF_RETURN_IF_ERROR(c->WithRank(c->input(2), 1, &unused));
       TF_RETURN_IF_ERROR(c->WithRank(c->input(3), 0, &unused));
       TF_RETURN_IF_ERROR(c->WithRank(c->input(4), 0, &unused));
-      TF_RETURN_IF_ERROR(c->WithRank(c->input(5), 0, &unused));
-      TF_RETURN_IF_ERROR(c->WithRank(c->input(6), 0, &unused));
+      TF_RETURN_IF_ERROR(c->WithRankAtMost(c->input(5), 1, &unused));
+      TF_RETURN_IF_ERROR(c->WithRankAtMost(c->input(6), 1, &unused));
       TF_RETURN_IF_ERROR(c->WithRank(c->input(7), 0, &unused));
       TF_RETURN_IF_ERROR(c->WithRank(c->input(8), 0, &unused));
       c->set_output(1, c->Scalar());
@@ -3255,8 +3343,8 @@ REGISTER_OP("QuantizedMatMulWithBiasAndDequantize")
       TF_RETURN_IF_ERROR(c->WithRank(c->input(2), 1, &unused));
       TF_RETURN_IF_ERROR(c->WithRank(c->input(3), 0, &unused));
       TF_RETURN_IF_ERROR(c->WithRank(c->input(4), 0, &unused));
-      TF_RETURN_IF_ERROR(c->WithRank(c->input(5), 0, &unused));
-      TF_RETURN_IF_ERROR(c->WithRank(c->input(6), 0, &unused));
+      TF_RETURN_IF_ERROR(c->WithRankAtMost(c->input(5), 1, &unused));
+      TF_RETURN_IF_ERROR(c->WithRankAtMost(c->input(6), 1, &unused));
       TF_RETURN_IF_ERROR(c->WithRank(c->input(7), 0, &unused));
       TF_RETURN_IF_ERROR(c->WithRank(c->input(8), 0, &unused));
 
@@ -3289,8 +3377,8 @@ REGISTER_OP("QuantizedMatMulWithBiasAndRequantize")
       TF_RETURN_IF_ERROR(c->WithRank(c->input(2), 1, &unused));
       TF_RETURN_IF_ERROR(c->WithRank(c->input(3), 0, &unused));
       TF_RETURN_IF_ERROR(c->WithRank(c->input(4), 0, &unused));
-      TF_RETURN_IF_ERROR(c->WithRank(c->input(5), 0, &unused));
-      TF_RETURN_IF_ERROR(c->WithRank(c->input(6), 0, &unused));
+      TF_RETURN_IF_ERROR(c->WithRankAtMost(c->input(5), 1, &unused));
+      TF_RETURN_IF_ERROR(c->WithRankAtMost(c->input(6), 1, &unused));
       TF_RETURN_IF_ERROR(c->WithRank(c->input(7), 0, &unused));
       TF_RETURN_IF_ERROR(c->WithRank(c->input(8), 0, &unused));
       c->set_output(1, c->Scalar());
@@ -23,6 +23,9 @@ using shape_inference::InferenceContext;
 using shape_inference::ShapeHandle;
 
 Status RaggedRangeShapeFn(InferenceContext* c);
+Status RaggedSegmentSoftmaxShapeFn(InferenceContext* c);
+Status RaggedSegmentReduceShapeFn(InferenceContext* c);
+Status RaggedBatchMatMulShapeFn(InferenceContext* c);
 
 //==============================================================================
 // Registered Ops
@@ -38,6 +41,32 @@ REGISTER_OP("RaggedRange")
     .Attr("Tsplits: {int32, int64} = DT_INT64")
     .SetShapeFn(RaggedRangeShapeFn);
 
+REGISTER_OP("RaggedSegmentSoftmax")
+    .Input("rt_row_splits: Tsplits")
+    .Input("rt_dense_values: T")
+    .Output("softmax_values: T")
+    .Attr("T: {bfloat16, half, float, double}")
+    .Attr("Tsplits: {int32, int64} = DT_INT64")
+    .SetShapeFn(RaggedSegmentSoftmaxShapeFn);
+
+REGISTER_OP("RaggedSegmentReduce")
+    .Input("rt_row_splits: Tsplits")
+    .Input("rt_dense_values: T")
+    .Output("output: T")
+    .Attr("reduction: {'sum', 'mean', 'max', 'min', 'prod'} = 'sum'")
+    .Attr("T: {float, double, int32, int64}")
+    .Attr("Tsplits: {int32, int64} = DT_INT64")
+    .SetShapeFn(RaggedSegmentReduceShapeFn);
+
+REGISTER_OP("RaggedBatchMatMul")
+    .Input("rt_row_splits: Tsplits")
+    .Input("rt_dense_values: T")
+    .Input("b: T")
+    .Output("output_dense_values: T")
+    .Attr("T: {float, double}")
+    .Attr("Tsplits: {int32, int64} = DT_INT64")
+    .SetShapeFn(RaggedBatchMatMulShapeFn);
+
 //==============================================================================
 // Shape Functions
 //==============================================================================
@@ -78,4 +107,48 @@ Status RaggedRangeShapeFn(InferenceContext* c) {
   return Status::OK();
 }
 
+Status RaggedSegmentSoftmaxShapeFn(InferenceContext* c) {
+  ShapeHandle splits;
+  ShapeHandle values;
+  TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 1, &splits));
+  TF_RETURN_IF_ERROR(c->WithRankAtLeast(c->input(1), 1, &values));
+  c->set_output(0, values);
+  return Status::OK();
+}
+
+Status RaggedSegmentReduceShapeFn(InferenceContext* c) {
+  ShapeHandle splits;
+  ShapeHandle values;
+  TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 1, &splits));
+  TF_RETURN_IF_ERROR(c->WithRankAtLeast(c->input(1), 1, &values));
+
+  // The output has one row per ragged row, one fewer than the splits.
+  DimensionHandle nrows;
+  TF_RETURN_IF_ERROR(c->Subtract(c->Dim(splits, 0), 1, &nrows));
+  ShapeHandle inner;
+  TF_RETURN_IF_ERROR(c->Subshape(values, 1, &inner));
+  ShapeHandle output;
+  TF_RETURN_IF_ERROR(c->Concatenate(c->Vector(nrows), inner, &output));
+  c->set_output(0, output);
+  return Status::OK();
+}
+
+Status RaggedBatchMatMulShapeFn(InferenceContext* c) {
+  ShapeHandle splits;
+  ShapeHandle values;
+  ShapeHandle b;
+  TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 1, &splits));
+  TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 2, &values));
+  TF_RETURN_IF_ERROR(c->WithRank(c->input(2), 3, &b));
+
+  // Row i of the ragged tensor is multiplied by b[i].
+  DimensionHandle nrows;
+  TF_RETURN_IF_ERROR(c->Subtract(c->Dim(splits, 0), 1, &nrows));
+  TF_RETURN_IF_ERROR(c->Merge(nrows, c->Dim(b, 0), &nrows));
+  DimensionHandle inner;
+  TF_RETURN_IF_ERROR(c->Merge(c->Dim(values, 1), c->Dim(b, 1), &inner));
+  c->set_output(0, c->Matrix(c->Dim(values, 0), c->Dim(b, 2)));
+  return Status::OK();
+}
+
 }  // namespace tensorflow
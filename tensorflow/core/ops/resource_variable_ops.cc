@@ -21,6 +21,7 @@
 #include "tensorflow/core/framework/shape_inference.h"
 #include "tensorflow/core/lib/core/errors.h"
 
+using ::tensorflow::shape_inference::DimensionHandle;
 using ::tensorflow::shape_inference::InferenceContext;
 using ::tensorflow::shape_inference::ShapeAndType;
 using ::tensorflow::shape_inference::ShapeHandle;
@@ -393,6 +394,151 @@ REGISTER_OP("ResourceScatterUpdate")
     .Attr("Tindices: {int32, int64}")
     .SetShapeFn(ResourceScatterUpdateShape);
 
+REGISTER_OP("EmbeddingVariable")
+    .Output("resource: resource")
+    .Attr("container: string = ''")
+    .Attr("shared_name: string = ''")
+    .Attr("dtype: {float, double}")
+    .Attr("dim: int >= 1")
+    .Attr("num_slots: int >= 0 = 0")
+    .Attr("min_frequency: int >= 0 = 0")
+    .Attr("max_rows: int >= 0 = 0")
+    .Attr("eviction_policy: {'lru', 'lfu'} = 'lru'")
+    .SetIsStateful()
+    .SetShapeFn(shape_inference::ScalarShape);
+
+REGISTER_OP("EmbeddingVariableLookup")
+    .Input("resource: resource")
+    .Input("ids: Tindices")
+    .Input("default_value: dtype")
+    .Output("values: dtype")
+    .Attr("dtype: {float, double}")
+    .Attr("Tindices: {int32, int64}")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle unused;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 0, &unused));
+      ShapeHandle default_value;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(2), 1, &default_value));
+      ShapeHandle out;
+      TF_RETURN_IF_ERROR(c->Concatenate(c->input(1), default_value, &out));
+      c->set_output(0, out);
+      return Status::OK();
+    });
+
+REGISTER_OP("EmbeddingVariableExport")
+    .Input("resource: resource")
+    .Output("ids: int64")
+    .Output("values: dtype")
+    .Output("slots: dtype")
+    .Output("frequencies: int64")
+    .Attr("dtype: {float, double}")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle unused;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 0, &unused));
+      c->set_output(0, c->Vector(InferenceContext::kUnknownDim));
+      c->set_output(1, c->UnknownShapeOfRank(2));
+      c->set_output(2, c->UnknownShapeOfRank(3));
+      c->set_output(3, c->Vector(InferenceContext::kUnknownDim));
+      return Status::OK();
+    });
+
+REGISTER_OP("EmbeddingVariableImport")
+    .Input("resource: resource")
+    .Input("ids: int64")
+    .Input("values: dtype")
+    .Input("slots: dtype")
+    .Input("frequencies: int64")
+    .Attr("dtype: {float, double}")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle unused;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 0, &unused));
+      ShapeHandle ids;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 1, &ids));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(2), 2, &unused));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(3), 3, &unused));
+      TF_RETURN_IF_ERROR(c->Merge(ids, c->input(4), &unused));
+      return Status::OK();
+    });
+
+REGISTER_OP("EmbeddingCache")
+    .Output("resource: resource")
+    .Attr("container: string = ''")
+    .Attr("shared_name: string = ''")
+    .Attr("dtype: {float, double}")
+    .Attr("dim: int >= 1")
+    .Attr("num_sets: int >= 1")
+    .Attr("ways: int >= 1 = 8")
+    .SetIsStateful()
+    .SetShapeFn(shape_inference::ScalarShape);
+
+REGISTER_OP("EmbeddingCacheLookup")
+    .Input("resource: resource")
+    .Input("ids: Tindices")
+    .Input("default_value: dtype")
+    .Output("values: dtype")
+    .Attr("dtype: {float, double}")
+    .Attr("Tindices: {int32, int64}")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle unused;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 0, &unused));
+      ShapeHandle default_value;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(2), 1, &default_value));
+      ShapeHandle out;
+      TF_RETURN_IF_ERROR(c->Concatenate(c->input(1), default_value, &out));
+      c->set_output(0, out);
+      return Status::OK();
+    });
+
+REGISTER_OP("EmbeddingCacheScatterAdd")
+    .Input("resource: resource")
+    .Input("ids: Tindices")
+    .Input("updates: dtype")
+    .Attr("dtype: {float, double}")
+    .Attr("Tindices: {int32, int64}")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle unused;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 0, &unused));
+      ShapeHandle ids;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 1, &ids));
+      ShapeHandle updates;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(2), 2, &updates));
+      DimensionHandle unused_dim;
+      TF_RETURN_IF_ERROR(
+          c->Merge(c->Dim(ids, 0), c->Dim(updates, 0), &unused_dim));
+      return Status::OK();
+    });
+
+REGISTER_OP("EmbeddingCacheExport")
+    .Input("resource: resource")
+    .Output("ids: int64")
+    .Output("values: dtype")
+    .Attr("dtype: {float, double}")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle unused;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 0, &unused));
+      c->set_output(0, c->Vector(InferenceContext::kUnknownDim));
+      c->set_output(1, c->UnknownShapeOfRank(2));
+      return Status::OK();
+    });
+
+REGISTER_OP("EmbeddingCacheImport")
+    .Input("resource: resource")
+    .Input("ids: int64")
+    .Input("values: dtype")
+    .Attr("dtype: {float, double}")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle unused;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 0, &unused));
+      ShapeHandle ids;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 1, &ids));
+      ShapeHandle values;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(2), 2, &values));
+      DimensionHandle unused_dim;
+      TF_RETURN_IF_ERROR(
+          c->Merge(c->Dim(ids, 0), c->Dim(values, 0), &unused_dim));
+      return Status::OK();
+    });
+
 REGISTER_OP("MutexV2")
     .Attr("container: string = ''")
     .Attr("shared_name: string = ''")
@@ -826,6 +826,39 @@ REGISTER_OP("ResourceApplyAdam")
     .Attr("use_nesterov: bool = false")
     .SetShapeFn(ApplyAdamShapeFn</*is_resource=*/true>);
 
+REGISTER_OP("ResourceApplyAdamMultiTensor")
+    .Input("var: N * resource")
+    .Input("m: N * resource")
+    .Input("v: N * resource")
+    .Input("beta1_power: T")
+    .Input("beta2_power: T")
+    .Input("lr: T")
+    .Input("beta1: T")
+    .Input("beta2: T")
+    .Input("epsilon: T")
+    .Input("grad: N * T")
+    .Attr("N: int >= 1")
+    .Attr("T: numbertype")
+    .Attr("use_locking: bool = false")
+    .Attr("use_nesterov: bool = false")
+    .SetShapeFn([](InferenceContext* c) {
+      int n;
+      TF_RETURN_IF_ERROR(c->GetAttr("N", &n));
+      ShapeHandle unused;
+      for (int i = 3 * n; i < 3 * n + 6; ++i) {
+        TF_RETURN_IF_ERROR(c->WithRank(c->input(i), 0, &unused));
+      }
+      for (int i = 0; i < n; ++i) {
+        ShapeHandle s = ShapeOrHandleShape</*is_resource=*/true>(c, i);
+        TF_RETURN_IF_ERROR(c->Merge(
+            s, ShapeOrHandleShape</*is_resource=*/true>(c, n + i), &s));
+        TF_RETURN_IF_ERROR(c->Merge(
+            s, ShapeOrHandleShape</*is_resource=*/true>(c, 2 * n + i), &s));
+        TF_RETURN_IF_ERROR(c->Merge(s, c->input(3 * n + 6 + i), &s));
+      }
+      return Status::OK();
+    });
+
 template <bool is_resource>
 static Status ApplyAdamWithAmsgradShapeFn(InferenceContext* c) {
   ShapeHandle unused;
@@ -1173,4 +1206,47 @@ REGISTER_OP("ResourceApplyPowerSign")
     .Attr("use_locking: bool = false")
     .SetShapeFn(ApplyPowerSignShapeFn</*is_resource=*/true>);
 
+// Checks the scalar hyperparameters after the variable, then grad [N, dim] and
+// indices [N].
+static Status EmbeddingVariableSparseApplyShapeFn(InferenceContext* c) {
+  ShapeHandle unused;
+  const int grad_idx = c->num_inputs() - 2;
+  TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 0, &unused));  // var
+  for (int i = 1; i < grad_idx; ++i) {
+    TF_RETURN_IF_ERROR(c->WithRank(c->input(i), 0, &unused));
+  }
+  ShapeHandle grad;
+  TF_RETURN_IF_ERROR(c->WithRank(c->input(grad_idx), 2, &grad));
+  ShapeHandle indices;
+  TF_RETURN_IF_ERROR(c->WithRank(c->input(grad_idx + 1), 1, &indices));
+  DimensionHandle unused_dim;
+  TF_RETURN_IF_ERROR(
+      c->Merge(c->Dim(grad, 0), c->Dim(indices, 0), &unused_dim));
+  return Status::OK();
+}
+
+REGISTER_OP("EmbeddingVariableSparseApplyAdagrad")
+    .Input("var: resource")
+    .Input("lr: T")
+    .Input("epsilon: T")
+    .Input("grad: T")
+    .Input("indices: Tindices")
+    .Attr("T: {float, double}")
+    .Attr("Tindices: {int32, int64}")
+    .SetShapeFn(EmbeddingVariableSparseApplyShapeFn);
+
+REGISTER_OP("EmbeddingVariableSparseApplyAdam")
+    .Input("var: resource")
+    .Input("beta1_power: T")
+    .Input("beta2_power: T")
+    .Input("lr: T")
+    .Input("beta1: T")
+    .Input("beta2: T")
+    .Input("epsilon: T")
+    .Input("grad: T")
+    .Input("indices: Tindices")
+    .Attr("T: {float, double}")
+    .Attr("Tindices: {int32, int64}")
+    .SetShapeFn(EmbeddingVariableSparseApplyShapeFn);
+
 }  // namespace tensorflow
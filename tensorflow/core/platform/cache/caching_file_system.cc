@@ -0,0 +1,451 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/platform/cache/caching_file_system.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <tuple>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/strip.h"
+#include "tensorflow/core/platform/blocking_counter.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/hash.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/numbers.h"
+#include "tensorflow/core/platform/path.h"
+#include "tensorflow/core/platform/random.h"
+#include "tensorflow/core/platform/strcat.h"
+
+namespace tensorflow {
+
+namespace {
+
+// The environment variables configuring the default instance.
+constexpr char kCacheDirEnv[] = "TF_FILE_CACHE_DIR";
+constexpr char kBlockSizeMbEnv[] = "TF_FILE_CACHE_BLOCK_SIZE_MB";
+constexpr uint64 kDefaultBlockSizeMb = 16;
+constexpr char kMaxSizeMbEnv[] = "TF_FILE_CACHE_MAX_SIZE_MB";
+constexpr uint64 kDefaultMaxSizeMb = 10240;
+
+// The number of threads fetching the missing blocks of a read.
+constexpr int kNumFetchThreads = 8;
+
+// The suffix of the blocks being written.
+constexpr char kTempSuffix[] = ".tmp";
+
+uint64 GetEnvMegabytes(const char* varname, uint64 default_value) {
+  const char* value = getenv(varname);
+  uint64 megabytes;
+  if (value == nullptr || !strings::safe_strtou64(value, &megabytes)) {
+    return default_value << 20;
+  }
+  return megabytes << 20;
+}
+
+string CachePrefix() {
+  return strings::StrCat(CachingFileSystem::kScheme, "://");
+}
+
+}  // namespace
+
+// A file whose reads go through the block cache of a CachingFileSystem. The
+// length and modification time of the file are those it had when opened.
+class CachedRandomAccessFile : public RandomAccessFile {
+ public:
+  CachedRandomAccessFile(CachingFileSystem* fs, const string& filename,
+                         std::unique_ptr<RandomAccessFile> base_file,
+                         uint64 file_key, uint64 file_size)
+      : fs_(fs),
+        filename_(filename),
+        base_file_(std::move(base_file)),
+        file_key_(file_key),
+        file_size_(file_size) {}
+
+  Status Name(StringPiece* result) const override {
+    *result = filename_;
+    return Status::OK();
+  }
+
+  Status Read(uint64 offset, size_t n, StringPiece* result,
+              char* scratch) const override {
+    *result = StringPiece();
+    const size_t length =
+        offset >= file_size_ ? 0 : std::min<uint64>(n, file_size_ - offset);
+    if (length > 0) {
+      const uint64 block_size = fs_->block_size_;
+      const uint64 first = offset / block_size;
+      const uint64 last = (offset + length - 1) / block_size;
+      // Reads the part of `block` in [offset, offset + length).
+      auto read_block = [this, offset, length, block_size, scratch](
+                            uint64 block) {
+        const uint64 block_start = block * block_size;
+        const size_t block_length =
+            std::min<uint64>(block_size, file_size_ - block_start);
+        const uint64 start = std::max(offset, block_start);
+        const uint64 end =
+            std::min(offset + length, block_start + block_length);
+        return fs_->ReadBlock(base_file_.get(), file_key_, block,
+                              block_length, start - block_start, end - start,
+                              scratch + (start - offset));
+      };
+      if (first == last) {
+        TF_RETURN_IF_ERROR(read_block(first));
+      } else {
+        std::vector<Status> statuses(last - first + 1);
+        BlockingCounter counter(statuses.size());
+        for (uint64 block = first; block <= last; ++block) {
+          fs_->fetch_pool_->Schedule(
+              [&read_block, &statuses, &counter, block, first]() {
+                statuses[block - first] = read_block(block);
+                counter.DecrementCount();
+              });
+        }
+        counter.Wait();
+        for (const Status& status : statuses) {
+          TF_RETURN_IF_ERROR(status);
+        }
+      }
+    }
+    *result = StringPiece(scratch, length);
+    if (length < n) {
+      return errors::OutOfRange("EOF reached, ", length,
+                                " bytes were read out of ", n,
+                                " bytes requested.");
+    }
+    return Status::OK();
+  }
+
+ private:
+  CachingFileSystem* const fs_;
+  const string filename_;
+  const std::unique_ptr<RandomAccessFile> base_file_;
+  const uint64 file_key_;
+  const uint64 file_size_;
+};
+
+constexpr char CachingFileSystem::kScheme[];
+
+CachingFileSystem::CachingFileSystem()
+    : CachingFileSystem(Env::Default(),
+                        getenv(kCacheDirEnv) ? getenv(kCacheDirEnv) : "",
+                        GetEnvMegabytes(kBlockSizeMbEnv, kDefaultBlockSizeMb),
+                        GetEnvMegabytes(kMaxSizeMbEnv, kDefaultMaxSizeMb)) {}
+
+CachingFileSystem::CachingFileSystem(Env* env, const string& cache_dir,
+                                     uint64 block_size, uint64 max_cache_bytes)
+    : env_(env),
+      cache_dir_(cache_dir),
+      block_size_(std::max<uint64>(block_size, 1)),
+      max_cache_bytes_(max_cache_bytes) {}
+
+CachingFileSystem::~CachingFileSystem() = default;
+
+void CachingFileSystem::MaybeInitialize() {
+  mutex_lock l(mu_);
+  if (initialized_) return;
+  initialized_ = true;
+  if (cache_dir_.empty()) {
+    std::vector<string> temp_dirs;
+    env_->GetLocalTempDirectories(&temp_dirs);
+    cache_dir_ = io::JoinPath(temp_dirs.empty() ? "/tmp" : temp_dirs[0],
+                              "tf_file_cache");
+  }
+  const Status status = env_->RecursivelyCreateDir(cache_dir_);
+  if (!status.ok()) {
+    LOG(WARNING) << "Could not create the file cache directory " << cache_dir_
+                 << ": " << status;
+  }
+  fetch_pool_.reset(
+      new thread::ThreadPool(env_, "cache_fs_fetch", kNumFetchThreads));
+
+  // The blocks left by earlier processes, oldest first.
+  std::vector<string> children;
+  if (!env_->GetChildren(cache_dir_, &children).ok()) return;
+  std::vector<std::tuple<int64, string, uint64>> blocks;
+  for (const string& child : children) {
+    if (absl::StrContains(child, kTempSuffix)) continue;
+    const string path = io::JoinPath(cache_dir_, child);
+    FileStatistics stat;
+    if (!env_->Stat(path, &stat).ok() || stat.is_directory) continue;
+    blocks.emplace_back(stat.mtime_nsec, path, stat.length);
+  }
+  std::sort(blocks.begin(), blocks.end());
+  for (const auto& block : blocks) {
+    lru_.push_back({std::get<1>(block), std::get<2>(block)});
+    index_[std::get<1>(block)] = std::prev(lru_.end());
+    cache_size_ += std::get<2>(block);
+  }
+}
+
+Status CachingFileSystem::GetBase(const string& fname, string* base_name,
+                                  FileSystem** base) {
+  StringPiece name(fname);
+  if (!absl::ConsumePrefix(&name, CachePrefix())) {
+    return errors::InvalidArgument("Not a ", kScheme, " file name: ", fname);
+  }
+  if (absl::StartsWith(name, CachePrefix())) {
+    return errors::InvalidArgument("Nested ", kScheme, " file name: ", fname);
+  }
+  *base_name = string(name);
+  return env_->GetFileSystemForFile(*base_name, base);
+}
+
+string CachingFileSystem::BlockPath(uint64 file_key, uint64 block) const {
+  return io::JoinPath(
+      cache_dir_, strings::StrCat(strings::Hex(file_key, strings::kZeroPad16),
+                                  "-", block));
+}
+
+Status CachingFileSystem::ReadBlock(RandomAccessFile* base_file,
+                                    uint64 file_key, uint64 block,
+                                    size_t block_length, size_t offset,
+                                    size_t n, char* dst) {
+  const string path = BlockPath(file_key, block);
+  std::unique_ptr<RandomAccessFile> cached_file;
+  if (env_->NewRandomAccessFile(path, &cached_file).ok()) {
+    StringPiece data;
+    const Status status = cached_file->Read(offset, n, &data, dst);
+    if (status.ok() && data.size() == n) {
+      if (data.data() != dst) memmove(dst, data.data(), n);
+      Touch(path, block_length);
+      return Status::OK();
+    }
+    // Another process evicted the block; fetch it again.
+  }
+
+  string contents(block_length, '\0');
+  StringPiece data;
+  Status status = base_file->Read(block * block_size_, block_length, &data,
+                                  &contents[0]);
+  if (errors::IsOutOfRange(status) && data.size() == block_length) {
+    status = Status::OK();
+  }
+  TF_RETURN_IF_ERROR(status);
+  if (data.size() != block_length) {
+    return errors::DataLoss("Read ", data.size(), " bytes of block ", block,
+                            " of ", block_length, " bytes, the file changed "
+                            "since it was opened.");
+  }
+  memcpy(dst, data.data() + offset, n);
+  WriteBlock(path, data);
+  return Status::OK();
+}
+
+void CachingFileSystem::WriteBlock(const string& path, StringPiece data) {
+  const string temp_path =
+      strings::StrCat(path, kTempSuffix, strings::Hex(random::New64()));
+  Status status = WriteStringToFile(env_, temp_path, data);
+  if (status.ok()) {
+    // The rename publishes the block whole to the other processes.
+    status = env_->RenameFile(temp_path, path);
+  }
+  if (!status.ok()) {
+    LOG_EVERY_N(WARNING, 100) << "Could not cache a block at " << path << ": "
+                              << status;
+    env_->DeleteFile(temp_path).IgnoreError();
+    return;
+  }
+  Touch(path, data.size());
+}
+
+void CachingFileSystem::Touch(const string& path, uint64 size) {
+  std::vector<string> evicted;
+  {
+    mutex_lock l(mu_);
+    auto it = index_.find(path);
+    if (it != index_.end()) {
+      lru_.splice(lru_.end(), lru_, it->second);
+    } else {
+      lru_.push_back({path, size});
+      index_[path] = std::prev(lru_.end());
+      cache_size_ += size;
+    }
+    evicted = EvictLocked();
+  }
+  for (const string& evicted_path : evicted) {
+    // The block may be gone already if another process evicted it.
+    env_->DeleteFile(evicted_path).IgnoreError();
+  }
+}
+
+std::vector<string> CachingFileSystem::EvictLocked() {
+  std::vector<string> evicted;
+  // The block used last stays, even if it alone exceeds the budget.
+  while (cache_size_ > max_cache_bytes_ && lru_.size() > 1) {
+    const Entry& entry = lru_.front();
+    evicted.push_back(entry.path);
+    cache_size_ -= entry.size;
+    index_.erase(entry.path);
+    lru_.pop_front();
+  }
+  return evicted;
+}
+
+uint64 CachingFileSystem::cache_size() const {
+  mutex_lock l(mu_);
+  return cache_size_;
+}
+
+Status CachingFileSystem::NewRandomAccessFile(
+    const string& fname, TransactionToken* token,
+    std::unique_ptr<RandomAccessFile>* result) {
+  string base_name;
+  FileSystem* base;
+  TF_RETURN_IF_ERROR(GetBase(fname, &base_name, &base));
+  FileStatistics stat;
+  TF_RETURN_IF_ERROR(base->Stat(base_name, token, &stat));
+  std::unique_ptr<RandomAccessFile> base_file;
+  TF_RETURN_IF_ERROR(base->NewRandomAccessFile(base_name, token, &base_file));
+  if (stat.length < 0) {
+    // Files of unknown length cannot be split into blocks.
+    *result = std::move(base_file);
+    return Status::OK();
+  }
+  MaybeInitialize();
+  const uint64 file_key = Hash64Combine(
+      Hash64(base_name), Hash64Combine(stat.length, stat.mtime_nsec));
+  result->reset(new CachedRandomAccessFile(this, fname, std::move(base_file),
+                                           file_key, stat.length));
+  return Status::OK();
+}
+
+Status CachingFileSystem::NewWritableFile(
+    const string& fname, TransactionToken* token,
+    std::unique_ptr<WritableFile>* result) {
+  string base_name;
+  FileSystem* base;
+  TF_RETURN_IF_ERROR(GetBase(fname, &base_name, &base));
+  return base->NewWritableFile(base_name, token, result);
+}
+
+Status CachingFileSystem::NewAppendableFile(
+    const string& fname, TransactionToken* token,
+    std::unique_ptr<WritableFile>* result) {
+  string base_name;
+  FileSystem* base;
+  TF_RETURN_IF_ERROR(GetBase(fname, &base_name, &base));
+  return base->NewAppendableFile(base_name, token, result);
+}
+
+Status CachingFileSystem::NewReadOnlyMemoryRegionFromFile(
+    const string& fname, TransactionToken* token,
+    std::unique_ptr<ReadOnlyMemoryRegion>* result) {
+  string base_name;
+  FileSystem* base;
+  TF_RETURN_IF_ERROR(GetBase(fname, &base_name, &base));
+  return base->NewReadOnlyMemoryRegionFromFile(base_name, token, result);
+}
+
+Status CachingFileSystem::FileExists(const string& fname,
+                                     TransactionToken* token) {
+  string base_name;
+  FileSystem* base;
+  TF_RETURN_IF_ERROR(GetBase(fname, &base_name, &base));
+  return base->FileExists(base_name, token);
+}
+
+Status CachingFileSystem::GetChildren(const string& dir,
+                                      TransactionToken* token,
+                                      std::vector<string>* result) {
+  string base_name;
+  FileSystem* base;
+  TF_RETURN_IF_ERROR(GetBase(dir, &base_name, &base));
+  return base->GetChildren(base_name, token, result);
+}
+
+Status CachingFileSystem::GetMatchingPaths(const string& pattern,
+                                           TransactionToken* token,
+                                           std::vector<string>* results) {
+  string base_pattern;
+  FileSystem* base;
+  TF_RETURN_IF_ERROR(GetBase(pattern, &base_pattern, &base));
+  TF_RETURN_IF_ERROR(base->GetMatchingPaths(base_pattern, token, results));
+  for (string& path : *results) {
+    path = strings::StrCat(CachePrefix(), path);
+  }
+  return Status::OK();
+}
+
+Status CachingFileSystem::Stat(const string& fname, TransactionToken* token,
+                               FileStatistics* stat) {
+  string base_name;
+  FileSystem* base;
+  TF_RETURN_IF_ERROR(GetBase(fname, &base_name, &base));
+  return base->Stat(base_name, token, stat);
+}
+
+Status CachingFileSystem::DeleteFile(const string& fname,
+                                     TransactionToken* token) {
+  string base_name;
+  FileSystem* base;
+  TF_RETURN_IF_ERROR(GetBase(fname, &base_name, &base));
+  return base->DeleteFile(base_name, token);
+}
+
+Status CachingFileSystem::CreateDir(const string& dirname,
+                                    TransactionToken* token) {
+  string base_name;
+  FileSystem* base;
+  TF_RETURN_IF_ERROR(GetBase(dirname, &base_name, &base));
+  return base->CreateDir(base_name, token);
+}
+
+Status CachingFileSystem::DeleteDir(const string& dirname,
+                                    TransactionToken* token) {
+  string base_name;
+  FileSystem* base;
+  TF_RETURN_IF_ERROR(GetBase(dirname, &base_name, &base));
+  return base->DeleteDir(base_name, token);
+}
+
+Status CachingFileSystem::GetFileSize(const string& fname,
+                                      TransactionToken* token,
+                                      uint64* file_size) {
+  string base_name;
+  FileSystem* base;
+  TF_RETURN_IF_ERROR(GetBase(fname, &base_name, &base));
+  return base->GetFileSize(base_name, token, file_size);
+}
+
+Status CachingFileSystem::RenameFile(const string& src, const string& target,
+                                     TransactionToken* token) {
+  string base_src;
+  string base_target;
+  FileSystem* base;
+  FileSystem* target_base;
+  TF_RETURN_IF_ERROR(GetBase(src, &base_src, &base));
+  TF_RETURN_IF_ERROR(GetBase(target, &base_target, &target_base));
+  if (base != target_base) {
+    return errors::Unimplemented("Renaming ", src, " to ", target,
+                                 " crosses file systems.");
+  }
+  return base->RenameFile(base_src, base_target, token);
+}
+
+Status CachingFileSystem::IsDirectory(const string& fname,
+                                      TransactionToken* token) {
+  string base_name;
+  FileSystem* base;
+  TF_RETURN_IF_ERROR(GetBase(fname, &base_name, &base));
+  return base->IsDirectory(base_name, token);
+}
+
+REGISTER_FILE_SYSTEM(CachingFileSystem::kScheme, CachingFileSystem);
+
+}  // namespace tensorflow
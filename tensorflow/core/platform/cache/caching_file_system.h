@@ -0,0 +1,170 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_PLATFORM_CACHE_CACHING_FILE_SYSTEM_H_
+#define TENSORFLOW_CORE_PLATFORM_CACHE_CACHING_FILE_SYSTEM_H_
+
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/file_system.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/threadpool.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// A file system which caches the files of another one on local disk, for
+// data read again and again from remote storage, such as the shards of a
+// dataset over the epochs of training or by the jobs of a host.
+//
+// The file "cache://<name>" is the file <name> of whatever file system serves
+// it, e.g. "cache://gs://bucket/data/shard-00001". Reads go through a cache of
+// blocks of block_size bytes in cache_dir, which holds at most max_cache_bytes
+// of them by evicting those used least recently. Missing blocks of a read are
+// fetched in parallel.
+//
+// The blocks of a file are keyed by its name, length and modification time,
+// so that a file written anew is read anew, and are written to a temporary
+// file renamed in place, so that the processes of a host can share one cache
+// directory: a block in it is complete and never changes. Every process
+// bounds the size of the blocks it knows of, those it wrote or read and those
+// in the directory when it started.
+//
+// Everything but reads goes to the underlying file system. The default
+// instance, registered for the "cache" scheme, is configured by the
+// environment variables:
+//   TF_FILE_CACHE_DIR: the cache directory, by default "tf_file_cache" in the
+//     first local temporary directory.
+//   TF_FILE_CACHE_BLOCK_SIZE_MB: the block size, 16 by default.
+//   TF_FILE_CACHE_MAX_SIZE_MB: the size of the cache, 10240 by default.
+class CachingFileSystem : public FileSystem {
+ public:
+  static constexpr char kScheme[] = "cache";
+
+  CachingFileSystem();
+  CachingFileSystem(Env* env, const string& cache_dir, uint64 block_size,
+                    uint64 max_cache_bytes);
+  ~CachingFileSystem() override;
+
+  TF_USE_FILESYSTEM_METHODS_WITH_NO_TRANSACTION_SUPPORT;
+
+  Status NewRandomAccessFile(
+      const string& fname, TransactionToken* token,
+      std::unique_ptr<RandomAccessFile>* result) override;
+
+  Status NewWritableFile(const string& fname, TransactionToken* token,
+                         std::unique_ptr<WritableFile>* result) override;
+
+  Status NewAppendableFile(const string& fname, TransactionToken* token,
+                           std::unique_ptr<WritableFile>* result) override;
+
+  Status NewReadOnlyMemoryRegionFromFile(
+      const string& fname, TransactionToken* token,
+      std::unique_ptr<ReadOnlyMemoryRegion>* result) override;
+
+  Status FileExists(const string& fname, TransactionToken* token) override;
+
+  Status GetChildren(const string& dir, TransactionToken* token,
+                     std::vector<string>* result) override;
+
+  Status GetMatchingPaths(const string& pattern, TransactionToken* token,
+                          std::vector<string>* results) override;
+
+  Status Stat(const string& fname, TransactionToken* token,
+              FileStatistics* stat) override;
+
+  Status DeleteFile(const string& fname, TransactionToken* token) override;
+
+  Status CreateDir(const string& dirname, TransactionToken* token) override;
+
+  Status DeleteDir(const string& dirname, TransactionToken* token) override;
+
+  Status GetFileSize(const string& fname, TransactionToken* token,
+                     uint64* file_size) override;
+
+  Status RenameFile(const string& src, const string& target,
+                    TransactionToken* token) override;
+
+  Status IsDirectory(const string& fname, TransactionToken* token) override;
+
+  string TranslateName(const string& name) const override { return name; }
+
+  // Returns the number of bytes of the blocks this instance knows of.
+  uint64 cache_size() const;
+
+ private:
+  friend class CachedRandomAccessFile;
+
+  // A cached block, in the order of use.
+  struct Entry {
+    string path;
+    uint64 size;
+  };
+
+  // Sets *base_name to the name of the file in the underlying file system,
+  // and *base to that file system.
+  Status GetBase(const string& fname, string* base_name, FileSystem** base);
+
+  // Creates the cache directory and indexes the blocks in it, once. The
+  // instance registered for the scheme is built at static initialization, so
+  // this is left to the first file opened.
+  void MaybeInitialize() TF_LOCKS_EXCLUDED(mu_);
+
+  // Reads [offset, offset + n) of block `block` of the file identified by
+  // `file_key` into `dst`, from the cache if it holds the block, else from
+  // `base_file`, in which case the block is added to the cache. The block
+  // holds `block_length` bytes.
+  Status ReadBlock(RandomAccessFile* base_file, uint64 file_key, uint64 block,
+                   size_t block_length, size_t offset, size_t n, char* dst);
+
+  // Writes a block fetched from the underlying file system into the cache.
+  void WriteBlock(const string& path, StringPiece data);
+
+  // Marks the block at `path` as the one used last, and evicts blocks if the
+  // cache is over budget.
+  void Touch(const string& path, uint64 size) TF_LOCKS_EXCLUDED(mu_);
+
+  // Removes the blocks used least recently from the index until the cache
+  // fits in its budget, and returns their paths.
+  std::vector<string> EvictLocked() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  string BlockPath(uint64 file_key, uint64 block) const;
+
+  Env* const env_;
+  // Set once by MaybeInitialize(), before blocks are read.
+  string cache_dir_;
+  const uint64 block_size_;
+  const uint64 max_cache_bytes_;
+  std::unique_ptr<thread::ThreadPool> fetch_pool_;
+
+  mutable mutex mu_;
+  bool initialized_ TF_GUARDED_BY(mu_) = false;
+  std::list<Entry> lru_ TF_GUARDED_BY(mu_);
+  std::unordered_map<string, std::list<Entry>::iterator> index_
+      TF_GUARDED_BY(mu_);
+  uint64 cache_size_ TF_GUARDED_BY(mu_) = 0;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(CachingFileSystem);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_PLATFORM_CACHE_CACHING_FILE_SYSTEM_H_
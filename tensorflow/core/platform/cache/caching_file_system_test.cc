@@ -0,0 +1,143 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/platform/cache/caching_file_system.h"
+
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/path.h"
+#include "tensorflow/core/platform/strcat.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+class CachingFileSystemTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    root_ = io::JoinPath(testing::TmpDir(), "caching_file_system_test",
+                         ::testing::UnitTest::GetInstance()
+                             ->current_test_info()
+                             ->name());
+    cache_dir_ = io::JoinPath(root_, "cache");
+    TF_ASSERT_OK(Env::Default()->RecursivelyCreateDir(root_));
+  }
+
+  // Returns the name of `path` in the cache file system.
+  string Cached(const string& path) {
+    return strings::StrCat("cache://", path);
+  }
+
+  // Returns the number of blocks in the cache directory.
+  int NumCachedBlocks() {
+    std::vector<string> children;
+    TF_CHECK_OK(Env::Default()->GetChildren(cache_dir_, &children));
+    return children.size();
+  }
+
+  string ReadAll(CachingFileSystem* fs, const string& path, uint64 offset,
+                 size_t n, Status* status) {
+    std::unique_ptr<RandomAccessFile> file;
+    TF_CHECK_OK(fs->NewRandomAccessFile(Cached(path), &file));
+    string scratch(n, 'x');
+    StringPiece result;
+    *status = file->Read(offset, n, &result, &scratch[0]);
+    return string(result);
+  }
+
+  string root_;
+  string cache_dir_;
+};
+
+TEST_F(CachingFileSystemTest, ReadsThroughTheCache) {
+  const string path = io::JoinPath(root_, "data");
+  TF_ASSERT_OK(WriteStringToFile(Env::Default(), path, "0123456789abcdef"));
+  CachingFileSystem fs(Env::Default(), cache_dir_, /*block_size=*/4,
+                       /*max_cache_bytes=*/1 << 20);
+
+  Status status;
+  // A read spanning several blocks fetches them all.
+  EXPECT_EQ("3456789", ReadAll(&fs, path, 3, 7, &status));
+  TF_EXPECT_OK(status);
+  EXPECT_EQ(3, NumCachedBlocks());
+  EXPECT_EQ(12, fs.cache_size());
+
+  // Reads of cached blocks do not add any, and reads past the end of the
+  // file return what there is.
+  EXPECT_EQ("6789abcdef", ReadAll(&fs, path, 6, 20, &status));
+  EXPECT_TRUE(errors::IsOutOfRange(status));
+  EXPECT_EQ(4, NumCachedBlocks());
+  EXPECT_EQ("", ReadAll(&fs, path, 16, 1, &status));
+  EXPECT_TRUE(errors::IsOutOfRange(status));
+
+  // A new instance sharing the directory uses the blocks there.
+  CachingFileSystem other_fs(Env::Default(), cache_dir_, 4, 1 << 20);
+  EXPECT_EQ("0123", ReadAll(&other_fs, path, 0, 4, &status));
+  TF_EXPECT_OK(status);
+  EXPECT_EQ(16, other_fs.cache_size());
+}
+
+TEST_F(CachingFileSystemTest, RereadsChangedFiles) {
+  const string path = io::JoinPath(root_, "data");
+  CachingFileSystem fs(Env::Default(), cache_dir_, 4, 1 << 20);
+  Status status;
+  TF_ASSERT_OK(WriteStringToFile(Env::Default(), path, "abcd"));
+  EXPECT_EQ("abcd", ReadAll(&fs, path, 0, 4, &status));
+  TF_ASSERT_OK(WriteStringToFile(Env::Default(), path, "efghi"));
+  EXPECT_EQ("efghi", ReadAll(&fs, path, 0, 5, &status));
+  TF_EXPECT_OK(status);
+}
+
+TEST_F(CachingFileSystemTest, EvictsLeastRecentlyUsedBlocks) {
+  const string path = io::JoinPath(root_, "data");
+  TF_ASSERT_OK(WriteStringToFile(Env::Default(), path, "0123456789ab"));
+  CachingFileSystem fs(Env::Default(), cache_dir_, /*block_size=*/4,
+                       /*max_cache_bytes=*/8);
+  Status status;
+  EXPECT_EQ("01", ReadAll(&fs, path, 0, 2, &status));
+  EXPECT_EQ("45", ReadAll(&fs, path, 4, 2, &status));
+  EXPECT_EQ("01", ReadAll(&fs, path, 0, 2, &status));
+  // Block 1 is the least recently used one.
+  EXPECT_EQ("89", ReadAll(&fs, path, 8, 2, &status));
+  EXPECT_EQ(2, NumCachedBlocks());
+  EXPECT_EQ(8, fs.cache_size());
+  EXPECT_EQ("0123456789ab", ReadAll(&fs, path, 0, 12, &status));
+  TF_EXPECT_OK(status);
+}
+
+TEST_F(CachingFileSystemTest, ForwardsOtherOperations) {
+  CachingFileSystem fs(Env::Default(), cache_dir_, 4, 1 << 20);
+  const string path = io::JoinPath(root_, "written");
+  std::unique_ptr<WritableFile> file;
+  TF_ASSERT_OK(fs.NewWritableFile(Cached(path), &file));
+  TF_ASSERT_OK(file->Append("hello"));
+  TF_ASSERT_OK(file->Close());
+  TF_EXPECT_OK(fs.FileExists(Cached(path)));
+  uint64 size;
+  TF_ASSERT_OK(fs.GetFileSize(Cached(path), &size));
+  EXPECT_EQ(5, size);
+  std::vector<string> matches;
+  TF_ASSERT_OK(
+      fs.GetMatchingPaths(Cached(io::JoinPath(root_, "writ*")), &matches));
+  EXPECT_EQ(std::vector<string>({Cached(path)}), matches);
+  TF_EXPECT_OK(fs.DeleteFile(Cached(path)));
+  EXPECT_TRUE(errors::IsNotFound(fs.FileExists(Cached(path))));
+
+  std::unique_ptr<RandomAccessFile> nested;
+  EXPECT_TRUE(errors::IsInvalidArgument(
+      fs.NewRandomAccessFile(Cached(Cached(path)), &nested)));
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -16,11 +16,13 @@ limitations under the License.
 #include "tensorflow/core/platform/cloud/curl_http_request.h"
 
 #include <algorithm>
+#include <vector>
 
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/gtl/map_util.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/scanner.h"
 #include "tensorflow/core/platform/str_util.h"
 #include "tensorflow/core/platform/types.h"
@@ -36,18 +38,40 @@ namespace {
 // Set to 1 to enable verbose debug output from curl.
 constexpr uint64 kVerboseOutput = 0;
 
+// The environment variable that overrides the most curl handles kept for
+// reuse once their requests are done.
+constexpr char kMaxIdleHandles[] = "TF_CURL_MAX_IDLE_HANDLES";
+constexpr int64 kDefaultMaxIdleHandles = 64;
+
 // Proxy to the real libcurl implementation.
+//
+// The handles of finished requests are reset and kept for the next requests,
+// so that these reuse the connections, DNS entries and TLS sessions cached by
+// the handles instead of opening new connections.
 class LibCurlProxy : public LibCurl {
  public:
   static LibCurlProxy* Load() {
     static LibCurlProxy* libcurl = []() -> LibCurlProxy* {
       curl_global_init(CURL_GLOBAL_ALL);
-      return new LibCurlProxy;
+      int64 max_idle_handles;
+      TF_CHECK_OK(ReadInt64FromEnvVar(kMaxIdleHandles, kDefaultMaxIdleHandles,
+                                      &max_idle_handles));
+      return new LibCurlProxy(max_idle_handles);
     }();
     return libcurl;
   }
 
-  CURL* curl_easy_init() override { return ::curl_easy_init(); }
+  CURL* curl_easy_init() override {
+    {
+      mutex_lock l(mu_);
+      if (!idle_handles_.empty()) {
+        CURL* curl = idle_handles_.back();
+        idle_handles_.pop_back();
+        return curl;
+      }
+    }
+    return ::curl_easy_init();
+  }
 
   CURLcode curl_easy_setopt(CURL* curl, CURLoption option,
                             uint64 param) override {
@@ -98,7 +122,16 @@ class LibCurlProxy : public LibCurl {
   }
 
   void curl_easy_cleanup(CURL* curl) override {
-    return ::curl_easy_cleanup(curl);
+    // Clears the options of the request but keeps the open connections.
+    ::curl_easy_reset(curl);
+    {
+      mutex_lock l(mu_);
+      if (idle_handles_.size() < max_idle_handles_) {
+        idle_handles_.push_back(curl);
+        return;
+      }
+    }
+    ::curl_easy_cleanup(curl);
   }
 
   char* curl_easy_escape(CURL* curl, const char* str, int length) override {
@@ -114,6 +147,14 @@ class LibCurlProxy : public LibCurl {
   }
 
   void curl_free(void* p) override { ::curl_free(p); }
+
+ private:
+  explicit LibCurlProxy(int64 max_idle_handles)
+      : max_idle_handles_(std::max<int64>(0, max_idle_handles)) {}
+
+  const size_t max_idle_handles_;
+  mutex mu_;
+  std::vector<CURL*> idle_handles_ TF_GUARDED_BY(mu_);
 };
 }  // namespace
 
@@ -47,6 +47,7 @@ limitations under the License.
 #include "tensorflow/core/platform/str_util.h"
 #include "tensorflow/core/platform/stringprintf.h"
 #include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/threadpool.h"
 #include "tensorflow/core/profiler/lib/traceme.h"
 
 #ifdef _WIN32
@@ -143,6 +144,15 @@ constexpr char kAppendMode[] = "GCS_APPEND_MODE";
 // default as the multiple API calls required add a risk of stranding temporary
 // objects.
 constexpr char kComposeAppend[] = "compose";
+// The environment variable that enables the upload of new files in parts of
+// this size, in MB, while they are written, instead of the upload of a local
+// temporary file when they are closed.
+constexpr char kParallelUploadPartSize[] = "GCS_PARALLEL_UPLOAD_PART_SIZE_MB";
+// The environment variable that overrides the most parts uploaded at once for
+// a file uploaded in parts.
+constexpr char kParallelUploadMaxParts[] = "GCS_PARALLEL_UPLOAD_MAX_PARTS";
+// The most source objects of a compose request.
+constexpr size_t kMaxComposeSources = 32;
 
 Status GetTmpFilename(string* filename) {
   *filename = io::GetTempFilename("");
@@ -714,6 +724,248 @@ class GcsWritableFile : public WritableFile {
   const StatusPoller status_poller_;
 };
 
+/// \brief GCS-based implementation of a writeable file uploaded in parts.
+///
+/// The appended data is buffered in memory and uploaded, while more data is
+/// appended, in parts of `part_size` bytes to temporary objects. Up to
+/// `max_parts_in_flight` parts are uploaded at once, and Append() waits while
+/// they all are, which bounds the memory used. Sync() composes the parts into
+/// the object, and Close() also deletes them. Flush() uploads nothing more.
+class GcsPartsWritableFile : public WritableFile {
+ public:
+  GcsPartsWritableFile(const string& bucket, const string& object,
+                       GcsFileSystem* filesystem,
+                       GcsFileSystem::TimeoutConfig* timeouts,
+                       std::function<void()> file_cache_erase,
+                       RetryConfig retry_config, size_t part_size,
+                       int max_parts_in_flight)
+      : bucket_(bucket),
+        object_(object),
+        filesystem_(filesystem),
+        timeouts_(timeouts),
+        file_cache_erase_(std::move(file_cache_erase)),
+        retry_config_(retry_config),
+        part_size_(part_size),
+        max_parts_in_flight_(max_parts_in_flight),
+        upload_pool_(new thread::ThreadPool(Env::Default(), "gcs_upload",
+                                            max_parts_in_flight)) {
+    VLOG(3) << "GcsPartsWritableFile: " << GetGcsPath();
+  }
+
+  ~GcsPartsWritableFile() override { Close().IgnoreError(); }
+
+  Status Append(StringPiece data) override {
+    TF_RETURN_IF_ERROR(CheckWritable());
+    VLOG(3) << "Append: " << GetGcsPath() << " size " << data.length();
+    sync_needed_ = true;
+    while (!data.empty()) {
+      const size_t n = std::min(data.size(), part_size_ - buffer_.size());
+      buffer_.append(data.data(), n);
+      data.remove_prefix(n);
+      size_ += n;
+      if (buffer_.size() == part_size_) {
+        TF_RETURN_IF_ERROR(UploadBuffer());
+      }
+    }
+    return Status::OK();
+  }
+
+  Status Close() override {
+    VLOG(3) << "Close:" << GetGcsPath();
+    if (closed_) {
+      return Status::OK();
+    }
+    Status status = Sync();
+    closed_ = true;
+    // Sync() waited for the uploads in flight, if it got to uploading.
+    status.Update(WaitForUploads());
+    for (const string& part : parts_) {
+      status.Update(
+          filesystem_->DeleteFile(GetGcsPathWithObject(part), nullptr));
+    }
+    return status;
+  }
+
+  Status Flush() override {
+    VLOG(3) << "Flush:" << GetGcsPath();
+    TF_RETURN_IF_ERROR(CheckWritable());
+    mutex_lock l(mu_);
+    return status_;
+  }
+
+  Status Name(StringPiece* result) const override {
+    return errors::Unimplemented(
+        "GcsPartsWritableFile does not support Name()");
+  }
+
+  Status Sync() override {
+    VLOG(3) << "Sync started:" << GetGcsPath();
+    TF_RETURN_IF_ERROR(CheckWritable());
+    if (!sync_needed_) {
+      return Status::OK();
+    }
+    // An empty file is still uploaded, as an empty part.
+    if (!buffer_.empty() || parts_.empty()) {
+      TF_RETURN_IF_ERROR(UploadBuffer());
+    }
+    TF_RETURN_IF_ERROR(WaitForUploads());
+    TF_RETURN_IF_ERROR(ComposeParts());
+    // Erase the file from the file cache on every successful write.
+    file_cache_erase_();
+    sync_needed_ = false;
+    VLOG(3) << "Sync finished " << GetGcsPath();
+    return Status::OK();
+  }
+
+  Status Tell(int64* position) override {
+    *position = size_;
+    return Status::OK();
+  }
+
+ private:
+  Status CheckWritable() const {
+    if (closed_) {
+      return errors::FailedPrecondition("The file is closed: ", GetGcsPath());
+    }
+    return Status::OK();
+  }
+
+  /// Uploads the buffered data as the next part, in the background.
+  Status UploadBuffer() {
+    const string part =
+        io::JoinPath(io::Dirname(object_), ".tmpcompose",
+                     strings::StrCat(io::Basename(object_), ".",
+                                     size_ - buffer_.size()));
+    auto data = std::make_shared<string>();
+    data->swap(buffer_);
+    {
+      mutex_lock l(mu_);
+      while (parts_in_flight_ >= max_parts_in_flight_) {
+        parts_cond_.wait(l);
+      }
+      TF_RETURN_IF_ERROR(status_);
+      ++parts_in_flight_;
+    }
+    parts_.push_back(part);
+    upload_pool_->Schedule([this, part, data]() {
+      const Status status = UploadPart(part, *data);
+      mutex_lock l(mu_);
+      status_.Update(status);
+      --parts_in_flight_;
+      parts_cond_.notify_all();
+    });
+    return Status::OK();
+  }
+
+  /// Waits for the parts in flight and returns the first error of the
+  /// uploads.
+  Status WaitForUploads() {
+    mutex_lock l(mu_);
+    while (parts_in_flight_ > 0) {
+      parts_cond_.wait(l);
+    }
+    return status_;
+  }
+
+  /// Uploads the contents of a part to its temporary object.
+  Status UploadPart(const string& part, const string& data) {
+    return RetryingUtils::CallWithRetries(
+        [&part, &data, this]() {
+          std::unique_ptr<HttpRequest> request;
+          TF_RETURN_IF_ERROR(filesystem_->CreateHttpRequest(&request));
+          request->SetUri(strings::StrCat(kGcsUploadUriBase, "b/", bucket_,
+                                          "/o?uploadType=media&name=",
+                                          request->EscapeString(part)));
+          request->SetTimeouts(timeouts_->connect, timeouts_->idle,
+                               timeouts_->write);
+          if (data.empty()) {
+            request->SetPostEmptyBody();
+          } else {
+            request->SetPostFromBuffer(data.data(), data.size());
+          }
+          TF_RETURN_WITH_CONTEXT_IF_ERROR(request->Send(), " when uploading ",
+                                          GetGcsPathWithObject(part));
+          return Status::OK();
+        },
+        retry_config_);
+  }
+
+  /// Composes the parts into the object. A compose request takes a bounded
+  /// number of sources, so the parts after the first ones are composed with
+  /// the object as composed so far.
+  Status ComposeParts() {
+    size_t next_part = 0;
+    while (next_part < parts_.size()) {
+      std::vector<string> sources;
+      if (next_part > 0) {
+        sources.push_back(object_);
+      }
+      while (sources.size() < kMaxComposeSources &&
+             next_part < parts_.size()) {
+        sources.push_back(parts_[next_part++]);
+      }
+      TF_RETURN_IF_ERROR(Compose(sources));
+    }
+    return Status::OK();
+  }
+
+  Status Compose(const std::vector<string>& sources) {
+    std::vector<string> names;
+    for (const string& source : sources) {
+      names.push_back(strings::StrCat("{'name': '", source, "'}"));
+    }
+    const string request_body = strings::StrCat(
+        "{'sourceObjects': [", absl::StrJoin(names, ","), "]}");
+    return RetryingUtils::CallWithRetries(
+        [&request_body, this]() {
+          std::unique_ptr<HttpRequest> request;
+          TF_RETURN_IF_ERROR(filesystem_->CreateHttpRequest(&request));
+          request->SetUri(strings::StrCat(kGcsUriBase, "b/", bucket_, "/o/",
+                                          request->EscapeString(object_),
+                                          "/compose"));
+          request->SetTimeouts(timeouts_->connect, timeouts_->idle,
+                               timeouts_->metadata);
+          request->AddHeader("content-type", "application/json");
+          request->SetPostFromBuffer(request_body.c_str(),
+                                     request_body.size());
+          TF_RETURN_WITH_CONTEXT_IF_ERROR(request->Send(),
+                                          " when composing to ", GetGcsPath());
+          return Status::OK();
+        },
+        retry_config_);
+  }
+
+  string GetGcsPathWithObject(string object) const {
+    return strings::StrCat("gs://", bucket_, "/", object);
+  }
+  string GetGcsPath() const { return GetGcsPathWithObject(object_); }
+
+  const string bucket_;
+  const string object_;
+  GcsFileSystem* const filesystem_;  // Not owned.
+  GcsFileSystem::TimeoutConfig* timeouts_;
+  std::function<void()> file_cache_erase_;
+  const RetryConfig retry_config_;
+  const size_t part_size_;
+  const int max_parts_in_flight_;
+  // The data appended since the last part.
+  string buffer_;
+  // The number of bytes appended.
+  uint64 size_ = 0;
+  // The temporary objects of the parts, in order.
+  std::vector<string> parts_;
+  bool sync_needed_ = true;
+  bool closed_ = false;
+
+  mutex mu_;
+  condition_variable parts_cond_;
+  int parts_in_flight_ TF_GUARDED_BY(mu_) = 0;
+  // The first error of the uploads.
+  Status status_ TF_GUARDED_BY(mu_);
+
+  std::unique_ptr<thread::ThreadPool> upload_pool_;
+};
+
 class GcsReadOnlyMemoryRegion : public ReadOnlyMemoryRegion {
  public:
   GcsReadOnlyMemoryRegion(std::unique_ptr<char[]> data, uint64 length)
@@ -779,12 +1031,17 @@ GcsFileSystem::GcsFileSystem(bool make_default_cache) {
   if (GetEnvVar(kMaxStaleness, strings::safe_strtou64, &value)) {
     max_staleness = value;
   }
+
+  if (GetEnvVar(kMaxReadaheadBlocks, strings::safe_strtou64, &value)) {
+    max_readahead_blocks_ = value;
+  }
   if (!make_default_cache) {
     max_bytes = 0;
   }
   VLOG(1) << "GCS cache max size = " << max_bytes << " ; "
           << "block size = " << block_size_ << " ; "
-          << "max staleness = " << max_staleness;
+          << "max staleness = " << max_staleness << " ; "
+          << "max readahead blocks = " << max_readahead_blocks_;
   file_block_cache_ = MakeFileBlockCache(block_size_, max_bytes, max_staleness);
   // Apply overrides for the stat cache max age and max entries, if provided.
   uint64 stat_cache_max_age = kStatCacheDefaultMaxAge;
@@ -905,6 +1162,15 @@ GcsFileSystem::GcsFileSystem(bool make_default_cache) {
   } else {
     compose_append_ = false;
   }
+
+  if (GetEnvVar(kParallelUploadPartSize, strings::safe_strtou64, &value)) {
+    parallel_upload_part_size_ = value * 1024 * 1024;
+  }
+  int64 max_parts;
+  if (GetEnvVar(kParallelUploadMaxParts, strings::safe_strto64, &max_parts) &&
+      max_parts > 0) {
+    parallel_upload_max_parts_ = max_parts;
+  }
 }
 
 GcsFileSystem::GcsFileSystem(
@@ -1017,7 +1283,8 @@ std::unique_ptr<FileBlockCache> GcsFileSystem::MakeFileBlockCache(
              size_t* bytes_transferred) {
         return LoadBufferFromGCS(filename, offset, n, buffer,
                                  bytes_transferred);
-      }));
+      },
+      Env::Default(), max_readahead_blocks_));
   return file_block_cache;
 }
 
@@ -1244,6 +1511,14 @@ Status GcsFileSystem::NewWritableFile(const string& fname,
   string bucket, object;
   TF_RETURN_IF_ERROR(ParseGcsPath(fname, false, &bucket, &object));
 
+  if (parallel_upload_part_size_ > 0) {
+    result->reset(new GcsPartsWritableFile(
+        bucket, object, this, &timeouts_,
+        [this, fname]() { ClearFileCaches(fname); }, retry_config_,
+        parallel_upload_part_size_, std::max(1, parallel_upload_max_parts_)));
+    return Status::OK();
+  }
+
   auto session_creator =
       [this](uint64 start_offset, const std::string& object_to_upload,
              const std::string& bucket, uint64 file_size,
@@ -50,6 +50,12 @@ constexpr size_t kDefaultMaxCacheSize = 0;
 // will be evicted on the next read.
 constexpr char kMaxStaleness[] = "GCS_READ_CACHE_MAX_STALENESS";
 constexpr uint64 kDefaultMaxStaleness = 0;
+// The environment variable that overrides the maximum number of blocks read
+// ahead of sequential reads through the block cache, each with its own
+// request. The number of blocks read ahead of a file grows from one up to this
+// number as its reads stay sequential.
+constexpr char kMaxReadaheadBlocks[] = "GCS_READ_CACHE_MAX_READAHEAD_BLOCKS";
+constexpr size_t kDefaultMaxReadaheadBlocks = 0;
 
 // Helper function to extract an environment variable and convert it into a
 // value of type T.
@@ -272,6 +278,17 @@ class GcsFileSystem : public FileSystem {
   void ResetFileBlockCache(size_t block_size_bytes, size_t max_bytes,
                            uint64 max_staleness_secs);
 
+  /// \brief Makes new files upload in parts while they are written.
+  ///
+  /// Files opened by NewWritableFile() afterwards are uploaded in parts of
+  /// `part_size` bytes, up to `max_parts_in_flight` at once, and composed
+  /// when synced or closed. A `part_size` of 0 restores the upload of whole
+  /// files.
+  void SetParallelUpload(size_t part_size, int max_parts_in_flight) {
+    parallel_upload_part_size_ = part_size;
+    parallel_upload_max_parts_ = max_parts_in_flight;
+  }
+
  protected:
   virtual std::unique_ptr<FileBlockCache> MakeFileBlockCache(
       size_t block_size, size_t max_bytes, uint64 max_staleness);
@@ -403,6 +420,9 @@ class GcsFileSystem : public FileSystem {
   // Reads smaller than block_size_ will trigger a read of block_size_.
   uint64 block_size_;
 
+  // The most blocks read ahead of sequential reads through the block cache.
+  size_t max_readahead_blocks_ = kDefaultMaxReadaheadBlocks;
+
   // block_cache_lock_ protects the file_block_cache_ pointer (Note that
   // FileBlockCache instances are themselves threadsafe).
   mutex block_cache_lock_;
@@ -422,6 +442,11 @@ class GcsFileSystem : public FileSystem {
   std::unordered_set<string> allowed_locations_;
   bool compose_append_;
 
+  // The size of the parts new files are uploaded in, or 0 to upload whole
+  // files, and the most parts uploaded at once.
+  size_t parallel_upload_part_size_ = 0;
+  int parallel_upload_max_parts_ = 4;
+
   GcsStatsInterface* stats_ = nullptr;  // Not owned.
 
   // Additional header material to be transmitted with all GCS requests
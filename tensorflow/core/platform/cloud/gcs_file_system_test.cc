@@ -1323,6 +1323,72 @@ TEST(GcsFileSystemTest, NewWritableFile_UploadReturns410) {
   EXPECT_EQ(tmp_files_before, results.size());
 }
 
+TEST(GcsFileSystemTest, NewWritableFile_ParallelUpload) {
+  std::vector<HttpRequest*> requests;
+  // The parts are uploaded as they fill up, then composed and deleted.
+  const std::vector<std::pair<string, string>> parts(
+      {{"0", "01234567"}, {"8", "89abcdef"}, {"16", "gh"}});
+  for (const auto& part : parts) {
+    requests.push_back(new FakeHttpRequest(
+        strings::StrCat("Uri: https://www.googleapis.com/upload/storage/v1/b/"
+                        "bucket/o?uploadType=media&name=path%2F.tmpcompose%2F"
+                        "writeable.",
+                        part.first,
+                        "\n"
+                        "Auth Token: fake_token\n"
+                        "Timeouts: 5 1 30\n"
+                        "Post body: ",
+                        part.second, "\n"),
+        ""));
+  }
+  requests.push_back(new FakeHttpRequest(
+      "Uri: https://www.googleapis.com/storage/v1/b/bucket/o/"
+      "path%2Fwriteable/compose\n"
+      "Auth Token: fake_token\n"
+      "Timeouts: 5 1 10\n"
+      "Header content-type: application/json\n"
+      "Post body: {'sourceObjects': [{'name': 'path/.tmpcompose/writeable.0'},"
+      "{'name': 'path/.tmpcompose/writeable.8'},"
+      "{'name': 'path/.tmpcompose/writeable.16'}]}\n",
+      ""));
+  for (const auto& part : parts) {
+    requests.push_back(new FakeHttpRequest(
+        strings::StrCat("Uri: https://www.googleapis.com/storage/v1/b/bucket/"
+                        "o/path%2F.tmpcompose%2Fwriteable.",
+                        part.first,
+                        "\n"
+                        "Auth Token: fake_token\n"
+                        "Timeouts: 5 1 10\n"
+                        "Delete: yes\n"),
+        ""));
+  }
+  GcsFileSystem fs(
+      std::unique_ptr<AuthProvider>(new FakeAuthProvider),
+      std::unique_ptr<HttpRequest::Factory>(
+          new FakeHttpRequestFactory(&requests)),
+      std::unique_ptr<ZoneProvider>(new FakeZoneProvider), 0 /* block size */,
+      0 /* max bytes */, 0 /* max staleness */, 0 /* stat cache max age */,
+      0 /* stat cache max entries */, 0 /* matching paths cache max age */,
+      0 /* matching paths cache max entries */, kTestRetryConfig,
+      kTestTimeoutConfig, *kAllowedLocationsDefault,
+      nullptr /* gcs additional header */, false /* compose append */);
+  // One part in flight at a time keeps the order of the requests.
+  fs.SetParallelUpload(8 /* part size */, 1 /* max parts in flight */);
+
+  std::unique_ptr<WritableFile> file;
+  TF_EXPECT_OK(
+      fs.NewWritableFile("gs://bucket/path/writeable", nullptr, &file));
+
+  TF_EXPECT_OK(file->Append("0123456789"));
+  TF_EXPECT_OK(file->Append("abcdefgh"));
+  int64 position;
+  TF_EXPECT_OK(file->Tell(&position));
+  EXPECT_EQ(18, position);
+  TF_EXPECT_OK(file->Close());
+  EXPECT_EQ(errors::Code::FAILED_PRECONDITION,
+            file->Append("more").code());
+}
+
 TEST(GcsFileSystemTest, NewWritableFile_NoObjectName) {
   std::vector<HttpRequest*> requests;
   GcsFileSystem fs(
@@ -14,6 +14,7 @@ limitations under the License.
 ==============================================================================*/
 
 #include "tensorflow/core/platform/cloud/ram_file_block_cache.h"
+#include <algorithm>
 #include <cstring>
 #include <memory>
 #include "tensorflow/core/lib/gtl/cleanup.h"
@@ -21,6 +22,13 @@ limitations under the License.
 
 namespace tensorflow {
 
+namespace {
+
+// The most files whose sequential reads are tracked at once.
+constexpr size_t kMaxReadaheadFiles = 1024;
+
+}  // namespace
+
 bool RamFileBlockCache::BlockNotStale(const std::shared_ptr<Block>& block) {
   mutex_lock l(block->mu);
   if (block->state != FetchState::FINISHED) {
@@ -79,15 +87,19 @@ Status RamFileBlockCache::UpdateLRU(const Key& key,
     block->lru_iterator = lru_list_.begin();
   }
 
-  // Check for inconsistent state. If there is a block later in the same file
-  // in the cache, and our current block is not block size, this likely means
-  // we have inconsistent state within the cache. Note: it's possible some
-  // incomplete reads may still go undetected.
+  // Check for inconsistent state. If there is a block with data later in the
+  // same file in the cache, and our current block is not block size, this
+  // likely means we have inconsistent state within the cache. Blocks still
+  // being fetched ahead, or fetched past the end of the file, are ignored.
+  // Note: it's possible some incomplete reads may still go undetected.
   if (block->data.size() < block_size_) {
-    Key fmax = std::make_pair(key.first, std::numeric_limits<size_t>::max());
-    auto fcmp = block_map_.upper_bound(fmax);
-    if (fcmp != block_map_.begin() && key < (--fcmp)->first) {
-      return errors::Internal("Block cache contents are inconsistent.");
+    for (auto it = block_map_.upper_bound(key);
+         it != block_map_.end() && it->first.first == key.first; ++it) {
+      mutex_lock l(it->second->mu);
+      if (it->second->state == FetchState::FINISHED &&
+          !it->second->data.empty()) {
+        return errors::Internal("Block cache contents are inconsistent.");
+      }
     }
   }
 
@@ -165,6 +177,41 @@ Status RamFileBlockCache::MaybeFetch(const Key& key,
       "Control flow should never reach the end of RamFileBlockCache::Fetch.");
 }
 
+void RamFileBlockCache::MaybeReadAhead(const string& filename, size_t offset,
+                                       size_t finish) {
+  size_t num_blocks;
+  {
+    mutex_lock lock(mu_);
+    if (readahead_.size() >= kMaxReadaheadFiles &&
+        readahead_.find(filename) == readahead_.end()) {
+      readahead_.clear();
+    }
+    Readahead& readahead = readahead_[filename];
+    if (offset == readahead.next_offset) {
+      readahead.num_blocks = std::min(
+          max_readahead_blocks_, std::max<size_t>(1, 2 * readahead.num_blocks));
+    } else {
+      readahead.num_blocks = 0;
+    }
+    readahead.next_offset = finish;
+    num_blocks = readahead.num_blocks;
+  }
+  for (size_t i = 0; i < num_blocks; ++i) {
+    Key key = std::make_pair(filename, finish + i * block_size_);
+    std::shared_ptr<Block> block = Lookup(key);
+    {
+      mutex_lock l(block->mu);
+      if (block->state != FetchState::CREATED) continue;
+    }
+    readahead_pool_->Schedule([this, key, block]() {
+      // Errors are left to the reads of the block, which fetch it again.
+      if (MaybeFetch(key, block).ok()) {
+        UpdateLRU(key, block).IgnoreError();
+      }
+    });
+  }
+}
+
 Status RamFileBlockCache::Read(const string& filename, size_t offset, size_t n,
                                char* buffer, size_t* bytes_transferred) {
   *bytes_transferred = 0;
@@ -182,6 +229,9 @@ Status RamFileBlockCache::Read(const string& filename, size_t offset, size_t n,
   if (finish < offset + n) {
     finish += block_size_;
   }
+  if (readahead_pool_ != nullptr) {
+    MaybeReadAhead(filename, offset, finish);
+  }
   size_t total_bytes_transferred = 0;
   // Now iterate through the blocks, reading them one at a time.
   for (size_t pos = start; pos < finish; pos += block_size_) {
@@ -271,6 +321,7 @@ void RamFileBlockCache::Flush() {
   block_map_.clear();
   lru_list_.clear();
   lra_list_.clear();
+  readahead_.clear();
   cache_size_ = 0;
 }
 
@@ -280,6 +331,7 @@ void RamFileBlockCache::RemoveFile(const string& filename) {
 }
 
 void RamFileBlockCache::RemoveFile_Locked(const string& filename) {
+  readahead_.erase(filename);
   Key begin = std::make_pair(filename, 0);
   auto it = block_map_.lower_bound(begin);
   while (it != block_map_.end() && it->first.first == filename) {
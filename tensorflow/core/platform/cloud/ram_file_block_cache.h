@@ -16,11 +16,13 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_PLATFORM_CLOUD_RAM_FILE_BLOCK_CACHE_H_
 #define TENSORFLOW_CORE_PLATFORM_CLOUD_RAM_FILE_BLOCK_CACHE_H_
 
+#include <algorithm>
 #include <functional>
 #include <list>
 #include <map>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "tensorflow/core/platform/cloud/file_block_cache.h"
@@ -30,6 +32,7 @@ limitations under the License.
 #include "tensorflow/core/platform/status.h"
 #include "tensorflow/core/platform/stringpiece.h"
 #include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/threadpool.h"
 #include "tensorflow/core/platform/types.h"
 
 namespace tensorflow {
@@ -50,22 +53,37 @@ class RamFileBlockCache : public FileBlockCache {
                                size_t* bytes_transferred)>
       BlockFetcher;
 
+  /// With `max_readahead_blocks` > 0, sequential reads of a file also fetch
+  /// the blocks that follow in the background, up to `max_readahead_blocks`
+  /// of them at once. The number of blocks read ahead starts at one and
+  /// doubles with every further sequential read.
   RamFileBlockCache(size_t block_size, size_t max_bytes, uint64 max_staleness,
-                    BlockFetcher block_fetcher, Env* env = Env::Default())
+                    BlockFetcher block_fetcher, Env* env = Env::Default(),
+                    size_t max_readahead_blocks = 0)
       : block_size_(block_size),
         max_bytes_(max_bytes),
         max_staleness_(max_staleness),
         block_fetcher_(block_fetcher),
-        env_(env) {
+        env_(env),
+        max_readahead_blocks_(
+            IsCacheEnabled()
+                ? std::min(max_readahead_blocks, max_bytes / block_size / 2)
+                : 0) {
     if (max_staleness_ > 0) {
       pruning_thread_.reset(env_->StartThread(ThreadOptions(), "TF_prune_FBC",
                                               [this] { Prune(); }));
     }
+    if (max_readahead_blocks_ > 0) {
+      readahead_pool_.reset(new thread::ThreadPool(
+          env_, "TF_readahead_FBC", static_cast<int>(max_readahead_blocks_)));
+    }
     VLOG(1) << "GCS file block cache is "
             << (IsCacheEnabled() ? "enabled" : "disabled");
   }
 
   ~RamFileBlockCache() override {
+    // Waits for the fetches in flight, which use the cache.
+    readahead_pool_.reset();
     if (pruning_thread_) {
       stop_pruning_thread_.Notify();
       // Destroying pruning_thread_ will block until Prune() receives the above
@@ -131,6 +149,8 @@ class RamFileBlockCache : public FileBlockCache {
   const BlockFetcher block_fetcher_;
   /// The Env from which we read timestamps.
   Env* const env_;  // not owned
+  /// The most blocks of a file fetched ahead of its sequential reads.
+  const size_t max_readahead_blocks_;
 
   /// \brief The key type for the file block cache.
   ///
@@ -200,6 +220,11 @@ class RamFileBlockCache : public FileBlockCache {
   Status MaybeFetch(const Key& key, const std::shared_ptr<Block>& block)
       TF_LOCKS_EXCLUDED(mu_);
 
+  /// Fetch in the background the blocks after `finish` that a sequential
+  /// read of `filename` ending at `finish` is likely to be followed by.
+  void MaybeReadAhead(const string& filename, size_t offset, size_t finish)
+      TF_LOCKS_EXCLUDED(mu_);
+
   /// Trim the block cache to make room for another entry.
   void Trim() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
 
@@ -221,6 +246,9 @@ class RamFileBlockCache : public FileBlockCache {
   /// Notification for stopping the cache pruning thread.
   Notification stop_pruning_thread_;
 
+  /// The threads fetching blocks ahead of the reads.
+  std::unique_ptr<thread::ThreadPool> readahead_pool_;
+
   /// Guards access to the block map, LRU list, and cached byte count.
   mutable mutex mu_;
 
@@ -243,6 +271,18 @@ class RamFileBlockCache : public FileBlockCache {
 
   // A filename->file_signature map.
   std::map<string, int64> file_signature_map_ TF_GUARDED_BY(mu_);
+
+  /// \brief The sequential reads of a file.
+  ///
+  /// `next_offset` is where the last read ended, and `num_blocks` the number
+  /// of blocks fetched ahead of it.
+  struct Readahead {
+    size_t next_offset = 0;
+    size_t num_blocks = 0;
+  };
+
+  /// The sequential reads of the files read with readahead.
+  std::unordered_map<string, Readahead> readahead_ TF_GUARDED_BY(mu_);
 };
 
 }  // namespace tensorflow
@@ -15,12 +15,15 @@ limitations under the License.
 
 #include "tensorflow/core/platform/cloud/ram_file_block_cache.h"
 
+#include <algorithm>
 #include <cstring>
+#include <map>
 
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/platform/blocking_counter.h"
 #include "tensorflow/core/platform/cloud/now_seconds_env.h"
 #include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/notification.h"
 #include "tensorflow/core/platform/test.h"
 
@@ -547,6 +550,56 @@ TEST(RamFileBlockCacheTest, CoalesceConcurrentReads) {
   EXPECT_EQ(1, num_requests);
 }
 
+TEST(RamFileBlockCacheTest, Readahead) {
+  // A file of 100 bytes, where byte i is i.
+  const size_t block_size = 16;
+  const size_t file_size = 100;
+  mutex mu;
+  std::map<size_t, int> fetches;
+  auto fetcher = [&mu, &fetches, file_size](
+                     const string& filename, size_t offset, size_t n,
+                     char* buffer, size_t* bytes_transferred) {
+    {
+      mutex_lock l(mu);
+      ++fetches[offset];
+    }
+    *bytes_transferred = offset < file_size ? std::min(n, file_size - offset)
+                                            : 0;
+    for (size_t i = 0; i < *bytes_transferred; ++i) {
+      buffer[i] = offset + i;
+    }
+    return Status::OK();
+  };
+  {
+    RamFileBlockCache cache(block_size, 32 * block_size, 0, fetcher,
+                            Env::Default(), /*max_readahead_blocks=*/4);
+    std::vector<char> out;
+    // Sequential reads up to and past the end of the file, while the blocks
+    // after them are fetched ahead.
+    for (size_t offset = 0; offset < file_size; offset += block_size) {
+      TF_EXPECT_OK(ReadCache(&cache, "a", offset, block_size, &out));
+      EXPECT_EQ(std::min(block_size, file_size - offset), out.size());
+      for (size_t i = 0; i < out.size(); ++i) {
+        EXPECT_EQ(static_cast<char>(offset + i), out[i]);
+      }
+    }
+    // The cache waits for the fetches in flight when destroyed.
+  }
+  // Every block of the file was fetched once.
+  for (size_t offset = 0; offset < file_size; offset += block_size) {
+    EXPECT_EQ(1, fetches[offset]) << "offset " << offset;
+  }
+  // Random reads do not read ahead.
+  fetches.clear();
+  {
+    RamFileBlockCache cache(block_size, 32 * block_size, 0, fetcher,
+                            Env::Default(), /*max_readahead_blocks=*/4);
+    std::vector<char> out;
+    TF_EXPECT_OK(ReadCache(&cache, "a", 3 * block_size, block_size, &out));
+  }
+  EXPECT_EQ(1, fetches.size());
+}
+
 TEST(RamFileBlockCacheTest, Flush) {
   int calls = 0;
   auto fetcher = [&calls](const string& filename, size_t offset, size_t n,
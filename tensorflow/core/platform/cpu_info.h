@@ -17,6 +17,7 @@ limitations under the License.
 #define TENSORFLOW_CORE_PLATFORM_CPU_INFO_H_
 
 #include <string>
+#include <vector>
 
 // TODO(ahentz): This is not strictly required here but, for historical
 // reasons, many people depend on cpu_info.h in order to use kLittleEndian.
@@ -37,6 +38,14 @@ namespace port {
 // value (e.g. `4`) may be returned.
 int NumSchedulableCPUs();
 
+// Returns the ids of the CPUs this process may run on, in increasing order, or
+// an empty vector if they cannot be determined.
+std::vector<int> SchedulableCPUs();
+
+// Restricts the calling thread to run on the CPUs with the given ids. Returns
+// false if the platform does not support it or the call fails.
+bool SetThreadCPUAffinity(const std::vector<int>& cpus);
+
 // Returns an estimate for the maximum parallelism for this process.
 // Applications should avoid running more than this number of threads with
 // intensive workloads concurrently to avoid performance degradation and
@@ -678,6 +678,12 @@ def tf_additional_core_deps():
         "//conditions:default": [
             clean_dep("//tensorflow/core/platform/s3:s3_file_system"),
         ],
+    }) + select({
+        clean_dep("//tensorflow:android"): [],
+        clean_dep("//tensorflow:ios"): [],
+        "//conditions:default": [
+            clean_dep("//tensorflow/core/platform/cache:caching_file_system"),
+        ],
     })
 
 def tf_lib_proto_parsing_deps():
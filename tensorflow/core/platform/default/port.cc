@@ -88,6 +88,34 @@ int NumSchedulableCPUs() {
   return kDefaultCores;
 }
 
+std::vector<int> SchedulableCPUs() {
+  std::vector<int> cpus;
+#if defined(__linux__) && !defined(__ANDROID__)
+  cpu_set_t cpuset;
+  if (sched_getaffinity(0, sizeof(cpu_set_t), &cpuset) == 0) {
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+      if (CPU_ISSET(cpu, &cpuset)) cpus.push_back(cpu);
+    }
+  }
+#endif
+  return cpus;
+}
+
+bool SetThreadCPUAffinity(const std::vector<int>& cpus) {
+#if defined(__linux__) && !defined(__ANDROID__)
+  cpu_set_t cpuset;
+  CPU_ZERO(&cpuset);
+  for (int cpu : cpus) {
+    if (cpu < 0 || cpu >= CPU_SETSIZE) return false;
+    CPU_SET(cpu, &cpuset);
+  }
+  // A pid of 0 is the calling thread.
+  return sched_setaffinity(0, sizeof(cpu_set_t), &cpuset) == 0;
+#else
+  return false;
+#endif
+}
+
 int MaxParallelism() { return NumSchedulableCPUs(); }
 
 int MaxParallelism(int numa_node) {
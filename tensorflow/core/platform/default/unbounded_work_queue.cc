@@ -15,16 +15,32 @@ limitations under the License.
 
 #include "tensorflow/core/platform/default/unbounded_work_queue.h"
 
+#include <thread>
+
 #include "absl/memory/memory.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/numa.h"
 
 namespace tensorflow {
 
+namespace {
+
+// The longest spin of an idle thread. Beyond it, parking and being woken up
+// costs less than the spin.
+constexpr uint64 kMaxSpinNanos = 100 * 1000;
+
+}  // namespace
+
 UnboundedWorkQueue::UnboundedWorkQueue(Env* env, const string& thread_name,
-                                       const ThreadOptions& thread_options)
-    : env_(env), thread_name_(thread_name), thread_options_(thread_options) {}
+                                       const ThreadOptions& thread_options,
+                                       bool adaptive_spinning)
+    : env_(env),
+      thread_name_(thread_name),
+      thread_options_(thread_options),
+      adaptive_spinning_(adaptive_spinning) {}
 
 UnboundedWorkQueue::~UnboundedWorkQueue() {
   {
@@ -57,7 +73,24 @@ void UnboundedWorkQueue::Schedule(WorkFunction fn) {
   // cached thread to process it.
   mutex_lock l(work_queue_mu_);
   work_queue_.push_back(std::move(fn));
-  work_queue_cv_.notify_one();
+  queue_length_.store(work_queue_.size(), std::memory_order_relaxed);
+  if (adaptive_spinning_) {
+    const uint64 now_nanos = env_->NowNanos();
+    if (last_schedule_nanos_ != 0) {
+      const uint64 interarrival_nanos = now_nanos - last_schedule_nanos_;
+      const uint64 average_nanos =
+          average_interarrival_nanos_.load(std::memory_order_relaxed);
+      average_interarrival_nanos_.store(
+          average_nanos == 0 ? interarrival_nanos
+                             : (7 * average_nanos + interarrival_nanos) / 8,
+          std::memory_order_relaxed);
+    }
+    last_schedule_nanos_ = now_nanos;
+  }
+  // The spinning threads pick up one item each without being woken up.
+  if (work_queue_.size() > num_spinning_threads_) {
+    work_queue_cv_.notify_one();
+  }
   // NOTE: The queue may be non-empty, so we must account for queued work when
   // considering how many threads are free.
   if (work_queue_.size() > num_idle_threads_) {
@@ -77,27 +110,86 @@ void UnboundedWorkQueue::PooledThreadFunc() {
   if (thread_options_.numa_node != port::kNUMANoAffinity) {
     port::NUMASetThreadNodeAffinity(thread_options_.numa_node);
   }
+  if (!thread_options_.cpu_set.empty() &&
+      !port::SetThreadCPUAffinity(thread_options_.cpu_set)) {
+    LOG(WARNING) << "Could not pin a thread of " << thread_name_
+                 << " to its CPU set.";
+  }
 
   while (true) {
     WorkFunction fn;
+    bool spin = false;
     {
       mutex_lock l(work_queue_mu_);
       ++num_idle_threads_;
-      while (!cancelled_ && work_queue_.empty()) {
-        // Wait for a new work function to be submitted, or the cache to be
-        // destroyed.
-        work_queue_cv_.wait(l);
+      if (adaptive_spinning_ && !cancelled_ && work_queue_.empty()) {
+        ++num_spinning_threads_;
+        spin = true;
+      } else if (!TakeWork(&l, &fn)) {
+        return;
       }
-      if (cancelled_) {
+    }
+    if (spin) {
+      SpinForWork();
+      mutex_lock l(work_queue_mu_);
+      --num_spinning_threads_;
+      if (!work_queue_.empty()) ++num_spin_hits_;
+      if (!TakeWork(&l, &fn)) {
         return;
       }
-      fn = std::move(work_queue_.front());
-      work_queue_.pop_front();
-      --num_idle_threads_;
     }
 
     fn();
   }
 }
 
+bool UnboundedWorkQueue::TakeWork(mutex_lock* l, WorkFunction* fn) {
+  while (!cancelled_ && work_queue_.empty()) {
+    // Wait for a new work function to be submitted, or the cache to be
+    // destroyed.
+    ++num_parks_;
+    work_queue_cv_.wait(*l);
+    ++num_unparks_;
+  }
+  if (cancelled_) {
+    return false;
+  }
+  *fn = std::move(work_queue_.front());
+  work_queue_.pop_front();
+  queue_length_.store(work_queue_.size(), std::memory_order_relaxed);
+  --num_idle_threads_;
+  return true;
+}
+
+void UnboundedWorkQueue::SpinForWork() {
+  // Spinning only pays off when the next item likely comes sooner than a park
+  // and unpark would take.
+  const uint64 spin_nanos =
+      2 * average_interarrival_nanos_.load(std::memory_order_relaxed);
+  if (spin_nanos == 0 || spin_nanos > kMaxSpinNanos) return;
+  const uint64 deadline_nanos = env_->NowNanos() + spin_nanos;
+  while (queue_length_.load(std::memory_order_relaxed) == 0 &&
+         env_->NowNanos() < deadline_nanos) {
+    // Let the threads of the other pools sharing the core run.
+    std::this_thread::yield();
+  }
+}
+
+UnboundedWorkQueue::Stats UnboundedWorkQueue::GetStats() {
+  Stats stats;
+  {
+    mutex_lock l(work_queue_mu_);
+    stats.queue_length = work_queue_.size();
+    stats.num_idle_threads = num_idle_threads_;
+    stats.num_parks = num_parks_;
+    stats.num_unparks = num_unparks_;
+    stats.num_spin_hits = num_spin_hits_;
+  }
+  {
+    mutex_lock l(thread_pool_mu_);
+    stats.num_threads = thread_pool_.size();
+  }
+  return stats;
+}
+
 }  // namespace tensorflow
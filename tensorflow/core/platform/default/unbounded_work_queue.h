@@ -15,6 +15,7 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_PLATFORM_DEFAULT_UNBOUNDED_WORK_QUEUE_H_
 #define TENSORFLOW_CORE_PLATFORM_DEFAULT_UNBOUNDED_WORK_QUEUE_H_
 
+#include <atomic>
 #include <deque>
 #include <memory>
 #include <vector>
@@ -34,12 +35,31 @@ namespace tensorflow {
 // is made. This mechanism is recommended in situations where short-lived
 // threads are created repeatedly, to avoid the overhead and memory
 // fragmentation that can result from excessive thread creation.
+//
+// If `adaptive_spinning` is true, an idle thread spins for a while before it
+// parks, when the work arrives often enough for the next item to be likely
+// before the spin ends. The spin lasts about twice the recent average time
+// between two items, and the threads park right away when the work is sparse,
+// so that they leave the cores to the other pools of the host.
 class UnboundedWorkQueue {
  public:
   UnboundedWorkQueue(Env* env, const string& thread_name,
-                     const ThreadOptions& thread_options = {});
+                     const ThreadOptions& thread_options = {},
+                     bool adaptive_spinning = false);
   ~UnboundedWorkQueue();
 
+  // The state and counts of the queue since it was created.
+  struct Stats {
+    size_t queue_length = 0;
+    size_t num_threads = 0;
+    size_t num_idle_threads = 0;
+    // The number of times a thread waited for work, and was woken up.
+    uint64 num_parks = 0;
+    uint64 num_unparks = 0;
+    // The number of items a spinning thread picked up without parking.
+    uint64 num_spin_hits = 0;
+  };
+
   using WorkFunction = std::function<void()>;
 
   // Schedule `fn` on a thread.  `fn` may perform blocking work, so if all the
@@ -47,17 +67,40 @@ class UnboundedWorkQueue {
   // will be added to the thread pool managed by this work queue.
   void Schedule(WorkFunction fn);
 
+  Stats GetStats();
+
  private:
   void PooledThreadFunc();
 
+  // Spins until an item is queued or the spin time derived from the arrival
+  // rate is over.
+  void SpinForWork();
+
+  // Waits for an item, and moves it to `fn`. Returns false if the queue was
+  // cancelled.
+  bool TakeWork(mutex_lock* l, WorkFunction* fn)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(work_queue_mu_);
+
   Env* const env_;  // Not owned.
   const string thread_name_;
   const ThreadOptions thread_options_;
+  const bool adaptive_spinning_;
   mutex work_queue_mu_;
   condition_variable work_queue_cv_ TF_GUARDED_BY(work_queue_mu_);
   size_t num_idle_threads_ TF_GUARDED_BY(work_queue_mu_) = 0;
+  // The idle threads which are spinning rather than waiting on
+  // `work_queue_cv_`.
+  size_t num_spinning_threads_ TF_GUARDED_BY(work_queue_mu_) = 0;
   bool cancelled_ TF_GUARDED_BY(work_queue_mu_) = false;
   std::deque<WorkFunction> work_queue_ TF_GUARDED_BY(work_queue_mu_);
+  uint64 last_schedule_nanos_ TF_GUARDED_BY(work_queue_mu_) = 0;
+  uint64 num_parks_ TF_GUARDED_BY(work_queue_mu_) = 0;
+  uint64 num_unparks_ TF_GUARDED_BY(work_queue_mu_) = 0;
+  uint64 num_spin_hits_ TF_GUARDED_BY(work_queue_mu_) = 0;
+  // Written with `work_queue_mu_` held, and polled by the spinning threads
+  // without it.
+  std::atomic<size_t> queue_length_{0};
+  std::atomic<uint64> average_interarrival_nanos_{0};
   mutex thread_pool_mu_;
   std::vector<std::unique_ptr<Thread>> thread_pool_
       TF_GUARDED_BY(thread_pool_mu_);
@@ -466,6 +466,9 @@ struct ThreadOptions {
   /// Guard area size to use near thread stacks to use (in bytes)
   size_t guard_size = 0;  // 0: use system default value
   int numa_node = port::kNUMANoAffinity;
+  /// If not empty, the ids of the CPUs the thread may run on, e.g. one of the
+  /// disjoint sets returned by thread::PartitionSchedulableCPUs().
+  std::vector<int> cpu_set;
 };
 
 /// A utility routine: copy contents of `src` in file system `src_fs`
@@ -17,10 +17,14 @@ limitations under the License.
 
 #define EIGEN_USE_THREADS
 
+#include <algorithm>
+#include <atomic>
+
 #include "absl/types/optional.h"
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/platform/blocking_counter.h"
 #include "tensorflow/core/platform/context.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/denormal.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/mutex.h"
@@ -31,12 +35,47 @@ limitations under the License.
 namespace tensorflow {
 namespace thread {
 
+// The task counts of a pool. The counts of executed tasks are kept per worker
+// thread, so that the workers don't contend on them.
+struct ThreadPoolCounters {
+  struct alignas(64) WorkerCounts {
+    std::atomic<int64> num_executed{0};
+    std::atomic<int64> num_stolen{0};
+  };
+
+  explicit ThreadPoolCounters(int num_threads)
+      : num_workers(num_threads), workers(new WorkerCounts[num_threads]) {}
+
+  std::atomic<int64> num_scheduled{0};
+  // Tasks the pool ran on the scheduling thread, because its queues were full.
+  std::atomic<int64> num_executed_inline{0};
+  std::atomic<int> next_worker{0};
+  const int num_workers;
+  std::unique_ptr<WorkerCounts[]> workers;
+};
+
+namespace {
+
+// The counters of the pool the current thread is a worker of, and its index.
+thread_local ThreadPoolCounters* current_pool_counters = nullptr;
+thread_local int current_worker = -1;
+
+// Increments a counter only the current thread writes to.
+void IncrementOwnCounter(std::atomic<int64>* counter) {
+  counter->store(counter->load(std::memory_order_relaxed) + 1,
+                 std::memory_order_relaxed);
+}
+
+}  // namespace
+
 struct EigenEnvironment {
   typedef Thread EnvThread;
   struct TaskImpl {
     std::function<void()> f;
     Context context;
     uint64 trace_id;
+    // The worker which scheduled the task, or -1 if it is not a worker.
+    int scheduling_worker;
   };
   struct Task {
     std::unique_ptr<TaskImpl> f;
@@ -45,12 +84,17 @@ struct EigenEnvironment {
   Env* const env_;
   const ThreadOptions thread_options_;
   const string name_;
+  ThreadPoolCounters* const counters_;  // Not owned.
 
   EigenEnvironment(Env* env, const ThreadOptions& thread_options,
-                   const string& name)
-      : env_(env), thread_options_(thread_options), name_(name) {}
+                   const string& name, ThreadPoolCounters* counters)
+      : env_(env),
+        thread_options_(thread_options),
+        name_(name),
+        counters_(counters) {}
 
   EnvThread* CreateThread(std::function<void()> f) {
+    const int worker = counters_->next_worker.fetch_add(1);
     return env_->StartThread(thread_options_, name_, [=]() {
       // Set the processor flag to flush denormals to zero.
       port::ScopedFlushDenormal flush;
@@ -59,26 +103,53 @@ struct EigenEnvironment {
       if (thread_options_.numa_node != port::kNUMANoAffinity) {
         port::NUMASetThreadNodeAffinity(thread_options_.numa_node);
       }
+      if (!thread_options_.cpu_set.empty() &&
+          !port::SetThreadCPUAffinity(thread_options_.cpu_set)) {
+        LOG(WARNING) << "Could not pin a thread of " << name_
+                     << " to its CPU set.";
+      }
+      if (worker < counters_->num_workers) {
+        current_pool_counters = counters_;
+        current_worker = worker;
+      }
       f();
     });
   }
 
+  // Returns the index of the current thread in the pool, or -1 if it is not a
+  // worker of the pool.
+  int CurrentWorker() const {
+    return current_pool_counters == counters_ ? current_worker : -1;
+  }
+
   Task CreateTask(std::function<void()> f) {
     uint64 id = 0;
     if (tracing::EventCollector::IsEnabled()) {
       id = tracing::GetUniqueArg();
       tracing::RecordEvent(tracing::EventCategory::kScheduleClosure, id);
     }
+    counters_->num_scheduled.fetch_add(1, std::memory_order_relaxed);
     return Task{
         std::unique_ptr<TaskImpl>(new TaskImpl{
             std::move(f),
             Context(ContextKind::kThread),
             id,
+            CurrentWorker(),
         }),
     };
   }
 
   void ExecuteTask(const Task& t) {
+    const int worker = CurrentWorker();
+    if (worker >= 0) {
+      ThreadPoolCounters::WorkerCounts& counts = counters_->workers[worker];
+      IncrementOwnCounter(&counts.num_executed);
+      if (t.f->scheduling_worker >= 0 && t.f->scheduling_worker != worker) {
+        IncrementOwnCounter(&counts.num_stolen);
+      }
+    } else {
+      counters_->num_executed_inline.fetch_add(1, std::memory_order_relaxed);
+    }
     WithContext wc(t.f->context);
     tracing::ScopedRegion region(tracing::EventCategory::kRunClosure,
                                  t.f->trace_id);
@@ -97,9 +168,10 @@ ThreadPool::ThreadPool(Env* env, const ThreadOptions& thread_options,
                        const string& name, int num_threads,
                        bool low_latency_hint, Eigen::Allocator* allocator) {
   CHECK_GE(num_threads, 1);
+  counters_.reset(new ThreadPoolCounters(num_threads));
   eigen_threadpool_.reset(new Eigen::ThreadPoolTempl<EigenEnvironment>(
       num_threads, low_latency_hint,
-      EigenEnvironment(env, thread_options, "tf_" + name)));
+      EigenEnvironment(env, thread_options, "tf_" + name, counters_.get())));
   underlying_threadpool_ = eigen_threadpool_.get();
   threadpool_device_.reset(new Eigen::ThreadPoolDevice(underlying_threadpool_,
                                                        num_threads, allocator));
@@ -263,9 +335,56 @@ void ThreadPool::SetStealPartitions(
   eigen_threadpool_->SetStealPartitions(partitions);
 }
 
+ThreadPool::Stats ThreadPool::GetStats() const {
+  Stats stats;
+  if (counters_ == nullptr) return stats;
+  int64 num_executed =
+      counters_->num_executed_inline.load(std::memory_order_relaxed);
+  for (int i = 0; i < counters_->num_workers; ++i) {
+    num_executed +=
+        counters_->workers[i].num_executed.load(std::memory_order_relaxed);
+    stats.num_stolen +=
+        counters_->workers[i].num_stolen.load(std::memory_order_relaxed);
+  }
+  stats.num_scheduled =
+      counters_->num_scheduled.load(std::memory_order_relaxed);
+  // The counts are read one by one, while the workers run.
+  stats.queue_length = std::max<int64>(stats.num_scheduled - num_executed, 0);
+  return stats;
+}
+
 Eigen::ThreadPoolInterface* ThreadPool::AsEigenThreadPool() const {
   DCHECK(underlying_threadpool_ != nullptr);
   return underlying_threadpool_;
 }
+
+std::vector<std::vector<int>> PartitionSchedulableCPUs(
+    const std::vector<int>& weights) {
+  std::vector<std::vector<int>> partitions(weights.size());
+  const std::vector<int> cpus = port::SchedulableCPUs();
+  // Without a CPU for each partition, the pools are left unpinned.
+  if (cpus.size() < weights.size()) return partitions;
+
+  int64 total_weight = 0;
+  for (int weight : weights) {
+    CHECK_GT(weight, 0);
+    total_weight += weight;
+  }
+  // Each partition gets one CPU, and a share of the others in proportion to
+  // its weight.
+  const int64 num_shared = cpus.size() - weights.size();
+  int64 cumulative_weight = 0;
+  int64 num_shared_assigned = 0;
+  auto next_cpu = cpus.begin();
+  for (size_t i = 0; i < weights.size(); ++i) {
+    cumulative_weight += weights[i];
+    const int64 shared_end = num_shared * cumulative_weight / total_weight;
+    const int64 size = 1 + shared_end - num_shared_assigned;
+    partitions[i].assign(next_cpu, next_cpu + size);
+    next_cpu += size;
+    num_shared_assigned = shared_end;
+  }
+  return partitions;
+}
 }  // namespace thread
 }  // namespace tensorflow
@@ -18,6 +18,7 @@ limitations under the License.
 
 #include <functional>
 #include <memory>
+#include <vector>
 
 #include "absl/types/optional.h"
 #include "tensorflow/core/platform/env.h"
@@ -38,6 +39,7 @@ namespace tensorflow {
 namespace thread {
 
 struct EigenEnvironment;
+struct ThreadPoolCounters;
 
 class ThreadPool {
  public:
@@ -138,6 +140,20 @@ class ThreadPool {
   // Schedules fn() for execution in the pool of threads.
   void Schedule(std::function<void()> fn);
 
+  // The task counts of the pool since it was created.
+  struct Stats {
+    // The number of tasks scheduled.
+    int64 num_scheduled = 0;
+    // The number of tasks scheduled but not started yet.
+    int64 queue_length = 0;
+    // The number of tasks a worker scheduled and another worker ran.
+    int64 num_stolen = 0;
+  };
+
+  // Returns the task counts of the pool. They are all 0 for a pool wrapping a
+  // user_threadpool.
+  Stats GetStats() const;
+
   void SetStealPartitions(
       const std::vector<std::pair<unsigned, unsigned>>& partitions);
 
@@ -227,6 +243,8 @@ class ThreadPool {
       const int64 total, const int64 block_size,
       const std::function<void(int64, int64)>& fn);
 
+  // Outlives eigen_threadpool_, whose environment updates the counts.
+  std::unique_ptr<ThreadPoolCounters> counters_;
   // underlying_threadpool_ is the user_threadpool if user_threadpool is
   // provided in the constructor. Otherwise it is the eigen_threadpool_.
   Eigen::ThreadPoolInterface* underlying_threadpool_;
@@ -237,6 +255,17 @@ class ThreadPool {
   TF_DISALLOW_COPY_AND_ASSIGN(ThreadPool);
 };
 
+// Partitions the CPUs the process may run on into one disjoint set per entry
+// of `weights`, with sizes roughly proportional to the weights, so that pools
+// sharing a host (e.g. the inter-op, intra-op and tf.data pools) can be pinned
+// to their own cores through ThreadOptions::cpu_set. Each set holds at least
+// one CPU. The sets are all empty, i.e. unpinned, if there are fewer CPUs than
+// sets or the CPUs cannot be determined.
+//
+// REQUIRES: all the weights are > 0
+std::vector<std::vector<int>> PartitionSchedulableCPUs(
+    const std::vector<int>& weights);
+
 }  // namespace thread
 }  // namespace tensorflow
 
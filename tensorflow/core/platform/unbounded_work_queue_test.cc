@@ -92,6 +92,38 @@ TEST_F(UnboundedWorkQueueTest, NestedClosures) {
   BlockUntilClosuresDone(num_closures * num_closures + num_closures);
 }
 
+TEST(UnboundedWorkQueueStatsTest, AdaptiveSpinning) {
+  UnboundedWorkQueue work_queue(Env::Default(), "test", {},
+                                /*adaptive_spinning=*/true);
+  constexpr int num_closures = 1000;
+  // Schedule the closures one at a time, often enough for the idle thread to
+  // spin rather than park.
+  for (int i = 0; i < num_closures; ++i) {
+    BlockingCounter counter(1);
+    work_queue.Schedule([&counter]() { counter.DecrementCount(); });
+    counter.Wait();
+  }
+  const UnboundedWorkQueue::Stats stats = work_queue.GetStats();
+  EXPECT_EQ(stats.queue_length, 0);
+  EXPECT_GE(stats.num_threads, 1);
+  EXPECT_LE(stats.num_unparks, stats.num_parks);
+  EXPECT_LE(stats.num_spin_hits, num_closures);
+}
+
+TEST(UnboundedWorkQueueStatsTest, NoSpinningByDefault) {
+  UnboundedWorkQueue work_queue(Env::Default(), "test");
+  constexpr int num_closures = 10;
+  BlockingCounter counter(num_closures);
+  for (int i = 0; i < num_closures; ++i) {
+    work_queue.Schedule([&counter]() { counter.DecrementCount(); });
+  }
+  counter.Wait();
+  const UnboundedWorkQueue::Stats stats = work_queue.GetStats();
+  EXPECT_EQ(stats.queue_length, 0);
+  EXPECT_LE(stats.num_threads, num_closures);
+  EXPECT_EQ(stats.num_spin_hits, 0);
+}
+
 TEST_F(UnboundedWorkQueueTest, RacyDestructor) {
   constexpr int num_closures = 100;
   // Run `num_closures` closures, then delete `work_queue_`.
@@ -63,6 +63,10 @@ int NumSchedulableCPUs() {
   return system_info.dwNumberOfProcessors;
 }
 
+std::vector<int> SchedulableCPUs() { return {}; }
+
+bool SetThreadCPUAffinity(const std::vector<int>& cpus) { return false; }
+
 int MaxParallelism() { return NumSchedulableCPUs(); }
 
 int MaxParallelism(int numa_node) {
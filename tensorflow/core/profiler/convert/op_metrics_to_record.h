@@ -16,9 +16,11 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_PROFILER_CONVERT_OP_METRICS_TO_RECORD_H_
 #define TENSORFLOW_CORE_PROFILER_CONVERT_OP_METRICS_TO_RECORD_H_
 
+#include <algorithm>
 #include <vector>
 
 #include "tensorflow/core/profiler/protobuf/op_metrics.pb.h"
+#include "tensorflow/core/profiler/protobuf/op_stats.pb.h"
 #include "tensorflow/core/profiler/utils/math_utils.h"
 #include "tensorflow/core/profiler/utils/time_utils.h"
 
@@ -82,9 +84,9 @@ inline void SetRankAndHostTimeFractions(double total_time_us,
 
 template <typename Record>
 inline void SetRooflineMetrics(const OpMetrics& metrics,
-                               double ridge_point_operational_intensity,
-                               Record* record) {
+                               const PerfEnv& perf_env, Record* record) {
   using ::tensorflow::profiler::PicosToNanos;
+  // In GFLOP/s and GB/s.
   record->set_measured_flop_rate(
       SafeDivide(metrics.flops(), PicosToNanos(metrics.time_ps())));
   record->set_measured_memory_bw(
@@ -93,10 +95,22 @@ inline void SetRooflineMetrics(const OpMetrics& metrics,
       SafeDivide(metrics.flops(), metrics.bytes_accessed()));
   record->set_bound_by((metrics.bytes_accessed() != 0)
                            ? ((record->operational_intensity() >=
-                               ridge_point_operational_intensity)
+                               perf_env.ridge_point())
                                   ? "Compute"
                                   : "Memory")
                            : ((metrics.flops() != 0) ? "Compute" : "Unknown"));
+  record->set_flop_rate_fraction_of_peak(
+      SafeDivide(record->measured_flop_rate(),
+                 perf_env.peak_tera_flops_per_second() * 1000));
+  record->set_memory_bw_fraction_of_peak(
+      SafeDivide(record->measured_memory_bw(),
+                 perf_env.peak_hbm_bw_giga_bytes_per_second()));
+  // Below the ridge point, the attainable FLOP rate is the operational
+  // intensity times the peak bandwidth, hence a FLOP rate fraction of the
+  // attainable rate equal to the bandwidth fraction of the peak.
+  record->set_roofline_efficiency(std::max(
+      record->flop_rate_fraction_of_peak(),
+      record->memory_bw_fraction_of_peak()));
 }
 
 }  // namespace profiler
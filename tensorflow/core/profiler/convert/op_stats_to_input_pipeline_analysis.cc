@@ -18,9 +18,12 @@ limitations under the License.
 #include <math.h>
 
 #include <algorithm>
+#include <string>
+#include <utility>
 #include <vector>
 
 #include "google/protobuf/any.pb.h"
+#include "absl/algorithm/container.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/strings/match.h"
 #include "absl/strings/str_cat.h"
@@ -330,6 +333,44 @@ InputOpDetails ConvertOpMetricsToInputOpDetails(const OpMetrics& op_metrics,
   return details;
 }
 
+// Aggregates the self time of the dataset ops by tf.data transformation, as
+// the iterators of a transformation are named after their position in the
+// pipeline (e.g. "Iterator::Batch::Map" and "Iterator::Interleave::Map").
+void ComputeInputTransformationDetails(const InputOpMetrics& input_op_metrics,
+                                       InputPipelineAnalysisResult* result) {
+  absl::flat_hash_map<std::string, InputTransformationDetails> details_map;
+  for (const OpMetrics* op_metrics : input_op_metrics.input_op_metrics) {
+    if (!IsDatasetOp(op_metrics->category())) continue;
+    std::string transformation = IteratorName(op_metrics->name());
+    InputTransformationDetails& details = details_map[transformation];
+    if (details.num_iterators() == 0) {
+      details.set_transformation(transformation);
+      details.set_category(InputOpCategoryString(
+          CategorizeInputOp(op_metrics->name(), op_metrics->category())));
+    }
+    details.set_num_iterators(details.num_iterators() + 1);
+    details.set_count(details.count() + op_metrics->occurrences());
+    details.set_self_time_in_ms(details.self_time_in_ms() +
+                                PicosToMillis(op_metrics->self_time_ps()));
+  }
+
+  std::vector<InputTransformationDetails*> sorted_details;
+  for (auto& transformation_and_details : details_map) {
+    InputTransformationDetails& details = transformation_and_details.second;
+    details.set_self_time_in_percent(
+        100.0 * SafeDivide(details.self_time_in_ms(),
+                           PicosToMillis(input_op_metrics.input_op_time_ps)));
+    sorted_details.push_back(&details);
+  }
+  absl::c_sort(sorted_details, [](const InputTransformationDetails* a,
+                                  const InputTransformationDetails* b) {
+    return a->self_time_in_ms() > b->self_time_in_ms();
+  });
+  for (InputTransformationDetails* details : sorted_details) {
+    *result->add_input_transformation_details() = std::move(*details);
+  }
+}
+
 // Returns the ratio of the host-to-device time in each step to the step-time.
 double RatioOfHostToDeviceTimeToStepTime(
     const OpMetricsDb& host_tf_metrics_db,
@@ -448,6 +489,7 @@ void GenerateHostResult(const OpMetricsDb& host_tf_metrics_db,
     aggregated_input_op_times_us[category] +=
         PicosToMicros(op_metrics->self_time_ps());
   }
+  ComputeInputTransformationDetails(input_op_metrics, result);
 
   double enqueue_time_us =
       aggregated_input_op_times_us[InputOpCategory::kEnqueue];
@@ -576,6 +618,16 @@ InputPipelineAnalysisResult ConvertOpStatsToInputPipelineAnalysis(
   *recommendation.mutable_summary_next_step() =
       GetSummaryNextStep(bottleneck_analysis.input_classification(),
                          result.input_time_breakdown());
+  if (!result.input_transformation_details().empty()) {
+    const InputTransformationDetails& bottleneck =
+        result.input_transformation_details(0);
+    *recommendation.add_details() = absl::StrFormat(
+        "Bottleneck transformation: %s takes %.1f%% of the input processing "
+        "time (%s). The time an iterator waits for a buffer it consumes (e.g. "
+        "from prefetch or a parallel map) counts as its own.",
+        bottleneck.transformation(), bottleneck.self_time_in_percent(),
+        bottleneck.category());
+  }
 
   *result.mutable_recommendation() = recommendation;
   return result;
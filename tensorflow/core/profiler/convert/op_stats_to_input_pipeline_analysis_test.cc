@@ -0,0 +1,88 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/profiler/convert/op_stats_to_input_pipeline_analysis.h"
+
+#include "absl/strings/string_view.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/profiler/protobuf/input_pipeline.pb.h"
+#include "tensorflow/core/profiler/protobuf/op_metrics.pb.h"
+#include "tensorflow/core/profiler/utils/tf_op_utils.h"
+#include "tensorflow/core/profiler/utils/time_utils.h"
+
+namespace tensorflow {
+namespace profiler {
+namespace {
+
+void AddDatasetOp(absl::string_view name, uint32 occurrences,
+                  uint64 self_time_ms, OpMetricsDb* db) {
+  OpMetrics* op_metrics = db->add_metrics_db();
+  op_metrics->set_name(std::string(name));
+  op_metrics->set_category(std::string(kDatasetOp));
+  op_metrics->set_occurrences(occurrences);
+  op_metrics->set_time_ps(MillisToPicos(self_time_ms));
+  op_metrics->set_self_time_ps(MillisToPicos(self_time_ms));
+}
+
+TEST(OpStatsToInputPipelineAnalysisTest, InputTransformationDetails) {
+  OpMetricsDb db;
+  AddDatasetOp("Iterator::Batch", /*occurrences=*/2, /*self_time_ms=*/1, &db);
+  AddDatasetOp("Iterator::Batch::Map", 10, 3, &db);
+  AddDatasetOp("Iterator::Interleave::Map", 5, 2, &db);
+  AddDatasetOp("Iterator::Batch::Map::TFRecord", 10, 4, &db);
+
+  InputPipelineAnalysisResult result;
+  GenerateHostResult(db, &result);
+
+  ASSERT_EQ(result.input_transformation_details_size(), 3);
+  const InputTransformationDetails& map =
+      result.input_transformation_details(0);
+  EXPECT_EQ(map.transformation(), "Map");
+  EXPECT_EQ(map.num_iterators(), 2);
+  EXPECT_EQ(map.count(), 15);
+  EXPECT_DOUBLE_EQ(map.self_time_in_ms(), 5.0);
+  EXPECT_DOUBLE_EQ(map.self_time_in_percent(), 50.0);
+  EXPECT_EQ(map.category(), "Preprocessing");
+
+  const InputTransformationDetails& tfrecord =
+      result.input_transformation_details(1);
+  EXPECT_EQ(tfrecord.transformation(), "TFRecord");
+  EXPECT_EQ(tfrecord.num_iterators(), 1);
+  EXPECT_EQ(tfrecord.count(), 10);
+  EXPECT_DOUBLE_EQ(tfrecord.self_time_in_ms(), 4.0);
+  EXPECT_DOUBLE_EQ(tfrecord.self_time_in_percent(), 40.0);
+  EXPECT_EQ(tfrecord.category(), "Demanded file read");
+
+  const InputTransformationDetails& batch =
+      result.input_transformation_details(2);
+  EXPECT_EQ(batch.transformation(), "Batch");
+  EXPECT_EQ(batch.num_iterators(), 1);
+  EXPECT_EQ(batch.count(), 2);
+  EXPECT_DOUBLE_EQ(batch.self_time_in_ms(), 1.0);
+  EXPECT_DOUBLE_EQ(batch.self_time_in_percent(), 10.0);
+  EXPECT_EQ(batch.category(), "Preprocessing");
+}
+
+TEST(OpStatsToInputPipelineAnalysisTest, NoDatasetOps) {
+  OpMetricsDb db;
+  InputPipelineAnalysisResult result;
+  GenerateHostResult(db, &result);
+  EXPECT_EQ(result.input_transformation_details_size(), 0);
+}
+
+}  // namespace
+}  // namespace profiler
+}  // namespace tensorflow
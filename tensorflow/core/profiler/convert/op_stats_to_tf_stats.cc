@@ -29,24 +29,28 @@ namespace tensorflow {
 namespace profiler {
 namespace {
 
-TfStatsRecord ConvertOpMetricsToTfStatsRecord(
-    bool on_device, const OpMetrics& metrics,
-    double ridge_point_operational_intensity) {
+// A GPU op whose kernels last less than this on average is considered bound by
+// the kernel launches, which take a few micro-seconds each.
+constexpr double kMaxLaunchBoundAvgKernelDurationUs = 5.0;
+
+TfStatsRecord ConvertOpMetricsToTfStatsRecord(bool on_device,
+                                              const OpMetrics& metrics,
+                                              const PerfEnv& perf_env) {
   TfStatsRecord record;
   record.set_host_or_device(on_device ? "Device" : "Host");
   record.set_is_eager(metrics.is_eager());
   record.set_op_type(metrics.category());
   record.set_op_name(metrics.name());
   SetExecutionTimes(metrics, &record);
-  SetRooflineMetrics(metrics, ridge_point_operational_intensity, &record);
+  SetRooflineMetrics(metrics, perf_env, &record);
   return record;
 }
 
 TfStatsTable GenerateTfStatsTable(
     const OpMetricsDb& host_tf_metrics_db,
     const OpMetricsDb& device_tf_metrics_db,
-    const KernelStatsByOpName& kernel_stats_by_op_name, double ridge_point,
-    bool exclude_idle) {
+    const KernelStatsByOpName& kernel_stats_by_op_name,
+    const PerfEnv& perf_env, bool exclude_idle) {
   TfStatsTable tf_stats_table;
   TfStatsRecord sentinel;
   sentinel.set_rank(0);
@@ -64,13 +68,21 @@ TfStatsTable GenerateTfStatsTable(
     if (exclude_idle && IsIdleOp(*metrics)) continue;
     TfStatsRecord* record = tf_stats_table.add_tf_stats_record();
     *record = ConvertOpMetricsToTfStatsRecord(
-        /*on_device=*/true, *metrics, ridge_point);
-    // Compute TensorCore utilization only on device side.
+        /*on_device=*/true, *metrics, perf_env);
+    // Compute TensorCore utilization and kernel durations only on device side.
     auto iter = kernel_stats_by_op_name.find(record->op_name());
     if (iter != kernel_stats_by_op_name.end()) {
       record->set_gpu_tensorcore_utilization(
           SafeDivide(iter->second.tensor_core_duration_ns,
                      iter->second.total_duration_ns));
+      record->set_gpu_avg_kernel_duration_in_us(
+          SafeDivide(NanosToMicros(iter->second.total_duration_ns),
+                     iter->second.occurrences));
+      if (iter->second.occurrences > 0 &&
+          record->gpu_avg_kernel_duration_in_us() <
+              kMaxLaunchBoundAvgKernelDurationUs) {
+        record->set_bound_by("Launch");
+      }
     } else {
       record->set_gpu_tensorcore_utilization(0.0);
     }
@@ -89,7 +101,7 @@ TfStatsTable GenerateTfStatsTable(
     if (exclude_idle && IsIdleOp(*metrics)) continue;
     TfStatsRecord* record = tf_stats_table.add_tf_stats_record();
     *record = ConvertOpMetricsToTfStatsRecord(
-        /*on_device=*/false, *metrics, ridge_point);
+        /*on_device=*/false, *metrics, perf_env);
     // Host side TensorCore utilization is always 0.0
     record->set_gpu_tensorcore_utilization(0.0);
     SetRankAndHostTimeFractions(total_host_time_us, *prev_record, record);
@@ -104,16 +116,15 @@ TfStatsDatabase ConvertOpStatsToTfStats(const OpStats& op_stats) {
   const OpMetricsDb& host_tf_metrics_db = op_stats.host_op_metrics_db();
   OpMetricsDb device_tf_metrics_db =
       CreateTfMetricsDbFromDeviceOpMetricsDb(op_stats.device_op_metrics_db());
-  double ridge_point = op_stats.perf_env().ridge_point();
   KernelStatsByOpName kernel_stats_by_op_name =
       GroupKernelReportsByOpName(op_stats.kernel_stats_db());
   TfStatsDatabase tf_stats_db;
   *tf_stats_db.mutable_with_idle() = GenerateTfStatsTable(
       host_tf_metrics_db, device_tf_metrics_db, kernel_stats_by_op_name,
-      ridge_point, /*exclude_idle=*/false);
+      op_stats.perf_env(), /*exclude_idle=*/false);
   *tf_stats_db.mutable_without_idle() = GenerateTfStatsTable(
       host_tf_metrics_db, device_tf_metrics_db, kernel_stats_by_op_name,
-      ridge_point, /*exclude_idle=*/true);
+      op_stats.perf_env(), /*exclude_idle=*/true);
   tf_stats_db.set_device_type(op_stats.run_environment().device_type());
   return tf_stats_db;
 }
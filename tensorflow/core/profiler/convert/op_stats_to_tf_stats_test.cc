@@ -159,6 +159,51 @@ block_z:1)MULTI";
             record_2.total_self_time_in_us());
 }
 
+TEST(OpStatsToTfStats, LaunchBoundGpuTfStats) {
+  // TfOp1 launches many short kernels; TfOp2 launches a long one.
+  static constexpr char kTfOp1[] = "TfOp1";
+  static constexpr char kTfOp2[] = "TfOp2";
+  static constexpr char kKernel1[] = "kernel1";
+  static constexpr char kKernel2[] = "kernel2";
+  constexpr int64 kKernel1DurationNs = 2000;
+  constexpr int64 kKernel2DurationNs = 50000;
+  const std::string kKernelDetails = R"MULTI(registers_per_thread:32
+grid_x:1
+block_x:32)MULTI";
+
+  XSpace space;
+  XPlaneBuilder device_plane(
+      GetOrCreateGpuXPlane(&space, /*device_ordinal=*/0));
+  XLineBuilder stream = device_plane.GetOrCreateLine(/*line_id=*/10);
+  for (int i = 0; i < 4; ++i) {
+    AddTensorFlowOpEventWithKernelDetails(
+        absl::StrCat(kTfOp1, ":", kTfOp1), 100000 + i * 10000,
+        kKernel1DurationNs, /*on_device=*/true, kKernel1, kKernelDetails,
+        &device_plane, &stream);
+  }
+  AddTensorFlowOpEventWithKernelDetails(
+      absl::StrCat(kTfOp2, ":", kTfOp2), 200000, kKernel2DurationNs,
+      /*on_device=*/true, kKernel2, kKernelDetails, &device_plane, &stream);
+
+  const OpStats op_stats =
+      ConvertXSpaceToOpStats(space, {OP_METRICS_DB, KERNEL_STATS_DB});
+  const TfStatsDatabase tf_stats = ConvertOpStatsToTfStats(op_stats);
+
+  // TfOp2, TfOp1
+  ASSERT_EQ(2, tf_stats.without_idle().tf_stats_record_size());
+  const TfStatsRecord& record_0 = tf_stats.without_idle().tf_stats_record(0);
+  EXPECT_EQ(kTfOp2, record_0.op_name());
+  EXPECT_DOUBLE_EQ(NanosToMicros(kKernel2DurationNs),
+                   record_0.gpu_avg_kernel_duration_in_us());
+  EXPECT_NE("Launch", record_0.bound_by());
+
+  const TfStatsRecord& record_1 = tf_stats.without_idle().tf_stats_record(1);
+  EXPECT_EQ(kTfOp1, record_1.op_name());
+  EXPECT_DOUBLE_EQ(NanosToMicros(kKernel1DurationNs),
+                   record_1.gpu_avg_kernel_duration_in_us());
+  EXPECT_EQ("Launch", record_1.bound_by());
+}
+
 }  // namespace
 }  // namespace profiler
 }  // namespace tensorflow
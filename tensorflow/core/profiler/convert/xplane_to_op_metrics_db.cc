@@ -230,17 +230,28 @@ OpMetricsDb ConvertDeviceTraceXPlaneToOpMetricsDb(
 
       absl::string_view tf_op_full_name;
       bool is_eager;
+      // The costs of the op, when the event carries them (e.g. computed by the
+      // HloCostAnalysis of an XLA op).
+      absl::optional<uint64> flops;
+      absl::optional<uint64> bytes_accessed;
       event.ForEachStat([&](const XStatVisitor& stat) {
         if (stat.Type() == StatType::kLevel0) {
           tf_op_full_name = stat.StrOrRefValue();
         } else if (stat.Type() == StatType::kIsEager) {
           is_eager = stat.IntValue();
+        } else if (stat.Type() == StatType::kFlops) {
+          flops = stat.IntOrUintValue();
+        } else if (stat.Type() == StatType::kBytesAccessed) {
+          bytes_accessed = stat.IntOrUintValue();
         }
       });
       if (tf_op_full_name.empty()) return;
       TfOp tf_op = ParseTfOpFullname(tf_op_full_name);
       TfOpRoofLineCostEstimator::OpRoofLineStats costs;
-      if (tf_op.category != Category::kUnknown) {
+      if (flops.has_value() || bytes_accessed.has_value()) {
+        costs.flops = flops.value_or(0);
+        costs.bytes_accessed = bytes_accessed.value_or(0);
+      } else if (tf_op.category != Category::kUnknown) {
         costs = op_level_cost_estimator.Predict(event);
       }
       device_op_metrics_db_builder.EnterOp(
@@ -171,6 +171,41 @@ TEST(ConvertXPlaneToOpMetricsDb, DeviceOpMetricsDb) {
   EXPECT_EQ(NanosToPicos(0), idle.time_ps());
 }
 
+TEST(ConvertXPlaneToOpMetricsDb, DeviceOpMetricsDbWithCosts) {
+  static constexpr char kTfOp[] = "TfOp";
+  static constexpr char kKernel[] = "kernel";
+  constexpr uint64 kFlops = 1000;
+  constexpr uint64 kBytesAccessed = 2000;
+
+  XSpace xspace;
+  XPlane* xplane = GetOrCreateGpuXPlane(&xspace, /*device_ordinal=*/0);
+  XPlaneBuilder device_plane(xplane);
+  XLineBuilder stream = device_plane.GetOrCreateLine(/*line_id=*/10);
+  XEventBuilder event =
+      stream.AddEvent(*device_plane.GetOrCreateEventMetadata(kKernel));
+  event.SetTimestampNs(100000);
+  event.SetDurationNs(10000);
+  event.ParseAndAddStatValue(*device_plane.GetOrCreateStatMetadata("level 0"),
+                             absl::StrCat(kTfOp, ":", kTfOp));
+  // The costs carried by the event are used over the estimated ones.
+  event.ParseAndAddStatValue(*device_plane.GetOrCreateStatMetadata("flops"),
+                             absl::StrCat(kFlops));
+  event.ParseAndAddStatValue(
+      *device_plane.GetOrCreateStatMetadata("bytes_accessed"),
+      absl::StrCat(kBytesAccessed));
+
+  OpMetricsDb op_metrics = ConvertDeviceTraceXPlaneToOpMetricsDb(
+      *xplane, /*peak_tera_flops_per_second=*/100,
+      /*peak_hbm_bw_giga_bytes_per_second=*/1000);
+
+  // kernel, Idle.
+  ASSERT_EQ(2, op_metrics.metrics_db_size());
+  const OpMetrics& op = op_metrics.metrics_db().at(0);
+  EXPECT_EQ(absl::StrCat(kTfOp, "/", kKernel), op.name());
+  EXPECT_EQ(kFlops, op.flops());
+  EXPECT_EQ(kBytesAccessed, op.bytes_accessed());
+}
+
 }  // namespace
 }  // namespace profiler
 }  // namespace tensorflow
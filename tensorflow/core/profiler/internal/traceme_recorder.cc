@@ -44,6 +44,12 @@ static_assert(ATOMIC_INT_LOCK_FREE == 2, "Assumed atomic<int> was lock free");
 
 namespace {
 
+// The bounds of the thread buffers, set by StartRecording before it enables
+// tracing. 0 for unbounded.
+std::atomic<size_t> g_max_events_per_thread(0);
+std::atomic<TraceMeRecorder::OverflowPolicy> g_overflow_policy(
+    TraceMeRecorder::OverflowPolicy::kDropNew);
+
 // A single-producer single-consumer queue of Events.
 //
 // Implemented as a linked-list of blocks containing numbered slots, with start
@@ -67,13 +73,19 @@ namespace {
 // the new event remains in the queue. Thus, the tracing control thread should
 // call PopAll when tracing stops to remove events created during tracing, but
 // also when tracing starts again to clear any remaining events.
+//
+// Push can bound the size of the queue. It then either drops the new event, or
+// drops the oldest block of events. As the latter moves start_, it is mutually
+// exclusive with PopAll: each side raises its flag before checking the other
+// one's (see TryDropOldestBlock). Push never waits, it drops the new event
+// instead if PopAll is active, while PopAll waits for the block to be dropped.
 class EventQueue {
  public:
   EventQueue()
       : start_block_(new Block{/*start=*/0, /*next=*/nullptr}),
         start_(start_block_->start),
         end_block_(start_block_),
-        end_(start_) {}
+        end_(start_block_->start) {}
 
   // REQUIRES: PopAll() was called since the last Push().
   // Memory should be deallocated and trace events destroyed on destruction.
@@ -83,15 +95,35 @@ class EventQueue {
   ~EventQueue() {
     DCHECK(Empty()) << "EventQueue destroyed without PopAll()";
     delete end_block_;
+    delete spare_block_;
   }
 
-  // Add a new event to the back of the queue. Fast and lock-free.
-  void Push(TraceMeRecorder::Event&& event) {
+  // Add a new event to the back of the queue. Fast and lock-free. If the queue
+  // holds `max_size` events or more (unless 0), the new event or the oldest
+  // events are dropped according to `overflow_policy`.
+  void Push(TraceMeRecorder::Event&& event, size_t max_size,
+            TraceMeRecorder::OverflowPolicy overflow_policy) {
     size_t end = end_.load(std::memory_order_relaxed);
+    if (TF_PREDICT_FALSE(max_size > 0 &&
+                         end - start_.load(std::memory_order_relaxed) >=
+                             max_size)) {
+      if (overflow_policy != TraceMeRecorder::OverflowPolicy::kDropOldest ||
+          !TryDropOldestBlock()) {
+        num_dropped_.fetch_add(1, std::memory_order_relaxed);
+        return;
+      }
+    }
     new (&end_block_->events[end++ - end_block_->start].event)
         TraceMeRecorder::Event(std::move(event));
     if (TF_PREDICT_FALSE(end - end_block_->start == Block::kNumSlots)) {
-      auto* new_block = new Block{end, nullptr};
+      Block* new_block = spare_block_;
+      if (new_block != nullptr) {
+        spare_block_ = nullptr;
+        new_block->start = end;
+        new_block->next = nullptr;
+      } else {
+        new_block = new Block{end, nullptr};
+      }
       end_block_->next = new_block;
       end_block_ = new_block;
     }
@@ -104,42 +136,86 @@ class EventQueue {
   // PopAll is only called from ThreadLocalRecorder::Clear, which in turn is
   // only called while holding TraceMeRecorder::Mutex, so PopAll has a single
   // caller at a time.
-  std::vector<TraceMeRecorder::Event> PopAll() {
+  // Also returns the number of events dropped since the previous PopAll.
+  std::vector<TraceMeRecorder::Event> PopAll(uint64* num_dropped) {
+    // Exclude TryDropOldestBlock, see there.
+    popping_.store(true, std::memory_order_seq_cst);
+    while (dropping_.load(std::memory_order_seq_cst)) {
+    }
     // Read index before contents.
     size_t end = end_.load(std::memory_order_acquire);
+    size_t start = start_.load(std::memory_order_relaxed);
     std::vector<TraceMeRecorder::Event> result;
-    result.reserve(end - start_);
-    while (start_ != end) {
-      result.emplace_back(Pop());
+    result.reserve(end - start);
+    while (start != end) {
+      result.emplace_back(Pop(&start));
     }
+    start_.store(start, std::memory_order_relaxed);
+    *num_dropped = num_dropped_.exchange(0, std::memory_order_relaxed);
+    popping_.store(false, std::memory_order_release);
     return result;
   }
 
  private:
   // Returns true if the queue is empty at the time of invocation.
   bool Empty() const {
-    return (start_ == end_.load(std::memory_order_acquire));
+    return (start_.load(std::memory_order_relaxed) ==
+            end_.load(std::memory_order_acquire));
   }
 
-  // Remove one event off the front of the queue and return it.
+  // Remove the event at `start` off the front of the queue and return it.
   // REQUIRES: The queue must not be empty.
-  TraceMeRecorder::Event Pop() {
-    DCHECK(!Empty());
+  TraceMeRecorder::Event Pop(size_t* start) {
     // Move the next event into the output.
-    auto& event = start_block_->events[start_++ - start_block_->start].event;
+    auto& event = start_block_->events[(*start)++ - start_block_->start].event;
     TraceMeRecorder::Event out = std::move(event);
     event.~Event();  // Events must be individually destroyed.
     // If we reach the end of a block, we own it and should delete it.
     // The next block is present: end always points to something.
-    if (TF_PREDICT_FALSE(start_ - start_block_->start == Block::kNumSlots)) {
+    if (TF_PREDICT_FALSE(*start - start_block_->start == Block::kNumSlots)) {
       auto* next_block = start_block_->next;
       delete start_block_;
       start_block_ = next_block;
-      DCHECK_EQ(start_, start_block_->start);
+      DCHECK_EQ(*start, start_block_->start);
     }
     return out;
   }
 
+  // Drops the events of the oldest block, unless it is the block being
+  // written. Returns false if PopAll is active, in which case nothing is
+  // dropped and the new event should be. Only called by the producer thread.
+  bool TryDropOldestBlock() {
+    // Both sides raise their flag and then check the other one's, with
+    // sequentially consistent operations, so at most one of them proceeds.
+    dropping_.store(true, std::memory_order_seq_cst);
+    if (popping_.load(std::memory_order_seq_cst)) {
+      dropping_.store(false, std::memory_order_release);
+      return false;
+    }
+    if (start_block_ == end_block_) {
+      // Fill the end block first.
+      dropping_.store(false, std::memory_order_release);
+      return true;
+    }
+    Block* block = start_block_;
+    size_t start = start_.load(std::memory_order_relaxed);
+    size_t block_end = block->start + Block::kNumSlots;
+    for (size_t i = start; i != block_end; ++i) {
+      block->events[i - block->start].event.~Event();
+    }
+    num_dropped_.fetch_add(block_end - start, std::memory_order_relaxed);
+    start_block_ = block->next;
+    start_.store(block_end, std::memory_order_relaxed);
+    dropping_.store(false, std::memory_order_release);
+    // Reused as the next end block.
+    if (spare_block_ == nullptr) {
+      spare_block_ = block;
+    } else {
+      delete block;
+    }
+    return true;
+  }
+
   struct Block {
     // The number of slots in a block is chosen so the block fits in 64 KiB.
     static constexpr size_t kSize = 1 << 16;
@@ -160,12 +236,21 @@ class EventQueue {
 
   static_assert(sizeof(Block) <= Block::kSize, "");
 
-  // Head of list for reading. Only accessed by consumer thread.
+  // Head of list for reading. Accessed by consumer thread, and by producer
+  // thread in TryDropOldestBlock.
   Block* start_block_;
-  size_t start_;
+  std::atomic<size_t> start_;  // Atomic: also read by producer thread.
   // Tail of list for writing. Accessed by producer thread.
   Block* end_block_;
   std::atomic<size_t> end_;  // Atomic: also read by consumer thread.
+  // A block dropped by TryDropOldestBlock, for the next end block. Only
+  // accessed by producer thread.
+  Block* spare_block_ = nullptr;
+
+  // Whether PopAll or TryDropOldestBlock is active.
+  std::atomic<bool> popping_{false};
+  std::atomic<bool> dropping_{false};
+  std::atomic<uint64> num_dropped_{0};
 };
 
 }  // namespace
@@ -190,11 +275,20 @@ class TraceMeRecorder::ThreadLocalRecorder {
   }
 
   // Record is only called from the owner thread.
-  void Record(TraceMeRecorder::Event&& event) { queue_.Push(std::move(event)); }
+  void Record(TraceMeRecorder::Event&& event) {
+    queue_.Push(std::move(event),
+                g_max_events_per_thread.load(std::memory_order_relaxed),
+                g_overflow_policy.load(std::memory_order_relaxed));
+  }
 
   // Clear is called from the control thread when tracing starts/stops, or from
   // the owner thread when it shuts down (see destructor).
-  TraceMeRecorder::ThreadEvents Clear() { return {info_, queue_.PopAll()}; }
+  TraceMeRecorder::ThreadEvents Clear() {
+    TraceMeRecorder::ThreadEvents events;
+    events.thread = info_;
+    events.events = queue_.PopAll(&events.num_dropped_events);
+    return events;
+  }
 
  private:
   TraceMeRecorder::ThreadInfo info_;
@@ -216,7 +310,7 @@ void TraceMeRecorder::UnregisterThread(uint32 tid) {
   auto it = threads_.find(tid);
   if (it != threads_.end()) {
     auto events = it->second->Clear();
-    if (!events.events.empty()) {
+    if (!events.events.empty() || events.num_dropped_events > 0) {
       orphaned_events_.push_back(std::move(events));
     }
     threads_.erase(it);
@@ -233,16 +327,25 @@ TraceMeRecorder::Events TraceMeRecorder::Clear() {
   for (const auto& entry : threads_) {
     auto* recorder = entry.second;
     TraceMeRecorder::ThreadEvents events = recorder->Clear();
-    if (!events.events.empty()) {
+    if (!events.events.empty() || events.num_dropped_events > 0) {
       result.push_back(std::move(events));
     }
   }
   return result;
 }
 
-bool TraceMeRecorder::StartRecording(int level) {
+bool TraceMeRecorder::StartRecording(int level,
+                                     const BufferOptions& options) {
   level = std::max(0, level);
   mutex_lock lock(mutex_);
+  if (internal::g_trace_level.load(std::memory_order_relaxed) !=
+      kTracingDisabled) {
+    return false;
+  }
+  // Published to the recording threads by enabling the tracing below.
+  g_max_events_per_thread.store(options.max_events_per_thread,
+                                std::memory_order_relaxed);
+  g_overflow_policy.store(options.overflow_policy, std::memory_order_relaxed);
   // Change trace_level_ while holding mutex_.
   int expected = kTracingDisabled;
   bool started = internal::g_trace_level.compare_exchange_strong(
@@ -15,6 +15,8 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_PROFILER_INTERNAL_TRACEME_RECORDER_H_
 #define TENSORFLOW_CORE_PROFILER_INTERNAL_TRACEME_RECORDER_H_
 
+#include <stddef.h>
+
 #include <atomic>
 #include <string>
 #include <vector>
@@ -47,6 +49,9 @@ TF_EXPORT extern std::atomic<int> g_trace_level;
 // events. TraceMe::ActivityStart records begin events, and TraceMe::ActivityEnd
 // records end events. The profiler then stops the recorder and finds start/end
 // pairs. (Unpaired start/end events are discarded at that point).
+//
+// The events of each thread are buffered without locks, and the memory of the
+// buffers can be bounded (see BufferOptions) for tracing to be left on.
 class TraceMeRecorder {
  public:
   // An Event is either the start of a TraceMe, the end of a TraceMe, or both.
@@ -64,13 +69,36 @@ class TraceMeRecorder {
   struct ThreadEvents {
     ThreadInfo thread;
     std::vector<Event> events;
+    // The number of events of the thread dropped by its bounded buffer.
+    uint64 num_dropped_events = 0;
   };
   using Events = std::vector<ThreadEvents>;
 
+  // What a thread does with its new events once its buffer is full.
+  enum class OverflowPolicy {
+    // The new events are dropped, the buffer keeps the first events.
+    kDropNew,
+    // The oldest events are dropped, the buffer keeps the last events. They
+    // are dropped by blocks of 64 KiB, so the buffer holds up to one block of
+    // events more than its capacity.
+    kDropOldest,
+  };
+
+  struct BufferOptions {
+    // The capacity of the buffer of each thread, in events. 0 for unbounded.
+    size_t max_events_per_thread = 0;
+    OverflowPolicy overflow_policy = OverflowPolicy::kDropNew;
+  };
+
   // Starts recording of TraceMe().
   // Only traces <= level will be recorded.
   // Level must be >= 0. If level is 0, no traces will be recorded.
-  static bool Start(int level) { return Get()->StartRecording(level); }
+  static bool Start(int level) { return Start(level, BufferOptions()); }
+
+  // Same as above, with the buffers of the threads bounded by `options`.
+  static bool Start(int level, const BufferOptions& options) {
+    return Get()->StartRecording(level, options);
+  }
 
   // Stops recording and returns events recorded since Start().
   // Events passed to Record after Stop has started will be dropped.
@@ -103,7 +131,7 @@ class TraceMeRecorder {
   void RegisterThread(uint32 tid, ThreadLocalRecorder* thread);
   void UnregisterThread(uint32 tid);
 
-  bool StartRecording(int level);
+  bool StartRecording(int level, const BufferOptions& options);
   Events StopRecording();
 
   // Gathers events from all active threads, and clears their buffers.
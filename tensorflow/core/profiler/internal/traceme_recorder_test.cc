@@ -28,6 +28,7 @@ limitations under the License.
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/notification.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
 #include "tensorflow/core/platform/threadpool.h"
 #include "tensorflow/core/platform/types.h"
 
@@ -57,6 +58,59 @@ TEST(RecorderTest, SingleThreaded) {
               ElementsAre(Named("during1"), Named("during2")));
 }
 
+TEST(RecorderTest, BoundedBufferDropsNewEvents) {
+  uint64 start_time = Env::Default()->NowNanos();
+  uint64 end_time = start_time + kNanosInSec;
+
+  TraceMeRecorder::BufferOptions options;
+  options.max_events_per_thread = 2;
+  options.overflow_policy = TraceMeRecorder::OverflowPolicy::kDropNew;
+  TraceMeRecorder::Start(/*level=*/1, options);
+  TraceMeRecorder::Record({1, "kept1", start_time, end_time});
+  TraceMeRecorder::Record({2, "kept2", start_time, end_time});
+  TraceMeRecorder::Record({3, "dropped", start_time, end_time});
+  auto results = TraceMeRecorder::Stop();
+
+  ASSERT_EQ(results.size(), 1);
+  EXPECT_THAT(results[0].events, ElementsAre(Named("kept1"), Named("kept2")));
+  EXPECT_EQ(results[0].num_dropped_events, 1);
+}
+
+TEST(RecorderTest, BoundedBufferDropsOldestEvents) {
+  constexpr int kNumEvents = 100000;
+  uint64 start_time = Env::Default()->NowNanos();
+  uint64 end_time = start_time + kNanosInSec;
+
+  TraceMeRecorder::BufferOptions options;
+  options.max_events_per_thread = 10;
+  options.overflow_policy = TraceMeRecorder::OverflowPolicy::kDropOldest;
+  TraceMeRecorder::Start(/*level=*/1, options);
+  for (uint64 i = 0; i < kNumEvents; ++i) {
+    TraceMeRecorder::Record({i, "event", start_time, end_time});
+  }
+  auto results = TraceMeRecorder::Stop();
+
+  // The buffer keeps the last events, up to a block more than its capacity.
+  ASSERT_EQ(results.size(), 1);
+  const auto& events = results[0].events;
+  ASSERT_GE(events.size(), options.max_events_per_thread);
+  EXPECT_LT(events.size(), kNumEvents / 2);
+  EXPECT_EQ(events.size() + results[0].num_dropped_events, kNumEvents);
+  for (size_t i = 0; i < events.size(); ++i) {
+    EXPECT_EQ(events[i].activity_id, kNumEvents - events.size() + i);
+  }
+
+  // The next session is unbounded again.
+  TraceMeRecorder::Start(/*level=*/1);
+  for (uint64 i = 0; i < kNumEvents; ++i) {
+    TraceMeRecorder::Record({i, "event", start_time, end_time});
+  }
+  results = TraceMeRecorder::Stop();
+  ASSERT_EQ(results.size(), 1);
+  EXPECT_EQ(results[0].events.size(), kNumEvents);
+  EXPECT_EQ(results[0].num_dropped_events, 0);
+}
+
 void SpinNanos(int nanos) {
   uint64 deadline = Env::Default()->NowNanos() + nanos;
   while (Env::Default()->NowNanos() < deadline) {
@@ -192,6 +246,47 @@ TEST(RecorderTest, Multithreaded) {
   }
 }
 
+// Measures the cost of an activity recorded at level 1, i.e. of the
+// TraceMeRecorder::Active check and the recording of an event with a short
+// name, with a bounded buffer so that it runs in fixed memory.
+void BM_RecordEvent(int iters, int drop_oldest) {
+  testing::StopTiming();
+  TraceMeRecorder::BufferOptions options;
+  options.max_events_per_thread = 1 << 16;
+  options.overflow_policy = drop_oldest
+                                ? TraceMeRecorder::OverflowPolicy::kDropOldest
+                                : TraceMeRecorder::OverflowPolicy::kDropNew;
+  TraceMeRecorder::Start(/*level=*/1, options);
+  testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    if (TraceMeRecorder::Active(/*level=*/1)) {
+      uint64 start_time = EnvTime::NowNanos();
+      TraceMeRecorder::Record(
+          {/*activity_id=*/0, "MatMul", start_time, EnvTime::NowNanos()});
+    }
+  }
+  testing::StopTiming();
+  TraceMeRecorder::Stop();
+}
+
+BENCHMARK(BM_RecordEvent)->Arg(0)->Arg(1);
+
+// Measures the cost of an activity not recorded, as it is above the level.
+void BM_RecordEventInactive(int iters) {
+  testing::StopTiming();
+  TraceMeRecorder::Start(/*level=*/1);
+  testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    if (TraceMeRecorder::Active(/*level=*/2)) {
+      TraceMeRecorder::Record({/*activity_id=*/0, "MatMul", 0, 0});
+    }
+  }
+  testing::StopTiming();
+  TraceMeRecorder::Stop();
+}
+
+BENCHMARK(BM_RecordEventInactive);
+
 }  // namespace
 }  // namespace profiler
 }  // namespace tensorflow
@@ -0,0 +1,148 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/profiler/lib/sampling_profiler.h"
+
+#include <utility>
+
+#include "tensorflow/core/platform/env_time.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/platform.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/profiler/protobuf/op_metrics.pb.h"
+#include "tensorflow/core/util/env_var.h"
+
+#if !defined(IS_MOBILE_PLATFORM)
+#include "tensorflow/core/profiler/convert/op_metrics_db_combiner.h"
+#include "tensorflow/core/profiler/convert/xplane_to_op_metrics_db.h"
+#include "tensorflow/core/profiler/internal/cpu/host_tracer_utils.h"
+#include "tensorflow/core/profiler/internal/traceme_recorder.h"
+#include "tensorflow/core/profiler/lib/profiler_utils.h"
+#include "tensorflow/core/profiler/protobuf/xplane.pb.h"
+#endif
+
+namespace tensorflow {
+namespace profiler {
+
+/*static*/ SamplingProfiler* SamplingProfiler::Get() {
+  static SamplingProfiler* profiler = [] {
+    SamplingProfiler* profiler = new SamplingProfiler;
+    int64 sampling_interval_steps = 0;
+    TF_CHECK_OK(ReadInt64FromEnvVar("TF_PROFILER_SAMPLING_INTERVAL_STEPS", 0,
+                                    &sampling_interval_steps));
+    if (sampling_interval_steps > 0) {
+      Options options;
+      options.sampling_interval_steps = sampling_interval_steps;
+      TF_CHECK_OK(profiler->Enable(options));
+    }
+    return profiler;
+  }();
+  return profiler;
+}
+
+Status SamplingProfiler::Enable(const Options& options) {
+  if (options.sampling_interval_steps <= 0) {
+    return errors::InvalidArgument(
+        "sampling_interval_steps must be positive; was ",
+        options.sampling_interval_steps);
+  }
+  if (options.num_sampled_steps <= 0) {
+    return errors::InvalidArgument("num_sampled_steps must be positive; was ",
+                                   options.num_sampled_steps);
+  }
+#if defined(IS_MOBILE_PLATFORM)
+  return errors::Unimplemented(
+      "The sampling profiler is not supported on mobile platforms");
+#else
+  mutex_lock l(mu_);
+  options_ = options;
+  sampled_steps_.clear();
+  step_count_.store(0, std::memory_order_relaxed);
+  enabled_.store(true, std::memory_order_relaxed);
+  return Status::OK();
+#endif
+}
+
+void SamplingProfiler::Disable() {
+  mutex_lock l(mu_);
+  enabled_.store(false, std::memory_order_relaxed);
+}
+
+OpMetricsDb SamplingProfiler::GetOpMetricsDb(int* num_sampled_steps) const {
+  OpMetricsDb result;
+  mutex_lock l(mu_);
+  *num_sampled_steps = sampled_steps_.size();
+#if !defined(IS_MOBILE_PLATFORM)
+  OpMetricsDbCombiner combiner(&result);
+  for (const OpMetricsDb& sampled_step : sampled_steps_) {
+    combiner.Combine(sampled_step);
+  }
+#endif
+  return result;
+}
+
+bool SamplingProfiler::StepBegin() {
+#if defined(IS_MOBILE_PLATFORM)
+  return false;
+#else
+  const int64 step = step_count_.fetch_add(1, std::memory_order_relaxed);
+  mutex_lock l(mu_);
+  if (!enabled_.load(std::memory_order_relaxed) ||
+      step % options_.sampling_interval_steps != 0 || tracing_) {
+    return false;
+  }
+  // Don't interfere with a ProfilerSession.
+  if (!AcquireProfilerLock()) return false;
+  if (!TraceMeRecorder::Start(options_.host_trace_level)) {
+    ReleaseProfilerLock();
+    return false;
+  }
+  tracing_ = true;
+  trace_start_time_ns_ = EnvTime::NowNanos();
+  return true;
+#endif
+}
+
+void SamplingProfiler::StepEnd() {
+#if !defined(IS_MOBILE_PLATFORM)
+  TraceMeRecorder::Events events;
+  uint64 trace_start_time_ns;
+  {
+    mutex_lock l(mu_);
+    DCHECK(tracing_);
+    events = TraceMeRecorder::Stop();
+    ReleaseProfilerLock();
+    tracing_ = false;
+    trace_start_time_ns = trace_start_time_ns_;
+  }
+
+  // Converted without holding the lock, the step is already over.
+  MakeCompleteEvents(&events);
+  XPlane host_plane;
+  ConvertCompleteEventsToXPlane(trace_start_time_ns, events, &host_plane);
+  OpMetricsDb op_metrics_db = ConvertHostThreadsXPlaneToOpMetricsDb(host_plane);
+
+  mutex_lock l(mu_);
+  sampled_steps_.push_back(std::move(op_metrics_db));
+  while (sampled_steps_.size() >
+         static_cast<size_t>(options_.num_sampled_steps)) {
+    sampled_steps_.pop_front();
+  }
+#endif
+}
+
+}  // namespace profiler
+}  // namespace tensorflow
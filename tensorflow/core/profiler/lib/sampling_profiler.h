@@ -0,0 +1,122 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_PROFILER_LIB_SAMPLING_PROFILER_H_
+#define TENSORFLOW_CORE_PROFILER_LIB_SAMPLING_PROFILER_H_
+
+#include <atomic>
+#include <deque>
+
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/profiler/protobuf/op_metrics.pb.h"
+
+namespace tensorflow {
+namespace profiler {
+
+// An always-on profiling mode, cheap enough to be left enabled in production.
+// It only traces one step in every `sampling_interval_steps`, at a reduced
+// TraceMe level, and keeps the op metrics of the last sampled steps in a fixed
+// ring buffer. Their rolling summary is returned by the Monitor RPC of the
+// profiler service.
+//
+// The steps are delimited by SamplingProfiler::ScopedStep, e.g. around each
+// Session::Run. Only the host (TraceMe) activity of the steps is recorded. A
+// step isn't sampled while a ProfilerSession is active, and a ProfilerSession
+// can't be started while a sampled step is being traced.
+//
+// The sampling can also be enabled with the TF_PROFILER_SAMPLING_INTERVAL_STEPS
+// environment variable, with the default options otherwise.
+//
+// Thread-safety: SamplingProfiler is thread-safe.
+class SamplingProfiler {
+ public:
+  struct Options {
+    // One step is traced in every `sampling_interval_steps`. Must be positive.
+    int64 sampling_interval_steps = 100;
+    // Only the TraceMe of level <= `host_trace_level` are recorded. The default
+    // records the expensive ops only, see GetTFTraceMeLevel().
+    int host_trace_level = 1;
+    // Number of sampled steps whose op metrics are kept. Must be positive.
+    int num_sampled_steps = 16;
+  };
+
+  // Returns the process-wide SamplingProfiler.
+  static SamplingProfiler* Get();
+
+  // Starts sampling the steps with `options`, dropping the steps sampled so
+  // far.
+  Status Enable(const Options& options) TF_LOCKS_EXCLUDED(mu_);
+
+  // Stops sampling the steps. The steps sampled so far are kept.
+  void Disable() TF_LOCKS_EXCLUDED(mu_);
+
+  bool enabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+  // Returns the combined op metrics of the steps in the ring buffer, and sets
+  // `num_sampled_steps` to their number.
+  OpMetricsDb GetOpMetricsDb(int* num_sampled_steps) const
+      TF_LOCKS_EXCLUDED(mu_);
+
+  // Traces the step from its construction to its destruction if it is
+  // sampled. Costs a relaxed atomic load when the sampling is disabled.
+  class ScopedStep {
+   public:
+    ScopedStep() {
+      SamplingProfiler* profiler = SamplingProfiler::Get();
+      if (TF_PREDICT_FALSE(profiler->enabled())) {
+        sampled_ = profiler->StepBegin();
+      }
+    }
+    ~ScopedStep() {
+      if (TF_PREDICT_FALSE(sampled_)) SamplingProfiler::Get()->StepEnd();
+    }
+
+   private:
+    bool sampled_ = false;
+
+    TF_DISALLOW_COPY_AND_ASSIGN(ScopedStep);
+  };
+
+ private:
+  SamplingProfiler() = default;
+
+  // Returns whether the step beginning is sampled, in which case its tracing
+  // started.
+  bool StepBegin() TF_LOCKS_EXCLUDED(mu_);
+
+  // Stops tracing the sampled step, and adds its op metrics to the ring
+  // buffer.
+  void StepEnd() TF_LOCKS_EXCLUDED(mu_);
+
+  std::atomic<bool> enabled_{false};
+  std::atomic<int64> step_count_{0};
+
+  mutable mutex mu_;
+  Options options_ TF_GUARDED_BY(mu_);
+  // Whether a sampled step is being traced, and since when.
+  bool tracing_ TF_GUARDED_BY(mu_) = false;
+  uint64 trace_start_time_ns_ TF_GUARDED_BY(mu_) = 0;
+  // The op metrics of the last sampled steps, oldest first.
+  std::deque<OpMetricsDb> sampled_steps_ TF_GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(SamplingProfiler);
+};
+
+}  // namespace profiler
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_PROFILER_LIB_SAMPLING_PROFILER_H_
@@ -0,0 +1,80 @@
+/* Copyright 2020 The TensorFlow Authors All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/profiler/lib/sampling_profiler.h"
+
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/profiler/lib/traceme.h"
+#include "tensorflow/core/profiler/protobuf/op_metrics.pb.h"
+
+namespace tensorflow {
+namespace profiler {
+namespace {
+
+void RunStep() {
+  SamplingProfiler::ScopedStep step;
+  TraceMe traceme("matmul:MatMul", /*level=*/1);
+  // Not recorded at the default host trace level.
+  TraceMe detailed_traceme("add:Add", /*level=*/2);
+}
+
+TEST(SamplingProfilerTest, BadOptions) {
+  SamplingProfiler::Options options;
+  options.sampling_interval_steps = 0;
+  EXPECT_FALSE(SamplingProfiler::Get()->Enable(options).ok());
+  options.sampling_interval_steps = 1;
+  options.num_sampled_steps = 0;
+  EXPECT_FALSE(SamplingProfiler::Get()->Enable(options).ok());
+}
+
+TEST(SamplingProfilerTest, SamplesEveryNthStep) {
+  SamplingProfiler* profiler = SamplingProfiler::Get();
+  SamplingProfiler::Options options;
+  options.sampling_interval_steps = 3;
+  TF_ASSERT_OK(profiler->Enable(options));
+  for (int i = 0; i < 7; ++i) RunStep();
+  profiler->Disable();
+  // Not sampled anymore.
+  RunStep();
+
+  int num_sampled_steps = 0;
+  OpMetricsDb op_metrics_db = profiler->GetOpMetricsDb(&num_sampled_steps);
+  // Steps 0, 3 and 6.
+  EXPECT_EQ(num_sampled_steps, 3);
+  ASSERT_EQ(op_metrics_db.metrics_db_size(), 1);
+  EXPECT_EQ(op_metrics_db.metrics_db(0).name(), "matmul");
+  EXPECT_EQ(op_metrics_db.metrics_db(0).category(), "MatMul");
+  EXPECT_EQ(op_metrics_db.metrics_db(0).occurrences(), 3);
+}
+
+TEST(SamplingProfilerTest, KeepsTheLastSampledSteps) {
+  SamplingProfiler* profiler = SamplingProfiler::Get();
+  SamplingProfiler::Options options;
+  options.sampling_interval_steps = 1;
+  options.num_sampled_steps = 2;
+  TF_ASSERT_OK(profiler->Enable(options));
+  for (int i = 0; i < 5; ++i) RunStep();
+  profiler->Disable();
+
+  int num_sampled_steps = 0;
+  OpMetricsDb op_metrics_db = profiler->GetOpMetricsDb(&num_sampled_steps);
+  EXPECT_EQ(num_sampled_steps, 2);
+  ASSERT_EQ(op_metrics_db.metrics_db_size(), 1);
+  EXPECT_EQ(op_metrics_db.metrics_db(0).occurrences(), 2);
+}
+
+}  // namespace
+}  // namespace profiler
+}  // namespace tensorflow
@@ -17,8 +17,10 @@ limitations under the License.
 
 #include <new>
 #include <string>
+#include <type_traits>
 #include <utility>
 
+#include "absl/meta/type_traits.h"
 #include "absl/strings/string_view.h"
 #include "tensorflow/core/platform/env_time.h"
 #include "tensorflow/core/platform/logging.h"
@@ -54,6 +56,19 @@ inline int GetTFTraceMeLevel(bool is_expensive) {
   return is_expensive ? kInfo : kVerbose;
 }
 
+namespace traceme_internal {
+
+// Whether T is a name (or metadata) generator, i.e. a callable without
+// arguments returning a type that the string() constructor can take.
+template <typename T, typename = void>
+struct IsNameGenerator : std::false_type {};
+template <typename T>
+struct IsNameGenerator<
+    T, absl::void_t<decltype(std::string(std::declval<T&>()()))>>
+    : std::true_type {};
+
+}  // namespace traceme_internal
+
 // This class permits user-specified (CPU) tracing activities. A trace activity
 // is started when an object of this class is created and stopped when the
 // object is destroyed.
@@ -131,6 +146,9 @@ class TraceMe {
   //   });
   template <typename NameGeneratorT>
   explicit TraceMe(NameGeneratorT name_generator, int level = 1) {
+    static_assert(traceme_internal::IsNameGenerator<NameGeneratorT>::value,
+                  "TraceMe takes a string_view, a string literal, or a "
+                  "callable without arguments returning the name");
     DCHECK_GE(level, 1);
 #if !defined(IS_MOBILE_PLATFORM)
     if (TF_PREDICT_FALSE(TraceMeRecorder::Active(level))) {
@@ -178,6 +196,10 @@ class TraceMe {
   //   });
   template <typename MetadataGeneratorT>
   void AppendMetadata(MetadataGeneratorT metadata_generator) {
+    static_assert(
+        traceme_internal::IsNameGenerator<MetadataGeneratorT>::value,
+        "AppendMetadata takes a callable without arguments returning the "
+        "metadata");
 #if !defined(IS_MOBILE_PLATFORM)
     if (TF_PREDICT_FALSE(start_time_ != kUntracedActivity)) {
       if (TF_PREDICT_TRUE(TraceMeRecorder::Active())) {
@@ -221,6 +243,9 @@ class TraceMe {
   // Records the time of an instant activity.
   template <typename NameGeneratorT>
   static void InstantActivity(NameGeneratorT name_generator, int level = 1) {
+    static_assert(traceme_internal::IsNameGenerator<NameGeneratorT>::value,
+                  "InstantActivity takes a callable without arguments "
+                  "returning the name");
 #if !defined(IS_MOBILE_PLATFORM)
     if (TF_PREDICT_FALSE(TraceMeRecorder::Active(level))) {
       uint64 now = EnvTime::NowNanos();
@@ -15,11 +15,18 @@ limitations under the License.
 
 #include "tensorflow/core/profiler/rpc/profiler_service_impl.h"
 
+#include <algorithm>
 #include <memory>
+#include <string>
+#include <vector>
 
 #include "grpcpp/support/status.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/env_time.h"
 #include "tensorflow/core/platform/errors.h"
@@ -29,8 +36,10 @@ limitations under the License.
 #include "tensorflow/core/platform/status.h"
 #include "tensorflow/core/profiler/internal/profiler_interface.h"
 #include "tensorflow/core/profiler/lib/profiler_session.h"
+#include "tensorflow/core/profiler/lib/sampling_profiler.h"
 #include "tensorflow/core/profiler/profiler_service.grpc.pb.h"
 #include "tensorflow/core/profiler/profiler_service.pb.h"
+#include "tensorflow/core/profiler/protobuf/op_metrics.pb.h"
 #include "tensorflow/core/profiler/protobuf/xplane.pb.h"
 
 namespace tensorflow {
@@ -38,6 +47,9 @@ namespace {
 
 const absl::string_view kXPlanePb = "xplane.pb";
 
+// Number of ops listed in the response to a Monitor request.
+constexpr int kNumMonitoredOps = 10;
+
 Status CollectDataToResponse(const ProfileRequest& req,
                              ProfilerSession* profiler,
                              ProfileResponse* response) {
@@ -49,11 +61,59 @@ Status CollectDataToResponse(const ProfileRequest& req,
   return Status::OK();
 }
 
+// Returns the most expensive ops of the steps sampled by the SamplingProfiler,
+// by decreasing self time.
+std::string SampledStepsSummary(bool timestamp) {
+  int num_sampled_steps = 0;
+  profiler::OpMetricsDb op_metrics_db =
+      profiler::SamplingProfiler::Get()->GetOpMetricsDb(&num_sampled_steps);
+  std::vector<const profiler::OpMetrics*> op_metrics;
+  uint64 total_self_time_ps = 0;
+  for (const profiler::OpMetrics& metrics : op_metrics_db.metrics_db()) {
+    op_metrics.push_back(&metrics);
+    total_self_time_ps += metrics.self_time_ps();
+  }
+  std::sort(op_metrics.begin(), op_metrics.end(),
+            [](const profiler::OpMetrics* a, const profiler::OpMetrics* b) {
+              return a->self_time_ps() > b->self_time_ps();
+            });
+  if (op_metrics.size() > kNumMonitoredOps) {
+    op_metrics.resize(kNumMonitoredOps);
+  }
+
+  std::string data;
+  if (timestamp) {
+    absl::StrAppend(&data, absl::FormatTime(absl::Now()), "\n");
+  }
+  absl::StrAppendFormat(&data, "Sampled steps: %d\n", num_sampled_steps);
+  if (num_sampled_steps > 0) {
+    absl::StrAppendFormat(&data, "Host time per step: %.3f ms\n",
+                          op_metrics_db.total_time_ps() / 1e9 /
+                              num_sampled_steps);
+  }
+  for (const profiler::OpMetrics* metrics : op_metrics) {
+    absl::StrAppendFormat(
+        &data, "%5.1f%%  %10.3f ms  %8d  %s (%s)\n",
+        total_self_time_ps > 0
+            ? 100.0 * metrics->self_time_ps() / total_self_time_ps
+            : 0.0,
+        metrics->self_time_ps() / 1e9, metrics->occurrences(),
+        metrics->name(), metrics->category());
+  }
+  return data;
+}
+
 class ProfilerServiceImpl : public grpc::ProfilerService::Service {
  public:
   ::grpc::Status Monitor(::grpc::ServerContext* ctx, const MonitorRequest* req,
                          MonitorResponse* response) override {
-    return ::grpc::Status(::grpc::StatusCode::UNIMPLEMENTED, "unimplemented.");
+    VLOG(1) << "Received a monitor request: " << req->DebugString();
+    if (!profiler::SamplingProfiler::Get()->enabled()) {
+      return ::grpc::Status(::grpc::StatusCode::FAILED_PRECONDITION,
+                            "The sampling profiler is not enabled.");
+    }
+    response->set_data(SampledStepsSummary(req->timestamp()));
+    return ::grpc::Status::OK;
   }
 
   ::grpc::Status Profile(::grpc::ServerContext* ctx, const ProfileRequest* req,
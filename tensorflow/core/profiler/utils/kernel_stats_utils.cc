@@ -263,6 +263,7 @@ KernelStatsByOpName GroupKernelReportsByOpName(
       if (kernel_report.is_kernel_using_tensor_core()) {
         stats.tensor_core_duration_ns += kernel_report.total_duration_ns();
       }
+      stats.occurrences += kernel_report.occurrences();
     } else {
       // Not inserted. Aggregate kernel stats to op level.
       OpLevelKernelStats& stats = ret.first->second;
@@ -274,6 +275,7 @@ KernelStatsByOpName GroupKernelReportsByOpName(
       if (kernel_report.is_kernel_using_tensor_core()) {
         stats.tensor_core_duration_ns += kernel_report.total_duration_ns();
       }
+      stats.occurrences += kernel_report.occurrences();
     }
   }
   return op_level_kernel_stats;
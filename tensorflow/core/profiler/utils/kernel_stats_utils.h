@@ -116,6 +116,8 @@ struct OpLevelKernelStats {
   // If this value is not 0, at least one of the kernels launched by this op
   // is using TensorCore.
   uint64 tensor_core_duration_ns = 0;
+  // The number of kernels launched in this op.
+  uint64 occurrences = 0;
 };
 
 using KernelStatsByOpName =
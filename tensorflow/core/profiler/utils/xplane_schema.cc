@@ -151,6 +151,8 @@ const StatTypeMap& GetStatTypeMap() {
       {"kpi_value", kKpiValue},
       {"element_id", kElementId},
       {"parent_id", kParentId},
+      {"buffered_elements", kBufferedElements},
+      {"wait_time", kWaitTime},
       // XPlane semantics related.
       {"_pt", kProducerType},
       {"_ct", kConsumerType},
@@ -139,6 +139,8 @@ enum StatType {
   kKpiValue,
   kElementId,
   kParentId,
+  kBufferedElements,
+  kWaitTime,
   // XPlane semantics related.
   kProducerType,
   kConsumerType,
@@ -14,6 +14,9 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/summary/summary_file_writer.h"
 
+#include <algorithm>
+#include <chrono>  // NOLINT(build/c++11)
+
 #include "tensorflow/core/summary/summary_converter.h"
 #include "tensorflow/core/framework/graph.pb.h"
 #include "tensorflow/core/framework/op_kernel.h"
@@ -21,12 +24,40 @@ limitations under the License.
 #include "tensorflow/core/framework/summary.pb.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/monitoring/counter.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/events_writer.h"
 #include "tensorflow/core/util/ptr_util.h"
 
 namespace tensorflow {
 namespace {
 
+auto* dropped_events = monitoring::Counter<0>::New(
+    "/tensorflow/core/summary_file_writer/dropped_events",
+    "The number of summary events dropped because the queue of a summary "
+    "file writer was full.");
+
+// The number of events the queue of a writer holds at most, unless
+// TF_SUMMARY_WRITER_MAX_PENDING_EVENTS sets it. Events written while the
+// queue is full are dropped rather than make the step wait for the file.
+constexpr int64 kDefaultMaxPendingEvents = 1000;
+
+int64 MaxPendingEvents(int max_queue) {
+  int64 max_pending_events;
+  Status status =
+      ReadInt64FromEnvVar("TF_SUMMARY_WRITER_MAX_PENDING_EVENTS",
+                          kDefaultMaxPendingEvents, &max_pending_events);
+  if (!status.ok()) {
+    LOG(ERROR) << status;
+    max_pending_events = kDefaultMaxPendingEvents;
+  }
+  // The queue always holds the events of a full batch.
+  return std::max<int64>(max_pending_events, max_queue + 1);
+}
+
+// Queues the events and writes them from a background thread, once there are
+// more than max_queue of them or flush_millis passed since the last flush, so
+// that the steps which write summaries never wait for the events file.
 class SummaryFileWriter : public SummaryWriterInterface {
  public:
   SummaryFileWriter(int max_queue, int flush_millis, Env* env)
@@ -34,6 +65,7 @@ class SummaryFileWriter : public SummaryWriterInterface {
         is_initialized_(false),
         max_queue_(max_queue),
         flush_millis_(flush_millis),
+        max_pending_events_(MaxPendingEvents(max_queue)),
         env_(env) {}
 
   Status Initialize(const string& logdir, const string& filename_suffix) {
@@ -44,26 +76,46 @@ class SummaryFileWriter : public SummaryWriterInterface {
       }
       TF_RETURN_IF_ERROR(env_->RecursivelyCreateDir(logdir));
     }
-    mutex_lock ml(mu_);
-    events_writer_ =
-        tensorflow::MakeUnique<EventsWriter>(io::JoinPath(logdir, "events"));
-    TF_RETURN_WITH_CONTEXT_IF_ERROR(
-        events_writer_->InitWithSuffix(filename_suffix),
-        "Could not initialize events writer.");
-    last_flush_ = env_->NowMicros();
-    is_initialized_ = true;
+    {
+      mutex_lock wl(write_mu_);
+      events_writer_ =
+          tensorflow::MakeUnique<EventsWriter>(io::JoinPath(logdir, "events"));
+      TF_RETURN_WITH_CONTEXT_IF_ERROR(
+          events_writer_->InitWithSuffix(filename_suffix),
+          "Could not initialize events writer.");
+    }
+    {
+      mutex_lock ml(mu_);
+      last_flush_ = env_->NowMicros();
+      is_initialized_ = true;
+    }
+    writer_thread_.reset(env_->StartThread(ThreadOptions(),
+                                           "summary_file_writer",
+                                           [this]() { WriterLoop(); }));
     return Status::OK();
   }
 
   Status Flush() override {
-    mutex_lock ml(mu_);
-    if (!is_initialized_) {
-      return errors::FailedPrecondition("Class was not properly initialized.");
+    {
+      mutex_lock ml(mu_);
+      if (!is_initialized_) {
+        return errors::FailedPrecondition(
+            "Class was not properly initialized.");
+      }
     }
-    return InternalFlush();
+    Status status = InternalFlush();
+    mutex_lock ml(mu_);
+    status.Update(TakeWriterStatus());
+    return status;
   }
 
   ~SummaryFileWriter() override {
+    {
+      mutex_lock ml(mu_);
+      shutdown_ = true;
+      queue_cond_.notify_all();
+    }
+    writer_thread_.reset();
     (void)Flush();  // Ignore errors.
   }
 
@@ -140,12 +192,17 @@ class SummaryFileWriter : public SummaryWriterInterface {
 
   Status WriteEvent(std::unique_ptr<Event> event) override {
     mutex_lock ml(mu_);
-    queue_.emplace_back(std::move(event));
-    if (queue_.size() > max_queue_ ||
-        env_->NowMicros() - last_flush_ > 1000 * flush_millis_) {
-      return InternalFlush();
+    Status status = TakeWriterStatus();
+    if (queue_.size() >= max_pending_events_) {
+      dropped_events->GetCell()->IncrementBy(1);
+      LOG_EVERY_N(WARNING, 1000)
+          << "Dropped a summary event: the queue of the writer is full with "
+          << queue_.size() << " events.";
+      return status;
     }
-    return Status::OK();
+    queue_.emplace_back(std::move(event));
+    if (FlushDue()) queue_cond_.notify_one();
+    return status;
   }
 
   string DebugString() const override { return "SummaryFileWriter"; }
@@ -155,26 +212,70 @@ class SummaryFileWriter : public SummaryWriterInterface {
     return static_cast<double>(env_->NowMicros()) / 1.0e6;
   }
 
-  Status InternalFlush() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
-    for (const std::unique_ptr<Event>& e : queue_) {
+  bool FlushDue() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    return queue_.size() > max_queue_ ||
+           (!queue_.empty() &&
+            env_->NowMicros() - last_flush_ > 1000 * flush_millis_);
+  }
+
+  // Returns the error of the last failed background flush, once.
+  Status TakeWriterStatus() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    Status status = writer_status_;
+    writer_status_ = Status::OK();
+    return status;
+  }
+
+  void WriterLoop() {
+    while (true) {
+      {
+        mutex_lock ml(mu_);
+        while (!shutdown_ && !FlushDue()) {
+          queue_cond_.wait_for(
+              ml, std::chrono::milliseconds(std::max(1, flush_millis_)));
+        }
+        if (shutdown_) return;
+      }
+      const Status status = InternalFlush();
+      if (!status.ok()) {
+        mutex_lock ml(mu_);
+        writer_status_.Update(status);
+      }
+    }
+  }
+
+  // Writes the queued events as a batch and flushes the events file.
+  Status InternalFlush() {
+    mutex_lock wl(write_mu_);
+    std::vector<std::unique_ptr<Event>> batch;
+    {
+      mutex_lock ml(mu_);
+      batch.swap(queue_);
+      last_flush_ = env_->NowMicros();
+    }
+    for (const std::unique_ptr<Event>& e : batch) {
       events_writer_->WriteEvent(*e);
     }
-    queue_.clear();
     TF_RETURN_WITH_CONTEXT_IF_ERROR(events_writer_->Flush(),
                                     "Could not flush events file.");
-    last_flush_ = env_->NowMicros();
     return Status::OK();
   }
 
-  bool is_initialized_;
+  bool is_initialized_ TF_GUARDED_BY(mu_);
   const int max_queue_;
   const int flush_millis_;
-  uint64 last_flush_;
+  const int64 max_pending_events_;
+  uint64 last_flush_ TF_GUARDED_BY(mu_);
   Env* env_;
+  // Acquired before mu_ when both are held.
+  mutex write_mu_;
   mutex mu_;
+  condition_variable queue_cond_;
+  bool shutdown_ TF_GUARDED_BY(mu_) = false;
+  Status writer_status_ TF_GUARDED_BY(mu_);
   std::vector<std::unique_ptr<Event>> queue_ TF_GUARDED_BY(mu_);
   // A pointer to allow deferred construction.
-  std::unique_ptr<EventsWriter> events_writer_ TF_GUARDED_BY(mu_);
+  std::unique_ptr<EventsWriter> events_writer_ TF_GUARDED_BY(write_mu_);
+  std::unique_ptr<Thread> writer_thread_;
   std::vector<std::pair<string, SummaryMetadata>> registered_summaries_
       TF_GUARDED_BY(mu_);
 };
@@ -28,7 +28,10 @@ namespace tensorflow {
 /// makes this summary writer suitable for file systems like GCS.
 ///
 /// It will enqueue up to max_queue summaries, and flush at least every
-/// flush_millis milliseconds. The summaries will be written to the
+/// flush_millis milliseconds. Writes and flushes happen on a background
+/// thread, other than those of Flush(); summaries written while that thread
+/// is behind by TF_SUMMARY_WRITER_MAX_PENDING_EVENTS (by default 1000) are
+/// dropped and counted. The summaries will be written to the
 /// directory specified by logdir and with the filename suffixed by
 /// filename_suffix. The caller owns a reference to result if the
 /// returned status is ok. The Env object must not be destroyed until
@@ -217,6 +217,38 @@ TEST_F(SummaryFileWriterTest, WriteEvent) {
                         }));
 }
 
+TEST_F(SummaryFileWriterTest, WritesInBackground) {
+  SummaryWriterInterface* writer;
+  TF_CHECK_OK(CreateSummaryFileWriter(0, 1000, testing::TmpDir(),
+                                      "background_test", &env_, &writer));
+  core::ScopedUnref deleter(writer);
+  std::unique_ptr<Event> e{new Event};
+  e->set_step(3);
+  TF_CHECK_OK(writer->WriteEvent(std::move(e)));
+
+  // The event is written without a Flush, as it exceeds the max_queue of 0.
+  std::vector<string> files;
+  TF_CHECK_OK(env_.GetMatchingPaths(
+      io::JoinPath(testing::TmpDir(), "events*background_test"), &files));
+  ASSERT_EQ(1, files.size());
+  tstring record;
+  Status status;
+  for (int i = 0; i < 1000; ++i) {
+    std::unique_ptr<RandomAccessFile> read_file;
+    TF_CHECK_OK(env_.NewRandomAccessFile(files[0], &read_file));
+    io::RecordReader reader(read_file.get(), io::RecordReaderOptions());
+    uint64 offset = 0;
+    TF_CHECK_OK(reader.ReadRecord(&offset, &record));
+    status = reader.ReadRecord(&offset, &record);
+    if (status.ok()) break;
+    Env::Default()->SleepForMicroseconds(10000);
+  }
+  TF_CHECK_OK(status);
+  Event event;
+  event.ParseFromString(record);
+  EXPECT_EQ(3, event.step());
+}
+
 TEST_F(SummaryFileWriterTest, WallTime) {
   env_.AdvanceByMillis(7023);
   TF_CHECK_OK(SummaryTestHelper(
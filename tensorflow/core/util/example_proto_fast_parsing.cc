@@ -113,6 +113,43 @@ constexpr uint8 kVarintTag(uint32 tag) { return (tag << 3) | 0; }
 constexpr uint8 kDelimitedTag(uint32 tag) { return (tag << 3) | 2; }
 constexpr uint8 kFixed32Tag(uint32 tag) { return (tag << 3) | 5; }
 
+// Returns the number of varints in [begin, end), which is the number of bytes
+// without a continuation bit. The loop has no branches, so that compilers
+// vectorize it.
+size_t CountVarints(const uint8* begin, const uint8* end) {
+  size_t count = 0;
+  for (const uint8* p = begin; p != end; ++p) {
+    count += (*p < 0x80);
+  }
+  return count;
+}
+
+// Decodes the varints in [begin, end), storing the first `max_values` of them
+// in `out`. Returns false if the last varint is truncated or if a varint is
+// longer than 10 bytes.
+bool DecodePackedVarints(const uint8* begin, const uint8* end, int64* out,
+                         size_t max_values) {
+  size_t index = 0;
+  const uint8* p = begin;
+  while (p != end) {
+    uint64 value = *p++;
+    // Ids and counts in Examples are often small, so decode one-byte varints
+    // without entering the loop.
+    if (value >= 0x80) {
+      value &= 0x7f;
+      for (int shift = 7;; shift += 7) {
+        if (p == end || shift > 63) return false;
+        const uint64 byte = *p++;
+        value |= (byte & 0x7f) << shift;
+        if (byte < 0x80) break;
+      }
+    }
+    if (index < max_values) out[index] = static_cast<int64>(value);
+    ++index;
+  }
+  return true;
+}
+
 namespace parsed {
 
 // ParseDataType has to be called first, then appropriate ParseZzzzList.
@@ -295,15 +332,28 @@ class Feature {
         if (!stream.ExpectTag(kDelimitedTag(1))) return false;  // packed tag
         uint32 packed_length;
         if (!stream.ReadVarint32(&packed_length)) return false;
-        auto packed_limit = stream.PushLimit(packed_length);
-
-        while (!stream.ExpectAtEnd()) {
-          protobuf_uint64 n;  // There is no API for int64
-          if (!stream.ReadVarint64(&n)) return false;
-          int64_list->push_back(static_cast<int64>(n));
+        if (packed_length > 0) {
+          const void* packed_data;
+          int available;
+          if (!stream.GetDirectBufferPointer(&packed_data, &available) ||
+              static_cast<uint32>(available) < packed_length) {
+            return false;
+          }
+          // Count the values first so that the output is resized once, then
+          // decode them straight from the serialized buffer.
+          const uint8* begin = static_cast<const uint8*>(packed_data);
+          const uint8* end = begin + packed_length;
+          const size_t initial_size = int64_list->size();
+          int64_list->resize(initial_size + CountVarints(begin, end));
+          // The output may have room for fewer values in case of a
+          // LimitedArraySlice.
+          if (!DecodePackedVarints(begin, end,
+                                   int64_list->data() + initial_size,
+                                   int64_list->size() - initial_size)) {
+            return false;
+          }
+          if (!stream.Skip(packed_length)) return false;
         }
-
-        stream.PopLimit(packed_limit);
       } else {  // non-packed
         while (!stream.ExpectAtEnd()) {
           if (!stream.ExpectTag(kVarintTag(1))) return false;
@@ -13,6 +13,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <limits>
 #include <utility>
 
 #include "tensorflow/core/util/example_proto_fast_parsing.h"
@@ -170,6 +171,30 @@ TEST(FastParse, Packed) {
       "\x0a\x0d\x0a\x0b\x0a\x03\x61\x67\x65\x12\x04\x1a\x02\x08\x0d");
 }
 
+TEST(FastParse, PackedInt64Varints) {
+  Example example;
+  Int64List* int64_list =
+      (*example.mutable_features()->mutable_feature())["ids"]
+          .mutable_int64_list();
+  // Values whose varints take from 1 to 10 bytes.
+  for (int64 value : {int64{0}, int64{1}, int64{127}, int64{128},
+                      int64{16383}, int64{16384}, int64{1} << 35,
+                      std::numeric_limits<int64>::max(), int64{-1},
+                      std::numeric_limits<int64>::min()}) {
+    int64_list->add_value(value);
+  }
+  TestCorrectness(Serialize(example));
+}
+
+TEST(FastParse, TruncatedPackedInt64) {
+  // The only value of the packed int64 list has a continuation bit.
+  const string serialized =
+      "\x0a\x0e\x0a\x0c\x0a\x03\x61\x67\x65\x12\x05\x1a\x03\x0a\x01\x8d";
+  Example example;
+  EXPECT_FALSE(example.ParseFromString(serialized));
+  EXPECT_FALSE(TestFastParse(serialized, &example));
+}
+
 TEST(FastParse, EmptyFeatures) {
   Example example;
   example.mutable_features();
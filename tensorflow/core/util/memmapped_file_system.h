@@ -46,7 +46,7 @@ namespace tensorflow {
 // kMemmappedPackageDefaultGraphDef;
 //
 // A "frozen" GraphDef can be converted into this format using
-// tensorflow/contrib/util/convert_graphdef_memmapped_format
+// ConvertConstantsToImmutableConst in memmapped_file_system_writer.h.
 class MemmappedFileSystem : public FileSystem {
  public:
   // Memmapped regions use this prefix to distinguish from
@@ -14,6 +14,7 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/util/memmapped_file_system.h"
 
+#include "tensorflow/core/framework/node_def_util.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/framework/versions.pb.h"
 #include "tensorflow/core/graph/graph_def_builder.h"
@@ -110,6 +111,61 @@ TEST(MemmappedFileSystemTest, SimpleTest) {
             memmapped_env.FileExists("bla-bla-bla").code());
 }
 
+TEST(MemmappedFileSystemTest, ConvertConstantsToImmutableConst) {
+  Tensor large(DT_FLOAT, TensorShape({16, 16}));
+  test::FillIota<float>(&large, 1);
+  GraphDef graph_def;
+  auto add_const = [&graph_def](const string& name, const Tensor& value,
+                                const string& device) {
+    NodeDef* node = graph_def.add_node();
+    node->set_name(name);
+    node->set_op("Const");
+    node->set_device(device);
+    AddNodeAttr("dtype", value.dtype(), node);
+    AddNodeAttr("value", value, node);
+  };
+  add_const("scope/large", large, "");
+  add_const("small", test::AsScalar<float>(1), "");
+  add_const("on_gpu", large, "/device:GPU:0");
+  add_const("strings", test::AsTensor<tstring>(std::vector<tstring>(
+                           100, "a string of some length")),
+            "");
+
+  const string filename =
+      io::JoinPath(testing::TmpDir(), "memmapped_env_convert_test");
+  int num_converted = 0;
+  TF_ASSERT_OK(ConvertConstantsToImmutableConst(
+      Env::Default(), graph_def, large.TotalBytes() / 2, filename,
+      &num_converted));
+  EXPECT_EQ(1, num_converted);
+
+  MemmappedEnv memmapped_env(Env::Default());
+  TF_ASSERT_OK(memmapped_env.InitializeFromFile(filename));
+  GraphDef converted;
+  TF_ASSERT_OK(ReadBinaryProto(
+      &memmapped_env, MemmappedFileSystem::kMemmappedPackageDefaultGraphDef,
+      &converted));
+  ASSERT_EQ(4, converted.node_size());
+  const NodeDef& node = converted.node(0);
+  EXPECT_EQ("scope/large", node.name());
+  EXPECT_EQ("ImmutableConst", node.op());
+  for (int i = 1; i < 4; ++i) {
+    EXPECT_EQ("Const", converted.node(i).op());
+  }
+
+  string region_name;
+  TF_ASSERT_OK(GetNodeAttr(node, "memory_region_name", &region_name));
+  TensorShape shape;
+  TF_ASSERT_OK(GetNodeAttr(node, "shape", &shape));
+  EXPECT_EQ(large.shape(), shape);
+  std::unique_ptr<ReadOnlyMemoryRegion> memory_region;
+  TF_ASSERT_OK(memmapped_env.NewReadOnlyMemoryRegionFromFile(region_name,
+                                                             &memory_region));
+  EXPECT_EQ(large.tensor_data(),
+            StringPiece(static_cast<const char*>(memory_region->data()),
+                        large.TotalBytes()));
+}
+
 TEST(MemmappedFileSystemTest, NotInitialized) {
   MemmappedEnv memmapped_env(Env::Default());
   std::unique_ptr<ReadOnlyMemoryRegion> memory_region;
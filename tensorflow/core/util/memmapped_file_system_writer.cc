@@ -16,6 +16,12 @@ limitations under the License.
 
 #include <algorithm>
 
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/util/device_name_utils.h"
+
 namespace tensorflow {
 
 Status MemmappedFileSystemWriter::InitializeToFile(Env* env,
@@ -133,4 +139,56 @@ void MemmappedFileSystemWriter::AddToDirectoryElement(const string& name,
   new_directory_element->set_length(length);
 }
 
+Status ConvertConstantsToImmutableConst(Env* env, const GraphDef& graph_def,
+                                        uint64 min_conversion_bytes,
+                                        const string& filename,
+                                        int* num_converted) {
+  MemmappedFileSystemWriter writer;
+  TF_RETURN_IF_ERROR(writer.InitializeToFile(env, filename));
+  GraphDef converted = graph_def;
+  int converted_count = 0;
+  for (NodeDef& node : *converted.mutable_node()) {
+    if (node.op() != "Const") continue;
+    // ImmutableConst only has a CPU kernel.
+    DeviceNameUtils::ParsedName device;
+    if (!node.device().empty() &&
+        (!DeviceNameUtils::ParseFullName(node.device(), &device) ||
+         (device.has_type && device.type != DEVICE_CPU))) {
+      continue;
+    }
+    const TensorProto* proto = nullptr;
+    TF_RETURN_IF_ERROR(GetNodeAttr(node, "value", &proto));
+    // The bytes of the value, as encoded in the proto, on which the choice of
+    // the nodes is made without parsing the small ones.
+    const uint64 proto_bytes = proto->ByteSizeLong();
+    if (!DataTypeCanUseMemcpy(proto->dtype()) ||
+        proto_bytes < min_conversion_bytes) {
+      continue;
+    }
+    Tensor value;
+    if (!value.FromProto(*proto)) {
+      return errors::InvalidArgument("Cannot parse the value of Const node ",
+                                     node.name());
+    }
+    if (value.TotalBytes() == 0) continue;
+    // Node names may contain characters which region names may not.
+    const string region_name =
+        strings::StrCat(MemmappedFileSystem::kMemmappedPackagePrefix,
+                        "const_", converted_count);
+    TF_RETURN_IF_ERROR(writer.SaveTensor(value, region_name));
+
+    node.set_op("ImmutableConst");
+    node.clear_attr();
+    AddNodeAttr("dtype", value.dtype(), &node);
+    AddNodeAttr("shape", value.shape(), &node);
+    AddNodeAttr("memory_region_name", region_name, &node);
+    ++converted_count;
+  }
+  TF_RETURN_IF_ERROR(writer.SaveProtobuf(
+      converted, MemmappedFileSystem::kMemmappedPackageDefaultGraphDef));
+  TF_RETURN_IF_ERROR(writer.FlushAndClose());
+  if (num_converted != nullptr) *num_converted = converted_count;
+  return Status::OK();
+}
+
 }  // namespace tensorflow
@@ -18,6 +18,7 @@ limitations under the License.
 #include <memory>
 #include <vector>
 
+#include "tensorflow/core/framework/graph.pb.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/util/memmapped_file_system.h"
@@ -48,6 +49,20 @@ class MemmappedFileSystemWriter {
   TF_DISALLOW_COPY_AND_ASSIGN(MemmappedFileSystemWriter);
 };
 
+// Writes `graph_def` into a memmapped package at `filename` as
+// kMemmappedPackageDefaultGraphDef, with every host Const node holding at
+// least `min_conversion_bytes` bytes replaced by an ImmutableConst node that
+// maps its value from the package. A frozen model loaded from the package with
+// MemmappedEnv::InitializeFromFile and ReadBinaryProto, and run in a session
+// whose SessionOptions::env is that MemmappedEnv, then neither parses nor
+// copies its large values: they stay in the page cache, shared by the
+// processes which map the package. Sets `*num_converted`, if it is not null,
+// to the number of nodes replaced.
+Status ConvertConstantsToImmutableConst(Env* env, const GraphDef& graph_def,
+                                        uint64 min_conversion_bytes,
+                                        const string& filename,
+                                        int* num_converted);
+
 }  // namespace tensorflow
 
 #endif  // TENSORFLOW_CORE_UTIL_MEMMAPPED_FILE_SYSTEM_WRITER_H_
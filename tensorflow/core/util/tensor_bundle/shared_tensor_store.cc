@@ -0,0 +1,93 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/util/tensor_bundle/shared_tensor_store.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/hash/crc32c.h"
+#include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/util/env_var.h"
+
+namespace tensorflow {
+
+constexpr size_t SharedTensorStore::kMinSharedBytes;
+
+SharedTensorStore* SharedTensorStore::Global() {
+  static SharedTensorStore* store = new SharedTensorStore;
+  return store;
+}
+
+bool SharedTensorStore::IsEnabled() {
+  static const bool enabled = [] {
+    bool value;
+    Status status =
+        ReadBoolFromEnvVar("TF_SHARE_IDENTICAL_TENSORS", false, &value);
+    if (!status.ok()) {
+      LOG(ERROR) << status;
+      return false;
+    }
+    return value;
+  }();
+  return enabled;
+}
+
+Tensor SharedTensorStore::Share(const Tensor& tensor) {
+  if (!tensor.IsInitialized() || !DataTypeCanUseMemcpy(tensor.dtype())) {
+    return tensor;
+  }
+  const StringPiece data = tensor.tensor_data();
+  if (data.size() < kMinSharedBytes) return tensor;
+  const uint64 key =
+      Hash64Combine(Hash64Combine(crc32c::Value(data.data(), data.size()),
+                                  static_cast<uint64>(tensor.dtype())),
+                    data.size());
+
+  mutex_lock l(mu_);
+  auto range = tensors_.equal_range(key);
+  for (auto it = range.first; it != range.second; ++it) {
+    const Tensor& stored = it->second;
+    if (stored.dtype() == tensor.dtype() &&
+        stored.shape() == tensor.shape() &&
+        std::memcmp(stored.tensor_data().data(), data.data(), data.size()) ==
+            0) {
+      return stored;
+    }
+  }
+  tensors_.emplace(key, tensor);
+  if (tensors_.size() >= next_sweep_size_) Sweep();
+  return tensor;
+}
+
+size_t SharedTensorStore::size() const {
+  mutex_lock l(mu_);
+  return tensors_.size();
+}
+
+void SharedTensorStore::Sweep() {
+  for (auto it = tensors_.begin(); it != tensors_.end();) {
+    if (it->second.RefCountIsOne()) {
+      it = tensors_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  next_sweep_size_ = std::max<size_t>(64, 2 * tensors_.size());
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,77 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_UTIL_TENSOR_BUNDLE_SHARED_TENSOR_STORE_H_
+#define TENSORFLOW_CORE_UTIL_TENSOR_BUNDLE_SHARED_TENSOR_STORE_H_
+
+#include <unordered_map>
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// A process-wide store of tensors keyed by their contents, so that the
+// sessions of a process which restore or embed the same values, such as two
+// versions of a model loaded while one replaces the other, hold one copy of
+// them.
+//
+// The shared buffers are never written in place: the ops that update tensors
+// (Assign, AssignVariableOp and the resource variable updates) only reuse a
+// buffer whose reference count is one, and the store holds a reference to
+// every tensor it returns, so the first write to a shared value copies it.
+//
+// Sharing is enabled by setting TF_SHARE_IDENTICAL_TENSORS=1, as hashing and
+// comparing the values adds to the cost of restoring them.
+class SharedTensorStore {
+ public:
+  // Tensors smaller than this are not worth sharing.
+  static constexpr size_t kMinSharedBytes = 4096;
+
+  // Returns the store of the process.
+  static SharedTensorStore* Global();
+
+  // Returns true if TF_SHARE_IDENTICAL_TENSORS enables the global store.
+  static bool IsEnabled();
+
+  SharedTensorStore() = default;
+
+  // Returns a stored tensor with the dtype, shape and contents of `tensor`,
+  // or stores and returns `tensor` if there is none. Tensors of types that
+  // are not memcpy-able, or smaller than kMinSharedBytes, are returned as is.
+  Tensor Share(const Tensor& tensor);
+
+  // Returns the number of tensors in the store.
+  size_t size() const;
+
+ private:
+  // Drops the tensors which nothing but the store references anymore.
+  void Sweep() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  mutable mutex mu_;
+  // The stored tensors by a hash of their dtype and contents.
+  std::unordered_multimap<uint64, Tensor> tensors_ TF_GUARDED_BY(mu_);
+  // The number of tensors at which the next sweep runs.
+  size_t next_sweep_size_ TF_GUARDED_BY(mu_) = 64;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(SharedTensorStore);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_UTIL_TENSOR_BUNDLE_SHARED_TENSOR_STORE_H_
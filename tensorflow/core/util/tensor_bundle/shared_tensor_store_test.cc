@@ -0,0 +1,69 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/util/tensor_bundle/shared_tensor_store.h"
+
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+Tensor MakeTensor(float value) {
+  Tensor tensor(DT_FLOAT, TensorShape({32, 32}));
+  tensor.flat<float>().setConstant(value);
+  return tensor;
+}
+
+TEST(SharedTensorStoreTest, SharesEqualTensors) {
+  SharedTensorStore store;
+  Tensor a = store.Share(MakeTensor(1));
+  Tensor b = store.Share(MakeTensor(1));
+  EXPECT_TRUE(a.SharesBufferWith(b));
+  test::ExpectTensorEqual<float>(MakeTensor(1), b);
+
+  Tensor c = store.Share(MakeTensor(2));
+  EXPECT_FALSE(a.SharesBufferWith(c));
+  // Equal bytes of another shape are a different tensor.
+  Tensor d(DT_FLOAT, TensorShape({1024}));
+  d.flat<float>().setConstant(1);
+  EXPECT_FALSE(a.SharesBufferWith(store.Share(d)));
+  EXPECT_EQ(3, store.size());
+}
+
+TEST(SharedTensorStoreTest, SkipsSmallAndNonMemcpyTensors) {
+  SharedTensorStore store;
+  Tensor small(DT_FLOAT, TensorShape({4}));
+  small.flat<float>().setZero();
+  EXPECT_TRUE(small.SharesBufferWith(store.Share(small)));
+  Tensor strings(DT_STRING, TensorShape({2048}));
+  store.Share(strings);
+  EXPECT_EQ(0, store.size());
+}
+
+TEST(SharedTensorStoreTest, DropsUnusedTensors) {
+  SharedTensorStore store;
+  for (int i = 0; i < 63; ++i) {
+    store.Share(MakeTensor(i));
+  }
+  EXPECT_EQ(63, store.size());
+  // The next tensor triggers a sweep of the others, none still in use.
+  Tensor kept = store.Share(MakeTensor(-1));
+  EXPECT_EQ(1, store.size());
+  EXPECT_TRUE(kept.SharesBufferWith(store.Share(MakeTensor(-1))));
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -22,6 +22,7 @@ limitations under the License.
 #include <utility>
 
 #include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/framework/tensor_util.h"
 #include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/framework/tensor_shape.pb.h"
 #include "tensorflow/core/framework/types.h"
@@ -62,6 +63,8 @@ static const int kBufferSize = 1024 * 1024;
 // bundle.
 const char* const kHeaderEntryKey = "";
 
+string RowIdsKey(StringPiece key) { return strings::StrCat(key, "/.ROW_IDS"); }
+
 namespace {
 
 // Reads "num_elements" string elements from file[offset, offset+size) into the
@@ -405,19 +408,33 @@ Status PadAlignment(FileOutputBuffer* out, int alignment, int64* size) {
 
 }  // namespace
 
+struct BundleWriter::DataShard {
+  // The name of the data file, and the name it is written under until
+  // Finish().
+  string path;
+  string temp_path;
+  std::unique_ptr<FileOutputBuffer> out;
+  int64 size = 0;  // Number of bytes written into out.
+  // Number of bytes of the tensors added to the shard, to balance the shards.
+  int64 added_bytes = 0;
+  // Runs the writes of the shard, in the order they were added, when the
+  // writes run in the background.
+  std::unique_ptr<thread::ThreadPool> thread;
+};
+
 BundleWriter::BundleWriter(Env* env, StringPiece prefix, const Options& options)
-    : env_(env),
-      options_(options),
-      prefix_(prefix),
-      out_(nullptr),
-      size_(0) {
+    : env_(env), options_(options), prefix_(prefix) {
+  mutex_lock l(mu_);
   status_ = env_->HasAtomicMove(prefix_, &use_temp_file_);
   if (!status_.ok()) return;
+  if (options_.num_data_shards < 1) {
+    status_ = errors::InvalidArgument("num_data_shards must be >= 1, got ",
+                                      options_.num_data_shards);
+    return;
+  }
 
-  data_path_ = DataFilename(prefix_, 0, 1);
   metadata_path_ = MetaFilename(prefix_);
   if (use_temp_file_) {
-    data_path_ = strings::StrCat(data_path_, ".tempstate", random::New64());
     metadata_path_ =
         strings::StrCat(metadata_path_, ".tempstate", random::New64());
   }
@@ -427,57 +444,122 @@ BundleWriter::BundleWriter(Env* env, StringPiece prefix, const Options& options)
     return;
   }
 
-  std::unique_ptr<WritableFile> wrapper;
-  status_ = env_->NewWritableFile(data_path_, &wrapper);
-  if (!status_.ok()) return;
-  out_ = std::unique_ptr<FileOutputBuffer>(
-      new FileOutputBuffer(wrapper.release(), 8 << 20 /* 8MB write buffer */));
-
-  VLOG(1) << "Writing to file " << data_path_;
+  const int num_shards = options_.num_data_shards;
+  for (int shard_id = 0; shard_id < num_shards; ++shard_id) {
+    std::unique_ptr<DataShard> shard(new DataShard);
+    shard->path = DataFilename(prefix_, shard_id, num_shards);
+    shard->temp_path = shard->path;
+    if (use_temp_file_) {
+      shard->temp_path =
+          strings::StrCat(shard->path, ".tempstate", random::New64());
+    }
+    std::unique_ptr<WritableFile> wrapper;
+    status_ = env_->NewWritableFile(shard->temp_path, &wrapper);
+    if (!status_.ok()) return;
+    shard->out = std::unique_ptr<FileOutputBuffer>(new FileOutputBuffer(
+        wrapper.release(), 8 << 20 /* 8MB write buffer */));
+    if (num_shards > 1) {
+      shard->thread.reset(
+          new thread::ThreadPool(env_, "bundle_writer_shard", 1));
+    }
+    VLOG(1) << "Writing to file " << shard->temp_path;
+    shards_.push_back(std::move(shard));
+  }
 }
 
-Status BundleWriter::Add(StringPiece key, const Tensor& val) {
-  if (!status_.ok()) return status_;
-  CHECK_NE(key, kHeaderEntryKey);
-  const string key_string(key);
-  if (entries_.find(key_string) != entries_.end()) {
-    status_ = errors::InvalidArgument("Adding duplicate key: ", key);
-    return status_;
+BundleWriter::~BundleWriter() {
+  // Waits for the writes still running in the background.
+  for (auto& shard : shards_) {
+    shard->thread.reset();
   }
+}
 
-  BundleEntryProto* entry = &entries_[key_string];
-  entry->set_dtype(val.dtype());
-  val.shape().AsProto(entry->mutable_shape());
-  entry->set_shard_id(0);
-  entry->set_offset(size_);
+Status BundleWriter::WriteToShard(const Tensor& val, DataShard* shard,
+                                  BundleEntryProto* entry) {
+  entry->set_offset(shard->size);
 
   // Updates the data file.
+  FileOutputBuffer* out = shard->out.get();
   size_t data_bytes_written = 0;
   uint32 crc32c = 0;
-  out_->clear_crc32c();
+  out->clear_crc32c();
   if (val.dtype() == DT_STRING) {
-    status_ = WriteStringTensor(val, out_.get(), &data_bytes_written, &crc32c);
+    TF_RETURN_IF_ERROR(
+        WriteStringTensor(val, out, &data_bytes_written, &crc32c));
   } else if (val.dtype() == DT_VARIANT) {
-    status_ = WriteVariantTensor(val, out_.get(), &data_bytes_written, &crc32c);
+    TF_RETURN_IF_ERROR(
+        WriteVariantTensor(val, out, &data_bytes_written, &crc32c));
   } else {
-    status_ = WriteTensor(val, out_.get(), &data_bytes_written);
-    crc32c = out_->crc32c();
+    TF_RETURN_IF_ERROR(WriteTensor(val, out, &data_bytes_written));
+    crc32c = out->crc32c();
   }
 
-  if (status_.ok()) {
-    entry->set_size(data_bytes_written);
-    entry->set_crc32c(crc32c::Mask(crc32c));
-    size_ += data_bytes_written;
-    status_ = PadAlignment(out_.get(), options_.data_alignment, &size_);
+  entry->set_size(data_bytes_written);
+  entry->set_crc32c(crc32c::Mask(crc32c));
+  shard->size += data_bytes_written;
+  return PadAlignment(out, options_.data_alignment, &shard->size);
+}
+
+Status BundleWriter::Add(StringPiece key, const Tensor& val) {
+  const string key_string(key);
+  DataShard* shard = nullptr;
+  {
+    mutex_lock l(mu_);
+    if (!status_.ok()) return status_;
+    CHECK_NE(key, kHeaderEntryKey);
+    if (entries_.find(key_string) != entries_.end()) {
+      status_ = errors::InvalidArgument("Adding duplicate key: ", key);
+      return status_;
+    }
+
+    // The tensor goes to the shard with the fewest bytes so far.
+    int32 shard_id = 0;
+    for (int32 i = 1; i < shards_.size(); ++i) {
+      if (shards_[i]->added_bytes < shards_[shard_id]->added_bytes) {
+        shard_id = i;
+      }
+    }
+    shard = shards_[shard_id].get();
+    shard->added_bytes += val.TotalBytes();
+
+    BundleEntryProto* entry = &entries_[key_string];
+    entry->set_dtype(val.dtype());
+    val.shape().AsProto(entry->mutable_shape());
+    entry->set_shard_id(shard_id);
   }
-  return status_;
+
+  auto write = [this, shard, key_string](const Tensor& tensor) {
+    {
+      mutex_lock l(mu_);
+      if (!status_.ok()) return;
+    }
+    BundleEntryProto written;
+    Status s = WriteToShard(tensor, shard, &written);
+    mutex_lock l(mu_);
+    if (!s.ok()) {
+      status_.Update(s);
+      return;
+    }
+    BundleEntryProto* entry = &entries_[key_string];
+    entry->set_offset(written.offset());
+    entry->set_size(written.size());
+    entry->set_crc32c(written.crc32c());
+  };
+  if (shard->thread == nullptr) {
+    write(val);
+    return status();
+  }
+  const Tensor to_write =
+      options_.snapshot_tensors ? tensor::DeepCopy(val) : val;
+  shard->thread->Schedule([write, to_write]() { write(to_write); });
+  return Status::OK();
 }
 
 Status BundleWriter::AddSlice(StringPiece full_tensor_key,
                               const TensorShape& full_tensor_shape,
                               const TensorSlice& slice_spec,
                               const Tensor& slice_tensor) {
-  if (!status_.ok()) return status_;
+  TF_RETURN_IF_ERROR(status());
   CHECK_NE(full_tensor_key, kHeaderEntryKey);
 
   // If just a singleton full slice, use the regular Add() to be more efficient.
@@ -491,43 +573,82 @@ Status BundleWriter::AddSlice(StringPiece full_tensor_key,
   // the "slices" field of multiple metadata entries corresponding to the same
   // full tensor.
   const string full_tensor_key_string(full_tensor_key);
-  BundleEntryProto* full_entry = &entries_[full_tensor_key_string];
-  if (full_entry->dtype() != DT_INVALID) {
-    CHECK_EQ(full_entry->dtype(), slice_tensor.dtype());
-  }
-  if (full_entry->has_shape()) {
-    CHECK(TensorShape(full_entry->shape()) == full_tensor_shape);
-  }
+  {
+    mutex_lock l(mu_);
+    BundleEntryProto* full_entry = &entries_[full_tensor_key_string];
+    if (full_entry->dtype() != DT_INVALID) {
+      CHECK_EQ(full_entry->dtype(), slice_tensor.dtype());
+    }
+    if (full_entry->has_shape()) {
+      CHECK(TensorShape(full_entry->shape()) == full_tensor_shape);
+    }
 
-  // Populates dtype, shape, and slices.  Intentionally leaving out shard_id and
-  // offset, which do not make sense for this full tensor entry.
-  full_entry->set_dtype(slice_tensor.dtype());
-  full_tensor_shape.AsProto(full_entry->mutable_shape());
-  TensorSliceProto* slice_proto = full_entry->add_slices();
-  slice_spec.AsProto(slice_proto);
+    // Populates dtype, shape, and slices.  Intentionally leaving out shard_id
+    // and offset, which do not make sense for this full tensor entry.
+    full_entry->set_dtype(slice_tensor.dtype());
+    full_tensor_shape.AsProto(full_entry->mutable_shape());
+    TensorSliceProto* slice_proto = full_entry->add_slices();
+    slice_spec.AsProto(slice_proto);
+  }
 
   // The slice itself is handled by a regular Add(), which includes adding its
   // own metadata entry, and writing out the slice's values.
   const string slice_name =
       checkpoint::EncodeTensorNameSlice(full_tensor_key_string, slice_spec);
-  status_ = Add(slice_name, slice_tensor);
-  return status_;
+  return Add(slice_name, slice_tensor);
+}
+
+Status BundleWriter::AddRows(StringPiece key, const Tensor& row_ids,
+                             const Tensor& rows) {
+  TF_RETURN_IF_ERROR(status());
+  if (row_ids.dtype() != DT_INT64 || row_ids.dims() != 1) {
+    return errors::InvalidArgument("The row ids of ", key,
+                                   " must be a 1-D int64 tensor, got ",
+                                   DataTypeString(row_ids.dtype()), " ",
+                                   row_ids.shape().DebugString());
+  }
+  if (rows.dims() < 1 || rows.dim_size(0) != row_ids.dim_size(0)) {
+    return errors::InvalidArgument("Expected ", row_ids.dim_size(0),
+                                   " rows of ", key, ", got shape ",
+                                   rows.shape().DebugString());
+  }
+  if (!DataTypeCanUseMemcpy(rows.dtype())) {
+    return errors::Unimplemented("Rows of ", DataTypeString(rows.dtype()),
+                                 " tensors cannot be saved: ", key);
+  }
+  TF_RETURN_IF_ERROR(Add(key, rows));
+  return Add(RowIdsKey(key), row_ids);
+}
+
+void BundleWriter::DeleteDataFiles() {
+  for (const auto& shard : shards_) {
+    Env::Default()->DeleteFile(shard->temp_path).IgnoreError();
+  }
 }
 
 // TODO(zongheng): on metadata write failure or !status_.ok(), consider removing
 // the orphaned data file.
 Status BundleWriter::Finish() {
-  if (out_) {
-    status_.Update(out_->Close());
-    out_ = nullptr;
+  // Waits for the writes still running in the background.
+  for (auto& shard : shards_) {
+    shard->thread.reset();
+  }
+  mutex_lock l(mu_);
+  if (!shards_.empty()) {
+    for (const auto& shard : shards_) {
+      status_.Update(shard->out->Close());
+    }
     if (status_.ok()) {
       if (use_temp_file_) {
-        status_ =
-            Env::Default()->RenameFile(data_path_, DataFilename(prefix_, 0, 1));
+        for (const auto& shard : shards_) {
+          status_ = Env::Default()->RenameFile(shard->temp_path, shard->path);
+          if (!status_.ok()) break;
+        }
       }
     } else {
-      Env::Default()->DeleteFile(data_path_).IgnoreError();
+      DeleteDataFiles();
     }
+    shards_.clear();
   }
   if (!status_.ok()) return status_;
   // Build key -> BundleEntryProto table.
@@ -542,7 +663,7 @@ Status BundleWriter::Finish() {
     table::TableBuilder builder(options, file.get());
     // Header entry.
     BundleHeaderProto header;
-    header.set_num_shards(1);
+    header.set_num_shards(options_.num_data_shards);
     header.set_endianness(BundleHeaderProto::LITTLE);
     if (!port::kLittleEndian) header.set_endianness(BundleHeaderProto::BIG);
     VersionDef* version = header.mutable_version();
@@ -569,6 +690,10 @@ Status BundleWriter::Finish() {
   return Status::OK();
 }
 
+void BundleWriter::FinishAsync(std::function<void(const Status&)> done) {
+  env_->SchedClosure([this, done]() { done(Finish()); });
+}
+
 // Merging tensor bundles.
 
 // Accumulator of metadata states during a merge.
@@ -950,6 +1075,51 @@ Status BundleReader::Lookup(StringPiece key, Tensor* val) {
   }
 }
 
+Status BundleReader::LookupDelta(StringPiece key, Tensor* val) {
+  CHECK(val != nullptr);
+  BundleEntryProto entry;
+  TF_RETURN_IF_ERROR(GetBundleEntryProto(key, &entry));
+  const string row_ids_key = RowIdsKey(key);
+  if (!Contains(row_ids_key)) {
+    return Lookup(key, val);
+  }
+
+  BundleEntryProto row_ids_entry;
+  TF_RETURN_IF_ERROR(GetBundleEntryProto(row_ids_key, &row_ids_entry));
+  Tensor row_ids(row_ids_entry.dtype(), TensorShape(row_ids_entry.shape()));
+  TF_RETURN_IF_ERROR(GetValue(row_ids_entry, &row_ids));
+  Tensor rows(entry.dtype(), TensorShape(entry.shape()));
+  TF_RETURN_IF_ERROR(GetValue(entry, &rows));
+
+  // The rows must be rows of "val".
+  TensorShape row_shape = rows.shape();
+  row_shape.RemoveDim(0);
+  TensorShape val_row_shape = val->shape();
+  if (val_row_shape.dims() > 0) val_row_shape.RemoveDim(0);
+  if (rows.dtype() != val->dtype() || val->dims() < 1 ||
+      row_shape != val_row_shape) {
+    return errors::InvalidArgument(
+        "Rows of ", key, " of type ", DataTypeString(rows.dtype()),
+        " and shape ", rows.shape().DebugString(), " do not fit a tensor of ",
+        "type ", DataTypeString(val->dtype()), " and shape ",
+        val->shape().DebugString());
+  }
+  const int64 num_rows = val->dim_size(0);
+  const size_t row_bytes =
+      row_shape.num_elements() * DataTypeSize(rows.dtype());
+  const char* src = rows.tensor_data().data();
+  char* dst = const_cast<char*>(val->tensor_data().data());
+  const auto ids = row_ids.flat<int64>();
+  for (int64 i = 0; i < ids.size(); ++i) {
+    if (ids(i) < 0 || ids(i) >= num_rows) {
+      return errors::DataLoss("Row id ", ids(i), " of ", key,
+                              " is out of range [0, ", num_rows, ")");
+    }
+    std::memcpy(dst + ids(i) * row_bytes, src + i * row_bytes, row_bytes);
+  }
+  return Status::OK();
+}
+
 Status BundleReader::ReadCurrent(Tensor* val) {
   CHECK(val != nullptr);
   BundleEntryProto entry;
@@ -61,9 +61,11 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_UTIL_TENSOR_BUNDLE_TENSOR_BUNDLE_H_
 #define TENSORFLOW_CORE_UTIL_TENSOR_BUNDLE_TENSOR_BUNDLE_H_
 
+#include <functional>
 #include <map>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
@@ -76,6 +78,9 @@ limitations under the License.
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/file_system.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/threadpool.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/protobuf/tensor_bundle.pb.h"
 #include "tensorflow/core/util/tensor_bundle/naming.h"
@@ -99,6 +104,10 @@ extern const int kTensorBundleVersion;
 // corresponding value is a BundleHeaderProto.
 extern const char* const kHeaderEntryKey;
 
+// Returns the key under which a delta bundle stores the ids of the rows of
+// "key" it holds. See BundleWriter::AddRows().
+string RowIdsKey(StringPiece key);
+
 // Builds a string-string table of tensor names to BundleEntryProto (metadata).
 //
 // On construction, attempts to create a directory given by the dirname of
@@ -112,9 +121,20 @@ class BundleWriter {
     // Alignment, in bytes, for tensor data.
     // Must be >= 1. The default size of 1 densely packs tensors.
     int data_alignment{1};
+    // Number of data files the tensors are spread over, each written by its
+    // own thread. With more than one, Add() only schedules the write of the
+    // tensor and returns, and the tensor must not be modified until Finish()
+    // returns, unless "snapshot_tensors" is set. Errors of the writes are
+    // returned by the following calls.
+    // Must be >= 1.
+    int num_data_shards{1};
+    // Whether Add() copies the tensors written in the background, so that
+    // the caller may modify them as soon as Add() returns.
+    bool snapshot_tensors{false};
   };
   BundleWriter(Env* env, StringPiece prefix,
                const Options& options = Options());
+  ~BundleWriter();
 
   // Adds the tensor "val" under key "key".
   // Across calls "key" must be unique but can be added in any order.
@@ -140,22 +160,53 @@ class BundleWriter {
                   const TensorShape& full_tensor_shape,
                   const TensorSlice& slice_spec, const Tensor& slice_tensor);
 
-  // Finishes the writer and flushes.
+  // Incremental checkpoints support.
+  // Adds rows "row_ids" of the tensor keyed by "key", with values "rows", to
+  // a delta bundle, which only holds what changed since a full bundle was
+  // written. "rows" is stored under "key" and the ids, a 1-D int64 tensor,
+  // under RowIdsKey(key). BundleReader::LookupDelta() applies them on top of
+  // the tensor read from the full bundle or from the preceding deltas.
+  //
+  // Tracking which rows changed is up to the caller, for instance through the
+  // indices of the sparse updates applied since the last checkpoint.
+  Status AddRows(StringPiece key, const Tensor& row_ids, const Tensor& rows);
+
+  // Finishes the writer and flushes. Waits for the writes of the data files
+  // to complete before writing the metadata file, which is the last file
+  // written.
   Status Finish() TF_MUST_USE_RESULT;
 
-  Status status() const { return status_; }
+  // Runs Finish() in the background and calls "done" with its result. The
+  // writer must not be used or destroyed until "done" is called.
+  void FinishAsync(std::function<void(const Status&)> done);
+
+  Status status() const {
+    mutex_lock l(mu_);
+    return status_;
+  }
 
  private:
+  // A data file and its writer.
+  struct DataShard;
+
+  // Writes the bytes of "val" at the end of "shard" and sets the offset, size
+  // and checksum of "entry" accordingly.
+  Status WriteToShard(const Tensor& val, DataShard* shard,
+                      BundleEntryProto* entry);
+
+  // Deletes the data files, which are incomplete.
+  void DeleteDataFiles();
+
   Env* const env_;  // Not owned.
   const Options options_;
   const string prefix_;
   string metadata_path_;
-  string data_path_;
   bool use_temp_file_;
-  std::unique_ptr<FileOutputBuffer> out_;
-  int64 size_;  // Number of bytes written into out_.
-  std::map<string, BundleEntryProto> entries_;
-  Status status_;
+  std::vector<std::unique_ptr<DataShard>> shards_;
+
+  mutable mutex mu_;
+  std::map<string, BundleEntryProto> entries_ TF_GUARDED_BY(mu_);
+  Status status_ TF_GUARDED_BY(mu_);
 
   TF_DISALLOW_COPY_AND_ASSIGN(BundleWriter);
 };
@@ -219,6 +270,16 @@ class BundleReader {
   // REQUIRES: status().ok()
   Status Lookup(StringPiece key, Tensor* val) TF_MUST_USE_RESULT;
 
+  // Applies the entry of "key" of a delta bundle to "val", which holds the
+  // tensor as of the previous bundle. If this bundle has rows of the tensor,
+  // added by BundleWriter::AddRows(), only those rows of "val" are replaced;
+  // otherwise "val" is read in full, like with Lookup().
+  //
+  // Returns a NotFound error if the tensor did not change since the previous
+  // bundle, in which case "val" is left untouched.
+  // REQUIRES: status().ok()
+  Status LookupDelta(StringPiece key, Tensor* val) TF_MUST_USE_RESULT;
+
   // Looks up the tensor pointed to by the internal iterator.
   //
   // On error, "val" may contain nonsense data.
@@ -261,15 +322,17 @@ class BundleReader {
   // REQUIRES: status().ok() && Valid()
   StringPiece value() const { return iter_->value(); }
 
-  string DebugString();
-
- private:
-  // Seeks for "key" and reads the metadata proto.
+  // Seeks for "key" and reads the metadata proto, which tells where the data
+  // of the tensor is, for instance to order reads.
   // On non-OK return, clears "entry" for the caller.
   // REQUIRES: status().ok()
   Status GetBundleEntryProto(StringPiece key,
                              BundleEntryProto* entry) TF_MUST_USE_RESULT;
 
+  string DebugString();
+
+ private:
+
   // Reads the tensor value described by the metadata proto "entry".
   // Usage for "val" follows the comment of "Lookup()".
   Status GetValue(const BundleEntryProto& entry,
@@ -29,6 +29,7 @@ limitations under the License.
 #include "tensorflow/core/lib/io/table_builder.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/notification.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/test_benchmark.h"
 #include "tensorflow/core/util/tensor_bundle/byte_swap.h"
@@ -882,6 +883,115 @@ TEST(TensorBundleTest, DirectoryStructure) {
                           "merged.data-00001-of-00002"});
 }
 
+TEST(TensorBundleTest, DataShards) {
+  Env* env = Env::Default();
+  const string prefix = Prefix("data_shards");
+  {
+    BundleWriter::Options options;
+    options.num_data_shards = 3;
+    options.data_alignment = 8;
+    BundleWriter writer(env, prefix, options);
+    TF_ASSERT_OK(writer.status());
+    for (int i = 0; i < 10; ++i) {
+      TF_EXPECT_OK(writer.Add(strings::StrCat("float", i),
+                              Constant(static_cast<float>(i),
+                                       TensorShape({i + 1, 100}))));
+    }
+    TF_EXPECT_OK(
+        writer.Add("string", Constant(tstring("abc"), TensorShape({5}))));
+    TF_EXPECT_OK(writer.AddSlice("partitioned", TensorShape({4, 3}),
+                                 TensorSlice::ParseOrDie("0,2:-"),
+                                 Constant_2x3<int32>(7)));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  for (int shard_id = 0; shard_id < 3; ++shard_id) {
+    TF_EXPECT_OK(env->FileExists(DataFilename(prefix, shard_id, 3)));
+  }
+
+  BundleReader reader(env, prefix);
+  TF_ASSERT_OK(reader.status());
+  for (int i = 0; i < 10; ++i) {
+    Expect<float>(&reader, strings::StrCat("float", i),
+                  Constant(static_cast<float>(i), TensorShape({i + 1, 100})));
+  }
+  Expect<tstring>(&reader, "string",
+                  Constant(tstring("abc"), TensorShape({5})));
+  Tensor slice(DT_INT32, TensorShape({2, 3}));
+  TF_ASSERT_OK(reader.LookupSlice(
+      "partitioned", TensorSlice::ParseOrDie("0,2:-"), &slice));
+  test::ExpectTensorEqual<int32>(Constant_2x3<int32>(7), slice);
+}
+
+TEST(TensorBundleTest, SnapshotTensors) {
+  Env* env = Env::Default();
+  const string prefix = Prefix("snapshot_tensors");
+  BundleWriter::Options options;
+  options.num_data_shards = 2;
+  options.snapshot_tensors = true;
+  BundleWriter writer(env, prefix, options);
+  Tensor val = Constant_2x3<float>(1.f);
+  TF_EXPECT_OK(writer.Add("foo", val));
+  // Modifying the tensor once added does not change what is written.
+  val.flat<float>().setConstant(2.f);
+  Notification done;
+  Status status;
+  writer.FinishAsync([&done, &status](const Status& s) {
+    status = s;
+    done.Notify();
+  });
+  done.WaitForNotification();
+  TF_ASSERT_OK(status);
+
+  BundleReader reader(env, prefix);
+  TF_ASSERT_OK(reader.status());
+  Expect<float>(&reader, "foo", Constant_2x3<float>(1.f));
+}
+
+TEST(TensorBundleTest, Deltas) {
+  Env* env = Env::Default();
+  const string base_prefix = Prefix("deltas_base");
+  const string delta_prefix = Prefix("deltas_delta");
+  {
+    BundleWriter writer(env, base_prefix);
+    TF_EXPECT_OK(writer.Add("embedding", Constant(0.f, TensorShape({4, 2}))));
+    TF_EXPECT_OK(writer.Add("bias", Constant(0.f, TensorShape({2}))));
+    TF_EXPECT_OK(writer.Add("step", Constant<int64>(1, TensorShape({}))));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  {
+    BundleWriter writer(env, delta_prefix);
+    TF_EXPECT_OK(writer.AddRows("embedding", test::AsTensor<int64>({3, 1}),
+                                test::AsTensor<float>({3, 3, 1, 1}, {2, 2})));
+    TF_EXPECT_OK(writer.Add("step", Constant<int64>(2, TensorShape({}))));
+    TF_ASSERT_OK(writer.Finish());
+  }
+
+  BundleReader base(env, base_prefix);
+  TF_ASSERT_OK(base.status());
+  BundleReader delta(env, delta_prefix);
+  TF_ASSERT_OK(delta.status());
+  Tensor embedding(DT_FLOAT, TensorShape({4, 2}));
+  TF_ASSERT_OK(base.Lookup("embedding", &embedding));
+  TF_ASSERT_OK(delta.LookupDelta("embedding", &embedding));
+  test::ExpectTensorEqual<float>(
+      test::AsTensor<float>({0, 0, 1, 1, 0, 0, 3, 3}, {4, 2}), embedding);
+  // Tensors saved in full replace the previous ones.
+  Tensor step(DT_INT64, TensorShape({}));
+  TF_ASSERT_OK(base.Lookup("step", &step));
+  TF_ASSERT_OK(delta.LookupDelta("step", &step));
+  test::ExpectTensorEqual<int64>(Constant<int64>(2, TensorShape({})), step);
+  // Tensors missing from the delta did not change.
+  Tensor bias(DT_FLOAT, TensorShape({2}));
+  TF_ASSERT_OK(base.Lookup("bias", &bias));
+  EXPECT_TRUE(errors::IsNotFound(delta.LookupDelta("bias", &bias)));
+  // The rows must fit the tensor.
+  Tensor too_short(DT_FLOAT, TensorShape({2, 2}));
+  EXPECT_TRUE(errors::IsDataLoss(delta.LookupDelta("embedding", &too_short)));
+  Tensor too_wide(DT_FLOAT, TensorShape({4, 3}));
+  EXPECT_TRUE(
+      errors::IsInvalidArgument(delta.LookupDelta("embedding", &too_wide)));
+}
+
 TEST(TensorBundleTest, Error) {
   {  // Dup keys.
     BundleWriter writer(Env::Default(), Prefix("dup"));
@@ -895,6 +1005,19 @@ TEST(TensorBundleTest, Error) {
     EXPECT_TRUE(writer.Finish().ok());
     EXPECT_FALSE(writer.Finish().ok());
   }
+  {  // No data shards.
+    BundleWriter::Options options;
+    options.num_data_shards = 0;
+    BundleWriter writer(Env::Default(), Prefix("no_shards"), options);
+    EXPECT_TRUE(errors::IsInvalidArgument(writer.status()));
+  }
+  {  // Rows that do not match their ids.
+    BundleWriter writer(Env::Default(), Prefix("bad_rows"));
+    EXPECT_TRUE(errors::IsInvalidArgument(
+        writer.AddRows("foo", test::AsTensor<int64>({0}), Constant_2x3(1.f))));
+    EXPECT_TRUE(errors::IsInvalidArgument(writer.AddRows(
+        "foo", test::AsTensor<int32>({0, 1}), Constant_2x3(1.f))));
+  }
   {  // Not found.
     BundleReader reader(Env::Default(), Prefix("nonexist"));
     EXPECT_TRUE(absl::StrContains(reader.status().ToString(), "Not found"));
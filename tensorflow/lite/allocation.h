@@ -45,6 +45,13 @@ class Allocation {
   virtual size_t bytes() const = 0;
   // Whether the allocation is valid
   virtual bool valid() const = 0;
+  // Hints that the `size` bytes at `data` in the allocation are about to be
+  // read, so that their pages are read ahead.
+  virtual void PageIn(const void* data, size_t size) const {}
+  // Hints that the `size` bytes at `data` in the allocation won't be read for
+  // a while, so that their pages can be freed. The bytes stay readable, and
+  // are paged in again when read.
+  virtual void Evict(const void* data, size_t size) const {}
   // Return the type of the Allocation.
   Type type() const { return type_; }
 
@@ -64,6 +71,8 @@ class MMAPAllocation : public Allocation {
   const void* base() const override;
   size_t bytes() const override;
   bool valid() const override;
+  void PageIn(const void* data, size_t size) const override;
+  void Evict(const void* data, size_t size) const override;
 
   int fd() const { return mmap_fd_; }
 
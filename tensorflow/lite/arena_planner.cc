@@ -161,11 +161,14 @@ TfLiteStatus ArenaPlanner::PlanAllocations() {
   for (size_t i = 0; i < graph_info_->num_nodes(); ++i) {
     const TfLiteNode& node = graph_info_->node(i);
 
-    // First queue output tensors for allocation.
+    // First queue output tensors for allocation. The outputs of a node are
+    // live from the start of its stage, and its inputs until the end of it,
+    // since the other nodes of the stage may run at the same time.
     TfLiteIntArray* node_outputs = node.outputs;
     for (int j = 0; j < node_outputs->size; ++j) {
       int tensor_index = node_outputs->data[j];
-      TF_LITE_ENSURE_STATUS(allocate(i, tensor_index));
+      TF_LITE_ENSURE_STATUS(
+          allocate(graph_info_->first_node_of_stage(i), tensor_index));
     }
 
     // Then update the ref-counts of the node's inputs, and if necessary queue
@@ -177,7 +180,8 @@ TfLiteStatus ArenaPlanner::PlanAllocations() {
         if (tensor_index != kTfLiteOptionalTensor) {
           refcounts[tensor_index]--;
           if (refcounts[tensor_index] == 0) {
-            TF_LITE_ENSURE_STATUS(deallocate(i, tensor_index));
+            TF_LITE_ENSURE_STATUS(
+                deallocate(graph_info_->last_node_of_stage(i), tensor_index));
           }
         }
       }
@@ -204,8 +208,8 @@ TfLiteStatus ArenaPlanner::ExecuteAllocations(int first_node, int last_node) {
     TfLiteIntArray* node_temporaries = node.temporaries;
     for (int j = 0; j < node_temporaries->size; ++j) {
       int tensor_index = node_temporaries->data[j];
-      alloc_node_[tensor_index] = i;
-      dealloc_node_[tensor_index] = i;
+      alloc_node_[tensor_index] = graph_info_->first_node_of_stage(i);
+      dealloc_node_[tensor_index] = graph_info_->last_node_of_stage(i);
     }
   }
 
@@ -250,7 +254,7 @@ TfLiteStatus ArenaPlanner::AcquireNonPersistentMemory() {
 }
 
 bool ArenaPlanner::HasNonPersistentMemory() {
-  return arena_.GetBufferSize() != 0;
+  return arena_.HasCurrentBuffer();
 }
 
 TfLiteStatus ArenaPlanner::Commit() {
@@ -262,6 +266,13 @@ TfLiteStatus ArenaPlanner::Commit() {
 std::vector<int32_t> ArenaPlanner::CreateTensorAllocationVector(int first_node,
                                                                 int last_node) {
   auto tensor_compare = [this](int idx1, int idx2) {
+    // Tensors placed ahead of time are allocated first, so that the tensors
+    // planned at runtime fill the gaps around them.
+    const bool offline1 = HasOfflinePlannedOffset(idx1);
+    const bool offline2 = HasOfflinePlannedOffset(idx2);
+    if (offline1 || offline2) {
+      return offline1 && offline2 ? idx1 < idx2 : offline1;
+    }
     // Tensors that have lifespan through the whole model inference time are
     // allocated at the beginning of memory slice. Their respective order
     // doesn't matter in fact, so here they are sorted by index.
@@ -305,19 +316,33 @@ TfLiteStatus ArenaPlanner::CalculateAllocations(int first_node, int last_node) {
   const std::vector<int32_t> tensor_order =
       CreateTensorAllocationVector(first_node, last_node);
 
-  // Deallocate if the tensor was already allocated.
+  // Deallocate if the tensor was already allocated, unless it still fits.
+  std::vector<bool> keeps_allocation(graph_info_->num_tensors(), false);
   for (const auto& tensor_index : tensor_order) {
     TfLiteTensor& tensor = *graph_info_->tensor(tensor_index);
-    if (tensor.allocation_type == kTfLiteArenaRw &&
-        allocs_[tensor_index].size != 0) {
+    if (FitsInAllocation(tensor_index)) {
+      keeps_allocation[tensor_index] = true;
+    } else if (tensor.allocation_type == kTfLiteArenaRw &&
+               allocs_[tensor_index].size != 0) {
       TF_LITE_ENSURE_STATUS(arena_.Deallocate(context_, allocs_[tensor_index]));
+    } else if (tensor.allocation_type == kTfLiteArenaRwPersistent &&
+               allocs_[tensor_index].size != 0) {
+      TF_LITE_ENSURE_STATUS(
+          persistent_arena_.Deallocate(context_, allocs_[tensor_index]));
     }
   }
 
   // Vector of ids of already allocated tensors, ordered by offset.
   for (const auto& tensor_index : tensor_order) {
+    if (keeps_allocation[tensor_index]) continue;
     TfLiteTensor& tensor = *graph_info_->tensor(tensor_index);
-    if (tensor.allocation_type == kTfLiteArenaRw) {
+    if (tensor.allocation_type == kTfLiteArenaRw &&
+        !(HasOfflinePlannedOffset(tensor_index) &&
+          arena_.AllocateAt(tensor_alignment_, offline_offsets_[tensor_index],
+                            tensor.bytes, tensor_index,
+                            alloc_node_[tensor_index],
+                            dealloc_node_[tensor_index],
+                            &allocs_[tensor_index]))) {
       TF_LITE_ENSURE_STATUS(
           arena_.Allocate(context_, tensor_alignment_, tensor.bytes,
                           tensor_index, alloc_node_[tensor_index],
@@ -334,6 +359,20 @@ TfLiteStatus ArenaPlanner::CalculateAllocations(int first_node, int last_node) {
   return kTfLiteOk;
 }
 
+bool ArenaPlanner::FitsInAllocation(int tensor_index) const {
+  const TfLiteTensor& tensor = *graph_info_->tensor(tensor_index);
+  const ArenaAllocWithUsageInterval& alloc = allocs_[tensor_index];
+  // Zero-sized tensors are unallocated, and resolve to null.
+  if (alloc.size == 0 || tensor.bytes == 0 || tensor.bytes > alloc.size ||
+      alloc.first_node != alloc_node_[tensor_index]) {
+    return false;
+  }
+  if (tensor.allocation_type == kTfLiteArenaRw) {
+    return alloc.last_node == dealloc_node_[tensor_index];
+  }
+  return tensor.allocation_type == kTfLiteArenaRwPersistent;
+}
+
 TfLiteStatus ArenaPlanner::ResolveTensorAllocation(int tensor_index) {
   TfLiteTensor& tensor = *graph_info_->tensor(tensor_index);
   if (tensor.allocation_type == kTfLiteArenaRw) {
@@ -17,6 +17,7 @@ limitations under the License.
 
 #include <cstdint>
 #include <memory>
+#include <utility>
 #include <vector>
 
 #include "tensorflow/lite/c/common.h"
@@ -67,6 +68,24 @@ class ArenaPlanner : public MemoryPlanner {
   // Returns the base arena location for a given allocation type.
   std::intptr_t BasePointer(TfLiteAllocationType type);
 
+  // Sets the offsets in the non-persistent arena of the tensors whose memory
+  // was planned ahead of time, e.g. by the converter, indexed by tensor. A
+  // negative offset leaves the tensor to be planned at runtime. An offset
+  // which is not aligned, or overlaps with a tensor it's planned at runtime
+  // around (when planning resumes after dynamic tensors), is ignored.
+  // Takes effect at the next call to ExecuteAllocations.
+  void SetOfflinePlannedOffsets(std::vector<int32_t> offsets) {
+    offline_offsets_ = std::move(offsets);
+  }
+
+  // Makes the non-persistent arena of this planner use `buffer`, which may be
+  // shared with the arenas of other planners. The graphs of these planners
+  // may then never be in use at the same time, and each of them must acquire
+  // its memory again (see AcquireNonPersistentMemory) once another was used.
+  void ShareNonPersistentArena(std::shared_ptr<ArenaBuffer> buffer) {
+    arena_.ShareBuffer(std::move(buffer));
+  }
+
  private:
   // Make sure all the arenas have reserved enough memory to store all their
   // tensors.
@@ -74,18 +93,31 @@ class ArenaPlanner : public MemoryPlanner {
 
   // Returns vector of tensor number ordered by the following algorithm.
   // Comparator to sort tensors for the allocation algorithm:
+  // - Tensors whose offsets were planned ahead of time go first;
   // - Tensors that have lifespan through the whole model inference time go
-  // first;
+  // next;
   // - Other tensors (e.g. intermediate and temporary ones) are sorted in
   // non-increasing order of their size. If sizes of two tensors are equal, the
   // one that needs to be allocated earlier goes first.
   std::vector<int32_t> CreateTensorAllocationVector(int first_node,
                                                     int last_node);
 
+  // Returns whether the offset of the tensor was planned ahead of time.
+  bool HasOfflinePlannedOffset(int tensor_index) const {
+    return tensor_index < offline_offsets_.size() &&
+           offline_offsets_[tensor_index] >= 0;
+  }
+
   // Traverse the allocation queue and reserve space in the appropriate arena
   // for all tensors affected by ops in the interval [first_node, last_node].
+  // The tensors whose allocations weren't reset, and still fit in them, keep
+  // them.
   TfLiteStatus CalculateAllocations(int first_node, int last_node);
 
+  // Returns true if the tensor still fits in its allocation, for the same
+  // nodes it was allocated for.
+  bool FitsInAllocation(int tensor_index) const;
+
   // Assign absolute memory location to a tensor, based on its relative
   // position inside the corresponding arena buffer.
   TfLiteStatus ResolveTensorAllocation(int tensor_index);
@@ -131,6 +163,10 @@ class ArenaPlanner : public MemoryPlanner {
 
   // Number of bytes that tensor buffers should be aligned to.
   int tensor_alignment_;
+
+  // The offsets of the tensors planned ahead of time, see
+  // SetOfflinePlannedOffsets.
+  std::vector<int32_t> offline_offsets_;
 };
 
 }  // namespace tflite
@@ -282,6 +282,68 @@ TEST_F(ArenaPlannerTest, SimpleGraph) {
   EXPECT_EQ(GetOffset(1), 0);
 }
 
+TEST_F(ArenaPlannerTest, SimpleGraphWithOfflinePlannedOffsets) {
+  TestGraph graph({0, 1},
+                  {
+                      /* in, out, tmp */
+                      {{0, 1}, {2}, {}},     // First op
+                      {{2, 0}, {4, 5}, {}},  // Second op
+                      {{4, 5}, {3}, {}}      // Third op
+                  },
+                  {3});
+  SetGraph(&graph);
+  // The offset of tensor 1 is not aligned, so it's planned at runtime.
+  planner_->SetOfflinePlannedOffsets({-1, 7, 200, 100, -1, -1});
+  Execute(0, 10);
+
+  EXPECT_EQ(GetOffset(2), 200);
+  EXPECT_EQ(GetOffset(3), 100);
+  // The other tensors are placed in the best fitting gaps around them.
+  EXPECT_EQ(GetOffset(5), GetOffsetAfter(3));
+  EXPECT_EQ(GetOffset(4), GetOffsetAfter(5));
+  EXPECT_EQ(GetOffset(0), GetOffsetAfter(4));
+  EXPECT_EQ(GetOffset(1), 0);
+}
+
+TEST_F(ArenaPlannerTest, SharedNonPersistentArena) {
+  TestGraph graph({0, 1},
+                  {
+                      /* in, out, tmp */
+                      {{0, 1}, {2}, {}},     // First op
+                      {{2, 0}, {4, 5}, {}},  // Second op
+                      {{4, 5}, {3}, {}}      // Third op
+                  },
+                  {3});
+  SetGraph(&graph);
+  // A graph with larger tensors, which needs a larger arena.
+  TestGraph other_graph({0}, {{{0}, {8}, {}}, {{8}, {9}, {}}}, {9});
+  ArenaPlanner other_planner(
+      &context_, std::unique_ptr<GraphInfo>(new TestGraphInfo(&other_graph)),
+      /*preserve_inputs=*/false, /*preserve_intermediates=*/false,
+      kTensorAlignment);
+  ASSERT_EQ(other_planner.PlanAllocations(), kTfLiteOk);
+  auto buffer = std::make_shared<ArenaBuffer>();
+  planner_->ShareNonPersistentArena(buffer);
+  other_planner.ShareNonPersistentArena(buffer);
+
+  Execute(0, 10);
+  EXPECT_TRUE(HasNonPersistentMemory());
+  const std::ptrdiff_t offset = GetOffset(4);
+
+  // Growing the shared buffer for the other graph moves it.
+  ASSERT_EQ(other_planner.ExecuteAllocations(0, 10), kTfLiteOk);
+  EXPECT_TRUE(other_planner.HasNonPersistentMemory());
+  EXPECT_FALSE(HasNonPersistentMemory());
+  EXPECT_EQ(planner_->BasePointer(kTfLiteArenaRw),
+            other_planner.BasePointer(kTfLiteArenaRw));
+
+  AcquireNonPersistentMemory();
+  EXPECT_TRUE(HasNonPersistentMemory());
+  EXPECT_EQ(GetOffset(4), offset);
+  // The other graph's allocations still resolve into the buffer.
+  EXPECT_TRUE(other_planner.HasNonPersistentMemory());
+}
+
 TEST_F(ArenaPlannerTest, SimpleGraphInputsPreserved) {
   TestGraph graph({0, 1},
                   {
@@ -355,6 +417,38 @@ TEST_F(ArenaPlannerTest, SimpleGraphWithResetAllocationsAfter) {
   EXPECT_TRUE(IsUnallocated(5));
 }
 
+TEST_F(ArenaPlannerTest, SimpleGraphKeepsAllocationsWhichFit) {
+  TestGraph graph({0, 1},
+                  {
+                      /* in, out, tmp */
+                      {{0, 1}, {2}, {}},   // First op
+                      {{2, 0}, {4}, {5}},  // Second op, with temporary
+                      {{4}, {3}, {}}       // Third op
+                  },
+                  {3});
+  SetGraph(&graph);
+  Execute(0, 10);
+
+  // Alloc(+) and dealloc(-) order: +0 +1 +2 -1 +5 +4 -2 -0 -5 +3 -4
+  const std::ptrdiff_t offset0 = GetOffset(0);
+  const std::ptrdiff_t offset2 = GetOffset(2);
+  const std::ptrdiff_t offset4 = GetOffset(4);
+
+  // Shrink #4 and grow #2 beyond its allocation, without resetting them.
+  (*graph.tensors())[4].bytes = 4;
+  (*graph.tensors())[2].bytes = 40;
+  Execute(0, 10);
+
+  EXPECT_EQ(GetOffset(3), 0);
+  EXPECT_EQ(GetOffset(5), 0);
+  EXPECT_EQ(GetOffset(4), offset4);
+  EXPECT_EQ(GetOffset(0), offset0);
+  EXPECT_EQ(GetOffset(1), 0);
+  // #2 no longer fits between #4 and #0, so it goes after #0.
+  EXPECT_NE(GetOffset(2), offset2);
+  EXPECT_EQ(GetOffset(2), GetOffsetAfter(0));
+}
+
 TEST_F(ArenaPlannerTest, SimpleGraphWithOptionals) {
   TestGraph graph({0, -1, 1},
                   {
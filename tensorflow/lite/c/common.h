@@ -512,6 +512,12 @@ typedef struct TfLiteNode {
   // created by calling `interpreter.ModifyGraphWithDelegate`.
   // WARNING: This is an experimental interface that is subject to change.
   struct TfLiteDelegate* delegate;
+
+  // Set by `prepare` to the inputs the node copied, e.g. to repack constant
+  // weights, and won't read during `invoke`. Bit i stands for inputs->data[i].
+  // The pages of those mapped from the model file can then be freed.
+  // WARNING: This is an experimental interface that is subject to change.
+  uint64_t copied_inputs_mask;
 } TfLiteNode;
 #else  // defined(TF_LITE_STATIC_MEMORY)?
 // NOTE: This flag is opt-in only at compile time.
@@ -17,6 +17,8 @@ limitations under the License.
 
 #include <algorithm>
 #include <cstdint>
+#include <memory>
+#include <utility>
 
 #include "tensorflow/lite/arena_planner.h"
 #include "tensorflow/lite/c/common.h"
@@ -186,6 +188,14 @@ class InterpreterInfo : public GraphInfo {
   const std::vector<int>& variables() const override {
     return subgraph_->variables();
   }
+  size_t first_node_of_stage(size_t index) const override {
+    const auto& stages = subgraph_->execution_stages();
+    return index < stages.size() ? stages[index].first : index;
+  }
+  size_t last_node_of_stage(size_t index) const override {
+    const auto& stages = subgraph_->execution_stages();
+    return index < stages.size() ? stages[index].second : index;
+  }
 
  public:
   Subgraph* subgraph_;
@@ -381,6 +391,7 @@ TfLiteStatus Subgraph::ReplaceNodeSubsetsWithDelegateKernels(
       node_subsets.size());
 
   execution_plan_.clear();
+  execution_stages_.clear();
 
   for (auto& node_subset : node_subsets) {
     // Subsets claimed by the delegate should have a "macro" op created, the
@@ -432,7 +443,14 @@ TfLiteExternalContext* Subgraph::GetExternalContext(
 
 TfLiteExternalContext* Subgraph::GetExternalContext(
     struct TfLiteContext* context, TfLiteExternalContextType type) {
-  return static_cast<Subgraph*>(context->impl_)->GetExternalContext(type);
+  Subgraph* subgraph = static_cast<Subgraph*>(context->impl_);
+  const std::vector<TfLiteContext>& workers = subgraph->worker_contexts_;
+  if (type == kTfLiteCpuBackendContext && !workers.empty() &&
+      context >= workers.data() && context < workers.data() + workers.size()) {
+    return subgraph->worker_cpu_backend_contexts_[context - workers.data()]
+        .get();
+  }
+  return subgraph->GetExternalContext(type);
 }
 
 void Subgraph::SetExternalContext(TfLiteExternalContextType type,
@@ -548,6 +566,44 @@ void Subgraph::SetCancellationFunction(void* data,
   check_cancelled_func_ = check_cancelled_func;
 }
 
+TfLiteStatus Subgraph::SetOfflinePlannedTensorOffsets(
+    std::vector<int32_t> offsets) {
+  TF_LITE_ENSURE(&context_, memory_planner_ == nullptr);
+  TF_LITE_ENSURE_EQ(&context_, offsets.size(), tensors_.size());
+  offline_planned_tensor_offsets_ = std::move(offsets);
+  return kTfLiteOk;
+}
+
+bool Subgraph::ShareNonPersistentArenaWith(Subgraph* other) {
+  if (shared_arena_buffer_ &&
+      shared_arena_buffer_ == other->shared_arena_buffer_) {
+    return true;
+  }
+  if (other == this || memory_planner_ || other->memory_planner_ ||
+      (shared_arena_buffer_ && other->shared_arena_buffer_)) {
+    return false;
+  }
+  if (!shared_arena_buffer_) {
+    shared_arena_buffer_ = other->shared_arena_buffer_
+                               ? other->shared_arena_buffer_
+                               : std::make_shared<ArenaBuffer>();
+  }
+  other->shared_arena_buffer_ = shared_arena_buffer_;
+  return true;
+}
+
+void Subgraph::SetParallelNodeExecution(bool enable) {
+  if (parallel_node_execution_ == enable) {
+    return;
+  }
+  parallel_node_execution_ = enable;
+  // Replan the execution stages and the memory at the next AllocateTensors.
+  if (state_ == kStateInvokable) {
+    state_ = kStateUninvokable;
+  }
+  only_inputs_resized_ = false;
+}
+
 bool Subgraph::IsCancelled() {
   return (check_cancelled_func_ != nullptr) &&
          (*check_cancelled_func_)(cancellation_data_);
@@ -647,14 +703,50 @@ TfLiteStatus Subgraph::AllocateTensors() {
     return kTfLiteOk;
   }
 
+  bool stages_changed = false;
+  PlanExecutionStages(&stages_changed);
+
+  // If only inputs were resized, only the nodes their new shapes propagate to
+  // are prepared again, and the tensors keep their allocations if they fit.
+  const bool incremental =
+      only_inputs_resized_ && !stages_changed && memory_planner_;
+  only_inputs_resized_ = false;
+
   next_execution_plan_index_to_prepare_ = 0;
   next_execution_plan_index_to_plan_allocation_ = 0;
   next_original_execution_plan_index_to_prepare_ = 0;
-  if (memory_planner_) {
-    TF_LITE_ENSURE_STATUS(memory_planner_->ResetAllocations());
+  if (memory_planner_ && !incremental) {
+    if (stages_changed) {
+      TF_LITE_ENSURE_STATUS(memory_planner_->PlanAllocations());
+    } else {
+      TF_LITE_ENSURE_STATUS(memory_planner_->ResetAllocations());
+    }
   }
 
-  TF_LITE_ENSURE_STATUS(PrepareOpsAndTensors());
+  prepare_resized_nodes_only_ = incremental;
+  const TfLiteStatus prepare_status = PrepareOpsAndTensors();
+  prepare_resized_nodes_only_ = false;
+  resized_tensors_.clear();
+  TF_LITE_ENSURE_STATUS(prepare_status);
+
+  // The nodes of a stage can only run concurrently if the whole graph is
+  // prepared ahead of Invoke, and none of them resizes its tensors in Invoke.
+  if (!execution_stages_.empty()) {
+    bool dynamic = next_execution_plan_index_to_prepare_ !=
+                   static_cast<int>(execution_plan_.size());
+    for (int node_index : execution_plan_) {
+      dynamic |= HasDynamicTensor(
+          context_, nodes_and_registration_[node_index].first.temporaries);
+    }
+    if (dynamic) {
+      execution_stages_.clear();
+      next_execution_plan_index_to_prepare_ = 0;
+      next_execution_plan_index_to_plan_allocation_ = 0;
+      next_original_execution_plan_index_to_prepare_ = 0;
+      TF_LITE_ENSURE_STATUS(memory_planner_->PlanAllocations());
+      TF_LITE_ENSURE_STATUS(PrepareOpsAndTensors());
+    }
+  }
 
   state_ = kStateInvokable;
 
@@ -685,6 +777,54 @@ TfLiteStatus Subgraph::ResetVariableTensors() {
   return kTfLiteOk;
 }
 
+TfLiteStatus Subgraph::PageInConstantTensors() {
+  // Whether the tensor is constant, and its bytes are in its allocation.
+  auto is_in_allocation = [](const TfLiteTensor& tensor) {
+    if (tensor.allocation_type != kTfLiteMmapRo ||
+        tensor.allocation == nullptr || tensor.data.raw_const == nullptr) {
+      return false;
+    }
+    const Allocation* allocation =
+        static_cast<const Allocation*>(tensor.allocation);
+    const char* base = static_cast<const char*>(allocation->base());
+    return tensor.data.raw_const >= base &&
+           tensor.data.raw_const + tensor.bytes <= base + allocation->bytes();
+  };
+
+  // The constant tensors read by the nodes during invoke, in the order they
+  // are first read.
+  std::vector<bool> read_by_invoke(tensors_.size(), false);
+  std::vector<int> read_order;
+  for (int node_index : execution_plan_) {
+    const TfLiteNode& node = nodes_and_registration_[node_index].first;
+    for (int i = 0; i < node.inputs->size; ++i) {
+      const int tensor_index = node.inputs->data[i];
+      if (tensor_index == kTfLiteOptionalTensor) continue;
+      const bool copied = i < 64 && (node.copied_inputs_mask >> i) & 1;
+      if (copied || read_by_invoke[tensor_index] ||
+          !is_in_allocation(tensors_[tensor_index])) {
+        continue;
+      }
+      read_by_invoke[tensor_index] = true;
+      read_order.push_back(tensor_index);
+    }
+  }
+
+  for (int i = 0; i < tensors_.size(); ++i) {
+    const TfLiteTensor& tensor = tensors_[i];
+    if (!read_by_invoke[i] && is_in_allocation(tensor)) {
+      static_cast<const Allocation*>(tensor.allocation)
+          ->Evict(tensor.data.raw_const, tensor.bytes);
+    }
+  }
+  for (int tensor_index : read_order) {
+    const TfLiteTensor& tensor = tensors_[tensor_index];
+    static_cast<const Allocation*>(tensor.allocation)
+        ->PageIn(tensor.data.raw_const, tensor.bytes);
+  }
+  return kTfLiteOk;
+}
+
 TfLiteStatus Subgraph::AddNodeWithParameters(
     const std::vector<int>& inputs, const std::vector<int>& outputs,
     const std::vector<int>& intermediates, const char* init_data,
@@ -697,6 +837,7 @@ TfLiteStatus Subgraph::AddNodeWithParameters(
     return kTfLiteError;
   }
   state_ = kStateUninvokable;
+  only_inputs_resized_ = false;
 
   TF_LITE_ENSURE_OK(&context_, CheckTensorIndices("node inputs", inputs.data(),
                                                   inputs.size()));
@@ -743,9 +884,11 @@ TfLiteStatus Subgraph::AddNodeWithParameters(
   }
 
   node.delegate = nullptr;
+  node.copied_inputs_mask = 0;
   // Copying of registration is required to support unresolved custom ops.
   node_and_reg.second = *registration;
   execution_plan_.push_back(new_node_index);
+  execution_stages_.clear();
   return kTfLiteOk;
 }
 
@@ -779,6 +922,8 @@ TfLiteStatus Subgraph::ResizeInputTensor(int tensor_index,
     // Undo delegation if it resulted in the graph being immutable.
     TF_LITE_ENSURE_STATUS(UndoAllDelegates());
   }
+  only_inputs_resized_ = state_ == kStateInvokable ||
+                         (state_ == kStateUninvokable && only_inputs_resized_);
   state_ = kStateUninvokable;
   return ResizeTensorImpl(tensor, ConvertVectorToTfLiteIntArray(dims));
 }
@@ -854,7 +999,10 @@ TfLiteStatus Subgraph::PrepareOpsStartingAt(
     const TfLiteRegistration& registration =
         nodes_and_registration_[node_index].second;
     EnsureTensorsVectorCapacity();
-    if (OpPrepare(registration, &node) != kTfLiteOk) {
+    // The output shapes of the nodes whose inputs weren't resized are
+    // unchanged, and so are their other resources.
+    if ((!prepare_resized_nodes_only_ || HasResizedInput(node)) &&
+        OpPrepare(registration, &node) != kTfLiteOk) {
       return ReportOpError(&context_, node, registration, node_index,
                            "failed to prepare");
     }
@@ -872,12 +1020,28 @@ TfLiteStatus Subgraph::PrepareOpsStartingAt(
   return kTfLiteOk;
 }
 
+bool Subgraph::HasResizedInput(const TfLiteNode& node) const {
+  for (int i = 0; i < node.inputs->size; ++i) {
+    const int tensor_index = node.inputs->data[i];
+    if (tensor_index >= 0 && tensor_index < resized_tensors_.size() &&
+        resized_tensors_[tensor_index]) {
+      return true;
+    }
+  }
+  return false;
+}
+
 TfLiteStatus Subgraph::PrepareOpsAndTensors() {
   if (!memory_planner_) {
-    memory_planner_.reset(new ArenaPlanner(
+    auto* arena_planner = new ArenaPlanner(
         &context_, std::unique_ptr<GraphInfo>(new InterpreterInfo(this)),
         /*preserve_inputs=*/true, /*preserve_intermediates*/ false,
-        kDefaultTensorAlignment));
+        kDefaultTensorAlignment);
+    arena_planner->SetOfflinePlannedOffsets(offline_planned_tensor_offsets_);
+    if (shared_arena_buffer_) {
+      arena_planner->ShareNonPersistentArena(shared_arena_buffer_);
+    }
+    memory_planner_.reset(arena_planner);
     memory_planner_->PlanAllocations();
   }
 
@@ -934,6 +1098,187 @@ TfLiteStatus Subgraph::PrepareOpsAndTensors() {
   return kTfLiteOk;
 }
 
+void Subgraph::PlanExecutionStages(bool* changed) {
+  std::vector<std::pair<int, int>> previous_stages;
+  previous_stages.swap(execution_stages_);
+  *changed = !previous_stages.empty();
+  if (!parallel_node_execution_ || execution_plan_.size() < 2) {
+    return;
+  }
+
+  // Delegate kernels and custom ops may not be safe to run concurrently with
+  // other nodes, and control flow ops invoke other subgraphs.
+  auto is_barrier = [](const TfLiteNode& node,
+                       const TfLiteRegistration& registration) {
+    if (node.delegate != nullptr) {
+      return true;
+    }
+    switch (registration.builtin_code) {
+      case BuiltinOperator_CUSTOM:
+      case BuiltinOperator_CALL:
+      case BuiltinOperator_IF:
+      case BuiltinOperator_WHILE:
+      case BuiltinOperator_DELEGATE:
+        return true;
+      default:
+        return false;
+    }
+  };
+
+  // Each node is assigned the earliest level after those of the nodes it
+  // depends on: the last writer of each tensor it reads or writes, and the
+  // readers of each tensor it writes since that tensor was last written.
+  // Variable tensors are written by the nodes which take them as inputs.
+  std::vector<int> last_write_level(tensors_.size(), -1);
+  std::vector<int> last_read_level(tensors_.size(), -1);
+  std::vector<int> levels(execution_plan_.size());
+  int barrier_level = -1;
+  int max_level = -1;
+  for (int i = 0; i < execution_plan_.size(); ++i) {
+    const auto& node_and_reg = nodes_and_registration_[execution_plan_[i]];
+    const TfLiteNode& node = node_and_reg.first;
+    const bool barrier = is_barrier(node, node_and_reg.second);
+    int level = barrier ? max_level + 1 : barrier_level + 1;
+    for (int tensor_index : TfLiteIntArrayView(node.inputs)) {
+      if (tensor_index == kTfLiteOptionalTensor) continue;
+      level = std::max(level, last_write_level[tensor_index] + 1);
+      if (tensors_[tensor_index].is_variable) {
+        level = std::max(level, last_read_level[tensor_index] + 1);
+      }
+    }
+    for (int tensor_index : TfLiteIntArrayView(node.outputs)) {
+      if (tensor_index == kTfLiteOptionalTensor) continue;
+      level = std::max(level, last_write_level[tensor_index] + 1);
+      level = std::max(level, last_read_level[tensor_index] + 1);
+    }
+    for (int tensor_index : TfLiteIntArrayView(node.inputs)) {
+      if (tensor_index == kTfLiteOptionalTensor) continue;
+      if (tensors_[tensor_index].is_variable) {
+        last_write_level[tensor_index] = level;
+        last_read_level[tensor_index] = -1;
+      } else {
+        last_read_level[tensor_index] =
+            std::max(last_read_level[tensor_index], level);
+      }
+    }
+    for (int tensor_index : TfLiteIntArrayView(node.outputs)) {
+      if (tensor_index == kTfLiteOptionalTensor) continue;
+      last_write_level[tensor_index] = level;
+      last_read_level[tensor_index] = -1;
+    }
+    if (barrier) {
+      barrier_level = level;
+    }
+    levels[i] = level;
+    max_level = std::max(max_level, level);
+  }
+  if (max_level + 1 == execution_plan_.size()) {
+    // No two nodes can run at the same time.
+    return;
+  }
+
+  std::vector<int> order(execution_plan_.size());
+  for (int i = 0; i < order.size(); ++i) {
+    order[i] = i;
+  }
+  std::stable_sort(order.begin(), order.end(),
+                   [&levels](int a, int b) { return levels[a] < levels[b]; });
+  std::vector<int> new_plan;
+  new_plan.reserve(execution_plan_.size());
+  execution_stages_.resize(execution_plan_.size());
+  for (int first = 0; first < order.size();) {
+    int last = first;
+    while (last + 1 < order.size() &&
+           levels[order[last + 1]] == levels[order[first]]) {
+      ++last;
+    }
+    for (int i = first; i <= last; ++i) {
+      new_plan.push_back(execution_plan_[order[i]]);
+      execution_stages_[i] = {first, last};
+    }
+    first = last + 1;
+  }
+  *changed =
+      new_plan != execution_plan_ || execution_stages_ != previous_stages;
+  execution_plan_.swap(new_plan);
+}
+
+TfLiteStatus Subgraph::InvokeStage(int first_execution_plan_index,
+                                   int last_execution_plan_index) {
+  for (int execution_plan_index = first_execution_plan_index;
+       execution_plan_index <= last_execution_plan_index;
+       ++execution_plan_index) {
+    const TfLiteNode& node =
+        nodes_and_registration_[execution_plan_[execution_plan_index]].first;
+    for (int tensor_index : TfLiteIntArrayView(node.inputs)) {
+      if (tensor_index == kTfLiteOptionalTensor) {
+        continue;
+      }
+      TfLiteTensor* tensor = &tensors_[tensor_index];
+      if (tensor->delegate && tensor->data_is_stale) {
+        TF_LITE_ENSURE_STATUS(EnsureTensorDataIsReadable(tensor_index));
+      }
+    }
+  }
+
+  if (IsCancelled()) {
+    ReportError("Client requested cancel during Invoke()");
+    return kTfLiteError;
+  }
+
+  EnsureTensorsVectorCapacity();
+  tensor_resized_since_op_invoke_ = false;
+
+  // Each worker invokes its nodes single-threaded, with a context of its own
+  // so that the kernels get a CPU backend context of their own.
+  const int num_nodes =
+      last_execution_plan_index - first_execution_plan_index + 1;
+  const int num_workers =
+      std::min(num_nodes, context_.recommended_num_threads);
+  worker_contexts_.assign(num_workers, context_);
+  for (TfLiteContext& worker_context : worker_contexts_) {
+    worker_context.recommended_num_threads = 1;
+  }
+  while (worker_cpu_backend_contexts_.size() < num_workers) {
+    worker_cpu_backend_contexts_.emplace_back(new ExternalCpuBackendContext());
+  }
+
+  std::vector<TfLiteStatus> statuses(num_nodes, kTfLiteOk);
+  auto worker = [&](int worker_index) {
+    for (int i = worker_index; i < num_nodes; i += num_workers) {
+      auto& node_and_reg =
+          nodes_and_registration_[execution_plan_[first_execution_plan_index +
+                                                  i]];
+      const TfLiteRegistration& registration = node_and_reg.second;
+      statuses[i] = registration.invoke == nullptr
+                        ? kTfLiteError
+                        : registration.invoke(&worker_contexts_[worker_index],
+                                              &node_and_reg.first);
+    }
+  };
+  auto* cpu_backend_context = static_cast<ExternalCpuBackendContext*>(
+      external_contexts_[kTfLiteCpuBackendContext]);
+  if (cpu_backend_context != nullptr &&
+      cpu_backend_context->internal_backend_context() != nullptr) {
+    cpu_backend_context->internal_backend_context()->RunWorkers(num_workers,
+                                                                worker);
+  } else {
+    for (int worker_index = 0; worker_index < num_workers; ++worker_index) {
+      worker(worker_index);
+    }
+  }
+
+  for (int i = 0; i < num_nodes; ++i) {
+    if (statuses[i] != kTfLiteOk) {
+      const int node_index = execution_plan_[first_execution_plan_index + i];
+      const auto& node_and_reg = nodes_and_registration_[node_index];
+      return ReportOpError(&context_, node_and_reg.first, node_and_reg.second,
+                           node_index, "failed to invoke");
+    }
+  }
+  return kTfLiteOk;
+}
+
 TfLiteStatus Subgraph::Invoke() {
   if (!consistent_) {
     ReportError("Invoke called on model that is not consistent.");
@@ -967,6 +1312,19 @@ TfLiteStatus Subgraph::Invoke() {
       TF_LITE_ENSURE(&context_, next_execution_plan_index_to_prepare_ >=
                                     execution_plan_index);
     }
+    // Run the nodes of a stage concurrently, unless they are profiled one at a
+    // time.
+    if (!execution_stages_.empty() && !profiler_ &&
+        context_.recommended_num_threads > 1) {
+      const std::pair<int, int>& stage =
+          execution_stages_[execution_plan_index];
+      if (stage.first == execution_plan_index && stage.second > stage.first &&
+          stage.second < next_execution_plan_index_to_prepare_) {
+        TF_LITE_ENSURE_STATUS(InvokeStage(stage.first, stage.second));
+        execution_plan_index = stage.second;
+        continue;
+      }
+    }
     int node_index = execution_plan_[execution_plan_index];
     TfLiteNode& node = nodes_and_registration_[node_index].first;
     const TfLiteRegistration& registration =
@@ -1166,6 +1524,7 @@ TfLiteStatus Subgraph::SetTensorParametersReadOnly(
     tensor.allocation = allocation;
   } else {
     state_ = kStateUninvokable;
+    only_inputs_resized_ = false;
     TfLiteTensorReset(type, name, ConvertArrayToTfLiteIntArray(rank, dims),
                       GetLegacyQuantization(quantization),
                       const_cast<char*>(buffer), bytes, kTfLiteMmapRo,
@@ -1236,6 +1595,7 @@ TfLiteStatus Subgraph::SetExecutionPlan(const std::vector<int>& new_plan) {
                                   node_index < nodes_and_registration_.size());
   }
   execution_plan_ = new_plan;
+  execution_stages_.clear();
   return kTfLiteOk;
 }
 
@@ -1247,8 +1607,16 @@ TfLiteStatus Subgraph::ResizeTensorImpl(TfLiteTensor* tensor,
       tensor->allocation_type == kTfLiteArenaRwPersistent ||
       tensor->allocation_type == kTfLitePersistentRo ||
       tensor->allocation_type == kTfLiteCustom) {
-    tensor_resized_since_op_invoke_ |=
-        TfLiteIntArrayEqual(tensor->dims, new_size) == 0;
+    if (TfLiteIntArrayEqual(tensor->dims, new_size) == 0) {
+      tensor_resized_since_op_invoke_ = true;
+      const int tensor_index = tensor - context_.tensors;
+      if (tensor_index >= 0 && tensor_index < context_.tensors_size) {
+        if (resized_tensors_.size() <= tensor_index) {
+          resized_tensors_.resize(context_.tensors_size);
+        }
+        resized_tensors_[tensor_index] = true;
+      }
+    }
     if (tensor->type != kTfLiteString) {
       size_t bytesRequired;
       TfLiteStatus status = BytesRequired(tensor->type, new_size->data,
@@ -1340,6 +1708,7 @@ TfLiteStatus Subgraph::UndoAllDelegates() {
   // Reset execution plan.
   execution_plan_ = pre_delegation_execution_plan_;
   pre_delegation_execution_plan_.clear();
+  execution_stages_.clear();
 
   // Delegate nodes are appended to nodes_and_registration_. Therefore,
   // cleanup nodes_and_registration_ to only contain nodes from
@@ -1353,6 +1722,7 @@ TfLiteStatus Subgraph::UndoAllDelegates() {
   nodes_and_registration_.resize(max_retained_node_index + 1);
   // After undoing delegates, the graph is uninvokable, but mutable.
   state_ = kStateUninvokable;
+  only_inputs_resized_ = false;
 
   delegates_undone_ = true;
   return kTfLiteOk;
@@ -1397,6 +1767,7 @@ void Subgraph::EnsureTensorsVectorCapacity() {
 TfLiteStatus Subgraph::EnsureMemoryAllocations() {
   if (memory_planner_) {
     state_ = kStateUninvokable;
+    only_inputs_resized_ = false;
     TF_LITE_ENSURE_OK(&context_, memory_planner_->PlanAllocations());
   }
   TF_LITE_ENSURE_OK(&context_, AllocateTensors());
@@ -1463,10 +1834,13 @@ TfLiteStatus Subgraph::ModifyGraphWithDelegate(TfLiteDelegate* delegate) {
   SwitchToKernelContext();
 
   TF_LITE_ENSURE_STATUS(reset_delegation_if_not_ok(status));
+  // The delegate kernels replacing nodes haven't been prepared yet.
+  only_inputs_resized_ = false;
 
   if (!(delegate->flags & kTfLiteDelegateFlagsAllowDynamicTensors)) {
     // Reset the state to force tensor/op reallocation.
     state_ = kStateUninvokable;
+    only_inputs_resized_ = false;
     TF_LITE_ENSURE_STATUS(
         reset_delegation_if_not_ok(EnsureMemoryAllocations()));
     // After using a delegate which doesn't support dynamic tensors, make the
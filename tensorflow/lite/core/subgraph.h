@@ -27,7 +27,9 @@ limitations under the License.
 #include "tensorflow/lite/core/macros.h"
 #include "tensorflow/lite/delegates/nnapi/nnapi_delegate.h"
 #include "tensorflow/lite/experimental/resource/resource_base.h"
+#include "tensorflow/lite/external_cpu_backend_context.h"
 #include "tensorflow/lite/memory_planner.h"
+#include "tensorflow/lite/simple_memory_arena.h"
 #include "tensorflow/lite/util.h"
 
 #if TFLITE_EXPERIMENTAL_RUNTIME_EAGER
@@ -216,6 +218,9 @@ class Subgraph {
   // Change the dimensionality of a given tensor. Note, this is only acceptable
   // for tensor indices that are inputs.
   // Returns status of failure or success.
+  // If the graph was invokable and only had inputs resized since, the next
+  // AllocateTensors() only prepares the nodes whose input shapes changed, and
+  // keeps the arena allocations of the tensors which still fit in them.
   // TODO(aselle): Consider implementing ArraySlice equivalent to make this
   //   more adept at accepting data without an extra copy. Use absl::ArraySlice
   //   if our partners determine that dependency is acceptable.
@@ -276,6 +281,42 @@ class Subgraph {
   // WARNING: This is an experimental API and subject to change.
   void SetCancellationFunction(void* data, bool (*check_cancelled_func)(void*));
 
+  // Enables or disables running independent nodes of the execution plan
+  // concurrently on the thread pool of the CPU backend context. When enabled,
+  // `AllocateTensors` groups the execution plan into stages of nodes that do
+  // not depend on each other, and `Invoke` runs the nodes of each stage in
+  // parallel, with at most `recommended_num_threads` threads. The nodes of a
+  // stage then run single-threaded. Graphs with dynamic tensors, and
+  // invocations with a profiler, run sequentially.
+  // Takes effect at the next call to `AllocateTensors`.
+  // WARNING: This is an experimental API and subject to change.
+  void SetParallelNodeExecution(bool enable);
+
+  // Sets the byte offsets in the non-persistent arena of the tensors whose
+  // memory was planned ahead of time, indexed by tensor, with -1 for the
+  // tensors to plan at runtime. Must be called before tensors are allocated.
+  // WARNING: This is an experimental API and subject to change.
+  TfLiteStatus SetOfflinePlannedTensorOffsets(std::vector<int32_t> offsets);
+
+  // Makes the non-persistent arenas of this subgraph and of `other`, and of
+  // the subgraphs either already shares its arena with, use the same memory.
+  // This is only valid for subgraphs which are never in use at the same time,
+  // such as the branches of an IF op. A subgraph whose arena is shared must be
+  // allocated again with `AllocateTensors` before each use, which only
+  // resolves its tensors again if another subgraph used the memory meanwhile.
+  // Returns false, and changes nothing, if the tensors of either subgraph were
+  // already allocated, or both already share their arena with other ones.
+  // WARNING: This is an experimental API and subject to change.
+  bool ShareNonPersistentArenaWith(Subgraph* other);
+
+  // Returns the [first, last] execution plan indices of the stage of each
+  // node in the execution plan, or an empty vector if the nodes are not
+  // grouped into stages.
+  // WARNING: This is an experimental API and subject to change.
+  const std::vector<std::pair<int, int>>& execution_stages() const {
+    return execution_stages_;
+  }
+
   // Ensure the data in `tensor.data` is readable. In case delegate is used,
   // it might require to copy the data from delegate buffer to raw memory.
   // WARNING: This is an experimental API and subject to change.
@@ -310,6 +351,13 @@ class Subgraph {
   // WARNING: This is an experimental API and subject to change.
   TfLiteStatus ResetVariableTensors();
 
+  // Reads the pages of the constant tensors the nodes read during invoke ahead
+  // of it, in execution order, and frees those of the constant tensors the
+  // nodes only read in prepare. Only affects the tensors of memory-mapped
+  // allocations.
+  // WARNING: This is an experimental API and subject to change.
+  TfLiteStatus PageInConstantTensors();
+
   void SetProfiler(Profiler* profiler, int associated_subgraph_idx) {
     if (!profiler) {
       profiler_.reset(nullptr);
@@ -437,14 +485,31 @@ class Subgraph {
   // to wait until Invoke() to resolve the sizes of dynamic tensors.
   TfLiteStatus PrepareOpsAndTensors();
 
+  // Reorders `execution_plan_` so that nodes which do not depend on each other
+  // are adjacent, and fills `execution_stages_` with the resulting stages.
+  // Nodes which may not run concurrently with others (delegate kernels,
+  // custom and control flow ops) are stages of their own, which no other node
+  // is moved across. Sets `*changed` if the plan or the stages changed.
+  void PlanExecutionStages(bool* changed);
+
+  // Invokes the nodes of the execution plan in [first, last] concurrently, on
+  // the thread pool of the CPU backend context.
+  TfLiteStatus InvokeStage(int first_execution_plan_index,
+                           int last_execution_plan_index);
+
   // Call OpPrepare() for all ops starting at 'first_node'. Stop when a
   // dynamic tensors is found or all ops have been prepared. Fill
   // 'last_node_prepared' with the id of the op containing dynamic tensors, or
-  // the last in the graph.
+  // the last in the graph. If `prepare_resized_nodes_only_` is set, the ops
+  // none of whose inputs were resized are not prepared again.
   TfLiteStatus PrepareOpsStartingAt(int first_execution_plan_index,
                                     const std::vector<int>& execution_plan,
                                     int* last_execution_plan_index_prepared);
 
+  // Returns true if any input of `node` was resized since the last
+  // AllocateTensors().
+  bool HasResizedInput(const TfLiteNode& node) const;
+
   // Tensors needed by the interpreter. Use `AddTensors` to add more blank
   // tensor entries. Note, `tensors_.data()` needs to be synchronized to the
   // `context_` whenever this std::vector is reallocated. Currently this
@@ -540,7 +605,9 @@ class Subgraph {
   // PreviewDelegatePartitioning was called.
   void FreeDelegatePartitioningData();
 
-  // Retrieve an existing external context by type.
+  // Retrieve an existing external context by type. When called with the
+  // context of a worker of `InvokeStage`, returns the worker's own CPU backend
+  // context.
   TfLiteExternalContext* GetExternalContext(TfLiteExternalContextType type);
   static TfLiteExternalContext* GetExternalContext(
       struct TfLiteContext* context, TfLiteExternalContextType type);
@@ -711,6 +778,17 @@ class Subgraph {
   // trigger downstream reallocation after op invocation.
   bool tensor_resized_since_op_invoke_ = false;
 
+  // Whether the graph was invokable and only had inputs resized since, in
+  // which case AllocateTensors() prepares the graph incrementally.
+  bool only_inputs_resized_ = false;
+
+  // Set while AllocateTensors() prepares the graph incrementally.
+  bool prepare_resized_nodes_only_ = false;
+
+  // Indexed by tensor, whether the shape of the tensor changed since the last
+  // AllocateTensors(). Tensors beyond its size weren't resized.
+  std::vector<bool> resized_tensors_;
+
   // Profiler for this interpreter instance.
   std::unique_ptr<SubgraphAwareProfiler> profiler_;
 
@@ -734,6 +812,28 @@ class Subgraph {
 
   // A map of resources. Owned by interpreter and shared by multiple subgraphs.
   resource::ResourceMap* resources_ = nullptr;
+
+  // The offsets of the tensors planned ahead of time, see
+  // SetOfflinePlannedTensorOffsets.
+  std::vector<int32_t> offline_planned_tensor_offsets_;
+
+  // The buffer of the non-persistent arena, if it's shared with other
+  // subgraphs. See ShareNonPersistentArenaWith.
+  std::shared_ptr<ArenaBuffer> shared_arena_buffer_;
+
+  // Whether independent nodes run concurrently, see SetParallelNodeExecution.
+  bool parallel_node_execution_ = false;
+
+  // The [first, last] execution plan indices of the stage of each node in
+  // `execution_plan_`. Empty when nodes are invoked one at a time.
+  std::vector<std::pair<int, int>> execution_stages_;
+
+  // The contexts the nodes of a stage are invoked with by each worker of
+  // `InvokeStage`, and the CPU backend context of each worker, so that the
+  // kernels of concurrent nodes don't share one.
+  std::vector<TfLiteContext> worker_contexts_;
+  std::vector<std::unique_ptr<ExternalCpuBackendContext>>
+      worker_cpu_backend_contexts_;
 };
 
 }  // namespace impl
@@ -204,6 +204,7 @@ absl::Status InferenceContext::InitFromGraph(
   TuningParameters tuning_parameters;
   tuning_parameters.queue = env->profiling_queue();
   tuning_parameters.info = &env->device().info_;
+  tuning_parameters.cache = env->program_cache();
   if (create_info.hints.Check(ModelHints::kFastTuning)) {
     tuning_parameters.tuning_type = TuningType::FAST;
   }
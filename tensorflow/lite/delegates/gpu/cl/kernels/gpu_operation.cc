@@ -15,10 +15,14 @@ limitations under the License.
 
 #include "tensorflow/lite/delegates/gpu/cl/kernels/gpu_operation.h"
 
+#include <algorithm>
+
+#include "absl/strings/str_cat.h"
 #include "absl/strings/substitute.h"
 #include "tensorflow/lite/delegates/gpu/cl/kernels/util.h"
 #include "tensorflow/lite/delegates/gpu/cl/kernels/work_group_picking.h"
 #include "tensorflow/lite/delegates/gpu/common/access_type.h"
+#include <farmhash.h>
 
 namespace tflite {
 namespace gpu {
@@ -134,6 +138,7 @@ GPUOperation::GPUOperation(GPUOperation&& operation)
       kernel_(std::move(operation.kernel_)),
       work_group_size_(operation.work_group_size_),
       grid_size_(operation.grid_size_),
+      program_fingerprint_(operation.program_fingerprint_),
       src_tensors_names_(std::move(operation.src_tensors_names_)),
       dst_tensors_names_(std::move(operation.dst_tensors_names_)),
       compiler_options_(std::move(operation.compiler_options_)),
@@ -153,6 +158,7 @@ GPUOperation& GPUOperation::operator=(GPUOperation&& operation) {
     kernel_ = std::move(operation.kernel_);
     std::swap(work_group_size_, operation.work_group_size_);
     std::swap(grid_size_, operation.grid_size_);
+    std::swap(program_fingerprint_, operation.program_fingerprint_);
     src_tensors_names_ = std::move(operation.src_tensors_names_);
     dst_tensors_names_ = std::move(operation.dst_tensors_names_);
     compiler_options_ = std::move(operation.compiler_options_);
@@ -235,6 +241,8 @@ absl::Status GPUOperation::Compile(const CreationContext& creation_context) {
     RETURN_IF_ERROR(creation_context.cache->GetOrCreateCLKernel(
         code, "main_function", *creation_context.context,
         *creation_context.device, &kernel_));
+    program_fingerprint_ = ProgramCache::GetProgramFingerprint(
+        code, {}, *creation_context.device);
   } else {
     std::string element_wise_code;
     RETURN_IF_ERROR(
@@ -245,6 +253,8 @@ absl::Status GPUOperation::Compile(const CreationContext& creation_context) {
     RETURN_IF_ERROR(creation_context.cache->GetOrCreateCLKernel(
         code_, "main_function", compiler_options_, *creation_context.context,
         *creation_context.device, &kernel_));
+    program_fingerprint_ = ProgramCache::GetProgramFingerprint(
+        code_, compiler_options_, *creation_context.device);
   }
   return PostCompileCheck(creation_context.device->info_, kernel_.info_);
 }
@@ -267,15 +277,31 @@ absl::Status GPUOperation::Tune(const TuningParameters& params) {
   if (possible_work_groups.size() == 1) {
     work_group_size_ = possible_work_groups[0];
     return absl::OkStatus();
-  } else {
-    RETURN_IF_ERROR(args_.Bind(kernel_.kernel()));
-    int best_work_group_index;
-    RETURN_IF_ERROR(params.queue->GetBestWorkGroupIndex(
-        kernel_, *params.info, grid_size_, possible_work_groups,
-        &best_work_group_index));
-    work_group_size_ = possible_work_groups[best_work_group_index];
+  }
+  const uint64_t tuning_fingerprint = ::util::Fingerprint64(absl::StrCat(
+      program_fingerprint_, ":", grid_size_.x, ",", grid_size_.y, ",",
+      grid_size_.z, ":", static_cast<int>(params.tuning_type)));
+  int3 cached_work_group;
+  // A work group from a stale cache may not be valid anymore, so it is only
+  // used if it is still one of the candidates.
+  if (params.cache &&
+      params.cache->FindTunedWorkGroup(tuning_fingerprint,
+                                       &cached_work_group) &&
+      std::find(possible_work_groups.begin(), possible_work_groups.end(),
+                cached_work_group) != possible_work_groups.end()) {
+    work_group_size_ = cached_work_group;
     return absl::OkStatus();
   }
+  RETURN_IF_ERROR(args_.Bind(kernel_.kernel()));
+  int best_work_group_index;
+  RETURN_IF_ERROR(params.queue->GetBestWorkGroupIndex(
+      kernel_, *params.info, grid_size_, possible_work_groups,
+      &best_work_group_index));
+  work_group_size_ = possible_work_groups[best_work_group_index];
+  if (params.cache) {
+    params.cache->AddTunedWorkGroup(tuning_fingerprint, work_group_size_);
+  }
+  return absl::OkStatus();
 }
 
 int3 GPUOperation::GetGridSize() const {
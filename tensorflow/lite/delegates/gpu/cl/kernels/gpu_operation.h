@@ -154,6 +154,8 @@ class GPUOperation {
   CLKernel kernel_;
   int3 work_group_size_ = int3(8, 4, 1);
   int3 grid_size_ = int3(0, 0, 0);
+  // Fingerprint of the program kernel_ is created from.
+  uint64_t program_fingerprint_ = 0;
   std::vector<std::string> src_tensors_names_;
   std::vector<std::string> dst_tensors_names_;
   std::vector<CompilerOptions> compiler_options_;
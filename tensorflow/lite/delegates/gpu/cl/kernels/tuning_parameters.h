@@ -18,6 +18,7 @@ limitations under the License.
 
 #include "tensorflow/lite/delegates/gpu/cl/cl_command_queue.h"
 #include "tensorflow/lite/delegates/gpu/cl/cl_device.h"
+#include "tensorflow/lite/delegates/gpu/cl/program_cache.h"
 
 namespace tflite {
 namespace gpu {
@@ -29,6 +30,9 @@ struct TuningParameters {
   ProfilingCommandQueue* queue;
   const DeviceInfo* info;
   TuningType tuning_type = TuningType::EXHAUSTIVE;
+  // When set, the work groups already tuned for a kernel are looked up in the
+  // cache, and the newly tuned ones added to it.
+  ProgramCache* cache = nullptr;
 };
 
 }  // namespace cl
@@ -28,30 +28,35 @@ limitations under the License.
 namespace tflite {
 namespace gpu {
 namespace cl {
+namespace {
+
+uint64_t GetFingerprint(const std::string& code, const std::string& options) {
+  return ::util::Fingerprint64(code) + ::util::Fingerprint64(options);
+}
+
+}  // namespace
 
 ProgramCache::ProgramDescriptor::ProgramDescriptor(const std::string& code_text,
                                                    const std::string& options,
                                                    bool use_fingerprints)
     : code(code_text),
       compiler_options(options),
-      use_fingerprint(use_fingerprints) {
-  const uint64_t code_fingerprint = ::util::Fingerprint64(code);
-  const uint64_t options_fingerprint =
-      ::util::Fingerprint64(compiler_options);
-  fingerprint = code_fingerprint + options_fingerprint;
-}
+      fingerprint(GetFingerprint(code_text, options)),
+      use_fingerprint(use_fingerprints) {}
 
 ProgramCache::ProgramDescriptor::ProgramDescriptor(uint64_t fingerprints)
     : fingerprint(fingerprints), use_fingerprint(true) {}
 
 ProgramCache::ProgramCache(ProgramCache&& program_cache)
     : use_fingerprints_(program_cache.use_fingerprints_),
-      programs_(std::move(program_cache.programs_)) {}
+      programs_(std::move(program_cache.programs_)),
+      work_groups_(std::move(program_cache.work_groups_)) {}
 
 ProgramCache& ProgramCache::operator=(ProgramCache&& program_cache) {
   if (this != &program_cache) {
     use_fingerprints_ = program_cache.use_fingerprints_;
     programs_ = std::move(program_cache.programs_);
+    work_groups_ = std::move(program_cache.work_groups_);
   }
   return *this;
 }
@@ -82,6 +87,29 @@ absl::Status ProgramCache::GetOrCreateCLKernel(const std::string& code,
   return GetOrCreateCLKernel(code, function_name, {}, context, device, result);
 }
 
+uint64_t ProgramCache::GetProgramFingerprint(
+    const std::string& code,
+    const std::vector<CompilerOptions>& compiler_options,
+    const CLDevice& device) {
+  return GetFingerprint(code,
+                        CompilerOptionsToString(device, compiler_options));
+}
+
+bool ProgramCache::FindTunedWorkGroup(uint64_t fingerprint,
+                                      int3* work_group_size) const {
+  auto it = work_groups_.find(fingerprint);
+  if (it == work_groups_.end()) {
+    return false;
+  }
+  *work_group_size = it->second;
+  return true;
+}
+
+void ProgramCache::AddTunedWorkGroup(uint64_t fingerprint,
+                                     const int3& work_group_size) {
+  work_groups_[fingerprint] = work_group_size;
+}
+
 absl::Status ProgramCache::AddSerializedCache(
     const CLContext& context, const CLDevice& device,
     absl::Span<const uint8_t> serialized_cache) {
@@ -115,6 +143,15 @@ absl::Status ProgramCache::AddSerializedCache(
       programs_.insert(std::make_pair(std::move(desc), std::move(program)));
     }
   }
+  // Caches serialized before the work groups were added don't have them.
+  if (model->work_groups()) {
+    for (auto serialized_work_group : *model->work_groups()) {
+      work_groups_.insert(std::make_pair(
+          serialized_work_group->fingerprint(),
+          int3(serialized_work_group->size_x(), serialized_work_group->size_y(),
+               serialized_work_group->size_z())));
+    }
+  }
   return absl::OkStatus();
 }
 
@@ -131,11 +168,19 @@ absl::Status ProgramCache::GetSerializedCache(
     program_builder.add_binary(binary_offset);
     serialized_programs.push_back(program_builder.Finish());
   }
+  std::vector<flatbuffers::Offset<data::WorkGroup>> serialized_work_groups;
+  for (auto& work_group : work_groups_) {
+    serialized_work_groups.push_back(data::CreateWorkGroup(
+        builder, work_group.first, work_group.second.x, work_group.second.y,
+        work_group.second.z));
+  }
   auto driver_version = builder.CreateString(device.GetPlatformVersion());
   auto programs_s = builder.CreateVector(serialized_programs);
+  auto work_groups_s = builder.CreateVector(serialized_work_groups);
   data::CompiledCacheBuilder cache_builder(builder);
   cache_builder.add_driver_version(driver_version);
   cache_builder.add_programs(programs_s);
+  cache_builder.add_work_groups(work_groups_s);
   data::FinishCompiledCacheBuffer(builder, cache_builder.Finish());
   size_t next_element = serialized_cache->size();
   serialized_cache->resize(serialized_cache->size() + builder.GetSize());
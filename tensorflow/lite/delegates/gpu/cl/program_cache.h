@@ -27,6 +27,7 @@ limitations under the License.
 #include "tensorflow/lite/delegates/gpu/cl/cl_kernel.h"
 #include "tensorflow/lite/delegates/gpu/cl/cl_program.h"
 #include "tensorflow/lite/delegates/gpu/common/status.h"
+#include "tensorflow/lite/delegates/gpu/common/types.h"
 
 namespace tflite {
 namespace gpu {
@@ -51,6 +52,20 @@ class ProgramCache {
                                    const CLContext& context,
                                    const CLDevice& device, CLKernel* result);
 
+  // Returns the fingerprint identifying the program compiled from `code` with
+  // `compiler_options` on `device`.
+  static uint64_t GetProgramFingerprint(
+      const std::string& code,
+      const std::vector<CompilerOptions>& compiler_options,
+      const CLDevice& device);
+
+  // Work group sizes picked by tuning kernels, keyed by a fingerprint of the
+  // program and of the launch the work group was tuned for. They are
+  // serialized along with the programs, so that kernels loaded from a
+  // serialized cache don't have to be tuned again.
+  bool FindTunedWorkGroup(uint64_t fingerprint, int3* work_group_size) const;
+  void AddTunedWorkGroup(uint64_t fingerprint, const int3& work_group_size);
+
   absl::Status AddSerializedCache(const CLContext& context,
                                   const CLDevice& device,
                                   absl::Span<const uint8_t> serialized_cache);
@@ -96,6 +111,7 @@ class ProgramCache {
   absl::flat_hash_map<ProgramDescriptor, CLProgram, ProgramDescriptorHasher,
                       ProgramDescriptorEqual>
       programs_;
+  absl::flat_hash_map<uint64_t, int3> work_groups_;
 };
 
 }  // namespace cl
@@ -39,6 +39,7 @@ limitations under the License.
 
 #ifndef CL_DELEGATE_NO_GL
 #include "tensorflow/lite/delegates/gpu/gl/api2.h"
+#include "tensorflow/lite/delegates/gpu/gl/gl_buffer.h"
 #endif
 
 namespace tflite {
@@ -71,6 +72,16 @@ InferenceUsage ToUsage(int32_t usage) {
 
 // Forward declarations.
 TfLiteStatus DelegatePrepare(TfLiteContext* context, TfLiteDelegate* delegate);
+TfLiteStatus DelegateCopyFromBufferHandle(TfLiteContext* context,
+                                          TfLiteDelegate* delegate,
+                                          TfLiteBufferHandle buffer_handle,
+                                          TfLiteTensor* tensor);
+TfLiteStatus DelegateCopyToBufferHandle(TfLiteContext* context,
+                                        TfLiteDelegate* delegate,
+                                        TfLiteBufferHandle buffer_handle,
+                                        TfLiteTensor* tensor);
+void DelegateFreeBufferHandle(TfLiteContext* context, TfLiteDelegate* delegate,
+                              TfLiteBufferHandle* buffer_handle);
 
 class Delegate {
  public:
@@ -94,18 +105,57 @@ class Delegate {
   }
   int num_delegate_kernels() const { return num_delegate_kernels_; }
 
+  // Registers the OpenGL shader storage buffer object `ssbo`, and returns the
+  // buffer handle binding it to a tensor.
+  TfLiteBufferHandle RegisterGlBuffer(GLuint ssbo) {
+    for (int i = 0; i < gl_buffers_.size(); ++i) {
+      if (gl_buffers_[i] == GL_INVALID_INDEX) {
+        gl_buffers_[i] = ssbo;
+        return i;
+      }
+    }
+    gl_buffers_.push_back(ssbo);
+    return gl_buffers_.size() - 1;
+  }
+
+  // Returns the OpenGL buffer of `buffer_handle`, or GL_INVALID_INDEX.
+  GLuint GetGlBuffer(TfLiteBufferHandle buffer_handle) const {
+    if (buffer_handle < 0 || buffer_handle >= gl_buffers_.size()) {
+      return GL_INVALID_INDEX;
+    }
+    return gl_buffers_[buffer_handle];
+  }
+
+  // Returns the OpenGL buffer bound to `tensor` through a buffer handle of
+  // this delegate, or GL_INVALID_INDEX.
+  GLuint GetGlBuffer(const TfLiteTensor& tensor) const {
+    if (tensor.delegate != &delegate_ || tensor.type != kTfLiteFloat32) {
+      return GL_INVALID_INDEX;
+    }
+    return GetGlBuffer(tensor.buffer_handle);
+  }
+
+  void FreeGlBuffer(TfLiteBufferHandle buffer_handle) {
+    if (buffer_handle >= 0 && buffer_handle < gl_buffers_.size()) {
+      gl_buffers_[buffer_handle] = GL_INVALID_INDEX;
+    }
+  }
+
  private:
   TfLiteDelegate delegate_ = {
       .data_ = reinterpret_cast<void*>(this),
       .Prepare = DelegatePrepare,
-      .CopyFromBufferHandle = nullptr,
-      .CopyToBufferHandle = nullptr,
-      .FreeBufferHandle = nullptr,
+      .CopyFromBufferHandle = DelegateCopyFromBufferHandle,
+      .CopyToBufferHandle = DelegateCopyToBufferHandle,
+      .FreeBufferHandle = DelegateFreeBufferHandle,
       .flags = kTfLiteDelegateFlagsNone,
   };
 
   TfLiteGpuDelegateOptionsV2 options_;
   int num_delegate_kernels_ = 0;
+  // The OpenGL buffers registered with the delegate, indexed by their buffer
+  // handle. The buffers are not owned.
+  std::vector<GLuint> gl_buffers_;
 
   friend class DelegateKernel;
 };
@@ -130,13 +180,31 @@ class DelegateKernel {
     RETURN_IF_ERROR(InitializeGraph(context, delegate_params, &graph,
                                     &input_refs, &output_refs));
 
+    // The inputs and outputs bound to OpenGL buffers are read and written in
+    // place by the OpenGL backend.
+    bound_gl_buffers_.clear();
+    for (const auto& refs : {input_refs, output_refs}) {
+      for (uint32_t tensor_index : refs) {
+        const GLuint buffer =
+            delegate_->GetGlBuffer(context->tensors[tensor_index]);
+        if (buffer != GL_INVALID_INDEX) {
+          bound_gl_buffers_[tensor_index] = buffer;
+        }
+      }
+    }
+
     std::unique_ptr<InferenceBuilder> builder;
     bool graph_is_destroyed;
     const int experimental_flags = delegate_->options().experimental_flags;
     if (experimental_flags & TFLITE_GPU_EXPERIMENTAL_FLAGS_CL_ONLY) {
+      if (!bound_gl_buffers_.empty()) {
+        return absl::InvalidArgumentError(
+            "Tensors bound to OpenGL buffers need the OpenGL backend.");
+      }
       RETURN_IF_ERROR(
           InitializeOpenClApi(&graph, &builder, &graph_is_destroyed));
-    } else if (experimental_flags & TFLITE_GPU_EXPERIMENTAL_FLAGS_GL_ONLY) {
+    } else if ((experimental_flags & TFLITE_GPU_EXPERIMENTAL_FLAGS_GL_ONLY) ||
+               !bound_gl_buffers_.empty()) {
       RETURN_IF_ERROR(InitializeOpenGlApi(&graph, &builder));
     } else {
       // By default, we try CL first & fall back to GL if that fails.
@@ -219,6 +287,13 @@ class DelegateKernel {
     }
     RETURN_IF_ERROR(SetInputsAndOutputs(context));
     RETURN_IF_ERROR(runner_->Run());
+    // The outputs written to OpenGL buffers are copied back to their CPU data
+    // only if it is accessed.
+    for (int64_t index : output_indices_) {
+      if (bound_gl_buffers_.contains(index)) {
+        context->tensors[index].data_is_stale = true;
+      }
+    }
     if (is_dequant_required) {
       RETURN_IF_ERROR(
           QuantizeOutputs(context, output_indices_, quant_conversion_map_));
@@ -243,12 +318,18 @@ class DelegateKernel {
     ObjectDef default_object_def;
     default_object_def.data_type = DataType::FLOAT32;
     default_object_def.data_layout = DataLayout::BHWC;
-    default_object_def.object_type = ObjectType::CPU_MEMORY;
+    default_object_def.object_type = bound_gl_buffers_.contains(index)
+                                         ? ObjectType::OPENGL_SSBO
+                                         : ObjectType::CPU_MEMORY;
     default_object_def.user_provided = true;
     return default_object_def;
   }
 
   TensorObject GetTensorObject(int index, TfLiteContext* context) const {
+    auto it = bound_gl_buffers_.find(index);
+    if (it != bound_gl_buffers_.end()) {
+      return OpenGlBuffer(it->second);
+    }
     auto& tensor = context->tensors[index];
     return MakeCpuMemory(absl::MakeSpan(tensor.data.raw, tensor.bytes));
   }
@@ -351,6 +432,8 @@ class DelegateKernel {
   // originally quantized (8-bit) tensor to its float version added in
   // model_builder - and vice versa.
   absl::flat_hash_map<int, int> quant_conversion_map_;
+  // Maps the inputs and outputs bound to OpenGL buffers to their buffer.
+  absl::flat_hash_map<int64_t, GLuint> bound_gl_buffers_;
   std::thread::id thread_id_prepare_;  // thread id used for Prapare()
   bool enforce_same_thread_ = false;   // flag to enforce same thread for Invoke
 };
@@ -435,6 +518,56 @@ TfLiteStatus DelegatePrepare(TfLiteContext* context, TfLiteDelegate* delegate) {
   return status;
 }
 
+TfLiteStatus DelegateCopyFromBufferHandle(TfLiteContext* context,
+                                          TfLiteDelegate* delegate,
+                                          TfLiteBufferHandle buffer_handle,
+                                          TfLiteTensor* tensor) {
+#ifndef CL_DELEGATE_NO_GL
+  const GLuint id = GetDelegate(delegate)->GetGlBuffer(buffer_handle);
+  if (id == GL_INVALID_INDEX) {
+    return kTfLiteError;
+  }
+  gl::GlBuffer buffer(GL_SHADER_STORAGE_BUFFER, id, tensor->bytes,
+                      /*offset=*/0, /*has_ownership=*/false);
+  const auto status =
+      buffer.Read(absl::MakeSpan(tensor->data.raw, tensor->bytes));
+  if (status.ok()) {
+    return kTfLiteOk;
+  }
+  TF_LITE_KERNEL_LOG(context, "TfLiteGpuDelegate CopyFromBufferHandle: %s",
+                     std::string(status.message()).c_str());
+#endif
+  return kTfLiteError;
+}
+
+TfLiteStatus DelegateCopyToBufferHandle(TfLiteContext* context,
+                                        TfLiteDelegate* delegate,
+                                        TfLiteBufferHandle buffer_handle,
+                                        TfLiteTensor* tensor) {
+#ifndef CL_DELEGATE_NO_GL
+  const GLuint id = GetDelegate(delegate)->GetGlBuffer(buffer_handle);
+  if (id == GL_INVALID_INDEX) {
+    return kTfLiteError;
+  }
+  gl::GlBuffer buffer(GL_SHADER_STORAGE_BUFFER, id, tensor->bytes,
+                      /*offset=*/0, /*has_ownership=*/false);
+  const auto status = buffer.Write(
+      absl::MakeConstSpan(tensor->data.raw_const, tensor->bytes));
+  if (status.ok()) {
+    return kTfLiteOk;
+  }
+  TF_LITE_KERNEL_LOG(context, "TfLiteGpuDelegate CopyToBufferHandle: %s",
+                     std::string(status.message()).c_str());
+#endif
+  return kTfLiteError;
+}
+
+void DelegateFreeBufferHandle(TfLiteContext* context, TfLiteDelegate* delegate,
+                              TfLiteBufferHandle* buffer_handle) {
+  GetDelegate(delegate)->FreeGlBuffer(*buffer_handle);
+  *buffer_handle = kTfLiteNullBufferHandle;
+}
+
 }  // namespace
 }  // namespace gpu
 }  // namespace tflite
@@ -465,3 +598,12 @@ TfLiteDelegate* TfLiteGpuDelegateV2Create(
 void TfLiteGpuDelegateV2Delete(TfLiteDelegate* delegate) {
   delete tflite::gpu::GetDelegate(delegate);
 }
+
+TfLiteBufferHandle TfLiteGpuDelegateV2RegisterGlBuffer(TfLiteDelegate* delegate,
+                                                       uint32_t ssbo) {
+#ifndef CL_DELEGATE_NO_GL
+  return tflite::gpu::GetDelegate(delegate)->RegisterGlBuffer(ssbo);
+#else
+  return kTfLiteNullBufferHandle;
+#endif
+}
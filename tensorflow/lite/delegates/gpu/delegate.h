@@ -123,6 +123,25 @@ TFL_CAPI_EXPORT TfLiteDelegate* TfLiteGpuDelegateV2Create(
 // Destroys a delegate created with `TfLiteGpuDelegateV2Create` call.
 TFL_CAPI_EXPORT void TfLiteGpuDelegateV2Delete(TfLiteDelegate* delegate);
 
+// Registers the OpenGL shader storage buffer object `ssbo` (a GLuint) with the
+// delegate. The returned handle binds it to a float32 input or output tensor
+// with `Interpreter::SetBufferHandle`, which must be called *before*
+// `Interpreter::ModifyGraphWithDelegate`.
+//
+// The delegate then reads or writes the tensor in the buffer, in BHWC layout,
+// instead of copying it from or to the CPU tensor data. A bound output is only
+// copied back to the CPU when its data is accessed there. AHardwareBuffers,
+// e.g. camera frames, can be bound once imported in an SSBO with
+// glBufferStorageExternalEXT.
+//
+// The partitions with bound tensors run on the OpenGL backend, with the GL
+// context current when the delegate is applied and invoked. The buffer is not
+// owned by the delegate.
+//
+// Returns kTfLiteNullBufferHandle if the delegate is built without OpenGL.
+TFL_CAPI_EXPORT TfLiteBufferHandle TfLiteGpuDelegateV2RegisterGlBuffer(
+    TfLiteDelegate* delegate, uint32_t ssbo);
+
 #ifdef __cplusplus
 }
 #endif  // __cplusplus
@@ -104,7 +104,8 @@ class TestModel {
   // Add Hexagon delegate to the graph.
   void ApplyDelegate(int max_batch_size,
                      const std::vector<int>& input_batch_dimensions,
-                     const std::vector<int>& output_batch_dimensions) {
+                     const std::vector<int>& output_batch_dimensions,
+                     bool enable_async_execution = false) {
     TfLiteIntArray* input_batch_dim =
         TfLiteIntArrayCreate(input_batch_dimensions.size());
     TfLiteIntArray* output_batch_dim =
@@ -118,6 +119,7 @@ class TestModel {
     options.max_batch_size = max_batch_size;
     options.input_batch_dimensions = input_batch_dim;
     options.output_batch_dimensions = output_batch_dim;
+    options.enable_async_execution = enable_async_execution;
     TfLiteDelegate* delegate = TfLiteHexagonDelegateCreate(&options);
     ASSERT_TRUE(delegate != nullptr);
     delegate_ = std::unique_ptr<TfLiteDelegate, void (*)(TfLiteDelegate*)>(
@@ -141,6 +143,11 @@ class TestModel {
            input_data.size() * sizeof(uint8));
 
     ASSERT_EQ(kTfLiteOk, interpreter_->Invoke());
+    // Waits for the graph if it runs asynchronously, returns right away
+    // otherwise.
+    if (delegate_ != nullptr) {
+      ASSERT_EQ(kTfLiteOk, TfLiteHexagonDelegateWait(delegate_.get()));
+    }
   }
 
   std::vector<float> GetOutput(int output_index) {
@@ -205,6 +212,24 @@ TEST(HexagonDynamicBatch, MultipleResizes) {
     TFLITE_LOG(INFO) << "Failed " << num_failed_tests << " out of " << num_test;
   }
 }
+
+TEST(HexagonDynamicBatch, MultipleResizesWithAsyncExecution) {
+  auto test_input_shapes = ParseInputShapes();
+  auto default_model = std::make_unique<TestModel>();
+  auto delegated_model = std::make_unique<TestModel>();
+  default_model->Init();
+  delegated_model->Init();
+  delegated_model->ApplyDelegate(absl::GetFlag(FLAGS_max_batch_size), {0}, {0},
+                                 /*enable_async_execution=*/true);
+  for (int i = 0; i < test_input_shapes.size(); ++i) {
+    const auto input = GetData(NumElements(test_input_shapes[i]));
+    default_model->Run(test_input_shapes[i], input);
+    delegated_model->Run(test_input_shapes[i], input);
+    EXPECT_TRUE(DiffOutput(default_model->GetOutput(0),
+                           delegated_model->GetOutput(0)))
+        << "Failed for input " << i;
+  }
+}
 }  // namespace tflite
 
 int main(int argc, char** argv) {
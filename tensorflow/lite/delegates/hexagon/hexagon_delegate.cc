@@ -64,7 +64,7 @@ class HexagonDelegate : public SimpleDelegateInterface {
 
   std::unique_ptr<SimpleDelegateKernelInterface> CreateDelegateKernelInterface()
       override {
-    return std::make_unique<HexagonDelegateKernel>(params_);
+    return std::make_unique<HexagonDelegateKernel>(params_, &async_kernels_);
   }
 
   SimpleDelegateInterface::Options DelegateOptions() const override {
@@ -107,8 +107,11 @@ class HexagonDelegate : public SimpleDelegateInterface {
            hexagon_nn->hexagon_nn_is_device_supported();
   }
 
+  TfLiteStatus WaitForAsyncKernels() { return async_kernels_.WaitAll(); }
+
  private:
   TfLiteHexagonDelegateOptions params_;
+  HexagonAsyncKernels async_kernels_;
 };
 
 }  // namespace
@@ -137,6 +140,13 @@ TfLiteHexagonDelegateOptions TfLiteHexagonDelegateOptionsDefault() {
   return result;
 }
 
+TfLiteStatus TfLiteHexagonDelegateWait(TfLiteDelegate* delegate) {
+  if (delegate == nullptr) return kTfLiteError;
+  auto* hexagon_delegate = static_cast<tflite::HexagonDelegate*>(
+      reinterpret_cast<tflite::SimpleDelegateInterface*>(delegate->data_));
+  return hexagon_delegate->WaitForAsyncKernels();
+}
+
 void TfLiteHexagonDelegateDelete(TfLiteDelegate* delegate) {
   tflite::TfLiteDelegateFactory::DeleteSimpleDelegate(delegate);
 }
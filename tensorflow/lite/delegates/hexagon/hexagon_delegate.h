@@ -88,6 +88,17 @@ struct TFL_CAPI_EXPORT TfLiteHexagonDelegateOptions {
   // should be -1. Delegate will take ownership of the pointer. WARNING:
   // Experimental and subject to change anytime.
   TfLiteIntArray* output_batch_dimensions;
+
+  // If set to true, Invoke() starts running the graph on the DSP and returns
+  // without waiting for it, so that the CPU can prepare the next inputs
+  // meanwhile. The inputs are copied by Invoke(), and can be overwritten as
+  // soon as it returns. The outputs are written by
+  // TfLiteHexagonDelegateWait(), which must be called before reading them.
+  // Can be combined with 'enable_dynamic_batch_size'.
+  // Only supported when the whole graph is delegated, the graph runs
+  // synchronously otherwise.
+  // WARNING: Experimental and subject to change anytime.
+  bool enable_async_execution;
 };
 
 // Return a delegate that uses Hexagon SDK for ops execution.
@@ -99,6 +110,13 @@ TfLiteHexagonDelegateCreate(const TfLiteHexagonDelegateOptions* options);
 TFL_CAPI_EXPORT TfLiteHexagonDelegateOptions
 TfLiteHexagonDelegateOptionsDefault();
 
+// Waits for the graphs started by Invoke() with 'enable_async_execution' to
+// finish running on the DSP, and writes their outputs to the output tensors.
+// Returns kTfLiteError if any of them failed.
+// WARNING: Experimental and subject to change anytime.
+TfLiteStatus TFL_CAPI_EXPORT
+TfLiteHexagonDelegateWait(TfLiteDelegate* delegate);
+
 // Do any needed cleanup and delete 'delegate'.
 void TFL_CAPI_EXPORT TfLiteHexagonDelegateDelete(TfLiteDelegate* delegate);
 
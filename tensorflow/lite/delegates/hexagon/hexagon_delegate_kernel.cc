@@ -14,6 +14,7 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/lite/delegates/hexagon/hexagon_delegate_kernel.h"
 
+#include <algorithm>
 #include <vector>
 
 #include "tensorflow/lite/builtin_ops.h"
@@ -37,6 +38,19 @@ inline uint64_t GetCycles(const hexagon_nn_perfinfo& perf_info) {
 }
 }  // namespace
 
+void HexagonAsyncKernels::Remove(HexagonDelegateKernel* kernel) {
+  kernels_.erase(std::remove(kernels_.begin(), kernels_.end(), kernel),
+                 kernels_.end());
+}
+
+TfLiteStatus HexagonAsyncKernels::WaitAll() {
+  TfLiteStatus status = kTfLiteOk;
+  for (HexagonDelegateKernel* kernel : kernels_) {
+    if (kernel->Wait() != kTfLiteOk) status = kTfLiteError;
+  }
+  return status;
+}
+
 void HexagonDelegateKernel::ReportError(TfLiteContext* context,
                                         const std::string& msg) {
   PrintLog();
@@ -81,6 +95,21 @@ TfLiteStatus HexagonDelegateKernel::Init(TfLiteContext* context,
     nodes_.push_back(node_index);
   }
 
+  if (params_.enable_async_execution && async_kernels_ != nullptr) {
+    // The CPU nodes following a partition would need its outputs before they
+    // are written, so only a graph delegated whole can run asynchronously.
+    TfLiteIntArray* plan;
+    TF_LITE_ENSURE_STATUS(context->GetExecutionPlan(context, &plan));
+    if (plan->size == params->nodes_to_replace->size) {
+      async_execution_ = true;
+      async_kernels_->Add(this);
+    } else {
+      TF_LITE_KERNEL_LOG(context,
+                         "Hexagon delegate: async execution needs the whole "
+                         "graph to be delegated, running synchronously.");
+    }
+  }
+
   TF_LITE_ENSURE_STATUS(
       BuildGraph(context, params->input_tensors, params->output_tensors));
   return kTfLiteOk;
@@ -92,6 +121,9 @@ TfLiteStatus HexagonDelegateKernel::Eval(TfLiteContext* context,
     TF_LITE_KERNEL_LOG(context, "Hexagon interface not available.");
     return kTfLiteError;
   }
+  // The graph runs one inference at a time.
+  TF_LITE_ENSURE_STATUS(Wait());
+
   // Allocate inputs.
   std::vector<hexagon_nn_tensordef> input_tensors;
   for (int input_idx = 0; input_idx < node->inputs->size; ++input_idx) {
@@ -121,6 +153,7 @@ TfLiteStatus HexagonDelegateKernel::Eval(TfLiteContext* context,
 
   // Allocate outputs.
   std::vector<hexagon_nn_tensordef> output_tensors;
+  output_tensor_indices_.clear();
   for (auto tensor_index : TfLiteIntArrayView(node->outputs)) {
     if (tensor_index == kTfLiteOptionalTensor) {
       continue;
@@ -135,7 +168,38 @@ TfLiteStatus HexagonDelegateKernel::Eval(TfLiteContext* context,
       auto& output_tensor = output_tensors.back();
       output_tensor.data = reinterpret_cast<unsigned char*>(tensor->data.raw);
       output_tensor.dataLen = tensor->bytes;
+      output_tensor_indices_.push_back(tensor_index);
+    }
+  }
+
+  if (async_execution_) {
+    // Run on copies of the inputs, so that the next ones can be written to
+    // the tensors while the DSP runs.
+    input_buffers_.resize(input_tensors.size());
+    for (int i = 0; i < input_tensors.size(); ++i) {
+      auto& input_tensor = input_tensors[i];
+      input_buffers_[i].assign(input_tensor.data,
+                               input_tensor.data + input_tensor.dataLen);
+      input_tensor.data = input_buffers_[i].data();
     }
+    output_buffers_.resize(output_tensors.size());
+    for (int i = 0; i < output_tensors.size(); ++i) {
+      output_buffers_[i].resize(output_tensors[i].dataLen);
+      output_tensors[i].data = output_buffers_[i].data();
+    }
+    if (params_.print_graph_profile) {
+      hexagon_nn_->hexagon_nn_reset_perfinfo(graph_id_, 0);
+    }
+    execution_context_ = context;
+    execution_ = std::thread(
+        [this](std::vector<hexagon_nn_tensordef> input_tensors,
+               std::vector<hexagon_nn_tensordef> output_tensors) {
+          execution_error_ = hexagon_nn_->hexagon_nn_execute_new(
+              graph_id_, input_tensors.data(), input_tensors.size(),
+              output_tensors.data(), output_tensors.size());
+        },
+        std::move(input_tensors), std::move(output_tensors));
+    return kTfLiteOk;
   }
 
   if (params_.print_graph_profile) {
@@ -157,6 +221,25 @@ TfLiteStatus HexagonDelegateKernel::Eval(TfLiteContext* context,
   return kTfLiteOk;
 }
 
+TfLiteStatus HexagonDelegateKernel::Wait() {
+  if (!execution_.joinable()) return kTfLiteOk;
+  execution_.join();
+  TfLiteContext* context = execution_context_;
+  if (execution_error_ != 0) {
+    ReportError(context, "Failed to execute graph.");
+    return kTfLiteError;
+  }
+  for (int i = 0; i < output_tensor_indices_.size(); ++i) {
+    TfLiteTensor* tensor = &context->tensors[output_tensor_indices_[i]];
+    std::copy(output_buffers_[i].begin(), output_buffers_[i].end(),
+              reinterpret_cast<unsigned char*>(tensor->data.raw));
+  }
+  if (params_.print_graph_profile) {
+    PrintPerformanceData(reinterpret_cast<Profiler*>(context->profiler));
+  }
+  return kTfLiteOk;
+}
+
 TfLiteStatus HexagonDelegateKernel::ResizeOutputTensors(TfLiteContext* context,
                                                         TfLiteNode* node) {
   if (!params_.enable_dynamic_batch_size) return kTfLiteError;
@@ -189,6 +272,9 @@ TfLiteStatus HexagonDelegateKernel::ResizeOutputTensors(TfLiteContext* context,
 
 TfLiteStatus HexagonDelegateKernel::Prepare(TfLiteContext* context,
                                             TfLiteNode* node) {
+  // The outputs of a running graph must be written before the tensors are
+  // reallocated.
+  TF_LITE_ENSURE_STATUS(Wait());
   if (graph_prepared_) {
     if (!params_.enable_dynamic_batch_size)
       TF_LITE_KERNEL_LOG(context, "Calling prepare multiple times");
@@ -285,6 +371,8 @@ TfLiteStatus HexagonDelegateKernel::BuildGraph(
 }
 
 HexagonDelegateKernel::~HexagonDelegateKernel() {
+  if (execution_.joinable()) execution_.join();
+  if (async_execution_) async_kernels_->Remove(this);
   if (graph_id_ != -1) {
     hexagon_nn_->hexagon_nn_teardown(graph_id_);
   }
@@ -19,6 +19,7 @@ limitations under the License.
 
 #include <memory>
 #include <string>
+#include <thread>  // NOLINT(build/c++11)
 #include <utility>
 #include <vector>
 
@@ -36,13 +37,32 @@ limitations under the License.
 
 namespace tflite {
 
+class HexagonDelegateKernel;
+
+// The kernels of a delegate running their graph asynchronously, for
+// TfLiteHexagonDelegateWait() to wait for.
+class HexagonAsyncKernels {
+ public:
+  void Add(HexagonDelegateKernel* kernel) { kernels_.push_back(kernel); }
+  void Remove(HexagonDelegateKernel* kernel);
+
+  // Waits for all the kernels to finish running.
+  TfLiteStatus WaitAll();
+
+ private:
+  std::vector<HexagonDelegateKernel*> kernels_;
+};
+
 // Represents an abstraction of a Hexagon NNLib graph with functionality to
 // initialize, prepare and invoke it based on the TFLite subgraph to be
 // delegated.
 class HexagonDelegateKernel : public SimpleDelegateKernelInterface {
  public:
-  explicit HexagonDelegateKernel(const ::TfLiteHexagonDelegateOptions& params)
-      : params_(params) {}
+  // 'async_kernels' tracks the kernel if it runs its graph asynchronously,
+  // and must outlive it.
+  HexagonDelegateKernel(const ::TfLiteHexagonDelegateOptions& params,
+                        HexagonAsyncKernels* async_kernels)
+      : params_(params), async_kernels_(async_kernels) {}
 
   // Initialize the Hexagon graph and add required nodes.
   TfLiteStatus Init(TfLiteContext* context,
@@ -63,6 +83,10 @@ class HexagonDelegateKernel : public SimpleDelegateKernelInterface {
   // Teardown the environment initialized in InitState.
   static void Teardown();
 
+  // Waits for the graph started by an async Eval to finish running, and
+  // copies its outputs to the output tensors.
+  TfLiteStatus Wait();
+
  private:
   // Builds the Hexagon graph based on delegated TFLite subgraph.
   TfLiteStatus BuildGraph(TfLiteContext* context,
@@ -94,6 +118,20 @@ class HexagonDelegateKernel : public SimpleDelegateKernelInterface {
 
   // Whether the Hexagon graph is prepared or not.
   bool graph_prepared_ = false;
+
+  // Set when the graph runs asynchronously, see
+  // TfLiteHexagonDelegateOptions::enable_async_execution.
+  HexagonAsyncKernels* async_kernels_ = nullptr;  // Not owned.
+  bool async_execution_ = false;
+  // Runs the graph started by the last async Eval, if not waited for yet.
+  std::thread execution_;
+  int execution_error_ = 0;
+  TfLiteContext* execution_context_ = nullptr;  // Not owned.
+  // Copies of the inputs the graph runs on, and the buffers it writes its
+  // outputs to, which Wait copies to the tensors in 'output_tensor_indices_'.
+  std::vector<std::vector<unsigned char>> input_buffers_;
+  std::vector<std::vector<unsigned char>> output_buffers_;
+  std::vector<int> output_tensor_indices_;
 };
 
 }  // namespace tflite
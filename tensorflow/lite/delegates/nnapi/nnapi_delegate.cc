@@ -4422,6 +4422,9 @@ StatefulNnApiDelegate::Data::~Data() {
                 [](const std::pair<int, NNAPIDelegateKernel*>& entry) {
                   delete entry.second;
                 });
+  for (const auto& entry : owned_memories) {
+    nnapi->ANeuralNetworksMemory_free(entry.second);
+  }
 }
 
 void StatefulNnApiDelegate::Data::CacheDelegateKernel(
@@ -4477,6 +4480,8 @@ StatefulNnApiDelegate::StatefulNnApiDelegate(const NnApi* nnapi,
   if (nnapi->android_sdk_version >= kMinSdkVersionForNNAPI11) {
     delegate_data_.allow_dynamic_dimensions = options.allow_dynamic_dimensions;
   }
+  delegate_data_.use_partition_cost_model = options.use_partition_cost_model;
+  delegate_data_.partition_cost_model = options.partition_cost_model;
   TFLITE_LOG_PROD_ONCE(tflite::TFLITE_LOG_INFO,
                        "Created TensorFlow Lite delegate for NNAPI.");
   Prepare = DoPrepare;
@@ -4519,6 +4524,8 @@ const StatefulNnApiDelegate::Options StatefulNnApiDelegate::GetOptions(
   options.max_execution_loop_timeout_duration_ns =
       delegate_data->max_execution_loop_timeout_duration_ns;
   options.allow_dynamic_dimensions = delegate_data->allow_dynamic_dimensions;
+  options.use_partition_cost_model = delegate_data->use_partition_cost_model;
+  options.partition_cost_model = delegate_data->partition_cost_model;
   return options;
 }
 
@@ -4544,6 +4551,27 @@ TfLiteBufferHandle StatefulNnApiDelegate::RegisterNnapiMemory(
   return map_size;
 }
 
+TfLiteBufferHandle StatefulNnApiDelegate::RegisterHardwareBuffer(
+    const AHardwareBuffer* buffer, CopyToHostTensorFnPtr callback,
+    void* callback_context) {
+  const NnApi* nnapi = delegate_data_.nnapi;
+  if (nnapi->android_sdk_version < kMinSdkVersionForNNAPI12 ||
+      nnapi->ANeuralNetworksMemory_createFromAHardwareBuffer == nullptr) {
+    return kTfLiteNullBufferHandle;
+  }
+  ANeuralNetworksMemory* memory = nullptr;
+  const int result =
+      nnapi->ANeuralNetworksMemory_createFromAHardwareBuffer(buffer, &memory);
+  if (result != ANEURALNETWORKS_NO_ERROR) {
+    delegate_data_.nnapi_errno = result;
+    return kTfLiteNullBufferHandle;
+  }
+  const TfLiteBufferHandle handle =
+      RegisterNnapiMemory(memory, callback, callback_context);
+  delegate_data_.owned_memories[handle] = memory;
+  return handle;
+}
+
 TfLiteStatus StatefulNnApiDelegate::DoCopyFromBufferHandle(
     TfLiteContext* context, TfLiteDelegate* delegate,
     TfLiteBufferHandle buffer_handle, TfLiteTensor* tensor) {
@@ -4574,6 +4602,11 @@ void StatefulNnApiDelegate::DoFreeBufferHandle(TfLiteContext* context,
   auto delegate_data = reinterpret_cast<Data*>(delegate->data_);
   if (*handle >= 0 && *handle < delegate_data->tensor_memory_map.size()) {
     delegate_data->tensor_memory_map[*handle] = {nullptr, nullptr, nullptr};
+    auto owned_it = delegate_data->owned_memories.find(*handle);
+    if (owned_it != delegate_data->owned_memories.end()) {
+      delegate_data->nnapi->ANeuralNetworksMemory_free(owned_it->second);
+      delegate_data->owned_memories.erase(owned_it);
+    }
     *handle = kTfLiteNullBufferHandle;
   }
 }
@@ -4676,6 +4709,74 @@ TfLiteStatus StatefulNnApiDelegate::LimitDelegatedPartitions(
   return kTfLiteOk;
 }
 
+// static
+float StatefulNnApiDelegate::EstimatePartitionGainUs(
+    const TfLiteContext* context, const PartitionCostModel& cost_model,
+    const TfLiteDelegateParams& partition_params) {
+  float cpu_us = 0;
+  for (int node_index : TfLiteIntArrayView(partition_params.nodes_to_replace)) {
+    cpu_us += static_cast<size_t>(node_index) < cost_model.node_cpu_us.size()
+                  ? cost_model.node_cpu_us[node_index]
+                  : cost_model.default_node_cpu_us;
+  }
+  const float accelerator_us =
+      cpu_us / std::max(cost_model.accelerator_speedup, 1e-6f);
+
+  // Constant inputs are copied to the accelerator once, at compilation.
+  size_t transfer_bytes = 0;
+  for (int tensor_index : TfLiteIntArrayView(partition_params.input_tensors)) {
+    if (tensor_index == kTfLiteOptionalTensor) continue;
+    const TfLiteTensor& tensor = context->tensors[tensor_index];
+    if (tensor.allocation_type != kTfLiteMmapRo) {
+      transfer_bytes += tensor.bytes;
+    }
+  }
+  for (int tensor_index : TfLiteIntArrayView(partition_params.output_tensors)) {
+    transfer_bytes += context->tensors[tensor_index].bytes;
+  }
+
+  return cpu_us - accelerator_us - cost_model.partition_overhead_us -
+         transfer_bytes * cost_model.transfer_us_per_byte;
+}
+
+// static
+TfLiteStatus StatefulNnApiDelegate::SelectPartitionsByCost(
+    const TfLiteContext* context, const PartitionCostModel& cost_model,
+    int max_partitions,
+    const std::vector<TfLiteDelegateParams>& partition_params_array,
+    std::vector<int>* nodes_to_delegate) {
+  // The partitions worth delegating with the time they save.
+  std::vector<std::pair<float, const TfLiteDelegateParams*>> gains;
+  for (const TfLiteDelegateParams& partition_params : partition_params_array) {
+    if (std::find(nodes_to_delegate->begin(), nodes_to_delegate->end(),
+                  partition_params.nodes_to_replace->data[0]) ==
+        nodes_to_delegate->end()) {
+      continue;
+    }
+    const float gain_us =
+        EstimatePartitionGainUs(context, cost_model, partition_params);
+    if (gain_us > 0) {
+      gains.emplace_back(gain_us, &partition_params);
+    }
+  }
+  std::stable_sort(gains.begin(), gains.end(),
+                   [](const std::pair<float, const TfLiteDelegateParams*>& left,
+                      const std::pair<float, const TfLiteDelegateParams*>&
+                          right) { return left.first > right.first; });
+  const int num_partitions = gains.size();
+  if (max_partitions > 0 && num_partitions > max_partitions) {
+    gains.resize(max_partitions);
+  }
+
+  nodes_to_delegate->clear();
+  for (const auto& gain : gains) {
+    const TfLiteIntArray* nodes = gain.second->nodes_to_replace;
+    nodes_to_delegate->insert(nodes_to_delegate->end(), nodes->data,
+                              nodes->data + nodes->size);
+  }
+  return kTfLiteOk;
+}
+
 TfLiteStatus StatefulNnApiDelegate::DoPrepare(TfLiteContext* context,
                                               TfLiteDelegate* delegate) {
   auto* delegate_data = static_cast<Data*>(delegate->data_);
@@ -4824,11 +4925,20 @@ TfLiteStatus StatefulNnApiDelegate::DoPrepare(TfLiteContext* context,
         &num_partitions));
   }
 
-  TF_LITE_ENSURE_STATUS(
-      LimitDelegatedPartitions(delegate_options.max_number_delegated_partitions,
-                               std::vector<TfLiteDelegateParams>(
-                                   params_array, params_array + num_partitions),
-                               &nodes_to_delegate));
+  if (delegate_options.use_partition_cost_model) {
+    TF_LITE_ENSURE_STATUS(SelectPartitionsByCost(
+        context, delegate_options.partition_cost_model,
+        delegate_options.max_number_delegated_partitions,
+        std::vector<TfLiteDelegateParams>(params_array,
+                                          params_array + num_partitions),
+        &nodes_to_delegate));
+  } else {
+    TF_LITE_ENSURE_STATUS(LimitDelegatedPartitions(
+        delegate_options.max_number_delegated_partitions,
+        std::vector<TfLiteDelegateParams>(params_array,
+                                          params_array + num_partitions),
+        &nodes_to_delegate));
+  }
 
   if (nodes_to_delegate.empty()) {
     return kTfLiteOk;
@@ -39,6 +39,26 @@ using tflite::delegate::nnapi::NNAPIDelegateKernel;
 // TFliteDelegate to interface with NNAPI.
 class StatefulNnApiDelegate : public TfLiteDelegate {
  public:
+  // Estimates the time delegating a partition saves per inference, from the
+  // CPU runtime of its nodes and the cost of running it on the accelerator.
+  // The defaults are rough figures for a mobile accelerator, the times
+  // measured by a calibration run on the target device are more accurate.
+  struct PartitionCostModel {
+    // The CPU runtime of each node in microseconds, indexed by node, e.g. as
+    // measured by a profiled run of the model without delegates. The nodes
+    // past its end run for default_node_cpu_us.
+    std::vector<float> node_cpu_us;
+    float default_node_cpu_us = 100.0f;
+    // How many times faster than the CPU the accelerator runs the nodes.
+    float accelerator_speedup = 4.0f;
+    // The time to transfer a byte of the non-constant inputs or of the
+    // outputs of a partition between the CPU and the accelerator.
+    float transfer_us_per_byte = 0.001f;
+    // The time each execution of a partition takes on top of its nodes, e.g.
+    // to schedule it on the accelerator.
+    float partition_overhead_us = 100.0f;
+  };
+
   // Encapsulates all options that are specific to NNAPI delegate.
   struct Options {
     // Preferred Power/perf trade-off. For more details please see
@@ -125,6 +145,13 @@ class StatefulNnApiDelegate : public TfLiteDelegate {
     // accelerator. This should only be enabled if the target device supports
     // dynamic dimensions of the model.
     bool allow_dynamic_dimensions = false;
+
+    // Whether to choose the partitions to delegate with partition_cost_model
+    // rather than by their number of nodes. Only the partitions estimated to
+    // save time are delegated, and if there are more than
+    // max_number_delegated_partitions of them, the ones saving the most.
+    bool use_partition_cost_model = false;
+    PartitionCostModel partition_cost_model;
   };
 
   // Uses default options.
@@ -173,6 +200,19 @@ class StatefulNnApiDelegate : public TfLiteDelegate {
                                          CopyToHostTensorFnPtr callback,
                                          void* callback_context);
 
+  // Wraps the AHardwareBuffer in an ANeuralNetworksMemory owned by the
+  // delegate, and registers it as RegisterNnapiMemory does. Tensors bound to
+  // the returned TfLiteBufferHandle with Interpreter::SetBufferHandle are read
+  // and written by NNAPI directly in the hardware buffer, e.g. a camera frame,
+  // without a copy through the CPU tensor.
+  // The buffer must be of format AHARDWAREBUFFER_FORMAT_BLOB, and stay valid
+  // until the handle is freed. Returns kTfLiteNullBufferHandle if the memory
+  // can't be created, e.g. before NNAPI 1.2.
+  // WARNING: This is an experimental interface that is subject to change.
+  TfLiteBufferHandle RegisterHardwareBuffer(const AHardwareBuffer* buffer,
+                                            CopyToHostTensorFnPtr callback,
+                                            void* callback_context);
+
   // Returns the vector of known ANeuralNetworksMemory handles.
   // Note: this function is not intended to be called by developers.
   // WARNING: This is an experimental interface that is subject to change.
@@ -208,6 +248,10 @@ class StatefulNnApiDelegate : public TfLiteDelegate {
     bool disallow_nnapi_cpu;
     // Tensor to ANeuralNetworksMemory mapping.
     std::vector<MemoryRegistration> tensor_memory_map;
+    // The ANeuralNetworksMemory created by RegisterHardwareBuffer, keyed by
+    // their buffer handle. They are freed with the handle.
+    std::unordered_map<TfLiteBufferHandle, ANeuralNetworksMemory*>
+        owned_memories;
     // Contains a non zero value if any NNAPI method call
     // operation returned a non zero result code.
     int nnapi_errno = ANEURALNETWORKS_NO_ERROR;
@@ -235,6 +279,9 @@ class StatefulNnApiDelegate : public TfLiteDelegate {
     uint64_t max_execution_loop_timeout_duration_ns = 0;
     // Whether to allow dynamic dimension sizes without re-compilation.
     bool allow_dynamic_dimensions = false;
+    // Whether to choose the partitions to delegate with partition_cost_model.
+    bool use_partition_cost_model = false;
+    PartitionCostModel partition_cost_model;
 
     explicit Data(const NnApi* nnapi);
     ~Data();
@@ -304,6 +351,23 @@ class StatefulNnApiDelegate : public TfLiteDelegate {
       std::vector<TfLiteDelegateParams> partition_params_array,
       std::vector<int>* nodes_to_delegate);
 
+  // Returns the microseconds per inference that delegating the partition
+  // described by `partition_params` saves according to `cost_model`. The
+  // result is negative if the partition runs faster on the CPU.
+  static float EstimatePartitionGainUs(
+      const TfLiteContext* context, const PartitionCostModel& cost_model,
+      const TfLiteDelegateParams& partition_params);
+
+  // Alters the given array of nodes_to_delegate, in the same format as
+  // LimitDelegatedPartitions, to only contain the nodes of the partitions
+  // estimated to save time by `cost_model`. If max_partitions is positive, at
+  // most max_partitions of them, saving the most time, are kept.
+  static TfLiteStatus SelectPartitionsByCost(
+      const TfLiteContext* context, const PartitionCostModel& cost_model,
+      int max_partitions,
+      const std::vector<TfLiteDelegateParams>& partition_params_array,
+      std::vector<int>* nodes_to_delegate);
+
   // Delegate data presented through TfLiteDelegate::data_.
   Data delegate_data_;
 };
@@ -234,6 +234,12 @@ class AcceleratedModel {
     stateful_delegate_.reset(new StatefulNnApiDelegate(nnapi, options));
   }
 
+  // build a delegate with the given options.
+  AcceleratedModel(const NnApi* nnapi,
+                   const StatefulNnApiDelegate::Options& options) {
+    stateful_delegate_.reset(new StatefulNnApiDelegate(nnapi, options));
+  }
+
  private:
   std::unique_ptr<StatefulNnApiDelegate> stateful_delegate_;
 };
@@ -817,6 +823,14 @@ class LongIdentityModel : public MultiOpModel, public AcceleratedModel {
     Init(input_shape, graph_size, custom_nodes_indexes);
   }
 
+  LongIdentityModel(const std::vector<int>& input_shape, int graph_size,
+                    const NnApi* nnapi,
+                    const StatefulNnApiDelegate::Options& options)
+      : MultiOpModel(), AcceleratedModel(nnapi, options) {
+    Init(input_shape, graph_size,
+         /*custom_nodes_indexes=*/std::unordered_set<int>());
+  }
+
   void SetInput(std::vector<float> value) { PopulateTensor(input_, value); }
 
   int CountNnApiPartitions() {
@@ -950,19 +964,8 @@ class DelegatePartitionLimitTest
             const std::vector<int>& nnapi_partition_sizes,
             const std::vector<int>& input_shape,
             bool specify_accelerator = true) {
-    // The graph will have as number of nodes the sum of nodes in the NNAPI
-    // partitions plus nnapi_partition_sizes.size() - 1 nodes that will be
-    // not supported by NNAPI and will cause the
-    graph_size_ = std::accumulate(std::begin(nnapi_partition_sizes),
-                                  std::end(nnapi_partition_sizes),
-                                  nnapi_partition_sizes.size() - 1);
-
-    std::unordered_set<int> unsupported_ops_idxs;
-    int partition_node_idx = -1;
-    for (int i = 0; i < nnapi_partition_sizes.size() - 1; i++) {
-      partition_node_idx += nnapi_partition_sizes[i] + 1;
-      unsupported_ops_idxs.insert(partition_node_idx);
-    }
+    std::unordered_set<int> unsupported_ops_idxs =
+        UnsupportedOpsIndexes(nnapi_partition_sizes);
 
     if (specify_accelerator) {
       // Building a model that will contain initially a single partition
@@ -996,11 +999,53 @@ class DelegatePartitionLimitTest
     }
   }
 
+  // Configures the graph as Init does, delegating to "test-device" with the
+  // partition cost model of `options`.
+  void InitWithCostModel(StatefulNnApiDelegate::Options options,
+                         const std::vector<int>& nnapi_partition_sizes,
+                         const std::vector<int>& input_shape) {
+    const std::unordered_set<int> unsupported_ops_idxs =
+        UnsupportedOpsIndexes(nnapi_partition_sizes);
+    DelegatePartitionLimitTestNodeFilter()->ConfigureSupportedNodes(
+        graph_size_, unsupported_ops_idxs);
+    nnapi_mock_->StubGetSupportedOperationsForDevicesWith(
+        [](const ANeuralNetworksModel* model,
+           const ANeuralNetworksDevice* const* devices, uint32_t num_devices,
+           bool* supported_ops) -> int {
+          DelegatePartitionLimitTestNodeFilter()->SetNodeSupport(supported_ops);
+          return ANEURALNETWORKS_NO_ERROR;
+        });
+
+    options.accelerator_name = "test-device";
+    options.use_partition_cost_model = true;
+    model_ = std::make_unique<LongIdentityModel>(
+        input_shape, graph_size_, nnapi_mock_->GetNnApi(), options);
+  }
+
   std::unique_ptr<LongIdentityModel> model_;
 
   int OriginalGraphSize() { return graph_size_; }
 
  private:
+  // Returns the indexes of the nodes separating the NNAPI partitions, and sets
+  // graph_size_. The graph will have as number of nodes the sum of nodes in
+  // the NNAPI partitions plus nnapi_partition_sizes.size() - 1 nodes that
+  // will be not supported by NNAPI and will cause the partitioning.
+  std::unordered_set<int> UnsupportedOpsIndexes(
+      const std::vector<int>& nnapi_partition_sizes) {
+    graph_size_ = std::accumulate(std::begin(nnapi_partition_sizes),
+                                  std::end(nnapi_partition_sizes),
+                                  nnapi_partition_sizes.size() - 1);
+
+    std::unordered_set<int> unsupported_ops_idxs;
+    int partition_node_idx = -1;
+    for (int i = 0; i < nnapi_partition_sizes.size() - 1; i++) {
+      partition_node_idx += nnapi_partition_sizes[i] + 1;
+      unsupported_ops_idxs.insert(partition_node_idx);
+    }
+    return unsupported_ops_idxs;
+  }
+
   int graph_size_;
 };
 
@@ -1078,6 +1123,46 @@ TEST_F(DelegatePartitionLimitTest,
       OriginalGraphSize() - (kLargestModelSize + kSecondLargestModelSize));
 }
 
+TEST_F(DelegatePartitionLimitTest, CostModelShouldNotDelegateSmallPartitions) {
+  StatefulNnApiDelegate::Options options;
+  options.max_number_delegated_partitions = 0;
+  // With the default costs, a single node partition saves less time than it
+  // takes to run it on the accelerator.
+  InitWithCostModel(options,
+                    /*nnapi_partition_sizes=*/{3, 1},
+                    /*input_shape=*/{1, 2, 2, 1});
+
+  EXPECT_EQ(model_->CountNnApiPartitions(), 1);
+  EXPECT_EQ(model_->CountOpsExecutedByCpuKernel(), OriginalGraphSize() - 3);
+}
+
+TEST_F(DelegatePartitionLimitTest,
+       CostModelShouldDelegatePartitionsSavingMostTime) {
+  StatefulNnApiDelegate::Options options;
+  options.max_number_delegated_partitions = 1;
+  // The two last nodes form the second partition, and are the slowest on CPU.
+  options.partition_cost_model.node_cpu_us = {100, 100, 100,
+                                              100, 1000, 1000};
+  InitWithCostModel(options,
+                    /*nnapi_partition_sizes=*/{3, 2},
+                    /*input_shape=*/{1, 2, 2, 1});
+
+  EXPECT_EQ(model_->CountNnApiPartitions(), 1);
+  EXPECT_EQ(model_->CountOpsExecutedByCpuKernel(), OriginalGraphSize() - 2);
+}
+
+TEST_F(DelegatePartitionLimitTest,
+       CostModelShouldNotDelegateIfTransfersAreTooSlow) {
+  StatefulNnApiDelegate::Options options;
+  options.partition_cost_model.transfer_us_per_byte = 100;
+  InitWithCostModel(options,
+                    /*nnapi_partition_sizes=*/{3, 2},
+                    /*input_shape=*/{1, 2, 2, 1});
+
+  EXPECT_EQ(model_->CountNnApiPartitions(), 0);
+  EXPECT_EQ(model_->CountOpsExecutedByCpuKernel(), OriginalGraphSize());
+}
+
 }  // namespace
 }  // namespace tflite
 
@@ -50,6 +50,12 @@ TfLiteBufferHandle StatefulNnApiDelegate::RegisterNnapiMemory(
   return kTfLiteNullBufferHandle;
 }
 
+TfLiteBufferHandle StatefulNnApiDelegate::RegisterHardwareBuffer(
+    const AHardwareBuffer* buffer, CopyToHostTensorFnPtr callback,
+    void* callback_context) {
+  return kTfLiteNullBufferHandle;
+}
+
 int StatefulNnApiDelegate::GetNnApiErrno() const { return 0; }
 
 using ::tflite::delegate::nnapi::NNAPIDelegateKernel;
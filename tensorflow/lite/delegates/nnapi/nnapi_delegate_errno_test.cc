@@ -177,6 +177,22 @@ TEST_F(NnApiErrnoTest, ErrnoIsUpdatedInCaseOfAnotherFailure) {
   EXPECT_EQ(m.GetDelegate()->GetNnApiErrno(), -5);
 }
 
+TEST_F(NnApiErrnoTest, HasTheStatusOfTheNnApiCallFailedRegisteringBuffer) {
+  nnapi_mock_->MemoryCreateFromAHardwareBufferReturns<4>();
+
+  StatefulNnApiDelegate delegate(nnapi_mock_->GetNnApi());
+  const AHardwareBuffer* buffer = reinterpret_cast<AHardwareBuffer*>(1);
+
+  EXPECT_EQ(delegate.RegisterHardwareBuffer(buffer, nullptr, nullptr),
+            kTfLiteNullBufferHandle);
+  EXPECT_EQ(delegate.GetNnApiErrno(), 4);
+
+  nnapi_mock_->MemoryCreateFromAHardwareBufferReturns<0>();
+
+  EXPECT_EQ(delegate.RegisterHardwareBuffer(buffer, nullptr, nullptr), 0);
+  EXPECT_EQ(StatefulNnApiDelegate::GetTensorMemoryMap(&delegate).size(), 1);
+}
+
 }  // namespace
 }  // namespace tflite
 
@@ -62,6 +62,7 @@ class NnApiMock : public ::tflite::nnapi::NnApiHandler {
     RelaxComputationFloatReturns<ANEURALNETWORKS_NO_ERROR>();
     ModelFinishReturns<ANEURALNETWORKS_NO_ERROR>();
     MemoryCreateFromFdReturns<ANEURALNETWORKS_NO_ERROR>();
+    MemoryCreateFromAHardwareBufferReturns<ANEURALNETWORKS_NO_ERROR>();
     CompilationCreateReturns<ANEURALNETWORKS_NO_ERROR>();
     CompilationCreateForDevicesReturns<ANEURALNETWORKS_NO_ERROR>();
     CompilationFinishReturns<ANEURALNETWORKS_NO_ERROR>();
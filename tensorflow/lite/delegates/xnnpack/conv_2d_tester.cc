@@ -15,7 +15,9 @@ limitations under the License.
 
 #include "tensorflow/lite/delegates/xnnpack/conv_2d_tester.h"
 
+#include <algorithm>
 #include <array>
+#include <cmath>
 #include <cstdint>
 #include <functional>
 #include <random>
@@ -95,8 +97,16 @@ void Conv2DTester::Test(TfLiteDelegate* delegate) const {
           const int32_t index = ((i * OutputHeight() + y) * OutputWidth() + x) *
                                     OutputChannels() +
                                 c;
+          // With dynamic-range weights, the default kernel quantizes the
+          // inputs, while the delegate computes in float with the
+          // dequantized filter.
+          const float tolerance =
+              DynamicRangeWeights()
+                  ? std::max(std::abs(default_output_data[index]), 1.0f) *
+                        2.0e-2f
+                  : std::abs(default_output_data[index]) * 3.0e-6f;
           ASSERT_NEAR(default_output_data[index], delegate_output_data[index],
-                      std::abs(default_output_data[index]) * 3.0e-6f)
+                      tolerance)
               << "batch " << i << " / " << BatchSize() << ", y position " << y
               << " / " << OutputHeight() << ", x position " << x << " / "
               << OutputWidth() << ", channel " << c << " / "
@@ -119,6 +129,7 @@ std::vector<char> Conv2DTester::CreateTfLiteModel() const {
   std::vector<flatbuffers::Offset<tflite::Operator>> operators;
   std::vector<flatbuffers::Offset<tflite::Buffer>> buffers{
       {CreateBuffer(builder, builder.CreateVector({}))}};
+  std::vector<float> filter_scales(OutputChannels());
 
   if (FP16Weights()) {
     operator_codes.emplace_back(
@@ -205,10 +216,34 @@ std::vector<char> Conv2DTester::CreateTfLiteModel() const {
       }
     }
 
-    buffers.emplace_back(CreateBuffer(
-        builder, builder.CreateVector(
-                     reinterpret_cast<const uint8_t*>(filter_data.data()),
-                     sizeof(float) * filter_data.size())));
+    if (DynamicRangeWeights()) {
+      const int32_t filter_channel_size =
+          KernelHeight() * KernelWidth() * InputChannels();
+      std::vector<int8_t> quantized_filter_data(filter_data.size());
+      for (int32_t oc = 0; oc < OutputChannels(); oc++) {
+        const float* channel_data = &filter_data[oc * filter_channel_size];
+        float max_abs_filter = 0.0f;
+        for (int32_t i = 0; i < filter_channel_size; i++) {
+          max_abs_filter = std::max(max_abs_filter, std::abs(channel_data[i]));
+        }
+        filter_scales[oc] = std::max(max_abs_filter, 1.0f) / 127.0f;
+        for (int32_t i = 0; i < filter_channel_size; i++) {
+          quantized_filter_data[oc * filter_channel_size + i] =
+              static_cast<int8_t>(
+                  std::round(channel_data[i] / filter_scales[oc]));
+        }
+      }
+      buffers.emplace_back(CreateBuffer(
+          builder,
+          builder.CreateVector(
+              reinterpret_cast<const uint8_t*>(quantized_filter_data.data()),
+              quantized_filter_data.size())));
+    } else {
+      buffers.emplace_back(CreateBuffer(
+          builder, builder.CreateVector(
+                       reinterpret_cast<const uint8_t*>(filter_data.data()),
+                       sizeof(float) * filter_data.size())));
+    }
     buffers.emplace_back(CreateBuffer(
         builder,
         builder.CreateVector(reinterpret_cast<const uint8_t*>(bias_data.data()),
@@ -274,10 +309,25 @@ std::vector<char> Conv2DTester::CreateTfLiteModel() const {
       builder,
       builder.CreateVector<int32_t>(input_shape.data(), input_shape.size()),
       TensorType_FLOAT32));
-  tensors.emplace_back(CreateTensor(
-      builder,
-      builder.CreateVector<int32_t>(filter_shape.data(), filter_shape.size()),
-      TensorType_FLOAT32, /*buffer=*/FP16Weights() || SparseWeights() ? 0 : 1));
+  if (DynamicRangeWeights()) {
+    tensors.emplace_back(CreateTensor(
+        builder,
+        builder.CreateVector<int32_t>(filter_shape.data(), filter_shape.size()),
+        TensorType_INT8, /*buffer=*/1, /*name=*/0,
+        CreateQuantizationParameters(
+            builder, /*min=*/0, /*max=*/0,
+            builder.CreateVector<float>(filter_scales),
+            builder.CreateVector<int64_t>(
+                std::vector<int64_t>(OutputChannels(), 0)),
+            QuantizationDetails_NONE, /*details=*/0,
+            /*quantized_dimension=*/0)));
+  } else {
+    tensors.emplace_back(CreateTensor(
+        builder,
+        builder.CreateVector<int32_t>(filter_shape.data(), filter_shape.size()),
+        TensorType_FLOAT32,
+        /*buffer=*/FP16Weights() || SparseWeights() ? 0 : 1));
+  }
   tensors.emplace_back(CreateTensor(
       builder,
       builder.CreateVector<int32_t>(bias_shape.data(), bias_shape.size()),
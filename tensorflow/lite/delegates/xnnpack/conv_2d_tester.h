@@ -162,6 +162,15 @@ class Conv2DTester {
 
   inline bool SparseWeights() const { return sparse_weights_; }
 
+  // Stores the filter as int8 with per-channel quantization, consumed directly
+  // by a dynamic-range (hybrid) CONV_2D operator.
+  inline Conv2DTester& DynamicRangeWeights() {
+    dynamic_range_weights_ = true;
+    return *this;
+  }
+
+  inline bool DynamicRangeWeights() const { return dynamic_range_weights_; }
+
   inline Conv2DTester& SamePadding() {
     padding_ = ::tflite::Padding_SAME;
     return *this;
@@ -221,6 +230,7 @@ class Conv2DTester {
   int32_t dilation_width_ = 1;
   bool fp16_weights_ = false;
   bool sparse_weights_ = false;
+  bool dynamic_range_weights_ = false;
   ::tflite::Padding padding_ = ::tflite::Padding_VALID;
   ::tflite::ActivationFunctionType activation_ =
       ::tflite::ActivationFunctionType_NONE;
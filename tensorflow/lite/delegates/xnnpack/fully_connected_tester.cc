@@ -16,6 +16,7 @@ limitations under the License.
 #include "tensorflow/lite/delegates/xnnpack/fully_connected_tester.h"
 
 #include <array>
+#include <cmath>
 #include <cstdint>
 #include <functional>
 #include <numeric>
@@ -101,9 +102,16 @@ void FullyConnectedTester::Test(TfLiteDelegate* delegate) const {
       delegate_interpreter->outputs()[0]);
 
   for (size_t i = 0; i < ComputeSize(OutputShape()); i++) {
-    ASSERT_NEAR(default_output_data[i], delegate_output_data[i],
-                std::numeric_limits<float>::epsilon() *
-                    std::max(std::abs(default_output_data[i]) * 10.0f, 1.0f));
+    if (DynamicRangeWeights()) {
+      // The default kernel quantizes the inputs, while the delegate computes
+      // in float with the dequantized filter.
+      ASSERT_NEAR(default_output_data[i], delegate_output_data[i],
+                  2.0e-2f * std::max(std::abs(default_output_data[i]), 1.0f));
+    } else {
+      ASSERT_NEAR(default_output_data[i], delegate_output_data[i],
+                  std::numeric_limits<float>::epsilon() *
+                      std::max(std::abs(default_output_data[i]) * 10.0f, 1.0f));
+    }
   }
 }
 
@@ -119,6 +127,8 @@ std::vector<char> FullyConnectedTester::CreateTfLiteModel() const {
   std::vector<flatbuffers::Offset<Operator>> operators;
   std::vector<flatbuffers::Offset<Buffer>> buffers{
       {CreateBuffer(builder, builder.CreateVector({}))}};
+  // The scale of the int8 filter.
+  float filter_scale = 1.0f;
 
   if (FP16Weights()) {
     operator_codes.emplace_back(
@@ -191,14 +201,46 @@ std::vector<char> FullyConnectedTester::CreateTfLiteModel() const {
       }
     }
 
-    buffers.emplace_back(CreateBuffer(
-        builder, builder.CreateVector(
-                     reinterpret_cast<const uint8_t*>(filter_data.data()),
-                     sizeof(float) * filter_data.size())));
+    if (INT8Weights() || DynamicRangeWeights()) {
+      float max_abs_filter = 0.0f;
+      for (float value : filter_data) {
+        max_abs_filter = std::max(max_abs_filter, std::abs(value));
+      }
+      filter_scale = std::max(max_abs_filter, 1.0f) / 127.0f;
+      std::vector<int8_t> quantized_filter_data(filter_data.size());
+      for (size_t i = 0; i < filter_data.size(); i++) {
+        quantized_filter_data[i] =
+            static_cast<int8_t>(std::round(filter_data[i] / filter_scale));
+      }
+      buffers.emplace_back(CreateBuffer(
+          builder,
+          builder.CreateVector(
+              reinterpret_cast<const uint8_t*>(quantized_filter_data.data()),
+              quantized_filter_data.size())));
+    } else {
+      buffers.emplace_back(CreateBuffer(
+          builder, builder.CreateVector(
+                       reinterpret_cast<const uint8_t*>(filter_data.data()),
+                       sizeof(float) * filter_data.size())));
+    }
     buffers.emplace_back(CreateBuffer(
         builder,
         builder.CreateVector(reinterpret_cast<const uint8_t*>(bias_data.data()),
                              sizeof(float) * bias_data.size())));
+
+    if (INT8Weights()) {
+      operator_codes.emplace_back(
+          CreateOperatorCode(builder, BuiltinOperator_DEQUANTIZE));
+
+      const std::array<int32_t, 1> dequantize_filter_inputs{{0}};
+      const std::array<int32_t, 1> dequantize_filter_outputs{{2}};
+      operators.emplace_back(CreateOperator(
+          builder, /*opcode_index=*/1,
+          builder.CreateVector<int32_t>(dequantize_filter_inputs.data(),
+                                        dequantize_filter_inputs.size()),
+          builder.CreateVector<int32_t>(dequantize_filter_outputs.data(),
+                                        dequantize_filter_outputs.size())));
+    }
   }
 
   const std::array<int32_t, 2> filter_shape{
@@ -217,14 +259,32 @@ std::vector<char> FullyConnectedTester::CreateTfLiteModel() const {
         builder.CreateVector<int32_t>(bias_shape.data(), bias_shape.size()),
         TensorType_FLOAT16, /*buffer=*/2));
   }
+  const auto create_int8_filter_tensor = [&]() {
+    return CreateTensor(
+        builder,
+        builder.CreateVector<int32_t>(filter_shape.data(), filter_shape.size()),
+        TensorType_INT8, /*buffer=*/1, /*name=*/0,
+        CreateQuantizationParameters(
+            builder, /*min=*/0, /*max=*/0,
+            builder.CreateVector<float>({filter_scale}),
+            builder.CreateVector<int64_t>({0})));
+  };
+  if (INT8Weights()) {
+    tensors.emplace_back(create_int8_filter_tensor());
+  }
   tensors.emplace_back(CreateTensor(
       builder,
       builder.CreateVector<int32_t>(InputShape().data(), InputShape().size()),
       TensorType_FLOAT32));
-  tensors.emplace_back(CreateTensor(
-      builder,
-      builder.CreateVector<int32_t>(filter_shape.data(), filter_shape.size()),
-      TensorType_FLOAT32, /*buffer=*/FP16Weights() ? 0 : 1));
+  if (DynamicRangeWeights()) {
+    tensors.emplace_back(create_int8_filter_tensor());
+  } else {
+    tensors.emplace_back(CreateTensor(
+        builder,
+        builder.CreateVector<int32_t>(filter_shape.data(), filter_shape.size()),
+        TensorType_FLOAT32,
+        /*buffer=*/FP16Weights() || INT8Weights() ? 0 : 1));
+  }
   tensors.emplace_back(CreateTensor(
       builder,
       builder.CreateVector<int32_t>(bias_shape.data(), bias_shape.size()),
@@ -78,6 +78,23 @@ class FullyConnectedTester {
 
   inline bool FP16Weights() const { return fp16_weights_; }
 
+  // Stores the filter as int8, dequantized by a DEQUANTIZE operator.
+  inline FullyConnectedTester& INT8Weights() {
+    int8_weights_ = true;
+    return *this;
+  }
+
+  inline bool INT8Weights() const { return int8_weights_; }
+
+  // Stores the filter as int8, consumed directly by a dynamic-range (hybrid)
+  // FULLY_CONNECTED operator.
+  inline FullyConnectedTester& DynamicRangeWeights() {
+    dynamic_range_weights_ = true;
+    return *this;
+  }
+
+  inline bool DynamicRangeWeights() const { return dynamic_range_weights_; }
+
   inline FullyConnectedTester& ReluActivation() {
     activation_ = ::tflite::ActivationFunctionType_RELU;
     return *this;
@@ -110,6 +127,8 @@ class FullyConnectedTester {
   int32_t output_channels_ = 1;
   bool keep_dims_ = false;
   bool fp16_weights_ = false;
+  bool int8_weights_ = false;
+  bool dynamic_range_weights_ = false;
   ::tflite::ActivationFunctionType activation_ =
       ::tflite::ActivationFunctionType_NONE;
 };
@@ -19,6 +19,7 @@ limitations under the License.
 #include <array>
 #include <cstdint>
 #include <cstring>
+#include <functional>
 #include <limits>
 #include <memory>
 #include <string>
@@ -32,6 +33,7 @@ limitations under the License.
 #include "tensorflow/lite/builtin_ops.h"
 #include "tensorflow/lite/c/builtin_op_data.h"
 #include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/kernels/weights_cache.h"
 #include "tensorflow/lite/minimal_logging.h"
 #include "tensorflow/lite/tools/optimize/sparsity/format_converter.h"
 
@@ -42,6 +44,66 @@ namespace {
 // Forward declaration.
 TfLiteStatus DelegatePrepare(TfLiteContext* context, TfLiteDelegate* delegate);
 
+// Returns whether the tensor holds static int8 weights with per-tensor or
+// per-channel affine quantization, which the delegate dequantizes to float.
+bool IsDequantizableInt8Tensor(const TfLiteTensor& tensor) {
+  if (tensor.type != kTfLiteInt8 || tensor.allocation_type != kTfLiteMmapRo ||
+      tensor.data.raw_const == nullptr || tensor.sparsity != nullptr ||
+      tensor.quantization.type != kTfLiteAffineQuantization) {
+    return false;
+  }
+  const auto* quantization = static_cast<const TfLiteAffineQuantization*>(
+      tensor.quantization.params);
+  if (quantization == nullptr || quantization->scale == nullptr ||
+      quantization->zero_point == nullptr ||
+      quantization->scale->size != quantization->zero_point->size) {
+    return false;
+  }
+  if (quantization->scale->size == 1) {
+    return true;
+  }
+  return quantization->quantized_dimension >= 0 &&
+         quantization->quantized_dimension < tensor.dims->size &&
+         tensor.dims->data[quantization->quantized_dimension] ==
+             quantization->scale->size;
+}
+
+// Returns a hash of the quantization parameters of a tensor for which
+// IsDequantizableInt8Tensor holds.
+uint64_t QuantizationFingerprint(const TfLiteTensor& tensor) {
+  const auto* quantization = static_cast<const TfLiteAffineQuantization*>(
+      tensor.quantization.params);
+  uint64_t hash = quantization->quantized_dimension;
+  for (int c = 0; c < quantization->scale->size; c++) {
+    uint32_t scale_bits;
+    std::memcpy(&scale_bits, &quantization->scale->data[c], sizeof(uint32_t));
+    hash = hash * 31 + scale_bits;
+    hash = hash * 31 + quantization->zero_point->data[c];
+  }
+  return hash;
+}
+
+// Dequantizes a tensor for which IsDequantizableInt8Tensor holds.
+void DequantizeInt8Tensor(const TfLiteTensor& tensor, float* unpacked_data) {
+  const auto* quantization = static_cast<const TfLiteAffineQuantization*>(
+      tensor.quantization.params);
+  const int8_t* packed_data = static_cast<const int8_t*>(tensor.data.data);
+  const int num_channels = quantization->scale->size;
+  // The number of consecutive elements with the same quantization params.
+  size_t channel_stride = 1;
+  for (int d = quantization->quantized_dimension + 1; d < tensor.dims->size;
+       d++) {
+    channel_stride *= tensor.dims->data[d];
+  }
+  for (size_t i = 0; i < tensor.bytes; i++) {
+    const int c = num_channels == 1 ? 0 : (i / channel_stride) % num_channels;
+    unpacked_data[i] =
+        quantization->scale->data[c] *
+        static_cast<float>(static_cast<int32_t>(packed_data[i]) -
+                           quantization->zero_point->data[c]);
+  }
+}
+
 class Delegate {
   friend class Subgraph;
 
@@ -78,12 +140,11 @@ class Delegate {
       kTfLiteDelegateFlagsNone,       // .flags
   };
 
-  // Unpacked data for quasi-static tensors, i.e. tensors produced by
-  // dequantizing or unpacking static buffers.
-  std::vector<char> static_unpacked_data_;
-  // Mapping from a tensor index for a quasi-static tensor to the offset to
-  // its unpacked data within static_unpacked_data_.
-  std::unordered_map<int, size_t> static_unpacked_data_map_;
+  // Mapping from a tensor index for a quasi-static tensor, i.e. a tensor
+  // produced by dequantizing or unpacking static buffers, to its unpacked
+  // data in the process-wide weights cache.
+  std::unordered_map<int, std::shared_ptr<const WeightsCache::PackedWeights>>
+      static_unpacked_data_map_;
   // Set of indices of nodes which unpack static data, e.g. Dequantize
   // operators which convert FP16 static weights to FP32. These nodes are simply
   // ignored in the delegate implementation, because their outputs are
@@ -187,7 +248,10 @@ class Subgraph {
     // XNNPACK Value IDs for TFLite tensors
     std::vector<uint32_t> xnnpack_tensors(tensors.back() + 1);
     for (int t : tensors) {
-      if (context->tensors[t].type != kTfLiteFloat32) {
+      // Quasi-static tensors are unpacked to float.
+      const auto unpacked_it = delegate->static_unpacked_data_map_.find(t);
+      if (context->tensors[t].type != kTfLiteFloat32 &&
+          unpacked_it == delegate->static_unpacked_data_map_.end()) {
         TF_LITE_KERNEL_LOG(
             context,
             "unsupported datatype (%s) of tensor %d in XNNPACK delegate",
@@ -197,14 +261,10 @@ class Subgraph {
 
       uint32_t flags = 0;
       const void* data = nullptr;
-      if (context->tensors[t].allocation_type == kTfLiteMmapRo) {
+      if (unpacked_it != delegate->static_unpacked_data_map_.end()) {
+        data = unpacked_it->second->data();
+      } else if (context->tensors[t].allocation_type == kTfLiteMmapRo) {
         data = context->tensors[t].data.raw_const;
-      } else {
-        // Check for quasi-static data.
-        const auto it = delegate->static_unpacked_data_map_.find(t);
-        if (it != delegate->static_unpacked_data_map_.end()) {
-          data = delegate->static_unpacked_data_.data() + it->second;
-        }
       }
       if (inputs.count(t) != 0) {
         flags |= XNN_VALUE_FLAG_EXTERNAL_INPUT;
@@ -232,8 +292,7 @@ class Subgraph {
 
     // Create a set of quasi-static tensors for VisitNode function
     std::unordered_set<int> quasi_static_tensors;
-    for (const std::pair<const int, size_t>& entry :
-         delegate->static_unpacked_data_map_) {
+    for (const auto& entry : delegate->static_unpacked_data_map_) {
       quasi_static_tensors.insert(entry.first);
     }
 
@@ -1205,11 +1264,13 @@ class Subgraph {
         logging_context, input_tensor, node->inputs->data[0], node_index));
 
     const TfLiteTensor& filter_tensor = tensors[node->inputs->data[1]];
-    TF_LITE_ENSURE_STATUS(CheckTensorFloatType(
-        logging_context, filter_tensor, node->inputs->data[1], node_index));
     TF_LITE_ENSURE_STATUS(CheckTensorShape(logging_context, filter_tensor, 4,
                                            node->inputs->data[1]));
+    // Quasi-static filters, e.g. the int8 filters of dynamic-range operators,
+    // are unpacked to float by the delegate.
     if (quasi_static_tensors.count(node->inputs->data[1]) == 0) {
+      TF_LITE_ENSURE_STATUS(CheckTensorFloatType(
+          logging_context, filter_tensor, node->inputs->data[1], node_index));
       TF_LITE_ENSURE_STATUS(CheckTensorStaticAllocation(
           logging_context, filter_tensor, node->inputs->data[1], node_index));
     }
@@ -1293,11 +1354,13 @@ class Subgraph {
         logging_context, input_tensor, node->inputs->data[0], node_index));
 
     const TfLiteTensor& filter_tensor = tensors[node->inputs->data[1]];
-    TF_LITE_ENSURE_STATUS(CheckTensorFloatType(
-        logging_context, filter_tensor, node->inputs->data[1], node_index));
     TF_LITE_ENSURE_STATUS(CheckTensorShape(logging_context, filter_tensor, 4,
                                            node->inputs->data[1]));
+    // Quasi-static filters, e.g. the int8 filters of dynamic-range operators,
+    // are unpacked to float by the delegate.
     if (quasi_static_tensors.count(node->inputs->data[1]) == 0) {
+      TF_LITE_ENSURE_STATUS(CheckTensorFloatType(
+          logging_context, filter_tensor, node->inputs->data[1], node_index));
       TF_LITE_ENSURE_STATUS(CheckTensorStaticAllocation(
           logging_context, filter_tensor, node->inputs->data[1], node_index));
     }
@@ -1438,11 +1501,13 @@ class Subgraph {
         logging_context, input_tensor, node->inputs->data[0], node_index));
 
     const TfLiteTensor& filter_tensor = tensors[node->inputs->data[1]];
-    TF_LITE_ENSURE_STATUS(CheckTensorFloatType(
-        logging_context, filter_tensor, node->inputs->data[1], node_index));
     TF_LITE_ENSURE_STATUS(CheckTensorShape(logging_context, filter_tensor, 2,
                                            node->inputs->data[1]));
+    // Quasi-static filters, e.g. the int8 filters of dynamic-range operators,
+    // are unpacked to float by the delegate.
     if (quasi_static_tensors.count(node->inputs->data[1]) == 0) {
+      TF_LITE_ENSURE_STATUS(CheckTensorFloatType(
+          logging_context, filter_tensor, node->inputs->data[1], node_index));
       TF_LITE_ENSURE_STATUS(CheckTensorStaticAllocation(
           logging_context, filter_tensor, node->inputs->data[1], node_index));
     }
@@ -1901,11 +1966,13 @@ class Subgraph {
         logging_context, input_tensor, node->inputs->data[0], node_index));
 
     const TfLiteTensor& filter_tensor = tensors[node->inputs->data[1]];
-    TF_LITE_ENSURE_STATUS(CheckTensorFloatType(
-        logging_context, filter_tensor, node->inputs->data[1], node_index));
     TF_LITE_ENSURE_STATUS(CheckTensorShape(logging_context, filter_tensor, 4,
                                            node->inputs->data[1]));
+    // Quasi-static filters, e.g. the int8 filters of dynamic-range operators,
+    // are unpacked to float by the delegate.
     if (quasi_static_tensors.count(node->inputs->data[1]) == 0) {
+      TF_LITE_ENSURE_STATUS(CheckTensorFloatType(
+          logging_context, filter_tensor, node->inputs->data[1], node_index));
       TF_LITE_ENSURE_STATUS(CheckTensorStaticAllocation(
           logging_context, filter_tensor, node->inputs->data[1], node_index));
     }
@@ -2793,7 +2860,6 @@ class Subgraph {
 TfLiteIntArray* Delegate::PrepareOpsToDelegate(TfLiteContext* context) {
   // Clear previous data, in case the delegate is reused without re-creation.
   static_unpacked_data_map_.clear();
-  static_unpacked_data_.clear();
   static_unpack_nodes_.clear();
 
   TfLiteIntArray* execution_plan = nullptr;
@@ -2827,15 +2893,16 @@ TfLiteIntArray* Delegate::PrepareOpsToDelegate(TfLiteContext* context) {
       continue;  // Soft error (skip this node).
     }
 
-    // Prepare to unpack FP16 tensors.
+    // Prepare to unpack FP16 and INT8 tensors.
     if (registration->builtin_code == kTfLiteBuiltinDequantize &&
         node->inputs->size == 1 && node->outputs->size == 1) {
       const TfLiteTensor& input_tensor =
           context->tensors[node->inputs->data[0]];
       const TfLiteTensor& output_tensor =
           context->tensors[node->outputs->data[0]];
-      if (input_tensor.allocation_type == kTfLiteMmapRo &&
-          input_tensor.type == kTfLiteFloat16 &&
+      if (((input_tensor.allocation_type == kTfLiteMmapRo &&
+            input_tensor.type == kTfLiteFloat16) ||
+           IsDequantizableInt8Tensor(input_tensor)) &&
           output_tensor.type == kTfLiteFloat32) {
         static_unpack_nodes_.insert(i);
         quasi_static_tensors_producers[node->outputs->data[0]] = i;
@@ -2872,6 +2939,18 @@ TfLiteIntArray* Delegate::PrepareOpsToDelegate(TfLiteContext* context) {
       }
     }
 
+    // Prepare to dequantize the int8 filters of dynamic-range operators, i.e.
+    // operators with float inputs and int8 weights, which are computed in
+    // float by the delegate.
+    if ((registration->builtin_code == kTfLiteBuiltinConv2d ||
+         registration->builtin_code == kTfLiteBuiltinDepthwiseConv2d ||
+         registration->builtin_code == kTfLiteBuiltinFullyConnected) &&
+        node->inputs->size >= 2 &&
+        context->tensors[node->inputs->data[0]].type == kTfLiteFloat32 &&
+        IsDequantizableInt8Tensor(context->tensors[node->inputs->data[1]])) {
+      quasi_static_tensors.insert(node->inputs->data[1]);
+    }
+
     if (Subgraph::VisitNode(/*subgraph=*/nullptr, context, registration, node,
                             node_index, quasi_static_tensors,
                             std::vector<uint32_t>()) != kTfLiteOk) {
@@ -2900,7 +2979,21 @@ TfLiteIntArray* Delegate::PrepareOpsToDelegate(TfLiteContext* context) {
 
   // Unpack static data of all tensors
   for (int t : quasi_static_tensors_to_unpack) {
-    const int producer_index = quasi_static_tensors_producers[t];
+    const auto producer_it = quasi_static_tensors_producers.find(t);
+    if (producer_it == quasi_static_tensors_producers.end()) {
+      // The int8 filter of a dynamic-range operator.
+      const TfLiteTensor& tensor = context->tensors[t];
+      static_unpacked_data_map_[t] = WeightsCache::Global().GetOrPack(
+          {tensor.data.raw_const, tensor.bytes,
+           WeightsCache::Packing::kXNNPackDequantizeInt8,
+           QuantizationFingerprint(tensor)},
+          tensor.bytes * sizeof(float) + XNN_EXTRA_BYTES,
+          [&tensor](char* unpacked) {
+            DequantizeInt8Tensor(tensor, reinterpret_cast<float*>(unpacked));
+          });
+      continue;
+    }
+    const int producer_index = producer_it->second;
     // Check if TFLite nodes can be delegated to XNNPACK
     TfLiteNode* node = nullptr;
     TfLiteRegistration* registration = nullptr;
@@ -2948,17 +3041,22 @@ TfLiteIntArray* Delegate::PrepareOpsToDelegate(TfLiteContext* context) {
     }
     const size_t tensor_elements = output_tensor.bytes / sizeof(float);
 
-    // Align to XNN_EXTRA_BYTES bytes
-    while (static_unpacked_data_.size() % XNN_EXTRA_BYTES != 0) {
-      static_unpacked_data_.push_back(0);
-    }
-    const size_t tensor_offset = static_unpacked_data_.size();
-    static_unpacked_data_.resize(tensor_offset + context->tensors[t].bytes);
-
-    float* unpacked_data =
-        reinterpret_cast<float*>(static_unpacked_data_.data() + tensor_offset);
+    WeightsCache::Packing packing;
+    // The unpacked shape is implied by the weights unless they are sparse.
+    uint64_t packing_params = 0;
+    std::function<void(char*)> unpack;
     switch (registration->builtin_code) {
       case kTfLiteBuiltinDequantize: {
+        if (IsDequantizableInt8Tensor(input_tensor)) {
+          packing = WeightsCache::Packing::kXNNPackDequantizeInt8;
+          packing_params = QuantizationFingerprint(input_tensor);
+          unpack = [&input_tensor](char* unpacked) {
+            DequantizeInt8Tensor(input_tensor,
+                                 reinterpret_cast<float*>(unpacked));
+          };
+          break;
+        }
+
         if (input_tensor.type != kTfLiteFloat16) {
           TF_LITE_KERNEL_LOG(
               context, "unexpected tensor %d data type (%s) in node %d",
@@ -2976,11 +3074,15 @@ TfLiteIntArray* Delegate::PrepareOpsToDelegate(TfLiteContext* context) {
           return nullptr;  // Hard error.
         }
 
-        const uint16_t* packed_data =
-            static_cast<const uint16_t*>(input_tensor.data.data);
-        for (size_t i = 0; i < tensor_elements; i++) {
-          unpacked_data[i] = fp16_ieee_to_fp32_value(packed_data[i]);
-        }
+        packing = WeightsCache::Packing::kXNNPackDequantizeFloat16;
+        unpack = [&input_tensor, tensor_elements](char* unpacked) {
+          const uint16_t* packed_data =
+              static_cast<const uint16_t*>(input_tensor.data.data);
+          float* unpacked_data = reinterpret_cast<float*>(unpacked);
+          for (size_t i = 0; i < tensor_elements; i++) {
+            unpacked_data[i] = fp16_ieee_to_fp32_value(packed_data[i]);
+          }
+        };
         break;
       }
       case kTfLiteBuiltinDensify: {
@@ -3004,16 +3106,20 @@ TfLiteIntArray* Delegate::PrepareOpsToDelegate(TfLiteContext* context) {
         std::vector<int> vector_shape(dims_count);
         for (int i = 0; i < dims_count; i++) {
           vector_shape[i] = output_tensor.dims->data[i];
+          packing_params = packing_params * 31 + vector_shape[i];
         }
 
-        tflite::optimize::sparsity::FormatConverter<float> converter(
-            vector_shape, *input_tensor.sparsity);
-        converter.SparseToDense(input_tensor.data.f);
-        const std::vector<float> out = converter.GetData();
-        for (int i = 0; i < out.size(); i++) {
-          unpacked_data[i] = out[i];
-        }
-
+        packing = WeightsCache::Packing::kXNNPackDensifyFloat;
+        unpack = [&input_tensor, vector_shape](char* unpacked) {
+          tflite::optimize::sparsity::FormatConverter<float> converter(
+              vector_shape, *input_tensor.sparsity);
+          converter.SparseToDense(input_tensor.data.f);
+          const std::vector<float> out = converter.GetData();
+          float* unpacked_data = reinterpret_cast<float*>(unpacked);
+          for (int i = 0; i < out.size(); i++) {
+            unpacked_data[i] = out[i];
+          }
+        };
         break;
       }
       default:
@@ -3023,7 +3129,13 @@ TfLiteIntArray* Delegate::PrepareOpsToDelegate(TfLiteContext* context) {
         return nullptr;  // Hard error.
     }
 
-    static_unpacked_data_map_[t] = tensor_offset;
+    // The unpacked weights are shared with the delegates of the other
+    // interpreters of the model. XNNPACK may read up to XNN_EXTRA_BYTES past
+    // their end.
+    static_unpacked_data_map_[t] = WeightsCache::Global().GetOrPack(
+        {input_tensor.data.raw_const, input_tensor.bytes, packing,
+         packing_params},
+        output_tensor.bytes + XNN_EXTRA_BYTES, unpack);
   }
 
   // Add nodes that unpack static data consumed by delegated nodes.
@@ -15,6 +15,7 @@ limitations under the License.
 #ifndef TENSORFLOW_LITE_EXTERNAL_CPU_BACKEND_CONTEXT_H_
 #define TENSORFLOW_LITE_EXTERNAL_CPU_BACKEND_CONTEXT_H_
 
+#include <functional>
 #include <memory>
 #include <utility>
 
@@ -38,6 +39,17 @@ class TfLiteInternalBackendContext {
   // A context may internally cache prepacked versions of constant tensors for
   // faster computation. This function will clear any caches on the context.
   virtual void ClearCaches() = 0;
+
+  // Calls `worker(i)` for each i in [0, workers_count), possibly concurrently
+  // on the threads of the context's thread pool, and returns once all of them
+  // have returned. The default implementation calls them in sequence.
+  // WARNING: This is an experimental API and subject to change.
+  virtual void RunWorkers(int workers_count,
+                          const std::function<void(int)>& worker) {
+    for (int i = 0; i < workers_count; ++i) {
+      worker(i);
+    }
+  }
 };
 
 // This TfLiteExternalContext-derived class is the default
@@ -53,6 +53,12 @@ class GraphInfo {
 
   // Returns the indices of the variable tensors.
   virtual const std::vector<int>& variables() const = 0;
+
+  // Returns the first and last node of the stage of the node at `index`. The
+  // nodes of a stage may run concurrently, so the tensors they use must be
+  // allocated for the whole stage. By default each node is its own stage.
+  virtual size_t first_node_of_stage(size_t index) const { return index; }
+  virtual size_t last_node_of_stage(size_t index) const { return index; }
 };
 
 // Represents a subset of nodes in a TensorFlow Lite graph.
@@ -273,6 +273,13 @@ TfLiteStatus Interpreter::ResetVariableTensors() {
   return primary_subgraph().ResetVariableTensors();
 }
 
+TfLiteStatus Interpreter::PageInConstantTensors() {
+  for (auto& subgraph : subgraphs_) {
+    TF_LITE_ENSURE_STATUS(subgraph->PageInConstantTensors());
+  }
+  return kTfLiteOk;
+}
+
 TfLiteStatus Interpreter::SetTensorParametersReadOnly(
     int tensor_index, TfLiteType type, const char* name,
     const std::vector<int>& dims, TfLiteQuantization quantization,
@@ -360,6 +367,12 @@ void Interpreter::SetCancellationFunction(void* data,
 
 bool Interpreter::IsCancelled() { return primary_subgraph().IsCancelled(); }
 
+void Interpreter::SetParallelNodeExecution(bool enable) {
+  for (auto& subgraph : subgraphs_) {
+    subgraph->SetParallelNodeExecution(enable);
+  }
+}
+
 TfLiteStatus Interpreter::ModifyGraphWithDelegate(TfLiteDelegate* delegate) {
   TfLiteStatus status = kTfLiteOk;
   for (auto& subgraph : subgraphs_) {
@@ -405,6 +405,15 @@ class Interpreter {
   /// WARNING: This is an experimental API and subject to change.
   void SetCancellationFunction(void* data, bool (*check_cancelled_func)(void*));
 
+  /// Enables or disables running the nodes of the execution plan which don't
+  /// depend on each other concurrently, with up to the number of threads set
+  /// by `SetNumThreads`. Each of these nodes then runs single-threaded, which
+  /// helps models made of many small independent branches. Takes effect at
+  /// the next call to `AllocateTensors`. Graphs with dynamic tensors, and
+  /// invocations with a profiler, still run one node at a time.
+  /// WARNING: This is an experimental API and subject to change.
+  void SetParallelNodeExecution(bool enable);
+
   /// Allow a delegate to look at the graph and modify the graph to handle
   /// parts of the graph themselves. After this is called, the graph may
   /// contain new nodes that replace 1 more nodes.
@@ -515,6 +524,14 @@ class Interpreter {
   /// WARNING: This is an experimental API and subject to change.
   TfLiteStatus ResetVariableTensors();
 
+  /// Reads the pages of the constant tensors mapped from the model file ahead
+  /// of the first invocation, in the order the execution plan reads them, and
+  /// frees the pages of those the kernels only read in prepare, e.g. weights
+  /// they repacked. Call it after AllocateTensors(), it has no effect unless
+  /// the model is memory-mapped.
+  /// WARNING: This is an experimental API and subject to change.
+  TfLiteStatus PageInConstantTensors();
+
   /// Retrieve an operator's description of its work, for profiling purposes.
   const char* OpProfilingString(const TfLiteRegistration& op_reg,
                                 const TfLiteNode* node) const {
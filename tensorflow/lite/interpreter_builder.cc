@@ -21,6 +21,9 @@ limitations under the License.
 #include <sys/stat.h>
 #include <sys/types.h>
 
+#include <cstring>
+#include <vector>
+
 #include "tensorflow/lite/allocation.h"
 #include "tensorflow/lite/c/builtin_op_data.h"
 #include "tensorflow/lite/c/common.h"
@@ -562,6 +565,55 @@ TfLiteStatus InterpreterBuilder::ApplyDelegates(Interpreter* interpreter,
   return kTfLiteOk;
 }
 
+TfLiteStatus InterpreterBuilder::ParseOfflinePlannedTensorOffsets(
+    const flatbuffers::Vector<flatbuffers::Offset<Buffer>>* buffers,
+    Interpreter* interpreter) {
+  // The offsets of the tensors of a subgraph in its arena, as planned by the
+  // converter, are stored in a metadata buffer of int32 values:
+  // [version (1), subgraph index, number of offsets N, offset 0, ..., N - 1],
+  // where an offset of -1 leaves the tensor to be planned at runtime.
+  constexpr char kOfflineMemoryAllocationMetadata[] = "OfflineMemoryAllocation";
+  constexpr int32_t kOfflineMemoryAllocationVersion = 1;
+  if (!model_->metadata()) {
+    return kTfLiteOk;
+  }
+  for (const auto* metadata : *model_->metadata()) {
+    if (!metadata->name() ||
+        metadata->name()->str() != kOfflineMemoryAllocationMetadata) {
+      continue;
+    }
+    const flatbuffers::Vector<uint8_t>* data =
+        metadata->buffer() < buffers->size()
+            ? (*buffers)[metadata->buffer()]->data()
+            : nullptr;
+    if (!data || data->size() % sizeof(int32_t) != 0 ||
+        data->size() < 3 * sizeof(int32_t)) {
+      TF_LITE_REPORT_ERROR(error_reporter_,
+                           "Malformed %s metadata in the model.",
+                           kOfflineMemoryAllocationMetadata);
+      return kTfLiteError;
+    }
+    std::vector<int32_t> values(data->size() / sizeof(int32_t));
+    memcpy(values.data(), data->data(), data->size());
+    const int32_t subgraph_index = values[1];
+    if (values[0] != kOfflineMemoryAllocationVersion || subgraph_index < 0 ||
+        subgraph_index >= static_cast<int32_t>(interpreter->subgraphs_size()) ||
+        values[2] != static_cast<int32_t>(values.size() - 3)) {
+      TF_LITE_REPORT_ERROR(error_reporter_,
+                           "Unsupported %s metadata in the model.",
+                           kOfflineMemoryAllocationMetadata);
+      return kTfLiteError;
+    }
+    std::vector<int32_t> offsets(values.begin() + 3, values.end());
+    if (interpreter->subgraph(subgraph_index)
+            ->SetOfflinePlannedTensorOffsets(std::move(offsets)) !=
+        kTfLiteOk) {
+      return kTfLiteError;
+    }
+  }
+  return kTfLiteOk;
+}
+
 TfLiteStatus InterpreterBuilder::operator()(
     std::unique_ptr<Interpreter>* interpreter) {
   return operator()(interpreter, /*num_threads=*/-1);
@@ -674,6 +726,11 @@ TfLiteStatus InterpreterBuilder::operator()(
     modified_subgraph->SetVariables(std::move(variables));
   }
 
+  if (ParseOfflinePlannedTensorOffsets(buffers, interpreter->get()) !=
+      kTfLiteOk) {
+    return cleanup_and_error();
+  }
+
   if (num_fp32_tensors_ > 0) {
     (*interpreter)->lazy_delegate_provider_ =
         MaybeCreateXNNPACKDelegate(num_threads);
@@ -78,6 +78,9 @@ class InterpreterBuilder {
       const flatbuffers::Vector<flatbuffers::Offset<Tensor>>* tensors,
       Subgraph* subgraph);
   TfLiteStatus ApplyDelegates(Interpreter* interpreter, int num_threads);
+  TfLiteStatus ParseOfflinePlannedTensorOffsets(
+      const flatbuffers::Vector<flatbuffers::Offset<Buffer>>* buffers,
+      Interpreter* interpreter);
   TfLiteStatus ParseQuantization(const QuantizationParameters* src_quantization,
                                  TfLiteQuantization* quantization,
                                  const std::vector<int>& dims);
@@ -693,6 +693,58 @@ TEST(BasicInterpreter, OneOpInterpreter) {
   ASSERT_EQ(interpreter.Invoke(), kTfLiteOk);
 }
 
+TEST(BasicInterpreter, ParallelNodeExecution) {
+  Interpreter interpreter;
+  ASSERT_EQ(interpreter.AddTensors(4), kTfLiteOk);
+  ASSERT_EQ(interpreter.SetInputs({0}), kTfLiteOk);
+  ASSERT_EQ(interpreter.SetOutputs({2, 3}), kTfLiteOk);
+  TfLiteQuantizationParams quantized;
+  for (int i = 0; i < 4; ++i) {
+    ASSERT_EQ(interpreter.SetTensorParametersReadWrite(i, kTfLiteFloat32, "",
+                                                       {3}, quantized),
+              kTfLiteOk);
+  }
+
+  // Node 2 only depends on the input, so it can run along with node 0.
+  TfLiteRegistration reg = GetPassthroughOpRegistration();
+  ASSERT_EQ(
+      interpreter.AddNodeWithParameters({0}, {1}, nullptr, 0, nullptr, &reg),
+      kTfLiteOk);
+  ASSERT_EQ(
+      interpreter.AddNodeWithParameters({1}, {2}, nullptr, 0, nullptr, &reg),
+      kTfLiteOk);
+  ASSERT_EQ(
+      interpreter.AddNodeWithParameters({0}, {3}, nullptr, 0, nullptr, &reg),
+      kTfLiteOk);
+  ASSERT_EQ(interpreter.SetNumThreads(2), kTfLiteOk);
+  interpreter.SetParallelNodeExecution(true);
+  ASSERT_EQ(interpreter.AllocateTensors(), kTfLiteOk);
+
+  ASSERT_EQ(interpreter.execution_plan(), std::vector<int>({0, 2, 1}));
+  const std::vector<std::pair<int, int>> expected_stages = {
+      {0, 1}, {0, 1}, {2, 2}};
+  ASSERT_EQ(interpreter.primary_subgraph().execution_stages(),
+            expected_stages);
+  // The outputs of the nodes of a stage must not share memory with each
+  // other's inputs.
+  EXPECT_NE(interpreter.tensor(1)->data.raw, interpreter.tensor(3)->data.raw);
+
+  float* input = interpreter.typed_input_tensor<float>(0);
+  for (int i = 0; i < 3; ++i) {
+    input[i] = i + 1;
+  }
+  ASSERT_EQ(interpreter.Invoke(), kTfLiteOk);
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(interpreter.typed_tensor<float>(2)[i], i + 1);
+    EXPECT_EQ(interpreter.typed_tensor<float>(3)[i], i + 1);
+  }
+
+  interpreter.SetParallelNodeExecution(false);
+  ASSERT_EQ(interpreter.AllocateTensors(), kTfLiteOk);
+  EXPECT_TRUE(interpreter.primary_subgraph().execution_stages().empty());
+  ASSERT_EQ(interpreter.Invoke(), kTfLiteOk);
+}
+
 TEST(BasicInterpreter, ReleaseNonPersistentMemory) {
   Interpreter interpreter;
   ASSERT_EQ(interpreter.AddTensors(2), kTfLiteOk);
@@ -1058,6 +1110,154 @@ TEST(BasicInterpreter, DynamicTensorsResizeDescendants) {
   ASSERT_EQ(interpreter.tensor(3)->bytes, sizeof(float) * 10 * 14);
 }
 
+TEST(BasicInterpreter, ResizeInputsOnlyPreparesResizedNodes) {
+  // An op copying the shape of its input to its output, which counts the
+  // calls to its Prepare in its builtin data.
+  TfLiteRegistration reg = {nullptr, nullptr, nullptr, nullptr};
+  reg.prepare = [](TfLiteContext* context, TfLiteNode* node) {
+    ++*static_cast<int*>(node->builtin_data);
+    const TfLiteTensor* input = &context->tensors[node->inputs->data[0]];
+    TfLiteTensor* output = &context->tensors[node->outputs->data[0]];
+    return context->ResizeTensor(context, output,
+                                 TfLiteIntArrayCopy(input->dims));
+  };
+  reg.invoke = [](TfLiteContext* context, TfLiteNode* node) {
+    return kTfLiteOk;
+  };
+
+  Interpreter interpreter;
+  ASSERT_EQ(interpreter.AddTensors(5), kTfLiteOk);
+  ASSERT_EQ(interpreter.SetInputs({0, 1}), kTfLiteOk);
+  ASSERT_EQ(interpreter.SetOutputs({3, 4}), kTfLiteOk);
+  TfLiteQuantizationParams quant;
+  for (int i = 0; i < 5; ++i) {
+    ASSERT_EQ(interpreter.SetTensorParametersReadWrite(i, kTfLiteFloat32, "",
+                                                       {2}, quant),
+              kTfLiteOk);
+  }
+  // Tensor 0 goes through two nodes, and tensor 1 through one.
+  int* prepare_counts[3];
+  const std::vector<std::pair<int, int>> nodes = {{0, 2}, {2, 3}, {1, 4}};
+  for (int i = 0; i < 3; ++i) {
+    // Freed by the interpreter.
+    prepare_counts[i] = static_cast<int*>(malloc(sizeof(int)));
+    *prepare_counts[i] = 0;
+    ASSERT_EQ(interpreter.AddNodeWithParameters({nodes[i].first},
+                                                {nodes[i].second}, nullptr, 0,
+                                                prepare_counts[i], &reg),
+              kTfLiteOk);
+  }
+  ASSERT_EQ(interpreter.AllocateTensors(), kTfLiteOk);
+  EXPECT_EQ(*prepare_counts[0], 1);
+  EXPECT_EQ(*prepare_counts[1], 1);
+  EXPECT_EQ(*prepare_counts[2], 1);
+
+  // Only the nodes the new shape of tensor 0 propagates to are prepared.
+  ASSERT_EQ(interpreter.ResizeInputTensor(0, {8}), kTfLiteOk);
+  ASSERT_EQ(interpreter.AllocateTensors(), kTfLiteOk);
+  EXPECT_EQ(*prepare_counts[0], 2);
+  EXPECT_EQ(*prepare_counts[1], 2);
+  EXPECT_EQ(*prepare_counts[2], 1);
+  EXPECT_EQ(interpreter.tensor(3)->bytes, 8 * sizeof(float));
+  ASSERT_EQ(interpreter.Invoke(), kTfLiteOk);
+
+  // Tensors shrunk to sizes which fit keep their allocations.
+  const char* output = interpreter.tensor(3)->data.raw;
+  ASSERT_EQ(interpreter.ResizeInputTensor(0, {4}), kTfLiteOk);
+  ASSERT_EQ(interpreter.AllocateTensors(), kTfLiteOk);
+  EXPECT_EQ(interpreter.tensor(3)->bytes, 4 * sizeof(float));
+  EXPECT_EQ(interpreter.tensor(3)->data.raw, output);
+
+  // Other changes to the graph prepare it all again.
+  ASSERT_EQ(interpreter.ResizeInputTensor(1, {4}), kTfLiteOk);
+  ASSERT_EQ(interpreter.AddTensors(1), kTfLiteOk);
+  ASSERT_EQ(interpreter.SetTensorParametersReadWrite(5, kTfLiteFloat32, "",
+                                                     {2}, quant),
+            kTfLiteOk);
+  int* last_prepare_count = static_cast<int*>(malloc(sizeof(int)));
+  *last_prepare_count = 0;
+  ASSERT_EQ(interpreter.AddNodeWithParameters({4}, {5}, nullptr, 0,
+                                              last_prepare_count, &reg),
+            kTfLiteOk);
+  ASSERT_EQ(interpreter.AllocateTensors(), kTfLiteOk);
+  EXPECT_EQ(*prepare_counts[0], 4);
+  EXPECT_EQ(*prepare_counts[1], 4);
+  EXPECT_EQ(*prepare_counts[2], 2);
+  EXPECT_EQ(*last_prepare_count, 1);
+}
+
+// Records the ranges of the allocation paged in and evicted.
+class RecordingAllocation : public MemoryAllocation {
+ public:
+  RecordingAllocation(const void* ptr, size_t num_bytes)
+      : MemoryAllocation(ptr, num_bytes, DefaultErrorReporter()) {}
+
+  void PageIn(const void* data, size_t size) const override {
+    paged_in.emplace_back(data, size);
+  }
+  void Evict(const void* data, size_t size) const override {
+    evicted.emplace_back(data, size);
+  }
+
+  mutable std::vector<std::pair<const void*, size_t>> paged_in;
+  mutable std::vector<std::pair<const void*, size_t>> evicted;
+};
+
+TEST(BasicInterpreter, PageInConstantTensors) {
+  // An op which copies its second input in prepare when its builtin data is
+  // set.
+  TfLiteRegistration reg = {nullptr, nullptr, nullptr, nullptr};
+  reg.prepare = [](TfLiteContext* context, TfLiteNode* node) {
+    node->copied_inputs_mask = node->builtin_data != nullptr ? 1 << 1 : 0;
+    return kTfLiteOk;
+  };
+  reg.invoke = [](TfLiteContext* context, TfLiteNode* node) {
+    return kTfLiteOk;
+  };
+
+  const float weights[4] = {1, 2, 3, 4};
+  RecordingAllocation allocation(weights, sizeof(weights));
+  Interpreter interpreter;
+  ASSERT_EQ(interpreter.AddTensors(7), kTfLiteOk);
+  ASSERT_EQ(interpreter.SetInputs({0}), kTfLiteOk);
+  ASSERT_EQ(interpreter.SetOutputs({3}), kTfLiteOk);
+  TfLiteQuantizationParams quant;
+  for (int i : {0, 1, 2, 3}) {
+    ASSERT_EQ(interpreter.SetTensorParametersReadWrite(i, kTfLiteFloat32, "",
+                                                       {1}, quant),
+              kTfLiteOk);
+  }
+  // Tensors 4, 5 and 6 are constants of the allocation.
+  for (int i : {4, 5, 6}) {
+    ASSERT_EQ(interpreter.SetTensorParametersReadOnly(
+                  i, kTfLiteFloat32, "", {1}, quant,
+                  reinterpret_cast<const char*>(&weights[i - 4]),
+                  sizeof(float), &allocation),
+              kTfLiteOk);
+  }
+  // Node 2 only reads tensor 6 in prepare.
+  void* copy_weights = malloc(1);  // Freed by the interpreter.
+  ASSERT_EQ(interpreter.AddNodeWithParameters({0, 5}, {1}, nullptr, 0,
+                                              nullptr, &reg),
+            kTfLiteOk);
+  ASSERT_EQ(interpreter.AddNodeWithParameters({1, 4}, {2}, nullptr, 0,
+                                              nullptr, &reg),
+            kTfLiteOk);
+  ASSERT_EQ(interpreter.AddNodeWithParameters({2, 6}, {3}, nullptr, 0,
+                                              copy_weights, &reg),
+            kTfLiteOk);
+  ASSERT_EQ(interpreter.AllocateTensors(), kTfLiteOk);
+  ASSERT_EQ(interpreter.PageInConstantTensors(), kTfLiteOk);
+
+  using Range = std::pair<const void*, size_t>;
+  EXPECT_EQ(allocation.paged_in,
+            std::vector<Range>({{&weights[1], sizeof(float)},
+                                {&weights[0], sizeof(float)}}));
+  EXPECT_EQ(allocation.evicted,
+            std::vector<Range>({{&weights[2], sizeof(float)}}));
+  EXPECT_EQ(interpreter.Invoke(), kTfLiteOk);
+}
+
 TEST(InterpreterTensorsCapacityTest, TestWithinHeadroom) {
   Interpreter interpreter;
   ASSERT_EQ(interpreter.AddTensors(Interpreter::kTensorsReservedCapacity),
@@ -17,6 +17,7 @@ limitations under the License.
 #include <stddef.h>
 
 #include <cstdint>
+#include <memory>
 #include <vector>
 
 #include "tensorflow/lite/c/builtin_op_data.h"
@@ -30,14 +31,17 @@ limitations under the License.
 #include "tensorflow/lite/kernels/internal/optimized/multithreaded_conv.h"
 #endif
 #include "tensorflow/lite/kernels/internal/optimized/optimized_ops.h"
+#include "tensorflow/lite/kernels/internal/optimized/sparse_ops/fully_connected.h"
 #include "tensorflow/lite/kernels/internal/quantization_util.h"
 #include "tensorflow/lite/kernels/internal/reference/conv.h"
 #include "tensorflow/lite/kernels/internal/reference/integer_ops/conv.h"
+#include "tensorflow/lite/kernels/internal/reference/sparse_ops/fully_connected.h"
 #include "tensorflow/lite/kernels/internal/tensor.h"
 #include "tensorflow/lite/kernels/internal/tensor_ctypes.h"
 #include "tensorflow/lite/kernels/internal/tensor_utils.h"
 #include "tensorflow/lite/kernels/kernel_util.h"
 #include "tensorflow/lite/kernels/padding.h"
+#include "tensorflow/lite/kernels/weights_cache.h"
 
 namespace tflite {
 namespace ops {
@@ -60,6 +64,12 @@ enum KernelType {
 
 const int kTensorNotAllocated = -1;
 
+// The sizes of the dimension metadata of the sparse filters, once viewed as the
+// weights of a fully connected op.
+const int kDimMetadataSizeRandomSparse = 2;
+const int kDimMetadataSizeBlockSparse = 3;
+const int kDimMetadataSizeBlockSparse2D = 4;
+
 struct OpData {
   // IDs are the arbitrary identifiers used by TF Lite to identify and access
   // memory buffers.
@@ -98,11 +108,23 @@ struct OpData {
 
   bool need_hwcn_weights = false;
   bool have_weights_been_transposed = false;
+  // The transposed weights of a constant filter, shared with the other
+  // interpreters of the model instead of held in the `hwcn_weights` tensor.
+  std::shared_ptr<const WeightsCache::PackedWeights> shared_hwcn_weights;
   bool need_im2col = false;
 
   bool supports_multithreaded_kernel = false;
   bool is_hybrid_per_channel = false;
   bool compute_hybrid_row_sums = true;
+
+  // A sparse 1x1 filter is run as the sparse [filter_count, input_depth]
+  // weights of a fully connected op over the input pixels, without being
+  // densified. `sparse_filter` views the sparsity of the filter with its
+  // height and width dimensions dropped, and points to the indices of the
+  // filter.
+  bool has_sparse_filter = false;
+  TfLiteSparsity sparse_filter = {};
+  std::vector<TfLiteDimensionMetadata> sparse_filter_dim_metadata;
 };
 
 inline PaddingType RuntimePaddingType(TfLitePadding padding) {
@@ -128,17 +150,17 @@ void* Init(TfLiteContext* context, const char* buffer, size_t length) {
 
 void Free(TfLiteContext* context, void* buffer) {
   eigen_support::DecrementUsageCounter(context);
-  delete reinterpret_cast<OpData*>(buffer);
+  OpData* data = reinterpret_cast<OpData*>(buffer);
+  TfLiteIntArrayFree(data->sparse_filter.traversal_order);
+  TfLiteIntArrayFree(data->sparse_filter.block_map);
+  delete data;
 }
 
 // Naive implementation of transpose for floats. Could be optimized to be more
 // cache friendly, but for now it's a one-time cost on first run, and we would
 // prefer to remove the need to do this at all eventually.
-void TransposeFloatTensor(const TfLiteTensor* input, TfLiteTensor* output) {
-  const int rows = output->dims->data[1];
-  const int cols = output->dims->data[0];
-  const float* input_data = GetTensorData<float>(input);
-  float* output_data = GetTensorData<float>(output);
+void TransposeFloatData(const float* input_data, int rows, int cols,
+                        float* output_data) {
   for (int i = 0; i < rows; ++i) {
     for (int j = 0; j < cols; ++j) {
       const float in_value = input_data[i * cols + j];
@@ -147,6 +169,11 @@ void TransposeFloatTensor(const TfLiteTensor* input, TfLiteTensor* output) {
   }
 }
 
+void TransposeFloatTensor(const TfLiteTensor* input, TfLiteTensor* output) {
+  TransposeFloatData(GetTensorData<float>(input), output->dims->data[1],
+                     output->dims->data[0], GetTensorData<float>(output));
+}
+
 // Check if im2col needs to be allocated, as some version of optimized Conv dont
 // use it. If any change is supporting im2col in any of the Conv versions, then
 // it should be updated here as well
@@ -199,6 +226,74 @@ bool IsIm2ColRequired(const TfLiteTensor* input, TfLiteConvParams* params,
   }
 }
 
+// Views the sparsity of a 1x1 float filter as that of 2D fully connected
+// weights. This requires the filter height and width to be traversed as dense
+// dimensions between the filter count and the input depth, which is how the
+// converter sparsifies filters, optionally in blocks of 1x4 or 4x4.
+TfLiteStatus PrepareSparseFilter(TfLiteContext* context,
+                                 TfLiteConvParams* params,
+                                 const TfLiteTensor* input,
+                                 const TfLiteTensor* filter, OpData* data) {
+  const TfLiteSparsity& sparsity = *filter->sparsity;
+  const int block_dims_count = sparsity.dim_metadata_size - 4;
+  bool supported =
+      input->type == kTfLiteFloat32 && filter->type == kTfLiteFloat32 &&
+      IsConstantTensor(filter) && filter->dims->data[1] == 1 &&
+      filter->dims->data[2] == 1 && params->stride_width == 1 &&
+      params->stride_height == 1 && params->dilation_width_factor == 1 &&
+      params->dilation_height_factor == 1 && block_dims_count >= 0 &&
+      block_dims_count <= 2 && sparsity.traversal_order != nullptr &&
+      sparsity.traversal_order->size == sparsity.dim_metadata_size;
+  for (int i = 0; supported && i < sparsity.dim_metadata_size; ++i) {
+    const TfLiteDimensionMetadata& metadata = sparsity.dim_metadata[i];
+    supported = sparsity.traversal_order->data[i] == i;
+    if (i == 3) {
+      supported = supported && metadata.format == kTfLiteDimSparseCSR;
+    } else {
+      supported = supported && metadata.format == kTfLiteDimDense;
+    }
+    if (i == 1 || i == 2) {
+      supported = supported && metadata.dense_size == 1;
+    } else if (i > 3) {
+      supported = supported && metadata.dense_size == 4;
+    }
+  }
+  // 1x4 blocks split the input depth, 4x4 blocks the filter count too.
+  const int block_map_1x4[] = {3};
+  const int block_map_4x4[] = {0, 3};
+  if (supported && block_dims_count > 0) {
+    supported = sparsity.block_map != nullptr &&
+                TfLiteIntArrayEqualsArray(
+                    sparsity.block_map, block_dims_count,
+                    block_dims_count == 1 ? block_map_1x4 : block_map_4x4);
+  }
+  if (!supported) {
+    TF_LITE_KERNEL_LOG(context, "Unsupported sparse convolution filter.");
+    return kTfLiteError;
+  }
+
+  data->sparse_filter_dim_metadata.assign(
+      {sparsity.dim_metadata[0], sparsity.dim_metadata[3]});
+  for (int i = 4; i < sparsity.dim_metadata_size; ++i) {
+    data->sparse_filter_dim_metadata.push_back(sparsity.dim_metadata[i]);
+  }
+  const int dims_count = data->sparse_filter_dim_metadata.size();
+  TfLiteIntArrayFree(data->sparse_filter.traversal_order);
+  data->sparse_filter.traversal_order = TfLiteIntArrayCreate(dims_count);
+  for (int i = 0; i < dims_count; ++i) {
+    data->sparse_filter.traversal_order->data[i] = i;
+  }
+  TfLiteIntArrayFree(data->sparse_filter.block_map);
+  data->sparse_filter.block_map = TfLiteIntArrayCreate(block_dims_count);
+  for (int i = 0; i < block_dims_count; ++i) {
+    // The input depth is the second dimension of the weights.
+    data->sparse_filter.block_map->data[i] = block_dims_count == 1 ? 1 : i;
+  }
+  data->sparse_filter.dim_metadata = data->sparse_filter_dim_metadata.data();
+  data->sparse_filter.dim_metadata_size = dims_count;
+  return kTfLiteOk;
+}
+
 // Allocate temporary tensors (`im2col`, `hwcn_weights` if necessary).
 // Note: `context->AddTensors` might invalidate pointers to existing tensors.
 // Therefore the logic to add tensors are isolated into this function.
@@ -225,6 +320,13 @@ static TfLiteStatus AllocateTemporaryTensorsIfRequired(TfLiteContext* context,
   // we're running with that data type.
   data->need_hwcn_weights =
       input->type == kTfLiteFloat32 && data->supports_multithreaded_kernel;
+  // Constant filters are transposed once for all the interpreters of the
+  // model, in the weights cache.
+  const bool share_hwcn_weights =
+      data->need_hwcn_weights && IsConstantTensor(filter);
+  if (!share_hwcn_weights) {
+    data->shared_hwcn_weights.reset();
+  }
 
   // We don't always need to allocate im2col. It is only used in some versions
   // of the optimized Conv. This test just mimics something that happens inside
@@ -240,7 +342,7 @@ static TfLiteStatus AllocateTemporaryTensorsIfRequired(TfLiteContext* context,
     }
     ++temporaries_count;
   }
-  if (data->need_hwcn_weights) {
+  if (data->need_hwcn_weights && !share_hwcn_weights) {
     data->hwcn_weights_index = temporaries_count;
     if (data->hwcn_weights_id == kTensorNotAllocated) {
       context->AddTensors(context, 1, &data->hwcn_weights_id);
@@ -367,11 +469,19 @@ TfLiteStatus Prepare(KernelType kernel_type, TfLiteContext* context,
     }
   }
 
-  // The multi-threaded kernel supports neither dilation nor hybrid kernels, and
-  // is incompatible with mutable input filters that might change between evals.
+  data->has_sparse_filter = filter->sparsity != nullptr;
+  if (data->has_sparse_filter) {
+    TF_LITE_ENSURE_STATUS(
+        PrepareSparseFilter(context, params, input, filter, data));
+  }
+
+  // The multi-threaded kernel supports neither dilation, hybrid kernels nor
+  // sparse filters, and is incompatible with mutable input filters that might
+  // change between evals.
   data->supports_multithreaded_kernel =
       (kernel_type == kMultithreadOptimized) &&
       (context->recommended_num_threads != 1) && !is_hybrid &&
+      !data->has_sparse_filter &&
       (params->dilation_width_factor == 1) &&
       (params->dilation_height_factor == 1) &&
       (filter->allocation_type != kTfLiteArenaRw) &&
@@ -453,7 +563,17 @@ TfLiteStatus Prepare(KernelType kernel_type, TfLiteContext* context,
     if (im2col_status != kTfLiteOk) return im2col_status;
   }
 
-  if (data->need_hwcn_weights) {
+  if (data->need_hwcn_weights && IsConstantTensor(filter)) {
+    const int rows = channels_out;
+    const int cols = filter_height * filter_width * input->dims->data[3];
+    data->shared_hwcn_weights = WeightsCache::Global().GetOrPack(
+        {filter->data.raw_const, filter->bytes,
+         WeightsCache::Packing::kConvHwcnFloat, static_cast<uint64_t>(rows)},
+        filter->bytes, [filter, rows, cols](char* packed) {
+          TransposeFloatData(GetTensorData<float>(filter), rows, cols,
+                             reinterpret_cast<float*>(packed));
+        });
+  } else if (data->need_hwcn_weights) {
     node->temporaries->data[data->hwcn_weights_index] = data->hwcn_weights_id;
     TfLiteIntArray* hwcn_weights_size = TfLiteIntArrayCreate(2);
 
@@ -478,6 +598,8 @@ TfLiteStatus Prepare(KernelType kernel_type, TfLiteContext* context,
     // changed, this will do extra redundant work.
     data->have_weights_been_transposed = false;
   }
+  // Eval reads the shared transposed filter rather than the constant one.
+  node->copied_inputs_mask = data->shared_hwcn_weights != nullptr ? 1 << 1 : 0;
 
   if (is_hybrid) {
     node->temporaries->data[data->input_quantized_index] =
@@ -718,6 +840,51 @@ void EvalQuantizedPerChannel16x8(TfLiteContext* context, TfLiteNode* node,
   }
 }
 
+// Runs a 1x1 conv with a sparse filter as a fully connected op mapping the
+// [pixels, input_depth] input to the [pixels, filter_count] output.
+template <KernelType kernel_type>
+void EvalSparseFloat(TfLiteContext* context, const OpData* data,
+                     float output_activation_min, float output_activation_max,
+                     const TfLiteTensor* input, const TfLiteTensor* filter,
+                     const TfLiteTensor* bias, TfLiteTensor* output) {
+  const int input_depth = SizeOfDimension(input, 3);
+  const int output_depth = SizeOfDimension(filter, 0);
+  const int pixels = NumElements(input) / input_depth;
+  const RuntimeShape input_shape({pixels, input_depth});
+  const RuntimeShape weights_shape({output_depth, input_depth});
+  const RuntimeShape bias_shape({output_depth});
+  const RuntimeShape output_shape({pixels, output_depth});
+  FullyConnectedParams op_params;
+  op_params.float_activation_min = output_activation_min;
+  op_params.float_activation_max = output_activation_max;
+  const TfLiteSparsity& sparsity = data->sparse_filter;
+  if (kernel_type == kReference) {
+    reference_ops::FullyConnectedSparseWeight(
+        sparsity, op_params, input_shape, GetTensorData<float>(input),
+        weights_shape, GetTensorData<float>(filter), bias_shape,
+        GetTensorData<float>(bias), output_shape, GetTensorData<float>(output));
+  } else if (sparsity.dim_metadata_size == kDimMetadataSizeRandomSparse) {
+    optimized_ops::FullyConnectedSparseWeight(
+        sparsity, op_params, input_shape, GetTensorData<float>(input),
+        weights_shape, GetTensorData<float>(filter), bias_shape,
+        GetTensorData<float>(bias), output_shape, GetTensorData<float>(output));
+  } else if (sparsity.dim_metadata_size == kDimMetadataSizeBlockSparse) {
+    optimized_ops::FullyConnectedSparseWeight1x4(
+        sparsity, op_params, input_shape, GetTensorData<float>(input),
+        weights_shape, GetTensorData<float>(filter), bias_shape,
+        GetTensorData<float>(bias), output_shape, GetTensorData<float>(output),
+        CpuBackendContext::GetFromContext(context));
+  } else {
+    TFLITE_DCHECK_EQ(sparsity.dim_metadata_size,
+                     kDimMetadataSizeBlockSparse2D);
+    optimized_ops::FullyConnectedSparseWeight4x4(
+        sparsity, op_params, input_shape, GetTensorData<float>(input),
+        weights_shape, GetTensorData<float>(filter), bias_shape,
+        GetTensorData<float>(bias), output_shape, GetTensorData<float>(output),
+        CpuBackendContext::GetFromContext(context));
+  }
+}
+
 template <KernelType kernel_type>
 void EvalFloat(TfLiteContext* context, TfLiteNode* node,
                TfLiteConvParams* params, OpData* data,
@@ -727,6 +894,12 @@ void EvalFloat(TfLiteContext* context, TfLiteNode* node,
   float output_activation_min, output_activation_max;
   CalculateActivationRange(params->activation, &output_activation_min,
                            &output_activation_max);
+  if (data->has_sparse_filter) {
+    EvalSparseFloat<kernel_type>(context, data, output_activation_min,
+                                 output_activation_max, input, filter, bias,
+                                 output);
+    return;
+  }
   KernelType effective_kernel_type = kernel_type;
   // Fall back to the optimized path if multi-threaded conv is unsupported.
   if ((kernel_type == kMultithreadOptimized) &&
@@ -772,7 +945,10 @@ void EvalFloat(TfLiteContext* context, TfLiteNode* node,
       TFLITE_DCHECK(false);
 #else
       const float* filter_data;
-      if (data->need_hwcn_weights) {
+      if (data->shared_hwcn_weights != nullptr) {
+        filter_data =
+            reinterpret_cast<const float*>(data->shared_hwcn_weights->data());
+      } else if (data->need_hwcn_weights) {
         filter_data = GetTensorData<float>(hwcn_weights);
       } else {
         filter_data = GetTensorData<float>(filter);
@@ -944,12 +1120,14 @@ TfLiteStatus EvalImpl(TfLiteContext* context, TfLiteNode* node) {
       data->need_im2col
           ? &context->tensors[node->temporaries->data[data->im2col_index]]
           : nullptr;
+  const bool has_hwcn_weights_tensor =
+      data->need_hwcn_weights && data->shared_hwcn_weights == nullptr;
   TfLiteTensor* hwcn_weights =
-      data->need_hwcn_weights
+      has_hwcn_weights_tensor
           ? &context->tensors[node->temporaries->data[data->hwcn_weights_index]]
           : nullptr;
 
-  if (data->need_hwcn_weights && !data->have_weights_been_transposed) {
+  if (has_hwcn_weights_tensor && !data->have_weights_been_transposed) {
     TransposeFloatTensor(filter, hwcn_weights);
     data->have_weights_been_transposed = true;
   }
@@ -60,7 +60,9 @@ class BaseConvolutionOpModel : public SingleOpModel {
       std::initializer_list<FilterType> filter_data = {}) {
     input_ = AddInput(input);
 
-    if (filter_data.size()) {
+    if (filter_data.size() && !filter.traversal_order.empty()) {
+      filter_ = AddConstSparseInput(filter, filter_data);
+    } else if (filter_data.size()) {
       filter_ = AddConstInput(filter, filter_data);
     } else {
       filter_ = AddInput(filter);
@@ -861,6 +863,63 @@ TEST_P(ConvolutionOpTest, SimpleTestFloatWithDilation) {
   EXPECT_THAT(m.GetOutput(), ElementsAreArray({5, 5, 5, 5, 5, 5, 5, 5, 5}));
 }
 
+// Runs a 1x1 conv whose filter is sparsified as described by `filter`.
+void TestSparseFilter1x1(TfLiteRegistration* registration,
+                         const TensorData& filter) {
+  ConvolutionOpModel m(registration, {TensorType_FLOAT32, {1, 2, 1, 12}},
+                       filter, {TensorType_FLOAT32, {}}, /*stride_width=*/1,
+                       /*stride_height=*/1, Padding_VALID,
+                       ActivationFunctionType_NONE, /*dilation_width_factor=*/1,
+                       /*dilation_height_factor=*/1, /*num_threads=*/-1,
+                       {
+                           1, 2, 3, 4, 0, 0, 0, 0, 1, 0, 0, 1,   // filter = 0
+                           0, 0, 0, 0, 0, 0, 0, 0, 2, 2, 2, 2,   // filter = 1
+                           1, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0,   // filter = 2
+                           0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, -1,  // filter = 3
+                       });
+
+  m.SetInput({
+      1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12,     // row = 1
+      1, -1, 1, -1, 1, -1, 1, -1, 2, -2, 2, -2,  // row = 2
+  });
+  m.SetBias({1, 2, 3, 4});
+
+  m.Invoke();
+
+  EXPECT_THAT(m.GetOutput(), ElementsAreArray({
+                                 52, 86, 7, -4,  // row = 1
+                                 -1, 2, 5, 5,    // row = 2
+                             }));
+}
+
+TEST_P(ConvolutionOpTest, SparseFilter1x1) {
+  TensorData filter = {TensorType_FLOAT32, {4, 1, 1, 12}};
+  filter.traversal_order = {0, 1, 2, 3};
+  filter.format = {kTfLiteDimDense, kTfLiteDimDense, kTfLiteDimDense,
+                   kTfLiteDimSparseCSR};
+  TestSparseFilter1x1(GetRegistration(), filter);
+}
+
+TEST_P(ConvolutionOpTest, SparseFilter1x1Block1x4) {
+  TensorData filter = {TensorType_FLOAT32, {4, 1, 1, 12}};
+  filter.traversal_order = {0, 1, 2, 3, 4};
+  filter.format = {kTfLiteDimDense, kTfLiteDimDense, kTfLiteDimDense,
+                   kTfLiteDimSparseCSR};
+  filter.block_map = {3};
+  filter.block_size = {4};
+  TestSparseFilter1x1(GetRegistration(), filter);
+}
+
+TEST_P(ConvolutionOpTest, SparseFilter1x1Block4x4) {
+  TensorData filter = {TensorType_FLOAT32, {4, 1, 1, 12}};
+  filter.traversal_order = {0, 1, 2, 3, 4, 5};
+  filter.format = {kTfLiteDimDense, kTfLiteDimDense, kTfLiteDimDense,
+                   kTfLiteDimSparseCSR};
+  filter.block_map = {0, 3};
+  filter.block_size = {4, 4};
+  TestSparseFilter1x1(GetRegistration(), filter);
+}
+
 class QuantizedConvolutionOpModel : public BaseConvolutionOpModel<uint8_t> {
  public:
   using BaseConvolutionOpModel::BaseConvolutionOpModel;
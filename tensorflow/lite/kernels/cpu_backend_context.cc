@@ -15,17 +15,75 @@ limitations under the License.
 
 #include "tensorflow/lite/kernels/cpu_backend_context.h"
 
+#include <algorithm>
+#include <cstdio>
+#include <functional>
 #include <memory>
+#include <vector>
 
 #include "public/gemmlowp.h"
 #include "ruy/context.h"  // from @ruy
+#include "ruy/thread_pool.h"  // from @ruy
 #include "tensorflow/lite/c/common.h"
 #include "tensorflow/lite/external_cpu_backend_context.h"
 #include "tensorflow/lite/kernels/op_macros.h"
 
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
 namespace {
 const int kDefaultNumThreadpoolThreads = 1;
 
+#ifdef TFLITE_WITH_RUY
+using TaskBase = ruy::Task;
+#else
+using TaskBase = gemmlowp::Task;
+#endif
+
+// Runs one of the workers given to CpuBackendContext::RunWorkers.
+class WorkerTask : public TaskBase {
+ public:
+  WorkerTask(int index, const std::function<void(int)>* worker)
+      : index_(index), worker_(worker) {}
+
+  void Run() override { (*worker_)(index_); }
+
+ private:
+  int index_;
+  const std::function<void(int)>* worker_;
+};
+
+#if defined(__linux__)
+// Pins the worker threads of a thread pool, by running as many tasks as the
+// pool has threads, each pinning the thread running it.
+template <typename Task, typename ThreadPool>
+bool PinWorkers(ThreadPool* thread_pool, int threads_count,
+                const cpu_set_t& cpu_set) {
+  class PinTask : public Task {
+   public:
+    explicit PinTask(const cpu_set_t* cpu_set) : cpu_set_(cpu_set) {}
+    void Run() override {
+      ok = sched_setaffinity(0, sizeof(*cpu_set_), cpu_set_) == 0;
+    }
+    bool ok = false;
+
+   private:
+    const cpu_set_t* cpu_set_;
+  };
+  std::vector<PinTask> tasks;
+  tasks.reserve(threads_count);
+  for (int i = 0; i < threads_count; ++i) {
+    tasks.emplace_back(&cpu_set);
+  }
+  thread_pool->Execute(threads_count, tasks.data());
+  for (const PinTask& task : tasks) {
+    if (!task.ok) return false;
+  }
+  return true;
+}
+#endif
+
 }  // namespace
 
 namespace tflite {
@@ -79,4 +137,82 @@ void CpuBackendContext::SetMaxNumThreads(int max_num_threads) {
 
 void CpuBackendContext::SetUseCaching(bool flag) { use_caching_ = flag; }
 
+void CpuBackendContext::SetGemmAutotuning(bool flag) {
+  if (!flag) {
+    gemm_tuning_cache_.reset();
+  } else if (gemm_tuning_cache_ == nullptr) {
+    gemm_tuning_cache_.reset(new cpu_backend_gemm::GemmTuningCache);
+  }
+}
+
+void CpuBackendContext::SetGemmNumThreads(int num_threads) {
+  const int target_num_threads = std::min(num_threads, max_num_threads_);
+  ruy_context_->set_max_num_threads(target_num_threads);
+  gemmlowp_context_->set_max_num_threads(target_num_threads);
+}
+
+bool CpuBackendContext::SetCpuAffinity(const std::vector<int>& cpus) {
+#if defined(__linux__)
+  if (cpus.empty()) return false;
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  for (int cpu : cpus) {
+    if (cpu < 0 || cpu >= CPU_SETSIZE) return false;
+    CPU_SET(cpu, &cpu_set);
+  }
+  // Threads inherit the affinity of the thread creating them, so the worker
+  // threads created later by the pools are pinned too.
+  if (sched_setaffinity(0, sizeof(cpu_set), &cpu_set) != 0) return false;
+  const int threads_count = std::max(max_num_threads_, 1);
+  return PinWorkers<ruy::Task>(ruy_context_->mutable_thread_pool(),
+                               threads_count, cpu_set) &&
+         PinWorkers<gemmlowp::Task>(gemmlowp_context_->workers_pool(),
+                                    threads_count, cpu_set);
+#else
+  return false;
+#endif
+}
+
+std::vector<int> CpuBackendContext::GetBigCores() {
+  std::vector<int> big_cores;
+  long max_frequency = 0;  // NOLINT(runtime/int)
+  for (int cpu = 0;; ++cpu) {
+    char path[96];
+    snprintf(path, sizeof(path),
+             "/sys/devices/system/cpu/cpu%d/cpufreq/cpuinfo_max_freq", cpu);
+    FILE* file = fopen(path, "r");
+    if (file == nullptr) break;
+    long frequency = 0;  // NOLINT(runtime/int)
+    const bool ok = fscanf(file, "%ld", &frequency) == 1;
+    fclose(file);
+    if (!ok) break;
+    if (frequency > max_frequency) {
+      max_frequency = frequency;
+      big_cores.clear();
+    }
+    if (frequency == max_frequency) {
+      big_cores.push_back(cpu);
+    }
+  }
+  return big_cores;
+}
+
+void CpuBackendContext::RunWorkers(int workers_count,
+                                   const std::function<void(int)>& worker) {
+  if (workers_count <= 1) {
+    TfLiteInternalBackendContext::RunWorkers(workers_count, worker);
+    return;
+  }
+  std::vector<WorkerTask> tasks;
+  tasks.reserve(workers_count);
+  for (int i = 0; i < workers_count; ++i) {
+    tasks.emplace_back(i, &worker);
+  }
+#ifdef TFLITE_WITH_RUY
+  ruy_context_->mutable_thread_pool()->Execute(workers_count, tasks.data());
+#else
+  gemmlowp_context_->workers_pool()->Execute(workers_count, tasks.data());
+#endif
+}
+
 }  // namespace tflite
@@ -16,12 +16,15 @@ limitations under the License.
 #ifndef TENSORFLOW_LITE_KERNELS_CPU_BACKEND_CONTEXT_H_
 #define TENSORFLOW_LITE_KERNELS_CPU_BACKEND_CONTEXT_H_
 
+#include <functional>
 #include <memory>
+#include <vector>
 
 #include "public/gemmlowp.h"
 #include "ruy/context.h"  // from @ruy
 #include "tensorflow/lite/c/common.h"
 #include "tensorflow/lite/external_cpu_backend_context.h"
+#include "tensorflow/lite/kernels/cpu_backend_gemm_tuning.h"
 
 namespace tflite {
 
@@ -50,6 +53,38 @@ class CpuBackendContext final : public TfLiteInternalBackendContext {
 
   void ClearCaches() override { ruy_context_->ClearPrepackedCache(); }
 
+  // Enables picking the backend and the number of threads of each GEMM shape
+  // at runtime: the first GEMM of each shape times the candidate
+  // configurations, and the later ones run the fastest of them. This
+  // accounts for the cores of big.LITTLE devices favoring different
+  // configurations, so it is best combined with SetCpuAffinity().
+  void SetGemmAutotuning(bool flag);
+
+  // The tuned GEMM configurations, or nullptr if autotuning is disabled. They
+  // can be saved, and loaded by later processes on the same device.
+  cpu_backend_gemm::GemmTuningCache* gemm_tuning_cache() const {
+    return gemm_tuning_cache_.get();
+  }
+
+  // Sets the number of threads the GEMM backends run on, up to
+  // max_num_threads(), e.g. as tuned for a GEMM.
+  void SetGemmNumThreads(int num_threads);
+
+  // Pins the calling thread, the worker threads and the threads they create
+  // later to the cpus with the given ids, e.g. to the big cores returned by
+  // GetBigCores(). Returns false if the affinity can't be set on this
+  // platform.
+  bool SetCpuAffinity(const std::vector<int>& cpus);
+
+  // Returns the ids of the cpus with the highest maximum frequency, or an
+  // empty vector if the frequencies aren't known.
+  static std::vector<int> GetBigCores();
+
+  // Runs the workers on the thread pool of the backend used by
+  // cpu_backend_threadpool::Execute.
+  void RunWorkers(int workers_count,
+                  const std::function<void(int)>& worker) override;
+
  private:
   // To enable a smooth transition from the current direct usage
   // of the underlying gemmlowp context to going through abstractions
@@ -77,6 +112,8 @@ class CpuBackendContext final : public TfLiteInternalBackendContext {
   // (currently the Ruy library only).
   bool use_caching_;
 
+  std::unique_ptr<cpu_backend_gemm::GemmTuningCache> gemm_tuning_cache_;
+
   CpuBackendContext(const CpuBackendContext&) = delete;
 };
 
@@ -17,12 +17,16 @@ limitations under the License.
 #define TENSORFLOW_LITE_KERNELS_CPU_BACKEND_GEMM_H_
 
 #include <cstdint>
+#include <limits>
+#include <type_traits>
 
 #include "ruy/profiler/instrumentation.h"  // from @ruy
 #include "tensorflow/lite/kernels/cpu_backend_context.h"
 #include "tensorflow/lite/kernels/cpu_backend_gemm_custom_gemv.h"
 #include "tensorflow/lite/kernels/cpu_backend_gemm_params.h"
 #include "tensorflow/lite/kernels/cpu_backend_gemm_ruy.h"
+#include "tensorflow/lite/kernels/cpu_backend_gemm_tuning.h"
+#include "tensorflow/lite/profiling/time.h"
 
 #ifndef TFLITE_WITH_RUY
 #include "tensorflow/lite/kernels/cpu_backend_gemm_eigen.h"
@@ -84,6 +88,111 @@ struct GemmImpl<float, float, float, float, QuantizationFlavor::kFloatingPoint>
 
 #endif  // not TFLITE_WITH_RUY
 
+namespace detail {
+
+// Runs the GEMM on the default backend, after trying the custom GEMV paths.
+template <typename LhsScalar, typename RhsScalar, typename AccumScalar,
+          typename DstScalar, QuantizationFlavor quantization_flavor>
+void GemmUsingDefaultBackend(
+    const MatrixParams<LhsScalar>& lhs_params, const LhsScalar* lhs_data,
+    const MatrixParams<RhsScalar>& rhs_params, const RhsScalar* rhs_data,
+    const MatrixParams<DstScalar>& dst_params, DstScalar* dst_data,
+    const GemmParams<AccumScalar, DstScalar, quantization_flavor>& params,
+    CpuBackendContext* context) {
+  // We may consider using custom GEMV code for the matrix*vector cases.
+  const bool try_custom_gemv = (dst_params.cols == 1);
+  if (try_custom_gemv) {
+    // GEMV case: try a custom fast GEMV path. It will return true if it
+    // actually handled it.
+    if (detail::CustomGemv(lhs_params, lhs_data, rhs_params, rhs_data,
+                           dst_params, dst_data, params, context)) {
+      return;
+    }
+  }
+  // Generic case: dispatch to any backend as a general GEMM.
+  GemmImpl<LhsScalar, RhsScalar, AccumScalar, DstScalar,
+           quantization_flavor>::Run(lhs_params, lhs_data, rhs_params, rhs_data,
+                                     dst_params, dst_data, params, context);
+}
+
+// Identifies a scalar type in the kinds of tuned GEMMs, in 6 bits.
+template <typename Scalar>
+constexpr uint32_t GemmScalarKind() {
+  return std::is_floating_point<Scalar>::value
+             ? 1
+             : (std::is_signed<Scalar>::value ? 2 : 3) * 8 + sizeof(Scalar);
+}
+
+// Runs the GEMM with the configuration tuned for its shape. The first GEMM of
+// each shape is run with each of the candidate configurations, keeping the
+// fastest of them: since a GEMM only writes its destination, that leaves the
+// same result as running it once.
+template <typename LhsScalar, typename RhsScalar, typename AccumScalar,
+          typename DstScalar, QuantizationFlavor quantization_flavor>
+void GemmWithTuning(
+    const MatrixParams<LhsScalar>& lhs_params, const LhsScalar* lhs_data,
+    const MatrixParams<RhsScalar>& rhs_params, const RhsScalar* rhs_data,
+    const MatrixParams<DstScalar>& dst_params, DstScalar* dst_data,
+    const GemmParams<AccumScalar, DstScalar, quantization_flavor>& params,
+    bool must_use_ruy, CpuBackendContext* context) {
+  auto run = [&](const GemmConfig& config) {
+    context->SetGemmNumThreads(config.num_threads);
+    if (config.use_ruy || must_use_ruy) {
+      detail::GemmImplUsingRuy<LhsScalar, RhsScalar, AccumScalar, DstScalar,
+                               quantization_flavor>::Run(lhs_params, lhs_data,
+                                                         rhs_params, rhs_data,
+                                                         dst_params, dst_data,
+                                                         params, context);
+    } else {
+      GemmUsingDefaultBackend(lhs_params, lhs_data, rhs_params, rhs_data,
+                              dst_params, dst_data, params, context);
+    }
+    context->SetGemmNumThreads(context->max_num_threads());
+  };
+
+  GemmShape shape;
+  shape.lhs_rows = lhs_params.rows;
+  shape.lhs_cols = lhs_params.cols;
+  shape.rhs_cols = rhs_params.cols;
+  shape.kind = GemmScalarKind<LhsScalar>() |
+               GemmScalarKind<RhsScalar>() << 6 |
+               GemmScalarKind<AccumScalar>() << 12 |
+               GemmScalarKind<DstScalar>() << 18 |
+               static_cast<uint32_t>(quantization_flavor) << 24;
+  shape.max_num_threads = context->max_num_threads();
+  GemmTuningCache* cache = context->gemm_tuning_cache();
+  if (const GemmConfig* config = cache->Find(shape)) {
+    run(*config);
+    return;
+  }
+
+  // Only the number of threads is tuned when ruy is the only backend.
+#ifdef TFLITE_WITH_RUY
+  const bool try_ruy = false;
+#else
+  const bool try_ruy = !must_use_ruy;
+#endif
+  ruy::profiler::ScopeLabel label("cpu_backend_gemm::Gemm: autotuning");
+  constexpr int kTrials = 3;
+  GemmConfig best_config;
+  uint64_t best_micros = std::numeric_limits<uint64_t>::max();
+  for (const GemmConfig& config :
+       GemmTuningCandidates(shape.max_num_threads, try_ruy)) {
+    for (int trial = 0; trial < kTrials; ++trial) {
+      const uint64_t start_micros = profiling::time::NowMicros();
+      run(config);
+      const uint64_t micros = profiling::time::NowMicros() - start_micros;
+      if (micros < best_micros) {
+        best_micros = micros;
+        best_config = config;
+      }
+    }
+  }
+  cache->Insert(shape, best_config);
+}
+
+}  // namespace detail
+
 /* Public entry point */
 
 template <typename LhsScalar, typename RhsScalar, typename AccumScalar,
@@ -114,6 +223,11 @@ void Gemm(const MatrixParams<LhsScalar>& lhs_params, const LhsScalar* lhs_data,
     // prefer to force usage of ruy in these cases.
     must_use_ruy = true;
   }
+  if (context->gemm_tuning_cache() != nullptr) {
+    detail::GemmWithTuning(lhs_params, lhs_data, rhs_params, rhs_data,
+                           dst_params, dst_data, params, must_use_ruy, context);
+    return;
+  }
   if (must_use_ruy) {
     detail::GemmImplUsingRuy<LhsScalar, RhsScalar, AccumScalar, DstScalar,
                              quantization_flavor>::Run(lhs_params, lhs_data,
@@ -124,19 +238,8 @@ void Gemm(const MatrixParams<LhsScalar>& lhs_params, const LhsScalar* lhs_data,
   }
   // If we did not choose to force usage of ruy above, then we may now consider
   // using custom GEMV code for the matrix*vector cases.
-  const bool try_custom_gemv = (dst_params.cols == 1);
-  if (try_custom_gemv) {
-    // GEMV case: try a custom fast GEMV path. It will return true if it
-    // actually handled it.
-    if (detail::CustomGemv(lhs_params, lhs_data, rhs_params, rhs_data,
-                           dst_params, dst_data, params, context)) {
-      return;
-    }
-  }
-  // Generic case: dispatch to any backend as a general GEMM.
-  GemmImpl<LhsScalar, RhsScalar, AccumScalar, DstScalar,
-           quantization_flavor>::Run(lhs_params, lhs_data, rhs_params, rhs_data,
-                                     dst_params, dst_data, params, context);
+  detail::GemmUsingDefaultBackend(lhs_params, lhs_data, rhs_params, rhs_data,
+                                  dst_params, dst_data, params, context);
 }
 
 // Special path for gemm with raw accumulator case. i.e. AccumScalar ==
@@ -372,6 +372,8 @@ void TestSomeGemm(int rows, int depth, int cols,
   cpu_backend_context.SetMaxNumThreads(1 + (random_engine() % 8));
   bool use_caching = static_cast<bool>(random_engine() % 2);
   cpu_backend_context.SetUseCaching(use_caching);
+  bool use_autotuning = static_cast<bool>(random_engine() % 2);
+  cpu_backend_context.SetGemmAutotuning(use_autotuning);
   const bool use_golden = !golden.empty();
 
   std::vector<LhsScalar> lhs_data;
@@ -0,0 +1,130 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/kernels/cpu_backend_gemm_tuning.h"
+
+#include <cstdio>
+#include <cstring>
+
+namespace tflite {
+namespace cpu_backend_gemm {
+namespace {
+
+constexpr char kMagic[4] = {'T', 'F', 'L', 'G'};
+constexpr uint32_t kVersion = 1;
+
+// A tuned configuration in a saved cache.
+struct Entry {
+  int32_t lhs_rows;
+  int32_t lhs_cols;
+  int32_t rhs_cols;
+  uint32_t kind;
+  int32_t max_num_threads;
+  int32_t use_ruy;
+  int32_t num_threads;
+  int32_t padding;
+};
+
+}  // namespace
+
+GemmTuningCache::Key GemmTuningCache::KeyOf(const GemmShape& shape) {
+  return Key(shape.lhs_rows, shape.lhs_cols, shape.rhs_cols, shape.kind,
+             shape.max_num_threads);
+}
+
+const GemmConfig* GemmTuningCache::Find(const GemmShape& shape) const {
+  auto it = configs_.find(KeyOf(shape));
+  return it == configs_.end() ? nullptr : &it->second;
+}
+
+void GemmTuningCache::Insert(const GemmShape& shape, const GemmConfig& config) {
+  configs_[KeyOf(shape)] = config;
+}
+
+bool GemmTuningCache::Save(const std::string& path) const {
+  FILE* file = fopen(path.c_str(), "wb");
+  if (file == nullptr) return false;
+  const uint64_t count = configs_.size();
+  bool ok = fwrite(kMagic, sizeof(kMagic), 1, file) == 1 &&
+            fwrite(&kVersion, sizeof(kVersion), 1, file) == 1 &&
+            fwrite(&count, sizeof(count), 1, file) == 1;
+  for (const auto& config : configs_) {
+    if (!ok) break;
+    Entry entry = {};
+    entry.lhs_rows = std::get<0>(config.first);
+    entry.lhs_cols = std::get<1>(config.first);
+    entry.rhs_cols = std::get<2>(config.first);
+    entry.kind = std::get<3>(config.first);
+    entry.max_num_threads = std::get<4>(config.first);
+    entry.use_ruy = config.second.use_ruy;
+    entry.num_threads = config.second.num_threads;
+    ok = fwrite(&entry, sizeof(entry), 1, file) == 1;
+  }
+  return fclose(file) == 0 && ok;
+}
+
+bool GemmTuningCache::Load(const std::string& path) {
+  FILE* file = fopen(path.c_str(), "rb");
+  if (file == nullptr) return false;
+  char magic[sizeof(kMagic)];
+  uint32_t version = 0;
+  uint64_t count = 0;
+  bool ok = fread(magic, sizeof(magic), 1, file) == 1 &&
+            memcmp(magic, kMagic, sizeof(kMagic)) == 0 &&
+            fread(&version, sizeof(version), 1, file) == 1 &&
+            version == kVersion && fread(&count, sizeof(count), 1, file) == 1;
+  std::map<Key, GemmConfig> configs;
+  for (uint64_t i = 0; ok && i < count; ++i) {
+    Entry entry;
+    ok = fread(&entry, sizeof(entry), 1, file) == 1 && entry.num_threads > 0;
+    if (!ok) break;
+    GemmConfig config;
+    config.use_ruy = entry.use_ruy != 0;
+    config.num_threads = entry.num_threads;
+    configs[Key(entry.lhs_rows, entry.lhs_cols, entry.rhs_cols, entry.kind,
+                entry.max_num_threads)] = config;
+  }
+  fclose(file);
+  if (!ok) return false;
+
+  for (const auto& config : configs) {
+    configs_[config.first] = config.second;
+  }
+  return true;
+}
+
+std::vector<GemmConfig> GemmTuningCandidates(int max_num_threads,
+                                             bool try_ruy) {
+  std::vector<int> thread_counts;
+  for (int num_threads = 1; num_threads < max_num_threads; num_threads *= 2) {
+    thread_counts.push_back(num_threads);
+  }
+  thread_counts.push_back(max_num_threads > 1 ? max_num_threads : 1);
+
+  std::vector<GemmConfig> candidates;
+  for (bool use_ruy : {false, true}) {
+    if (use_ruy && !try_ruy) continue;
+    for (int num_threads : thread_counts) {
+      GemmConfig config;
+      config.use_ruy = use_ruy;
+      config.num_threads = num_threads;
+      candidates.push_back(config);
+    }
+  }
+  return candidates;
+}
+
+}  // namespace cpu_backend_gemm
+}  // namespace tflite
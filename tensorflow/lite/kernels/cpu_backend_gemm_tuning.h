@@ -0,0 +1,93 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LITE_KERNELS_CPU_BACKEND_GEMM_TUNING_H_
+#define TENSORFLOW_LITE_KERNELS_CPU_BACKEND_GEMM_TUNING_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace tflite {
+namespace cpu_backend_gemm {
+
+// How a GEMM is run, as picked by autotuning for its shape.
+struct GemmConfig {
+  // Whether the GEMM runs on ruy rather than on the default backend of the
+  // build (gemmlowp or Eigen, unless built with TFLITE_WITH_RUY).
+  bool use_ruy = false;
+  // The number of threads the GEMM runs on.
+  int num_threads = 1;
+};
+
+// Identifies the GEMMs sharing a configuration.
+struct GemmShape {
+  int lhs_rows;
+  int lhs_cols;
+  int rhs_cols;
+  // Distinguishes the scalar types and quantization flavors of the GEMMs.
+  uint32_t kind;
+  // The maximum number of threads of the context, which bounds the numbers of
+  // threads tried.
+  int max_num_threads;
+};
+
+// Caches the fastest configuration timed for each GEMM shape.
+//
+// Save() and Load() carry the configurations over to later processes on the
+// same device, which then run the tuned GEMMs without timing them again.
+//
+// The class is not thread-safe, in the same way as the CpuBackendContext
+// owning it.
+class GemmTuningCache {
+ public:
+  // Returns the configuration tuned for `shape`, or nullptr if there's none.
+  const GemmConfig* Find(const GemmShape& shape) const;
+
+  void Insert(const GemmShape& shape, const GemmConfig& config);
+
+  // Writes the tuned configurations to the file at `path`. Returns false if
+  // the file can't be written.
+  bool Save(const std::string& path) const;
+
+  // Reads the configurations written by Save() to the file at `path`. Returns
+  // false, and leaves the cache unchanged, if the file can't be read or isn't
+  // a saved cache.
+  bool Load(const std::string& path);
+
+  size_t size() const { return configs_.size(); }
+
+ private:
+  using Key = std::tuple<int, int, int, uint32_t, int>;
+
+  static Key KeyOf(const GemmShape& shape);
+
+  std::map<Key, GemmConfig> configs_;
+};
+
+// Returns the configurations timed for a GEMM of a context with
+// `max_num_threads` threads: the powers of two numbers of threads up to
+// `max_num_threads` and `max_num_threads` itself, on the default backend and,
+// if `try_ruy`, on ruy.
+std::vector<GemmConfig> GemmTuningCandidates(int max_num_threads,
+                                             bool try_ruy);
+
+}  // namespace cpu_backend_gemm
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_KERNELS_CPU_BACKEND_GEMM_TUNING_H_
@@ -0,0 +1,110 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/kernels/cpu_backend_gemm_tuning.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace tflite {
+namespace cpu_backend_gemm {
+namespace {
+
+GemmShape ShapeOf(int lhs_rows, int lhs_cols, int rhs_cols, uint32_t kind = 0,
+                  int max_num_threads = 4) {
+  return {lhs_rows, lhs_cols, rhs_cols, kind, max_num_threads};
+}
+
+GemmConfig ConfigOf(bool use_ruy, int num_threads) {
+  GemmConfig config;
+  config.use_ruy = use_ruy;
+  config.num_threads = num_threads;
+  return config;
+}
+
+TEST(GemmTuningCacheTest, FindsInsertedConfigs) {
+  GemmTuningCache cache;
+  EXPECT_EQ(cache.Find(ShapeOf(8, 16, 4)), nullptr);
+  cache.Insert(ShapeOf(8, 16, 4), ConfigOf(true, 2));
+  const GemmConfig* config = cache.Find(ShapeOf(8, 16, 4));
+  ASSERT_NE(config, nullptr);
+  EXPECT_TRUE(config->use_ruy);
+  EXPECT_EQ(config->num_threads, 2);
+  EXPECT_EQ(cache.Find(ShapeOf(8, 16, 5)), nullptr);
+  EXPECT_EQ(cache.Find(ShapeOf(8, 16, 4, /*kind=*/1)), nullptr);
+  EXPECT_EQ(cache.Find(ShapeOf(8, 16, 4, 0, /*max_num_threads=*/8)), nullptr);
+  EXPECT_EQ(cache.size(), 1);
+}
+
+TEST(GemmTuningCacheTest, SavesAndLoadsConfigs) {
+  const std::string path = ::testing::TempDir() + "/gemm_tuning_cache";
+  {
+    GemmTuningCache cache;
+    cache.Insert(ShapeOf(8, 16, 4), ConfigOf(true, 2));
+    cache.Insert(ShapeOf(1, 16, 4, /*kind=*/3), ConfigOf(false, 1));
+    ASSERT_TRUE(cache.Save(path));
+  }
+  GemmTuningCache cache;
+  ASSERT_TRUE(cache.Load(path));
+  EXPECT_EQ(cache.size(), 2);
+  const GemmConfig* config = cache.Find(ShapeOf(8, 16, 4));
+  ASSERT_NE(config, nullptr);
+  EXPECT_TRUE(config->use_ruy);
+  EXPECT_EQ(config->num_threads, 2);
+  config = cache.Find(ShapeOf(1, 16, 4, /*kind=*/3));
+  ASSERT_NE(config, nullptr);
+  EXPECT_FALSE(config->use_ruy);
+  EXPECT_EQ(config->num_threads, 1);
+  std::remove(path.c_str());
+}
+
+TEST(GemmTuningCacheTest, RejectsOtherFiles) {
+  const std::string path = ::testing::TempDir() + "/not_a_gemm_tuning_cache";
+  FILE* file = fopen(path.c_str(), "wb");
+  ASSERT_NE(file, nullptr);
+  fputs("TFLWnot a gemm tuning cache", file);
+  fclose(file);
+  GemmTuningCache cache;
+  EXPECT_FALSE(cache.Load(path));
+  EXPECT_FALSE(cache.Load(path + ".missing"));
+  EXPECT_EQ(cache.size(), 0);
+  std::remove(path.c_str());
+}
+
+TEST(GemmTuningCandidatesTest, TriesPowersOfTwoThreadCounts) {
+  std::vector<int> thread_counts;
+  for (const GemmConfig& config : GemmTuningCandidates(6, /*try_ruy=*/false)) {
+    EXPECT_FALSE(config.use_ruy);
+    thread_counts.push_back(config.num_threads);
+  }
+  EXPECT_EQ(thread_counts, std::vector<int>({1, 2, 4, 6}));
+}
+
+TEST(GemmTuningCandidatesTest, TriesRuy) {
+  const std::vector<GemmConfig> candidates =
+      GemmTuningCandidates(1, /*try_ruy=*/true);
+  ASSERT_EQ(candidates.size(), 2);
+  EXPECT_FALSE(candidates[0].use_ruy);
+  EXPECT_TRUE(candidates[1].use_ruy);
+  EXPECT_EQ(candidates[0].num_threads, 1);
+  EXPECT_EQ(candidates[1].num_threads, 1);
+}
+
+}  // namespace
+}  // namespace cpu_backend_gemm
+}  // namespace tflite
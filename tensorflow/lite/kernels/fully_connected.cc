@@ -18,6 +18,7 @@ limitations under the License.
 #include <algorithm>
 #include <cstddef>
 #include <cstdint>
+#include <memory>
 
 #include "tensorflow/lite/c/builtin_op_data.h"
 #include "tensorflow/lite/c/common.h"
@@ -34,6 +35,7 @@ limitations under the License.
 #include "tensorflow/lite/kernels/internal/tensor_utils.h"
 #include "tensorflow/lite/kernels/internal/types.h"
 #include "tensorflow/lite/kernels/kernel_util.h"
+#include "tensorflow/lite/kernels/weights_cache.h"
 
 namespace tflite {
 namespace ops {
@@ -52,6 +54,7 @@ bool SupportedSparsityFormat(const TfLiteSparsity& sparsity) {
 
 static const int kDimMetadataSizeRandomSparse = 2;
 static const int kDimMetadataSizeBlockSparse = 3;
+static const int kDimMetadataSizeBlockSparse2D = 4;
 
 }  // namespace
 
@@ -74,6 +77,9 @@ struct OpData {
   // The index of the temporary tensor where the quantized inputs are cached.
   int scratch_tensor_index;
   bool compute_row_sums = false;
+  // The row sums of a constant filter, shared with the other interpreters of
+  // the model.
+  std::shared_ptr<const WeightsCache::PackedWeights> shared_row_sums;
 };
 
 constexpr int kInputTensor = 0;
@@ -391,12 +397,32 @@ TfLiteStatus EvalHybrid(TfLiteContext* context, TfLiteNode* node,
   float* scaling_factors_ptr = GetTensorData<float>(scaling_factors);
   int32_t* input_offset_ptr = nullptr;
   int32_t* row_sums_ptr = nullptr;
+  bool* compute_row_sums = &data->compute_row_sums;
+  // The shared row sums are already computed, and only read.
+  bool compute_shared_row_sums = false;
+  const int8_t* filter_data = GetTensorData<int8_t>(filter);
   if (params->asymmetric_quantize_inputs) {
     input_offset_ptr = GetTensorData<int32_t>(input_offsets);
     row_sums_ptr = GetTensorData<int32_t>(row_sums);
+    if (IsConstantTensor(filter)) {
+      if (data->shared_row_sums == nullptr) {
+        data->shared_row_sums = WeightsCache::Global().GetOrPack(
+            {filter->data.raw_const, filter->bytes,
+             WeightsCache::Packing::kFullyConnectedRowSums,
+             static_cast<uint64_t>(num_units)},
+            num_units * sizeof(int32_t),
+            [filter_data, num_units, input_size](char* packed) {
+              tensor_utils::ReductionSumVector(
+                  filter_data, reinterpret_cast<int32_t*>(packed), num_units,
+                  input_size);
+            });
+      }
+      row_sums_ptr = const_cast<int32_t*>(
+          reinterpret_cast<const int32_t*>(data->shared_row_sums->data()));
+      compute_row_sums = &compute_shared_row_sums;
+    }
   }
   int8_t* quant_data = GetTensorData<int8_t>(input_quantized);
-  const int8_t* filter_data = GetTensorData<int8_t>(filter);
   const float* input_ptr = GetTensorData<float>(input);
   tensor_utils::BatchQuantizeFloats(
       input_ptr, batch_size, input_size, quant_data, scaling_factors_ptr,
@@ -411,7 +437,7 @@ TfLiteStatus EvalHybrid(TfLiteContext* context, TfLiteNode* node,
   tensor_utils::MatrixBatchVectorMultiplyAccumulate(
       filter_data, num_units, input_size, quant_data, scaling_factors_ptr,
       batch_size, GetTensorData<float>(output), /*per_channel_scale=*/nullptr,
-      input_offset_ptr, scratch, row_sums_ptr, &data->compute_row_sums,
+      input_offset_ptr, scratch, row_sums_ptr, compute_row_sums,
       CpuBackendContext::GetFromContext(context));
 
   // Apply activation function to floats.
@@ -666,6 +692,17 @@ TfLiteStatus EvalFloat(TfLiteContext* context, TfLiteNode* node,
             GetTensorData<float>(bias), GetTensorShape(output),
             GetTensorData<float>(output),
             CpuBackendContext::GetFromContext(context));
+      } else if (sparsity.dim_metadata_size == kDimMetadataSizeBlockSparse2D &&
+                 sparsity.dim_metadata[2].dense_size == 4 &&
+                 sparsity.dim_metadata[3].dense_size == 4) {
+        // Block sparse with block size of 4x4.
+        optimized_ops::FullyConnectedSparseWeight4x4(
+            sparsity, op_params, GetTensorShape(input),
+            GetTensorData<float>(input), GetTensorShape(filter),
+            GetTensorData<float>(filter), GetTensorShape(bias),
+            GetTensorData<float>(bias), GetTensorShape(output),
+            GetTensorData<float>(output),
+            CpuBackendContext::GetFromContext(context));
       } else {
         TF_LITE_KERNEL_LOG(context,
                            "Unsupported sparse fully-connected weight format.");
@@ -1355,6 +1355,47 @@ TEST_P(SparseFullyConnectedOpTest, Simple1x4TestMultiThreadedMoreBatches) {
                                            ));
   }
 }
+
+TEST_P(SparseFullyConnectedOpTest, Simple4x4Test) {
+  std::initializer_list<float> weight_data = {
+      1, 2, 3, 4, 0,  0,  0,  0,   // u = 0
+      5, 6, 7, 8, 0,  0,  0,  0,   // u = 1
+      1, 1, 1, 1, 0,  0,  0,  0,   // u = 2
+      0, 0, 0, 1, 0,  0,  0,  0,   // u = 3
+      0, 0, 0, 0, 1,  2,  3,  4,   // u = 4
+      0, 0, 0, 0, -1, -2, -3, -4,  // u = 5
+      0, 0, 0, 0, 2,  0,  2,  0,   // u = 6
+      0, 0, 0, 0, 0,  1,  0,  1,   // u = 7
+  };
+  TensorData weight = {};
+  weight.type = TensorType_FLOAT32;
+  weight.shape = {8, 8};
+  weight.traversal_order = {0, 1, 2, 3};
+  weight.format = {kTfLiteDimDense, kTfLiteDimSparseCSR};
+  weight.block_map = {0, 1};
+  weight.block_size = {4, 4};
+  for (int num_threads = 1; num_threads <= 2; num_threads++) {
+    SparseFullyConnectedOpModel<float> m(
+        GetRegistration(),
+        /*units=*/8, /*batches=*/2,
+        /*input=*/{TensorType_FLOAT32, {2, 8}}, weight, weight_data,
+        num_threads);
+    m.SetBias({1, 2, 3, 4, 5, 6, 7, 8});
+
+    m.SetInput({
+        1,  2, 3,  4, 5,  6, 7,  8,  // b = 0
+        -1, 2, -3, 4, -5, 6, -7, 8,  // b = 1
+    });
+
+    m.Invoke();
+
+    EXPECT_THAT(m.GetOutputShape(), ElementsAre(2, 8));
+    EXPECT_THAT(m.GetOutput(),
+                ElementsAre(31, 72, 13, 8, 75, 0, 31, 22,  // b = 0
+                            11, 20, 5, 8, 23, 0, 0, 22));  // b = 1
+  }
+}
+
 // TODO(b/148391360): Add tests for unsupported sparsity format.
 // TEST_P(SparseFullyConnectedOpTest, TestUnsupportedSparsityFormat)
 
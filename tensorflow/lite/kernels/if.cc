@@ -19,6 +19,7 @@ limitations under the License.
 #include <memory>
 #include <vector>
 
+#include "tensorflow/lite/builtin_ops.h"
 #include "tensorflow/lite/c/builtin_op_data.h"
 #include "tensorflow/lite/c/common.h"
 #include "tensorflow/lite/core/subgraph.h"
@@ -32,13 +33,56 @@ namespace if_kernel {
 struct OpData {
   int then_subgraph_index;
   int else_subgraph_index;
+  // Whether the branches share the memory of their arenas.
+  bool branches_share_arena;
 };
 
+// Returns whether the two branches of an IF op can share the memory of their
+// arenas, i.e. are never in use at the same time. This is the case when they
+// don't invoke other subgraphs themselves, and are only ever invoked as the
+// branches of IF ops, of which only one runs at a time.
+bool CanShareArena(const std::vector<std::unique_ptr<Subgraph>>& subgraphs,
+                   int then_subgraph_index, int else_subgraph_index) {
+  if (then_subgraph_index == else_subgraph_index) {
+    return false;
+  }
+  auto is_branch = [&](int subgraph_index) {
+    return subgraph_index == then_subgraph_index ||
+           subgraph_index == else_subgraph_index;
+  };
+  for (int i = 0; i < subgraphs.size(); ++i) {
+    for (const auto& node_and_reg : subgraphs[i]->nodes_and_registration()) {
+      switch (node_and_reg.second.builtin_code) {
+        case kTfLiteBuiltinWhile: {
+          const auto* params = reinterpret_cast<const TfLiteWhileParams*>(
+              node_and_reg.first.builtin_data);
+          if (params == nullptr || is_branch(params->cond_subgraph_index) ||
+              is_branch(params->body_subgraph_index)) {
+            return false;
+          }
+          break;
+        }
+        case kTfLiteBuiltinIf:
+        case kTfLiteBuiltinCall:
+        case kTfLiteBuiltinCustom:
+          break;
+        default:
+          continue;
+      }
+      if (is_branch(i)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
 void* Init(TfLiteContext* context, const char* buffer, size_t length) {
   auto* op_data = new OpData;
   const auto* params = reinterpret_cast<const TfLiteIfParams*>(buffer);
   op_data->then_subgraph_index = params->then_subgraph_index;
   op_data->else_subgraph_index = params->else_subgraph_index;
+  op_data->branches_share_arena = false;
   return op_data;
 }
 
@@ -47,7 +91,7 @@ void Free(TfLiteContext* context, void* buffer) {
 }
 
 TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
-  const OpData* op_data = reinterpret_cast<OpData*>(node->user_data);
+  OpData* op_data = reinterpret_cast<OpData*>(node->user_data);
 
   TF_LITE_ENSURE(context, node->inputs->size > 0);
 
@@ -78,6 +122,15 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
     TF_LITE_ENSURE_EQ(context, num_outputs, subgraph->outputs().size());
   }
 
+  // Only one branch runs at a time, so they can usually use the same memory.
+  // This fails if either was already allocated unshared, e.g. by another op.
+  if (!op_data->branches_share_arena &&
+      CanShareArena(*subgraphs, op_data->then_subgraph_index,
+                    op_data->else_subgraph_index)) {
+    op_data->branches_share_arena =
+        then_subgraph->ShareNonPersistentArenaWith(else_subgraph);
+  }
+
   bool has_dynamic_output_tensors = false;
   for (auto* subgraph : {then_subgraph, else_subgraph}) {
     for (int i = 0; i < num_inputs; ++i) {
@@ -146,6 +199,11 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
       cond_value ? op_data->then_subgraph_index : op_data->else_subgraph_index;
   Subgraph& active_branch_subgraph =
       *(*subgraphs)[active_branch_subgraph_index];
+  // The other branch may have used the memory the branches share since this
+  // one was last allocated.
+  if (op_data->branches_share_arena) {
+    TF_LITE_ENSURE_OK(context, active_branch_subgraph.AllocateTensors());
+  }
   for (int i = 0; i < active_branch_subgraph.inputs().size(); ++i) {
     const TfLiteTensor* input = GetInput(context, node, i + 1);
     TfLiteTensor* subgraph_input =
@@ -112,15 +112,66 @@ inline void FullyConnectedSparseWeight1x4Impl(
   }
 }
 
-struct FullyConnectedSparseWeight1x4Task : cpu_backend_threadpool::Task {
-  FullyConnectedSparseWeight1x4Task(
+inline void FullyConnectedSparseWeight4x4Impl(
+    const TfLiteSparsity& sparsity, const FullyConnectedParams& params,
+    const RuntimeShape& input_shape, const float* input_data,
+    const RuntimeShape& weights_shape, const float* weights_data,
+    const RuntimeShape& bias_shape, const float* bias_data,
+    const RuntimeShape& output_shape, float* output_data, int thread_start,
+    int thread_end, const CpuBackendContext& cpu_backend_context) {
+  ruy::profiler::ScopeLabel label("FullyConnected");
+  ruy::profiler::ScopeLabel inner_label("4x4 Block Sparse");
+  const float output_activation_min = params.float_activation_min;
+  const float output_activation_max = params.float_activation_max;
+
+  const int input_dims_count = input_shape.DimensionsCount();
+  const int output_dims_count = output_shape.DimensionsCount();
+  const int weights_dims_count = weights_shape.DimensionsCount();
+  const int batches = thread_end - thread_start;
+  const int input_depth = MatchingDim(weights_shape, weights_dims_count - 1,
+                                      input_shape, input_dims_count - 1);
+  const int output_depth = MatchingDim(weights_shape, weights_dims_count - 2,
+                                       output_shape, output_dims_count - 1);
+  const int* w1_segments = sparsity.dim_metadata[1].array_segments->data;
+  const int* w1_indices = sparsity.dim_metadata[1].array_indices->data;
+
+  tensor_utils::SparseMatrixBatchVectorMultiplyAccumulate4x4(
+      weights_data, w1_segments, w1_indices, weights_shape.Dims(0),
+      weights_shape.Dims(1), input_data + thread_start * input_depth, batches,
+      output_data + thread_start * output_depth);
+
+  ruy::profiler::ScopeLabel activation_label("activation function");
+  for (int b = thread_start; b < thread_end; ++b) {
+    for (int i = 0; i < output_depth; ++i) {
+      float total = output_data[b * output_depth + i];
+      float bias_value = bias_data[i];
+      output_data[b * output_depth + i] = ActivationFunctionWithMinMax(
+          total + bias_value, output_activation_min, output_activation_max);
+    }
+  }
+}
+
+// The single-threaded kernel of a block sparse fully connected op, computing
+// the batches [thread_start, thread_end).
+using FullyConnectedSparseWeightBlockImpl = void (*)(
+    const TfLiteSparsity& sparsity, const FullyConnectedParams& params,
+    const RuntimeShape& input_shape, const float* input_data,
+    const RuntimeShape& weights_shape, const float* weights_data,
+    const RuntimeShape& bias_shape, const float* bias_data,
+    const RuntimeShape& output_shape, float* output_data, int thread_start,
+    int thread_end, const CpuBackendContext& cpu_backend_context);
+
+struct FullyConnectedSparseWeightBlockTask : cpu_backend_threadpool::Task {
+  FullyConnectedSparseWeightBlockTask(
+      FullyConnectedSparseWeightBlockImpl impl,
       const TfLiteSparsity& sparsity, const FullyConnectedParams& params,
       const RuntimeShape& input_shape, const float* input_data,
       const RuntimeShape& weights_shape, const float* weights_data,
       const RuntimeShape& bias_shape, const float* bias_data,
       const RuntimeShape& output_shape, float* output_data, int thread_start,
       int thread_end, const CpuBackendContext& cpu_backend_context_x)
-      : sparsity(sparsity),
+      : impl(impl),
+        sparsity(sparsity),
         params(params),
         input_shape(input_shape),
         input_data(input_data),
@@ -135,13 +186,13 @@ struct FullyConnectedSparseWeight1x4Task : cpu_backend_threadpool::Task {
         cpu_backend_context(cpu_backend_context_x) {}
 
   void Run() override {
-    FullyConnectedSparseWeight1x4Impl(
-        sparsity, params, input_shape, input_data, weights_shape, weights_data,
-        bias_shape, bias_data, output_shape, output_data, thread_start,
-        thread_end, cpu_backend_context);
+    impl(sparsity, params, input_shape, input_data, weights_shape,
+         weights_data, bias_shape, bias_data, output_shape, output_data,
+         thread_start, thread_end, cpu_backend_context);
   }
 
  private:
+  FullyConnectedSparseWeightBlockImpl impl;
   const TfLiteSparsity& sparsity;
   const FullyConnectedParams& params;
   const RuntimeShape& input_shape;
@@ -161,13 +212,13 @@ struct FullyConnectedSparseWeight1x4Task : cpu_backend_threadpool::Task {
 // there's not enough batches of data, the number of threads used is equal to
 // the batch size. We can improve this later with slicing along the row
 // dimension of the weight.
-inline void FullyConnectedSparseWeight1x4(
-    const TfLiteSparsity& sparsity, const FullyConnectedParams& params,
-    const RuntimeShape& input_shape, const float* input_data,
-    const RuntimeShape& weights_shape, const float* weights_data,
-    const RuntimeShape& bias_shape, const float* bias_data,
-    const RuntimeShape& output_shape, float* output_data,
-    CpuBackendContext* cpu_backend_context) {
+inline void FullyConnectedSparseWeightBlock(
+    FullyConnectedSparseWeightBlockImpl impl, const TfLiteSparsity& sparsity,
+    const FullyConnectedParams& params, const RuntimeShape& input_shape,
+    const float* input_data, const RuntimeShape& weights_shape,
+    const float* weights_data, const RuntimeShape& bias_shape,
+    const float* bias_data, const RuntimeShape& output_shape,
+    float* output_data, CpuBackendContext* cpu_backend_context) {
   const int output_elements = output_shape.FlatSize();
   memset(output_data, 0, output_elements * sizeof(float));
 
@@ -176,12 +227,11 @@ inline void FullyConnectedSparseWeight1x4(
       FlatSizeSkipDim(output_shape, output_shape.DimensionsCount() - 1);
   const int thread_count = std::max(1, std::min(batches, max_threads));
   if (thread_count == 1) {
-    return FullyConnectedSparseWeight1x4Impl(
-        sparsity, params, input_shape, input_data, weights_shape, weights_data,
-        bias_shape, bias_data, output_shape, output_data, 0, batches,
-        *cpu_backend_context);
+    return impl(sparsity, params, input_shape, input_data, weights_shape,
+                weights_data, bias_shape, bias_data, output_shape, output_data,
+                0, batches, *cpu_backend_context);
   }
-  std::vector<FullyConnectedSparseWeight1x4Task> tasks;
+  std::vector<FullyConnectedSparseWeightBlockTask> tasks;
   tasks.reserve(thread_count);
   int thread_start = 0;
   for (int i = 0; i < thread_count; ++i) {
@@ -191,9 +241,9 @@ inline void FullyConnectedSparseWeight1x4(
     int thread_end = thread_start + batches / thread_count;
     if (i < batches % thread_count) thread_end++;
 
-    tasks.emplace_back(sparsity, params, input_shape, input_data, weights_shape,
-                       weights_data, bias_shape, bias_data, output_shape,
-                       output_data, thread_start, thread_end,
+    tasks.emplace_back(impl, sparsity, params, input_shape, input_data,
+                       weights_shape, weights_data, bias_shape, bias_data,
+                       output_shape, output_data, thread_start, thread_end,
                        *cpu_backend_context);
     thread_start = thread_end;
   }
@@ -201,6 +251,34 @@ inline void FullyConnectedSparseWeight1x4(
                                   cpu_backend_context);
 }
 
+inline void FullyConnectedSparseWeight1x4(
+    const TfLiteSparsity& sparsity, const FullyConnectedParams& params,
+    const RuntimeShape& input_shape, const float* input_data,
+    const RuntimeShape& weights_shape, const float* weights_data,
+    const RuntimeShape& bias_shape, const float* bias_data,
+    const RuntimeShape& output_shape, float* output_data,
+    CpuBackendContext* cpu_backend_context) {
+  FullyConnectedSparseWeightBlock(
+      FullyConnectedSparseWeight1x4Impl, sparsity, params, input_shape,
+      input_data, weights_shape, weights_data, bias_shape, bias_data,
+      output_shape, output_data, cpu_backend_context);
+}
+
+// The weights are stored in blocks of 4x4, so both the output depth and the
+// input depth must be multiples of 4.
+inline void FullyConnectedSparseWeight4x4(
+    const TfLiteSparsity& sparsity, const FullyConnectedParams& params,
+    const RuntimeShape& input_shape, const float* input_data,
+    const RuntimeShape& weights_shape, const float* weights_data,
+    const RuntimeShape& bias_shape, const float* bias_data,
+    const RuntimeShape& output_shape, float* output_data,
+    CpuBackendContext* cpu_backend_context) {
+  FullyConnectedSparseWeightBlock(
+      FullyConnectedSparseWeight4x4Impl, sparsity, params, input_shape,
+      input_data, weights_shape, weights_data, bias_shape, bias_data,
+      output_shape, output_data, cpu_backend_context);
+}
+
 }  // namespace optimized_ops
 }  // namespace tflite
 #endif  // TENSORFLOW_LITE_KERNELS_INTERNAL_OPTIMIZED_SPARSE_OPS_FULLY_CONNECTED_H_
@@ -91,6 +91,15 @@ float GetFloatVectorElement(__m128 v) {
   return _mm_cvtss_f32(v);
 }
 
+// Horizontally add 4 float values stored in a single XMM register to float.
+static inline float ReduceFloat32x4(__m128 acc) {
+  // Add the high half of acc to its low half.
+  acc = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+  // Add the second element to the first one.
+  acc = _mm_add_ss(acc, _mm_shuffle_ps(acc, acc, _MM_SHUFFLE(1, 1, 1, 1)));
+  return _mm_cvtss_f32(acc);
+}
+
 }  // namespace
 
 void SseMatrixBatchVectorMultiplyAccumulateImpl(
@@ -415,6 +424,71 @@ void SseSparseMatrixBatchVectorMultiplyAccumulate(
   }  // for batch
 }
 
+void SseSparseMatrixBatchVectorMultiplyAccumulate1x4(
+    const float* __restrict__ matrix, const int32_t* __restrict__ segments,
+    const int32_t* __restrict__ indices, int m_rows, int m_cols,
+    const float* __restrict__ vector, int n_batch, float* __restrict__ result) {
+  static constexpr int kBlockSize = 4;
+  TFLITE_DCHECK_EQ(m_cols % kBlockSize, 0);
+  for (int batch = 0; batch < n_batch; batch++) {
+    const float* matrix_ptr = matrix;
+    const float* vector_in_batch = vector + batch * m_cols;
+    for (int row = 0; row < m_rows; row++) {
+      __m128 acc_fx4 = _mm_setzero_ps();
+      for (int i = segments[row]; i < segments[row + 1]; i++) {
+        const __m128 vector_fx4 =
+            _mm_loadu_ps(vector_in_batch + indices[i] * kBlockSize);
+        const __m128 matrix_fx4 = _mm_loadu_ps(matrix_ptr);
+        acc_fx4 = _mm_add_ps(acc_fx4, _mm_mul_ps(matrix_fx4, vector_fx4));
+        matrix_ptr += kBlockSize;
+      }
+      result[batch * m_rows + row] += ReduceFloat32x4(acc_fx4);
+    }
+  }
+}
+
+void SseSparseMatrixBatchVectorMultiplyAccumulate4x4(
+    const float* __restrict__ matrix, const int32_t* __restrict__ segments,
+    const int32_t* __restrict__ indices, int m_rows, int m_cols,
+    const float* __restrict__ vector, int n_batch, float* __restrict__ result) {
+  static constexpr int kBlockSize = 4;
+  TFLITE_DCHECK_EQ(m_rows % kBlockSize, 0);
+  TFLITE_DCHECK_EQ(m_cols % kBlockSize, 0);
+  for (int batch = 0; batch < n_batch; batch++) {
+    const float* matrix_ptr = matrix;
+    const float* vector_in_batch = vector + batch * m_cols;
+    float* result_in_batch = result + batch * m_rows;
+    for (int block_row = 0; block_row < m_rows / kBlockSize; block_row++) {
+      // One accumulator for each row of the blocks.
+      __m128 acc0_fx4 = _mm_setzero_ps();
+      __m128 acc1_fx4 = _mm_setzero_ps();
+      __m128 acc2_fx4 = _mm_setzero_ps();
+      __m128 acc3_fx4 = _mm_setzero_ps();
+      for (int i = segments[block_row]; i < segments[block_row + 1]; i++) {
+        // The 4 vector values are shared by the 4 rows of the block.
+        const __m128 vector_fx4 =
+            _mm_loadu_ps(vector_in_batch + indices[i] * kBlockSize);
+        acc0_fx4 = _mm_add_ps(
+            acc0_fx4, _mm_mul_ps(_mm_loadu_ps(matrix_ptr), vector_fx4));
+        acc1_fx4 = _mm_add_ps(
+            acc1_fx4, _mm_mul_ps(_mm_loadu_ps(matrix_ptr + 4), vector_fx4));
+        acc2_fx4 = _mm_add_ps(
+            acc2_fx4, _mm_mul_ps(_mm_loadu_ps(matrix_ptr + 8), vector_fx4));
+        acc3_fx4 = _mm_add_ps(
+            acc3_fx4, _mm_mul_ps(_mm_loadu_ps(matrix_ptr + 12), vector_fx4));
+        matrix_ptr += kBlockSize * kBlockSize;
+      }
+      // Transpose so that the sums of the 4 accumulators are computed with
+      // vertical adds: acc<j>[i] then holds the jth partial sum of row i.
+      _MM_TRANSPOSE4_PS(acc0_fx4, acc1_fx4, acc2_fx4, acc3_fx4);
+      const __m128 sum_fx4 = _mm_add_ps(_mm_add_ps(acc0_fx4, acc1_fx4),
+                                        _mm_add_ps(acc2_fx4, acc3_fx4));
+      float* result_ptr = result_in_batch + block_row * kBlockSize;
+      _mm_storeu_ps(result_ptr, _mm_add_ps(_mm_loadu_ps(result_ptr), sum_fx4));
+    }
+  }
+}
+
 void SseReductionSumVector(const int8_t* input_vector, int32_t* output_vector,
                            const int output_size, const int reduction_size) {
   static constexpr std::intptr_t kBlockSize = 16;
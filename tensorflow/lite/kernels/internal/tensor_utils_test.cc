@@ -1535,6 +1535,53 @@ TEST(uKernels, SparseMatrixBatchVectorMultiplyAccumulateTest) {
               ElementsAreArray(ArrayFloatNear(dense_output, 1e-4)));
 }
 
+TEST(uKernels, SparseMatrixBatchVectorMultiplyAccumulate4x4Test) {
+  const int kRow = 8;
+  const int kCol = 12;
+  const int kBatch = 2;
+  /* clang-format off */
+  float matrix[kRow * kCol] = {
+      /* 1st row of blocks */
+      1.1, 2.2, 3.3, 4.4, 0.0, 0.0, 0.0, 0.0, 9.9, 10.1, 11.11, 12.12,
+      -1.1, 2.2, -3.3, 4.4, 0.0, 0.0, 0.0, 0.0, 9.9, -10.1, 11.11, -12.12,
+      5.5, 6.6, 7.7, 8.8, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0,
+      0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0,
+      /* 2nd row of blocks */
+      0.0, 0.0, 0.0, 0.0, 17.17, -18.18, 19.19, -20.2, 0.0, 0.0, 0.0, 0.0,
+      0.0, 0.0, 0.0, 0.0, 21.21, 22.22, 23.23, 24.24, 0.0, 0.0, 0.0, 0.0,
+      0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0,
+      0.0, 0.0, 0.0, 0.0, -1.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 0.0};
+
+  // 4x4 block compressed version of the above matrix, each block in row major.
+  float matrix_values[] = {
+      1.1, 2.2, 3.3, 4.4, -1.1, 2.2, -3.3, 4.4, 5.5, 6.6, 7.7, 8.8,
+      0.0, 0.0, 0.0, 1.0,
+      9.9, 10.1, 11.11, 12.12, 9.9, -10.1, 11.11, -12.12, 0.0, 0.0, 0.0, 0.0,
+      1.0, 0.0, 0.0, 0.0,
+      17.17, -18.18, 19.19, -20.2, 21.21, 22.22, 23.23, 24.24, 0.0, 0.0, 0.0,
+      0.0, -1.0, 0.0, 0.0, 1.0};
+  int32_t segments[] = {0, 2, 3};
+  int32_t indices[] = {0, 2, 1};
+
+  float vector[kBatch * kCol] = {
+    1.0, -1.0, 1.0, -1.0, 1.0, -1.0, 1.0, -1.0, 1.0, -1.0, 1.0, -1.0,
+    2.5, 0.0, -2.1, 0.0, 3.0, 0.0, -1.3, 0.0, 1.3, 0.0, -1.1, 0.0,
+  };
+  /* clang-format on */
+
+  std::vector<float> dense_output(kRow * kBatch, 0.0);
+  MatrixBatchVectorMultiplyAccumulate(matrix, kRow, kCol, vector, kBatch,
+                                      dense_output.data());
+
+  std::vector<float> sparse_output(kRow * kBatch, 0.0);
+  SparseMatrixBatchVectorMultiplyAccumulate4x4(matrix_values, segments,
+                                               indices, kRow, kCol, vector,
+                                               kBatch, sparse_output.data());
+
+  EXPECT_THAT(sparse_output,
+              ElementsAreArray(ArrayFloatNear(dense_output, 1e-4)));
+}
+
 #ifdef __ANDROID__
 TEST(uKernels,
      SparseMatrixBatchVectorMultiplyAccumulateSymmetricQuantizedTest) {
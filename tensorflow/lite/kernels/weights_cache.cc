@@ -0,0 +1,194 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/kernels/weights_cache.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <utility>
+
+namespace tflite {
+namespace {
+
+constexpr char kMagic[4] = {'T', 'F', 'L', 'W'};
+constexpr uint32_t kVersion = 1;
+
+// 64-bit FNV-1a hash of the weights.
+uint64_t Fingerprint(const void* data, size_t size) {
+  const unsigned char* bytes = static_cast<const unsigned char*>(data);
+  uint64_t hash = 14695981039346656037ULL;
+  for (size_t i = 0; i < size; ++i) {
+    hash = (hash ^ bytes[i]) * 1099511628211ULL;
+  }
+  return hash;
+}
+
+// The header of each packed weights in a saved cache.
+struct EntryHeader {
+  uint64_t fingerprint;
+  uint64_t weights_size;
+  uint64_t params;
+  uint64_t packed_size;
+  uint32_t packing;
+  uint32_t padding;
+};
+
+}  // namespace
+
+WeightsCache& WeightsCache::Global() {
+  static WeightsCache* cache = new WeightsCache;
+  return *cache;
+}
+
+std::shared_ptr<const WeightsCache::PackedWeights> WeightsCache::GetOrPack(
+    const Key& key, size_t packed_size,
+    const std::function<void(char* packed)>& pack) {
+  const LiveKey live_key(key.weights, key.weights_size, key.packing,
+                         key.params);
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = live_.find(live_key);
+  if (it != live_.end()) {
+    std::shared_ptr<const PackedWeights> packed = it->second.lock();
+    if (packed != nullptr && packed->size() == packed_size) {
+      return packed;
+    }
+  }
+
+  std::shared_ptr<const PackedWeights> packed;
+  if (!loaded_.empty()) {
+    const LoadedKey loaded_key(Fingerprint(key.weights, key.weights_size),
+                               key.weights_size, key.packing, key.params);
+    auto loaded_it = loaded_.find(loaded_key);
+    if (loaded_it != loaded_.end() &&
+        loaded_it->second->size() == packed_size) {
+      packed = std::move(loaded_it->second);
+      loaded_.erase(loaded_it);
+    }
+  }
+  if (packed == nullptr) {
+    auto new_packed = std::make_shared<PackedWeights>(packed_size);
+    pack(new_packed->data());
+    packed = std::move(new_packed);
+  }
+
+  // Drop the entries of the weights no longer in use.
+  for (auto live_it = live_.begin(); live_it != live_.end();) {
+    if (live_it->second.expired()) {
+      live_it = live_.erase(live_it);
+    } else {
+      ++live_it;
+    }
+  }
+  live_[live_key] = packed;
+  return packed;
+}
+
+bool WeightsCache::Save(const std::string& path) const {
+  std::vector<std::pair<EntryHeader, std::shared_ptr<const PackedWeights>>>
+      entries;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& entry : live_) {
+      std::shared_ptr<const PackedWeights> packed = entry.second.lock();
+      if (packed == nullptr) continue;
+      // The weights stay valid while they are packed in use.
+      const void* weights = std::get<0>(entry.first);
+      const size_t weights_size = std::get<1>(entry.first);
+      EntryHeader header = {};
+      header.fingerprint = Fingerprint(weights, weights_size);
+      header.weights_size = weights_size;
+      header.packing = static_cast<uint32_t>(std::get<2>(entry.first));
+      header.params = std::get<3>(entry.first);
+      header.packed_size = packed->size();
+      entries.emplace_back(header, std::move(packed));
+    }
+    for (const auto& entry : loaded_) {
+      EntryHeader header = {};
+      header.fingerprint = std::get<0>(entry.first);
+      header.weights_size = std::get<1>(entry.first);
+      header.packing = static_cast<uint32_t>(std::get<2>(entry.first));
+      header.params = std::get<3>(entry.first);
+      header.packed_size = entry.second->size();
+      entries.emplace_back(header, entry.second);
+    }
+  }
+
+  FILE* file = fopen(path.c_str(), "wb");
+  if (file == nullptr) return false;
+  const uint64_t count = entries.size();
+  bool ok = fwrite(kMagic, sizeof(kMagic), 1, file) == 1 &&
+            fwrite(&kVersion, sizeof(kVersion), 1, file) == 1 &&
+            fwrite(&count, sizeof(count), 1, file) == 1;
+  for (const auto& entry : entries) {
+    if (!ok) break;
+    ok = fwrite(&entry.first, sizeof(entry.first), 1, file) == 1 &&
+         fwrite(entry.second->data(), 1, entry.second->size(), file) ==
+             entry.second->size();
+  }
+  return fclose(file) == 0 && ok;
+}
+
+bool WeightsCache::Load(const std::string& path) {
+  FILE* file = fopen(path.c_str(), "rb");
+  if (file == nullptr) return false;
+  char magic[sizeof(kMagic)];
+  uint32_t version = 0;
+  uint64_t count = 0;
+  bool ok = fread(magic, sizeof(magic), 1, file) == 1 &&
+            memcmp(magic, kMagic, sizeof(kMagic)) == 0 &&
+            fread(&version, sizeof(version), 1, file) == 1 &&
+            version == kVersion && fread(&count, sizeof(count), 1, file) == 1;
+  std::map<LoadedKey, std::shared_ptr<const PackedWeights>> loaded;
+  for (uint64_t i = 0; ok && i < count; ++i) {
+    EntryHeader header;
+    if (fread(&header, sizeof(header), 1, file) != 1) {
+      ok = false;
+      break;
+    }
+    auto packed = std::make_shared<PackedWeights>();
+    // Read in chunks so that a corrupted size fails at the end of the file
+    // rather than allocating it all upfront.
+    constexpr size_t kChunkSize = 1 << 20;
+    while (ok && packed->size() < header.packed_size) {
+      const size_t offset = packed->size();
+      const size_t chunk =
+          std::min<uint64_t>(kChunkSize, header.packed_size - offset);
+      packed->resize(offset + chunk);
+      ok = fread(packed->data() + offset, 1, chunk, file) == chunk;
+    }
+    loaded[LoadedKey(header.fingerprint, header.weights_size,
+                     static_cast<Packing>(header.packing), header.params)] =
+        std::move(packed);
+  }
+  fclose(file);
+  if (!ok) return false;
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto& entry : loaded) {
+    loaded_[entry.first] = std::move(entry.second);
+  }
+  return true;
+}
+
+size_t WeightsCache::size() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  size_t size = loaded_.size();
+  for (const auto& entry : live_) {
+    if (!entry.second.expired()) ++size;
+  }
+  return size;
+}
+
+}  // namespace tflite
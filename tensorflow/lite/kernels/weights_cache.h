@@ -0,0 +1,108 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_KERNELS_WEIGHTS_CACHE_H_
+#define TENSORFLOW_LITE_KERNELS_WEIGHTS_CACHE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace tflite {
+
+// A process-wide cache of the weights that kernels and delegates repack from
+// the constant buffers of a model, e.g. transposed or dequantized filters.
+// The interpreters created for the same model share the packed weights,
+// instead of each packing its own copy.
+//
+// The packed weights are owned by the kernels using them, and are freed with
+// the last of them. They are looked up by the address of the buffer they are
+// packed from, which can't be reused for other weights while they are in use.
+//
+// Save() and Load() carry the packed weights over to later processes on the
+// same machine, which then don't pack them again. The loaded weights are
+// matched with the buffers they were packed from by their contents.
+//
+// The class is thread-safe.
+class WeightsCache {
+ public:
+  // Identifies how the weights are packed. The values are stored by Save(),
+  // and must not change.
+  enum class Packing : uint32_t {
+    // Float conv filters transposed to [height * width * depth, count].
+    kConvHwcnFloat = 1,
+    // The int32 row sums of the int8 filters of hybrid fully connected ops.
+    kFullyConnectedRowSums = 2,
+    // Float16 weights dequantized to float by the XNNPACK delegate.
+    kXNNPackDequantizeFloat16 = 3,
+    // Sparse float weights densified by the XNNPACK delegate.
+    kXNNPackDensifyFloat = 4,
+    // Int8 weights dequantized to float by the XNNPACK delegate.
+    kXNNPackDequantizeInt8 = 5,
+  };
+
+  struct Key {
+    // The buffer the weights are packed from.
+    const void* weights;
+    size_t weights_size;
+    Packing packing;
+    // The parameters of the packing which the weights don't determine, such
+    // as their shape.
+    uint64_t params;
+  };
+
+  using PackedWeights = std::vector<char>;
+
+  // Returns the cache shared by all the interpreters of the process.
+  static WeightsCache& Global();
+
+  // Returns the weights packed for `key`. If no kernel holds them, they are
+  // packed by `pack` into a zero-initialized buffer of `packed_size` bytes.
+  std::shared_ptr<const PackedWeights> GetOrPack(
+      const Key& key, size_t packed_size,
+      const std::function<void(char* packed)>& pack);
+
+  // Writes the packed weights in use, as well as the loaded ones not claimed
+  // yet, to the file at `path`. Returns false if the file can't be written.
+  bool Save(const std::string& path) const;
+
+  // Reads the packed weights written by Save() to the file at `path`. Returns
+  // false, and leaves the cache unchanged, if the file can't be read or isn't
+  // a saved cache.
+  bool Load(const std::string& path);
+
+  // Returns the number of packed weights in use, or loaded and not claimed.
+  size_t size() const;
+
+ private:
+  // Keyed by the address and size of the weights, the packing and its params.
+  using LiveKey = std::tuple<const void*, size_t, Packing, uint64_t>;
+  // Keyed by the fingerprint and size of the weights, the packing and its
+  // params.
+  using LoadedKey = std::tuple<uint64_t, size_t, Packing, uint64_t>;
+
+  mutable std::mutex mutex_;
+  std::map<LiveKey, std::weak_ptr<const PackedWeights>> live_;
+  std::map<LoadedKey, std::shared_ptr<const PackedWeights>> loaded_;
+};
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_KERNELS_WEIGHTS_CACHE_H_
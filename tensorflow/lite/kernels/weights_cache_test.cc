@@ -0,0 +1,136 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/kernels/weights_cache.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace tflite {
+namespace {
+
+using Packing = WeightsCache::Packing;
+
+// Packs the weights by negating them, and counts the calls.
+class Negate {
+ public:
+  Negate(const std::vector<char>& weights, int* calls)
+      : weights_(weights), calls_(calls) {}
+
+  void operator()(char* packed) const {
+    ++*calls_;
+    for (size_t i = 0; i < weights_.size(); ++i) {
+      packed[i] = -weights_[i];
+    }
+  }
+
+ private:
+  const std::vector<char>& weights_;
+  int* calls_;
+};
+
+WeightsCache::Key KeyOf(const std::vector<char>& weights,
+                        Packing packing = Packing::kConvHwcnFloat,
+                        uint64_t params = 0) {
+  return {weights.data(), weights.size(), packing, params};
+}
+
+TEST(WeightsCacheTest, SharesPackedWeights) {
+  WeightsCache cache;
+  const std::vector<char> weights = {1, 2, 3};
+  int calls = 0;
+  auto packed1 =
+      cache.GetOrPack(KeyOf(weights), weights.size(), Negate(weights, &calls));
+  auto packed2 =
+      cache.GetOrPack(KeyOf(weights), weights.size(), Negate(weights, &calls));
+  EXPECT_EQ(calls, 1);
+  EXPECT_EQ(packed1, packed2);
+  EXPECT_EQ(*packed1, std::vector<char>({-1, -2, -3}));
+  EXPECT_EQ(cache.size(), 1);
+}
+
+TEST(WeightsCacheTest, PacksAgainOnceReleased) {
+  WeightsCache cache;
+  const std::vector<char> weights = {1, 2, 3};
+  int calls = 0;
+  cache.GetOrPack(KeyOf(weights), weights.size(), Negate(weights, &calls));
+  EXPECT_EQ(cache.size(), 0);
+  cache.GetOrPack(KeyOf(weights), weights.size(), Negate(weights, &calls));
+  EXPECT_EQ(calls, 2);
+}
+
+TEST(WeightsCacheTest, DistinguishesPackings) {
+  WeightsCache cache;
+  const std::vector<char> weights = {1, 2, 3};
+  int calls = 0;
+  auto packed1 =
+      cache.GetOrPack(KeyOf(weights), weights.size(), Negate(weights, &calls));
+  auto packed2 = cache.GetOrPack(KeyOf(weights, Packing::kConvHwcnFloat, 1),
+                                 weights.size(), Negate(weights, &calls));
+  auto packed3 =
+      cache.GetOrPack(KeyOf(weights, Packing::kFullyConnectedRowSums),
+                      weights.size(), Negate(weights, &calls));
+  EXPECT_EQ(calls, 3);
+  EXPECT_NE(packed1, packed2);
+  EXPECT_NE(packed1, packed3);
+  EXPECT_EQ(cache.size(), 3);
+}
+
+TEST(WeightsCacheTest, SaveAndLoad) {
+  const std::string path = ::testing::TempDir() + "/weights_cache";
+  const std::vector<char> weights = {1, 2, 3};
+  int calls = 0;
+  {
+    WeightsCache cache;
+    auto packed = cache.GetOrPack(KeyOf(weights), weights.size(),
+                                  Negate(weights, &calls));
+    ASSERT_TRUE(cache.Save(path));
+  }
+
+  // The loaded weights are matched by the contents of a different buffer.
+  WeightsCache cache;
+  ASSERT_TRUE(cache.Load(path));
+  EXPECT_EQ(cache.size(), 1);
+  const std::vector<char> same_weights = weights;
+  auto packed = cache.GetOrPack(KeyOf(same_weights), same_weights.size(),
+                                Negate(same_weights, &calls));
+  EXPECT_EQ(calls, 1);
+  EXPECT_EQ(*packed, std::vector<char>({-1, -2, -3}));
+
+  const std::vector<char> other_weights = {1, 2, 4};
+  cache.GetOrPack(KeyOf(other_weights), other_weights.size(),
+                  Negate(other_weights, &calls));
+  EXPECT_EQ(calls, 2);
+  std::remove(path.c_str());
+}
+
+TEST(WeightsCacheTest, LoadRejectsOtherFiles) {
+  const std::string path = ::testing::TempDir() + "/not_a_weights_cache";
+  FILE* file = fopen(path.c_str(), "wb");
+  ASSERT_NE(file, nullptr);
+  fputs("not a weights cache", file);
+  fclose(file);
+
+  WeightsCache cache;
+  EXPECT_FALSE(cache.Load(path));
+  EXPECT_FALSE(cache.Load(path + ".missing"));
+  EXPECT_EQ(cache.size(), 0);
+  std::remove(path.c_str());
+}
+
+}  // namespace
+}  // namespace tflite
@@ -0,0 +1,475 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/micro/kernels/riscv-nn/riscv_nn.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "tensorflow/lite/kernels/internal/common.h"
+
+#if defined(__riscv_v_intrinsic)
+#include <riscv_vector.h>
+#endif
+
+namespace tflite {
+namespace riscv_nn {
+namespace {
+
+// The number of channels the depthwise conv and the average pool accumulate at
+// once, which bounds their accumulators on the stack.
+constexpr int kChannelBlock = 64;
+
+// Computes the range [start, end) of the filter taps whose input is inside the
+// image at `origin`. The taps outside are the zero padding.
+void GetFilterRange(int origin, int dilation, int filter_size, int input_size,
+                    int* start, int* end) {
+  *start = 0;
+  while (*start < filter_size && origin + dilation * *start < 0) ++*start;
+  *end = filter_size;
+  while (*end > *start && origin + dilation * (*end - 1) >= input_size) --*end;
+}
+
+inline int8_t Requantize(int32_t acc, int32_t output_multiplier,
+                         int32_t output_shift, int32_t output_offset,
+                         int32_t output_activation_min,
+                         int32_t output_activation_max) {
+  acc = MultiplyByQuantizedMultiplier(acc, output_multiplier, output_shift);
+  acc += output_offset;
+  acc = std::max(acc, output_activation_min);
+  acc = std::min(acc, output_activation_max);
+  return static_cast<int8_t>(acc);
+}
+
+}  // namespace
+
+#if defined(__riscv_v_intrinsic)
+
+int32_t DotProduct(const int8_t* a, const int8_t* b, int length) {
+  vint32m1_t acc = __riscv_vmv_s_x_i32m1(0, 1);
+  while (length > 0) {
+    const size_t vl = __riscv_vsetvl_e8m1(length);
+    // The products of two int8 values fit in int16, and are widened again to
+    // int32 by the reduction.
+    const vint16m2_t products = __riscv_vwmul_vv_i16m2(
+        __riscv_vle8_v_i8m1(a, vl), __riscv_vle8_v_i8m1(b, vl), vl);
+    acc = __riscv_vwredsum_vs_i16m2_i32m1(products, acc, vl);
+    a += vl;
+    b += vl;
+    length -= vl;
+  }
+  return __riscv_vmv_x_s_i32m1_i32(acc);
+}
+
+void MultiplyAccumulate(const int8_t* input, int32_t input_offset,
+                        const int8_t* filter, int length, int32_t* acc) {
+  // The offset inputs fit in int16 since the offset is a negated int8 zero
+  // point.
+  const int16_t offset = static_cast<int16_t>(input_offset);
+  while (length > 0) {
+    const size_t vl = __riscv_vsetvl_e8m1(length);
+    const vint16m2_t x = __riscv_vadd_vx_i16m2(
+        __riscv_vsext_vf2_i16m2(__riscv_vle8_v_i8m1(input, vl), vl), offset,
+        vl);
+    const vint16m2_t w =
+        __riscv_vsext_vf2_i16m2(__riscv_vle8_v_i8m1(filter, vl), vl);
+    __riscv_vse32_v_i32m4(
+        acc, __riscv_vwmacc_vv_i32m4(__riscv_vle32_v_i32m4(acc, vl), x, w, vl),
+        vl);
+    input += vl;
+    filter += vl;
+    acc += vl;
+    length -= vl;
+  }
+}
+
+#else
+
+int32_t DotProduct(const int8_t* a, const int8_t* b, int length) {
+  int32_t acc = 0;
+  for (int i = 0; i < length; ++i) {
+    acc += a[i] * b[i];
+  }
+  return acc;
+}
+
+void MultiplyAccumulate(const int8_t* input, int32_t input_offset,
+                        const int8_t* filter, int length, int32_t* acc) {
+  for (int i = 0; i < length; ++i) {
+    acc[i] += (input[i] + input_offset) * filter[i];
+  }
+}
+
+#endif  // defined(__riscv_v_intrinsic)
+
+int32_t Sum(const int8_t* a, int length) {
+  int32_t sum = 0;
+  for (int i = 0; i < length; ++i) {
+    sum += a[i];
+  }
+  return sum;
+}
+
+void ComputeFilterSums(const int8_t* filter_data, int num_filters,
+                       int filter_size, int32_t* filter_sums) {
+  for (int i = 0; i < num_filters; ++i) {
+    filter_sums[i] = Sum(filter_data + i * filter_size, filter_size);
+  }
+}
+
+void ConvPerChannel(const ConvParams& params, const int32_t* output_multiplier,
+                    const int32_t* output_shift, const int32_t* filter_sums,
+                    const RuntimeShape& input_shape, const int8_t* input_data,
+                    const RuntimeShape& filter_shape, const int8_t* filter_data,
+                    const RuntimeShape& bias_shape, const int32_t* bias_data,
+                    const RuntimeShape& output_shape, int8_t* output_data) {
+  const int stride_width = params.stride_width;
+  const int stride_height = params.stride_height;
+  const int dilation_width_factor = params.dilation_width_factor;
+  const int dilation_height_factor = params.dilation_height_factor;
+  const int pad_width = params.padding_values.width;
+  const int pad_height = params.padding_values.height;
+  const int32_t input_offset = params.input_offset;
+  const int32_t output_offset = params.output_offset;
+  const int32_t output_activation_min = params.quantized_activation_min;
+  const int32_t output_activation_max = params.quantized_activation_max;
+
+  TFLITE_DCHECK_EQ(input_shape.DimensionsCount(), 4);
+  TFLITE_DCHECK_EQ(filter_shape.DimensionsCount(), 4);
+  TFLITE_DCHECK_EQ(output_shape.DimensionsCount(), 4);
+  TFLITE_DCHECK_LE(output_activation_min, output_activation_max);
+  const int batches = MatchingDim(input_shape, 0, output_shape, 0);
+  const int input_depth = MatchingDim(input_shape, 3, filter_shape, 3);
+  const int output_depth = MatchingDim(filter_shape, 0, output_shape, 3);
+  if (bias_data) {
+    TFLITE_DCHECK_EQ(bias_shape.FlatSize(), output_depth);
+  }
+  const int input_height = input_shape.Dims(1);
+  const int input_width = input_shape.Dims(2);
+  const int filter_height = filter_shape.Dims(1);
+  const int filter_width = filter_shape.Dims(2);
+  const int output_height = output_shape.Dims(1);
+  const int output_width = output_shape.Dims(2);
+  const int filter_size = filter_height * filter_width * input_depth;
+
+  for (int batch = 0; batch < batches; ++batch) {
+    for (int out_y = 0; out_y < output_height; ++out_y) {
+      const int in_y_origin = (out_y * stride_height) - pad_height;
+      int filter_y_start, filter_y_end;
+      GetFilterRange(in_y_origin, dilation_height_factor, filter_height,
+                     input_height, &filter_y_start, &filter_y_end);
+      for (int out_x = 0; out_x < output_width; ++out_x) {
+        const int in_x_origin = (out_x * stride_width) - pad_width;
+        int filter_x_start, filter_x_end;
+        GetFilterRange(in_x_origin, dilation_width_factor, filter_width,
+                       input_width, &filter_x_start, &filter_x_end);
+        const int num_taps_x = filter_x_end - filter_x_start;
+        // The precomputed filter sums only hold when no tap is in the padding.
+        const bool use_filter_sums =
+            filter_sums != nullptr && filter_y_start == 0 &&
+            filter_y_end == filter_height && num_taps_x == filter_width;
+        int8_t* output_ptr =
+            output_data + Offset(output_shape, batch, out_y, out_x, 0);
+        for (int out_channel = 0; out_channel < output_depth; ++out_channel) {
+          const int8_t* filter_ptr = filter_data + out_channel * filter_size;
+          int32_t acc = 0;
+          int32_t filter_sum = 0;
+          for (int filter_y = filter_y_start;
+               filter_y < filter_y_end && num_taps_x > 0; ++filter_y) {
+            const int in_y = in_y_origin + dilation_height_factor * filter_y;
+            const int8_t* input_row =
+                input_data +
+                Offset(input_shape, batch, in_y,
+                       in_x_origin + dilation_width_factor * filter_x_start, 0);
+            const int8_t* filter_row =
+                filter_ptr +
+                (filter_y * filter_width + filter_x_start) * input_depth;
+            if (dilation_width_factor == 1) {
+              // The taps of a filter row are contiguous in the input.
+              const int length = num_taps_x * input_depth;
+              acc += DotProduct(input_row, filter_row, length);
+              if (!use_filter_sums) filter_sum += Sum(filter_row, length);
+            } else {
+              for (int i = 0; i < num_taps_x; ++i) {
+                const int8_t* filter_tap = filter_row + i * input_depth;
+                acc += DotProduct(
+                    input_row + i * dilation_width_factor * input_depth,
+                    filter_tap, input_depth);
+                if (!use_filter_sums) {
+                  filter_sum += Sum(filter_tap, input_depth);
+                }
+              }
+            }
+          }
+          if (use_filter_sums) filter_sum = filter_sums[out_channel];
+          // sum(filter * (input + input_offset)) over the taps in the image.
+          acc += input_offset * filter_sum;
+          if (bias_data) {
+            acc += bias_data[out_channel];
+          }
+          output_ptr[out_channel] = Requantize(
+              acc, output_multiplier[out_channel], output_shift[out_channel],
+              output_offset, output_activation_min, output_activation_max);
+        }
+      }
+    }
+  }
+}
+
+void DepthwiseConvPerChannel(
+    const DepthwiseParams& params, const int32_t* output_multiplier,
+    const int32_t* output_shift, const RuntimeShape& input_shape,
+    const int8_t* input_data, const RuntimeShape& filter_shape,
+    const int8_t* filter_data, const RuntimeShape& bias_shape,
+    const int32_t* bias_data, const RuntimeShape& output_shape,
+    int8_t* output_data) {
+  const int stride_width = params.stride_width;
+  const int stride_height = params.stride_height;
+  const int dilation_width_factor = params.dilation_width_factor;
+  const int dilation_height_factor = params.dilation_height_factor;
+  const int pad_width = params.padding_values.width;
+  const int pad_height = params.padding_values.height;
+  const int32_t input_offset = params.input_offset;
+  const int32_t output_offset = params.output_offset;
+  const int32_t output_activation_min = params.quantized_activation_min;
+  const int32_t output_activation_max = params.quantized_activation_max;
+
+  TFLITE_DCHECK_EQ(params.depth_multiplier, 1);
+  TFLITE_DCHECK_EQ(input_shape.DimensionsCount(), 4);
+  TFLITE_DCHECK_EQ(filter_shape.DimensionsCount(), 4);
+  TFLITE_DCHECK_EQ(output_shape.DimensionsCount(), 4);
+  TFLITE_DCHECK_LE(output_activation_min, output_activation_max);
+  const int batches = MatchingDim(input_shape, 0, output_shape, 0);
+  const int depth = MatchingDim(filter_shape, 3, output_shape, 3);
+  TFLITE_DCHECK_EQ(input_shape.Dims(3), depth);
+  TFLITE_DCHECK_EQ(bias_shape.FlatSize(), depth);
+  const int input_height = input_shape.Dims(1);
+  const int input_width = input_shape.Dims(2);
+  const int filter_height = filter_shape.Dims(1);
+  const int filter_width = filter_shape.Dims(2);
+  const int output_height = output_shape.Dims(1);
+  const int output_width = output_shape.Dims(2);
+
+  int32_t acc[kChannelBlock];
+  for (int batch = 0; batch < batches; ++batch) {
+    for (int out_y = 0; out_y < output_height; ++out_y) {
+      const int in_y_origin = (out_y * stride_height) - pad_height;
+      int filter_y_start, filter_y_end;
+      GetFilterRange(in_y_origin, dilation_height_factor, filter_height,
+                     input_height, &filter_y_start, &filter_y_end);
+      for (int out_x = 0; out_x < output_width; ++out_x) {
+        const int in_x_origin = (out_x * stride_width) - pad_width;
+        int filter_x_start, filter_x_end;
+        GetFilterRange(in_x_origin, dilation_width_factor, filter_width,
+                       input_width, &filter_x_start, &filter_x_end);
+        int8_t* output_ptr =
+            output_data + Offset(output_shape, batch, out_y, out_x, 0);
+        for (int channel = 0; channel < depth; channel += kChannelBlock) {
+          const int num_channels = std::min(kChannelBlock, depth - channel);
+          for (int i = 0; i < num_channels; ++i) {
+            acc[i] = bias_data ? bias_data[channel + i] : 0;
+          }
+          for (int filter_y = filter_y_start; filter_y < filter_y_end;
+               ++filter_y) {
+            const int in_y = in_y_origin + dilation_height_factor * filter_y;
+            for (int filter_x = filter_x_start; filter_x < filter_x_end;
+                 ++filter_x) {
+              const int in_x = in_x_origin + dilation_width_factor * filter_x;
+              MultiplyAccumulate(
+                  input_data + Offset(input_shape, batch, in_y, in_x, channel),
+                  input_offset,
+                  filter_data +
+                      Offset(filter_shape, 0, filter_y, filter_x, channel),
+                  num_channels, acc);
+            }
+          }
+          for (int i = 0; i < num_channels; ++i) {
+            output_ptr[channel + i] = Requantize(
+                acc[i], output_multiplier[channel + i],
+                output_shift[channel + i], output_offset,
+                output_activation_min, output_activation_max);
+          }
+        }
+      }
+    }
+  }
+}
+
+void FullyConnected(const FullyConnectedParams& params,
+                    const int32_t* filter_sums, const RuntimeShape& input_shape,
+                    const int8_t* input_data, const RuntimeShape& filter_shape,
+                    const int8_t* filter_data, const RuntimeShape& bias_shape,
+                    const int32_t* bias_data, const RuntimeShape& output_shape,
+                    int8_t* output_data) {
+  const int32_t input_offset = params.input_offset;
+  const int32_t output_offset = params.output_offset;
+  const int32_t output_multiplier = params.output_multiplier;
+  const int output_shift = params.output_shift;
+  const int32_t output_activation_min = params.quantized_activation_min;
+  const int32_t output_activation_max = params.quantized_activation_max;
+  TFLITE_DCHECK_EQ(params.weights_offset, 0);
+  TFLITE_DCHECK_GE(filter_shape.DimensionsCount(), 2);
+  TFLITE_DCHECK_EQ(output_shape.DimensionsCount(), 2);
+  TFLITE_DCHECK_LE(output_activation_min, output_activation_max);
+  const int filter_dim_count = filter_shape.DimensionsCount();
+  const int batches = output_shape.Dims(0);
+  const int output_depth = output_shape.Dims(1);
+  TFLITE_DCHECK_LE(output_depth, filter_shape.Dims(filter_dim_count - 2));
+  const int accum_depth = filter_shape.Dims(filter_dim_count - 1);
+
+  for (int b = 0; b < batches; ++b) {
+    const int8_t* input_ptr = input_data + b * accum_depth;
+    for (int out_c = 0; out_c < output_depth; ++out_c) {
+      const int8_t* filter_ptr = filter_data + out_c * accum_depth;
+      int32_t acc = DotProduct(input_ptr, filter_ptr, accum_depth);
+      acc += input_offset * (filter_sums ? filter_sums[out_c]
+                                         : Sum(filter_ptr, accum_depth));
+      if (bias_data) {
+        acc += bias_data[out_c];
+      }
+      output_data[out_c + output_depth * b] =
+          Requantize(acc, output_multiplier, output_shift, output_offset,
+                     output_activation_min, output_activation_max);
+    }
+  }
+}
+
+void AveragePool(const PoolParams& params, const RuntimeShape& input_shape,
+                 const int8_t* input_data, const RuntimeShape& output_shape,
+                 int8_t* output_data) {
+  TFLITE_DCHECK_LE(params.quantized_activation_min,
+                   params.quantized_activation_max);
+  TFLITE_DCHECK_EQ(input_shape.DimensionsCount(), 4);
+  TFLITE_DCHECK_EQ(output_shape.DimensionsCount(), 4);
+  const int batches = MatchingDim(input_shape, 0, output_shape, 0);
+  const int depth = MatchingDim(input_shape, 3, output_shape, 3);
+  const int input_height = input_shape.Dims(1);
+  const int input_width = input_shape.Dims(2);
+  const int output_height = output_shape.Dims(1);
+  const int output_width = output_shape.Dims(2);
+
+  int32_t acc[kChannelBlock];
+  for (int batch = 0; batch < batches; ++batch) {
+    for (int out_y = 0; out_y < output_height; ++out_y) {
+      const int in_y_origin =
+          (out_y * params.stride_height) - params.padding_values.height;
+      int filter_y_start, filter_y_end;
+      GetFilterRange(in_y_origin, 1, params.filter_height, input_height,
+                     &filter_y_start, &filter_y_end);
+      for (int out_x = 0; out_x < output_width; ++out_x) {
+        const int in_x_origin =
+            (out_x * params.stride_width) - params.padding_values.width;
+        int filter_x_start, filter_x_end;
+        GetFilterRange(in_x_origin, 1, params.filter_width, input_width,
+                       &filter_x_start, &filter_x_end);
+        const int filter_count =
+            (filter_y_end - filter_y_start) * (filter_x_end - filter_x_start);
+        int8_t* output_ptr =
+            output_data + Offset(output_shape, batch, out_y, out_x, 0);
+        for (int channel = 0; channel < depth; channel += kChannelBlock) {
+          const int num_channels = std::min(kChannelBlock, depth - channel);
+          std::fill(acc, acc + num_channels, 0);
+          for (int filter_y = filter_y_start; filter_y < filter_y_end;
+               ++filter_y) {
+            for (int filter_x = filter_x_start; filter_x < filter_x_end;
+                 ++filter_x) {
+              const int8_t* input_ptr =
+                  input_data + Offset(input_shape, batch,
+                                      in_y_origin + filter_y,
+                                      in_x_origin + filter_x, channel);
+              for (int i = 0; i < num_channels; ++i) {
+                acc[i] += input_ptr[i];
+              }
+            }
+          }
+          for (int i = 0; i < num_channels; ++i) {
+            // Round to the closest integer value.
+            int32_t average =
+                acc[i] > 0 ? (acc[i] + filter_count / 2) / filter_count
+                           : (acc[i] - filter_count / 2) / filter_count;
+            average = std::max(average, params.quantized_activation_min);
+            average = std::min(average, params.quantized_activation_max);
+            output_ptr[channel + i] = static_cast<int8_t>(average);
+          }
+        }
+      }
+    }
+  }
+}
+
+void MaxPool(const PoolParams& params, const RuntimeShape& input_shape,
+             const int8_t* input_data, const RuntimeShape& output_shape,
+             int8_t* output_data) {
+  TFLITE_DCHECK_LE(params.quantized_activation_min,
+                   params.quantized_activation_max);
+  TFLITE_DCHECK_GE(params.quantized_activation_min,
+                   std::numeric_limits<int8_t>::min());
+  TFLITE_DCHECK_LE(params.quantized_activation_max,
+                   std::numeric_limits<int8_t>::max());
+  TFLITE_DCHECK_EQ(input_shape.DimensionsCount(), 4);
+  TFLITE_DCHECK_EQ(output_shape.DimensionsCount(), 4);
+  const int batches = MatchingDim(input_shape, 0, output_shape, 0);
+  const int depth = MatchingDim(input_shape, 3, output_shape, 3);
+  const int input_height = input_shape.Dims(1);
+  const int input_width = input_shape.Dims(2);
+  const int output_height = output_shape.Dims(1);
+  const int output_width = output_shape.Dims(2);
+  const int8_t activation_min =
+      static_cast<int8_t>(params.quantized_activation_min);
+  const int8_t activation_max =
+      static_cast<int8_t>(params.quantized_activation_max);
+
+  for (int batch = 0; batch < batches; ++batch) {
+    for (int out_y = 0; out_y < output_height; ++out_y) {
+      const int in_y_origin =
+          (out_y * params.stride_height) - params.padding_values.height;
+      int filter_y_start, filter_y_end;
+      GetFilterRange(in_y_origin, 1, params.filter_height, input_height,
+                     &filter_y_start, &filter_y_end);
+      for (int out_x = 0; out_x < output_width; ++out_x) {
+        const int in_x_origin =
+            (out_x * params.stride_width) - params.padding_values.width;
+        int filter_x_start, filter_x_end;
+        GetFilterRange(in_x_origin, 1, params.filter_width, input_width,
+                       &filter_x_start, &filter_x_end);
+        // The output pixel is the accumulator of the maximums.
+        int8_t* output_ptr =
+            output_data + Offset(output_shape, batch, out_y, out_x, 0);
+        std::fill(output_ptr, output_ptr + depth,
+                  std::numeric_limits<int8_t>::lowest());
+        for (int filter_y = filter_y_start; filter_y < filter_y_end;
+             ++filter_y) {
+          for (int filter_x = filter_x_start; filter_x < filter_x_end;
+               ++filter_x) {
+            const int8_t* input_ptr =
+                input_data + Offset(input_shape, batch, in_y_origin + filter_y,
+                                    in_x_origin + filter_x, 0);
+            for (int channel = 0; channel < depth; ++channel) {
+              output_ptr[channel] =
+                  std::max(output_ptr[channel], input_ptr[channel]);
+            }
+          }
+        }
+        for (int channel = 0; channel < depth; ++channel) {
+          output_ptr[channel] = std::min(
+              std::max(output_ptr[channel], activation_min), activation_max);
+        }
+      }
+    }
+  }
+}
+
+}  // namespace riscv_nn
+}  // namespace tflite
@@ -0,0 +1,89 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_MICRO_KERNELS_RISCV_NN_RISCV_NN_H_
+#define TENSORFLOW_LITE_MICRO_KERNELS_RISCV_NN_RISCV_NN_H_
+
+#include <cstdint>
+
+#include "tensorflow/lite/kernels/internal/types.h"
+
+// Int8 kernels for RISC-V cores, in the spirit of CMSIS-NN. The inner loops
+// run over contiguous channels, and use the vector extension intrinsics when
+// the compiler provides them (e.g. -march=rv32imacv). Otherwise they are plain
+// loops the compiler can map to the packed SIMD instructions of the core.
+//
+// The results match the reference_integer_ops kernels bit for bit.
+
+namespace tflite {
+namespace riscv_nn {
+
+// Returns the sum of a[i] * b[i] for i in [0, length).
+int32_t DotProduct(const int8_t* a, const int8_t* b, int length);
+
+// Returns the sum of a[i] for i in [0, length).
+int32_t Sum(const int8_t* a, int length);
+
+// Adds (input[i] + input_offset) * filter[i] to acc[i] for i in [0, length).
+void MultiplyAccumulate(const int8_t* input, int32_t input_offset,
+                        const int8_t* filter, int length, int32_t* acc);
+
+// Computes the sum of each of the `num_filters` consecutive filters of
+// `filter_size` values, which lets the kernels fold the input offset in after
+// the dot products.
+void ComputeFilterSums(const int8_t* filter_data, int num_filters,
+                       int filter_size, int32_t* filter_sums);
+
+// Same as reference_integer_ops::ConvPerChannel. The `filter_sums` of the
+// output channels may be null, in which case they are computed on the fly.
+void ConvPerChannel(const ConvParams& params, const int32_t* output_multiplier,
+                    const int32_t* output_shift, const int32_t* filter_sums,
+                    const RuntimeShape& input_shape, const int8_t* input_data,
+                    const RuntimeShape& filter_shape, const int8_t* filter_data,
+                    const RuntimeShape& bias_shape, const int32_t* bias_data,
+                    const RuntimeShape& output_shape, int8_t* output_data);
+
+// Same as reference_integer_ops::DepthwiseConvPerChannel, for a depth
+// multiplier of 1 only.
+void DepthwiseConvPerChannel(
+    const DepthwiseParams& params, const int32_t* output_multiplier,
+    const int32_t* output_shift, const RuntimeShape& input_shape,
+    const int8_t* input_data, const RuntimeShape& filter_shape,
+    const int8_t* filter_data, const RuntimeShape& bias_shape,
+    const int32_t* bias_data, const RuntimeShape& output_shape,
+    int8_t* output_data);
+
+// Same as reference_integer_ops::FullyConnected, for a weights offset of 0
+// only. The `filter_sums` may be null as for ConvPerChannel.
+void FullyConnected(const FullyConnectedParams& params,
+                    const int32_t* filter_sums, const RuntimeShape& input_shape,
+                    const int8_t* input_data, const RuntimeShape& filter_shape,
+                    const int8_t* filter_data, const RuntimeShape& bias_shape,
+                    const int32_t* bias_data, const RuntimeShape& output_shape,
+                    int8_t* output_data);
+
+// Same as reference_integer_ops::AveragePool.
+void AveragePool(const PoolParams& params, const RuntimeShape& input_shape,
+                 const int8_t* input_data, const RuntimeShape& output_shape,
+                 int8_t* output_data);
+
+// Same as reference_integer_ops::MaxPool.
+void MaxPool(const PoolParams& params, const RuntimeShape& input_shape,
+             const int8_t* input_data, const RuntimeShape& output_shape,
+             int8_t* output_data);
+
+}  // namespace riscv_nn
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_KERNELS_RISCV_NN_RISCV_NN_H_
@@ -367,6 +367,59 @@ TfLiteStatus CreatePlan(ErrorReporter* error_reporter,
   return kTfLiteOk;
 }
 
+// Returns whether all the buffers to allocate have offline planned offsets, in
+// which case they are placed without running a memory planner.
+bool IsFullyOfflinePlanned(const AllocationInfo* allocation_info,
+                           size_t allocation_info_size) {
+  for (size_t i = 0; i < allocation_info_size; ++i) {
+    const AllocationInfo* current = &allocation_info[i];
+    if (current->needs_allocating &&
+        current->offline_offset == kOnlinePlannedBuffer) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Calculates the arena size needed by a fully offline planned allocation.
+TfLiteStatus GetOfflinePlanSize(ErrorReporter* error_reporter,
+                                const AllocationInfo* allocation_info,
+                                size_t allocation_info_size,
+                                size_t* arena_size) {
+  *arena_size = 0;
+  for (size_t i = 0; i < allocation_info_size; ++i) {
+    const AllocationInfo* current = &allocation_info[i];
+    if (current->needs_allocating) {
+      if (current->offline_offset < 0 ||
+          current->offline_offset % kBufferAlignment != 0) {
+        TF_LITE_REPORT_ERROR(error_reporter,
+                             "Offline planned offset %d of tensor %d is not a "
+                             "non-negative multiple of %d",
+                             current->offline_offset, i, kBufferAlignment);
+        return kTfLiteError;
+      }
+      const size_t end = current->offline_offset +
+                         AlignSizeUp(current->bytes, kBufferAlignment);
+      if (end > *arena_size) {
+        *arena_size = end;
+      }
+    }
+  }
+  return kTfLiteOk;
+}
+
+void CommitOfflinePlan(uint8_t* starting_point,
+                       const AllocationInfo* allocation_info,
+                       size_t allocation_info_size) {
+  for (size_t i = 0; i < allocation_info_size; ++i) {
+    const AllocationInfo* current = &allocation_info[i];
+    if (current->needs_allocating) {
+      *current->output_ptr =
+          reinterpret_cast<void*>(starting_point + current->offline_offset);
+    }
+  }
+}
+
 TfLiteStatus CommitPlan(ErrorReporter* error_reporter, MemoryPlanner* planner,
                         uint8_t* starting_point,
                         const AllocationInfo* allocation_info,
@@ -735,6 +788,20 @@ void* MicroAllocator::GetScratchBuffer(int buffer_idx) const {
   return scratch_buffer_handles_[scratch_buffer_count_ - buffer_idx - 1].data;
 }
 
+size_t MicroAllocator::GetScratchBufferBytes(int node_id) const {
+  size_t bytes = 0;
+  for (size_t i = 0; i < scratch_buffer_count_; ++i) {
+    if (scratch_buffer_handles_[i].node_idx == node_id) {
+      bytes += scratch_buffer_handles_[i].bytes;
+    }
+  }
+  return bytes;
+}
+
+size_t MicroAllocator::GetTempUsedBytes() const {
+  return memory_allocator_->GetTempUsedBytes();
+}
+
 size_t MicroAllocator::used_bytes() const {
   return memory_allocator_->GetUsedBytes();
 }
@@ -1039,6 +1106,26 @@ TfLiteStatus MicroAllocator::CommitStaticMemoryPlan(
     TF_LITE_ENSURE_STATUS(builder.AddScratchBuffers(scratch_buffer_handles_));
     const AllocationInfo* allocation_info = builder.Finish();
 
+    // Models planned offline by a host tool don't need the memory planner,
+    // unless their kernels request scratch buffers, which are planned online.
+    if (IsFullyOfflinePlanned(allocation_info, builder.Size())) {
+      TF_LITE_ENSURE_STATUS(GetOfflinePlanSize(error_reporter_, allocation_info,
+                                               builder.Size(), &head_usage));
+      const size_t available_arena_size =
+          memory_allocator_->GetAvailableMemory(kBufferAlignment);
+      if (head_usage > available_arena_size) {
+        TF_LITE_REPORT_ERROR(
+            error_reporter_,
+            "Arena size is too small for activation buffers. Needed %d but "
+            "only %d was available.",
+            head_usage, available_arena_size);
+        return kTfLiteError;
+      }
+      CommitOfflinePlan(memory_allocator_->GetBufferHead(), allocation_info,
+                        builder.Size());
+      return memory_allocator_->EnsureHeadSize(head_usage, kBufferAlignment);
+    }
+
     // Remaining arena size that memory planner can use for calculating offsets.
     size_t remaining_arena_size =
         tmp_allocator.GetAvailableMemory(kBufferAlignment);
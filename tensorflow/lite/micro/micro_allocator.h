@@ -160,6 +160,9 @@ class MicroAllocator {
   // This method only allocates a BufferHandle holding information for memory
   // planning. The buffer ptr is ready after `FinishModelAllocation` and can
   // be retrieved by `GetScratchBuffer` method using the returned buffer_idx.
+  // The buffer is only live while the Node is invoked, so the memory planner
+  // shares it with the scratch buffers of the other Nodes and with the
+  // tensors that are not live at that time.
   // Note that there should be no tail allocation between two consecutive
   // `RequestScratchBufferInArena` calls.
   TfLiteStatus RequestScratchBufferInArena(int node_id, size_t bytes,
@@ -167,6 +170,14 @@ class MicroAllocator {
   // Returns the pointer to the planned scratch buffer.
   void* GetScratchBuffer(int buffer_idx) const;
 
+  // Returns the total size in bytes of the scratch buffers requested by the
+  // Node with `node_id`.
+  size_t GetScratchBufferBytes(int node_id) const;
+
+  // Returns the size in bytes of the current chain of temp allocations, i.e.
+  // the temp memory used since the last `ResetTempAllocations` call.
+  size_t GetTempUsedBytes() const;
+
   // Returns the arena usage in bytes, only available after
   // `FinishModelAllocation`. Otherwise, it will return 0.
   size_t used_bytes() const;
@@ -307,6 +307,56 @@ TF_LITE_MICRO_TEST(TestMockModelAllocation) {
                                                        /*count=*/2);
 }
 
+TF_LITE_MICRO_TEST(TestScratchBuffersOfDifferentNodesShareMemory) {
+  const tflite::Model* model = tflite::testing::GetSimpleMockModel();
+  TfLiteEvalTensor* eval_tensors = nullptr;
+  tflite::AllOpsResolver op_resolver = tflite::testing::GetOpResolver();
+  tflite::NodeAndRegistration* node_and_registration;
+  constexpr size_t arena_size = 4096;
+  uint8_t arena[arena_size];
+  tflite::MicroAllocator* allocator =
+      tflite::MicroAllocator::Create(arena, arena_size, micro_test::reporter);
+  TF_LITE_MICRO_EXPECT(nullptr != allocator);
+  TF_LITE_MICRO_EXPECT_EQ(
+      kTfLiteOk,
+      allocator->StartModelAllocation(model, op_resolver,
+                                      &node_and_registration, &eval_tensors));
+
+  // Two scratch buffers for the first operator and one for the second, all
+  // larger than the tensors of the model so they are planned first.
+  constexpr size_t scratch_bytes = 1024;
+  int node0_buffer0 = -1;
+  int node0_buffer1 = -1;
+  int node1_buffer0 = -1;
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk, allocator->RequestScratchBufferInArena(
+                                         0, scratch_bytes, &node0_buffer0));
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk, allocator->RequestScratchBufferInArena(
+                                         0, scratch_bytes, &node0_buffer1));
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk, allocator->RequestScratchBufferInArena(
+                                         1, scratch_bytes, &node1_buffer0));
+  TF_LITE_MICRO_EXPECT_EQ(
+      kTfLiteOk, allocator->FinishModelAllocation(model, eval_tensors));
+
+  uint8_t* node0_data0 =
+      static_cast<uint8_t*>(allocator->GetScratchBuffer(node0_buffer0));
+  uint8_t* node0_data1 =
+      static_cast<uint8_t*>(allocator->GetScratchBuffer(node0_buffer1));
+  uint8_t* node1_data0 =
+      static_cast<uint8_t*>(allocator->GetScratchBuffer(node1_buffer0));
+  TF_LITE_MICRO_EXPECT(nullptr != node0_data0);
+  TF_LITE_MICRO_EXPECT(nullptr != node0_data1);
+  TF_LITE_MICRO_EXPECT(nullptr != node1_data0);
+
+  // The buffers of the same operator are live at the same time.
+  TF_LITE_MICRO_EXPECT(node0_data0 + scratch_bytes <= node0_data1 ||
+                       node0_data1 + scratch_bytes <= node0_data0);
+  // The buffer of the second operator reuses the memory of the first one.
+  TF_LITE_MICRO_EXPECT(node1_data0 == node0_data0 ||
+                       node1_data0 == node0_data1);
+  TF_LITE_MICRO_EXPECT_LE(allocator->used_bytes(),
+                          2 * scratch_bytes + 856 + 100);
+}
+
 TF_LITE_MICRO_TEST(TestMultiTenantAllocation) {
   // The `OpResolver` is shared among different models in this test for
   // simplicity but in practice you could have different `OpResolver`.
@@ -653,6 +703,50 @@ TF_LITE_MICRO_TEST(OfflinePlannerOfflineOnline) {
   TF_LITE_MICRO_EXPECT_EQ(0, eval_tensors[3].data.uint8 - start);
 }
 
+TF_LITE_MICRO_TEST(OfflinePlannerMisalignedOffset) {
+  constexpr int nbr_tensors = 3;
+  tflite::AllOpsResolver op_resolver = tflite::testing::GetOpResolver();
+  tflite::NodeAndRegistration* node_and_registration;
+  const int32_t metadata_buffer[tflite::testing::kOfflinePlannerHeaderSize +
+                                nbr_tensors] = {
+      1, 0, nbr_tensors,  // header: version, subgraph, nbr tensors
+      // memory offsets:
+      0,    // t0
+      56,   // t1
+      0};   // t2
+
+  int t0 = 0;
+  int t1 = 1;
+  int t2 = 2;
+
+  int num_conns = 2;
+  tflite::testing::NodeConnection node_list[2] = {{
+                                                      {t0},  // input
+                                                      {t1}   // output
+                                                  },
+                                                  {
+                                                      {t1},  // input
+                                                      {t2}   // output
+                                                  }};
+
+  const tflite::Model* model = tflite::testing::GetModelWithOfflinePlanning(
+      nbr_tensors, metadata_buffer, node_list, num_conns);
+
+  TfLiteEvalTensor* eval_tensors = nullptr;
+  constexpr size_t arena_size = 4096;
+  uint8_t arena[arena_size];
+  tflite::MicroAllocator* allocator =
+      tflite::MicroAllocator::Create(arena, arena_size, micro_test::reporter);
+
+  TF_LITE_MICRO_EXPECT_EQ(
+      kTfLiteOk,
+      allocator->StartModelAllocation(model, op_resolver,
+                                      &node_and_registration, &eval_tensors));
+  // The fully offline planned buffers must be aligned like the planned ones.
+  TF_LITE_MICRO_EXPECT_EQ(
+      kTfLiteError, allocator->FinishModelAllocation(model, eval_tensors));
+}
+
 TF_LITE_MICRO_TEST(TestAllocatePersistentTfLiteTensor) {
   const tflite::Model* model = tflite::GetModel(kTestConvModelData);
   constexpr size_t arena_size = 1024 * 12;
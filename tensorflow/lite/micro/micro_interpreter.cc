@@ -26,6 +26,7 @@ limitations under the License.
 #include "tensorflow/lite/micro/micro_allocator.h"
 #include "tensorflow/lite/micro/micro_op_resolver.h"
 #include "tensorflow/lite/micro/micro_profiler.h"
+#include "tensorflow/lite/micro/micro_time.h"
 #include "tensorflow/lite/schema/schema_generated.h"
 
 namespace tflite {
@@ -340,8 +341,22 @@ TfLiteStatus MicroInterpreter::Invoke() {
           reinterpret_cast<tflite::Profiler*>(context_.profiler);
       ScopedOperatorProfile scoped_profiler(
           profiler, OpNameFromRegistration(registration), i);
+#endif
+#ifdef TF_LITE_MICRO_OP_TRACE
+      const int32_t start_ticks =
+          op_tracer_ != nullptr ? GetCurrentTimeTicks() : 0;
 #endif
       invoke_status = registration->invoke(&context_, node);
+#ifdef TF_LITE_MICRO_OP_TRACE
+      if (op_tracer_ != nullptr) {
+        // The temp allocations of the kernel are still live, so their size is
+        // its high-water mark.
+        op_tracer_->Record(i, registration->builtin_code,
+                           GetCurrentTimeTicks() - start_ticks,
+                           allocator_.GetScratchBufferBytes(i),
+                           allocator_.GetTempUsedBytes());
+      }
+#endif
 
       // All TfLiteTensor structs used in the kernel are allocated from temp
       // memory in the allocator. This creates a chain of allocations in the
@@ -25,6 +25,7 @@ limitations under the License.
 #include "tensorflow/lite/kernels/internal/tensor_ctypes.h"
 #include "tensorflow/lite/micro/micro_allocator.h"
 #include "tensorflow/lite/micro/micro_op_resolver.h"
+#include "tensorflow/lite/micro/micro_op_tracer.h"
 #include "tensorflow/lite/schema/schema_generated.h"
 #include "tensorflow/lite/type_to_tflitetype.h"
 
@@ -104,6 +105,11 @@ class MicroInterpreter {
   // TODO(b/149795762): Add this to the TfLiteStatus enum.
   TfLiteStatus Invoke();
 
+  // Records each operator run by Invoke() in `tracer`, or stops recording if
+  // it is null. The tracer must outlive its use by the interpreter. This is a
+  // no-op unless TF_LITE_MICRO_OP_TRACE is defined, see micro_op_tracer.h.
+  void SetOpTracer(MicroOpTracer* tracer) { op_tracer_ = tracer; }
+
   size_t tensors_size() const { return context_.tensors_size; }
   TfLiteTensor* tensor(size_t tensor_index);
   template <class T>
@@ -201,6 +207,8 @@ class MicroInterpreter {
   // TfLiteEvalTensor buffers.
   TfLiteTensor* input_tensor_;
   TfLiteTensor* output_tensor_;
+
+  MicroOpTracer* op_tracer_ = nullptr;
 };
 
 }  // namespace tflite
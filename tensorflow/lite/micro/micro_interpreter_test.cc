@@ -376,6 +376,30 @@ TF_LITE_MICRO_TEST(InterpreterWithProfilerShouldProfileOps) {
 #endif
 }
 
+TF_LITE_MICRO_TEST(InterpreterWithOpTracerShouldTraceOps) {
+  const tflite::Model* model = tflite::testing::GetComplexMockModel();
+  TF_LITE_MICRO_EXPECT_NE(nullptr, model);
+
+  tflite::AllOpsResolver op_resolver = tflite::testing::GetOpResolver();
+
+  constexpr size_t allocator_buffer_size = 2048;
+  uint8_t allocator_buffer[allocator_buffer_size];
+  tflite::MicroInterpreter interpreter(model, op_resolver, allocator_buffer,
+                                       allocator_buffer_size,
+                                       micro_test::reporter);
+  uint8_t trace_buffer[256];
+  tflite::MicroOpTracer tracer(trace_buffer, sizeof(trace_buffer));
+  interpreter.SetOpTracer(&tracer);
+
+  TF_LITE_MICRO_EXPECT_EQ(interpreter.AllocateTensors(), kTfLiteOk);
+  TF_LITE_MICRO_EXPECT_EQ(interpreter.Invoke(), kTfLiteOk);
+#ifdef TF_LITE_MICRO_OP_TRACE
+  TF_LITE_MICRO_EXPECT_EQ(static_cast<size_t>(3), tracer.num_records());
+#else  // The tracing is compiled out.
+  TF_LITE_MICRO_EXPECT_EQ(static_cast<size_t>(0), tracer.num_records());
+#endif
+}
+
 TF_LITE_MICRO_TEST(TestIncompleteInitializationAllocationsWithSmallArena) {
   const tflite::Model* model = tflite::testing::GetComplexMockModel();
   TF_LITE_MICRO_EXPECT_NE(nullptr, model);
@@ -0,0 +1,88 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/micro/micro_op_tracer.h"
+
+#include <cstring>
+
+#include "tensorflow/lite/micro/micro_time.h"
+
+namespace tflite {
+namespace {
+
+// The fields are copied one by one since the buffer isn't necessarily aligned.
+template <typename T>
+uint8_t* Write(uint8_t* dest, T value) {
+  std::memcpy(dest, &value, sizeof(T));
+  return dest + sizeof(T);
+}
+
+uint32_t Saturate(size_t value) {
+  return value > UINT32_MAX ? UINT32_MAX : static_cast<uint32_t>(value);
+}
+
+}  // namespace
+
+constexpr uint32_t MicroOpTracer::kMagic;
+constexpr uint16_t MicroOpTracer::kVersion;
+constexpr size_t MicroOpTracer::kHeaderSize;
+constexpr size_t MicroOpTracer::kRecordSize;
+
+MicroOpTracer::MicroOpTracer(uint8_t* buffer, size_t buffer_size)
+    : buffer_(buffer), buffer_size_(buffer_size) {
+  Reset();
+}
+
+void MicroOpTracer::Record(int op_index, int32_t builtin_code, int32_t ticks,
+                           size_t scratch_bytes, size_t temp_bytes) {
+  if (buffer_size_ < kHeaderSize ||
+      (buffer_size_ - kHeaderSize) / kRecordSize <= num_records_) {
+    ++num_dropped_records_;
+  } else {
+    uint8_t* record = buffer_ + kHeaderSize + num_records_ * kRecordSize;
+    record = Write(record, static_cast<uint16_t>(op_index));
+    record = Write(record, static_cast<uint16_t>(builtin_code));
+    record = Write(record, ticks);
+    record = Write(record, Saturate(scratch_bytes));
+    Write(record, Saturate(temp_bytes));
+    ++num_records_;
+  }
+  WriteCounts();
+}
+
+void MicroOpTracer::Reset() {
+  num_records_ = 0;
+  num_dropped_records_ = 0;
+  if (buffer_size_ < kHeaderSize) return;
+  uint8_t* header = Write(buffer_, kMagic);
+  header = Write(header, kVersion);
+  header = Write(header, static_cast<uint16_t>(kRecordSize));
+  Write(header, ticks_per_second());
+  WriteCounts();
+}
+
+size_t MicroOpTracer::trace_size() const {
+  return buffer_size_ < kHeaderSize ? 0
+                                    : kHeaderSize + num_records_ * kRecordSize;
+}
+
+void MicroOpTracer::WriteCounts() {
+  if (buffer_size_ < kHeaderSize) return;
+  uint8_t* counts = buffer_ + kHeaderSize - 2 * sizeof(uint32_t);
+  counts = Write(counts, Saturate(num_records_));
+  Write(counts, Saturate(num_dropped_records_));
+}
+
+}  // namespace tflite
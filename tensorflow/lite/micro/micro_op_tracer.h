@@ -0,0 +1,84 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LITE_MICRO_MICRO_OP_TRACER_H_
+#define TENSORFLOW_LITE_MICRO_MICRO_OP_TRACER_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace tflite {
+
+// MicroOpTracer records a compact binary trace of the operators run by a
+// MicroInterpreter: the ticks of GetCurrentTimeTicks() each invocation took,
+// the bytes of its planned scratch buffers and the high-water mark of its temp
+// allocations. The trace is written to a caller provided buffer, which can be
+// dumped to the host and turned into a per-layer report with
+// tensorflow/lite/tools/micro_op_trace_report.py.
+//
+// The tracing code of the interpreter is only compiled in when
+// TF_LITE_MICRO_OP_TRACE is defined (e.g. OP_TRACE=true with make), so it
+// costs nothing otherwise.
+//
+// Usage example:
+// uint8_t trace_buffer[1024];
+// MicroOpTracer tracer(trace_buffer, sizeof(trace_buffer));
+// interpreter.SetOpTracer(&tracer);
+// interpreter.Invoke();
+// DumpToHost(tracer.trace(), tracer.trace_size());
+//
+// The trace is a header followed by one record per operator invocation, all
+// fields in the byte order of the device:
+//   Header: uint32 magic ("TFOT"), uint16 version, uint16 record size,
+//           int32 ticks per second, uint32 records, uint32 dropped records.
+//   Record: uint16 operator index, uint16 builtin code, int32 ticks,
+//           uint32 scratch bytes, uint32 temp bytes.
+// The records not fitting in the buffer are dropped, and only counted.
+class MicroOpTracer {
+ public:
+  static constexpr uint32_t kMagic = 0x544F4654;
+  static constexpr uint16_t kVersion = 1;
+  static constexpr size_t kHeaderSize = 20;
+  static constexpr size_t kRecordSize = 16;
+
+  // The buffer must outlive the tracer. A buffer smaller than the header
+  // records nothing.
+  MicroOpTracer(uint8_t* buffer, size_t buffer_size);
+
+  // Appends the record of an operator invocation.
+  void Record(int op_index, int32_t builtin_code, int32_t ticks,
+              size_t scratch_bytes, size_t temp_bytes);
+
+  // Drops all the records.
+  void Reset();
+
+  const uint8_t* trace() const { return buffer_; }
+  // The size in bytes of the header and the records.
+  size_t trace_size() const;
+  size_t num_records() const { return num_records_; }
+  size_t num_dropped_records() const { return num_dropped_records_; }
+
+ private:
+  void WriteCounts();
+
+  uint8_t* buffer_;
+  size_t buffer_size_;
+  size_t num_records_ = 0;
+  size_t num_dropped_records_ = 0;
+};
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_MICRO_OP_TRACER_H_
@@ -0,0 +1,94 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/micro/micro_op_tracer.h"
+
+#include <cstdint>
+#include <cstring>
+
+#include "tensorflow/lite/micro/micro_time.h"
+#include "tensorflow/lite/micro/testing/micro_test.h"
+
+namespace {
+
+template <typename T>
+T Read(const uint8_t* trace, size_t offset) {
+  T value;
+  std::memcpy(&value, trace + offset, sizeof(T));
+  return value;
+}
+
+}  // namespace
+
+TF_LITE_MICRO_TESTS_BEGIN
+
+TF_LITE_MICRO_TEST(TestTraceLayout) {
+  uint8_t buffer[tflite::MicroOpTracer::kHeaderSize +
+                 2 * tflite::MicroOpTracer::kRecordSize];
+  tflite::MicroOpTracer tracer(buffer, sizeof(buffer));
+  TF_LITE_MICRO_EXPECT_EQ(tflite::MicroOpTracer::kHeaderSize,
+                          tracer.trace_size());
+
+  tracer.Record(/*op_index=*/1, /*builtin_code=*/3, /*ticks=*/1000,
+                /*scratch_bytes=*/64, /*temp_bytes=*/32);
+  TF_LITE_MICRO_EXPECT_EQ(static_cast<size_t>(1), tracer.num_records());
+  TF_LITE_MICRO_EXPECT_EQ(sizeof(buffer) - tflite::MicroOpTracer::kRecordSize,
+                          tracer.trace_size());
+
+  const uint8_t* trace = tracer.trace();
+  TF_LITE_MICRO_EXPECT_EQ(0, std::memcmp(trace, "TFOT", 4));
+  TF_LITE_MICRO_EXPECT_EQ(1, Read<uint16_t>(trace, 4));
+  TF_LITE_MICRO_EXPECT_EQ(16, Read<uint16_t>(trace, 6));
+  TF_LITE_MICRO_EXPECT_EQ(tflite::ticks_per_second(), Read<int32_t>(trace, 8));
+  TF_LITE_MICRO_EXPECT_EQ(1u, Read<uint32_t>(trace, 12));
+  TF_LITE_MICRO_EXPECT_EQ(0u, Read<uint32_t>(trace, 16));
+  TF_LITE_MICRO_EXPECT_EQ(1, Read<uint16_t>(trace, 20));
+  TF_LITE_MICRO_EXPECT_EQ(3, Read<uint16_t>(trace, 22));
+  TF_LITE_MICRO_EXPECT_EQ(1000, Read<int32_t>(trace, 24));
+  TF_LITE_MICRO_EXPECT_EQ(64u, Read<uint32_t>(trace, 28));
+  TF_LITE_MICRO_EXPECT_EQ(32u, Read<uint32_t>(trace, 32));
+}
+
+TF_LITE_MICRO_TEST(TestRecordsNotFittingAreDropped) {
+  uint8_t buffer[tflite::MicroOpTracer::kHeaderSize +
+                 tflite::MicroOpTracer::kRecordSize];
+  tflite::MicroOpTracer tracer(buffer, sizeof(buffer));
+  tracer.Record(0, 0, 10, 0, 0);
+  tracer.Record(1, 0, 20, 0, 0);
+  tracer.Record(2, 0, 30, 0, 0);
+  TF_LITE_MICRO_EXPECT_EQ(static_cast<size_t>(1), tracer.num_records());
+  TF_LITE_MICRO_EXPECT_EQ(static_cast<size_t>(2),
+                          tracer.num_dropped_records());
+  TF_LITE_MICRO_EXPECT_EQ(sizeof(buffer), tracer.trace_size());
+  TF_LITE_MICRO_EXPECT_EQ(2u, Read<uint32_t>(tracer.trace(), 16));
+
+  tracer.Reset();
+  TF_LITE_MICRO_EXPECT_EQ(static_cast<size_t>(0), tracer.num_records());
+  TF_LITE_MICRO_EXPECT_EQ(static_cast<size_t>(0),
+                          tracer.num_dropped_records());
+  TF_LITE_MICRO_EXPECT_EQ(0u, Read<uint32_t>(tracer.trace(), 12));
+}
+
+TF_LITE_MICRO_TEST(TestBufferSmallerThanHeader) {
+  uint8_t buffer[4];
+  tflite::MicroOpTracer tracer(buffer, sizeof(buffer));
+  tracer.Record(0, 0, 10, 0, 0);
+  TF_LITE_MICRO_EXPECT_EQ(static_cast<size_t>(0), tracer.num_records());
+  TF_LITE_MICRO_EXPECT_EQ(static_cast<size_t>(1),
+                          tracer.num_dropped_records());
+  TF_LITE_MICRO_EXPECT_EQ(static_cast<size_t>(0), tracer.trace_size());
+}
+
+TF_LITE_MICRO_TESTS_END
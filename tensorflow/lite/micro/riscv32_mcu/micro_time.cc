@@ -0,0 +1,34 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// RISC-V implementation of the timer functions, which counts the cycles of the
+// core. This lets the MicroProfiler report the cycles taken by each kernel.
+#include "tensorflow/lite/micro/micro_time.h"
+
+namespace tflite {
+
+// The clock frequency of the core depends on the board, so the cycles can't be
+// converted to seconds here.
+int32_t ticks_per_second() { return 0; }
+
+int32_t GetCurrentTimeTicks() {
+  // The low 32 bits of the cycle counter, which wrap around the same way as
+  // the ticks of the other platforms.
+  uint32_t cycles;
+  asm volatile("rdcycle %0" : "=r"(cycles));
+  return static_cast<int32_t>(cycles);
+}
+
+}  // namespace tflite
@@ -133,6 +133,10 @@ size_t SimpleMemoryAllocator::GetHeadUsedBytes() const {
   return head_ - buffer_head_;
 }
 
+size_t SimpleMemoryAllocator::GetTempUsedBytes() const {
+  return temp_ - head_;
+}
+
 size_t SimpleMemoryAllocator::GetTailUsedBytes() const {
   return buffer_tail_ - tail_;
 }
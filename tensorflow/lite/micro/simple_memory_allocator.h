@@ -75,6 +75,8 @@ class SimpleMemoryAllocator {
 
   size_t GetHeadUsedBytes() const;
   size_t GetTailUsedBytes() const;
+  // Returns the number of bytes of the current chain of temp allocations.
+  size_t GetTempUsedBytes() const;
 
   // Returns the number of bytes available with a given alignment.
   size_t GetAvailableMemory(size_t alignment) const;
@@ -179,6 +179,22 @@ TF_LITE_MICRO_TEST(TestResetTempAllocations) {
   TF_LITE_MICRO_EXPECT_EQ(temp2 - temp1, 0);
 }
 
+TF_LITE_MICRO_TEST(TestTempUsedBytes) {
+  constexpr size_t arena_size = 1024;
+  uint8_t arena[arena_size];
+  tflite::SimpleMemoryAllocator allocator(micro_test::reporter, arena,
+                                          arena_size);
+  TF_LITE_MICRO_EXPECT_EQ(static_cast<size_t>(0), allocator.GetTempUsedBytes());
+
+  TF_LITE_MICRO_EXPECT(nullptr != allocator.AllocateTemp(100, 1));
+  TF_LITE_MICRO_EXPECT(nullptr != allocator.AllocateTemp(50, 1));
+  TF_LITE_MICRO_EXPECT_EQ(static_cast<size_t>(150),
+                          allocator.GetTempUsedBytes());
+
+  allocator.ResetTempAllocations();
+  TF_LITE_MICRO_EXPECT_EQ(static_cast<size_t>(0), allocator.GetTempUsedBytes());
+}
+
 TF_LITE_MICRO_TEST(TestEnsureHeadSizeWithoutResettingTemp) {
   constexpr size_t arena_size = 1024;
   uint8_t arena[arena_size];
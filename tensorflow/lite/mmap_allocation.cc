@@ -19,6 +19,8 @@ limitations under the License.
 #include <sys/types.h>
 #include <unistd.h>
 
+#include <cstdint>
+
 #include "tensorflow/lite/allocation.h"
 #include "tensorflow/lite/core/api/error_reporter.h"
 
@@ -57,6 +59,29 @@ size_t MMAPAllocation::bytes() const { return buffer_size_bytes_; }
 
 bool MMAPAllocation::valid() const { return mmapped_buffer_ != MAP_FAILED; }
 
+void MMAPAllocation::PageIn(const void* data, size_t size) const {
+  if (!valid() || size == 0) return;
+  // Rounds the range out to whole pages.
+  const uintptr_t page_size = sysconf(_SC_PAGESIZE);
+  const uintptr_t start = reinterpret_cast<uintptr_t>(data) & ~(page_size - 1);
+  const uintptr_t end = reinterpret_cast<uintptr_t>(data) + size;
+  madvise(reinterpret_cast<void*>(start), end - start, MADV_WILLNEED);
+}
+
+void MMAPAllocation::Evict(const void* data, size_t size) const {
+  if (!valid()) return;
+  // Only frees the pages wholly in the range, the others may hold bytes still
+  // in use. The mapping is read-only, so its pages are read from the file
+  // again if they are used afterwards.
+  const uintptr_t page_size = sysconf(_SC_PAGESIZE);
+  const uintptr_t start =
+      (reinterpret_cast<uintptr_t>(data) + page_size - 1) & ~(page_size - 1);
+  const uintptr_t end =
+      (reinterpret_cast<uintptr_t>(data) + size) & ~(page_size - 1);
+  if (end <= start) return;
+  madvise(reinterpret_cast<void*>(start), end - start, MADV_DONTNEED);
+}
+
 bool MMAPAllocation::IsSupported() { return true; }
 
 }  // namespace tflite
@@ -35,6 +35,10 @@ size_t MMAPAllocation::bytes() const { return 0; }
 
 bool MMAPAllocation::valid() const { return false; }
 
+void MMAPAllocation::PageIn(const void* data, size_t size) const {}
+
+void MMAPAllocation::Evict(const void* data, size_t size) const {}
+
 bool MMAPAllocation::IsSupported() { return false; }
 
 }  // namespace tflite
@@ -176,6 +176,15 @@ class NnApiHandler {
         };
   }
 
+  template <int Value>
+  void MemoryCreateFromAHardwareBufferReturns() {
+    nnapi_->ANeuralNetworksMemory_createFromAHardwareBuffer =
+        [](const AHardwareBuffer* ahwb, ANeuralNetworksMemory** memory) {
+          *memory = reinterpret_cast<ANeuralNetworksMemory*>(2);
+          return Value;
+        };
+  }
+
   template <int Value>
   void CompilationCreateReturns() {
     nnapi_->ANeuralNetworksCompilation_create =
@@ -18,6 +18,7 @@ limitations under the License.
 #include <algorithm>
 #include <cstring>
 #include <limits>
+#include <utility>
 #include <vector>
 
 namespace {
@@ -84,6 +85,39 @@ TfLiteStatus SimpleMemoryArena::Allocate(
   return kTfLiteOk;
 }
 
+bool SimpleMemoryArena::AllocateAt(size_t alignment, size_t offset,
+                                   size_t size, int32_t tensor,
+                                   int32_t first_node, int32_t last_node,
+                                   ArenaAllocWithUsageInterval* new_alloc) {
+  if (alignment > arena_alignment_ || AlignTo(alignment, offset) != offset) {
+    return false;
+  }
+  for (const auto& alloc : ordered_allocs_) {
+    if (alloc.last_node < first_node || alloc.first_node > last_node) {
+      continue;
+    }
+    if (alloc.offset < offset + size && offset < alloc.offset + alloc.size) {
+      return false;
+    }
+  }
+  new_alloc->tensor = tensor;
+  new_alloc->first_node = first_node;
+  new_alloc->last_node = last_node;
+  new_alloc->size = size;
+  new_alloc->offset = size == 0 ? 0 : offset;
+  if (size == 0) {
+    return true;
+  }
+  high_water_mark_ = std::max(high_water_mark_, offset + size);
+
+  auto insertion_it = ordered_allocs_.begin();
+  while (insertion_it != ordered_allocs_.end() && *insertion_it < *new_alloc) {
+    ++insertion_it;
+  }
+  ordered_allocs_.insert(insertion_it, *new_alloc);
+  return true;
+}
+
 TfLiteStatus SimpleMemoryArena::Deallocate(
     TfLiteContext* context, const ArenaAllocWithUsageInterval& alloc) {
   if (alloc.size == 0) {
@@ -106,7 +140,8 @@ TfLiteStatus SimpleMemoryArena::Deallocate(
 
 TfLiteStatus SimpleMemoryArena::Commit(TfLiteContext* context) {
   size_t required_size = RequiredBufferSize();
-  if (required_size > underlying_buffer_size_) {
+  ArenaBuffer& buffer = *buffer_;
+  if (required_size > buffer.size) {
     char* new_alloc = new char[required_size];
     char* new_underlying_buffer_aligned_ptr = reinterpret_cast<char*>(
         AlignTo(arena_alignment_, reinterpret_cast<intptr_t>(new_alloc)));
@@ -114,21 +149,22 @@ TfLiteStatus SimpleMemoryArena::Commit(TfLiteContext* context) {
     // If the arena had been previously allocated, copy over the old memory.
     // Since Alloc pointers are offset based, they will remain valid in the new
     // memory block.
-    if (high_water_mark_ > 0 && underlying_buffer_size_ > 0) {
+    if (high_water_mark_ > 0 && buffer.size > 0) {
       size_t copy_amount = std::min(
-          underlying_buffer_.get() + underlying_buffer_size_ -
-              underlying_buffer_aligned_ptr_,
+          buffer.buffer.get() + buffer.size - buffer.aligned_ptr,
           new_alloc + required_size - new_underlying_buffer_aligned_ptr);
-      memcpy(new_underlying_buffer_aligned_ptr, underlying_buffer_aligned_ptr_,
+      memcpy(new_underlying_buffer_aligned_ptr, buffer.aligned_ptr,
              copy_amount);
     }
 
-    underlying_buffer_.reset(new_alloc);
-    underlying_buffer_size_ = required_size;
-    underlying_buffer_aligned_ptr_ = new_underlying_buffer_aligned_ptr;
+    buffer.buffer.reset(new_alloc);
+    buffer.size = required_size;
+    buffer.aligned_ptr = new_underlying_buffer_aligned_ptr;
+    ++buffer.generation;
   }
   committed_ = true;
-  return underlying_buffer_ != nullptr ? kTfLiteOk : kTfLiteError;
+  committed_generation_ = buffer.generation;
+  return buffer.buffer != nullptr ? kTfLiteOk : kTfLiteError;
 }
 
 TfLiteStatus SimpleMemoryArena::ResolveAlloc(
@@ -136,12 +172,11 @@ TfLiteStatus SimpleMemoryArena::ResolveAlloc(
     char** output_ptr) {
   TF_LITE_ENSURE(context, committed_);
   TF_LITE_ENSURE(context, output_ptr != nullptr);
-  TF_LITE_ENSURE(context,
-                 underlying_buffer_size_ >= (alloc.offset + alloc.size));
+  TF_LITE_ENSURE(context, buffer_->size >= (alloc.offset + alloc.size));
   if (alloc.size == 0) {
     *output_ptr = nullptr;
   } else {
-    *output_ptr = underlying_buffer_aligned_ptr_ + alloc.offset;
+    *output_ptr = buffer_->aligned_ptr + alloc.offset;
   }
   return kTfLiteOk;
 }
@@ -155,10 +190,23 @@ TfLiteStatus SimpleMemoryArena::ClearPlan() {
 
 TfLiteStatus SimpleMemoryArena::ReleaseBuffer() {
   committed_ = false;
-  underlying_buffer_size_ = 0;
-  underlying_buffer_aligned_ptr_ = nullptr;
-  underlying_buffer_.reset();
+  committed_generation_ = -1;
+  if (buffer_.use_count() == 1) {
+    buffer_->size = 0;
+    buffer_->aligned_ptr = nullptr;
+    buffer_->buffer.reset();
+    ++buffer_->generation;
+  }
   return kTfLiteOk;
 }
 
+void SimpleMemoryArena::ShareBuffer(std::shared_ptr<ArenaBuffer> buffer) {
+  if (buffer_ == buffer) {
+    return;
+  }
+  committed_ = false;
+  committed_generation_ = -1;
+  buffer_ = std::move(buffer);
+}
+
 }  // namespace tflite
@@ -52,6 +52,16 @@ struct ArenaAllocWithUsageInterval {
   }
 };
 
+// The underlying buffer of one or more SimpleMemoryArenas.
+struct ArenaBuffer {
+  std::unique_ptr<char[]> buffer;
+  size_t size = 0;
+  char* aligned_ptr = nullptr;
+  // Incremented each time the buffer is reallocated, which invalidates the
+  // allocations resolved into it by the arenas sharing it.
+  int64_t generation = 0;
+};
+
 // This small class is responsible for allocating, deallocating and reusing
 // dynamic memory from a common underlying buffer. The arena can be used in
 // scenarios when the pattern of memory allocations and deallocations is
@@ -63,7 +73,8 @@ class SimpleMemoryArena {
       : committed_(false),
         arena_alignment_(arena_alignment),
         high_water_mark_(0),
-        underlying_buffer_size_(0),
+        buffer_(std::make_shared<ArenaBuffer>()),
+        committed_generation_(-1),
         ordered_allocs_() {}
 
   // Schedule memory allocation for a tensor with a given size, assuming that it
@@ -73,6 +84,15 @@ class SimpleMemoryArena {
                         int32_t tensor, int32_t first_node, int32_t last_node,
                         ArenaAllocWithUsageInterval* new_alloc);
 
+  // Schedules the memory allocation for a tensor like Allocate, but at the
+  // given `offset` of the arena, e.g. one planned ahead of time. Returns false
+  // and leaves `new_alloc` untouched if `offset` is not aligned to `alignment`
+  // or the memory at `offset` is used by an allocation whose usage interval
+  // intersects [first_node, last_node].
+  bool AllocateAt(size_t alignment, size_t offset, size_t size, int32_t tensor,
+                  int32_t first_node, int32_t last_node,
+                  ArenaAllocWithUsageInterval* new_alloc);
+
   TfLiteStatus Deallocate(TfLiteContext* context,
                           const ArenaAllocWithUsageInterval& alloc);
 
@@ -96,22 +116,38 @@ class SimpleMemoryArena {
 
   // This releases the underlying buffer but does not clear the allocation plan.
   // Since all associated pointers are invalidated, the arena cannot be used
-  // again until Commit() is called & tensor allocations are resolved.
+  // again until Commit() is called & tensor allocations are resolved. A buffer
+  // shared with other arenas is only freed along with the last of them.
   TfLiteStatus ReleaseBuffer();
 
-  size_t GetBufferSize() { return underlying_buffer_size_; }
+  // Makes the arena use `buffer` as its underlying buffer, and drops its own.
+  // The buffer is grown to the largest of the sizes the arenas sharing it
+  // need. These arenas overwrite each other's allocations, so they may only be
+  // used one at a time, and each of them must be committed again before it's
+  // used after any other was (see HasCurrentBuffer).
+  void ShareBuffer(std::shared_ptr<ArenaBuffer> buffer);
+
+  // Returns whether the arena's allocations resolve into the current
+  // underlying buffer: the arena was committed, and its buffer was neither
+  // released since nor reallocated by an arena sharing it.
+  bool HasCurrentBuffer() const {
+    return buffer_->size != 0 && committed_generation_ == buffer_->generation;
+  }
+
+  size_t GetBufferSize() { return buffer_->size; }
 
   std::intptr_t BasePointer() const {
-    return reinterpret_cast<std::intptr_t>(underlying_buffer_aligned_ptr_);
+    return reinterpret_cast<std::intptr_t>(buffer_->aligned_ptr);
   }
 
  private:
   bool committed_;
   size_t arena_alignment_;
   size_t high_water_mark_;
-  std::unique_ptr<char[]> underlying_buffer_;
-  size_t underlying_buffer_size_;
-  char* underlying_buffer_aligned_ptr_;
+  std::shared_ptr<ArenaBuffer> buffer_;
+  // The generation of `buffer_` at the last Commit(), or -1 if the buffer was
+  // released or replaced since.
+  int64_t committed_generation_;
   std::vector<ArenaAllocWithUsageInterval> ordered_allocs_;
 };
 
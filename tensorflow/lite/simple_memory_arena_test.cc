@@ -44,6 +44,63 @@ TEST(SimpleMemoryArenaTest, BasicArenaOperations) {
   EXPECT_EQ(allocs[5].offset, 2048);
 }
 
+TEST(SimpleMemoryArenaTest, AllocateAt) {
+  TfLiteContext context;
+  SimpleMemoryArena arena(64);
+  ArenaAllocWithUsageInterval allocs[4];
+
+  ASSERT_TRUE(arena.AllocateAt(32, 4096, 1023, 0, 0, 2, &allocs[0]));
+  arena.Allocate(&context, 32, 2047, 1, 1, 3, &allocs[1]);
+  arena.Allocate(&context, 32, 2047, 2, 1, 2, &allocs[2]);
+  EXPECT_EQ(allocs[0].offset, 4096);
+  EXPECT_EQ(allocs[1].offset, 0);
+  EXPECT_EQ(allocs[2].offset, 2048);
+
+  // The memory is in use at that time.
+  EXPECT_FALSE(arena.AllocateAt(32, 4096, 16, 3, 1, 1, &allocs[3]));
+  // The offset is not aligned.
+  EXPECT_FALSE(arena.AllocateAt(32, 4100, 16, 3, 3, 3, &allocs[3]));
+  ASSERT_TRUE(arena.AllocateAt(32, 4096, 16, 3, 3, 3, &allocs[3]));
+  EXPECT_EQ(allocs[3].offset, 4096);
+}
+
+TEST(SimpleMemoryArenaTest, SharedBuffer) {
+  TfLiteContext context;
+  context.ReportError = ReportError;
+  SimpleMemoryArena arena1(64);
+  SimpleMemoryArena arena2(64);
+  auto buffer = std::make_shared<ArenaBuffer>();
+  arena1.ShareBuffer(buffer);
+  arena2.ShareBuffer(buffer);
+  ArenaAllocWithUsageInterval alloc1;
+  ArenaAllocWithUsageInterval alloc2;
+
+  arena1.Allocate(&context, 32, 2047, 0, 0, 2, &alloc1);
+  ASSERT_EQ(arena1.Commit(&context), kTfLiteOk);
+  EXPECT_TRUE(arena1.HasCurrentBuffer());
+  EXPECT_FALSE(arena2.HasCurrentBuffer());
+
+  // Growing the buffer for the second arena reallocates it.
+  arena2.Allocate(&context, 32, 8191, 0, 0, 2, &alloc2);
+  ASSERT_EQ(arena2.Commit(&context), kTfLiteOk);
+  EXPECT_TRUE(arena2.HasCurrentBuffer());
+  EXPECT_FALSE(arena1.HasCurrentBuffer());
+  EXPECT_EQ(arena1.BasePointer(), arena2.BasePointer());
+
+  // Committing the first arena again doesn't.
+  ASSERT_EQ(arena1.Commit(&context), kTfLiteOk);
+  EXPECT_TRUE(arena1.HasCurrentBuffer());
+  EXPECT_TRUE(arena2.HasCurrentBuffer());
+
+  // The buffer is kept for the second arena.
+  ASSERT_EQ(arena1.ReleaseBuffer(), kTfLiteOk);
+  EXPECT_FALSE(arena1.HasCurrentBuffer());
+  EXPECT_TRUE(arena2.HasCurrentBuffer());
+  char* resolved_ptr = nullptr;
+  ASSERT_EQ(arena2.ResolveAlloc(&context, alloc2, &resolved_ptr), kTfLiteOk);
+  EXPECT_EQ(resolved_ptr, reinterpret_cast<char*>(arena2.BasePointer()));
+}
+
 TEST(SimpleMemoryArenaTest, BasicZeroAlloc) {
   TfLiteContext context;
   SimpleMemoryArena arena(64);
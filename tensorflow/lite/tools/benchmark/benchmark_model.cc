@@ -218,7 +218,10 @@ TfLiteStatus BenchmarkModel::Run() {
   listeners_.OnBenchmarkEnd({model_size_mb, startup_latency_us, input_bytes,
                              warmup_time_us, inference_time_us, init_mem_usage,
                              overall_mem_usage});
-  return status;
+  if (status != kTfLiteOk) {
+    return status;
+  }
+  return RunThroughputBenchmark();
 }
 
 TfLiteStatus BenchmarkModel::ParseFlags(int* argc, char** argv) {
@@ -212,6 +212,10 @@ class BenchmarkModel {
 
   virtual TfLiteStatus ResetInputsAndOutputs();
   virtual TfLiteStatus RunImpl() = 0;
+
+  // Benchmarks the throughput of concurrent runs of the model, after the
+  // latency benchmark, if the subclass supports it.
+  virtual TfLiteStatus RunThroughputBenchmark() { return kTfLiteOk; }
   BenchmarkParams params_;
   BenchmarkListeners listeners_;
 };
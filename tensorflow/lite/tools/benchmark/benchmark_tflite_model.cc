@@ -22,6 +22,7 @@ limitations under the License.
 #include <iostream>
 #include <memory>
 #include <random>
+#include <sstream>
 #include <string>
 #include <unordered_set>
 #include <vector>
@@ -34,8 +35,10 @@ limitations under the License.
 #include "tensorflow/lite/kernels/register.h"
 #include "tensorflow/lite/model.h"
 #include "tensorflow/lite/op_resolver.h"
+#include "tensorflow/lite/profiling/memory_info.h"
 #include "tensorflow/lite/profiling/platform_profiler.h"
 #include "tensorflow/lite/profiling/profile_summary_formatter.h"
+#include "tensorflow/lite/profiling/time.h"
 #include "tensorflow/lite/string_util.h"
 #include "tensorflow/lite/tools/benchmark/benchmark_utils.h"
 #include "tensorflow/lite/tools/benchmark/profiling_listener.h"
@@ -61,6 +64,38 @@ constexpr int kOpProfilingEnabledDefault = true;
 constexpr int kOpProfilingEnabledDefault = false;
 #endif
 
+// Logs the time and memory taken by each stage of the initialization.
+class StartupBreakdown {
+ public:
+  StartupBreakdown()
+      : stage_start_us_(profiling::time::NowMicros()),
+        stage_start_mem_usage_(profiling::memory::GetMemoryUsage()) {}
+
+  // Logs the stage ending now, which started at the end of the previous one.
+  void EndStage(const std::string& stage) {
+    const int64_t now_us = profiling::time::NowMicros();
+    const auto mem_usage = profiling::memory::GetMemoryUsage();
+    if (profiling::memory::MemoryUsage::IsSupported()) {
+      const auto stage_mem_usage = mem_usage - stage_start_mem_usage_;
+      TFLITE_LOG(INFO) << stage << " took " << (now_us - stage_start_us_) / 1e3
+                       << "ms, max resident set size grew by "
+                       << stage_mem_usage.max_rss_kb / 1024.0
+                       << "MB, heap in use by "
+                       << stage_mem_usage.in_use_allocated_bytes / 1e6
+                       << "MB.";
+    } else {
+      TFLITE_LOG(INFO) << stage << " took " << (now_us - stage_start_us_) / 1e3
+                       << "ms.";
+    }
+    stage_start_us_ = now_us;
+    stage_start_mem_usage_ = mem_usage;
+  }
+
+ private:
+  int64_t stage_start_us_;
+  profiling::memory::MemoryUsage stage_start_mem_usage_;
+};
+
 // Dumps platform-wide tracing files via a platform-based profiler that's built
 // upon platform tracing tools, like ATrace on Android etc.
 class PlatformProfilingListener : public BenchmarkListener {
@@ -262,6 +297,8 @@ BenchmarkParams BenchmarkTfLiteModel::DefaultParams() {
   default_params.AddParam("allow_fp16", BenchmarkParam::Create<bool>(false));
   default_params.AddParam("require_full_delegation",
                           BenchmarkParam::Create<bool>(false));
+  default_params.AddParam("page_in_weights",
+                          BenchmarkParam::Create<bool>(false));
   default_params.AddParam(
       "enable_op_profiling",
       BenchmarkParam::Create<bool>(kOpProfilingEnabledDefault));
@@ -271,6 +308,15 @@ BenchmarkParams BenchmarkTfLiteModel::DefaultParams() {
                           BenchmarkParam::Create<std::string>(""));
   default_params.AddParam("enable_platform_tracing",
                           BenchmarkParam::Create<bool>(false));
+  default_params.AddParam("num_interpreters",
+                          BenchmarkParam::Create<int32_t>(0));
+  default_params.AddParam("num_request_threads",
+                          BenchmarkParam::Create<int32_t>(1));
+  default_params.AddParam("request_rate", BenchmarkParam::Create<float>(0.0f));
+  default_params.AddParam("num_requests",
+                          BenchmarkParam::Create<int32_t>(1000));
+  default_params.AddParam("throughput_output_json",
+                          BenchmarkParam::Create<std::string>(""));
 
   for (const auto& delegate_provider :
        tools::GetRegisteredDelegateProviders()) {
@@ -325,6 +371,10 @@ std::vector<Flag> BenchmarkTfLiteModel::GetFlags() {
       CreateFlag<bool>("allow_fp16", &params_, "allow fp16"),
       CreateFlag<bool>("require_full_delegation", &params_,
                        "require delegate to run the entire graph"),
+      CreateFlag<bool>("page_in_weights", &params_,
+                       "read the pages of the weights ahead of the first run, "
+                       "and free those of the weights only read at "
+                       "initialization"),
       CreateFlag<bool>("enable_op_profiling", &params_, "enable op profiling"),
       CreateFlag<int32_t>("max_profiling_buffer_entries", &params_,
                           "max profiling buffer entries"),
@@ -334,7 +384,25 @@ std::vector<Flag> BenchmarkTfLiteModel::GetFlags() {
           "prints to stdout."),
       CreateFlag<bool>("enable_platform_tracing", &params_,
                        "enable platform-wide tracing, only meaningful when "
-                       "--enable_op_profiling is set to true.")};
+                       "--enable_op_profiling is set to true."),
+      CreateFlag<int32_t>(
+          "num_interpreters", &params_,
+          "if positive, the number of interpreters serving concurrent "
+          "requests in a throughput benchmark run after the latency one"),
+      CreateFlag<int32_t>("num_request_threads", &params_,
+                          "number of threads issuing the requests of the "
+                          "throughput benchmark"),
+      CreateFlag<float>(
+          "request_rate", &params_,
+          "mean number of requests per second of the throughput benchmark, "
+          "arriving as a Poisson process. If not positive, each thread "
+          "issues its next request when the previous one completes."),
+      CreateFlag<int32_t>("num_requests", &params_,
+                          "number of requests of the throughput benchmark"),
+      CreateFlag<std::string>(
+          "throughput_output_json", &params_,
+          "File path to export the throughput benchmark results to as JSON, "
+          "if not set logs them.")};
 
   flags.insert(flags.end(), specific_flags.begin(), specific_flags.end());
 
@@ -363,6 +431,7 @@ void BenchmarkTfLiteModel::LogParams() {
   LOG_BENCHMARK_PARAM(bool, "allow_fp16", "Allow fp16", verbose);
   LOG_BENCHMARK_PARAM(bool, "require_full_delegation",
                       "Require full delegation", verbose);
+  LOG_BENCHMARK_PARAM(bool, "page_in_weights", "Page in weights", verbose);
   LOG_BENCHMARK_PARAM(bool, "enable_op_profiling", "Enable op profiling",
                       verbose);
   LOG_BENCHMARK_PARAM(int32_t, "max_profiling_buffer_entries",
@@ -371,6 +440,15 @@ void BenchmarkTfLiteModel::LogParams() {
                       "CSV File to export profiling data to", verbose);
   LOG_BENCHMARK_PARAM(bool, "enable_platform_tracing",
                       "Enable platform-wide tracing", verbose);
+  LOG_BENCHMARK_PARAM(int32_t, "num_interpreters",
+                      "Num interpreters of the throughput benchmark", verbose);
+  LOG_BENCHMARK_PARAM(int32_t, "num_request_threads", "Num request threads",
+                      verbose);
+  LOG_BENCHMARK_PARAM(float, "request_rate", "Request rate (per second)",
+                      verbose);
+  LOG_BENCHMARK_PARAM(int32_t, "num_requests", "Num requests", verbose);
+  LOG_BENCHMARK_PARAM(std::string, "throughput_output_json",
+                      "JSON file to export throughput results to", verbose);
 
   for (const auto& delegate_provider :
        tools::GetRegisteredDelegateProviders()) {
@@ -568,11 +646,15 @@ TfLiteStatus BenchmarkTfLiteModel::PrepareInputData() {
 }
 
 TfLiteStatus BenchmarkTfLiteModel::ResetInputsAndOutputs() {
-  auto interpreter_inputs = interpreter_->inputs();
+  return SetInputs(interpreter_.get());
+}
+
+TfLiteStatus BenchmarkTfLiteModel::SetInputs(Interpreter* interpreter) {
+  auto interpreter_inputs = interpreter->inputs();
   // Set the values of the input tensors from inputs_data_.
   for (int j = 0; j < interpreter_inputs.size(); ++j) {
     int i = interpreter_inputs[j];
-    TfLiteTensor* t = interpreter_->tensor(i);
+    TfLiteTensor* t = interpreter->tensor(i);
     if (t->type == kTfLiteString) {
       if (inputs_data_[j].data) {
         static_cast<DynamicBuffer*>(inputs_data_[j].data.get())
@@ -620,8 +702,11 @@ TfLiteStatus BenchmarkTfLiteModel::InitInterpreter() {
 }
 
 TfLiteStatus BenchmarkTfLiteModel::Init() {
+  StartupBreakdown startup;
   TF_LITE_ENSURE_STATUS(LoadModel());
+  startup.EndStage("Loading the model");
   TF_LITE_ENSURE_STATUS(InitInterpreter());
+  startup.EndStage("Building the interpreter");
 
   // Install profilers if necessary right after interpreter is created so that
   // any memory allocations inside the TFLite runtime could be recorded if the
@@ -632,6 +717,7 @@ TfLiteStatus BenchmarkTfLiteModel::Init() {
   interpreter_->SetAllowFp16PrecisionForFp32(params_.Get<bool>("allow_fp16"));
 
   owned_delegates_.clear();
+  delegate_partitions_.clear();
   for (const auto& delegate_provider :
        tools::GetRegisteredDelegateProviders()) {
     auto delegate = delegate_provider->CreateTfLiteDelegate(params_);
@@ -656,6 +742,11 @@ TfLiteStatus BenchmarkTfLiteModel::Init() {
       }
       bool fully_delegated = (num_delegated_kernels == 1 &&
                               interpreter_->execution_plan().size() == 1);
+      DelegatePartition partition;
+      partition.delegate = delegate_provider->GetName();
+      partition.num_delegated_kernels = num_delegated_kernels;
+      partition.num_nodes = interpreter_->execution_plan().size();
+      delegate_partitions_.push_back(partition);
 
       if (params_.Get<bool>("require_full_delegation") && !fully_delegated) {
         TFLITE_LOG(ERROR) << "Disallowed CPU fallback detected.";
@@ -681,6 +772,7 @@ TfLiteStatus BenchmarkTfLiteModel::Init() {
     }
     owned_delegates_.emplace_back(std::move(delegate));
   }
+  startup.EndStage("Applying the delegates");
 
   auto interpreter_inputs = interpreter_->inputs();
 
@@ -717,6 +809,15 @@ TfLiteStatus BenchmarkTfLiteModel::Init() {
     TFLITE_LOG(ERROR) << "Failed to allocate tensors!";
     return kTfLiteError;
   }
+  startup.EndStage("Allocating the tensors");
+
+  if (params_.Get<bool>("page_in_weights")) {
+    if (interpreter_->PageInConstantTensors() != kTfLiteOk) {
+      TFLITE_LOG(ERROR) << "Failed to page in the weights!";
+      return kTfLiteError;
+    }
+    startup.EndStage("Paging in the weights");
+  }
 
   ruy_profiling_listener_.reset(new RuyProfileListener());
   AddListener(ruy_profiling_listener_.get());
@@ -724,6 +825,112 @@ TfLiteStatus BenchmarkTfLiteModel::Init() {
   return kTfLiteOk;
 }
 
+TfLiteStatus BenchmarkTfLiteModel::InitThroughputInterpreter(
+    std::unique_ptr<Interpreter>* interpreter) {
+  auto resolver = GetOpResolver();
+  tflite::InterpreterBuilder(*model_, *resolver)(
+      interpreter, params_.Get<int32_t>("num_threads"));
+  if (!*interpreter) {
+    TFLITE_LOG(ERROR) << "Failed to initialize the interpreter";
+    return kTfLiteError;
+  }
+  (*interpreter)
+      ->SetAllowFp16PrecisionForFp32(params_.Get<bool>("allow_fp16"));
+
+  // Delegates can't be shared by interpreters, so each gets its own.
+  for (const auto& delegate_provider :
+       tools::GetRegisteredDelegateProviders()) {
+    auto delegate = delegate_provider->CreateTfLiteDelegate(params_);
+    if (delegate == nullptr) continue;
+    if ((*interpreter)->ModifyGraphWithDelegate(delegate.get()) != kTfLiteOk) {
+      TFLITE_LOG(ERROR) << "Failed to apply " << delegate_provider->GetName()
+                        << " delegate.";
+      return kTfLiteError;
+    }
+    owned_delegates_.emplace_back(std::move(delegate));
+  }
+
+  const std::vector<int>& interpreter_inputs = (*interpreter)->inputs();
+  for (int j = 0; j < inputs_.size(); ++j) {
+    const int i = interpreter_inputs[j];
+    if ((*interpreter)->tensor(i)->type != kTfLiteString) {
+      (*interpreter)->ResizeInputTensor(i, inputs_[j].shape);
+    }
+  }
+  if ((*interpreter)->AllocateTensors() != kTfLiteOk) {
+    TFLITE_LOG(ERROR) << "Failed to allocate tensors!";
+    return kTfLiteError;
+  }
+  return kTfLiteOk;
+}
+
+TfLiteStatus BenchmarkTfLiteModel::RunThroughputBenchmark() {
+  ThroughputOptions options;
+  options.num_interpreters = params_.Get<int32_t>("num_interpreters");
+  if (options.num_interpreters <= 0) return kTfLiteOk;
+  options.num_threads = params_.Get<int32_t>("num_request_threads");
+  options.request_rate = params_.Get<float>("request_rate");
+  options.num_requests = params_.Get<int32_t>("num_requests");
+  options.max_secs = params_.Get<float>("max_secs");
+  options.seed = random_engine_();
+
+  std::vector<Interpreter*> interpreters = {interpreter_.get()};
+  std::vector<std::unique_ptr<Interpreter>> owned_interpreters;
+  const auto start_mem_usage = profiling::memory::GetMemoryUsage();
+  for (int i = 1; i < options.num_interpreters; ++i) {
+    std::unique_ptr<Interpreter> interpreter;
+    TF_LITE_ENSURE_STATUS(InitThroughputInterpreter(&interpreter));
+    interpreters.push_back(interpreter.get());
+    owned_interpreters.push_back(std::move(interpreter));
+  }
+  // The heap memory taken by each of the interpreters created above, which
+  // share the model.
+  double memory_per_interpreter_mb = -1;
+  if (options.num_interpreters > 1 &&
+      profiling::memory::MemoryUsage::IsSupported()) {
+    const auto mem_usage =
+        profiling::memory::GetMemoryUsage() - start_mem_usage;
+    memory_per_interpreter_mb = mem_usage.in_use_allocated_bytes /
+                                (1024.0 * 1024.0) /
+                                (options.num_interpreters - 1);
+  }
+
+  TFLITE_LOG(INFO) << "Running throughput benchmark of "
+                   << options.num_requests << " requests served by "
+                   << options.num_interpreters << " interpreters on "
+                   << options.num_threads << " threads.";
+  const ThroughputResults results =
+      tflite::benchmark::RunThroughputBenchmark(
+          options, [this, &interpreters](int interpreter_index) {
+            Interpreter* interpreter = interpreters[interpreter_index];
+            TF_LITE_ENSURE_STATUS(SetInputs(interpreter));
+            return interpreter->Invoke();
+          });
+  TFLITE_LOG(INFO) << "Throughput: " << results.qps() << " requests/s, "
+                   << "latency in us: "
+                   << "p50: " << results.LatencyPercentileUs(50) << ", "
+                   << "p90: " << results.LatencyPercentileUs(90) << ", "
+                   << "p99: " << results.LatencyPercentileUs(99) << ", "
+                   << "p99.9: " << results.LatencyPercentileUs(99.9);
+
+  const std::string json_path =
+      params_.Get<std::string>("throughput_output_json");
+  std::stringstream json;
+  WriteThroughputJson(options, results, memory_per_interpreter_mb,
+                      delegate_partitions_, &json);
+  if (json_path.empty()) {
+    TFLITE_LOG(INFO) << json.str();
+  } else {
+    std::ofstream json_file(json_path);
+    json_file << json.str() << std::endl;
+    if (!json_file) {
+      TFLITE_LOG(ERROR) << "Failed to write " << json_path;
+      return kTfLiteError;
+    }
+  }
+  return results.num_failures == 0 ? kTfLiteOk : kTfLiteError;
+}
+
 TfLiteStatus BenchmarkTfLiteModel::LoadModel() {
   std::string graph = params_.Get<std::string>("graph");
   model_ = tflite::FlatBufferModel::BuildFromFile(graph.c_str());
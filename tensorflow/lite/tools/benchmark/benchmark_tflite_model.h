@@ -26,6 +26,7 @@ limitations under the License.
 #include "tensorflow/lite/model.h"
 #include "tensorflow/lite/profiling/profiler.h"
 #include "tensorflow/lite/tools/benchmark/benchmark_model.h"
+#include "tensorflow/lite/tools/benchmark/throughput_benchmark.h"
 
 namespace tflite {
 namespace benchmark {
@@ -67,6 +68,11 @@ class BenchmarkTfLiteModel : public BenchmarkModel {
   TfLiteStatus PrepareInputData() override;
   TfLiteStatus ResetInputsAndOutputs() override;
 
+  // Serves requests with --num_interpreters interpreters, including the one
+  // of the latency benchmark, and reports the throughput and the latency
+  // distribution.
+  TfLiteStatus RunThroughputBenchmark() override;
+
   int64_t MayGetModelFileSize() override;
 
   virtual TfLiteStatus LoadModel();
@@ -118,12 +124,22 @@ class BenchmarkTfLiteModel : public BenchmarkModel {
   InputTensorData LoadInputTensorData(const TfLiteTensor& t,
                                       const std::string& input_file_path);
 
+  // Sets the inputs of `interpreter` from inputs_data_.
+  TfLiteStatus SetInputs(Interpreter* interpreter);
+
+  // Creates another interpreter of the model, with the same delegates and
+  // input shapes as the one of the latency benchmark.
+  TfLiteStatus InitThroughputInterpreter(
+      std::unique_ptr<Interpreter>* interpreter);
+
   std::vector<InputLayerInfo> inputs_;
   std::vector<InputTensorData> inputs_data_;
   std::unique_ptr<BenchmarkListener> profiling_listener_ = nullptr;
   std::unique_ptr<BenchmarkListener> ruy_profiling_listener_ = nullptr;
   std::mt19937 random_engine_;
   std::vector<Interpreter::TfLiteDelegatePtr> owned_delegates_;
+  // The kernels of each delegate applied to interpreter_.
+  std::vector<DelegatePartition> delegate_partitions_;
   // Always TFLITE_LOG the benchmark result.
   BenchmarkLoggingListener log_output_;
 };
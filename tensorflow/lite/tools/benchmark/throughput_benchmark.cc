@@ -0,0 +1,198 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/tools/benchmark/throughput_benchmark.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>  // NOLINT(build/c++11)
+#include <mutex>               // NOLINT(build/c++11)
+#include <random>
+#include <thread>  // NOLINT(build/c++11)
+
+#include "tensorflow/lite/profiling/time.h"
+
+namespace tflite {
+namespace benchmark {
+namespace {
+
+// Hands out the interpreters not running a request.
+class InterpreterPool {
+ public:
+  explicit InterpreterPool(int num_interpreters) {
+    for (int i = num_interpreters - 1; i >= 0; --i) {
+      free_.push_back(i);
+    }
+  }
+
+  int Acquire() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cond_.wait(lock, [this] { return !free_.empty(); });
+    const int interpreter_index = free_.back();
+    free_.pop_back();
+    return interpreter_index;
+  }
+
+  void Release(int interpreter_index) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      free_.push_back(interpreter_index);
+    }
+    cond_.notify_one();
+  }
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  std::vector<int> free_;
+};
+
+void WriteJsonString(const std::string& str, std::ostream* stream) {
+  *stream << '"';
+  for (char c : str) {
+    if (c == '"' || c == '\\') *stream << '\\';
+    *stream << c;
+  }
+  *stream << '"';
+}
+
+}  // namespace
+
+int64_t ThroughputResults::LatencyPercentileUs(double percentile) const {
+  if (latencies_us.empty()) return 0;
+  // The nearest-rank percentile, ignoring the rounding errors of the product.
+  const int64_t rank = static_cast<int64_t>(
+      std::ceil(percentile / 100.0 * latencies_us.size() - 1e-6));
+  const int64_t index = std::min<int64_t>(std::max<int64_t>(rank, 1),
+                                          latencies_us.size()) -
+                        1;
+  return latencies_us[index];
+}
+
+double ThroughputResults::AverageLatencyUs() const {
+  if (latencies_us.empty()) return 0;
+  double sum = 0;
+  for (int64_t latency_us : latencies_us) sum += latency_us;
+  return sum / latencies_us.size();
+}
+
+ThroughputResults RunThroughputBenchmark(
+    const ThroughputOptions& options,
+    const std::function<TfLiteStatus(int interpreter_index)>& invoke) {
+  const bool open_loop = options.request_rate > 0;
+  // The arrival times of the requests, from the start of the benchmark.
+  std::vector<int64_t> arrivals_us;
+  if (open_loop) {
+    std::mt19937 random_engine(options.seed);
+    std::exponential_distribution<double> interval_secs(options.request_rate);
+    double arrival_secs = 0;
+    for (int i = 0; i < options.num_requests; ++i) {
+      arrival_secs += interval_secs(random_engine);
+      arrivals_us.push_back(static_cast<int64_t>(arrival_secs * 1e6));
+    }
+  }
+
+  const int num_threads = std::max(options.num_threads, 1);
+  InterpreterPool pool(std::max(options.num_interpreters, 1));
+  std::atomic<int> next_request(0);
+  std::atomic<int64_t> num_failures(0);
+  std::vector<std::vector<int64_t>> thread_latencies_us(num_threads);
+  const int64_t start_us = profiling::time::NowMicros();
+  const int64_t deadline_us =
+      start_us + static_cast<int64_t>(options.max_secs * 1e6);
+
+  auto serve = [&](int thread_index) {
+    for (int request = next_request++; request < options.num_requests;
+         request = next_request++) {
+      int64_t now_us = profiling::time::NowMicros();
+      int64_t arrival_us = now_us;
+      if (open_loop) {
+        arrival_us = start_us + arrivals_us[request];
+        if (arrival_us > deadline_us) break;
+        if (arrival_us > now_us) {
+          profiling::time::SleepForMicros(arrival_us - now_us);
+        }
+      } else if (now_us > deadline_us) {
+        break;
+      }
+      const int interpreter_index = pool.Acquire();
+      const TfLiteStatus status = invoke(interpreter_index);
+      pool.Release(interpreter_index);
+      if (status != kTfLiteOk) {
+        ++num_failures;
+        continue;
+      }
+      thread_latencies_us[thread_index].push_back(
+          profiling::time::NowMicros() - arrival_us);
+    }
+  };
+  std::vector<std::thread> threads;
+  for (int i = 1; i < num_threads; ++i) {
+    threads.emplace_back(serve, i);
+  }
+  serve(0);
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  ThroughputResults results;
+  results.duration_us = profiling::time::NowMicros() - start_us;
+  results.num_failures = num_failures;
+  for (const auto& latencies_us : thread_latencies_us) {
+    results.latencies_us.insert(results.latencies_us.end(),
+                                latencies_us.begin(), latencies_us.end());
+  }
+  std::sort(results.latencies_us.begin(), results.latencies_us.end());
+  results.num_requests = results.latencies_us.size();
+  return results;
+}
+
+void WriteThroughputJson(const ThroughputOptions& options,
+                         const ThroughputResults& results,
+                         double memory_per_interpreter_mb,
+                         const std::vector<DelegatePartition>& partitions,
+                         std::ostream* stream) {
+  *stream << "{\"num_interpreters\": " << options.num_interpreters
+          << ", \"num_threads\": " << options.num_threads
+          << ", \"request_rate\": " << options.request_rate
+          << ", \"num_requests\": " << results.num_requests
+          << ", \"num_failures\": " << results.num_failures
+          << ", \"duration_us\": " << results.duration_us
+          << ", \"qps\": " << results.qps() << ", \"latency_us\": {"
+          << "\"avg\": " << results.AverageLatencyUs()
+          << ", \"p50\": " << results.LatencyPercentileUs(50)
+          << ", \"p90\": " << results.LatencyPercentileUs(90)
+          << ", \"p99\": " << results.LatencyPercentileUs(99)
+          << ", \"p99.9\": " << results.LatencyPercentileUs(99.9)
+          << ", \"max\": " << results.LatencyPercentileUs(100) << "}";
+  if (memory_per_interpreter_mb >= 0) {
+    *stream << ", \"memory_per_interpreter_mb\": "
+            << memory_per_interpreter_mb;
+  }
+  *stream << ", \"delegate_partitions\": [";
+  for (int i = 0; i < partitions.size(); ++i) {
+    if (i > 0) *stream << ", ";
+    *stream << "{\"delegate\": ";
+    WriteJsonString(partitions[i].delegate, stream);
+    *stream << ", \"num_delegated_kernels\": "
+            << partitions[i].num_delegated_kernels
+            << ", \"num_nodes\": " << partitions[i].num_nodes << "}";
+  }
+  *stream << "]}";
+}
+
+}  // namespace benchmark
+}  // namespace tflite
@@ -0,0 +1,89 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LITE_TOOLS_BENCHMARK_THROUGHPUT_BENCHMARK_H_
+#define TENSORFLOW_LITE_TOOLS_BENCHMARK_THROUGHPUT_BENCHMARK_H_
+
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "tensorflow/lite/c/common.h"
+
+namespace tflite {
+namespace benchmark {
+
+struct ThroughputOptions {
+  // The number of interpreters serving the requests. Each runs one request at
+  // a time.
+  int num_interpreters = 1;
+  // The number of threads issuing the requests.
+  int num_threads = 1;
+  // The mean number of requests arriving per second, as a Poisson process. If
+  // not positive, each thread issues its next request as soon as the previous
+  // one completes instead (closed loop).
+  double request_rate = 0;
+  int num_requests = 100;
+  // The requests not started within `max_secs` are dropped.
+  float max_secs = 150;
+  uint32_t seed = 0;
+};
+
+struct ThroughputResults {
+  int64_t num_requests = 0;
+  int64_t num_failures = 0;
+  int64_t duration_us = 0;
+  // The latencies of the completed requests, from their arrival to their
+  // completion, in increasing order. They include the time waiting for a
+  // thread or an interpreter.
+  std::vector<int64_t> latencies_us;
+
+  double qps() const {
+    return duration_us > 0 ? num_requests * 1e6 / duration_us : 0;
+  }
+  // Returns the latency `percentile` percent of the requests completed within,
+  // or 0 if none completed.
+  int64_t LatencyPercentileUs(double percentile) const;
+  double AverageLatencyUs() const;
+};
+
+// Runs the requests of `options` by calling `invoke` with the index of a free
+// interpreter, from `options.num_threads` threads.
+ThroughputResults RunThroughputBenchmark(
+    const ThroughputOptions& options,
+    const std::function<TfLiteStatus(int interpreter_index)>& invoke);
+
+// How the delegates partition the model graph of each interpreter.
+struct DelegatePartition {
+  std::string delegate;
+  int num_delegated_kernels = 0;
+  // The nodes in the execution plan, including the delegate kernels.
+  int num_nodes = 0;
+};
+
+// Writes `results` as a JSON object, along with the options and the memory
+// footprint of each interpreter, or a negative value if it is unknown.
+void WriteThroughputJson(const ThroughputOptions& options,
+                         const ThroughputResults& results,
+                         double memory_per_interpreter_mb,
+                         const std::vector<DelegatePartition>& partitions,
+                         std::ostream* stream);
+
+}  // namespace benchmark
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_TOOLS_BENCHMARK_THROUGHPUT_BENCHMARK_H_
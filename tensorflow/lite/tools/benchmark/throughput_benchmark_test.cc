@@ -0,0 +1,102 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/tools/benchmark/throughput_benchmark.h"
+
+#include <atomic>
+#include <sstream>
+
+#include <gtest/gtest.h>
+#include "tensorflow/lite/profiling/time.h"
+
+namespace tflite {
+namespace benchmark {
+namespace {
+
+TEST(ThroughputBenchmarkTest, ClosedLoopRunsAllRequests) {
+  ThroughputOptions options;
+  options.num_interpreters = 2;
+  options.num_threads = 4;
+  options.num_requests = 40;
+  // The interpreters must never run two requests at once.
+  std::atomic<int> busy[2];
+  busy[0] = 0;
+  busy[1] = 0;
+  std::atomic<bool> overlapped(false);
+  ThroughputResults results =
+      RunThroughputBenchmark(options, [&](int interpreter_index) {
+        if (busy[interpreter_index]++ != 0) overlapped = true;
+        profiling::time::SleepForMicros(100);
+        --busy[interpreter_index];
+        return kTfLiteOk;
+      });
+  EXPECT_FALSE(overlapped);
+  EXPECT_EQ(results.num_requests, 40);
+  EXPECT_EQ(results.num_failures, 0);
+  ASSERT_EQ(results.latencies_us.size(), 40);
+  EXPECT_GE(results.LatencyPercentileUs(50), 100);
+  EXPECT_LE(results.LatencyPercentileUs(50), results.LatencyPercentileUs(99));
+  EXPECT_GT(results.qps(), 0);
+}
+
+TEST(ThroughputBenchmarkTest, OpenLoopCountsFailures) {
+  ThroughputOptions options;
+  options.num_requests = 20;
+  options.request_rate = 10000;
+  std::atomic<int> num_invocations(0);
+  ThroughputResults results = RunThroughputBenchmark(options, [&](int) {
+    return num_invocations++ % 2 == 0 ? kTfLiteOk : kTfLiteError;
+  });
+  EXPECT_EQ(num_invocations, 20);
+  EXPECT_EQ(results.num_requests, 10);
+  EXPECT_EQ(results.num_failures, 10);
+}
+
+TEST(ThroughputBenchmarkTest, Percentiles) {
+  ThroughputResults results;
+  EXPECT_EQ(results.LatencyPercentileUs(50), 0);
+  for (int i = 1; i <= 1000; ++i) results.latencies_us.push_back(i);
+  EXPECT_EQ(results.LatencyPercentileUs(50), 500);
+  EXPECT_EQ(results.LatencyPercentileUs(99.9), 999);
+  EXPECT_EQ(results.LatencyPercentileUs(100), 1000);
+  EXPECT_DOUBLE_EQ(results.AverageLatencyUs(), 500.5);
+}
+
+TEST(ThroughputBenchmarkTest, WritesJson) {
+  ThroughputOptions options;
+  ThroughputResults results;
+  results.num_requests = 2;
+  results.duration_us = 1000000;
+  results.latencies_us = {10, 20};
+  DelegatePartition partition;
+  partition.delegate = "XNNPACK";
+  partition.num_delegated_kernels = 1;
+  partition.num_nodes = 3;
+  std::stringstream stream;
+  WriteThroughputJson(options, results, /*memory_per_interpreter_mb=*/-1,
+                      {partition}, &stream);
+  EXPECT_EQ(stream.str(),
+            "{\"num_interpreters\": 1, \"num_threads\": 1, "
+            "\"request_rate\": 0, \"num_requests\": 2, \"num_failures\": 0, "
+            "\"duration_us\": 1000000, \"qps\": 2, \"latency_us\": {"
+            "\"avg\": 15, \"p50\": 10, \"p90\": 20, \"p99\": 20, "
+            "\"p99.9\": 20, \"max\": 20}, "
+            "\"delegate_partitions\": [{\"delegate\": \"XNNPACK\", "
+            "\"num_delegated_kernels\": 1, \"num_nodes\": 3}]}");
+}
+
+}  // namespace
+}  // namespace benchmark
+}  // namespace tflite
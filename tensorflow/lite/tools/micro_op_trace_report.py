@@ -0,0 +1,174 @@
+# Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+r"""Turns a TFLite Micro operator trace into a per-layer report.
+
+The trace is the buffer recorded by tflite::MicroOpTracer on the device, see
+tensorflow/lite/micro/micro_op_tracer.h, dumped either as raw bytes or as hex
+text (e.g. printed on a serial console).
+
+Example usage:
+python micro_op_trace_report.py --trace_file=trace.bin
+"""
+
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+import argparse
+import binascii
+import collections
+import struct
+import sys
+
+from tensorflow.lite.python import schema_py_generated as schema_fb
+from tensorflow.python.platform import app
+
+TRACE_MAGIC = b'TFOT'
+TRACE_VERSION = 1
+# The fields after the magic, and those of a record, as in micro_op_tracer.h.
+# The supported devices are all little-endian.
+_HEADER_FORMAT = '<HHiII'
+_RECORD_FORMAT = '<HHiII'
+_HEADER_SIZE = len(TRACE_MAGIC) + struct.calcsize(_HEADER_FORMAT)
+
+OpRecord = collections.namedtuple(
+    'OpRecord',
+    ['op_index', 'builtin_code', 'ticks', 'scratch_bytes', 'temp_bytes'])
+
+OpSummary = collections.namedtuple('OpSummary', [
+    'op_index', 'builtin_code', 'invocations', 'total_ticks', 'max_ticks',
+    'scratch_bytes', 'temp_bytes'
+])
+
+
+def parse_trace(data):
+  """Parses a trace recorded by MicroOpTracer.
+
+  Args:
+    data: The bytes of the trace.
+
+  Returns:
+    The ticks per second of the device, or 0 if they are unknown, the list of
+    OpRecord in the order the operators ran, and the number of records the
+    device dropped.
+
+  Raises:
+    ValueError: If the data isn't a supported trace.
+  """
+  if len(data) < _HEADER_SIZE or data[:len(TRACE_MAGIC)] != TRACE_MAGIC:
+    raise ValueError('Not a TFLite Micro operator trace')
+  version, record_size, ticks_per_second, num_records, num_dropped = (
+      struct.unpack_from(_HEADER_FORMAT, data, len(TRACE_MAGIC)))
+  if version != TRACE_VERSION:
+    raise ValueError('Unsupported trace version %d' % version)
+  if record_size < struct.calcsize(_RECORD_FORMAT):
+    raise ValueError('Unsupported record size %d' % record_size)
+  if len(data) < _HEADER_SIZE + num_records * record_size:
+    raise ValueError('The trace holds %d records but is truncated' %
+                     num_records)
+  records = [
+      OpRecord(*struct.unpack_from(_RECORD_FORMAT, data,
+                                   _HEADER_SIZE + i * record_size))
+      for i in range(num_records)
+  ]
+  return ticks_per_second, records, num_dropped
+
+
+def summarize(records):
+  """Aggregates the records of each operator, by increasing operator index."""
+  summaries = {}
+  for record in records:
+    summary = summaries.get(record.op_index)
+    if summary is None:
+      summaries[record.op_index] = OpSummary(record.op_index,
+                                             record.builtin_code, 1,
+                                             record.ticks, record.ticks,
+                                             record.scratch_bytes,
+                                             record.temp_bytes)
+    else:
+      summaries[record.op_index] = summary._replace(
+          invocations=summary.invocations + 1,
+          total_ticks=summary.total_ticks + record.ticks,
+          max_ticks=max(summary.max_ticks, record.ticks),
+          scratch_bytes=max(summary.scratch_bytes, record.scratch_bytes),
+          temp_bytes=max(summary.temp_bytes, record.temp_bytes))
+  return [summaries[op_index] for op_index in sorted(summaries)]
+
+
+def builtin_code_to_name(code):
+  for name, value in schema_fb.BuiltinOperator.__dict__.items():
+    if value == code and not name.startswith('_'):
+      return name
+  return str(code)
+
+
+def format_report(ticks_per_second, summaries, num_dropped=0):
+  """Returns the per-layer report of the summaries as a text table."""
+  total_ticks = sum(summary.total_ticks for summary in summaries)
+  lines = []
+  header = ['Op', 'Type', 'Runs', 'Avg ticks', 'Max ticks', '%', 'Scratch B',
+            'Temp B']
+  if ticks_per_second > 0:
+    header.append('Avg us')
+  lines.append(header)
+  for summary in summaries:
+    avg_ticks = summary.total_ticks / summary.invocations
+    row = [
+        str(summary.op_index),
+        builtin_code_to_name(summary.builtin_code),
+        str(summary.invocations),
+        '%.0f' % avg_ticks,
+        str(summary.max_ticks),
+        '%.1f' % (100.0 * summary.total_ticks / total_ticks
+                  if total_ticks else 0.0),
+        str(summary.scratch_bytes),
+        str(summary.temp_bytes),
+    ]
+    if ticks_per_second > 0:
+      row.append('%.1f' % (avg_ticks * 1e6 / ticks_per_second))
+    lines.append(row)
+
+  widths = [max(len(line[i]) for line in lines) for i in range(len(header))]
+  text = '\n'.join('  '.join(
+      field.ljust(width) if i < 2 else field.rjust(width)
+      for i, (field, width) in enumerate(zip(line, widths))).rstrip()
+                   for line in lines)
+  if num_dropped:
+    text += ('\n%d records were dropped, the trace buffer was too small.' %
+             num_dropped)
+  return text + '\n'
+
+
+def main(_):
+  parser = argparse.ArgumentParser(
+      description='Print the per-layer report of a TFLite Micro op trace.')
+  parser.add_argument(
+      '--trace_file',
+      type=str,
+      required=True,
+      help='Full path name to the trace, as raw bytes or hex text.')
+  args = parser.parse_args()
+
+  with open(args.trace_file, 'rb') as trace_file:
+    data = trace_file.read()
+  if not data.startswith(TRACE_MAGIC):
+    data = binascii.unhexlify(b''.join(data.split()))
+  ticks_per_second, records, num_dropped = parse_trace(data)
+  sys.stdout.write(
+      format_report(ticks_per_second, summarize(records), num_dropped))
+
+
+if __name__ == '__main__':
+  app.run(main=main, argv=sys.argv[:1])
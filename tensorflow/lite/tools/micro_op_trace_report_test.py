@@ -0,0 +1,87 @@
+# Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Tests for micro_op_trace_report.py."""
+
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+import struct
+
+from tensorflow.lite.tools import micro_op_trace_report
+from tensorflow.python.framework import test_util
+from tensorflow.python.platform import test
+
+
+def _build_trace(records, ticks_per_second=0, num_dropped=0):
+  data = b'TFOT' + struct.pack('<HHiII', 1, 16, ticks_per_second,
+                               len(records), num_dropped)
+  for record in records:
+    data += struct.pack('<HHiII', *record)
+  return data
+
+
+class MicroOpTraceReportTest(test_util.TensorFlowTestCase):
+
+  def testParseTrace(self):
+    ticks_per_second, records, num_dropped = (
+        micro_op_trace_report.parse_trace(
+            _build_trace([(0, 3, 1000, 64, 32), (1, 9, 200, 0, 0)],
+                         ticks_per_second=1000000,
+                         num_dropped=2)))
+    self.assertEqual(ticks_per_second, 1000000)
+    self.assertEqual(num_dropped, 2)
+    self.assertEqual(records, [(0, 3, 1000, 64, 32), (1, 9, 200, 0, 0)])
+
+  def testParseTraceRejectsOtherData(self):
+    with self.assertRaises(ValueError):
+      micro_op_trace_report.parse_trace(b'not a trace at all')
+    with self.assertRaises(ValueError):
+      # The header counts a record missing from the data.
+      micro_op_trace_report.parse_trace(_build_trace([(0, 3, 1, 0, 0)])[:-1])
+
+  def testSummarize(self):
+    records = [
+        micro_op_trace_report.OpRecord(1, 9, 200, 0, 16),
+        micro_op_trace_report.OpRecord(0, 3, 1000, 64, 0),
+        micro_op_trace_report.OpRecord(1, 9, 400, 0, 48),
+    ]
+    self.assertEqual(
+        micro_op_trace_report.summarize(records),
+        [(0, 3, 1, 1000, 1000, 64, 0), (1, 9, 2, 600, 400, 0, 48)])
+
+  def testFormatReport(self):
+    summaries = [
+        micro_op_trace_report.OpSummary(0, 3, 1, 1500, 1500, 64, 0),
+        micro_op_trace_report.OpSummary(1, 9, 2, 500, 300, 0, 48),
+    ]
+    report = micro_op_trace_report.format_report(1000, summaries, 1)
+    lines = report.splitlines()
+    self.assertEqual(lines[0].split(), [
+        'Op', 'Type', 'Runs', 'Avg', 'ticks', 'Max', 'ticks', '%', 'Scratch',
+        'B', 'Temp', 'B', 'Avg', 'us'
+    ])
+    self.assertEqual(lines[1].split(),
+                     ['0', 'CONV_2D', '1', '1500', '1500', '75.0', '64', '0',
+                      '1500000.0'])
+    self.assertEqual(lines[2].split(), [
+        '1', 'FULLY_CONNECTED', '2', '250', '300', '25.0', '0', '48',
+        '250000.0'
+    ])
+    self.assertIn('1 records were dropped', lines[3])
+
+
+if __name__ == '__main__':
+  test.main()
@@ -0,0 +1,265 @@
+# Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+r"""Plans the tensor arena of a tflite file for TFLite Micro offline.
+
+The arena offset of each tensor is written to the "OfflineMemoryAllocation"
+metadata of the model, which the MicroAllocator uses instead of running its
+greedy memory planner on the device. The scratch buffers requested by the
+kernels are still planned on the device, around the offline planned tensors.
+
+Example usage:
+python offline_memory_planner.py \
+  --input_tflite_file=foo.tflite \
+  --output_tflite_file=foo_planned.tflite
+"""
+
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+import argparse
+import sys
+
+import numpy as np
+
+from tensorflow.lite.python import schema_py_generated as schema_fb
+from tensorflow.lite.tools import flatbuffer_utils
+from tensorflow.python.platform import app
+
+OFFLINE_MEMORY_ALLOCATION_METADATA = 'OfflineMemoryAllocation'
+# The version of the metadata the MicroAllocator supports.
+OFFLINE_MEMORY_ALLOCATION_VERSION = 1
+# The alignment of the buffers in the arena, as in micro_allocator.cc.
+BUFFER_ALIGNMENT = 16
+# The offset of the tensors which are allocated on the device.
+ONLINE_PLANNED_BUFFER = -1
+
+_TENSOR_TYPE_SIZES = {
+    schema_fb.TensorType.FLOAT32: 4,
+    schema_fb.TensorType.FLOAT16: 2,
+    schema_fb.TensorType.FLOAT64: 8,
+    schema_fb.TensorType.INT32: 4,
+    schema_fb.TensorType.UINT8: 1,
+    schema_fb.TensorType.INT64: 8,
+    schema_fb.TensorType.BOOL: 1,
+    schema_fb.TensorType.INT16: 2,
+    schema_fb.TensorType.COMPLEX64: 8,
+    schema_fb.TensorType.INT8: 1,
+}
+
+
+def _align_up(size):
+  return (size + BUFFER_ALIGNMENT - 1) // BUFFER_ALIGNMENT * BUFFER_ALIGNMENT
+
+
+def get_buffer_lifetimes(model, subgraph_index=0):
+  """Returns the tensors of a subgraph the MicroAllocator places in the arena.
+
+  The lifetimes are computed as in micro_allocator.cc: the constant and the
+  variable tensors aren't placed in the arena, the inputs are live from the
+  first operator and the outputs until the last one.
+
+  Args:
+    model: The model object.
+    subgraph_index: The index of the subgraph.
+
+  Returns:
+    A list of (tensor index, aligned size in bytes, first operator using the
+    tensor, last operator using the tensor) tuples.
+
+  Raises:
+    ValueError: If a tensor has an unsupported type.
+  """
+  subgraph = model.subgraphs[subgraph_index]
+  num_tensors = len(subgraph.tensors)
+  operators = subgraph.operators if subgraph.operators is not None else []
+  first_created = [-1] * num_tensors
+  last_used = [-1] * num_tensors
+  for tensor_index in subgraph.inputs:
+    first_created[tensor_index] = 0
+  for tensor_index in subgraph.outputs:
+    last_used[tensor_index] = len(operators) - 1
+  for i, op in enumerate(operators):
+    for tensor_index in op.inputs:
+      if tensor_index >= 0:
+        last_used[tensor_index] = max(last_used[tensor_index], i)
+    for tensor_index in op.outputs:
+      if first_created[tensor_index] == -1:
+        first_created[tensor_index] = i
+
+  lifetimes = []
+  for i, tensor in enumerate(subgraph.tensors):
+    data = model.buffers[tensor.buffer].data
+    if (data is not None and len(data)) or tensor.isVariable:
+      continue
+    if first_created[i] == -1 or last_used[i] == -1:
+      continue
+    if tensor.type not in _TENSOR_TYPE_SIZES:
+      raise ValueError('Tensor %d has an unsupported type %d' %
+                       (i, tensor.type))
+    num_elements = 1
+    for dim in (tensor.shape if tensor.shape is not None else []):
+      num_elements *= dim
+    size = _align_up(num_elements * _TENSOR_TYPE_SIZES[tensor.type])
+    lifetimes.append((i, size, first_created[i], last_used[i]))
+  return lifetimes
+
+
+def _place(lifetimes, order):
+  """Places the buffers in `order`, each at the lowest offset that fits.
+
+  Returns:
+    The offsets of the buffers indexed as in `lifetimes`, and the arena size.
+  """
+  offsets = [None] * len(lifetimes)
+  placed = []
+  arena_size = 0
+  for i in order:
+    _, size, first, last = lifetimes[i]
+    # The buffers live at the same time as this one, by increasing offset.
+    live = sorted((offsets[j], lifetimes[j][1])
+                  for j in placed
+                  if lifetimes[j][2] <= last and first <= lifetimes[j][3])
+    offset = 0
+    for live_offset, live_size in live:
+      if offset + size <= live_offset:
+        break
+      offset = max(offset, live_offset + live_size)
+    offsets[i] = offset
+    placed.append(i)
+    arena_size = max(arena_size, offset + size)
+  return offsets, arena_size
+
+
+def plan_offsets(lifetimes):
+  """Plans the arena offsets of the buffers.
+
+  Finding the smallest arena is NP-hard, so the buffers are placed in several
+  orders, e.g. by decreasing size as the greedy planner of TFLite Micro does,
+  and the smallest of the resulting arenas is kept. Since the planning runs on
+  the host, it can afford to try them all.
+
+  Args:
+    lifetimes: The buffers returned by get_buffer_lifetimes().
+
+  Returns:
+    The offsets of the buffers indexed as in `lifetimes`, and the arena size.
+  """
+  indices = range(len(lifetimes))
+  orders = [
+      # By decreasing size.
+      sorted(indices, key=lambda i: -lifetimes[i][1]),
+      # By decreasing size times lifetime.
+      sorted(
+          indices,
+          key=lambda i: -lifetimes[i][1] *
+          (lifetimes[i][3] - lifetimes[i][2] + 1)),
+      # By decreasing lifetime, then size.
+      sorted(
+          indices,
+          key=lambda i: (lifetimes[i][2] - lifetimes[i][3], -lifetimes[i][1])),
+      # In execution order.
+      sorted(indices, key=lambda i: (lifetimes[i][2], -lifetimes[i][1])),
+  ]
+  best = None
+  for order in orders:
+    offsets, arena_size = _place(lifetimes, order)
+    if best is None or arena_size < best[1]:
+      best = (offsets, arena_size)
+  return best if best is not None else ([], 0)
+
+
+def get_arena_lower_bound(lifetimes):
+  """Returns the largest total size of the buffers live at the same time."""
+  if not lifetimes:
+    return 0
+  num_operators = max(last for _, _, _, last in lifetimes) + 1
+  return max(
+      sum(size
+          for _, size, first, last in lifetimes
+          if first <= i <= last)
+      for i in range(num_operators))
+
+
+def add_offline_memory_plan(model, subgraph_index=0):
+  """Plans the arena of a subgraph, and stores its offsets in the model.
+
+  A previous plan of the model is replaced.
+
+  Args:
+    model: The model object, modified in place.
+    subgraph_index: The index of the subgraph, which must be 0 for TFLite
+      Micro.
+
+  Returns:
+    The size in bytes of the planned part of the arena.
+  """
+  lifetimes = get_buffer_lifetimes(model, subgraph_index)
+  offsets, arena_size = plan_offsets(lifetimes)
+  tensor_offsets = [ONLINE_PLANNED_BUFFER] * len(
+      model.subgraphs[subgraph_index].tensors)
+  for (tensor_index, _, _, _), offset in zip(lifetimes, offsets):
+    tensor_offsets[tensor_index] = offset
+  values = [
+      OFFLINE_MEMORY_ALLOCATION_VERSION, subgraph_index,
+      len(tensor_offsets)
+  ] + tensor_offsets
+
+  buffer = schema_fb.BufferT()
+  buffer.data = np.frombuffer(
+      np.array(values, dtype='<i4').tobytes(), dtype=np.uint8)
+  if model.metadata is None:
+    model.metadata = []
+  metadata = None
+  for existing_metadata in model.metadata:
+    if existing_metadata.name in (OFFLINE_MEMORY_ALLOCATION_METADATA,
+                                  OFFLINE_MEMORY_ALLOCATION_METADATA.encode()):
+      metadata = existing_metadata
+  if metadata is None:
+    metadata = schema_fb.MetadataT()
+    metadata.name = OFFLINE_MEMORY_ALLOCATION_METADATA
+    model.metadata.append(metadata)
+    metadata.buffer = len(model.buffers)
+    model.buffers.append(buffer)
+  else:
+    model.buffers[metadata.buffer] = buffer
+  return arena_size
+
+
+def main(_):
+  parser = argparse.ArgumentParser(
+      description='Plan the tensor arena of a tflite file for TFLite Micro.')
+  parser.add_argument(
+      '--input_tflite_file',
+      type=str,
+      required=True,
+      help='Full path name to the input tflite file.')
+  parser.add_argument(
+      '--output_tflite_file',
+      type=str,
+      required=True,
+      help='Full path name to the output planned tflite file.')
+  args = parser.parse_args()
+
+  model = flatbuffer_utils.read_model(args.input_tflite_file)
+  lifetimes = get_buffer_lifetimes(model)
+  arena_size = add_offline_memory_plan(model)
+  print('Planned %d tensors in %d bytes, at least %d bytes are needed.' %
+        (len(lifetimes), arena_size, get_arena_lower_bound(lifetimes)))
+  flatbuffer_utils.write_model(model, args.output_tflite_file)
+
+
+if __name__ == '__main__':
+  app.run(main=main, argv=sys.argv[:1])
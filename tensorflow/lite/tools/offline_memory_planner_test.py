@@ -0,0 +1,78 @@
+# Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Tests for offline_memory_planner.py."""
+
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+import numpy as np
+
+from tensorflow.lite.tools import offline_memory_planner
+from tensorflow.lite.tools import test_utils
+from tensorflow.python.framework import test_util
+from tensorflow.python.platform import test
+
+
+class OfflineMemoryPlannerTest(test_util.TensorFlowTestCase):
+
+  def testGetBufferLifetimes(self):
+    model = test_utils.build_mock_model()
+    # The constant tensor 1 isn't placed in the arena, the input and output of
+    # the single operator take 40 bytes each, aligned to 48.
+    self.assertEqual(
+        offline_memory_planner.get_buffer_lifetimes(model),
+        [(0, 48, 0, 0), (2, 48, 0, 0)])
+
+  def testPlanOffsetsReusesMemory(self):
+    # Buffer 1 and 2 are live at different times, so they share the memory.
+    lifetimes = [(0, 64, 0, 2), (1, 32, 0, 0), (2, 32, 1, 2)]
+    offsets, arena_size = offline_memory_planner.plan_offsets(lifetimes)
+    self.assertEqual(offsets, [0, 64, 64])
+    self.assertEqual(arena_size, 96)
+    self.assertEqual(
+        offline_memory_planner.get_arena_lower_bound(lifetimes), 96)
+
+  def testPlanOffsetsBeatsSizeOrder(self):
+    # Placing the buffers by decreasing size puts buffer 0 after buffer 2, which
+    # leaves a gap between buffers 1 and 0 too small for buffer 3. Placing the
+    # longest lived buffers first reaches the lower bound.
+    lifetimes = [(0, 48, 0, 3), (1, 48, 3, 3), (2, 64, 0, 1), (3, 32, 3, 3)]
+    offsets, arena_size = offline_memory_planner.plan_offsets(lifetimes)
+    self.assertEqual(offsets, [0, 48, 48, 96])
+    self.assertEqual(arena_size, 128)
+    self.assertEqual(
+        offline_memory_planner.get_arena_lower_bound(lifetimes), 128)
+
+  def testAddOfflineMemoryPlan(self):
+    model = test_utils.build_mock_model()
+    num_buffers = len(model.buffers)
+    self.assertEqual(offline_memory_planner.add_offline_memory_plan(model), 96)
+    # Planning again replaces the plan.
+    self.assertEqual(offline_memory_planner.add_offline_memory_plan(model), 96)
+
+    self.assertLen(model.metadata, 1)
+    self.assertEqual(model.metadata[0].name, 'OfflineMemoryAllocation')
+    self.assertEqual(model.metadata[0].buffer, num_buffers)
+    self.assertLen(model.buffers, num_buffers + 1)
+    plan = np.frombuffer(
+        np.array(model.buffers[num_buffers].data, dtype=np.uint8).tobytes(),
+        dtype='<i4')
+    # The version, subgraph and number of tensors, then the offsets.
+    self.assertEqual(list(plan), [1, 0, 3, 0, -1, 48])
+
+
+if __name__ == '__main__':
+  test.main()
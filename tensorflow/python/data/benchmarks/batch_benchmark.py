@@ -21,7 +21,10 @@ import numpy as np
 
 from tensorflow.python.data.benchmarks import benchmark_base
 from tensorflow.python.data.ops import dataset_ops
+from tensorflow.python.framework import dtypes
 from tensorflow.python.framework import sparse_tensor
+from tensorflow.python.ops import array_ops
+from tensorflow.python.ops import math_ops
 
 
 class BatchBenchmark(benchmark_base.DatasetBenchmarkBase):
@@ -67,6 +70,24 @@ class BatchBenchmark(benchmark_base.DatasetBenchmarkBase):
               name="batch_element_size_%d_batch_size_%d%s" %
               (element_size, batch_size, tag))
 
+  def benchmark_map_batch_images(self):
+    """Benchmarks batching the outputs of a map of image-sized elements."""
+    for batch_size in [32, 128]:
+      for fusion in [True, False]:
+        dataset = dataset_ops.Dataset.range(1 << 20).map(
+            lambda x: array_ops.broadcast_to(
+                math_ops.cast(x, dtypes.uint8), [224, 224, 3])).batch(
+                    batch_size)
+        options = dataset_ops.Options()
+        options.experimental_optimization.map_and_batch_fusion = fusion
+        dataset = dataset.with_options(options)
+        tag = "_fused" if fusion else ""
+        self.run_and_report_benchmark(
+            dataset,
+            num_elements=(1 << 13) // batch_size,
+            iters=5,
+            name="map_batch_images_batch_size_%d%s" % (batch_size, tag))
+
 
 if __name__ == "__main__":
   benchmark_base.test.main()
@@ -0,0 +1,73 @@
+# Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Benchmarks for the latency of individual `tf.data` iterator calls."""
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+import time
+
+import numpy as np
+
+from tensorflow.python.client import session
+from tensorflow.python.data.benchmarks import benchmark_base
+from tensorflow.python.data.ops import dataset_ops
+from tensorflow.python.data.util import nest
+from tensorflow.python.ops import math_ops
+
+
+# TODO(b/119837791): Add eager benchmarks.
+class LatencyBenchmark(benchmark_base.DatasetBenchmarkBase):
+  """Benchmarks for the latency of individual `tf.data` iterator calls."""
+
+  def _run_and_report_latency(self, dataset, num_elements, name):
+    iterator = dataset_ops.make_initializable_iterator(dataset)
+    next_element = nest.flatten(iterator.get_next())[0]
+    with session.Session() as sess:
+      sess.run(iterator.initializer)
+      # Warm up the session caches and any lazily started threads.
+      for _ in range(100):
+        sess.run(next_element.op)
+      deltas = []
+      for _ in range(num_elements):
+        start = time.time()
+        sess.run(next_element.op)
+        deltas.append(time.time() - start)
+    self.report_benchmark(
+        wall_time=np.median(deltas),
+        iters=num_elements,
+        name=name,
+        extras={
+            "p50_latency_us": np.percentile(deltas, 50) * 1e6,
+            "p99_latency_us": np.percentile(deltas, 99) * 1e6,
+        })
+
+  def benchmark_map_and_batch(self):
+    for low_latency in [False, True]:
+      dataset = dataset_ops.Dataset.range(10**9)
+      for _ in range(3):
+        dataset = dataset.map(lambda x: math_ops.cast(x, "float32") * 2.)
+      dataset = dataset.batch(32)
+      options = dataset_ops.Options()
+      options.experimental_optimization.low_latency = low_latency
+      dataset = dataset.with_options(options)
+      self._run_and_report_latency(
+          dataset,
+          num_elements=10000,
+          name="map_and_batch%s" % ("_low_latency" if low_latency else ""))
+
+
+if __name__ == "__main__":
+  benchmark_base.test.main()
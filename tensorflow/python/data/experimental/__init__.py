@@ -47,6 +47,7 @@ See [Importing Data](https://tensorflow.org/guide/datasets) for an overview.
 
 @@assert_cardinality
 @@bucket_by_sequence_length
+@@bucket_by_token_budget
 @@bytes_produced_stats
 @@cardinality
 @@choose_from_datasets
@@ -110,6 +111,7 @@ from tensorflow.python.data.experimental.ops.enumerate_ops import enumerate_data
 from tensorflow.python.data.experimental.ops.error_ops import ignore_errors
 from tensorflow.python.data.experimental.ops.get_single_element import get_single_element
 from tensorflow.python.data.experimental.ops.grouping import bucket_by_sequence_length
+from tensorflow.python.data.experimental.ops.grouping import bucket_by_token_budget
 from tensorflow.python.data.experimental.ops.grouping import group_by_reducer
 from tensorflow.python.data.experimental.ops.grouping import group_by_window
 from tensorflow.python.data.experimental.ops.grouping import Reducer
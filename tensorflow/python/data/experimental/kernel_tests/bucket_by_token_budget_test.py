@@ -0,0 +1,106 @@
+# Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Tests for `tf.data.experimental.bucket_by_token_budget()`."""
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+from absl.testing import parameterized
+import numpy as np
+
+from tensorflow.python.data.experimental.ops import grouping
+from tensorflow.python.data.kernel_tests import test_base
+from tensorflow.python.data.ops import dataset_ops
+from tensorflow.python.framework import combinations
+from tensorflow.python.framework import errors
+from tensorflow.python.ops import array_ops
+from tensorflow.python.platform import test
+
+
+def _element_length_fn(x, y=None):
+  del y
+  return array_ops.shape(x)[0]
+
+
+def _sequences(lengths):
+  # Each sequence of length `n` is filled with `n`, so that its original
+  # length can be recovered from a padded batch.
+  return dataset_ops.Dataset.from_tensor_slices(lengths).map(
+      lambda n: array_ops.fill([n], n))
+
+
+class BucketByTokenBudgetTest(test_base.DatasetTestBase,
+                              parameterized.TestCase):
+
+  @combinations.generate(test_base.default_test_combinations())
+  def testRespectsTokenBudget(self):
+    lengths = np.random.randint(1, 40, size=(200,)).astype(np.int64)
+    dataset = _sequences(lengths).apply(
+        grouping.bucket_by_token_budget(_element_length_fn, token_budget=64))
+    seen = []
+    for batch in self.getDatasetOutput(dataset):
+      if batch.shape[0] > 1:
+        self.assertLessEqual(batch.shape[0] * batch.shape[1], 64)
+      self.assertEqual(batch.shape[1], np.max(batch))
+      for row in batch:
+        seen.append(np.count_nonzero(row))
+    self.assertEqual(sorted(seen), sorted(lengths.tolist()))
+
+  @combinations.generate(test_base.default_test_combinations())
+  def testReducesPadding(self):
+    # Two clusters of lengths, which a single bucket would pad heavily.
+    lengths = np.concatenate([
+        np.random.randint(2, 5, size=(300,)),
+        np.random.randint(50, 53, size=(300,))
+    ]).astype(np.int64)
+    np.random.shuffle(lengths)
+    dataset = _sequences(lengths).apply(
+        grouping.bucket_by_token_budget(
+            _element_length_fn, token_budget=512, max_padding_fraction=0.1))
+    padded_tokens = 0
+    for batch in self.getDatasetOutput(dataset):
+      padded_tokens += batch.size
+    padding_fraction = 1.0 - np.sum(lengths) / padded_tokens
+    self.assertLess(padding_fraction, 0.2)
+
+  @combinations.generate(test_base.default_test_combinations())
+  def testLongElementFormsOwnBatch(self):
+    dataset = _sequences([3, 100, 3]).apply(
+        grouping.bucket_by_token_budget(_element_length_fn, token_budget=10))
+    shapes = sorted(
+        batch.shape for batch in self.getDatasetOutput(dataset))
+    self.assertEqual(shapes, [(1, 100), (2, 3)])
+
+  @combinations.generate(test_base.default_test_combinations())
+  def testTupleWithPaddingValues(self):
+    dataset = _sequences([1, 2]).map(lambda x: (x, x * 2)).apply(
+        grouping.bucket_by_token_budget(
+            _element_length_fn,
+            token_budget=100,
+            max_buckets=1,
+            padding_values=(-1, -2)))
+    self.assertDatasetProduces(
+        dataset, expected_output=[([[1, -1], [2, 2]], [[2, -2], [4, 4]])])
+
+  @combinations.generate(test_base.default_test_combinations())
+  def testInvalidTokenBudget(self):
+    dataset = _sequences([1, 2]).apply(
+        grouping.bucket_by_token_budget(_element_length_fn, token_budget=0))
+    self.assertDatasetProduces(
+        dataset, expected_error=(errors.InvalidArgumentError, "Token budget"))
+
+
+if __name__ == "__main__":
+  test.main()
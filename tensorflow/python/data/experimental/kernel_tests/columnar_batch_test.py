@@ -0,0 +1,93 @@
+# Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Tests for `tf.data.experimental.columnar.ColumnarBatchDataset`."""
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+from absl.testing import parameterized
+import numpy as np
+
+from tensorflow.python.data.experimental.ops import columnar
+from tensorflow.python.data.kernel_tests import test_base
+from tensorflow.python.framework import combinations
+from tensorflow.python.framework import errors
+from tensorflow.python.platform import test
+
+
+class ColumnarBatchTest(test_base.DatasetTestBase, parameterized.TestCase):
+
+  def _table(self, num_rows):
+    return {
+        "id": np.arange(num_rows, dtype=np.int64),
+        "features": np.arange(num_rows * 3, dtype=np.float32).reshape(
+            (num_rows, 3)),
+        "name": np.array([str(i).encode() for i in range(num_rows)]),
+    }
+
+  @combinations.generate(
+      combinations.times(
+          test_base.default_test_combinations(),
+          combinations.combine(num_rows=[8, 10], drop_remainder=[True, False])))
+  def testBatches(self, num_rows, drop_remainder):
+    table = self._table(num_rows)
+    dataset = columnar.ColumnarBatchDataset(
+        table, batch_size=4, drop_remainder=drop_remainder)
+    known_batch_dim = drop_remainder or num_rows % 4 == 0
+    self.assertEqual([4 if known_batch_dim else None, 3],
+                     dataset.element_spec["features"].shape.as_list())
+
+    expected = []
+    for start in range(0, num_rows, 4):
+      end = min(start + 4, num_rows)
+      if drop_remainder and end - start < 4:
+        break
+      expected.append({k: v[start:end] for k, v in table.items()})
+    self.assertDatasetProduces(dataset, expected_output=expected)
+
+  @combinations.generate(test_base.default_test_combinations())
+  def testShuffle(self):
+    table = self._table(100)
+    dataset = columnar.ColumnarBatchDataset(
+        table, batch_size=7, shuffle=True, seed=42)
+    output = self.getDatasetOutput(dataset)
+    ids = np.concatenate([batch["id"] for batch in output])
+    self.assertNotEqual(ids.tolist(), list(range(100)))
+    self.assertCountEqual(ids.tolist(), list(range(100)))
+    # The other columns are permuted along with the ids.
+    for batch in output:
+      self.assertAllEqual(table["features"][batch["id"]], batch["features"])
+      self.assertAllEqual(table["name"][batch["id"]], batch["name"])
+
+    # The order is determined by the seed.
+    self.assertAllEqual(
+        ids, np.concatenate([b["id"] for b in self.getDatasetOutput(dataset)]))
+
+  @combinations.generate(test_base.default_test_combinations())
+  def testMismatchedColumns(self):
+    with self.assertRaises((ValueError, errors.InvalidArgumentError)):
+      dataset = columnar.ColumnarBatchDataset(
+          (np.arange(3), np.arange(4)), batch_size=2)
+      self.getDatasetOutput(dataset)
+
+  @combinations.generate(test_base.default_test_combinations())
+  def testInvalidBatchSize(self):
+    with self.assertRaises(errors.InvalidArgumentError):
+      dataset = columnar.ColumnarBatchDataset(np.arange(3), batch_size=0)
+      self.getDatasetOutput(dataset)
+
+
+if __name__ == "__main__":
+  test.main()
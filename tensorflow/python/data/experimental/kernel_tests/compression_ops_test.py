@@ -24,6 +24,7 @@ from tensorflow.python.data.kernel_tests import test_base
 from tensorflow.python.data.ops import dataset_ops
 from tensorflow.python.data.util import structure
 from tensorflow.python.framework import combinations
+from tensorflow.python.framework import errors
 from tensorflow.python.framework import sparse_tensor
 from tensorflow.python.platform import test
 
@@ -54,11 +55,13 @@ class CompressionOpsTest(test_base.DatasetTestBase, parameterized.TestCase):
 
   @combinations.generate(
       combinations.times(test_base.default_test_combinations(),
-                         combinations.combine(element=_test_objects())))
-  def testCompression(self, element):
+                         combinations.combine(
+                             element=_test_objects(),
+                             compression=["snappy", "none", "auto"])))
+  def testCompression(self, element, compression):
     element = element._obj
 
-    compressed = compression_ops.compress(element)
+    compressed = compression_ops.compress(element, compression=compression)
     uncompressed = compression_ops.uncompress(
         compressed, structure.type_spec_from_value(element))
     self.assertValuesEqual(element, self.evaluate(uncompressed))
@@ -76,6 +79,12 @@ class CompressionOpsTest(test_base.DatasetTestBase, parameterized.TestCase):
     dataset = dataset.map(lambda x: compression_ops.uncompress(x, element_spec))
     self.assertDatasetProduces(dataset, [element])
 
+  @combinations.generate(test_base.default_test_combinations())
+  def testInvalidCompression(self):
+    with self.assertRaisesRegex(errors.InvalidArgumentError,
+                                "Unsupported compression"):
+      self.evaluate(compression_ops.compress(1, compression="zip"))
+
 
 if __name__ == "__main__":
   test.main()
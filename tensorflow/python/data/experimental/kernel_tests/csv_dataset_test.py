@@ -570,6 +570,26 @@ class CsvDatasetTest(test_base.DatasetTestBase, parameterized.TestCase):
     self._test_dataset_on_buffer_sizes(
         inputs, expected, linebreak='\r\n', record_defaults=record_defaults)
 
+  @combinations.generate(test_base.default_test_combinations())
+  def testCsvDataset_withLongFields(self):
+    # Fields longer than the eight bytes the parser scans at a time, with
+    # delimiters, line breaks and quotes at every offset within a word.
+    record_defaults = [['NA']] * 3
+    fields = ['x' * i for i in range(1, 20)]
+    inputs = [[
+        '%s,"%s""%s",%s' % (fields[i], fields[-i], fields[i], fields[-i])
+        for i in range(len(fields))
+    ]]
+    expected = [[fields[i], '%s"%s' % (fields[-i], fields[i]), fields[-i]]
+                for i in range(len(fields))]
+    for linebreak in ['\n', '\r', '\r\n']:
+      self._test_dataset_on_buffer_sizes(
+          inputs,
+          expected,
+          linebreak=linebreak,
+          record_defaults=record_defaults,
+          num_sizes_to_test=10)
+
   @combinations.generate(test_base.default_test_combinations())
   def testCsvDataset_withGzipCompressionType(self):
     record_defaults = [['NA']] * 3
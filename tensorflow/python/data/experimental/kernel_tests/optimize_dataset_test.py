@@ -278,6 +278,7 @@ class OptimizeDatasetTest(test_base.DatasetTestBase, parameterized.TestCase):
     expected_optimizations_default = [
         "map_and_batch_fusion",
         "noop_elimination",
+        "ragged_variant_elimination",
         "shuffle_and_repeat_fusion",
     ]
     graph_rewrites = options._graph_rewrites()
@@ -320,6 +321,7 @@ class OptimizeDatasetTest(test_base.DatasetTestBase, parameterized.TestCase):
     options.experimental_optimization.map_fusion = True
     options.experimental_optimization.noop_elimination = True
     options.experimental_optimization.parallel_batch = True
+    options.experimental_optimization.ragged_variant_elimination = True
     options.experimental_optimization.shuffle_and_repeat_fusion = True
     options.experimental_optimization.map_vectorization.enabled = True
     options.experimental_optimization.autotune_buffers = True
@@ -337,6 +339,7 @@ class OptimizeDatasetTest(test_base.DatasetTestBase, parameterized.TestCase):
         "map_fusion",
         "noop_elimination",
         "parallel_batch",
+        "ragged_variant_elimination",
         "shuffle_and_repeat_fusion",
         "map_vectorization",
         "inject_prefetch",
@@ -367,6 +370,7 @@ class OptimizeDatasetTest(test_base.DatasetTestBase, parameterized.TestCase):
     options.experimental_optimization.map_fusion = False
     options.experimental_optimization.noop_elimination = False
     options.experimental_optimization.parallel_batch = False
+    options.experimental_optimization.ragged_variant_elimination = False
     options.experimental_optimization.shuffle_and_repeat_fusion = False
     options.experimental_optimization.map_vectorization.enabled = False
     options.experimental_optimization.autotune = False
@@ -385,6 +389,7 @@ class OptimizeDatasetTest(test_base.DatasetTestBase, parameterized.TestCase):
         "map_fusion",
         "noop_elimination",
         "parallel_batch",
+        "ragged_variant_elimination",
         "shuffle_and_repeat_fusion",
         "map_vectorization",
         "inject_prefetch",
@@ -423,6 +428,43 @@ class OptimizeDatasetTest(test_base.DatasetTestBase, parameterized.TestCase):
                      optimization_options._AutotuneAlgorithm.GRADIENT_DESCENT)
     self.assertEqual(cpu_budget, 0)
 
+  @combinations.generate(test_base.default_test_combinations())
+  def testLowLatency(self):
+    options = dataset_ops.Options()
+    options.experimental_optimization.low_latency = True
+    autotune, _, _ = options._autotune_settings()
+    self.assertFalse(autotune)
+    graph_rewrites = options._graph_rewrites()
+    self.assertEqual(
+        set(graph_rewrites.enabled), set(["filter_fusion", "map_fusion"]))
+    self.assertEqual(
+        set(graph_rewrites.disabled),
+        set([
+            "inject_prefetch", "map_and_batch_fusion", "map_parallelization",
+            "parallel_batch"
+        ]))
+    self.assertEqual(
+        set(graph_rewrites.default),
+        set([
+            "noop_elimination", "ragged_variant_elimination",
+            "shuffle_and_repeat_fusion"
+        ]))
+
+  @combinations.generate(test_base.default_test_combinations())
+  def testLowLatencyRespectsExplicitSettings(self):
+    options = dataset_ops.Options()
+    options.experimental_optimization.low_latency = True
+    options.experimental_optimization.autotune = True
+    options.experimental_optimization.map_fusion = False
+    options.experimental_optimization.map_and_batch_fusion = True
+    autotune, _, _ = options._autotune_settings()
+    self.assertTrue(autotune)
+    graph_rewrites = options._graph_rewrites()
+    self.assertIn("map_and_batch_fusion", graph_rewrites.enabled)
+    self.assertIn("map_fusion", graph_rewrites.disabled)
+    self.assertNotIn("map_fusion", graph_rewrites.enabled)
+    self.assertNotIn("inject_prefetch", graph_rewrites.disabled)
+
 
 if __name__ == "__main__":
   test.main()
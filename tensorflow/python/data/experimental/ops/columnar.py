@@ -0,0 +1,111 @@
+# Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Experimental API for batching rows of in-memory columnar tables."""
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+from tensorflow.python.data.ops import dataset_ops
+from tensorflow.python.data.util import nest
+from tensorflow.python.data.util import random_seed
+from tensorflow.python.data.util import structure
+from tensorflow.python.framework import dtypes
+from tensorflow.python.framework import ops
+from tensorflow.python.framework import tensor_shape
+from tensorflow.python.framework import tensor_spec
+from tensorflow.python.ops import gen_experimental_dataset_ops
+
+
+class ColumnarBatchDataset(dataset_ops.DatasetSource):
+  """A `Dataset` of batches of rows of an in-memory columnar table.
+
+  The columns are dense tensors whose 0th dimensions index the rows of the
+  table. Unlike `from_tensor_slices(columns).batch(batch_size)`, the rows are
+  never copied into individual elements: without shuffling, each batch shares
+  the buffers of the columns whenever it is suitably aligned, and with
+  shuffling, only the row indices are permuted.
+
+  >>> table = {"x": [1, 2, 3, 4, 5], "y": [[1., 0.], [2., 0.], [3., 0.],
+  ...                                       [4., 0.], [5., 0.]]}
+  >>> dataset = ColumnarBatchDataset(table, batch_size=2)
+  >>> [batch["x"].numpy().tolist() for batch in dataset]
+  [[1, 2], [3, 4], [5]]
+  """
+
+  def __init__(self,
+               columns,
+               batch_size,
+               drop_remainder=False,
+               shuffle=False,
+               seed=None):
+    """Creates a `ColumnarBatchDataset`.
+
+    Args:
+      columns: A (nested) structure of dense tensors, the columns of the table.
+        All columns must have the same size in the 0th dimension.
+      batch_size: A `tf.int64` scalar `tf.Tensor`, representing the number of
+        rows to combine in a single batch.
+      drop_remainder: (Optional.) A `tf.bool` scalar `tf.Tensor`, representing
+        whether the last batch should be dropped in the case it has fewer than
+        `batch_size` rows.
+      shuffle: (Optional.) A Python boolean, representing whether each iterator
+        should produce the rows in a different random order.
+      seed: (Optional.) A `tf.int64` scalar `tf.Tensor`, representing the random
+        seed that will be used to create the distribution. See
+        `tf.random.set_seed` for behavior.
+
+    Raises:
+      TypeError: If a column is not a dense tensor.
+    """
+    columns = structure.normalize_element(columns)
+    for spec in nest.flatten(structure.type_spec_from_value(columns)):
+      if not isinstance(spec, tensor_spec.TensorSpec):
+        raise TypeError("All columns must be dense tensors, but got %r." %
+                        (spec,))
+    self._columns = nest.flatten(columns)
+    self._batch_size = ops.convert_to_tensor(
+        batch_size, dtype=dtypes.int64, name="batch_size")
+    self._drop_remainder = ops.convert_to_tensor(
+        drop_remainder, dtype=dtypes.bool, name="drop_remainder")
+    self._seed, self._seed2 = random_seed.get_seed(seed)
+
+    num_rows = tensor_shape.dimension_value(self._columns[0].shape[0])
+    constant_batch_size = ops.get_static_value(self._batch_size)
+    constant_drop_remainder = ops.get_static_value(self._drop_remainder)
+    if constant_batch_size is not None and (
+        constant_drop_remainder or
+        (num_rows is not None and num_rows % constant_batch_size == 0)):
+      batch_dim = constant_batch_size
+    else:
+      batch_dim = None
+    self._structure = nest.pack_sequence_as(columns, [
+        tensor_spec.TensorSpec(
+            tensor_shape.TensorShape([batch_dim]).concatenate(c.shape[1:]),
+            c.dtype) for c in self._columns
+    ])
+
+    variant_tensor = gen_experimental_dataset_ops.columnar_batch_dataset(
+        self._columns,
+        batch_size=self._batch_size,
+        drop_remainder=self._drop_remainder,
+        seed=self._seed,
+        seed2=self._seed2,
+        shuffle=shuffle,
+        output_shapes=structure.get_flat_tensor_shapes(self._structure))
+    super(ColumnarBatchDataset, self).__init__(variant_tensor)
+
+  @property
+  def element_spec(self):
+    return self._structure
@@ -21,11 +21,15 @@ from tensorflow.python.data.util import structure
 from tensorflow.python.ops import gen_experimental_dataset_ops as ged_ops
 
 
-def compress(element):
+def compress(element, compression="snappy"):
   """Compress a dataset element.
 
   Args:
     element: A nested structure of types supported by Tensorflow.
+    compression: (Optional.) One of "snappy", "none" or "auto". "none" stores
+      the element bytes uncompressed, which avoids spending CPU on elements
+      that do not compress well. "auto" compresses with snappy, but stores
+      elements uncompressed for as long as compression does not pay off.
 
   Returns:
     A variant tensor representing the compressed element. This variant can be
@@ -33,7 +37,7 @@ def compress(element):
   """
   element_spec = structure.type_spec_from_value(element)
   tensor_list = structure.to_tensor_list(element_spec, element)
-  return ged_ops.compress_element(tensor_list)
+  return ged_ops.compress_element(tensor_list, compression=compression)
 
 
 def uncompress(element, output_spec):
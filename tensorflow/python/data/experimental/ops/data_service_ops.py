@@ -35,11 +35,16 @@ from tensorflow.python.util.tf_export import tf_export
 
 class ProcessingMode(object):
   PARALLEL_EPOCHS = "parallel_epochs"
+  ONE_EPOCH = "one_epoch"
+  SHARED_EPOCHS = "shared_epochs"
 
   @staticmethod
   def validate(mode):
     """Raises a ValueError if the given object is not a valid processing mode."""
-    valid_modes = [ProcessingMode.PARALLEL_EPOCHS]
+    valid_modes = [
+        ProcessingMode.PARALLEL_EPOCHS, ProcessingMode.ONE_EPOCH,
+        ProcessingMode.SHARED_EPOCHS
+    ]
     if mode not in valid_modes:
       raise ValueError(
           "{0} is not a valid processing mode. Valid modes: {1}".format(
@@ -249,7 +254,8 @@ def _distribute(processing_mode,
                 service,
                 job_name=None,
                 max_outstanding_requests=None,
-                task_refresh_interval_hint_ms=None):
+                task_refresh_interval_hint_ms=None,
+                compression="auto"):
   """A transformation that moves dataset processing to the tf.data service.
 
   This transformation is similar to `distribute`, but supports additional
@@ -271,6 +277,8 @@ def _distribute(processing_mode,
       `max_outstanding_requests` of memory.
     task_refresh_interval_hint_ms: (Optional.) A hint for how often to query the
       dispatcher for task changes.
+    compression: (Optional.) How the tf.data workers compress dataset elements
+      before sending them over the network. See `_register_dataset`.
 
   Returns:
     Dataset: A `Dataset` of the elements produced by the data service.
@@ -278,7 +286,7 @@ def _distribute(processing_mode,
   ProcessingMode.validate(processing_mode)
 
   def _apply_fn(dataset):  # pylint: disable=missing-docstring
-    dataset_id = register_dataset(service, dataset)
+    dataset_id = _register_dataset(service, dataset, compression=compression)
     return _from_dataset_id(
         processing_mode,
         service,
@@ -303,7 +311,8 @@ def distribute(processing_mode,
   iteration.
 
   The `processing_mode` argument controls what data is produced by a tf.data
-  service job. Currently, the only supported mode is "parallel_epochs".
+  service job. The supported modes are "parallel_epochs", "one_epoch" and
+  "shared_epochs".
 
   processing_mode="parallel_epochs" means that multiple tf.data workers will
   iterate through the dataset in parallel, each producing all elements of the
@@ -314,9 +323,24 @@ def distribute(processing_mode,
   your dataset, so that different tf.data workers will iterate through the
   dataset in different orders.
 
-  In the future, there will be additional processing modes. For example,
-  a "one_epoch" mode which partitions the dataset across the tf.data
-  workers, so that the consumers see each element of the dataset only once.
+  processing_mode="one_epoch" partitions the dataset into splits which the
+  dispatcher hands out to the tf.data workers on demand, so that the consumers
+  see each element of the dataset once, and fast workers process more splits
+  than slow ones. Datasets reading from enough files are split by file;
+  other datasets are split by element, with each worker computing the whole
+  input pipeline and keeping its share, so the dataset must produce its
+  elements in the same order every time. Splits held by a worker which stops
+  responding are handed out to other workers, so elements the lost worker had
+  already produced from those splits may be seen twice.
+
+  processing_mode="shared_epochs" behaves like "parallel_epochs", except that
+  jobs reading the same dataset at the same time share the elements each
+  worker produces. This is useful when many consumers, such as the trials of a
+  hyperparameter search, read the same input pipeline: each worker computes
+  the pipeline once per epoch instead of once per job. Consumers sharing
+  elements see them in the same order, so randomness in the dataset is shared
+  as well. Elements are cached on the workers up to a configurable size, and a
+  job which falls too far behind the others computes the dataset on its own.
 
   ```
   dataset = tf.data.Dataset.range(5)
@@ -456,6 +480,30 @@ def register_dataset(service, dataset):
       "grpc://localhost:5000".
     dataset: A `tf.data.Dataset` to register with the tf.data service.
 
+  Returns:
+    A scalar int64 tensor of the registered dataset's id.
+  """
+  return _register_dataset(service, dataset)
+
+
+def _register_dataset(service, dataset, compression="auto"):
+  """Registers a dataset with the tf.data service.
+
+  This method is similar to `register_dataset`, but supports additional
+  parameters which we do not yet want to add to the public Python API.
+
+  Args:
+    service: A string indicating how to connect to the tf.data service. The
+      string should be in the format "protocol://address", e.g.
+      "grpc://localhost:5000".
+    dataset: A `tf.data.Dataset` to register with the tf.data service.
+    compression: (Optional.) How the tf.data workers compress dataset elements
+      before sending them over the network. One of "auto", "snappy" or "none".
+      "snappy" always compresses, which suits slow networks. "none" never
+      compresses, which saves worker and client CPU when the network is fast.
+      "auto" compresses, but stops trying while the elements do not compress
+      well.
+
   Returns:
     A scalar int64 tensor of the registered dataset's id.
   """
@@ -468,7 +516,8 @@ def register_dataset(service, dataset):
   # be sent over the network.
   # TODO(b/157105111): Make this an autotuned parallel map when we have a way
   # to limit memory usage.
-  dataset = dataset.map(lambda *x: compression_ops.compress(x))
+  dataset = dataset.map(
+      lambda *x: compression_ops.compress(x, compression=compression))
   # Prefetch one compressed element to reduce latency when requesting data
   # from tf.data workers.
   # TODO(b/157105111): Set this to autotune when we have a way to limit
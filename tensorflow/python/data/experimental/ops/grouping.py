@@ -244,6 +244,118 @@ def bucket_by_sequence_length(element_length_func,
     return _apply_fn
 
 
+@tf_export("data.experimental.bucket_by_token_budget")
+def bucket_by_token_budget(element_length_func,
+                           token_budget,
+                           max_padding_fraction=0.1,
+                           max_buckets=16,
+                           padding_values=None):
+  """A transformation that batches elements of similar length by token count.
+
+  Like `bucket_by_sequence_length`, this groups elements of similar length to
+  reduce padding, but it picks the bucket boundaries itself. It keeps a
+  histogram of the lengths seen so far and periodically recomputes the
+  boundaries, using the fewest buckets (at most `max_buckets`) of about equal
+  numbers of elements whose expected fraction of padding tokens is at most
+  `max_padding_fraction`.
+
+  Batches hold a fixed number of tokens rather than a fixed number of elements:
+  a bucket is emitted as soon as another element would make the number of
+  elements times the largest length in the batch exceed `token_budget`. An
+  element longer than `token_budget` forms a batch of its own. Each component
+  is padded to the largest size of each dimension in its batch.
+
+  ```python
+  dataset = dataset.apply(
+      tf.data.experimental.bucket_by_token_budget(
+          lambda tokens: tf.shape(tokens)[0], token_budget=4096))
+  ```
+
+  Args:
+    element_length_func: function from element in `Dataset` to `tf.int32` or
+      `tf.int64`, determines the length of the element.
+    token_budget: A `tf.int64` scalar `tf.Tensor`, representing the maximum
+      number of tokens in a batch.
+    max_padding_fraction: (Optional.) A `tf.float32` scalar `tf.Tensor` in
+      [0, 1), representing the largest fraction of padding tokens the bucket
+      boundaries should allow.
+    max_buckets: (Optional.) A `tf.int64` scalar `tf.Tensor`, representing the
+      maximum number of buckets.
+    padding_values: (Optional.) A (nested) structure of scalar-shaped
+      `tf.Tensor`, representing the padding values to use for the respective
+      components. Defaults to padding with 0 (or the empty string for
+      `tf.string` components).
+
+  Returns:
+    A `Dataset` transformation function, which can be passed to
+    `tf.data.Dataset.apply`.
+  """
+
+  def _apply_fn(dataset):
+    return _BucketByTokenBudgetDataset(dataset, element_length_func,
+                                       token_budget, max_padding_fraction,
+                                       max_buckets, padding_values)
+
+  return _apply_fn
+
+
+class _BucketByTokenBudgetDataset(dataset_ops.UnaryDataset):
+  """A `Dataset` that batches elements of similar length by token count."""
+
+  def __init__(self, input_dataset, element_length_func, token_budget,
+               max_padding_fraction, max_buckets, padding_values):
+    """See `bucket_by_token_budget()` for details."""
+
+    def check_types(component_spec):
+      if not isinstance(component_spec, tensor_spec.TensorSpec):
+        raise TypeError("Bucketing of components of type ",
+                        type(component_spec), " is not supported.")
+
+    nest.map_structure(check_types, input_dataset.element_spec)
+    # pylint: disable=protected-access
+    padding_values = dataset_ops._padding_values_or_default(
+        padding_values, input_dataset)
+    input_shapes = dataset_ops.get_legacy_output_shapes(input_dataset)
+    if nest.is_sequence(input_shapes) and not nest.is_sequence(padding_values):
+      padding_values = nest.map_structure(lambda _: padding_values,
+                                          input_shapes)
+    self._padding_values = nest.map_structure_up_to(
+        input_shapes, dataset_ops._padding_value_to_tensor, padding_values,
+        dataset_ops.get_legacy_output_types(input_dataset))
+    # pylint: enable=protected-access
+    self._token_budget = ops.convert_to_tensor(
+        token_budget, dtype=dtypes.int64, name="token_budget")
+    self._max_padding_fraction = ops.convert_to_tensor(
+        max_padding_fraction, dtype=dtypes.float32,
+        name="max_padding_fraction")
+    self._max_buckets = ops.convert_to_tensor(
+        max_buckets, dtype=dtypes.int64, name="max_buckets")
+    self._element_spec = nest.map_structure(
+        lambda spec: tensor_spec.TensorSpec(
+            tensor_shape.TensorShape([None]).concatenate(spec.shape),
+            spec.dtype), input_dataset.element_spec)
+
+    def add_length(*args):
+      length = math_ops.cast(element_length_func(*args), dtypes.int64)
+      return length, args
+
+    # The kernel reads the length of each element from its first component.
+    self._input_dataset = input_dataset.map(add_length)
+    variant_tensor = ged_ops.bucket_by_token_budget_dataset(
+        self._input_dataset._variant_tensor,  # pylint: disable=protected-access
+        token_budget=self._token_budget,
+        max_padding_fraction=self._max_padding_fraction,
+        max_buckets=self._max_buckets,
+        padding_values=nest.flatten(self._padding_values),
+        output_shapes=structure.get_flat_tensor_shapes(self._element_spec))
+    super(_BucketByTokenBudgetDataset, self).__init__(self._input_dataset,
+                                                      variant_tensor)
+
+  @property
+  def element_spec(self):
+    return self._element_spec
+
+
 class _GroupByReducerDataset(dataset_ops.UnaryDataset):
   """A `Dataset` that groups its input and performs a reduction."""
 
@@ -137,6 +137,18 @@ class OptimizationOptions(options.OptionsBase):
       "Whether to hoist `tf.random_uniform()` ops out of map transformations. "
       "If None, defaults to False.")
 
+  low_latency = options.create_option(
+      name="low_latency",
+      ty=bool,
+      docstring=
+      "Whether to optimize for the latency of each element rather than for "
+      "throughput, e.g. when preprocessing requests in online serving. Unless "
+      "set explicitly, this disables autotuning and the rewrites that move "
+      "work to background threads (`map_and_batch_fusion`, "
+      "`map_parallelization` and `parallel_batch`), and enables `map_fusion` "
+      "and `filter_fusion` so that chains of transformations run fewer "
+      "functions on the thread calling `GetNext`. If None, defaults to False.")
+
   map_and_batch_fusion = options.create_option(
       name="map_and_batch_fusion",
       ty=bool,
@@ -189,6 +201,14 @@ class OptimizationOptions(options.OptionsBase):
       "batching and b) you have validated that this optimization improves "
       "performance. If None, defaults to False.")
 
+  ragged_variant_elimination = options.create_option(
+      name="ragged_variant_elimination",
+      ty=bool,
+      docstring="Whether to eliminate the conversions of ragged tensors to and "
+      "from variants that cancel out once transformations are fused, e.g. "
+      "when a ragged tensor returned by one `map` function is consumed by the "
+      "next one. If None, defaults to True.")
+
   reorder_data_discarding_ops = options.create_option(
       name="reorder_data_discarding_ops",
       ty=bool,
@@ -227,6 +247,8 @@ class OptimizationOptions(options.OptionsBase):
     # Set these options if they are explicitly set by the user.
     if self.autotune is False:  # pylint: disable=g-bool-id-comparison
       autotune = False
+    elif self.autotune is None and self.low_latency:
+      autotune = False
     if self.autotune_cpu_budget is not None:
       cpu_budget = self.autotune_cpu_budget
 
@@ -257,6 +279,7 @@ class OptimizationOptions(options.OptionsBase):
         "map_fusion",
         "noop_elimination",
         "parallel_batch",
+        "ragged_variant_elimination",
         "reorder_data_discarding_ops",
         "shuffle_and_repeat_fusion",
     ]
@@ -267,10 +290,12 @@ class OptimizationOptions(options.OptionsBase):
       optimizations_to_disable = [
           "map_and_batch_fusion",
           "noop_elimination",
+          "ragged_variant_elimination",
           "shuffle_and_repeat_fusion",
       ]
       for optimization in optimizations_to_disable:
-        if getattr(self, optimization) is None:
+        if getattr(self, optimization) is None and not (
+            self.low_latency and optimization == "map_and_batch_fusion"):
           result.default.append(optimization)
 
     # Each of these attributes on the Options object is either True (explicitly
@@ -281,15 +306,28 @@ class OptimizationOptions(options.OptionsBase):
       elif getattr(self, optimization) is False:  # pylint: disable=g-bool-id-comparison
         result.disabled.append(optimization)
 
+    if self.low_latency:
+      # Unless the user has set them explicitly, run the pipeline in as few
+      # function calls as possible on the calling thread.
+      for optimization in ["filter_fusion", "map_fusion"]:
+        if getattr(self, optimization) is None:
+          result.enabled.append(optimization)
+      for optimization in [
+          "map_and_batch_fusion", "map_parallelization", "parallel_batch"
+      ]:
+        if getattr(self, optimization) is None:
+          result.disabled.append(optimization)
+
+    autotune, _, _ = self._autotune_settings()
     autotune_buffers = self._autotune_buffers()
-    if self.autotune is not False and autotune_buffers is True:  # pylint: disable=g-bool-id-comparison
+    if autotune and autotune_buffers is True:  # pylint: disable=g-bool-id-comparison
       # When autotuning buffer sizes is enabled, we inject a `prefetch`
       # transformation after asynchronous dataset ops. Only the buffer sizes of
       # prefetch transformations will be autotuned, though this is practically
       # equivalent to tuning the buffer sizes of the other asynchronous
       # transformations.
       result.enabled.append("inject_prefetch")
-    if self.autotune is False:  # pylint: disable=g-bool-id-comparison
+    if not autotune:
       result.disabled.append("inject_prefetch")
 
     return result
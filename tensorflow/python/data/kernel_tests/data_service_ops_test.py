@@ -53,10 +53,11 @@ def _address_from_target(target):
 def _make_distributed_dataset(dataset,
                               dispatcher,
                               job_name=None,
-                              max_outstanding_requests=None):
+                              max_outstanding_requests=None,
+                              processing_mode="parallel_epochs"):
   return dataset.apply(
       data_service_ops._distribute(
-          "parallel_epochs",
+          processing_mode,
           dispatcher.target,
           job_name=job_name,
           max_outstanding_requests=max_outstanding_requests,
@@ -329,6 +330,53 @@ class DataServiceOpsTest(test_base.DatasetTestBase, parameterized.TestCase):
     results = [elem.numpy() for elem in ds]
     self.assertCountEqual(num_workers * list(range(num_elements)), results)
 
+  @combinations.generate(test_base.eager_only_combinations())
+  def testOneEpoch(self):
+    dispatcher, workers = self.start_cluster(1)  # to avoid gcing workers, pylint: disable=unused-variable
+    num_elements = 100
+    ds = _make_distributed_dataset(
+        dataset_ops.Dataset.range(num_elements),
+        dispatcher,
+        processing_mode="one_epoch")
+    results = [elem.numpy() for elem in ds]
+    self.assertCountEqual(list(range(num_elements)), results)
+
+  @combinations.generate(test_base.eager_only_combinations())
+  def testOneEpochMultiWorker(self):
+    num_workers = 3
+    dispatcher, workers = self.start_cluster(num_workers)  # to avoid gcing workers, pylint: disable=unused-variable
+    num_elements = 100
+    ds = _make_distributed_dataset(
+        dataset_ops.Dataset.range(num_elements),
+        dispatcher,
+        processing_mode="one_epoch")
+    results = [elem.numpy() for elem in ds]
+    self.assertCountEqual(list(range(num_elements)), results)
+
+  @combinations.generate(test_base.eager_only_combinations())
+  def testSharedEpochs(self):
+    num_workers = 2
+    dispatcher, workers = self.start_cluster(num_workers)  # to avoid gcing workers, pylint: disable=unused-variable
+    num_elements = 100
+    ds1 = _make_distributed_dataset(
+        dataset_ops.Dataset.range(num_elements),
+        dispatcher,
+        processing_mode="shared_epochs")
+    ds2 = _make_distributed_dataset(
+        dataset_ops.Dataset.range(num_elements),
+        dispatcher,
+        processing_mode="shared_epochs")
+    iter1 = iter(ds1)
+    iter2 = iter(ds2)
+    results1 = []
+    results2 = []
+    for _ in range(num_workers * num_elements):
+      results1.append(next(iter1).numpy())
+      results2.append(next(iter2).numpy())
+    expected = num_workers * list(range(num_elements))
+    self.assertCountEqual(expected, results1)
+    self.assertCountEqual(expected, results2)
+
   @combinations.generate(test_base.eager_only_combinations())
   def testStartServersLate(self):
     # Test that the data service client performs retries instead of failing when
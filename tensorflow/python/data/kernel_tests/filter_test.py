@@ -35,6 +35,9 @@ def _test_combinations():
   def filter_fn(dataset, predicate):
     return dataset.filter(predicate)
 
+  def parallel_filter_fn(dataset, predicate):
+    return dataset.filter(predicate, num_parallel_calls=2)
+
   def legacy_filter_fn(dataset, predicate):
     return dataset.filter_with_legacy_function(predicate)
 
@@ -43,13 +46,20 @@ def _test_combinations():
       mode=["eager", "graph"],
       apply_filter=combinations.NamedObject("filter_fn", filter_fn))
 
+  parallel_filter_combinations = combinations.combine(
+      tf_api_version=[1, 2],
+      mode=["eager", "graph"],
+      apply_filter=combinations.NamedObject("parallel_filter_fn",
+                                            parallel_filter_fn))
+
   legacy_filter_combinations = combinations.combine(
       tf_api_version=1,
       mode=["eager", "graph"],
       apply_filter=combinations.NamedObject("legacy_filter_fn",
                                             legacy_filter_fn))
 
-  return filter_combinations + legacy_filter_combinations
+  return (filter_combinations + parallel_filter_combinations +
+          legacy_filter_combinations)
 
 
 class FilterTest(test_base.DatasetTestBase, parameterized.TestCase):
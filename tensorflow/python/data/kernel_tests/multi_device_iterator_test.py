@@ -18,6 +18,8 @@ from __future__ import absolute_import
 from __future__ import division
 from __future__ import print_function
 
+import os
+
 from absl.testing import parameterized
 import numpy as np
 
@@ -260,6 +262,31 @@ class MultiDeviceIteratorTest(test_base.DatasetTestBase,
         self.evaluate(elem_on_1)
         self.evaluate(elem_on_2)
 
+  @combinations.generate(skip_v2_test_combinations())
+  def testPinnedStagingGpu(self):
+    if not test_util.is_gpu_available():
+      self.skipTest("No GPU available")
+
+    with test.mock.patch.dict(
+        os.environ, {"TF_DATA_MULTI_DEVICE_ITERATOR_PINNED_STAGING": "true"}):
+      dataset = dataset_ops.Dataset.range(10).map(
+          lambda x: (x, array_ops.fill([16], x)))
+      multi_device_iterator = multi_device_iterator_ops.MultiDeviceIterator(
+          dataset, ["/cpu:1", "/gpu:0"])
+
+      config = config_pb2.ConfigProto(device_count={"CPU": 2, "GPU": 1})
+      with self.test_session(config=config):
+        self.evaluate(multi_device_iterator.initializer)
+        for i in range(0, 10, 2):
+          elem_on_1, elem_on_2 = multi_device_iterator.get_next()
+          for j, (x, y) in enumerate(self.evaluate([elem_on_1, elem_on_2])):
+            self.assertEqual(i + j, x)
+            self.assertAllEqual([i + j] * 16, y)
+        with self.assertRaises(errors.OutOfRangeError):
+          elem_on_1, elem_on_2 = multi_device_iterator.get_next()
+          self.evaluate(elem_on_1)
+          self.evaluate(elem_on_2)
+
   @combinations.generate(skip_v2_test_combinations())
   def testUnevenGpu(self):
     if not test_util.is_gpu_available():
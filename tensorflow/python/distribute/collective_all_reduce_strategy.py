@@ -106,7 +106,7 @@ class CollectiveAllReduceStrategy(distribute_lib.Strategy):
       communication: optional
         `tf.distribute.experimental.CollectiveCommunication`. This is a hint on
         the preferred collective communication implementation. Possible values
-        include `AUTO`, `RING`, and `NCCL`.
+        include `AUTO`, `RING`, `NCCL`, and `HIERARCHICAL`.
       cluster_resolver: optional
         `tf.distribute.cluster_resolver.ClusterResolver`. If `None`,
         `tf.distribute.cluster_resolver.TFConfigClusterResolver` is used.
@@ -913,6 +913,11 @@ class MultiWorkerAllReduce(AllReduceCrossDeviceOps):
                                       reduce_op)
 
 
+# Default pack size when all-reducing with CollectiveCommunication.HIERARCHICAL
+# and no `bytes_per_pack` hint is given.
+_HIERARCHICAL_BYTES_PER_PACK = 32 * 1024 * 1024
+
+
 @tf_export("distribute.experimental.CollectiveCommunication")
 class CollectiveCommunication(enum.Enum):
   """Communication choices for CollectiveOps.
@@ -922,10 +927,15 @@ class CollectiveCommunication(enum.Enum):
     all-gather.
   * `NCCL`: Use ncclAllReduce for all-reduce, and ring algorithms for
     all-gather.
+  * `HIERARCHICAL`: Use a two-level ring all-reduce that reduces within each
+    worker before reducing across workers, and ring algorithms for
+    all-gather. Requires the same number of devices on every worker and falls
+    back to `RING` otherwise.
   """
   AUTO = "AUTO"
   RING = "RING"
   NCCL = "NCCL"
+  HIERARCHICAL = "HIERARCHICAL"
   # TODO(ayushd): add ncclAllGather implementation.
 
 
@@ -1081,8 +1091,14 @@ class CollectiveAllReduce(CrossDeviceOps):
     # queuing time due to concurrent intense computation.
     #
     # TODO(b/147393503): explore solutions for optimal ordering.
+    bytes_per_pack = experimental_hints.bytes_per_pack
+    if (not bytes_per_pack and
+        self._communication == CollectiveCommunication.HIERARCHICAL):
+      # Bucket the values so that the all-reduce of the first buckets overlaps
+      # with the computation of the remaining ones.
+      bytes_per_pack = _HIERARCHICAL_BYTES_PER_PACK
     packs = cross_device_utils.pack_by_size(
-        list(reversed(per_replica_values)), experimental_hints.bytes_per_pack)
+        list(reversed(per_replica_values)), bytes_per_pack)
 
     if batch_size > 1:
       logging.info(
@@ -1099,6 +1115,11 @@ class CollectiveAllReduce(CrossDeviceOps):
 
     reduced_values = []
     with self._lock:
+      # Values are reduced in reverse order, so that the i-th value gets
+      # priority i and the first layers, which are needed first by the next
+      # step, are launched first when the runtime bounds concurrent
+      # reductions.
+      priority = batch_size
       for pack in packs:
         # By placing all CollectiveReduce ops in a pack under single name scope,
         # we ensure they will be picked up by the `ScopedAllocator` grappler
@@ -1112,6 +1133,7 @@ class CollectiveAllReduce(CrossDeviceOps):
               control_inputs = list(reduced_values[-1])
             else:
               control_inputs = None
+            priority -= 1
             reduced_values.append(
                 cross_device_utils.build_collective_reduce(
                     per_replica.values,
@@ -1123,7 +1145,8 @@ class CollectiveAllReduce(CrossDeviceOps):
                     communication,
                     control_inputs,
                     executors=self._executors,
-                    timeout=experimental_hints.timeout_seconds))
+                    timeout=experimental_hints.timeout_seconds,
+                    priority=priority))
 
     for e in self._executors:
       e.wait()
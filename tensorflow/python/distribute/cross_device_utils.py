@@ -22,6 +22,7 @@ import collections as pycoll
 import copy
 import threading
 
+from tensorflow.core.framework import attr_value_pb2
 from tensorflow.python.distribute import all_reduce
 from tensorflow.python.distribute import values as value_lib
 from tensorflow.python.eager import backprop
@@ -328,7 +329,8 @@ def build_collective_reduce(input_tensors,
                             communication_hint='AUTO',
                             control_inputs=None,
                             executors=None,
-                            timeout=None):
+                            timeout=None,
+                            priority=None):
   """Build a subgraph that does one full all-reduce, using the collective Op.
 
   If called in eager mode, it's required to supply a list of async executors for
@@ -350,6 +352,10 @@ def build_collective_reduce(input_tensors,
       (index-wise) corresponding collective_reduce tensors
     executors: a list of async executor. Required for eager execution.
     timeout: a float or None. The timeout in seconds.
+    priority: a non-negative int or None.  When the runtime bounds the number
+      of concurrent reductions, queued reductions with smaller priorities are
+      launched first.  Every worker must use the same priority for this
+      reduction.  Ignored in eager mode.
 
   Returns:
     An array of final tensors, one per device, computed by the full reduction.
@@ -393,6 +399,9 @@ def build_collective_reduce(input_tensors,
           subdiv_offsets,
           communication_hint,
           timeout=timeout)
+      if priority is not None and not context.executing_eagerly():
+        out_tensor.op._set_attr(  # pylint: disable=protected-access
+            '_collective_priority', attr_value_pb2.AttrValue(i=priority))
     out_tensors.append(out_tensor)
   return out_tensors
 
@@ -203,5 +203,27 @@ class PackBySizeTest(test.TestCase):
     self.assertEqual(packs[0], per_replica_values)
 
 
+class BuildCollectiveReduceTest(test.TestCase):
+
+  def testSetsPriority(self):
+    with ops.Graph().as_default():
+      devices = ["/cpu:0", "/cpu:1"]
+      inputs = [constant_op.constant(1.0), constant_op.constant(2.0)]
+      outputs = cross_device_utils.build_collective_reduce(
+          inputs, devices, 2, cross_device_utils.CollectiveKeys(), priority=3)
+      for output in outputs:
+        self.assertEqual(output.op.get_attr("_collective_priority"), 3)
+
+  def testNoPriorityByDefault(self):
+    with ops.Graph().as_default():
+      devices = ["/cpu:0", "/cpu:1"]
+      inputs = [constant_op.constant(1.0), constant_op.constant(2.0)]
+      outputs = cross_device_utils.build_collective_reduce(
+          inputs, devices, 2, cross_device_utils.CollectiveKeys())
+      for output in outputs:
+        with self.assertRaises(ValueError):
+          output.op.get_attr("_collective_priority")
+
+
 if __name__ == "__main__":
   test.main()
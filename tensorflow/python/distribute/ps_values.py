@@ -24,7 +24,14 @@ from tensorflow.python.distribute import distribute_lib
 from tensorflow.python.distribute import distribution_strategy_context as ds_context
 from tensorflow.python.distribute import values
 from tensorflow.python.distribute import values_util
+from tensorflow.python.eager import tape
+from tensorflow.python.framework import dtypes
 from tensorflow.python.framework import ops
+from tensorflow.python.ops import array_ops
+from tensorflow.python.ops import control_flow_ops
+from tensorflow.python.ops import custom_gradient
+from tensorflow.python.ops import gen_resource_variable_ops
+from tensorflow.python.ops import resource_variable_ops
 from tensorflow.python.ops import variable_scope as vs
 from tensorflow.python.ops import variables as variables_lib
 from tensorflow.python.training.tracking import base as trackable
@@ -310,3 +317,89 @@ def _tensor_conversion_aggregate(var, dtype=None, name=None, as_ref=False):
 
 ops.register_tensor_conversion_function(AggregatingVariable,
                                         _tensor_conversion_aggregate)
+
+
+class BoundedStalenessReader(object):
+  """Reads a variable through a local copy refreshed every few reads.
+
+  In PS training every step of every worker fetches the dense variables it
+  uses from the parameter servers.  A `BoundedStalenessReader` keeps a copy of
+  `variable` on the device that is current when it is created, typically the
+  worker, and refreshes it from `variable` once it has been served
+  `max_staleness` times.  The refresh lives in the untaken branch of a `cond`
+  on the other reads, so only a dead tensor crosses the network for them.
+
+  Gradients of the values read flow to `variable` as if it had been read
+  directly, so the optimizer still updates it every step.  They are computed
+  at a value up to `max_staleness` reads old, as with asynchronous training.
+
+  The local copy is a local variable, so in graph mode it is initialized along
+  with the other local variables.
+  """
+
+  def __init__(self, variable, max_staleness, name=None):
+    if max_staleness < 0:
+      raise ValueError(
+          "max_staleness must be non-negative, got %d" % max_staleness)
+    self._variable = variable
+    self._max_staleness = max_staleness
+    with ops.name_scope(name, "BoundedStalenessReader") as scope:
+      # Instantiating the variable classes directly bypasses the strategy's
+      # variable creator, which would place them on the parameter servers.
+      self._cache = resource_variable_ops.UninitializedVariable(
+          shape=variable.shape,
+          dtype=variable.dtype.base_dtype,
+          trainable=False,
+          name=scope + "cache")
+      # Number of reads served from `_cache` since it was refreshed.  Starts
+      # at `max_staleness` so that the first read refreshes it.
+      self._age = resource_variable_ops.ResourceVariable(
+          max_staleness,
+          dtype=dtypes.int64,
+          trainable=False,
+          collections=[ops.GraphKeys.LOCAL_VARIABLES],
+          name=scope + "age")
+
+  @property
+  def variable(self):
+    return self._variable
+
+  @property
+  def max_staleness(self):
+    return self._max_staleness
+
+  def read(self):
+    """Returns the value of the variable, at most `max_staleness` reads old."""
+    tape.variable_accessed(self._variable)
+
+    @custom_gradient.custom_gradient
+    def _read(handle):
+
+      def grad(dy):
+        return dy
+
+      return self._read_cached(handle), grad
+
+    return _read(self._variable.handle)
+
+  def _read_cached(self, handle):
+    """Reads the local copy, refreshing it from `handle` if too old."""
+
+    def cached():
+      value = self._cache.read_value()
+      with ops.control_dependencies([value]):
+        update = self._age.assign_add(1, read_value=False)
+      with ops.control_dependencies([update]):
+        return array_ops.identity(value)
+
+    def refresh():
+      with ops.device(self._variable.device):
+        value = gen_resource_variable_ops.read_variable_op(
+            handle, self._variable.dtype.base_dtype)
+      assign = self._cache.assign(value, read_value=False)
+      reset = self._age.assign(0, read_value=False)
+      with ops.control_dependencies([assign, reset]):
+        return array_ops.identity(value)
+
+    return control_flow_ops.cond(self._age.read_value() < self._max_staleness,
+                                 cached, refresh)
@@ -23,8 +23,10 @@ from absl.testing import parameterized
 from tensorflow.python.distribute import combinations
 from tensorflow.python.distribute import ps_values
 from tensorflow.python.distribute import strategy_combinations
+from tensorflow.python.eager import backprop
 from tensorflow.python.eager import def_function
 from tensorflow.python.eager import test
+from tensorflow.python.framework import test_util
 from tensorflow.python.ops import variable_scope
 from tensorflow.python.ops import variables as variables_lib
 
@@ -61,5 +63,49 @@ class AggregatingVariableTest(test.TestCase, parameterized.TestCase):
     self.assertAllEqual([3], per_replica_results)
 
 
+class BoundedStalenessReaderTest(test.TestCase):
+
+  def _initialize(self):
+    self.evaluate(variables_lib.global_variables_initializer())
+    self.evaluate(variables_lib.local_variables_initializer())
+
+  @test_util.run_in_graph_and_eager_modes
+  def testRefreshesAfterMaxStalenessReads(self):
+    v = variables_lib.Variable(1.)
+    reader = ps_values.BoundedStalenessReader(v, max_staleness=2)
+    read = def_function.function(reader.read)
+    self._initialize()
+    values = []
+    for _ in range(6):
+      values.append(self.evaluate(read()))
+      self.evaluate(v.assign_add(1.))
+    self.assertAllEqual([1., 1., 1., 4., 4., 4.], values)
+
+  @test_util.run_in_graph_and_eager_modes
+  def testZeroStalenessAlwaysRefreshes(self):
+    v = variables_lib.Variable([1., 2.])
+    reader = ps_values.BoundedStalenessReader(v, max_staleness=0)
+    read = def_function.function(reader.read)
+    self._initialize()
+    self.assertAllEqual([1., 2.], self.evaluate(read()))
+    self.evaluate(v.assign([3., 4.]))
+    self.assertAllEqual([3., 4.], self.evaluate(read()))
+
+  @test_util.run_in_graph_and_eager_modes
+  def testGradientFlowsToVariable(self):
+    v = variables_lib.Variable(3.)
+    reader = ps_values.BoundedStalenessReader(v, max_staleness=1)
+    self._initialize()
+    with backprop.GradientTape() as t:
+      y = reader.read() * 2.
+    self.assertAllEqual(6., self.evaluate(y))
+    self.assertAllEqual(2., self.evaluate(t.gradient(y, v)))
+
+  def testNegativeStaleness(self):
+    v = variables_lib.Variable(1.)
+    with self.assertRaisesRegex(ValueError, "max_staleness"):
+      ps_values.BoundedStalenessReader(v, max_staleness=-1)
+
+
 if __name__ == "__main__":
   test.main()
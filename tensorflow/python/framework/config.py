@@ -187,6 +187,11 @@ def set_optimizer_experimental_options(options):
         GPUs and above. Without the use of loss scaling, this can cause
         numerical underflow (see
         `keras.mixed_precision.experimental.LossScaleOptimizer`).
+      - auto_mixed_precision_cpu: Change certain float32 ops to bfloat16 on
+        CPUs. This is faster on CPUs with native bfloat16 support, such as
+        those with AVX512-BF16.
+      - horizontal_fusion: Fuse independent element-wise ops placed on a GPU
+        into a single multi-tensor kernel launch.
       - disable_meta_optimizer: Disable the entire meta optimizer.
       - min_graph_nodes: The minimum number of nodes in a graph to optimizer.
         For smaller graphs, optimization is skipped.
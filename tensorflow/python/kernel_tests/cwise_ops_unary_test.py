@@ -412,6 +412,25 @@ class UnaryOpTest(test.TestCase):
     self._compareBoth(x, compute_f32(np.cosh), math_ops.cosh)
     self._compareBoth(x, compute_f32(np.tanh), math_ops.tanh)
 
+  def testHalfAndBFloat16Large(self):
+    # Several blocks and a partial one of the float evaluation on CPU.
+    rng = np.random.RandomState(0)
+    x = rng.uniform(-4, 4, size=5000).astype(np.float32)
+    z = rng.uniform(0.1, 10, size=5000).astype(np.float32)
+    funcs = [(x, np.exp, math_ops.exp), (x, np.expm1, math_ops.expm1),
+             (z, np.log, math_ops.log), (z, np.log1p, math_ops.log1p),
+             (x, np.tanh, math_ops.tanh), (z, np.sqrt, math_ops.sqrt),
+             (x, np.sin, math_ops.sin), (x, np.cos, math_ops.cos),
+             (x, lambda v: 1 / (1 + np.exp(-v)), math_ops.sigmoid)]
+    for dtype, tol in ((np.float16, 1e-3),
+                       (dtypes_lib.bfloat16.as_numpy_dtype, 1e-2)):
+      for values, np_func, tf_func in funcs:
+        inputs = values.astype(dtype)
+        expected = np_func(inputs.astype(np.float32)).astype(dtype)
+        with self.cached_session(use_gpu=False):
+          result = self.evaluate(tf_func(inputs))
+        self.assertAllClose(expected, result, rtol=tol, atol=tol)
+
   def testInt8Basic(self):
     x = np.arange(-6, 6, 2).reshape(1, 3, 2).astype(np.int8)
     self._compareCpu(x, np.abs, math_ops.abs)
@@ -24,6 +24,8 @@ import numpy as np
 
 from tensorflow.python.framework import errors_impl
 from tensorflow.python.framework import test_util
+from tensorflow.python.ops import array_ops
+from tensorflow.python.ops import gen_image_ops
 from tensorflow.python.ops import image_ops
 from tensorflow.python.ops import io_ops
 import tensorflow.python.ops.nn_grad  # pylint: disable=unused-import
@@ -97,6 +99,41 @@ class DecodeImageOpTest(test.TestCase):
       with self.assertRaises(errors_impl.InvalidArgumentError):
         self.evaluate(bad_channels)
 
+  def testJpegBatch(self):
+    names = ["jpeg_merge_test1.jpg", "small.jpg", "medium.jpg"]
+    for channels, ratio in (1, 1), (3, 1), (3, 2), (3, 8):
+      with self.cached_session(use_gpu=True):
+        jpegs = [
+            io_ops.read_file(os.path.join(prefix_path, "jpeg", "testdata", n))
+            for n in names
+        ]
+        batch, sizes = gen_image_ops.decode_jpeg_batch(
+            array_ops.stack(jpegs), channels=channels, ratio=ratio)
+        images = [
+            image_ops.decode_jpeg(jpeg, channels=channels, ratio=ratio)
+            for jpeg in jpegs
+        ]
+        batch, sizes, images = self.evaluate([batch, sizes, images])
+        self.assertEqual(batch.shape[0], len(names))
+        self.assertEqual(batch.shape[3], channels)
+        for i, image in enumerate(images):
+          height, width = image.shape[:2]
+          self.assertAllEqual(sizes[i], [height, width])
+          self.assertAllEqual(batch[i, :height, :width], image)
+          padding = batch[i].copy()
+          padding[:height, :width] = 0
+          self.assertAllEqual(padding, np.zeros_like(padding))
+        self.assertEqual(batch.shape[1], max(i.shape[0] for i in images))
+        self.assertEqual(batch.shape[2], max(i.shape[1] for i in images))
+
+  def testJpegBatchInvalidImage(self):
+    path = os.path.join(prefix_path, "jpeg", "testdata", "small.jpg")
+    with self.cached_session():
+      jpegs = array_ops.stack([io_ops.read_file(path), "ThisIsNotAnImage!"])
+      with self.assertRaisesRegexp(errors_impl.InvalidArgumentError,
+                                   "image 1"):
+        self.evaluate(gen_image_ops.decode_jpeg_batch(jpegs))
+
   def testPng(self):
     # Read some real PNGs, converting to different channel numbers
     inputs = [(1, "lena_gray.png")]
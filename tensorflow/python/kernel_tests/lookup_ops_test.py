@@ -41,6 +41,7 @@ from tensorflow.python.framework import sparse_tensor
 from tensorflow.python.framework import test_util
 from tensorflow.python.ops import array_ops
 from tensorflow.python.ops import control_flow_ops
+from tensorflow.python.ops import gen_lookup_ops
 from tensorflow.python.ops import lookup_ops
 from tensorflow.python.ops import map_fn
 from tensorflow.python.ops import string_ops
@@ -3535,6 +3536,112 @@ class MutableHashTableOpTest(test.TestCase):
       result = self.evaluate(output)
       self.assertAllEqual((b"brain", b"salad", b"n/a"), result)
 
+  def testMutableHashTableLargeBatch(self):
+    with self.cached_session():
+      # Large enough to update and look up the shards in parallel.
+      num_keys = 20000
+      keys = np.arange(num_keys, dtype=np.int64) * 3
+      table = lookup_ops.MutableHashTable(dtypes.int64, dtypes.int64, -1)
+
+      self.evaluate(table.insert(keys, keys + 1))
+      self.assertAllEqual(num_keys, self.evaluate(table.size()))
+      self.evaluate(table.remove(keys[::2]))
+      self.assertAllEqual(num_keys // 2, self.evaluate(table.size()))
+
+      expected = keys + 1
+      expected[::2] = -1
+      self.assertAllEqual(expected, self.evaluate(table.lookup(keys)))
+
+      exported_keys, exported_values = self.evaluate(table.export())
+      self.assertAllEqual(sorted(keys[1::2]), sorted(exported_keys))
+      self.assertAllEqual(exported_keys + 1, exported_values)
+
+
+class MemmappedTableOpTest(test.TestCase):
+
+  def _writeTable(self, basename, keys, values):
+    filename = os.path.join(self.get_temp_dir(), basename)
+    self.evaluate(gen_lookup_ops.write_memmapped_table(filename, keys, values))
+    return filename
+
+  def testStringToInt64(self):
+    filename = self._writeTable(
+        "string_to_int64.tbl", constant_op.constant(["salad", "brain", "tank"]),
+        constant_op.constant([1, 0, 2], dtypes.int64))
+    table = gen_lookup_ops.memmapped_table_v2(
+        key_dtype=dtypes.string, value_dtype=dtypes.int64, filename=filename)
+    self.assertAllEqual(3, self.evaluate(gen_lookup_ops.lookup_table_size_v2(
+        table)))
+
+    output = gen_lookup_ops.lookup_table_find_v2(
+        table, constant_op.constant(["brain", "surgery", "tank", "a", "z"]),
+        constant_op.constant(-1, dtypes.int64))
+    self.assertAllEqual([0, -1, 2, -1, -1], self.evaluate(output))
+
+    exported_keys, exported_values = self.evaluate(
+        gen_lookup_ops.lookup_table_export_v2(table, dtypes.string,
+                                              dtypes.int64))
+    self.assertAllEqual([b"brain", b"salad", b"tank"], exported_keys)
+    self.assertAllEqual([0, 1, 2], exported_values)
+
+  def testInt64ToString(self):
+    filename = self._writeTable(
+        "int64_to_string.tbl", constant_op.constant([7, -3, 11], dtypes.int64),
+        constant_op.constant(["seven", "", "eleven"]))
+    table = gen_lookup_ops.memmapped_table_v2(
+        key_dtype=dtypes.int64, value_dtype=dtypes.string, filename=filename)
+
+    output = gen_lookup_ops.lookup_table_find_v2(
+        table, constant_op.constant([[11, -3], [0, 7]], dtypes.int64),
+        constant_op.constant("n/a"))
+    self.assertAllEqual([[b"eleven", b""], [b"n/a", b"seven"]],
+                        self.evaluate(output))
+
+  def testTablesOfSameFileWithDifferentTypes(self):
+    filename = self._writeTable(
+        "float_values.tbl", constant_op.constant([1, 2], dtypes.int64),
+        constant_op.constant([0.5, 1.5], dtypes.float32))
+    table = gen_lookup_ops.memmapped_table_v2(
+        key_dtype=dtypes.int64, value_dtype=dtypes.float32, filename=filename)
+    self.assertAllClose([1.5], self.evaluate(
+        gen_lookup_ops.lookup_table_find_v2(
+            table, constant_op.constant([2], dtypes.int64),
+            constant_op.constant(0.0))))
+
+    with self.assertRaisesOpError("maps int64 keys to float values"):
+      table = gen_lookup_ops.memmapped_table_v2(
+          key_dtype=dtypes.int64, value_dtype=dtypes.int64, filename=filename)
+      self.evaluate(gen_lookup_ops.lookup_table_size_v2(table))
+
+  def testDuplicateKeys(self):
+    filename = os.path.join(self.get_temp_dir(), "duplicate_keys.tbl")
+    with self.assertRaisesOpError("Duplicate key in MemmappedTable: 3"):
+      self.evaluate(
+          gen_lookup_ops.write_memmapped_table(
+              filename, constant_op.constant([3, 1, 3], dtypes.int64),
+              constant_op.constant([0, 1, 2], dtypes.int64)))
+
+  def testReadOnly(self):
+    filename = self._writeTable("read_only.tbl",
+                                constant_op.constant([1], dtypes.int64),
+                                constant_op.constant([1], dtypes.int64))
+    table = gen_lookup_ops.memmapped_table_v2(
+        key_dtype=dtypes.int64, value_dtype=dtypes.int64, filename=filename)
+    with self.assertRaisesOpError("MemmappedTable is read-only"):
+      self.evaluate(
+          gen_lookup_ops.lookup_table_insert_v2(
+              table, constant_op.constant([2], dtypes.int64),
+              constant_op.constant([2], dtypes.int64)))
+
+  def testInvalidFile(self):
+    filename = os.path.join(self.get_temp_dir(), "invalid.tbl")
+    with open(filename, "w") as f:
+      f.write("brain\t0\nsalad\t1\n" * 4)
+    with self.assertRaisesOpError("invalid magic number"):
+      table = gen_lookup_ops.memmapped_table_v2(
+          key_dtype=dtypes.string, value_dtype=dtypes.int64, filename=filename)
+      self.evaluate(gen_lookup_ops.lookup_table_size_v2(table))
+
 
 class MutableHashTableBenchmark(test.Benchmark):
 
@@ -3583,6 +3690,15 @@ class MutableHashTableBenchmark(test.Benchmark):
       self.run_op_benchmark(sess, insert, burn_iters=10, min_iters=1000)
       assert sess.run(size) >= 1000 * 32
 
+  def benchmark_batch_16384_lookup_scalar(self):
+    table = self._create_table()
+    keys = np.arange(16384, dtype=np.int64)
+    insert = table.insert(keys, np.ones(16384, dtype=np.float32))
+    lookup = table.lookup(keys)
+    with session.Session() as sess:
+      sess.run(insert)
+      self.run_op_benchmark(sess, lookup, burn_iters=10, min_iters=1000)
+
 
 class DenseHashTableBenchmark(MutableHashTableBenchmark):
 
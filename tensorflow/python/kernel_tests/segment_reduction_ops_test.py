@@ -536,7 +536,9 @@ class SparseSegmentReductionOpTest(SparseSegmentReductionHelper):
     # Each item is np_op1, np_op2, tf_op
     ops_list = [(np.add, None, math_ops.sparse_segment_sum),
                 (self._mean_cum_op, self._mean_reduce_op,
-                 math_ops.sparse_segment_mean)]
+                 math_ops.sparse_segment_mean),
+                (self._mean_cum_op, self._sqrt_n_reduce_op,
+                 math_ops.sparse_segment_sqrt_n)]
 
     n = 400
     shape = [n, 2]
@@ -548,27 +550,30 @@ class SparseSegmentReductionOpTest(SparseSegmentReductionHelper):
     for dtype in dtypes:
       for index_dtype in index_dtypes:
         for segment_ids_dtype in segment_ids_dtypes:
-          with self.cached_session(use_gpu=False):
-            tf_indices, np_indices, tf_x, np_x = self._sparse_input(
-                shape, num_indices, dtype=dtype)
-            for np_op1, np_op2, tf_op in ops_list:
-              if (tf_op == math_ops.sparse_segment_mean
-                  and dtype not in mean_dtypes):
-                continue
-              np_ans = self._sparseSegmentReduce(np_x, np_indices,
-                                                 segment_indices, np_op1,
-                                                 np_op2)
-              s = tf_op(
-                  data=tf_x,
-                  indices=math_ops.cast(tf_indices, index_dtype),
-                  segment_ids=math_ops.cast(segment_indices, segment_ids_dtype))
-              tf_ans = self.evaluate(s)
-              self.assertAllClose(np_ans, tf_ans)
-              # NOTE(mrry): The static shape inference that computes
-              # `tf_ans.shape` can only infer that sizes from dimension 1
-              # onwards, because the size of dimension 0 is data-dependent
-              # and may therefore vary dynamically.
-              self.assertAllEqual(np_ans.shape[1:], tf_ans.shape[1:])
+          for use_gpu in [True, False]:
+            with self.cached_session(use_gpu=use_gpu):
+              tf_indices, np_indices, tf_x, np_x = self._sparse_input(
+                  shape, num_indices, dtype=dtype)
+              for np_op1, np_op2, tf_op in ops_list:
+                if (tf_op in (math_ops.sparse_segment_mean,
+                              math_ops.sparse_segment_sqrt_n)
+                    and dtype not in mean_dtypes):
+                  continue
+                np_ans = self._sparseSegmentReduce(np_x, np_indices,
+                                                   segment_indices, np_op1,
+                                                   np_op2)
+                s = tf_op(
+                    data=tf_x,
+                    indices=math_ops.cast(tf_indices, index_dtype),
+                    segment_ids=math_ops.cast(segment_indices,
+                                              segment_ids_dtype))
+                tf_ans = self.evaluate(s)
+                self.assertAllClose(np_ans, tf_ans)
+                # NOTE(mrry): The static shape inference that computes
+                # `tf_ans.shape` can only infer that sizes from dimension 1
+                # onwards, because the size of dimension 0 is data-dependent
+                # and may therefore vary dynamically.
+                self.assertAllEqual(np_ans.shape[1:], tf_ans.shape[1:])
 
   def testSegmentIdsHole(self):
     tf_x, np_x = self._input([10, 4], dtype=dtypes_lib.float32)
@@ -576,13 +581,14 @@ class SparseSegmentReductionOpTest(SparseSegmentReductionHelper):
         self._mean_cum_op, self._mean_reduce_op, math_ops.sparse_segment_mean)]
     segment_indices = [0, 2, 2, 2]
     tf_indices = [8, 3, 0, 9]
-    with self.session(use_gpu=False):
-      for np_op1, np_op2, tf_op in ops_list:
-        np_ans = self._sparseSegmentReduce(np_x, tf_indices, segment_indices,
-                                           np_op1, np_op2)
-        s = tf_op(data=tf_x, indices=tf_indices, segment_ids=segment_indices)
-        tf_ans = self.evaluate(s)
-        self.assertAllClose(np_ans, tf_ans)
+    for use_gpu in [True, False]:
+      with self.session(use_gpu=use_gpu):
+        for np_op1, np_op2, tf_op in ops_list:
+          np_ans = self._sparseSegmentReduce(np_x, tf_indices,
+                                             segment_indices, np_op1, np_op2)
+          s = tf_op(data=tf_x, indices=tf_indices, segment_ids=segment_indices)
+          tf_ans = self.evaluate(s)
+          self.assertAllClose(np_ans, tf_ans)
 
   def testWithNumSegments(self):
     tf_x, np_x = self._input([10, 4], dtype=dtypes_lib.float32)
@@ -592,22 +598,23 @@ class SparseSegmentReductionOpTest(SparseSegmentReductionHelper):
     segment_indices = [0, 2, 2, 2]
     tf_indices = [8, 3, 0, 9]
     num_segments = 5
-    with self.session(use_gpu=False):
-      for np_op1, np_op2, tf_op in ops_list:
-        np_ans = self._sparseSegmentReduce(
-            np_x,
-            tf_indices,
-            segment_indices,
-            np_op1,
-            np_op2,
-            num_segments=num_segments)
-        s = tf_op(
-            data=tf_x,
-            indices=tf_indices,
-            segment_ids=segment_indices,
-            num_segments=num_segments)
-        tf_ans = self.evaluate(s)
-        self.assertAllClose(np_ans, tf_ans)
+    for use_gpu in [True, False]:
+      with self.session(use_gpu=use_gpu):
+        for np_op1, np_op2, tf_op in ops_list:
+          np_ans = self._sparseSegmentReduce(
+              np_x,
+              tf_indices,
+              segment_indices,
+              np_op1,
+              np_op2,
+              num_segments=num_segments)
+          s = tf_op(
+              data=tf_x,
+              indices=tf_indices,
+              segment_ids=segment_indices,
+              num_segments=num_segments)
+          tf_ans = self.evaluate(s)
+          self.assertAllClose(np_ans, tf_ans)
 
   def testWithEmptySegments(self):
     tf_x = constant_op.constant([], shape=[0, 4], dtype=dtypes_lib.float32)
@@ -618,15 +625,16 @@ class SparseSegmentReductionOpTest(SparseSegmentReductionHelper):
     segment_indices = []
     tf_indices = []
     num_segments = 5
-    with self.session(use_gpu=False):
-      for tf_op in ops_list:
-        s = tf_op(
-            data=tf_x,
-            indices=tf_indices,
-            segment_ids=segment_indices,
-            num_segments=num_segments)
-        tf_ans = self.evaluate(s)
-        self.assertAllClose(np.zeros([5, 4]), tf_ans)
+    for use_gpu in [True, False]:
+      with self.session(use_gpu=use_gpu):
+        for tf_op in ops_list:
+          s = tf_op(
+              data=tf_x,
+              indices=tf_indices,
+              segment_ids=segment_indices,
+              num_segments=num_segments)
+          tf_ans = self.evaluate(s)
+          self.assertAllClose(np.zeros([5, 4]), tf_ans)
 
   def testSegmentIdsGreaterThanZero(self):
     tf_x, np_x = self._input([10, 4], dtype=dtypes_lib.float32)
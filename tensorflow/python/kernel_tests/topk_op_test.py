@@ -165,6 +165,32 @@ class TopKTest(test.TestCase):
       values = -np.sort(-inputs, axis=1)[:, :k]
       self._validateTopK(inputs, k, values, indices)
 
+  def _testLargeRowTopK(self, dtype):
+    # Few rows with many columns, which are selected by shards of columns on
+    # CPU and by the radix select on GPU.
+    b = 2
+    n = 1 << 17
+    k = 1000
+    inputs = np.random.permutation(
+        np.linspace(0, 100, b * n, dtype=dtype)).reshape(b, n)
+    indices = np.argsort(-inputs, axis=1)[:, :k]
+    values = -np.sort(-inputs, axis=1)[:, :k]
+    self._validateTopK(inputs, k, values, indices)
+
+  def testLargeRowTopK(self):
+    self._testLargeRowTopK(np.float32)
+    self._testLargeRowTopK(np.float64)
+
+  def testStableSortOfLargeRow(self):
+    b = 2
+    n = 1 << 17
+    for k in [100, 1000]:
+      inputs = np.random.permutation(
+          np.linspace(0, 3, b * n, dtype=np.int32)).reshape(b, n)
+      indices = np.argsort(-inputs, axis=1, kind="mergesort")[:, :k]
+      values = -np.sort(-inputs, axis=1)[:, :k]
+      self._validateTopK(inputs, k, values, indices)
+
   def testTopAll(self):
     inputs = [[0.1, 0.3, 0.2, 0.4], [0.1, 0.3, 0.3, 0.2]]
     self._validateTopK(inputs, 4, [[0.4, 0.3, 0.2, 0.1], [0.3, 0.3, 0.2, 0.1]],
@@ -86,6 +86,17 @@ class UniqueTest(test.TestCase):
     for i in range(len(x)):
       self.assertEqual(x[i], tf_y[tf_idx[i]])
 
+  def testInt64Large(self):
+    # Large enough to be uniquified on several threads on CPU.
+    x = np.random.randint(-1000, high=1000, size=100000).astype(np.int64)
+    y, idx = array_ops.unique(x)
+    tf_y, tf_idx = self.evaluate([y, idx])
+
+    # The unique elements are in the order of their first occurrence.
+    _, first = np.unique(x, return_index=True)
+    self.assertAllEqual(x[np.sort(first)], tf_y)
+    self.assertAllEqual(x, tf_y[tf_idx])
+
   def testBool(self):
     x = np.random.choice([True, False], size=7000)
     y, idx = array_ops.unique(x)
@@ -208,6 +219,17 @@ class UniqueWithCountsTest(test.TestCase):
     for value, count in zip(tf_y, tf_count):
       self.assertEqual(count, np.sum(x == value))
 
+  def testInt64Large(self):
+    x = np.random.randint(0, high=5000, size=100000).astype(np.int64)
+    y, idx, count = gen_array_ops.unique_with_counts(x, out_idx=dtypes.int64)
+    tf_y, tf_idx, tf_count = self.evaluate([y, idx, count])
+
+    _, first, counts = np.unique(x, return_index=True, return_counts=True)
+    order = np.argsort(first)
+    self.assertAllEqual(x[first[order]], tf_y)
+    self.assertAllEqual(counts[order], tf_count)
+    self.assertAllEqual(x, tf_y[tf_idx])
+
   def testFloat(self):
     # NOTE(mrry): The behavior when a key is NaN is inherited from
     # `std::unordered_map<float, ...>`: each NaN becomes a unique key in the
@@ -28,7 +28,8 @@ def all_reduce(t,
                final_op,
                subdiv_offsets=(0,),
                communication_hint='auto',
-               timeout=0):
+               timeout=0,
+               compression='none'):
   """Reduces tensors collectively, across devices.
 
   Args:
@@ -50,6 +51,10 @@ def all_reduce(t,
     timeout: If set to a non zero, set a completion timeout to detect staleness.
       If the timer goes off, a DeadlineExceededError is raised.
       The timeout value in seconds. This feature is experimental.
+    compression: how float and double values are encoded when sent between
+      devices of the ring implementation.  One of `none`, `fp16` and `bf16`.
+      Lossy: the casts round every partial reduction. This feature is
+      experimental.
 
   Returns:
     An Op implementing the distributed reduction.
@@ -68,7 +73,8 @@ def all_reduce(t,
       final_op=final_op,
       subdiv_offsets=subdiv_offsets,
       communication_hint=communication_hint.lower(),
-      timeout_seconds=timeout)
+      timeout_seconds=timeout,
+      compression=compression)
 
 
 def all_gather(t,
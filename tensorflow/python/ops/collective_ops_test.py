@@ -57,7 +57,8 @@ class CollectiveOpTest(test.TestCase):
                             merge_op='Add',
                             final_op='Div',
                             timeout=0,
-                            reported_group_size=None):
+                            reported_group_size=None,
+                            compression='none'):
     group_key = 1
     group_size = len(inputs)
     if reported_group_size is None:
@@ -81,12 +82,15 @@ class CollectiveOpTest(test.TestCase):
                   merge_op,
                   final_op,
                   communication_hint=communication_hint,
-                  timeout=timeout))
+                  timeout=timeout,
+                  compression=compression))
       run_options = config_pb2.RunOptions()
       if set_graph_key:
         run_options.experimental.collective_graph_key = 1
       results = sess.run(colred, options=run_options)
-    tolerance = 1e-3 if fp16 else 1e-5
+    tolerance = 1e-3 if fp16 or compression == 'fp16' else 1e-5
+    if compression == 'bf16':
+      tolerance = 1e-2
     for i in range(group_size):
       logging.info('i {} result {} expected {}'.format(i, results[i], expected))
       self.assertAllClose(results[i], expected, rtol=tolerance, atol=tolerance)
@@ -137,6 +141,19 @@ class CollectiveOpTest(test.TestCase):
           set_graph_key=True,
           fp16=True)
 
+  def testCompressedReduce(self):
+    # Tests that execute collectives need to be enclosed in graph or tf.function
+    for instance_key, compression in ((50, 'fp16'), (51, 'bf16')):
+      with ops.Graph().as_default():
+        self._testCollectiveReduce(
+            inputs=[[0.1, 1.1, 2.1, 3.1, 4.1, 5.1, 6.1, 7.1],
+                    [0.3, 1.3, 2.3, 3.3, 4.3, 5.3, 6.3, 7.3]],
+            expected=[0.2, 1.2, 2.2, 3.2, 4.2, 5.2, 6.2, 7.2],
+            set_graph_key=True,
+            instance_key=instance_key,
+            communication_hint='ring',
+            compression=compression)
+
   def testCollectiveMultipleConcurrentReduce(self):
     # Tests that execute collectives need to be enclosed in graph or tf.function
     with ops.Graph().as_default():
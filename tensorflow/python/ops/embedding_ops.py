@@ -27,9 +27,11 @@ from tensorflow.python.framework import sparse_tensor
 from tensorflow.python.framework import tensor_shape
 from tensorflow.python.ops import array_ops
 from tensorflow.python.ops import clip_ops
+from tensorflow.python.ops import control_flow_util
 # Imports gradient definitions.
 from tensorflow.python.ops import data_flow_grad  # pylint: disable=unused-import
 from tensorflow.python.ops import data_flow_ops
+from tensorflow.python.ops import gen_math_ops
 from tensorflow.python.ops import math_ops
 from tensorflow.python.ops import resource_variable_ops
 from tensorflow.python.ops import sparse_ops
@@ -505,6 +507,20 @@ def embedding_lookup_sparse(params,
                       params + [sp_ids]) as name:
     segment_ids = sp_ids.indices[:, 0]
 
+    if _can_fuse_embedding_lookup_sparse(params, sp_ids, max_norm):
+      dtype = params[0].dtype.base_dtype
+      if ignore_weights:
+        weights = array_ops.zeros([0], dtype=dtype)
+      else:
+        weights = math_ops.cast(sp_weights.values, dtype)
+      return gen_math_ops.fused_embedding_lookup_sparse(
+          params[0],
+          sp_ids.values,
+          segment_ids,
+          weights,
+          combiner=combiner,
+          name=name)
+
     ids = sp_ids.values
     ids, idx = array_ops.unique(ids)
 
@@ -577,6 +593,23 @@ def embedding_lookup_sparse(params,
     return embeddings
 
 
+def _can_fuse_embedding_lookup_sparse(params, sp_ids, max_norm):
+  """Whether FusedEmbeddingLookupSparse can replace the gather and reduction.
+
+  The fused op looks up the rows of a single, unpartitioned tensor and
+  accumulates them directly into their segments, without materializing the
+  gathered rows. It has no XLA kernel.
+  """
+  if len(params) != 1 or max_norm is not None:
+    return False
+  if params[0].dtype.base_dtype not in (dtypes.float32, dtypes.float64):
+    return False
+  if sp_ids.values.dtype not in (dtypes.int32, dtypes.int64):
+    return False
+  return not control_flow_util.GraphOrParentsInXlaContext(
+      ops.get_default_graph())
+
+
 @tf_export("nn.embedding_lookup_sparse", v1=[])
 @dispatch.add_dispatch_support
 def embedding_lookup_sparse_v2(params,
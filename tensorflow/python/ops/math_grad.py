@@ -387,6 +387,48 @@ def _SparseSegmentSqrtNWithNumSegmentsGrad(op, grad):
                                               dim0), None, None, None)
 
 
+@ops.RegisterGradient("FusedEmbeddingLookupSparse")
+def _FusedEmbeddingLookupSparseGrad(op, grad):
+  """Gradient for FusedEmbeddingLookupSparse."""
+  params, ids, segment_ids, weights = op.inputs
+  combiner = op.get_attr("combiner").decode()
+  params_grad = ops.IndexedSlices(
+      gen_math_ops.fused_embedding_lookup_sparse_grad(
+          grad, segment_ids, weights, combiner=combiner), ids,
+      array_ops.shape(params, out_type=ids.dtype))
+
+  skip_input_indices = None
+  try:
+    skip_input_indices = op.skip_input_indices
+  except AttributeError:
+    # No gradient skipping, so do the full gradient computation
+    pass
+  if (weights.shape.num_elements() == 0 or
+      (skip_input_indices is not None and 3 in skip_input_indices)):
+    return params_grad, None, None, None
+
+  # The weight of id i scales params[ids[i]] in segment s = segment_ids[i].
+  # With the mean and sqrtn combiners it also changes the scale of s, which
+  # adds a term proportional to output[s].
+  rows = array_ops.gather(params, ids)
+  segment_grad = array_ops.gather(grad, segment_ids)
+  axes = math_ops.range(1, array_ops.rank(rows))
+  rows_dot_grad = math_ops.reduce_sum(segment_grad * rows, axes)
+  if combiner == "sum":
+    return params_grad, None, None, rows_dot_grad
+
+  if combiner == "mean":
+    totals = math_ops.segment_sum(weights, segment_ids)
+  else:
+    totals = math_ops.sqrt(math_ops.segment_sum(weights * weights, segment_ids))
+  scales = array_ops.gather(math_ops.reciprocal(totals), segment_ids)
+  output_dot_grad = math_ops.reduce_sum(
+      segment_grad * array_ops.gather(op.outputs[0], segment_ids), axes)
+  if combiner == "sqrtn":
+    output_dot_grad *= weights * scales
+  return params_grad, None, None, scales * (rows_dot_grad - output_dot_grad)
+
+
 def _SegmentMinOrMaxGrad(op, grad):
   """ Gradient for SegmentMin and SegmentMax. """
   zeros = array_ops.zeros_like(op.inputs[0], dtype=op.inputs[0].dtype)
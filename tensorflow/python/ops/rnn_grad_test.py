@@ -120,6 +120,65 @@ class RNNGradTest(test.TestCase):
     self.assertAllClose(outputs[0], outputs[1])
     self.assertAllClose(grads[0], grads[1])
 
+  @test_util.deprecated_graph_mode_only
+  def testBlockLSTMMatchesLSTMBlockCell(self):
+    num_steps = 5
+    seq_len_max = 4
+    # Odd sizes make the timesteps unaligned.
+    batch_size = 3
+    input_size = 5
+    hidden_size = 7
+    w = deterministic_random_uniform(
+        [input_size + hidden_size, 4 * hidden_size])
+    b = deterministic_random_uniform([4 * hidden_size])
+    x = deterministic_random_uniform([num_steps, batch_size, input_size])
+    cs_prev = h_prev = deterministic_random_uniform([batch_size, hidden_size])
+    wci = deterministic_random_uniform([hidden_size])
+    wcf = deterministic_random_uniform([hidden_size])
+    wco = deterministic_random_uniform([hidden_size])
+
+    with self.cached_session(use_gpu=False):
+      block_outputs = gen_rnn_ops.block_lstm(
+          seq_len_max=math_ops.cast(seq_len_max, dtypes.int64),
+          x=x,
+          cs_prev=cs_prev,
+          h_prev=h_prev,
+          w=w,
+          wci=wci,
+          wcf=wcf,
+          wco=wco,
+          b=b,
+          forget_bias=1.0,
+          cell_clip=0.5,
+          use_peephole=True)
+      cell_outputs = []
+      cs, h = cs_prev, h_prev
+      for t in range(seq_len_max):
+        outputs = gen_rnn_ops.lstm_block_cell(
+            x=x[t],
+            cs_prev=cs,
+            h_prev=h,
+            w=w,
+            wci=wci,
+            wcf=wcf,
+            wco=wco,
+            b=b,
+            forget_bias=1.0,
+            cell_clip=0.5,
+            use_peephole=True)
+        cs, h = outputs[1], outputs[6]
+        cell_outputs.append(outputs)
+      block_outputs, cell_outputs = self.evaluate([block_outputs, cell_outputs])
+
+    for i in range(7):
+      self.assertAllClose(block_outputs[i][:seq_len_max],
+                          [outputs[i] for outputs in cell_outputs])
+    # The cell states and outputs of the steps past seq_len_max are zero.
+    self.assertAllEqual(block_outputs[1][seq_len_max:],
+                        np.zeros([1, batch_size, hidden_size]))
+    self.assertAllEqual(block_outputs[6][seq_len_max:],
+                        np.zeros([1, batch_size, hidden_size]))
+
   def _lstm_block(self, op, w, b, x, cs_prev, h_prev):
     w_peephole = array_ops.zeros(cs_prev.shape[1:], dtype=w.dtype)
     _, all_cs, _, _, _, _, all_h = op(
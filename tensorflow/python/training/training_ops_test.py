@@ -27,7 +27,7 @@ from tensorflow.python.framework import dtypes
 from tensorflow.python.framework import test_util
 from tensorflow.python.framework.test_util import TensorFlowTestCase
 # Import resource_variable_ops for the variables-to-tensor implicit conversion.
-from tensorflow.python.ops import resource_variable_ops  # pylint: disable=unused-import
+from tensorflow.python.ops import resource_variable_ops
 from tensorflow.python.ops import variables
 from tensorflow.python.platform import googletest
 from tensorflow.python.training import training_ops
@@ -432,13 +432,66 @@ class TrainingOpsTest(TensorFlowTestCase):
       self.assertShapeEqual(out, apply_adam)
       self.assertAllCloseAccordingToType(new_var, out)
 
-  def _adamUpdateNumpy(self, param, g_t, t, m, v, alpha, beta1, beta2, epsilon):
+  @test_util.run_in_graph_and_eager_modes
+  def testResourceApplyAdamMultiTensor(self):
+    for dtype, use_gpu, use_nesterov in itertools.product(
+        [np.float16, np.float32, np.float64], [False, True], [False, True]):
+      # Covers variables smaller and larger than one block of the kernels.
+      sizes = [1, 100, 70000]
+      self._testTypesForAdamMultiTensor(sizes, dtype, use_gpu, use_nesterov)
+
+  def _testTypesForAdamMultiTensor(self, sizes, dtype, use_gpu, use_nesterov):
+    with test_util.device(use_gpu=use_gpu):
+      np.random.seed(len(sizes))
+      vars_np = [np.random.rand(n).astype(dtype) for n in sizes]
+      ms_np = [np.random.rand(n).astype(dtype) for n in sizes]
+      vs_np = [np.random.rand(n).astype(dtype) for n in sizes]
+      grads_np = [np.random.rand(n).astype(dtype) for n in sizes]
+      var_ts = [resource_variable_ops.ResourceVariable(x) for x in vars_np]
+      m_ts = [resource_variable_ops.ResourceVariable(x) for x in ms_np]
+      v_ts = [resource_variable_ops.ResourceVariable(x) for x in vs_np]
+      self.evaluate(variables.global_variables_initializer())
+
+      t = 2
+      beta1 = np.array(0.9, dtype=dtype)
+      beta2 = np.array(0.999, dtype=dtype)
+      lr = np.array(0.001, dtype=dtype)
+      epsilon = np.array(1e-3, dtype=dtype)
+      self.evaluate(
+          training_ops.resource_apply_adam_multi_tensor(
+              [x.handle for x in var_ts], [x.handle for x in m_ts],
+              [x.handle for x in v_ts], beta1**t, beta2**t, lr, beta1, beta2,
+              epsilon, grads_np, use_nesterov=use_nesterov))
+
+      for i in range(len(sizes)):
+        new_var, new_m, new_v = self._adamUpdateNumpy(
+            vars_np[i], grads_np[i], t, ms_np[i], vs_np[i], lr, beta1, beta2,
+            epsilon, use_nesterov)
+        self.assertAllCloseAccordingToType(new_m, self.evaluate(m_ts[i]))
+        self.assertAllCloseAccordingToType(new_v, self.evaluate(v_ts[i]))
+        self.assertAllCloseAccordingToType(new_var, self.evaluate(var_ts[i]))
+
+  def _adamUpdateNumpy(self,
+                       param,
+                       g_t,
+                       t,
+                       m,
+                       v,
+                       alpha,
+                       beta1,
+                       beta2,
+                       epsilon,
+                       use_nesterov=False):
     alpha_t = alpha * np.sqrt(1 - beta2**t) / (1 - beta1**t)
 
     m_t = beta1 * m + (1 - beta1) * g_t
     v_t = beta2 * v + (1 - beta2) * g_t * g_t
 
-    param_t = param - alpha_t * m_t / (np.sqrt(v_t) + epsilon)
+    if use_nesterov:
+      update = beta1 * m_t + (1 - beta1) * g_t
+    else:
+      update = m_t
+    param_t = param - alpha_t * update / (np.sqrt(v_t) + epsilon)
     return param_t, m_t, v_t
 
 
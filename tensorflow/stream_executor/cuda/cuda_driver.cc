@@ -994,6 +994,87 @@ GpuDriver::ContextGetSharedMemConfig(GpuContext* context) {
   return false;
 }
 
+/* static */ port::Status GpuDriver::StreamBeginCapture(GpuContext* context,
+                                                        CUstream stream) {
+#if CUDA_VERSION >= 10010
+  ScopedActivateContext activated{context};
+  CHECK(stream != nullptr);
+  RETURN_IF_CUDA_RES_ERROR(
+      cuStreamBeginCapture(stream, CU_STREAM_CAPTURE_MODE_THREAD_LOCAL),
+      "Could not begin capturing CUDA stream");
+  return port::Status::OK();
+#else
+  return port::UnimplementedError(
+      "Stream capture requires CUDA 10.1 or later");
+#endif
+}
+
+/* static */ port::Status GpuDriver::StreamEndCapture(GpuContext* context,
+                                                      CUstream stream,
+                                                      CUgraph* graph) {
+  ScopedActivateContext activated{context};
+  CHECK(stream != nullptr);
+  RETURN_IF_CUDA_RES_ERROR(cuStreamEndCapture(stream, graph),
+                           "Could not end capturing CUDA stream");
+  return port::Status::OK();
+}
+
+/* static */ port::Status GpuDriver::GraphInstantiate(GpuContext* context,
+                                                      CUgraph graph,
+                                                      CUgraphExec* graph_exec) {
+  ScopedActivateContext activated{context};
+  RETURN_IF_CUDA_RES_ERROR(
+      cuGraphInstantiate(graph_exec, graph, /*phErrorNode=*/nullptr,
+                         /*logBuffer=*/nullptr, /*bufferSize=*/0),
+      "Could not instantiate CUDA graph");
+  return port::Status::OK();
+}
+
+/* static */ port::Status GpuDriver::GraphExecUpdate(GpuContext* context,
+                                                     CUgraphExec graph_exec,
+                                                     CUgraph graph) {
+#if CUDA_VERSION >= 10020
+  ScopedActivateContext activated{context};
+  CUgraphNode error_node = nullptr;
+  CUgraphExecUpdateResult result;
+  RETURN_IF_CUDA_RES_ERROR(
+      cuGraphExecUpdate(graph_exec, graph, &error_node, &result),
+      "Could not update executable CUDA graph (result ",
+      static_cast<int>(result), ")");
+  return port::Status::OK();
+#else
+  return port::UnimplementedError(
+      "Updating executable graphs requires CUDA 10.2 or later");
+#endif
+}
+
+/* static */ port::Status GpuDriver::GraphLaunch(GpuContext* context,
+                                                 CUgraphExec graph_exec,
+                                                 CUstream stream) {
+  ScopedActivateContext activated{context};
+  RETURN_IF_CUDA_RES_ERROR(cuGraphLaunch(graph_exec, stream),
+                           "Could not launch CUDA graph");
+  return port::Status::OK();
+}
+
+/* static */ void GpuDriver::DestroyGraph(GpuContext* context,
+                                          CUgraph graph) {
+  ScopedActivateContext activated{context};
+  CUresult res = cuGraphDestroy(graph);
+  if (res != CUDA_SUCCESS) {
+    LOG(ERROR) << "failed to destroy CUDA graph: " << ToString(res);
+  }
+}
+
+/* static */ void GpuDriver::DestroyGraphExec(GpuContext* context,
+                                              CUgraphExec graph_exec) {
+  ScopedActivateContext activated{context};
+  CUresult res = cuGraphExecDestroy(graph_exec);
+  if (res != CUDA_SUCCESS) {
+    LOG(ERROR) << "failed to destroy executable CUDA graph: " << ToString(res);
+  }
+}
+
 /* static */ port::Status GpuDriver::SynchronousMemcpyD2H(GpuContext* context,
                                                           void* host_dst,
                                                           CUdeviceptr gpu_src,
@@ -140,29 +140,39 @@ port::StatusOr<std::vector<uint8>> CompileGpuAsm(int device_ordinal,
   return CompileGpuAsm(cc_major, cc_minor, ptx_contents, options);
 }
 
-port::StatusOr<std::vector<uint8>> CompileGpuAsm(int cc_major, int cc_minor,
-                                                 const char* ptx_contents,
-                                                 GpuAsmOpts options) {
-  std::string ptxas_path;
-  auto env = tensorflow::Env::Default();
-  std::string ptxas_binary_name = "ptxas";
+// Returns the path of the given binary of the CUDA SDK, searching the
+// candidate CUDA roots first.
+static std::string FindCudaExecutable(const std::string& binary_name,
+                                      const std::string& preferred_cuda_dir) {
+  std::string binary_filename = binary_name;
 #if defined(PLATFORM_WINDOWS)
-  ptxas_binary_name += ".exe";
+  binary_filename += ".exe";
 #endif
 
+  auto env = tensorflow::Env::Default();
+  std::string binary_path;
   for (const std::string& cuda_root :
-       tensorflow::CandidateCudaRoots(options.preferred_cuda_dir)) {
-    ptxas_path = tensorflow::io::JoinPath(cuda_root, "bin", ptxas_binary_name);
-    VLOG(2) << "Looking for ptxas at " << ptxas_path;
-    if (env->FileExists(ptxas_path).ok()) {
+       tensorflow::CandidateCudaRoots(preferred_cuda_dir)) {
+    binary_path = tensorflow::io::JoinPath(cuda_root, "bin", binary_filename);
+    VLOG(2) << "Looking for " << binary_filename << " at " << binary_path;
+    if (env->FileExists(binary_path).ok()) {
       break;
     }
   }
-  if (!env->FileExists(ptxas_path).ok()) {
+  if (!env->FileExists(binary_path).ok()) {
     // Rely on subprocess invocation to find the correct binary.
-    ptxas_path = ptxas_binary_name;
+    binary_path = binary_filename;
   }
-  VLOG(2) << "Using ptxas at " << ptxas_path;
+  VLOG(2) << "Using " << binary_filename << " at " << binary_path;
+  return binary_path;
+}
+
+port::StatusOr<std::vector<uint8>> CompileGpuAsm(int cc_major, int cc_minor,
+                                                 const char* ptx_contents,
+                                                 GpuAsmOpts options) {
+  auto env = tensorflow::Env::Default();
+  std::string ptxas_path =
+      FindCudaExecutable("ptxas", options.preferred_cuda_dir);
 
   WarnIfBadPtxasVersion(ptxas_path);
 
@@ -232,4 +242,71 @@ port::StatusOr<std::vector<uint8>> CompileGpuAsm(int cc_major, int cc_minor,
   return cubin_vector;
 }
 
+port::StatusOr<std::vector<uint8>> LinkGpuAsm(
+    int cc_major, int cc_minor,
+    const std::vector<std::vector<uint8>>& relocatable_cubins,
+    GpuAsmOpts options) {
+  auto env = tensorflow::Env::Default();
+  std::string nvlink_path =
+      FindCudaExecutable("nvlink", options.preferred_cuda_dir);
+
+  // Write the relocatable cubins into temporary files, and collect them into
+  // the arguments of nvlink.
+  std::vector<std::string> temp_paths;
+  auto temp_cleaner = tensorflow::gtl::MakeCleanup([&temp_paths] {
+    // Some files may never be created, so the failure to delete them should
+    // not produce TF error.
+    for (const std::string& path : temp_paths) {
+      tensorflow::Env::Default()->DeleteFile(path).IgnoreError();
+    }
+  });
+  std::vector<std::string> nvlink_args = {
+      nvlink_path, absl::StrCat("-arch=sm_", cc_major, cc_minor)};
+  for (const std::vector<uint8>& relocatable_cubin : relocatable_cubins) {
+    std::string path;
+    if (!env->LocalTempFilename(&path)) {
+      return port::InternalError("couldn't get temp CUBIN file name");
+    }
+    temp_paths.push_back(path);
+    TF_RETURN_IF_ERROR(tensorflow::WriteStringToFile(
+        env, path,
+        absl::string_view(
+            reinterpret_cast<const char*>(relocatable_cubin.data()),
+            relocatable_cubin.size())));
+    nvlink_args.push_back(path);
+  }
+  std::string output_path;
+  if (!env->LocalTempFilename(&output_path)) {
+    return port::InternalError("couldn't get temp CUBIN file name");
+  }
+  temp_paths.push_back(output_path);
+  nvlink_args.push_back("-o");
+  nvlink_args.push_back(output_path);
+  if (VLOG_IS_ON(3)) {
+    VLOG(3) << absl::StrJoin(nvlink_args, " ");
+  }
+
+  tensorflow::SubProcess nvlink;
+  nvlink.SetProgram(nvlink_path, nvlink_args);
+  nvlink.SetChannelAction(tensorflow::CHAN_STDERR, tensorflow::ACTION_PIPE);
+  if (!nvlink.Start()) {
+    return port::InternalError("Failed to launch nvlink");
+  }
+  std::string stderr_output;
+  int exit_status = nvlink.Communicate(
+      /*stdin_input=*/nullptr, /*stdout_output=*/nullptr, &stderr_output);
+  if (exit_status != 0) {
+    return port::InternalError(
+        absl::StrFormat("nvlink exited with non-zero error code %d, output: %s",
+                        exit_status, stderr_output));
+  }
+  if (!stderr_output.empty()) {
+    VLOG(2) << stderr_output;
+  }
+
+  std::string cubin;
+  TF_RETURN_IF_ERROR(tensorflow::ReadFileToString(env, output_path, &cubin));
+  return std::vector<uint8>(cubin.begin(), cubin.end());
+}
+
 }  // namespace stream_executor
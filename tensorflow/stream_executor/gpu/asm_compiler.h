@@ -45,6 +45,17 @@ port::StatusOr<std::vector<uint8>> CompileGpuAsm(int cc_major, int cc_minor,
                                                  const char* ptx_contents,
                                                  GpuAsmOpts options);
 
+// Links the given relocatable cubins, as compiled by CompileGpuAsm with the
+// "-c" extra flag, into a single cubin for the compute capabilities provided
+// by 'cc_major' and 'cc_minor', using nvlink.
+//
+// 'options' is used to query for the CUDA location in case it is
+// customized in a passed flag.
+port::StatusOr<std::vector<uint8>> LinkGpuAsm(
+    int cc_major, int cc_minor,
+    const std::vector<std::vector<uint8>>& relocatable_cubins,
+    GpuAsmOpts options);
+
 // Same as CompileGpuAsm, but caches the result, and returns unowned view of
 // the compiled binary.
 //
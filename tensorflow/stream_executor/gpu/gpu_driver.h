@@ -346,6 +346,46 @@ class GpuDriver {
   // the stream immediately after this returns).
   static bool IsStreamIdle(GpuContext* context, GpuStreamHandle stream);
 
+  // Starts capturing the work enqueued onto stream into a graph instead of
+  // running it, via cuStreamBeginCapture. Only calls made by the capturing
+  // thread that are unsafe during capture, such as cuMemAlloc, make the
+  // capture fail; other threads are not affected.
+  // (supported on CUDA 10.1 and later only)
+  static port::Status StreamBeginCapture(GpuContext* context,
+                                         GpuStreamHandle stream);
+
+  // Ends the capture started on stream and returns the captured graph, via
+  // cuStreamEndCapture. Fails if the capture was invalidated, in which case
+  // none of the captured work ran.
+  static port::Status StreamEndCapture(GpuContext* context,
+                                       GpuStreamHandle stream,
+                                       GpuGraphHandle* graph);
+
+  // Creates an executable graph from graph, via cuGraphInstantiate.
+  static port::Status GraphInstantiate(GpuContext* context,
+                                       GpuGraphHandle graph,
+                                       GpuGraphExecHandle* graph_exec);
+
+  // Updates the parameters of the nodes of graph_exec to those of graph, via
+  // cuGraphExecUpdate. Fails if graph differs from the graph graph_exec was
+  // instantiated from in more than the parameters of its nodes, in which case
+  // graph_exec is left unchanged. Launches already enqueued are not affected.
+  // (supported on CUDA 10.2 and later only)
+  static port::Status GraphExecUpdate(GpuContext* context,
+                                      GpuGraphExecHandle graph_exec,
+                                      GpuGraphHandle graph);
+
+  // Enqueues all the work of graph_exec onto stream, via cuGraphLaunch.
+  static port::Status GraphLaunch(GpuContext* context,
+                                  GpuGraphExecHandle graph_exec,
+                                  GpuStreamHandle stream);
+
+  // Destroy a graph, or an executable graph. An executable graph with pending
+  // launches is freed once they complete.
+  static void DestroyGraph(GpuContext* context, GpuGraphHandle graph);
+  static void DestroyGraphExec(GpuContext* context,
+                               GpuGraphExecHandle graph_exec);
+
   // Returns whether code in the from context can access memory in the to
   // context via cuDeviceCanAccessPeer.
   // http://docs.nvidia.com/cuda/cuda-driver-api/group__CUDA__PEER__ACCESS.html#group__CUDA__PEER__ACCESS_1g496bdaae1f632ebfb695b99d2c40f19e
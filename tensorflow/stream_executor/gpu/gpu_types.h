@@ -59,6 +59,9 @@ using GpuSharedMemConfig = hipSharedMemConfig;
 using GpuComplexType = hipComplex;
 using GpuDoubleComplexType = hipDoubleComplex;
 using GpuRngHandle = hiprandGenerator_t;
+// Stream capture is not supported on ROCm.
+using GpuGraphHandle = void*;
+using GpuGraphExecHandle = void*;
 
 #else  // CUDA
 
@@ -77,6 +80,8 @@ using GpuSharedMemConfig = CUsharedconfig;
 using GpuComplexType = cuComplex;
 using GpuDoubleComplexType = cuDoubleComplex;
 using GpuRngHandle = curandGenerator_t;
+using GpuGraphHandle = CUgraph;
+using GpuGraphExecHandle = CUgraphExec;
 
 #endif
 
@@ -983,19 +983,14 @@ def _create_local_cuda_repository(repository_ctx):
         ),
     ]
 
+    cublas_headers = ["cublas.h", "cublas_v2.h", "cublas_api.h"]
+    if int(cuda_config.config["cuda_version"].split(".")[0]) >= 11:
+        cublas_headers.append("cublasLt.h")
     copy_rules.append(make_copy_files_rule(
         repository_ctx,
         name = "cublas-include",
-        srcs = [
-            cublas_include_path + "/cublas.h",
-            cublas_include_path + "/cublas_v2.h",
-            cublas_include_path + "/cublas_api.h",
-        ],
-        outs = [
-            "cublas/include/cublas.h",
-            "cublas/include/cublas_v2.h",
-            "cublas/include/cublas_api.h",
-        ],
+        srcs = [cublas_include_path + "/" + h for h in cublas_headers],
+        outs = ["cublas/include/" + h for h in cublas_headers],
     ))
 
     cusolver_include_path = cuda_config.config["cusolver_include_dir"]